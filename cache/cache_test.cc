@@ -676,6 +676,108 @@ TEST_P(CacheTest, DefaultShardBits) {
   ASSERT_EQ(6, sc->GetNumShardBits());
 }
 
+TEST_P(CacheTest, AdmissionFilter) {
+  CacheAdmissionOptions admission_options;
+  admission_options.sketch_counters = 1024;
+  admission_options.statistics = CreateDBStatistics();
+  std::vector<std::shared_ptr<Cache>> caches;
+  if (GetParam() == kLRU) {
+    LRUCacheOptions lru_options(10, 0, false, 0.0);
+    lru_options.admission_options = admission_options;
+    caches.push_back(NewLRUCache(lru_options));
+    LIRSCacheOptions lirs_options(10, 0, false, 0.9);
+    lirs_options.admission_options = admission_options;
+    caches.push_back(NewLIRSCache(lirs_options));
+  } else {
+    caches.push_back(NewClockCache(10, 0, false, admission_options));
+  }
+  auto* stats = admission_options.statistics.get();
+  for (auto& cache : caches) {
+    uint64_t rejects = stats->getTickerCount(CACHE_ADMISSION_REJECT);
+    deleted_keys_.clear();
+    // everything is admitted until the cache is full
+    for (int i = 0; i < 10; i++) {
+      Insert(cache, i, i + 1000);
+    }
+    ASSERT_EQ(10u, cache->GetUsage());
+    ASSERT_EQ(rejects, stats->getTickerCount(CACHE_ADMISSION_REJECT));
+
+    // a key never looked up is rejected, and its value is deleted
+    Insert(cache, 100, 1100);
+    ASSERT_EQ(rejects + 1, stats->getTickerCount(CACHE_ADMISSION_REJECT));
+    ASSERT_EQ(1u, deleted_keys_.size());
+    ASSERT_EQ(100, deleted_keys_[0]);
+
+    // so is a key looked up once
+    ASSERT_EQ(-1, Lookup(cache, 101));
+    Insert(cache, 101, 1101);
+    ASSERT_EQ(rejects + 2, stats->getTickerCount(CACHE_ADMISSION_REJECT));
+
+    // the second miss admits it
+    ASSERT_EQ(-1, Lookup(cache, 101));
+    Insert(cache, 101, 1101);
+    ASSERT_EQ(rejects + 2, stats->getTickerCount(CACHE_ADMISSION_REJECT));
+    ASSERT_EQ(1101, Lookup(cache, 101));
+  }
+}
+
+namespace {
+size_t quota_callback_count = 0;
+void QuotaCallback(void* /*entry*/, size_t /*charge*/) {
+  quota_callback_count++;
+}
+}  // namespace
+
+TEST(CacheQuotaTest, ReservationAndSoftMax) {
+  std::shared_ptr<Cache> shared = NewLRUCache(100, 0);
+  ASSERT_EQ(nullptr, NewCacheQuota(shared, 20, 10));
+  std::shared_ptr<Cache> a = NewCacheQuota(shared, 20, 60);
+  std::shared_ptr<Cache> b = NewCacheQuota(shared, 0, 100);
+  auto check = [](std::shared_ptr<Cache> cache, int key) {
+    Cache::Handle* h = cache->Lookup(EncodeKey(key));
+    if (h == nullptr) {
+      return false;
+    }
+    EXPECT_EQ(key, DecodeValue(cache->Value(h)));
+    cache->Release(h);
+    return true;
+  };
+
+  for (int i = 0; i < 20; i++) {
+    ASSERT_OK(a->Insert(EncodeKey(i), EncodeValue(i), 1, &dumbDeleter));
+  }
+  ASSERT_EQ(20u, a->GetUsage());
+  ASSERT_EQ(20u, a->GetPinnedUsage());
+
+  // b flushes the shared cache, but can't evict the reservation of a
+  for (int i = 1000; i < 1200; i++) {
+    ASSERT_OK(b->Insert(EncodeKey(i), EncodeValue(i), 1, &dumbDeleter));
+  }
+  ASSERT_EQ(80u, b->GetUsage());
+  ASSERT_EQ(20u, a->GetUsage());
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(check(a, i));
+  }
+  quota_callback_count = 0;
+  a->ApplyToAllCacheEntries(&QuotaCallback, true);
+  ASSERT_EQ(20u, quota_callback_count);
+
+  // a strict view doesn't go beyond its soft maximum
+  a->SetStrictCapacityLimit(true);
+  for (int i = 100; i < 200; i++) {
+    a->Insert(EncodeKey(i), EncodeValue(i), 1, &dumbDeleter);
+  }
+  ASSERT_EQ(60u, a->GetUsage());
+  ASSERT_EQ(40u, b->GetUsage());
+  ASSERT_EQ(20u, a->GetPinnedUsage());
+  ASSERT_EQ(100u, shared->GetUsage());
+
+  a.reset();
+  b.reset();
+  shared->EraseUnRefEntries();
+  ASSERT_EQ(0u, shared->GetUsage());
+}
+
 #ifdef SUPPORT_CLOCK_CACHE
 shared_ptr<Cache> (*new_clock_cache_func)(size_t, int, bool) = NewClockCache;
 INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest,
@@ -22,6 +22,14 @@ std::shared_ptr<Cache> NewClockCache(size_t /*capacity*/,
   return nullptr;
 }
 
+std::shared_ptr<Cache> NewClockCache(
+    size_t /*capacity*/, int /*num_shard_bits*/,
+    bool /*strict_capacity_limit*/,
+    const CacheAdmissionOptions& /*admission_options*/) {
+  // Clock cache not supported.
+  return nullptr;
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 #else
@@ -729,6 +737,15 @@ std::shared_ptr<Cache> NewClockCache(size_t capacity, int num_shard_bits,
                                       strict_capacity_limit);
 }
 
+std::shared_ptr<Cache> NewClockCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    const CacheAdmissionOptions& admission_options) {
+  auto cache = NewClockCache(capacity, num_shard_bits, strict_capacity_limit);
+  static_cast<ShardedCache*>(cache.get())
+      ->SetAdmissionOptions(admission_options);
+  return cache;
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 #endif  // SUPPORT_CLOCK_CACHE
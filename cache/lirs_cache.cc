@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <string>
 
 #include "rocksdb/terark_namespace.h"
@@ -86,13 +87,16 @@ void LIRSHandleTable::Resize() {
   length_ = new_length;
 }
 
+const size_t LIRSCacheShard::kAccessBufferSize;
+
 LIRSCacheShard::LIRSCacheShard(size_t capacity, bool strict_capacity_limit,
                                double irr_ratio)
     : capacity_(capacity),
       usage_(0),
       stack_usage_(0),
       irr_ratio_(irr_ratio),
-      strict_capacity_limit_(strict_capacity_limit) {
+      strict_capacity_limit_(strict_capacity_limit),
+      num_accesses_(0) {
   cache_.next_stack = cache_.prev_stack = cache_.next_queue =
       cache_.prev_queue = &cache_;
   SetCapacity(capacity);
@@ -190,7 +194,8 @@ bool LIRSCacheShard::Unref(LIRSHandle* h) {
 void LIRSCacheShard::EraseUnRefEntries() {
   autovector<LIRSHandle*> last_reference_list;
   {
-    MutexLock l(&mutex_);
+    WriteLock l(&mutex_);
+    ApplyBufferedAccesses();
     while (cache_.prev_queue != &cache_) {
       LIRSHandle* old = cache_.prev_queue;
       LIRS_Remove(old);
@@ -210,12 +215,12 @@ void LIRSCacheShard::EraseUnRefEntries() {
 void LIRSCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                             bool thread_safe) {
   if (thread_safe) {
-    mutex_.Lock();
+    mutex_.ReadLock();
   }
   table_.ApplyToAllCacheEntries(
       [callback](LIRSHandle* h) { callback(h->value, h->charge); });
   if (thread_safe) {
-    mutex_.Unlock();
+    mutex_.ReadUnlock();
   }
 }
 
@@ -263,44 +268,112 @@ void LIRSCacheShard::EvictFromLIRS(size_t charge,
 }
 
 void LIRSCacheShard::SetCapacity(size_t capacity) {
-  MutexLock l(&mutex_);
+  WriteLock l(&mutex_);
   capacity_ = capacity;
   stack_capacity_ = capacity_ * irr_ratio_;
 }
 
+void LIRSCacheShard::Promote(LIRSHandle* h) {
+  // Pinned handles are kept out of the stack and queue. A buffered access may
+  // also be stale, so skip it if the handle has since left the part of the
+  // stack and queue its state says it is in.
+  if (h->next_stack == nullptr && h->next_queue == nullptr) {
+    return;
+  }
+  if (h->LIR()) {
+    if (h->next_stack == nullptr) {
+      return;
+    }
+    AdjustToStackTop(h);
+  } else if (h->HIR()) {
+    if (h->next_queue == nullptr) {
+      return;
+    }
+    if (h->next_stack != nullptr) {
+      h->SetLIR();
+      AdjustToStackTop(h);
+      RemoveFromQueue(h);
+      AdjustStackBottom();
+    } else {
+      PushToStack(h);
+      AdjustToQueueTail(h);
+    }
+  } else if (h->NHIR()) {
+    if (h->next_queue != nullptr) {
+      return;
+    }
+    ShiftQueueHead();
+    if (h->next_stack != nullptr) {
+      h->SetLIR();
+      AdjustToStackTop(h);
+      AdjustStackBottom();
+    } else {
+      h->SetHIR();
+      PushToStack(h);
+      PushToQueue(h);
+    }
+  } else {
+    return;
+  }
+  StackPruning();
+}
+
+void LIRSCacheShard::ApplyBufferedAccesses() {
+  size_t n = std::min(num_accesses_.load(std::memory_order_relaxed),
+                      kAccessBufferSize);
+  for (size_t i = 0; i < n; ++i) {
+    Promote(access_buffer_[i]);
+  }
+  num_accesses_.store(0, std::memory_order_relaxed);
+}
+
 Cache::Handle* LIRSCacheShard::Lookup(const Slice& key, uint32_t hash) {
-  MutexLock l(&mutex_);
-  LIRSHandle* h = table_.Lookup(key, hash);
+  LIRSHandle* h;
+  bool apply_accesses = false;
+  {
+    ReadLock l(&mutex_);
+    h = table_.Lookup(key, hash);
+    if (h == nullptr) {
+      return nullptr;
+    }
+    if (h->Remote() ||
+        (h->next_stack == nullptr && h->next_queue == nullptr)) {
+      // Nothing to promote or to take out of the stack and queue
+      h->refs.fetch_add(1, std::memory_order_relaxed);
+      return reinterpret_cast<Cache::Handle*>(h);
+    }
+    uint32_t refs = h->refs.load(std::memory_order_relaxed);
+    while (refs > 1 && !h->refs.compare_exchange_weak(
+                           refs, refs + 1, std::memory_order_relaxed)) {
+    }
+    if (refs > 1) {
+      // Already pinned by someone else, only a promotion is needed
+      size_t i = num_accesses_.fetch_add(1, std::memory_order_relaxed);
+      if (i < kAccessBufferSize) {
+        access_buffer_[i] = h;
+        apply_accesses = i + 1 == kAccessBufferSize;
+      }
+      if (!apply_accesses) {
+        return reinterpret_cast<Cache::Handle*>(h);
+      }
+    }
+  }
+
+  WriteLock l(&mutex_);
+  ApplyBufferedAccesses();
+  if (apply_accesses) {
+    // h is still alive: we hold a reference to it
+    return reinterpret_cast<Cache::Handle*>(h);
+  }
+  // Only the cache references h, so it has to leave the stack and queue.
+  // Look it up again, the table may have changed in between.
+  h = table_.Lookup(key, hash);
   if (h != nullptr) {
     if (!h->Remote()) {
       if (h->refs == 1) {
         LIRS_Remove(h);
       } else {
-        if (h->LIR()) {
-          AdjustToStackTop(h);
-        } else if (h->HIR()) {
-          if (h->next_stack != nullptr) {
-            h->SetLIR();
-            AdjustToStackTop(h);
-            RemoveFromQueue(h);
-            AdjustStackBottom();
-          } else {
-            PushToStack(h);
-            AdjustToQueueTail(h);
-          }
-        } else {
-          ShiftQueueHead();
-          if (h->next_stack != nullptr) {
-            h->SetLIR();
-            AdjustToStackTop(h);
-            AdjustStackBottom();
-          } else {
-            h->SetHIR();
-            PushToStack(h);
-            PushToQueue(h);
-          }
-        }
-        StackPruning();
+        Promote(h);
       }
     }
     h->refs++;
@@ -310,7 +383,8 @@ Cache::Handle* LIRSCacheShard::Lookup(const Slice& key, uint32_t hash) {
 
 bool LIRSCacheShard::Ref(Cache::Handle* h) {
   LIRSHandle* handle = reinterpret_cast<LIRSHandle*>(h);
-  MutexLock l(&mutex_);
+  WriteLock l(&mutex_);
+  ApplyBufferedAccesses();
   if (handle->InCache() && handle->refs == 1) {
     LIRS_Remove(handle);
   }
@@ -323,9 +397,19 @@ bool LIRSCacheShard::Release(Cache::Handle* handle, bool force_erase) {
     return false;
   }
   LIRSHandle* e = reinterpret_cast<LIRSHandle*>(handle);
+  if (!force_erase) {
+    ReadLock l(&mutex_);
+    if (e->InCache() && usage_ <= capacity_) {
+      // The cache keeps its own reference, so this is not the last one and
+      // nothing but the count changes
+      e->refs.fetch_sub(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
   bool last_reference = false;
   {
-    MutexLock l(&mutex_);
+    WriteLock l(&mutex_);
+    ApplyBufferedAccesses();
     last_reference = Unref(e);
     if (last_reference) {
       usage_ -= e->charge;
@@ -371,7 +455,8 @@ Status LIRSCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
 
   autovector<LIRSHandle*> last_reference_list;
   {
-    MutexLock l(&mutex_);
+    WriteLock l(&mutex_);
+    ApplyBufferedAccesses();
     EvictFromLIRS(charge, &last_reference_list);
     if (usage_ + charge > capacity_ && strict_capacity_limit_) {
       e->refs = 0;
@@ -411,7 +496,8 @@ void LIRSCacheShard::Erase(const Slice& key, uint32_t hash) {
   LIRSHandle* e;
   bool last_reference = false;
   {
-    MutexLock l(&mutex_);
+    WriteLock l(&mutex_);
+    ApplyBufferedAccesses();
     e = table_.Remove(key, hash);
     if (e != nullptr) {
       last_reference = Unref(e);
@@ -433,12 +519,12 @@ void LIRSCacheShard::Erase(const Slice& key, uint32_t hash) {
 }
 
 size_t LIRSCacheShard::GetUsage() const {
-  MutexLock l(&mutex_);
+  ReadLock l(&mutex_);
   return usage_;
 }
 
 size_t LIRSCacheShard::GetPinnedUsage() const {
-  MutexLock l(&mutex_);
+  ReadLock l(&mutex_);
   assert(usage_ >= stack_usage_);
   return usage_ - stack_usage_;
 }
@@ -447,14 +533,14 @@ std::string LIRSCacheShard::GetPrintableOptions() const {
   const int kBufferSize = 200;
   char buffer[kBufferSize];
   {
-    MutexLock l(&mutex_);
+    ReadLock l(&mutex_);
     snprintf(buffer, kBufferSize, "    irr_ratio : %.3lf\n", irr_ratio_);
   }
   return std::string(buffer);
 }
 
 void LIRSCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
-  MutexLock l(&mutex_);
+  WriteLock l(&mutex_);
   strict_capacity_limit_ = strict_capacity_limit;
 }
 
@@ -519,9 +605,14 @@ void LIRSCache::DisownData() {
 }
 
 std::shared_ptr<Cache> NewLIRSCache(const LIRSCacheOptions& cache_opts) {
-  return NewLIRSCache(cache_opts.capacity, cache_opts.num_shard_bits,
-                      cache_opts.strict_capacity_limit, cache_opts.irr_ratio,
-                      cache_opts.memory_allocator);
+  auto cache = NewLIRSCache(cache_opts.capacity, cache_opts.num_shard_bits,
+                            cache_opts.strict_capacity_limit,
+                            cache_opts.irr_ratio, cache_opts.memory_allocator);
+  if (cache != nullptr && cache_opts.admission_options.sketch_counters > 0) {
+    static_cast<ShardedCache*>(cache.get())
+        ->SetAdmissionOptions(cache_opts.admission_options);
+  }
+  return cache;
 }
 
 std::shared_ptr<Cache> NewLIRSCache(
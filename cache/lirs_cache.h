@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "cache/sharded_cache.h"
@@ -19,7 +20,9 @@ struct LIRSHandle {
   LIRSHandle* prev_queue;
   size_t charge;
   size_t key_length;
-  uint32_t refs;
+  // Only incremented under the shard's read lock; every other change is made
+  // under its write lock
+  std::atomic<uint32_t> refs;
   uint32_t hash;  // Hash of key(); used for fast sharding and comparisons
 
   enum State { kRemote = 0, kLIR, kHIR, kNHIR, kInvalid } state;
@@ -132,6 +135,9 @@ class ALIGN_AS(CACHE_LINE_SIZE) LIRSCacheShard : public CacheShard {
   void LIRS_Insert(LIRSHandle* h);
   bool Unref(LIRSHandle* h);
   void EvictFromLIRS(size_t charge, autovector<LIRSHandle*>* deleted);
+  void Promote(LIRSHandle* h);
+  // REQUIRES: mutex_ held for write
+  void ApplyBufferedAccesses();
 
   size_t capacity_;
   size_t stack_capacity_;
@@ -141,7 +147,16 @@ class ALIGN_AS(CACHE_LINE_SIZE) LIRSCacheShard : public CacheShard {
   LIRSHandle cache_;
   LIRSHandleTable table_;
   bool strict_capacity_limit_;
-  mutable port::Mutex mutex_;
+  mutable port::RWMutex mutex_;
+
+  // A lookup that only has to promote the handle in the stack and queue runs
+  // under the read lock and records the handle here. The promotions are
+  // applied in a batch by the lookup that fills the buffer, or by the next
+  // operation that takes the write lock, before anything can be freed.
+  // Lookups finding the buffer full drop their promotion.
+  static const size_t kAccessBufferSize = 64;
+  std::atomic<size_t> num_accesses_;
+  LIRSHandle* access_buffer_[kAccessBufferSize];
 };
 
 class LIRSCache : public ShardedCache {
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <string>
 
 #include "rocksdb/terark_namespace.h"
@@ -108,7 +109,11 @@ LRUCacheShardTemplate<CacheMonitor>::LRUCacheShardTemplate(
       capacity_(0),
       strict_capacity_limit_(strict_capacity_limit),
       high_pri_pool_ratio_(high_pri_pool_ratio),
-      high_pri_pool_capacity_(0) {
+      high_pri_pool_capacity_(0),
+      high_pri_pool_max_ratio_(0),
+      high_pri_pool_max_capacity_(0),
+      high_pri_pool_peak_usage_(0),
+      high_pri_pool_window_inserts_(0) {
   // Make empty circular linked list
   lru_.next = &lru_;
   lru_.prev = &lru_;
@@ -183,6 +188,12 @@ size_t LRUCacheShardTemplate<CacheMonitor>::TEST_GetLRUSize() {
   return lru_size;
 }
 
+template <class CacheMonitor>
+double LRUCacheShardTemplate<CacheMonitor>::TEST_GetHighPriPoolCapacity() {
+  MutexLock l(&mutex_);
+  return high_pri_pool_capacity_;
+}
+
 template <class CacheMonitor>
 double LRUCacheShardTemplate<CacheMonitor>::GetHighPriPoolRatio() {
   MutexLock l(&mutex_);
@@ -218,6 +229,8 @@ void LRUCacheShardTemplate<CacheMonitor>::LRU_Insert(LRUHandle* e) {
     e->next->prev = e;
     e->SetInHighPriPool(true);
     HighPriPoolUsageAdd(e);
+    high_pri_pool_peak_usage_ =
+        std::max(high_pri_pool_peak_usage_, high_pri_pool_usage_);
     MaintainPoolSize();
   } else {
     // Insert "e" to the head of low-pri pool. Note that when
@@ -234,6 +247,14 @@ void LRUCacheShardTemplate<CacheMonitor>::LRU_Insert(LRUHandle* e) {
 
 template <class CacheMonitor>
 void LRUCacheShardTemplate<CacheMonitor>::MaintainPoolSize() {
+  if (high_pri_pool_usage_ > high_pri_pool_capacity_ &&
+      high_pri_pool_capacity_ < high_pri_pool_max_capacity_) {
+    // Keep a burst of high-pri entries, e.g. the filters of a large flush,
+    // rather than overflowing older ones to the low-pri pool
+    high_pri_pool_capacity_ =
+        std::min(high_pri_pool_max_capacity_,
+                 static_cast<double>(high_pri_pool_usage_));
+  }
   while (high_pri_pool_usage_ > high_pri_pool_capacity_) {
     // Overflow last entry in high-pri pool to low-pri pool.
     lru_low_pri_ = lru_low_pri_->next;
@@ -243,6 +264,31 @@ void LRUCacheShardTemplate<CacheMonitor>::MaintainPoolSize() {
   }
 }
 
+template <class CacheMonitor>
+void LRUCacheShardTemplate<CacheMonitor>::ResizePool() {
+  if (high_pri_pool_max_capacity_ <= capacity_ * high_pri_pool_ratio_ ||
+      ++high_pri_pool_window_inserts_ < kHighPriPoolResizeWindow) {
+    return;
+  }
+  // The pool gives back what the working set no longer needs
+  high_pri_pool_capacity_ =
+      std::max(capacity_ * high_pri_pool_ratio_,
+               std::min(high_pri_pool_capacity_,
+                        static_cast<double>(high_pri_pool_peak_usage_)));
+  high_pri_pool_peak_usage_ = high_pri_pool_usage_;
+  high_pri_pool_window_inserts_ = 0;
+}
+
+template <class CacheMonitor>
+void LRUCacheShardTemplate<CacheMonitor>::UpdatePoolCapacity() {
+  double min_capacity = capacity_ * high_pri_pool_ratio_;
+  high_pri_pool_max_capacity_ =
+      std::max(min_capacity, capacity_ * high_pri_pool_max_ratio_);
+  high_pri_pool_capacity_ =
+      std::max(min_capacity,
+               std::min(high_pri_pool_capacity_, high_pri_pool_max_capacity_));
+}
+
 template <class CacheMonitor>
 void LRUCacheShardTemplate<CacheMonitor>::EvictFromLRU(
     size_t charge, autovector<LRUHandle*>* deleted) {
@@ -265,7 +311,8 @@ void LRUCacheShardTemplate<CacheMonitor>::SetCapacity(size_t capacity) {
   {
     MutexLock l(&mutex_);
     capacity_ = capacity;
-    high_pri_pool_capacity_ = capacity_ * high_pri_pool_ratio_;
+    UpdatePoolCapacity();
+    MaintainPoolSize();
     EvictFromLRU(0, &last_reference_list);
   }
   // we free the entries here outside of mutex for
@@ -314,7 +361,16 @@ void LRUCacheShardTemplate<CacheMonitor>::SetHighPriorityPoolRatio(
     double high_pri_pool_ratio) {
   MutexLock l(&mutex_);
   high_pri_pool_ratio_ = high_pri_pool_ratio;
-  high_pri_pool_capacity_ = capacity_ * high_pri_pool_ratio_;
+  UpdatePoolCapacity();
+  MaintainPoolSize();
+}
+
+template <class CacheMonitor>
+void LRUCacheShardTemplate<CacheMonitor>::SetHighPriorityPoolMaxRatio(
+    double high_pri_pool_max_ratio) {
+  MutexLock l(&mutex_);
+  high_pri_pool_max_ratio_ = high_pri_pool_max_ratio;
+  UpdatePoolCapacity();
   MaintainPoolSize();
 }
 
@@ -388,6 +444,8 @@ Status LRUCacheShardTemplate<CacheMonitor>::Insert(
   {
     MutexLock l(&mutex_);
 
+    ResizePool();
+
     // Free the space following strict LRU policy until enough space
     // is freed or the lru list is empty
     EvictFromLRU(charge, &last_reference_list);
@@ -483,8 +541,10 @@ std::string LRUCacheShardTemplate<CacheMonitor>::GetPrintableOptions() const {
   char buffer[kBufferSize];
   {
     MutexLock l(&mutex_);
-    snprintf(buffer, kBufferSize, "    high_pri_pool_ratio: %.3lf\n",
-             high_pri_pool_ratio_);
+    snprintf(buffer, kBufferSize,
+             "    high_pri_pool_ratio: %.3lf\n"
+             "    high_pri_pool_max_ratio: %.3lf\n",
+             high_pri_pool_ratio_, high_pri_pool_max_ratio_);
   }
   return std::string(buffer);
 }
@@ -617,10 +677,24 @@ size_t LRUCacheBase<LRUCacheShardType>::TEST_GetLRUSize() {
 // double LRUCacheBase<LRUCacheShardType>::GetHighPriPoolRatio()
 
 std::shared_ptr<Cache> NewLRUCache(const LRUCacheOptions& cache_opts) {
-  return NewLRUCache(cache_opts.capacity, cache_opts.num_shard_bits,
-                     cache_opts.strict_capacity_limit,
-                     cache_opts.high_pri_pool_ratio,
-                     cache_opts.memory_allocator);
+  auto cache = NewLRUCache(cache_opts.capacity, cache_opts.num_shard_bits,
+                           cache_opts.strict_capacity_limit,
+                           cache_opts.high_pri_pool_ratio,
+                           cache_opts.memory_allocator);
+  if (cache != nullptr && cache_opts.high_pri_pool_max_ratio > 0) {
+    if (cache_opts.high_pri_pool_max_ratio < cache_opts.high_pri_pool_ratio ||
+        cache_opts.high_pri_pool_max_ratio > 1.0) {
+      // invalid high_pri_pool_max_ratio
+      return nullptr;
+    }
+    static_cast<LRUCache*>(cache.get())
+        ->SetHighPriorityPoolMaxRatio(cache_opts.high_pri_pool_max_ratio);
+  }
+  if (cache != nullptr && cache_opts.admission_options.sketch_counters > 0) {
+    static_cast<ShardedCache*>(cache.get())
+        ->SetAdmissionOptions(cache_opts.admission_options);
+  }
+  return cache;
 }
 
 std::shared_ptr<Cache> NewLRUCache(
@@ -198,6 +198,10 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShardTemplate : public CacheMonitor,
   // Set percentage of capacity reserved for high-pri cache entries.
   void SetHighPriorityPoolRatio(double high_pri_pool_ratio);
 
+  // Let the high-pri pool grow up to this percentage of capacity instead of
+  // overflowing, see LRUCacheOptions::high_pri_pool_max_ratio.
+  void SetHighPriorityPoolMaxRatio(double high_pri_pool_max_ratio);
+
   // Like Cache methods, but with an extra "hash" parameter.
   virtual Status Insert(const Slice& key, uint32_t hash, void* value,
                         size_t charge,
@@ -233,14 +237,28 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShardTemplate : public CacheMonitor,
   //  Retrives high pri pool ratio
   double GetHighPriPoolRatio();
 
+  //  Retrives current high pri pool size, for unit test purpose only
+  double TEST_GetHighPriPoolCapacity();
+
+  // Number of inserts over which the high-pri pool working set is measured
+  static const uint32_t kHighPriPoolResizeWindow = 1024;
+
  private:
   void LRU_Remove(LRUHandle* e);
   void LRU_Insert(LRUHandle* e);
 
   // Overflow the last entry in high-pri pool to low-pri pool until size of
   // high-pri pool is no larger than the size specify by high_pri_pool_pct.
+  // An adaptive pool grows up to its maximum before overflowing.
   void MaintainPoolSize();
 
+  // Shrink an adaptive pool to the peak usage of the last window, once per
+  // kHighPriPoolResizeWindow inserts.
+  void ResizePool();
+
+  // Recompute the pool size bounds after capacity or ratios change.
+  void UpdatePoolCapacity();
+
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(LRUHandle* e);
@@ -264,6 +282,16 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShardTemplate : public CacheMonitor,
   // Remember the value to avoid recomputing each time.
   double high_pri_pool_capacity_;
 
+  // Upper bound of the adaptive high-pri pool, no larger than capacity *
+  // high_pri_pool_max_ratio. The pool is fixed when it is not above
+  // capacity * high_pri_pool_ratio.
+  double high_pri_pool_max_ratio_;
+  double high_pri_pool_max_capacity_;
+
+  // Peak high-pri pool usage and inserts of the current resize window.
+  size_t high_pri_pool_peak_usage_;
+  uint32_t high_pri_pool_window_inserts_;
+
   // Dummy head of LRU list.
   // lru.prev is newest entry, lru.next is oldest entry.
   // LRU contains items which can be evicted, ie reference only by cache
@@ -669,6 +697,13 @@ class LRUCacheBase : public ShardedCache {
   //  Retrieves number of elements in LRU, for unit test purpose only
   size_t TEST_GetLRUSize();
 
+  //  Let the high-pri pool of every shard grow up to this ratio
+  void SetHighPriorityPoolMaxRatio(double high_pri_pool_max_ratio) {
+    for (int i = 0; i < num_shards_; i++) {
+      shards_[i].SetHighPriorityPoolMaxRatio(high_pri_pool_max_ratio);
+    }
+  }
+
   //  Retrives high pri pool ratio
   double GetHighPriPoolRatio() {
     double result = 0.0;
@@ -91,6 +91,30 @@ class LRUCacheTest : public testing::Test,
 
   void Erase(const std::string& key) { cache_->Erase(key, 0 /*hash*/); }
 
+  void SetHighPriPoolMaxRatio(double high_pri_pool_max_ratio) {
+#ifdef WITH_DIAGNOSE_CACHE
+    if (is_diagnose_) {
+      reinterpret_cast<LRUCacheDiagnosableShard*>(cache_)
+          ->SetHighPriorityPoolMaxRatio(high_pri_pool_max_ratio);
+    } else
+#endif
+    {
+      reinterpret_cast<LRUCacheShard*>(cache_)->SetHighPriorityPoolMaxRatio(
+          high_pri_pool_max_ratio);
+    }
+  }
+
+  double GetHighPriPoolCapacity() {
+#ifdef WITH_DIAGNOSE_CACHE
+    if (is_diagnose_) {
+      return reinterpret_cast<LRUCacheDiagnosableShard*>(cache_)
+          ->TEST_GetHighPriPoolCapacity();
+    }
+#endif
+    return reinterpret_cast<LRUCacheShard*>(cache_)
+        ->TEST_GetHighPriPoolCapacity();
+  }
+
   void ValidateLRUList(std::vector<std::string> keys,
                        size_t num_high_pri_pool_keys = 0) {
     LRUHandle* lru;
@@ -264,6 +288,43 @@ TEST_P(LRUCacheTest, EntriesWithPriority) {
   ValidateLRUList({"e", "f", "g", "Z", "d"}, 2);
 }
 
+TEST_P(LRUCacheTest, AdaptiveHighPriPool) {
+  SetDiagnose(GetParam());
+  // High-pri pool of 2 entries, allowed to grow up to 6.
+  NewCache(10, 0.2);
+  SetHighPriPoolMaxRatio(0.6);
+  ASSERT_EQ(2, GetHighPriPoolCapacity());
+
+  Insert("a", Cache::Priority::LOW);
+  Insert("b", Cache::Priority::LOW);
+  Insert("c", Cache::Priority::LOW);
+  Insert("d", Cache::Priority::LOW);
+  Insert("W", Cache::Priority::HIGH);
+  Insert("X", Cache::Priority::HIGH);
+  Insert("Y", Cache::Priority::HIGH);
+  Insert("Z", Cache::Priority::HIGH);
+  // The pool grows instead of overflowing W and X.
+  ValidateLRUList({"a", "b", "c", "d", "W", "X", "Y", "Z"}, 4);
+  ASSERT_EQ(4, GetHighPriPoolCapacity());
+
+  // Beyond its maximum the pool overflows as usual.
+  Insert("U", Cache::Priority::HIGH);
+  Insert("V", Cache::Priority::HIGH);
+  Insert("T", Cache::Priority::HIGH);
+  ValidateLRUList({"b", "c", "d", "W", "X", "Y", "Z", "U", "V", "T"}, 6);
+  ASSERT_EQ(6, GetHighPriPoolCapacity());
+
+  // Once the working set is gone for a whole window, the pool shrinks back.
+  for (auto key : {"X", "Y", "Z", "U", "V"}) {
+    Erase(key);
+  }
+  for (uint32_t i = 0; i < 2 * LRUCacheShard::kHighPriPoolResizeWindow; i++) {
+    Insert("k" + std::to_string(i), Cache::Priority::LOW);
+  }
+  ASSERT_EQ(2, GetHighPriPoolCapacity());
+  ASSERT_TRUE(Lookup("T"));
+}
+
 #ifdef WITH_DIAGNOSE_CACHE
 
 TEST_F(LRUCacheTest, LRUCacheDiagnosableMonitor) {
@@ -0,0 +1,256 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "cache/quota_cache.h"
+
+#include <inttypes.h>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/mutexlock.h"
+
+namespace TERARKDB_NAMESPACE {
+
+QuotaCache::QuotaCache(std::shared_ptr<Cache> shared, size_t min_reserved,
+                       size_t soft_max)
+    : shared_(std::move(shared)),
+      state_(std::make_shared<State>()),
+      min_reserved_(min_reserved),
+      soft_max_(soft_max),
+      strict_capacity_limit_(false),
+      pinned_usage_(0) {}
+
+QuotaCache::~QuotaCache() {
+  std::vector<Handle*> unpinned(pinned_.begin(), pinned_.end());
+  pinned_.clear();
+  pinned_index_.clear();
+  ReleaseAll(unpinned);
+}
+
+void QuotaCache::DeleteEntry(const Slice& key, void* value) {
+  Entry* e = reinterpret_cast<Entry*>(value);
+  e->state->usage.fetch_sub(e->charge, std::memory_order_relaxed);
+  if (e->deleter != nullptr) {
+    (*e->deleter)(key, e->value);
+  }
+  delete e;
+}
+
+void QuotaCache::Pin(Handle* handle, std::vector<Handle*>* unpinned) {
+  MutexLock l(&mutex_);
+  auto find = pinned_index_.find(handle);
+  if (find != pinned_index_.end()) {
+    pinned_.splice(pinned_.begin(), pinned_, find->second);
+    return;
+  }
+  size_t charge = shared_->GetUsage(handle);
+  if (charge > min_reserved_) {
+    return;
+  }
+  shared_->Ref(handle);
+  pinned_.push_front(handle);
+  pinned_index_.emplace(handle, pinned_.begin());
+  pinned_usage_ += charge;
+  while (pinned_usage_ > min_reserved_) {
+    Handle* victim = pinned_.back();
+    pinned_.pop_back();
+    pinned_index_.erase(victim);
+    pinned_usage_ -= shared_->GetUsage(victim);
+    unpinned->push_back(victim);
+  }
+}
+
+void QuotaCache::Unpin(Handle* handle) {
+  {
+    MutexLock l(&mutex_);
+    auto find = pinned_index_.find(handle);
+    if (find == pinned_index_.end()) {
+      return;
+    }
+    pinned_.erase(find->second);
+    pinned_index_.erase(find);
+    pinned_usage_ -= shared_->GetUsage(handle);
+  }
+  shared_->Release(handle);
+}
+
+void QuotaCache::ReleaseAll(const std::vector<Handle*>& handles) {
+  for (auto handle : handles) {
+    shared_->Release(handle);
+  }
+}
+
+Status QuotaCache::Insert(const Slice& key, void* value, size_t charge,
+                          void (*deleter)(const Slice& key, void* value),
+                          Handle** handle, Priority priority) {
+  bool over_quota = state_->usage.load(std::memory_order_relaxed) + charge >
+                    soft_max_.load(std::memory_order_relaxed);
+  if (over_quota && strict_capacity_limit_.load(std::memory_order_relaxed)) {
+    if (handle == nullptr && deleter != nullptr) {
+      (*deleter)(key, value);
+    }
+    return Status::Incomplete("Insert failed due to quota limit");
+  }
+  Entry* e = new Entry{value, deleter, charge, state_};
+  Handle* h = nullptr;
+  // Beyond the soft maximum, entries are the first to go
+  Status s = shared_->Insert(key, e, charge, &QuotaCache::DeleteEntry, &h,
+                             over_quota ? Priority::LOW : priority);
+  if (!s.ok()) {
+    delete e;
+    if (handle == nullptr && deleter != nullptr) {
+      (*deleter)(key, value);
+    }
+    return s;
+  }
+  // h keeps the entry alive, DeleteEntry can't run before this
+  state_->usage.fetch_add(charge, std::memory_order_relaxed);
+  if (!over_quota && min_reserved_ > 0) {
+    std::vector<Handle*> unpinned;
+    Pin(h, &unpinned);
+    ReleaseAll(unpinned);
+  }
+  if (handle != nullptr) {
+    *handle = h;
+  } else {
+    shared_->Release(h);
+  }
+  return s;
+}
+
+Cache::Handle* QuotaCache::Lookup(const Slice& key, Statistics* stats) {
+  Handle* h = shared_->Lookup(key, stats);
+  if (h != nullptr && min_reserved_ > 0) {
+    std::vector<Handle*> unpinned;
+    Pin(h, &unpinned);
+    ReleaseAll(unpinned);
+  }
+  return h;
+}
+
+bool QuotaCache::Ref(Handle* handle) { return shared_->Ref(handle); }
+
+bool QuotaCache::Release(Handle* handle, bool force_erase) {
+  return shared_->Release(handle, force_erase);
+}
+
+void* QuotaCache::Value(Handle* handle) {
+  return reinterpret_cast<Entry*>(shared_->Value(handle))->value;
+}
+
+void QuotaCache::Erase(const Slice& key) {
+  if (min_reserved_ > 0) {
+    Handle* h = shared_->Lookup(key);
+    if (h != nullptr) {
+      Unpin(h);
+      shared_->Release(h);
+    }
+  }
+  shared_->Erase(key);
+}
+
+uint64_t QuotaCache::NewId() { return shared_->NewId(); }
+
+void QuotaCache::SetCapacity(size_t capacity) {
+  soft_max_.store(capacity, std::memory_order_relaxed);
+}
+
+void QuotaCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
+  strict_capacity_limit_.store(strict_capacity_limit,
+                               std::memory_order_relaxed);
+}
+
+bool QuotaCache::HasStrictCapacityLimit() const {
+  return strict_capacity_limit_.load(std::memory_order_relaxed);
+}
+
+size_t QuotaCache::GetCapacity() const {
+  return soft_max_.load(std::memory_order_relaxed);
+}
+
+size_t QuotaCache::GetUsage() const {
+  return state_->usage.load(std::memory_order_relaxed);
+}
+
+size_t QuotaCache::GetUsage(Handle* handle) const {
+  return shared_->GetUsage(handle);
+}
+
+size_t QuotaCache::GetPinnedUsage() const {
+  MutexLock l(&mutex_);
+  return pinned_usage_;
+}
+
+namespace {
+// ApplyToAllCacheEntries has no context argument, pass the unwrapping state
+// to the callback through the calling thread
+struct ApplyContext {
+  void (*callback)(void*, size_t);
+  const void* state;
+};
+thread_local ApplyContext* apply_context = nullptr;
+}  // namespace
+
+void QuotaCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                        bool thread_safe) {
+  ApplyContext context{callback, state_.get()};
+  ApplyContext* saved = apply_context;
+  apply_context = &context;
+  shared_->ApplyToAllCacheEntries(
+      [](void* value, size_t charge) {
+        Entry* e = reinterpret_cast<Entry*>(value);
+        // Only the entries of this tenant
+        if (e->state.get() == apply_context->state) {
+          apply_context->callback(e->value, charge);
+        }
+      },
+      thread_safe);
+  apply_context = saved;
+}
+
+void QuotaCache::EraseUnRefEntries() {
+  std::vector<Handle*> unpinned;
+  {
+    MutexLock l(&mutex_);
+    unpinned.assign(pinned_.begin(), pinned_.end());
+    pinned_.clear();
+    pinned_index_.clear();
+    pinned_usage_ = 0;
+  }
+  ReleaseAll(unpinned);
+  shared_->EraseUnRefEntries();
+}
+
+std::string QuotaCache::GetPrintableOptions() const {
+  std::string ret;
+  ret.reserve(20000);
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+  snprintf(buffer, kBufferSize, "    min_reserved : %" ROCKSDB_PRIszt "\n",
+           min_reserved_);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "    soft_max : %" ROCKSDB_PRIszt "\n",
+           GetCapacity());
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "    strict_capacity_limit : %d\n",
+           HasStrictCapacityLimit());
+  ret.append(buffer);
+  ret.append(shared_->GetPrintableOptions());
+  return ret;
+}
+
+std::shared_ptr<Cache> NewCacheQuota(std::shared_ptr<Cache> shared,
+                                     size_t min_reserved, size_t soft_max) {
+  if (shared == nullptr || min_reserved > soft_max) {
+    return nullptr;
+  }
+  return std::make_shared<QuotaCache>(std::move(shared), min_reserved,
+                                      soft_max);
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,97 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// A view of a shared cache for one tenant, see NewCacheQuota.
+//
+// Values are wrapped so that the charge of every entry inserted through the
+// view goes back to the tenant when the shared cache frees it. The most
+// recently used entries of the tenant, up to min_reserved bytes, are pinned
+// by holding an extra reference, which keeps other tenants from evicting
+// them.
+class QuotaCache : public Cache {
+ public:
+  QuotaCache(std::shared_ptr<Cache> shared, size_t min_reserved,
+             size_t soft_max);
+  virtual ~QuotaCache();
+
+  virtual const char* Name() const override { return "QuotaCache"; }
+
+  virtual Status Insert(const Slice& key, void* value, size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Handle** handle, Priority priority) override;
+  virtual Handle* Lookup(const Slice& key, Statistics* stats) override;
+  virtual bool Ref(Handle* handle) override;
+  virtual bool Release(Handle* handle, bool force_erase = false) override;
+  virtual void* Value(Handle* handle) override;
+  virtual void Erase(const Slice& key) override;
+  virtual uint64_t NewId() override;
+
+  // The capacity of a view is its soft maximum
+  virtual void SetCapacity(size_t capacity) override;
+  // A strict view rejects inserts beyond its soft maximum
+  virtual void SetStrictCapacityLimit(bool strict_capacity_limit) override;
+  virtual bool HasStrictCapacityLimit() const override;
+  virtual size_t GetCapacity() const override;
+  // Bytes of the tenant's entries residing in the shared cache
+  virtual size_t GetUsage() const override;
+  virtual size_t GetUsage(Handle* handle) const override;
+  // Bytes of the tenant's entries pinned by the reservation
+  virtual size_t GetPinnedUsage() const override;
+  // REQUIRES: every entry of the shared cache was inserted through a view
+  virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                      bool thread_safe) override;
+  // Unpins the reserved entries, then erases unreferenced entries of the
+  // shared cache, including the ones of other tenants
+  virtual void EraseUnRefEntries() override;
+  virtual std::string GetPrintableOptions() const override;
+
+ private:
+  struct State {
+    std::atomic<size_t> usage{0};
+  };
+  struct Entry {
+    void* value;
+    void (*deleter)(const Slice& key, void* value);
+    size_t charge;
+    std::shared_ptr<State> state;
+  };
+
+  static void DeleteEntry(const Slice& key, void* value);
+
+  // Makes handle the most recently used entry of the reservation. Handles
+  // pushed out of the reservation are returned in *unpinned
+  void Pin(Handle* handle, std::vector<Handle*>* unpinned);
+  void Unpin(Handle* handle);
+  void ReleaseAll(const std::vector<Handle*>& handles);
+
+  std::shared_ptr<Cache> shared_;
+  std::shared_ptr<State> state_;
+  const size_t min_reserved_;
+  std::atomic<size_t> soft_max_;
+  std::atomic<bool> strict_capacity_limit_;
+
+  mutable port::Mutex mutex_;
+  // Pinned handles, most recently used first
+  std::list<Handle*> pinned_;
+  std::unordered_map<Handle*, std::list<Handle*>::iterator> pinned_index_;
+  size_t pinned_usage_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
@@ -13,13 +13,84 @@
 
 #include "cache/sharded_cache.h"
 
+#include <algorithm>
 #include <string>
 
+#include "monitoring/statistics.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/mutexlock.h"
 
 namespace TERARKDB_NAMESPACE {
 
+FrequencySketch::FrequencySketch(size_t num_counters) : additions_(0) {
+  // 16 counters per word, at least one word per sketch row
+  size_t num_words = 1;
+  while (num_words * 16 < num_counters) {
+    num_words <<= 1;
+  }
+  mask_ = num_words - 1;
+  table_.reset(new std::atomic<uint64_t>[num_words]);
+  for (size_t i = 0; i < num_words; ++i) {
+    table_[i].store(0, std::memory_order_relaxed);
+  }
+  sample_size_ = num_words * 16 * 10;
+}
+
+void FrequencySketch::Locate(uint32_t hash, int i, size_t* word,
+                             int* shift) const {
+  static const uint64_t kSeeds[kDepth] = {
+      0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+      0xcbf29ce484222325ULL};
+  uint64_t h = (static_cast<uint64_t>(hash) + 1) * kSeeds[i];
+  h ^= h >> 32;
+  *word = static_cast<size_t>(h >> 4) & mask_;
+  *shift = static_cast<int>(h & 15) << 2;
+}
+
+void FrequencySketch::Increment(uint32_t hash) {
+  bool added = false;
+  for (int i = 0; i < kDepth; ++i) {
+    size_t word;
+    int shift;
+    Locate(hash, i, &word, &shift);
+    uint64_t old = table_[word].load(std::memory_order_relaxed);
+    while (((old >> shift) & 15) != 15) {
+      if (table_[word].compare_exchange_weak(old, old + (uint64_t(1) << shift),
+                                             std::memory_order_relaxed)) {
+        added = true;
+        break;
+      }
+    }
+  }
+  if (added && additions_.fetch_add(1, std::memory_order_relaxed) + 1 ==
+                   sample_size_) {
+    Reset();
+  }
+}
+
+uint32_t FrequencySketch::Frequency(uint32_t hash) const {
+  uint32_t frequency = 15;
+  for (int i = 0; i < kDepth; ++i) {
+    size_t word;
+    int shift;
+    Locate(hash, i, &word, &shift);
+    uint32_t count = static_cast<uint32_t>(
+        (table_[word].load(std::memory_order_relaxed) >> shift) & 15);
+    frequency = std::min(frequency, count);
+  }
+  return frequency;
+}
+
+void FrequencySketch::Reset() {
+  for (size_t i = 0; i <= mask_; ++i) {
+    uint64_t old = table_[i].load(std::memory_order_relaxed);
+    while (!table_[i].compare_exchange_weak(
+        old, (old >> 1) & 0x7777777777777777ULL, std::memory_order_relaxed)) {
+    }
+  }
+  additions_.fetch_sub(sample_size_ / 2, std::memory_order_relaxed);
+}
+
 ShardedCache::ShardedCache(size_t capacity, int num_shard_bits,
                            bool strict_capacity_limit,
                            std::shared_ptr<MemoryAllocator> allocator)
@@ -27,7 +98,9 @@ ShardedCache::ShardedCache(size_t capacity, int num_shard_bits,
       num_shard_bits_(num_shard_bits),
       capacity_(capacity),
       strict_capacity_limit_(strict_capacity_limit),
-      last_id_(1) {}
+      last_id_(1),
+      shard_capacity_((capacity + (size_t(1) << num_shard_bits) - 1) >>
+                      num_shard_bits) {}
 
 void ShardedCache::SetCapacity(size_t capacity) {
   int num_shards = 1 << num_shard_bits_;
@@ -37,6 +110,33 @@ void ShardedCache::SetCapacity(size_t capacity) {
     GetShard(s)->SetCapacity(per_shard);
   }
   capacity_ = capacity;
+  shard_capacity_.store(per_shard, std::memory_order_relaxed);
+}
+
+void ShardedCache::SetAdmissionOptions(
+    const CacheAdmissionOptions& admission_options) {
+  if (admission_options.sketch_counters == 0) {
+    admission_sketch_.reset();
+    return;
+  }
+  admission_sketch_.reset(
+      new FrequencySketch(admission_options.sketch_counters));
+  admission_min_frequency_ = admission_options.min_frequency;
+  admission_statistics_ = admission_options.statistics;
+}
+
+bool ShardedCache::Admit(uint32_t hash, size_t charge) {
+  // Admit everything until the shard is full
+  if (GetShard(Shard(hash))->GetUsage() + charge <=
+      shard_capacity_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  if (admission_sketch_->Frequency(hash) >= admission_min_frequency_) {
+    return true;
+  }
+  RecordTick(admission_statistics_.get(), CACHE_ADMISSION_REJECT);
+  RecordTick(admission_statistics_.get(), CACHE_ADMISSION_REJECT_BYTES, charge);
+  return false;
 }
 
 void ShardedCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
@@ -52,12 +152,21 @@ Status ShardedCache::Insert(const Slice& key, void* value, size_t charge,
                             void (*deleter)(const Slice& key, void* value),
                             Handle** handle, Priority priority) {
   uint32_t hash = HashSlice(key);
+  if (admission_sketch_ != nullptr && !Admit(hash, charge)) {
+    if (handle == nullptr && deleter != nullptr) {
+      (*deleter)(key, value);
+    }
+    return Status::Incomplete("Insert rejected by cache admission filter");
+  }
   return GetShard(Shard(hash))
       ->Insert(key, hash, value, charge, deleter, handle, priority);
 }
 
 Cache::Handle* ShardedCache::Lookup(const Slice& key, Statistics* /*stats*/) {
   uint32_t hash = HashSlice(key);
+  if (admission_sketch_ != nullptr) {
+    admission_sketch_->Increment(hash);
+  }
   return GetShard(Shard(hash))->Lookup(key, hash);
 }
 
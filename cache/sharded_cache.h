@@ -10,6 +10,7 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <string>
 
 #include "port/port.h"
@@ -43,6 +44,31 @@ class CacheShard {
   virtual std::string GetPrintableOptions() const { return ""; }
 };
 
+// Count-min sketch of 4-bit counters estimating how often a key hash was seen
+// recently. All counters are halved once the number of increments reaches
+// ten times the number of counters, so old popularity fades out. Thread safe,
+// increments racing with the halving may get lost.
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(size_t num_counters);
+
+  void Increment(uint32_t hash);
+  // Estimated number of increments of hash, at most 15
+  uint32_t Frequency(uint32_t hash) const;
+
+ private:
+  static const int kDepth = 4;
+
+  // Word and nibble shift of the i-th counter of hash
+  void Locate(uint32_t hash, int i, size_t* word, int* shift) const;
+  void Reset();
+
+  size_t mask_;
+  std::unique_ptr<std::atomic<uint64_t>[]> table_;
+  size_t sample_size_;
+  std::atomic<size_t> additions_;
+};
+
 // Generic cache interface which shards cache by hash of keys. 2^num_shard_bits
 // shards will be created, with capacity split evenly to each of the shards.
 // Keys are sharded by the highest num_shard_bits bits of hash value.
@@ -82,7 +108,14 @@ class ShardedCache : public Cache {
 
   int GetNumShardBits() const { return num_shard_bits_; }
 
+  // Puts an admission filter in front of the shards, see
+  // CacheAdmissionOptions. Must be called before the cache is used.
+  void SetAdmissionOptions(const CacheAdmissionOptions& admission_options);
+
  private:
+  // Whether an insert of charge bytes under hash is admitted
+  bool Admit(uint32_t hash, size_t charge);
+
   static inline uint32_t HashSlice(const Slice& s) {
     return Hash(s.data(), s.size(), 0);
   }
@@ -97,6 +130,12 @@ class ShardedCache : public Cache {
   size_t capacity_;
   bool strict_capacity_limit_;
   std::atomic<uint64_t> last_id_;
+
+  // Admission filter, nullptr if disabled
+  std::unique_ptr<FrequencySketch> admission_sketch_;
+  uint32_t admission_min_frequency_ = 0;
+  std::shared_ptr<Statistics> admission_statistics_;
+  std::atomic<size_t> shard_capacity_;
 };
 
 extern int GetDefaultCacheShardBits(size_t capacity);
@@ -42,6 +42,15 @@ namespace TERARKDB_NAMESPACE {
 
 class TableFactory;
 
+namespace {
+void ReportFlushProgress(const CompactionIterationStats& iter_stats) {
+  ThreadStatusUtil::SetThreadOperationProperty(
+      ThreadStatus::FLUSH_PROGRESS_BYTES_DONE,
+      iter_stats.total_input_raw_key_bytes +
+          iter_stats.total_input_raw_value_bytes);
+}
+}  // namespace
+
 TableBuilder* NewTableBuilder(
     const ImmutableCFOptions& ioptions, const MutableCFOptions& moptions,
     const InternalKeyComparator& internal_comparator,
@@ -52,7 +61,7 @@ TableBuilder* NewTableBuilder(
     const CompressionOptions& compression_opts, int level,
     double compaction_load, const std::string* compression_dict,
     bool skip_filters, uint64_t creation_time, uint64_t oldest_key_time,
-    SstPurpose sst_purpose) {
+    SstPurpose sst_purpose, CompactionReason compaction_reason) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
@@ -61,7 +70,8 @@ TableBuilder* NewTableBuilder(
                           int_tbl_prop_collector_factories, compression_type,
                           compression_opts, compression_dict, skip_filters,
                           column_family_name, level, compaction_load,
-                          creation_time, oldest_key_time, sst_purpose),
+                          creation_time, oldest_key_time, sst_purpose,
+                          compaction_reason),
       column_family_id, file);
 }
 
@@ -89,12 +99,14 @@ Status BuildTable(
     EventLogger* event_logger, int job_id, const Env::IOPriority io_priority,
     std::vector<TableProperties>* table_properties_vec, int level,
     double compaction_load, const uint64_t creation_time,
-    const uint64_t oldest_key_time, Env::WriteLifeTimeHint write_hint) {
+    const uint64_t oldest_key_time, Env::WriteLifeTimeHint write_hint,
+    const BlobConfig* blob_config_ptr, CompactionIterationStats* iter_stats) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
   // Reports the IOStats for flush for every following bytes.
   const size_t kReportFlushIOStatsEvery = 1048576;
+  const uint64_t kReportFlushProgressEvery = 1000;
   Status s;
   assert(meta_vec->size() == 1);
   if (table_properties_vec != nullptr) {
@@ -139,15 +151,19 @@ Status BuildTable(
       file->SetIOPriority(io_priority);
       file->SetWriteLifeTimeHint(write_hint);
 
-      file_writer.reset(new WritableFileWriter(std::move(file), fname,
-                                               env_options, ioptions.statistics,
-                                               ioptions.listeners));
+      file_writer.reset(new WritableFileWriter(
+          std::move(file), fname, env_options, ioptions.statistics,
+          ioptions.listeners, ioptions.compaction_buffer_allocator));
       builder = NewTableBuilder(
           ioptions, mutable_cf_options, internal_comparator,
           int_tbl_prop_collector_factories, column_family_id,
           column_family_name, file_writer.get(), compression, compression_opts,
           level, compaction_load, nullptr /* compression_dict */,
-          false /* skip_filters */, creation_time, oldest_key_time);
+          false /* skip_filters */, creation_time, oldest_key_time,
+          kEssenceSst,
+          reason == TableFileCreationReason::kFlush
+              ? CompactionReason::kFlush
+              : CompactionReason::kUnknown);
     }
 
     MergeHelper merge(env, internal_comparator.user_comparator(),
@@ -278,7 +294,8 @@ Status BuildTable(
 
         separate_helper.file_writer.reset(
             new WritableFileWriter(std::move(blob_file), fname, env_options,
-                                   ioptions.statistics, ioptions.listeners));
+                                   ioptions.statistics, ioptions.listeners,
+                                   ioptions.compaction_buffer_allocator));
         separate_helper.builder.reset(NewTableBuilder(
             ioptions, mutable_cf_options, internal_comparator,
             int_tbl_prop_collector_factories_for_blob, column_family_id,
@@ -302,7 +319,9 @@ Status BuildTable(
 
     separate_helper.output = meta_vec;
     separate_helper.prop = table_properties_vec;
-    BlobConfig blob_config = mutable_cf_options.get_blob_config();
+    BlobConfig blob_config = blob_config_ptr != nullptr
+                                 ? *blob_config_ptr
+                                 : mutable_cf_options.get_blob_config();
     if (ioptions.table_factory->IsBuilderNeedSecondPass()) {
       blob_config.blob_size = size_t(-1);
     } else {
@@ -375,7 +394,12 @@ Status BuildTable(
         ThreadStatusUtil::SetThreadOperationProperty(
             ThreadStatus::FLUSH_BYTES_WRITTEN, IOSTATS(bytes_written));
       }
+      if (c_iter.iter_stats().num_input_records % kReportFlushProgressEvery ==
+          0) {
+        ReportFlushProgress(c_iter.iter_stats());
+      }
     }
+    ReportFlushProgress(c_iter.iter_stats());
 
     auto range_del_it = range_del_agg->NewIterator();
     for (range_del_it->SeekToFirst(); s.ok() && range_del_it->Valid();
@@ -388,6 +412,10 @@ Status BuildTable(
                                            tombstone.seq_, internal_comparator);
     }
 
+    if (iter_stats != nullptr) {
+      *iter_stats = c_iter.iter_stats();
+    }
+
     // Finish and check for builder errors
     tp = builder->GetTableProperties();
     bool empty = builder->NumEntries() == 0 && tp.num_range_deletions == 0;
@@ -408,6 +436,8 @@ Status BuildTable(
         sst_meta()->prop.dependence.emplace_back(
             Dependence{blob.fd.GetNumber(), blob.prop.num_entries});
       }
+      sst_meta()->prop.separate_threshold = blob_config.blob_size;
+      sst_meta()->prop.creation_time = creation_time;
       auto shrinked_snapshots = sst_meta()->ShrinkSnapshot(snapshots);
       s = builder->Finish(&sst_meta()->prop, &shrinked_snapshots);
       sst_meta()->prop.num_deletions = tp.num_deletions;
@@ -423,6 +453,9 @@ Status BuildTable(
             builder->GetTableProperties().user_collected_properties,
             &sst_meta()->prop.earliest_time_begin_compact,
             &sst_meta()->prop.latest_time_end_compact);
+        GetTtlExpiryHistogram(
+            builder->GetTableProperties().user_collected_properties,
+            &sst_meta()->prop.ttl_expiry_histogram);
       }
     }
 
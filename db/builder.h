@@ -10,6 +10,7 @@
 #include <utility>
 #include <vector>
 
+#include "db/compaction_iteration_stats.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/table_properties_collector.h"
 #include "db/version_edit.h"
@@ -55,7 +56,8 @@ TableBuilder* NewTableBuilder(
     const CompressionOptions& compression_opts, int level,
     double compaction_load, const std::string* compression_dict = nullptr,
     bool skip_filters = false, uint64_t creation_time = 0,
-    uint64_t oldest_key_time = 0, SstPurpose sst_purpose = kEssenceSst);
+    uint64_t oldest_key_time = 0, SstPurpose sst_purpose = kEssenceSst,
+    CompactionReason compaction_reason = CompactionReason::kUnknown);
 
 // Build a Table file from the contents of *iter.  The generated file
 // will be named according to number specified in meta. On success, the rest of
@@ -65,6 +67,9 @@ TableBuilder* NewTableBuilder(
 //
 // @param column_family_name Name of the column family that is also identified
 //    by column_family_id, or empty string if unknown.
+// @param blob_config Value separation config, nullptr to use the one of
+//    mutable_cf_options.
+// @param iter_stats If non-nullptr, receives the statistics of the input.
 extern Status BuildTable(
     const std::string& dbname, VersionSet* versions_, Env* env,
     const ImmutableCFOptions& options,
@@ -91,6 +96,8 @@ extern Status BuildTable(
     std::vector<TableProperties>* table_properties = nullptr, int level = -1,
     double compaction_load = 0, const uint64_t creation_time = 0,
     const uint64_t oldest_key_time = 0,
-    Env::WriteLifeTimeHint write_hint = Env::WLTH_NOT_SET);
+    Env::WriteLifeTimeHint write_hint = Env::WLTH_NOT_SET,
+    const BlobConfig* blob_config = nullptr,
+    CompactionIterationStats* iter_stats = nullptr);
 
 }  // namespace TERARKDB_NAMESPACE
@@ -58,6 +58,7 @@ using TERARKDB_NAMESPACE::BottommostLevelCompaction;
 using TERARKDB_NAMESPACE::BytewiseComparator;
 using TERARKDB_NAMESPACE::Cache;
 using TERARKDB_NAMESPACE::Checkpoint;
+using TERARKDB_NAMESPACE::Cleanable;
 using TERARKDB_NAMESPACE::ColumnFamilyDescriptor;
 using TERARKDB_NAMESPACE::ColumnFamilyHandle;
 using TERARKDB_NAMESPACE::ColumnFamilyOptions;
@@ -941,6 +942,63 @@ void rocksdb_multi_get_cf(
   }
 }
 
+// The values are handed over to the pinnable slices without a copy
+static void MultiGetPinned(DB* db, const ReadOptions& options,
+                           const std::vector<ColumnFamilyHandle*>& cfs,
+                           size_t num_keys, const char* const* keys_list,
+                           const size_t* keys_list_sizes,
+                           rocksdb_pinnableslice_t** values, char** errs) {
+  std::vector<Slice> keys(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    keys[i] = Slice(keys_list[i], keys_list_sizes[i]);
+  }
+  std::vector<std::string> strings(num_keys);
+  std::vector<Status> statuses = db->MultiGet(options, cfs, keys, &strings);
+  for (size_t i = 0; i < num_keys; i++) {
+    values[i] = nullptr;
+    errs[i] = nullptr;
+    if (statuses[i].ok()) {
+      auto* value = new std::string(std::move(strings[i]));
+      Cleanable cleanable;
+      cleanable.RegisterCleanup(
+          [](void* arg1, void* /*arg2*/) {
+            delete static_cast<std::string*>(arg1);
+          },
+          value, nullptr);
+      values[i] = new rocksdb_pinnableslice_t;
+      values[i]->rep.reset(Slice(*value), std::move(cleanable));
+    } else if (!statuses[i].IsNotFound()) {
+      errs[i] = strdup(statuses[i].ToString().c_str());
+    }
+  }
+}
+
+void rocksdb_multi_get_pinned(rocksdb_t* db,
+                              const rocksdb_readoptions_t* options,
+                              size_t num_keys, const char* const* keys_list,
+                              const size_t* keys_list_sizes,
+                              rocksdb_pinnableslice_t** values, char** errs) {
+  MultiGetPinned(
+      db->rep, options->rep,
+      std::vector<ColumnFamilyHandle*>(num_keys,
+                                       db->rep->DefaultColumnFamily()),
+      num_keys, keys_list, keys_list_sizes, values, errs);
+}
+
+void rocksdb_multi_get_pinned_cf(
+    rocksdb_t* db, const rocksdb_readoptions_t* options,
+    const rocksdb_column_family_handle_t* const* column_families,
+    size_t num_keys, const char* const* keys_list,
+    const size_t* keys_list_sizes, rocksdb_pinnableslice_t** values,
+    char** errs) {
+  std::vector<ColumnFamilyHandle*> cfs(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    cfs[i] = column_families[i]->rep;
+  }
+  MultiGetPinned(db->rep, options->rep, cfs, num_keys, keys_list,
+                 keys_list_sizes, values, errs);
+}
+
 rocksdb_iterator_t* rocksdb_create_iterator(
     rocksdb_t* db, const rocksdb_readoptions_t* options) {
   rocksdb_iterator_t* result = new rocksdb_iterator_t;
@@ -1220,6 +1278,21 @@ const char* rocksdb_iter_value(const rocksdb_iterator_t* iter, size_t* vlen) {
   return s.data();
 }
 
+unsigned char rocksdb_iter_entry(const rocksdb_iterator_t* iter,
+                                 const char** key, size_t* klen,
+                                 const char** value, size_t* vlen) {
+  if (!iter->rep->Valid()) {
+    return 0;
+  }
+  Slice k = iter->rep->key();
+  *key = k.data();
+  *klen = k.size();
+  Slice v = iter->rep->value();
+  *value = v.data();
+  *vlen = v.size();
+  return 1;
+}
+
 void rocksdb_iter_get_error(const rocksdb_iterator_t* iter, char** errptr) {
   SaveError(errptr, iter->rep->status());
 }
@@ -1288,6 +1361,30 @@ void rocksdb_writebatch_putv_cf(rocksdb_writebatch_t* b,
              SliceParts(value_slices.data(), num_values));
 }
 
+void rocksdb_writebatch_put_many(rocksdb_writebatch_t* b, size_t num_entries,
+                                 const char* const* keys_list,
+                                 const size_t* keys_list_sizes,
+                                 const char* const* values_list,
+                                 const size_t* values_list_sizes) {
+  for (size_t i = 0; i < num_entries; i++) {
+    b->rep.Put(Slice(keys_list[i], keys_list_sizes[i]),
+               Slice(values_list[i], values_list_sizes[i]));
+  }
+}
+
+void rocksdb_writebatch_put_many_cf(
+    rocksdb_writebatch_t* b,
+    rocksdb_column_family_handle_t* const* column_families,
+    size_t num_entries, const char* const* keys_list,
+    const size_t* keys_list_sizes, const char* const* values_list,
+    const size_t* values_list_sizes) {
+  for (size_t i = 0; i < num_entries; i++) {
+    b->rep.Put(column_families[i]->rep,
+               Slice(keys_list[i], keys_list_sizes[i]),
+               Slice(values_list[i], values_list_sizes[i]));
+  }
+}
+
 void rocksdb_writebatch_merge(rocksdb_writebatch_t* b, const char* key,
                               size_t klen, const char* val, size_t vlen) {
   b->rep.Merge(Slice(key, klen), Slice(val, vlen));
@@ -2302,6 +2399,11 @@ void rocksdb_options_set_use_adaptive_mutex(rocksdb_options_t* opt,
   opt->rep.use_adaptive_mutex = v;
 }
 
+void rocksdb_options_set_use_async_file_writes(rocksdb_options_t* opt,
+                                               unsigned char v) {
+  opt->rep.use_async_file_writes = v;
+}
+
 void rocksdb_options_set_wal_bytes_per_sync(rocksdb_options_t* opt,
                                             uint64_t v) {
   opt->rep.wal_bytes_per_sync = v;
@@ -2430,6 +2532,11 @@ void rocksdb_options_set_max_manifest_edit_count(rocksdb_options_t* opt,
   opt->rep.max_manifest_edit_count = v;
 }
 
+void rocksdb_options_set_max_manifest_tail_ratio(rocksdb_options_t* opt,
+                                                 double v) {
+  opt->rep.max_manifest_tail_ratio = v;
+}
+
 void rocksdb_options_set_table_cache_numshardbits(rocksdb_options_t* opt,
                                                   int v) {
   opt->rep.table_cache_numshardbits = v;
@@ -3987,6 +4094,9 @@ rocksdb_pinnableslice_t* rocksdb_get_pinned(
   rocksdb_pinnableslice_t* v = new (rocksdb_pinnableslice_t);
   Status s = db->rep->Get(options->rep, db->rep->DefaultColumnFamily(),
                           Slice(key, keylen), &v->rep);
+  if (s.ok()) {
+    s = v->rep.fetch();
+  }
   if (!s.ok()) {
     delete (v);
     if (!s.IsNotFound()) {
@@ -4004,6 +4114,9 @@ rocksdb_pinnableslice_t* rocksdb_get_pinned_cf(
   rocksdb_pinnableslice_t* v = new (rocksdb_pinnableslice_t);
   Status s = db->rep->Get(options->rep, column_family->rep, Slice(key, keylen),
                           &v->rep);
+  if (s.ok()) {
+    s = v->rep.fetch();
+  }
   if (!s.ok()) {
     delete v;
     if (!s.IsNotFound()) {
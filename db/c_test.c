@@ -766,6 +766,28 @@ int main(int argc, char** argv) {
     rocksdb_writebatch_destroy(wb);
   }
 
+  StartPhase("writebatch_put_many");
+  {
+    rocksdb_writebatch_t* wb = rocksdb_writebatch_create();
+    const char* k_list[2] = { "zap", "zip" };
+    const size_t k_sizes[2] = { 3, 3 };
+    const char* v_list[2] = { "x", "yz" };
+    const size_t v_sizes[2] = { 1, 2 };
+    rocksdb_writebatch_put_many(wb, 2, k_list, k_sizes, v_list, v_sizes);
+    CheckCondition(rocksdb_writebatch_count(wb) == 2);
+    rocksdb_write(db, woptions, wb, &err);
+    CheckNoError(err);
+    CheckGet(db, roptions, "zap", "x");
+    CheckGet(db, roptions, "zip", "yz");
+    rocksdb_writebatch_clear(wb);
+    rocksdb_writebatch_delete(wb, "zap", 3);
+    rocksdb_writebatch_delete(wb, "zip", 3);
+    rocksdb_write(db, woptions, wb, &err);
+    CheckNoError(err);
+    CheckGet(db, roptions, "zap", NULL);
+    rocksdb_writebatch_destroy(wb);
+  }
+
   StartPhase("writebatch_savepoint");
   {
     rocksdb_writebatch_t* wb = rocksdb_writebatch_create();
@@ -911,6 +933,18 @@ int main(int argc, char** argv) {
     CheckIter(iter, "box", "c");
     rocksdb_iter_get_error(iter, &err);
     CheckNoError(err);
+    {
+      const char* k;
+      const char* v;
+      size_t klen, vlen;
+      rocksdb_iter_seek_to_first(iter);
+      CheckCondition(rocksdb_iter_entry(iter, &k, &klen, &v, &vlen));
+      CheckEqual("box", k, klen);
+      CheckEqual("c", v, vlen);
+      rocksdb_iter_seek_to_last(iter);
+      rocksdb_iter_next(iter);
+      CheckCondition(!rocksdb_iter_entry(iter, &k, &klen, &v, &vlen));
+    }
     rocksdb_iter_destroy(iter);
   }
 
@@ -979,6 +1013,36 @@ int main(int argc, char** argv) {
     CheckPinGet(db, roptions, "notfound", NULL);
   }
 
+  StartPhase("multiget_pinned");
+  {
+    const char* keys[3] = { "box", "foo", "notfound" };
+    const size_t keys_sizes[3] = { 3, 3, 8 };
+    rocksdb_pinnableslice_t* vals[3];
+    char* errs[3];
+    const char* val;
+    size_t val_len;
+    rocksdb_multi_get_pinned(db, roptions, 3, keys, keys_sizes, vals, errs);
+
+    int i;
+    for (i = 0; i < 3; i++) {
+      CheckEqual(NULL, errs[i], 0);
+      val = rocksdb_pinnableslice_value(vals[i], &val_len);
+      switch (i) {
+      case 0:
+        CheckEqual("c", val, val_len);
+        break;
+      case 1:
+        CheckEqual("hello", val, val_len);
+        break;
+      case 2:
+        CheckCondition(vals[i] == NULL);
+        CheckEqual(NULL, val, val_len);
+        break;
+      }
+      rocksdb_pinnableslice_destroy(vals[i]);
+    }
+  }
+
   StartPhase("approximate_sizes");
   {
     int i;
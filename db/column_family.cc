@@ -31,6 +31,7 @@
 #include "db/write_controller.h"
 #include "memtable/hash_skiplist_rep.h"
 #include "monitoring/thread_status_util.h"
+#include "monitoring/usdt.h"
 #include "options/options_helper.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/merging_iterator.h"
@@ -332,20 +333,22 @@ ColumnFamilyOptions SanitizeOptions(const ImmutableDBOptions& db_options,
   if (result.blob_large_key_ratio < 0) {
     result.blob_large_key_ratio = 0;
   }
+  if (result.blob_target_write_amp < 0) {
+    result.blob_target_write_amp = 0;
+  }
   if (result.blob_gc_ratio > 0.5) {
     result.blob_gc_ratio = 0.5;
   }
   if (result.blob_gc_ratio < 0) {
     result.blob_gc_ratio = 0;
   }
+  if (result.blob_gc_hotness_weight < 0) {
+    result.blob_gc_hotness_weight = 0;
+  }
 
   return result;
 }
 
-int SuperVersion::dummy = 0;
-void* const SuperVersion::kSVInUse = &SuperVersion::dummy;
-void* const SuperVersion::kSVObsolete = nullptr;
-
 SuperVersion::~SuperVersion() {
   for (auto td : to_delete) {
     delete td;
@@ -388,23 +391,6 @@ void SuperVersion::Init(MemTable* new_mem, MemTableListVersion* new_imm,
   refs.store(1, std::memory_order_relaxed);
 }
 
-namespace {
-void SuperVersionUnrefHandle(void* ptr) {
-  // UnrefHandle is called when a thread exists or a ThreadLocalPtr gets
-  // destroyed. When former happens, the thread shouldn't see kSVInUse.
-  // When latter happens, we are in ~ColumnFamilyData(), no get should happen as
-  // well.
-  SuperVersion* sv = static_cast<SuperVersion*>(ptr);
-  bool was_last_ref __attribute__((__unused__));
-  was_last_ref = sv->Unref();
-  // Thread-local SuperVersions can't outlive ColumnFamilyData::super_version_.
-  // This is important because we can't do SuperVersion cleanup here.
-  // That would require locking DB mutex, which would deadlock because
-  // SuperVersionUnrefHandle is called with locked ThreadLocalPtr mutex.
-  assert(!was_last_ref);
-}
-}  // anonymous namespace
-
 ColumnFamilyData::ColumnFamilyData(
     uint32_t id, const std::string& name, Version* _dummy_versions,
     Cache* _table_cache, WriteBufferManager* write_buffer_manager,
@@ -430,7 +416,8 @@ ColumnFamilyData::ColumnFamilyData(
            ioptions_.max_write_buffer_number_to_maintain),
       super_version_(nullptr),
       super_version_number_(0),
-      local_sv_(new ThreadLocalPtr(&SuperVersionUnrefHandle)),
+      current_super_version_(nullptr),
+      num_retired_super_versions_(0),
       next_(nullptr),
       prev_(nullptr),
       log_number_(0),
@@ -440,6 +427,8 @@ ColumnFamilyData::ColumnFamilyData(
       queued_for_compaction_(false),
       queued_for_garbage_collection_(false),
       prev_compaction_needed_bytes_(0),
+      delayed_write_rate_target_(0),
+      write_stall_cause_(WriteStallCause::kNone),
       allow_2pc_(db_options.allow_2pc),
       last_memtable_id_(0) {
   Ref();
@@ -448,6 +437,30 @@ ColumnFamilyData::ColumnFamilyData(
   if (_dummy_versions != nullptr) {
     internal_stats_.reset(
         new InternalStats(ioptions_.num_levels, db_options.env, this));
+    metrics_reporter_factory_ = db_options.metrics_reporter_factory;
+    if (metrics_reporter_factory_ != nullptr) {
+      std::string tags =
+          "dbname=" + column_family_set_->db_name_ + "|cfname=" + name;
+      auto build = [&](const char* metric_name) {
+        return metrics_reporter_factory_->BuildHistReporter(
+            metric_name, tags, db_options.info_log.get());
+      };
+      latency_reporters_.superversion_acquire =
+          build("cfd_superversion_acquire_latency");
+      latency_reporters_.blob_fetch = build("cfd_blob_fetch_latency");
+      latency_reporters_.flush_build_table =
+          build("cfd_flush_build_table_latency");
+      latency_reporters_.compaction_finish_table =
+          build("cfd_compaction_finish_table_latency");
+      latency_reporters_.map_sst_build = build("cfd_map_sst_build_latency");
+      latency_reporters_.gc_rewrite = build("cfd_gc_rewrite_latency");
+      latency_reporters_.remote_compaction =
+          build("cfd_remote_compaction_latency");
+    }
+    if (db_options.negative_lookup_cache_size > 0) {
+      negative_lookup_cache_.reset(
+          new NegativeLookupCache(db_options.negative_lookup_cache_size));
+    }
     table_cache_.reset(new TableCache(ioptions_, env_options, _table_cache));
     if (ioptions_.compaction_style == kCompactionStyleLevel) {
       compaction_picker_.reset(new LevelCompactionPicker(
@@ -512,13 +525,17 @@ ColumnFamilyData::~ColumnFamilyData() {
   assert(!queued_for_compaction_);
   assert(!queued_for_garbage_collection_);
 
-  if (super_version_ != nullptr) {
-    // Release SuperVersion reference kept in ThreadLocalPtr.
-    // This must be done outside of mutex_ since unref handler can lock mutex.
-    super_version_->db_mutex->Unlock();
-    local_sv_.reset();
-    super_version_->db_mutex->Lock();
+  // No reader is left, the retired SuperVersions are released whatever the
+  // epochs of the other column families
+  for (auto& retired : retired_super_versions_) {
+    if (retired.second->Unref()) {
+      retired.second->Cleanup();
+      delete retired.second;
+    }
+  }
+  retired_super_versions_.clear();
 
+  if (super_version_ != nullptr) {
     bool is_last_reference __attribute__((__unused__));
     is_last_reference = super_version_->Unref();
     assert(is_last_reference);
@@ -586,13 +603,13 @@ const double kNearStopSlowdownRatio = 0.6;
 const double kDelayRecoverSlowdownRatio = 1.4;
 
 namespace {
+const uint64_t kMinWriteRate = 16 * 1024u;  // Minimum write rate 16KB/s.
+
 // If penalize_stop is true, we further reduce slowdown rate.
 std::unique_ptr<WriteControllerToken> SetupDelay(
     WriteController* write_controller, uint64_t compaction_needed_bytes,
     uint64_t prev_compaction_need_bytes, bool penalize_stop,
     bool auto_comapctions_disabled) {
-  const uint64_t kMinWriteRate = 16 * 1024u;  // Minimum write rate 16KB/s.
-
   uint64_t max_write_rate = write_controller->max_delayed_write_rate();
   uint64_t write_rate = write_controller->delayed_write_rate();
 
@@ -650,6 +667,74 @@ std::unique_ptr<WriteControllerToken> SetupDelay(
   return write_controller->GetDelayToken(write_rate);
 }
 
+// How far a delayed column family has moved from its slowdown triggers
+// towards its stop triggers: 0 at the slowdown trigger, 1 at the stop
+// trigger, taking the worst of all causes.
+double GetWriteStallPressure(int num_unflushed_memtables, int num_l0_files,
+                             int read_amp, uint64_t compaction_needed_bytes,
+                             double garbage_ratio, int num_levels,
+                             const MutableCFOptions& mutable_cf_options) {
+  auto progress = [](double value, double slowdown, double stop) {
+    if (stop <= slowdown) {
+      return value >= slowdown ? 1.0 : 0.0;
+    }
+    return std::min(std::max((value - slowdown) / (stop - slowdown), 0.0),
+                    1.0);
+  };
+  double pressure = 0;
+  if (mutable_cf_options.max_write_buffer_number > 3) {
+    pressure = progress(num_unflushed_memtables,
+                        mutable_cf_options.max_write_buffer_number - 2,
+                        mutable_cf_options.max_write_buffer_number);
+  }
+  if (mutable_cf_options.disable_auto_compactions) {
+    return pressure;
+  }
+  if (mutable_cf_options.level0_slowdown_writes_trigger >= 0) {
+    pressure = std::max(
+        pressure, progress(num_l0_files,
+                           mutable_cf_options.level0_slowdown_writes_trigger,
+                           mutable_cf_options.level0_stop_writes_trigger));
+    pressure = std::max(
+        pressure, progress(read_amp - num_levels,
+                           mutable_cf_options.level0_slowdown_writes_trigger,
+                           mutable_cf_options.level0_stop_writes_trigger));
+  }
+  uint64_t soft_limit = mutable_cf_options.soft_pending_compaction_bytes_limit;
+  uint64_t hard_limit = mutable_cf_options.hard_pending_compaction_bytes_limit;
+  if (soft_limit > 0) {
+    pressure = std::max(
+        pressure,
+        progress(static_cast<double>(compaction_needed_bytes),
+                 static_cast<double>(soft_limit),
+                 static_cast<double>(hard_limit > 0 ? hard_limit
+                                                    : 4 * soft_limit)));
+  }
+  // Garbage well past the GC trigger means GC is behind on the blobs that
+  // writes keep turning into garbage
+  if (mutable_cf_options.blob_gc_ratio > 0) {
+    pressure = std::max(
+        pressure, progress(garbage_ratio, 2 * mutable_cf_options.blob_gc_ratio,
+                           4 * mutable_cf_options.blob_gc_ratio));
+  }
+  return pressure;
+}
+
+// The rate falls with the square of the pressure, so writes slow down
+// gently near the slowdown triggers and firmly near the stop triggers.
+uint64_t GetSmoothDelayRate(WriteController* write_controller,
+                            double pressure, bool auto_comapctions_disabled) {
+  uint64_t max_write_rate = write_controller->max_delayed_write_rate();
+  if (auto_comapctions_disabled || max_write_rate <= kMinWriteRate) {
+    return max_write_rate;
+  }
+  double headroom = (1 - pressure) * (1 - pressure);
+  return kMinWriteRate + static_cast<uint64_t>(
+                             static_cast<double>(max_write_rate -
+                                                 kMinWriteRate) *
+                             headroom);
+}
+
 int GetL0ThresholdSpeedupCompaction(int level0_file_num_compaction_trigger,
                                     int level0_slowdown_writes_trigger) {
   // SanitizeOptions() ensures it.
@@ -683,7 +768,7 @@ int GetL0ThresholdSpeedupCompaction(int level0_file_num_compaction_trigger,
 }
 }  // namespace
 
-std::pair<WriteStallCondition, ColumnFamilyData::WriteStallCause>
+std::pair<WriteStallCondition, WriteStallCause>
 ColumnFamilyData::GetWriteStallConditionAndCause(
     int num_unflushed_memtables, int num_l0_files, int read_amp,
     uint64_t num_compaction_needed_bytes, int num_levels,
@@ -742,9 +827,30 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
         mutable_cf_options);
     write_stall_condition = write_stall_condition_and_cause.first;
     auto write_stall_cause = write_stall_condition_and_cause.second;
+    write_stall_cause_ = write_stall_cause;
 
     bool was_stopped = write_controller->IsStopped();
     bool needed_delay = write_controller->NeedsDelay();
+    delayed_write_rate_target_ = 0;
+    auto setup_delay = [&](bool penalize_stop) {
+      if (column_family_set_->db_options_->smooth_write_delay) {
+        double pressure = GetWriteStallPressure(
+            imm()->NumNotFlushed(), vstorage->l0_delay_trigger_count(),
+            int(vstorage->read_amplification()), compaction_needed_bytes,
+            vstorage->total_garbage_ratio(), ioptions_.num_levels,
+            mutable_cf_options);
+        delayed_write_rate_target_ =
+            GetSmoothDelayRate(write_controller, pressure,
+                               mutable_cf_options.disable_auto_compactions);
+        return write_controller->GetSmoothDelayToken(
+            delayed_write_rate_target_);
+      }
+      auto token = SetupDelay(write_controller, compaction_needed_bytes,
+                              prev_compaction_needed_bytes_, penalize_stop,
+                              mutable_cf_options.disable_auto_compactions);
+      delayed_write_rate_target_ = write_controller->delayed_write_rate();
+      return token;
+    };
 
     if (write_stall_condition == WriteStallCondition::kStopped &&
         write_stall_cause == WriteStallCause::kMemtableLimit) {
@@ -788,10 +894,7 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
           name_.c_str(), vstorage->read_amplification());
     } else if (write_stall_condition == WriteStallCondition::kDelayed &&
                write_stall_cause == WriteStallCause::kMemtableLimit) {
-      write_controller_token_ =
-          SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped,
-                     mutable_cf_options.disable_auto_compactions);
+      write_controller_token_ = setup_delay(was_stopped);
       internal_stats_->AddCFStats(InternalStats::MEMTABLE_LIMIT_SLOWDOWNS, 1);
       ROCKS_LOG_WARN(
           ioptions_.info_log,
@@ -806,10 +909,7 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
       // L0 is the last two files from stopping.
       bool near_stop = vstorage->l0_delay_trigger_count() >=
                        mutable_cf_options.level0_stop_writes_trigger - 2;
-      write_controller_token_ =
-          SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped || near_stop,
-                     mutable_cf_options.disable_auto_compactions);
+      write_controller_token_ = setup_delay(was_stopped || near_stop);
       internal_stats_->AddCFStats(InternalStats::L0_FILE_COUNT_LIMIT_SLOWDOWNS,
                                   1);
       if (compaction_picker_->IsLevel0CompactionInProgress()) {
@@ -835,10 +935,7 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
                    mutable_cf_options.soft_pending_compaction_bytes_limit) /
                   4;
 
-      write_controller_token_ =
-          SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped || near_stop,
-                     mutable_cf_options.disable_auto_compactions);
+      write_controller_token_ = setup_delay(was_stopped || near_stop);
       internal_stats_->AddCFStats(
           InternalStats::PENDING_COMPACTION_BYTES_LIMIT_SLOWDOWNS, 1);
       ROCKS_LOG_WARN(
@@ -851,10 +948,7 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
                write_stall_cause == WriteStallCause::kReadAmpLimit) {
       bool near_stop = vstorage->read_amplification() - ioptions_.num_levels >=
                        mutable_cf_options.level0_stop_writes_trigger - 2;
-      write_controller_token_ =
-          SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped || near_stop,
-                     mutable_cf_options.disable_auto_compactions);
+      write_controller_token_ = setup_delay(was_stopped || near_stop);
       internal_stats_->AddCFStats(InternalStats::READ_AMP_LIMIT_SLOWDOWNS, 1);
       ROCKS_LOG_WARN(
           ioptions_.info_log,
@@ -920,6 +1014,27 @@ const EnvOptions* ColumnFamilyData::soptions() const {
 
 void ColumnFamilyData::SetCurrent(Version* current_version) {
   current_ = current_version;
+  if (mutable_cf_options_.blob_target_write_amp <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(value_size_mutex_);
+  if (value_sizes_recorded_) {
+    return;
+  }
+  // Keep the threshold the newest table was written with across reopen
+  auto* vstorage = current_version->storage_info();
+  uint64_t newest_file_number = 0;
+  size_t threshold = 0;
+  for (int level = 0; level < vstorage->num_levels(); ++level) {
+    for (auto* f : vstorage->LevelFiles(level)) {
+      if (f->prop.separate_threshold != 0 &&
+          f->fd.GetNumber() > newest_file_number) {
+        newest_file_number = f->fd.GetNumber();
+        threshold = static_cast<size_t>(f->prop.separate_threshold);
+      }
+    }
+  }
+  recorded_separate_threshold_ = threshold;
 }
 
 void ColumnFamilyData::ForEachVersionList(void (*callback)(void*, Version*),
@@ -945,9 +1060,11 @@ uint64_t ColumnFamilyData::GetLiveSstFilesSize() const {
 MemTable* ColumnFamilyData::ConstructNewMemtable(
     const MutableCFOptions& mutable_cf_options, bool needs_dup_key_check,
     SequenceNumber earliest_seq) {
-  return new MemTable(internal_comparator_, ioptions_, mutable_cf_options,
-                      needs_dup_key_check, write_buffer_manager_, earliest_seq,
-                      id_);
+  auto mem =
+      new MemTable(internal_comparator_, ioptions_, mutable_cf_options,
+                   needs_dup_key_check, write_buffer_manager_, earliest_seq, id_);
+  mem->SetNegativeLookupCache(negative_lookup_cache_.get());
+  return mem;
 }
 
 void ColumnFamilyData::CreateNewMemtable(
@@ -970,6 +1087,7 @@ bool ColumnFamilyData::NeedsGarbageCollection() const {
   auto vstorage = current_->storage_info();
   return !vstorage->IsPickGarbageCollectionFail() &&
          (vstorage->blob_marked_for_compaction() ||
+          vstorage->space_amp_gc_needed() ||
           vstorage->total_garbage_ratio() >= mutable_cf_options_.blob_gc_ratio);
 }
 
@@ -1106,81 +1224,48 @@ Compaction* ColumnFamilyData::CompactRange(
 
 SuperVersion* ColumnFamilyData::GetReferencedSuperVersion(DBImpl* db) {
   SuperVersion* sv = GetThreadLocalSuperVersion(db);
+  // The epoch keeps the reference of sv as super_version_ until this one is
+  // taken
   sv->Ref();
-  if (!ReturnThreadLocalSuperVersion(sv)) {
-    // This Unref() corresponds to the Ref() in GetThreadLocalSuperVersion()
-    // when the thread-local pointer was populated. So, the Ref() earlier in
-    // this function still prevents the returned SuperVersion* from being
-    // deleted out from under the caller.
-    sv->Unref();
-  }
+  ReturnThreadLocalSuperVersion(sv);
   return sv;
 }
 
-SuperVersion* ColumnFamilyData::GetThreadLocalSuperVersion(DBImpl* db) {
-  // The SuperVersion is cached in thread local storage to avoid acquiring
-  // mutex when SuperVersion does not change since the last use. When a new
-  // SuperVersion is installed, the compaction or flush thread cleans up
-  // cached SuperVersion in all existing thread local storage. To avoid
-  // acquiring mutex for this operation, we use atomic Swap() on the thread
-  // local pointer to guarantee exclusive access. If the thread local pointer
-  // is being used while a new SuperVersion is installed, the cached
-  // SuperVersion can become stale. In that case, the background thread would
-  // have swapped in kSVObsolete. We re-check the value at when returning
-  // SuperVersion back to thread local, with an atomic compare and swap.
-  // The superversion will need to be released if detected to be stale.
-  void* ptr = local_sv_->Swap(SuperVersion::kSVInUse);
-  // Invariant:
-  // (1) Scrape (always) installs kSVObsolete in ThreadLocal storage
-  // (2) the Swap above (always) installs kSVInUse, ThreadLocal storage
-  // should only keep kSVInUse before ReturnThreadLocalSuperVersion call
-  // (if no Scrape happens).
-  assert(ptr != SuperVersion::kSVInUse);
-  SuperVersion* sv = static_cast<SuperVersion*>(ptr);
-  if (sv == SuperVersion::kSVObsolete ||
-      sv->version_number != super_version_number_.load()) {
-    RecordTick(ioptions_.statistics, NUMBER_SUPERVERSION_ACQUIRES);
-    SuperVersion* sv_to_delete = nullptr;
-
-    if (sv && sv->Unref()) {
-      RecordTick(ioptions_.statistics, NUMBER_SUPERVERSION_CLEANUPS);
-      db->mutex()->Lock();
-      // NOTE: underlying resources held by superversion (sst files) might
-      // not be released until the next background job.
-      sv->Cleanup();
-      sv_to_delete = sv;
-    } else {
-      db->mutex()->Lock();
-    }
-    sv = super_version_->Ref();
-    if (db->immutable_db_options().avoid_unnecessary_blocking_io) {
-      db->ScheduleBgFree(nullptr, sv_to_delete);
-      sv_to_delete = nullptr;
-    }
-    db->mutex()->Unlock();
-
-    delete sv_to_delete;
-  }
+SuperVersion* ColumnFamilyData::GetThreadLocalSuperVersion(DBImpl* /*db*/) {
+  LatencyHistGuard guard(latency_reporters_.superversion_acquire);
+  TERARKDB_PROBE1(superversion_acquire_start, id_);
+  // The reader only announces the current epoch in the slot of its thread
+  // and loads the SuperVersion, no reference count or thread local pointer
+  // of this column family is touched. InstallSuperVersion() retires the
+  // replaced SuperVersion in the epoch it was replaced in, its reference is
+  // released once no thread is in that epoch or an older one anymore.
+  EpochManager::Default()->Enter();
+  SuperVersion* sv = current_super_version_.load(std::memory_order_seq_cst);
   assert(sv != nullptr);
+  TERARKDB_PROBE2(superversion_acquire_done, id_, false);
   return sv;
 }
 
-bool ColumnFamilyData::ReturnThreadLocalSuperVersion(SuperVersion* sv) {
+void ColumnFamilyData::ReturnThreadLocalSuperVersion(SuperVersion* sv) {
   assert(sv != nullptr);
-  // Put the SuperVersion back
-  void* expected = SuperVersion::kSVInUse;
-  if (local_sv_->CompareAndSwap(static_cast<void*>(sv), expected)) {
-    // When we see kSVInUse in the ThreadLocal, we are sure ThreadLocal
-    // storage has not been altered and no Scrape has happened. The
-    // SuperVersion is still current.
-    return true;
-  } else {
-    // ThreadLocal scrape happened in the process of this GetImpl call (after
-    // thread local Swap() at the beginning and before CompareAndSwap()).
-    // This means the SuperVersion it holds is obsolete.
-    assert(expected == SuperVersion::kSVObsolete);
+  (void)sv;
+  EpochManager::Default()->Exit();
+}
+
+void ColumnFamilyData::PopExpiredSuperVersions(
+    autovector<SuperVersion*>* expired) {
+  std::lock_guard<std::mutex> lock(retired_super_versions_mutex_);
+  if (retired_super_versions_.empty()) {
+    return;
+  }
+  uint64_t min_active_epoch = EpochManager::Default()->MinActiveEpoch();
+  while (!retired_super_versions_.empty() &&
+         retired_super_versions_.front().first < min_active_epoch) {
+    expired->push_back(retired_super_versions_.front().second);
+    retired_super_versions_.pop_front();
   }
-  return false;
+  num_retired_super_versions_.store(retired_super_versions_.size(),
+                                    std::memory_order_relaxed);
 }
 
 void ColumnFamilyData::InstallSuperVersion(SuperVersionContext* sv_context,
@@ -1199,50 +1284,58 @@ void ColumnFamilyData::InstallSuperVersion(
   new_superversion->Init(mem_, imm_.current(), current_);
   SuperVersion* old_superversion = super_version_;
   super_version_ = new_superversion;
+  current_super_version_.store(new_superversion, std::memory_order_seq_cst);
   ++super_version_number_;
   super_version_->version_number = super_version_number_;
+  WriteStallCause old_write_stall_cause = write_stall_cause_;
   super_version_->write_stall_condition =
       RecalculateWriteStallConditions(mutable_cf_options);
 
   if (old_superversion != nullptr) {
-    // Reset SuperVersions cached in thread local storage.
-    // This should be done before old_superversion->Unref(). That's to ensure
-    // that local_sv_ never holds the last reference to SuperVersion, since
-    // it has no means to safely do SuperVersion cleanup.
-    ResetThreadLocalSuperVersions();
+    // Readers that loaded old_superversion are in this epoch or an older one
+    uint64_t epoch = EpochManager::Default()->Retire();
+    {
+      std::lock_guard<std::mutex> lock(retired_super_versions_mutex_);
+      retired_super_versions_.emplace_back(epoch, old_superversion);
+      num_retired_super_versions_.store(retired_super_versions_.size(),
+                                        std::memory_order_relaxed);
+    }
 
     if (old_superversion->mutable_cf_options.write_buffer_size !=
         mutable_cf_options.write_buffer_size) {
       mem_->UpdateWriteBufferSize(mutable_cf_options.write_buffer_size);
     }
     if (old_superversion->write_stall_condition !=
-        new_superversion->write_stall_condition) {
-      sv_context->PushWriteStallNotification(
-          old_superversion->write_stall_condition,
-          new_superversion->write_stall_condition, GetName(), ioptions());
-    }
-    if (old_superversion->Unref()) {
-      old_superversion->Cleanup();
-      sv_context->superversions_to_free.push_back(old_superversion);
+            new_superversion->write_stall_condition ||
+        old_write_stall_cause != write_stall_cause_) {
+      WriteStallInfo info;
+      info.cf_name = GetName();
+      info.condition.prev = old_superversion->write_stall_condition;
+      info.condition.cur = new_superversion->write_stall_condition;
+      info.cause.prev = old_write_stall_cause;
+      info.cause.cur = write_stall_cause_;
+      info.num_unflushed_memtables = imm()->NumNotFlushed();
+      info.num_l0_files = 0;
+      info.pending_compaction_bytes = 0;
+      info.read_amplification = 0;
+      if (current_ != nullptr) {
+        auto* vstorage = current_->storage_info();
+        info.num_l0_files = vstorage->l0_delay_trigger_count();
+        info.pending_compaction_bytes =
+            vstorage->estimated_compaction_needed_bytes();
+        info.read_amplification = vstorage->read_amplification();
+      }
+      sv_context->PushWriteStallNotification(info, ioptions());
     }
-  }
-}
-
-void ColumnFamilyData::ResetThreadLocalSuperVersions() {
-  autovector<void*> sv_ptrs;
-  local_sv_->Scrape(&sv_ptrs, SuperVersion::kSVObsolete);
-  for (auto ptr : sv_ptrs) {
-    assert(ptr);
-    if (ptr == SuperVersion::kSVInUse) {
-      continue;
+    // Usually no reader is left, and old_superversion is released right away
+    autovector<SuperVersion*> expired;
+    PopExpiredSuperVersions(&expired);
+    for (auto sv : expired) {
+      if (sv->Unref()) {
+        sv->Cleanup();
+        sv_context->superversions_to_free.push_back(sv);
+      }
     }
-    auto sv = static_cast<SuperVersion*>(ptr);
-    bool was_last_ref __attribute__((__unused__));
-    was_last_ref = sv->Unref();
-    // sv couldn't have been the last reference because
-    // ResetThreadLocalSuperVersions() is called before
-    // unref'ing super_version_.
-    assert(!was_last_ref);
   }
 }
 
@@ -1271,6 +1364,62 @@ Status ColumnFamilyData::SetOptions(
 #endif  // ROCKSDB_LITE
 
 // REQUIRES: DB mutex held
+BlobConfig ColumnFamilyData::GetBlobConfig(
+    const MutableCFOptions& moptions) const {
+  BlobConfig blob_config = moptions.get_blob_config();
+  if (moptions.blob_target_write_amp <= 0 ||
+      blob_config.blob_size == size_t(-1)) {
+    return blob_config;
+  }
+  // Inline values are rewritten once per level, separated values once per
+  // blob GC round. Solve the inline ratio of the target amplification:
+  // target = inline_ratio * level_amp + (1 - inline_ratio) * blob_amp
+  double level_amp = std::max(ioptions_.num_levels, 1);
+  double blob_amp = 1 / std::max(moptions.blob_gc_ratio, 0.01);
+  if (level_amp == blob_amp) {
+    return blob_config;
+  }
+  double inline_ratio = (blob_amp - moptions.blob_target_write_amp) /
+                        (blob_amp - level_amp);
+  inline_ratio = std::min(std::max(inline_ratio, 0.0), 1.0);
+
+  std::lock_guard<std::mutex> lock(value_size_mutex_);
+  double total_bytes = 0;
+  for (double bytes : value_size_bytes_) {
+    total_bytes += bytes;
+  }
+  if (total_bytes <= 0) {
+    blob_config.blob_size =
+        std::max(blob_config.blob_size, recorded_separate_threshold_);
+    return blob_config;
+  }
+  // Values of bucket i are in [2^i, 2^(i+1)), pick the smallest power of 2
+  // which keeps enough bytes inline
+  const int kBuckets = CompactionIterationStats::kValueSizeBuckets;
+  size_t threshold = size_t(1) << (kBuckets - 1);
+  double inline_bytes = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    if (inline_bytes >= total_bytes * inline_ratio) {
+      threshold = size_t(1) << i;
+      break;
+    }
+    inline_bytes += value_size_bytes_[i];
+  }
+  blob_config.blob_size = std::max(blob_config.blob_size, threshold);
+  return blob_config;
+}
+
+void ColumnFamilyData::RecordValueSizes(
+    const CompactionIterationStats& iter_stats) {
+  const double kDecay = 0.9;
+  std::lock_guard<std::mutex> lock(value_size_mutex_);
+  value_sizes_recorded_ = true;
+  for (int i = 0; i < CompactionIterationStats::kValueSizeBuckets; ++i) {
+    value_size_bytes_[i] = value_size_bytes_[i] * kDecay +
+                           iter_stats.value_bytes_by_size_log2[i];
+  }
+}
+
 Env::WriteLifeTimeHint ColumnFamilyData::CalculateSSTWriteHint(int level) {
   if (initial_cf_options_.compaction_style != kCompactionStyleLevel) {
     return Env::WLTH_NOT_SET;
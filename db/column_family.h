@@ -10,12 +10,16 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "db/compaction_iteration_stats.h"
 #include "db/memtable_list.h"
+#include "db/negative_lookup_cache.h"
 #include "db/table_cache.h"
 #include "db/table_properties_collector.h"
 #include "db/write_batch_internal.h"
@@ -24,9 +28,11 @@
 #include "rocksdb/compaction_job_stats.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
+#include "rocksdb/metrics_reporter.h"
 #include "rocksdb/options.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/chash_set.h"
+#include "util/epoch_manager.h"
 #include "util/thread_local.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -121,15 +127,6 @@ struct SuperVersion {
   void Init(MemTable* new_mem, MemTableListVersion* new_imm,
             Version* new_current);
 
-  // The value of dummy is not actually used. kSVInUse takes its address as a
-  // mark in the thread local storage to indicate the SuperVersion is in use
-  // by thread. This way, the value of kSVInUse is guaranteed to have no
-  // conflict with SuperVersion object address and portable on different
-  // platform.
-  static int dummy;
-  static void* const kSVInUse;
-  static void* const kSVObsolete;
-
  private:
   std::atomic<uint32_t> refs;
   // We need to_delete because during Cleanup(), imm->Unref() returns
@@ -151,6 +148,28 @@ extern ColumnFamilyOptions SanitizeOptions(const ImmutableDBOptions& db_options,
 
 class ColumnFamilySet;
 
+// Latency reporters of a column family, built by
+// DBOptions::metrics_reporter_factory with the tags
+// "dbname=<db>|cfname=<column family>". All null in the dummy column family.
+struct ColumnFamilyLatencyReporters {
+  // GetThreadLocalSuperVersion()
+  HistReporterHandle* superversion_acquire = nullptr;
+  // A value read from a blob SST, Version::fetch_buffer()
+  HistReporterHandle* blob_fetch = nullptr;
+  // The L0 files of one flush partition, BuildTable()
+  HistReporterHandle* flush_build_table = nullptr;
+  // TableBuilder::Finish() of a compaction output, where TerarkZip builds
+  // its index and compresses the values
+  HistReporterHandle* compaction_finish_table = nullptr;
+  // A Map SST, MapBuilder
+  HistReporterHandle* map_sst_build = nullptr;
+  // The rewrite of one garbage collection subcompaction
+  HistReporterHandle* gc_rewrite = nullptr;
+  // One subcompaction sent to a CompactionDispatcher, until its result is
+  // back
+  HistReporterHandle* remote_compaction = nullptr;
+};
+
 // This class keeps all the data that a column family needs.
 // Most methods require DB mutex held, unless otherwise noted
 class ColumnFamilyData {
@@ -242,6 +261,15 @@ class ColumnFamilyData {
 
   InternalStats* internal_stats() { return internal_stats_.get(); }
 
+  const ColumnFamilyLatencyReporters& latency_reporters() const {
+    return latency_reporters_;
+  }
+
+  // nullptr unless DBOptions::negative_lookup_cache_size is set
+  NegativeLookupCache* negative_lookup_cache() {
+    return negative_lookup_cache_.get();
+  }
+
   MemTableList* imm() { return &imm_; }
   MemTable* mem() { return mem_; }
   Version* current() { return current_; }
@@ -338,18 +366,36 @@ class ColumnFamilyData {
                : ioptions_.int_tbl_prop_collector_factories_for_blob.get();
   }
 
+  // thread-safe
+  // Value separation config for flush and compaction. When
+  // blob_target_write_amp is set, blob_size is raised by the recorded value
+  // size distribution, or by the threshold of the newest table until a value
+  // size is recorded.
+  BlobConfig GetBlobConfig(const MutableCFOptions& moptions) const;
+  // thread-safe
+  // Record value sizes seen by a flush or compaction, older records decay
+  void RecordValueSizes(const CompactionIterationStats& iter_stats);
+
   SuperVersion* GetSuperVersion() { return super_version_; }
   // thread-safe
   // Return a already referenced SuperVersion to be used safely.
   SuperVersion* GetReferencedSuperVersion(DBImpl* db);
   // thread-safe
-  // Get SuperVersion stored in thread local storage. If it does not exist,
-  // get a reference from a current SuperVersion.
+  // Get the current SuperVersion without a reference. The thread enters an
+  // epoch of EpochManager::Default() instead, which keeps the SuperVersion
+  // alive until ReturnThreadLocalSuperVersion().
   SuperVersion* GetThreadLocalSuperVersion(DBImpl* db);
-  // Try to return SuperVersion back to thread local storage. Retrun true on
-  // success and false on failure. It fails when the thread local storage
-  // contains anything other than SuperVersion::kSVInUse flag.
-  bool ReturnThreadLocalSuperVersion(SuperVersion* sv);
+  // Exits the epoch entered by GetThreadLocalSuperVersion()
+  void ReturnThreadLocalSuperVersion(SuperVersion* sv);
+  // thread-safe
+  bool HasRetiredSuperVersions() const {
+    return num_retired_super_versions_.load(std::memory_order_relaxed) != 0;
+  }
+  // thread-safe
+  // Moves the replaced SuperVersions no thread can still be reading without
+  // a reference to *expired, the caller releases their reference of current
+  // SuperVersion
+  void PopExpiredSuperVersions(autovector<SuperVersion*>* expired);
   // thread-safe
   uint64_t GetSuperVersionNumber() const {
     return super_version_number_.load();
@@ -365,8 +411,6 @@ class ColumnFamilyData {
   void InstallSuperVersion(SuperVersionContext* sv_context,
                            InstrumentedMutex* db_mutex);
 
-  void ResetThreadLocalSuperVersions();
-
   // Protected by DB mutex
   void inc_queued_for_flush() { ++queued_for_flush_; }
   void dec_queued_for_flush() {
@@ -383,13 +427,22 @@ class ColumnFamilyData {
     return queued_for_garbage_collection_;
   }
 
-  enum class WriteStallCause {
-    kNone,
-    kMemtableLimit,
-    kL0FileCountLimit,
-    kPendingCompactionBytes,
-    kReadAmpLimit,
+  // Scheduling state of a background work queue, protected by DB mutex
+  struct ScheduleState {
+    // Input bytes of the finished jobs, halved at every job
+    uint64_t consumed_bytes = 0;
+    // Times the column family was passed over since it was queued
+    size_t skipped = 0;
+
+    void Consume(uint64_t bytes) {
+      consumed_bytes = consumed_bytes / 2 + bytes;
+    }
   };
+  ScheduleState* compaction_schedule() { return &compaction_schedule_; }
+  ScheduleState* garbage_collection_schedule() {
+    return &garbage_collection_schedule_;
+  }
+
   static std::pair<WriteStallCondition, WriteStallCause>
   GetWriteStallConditionAndCause(int num_unflushed_memtables, int num_l0_files,
                                  int read_amp,
@@ -405,6 +458,17 @@ class ColumnFamilyData {
   WriteStallCondition RecalculateWriteStallConditions(
       const MutableCFOptions& mutable_cf_options);
 
+  // Write rate this column family asks for while it delays writes, 0 if it
+  // does not delay writes.
+  // REQUIRES: DB mutex held
+  uint64_t delayed_write_rate_target() const {
+    return delayed_write_rate_target_;
+  }
+
+  // The limit behind the current write stall condition
+  // REQUIRES: DB mutex held
+  WriteStallCause write_stall_cause() const { return write_stall_cause_; }
+
   void set_initialized() { initialized_.store(true); }
 
   bool initialized() const { return initialized_.load(); }
@@ -450,6 +514,12 @@ class ColumnFamilyData {
 
   std::unique_ptr<InternalStats> internal_stats_;
 
+  // Keeps the factory that owns latency_reporters_ alive
+  std::shared_ptr<MetricsReporterFactory> metrics_reporter_factory_;
+  ColumnFamilyLatencyReporters latency_reporters_;
+
+  std::unique_ptr<NegativeLookupCache> negative_lookup_cache_;
+
   WriteBufferManager* write_buffer_manager_;
 
   MemTable* mem_;
@@ -461,9 +531,16 @@ class ColumnFamilyData {
   // changes.
   std::atomic<uint64_t> super_version_number_;
 
-  // Thread's local copy of SuperVersion pointer
-  // This needs to be destructed before mutex_
-  std::unique_ptr<ThreadLocalPtr> local_sv_;
+  // super_version_ for the readers out of the mutex, see
+  // GetThreadLocalSuperVersion()
+  std::atomic<SuperVersion*> current_super_version_;
+
+  // The replaced SuperVersions with the epoch they were replaced in, in
+  // epoch order. Each still holds the reference it had as super_version_,
+  // released once no reader can see it.
+  std::mutex retired_super_versions_mutex_;
+  std::deque<std::pair<uint64_t, SuperVersion*>> retired_super_versions_;
+  std::atomic<size_t> num_retired_super_versions_;
 
   // pointers for a circular linked list. we use it to support iterations over
   // all column families that are alive (note: dropped column families can also
@@ -495,8 +572,14 @@ class ColumnFamilyData {
 
   bool queued_for_garbage_collection_;
 
+  ScheduleState compaction_schedule_;
+  ScheduleState garbage_collection_schedule_;
+
   uint64_t prev_compaction_needed_bytes_;
 
+  uint64_t delayed_write_rate_target_;
+  WriteStallCause write_stall_cause_;
+
   // if the database was opened with 2pc enabled
   bool allow_2pc_;
 
@@ -505,6 +588,14 @@ class ColumnFamilyData {
 
   // Directories corresponding to cf_paths.
   std::vector<std::unique_ptr<Directory>> data_dirs_;
+
+  // Decayed value bytes by floor(log2(size)), for adaptive separation
+  mutable std::mutex value_size_mutex_;
+  double value_size_bytes_[CompactionIterationStats::kValueSizeBuckets] = {};
+  // The separate_threshold of the newest table, the adaptive threshold until
+  // value sizes are recorded, e.g. right after open
+  size_t recorded_separate_threshold_ = 0;
+  bool value_sizes_recorded_ = false;
 };
 
 // ColumnFamilySet has interesting thread-safety requirements
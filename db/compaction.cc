@@ -74,6 +74,22 @@ uint64_t TotalFileSize(const std::vector<FileMetaData*>& files) {
   return sum;
 }
 
+bool GetHotPathId(const ImmutableCFOptions& ioptions,
+                  const MutableCFOptions& mutable_cf_options, int level,
+                  uint32_t* path_id) {
+  if (mutable_cf_options.hot_path_levels <= 0 ||
+      ioptions.cf_paths.size() <= 1 ||
+      ioptions.compaction_style != kCompactionStyleLevel) {
+    return false;
+  }
+  if (level >= 0 && level < mutable_cf_options.hot_path_levels) {
+    *path_id = 0;
+  } else {
+    *path_id = static_cast<uint32_t>(ioptions.cf_paths.size() - 1);
+  }
+  return true;
+}
+
 const char* CompactionTypeName(CompactionType type) {
   switch (type) {
     case kKeyValueCompaction:
@@ -336,6 +352,21 @@ Compaction::Compaction(CompactionParams&& params)
                   &largest_user_key_);
 }
 
+void Compaction::SkipInputFiles(
+    const std::unordered_set<uint64_t>& file_numbers) {
+  for (size_t which = 0; which < num_input_levels(); which++) {
+    std::vector<FileMetaData*> files;
+    for (auto f : inputs_[which].files) {
+      if (file_numbers.count(f->fd.GetNumber()) == 0) {
+        files.push_back(f);
+      }
+    }
+    if (files.size() != inputs_[which].size()) {
+      DoGenerateLevelFilesBrief(&input_levels_[which], files, &arena_);
+    }
+  }
+}
+
 Compaction::~Compaction() {
   if (input_version_ != nullptr) {
     input_version_->Unref();
@@ -608,14 +639,14 @@ bool Compaction::IsOutputLevelEmpty() const {
   return inputs_.back().level != output_level_ || inputs_.back().empty();
 }
 
-bool Compaction::ShouldFormSubcompactions() const {
+bool Compaction::ShouldFormSubcompactions(bool remote) const {
   if (compaction_type_ == kMapCompaction || max_subcompactions_ <= 1 ||
       cfd_ == nullptr) {
     return false;
   }
   if (cfd_->ioptions()->compaction_style == kCompactionStyleLevel) {
-    return (start_level_ == 0 || is_manual_compaction_) && output_level_ > 0 &&
-           !IsOutputLevelEmpty();
+    return (start_level_ == 0 || is_manual_compaction_ || remote) &&
+           output_level_ > 0 && !IsOutputLevelEmpty();
   } else if (cfd_->ioptions()->compaction_style == kCompactionStyleUniversal) {
     return number_levels_ > 1 && output_level_ > 0;
   } else {
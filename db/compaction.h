@@ -168,6 +168,14 @@ struct CompactionWorkerContext {
   int level, output_level, number_levels;
   bool skip_filters, bottommost_level, allow_ingest_behind, preserve_deletes;
   std::vector<NameParam> int_tbl_prop_collector_factories;
+
+  // Varint based binary encoding, the payload is compressed by "compression"
+  // when it is supported and worthwhile
+  void EncodeTo(std::string* dst,
+                CompressionType compression = kNoCompression) const;
+  // "compression" receives the compression of the payload, if not null
+  Status DecodeFrom(const Slice& src,
+                    CompressionType* compression = nullptr);
 };
 
 struct CompactionWorkerResult {
@@ -186,8 +194,16 @@ struct CompactionWorkerResult {
   std::vector<FileInfo> files;
   std::string stat_all;
   size_t time_us = 0;
+
+  void EncodeTo(std::string* dst,
+                CompressionType compression = kNoCompression) const;
+  Status DecodeFrom(const Slice& src);
 };
 
+// Whether "src" holds the binary encoding of CompactionWorkerContext or
+// CompactionWorkerResult, rather than the legacy one
+extern bool IsCompactionWorkerEncoding(const Slice& src);
+
 // A Compaction encapsulates information about a compaction.
 class Compaction {
  public:
@@ -260,6 +276,10 @@ class Compaction {
     return &input_levels_[compaction_input_level];
   }
 
+  // Leaves the given input files out of input_levels(), so the compaction
+  // doesn't read them. They are still inputs and get deleted on install
+  void SkipInputFiles(const std::unordered_set<uint64_t>& file_numbers);
+
   // GC expectation clears
   uint64_t num_antiquation() const { return num_antiquation_; }
 
@@ -385,7 +405,9 @@ class Compaction {
   bool IsOutputLevelEmpty() const;
 
   // Should this compaction be broken up into smaller ones run in parallel?
-  bool ShouldFormSubcompactions() const;
+  // "remote" sub compactions run on workers and need no local slot, so
+  // non-L0 automatic compactions are split as well.
+  bool ShouldFormSubcompactions(bool remote = false) const;
 
   // test function to validate the functionality of IsBottommostLevel()
   // function -- determines if compaction with inputs and storage is bottommost
@@ -415,7 +437,7 @@ class Compaction {
 
   int GetInputBaseLevel() const;
 
-  CompactionReason compaction_reason() { return compaction_reason_; }
+  CompactionReason compaction_reason() const { return compaction_reason_; }
 
   const std::vector<FileMetaData*>& grandparents() const {
     return grandparents_;
@@ -486,7 +508,8 @@ class Compaction {
   // Compaction input files organized by level. Constant after construction
   const std::vector<CompactionInputFiles> inputs_;
 
-  // A copy of inputs_, organized more closely in memory
+  // A copy of inputs_, organized more closely in memory, minus the files
+  // passed to SkipInputFiles
   autovector<LevelFilesBrief, 2> input_levels_;
 
   // State used to check for number of overlapping grandparent files
@@ -538,6 +561,13 @@ extern uint64_t TotalFileSize(const std::vector<FileMetaData*>& files);
 
 extern const char* CompactionTypeName(CompactionType type);
 
+// Stores in *path_id the path that hot_path_levels placement picks for the
+// files of "level", -1 standing for blob files rewritten by GC. Returns
+// false if the placement is off and files are placed by target size.
+extern bool GetHotPathId(const ImmutableCFOptions& ioptions,
+                         const MutableCFOptions& mutable_cf_options, int level,
+                         uint32_t* path_id);
+
 extern Status BuildInheritanceTree(
     const std::vector<CompactionInputFiles>& inputs,
     const DependenceMap& dependence_map, const Version* version,
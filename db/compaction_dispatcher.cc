@@ -320,8 +320,8 @@ class WorkerSeparateHelper : public SeparateHelper, public LazyBufferState {
 std::function<CompactionWorkerResult()>
 RemoteCompactionDispatcher::StartCompaction(
     const CompactionWorkerContext& context) {
-  ajson::string_stream stream;
-  ajson::save_to(stream, context);
+  std::string data;
+  context.EncodeTo(&data, payload_compression());
   struct Result {
     Result(std::future<std::string>&& _future) : future(_future.share()) {}
 
@@ -330,6 +330,15 @@ RemoteCompactionDispatcher::StartCompaction(
     CompactionWorkerResult operator()() {
       CompactionWorkerResult result;
       std::string encoded_result = future.get();
+      if (IsCompactionWorkerEncoding(encoded_result)) {
+        Status s = result.DecodeFrom(encoded_result);
+        if (!s.ok()) {
+          result = CompactionWorkerResult();
+          result.status = std::move(s);
+        }
+        return result;
+      }
+      // Legacy worker
       try {
         ajson::load_from_buff(result, encoded_result);
       } catch (const std::exception& ex) {
@@ -342,10 +351,14 @@ RemoteCompactionDispatcher::StartCompaction(
       return result;
     }
   };
-  std::future<std::string> str_result = DoCompaction(stream.str());
+  std::future<std::string> str_result = DoCompaction(std::move(data));
   return Result(std::move(str_result));
 }
 
+CompressionType RemoteCompactionDispatcher::payload_compression() const {
+  return kNoCompression;
+}
+
 static bool g_isCompactionWorkerNode = false;
 bool IsCompactionWorkerNode() { return g_isCompactionWorkerNode; }
 
@@ -400,14 +413,23 @@ class RemoteCompactionProxy : public CompactionIterator::CompactionProxy {
 static std::string make_error(Status&& status) {
   CompactionWorkerResult result;
   result.status = std::move(status);
-  ajson::string_stream stream;
-  ajson::save_to(stream, result);
-  return stream.str();
+  std::string encoded_result;
+  result.EncodeTo(&encoded_result);
+  return encoded_result;
 };
 
 std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   CompactionWorkerContext context;
-  ajson::load_from_buff(context, data);
+  CompressionType payload_compression = kNoCompression;
+  if (IsCompactionWorkerEncoding(data)) {
+    Status s = context.DecodeFrom(data, &payload_compression);
+    if (!s.ok()) {
+      return make_error(std::move(s));
+    }
+  } else {
+    // Legacy host
+    ajson::load_from_buff(context, data);
+  }
   context.compaction_filter_context.smallest_user_key =
       context.smallest_user_key;
   context.compaction_filter_context.largest_user_key = context.largest_user_key;
@@ -1098,18 +1120,22 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   auto finish_time = system_clock::now();
   auto duration = duration_cast<microseconds>(finish_time - start_time);
   result.time_us = duration.count();
-  ajson::string_stream stream;
-  ajson::save_to(stream, result);
-  return stream.str();
+  std::string encoded_result;
+  result.EncodeTo(&encoded_result, payload_compression);
+  return encoded_result;
 }
 
 void RemoteCompactionDispatcher::Worker::DebugSerializeCheckResult(Slice data) {
 #ifdef WITH_TERARK_ZIP
   using namespace terark;
-  LittleEndianDataInput<MemIO> dio;
-  dio.set((void*)(data.data_), data.size());
   CompactionWorkerResult res;
-  dio >> res;
+  if (IsCompactionWorkerEncoding(data)) {
+    res.DecodeFrom(data);
+  } else {
+    LittleEndianDataInput<MemIO> dio;
+    dio.set((void*)(data.data_), data.size());
+    dio >> res;
+  }
   string_appender<> str;
   str << "CompactionWorkerResult: time_us = " << res.time_us << " ("
       << (res.time_us * 1e-6) << " sec), ";
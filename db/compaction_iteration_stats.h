@@ -18,7 +18,12 @@ struct CompactionIterationStats {
   int64_t num_range_del_drop_obsolete = 0;
   // Deletions obsoleted before bottom level due to file gap optimization.
   int64_t num_optimized_del_drop_obsolete = 0;
+  // Wall and CPU nanos in the compaction filter and the merge operator,
+  // estimated from a sample of the calls
   uint64_t total_filter_time = 0;
+  uint64_t total_filter_cpu_time = 0;
+  uint64_t total_merge_time = 0;
+  uint64_t total_merge_cpu_time = 0;
 
   // Input statistics
   // TODO(noetzli): The stats are incomplete. They are lacking everything
@@ -32,4 +37,8 @@ struct CompactionIterationStats {
   // Single-Delete diagnostics for exceptional situations
   uint64_t num_single_del_fallthru = 0;
   uint64_t num_single_del_mismatch = 0;
+
+  // Bytes of values checked for separation, bucketed by floor(log2(size))
+  static constexpr int kValueSizeBuckets = 64;
+  uint64_t value_bytes_by_size_log2[kValueSizeBuckets] = {};
 };
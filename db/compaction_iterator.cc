@@ -10,6 +10,7 @@
 #include "rocksdb/listener.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/internal_iterator.h"
+#include "util/stop_watch.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -106,6 +107,199 @@ InternalIterator* NewCompactionIterator(
                                                   arg, start_user_key);
 }
 
+// Reads up to CompactionFilter::FilterBatchSize() records ahead of the
+// compaction iterator and filters the newest versions of plain values among
+// them with one FilterBatch() call. The compaction iterator takes the
+// decision of a record instead of calling FilterV2(), records without a
+// decision are filtered one by one as before.
+class CompactionFilterBatchIterator : public InternalIterator {
+ public:
+  CompactionFilterBatchIterator(InternalIterator* input,
+                                const CompactionFilter* filter, int level,
+                                const Comparator* cmp, const Slice* end,
+                                bool filter_all, SequenceNumber latest_snapshot,
+                                Env* env)
+      : input_(input),
+        filter_(filter),
+        level_(level),
+        cmp_(cmp),
+        end_(end),
+        filter_all_(filter_all),
+        latest_snapshot_(latest_snapshot),
+        env_(env),
+        filter_time_(0),
+        filter_cpu_time_(0),
+        records_(filter->FilterBatchSize()),
+        size_(0),
+        pos_(0),
+        has_last_user_key_(false) {
+    assert(!records_.empty());
+    Fill();
+  }
+
+  virtual bool Valid() const override { return pos_ < size_; }
+  virtual Slice key() const override { return records_[pos_].key; }
+  virtual LazyBuffer value() const override {
+    return LazyBufferReference(records_[pos_].value);
+  }
+  virtual Status status() const override { return input_->status(); }
+  virtual void Next() override {
+    assert(Valid());
+    if (++pos_ == size_) {
+      Fill();
+    }
+  }
+  virtual void Seek(const Slice& target) override {
+    input_->Seek(target);
+    has_last_user_key_ = false;
+    Fill();
+  }
+  virtual void SeekToFirst() override {
+    input_->SeekToFirst();
+    has_last_user_key_ = false;
+    Fill();
+  }
+  // Compactions only move forward
+  virtual void Prev() override { abort(); }
+  virtual void SeekToLast() override { abort(); }
+  virtual void SeekForPrev(const Slice&) override { abort(); }
+
+  // Moves the decision the batch made for the current record, if any, to
+  // *decision and *new_value. The wall and CPU time spent in FilterBatch()
+  // since the last call is added to *filter_time and *filter_cpu_time
+  bool TakeDecision(CompactionFilter::Decision* decision,
+                    LazyBuffer* new_value, uint64_t* filter_time,
+                    uint64_t* filter_cpu_time) {
+    assert(Valid());
+    Record& r = records_[pos_];
+    if (!r.has_decision) {
+      return false;
+    }
+    r.has_decision = false;
+    *decision = r.decision;
+    new_value->reset(std::move(r.new_value));
+    *filter_time += filter_time_;
+    *filter_cpu_time += filter_cpu_time_;
+    filter_time_ = 0;
+    filter_cpu_time_ = 0;
+    return true;
+  }
+
+ private:
+  struct Record {
+    std::string key;
+    LazyBuffer value;
+    bool has_decision;
+    CompactionFilter::Decision decision;
+    LazyBuffer new_value;
+  };
+
+  void Fill() {
+    size_ = 0;
+    pos_ = 0;
+    batch_.clear();
+    for (; size_ < records_.size() && input_->Valid(); input_->Next()) {
+      Record& r = records_[size_++];
+      Slice key = input_->key();
+      r.key.assign(key.data(), key.size());
+      LazyBuffer value = input_->value();
+      Status s = value.fetch();
+      if (s.ok()) {
+        r.value.reset(value.slice(), true, value.file_number());
+      } else {
+        r.value.reset(std::move(s));
+      }
+      r.has_decision = false;
+      ParsedInternalKey ikey;
+      if (!ParseInternalKey(r.key, &ikey)) {
+        has_last_user_key_ = false;
+        continue;
+      }
+      // Only the first version of a user key gets filtered
+      bool first = !has_last_user_key_ ||
+                   !cmp_->Equal(ikey.user_key, last_user_key_);
+      last_user_key_.assign(ikey.user_key.data(), ikey.user_key.size());
+      has_last_user_key_ = true;
+      if (first && ikey.type == kTypeValue && s.ok() &&
+          (filter_all_ || ikey.sequence > latest_snapshot_) &&
+          (end_ == nullptr || cmp_->Compare(ikey.user_key, *end_) < 0)) {
+        batch_.push_back(size_ - 1);
+      }
+    }
+    if (batch_.empty()) {
+      return;
+    }
+    size_t n = batch_.size();
+    keys_.resize(n);
+    values_.resize(n);
+    new_values_.resize(n);
+    decisions_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      Record& r = records_[batch_[i]];
+      keys_[i] = ExtractUserKey(r.key);
+      values_[i].reset(r.value.slice());
+      new_values_[i].clear();
+    }
+    {
+      PhaseStopWatch timer(env_, &filter_time_, &filter_cpu_time_);
+      filter_->FilterBatch(level_, n, keys_.data(), values_.data(),
+                           new_values_.data(), decisions_.data());
+    }
+    for (size_t i = 0; i < n; ++i) {
+      Record& r = records_[batch_[i]];
+      r.has_decision = true;
+      r.decision = decisions_[i];
+      if (r.decision == CompactionFilter::Decision::kRemoveAndSkipUntil) {
+        r.decision = CompactionFilter::Decision::kKeep;
+      }
+      r.new_value.reset(std::move(new_values_[i]));
+    }
+  }
+
+  InternalIterator* input_;
+  const CompactionFilter* filter_;
+  const int level_;
+  const Comparator* cmp_;
+  const Slice* end_;
+  const bool filter_all_;
+  const SequenceNumber latest_snapshot_;
+  Env* env_;
+  uint64_t filter_time_;
+  uint64_t filter_cpu_time_;
+
+  std::vector<Record> records_;
+  size_t size_;
+  size_t pos_;
+  std::string last_user_key_;
+  bool has_last_user_key_;
+
+  // Scratch of FilterBatch() calls
+  std::vector<size_t> batch_;
+  std::vector<Slice> keys_;
+  std::vector<LazyBuffer> values_;
+  std::vector<LazyBuffer> new_values_;
+  std::vector<CompactionFilter::Decision> decisions_;
+};
+
+CompactionFilterBatchIterator* CompactionIterator::NewFilterBatchIterator(
+    InternalIterator* input, const Comparator* cmp, const Slice* end,
+    const std::vector<SequenceNumber>& snapshots,
+    const SnapshotChecker* snapshot_checker, Env* env,
+    const CompactionProxy* compaction,
+    const CompactionFilter* compaction_filter) {
+  if (compaction == nullptr || compaction_filter == nullptr ||
+      compaction_filter->FilterBatchSize() == 0 ||
+      snapshot_checker != nullptr) {
+    return nullptr;
+  }
+  // See InvokeFilterIfNeeded()
+  bool filter_all = snapshots.empty() || compaction_filter->IgnoreSnapshots();
+  SequenceNumber latest_snapshot = snapshots.empty() ? 0 : snapshots.back();
+  return new CompactionFilterBatchIterator(
+      input, compaction_filter, compaction->level(), cmp, end, filter_all,
+      latest_snapshot, env);
+}
+
 CompactionIterator::CompactionIterator(
     InternalIterator* input, SeparateHelper* separate_helper, const Slice* end,
     const Comparator* cmp, MergeHelper* merge_helper,
@@ -140,7 +334,11 @@ CompactionIterator::CompactionIterator(
     const std::atomic<bool>* shutting_down,
     const SequenceNumber preserve_deletes_seqnum,
     const chash_set<uint64_t>* need_rebuild_blobs)
-    : input_(input, separate_helper),
+    : filter_batch_iter_(NewFilterBatchIterator(
+          input, cmp, end, *snapshots, snapshot_checker, env, compaction.get(),
+          compaction_filter)),
+      input_(filter_batch_iter_ ? filter_batch_iter_.get() : input,
+             separate_helper),
       end_(end),
       cmp_(cmp),
       merge_helper_(merge_helper),
@@ -291,10 +489,15 @@ void CompactionIterator::InvokeFilterIfNeeded(bool* need_skip,
           &compaction_filter_value_, compaction_filter_skip_until_.rep());
     };
     auto sample = filter_sample_interval_;
-    if (env_ && sample && (filter_hit_count_ & (sample - 1)) == 0) {
-      StopWatchNano timer(env_, true);
+    if (filter_batch_iter_ &&
+        filter_batch_iter_->TakeDecision(&filter, &compaction_filter_value_,
+                                         &iter_stats_.total_filter_time,
+                                         &iter_stats_.total_filter_cpu_time)) {
+      // Filtered along with the records around it
+    } else if (env_ && sample && (filter_hit_count_ & (sample - 1)) == 0) {
+      PhaseStopWatch timer(env_, &iter_stats_.total_filter_time,
+                           &iter_stats_.total_filter_cpu_time, sample);
       doFilter();
-      iter_stats_.total_filter_time += timer.ElapsedNanos() * sample;
     } else {
       doFilter();
     }
@@ -678,9 +881,18 @@ void CompactionIterator::NextFromInput() {
       // We encapsulate the merge related state machine in a different
       // object to minimize change to the existing flow.
       value_.reset();  // MergeUntil will get iter value and move iter
-      Status s = merge_helper_->MergeUntil(current_key_.GetUserKey(), &input_,
-                                           range_del_agg_, prev_snapshot,
-                                           bottommost_level_);
+      Status s;
+      {
+        // Timed on the same sample as the compaction filter
+        auto sample = filter_sample_interval_;
+        bool timed = sample && (merge_count_++ & (sample - 1)) == 0;
+        PhaseStopWatch timer(timed ? env_ : nullptr,
+                             &iter_stats_.total_merge_time,
+                             &iter_stats_.total_merge_cpu_time, sample);
+        s = merge_helper_->MergeUntil(current_key_.GetUserKey(), &input_,
+                                      range_del_agg_, prev_snapshot,
+                                      bottommost_level_);
+      }
       merge_out_iter_.SeekToFirst();
 
       if (!s.ok() && !s.IsMergeInProgress()) {
@@ -781,6 +993,11 @@ void CompactionIterator::PrepareOutput() {
     }
     assert(value_.size() < (1ull << 49));
     assert(blob_large_key_ratio_lsh16_ < (1ull << 17));
+    int size_log2 = 0;
+    for (uint64_t size = value_.size() >> 1; size != 0; size >>= 1) {
+      ++size_log2;
+    }
+    iter_stats_.value_bytes_by_size_log2[size_log2] += value_.size();
     // (key.size << 16) > value.size * large_key_ratio_lsh16
     if (value_.size() < blob_config_.blob_size ||
         (current_user_key_.size() << 16) >
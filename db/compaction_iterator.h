@@ -22,6 +22,8 @@
 
 namespace TERARKDB_NAMESPACE {
 
+class CompactionFilterBatchIterator;
+
 class CompactionIterator {
  public:
   friend class CompactionIteratorToInternalIterator;
@@ -146,6 +148,16 @@ class CompactionIterator {
   // or seqnum be zero-ed out even if all other conditions for it are met.
   inline bool ikeyNotNeededForIncrementalSnapshot();
 
+  // Reads ahead of input for compaction filters that take batches, nullptr
+  // when compaction_filter doesn't
+  static CompactionFilterBatchIterator* NewFilterBatchIterator(
+      InternalIterator* input, const Comparator* cmp, const Slice* end,
+      const std::vector<SequenceNumber>& snapshots,
+      const SnapshotChecker* snapshot_checker, Env* env,
+      const CompactionProxy* compaction,
+      const CompactionFilter* compaction_filter);
+
+  std::unique_ptr<CompactionFilterBatchIterator> filter_batch_iter_;
   CombinedInternalIterator input_;
   const Slice* end_;
   const Comparator* cmp_;
@@ -227,6 +239,7 @@ class CompactionIterator {
 
   size_t filter_sample_interval_ = 64;
   size_t filter_hit_count_ = 0;
+  size_t merge_count_ = 0;
   const chash_set<uint64_t>* rebuild_blob_set_;
 
  public:
@@ -693,6 +693,67 @@ TEST_P(CompactionIteratorTest, SingleMergeOperand) {
   ASSERT_EQ("cv1cv2", c_iter_->value().ToString());
 }
 
+TEST_P(CompactionIteratorTest, CompactionFilterBatch) {
+  class Filter : public CompactionFilter {
+   public:
+    Decision FilterV2(int /*level*/, const Slice& /*key*/, ValueType /*t*/,
+                      const Slice& /*existing_value_meta*/,
+                      const LazyBuffer& existing_value, LazyBuffer* new_value,
+                      std::string* /*skip_until*/) const override {
+      if (!existing_value.fetch().ok()) {
+        return Decision::kKeep;
+      }
+      if (existing_value.slice() == "rm") {
+        return Decision::kRemove;
+      }
+      if (existing_value.slice() == "chg") {
+        new_value->reset("new");
+        return Decision::kChangeValue;
+      }
+      return Decision::kKeep;
+    }
+
+    void FilterBatch(int level, size_t n, const Slice* keys,
+                     const LazyBuffer* values, LazyBuffer* new_values,
+                     Decision* decisions) const override {
+      ++num_batches;
+      num_filtered += n;
+      CompactionFilter::FilterBatch(level, n, keys, values, new_values,
+                                    decisions);
+    }
+
+    size_t FilterBatchSize() const override { return 2; }
+
+    const char* Name() const override {
+      return "CompactionIteratorTest.CompactionFilterBatch::Filter";
+    }
+
+    mutable int num_batches = 0;
+    mutable size_t num_filtered = 0;
+  };
+
+  Filter filter;
+  AddSnapshot(3);
+  RunTest({test::KeyStr("a", 10, kTypeValue), test::KeyStr("a", 5, kTypeValue),
+           test::KeyStr("b", 9, kTypeValue), test::KeyStr("c", 8, kTypeValue),
+           test::KeyStr("d", 7, kTypeValue), test::KeyStr("e", 2, kTypeValue)},
+          {"rm", "chg", "chg", "keep", "rm", "rm"},
+          {test::KeyStr("a", 10, kTypeDeletion),
+           test::KeyStr("b", 9, kTypeValue), test::KeyStr("c", 8, kTypeValue),
+           test::KeyStr("d", 7, kTypeDeletion),
+           test::KeyStr("e", 2, kTypeValue)},
+          {"", "new", "keep", "", "rm"}, kMaxSequenceNumber,
+          nullptr /*merge_operator*/, &filter);
+  if (GetParam()) {
+    // Snapshot checkers filter one record at a time
+    ASSERT_EQ(0, filter.num_batches);
+  } else {
+    // e is older than the snapshot and a@5 is not the newest version
+    ASSERT_EQ(3, filter.num_batches);
+    ASSERT_EQ(4U, filter.num_filtered);
+  }
+}
+
 // In bottommost level, values earlier than earliest snapshot can be output
 // with sequence = 0.
 TEST_P(CompactionIteratorTest, ZeroOutSequenceAtBottomLevel) {
@@ -50,10 +50,12 @@
 #include "db/merge_context.h"
 #include "db/merge_helper.h"
 #include "db/range_del_aggregator.h"
+#include "db/table_properties_collector.h"
 #include "db/version_edit.h"
 #include "db/version_set.h"
 #include "monitoring/iostats_context_imp.h"
 #include "monitoring/thread_status_util.h"
+#include "monitoring/usdt.h"
 #include "port/port.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
@@ -82,6 +84,7 @@
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
+#include "util/work_stealing_thread_pool.h"
 #include "utilities/util/valvec.hpp"
 
 namespace TERARKDB_NAMESPACE {
@@ -124,6 +127,10 @@ const char* GetCompactionReasonString(CompactionReason compaction_reason) {
       return "GarbageCollection";
     case CompactionReason::kRangeDeletion:
       return "RangeDeletion";
+    case CompactionReason::kColdRecompress:
+      return "ColdRecompress";
+    case CompactionReason::kPathMigration:
+      return "PathMigration";
     case CompactionReason::kNumOfReasons:
       // fall through
     default:
@@ -132,6 +139,52 @@ const char* GetCompactionReasonString(CompactionReason compaction_reason) {
   }
 }
 
+// One in kPhaseSampleInterval calls of a per record phase is timed, see
+// CompactionJobStats::PhaseTime
+static const uint64_t kPhaseSampleInterval = 64;
+
+// Returns env if the call number *count of a phase is timed, else nullptr
+static Env* SamplePhase(Env* env, uint64_t* count) {
+  return (*count)++ % kPhaseSampleInterval == 0 ? env : nullptr;
+}
+
+// Times the reads of the compaction input into *time
+class InputReadTimingIterator : public InternalIterator {
+ public:
+  InputReadTimingIterator(InternalIterator* iter, Env* env,
+                          CompactionJobStats::PhaseTime* time)
+      : iter_(iter), env_(env), time_(time), count_(0) {}
+
+  virtual bool Valid() const override { return iter_->Valid(); }
+  virtual void SeekToFirst() override {
+    PhaseStopWatch timer(env_, &time_->wall_nanos, &time_->cpu_nanos);
+    iter_->SeekToFirst();
+  }
+  virtual void SeekToLast() override { iter_->SeekToLast(); }
+  virtual void Seek(const Slice& target) override {
+    PhaseStopWatch timer(env_, &time_->wall_nanos, &time_->cpu_nanos);
+    iter_->Seek(target);
+  }
+  virtual void SeekForPrev(const Slice& target) override {
+    iter_->SeekForPrev(target);
+  }
+  virtual void Next() override {
+    PhaseStopWatch timer(SamplePhase(env_, &count_), &time_->wall_nanos,
+                         &time_->cpu_nanos, kPhaseSampleInterval);
+    iter_->Next();
+  }
+  virtual void Prev() override { iter_->Prev(); }
+  virtual Slice key() const override { return iter_->key(); }
+  virtual LazyBuffer value() const override { return iter_->value(); }
+  virtual Status status() const override { return iter_->status(); }
+
+ private:
+  std::unique_ptr<InternalIterator> iter_;
+  Env* env_;
+  CompactionJobStats::PhaseTime* time_;
+  uint64_t count_;
+};
+
 // Maintains state for each sub-compaction
 struct CompactionJob::SubcompactionState {
   const Compaction* compaction;
@@ -196,6 +249,9 @@ struct CompactionJob::SubcompactionState {
   uint64_t num_input_records;
   uint64_t num_output_records;
   CompactionJobStats compaction_job_stats;
+  // Calls of the per record phases, see SamplePhase()
+  uint64_t output_record_count = 0;
+  uint64_t blob_record_count = 0;
   uint64_t approx_size;
   // An index that used to speed up ShouldStopBefore().
   size_t grandparent_index = 0;
@@ -245,6 +301,8 @@ struct CompactionJob::SubcompactionState {
     num_input_records = std::move(o.num_input_records);
     num_output_records = std::move(o.num_output_records);
     compaction_job_stats = std::move(o.compaction_job_stats);
+    output_record_count = std::move(o.output_record_count);
+    blob_record_count = std::move(o.blob_record_count);
     approx_size = std::move(o.approx_size);
     grandparent_index = std::move(o.grandparent_index);
     overlapped_bytes = std::move(o.overlapped_bytes);
@@ -696,7 +754,11 @@ CompactionJob::CompactionJob(
       bottommost_level_(false),
       paranoid_file_checks_(paranoid_file_checks),
       measure_io_stats_(measure_io_stats),
-      write_hint_(Env::WLTH_NOT_SET) {
+      subcompaction_threads_(0),
+      next_subcompaction_(0),
+      garbage_collection_threads_(1),
+      write_hint_(Env::WLTH_NOT_SET),
+      progress_bytes_done_(0) {
   assert(log_buffer_ != nullptr);
   const auto* cfd = compact_->compaction->column_family_data();
   ThreadStatusUtil::SetColumnFamily(cfd, cfd->ioptions()->env,
@@ -710,6 +772,29 @@ CompactionJob::~CompactionJob() {
   ThreadStatusUtil::ResetThreadStatus();
 }
 
+// Uncompressed bytes the compaction iterator reads, the tables a map sst
+// refers to are read in place of it
+static uint64_t EstimateInputRawBytes(const Compaction* c) {
+  auto& dependence_map = c->input_version()->storage_info()->dependence_map();
+  uint64_t bytes = 0;
+  for (auto& level_files : *c->inputs()) {
+    for (auto f : level_files.files) {
+      if (!f->prop.is_map_sst()) {
+        bytes += f->prop.raw_key_size + f->prop.raw_value_size;
+        continue;
+      }
+      for (auto& dependence : f->prop.dependence) {
+        auto find = dependence_map.find(dependence.file_number);
+        if (find != dependence_map.end()) {
+          bytes += find->second->prop.raw_key_size +
+                   find->second->prop.raw_value_size;
+        }
+      }
+    }
+  }
+  return bytes;
+}
+
 void CompactionJob::ReportStartedCompaction(Compaction* compaction) {
   const auto* cfd = compact_->compaction->column_family_data();
   ThreadStatusUtil::SetColumnFamily(cfd, cfd->ioptions()->env,
@@ -734,6 +819,11 @@ void CompactionJob::ReportStartedCompaction(Compaction* compaction) {
   ThreadStatusUtil::SetThreadOperationProperty(
       ThreadStatus::COMPACTION_TOTAL_INPUT_BYTES,
       compaction->CalculateTotalInputSize());
+  ThreadStatusUtil::SetThreadOperationProperty(
+      ThreadStatus::COMPACTION_PROGRESS_BYTES_TOTAL,
+      EstimateInputRawBytes(compaction));
+  ThreadStatusUtil::SetThreadOperationProperty(
+      ThreadStatus::COMPACTION_PROGRESS_BYTES_DONE, 0);
 
   IOSTATS_RESET(bytes_written);
   IOSTATS_RESET(bytes_read);
@@ -752,6 +842,33 @@ void CompactionJob::ReportStartedCompaction(Compaction* compaction) {
   }
 }
 
+static std::shared_ptr<CompactionDispatcher> GetCmdLineDispatcher() {
+  const char* cmdline = getenv("TerarkDB_compactionWorkerCommandLine");
+  if (cmdline) {
+#ifdef WITH_TERARK_ZIP
+    return NewCommandLineCompactionDispatcher(cmdline);
+#endif
+  }
+  return {};
+}
+
+// Dispatcher for compaction "c", null to run locally
+static CompactionDispatcher* GetCompactionDispatcher(const Compaction* c) {
+  // Cold recompress relies on the local builder seeing the reason
+  if (c->compaction_type() != kKeyValueCompaction ||
+      c->compaction_reason() == CompactionReason::kColdRecompress) {
+    return nullptr;
+  }
+  CompactionDispatcher* dispatcher =
+      c->immutable_cf_options()->compaction_dispatcher;
+  if (!dispatcher) {
+    static std::shared_ptr<CompactionDispatcher> command_line_dispatcher(
+        GetCmdLineDispatcher());
+    dispatcher = command_line_dispatcher.get();
+  }
+  return dispatcher;
+}
+
 int CompactionJob::Prepare(int sub_compaction_slots) {
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_PREPARE);
@@ -764,12 +881,27 @@ int CompactionJob::Prepare(int sub_compaction_slots) {
       c->column_family_data()->CalculateSSTWriteHint(c->output_level());
   // Is this compaction producing files at the bottommost level?
   bottommost_level_ = c->bottommost_level();
-
-  if (c->compaction_type() != kMapCompaction && !c->input_range().empty()) {
+  // Remote sub compactions run on workers, they take no local slot
+  bool remote = GetCompactionDispatcher(c) != nullptr;
+  int max_usable_threads =
+      remote ? static_cast<int>(std::max(1U, c->max_subcompactions()))
+             : sub_compaction_slots + 1;
+
+  SkipCoveredInputFiles();
+
+  if (c->compaction_type() == kGarbageCollection) {
+    // GC always write one blob, extra slots are used to check records
+    garbage_collection_threads_ =
+        std::min(uint32_t(sub_compaction_slots + 1),
+                 std::max(1U, c->max_subcompactions()));
+    compact_->sub_compact_states.emplace_back(c, nullptr, nullptr);
+    return static_cast<int>(garbage_collection_threads_ - 1);
+  } else if (c->compaction_type() != kMapCompaction &&
+             !c->input_range().empty()) {
     auto& input_range = c->input_range();
     size_t n =
-        std::min({uint32_t(sub_compaction_slots + 1),
-                  uint32_t(input_range.size()), c->max_subcompactions()});
+        std::min({uint32_t(max_usable_threads), uint32_t(input_range.size()),
+                  c->max_subcompactions()});
     boundaries_.resize(n * 2);
     auto uc = c->column_family_data()->user_comparator();
     if (n < input_range.size()) {
@@ -794,9 +926,12 @@ int CompactionJob::Prepare(int sub_compaction_slots) {
       }
       compact_->sub_compact_states.emplace_back(c, start, end);
     }
-  } else if (c->ShouldFormSubcompactions()) {
+  } else if (c->ShouldFormSubcompactions(remote)) {
     const uint64_t start_micros = env_->NowMicros();
-    GenSubcompactionBoundaries(sub_compaction_slots + 1);
+    GenSubcompactionBoundaries(
+        max_usable_threads,
+        remote ? 1
+               : int(c->mutable_cf_options()->subcompaction_tasks_per_thread));
     MeasureTime(stats_, SUBCOMPACTION_SETUP_TIME,
                 env_->NowMicros() - start_micros);
 
@@ -813,7 +948,105 @@ int CompactionJob::Prepare(int sub_compaction_slots) {
     compact_->sub_compact_states.emplace_back(c, nullptr, nullptr);
   }
   assert(!compact_->sub_compact_states.empty());
-  return static_cast<int>(compact_->sub_compact_states.size() - 1);
+  if (subcompaction_threads_ == 0) {
+    subcompaction_threads_ = compact_->sub_compact_states.size();
+  }
+  if (remote) {
+    return 0;
+  }
+  return static_cast<int>(subcompaction_threads_ - 1);
+}
+
+// An input file whose keys all sit under a range tombstone of another input,
+// newer than the file and with no snapshot in between, would only be read to
+// be dropped key by key. Leave it out of the input iterator instead, the
+// compaction still deletes it along with the other inputs
+void CompactionJob::SkipCoveredInputFiles() {
+  auto* c = compact_->compaction;
+  if (c->compaction_type() != kKeyValueCompaction ||
+      snapshot_checker_ != nullptr) {
+    return;
+  }
+  auto* cfd = c->column_family_data();
+  const InternalKeyComparator& icmp = cfd->internal_comparator();
+  const Comparator* ucmp = icmp.user_comparator();
+  struct Tombstone {
+    std::string start;
+    std::string end;
+    SequenceNumber seq;
+    const FileMetaData* file;
+  };
+  std::vector<Tombstone> tombstones;
+  for (size_t which = 0; which < c->num_input_levels(); which++) {
+    for (auto f : *c->inputs(which)) {
+      if (f->prop.is_map_sst() || !f->prop.has_range_deletions()) {
+        continue;
+      }
+      Cache::Handle* handle = nullptr;
+      Status s = cfd->table_cache()->FindTable(
+          env_options_for_read_, icmp, f->fd, &handle,
+          c->mutable_cf_options()->prefix_extractor.get());
+      if (!s.ok()) {
+        // The compaction itself reports the error
+        return;
+      }
+      std::unique_ptr<FragmentedRangeTombstoneIterator> iter(
+          cfd->table_cache()
+              ->GetTableReaderFromHandle(handle)
+              ->NewRangeTombstoneIterator(ReadOptions()));
+      if (iter != nullptr) {
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+          tombstones.emplace_back(Tombstone{iter->start_key().ToString(),
+                                            iter->end_key().ToString(),
+                                            iter->seq(), f});
+        }
+      }
+      cfd->table_cache()->ReleaseHandle(handle);
+    }
+  }
+  if (tombstones.empty()) {
+    return;
+  }
+  auto covers = [&](const Tombstone& t, const FileMetaData* f) {
+    if (t.seq <= f->fd.largest_seqno) {
+      return false;
+    }
+    // A snapshot taken after any key of f but before the tombstone still
+    // sees that key
+    auto snapshot =
+        std::lower_bound(existing_snapshots_.begin(), existing_snapshots_.end(),
+                         f->fd.smallest_seqno);
+    if (snapshot != existing_snapshots_.end() && *snapshot < t.seq) {
+      return false;
+    }
+    // Tombstones are truncated to the bounds of the file holding them
+    return ucmp->Compare(t.start, f->smallest.user_key()) <= 0 &&
+           ucmp->Compare(f->largest.user_key(), t.end) < 0 &&
+           icmp.Compare(t.file->smallest, f->smallest) <= 0 &&
+           icmp.Compare(f->largest, t.file->largest) <= 0;
+  };
+  std::unordered_set<uint64_t> skipped;
+  for (size_t which = 0; which < c->num_input_levels(); which++) {
+    for (auto f : *c->inputs(which)) {
+      if (f->prop.is_map_sst()) {
+        continue;
+      }
+      for (auto& t : tombstones) {
+        if (covers(t, f)) {
+          skipped.emplace(f->fd.GetNumber());
+          break;
+        }
+      }
+    }
+  }
+  TEST_SYNC_POINT_CALLBACK("CompactionJob::SkipCoveredInputFiles", &skipped);
+  if (!skipped.empty()) {
+    ROCKS_LOG_BUFFER(log_buffer_,
+                     "[%s] [JOB %d] Skipping %" ROCKSDB_PRIszt
+                     " input files covered by range deletions",
+                     cfd->GetName().c_str(), job_id_, skipped.size());
+    c->SkipInputFiles(skipped);
+  }
 }
 
 struct RangeWithSize {
@@ -829,7 +1062,8 @@ struct RangeWithSize {
 // to the working set and then finds the approximate size of data in between
 // each consecutive pair of slices. Then it divides these ranges into
 // consecutive groups such that each group has a similar size.
-void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads) {
+void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads,
+                                               int tasks_per_thread) {
   auto* c = compact_->compaction;
   auto* cfd = c->column_family_data();
   const Comparator* cfd_comparator = cfd->user_comparator();
@@ -937,6 +1171,14 @@ void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads) {
       std::min({max_usable_threads, static_cast<int>(ranges.size()),
                 static_cast<int>(c->max_subcompactions()),
                 static_cast<int>(max_output_files)});
+  subcompaction_threads_ = std::max(1, subcompactions);
+  if (subcompactions > 1 && tasks_per_thread > 1) {
+    // Smaller subcompactions than threads, a thread done early takes the next
+    // pending one instead of waiting for the largest to finish
+    subcompactions = static_cast<int>(
+        std::min({uint64_t(subcompactions) * uint64_t(tasks_per_thread),
+                  uint64_t(ranges.size()), max_output_files}));
+  }
 
   if (subcompactions > 1) {
     double mean = sum * 1.0 / subcompactions;
@@ -964,30 +1206,15 @@ void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads) {
   }
 }
 
-static std::shared_ptr<CompactionDispatcher> GetCmdLineDispatcher() {
-  const char* cmdline = getenv("TerarkDB_compactionWorkerCommandLine");
-  if (cmdline) {
-#ifdef WITH_TERARK_ZIP
-    return NewCommandLineCompactionDispatcher(cmdline);
-#endif
-  }
-  return {};
-}
-
 Status CompactionJob::Run() {
   TEST_SYNC_POINT("CompactionJob::Run():OuterStart");
 #ifdef WITH_TERARK_ZIP
   assert(!IsCompactionWorkerNode());
 #endif
   ColumnFamilyData* cfd = compact_->compaction->column_family_data();
-  CompactionDispatcher* dispatcher = cfd->ioptions()->compaction_dispatcher;
   Compaction* c = compact_->compaction;
+  CompactionDispatcher* dispatcher = GetCompactionDispatcher(c);
   if (!dispatcher) {
-    static std::shared_ptr<CompactionDispatcher> command_line_dispatcher(
-        GetCmdLineDispatcher());
-    dispatcher = command_line_dispatcher.get();
-  }
-  if (!dispatcher || c->compaction_type() != kKeyValueCompaction) {
     return RunSelf();
   }
   Status s;
@@ -1040,7 +1267,8 @@ Status CompactionJob::Run() {
     }
     context.compaction_filter_factory = factory->Name();
   }
-  context.blob_config = c->mutable_cf_options()->get_blob_config();
+  context.blob_config =
+      c->column_family_data()->GetBlobConfig(*c->mutable_cf_options());
   context.separation_type = c->separation_type();
   context.table_factory = iopt->table_factory->Name();
   s = iopt->table_factory->GetOptionString(&context.table_factory_options,
@@ -1103,6 +1331,7 @@ Status CompactionJob::Run() {
         {collector->Name(), {std::move(param)}});
   }
   std::vector<std::function<CompactionWorkerResult()>> results_fn;
+  uint64_t dispatch_micros = env_->NowMicros();
   for (const auto& state : compact_->sub_compact_states) {
     if (state.start != nullptr) {
       context.has_start = true;
@@ -1121,6 +1350,7 @@ Status CompactionJob::Run() {
     results_fn.emplace_back(dispatcher->StartCompaction(context));
   }
   Status status = Status::Corruption();
+  bool run_self = false;
   for (size_t i = 0; i < compact_->sub_compact_states.size(); ++i) {
     auto& sub_compact = compact_->sub_compact_states[i];
     CompactionWorkerResult result;
@@ -1128,6 +1358,15 @@ Status CompactionJob::Run() {
     try {
 #endif
       result = results_fn[i]();
+      if (auto reporter = cfd->latency_reporters().remote_compaction) {
+        // The subcompactions run concurrently, each one since the dispatch
+        reporter->AddRecord(env_->NowMicros() - dispatch_micros);
+      }
+      if (result.status.IsTryAgain()) {
+        // The dispatcher gave up on remote execution
+        run_self = true;
+        continue;
+      }
       sub_compact.status = std::move(result.status);
       s = sub_compact.status;
       if (s.ok()) {
@@ -1146,31 +1385,32 @@ Status CompactionJob::Run() {
           output.meta.largest = std::move(file_info.largest);
           output.meta.marked_for_compaction = file_info.marked_for_compaction;
           // output.stat_one = std::move(file_info.stat_one);
-          std::unique_ptr<TERARKDB_NAMESPACE::RandomAccessFile> file;
-          s = env_->NewRandomAccessFile(fname, &file, env_options_);
-          if (!s.ok()) {
-            break;
-          }
-          std::unique_ptr<TERARKDB_NAMESPACE::RandomAccessFileReader>
-              file_reader(new TERARKDB_NAMESPACE::RandomAccessFileReader(
-                  std::move(file), fname, env_));
-          std::unique_ptr<TERARKDB_NAMESPACE::TableReader> reader;
-          TableReaderOptions table_reader_options(
-              *c->immutable_cf_options(),
-              c->mutable_cf_options()->prefix_extractor.get(), env_options_,
-              c->immutable_cf_options()->internal_comparator);
-          s = c->immutable_cf_options()->table_factory->NewTableReader(
-              table_reader_options, std::move(file_reader),
-              output.meta.fd.file_size, &reader, false);
+          // Open the output the way user reads do and keep it in the table
+          // cache, so the index is warm before the new version is installed.
+          // Later sub compactions are still running remotely meanwhile.
+          Cache::Handle* handle = nullptr;
+          int output_level = c->output_level();
+          s = cfd->table_cache()->FindTable(
+              env_options_, cfd->internal_comparator(), output.meta.fd,
+              &handle, c->mutable_cf_options()->prefix_extractor.get(),
+              false /* no_io */, true /* record_read_stats */,
+              output_level == -1
+                  ? nullptr
+                  : cfd->internal_stats()->GetFileReadHist(output_level),
+              false /* skip_filters */, output_level);
           if (!s.ok()) {
             break;
           }
-          output.table_properties = reader->GetTableProperties();
+          output.table_properties =
+              cfd->table_cache()->GetTableReaderFromHandle(handle)
+                  ->GetTableProperties();
+          cfd->table_cache()->ReleaseHandle(handle);
           auto tp = output.table_properties.get();
           output.meta.prop.num_entries = tp->num_entries;
           output.meta.prop.num_deletions = tp->num_deletions;
           output.meta.prop.raw_key_size = tp->raw_key_size;
           output.meta.prop.raw_value_size = tp->raw_value_size;
+          output.meta.prop.creation_time = tp->creation_time;
           output.meta.prop.flags |= tp->num_range_deletions > 0
                                         ? 0
                                         : TablePropertyCache::kNoRangeDeletions;
@@ -1187,6 +1427,8 @@ Status CompactionJob::Run() {
                 tp->user_collected_properties,
                 &output.meta.prop.earliest_time_begin_compact,
                 &output.meta.prop.latest_time_end_compact);
+            GetTtlExpiryHistogram(tp->user_collected_properties,
+                                  &output.meta.prop.ttl_expiry_histogram);
             ROCKS_LOG_INFO(
                 db_options_.info_log,
                 "CompactionOutput earliest_time_begin_compact = %" PRIu64
@@ -1200,6 +1442,9 @@ Status CompactionJob::Run() {
         if (s.ok()) {
           sub_compact.actual_start = std::move(result.actual_start);
           sub_compact.actual_end = std::move(result.actual_end);
+        } else {
+          // Let CleanupCompaction evict the outputs opened so far
+          sub_compact.status = s;
         }
       }
       if (s.ok()) {
@@ -1230,6 +1475,25 @@ Status CompactionJob::Run() {
     }
 #endif
   }
+  if (run_self) {
+    ROCKS_LOG_INFO(db_options_.info_log,
+                   "[%s] [JOB %d] remote compaction unavailable, run locally",
+                   cfd->GetName().c_str(), job_id_);
+    for (auto& sub_compact : compact_->sub_compact_states) {
+      for (auto& output : sub_compact.outputs) {
+        TableCache::Evict(table_cache_.get(), output.meta.fd.GetNumber());
+        env_->DeleteFile(TableFileName(cfd->ioptions()->cf_paths,
+                                       output.meta.fd.GetNumber(),
+                                       output.meta.fd.GetPathId()));
+      }
+      sub_compact.outputs.clear();
+      sub_compact.status = Status::OK();
+      sub_compact.actual_start.Clear();
+      sub_compact.actual_end.Clear();
+      sub_compact.stat_all.clear();
+    }
+    return RunSelf();
+  }
   if (status.ok()) {
     status = VerifyFiles();
   }
@@ -1240,11 +1504,23 @@ Status CompactionJob::RunSelf() {
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_RUN);
   TEST_SYNC_POINT("CompactionJob::Run():Start");
+  const bool is_gc = compact_->compaction->compaction_type() ==
+                     kGarbageCollection;
+  const uint32_t cf_id = compact_->compaction->column_family_data()->GetID();
+  if (is_gc) {
+    TERARKDB_PROBE2(gc_start, job_id_, cf_id);
+  } else {
+    TERARKDB_PROBE4(compaction_start, job_id_, cf_id,
+                    compact_->compaction->start_level(),
+                    compact_->compaction->output_level());
+  }
   log_buffer_->FlushBufferToLog();
   LogCompaction();
 
-  const size_t num_threads = compact_->sub_compact_states.size();
-  assert(num_threads > 0);
+  const size_t num_subcompactions = compact_->sub_compact_states.size();
+  assert(num_subcompactions > 0);
+  const size_t num_threads = std::max<size_t>(
+      1, std::min(subcompaction_threads_, num_subcompactions));
   const uint64_t start_micros = env_->NowMicros();
 
   if (compact_->compaction->compaction_type() != kMapCompaction) {
@@ -1252,17 +1528,18 @@ Status CompactionJob::RunSelf() {
     std::vector<ProcessArg> vec_process_arg(num_threads - 1);
     for (size_t i = 0; i < num_threads - 1; i++) {
       vec_process_arg[i].job = this;
-      vec_process_arg[i].task_id = int(i);
       vec_process_arg[i].future = vec_process_arg[i].finished.get_future();
-      env_->Schedule(&CompactionJob::CallProcessCompaction, &vec_process_arg[i],
-                     TERARKDB_NAMESPACE::Env::LOW, this, nullptr);
+      ScheduleParallelTask(env_, db_options_.parallel_task_pool.get(),
+                           &CompactionJob::CallProcessCompaction,
+                           &vec_process_arg[i], Env::LOW, this);
     }
-    ProcessCompaction(&compact_->sub_compact_states.back());
+    ProcessSubcompactionQueue();
     for (auto& arg : vec_process_arg) {
       arg.future.wait();
     }
+    ReportProgress(0);
   } else {
-    assert(num_threads == 1);
+    assert(num_subcompactions == 1);
   }
 
   compaction_stats_.micros = env_->NowMicros() - start_micros;
@@ -1292,6 +1569,13 @@ Status CompactionJob::RunSelf() {
   RecordCompactionIOStats();
   LogFlush(db_options_.info_log);
   TEST_SYNC_POINT("CompactionJob::Run():End");
+  if (is_gc) {
+    TERARKDB_PROBE3(gc_done, job_id_, status.ok(),
+                    compaction_stats_.bytes_written);
+  } else {
+    TERARKDB_PROBE3(compaction_done, job_id_, status.ok(),
+                    compaction_stats_.bytes_written);
+  }
 
   compact_->status = status;
   return status;
@@ -1363,7 +1647,9 @@ Status CompactionJob::VerifyFiles() {
     for (size_t i = 0; i < thread_count - 1; ++i) {
       vec_task[i] = std::unique_ptr<AsyncTask<Status>>(
           new AsyncTask<Status>(verify_table));
-      env_->Schedule(c_style_callback(*(vec_task[i])), vec_task[i].get());
+      ScheduleParallelTask(env_, db_options_.parallel_task_pool.get(),
+                           c_style_callback(*(vec_task[i])),
+                           vec_task[i].get());
     }
   }
   Status s = verify_table();
@@ -1449,6 +1735,7 @@ Status CompactionJob::Install(const MutableCFOptions& mutable_cf_options) {
            << compaction_job_stats_->num_single_del_mismatch;
     stream << "num_single_delete_fallthrough"
            << compaction_job_stats_->num_single_del_fallthru;
+    stream << "compaction_cpu_micros" << compaction_job_stats_->cpu_micros;
   }
 
   if (measure_io_stats_ && compaction_job_stats_ != nullptr) {
@@ -1458,6 +1745,24 @@ Status CompactionJob::Install(const MutableCFOptions& mutable_cf_options) {
     stream << "file_fsync_nanos" << compaction_job_stats_->file_fsync_nanos;
     stream << "file_prepare_write_nanos"
            << compaction_job_stats_->file_prepare_write_nanos;
+    const std::pair<const char*, const CompactionJobStats::PhaseTime*>
+        phases[] = {
+            {"input_read", &compaction_job_stats_->input_read_time},
+            {"compaction_iterator",
+             &compaction_job_stats_->compaction_iterator_time},
+            {"compaction_filter",
+             &compaction_job_stats_->compaction_filter_time},
+            {"merge", &compaction_job_stats_->merge_time},
+            {"table_add", &compaction_job_stats_->table_add_time},
+            {"table_finish", &compaction_job_stats_->table_finish_time},
+            {"blob_output", &compaction_job_stats_->blob_output_time},
+        };
+    for (auto& phase : phases) {
+      stream << std::string(phase.first) + "_wall_nanos"
+             << phase.second->wall_nanos;
+      stream << std::string(phase.first) + "_cpu_nanos"
+             << phase.second->cpu_nanos;
+    }
   }
 
   stream << "lsm_state";
@@ -1478,6 +1783,7 @@ Status CompactionJob::Install(const MutableCFOptions& mutable_cf_options) {
 }
 
 void CompactionJob::ProcessCompaction(SubcompactionState* sub_compact) {
+  const uint64_t start_cpu_nanos = env_->NowCPUNanos();
   // SetThreadSched(kSchedIdle);
   switch (sub_compact->compaction->compaction_type()) {
     case kKeyValueCompaction:
@@ -1494,6 +1800,35 @@ void CompactionJob::ProcessCompaction(SubcompactionState* sub_compact) {
       break;
   }
   // SetThreadSched(kSchedOther);
+  sub_compact->compaction_job_stats.cpu_micros +=
+      (env_->NowCPUNanos() - start_cpu_nanos) / 1000;
+}
+
+// The ttl window a put or merge expires in, port::kMaxUint64 for the other
+// entries and the entries without a ttl. Separated values are not fetched
+// for their ttl, their entries have no window here.
+static uint64_t GetTtlWindow(const TtlExtractor* ttl_extractor,
+                             const ParsedInternalKey& ikey,
+                             const LazyBuffer& value, uint64_t now_seconds,
+                             uint64_t ttl_window_seconds) {
+  EntryType entry_type = GetEntryType(ikey.type);
+  if (entry_type != kEntryPut && entry_type != kEntryMerge) {
+    return port::kMaxUint64;
+  }
+  if (!value.fetch().ok()) {
+    return port::kMaxUint64;
+  }
+  bool has_ttl = false;
+  std::chrono::seconds ttl(0);
+  if (!ttl_extractor
+           ->Extract(entry_type, ikey.user_key, value.slice(), &has_ttl, &ttl)
+           .ok() ||
+      !has_ttl) {
+    return port::kMaxUint64;
+  }
+  return (now_seconds + std::min(static_cast<uint64_t>(ttl.count()),
+                                 kFiftyYearSecondsNumber)) /
+         ttl_window_seconds;
 }
 
 void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
@@ -1506,6 +1841,13 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   // the AddTombstones calls will be propagated down to the v1 aggregator.
   std::unique_ptr<InternalIterator> input(versions_->MakeInputIterator(
       sub_compact->compaction, &range_del_agg, env_options_for_read_));
+  // The phases are only timed along with the I/O
+  Env* phase_env = measure_io_stats_ ? env_ : nullptr;
+  CompactionJobStats& job_stats = sub_compact->compaction_job_stats;
+  if (phase_env != nullptr) {
+    input.reset(new InputReadTimingIterator(input.release(), phase_env,
+                                            &job_stats.input_read_time));
+  }
 
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
@@ -1615,22 +1957,37 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   size_t target_blob_file_size =
       MaxBlobSize(*mutable_cf_options, cfd->ioptions()->num_levels,
                   cfd->ioptions()->compaction_style);
+  // With align_blob_output_to_sst the blob output is cut along with the SST
+  // output, unless it would be left smaller than a fragment collected by GC
+  const bool align_blob_output = mutable_cf_options->align_blob_output_to_sst;
+  size_t aligned_blob_file_size = mutable_cf_options->blob_file_defragment_size;
+  if (aligned_blob_file_size == 0) {
+    aligned_blob_file_size = target_blob_file_size / 8;
+  }
+  bool cut_blob_output = false;
 
   auto trans_to_separate = [&](const Slice& key, LazyBuffer& value) {
     Status s;
     TableBuilder* blob_builder = sub_compact->blob_builder.get();
     FileMetaData* blob_meta = &sub_compact->current_blob_output()->meta;
     if (blob_builder != nullptr &&
-        blob_builder->FileSize() > target_blob_file_size) {
+        (blob_builder->FileSize() > target_blob_file_size ||
+         (cut_blob_output &&
+          blob_builder->FileSize() >= aligned_blob_file_size))) {
       s = FinishCompactionOutputBlob(s, sub_compact, {});
       blob_builder = nullptr;
     }
+    cut_blob_output = false;
     if (s.ok() && blob_builder == nullptr) {
       s = OpenCompactionOutputBlob(sub_compact);
       blob_builder = sub_compact->blob_builder.get();
       blob_meta = &sub_compact->current_blob_output()->meta;
     }
     if (s.ok()) {
+      PhaseStopWatch timer(
+          SamplePhase(phase_env, &sub_compact->blob_record_count),
+          &job_stats.blob_output_time.wall_nanos,
+          &job_stats.blob_output_time.cpu_nanos, kPhaseSampleInterval);
       s = blob_builder->Add(key, value);
     }
     if (s.ok()) {
@@ -1678,16 +2035,22 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     status = Status::OK();
   }
 
+  // Both passes must separate values by the same threshold
+  BlobConfig blob_config = cfd->GetBlobConfig(*mutable_cf_options);
   sub_compact->c_iter.reset(new CompactionIterator(
       input.get(), &separate_helper, end, cfd->user_comparator(), &merge,
       versions_->LastSequence(), &existing_snapshots_,
       earliest_write_conflict_snapshot_, snapshot_checker_, env_,
       ShouldReportDetailedTime(env_, stats_), false, &range_del_agg,
-      sub_compact->compaction, mutable_cf_options->get_blob_config(),
-      compaction_filter, shutting_down_, preserve_deletes_seqnum_,
-      &rebuild_blobs_info.blobs));
+      sub_compact->compaction, blob_config, compaction_filter, shutting_down_,
+      preserve_deletes_seqnum_, &rebuild_blobs_info.blobs));
   auto c_iter = sub_compact->c_iter.get();
-  c_iter->SeekToFirst();
+  {
+    PhaseStopWatch timer(phase_env,
+                         &job_stats.compaction_iterator_time.wall_nanos,
+                         &job_stats.compaction_iterator_time.cpu_nanos);
+    c_iter->SeekToFirst();
+  }
 
   struct SecondPassIterStorage {
     std::aligned_storage<sizeof(CompactionRangeDelAggregator),
@@ -1737,7 +2100,7 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
         cfd->user_comparator(), merge_ptr, versions_->LastSequence(),
         &existing_snapshots_, earliest_write_conflict_snapshot_,
         snapshot_checker_, env_, false, false, range_del_agg_ptr,
-        sub_compact->compaction, mutable_cf_options->get_blob_config(),
+        sub_compact->compaction, blob_config,
         second_pass_iter_storage.compaction_filter, shutting_down_,
         preserve_deletes_seqnum_, &rebuild_blobs_info.blobs);
   };
@@ -1752,6 +2115,7 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
                                   sub_compact->current_output_file_size);
   }
   const auto& c_iter_stats = c_iter->iter_stats();
+  uint64_t reported_progress_bytes = 0;
   auto sample_begin_offset_iter = sample_begin_offsets.cbegin();
   // data_begin_offset and dict_sample_data are only valid while generating
   // dictionary from the first output file.
@@ -1763,6 +2127,24 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   }
   std::unordered_map<uint64_t, uint64_t> dependence;
 
+  // Time-series column families cut the output files where the ttl window of
+  // the keys changes, so the files can be dropped wholesale when they expire
+  std::unique_ptr<TtlExtractor> ttl_extractor;
+  uint64_t ttl_window_seconds =
+      sub_compact->compaction->mutable_cf_options()->ttl_window_seconds;
+  uint64_t ttl_now_seconds = 0;
+  uint64_t output_ttl_window = port::kMaxUint64;
+  if (ttl_window_seconds > 0 &&
+      cfd->ioptions()->ttl_extractor_factory != nullptr &&
+      !sub_compact->compaction->partial_compaction()) {
+    TtlExtractorContext ttl_context;
+    ttl_context.column_family_id = cfd->GetID();
+    ttl_extractor =
+        cfd->ioptions()->ttl_extractor_factory->CreateTtlExtractor(
+            ttl_context);
+    ttl_now_seconds = env_->NowMicros() / 1000000;
+  }
+
   size_t yield_count = 0;
   while (status.ok() && !cfd->IsDropped() && c_iter->Valid()) {
     // Invariant: c_iter.status() is guaranteed to be OK if c_iter->Valid()
@@ -1785,6 +2167,10 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
       RecordDroppedKeys(c_iter_stats, &sub_compact->compaction_job_stats);
       c_iter->ResetRecordCounts();
       RecordCompactionIOStats();
+      uint64_t progress_bytes = c_iter_stats.total_input_raw_key_bytes +
+                                c_iter_stats.total_input_raw_value_bytes;
+      ReportProgress(progress_bytes - reported_progress_bytes);
+      reported_progress_bytes = progress_bytes;
     }
 
     // Open output file if necessary
@@ -1802,7 +2188,15 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     }
     assert(sub_compact->builder != nullptr);
     assert(sub_compact->current_output() != nullptr);
-    status = sub_compact->builder->Add(key, value);
+    // Add() and the following Next() are timed on the same records
+    Env* record_env =
+        SamplePhase(phase_env, &sub_compact->output_record_count);
+    {
+      PhaseStopWatch timer(record_env, &job_stats.table_add_time.wall_nanos,
+                           &job_stats.table_add_time.cpu_nanos,
+                           kPhaseSampleInterval);
+      status = sub_compact->builder->Add(key, value);
+    }
     if (!status.ok()) {
       break;
     }
@@ -1810,10 +2204,18 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     sub_compact->current_output()->meta.UpdateBoundaries(
         key, c_iter->ikey().sequence);
     sub_compact->num_output_records++;
+    if (ttl_extractor != nullptr && output_ttl_window == port::kMaxUint64) {
+      output_ttl_window =
+          GetTtlWindow(ttl_extractor.get(), c_iter->ikey(), value,
+                       ttl_now_seconds, ttl_window_seconds);
+    }
 
-    // partial_compaction always output single sst, don't need sample
+    // partial_compaction always output single sst, don't need sample. Once
+    // the samples are taken, values are left to the builder, which may defer
+    // them to the second pass
     if (!sub_compact->compaction->partial_compaction() &&
-        sub_compact->outputs.size() == 1) {  // first output file
+        sub_compact->outputs.size() == 1 &&  // first output file
+        sample_begin_offset_iter != sample_begin_offsets.cend()) {
       // Check if this key/value overlaps any sample intervals; if so, appends
       // overlapping portions to the dictionary.
       status = value.fetch();
@@ -1883,8 +2285,17 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
       // status before advancing will be given to FinishCompactionOutputFile().
       input_status = input->status();
       output_file_ended = true;
+      // The next value is separated while advancing, into the next blob
+      cut_blob_output = align_blob_output;
+    }
+    const bool ended_before_next = output_file_ended;
+    {
+      PhaseStopWatch timer(record_env,
+                           &job_stats.compaction_iterator_time.wall_nanos,
+                           &job_stats.compaction_iterator_time.cpu_nanos,
+                           kPhaseSampleInterval);
+      c_iter->Next();
     }
-    c_iter->Next();
     if (!output_file_ended && c_iter->Valid() &&
         sub_compact->compaction->max_output_file_size() != 0 &&
         sub_compact->ShouldStopBefore(c_iter->key(),
@@ -1896,6 +2307,20 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
       input_status = input->status();
       output_file_ended = true;
     }
+    if (!output_file_ended && c_iter->Valid() && ttl_extractor != nullptr &&
+        output_ttl_window != port::kMaxUint64 &&
+        sub_compact->compaction->max_output_file_size() != 0 &&
+        sub_compact->builder != nullptr) {
+      uint64_t next_ttl_window =
+          GetTtlWindow(ttl_extractor.get(), c_iter->ikey(), c_iter->value(),
+                       ttl_now_seconds, ttl_window_seconds);
+      if (next_ttl_window != port::kMaxUint64 &&
+          next_ttl_window != output_ttl_window) {
+        // (3) this key expires in another window than the file
+        input_status = input->status();
+        output_file_ended = true;
+      }
+    }
     const Slice* next_key = nullptr;
     if (output_file_ended) {
       assert(sub_compact->compaction->max_output_file_size() != 0);
@@ -1909,14 +2334,20 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
               ExtractUserKey(*next_key),
               sub_compact->outputs.back().meta.largest.user_key()) == 0) {
         output_file_ended = false;
+        cut_blob_output = false;
       }
     }
     if (output_file_ended) {
+      if (!ended_before_next) {
+        // The next value is already separated, the blob output lags one key
+        cut_blob_output = align_blob_output;
+      }
       CompactionIterationStats range_del_out_stats;
       status = FinishCompactionOutputFile(input_status, sub_compact,
                                           &range_del_agg, &range_del_out_stats,
                                           dependence, next_key);
       dependence.clear();
+      output_ttl_window = port::kMaxUint64;
       RecordDroppedKeys(range_del_out_stats,
                         &sub_compact->compaction_job_stats);
       if (sub_compact->compaction->partial_compaction()) {
@@ -1958,8 +2389,20 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
 
   RecordTick(stats_, FILTER_OPERATION_TOTAL_TIME,
              c_iter_stats.total_filter_time);
+  if (phase_env != nullptr) {
+    job_stats.compaction_filter_time.wall_nanos +=
+        c_iter_stats.total_filter_time;
+    job_stats.compaction_filter_time.cpu_nanos +=
+        c_iter_stats.total_filter_cpu_time;
+    job_stats.merge_time.wall_nanos += c_iter_stats.total_merge_time;
+    job_stats.merge_time.cpu_nanos += c_iter_stats.total_merge_cpu_time;
+  }
   RecordDroppedKeys(c_iter_stats, &sub_compact->compaction_job_stats);
   RecordCompactionIOStats();
+  ReportProgress(c_iter_stats.total_input_raw_key_bytes +
+                 c_iter_stats.total_input_raw_value_bytes -
+                 reported_progress_bytes);
+  cfd->RecordValueSizes(c_iter_stats);
 
   if (status.ok() &&
       (shutting_down_->load(std::memory_order_relaxed) || cfd->IsDropped())) {
@@ -1997,6 +2440,9 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
       status = s;
     }
   }
+  for (auto& output : sub_compact->outputs) {
+    output.meta.prop.separate_threshold = blob_config.blob_size;
+  }
 
   if (!rebuild_blobs_info.blobs.empty()) {
     ROCKS_LOG_INFO(
@@ -2036,12 +2482,20 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
 void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   assert(sub_compact != nullptr);
   ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
+  LatencyHistGuard guard(cfd->latency_reporters().gc_rewrite);
 
   std::unique_ptr<InternalIterator> input(versions_->MakeInputIterator(
       sub_compact->compaction, nullptr, env_options_for_read_));
+  // The phases are only timed along with the I/O
+  Env* phase_env = measure_io_stats_ ? env_ : nullptr;
+  CompactionJobStats& job_stats = sub_compact->compaction_job_stats;
+  if (phase_env != nullptr) {
+    input.reset(new InputReadTimingIterator(input.release(), phase_env,
+                                            &job_stats.input_read_time));
+  }
 
   AutoThreadOperationStageUpdater stage_updater(
-      ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
+      ThreadStatus::STAGE_GARBAGE_COLLECTION);
 
   // I/O measurement variables
   PerfLevel prev_perf_level = PerfLevel::kEnableTime;
@@ -2093,19 +2547,205 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   auto& comp = cfd->internal_comparator();
   std::string last_key;
   uint64_t last_file_number = uint64_t(-1);
-  IterKey iter_key;
   ParsedInternalKey ikey;
   struct {
     uint64_t input = 0;
     uint64_t garbage_type = 0;
     uint64_t get_not_found = 0;
     uint64_t file_number_mismatch = 0;
+    uint64_t shadowed = 0;
+    uint64_t snapshot_retained = 0;
   } counter;
   std::vector<std::pair<uint64_t, FileMetaData*>> blob_meta_cache;
   assert(!sub_compact->compaction->inputs()->empty());
   blob_meta_cache.reserve(sub_compact->compaction->inputs()->front().size());
+
+  // Liveness of a record only depends on the input version, so checks are
+  // done ahead of the output in batches and spread over the reserved threads.
+  // The blob builder still consumes the records in input order.
+  enum CheckResult : uint8_t {
+    kCheckValid,
+    kCheckGarbageType,
+    kCheckGetNotFound,
+    kCheckFileNumberMismatch,
+  };
+  struct CheckItem {
+    std::string key;
+    FileMetaData* blob_meta;
+    CheckResult result;
+  };
+  const size_t kCheckBatchPerThread = 256;
+  const size_t check_threads = garbage_collection_threads_;
+  std::unique_ptr<InternalIterator> check_input;
+  InternalIterator* check_iter = input.get();
+  if (check_threads > 1) {
+    check_input.reset(versions_->MakeInputIterator(
+        sub_compact->compaction, nullptr, env_options_for_read_));
+    check_input->SeekToFirst();
+    check_iter = check_input.get();
+  }
+  std::vector<CheckItem> check_batch;
+  size_t check_batch_size = 0;
+  size_t check_batch_pos = 0;
+
+  auto check_record = [&](CheckItem& item) {
+    ParsedInternalKey check_ikey;
+    ParseInternalKey(item.key, &check_ikey);
+    IterKey seek_key;
+    seek_key.SetInternalKey(check_ikey.user_key, check_ikey.sequence,
+                            kValueTypeForSeek);
+    Status s;
+    ValueType type = kTypeDeletion;
+    SequenceNumber seq = kMaxSequenceNumber;
+    LazyBuffer value;
+    input_version->GetKey(check_ikey.user_key, seek_key.GetInternalKey(), &s,
+                          &type, &seq, &value, *item.blob_meta);
+    if (s.IsNotFound()) {
+      item.result = kCheckGetNotFound;
+      return Status::OK();
+    } else if (!s.ok()) {
+      return s;
+    } else if (seq != check_ikey.sequence ||
+               (type != kTypeValueIndex && type != kTypeMergeIndex)) {
+      item.result = kCheckGetNotFound;
+      return Status::OK();
+    }
+    s = value.fetch();
+    if (!s.ok()) {
+      return s;
+    }
+    uint64_t file_number = SeparateHelper::DecodeFileNumber(value.slice());
+    auto find = dependence_map.find(file_number);
+    if (find == dependence_map.end()) {
+      return Status::Corruption("Separate value dependence missing");
+    }
+    item.result = find->second->fd.GetNumber() != item.blob_meta->fd.GetNumber()
+                      ? kCheckFileNumberMismatch
+                      : kCheckValid;
+    return Status::OK();
+  };
+  auto check_range = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      auto& item = check_batch[i];
+      if (item.result != kCheckValid) {
+        continue;
+      }
+      Status s = check_record(item);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    return Status::OK();
+  };
+  auto fill_check_batch = [&]() {
+    size_t limit = check_threads > 1 ? check_threads * kCheckBatchPerThread : 1;
+    if (check_batch.size() < limit) {
+      check_batch.resize(limit);
+    }
+    check_batch_size = 0;
+    check_batch_pos = 0;
+    ParsedInternalKey check_ikey;
+    while (check_batch_size < limit && check_iter->Valid()) {
+      Slice key = check_iter->key();
+      if (!ParseInternalKey(key, &check_ikey)) {
+        return Status::Corruption(
+            "ProcessGarbageCollection invalid InternalKey");
+      }
+      uint64_t blob_file_number = check_iter->value().file_number();
+      FileMetaData* blob_meta;
+      auto find_cache = std::find_if(
+          blob_meta_cache.begin(), blob_meta_cache.end(),
+          [blob_file_number](const std::pair<uint64_t, FileMetaData*>& pair) {
+            return pair.first == blob_file_number;
+          });
+      if (find_cache != blob_meta_cache.end()) {
+        blob_meta = find_cache->second;
+      } else {
+        auto find_dependence_map = dependence_map.find(blob_file_number);
+        if (find_dependence_map == dependence_map.end()) {
+          return Status::Corruption(
+              "ProcessGarbageCollection internal error !");
+        }
+        blob_meta = find_dependence_map->second;
+        blob_meta_cache.emplace_back(blob_file_number, blob_meta);
+        assert(blob_meta->fd.GetNumber() == blob_file_number);
+      }
+      auto& item = check_batch[check_batch_size++];
+      item.key.assign(key.data(), key.size());
+      item.blob_meta = blob_meta;
+      item.result =
+          check_ikey.type != kTypeValue && check_ikey.type != kTypeMerge
+              ? kCheckGarbageType
+              : kCheckValid;
+      if (check_iter == input.get()) {
+        break;
+      }
+      check_iter->Next();
+    }
+    if (!check_iter->status().ok()) {
+      return check_iter->status();
+    }
+    size_t thread_count = std::min(
+        check_threads,
+        (check_batch_size + kCheckBatchPerThread - 1) / kCheckBatchPerThread);
+    if (thread_count <= 1) {
+      return check_range(0, check_batch_size);
+    }
+    size_t step = (check_batch_size + thread_count - 1) / thread_count;
+    std::vector<std::unique_ptr<AsyncTask<Status>>> vec_task(thread_count - 1);
+    for (size_t i = 0; i < thread_count - 1; ++i) {
+      size_t begin = (i + 1) * step;
+      size_t end = std::min(begin + step, check_batch_size);
+      vec_task[i] = std::unique_ptr<AsyncTask<Status>>(new AsyncTask<Status>(
+          [&check_range, begin, end] { return check_range(begin, end); }));
+      ScheduleParallelTask(env_, db_options_.parallel_task_pool.get(),
+                           c_style_callback(*(vec_task[i])),
+                           vec_task[i].get());
+    }
+    Status s = check_range(0, step);
+    for (auto& task : vec_task) {
+      s.ok() ? s = task->get() : task->get();
+    }
+    return s;
+  };
+
+  // An older version of a key stays in the SSTs until they are compacted, and
+  // the check above finds it live. Once a newer put of the key is live in the
+  // input and no snapshot sees the older one, nothing reads it anymore, drop
+  // it along with the garbage. A long-lived snapshot then only pins the
+  // versions it sees, the rest is reclaimed without waiting for the SSTs.
+  // Write prepared transactions decide visibility with a snapshot checker,
+  // and iterators from preserved deletes read every version, keep them all
+  const bool drop_shadowed =
+      snapshot_checker_ == nullptr && !db_options_.preserve_deletes;
+  const Comparator* ucmp = comp.user_comparator();
+  std::string shadow_user_key;
+  SequenceNumber shadow_seq = 0;
+
+  // The bytes processed are estimated from the number of records
+  uint64_t input_raw_bytes = 0;
+  uint64_t input_entries = 0;
+  for (auto& level_files : *sub_compact->compaction->inputs()) {
+    for (auto f : level_files.files) {
+      input_raw_bytes += f->prop.raw_key_size + f->prop.raw_value_size;
+      input_entries += f->prop.num_entries;
+    }
+  }
+  uint64_t reported_progress_bytes = 0;
+  auto report_progress = [&] {
+    if (input_entries == 0) {
+      return;
+    }
+    uint64_t progress_bytes = static_cast<uint64_t>(
+        static_cast<double>(input_raw_bytes) * counter.input / input_entries);
+    ReportProgress(progress_bytes - reported_progress_bytes);
+    reported_progress_bytes = progress_bytes;
+  };
+
   while (status.ok() && !cfd->IsDropped() && input->Valid()) {
-    ++counter.input;
+    if (++counter.input % 1000 == 0) {
+      report_progress();
+    }
     Slice curr_key = input->key();
     uint64_t curr_file_number = uint64_t(-1);
     if (!ParseInternalKey(curr_key, &ikey)) {
@@ -2113,76 +2753,68 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
           Status::Corruption("ProcessGarbageCollection invalid InternalKey");
       break;
     }
-    uint64_t blob_file_number = input->value().file_number();
-    FileMetaData* blob_meta;
-    auto find_cache = std::find_if(
-        blob_meta_cache.begin(), blob_meta_cache.end(),
-        [blob_file_number](const std::pair<uint64_t, FileMetaData*>& pair) {
-          return pair.first == blob_file_number;
-        });
-    if (find_cache != blob_meta_cache.end()) {
-      blob_meta = find_cache->second;
-    } else {
-      auto find_dependence_map = dependence_map.find(blob_file_number);
-      if (find_dependence_map == dependence_map.end()) {
+    if (check_batch_pos == check_batch_size) {
+      status = fill_check_batch();
+      if (!status.ok()) {
+        break;
+      }
+      if (check_batch_size == 0) {
         status =
             Status::Corruption("ProcessGarbageCollection internal error !");
         break;
       }
-      blob_meta = find_dependence_map->second;
-      blob_meta_cache.emplace_back(blob_file_number, blob_meta);
-      assert(blob_meta->fd.GetNumber() == blob_file_number);
     }
-    do {
-      if (ikey.type != kTypeValue && ikey.type != kTypeMerge) {
+    auto& check_item = check_batch[check_batch_pos++];
+    assert(curr_key == Slice(check_item.key));
+    switch (check_item.result) {
+      case kCheckGarbageType:
         ++counter.garbage_type;
         break;
-      }
-      iter_key.SetInternalKey(ikey.user_key, ikey.sequence, kValueTypeForSeek);
-      Status s;
-      ValueType type = kTypeDeletion;
-      SequenceNumber seq = kMaxSequenceNumber;
-      LazyBuffer value;
-      input_version->GetKey(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
-                            &seq, &value, *blob_meta);
-      if (s.IsNotFound()) {
-        ++counter.get_not_found;
-        break;
-      } else if (!s.ok()) {
-        status = std::move(s);
-        break;
-      } else if (seq != ikey.sequence ||
-                 (type != kTypeValueIndex && type != kTypeMergeIndex)) {
+      case kCheckGetNotFound:
         ++counter.get_not_found;
         break;
-      }
-      status = value.fetch();
-      if (!status.ok()) {
-        break;
-      }
-      uint64_t file_number = SeparateHelper::DecodeFileNumber(value.slice());
-      auto find = dependence_map.find(file_number);
-      if (find == dependence_map.end()) {
-        status = Status::Corruption("Separate value dependence missing");
-        break;
-      }
-      value = input->value();
-      if (find->second->fd.GetNumber() != value.file_number()) {
+      case kCheckFileNumberMismatch:
         ++counter.file_number_mismatch;
         break;
-      }
-      curr_file_number = value.file_number();
-
-      assert(sub_compact->blob_builder != nullptr);
-      assert(sub_compact->current_blob_output() != nullptr);
-      status = sub_compact->blob_builder->Add(curr_key, value);
-      if (!status.ok()) {
+      case kCheckValid: {
+        if (drop_shadowed && ikey.sequence < shadow_seq &&
+            ucmp->Compare(ikey.user_key, shadow_user_key) == 0) {
+          auto snapshot =
+              std::lower_bound(existing_snapshots_.begin(),
+                               existing_snapshots_.end(), ikey.sequence);
+          if (snapshot == existing_snapshots_.end() ||
+              *snapshot >= shadow_seq) {
+            ++counter.shadowed;
+            break;
+          }
+          ++counter.snapshot_retained;
+        }
+        if (ikey.type == kTypeValue) {
+          shadow_user_key.assign(ikey.user_key.data(), ikey.user_key.size());
+          shadow_seq = ikey.sequence;
+        }
+        LazyBuffer value = input->value();
+        assert(value.file_number() == check_item.blob_meta->fd.GetNumber());
+        curr_file_number = value.file_number();
+
+        assert(sub_compact->blob_builder != nullptr);
+        assert(sub_compact->current_blob_output() != nullptr);
+        {
+          PhaseStopWatch timer(
+              SamplePhase(phase_env, &sub_compact->blob_record_count),
+              &job_stats.blob_output_time.wall_nanos,
+              &job_stats.blob_output_time.cpu_nanos, kPhaseSampleInterval);
+          status = sub_compact->blob_builder->Add(curr_key, value);
+        }
+        if (!status.ok()) {
+          break;
+        }
+        sub_compact->current_blob_output()->meta.UpdateBoundaries(
+            curr_key, ikey.sequence);
+        sub_compact->num_output_records++;
         break;
       }
-      sub_compact->current_blob_output()->meta.UpdateBoundaries(curr_key,
-                                                                ikey.sequence);
-      sub_compact->num_output_records++;
-    } while (false);
+    }
 
     if (counter.input > 1 && comp.Compare(curr_key, last_key) == 0 &&
         (last_file_number & curr_file_number) != uint64_t(-1)) {
@@ -2198,6 +2830,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
 
     input->Next();
   }
+  report_progress();
 
   if (status.ok() &&
       (shutting_down_->load(std::memory_order_relaxed) || cfd->IsDropped())) {
@@ -2228,15 +2861,23 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
         "[%s] [JOB %d] Table #%" PRIu64 " GC: %" PRIu64
         " inputs from %zd files. %" PRIu64
         " clear, %.2f%% estimation: [ %" PRIu64 " garbage type, %" PRIu64
-        " get not found, %" PRIu64
-        " file number mismatch ], inheritance tree: %" PRIu64 " -> %" PRIu64,
+        " get not found, %" PRIu64 " file number mismatch, %" PRIu64
+        " shadowed ], %" PRIu64
+        " kept for snapshots, inheritance tree: %" PRIu64 " -> %" PRIu64,
         cfd->GetName().c_str(), job_id_, meta.fd.GetNumber(), counter.input,
         files.size(), counter.input - meta.prop.num_entries,
         sub_compact->compaction->num_antiquation() * 100. / counter.input,
         counter.garbage_type, counter.get_not_found,
-        counter.file_number_mismatch,
+        counter.file_number_mismatch, counter.shadowed,
+        counter.snapshot_retained,
         meta.prop.inheritance.size() + inheritance_tree_pruge_count,
         meta.prop.inheritance.size());
+    uint64_t read_bytes = 0;
+    for (auto f : files) {
+      read_bytes += f->fd.GetFileSize();
+    }
+    RecordTick(stats_, GC_READ_BYTES, read_bytes);
+    RecordTick(stats_, GC_WRITE_BYTES, meta.fd.GetFileSize());
     if ((std::find_if(files.begin(), files.end(),
                       [](FileMetaData* f) {
                         return f->marked_for_compaction;
@@ -2436,6 +3077,10 @@ Status CompactionJob::FinishCompactionOutputFile(
               TERARK_CMP(file_number, <));
 
     auto shrinked_snapshots = meta->ShrinkSnapshot(existing_snapshots_);
+    LatencyHistGuard guard(cfd->latency_reporters().compaction_finish_table);
+    auto& phase = sub_compact->compaction_job_stats.table_finish_time;
+    PhaseStopWatch timer(measure_io_stats_ ? env_ : nullptr, &phase.wall_nanos,
+                         &phase.cpu_nanos);
     s = sub_compact->builder->Finish(&meta->prop, &shrinked_snapshots);
   } else {
     sub_compact->builder->Abandon();
@@ -2463,6 +3108,7 @@ Status CompactionJob::FinishCompactionOutputFile(
     meta->prop.num_deletions = tp.num_deletions;
     meta->prop.raw_key_size = tp.raw_key_size;
     meta->prop.raw_value_size = tp.raw_value_size;
+    meta->prop.creation_time = tp.creation_time;
     meta->prop.flags |=
         tp.num_range_deletions > 0 ? 0 : TablePropertyCache::kNoRangeDeletions;
     meta->prop.flags |=
@@ -2473,6 +3119,8 @@ Status CompactionJob::FinishCompactionOutputFile(
       GetCompactionTimePoint(tp.user_collected_properties,
                              &meta->prop.earliest_time_begin_compact,
                              &meta->prop.latest_time_end_compact);
+      GetTtlExpiryHistogram(tp.user_collected_properties,
+                            &meta->prop.ttl_expiry_histogram);
       ROCKS_LOG_INFO(db_options_.info_log,
                      "CompactionOutput earliest_time_begin_compact = %" PRIu64
                      ", latest_time_end_compact = %" PRIu64,
@@ -2578,6 +3226,9 @@ Status CompactionJob::FinishCompactionOutputBlob(
     meta->prop.inheritance = InheritanceTreeToSet(inheritance_tree);
     assert(std::is_sorted(meta->prop.inheritance.begin(),
                           meta->prop.inheritance.end()));
+    auto& phase = sub_compact->compaction_job_stats.blob_output_time;
+    PhaseStopWatch timer(measure_io_stats_ ? env_ : nullptr, &phase.wall_nanos,
+                         &phase.cpu_nanos);
     s = sub_compact->blob_builder->Finish(&meta->prop, nullptr,
                                           &inheritance_tree);
   } else {
@@ -2606,6 +3257,7 @@ Status CompactionJob::FinishCompactionOutputBlob(
     meta->prop.num_deletions = tp.num_deletions;
     meta->prop.raw_key_size = tp.raw_key_size;
     meta->prop.raw_value_size = tp.raw_value_size;
+    meta->prop.creation_time = tp.creation_time;
     meta->prop.flags |= TablePropertyCache::kNoRangeDeletions;
   }
 
@@ -2659,10 +3311,18 @@ Status CompactionJob::FinishCompactionOutputBlob(
   return s;
 }
 
+void CompactionJob::ProcessSubcompactionQueue() {
+  auto& sub_compact_states = compact_->sub_compact_states;
+  for (size_t i = next_subcompaction_.fetch_add(1, std::memory_order_relaxed);
+       i < sub_compact_states.size();
+       i = next_subcompaction_.fetch_add(1, std::memory_order_relaxed)) {
+    ProcessCompaction(&sub_compact_states[i]);
+  }
+}
+
 void CompactionJob::CallProcessCompaction(void* arg) {
   ProcessArg* args = (ProcessArg*)arg;
-  args->job->ProcessCompaction(
-      &args->job->compact_->sub_compact_states[args->task_id]);
+  args->job->ProcessSubcompactionQueue();
   auto finished = std::move(args->finished);
   finished.set_value(true);
 }
@@ -2786,11 +3446,21 @@ Status CompactionJob::InstallCompactionResults(
     db_mutex_->Unlock();
     bool optimize_range_deletion = mutable_cf_options.optimize_range_deletion &&
                                    !compaction->bottommost_level();
+    // Nothing lies below the bottommost level, tombstones every snapshot sees
+    // can take the data they cover out of the map
+    SequenceNumber range_deletion_drop_seqno = 0;
+    if (mutable_cf_options.optimize_range_deletion &&
+        compaction->bottommost_level()) {
+      range_deletion_drop_seqno = existing_snapshots_.empty()
+                                      ? kMaxSequenceNumber
+                                      : existing_snapshots_.front();
+    }
     auto s = map_builder.Build(
         *compaction->inputs(), deleted_range, added_files,
         compaction->output_level(), compaction->output_path_id(), cfd,
         optimize_range_deletion, compaction->input_version(),
-        compact_->compaction->edit(), &file_meta, &prop);
+        compact_->compaction->edit(), &file_meta, &prop,
+        nullptr /* deleted_files */, range_deletion_drop_seqno);
     if (s.ok() && file_meta.fd.file_size > 0) {
       // test map sst
       DependenceMap empty_dependence_map;
@@ -2883,6 +3553,15 @@ Status CompactionJob::InstallCompactionResults(
                                 db_mutex_, db_directory_);
 }
 
+void CompactionJob::ReportProgress(uint64_t bytes) {
+  uint64_t done =
+      progress_bytes_done_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  // A no-op on the threads of the subcompactions but the first one, which
+  // are not tracked
+  ThreadStatusUtil::SetThreadOperationProperty(
+      ThreadStatus::COMPACTION_PROGRESS_BYTES_DONE, done);
+}
+
 void CompactionJob::RecordCompactionIOStats() {
   RecordTick(stats_, COMPACT_READ_BYTES, IOSTATS(bytes_read));
   ThreadStatusUtil::IncreaseThreadOperationProperty(
@@ -2894,6 +3573,14 @@ void CompactionJob::RecordCompactionIOStats() {
   IOSTATS_RESET(bytes_written);
 }
 
+Env::IOPriority CompactionJob::GetRateLimiterPriority() const {
+  Compaction* c = compact_->compaction;
+  if (c->compaction_type() != kGarbageCollection && c->start_level() == 0) {
+    return Env::IO_MID;
+  }
+  return Env::IO_LOW;
+}
+
 Status CompactionJob::OpenCompactionOutputFile(
     SubcompactionState* sub_compact) {
   assert(sub_compact != nullptr);
@@ -2939,7 +3626,7 @@ Status CompactionJob::OpenCompactionOutputFile(
   out.finished = false;
 
   sub_compact->outputs.push_back(out);
-  writable_file->SetIOPriority(Env::IO_LOW);
+  writable_file->SetIOPriority(GetRateLimiterPriority());
   writable_file->SetWriteLifeTimeHint(write_hint_);
   writable_file->SetPreallocationBlockSize(static_cast<size_t>(
       sub_compact->compaction->OutputFilePreallocationSize()));
@@ -2947,7 +3634,8 @@ Status CompactionJob::OpenCompactionOutputFile(
       sub_compact->compaction->immutable_cf_options()->listeners;
   sub_compact->outfile.reset(
       new WritableFileWriter(std::move(writable_file), fname, env_options_,
-                             db_options_.statistics.get(), listeners));
+                             db_options_.statistics.get(), listeners,
+                             db_options_.compaction_buffer_allocator.get()));
 
   // If the Column family flag is to only optimize filters for hits,
   // we can skip creating filters if this is the bottommost_level where
@@ -2956,8 +3644,12 @@ Status CompactionJob::OpenCompactionOutputFile(
                           ->optimize_filters_for_hits &&
                       bottommost_level_;
 
+  auto c = sub_compact->compaction;
+  // Recompressed files restart their cold clock
   uint64_t output_file_creation_time =
-      sub_compact->compaction->MaxInputFileCreationTime();
+      c->compaction_reason() == CompactionReason::kColdRecompress
+          ? 0
+          : c->MaxInputFileCreationTime();
   if (output_file_creation_time == 0) {
     int64_t _current_time = 0;
     auto status = db_options_.env->GetCurrentTime(&_current_time);
@@ -2972,7 +3664,6 @@ Status CompactionJob::OpenCompactionOutputFile(
     output_file_creation_time = static_cast<uint64_t>(_current_time);
   }
 
-  auto c = sub_compact->compaction;
   auto& moptions = *c->mutable_cf_options();
   sub_compact->builder.reset(NewTableBuilder(
       *cfd->ioptions(), moptions, cfd->internal_comparator(),
@@ -2985,7 +3676,8 @@ Status CompactionJob::OpenCompactionOutputFile(
       0 /* oldest_key_time */,
       sub_compact->compaction->compaction_type() == kMapCompaction
           ? kMapSst
-          : kEssenceSst));
+          : kEssenceSst,
+      c->compaction_reason()));
   LogFlush(db_options_.info_log);
   return s;
 }
@@ -3035,7 +3727,7 @@ Status CompactionJob::OpenCompactionOutputBlob(
   out.finished = false;
 
   sub_compact->blob_outputs.push_back(out);
-  writable_file->SetIOPriority(Env::IO_LOW);
+  writable_file->SetIOPriority(GetRateLimiterPriority());
   writable_file->SetWriteLifeTimeHint(write_hint_);
   writable_file->SetPreallocationBlockSize(static_cast<size_t>(
       sub_compact->compaction->OutputFilePreallocationSize()));
@@ -3043,7 +3735,8 @@ Status CompactionJob::OpenCompactionOutputBlob(
       sub_compact->compaction->immutable_cf_options()->listeners;
   sub_compact->blob_outfile.reset(
       new WritableFileWriter(std::move(writable_file), fname, env_options_,
-                             db_options_.statistics.get(), listeners));
+                             db_options_.statistics.get(), listeners,
+                             db_options_.compaction_buffer_allocator.get()));
 
   uint64_t output_file_creation_time =
       sub_compact->compaction->MaxInputFileCreationTime();
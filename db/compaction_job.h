@@ -103,7 +103,6 @@ class CompactionJob {
 
   struct ProcessArg {
     CompactionJob* job;
-    int task_id;
     std::promise<bool> finished;
     std::future<bool> future;
   };
@@ -114,7 +113,11 @@ class CompactionJob {
   struct SubcompactionState;
 
   void AggregateStatistics();
-  void GenSubcompactionBoundaries(int max_usable_threads);
+  void GenSubcompactionBoundaries(int max_usable_threads,
+                                  int tasks_per_thread);
+  // Runs pending subcompactions until none is left
+  void ProcessSubcompactionQueue();
+  void SkipCoveredInputFiles();
 
   // update the thread status for starting a compaction.
   void ReportStartedCompaction(Compaction* compaction);
@@ -136,8 +139,14 @@ class CompactionJob {
       const std::vector<uint64_t>& inheritance_tree);
   Status InstallCompactionResults(const MutableCFOptions& mutable_cf_options);
   void RecordCompactionIOStats();
+  // Adds the uncompressed input bytes a subcompaction processed to the
+  // progress published by the thread status
+  void ReportProgress(uint64_t bytes);
   Status OpenCompactionOutputFile(SubcompactionState* sub_compact);
   Status OpenCompactionOutputBlob(SubcompactionState* sub_compact);
+  // Compactions out of L0 keep writes from stalling, they are written ahead
+  // of deeper compactions and GC
+  Env::IOPriority GetRateLimiterPriority() const;
   void CleanupCompaction();
   void UpdateCompactionJobStats(
       const InternalStats::CompactionStats& stats) const;
@@ -199,7 +208,15 @@ class CompactionJob {
   std::vector<Slice> boundaries_;
   // Stores the approx size of keys covered in the range of each subcompaction
   std::vector<uint64_t> sizes_;
+  // Threads running subcompactions, there may be more subcompactions
+  size_t subcompaction_threads_;
+  // Index of the next subcompaction to run
+  std::atomic<size_t> next_subcompaction_;
+  // Threads used to check record liveness for garbage collection
+  size_t garbage_collection_threads_;
   Env::WriteLifeTimeHint write_hint_;
+  // Uncompressed input bytes processed by all the subcompactions
+  std::atomic<uint64_t> progress_bytes_done_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -23,6 +23,7 @@
 #include "db/column_family.h"
 #include "db/map_builder.h"
 #include "rocksdb/terark_namespace.h"
+#include "table/table_reader.h"
 #include "util/c_style_callback.h"
 #include "util/chash_set.h"
 #include "util/filename.h"
@@ -75,11 +76,31 @@ struct GarbageFileInfo {
   FileMetaData* f;
   double score;
   uint64_t estimate_size;
-  GarbageFileInfo(FileMetaData* _f) : f(_f), score(0.0), estimate_size(0) {
+  GarbageFileInfo(FileMetaData* _f, double hotness_weight = 0, uint64_t now = 0)
+      : f(_f), score(0.0), estimate_size(0) {
     if (f == nullptr) return;
-    score = std::min(
+    double garbage_ratio = std::min(
         1.0, f->num_antiquation / std::max<double>(1, f->prop.num_entries));
-    estimate_size = static_cast<uint64_t>(f->fd.file_size * (1 - score));
+    estimate_size =
+        static_cast<uint64_t>(f->fd.file_size * (1 - garbage_ratio));
+    score = garbage_ratio;
+    if (hotness_weight > 0) {
+      // Sampled reads per entry per hour since the blob was created, age is
+      // only known if the table reader is open, which is true for hot blobs
+      double age_hours = 1;
+      if (f->fd.table_reader != nullptr &&
+          f->fd.table_reader->GetTableProperties() != nullptr) {
+        uint64_t creation_time =
+            f->fd.table_reader->GetTableProperties()->creation_time;
+        if (creation_time != 0 && now > creation_time) {
+          age_hours = std::max(1.0, (now - creation_time) / 3600.0);
+        }
+      }
+      double read_rate =
+          f->stats.num_reads_sampled.load(std::memory_order_relaxed) /
+          std::max<double>(1, f->prop.num_entries) / age_hours;
+      score *= 1 + hotness_weight * read_rate / (1 + read_rate);
+    }
   }
 };
 struct FileUseInfo {
@@ -102,12 +123,19 @@ uint64_t TotalCompensatedFileSize(const std::vector<FileMetaData*>& files) {
 /*
  * Find the optimal path to place a file
  * Given a level, finds the path where levels up to it will fit in levels
- * up to and including this path
+ * up to and including this path. Level -1 stands for blob files written by
+ * GC, which are placed like L1 by target size.
  */
 uint32_t GetPathId(const ImmutableCFOptions& ioptions,
                    const MutableCFOptions& mutable_cf_options, int level) {
   uint32_t p = 0;
   assert(!ioptions.cf_paths.empty());
+  if (GetHotPathId(ioptions, mutable_cf_options, level, &p)) {
+    return p;
+  }
+  if (level < 0) {
+    level = 1;
+  }
 
   // size remaining in the most recent path
   uint64_t current_path_size = ioptions.cf_paths[0].target_size;
@@ -375,6 +403,104 @@ bool CompactionPicker::FixInputRange(std::vector<SelectedRange>& input_range,
   return !input_range.empty();
 }
 
+bool CompactionPicker::PickPartialCompactionRange(
+    const std::vector<CompactionInputFiles>& inputs,
+    const InternalKeyComparator& icmp, double max_overlap_ratio,
+    std::vector<SelectedRange>* input_range) {
+  if (!(max_overlap_ratio > 0)) {
+    return false;
+  }
+  auto uc = icmp.user_comparator();
+  std::vector<FileMetaData*> files;
+  uint64_t total_size = 0;
+  for (auto& level_inputs : inputs) {
+    for (auto f : level_inputs.files) {
+      files.emplace_back(f);
+      total_size += f->fd.GetFileSize();
+    }
+  }
+  if (files.size() < 2) {
+    return false;
+  }
+  auto smallest_less = [uc](const FileMetaData* a, const FileMetaData* b) {
+    return uc->Compare(a->smallest.user_key(), b->smallest.user_key()) < 0;
+  };
+  std::sort(files.begin(), files.end(), smallest_less);
+
+  // Key ranges covered by two or more files, both ends included
+  std::vector<std::pair<Slice, Slice>> overlap;
+  Slice max_limit = files.front()->largest.user_key();
+  for (size_t i = 1; i < files.size(); ++i) {
+    Slice start = files[i]->smallest.user_key();
+    Slice limit = files[i]->largest.user_key();
+    if (uc->Compare(start, max_limit) <= 0) {
+      Slice overlap_limit = uc->Compare(limit, max_limit) < 0 ? limit
+                                                              : max_limit;
+      if (!overlap.empty() && uc->Compare(start, overlap.back().second) <= 0) {
+        if (uc->Compare(overlap.back().second, overlap_limit) < 0) {
+          overlap.back().second = overlap_limit;
+        }
+      } else {
+        overlap.emplace_back(start, overlap_limit);
+      }
+    }
+    if (uc->Compare(max_limit, limit) < 0) {
+      max_limit = limit;
+    }
+  }
+  if (overlap.empty()) {
+    return false;
+  }
+  std::vector<uint64_t> overlap_size(overlap.size());
+  uint64_t total_overlap_size = 0;
+  for (auto f : files) {
+    auto find = std::lower_bound(
+        overlap.begin(), overlap.end(), f->smallest.user_key(),
+        [uc](const std::pair<Slice, Slice>& r, const Slice& key) {
+          return uc->Compare(r.second, key) < 0;
+        });
+    if (find != overlap.end() &&
+        uc->Compare(find->first, f->largest.user_key()) <= 0) {
+      overlap_size[find - overlap.begin()] += f->fd.GetFileSize();
+      total_overlap_size += f->fd.GetFileSize();
+    }
+  }
+  if (total_overlap_size >= max_overlap_ratio * total_size) {
+    return false;
+  }
+
+  // A range ends before the next file start behind it, so the files between
+  // two ranges are linked as a whole
+  std::vector<SelectedRange> range;
+  for (size_t i = 0; i < overlap.size(); ++i) {
+    auto next = std::upper_bound(
+        files.begin(), files.end(), overlap[i].second,
+        [uc](const Slice& key, const FileMetaData* f) {
+          return uc->Compare(key, f->smallest.user_key()) < 0;
+        });
+    if (!range.empty() &&
+        uc->Compare(overlap[i].first, range.back().limit) <= 0) {
+      range.back().weight += overlap_size[i];
+    } else {
+      range.emplace_back(overlap[i].first, max_limit, true, true);
+      range.back().weight = overlap_size[i];
+    }
+    if (next != files.end()) {
+      range.back().limit.assign((*next)->smallest.user_key().data(),
+                                (*next)->smallest.user_key().size());
+      range.back().include_limit = false;
+    } else {
+      range.back().limit.assign(max_limit.data(), max_limit.size());
+      range.back().include_limit = true;
+    }
+  }
+  if (!FixInputRange(range, icmp, false /* sort */, false /* merge */)) {
+    return false;
+  }
+  *input_range = std::move(range);
+  return true;
+}
+
 // Delete this compaction from the list of running compactions.
 void CompactionPicker::ReleaseCompactionFiles(Compaction* c, Status status) {
   UnregisterCompaction(c);
@@ -789,7 +915,8 @@ void CompactionPicker::GetGrandparents(
 // Try to perform garbage collection from certain column family.
 // Resulting as a pointer of compaction, nullptr as nothing to do.
 // GC picker's principle:
-// 1. pick the largest score blob, which must more than gc ratio
+// 1. pick the largest score blob, which must more than gc ratio, score is
+//    garbage ratio, optionally boosted by sampled read hotness
 // 2. fragment should be take away by the way
 // 3. it marked for compaction
 Compaction* CompactionPicker::PickGarbageCollection(
@@ -807,6 +934,14 @@ Compaction* CompactionPicker::PickGarbageCollection(
     fragment_size = target_blob_file_size / 8;
   }
 
+  double hotness_weight = mutable_cf_options.blob_gc_hotness_weight;
+  uint64_t now = 0;
+  int64_t current_time = 0;
+  if (hotness_weight > 0 &&
+      ioptions_.env->GetCurrentTime(&current_time).ok()) {
+    now = static_cast<uint64_t>(current_time);
+  }
+
   auto& hidden_files = vstorage->LevelFiles(-1);
   uint64_t idx = 0;
   // Find largest score blob
@@ -817,7 +952,7 @@ Compaction* CompactionPicker::PickGarbageCollection(
     if (!f->is_gc_permitted() || f->being_compacted) {
       continue;
     }
-    GarbageFileInfo info{f};
+    GarbageFileInfo info(f, hotness_weight, now);
     if (info.score > dirtiest_blob.score) {
       dirtiest_blob = info;
     }
@@ -825,6 +960,7 @@ Compaction* CompactionPicker::PickGarbageCollection(
 
   if (dirtiest_blob.f == nullptr ||
       (!dirtiest_blob.f->marked_for_compaction &&
+       !vstorage->space_amp_gc_needed() &&
        dirtiest_blob.score < mutable_cf_options.blob_gc_ratio)) {
     return nullptr;
   }
@@ -879,7 +1015,7 @@ Compaction* CompactionPicker::PickGarbageCollection(
   }
   auto push_candidate = [&](FileMetaData* f) {
     if (f->is_gc_permitted() && !f->being_compacted) {
-      GarbageFileInfo gc_blob(f);
+      GarbageFileInfo gc_blob(f, hotness_weight, now);
       if (gc_blob.estimate_size <= fragment_size ||
           gc_blob.score >= mutable_cf_options.blob_gc_ratio ||
           gc_blob.f->marked_for_compaction) {
@@ -921,12 +1057,12 @@ Compaction* CompactionPicker::PickGarbageCollection(
   params.output_level = -1;
   params.num_antiquation = num_antiquation;
   params.max_compaction_bytes = LLONG_MAX;
-  params.output_path_id = GetPathId(ioptions_, mutable_cf_options, 1);
+  params.output_path_id = GetPathId(ioptions_, mutable_cf_options, -1);
   params.compression = GetCompressionType(
       ioptions_, vstorage, mutable_cf_options, bottommost_level, 1, true);
   params.compression_opts =
       GetCompressionOptions(ioptions_, vstorage, bottommost_level, true);
-  params.max_subcompactions = 1;
+  params.max_subcompactions = mutable_cf_options.max_subcompactions;
   params.score = vstorage->total_garbage_ratio();
   params.compaction_type = kGarbageCollection;
   params.compaction_reason = CompactionReason::kGarbageCollection;
@@ -1710,6 +1846,25 @@ Compaction* CompactionPicker::PickCompositeCompaction(
   double max_read_amp_ratio = -std::numeric_limits<double>::infinity();
   double read_amp = 1;
   uint32_t max_subcompactions = mutable_cf_options.max_subcompactions;
+  size_t max_map_sst_read_amp = mutable_cf_options.max_map_sst_read_amp;
+  auto read_amp_depth = [vstorage](const SortedRun& sr) -> uint64_t {
+    return sr.level > 0 ? vstorage->read_amp_depth(sr.level)
+                        : sr.file->prop.max_read_amp;
+  };
+  // The sorted run reclaiming the most space goes first while the space
+  // amplification is beyond its bound
+  auto& space_amp_run = vstorage->space_amp_sorted_run();
+  // Sorted runs beyond the read amp bound are merged before others
+  bool over_read_amp = false;
+  if (max_map_sst_read_amp > 0) {
+    for (auto& sr : sorted_runs) {
+      if (!sr.skip_composite && !sr.being_compacted &&
+          read_amp_depth(sr) > max_map_sst_read_amp) {
+        over_read_amp = true;
+        break;
+      }
+    }
+  }
   // Traverse all sorted_runs from the highest to bottomest finding selection.
   for (auto& sr : sorted_runs) {
     // Skip if this sorted run was occupied by other compaction.
@@ -1735,6 +1890,18 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       }
       level_read_amp = sr.file->prop.read_amp;
     }
+    if (sr.level == space_amp_run.first &&
+        (sr.level > 0 || sr.file == space_amp_run.second)) {
+      read_amp = level_read_amp;
+      input.level = sr.level;
+      if (sr.level == 0) {
+        input.files = {sr.file};
+      }
+      break;
+    }
+    if (over_read_amp && read_amp_depth(sr) <= max_map_sst_read_amp) {
+      continue;
+    }
     double level_read_amp_ratio = 1. * level_read_amp / sr.size;
     if (level_read_amp <= 1) {
       level_read_amp_ratio = -level_read_amp_ratio;
@@ -1918,6 +2085,11 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     }
     p *= 1 + 1.0 * total_garbage / total_file_size;
     p += file_number_score(map_element);
+    if (max_map_sst_read_amp > 0 &&
+        map_element.link.size() > max_map_sst_read_amp) {
+      // Ranges beyond the read amp bound outweigh any garbage score
+      p += 1e6 * (map_element.link.size() - max_map_sst_read_amp);
+    }
     PickerCompositeHeapItem item = {
         ArenaPinSlice(map_element.largest_key, &arena), p};
     priority_heap.push_back(item);
@@ -2090,7 +2262,9 @@ bool LevelCompactionPicker::NeedsCompaction(
   }
   // FilesMarkedForCompaction & BottommostFilesMarkedForCompaction move to
   // has_space_amplification
-  return vstorage->has_space_amplification();
+  return vstorage->has_space_amplification() ||
+         !vstorage->ColdFilesMarkedForRecompress().empty() ||
+         !vstorage->FilesMarkedForPathMigration().empty();
 }
 
 namespace {
@@ -2256,7 +2430,39 @@ void LevelCompactionBuilder::SetupInitialFiles() {
       return;
     }
 
-    assert(start_level_inputs_.empty());
+    // Cold recompress only takes otherwise idle time, one file at a time
+    if (compaction_picker_->compactions_in_progress()->empty()) {
+      for (auto& level_and_file : vstorage_->ColdFilesMarkedForRecompress()) {
+        if (level_and_file.second->being_compacted) {
+          continue;
+        }
+        start_level_inputs_.level = output_level_ = start_level_ =
+            level_and_file.first;
+        start_level_inputs_.files = {level_and_file.second};
+        if (compaction_picker_->ExpandInputsToCleanCut(cf_name_, vstorage_,
+                                                       &start_level_inputs_)) {
+          compaction_reason_ = CompactionReason::kColdRecompress;
+          return;
+        }
+      }
+      start_level_inputs_.clear();
+
+      // So does moving files to the path of their level
+      for (auto& level_and_file : vstorage_->FilesMarkedForPathMigration()) {
+        if (level_and_file.second->being_compacted) {
+          continue;
+        }
+        start_level_inputs_.level = output_level_ = start_level_ =
+            level_and_file.first;
+        start_level_inputs_.files = {level_and_file.second};
+        if (compaction_picker_->ExpandInputsToCleanCut(cf_name_, vstorage_,
+                                                       &start_level_inputs_)) {
+          compaction_reason_ = CompactionReason::kPathMigration;
+          return;
+        }
+      }
+      start_level_inputs_.clear();
+    }
   }
 }
 
@@ -2326,6 +2532,16 @@ Compaction* LevelCompactionBuilder::PickCompaction() {
     return nullptr;
   }
 
+  // Rewrite only the overlapping key ranges when most of the inputs don't
+  // overlap, the rest of them is linked into a map sst at the output level
+  if (output_level_ != 0 &&
+      (compaction_reason_ == CompactionReason::kLevelL0FilesNum ||
+       compaction_reason_ == CompactionReason::kLevelMaxLevelSize)) {
+    CompactionPicker::PickPartialCompactionRange(
+        compaction_inputs_, ioptions_.internal_comparator,
+        mutable_cf_options_.partial_compaction_overlap_ratio, &input_range_);
+  }
+
   // Form a compaction object containing the files we picked.
   Compaction* c = GetCompaction();
 
@@ -90,6 +90,15 @@ class CompactionPicker {
                             const InternalKeyComparator& icmp, bool sort,
                             bool merge);
 
+  // Fills input_range with the key ranges where input files overlap each
+  // other. Returns false if nothing overlaps, or if the overlapping files make
+  // up max_overlap_ratio or more of the input bytes, then the whole inputs
+  // should be rewritten.
+  static bool PickPartialCompactionRange(
+      const std::vector<CompactionInputFiles>& inputs,
+      const InternalKeyComparator& icmp, double max_overlap_ratio,
+      std::vector<SelectedRange>* input_range);
+
   const EnvOptions& env_options() { return env_options_; }
 
   TableCache* table_cache() { return table_cache_; }
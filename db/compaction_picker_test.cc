@@ -199,6 +199,43 @@ TEST_F(CompactionPickerTest, Level1Trigger2) {
   ASSERT_EQ(uint64_t{1073741824}, compaction->OutputFilePreallocationSize());
 }
 
+TEST_F(CompactionPickerTest, PartialCompactionOverlapRange) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  mutable_cf_options_.level0_file_num_compaction_trigger = 4;
+  mutable_cf_options_.partial_compaction_overlap_ratio = 0.75;
+  Add(0, 1U, "100", "110");
+  Add(0, 2U, "200", "210");
+  Add(0, 3U, "300", "310");
+  Add(0, 4U, "400", "410");
+  Add(1, 6U, "205", "250");
+  Add(1, 7U, "405", "500");
+  UpdateVersionStorageInfo();
+
+  std::unique_ptr<Compaction> compaction(level_compaction_picker.PickCompaction(
+      cf_name_, mutable_cf_options_, vstorage_.get(), {}, &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(4U, compaction->num_input_files(0));
+  ASSERT_EQ(2U, compaction->num_input_files(1));
+  // Files 1 and 3 overlap nothing, they are linked instead of rewritten
+  auto& input_range = compaction->input_range();
+  ASSERT_EQ(2U, input_range.size());
+  ASSERT_EQ("205", input_range[0].start);
+  ASSERT_EQ("300", input_range[0].limit);
+  ASSERT_TRUE(input_range[0].include_start);
+  ASSERT_FALSE(input_range[0].include_limit);
+  ASSERT_EQ("405", input_range[1].start);
+  ASSERT_EQ("500", input_range[1].limit);
+  ASSERT_TRUE(input_range[1].include_limit);
+
+  // 4 of 6 input files overlap
+  std::vector<SelectedRange> range;
+  ASSERT_FALSE(CompactionPicker::PickPartialCompactionRange(
+      *compaction->inputs(), icmp_, 0.5, &range));
+  ASSERT_TRUE(CompactionPicker::PickPartialCompactionRange(
+      *compaction->inputs(), icmp_, 0.7, &range));
+  ASSERT_EQ(2U, range.size());
+}
+
 TEST_F(CompactionPickerTest, LevelMaxScore) {
   NewVersionStorage(6, kCompactionStyleLevel);
   mutable_cf_options_.target_file_size_base = 10000000;
@@ -1426,6 +1463,43 @@ TEST_F(CompactionPickerTest, CacheNextCompactionIndex) {
   ASSERT_EQ(4, vstorage_->NextCompactionIndex(1 /* level */));
 }
 
+TEST_F(CompactionPickerTest, GarbageCollectionHotness) {
+  auto add_blob = [this](uint32_t file_number, const char* smallest,
+                         const char* largest, uint64_t num_antiquation,
+                         uint64_t num_reads_sampled) {
+    Add(-1, file_number, smallest, largest, 1000000U);
+    FileMetaData* f = file_map_[file_number].first;
+    f->gc_status = FileMetaData::kGarbageCollectionPermitted;
+    f->prop.num_entries = 1000;
+    f->num_antiquation = num_antiquation;
+    f->stats.num_reads_sampled = num_reads_sampled;
+  };
+  mutable_cf_options_.blob_gc_ratio = 0.1;
+
+  // Cold blob with more garbage wins by garbage ratio only
+  NewVersionStorage(6, kCompactionStyleLevel);
+  add_blob(1U, "100", "149", 200, 0);
+  add_blob(2U, "500", "549", 150, 100000);
+  UpdateVersionStorageInfo();
+  std::unique_ptr<Compaction> compaction(
+      level_compaction_picker.PickGarbageCollection(
+          cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(1U, compaction->input(0, 0)->fd.GetNumber());
+  compaction.reset();
+
+  // Hot blob with moderate garbage is collected first
+  mutable_cf_options_.blob_gc_hotness_weight = 1;
+  NewVersionStorage(6, kCompactionStyleLevel);
+  add_blob(1U, "100", "149", 200, 0);
+  add_blob(2U, "500", "549", 150, 100000);
+  UpdateVersionStorageInfo();
+  compaction.reset(level_compaction_picker.PickGarbageCollection(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(2U, compaction->input(0, 0)->fd.GetNumber());
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
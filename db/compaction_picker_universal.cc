@@ -925,6 +925,14 @@ Compaction* UniversalCompactionPicker::PickCompactionToReduceSortedRunsOld(
   } else {
     compaction_reason = CompactionReason::kUniversalSortedRunNum;
   }
+  // Sorted runs of disjoint key ranges, e.g. time ordered keys, are linked
+  // into a map sst instead of being rewritten
+  std::vector<SelectedRange> input_range;
+  if (output_level != 0) {
+    PickPartialCompactionRange(
+        inputs, ioptions_.internal_comparator,
+        mutable_cf_options.partial_compaction_overlap_ratio, &input_range);
+  }
   CompactionParams params(vstorage, ioptions_, mutable_cf_options);
   params.inputs = std::move(inputs);
   params.output_level = output_level;
@@ -938,6 +946,7 @@ Compaction* UniversalCompactionPicker::PickCompactionToReduceSortedRunsOld(
   params.compression_opts = GetCompressionOptions(
       ioptions_, vstorage, output_level, enable_compression);
   params.score = score;
+  params.input_range = std::move(input_range);
   params.compaction_reason = compaction_reason;
 
   return new Compaction(std::move(params));
@@ -0,0 +1,385 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+// fname lies in one of paths, and cannot climb out of it
+bool IsUnderPaths(const std::vector<std::string>& paths,
+                  const std::string& fname) {
+  if (fname.find("/../") != std::string::npos ||
+      (fname.size() >= 3 && fname.compare(fname.size() - 3, 3, "/..") == 0)) {
+    return false;
+  }
+  for (auto& path : paths) {
+    if (!path.empty() && fname.size() > path.size() &&
+        fname.compare(0, path.size(), path) == 0 &&
+        (path.back() == '/' || fname[path.size()] == '/')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+struct CompactionTransportService::Rep {
+  struct TransportFile {
+    bool is_output;
+    // Jobs reading an input, an output belongs to one job
+    size_t refs;
+    // Opened on the first chunk, kept until the file is unregistered
+    std::shared_ptr<RandomAccessFile> reader;
+    std::unique_ptr<WritableFile> writer;
+    bool finished;
+  };
+
+  Env* env;
+  EnvOptions env_options;
+  std::vector<std::string> paths;
+  size_t chunk_size;
+  std::mutex mutex;
+  std::unordered_map<std::string, TransportFile> files;
+  std::unordered_map<uint64_t, std::vector<std::string>> jobs;
+
+  void Release(const std::string& fname) {
+    auto find = files.find(fname);
+    assert(find != files.end());
+    if (--find->second.refs == 0) {
+      if (find->second.writer) {
+        find->second.writer->Close();
+      }
+      files.erase(find);
+    }
+  }
+};
+
+CompactionTransportService::CompactionTransportService(
+    Env* env, EnvOptions env_options, std::vector<std::string> paths,
+    size_t chunk_size)
+    : rep_(new Rep()) {
+  rep_->env = env;
+  rep_->env_options = env_options;
+  rep_->paths = std::move(paths);
+  rep_->chunk_size = chunk_size;
+}
+
+CompactionTransportService::~CompactionTransportService() {
+  for (auto& pair : rep_->files) {
+    if (pair.second.writer) {
+      pair.second.writer->Close();
+    }
+  }
+  delete rep_;
+}
+
+Status CompactionTransportService::RegisterJob(
+    uint64_t job_id, const std::vector<std::string>& inputs,
+    const std::vector<std::string>& outputs) {
+  for (auto& fname : inputs) {
+    if (!IsUnderPaths(rep_->paths, fname)) {
+      return Status::InvalidArgument("Input not in the DB paths", fname);
+    }
+  }
+  for (auto& fname : outputs) {
+    if (!IsUnderPaths(rep_->paths, fname)) {
+      return Status::InvalidArgument("Output not in the DB paths", fname);
+    }
+  }
+  std::lock_guard<std::mutex> lock(rep_->mutex);
+  if (rep_->jobs.count(job_id) > 0) {
+    return Status::InvalidArgument("Job already registered");
+  }
+  for (auto& fname : inputs) {
+    auto find = rep_->files.find(fname);
+    if (find != rep_->files.end() && find->second.is_output) {
+      return Status::InvalidArgument("Input is an output of a job", fname);
+    }
+  }
+  for (auto& fname : outputs) {
+    if (rep_->files.count(fname) > 0) {
+      return Status::InvalidArgument("Output already registered", fname);
+    }
+  }
+  auto& job_files = rep_->jobs[job_id];
+  for (auto& fname : inputs) {
+    auto ib = rep_->files.emplace(
+        fname, Rep::TransportFile{false, 0, nullptr, nullptr, false});
+    ++ib.first->second.refs;
+    job_files.emplace_back(fname);
+  }
+  for (auto& fname : outputs) {
+    rep_->files.emplace(fname,
+                        Rep::TransportFile{true, 1, nullptr, nullptr, false});
+    job_files.emplace_back(fname);
+  }
+  return Status::OK();
+}
+
+void CompactionTransportService::UnregisterJob(uint64_t job_id) {
+  std::lock_guard<std::mutex> lock(rep_->mutex);
+  auto find = rep_->jobs.find(job_id);
+  if (find == rep_->jobs.end()) {
+    return;
+  }
+  for (auto& fname : find->second) {
+    rep_->Release(fname);
+  }
+  rep_->jobs.erase(find);
+}
+
+Status CompactionTransportService::ReadChunk(const std::string& fname,
+                                             uint64_t offset, size_t n,
+                                             std::string* chunk) {
+  std::shared_ptr<RandomAccessFile> file;
+  {
+    std::lock_guard<std::mutex> lock(rep_->mutex);
+    auto find = rep_->files.find(fname);
+    if (find == rep_->files.end() || find->second.is_output) {
+      return Status::InvalidArgument("Not a registered input", fname);
+    }
+    if (!find->second.reader) {
+      std::unique_ptr<RandomAccessFile> reader;
+      Status s =
+          rep_->env->NewRandomAccessFile(fname, &reader, rep_->env_options);
+      if (!s.ok()) {
+        return s;
+      }
+      find->second.reader = std::move(reader);
+    }
+    file = find->second.reader;
+  }
+  n = std::min(n, rep_->chunk_size);
+  chunk->resize(n);
+  Slice result;
+  Status s = file->Read(offset, n, &result, &(*chunk)[0]);
+  if (!s.ok()) {
+    chunk->clear();
+    return s;
+  }
+  if (result.data() != chunk->data()) {
+    memmove(&(*chunk)[0], result.data(), result.size());
+  }
+  chunk->resize(result.size());
+  return s;
+}
+
+Status CompactionTransportService::WriteChunk(const std::string& fname,
+                                              const Slice& chunk) {
+  std::lock_guard<std::mutex> lock(rep_->mutex);
+  auto find = rep_->files.find(fname);
+  if (find == rep_->files.end() || !find->second.is_output) {
+    return Status::InvalidArgument("Not a registered output", fname);
+  }
+  auto& file = find->second;
+  if (file.finished) {
+    return Status::InvalidArgument("Output already finished", fname);
+  }
+  if (!file.writer) {
+    Status s =
+        rep_->env->NewWritableFile(fname, &file.writer, rep_->env_options);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return chunk.empty() ? Status::OK() : file.writer->Append(chunk);
+}
+
+Status CompactionTransportService::FinishOutput(const std::string& fname) {
+  std::unique_ptr<WritableFile> file;
+  {
+    std::lock_guard<std::mutex> lock(rep_->mutex);
+    auto find = rep_->files.find(fname);
+    if (find == rep_->files.end() || !find->second.is_output ||
+        !find->second.writer) {
+      return Status::InvalidArgument("Output not opened", fname);
+    }
+    file = std::move(find->second.writer);
+    find->second.finished = true;
+  }
+  Status s = file->Sync();
+  if (s.ok()) {
+    s = file->Close();
+  }
+  return s;
+}
+
+namespace {
+
+// Keeps the last fetched chunk, table readers mostly read forward
+class TransportRandomAccessFile : public RandomAccessFile {
+ public:
+  TransportRandomAccessFile(std::string fname, CompactionTransport* transport,
+                            size_t chunk_size)
+      : fname_(std::move(fname)),
+        transport_(transport),
+        chunk_size_(chunk_size),
+        chunk_offset_(0),
+        chunk_eof_(false) {}
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    if (n >= chunk_size_) {
+      // The host sends at most chunk_size_ bytes per call
+      std::string chunk;
+      size_t done = 0;
+      while (done < n) {
+        size_t want = std::min(n - done, chunk_size_);
+        Status s = transport_->ReadChunk(fname_, offset + done, want, &chunk);
+        if (!s.ok()) {
+          return s;
+        }
+        memcpy(scratch + done, chunk.data(), chunk.size());
+        done += chunk.size();
+        if (chunk.size() < want) {
+          break;
+        }
+      }
+      *result = Slice(scratch, done);
+      return Status::OK();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t chunk_end = chunk_offset_ + chunk_.size();
+    bool hit = offset >= chunk_offset_ &&
+               (offset + n <= chunk_end || (chunk_eof_ && offset <= chunk_end));
+    if (!hit) {
+      Status s = transport_->ReadChunk(fname_, offset, chunk_size_, &chunk_);
+      if (!s.ok()) {
+        chunk_.clear();
+        chunk_eof_ = false;
+        return s;
+      }
+      chunk_offset_ = offset;
+      chunk_eof_ = chunk_.size() < chunk_size_;
+    }
+    size_t pos = static_cast<size_t>(offset - chunk_offset_);
+    size_t len = std::min(n, chunk_.size() - pos);
+    memcpy(scratch, chunk_.data() + pos, len);
+    *result = Slice(scratch, len);
+    return Status::OK();
+  }
+
+ private:
+  const std::string fname_;
+  CompactionTransport* transport_;
+  const size_t chunk_size_;
+
+  mutable std::mutex mutex_;
+  mutable std::string chunk_;
+  mutable uint64_t chunk_offset_;
+  mutable bool chunk_eof_;
+};
+
+class TransportWritableFile : public WritableFile {
+ public:
+  TransportWritableFile(std::string fname, CompactionTransport* transport,
+                        size_t chunk_size)
+      : fname_(std::move(fname)),
+        transport_(transport),
+        chunk_size_(chunk_size),
+        file_size_(0),
+        closed_(false) {}
+
+  ~TransportWritableFile() {
+    if (!closed_) {
+      Close();
+    }
+  }
+
+  Status Append(const Slice& data) override {
+    buffer_.append(data.data(), data.size());
+    file_size_ += data.size();
+    if (buffer_.size() >= chunk_size_) {
+      return Flush();
+    }
+    return Status::OK();
+  }
+
+  Status Flush() override {
+    if (buffer_.empty()) {
+      return Status::OK();
+    }
+    Status s = transport_->WriteChunk(fname_, buffer_);
+    buffer_.clear();
+    return s;
+  }
+
+  Status Sync() override { return Flush(); }
+
+  Status Close() override {
+    closed_ = true;
+    Status s = Flush();
+    if (s.ok()) {
+      s = transport_->FinishOutput(fname_);
+    }
+    return s;
+  }
+
+  uint64_t GetFileSize() override { return file_size_; }
+
+ private:
+  const std::string fname_;
+  CompactionTransport* transport_;
+  const size_t chunk_size_;
+  std::string buffer_;
+  uint64_t file_size_;
+  bool closed_;
+};
+
+class CompactionTransportEnv : public EnvWrapper {
+ public:
+  CompactionTransportEnv(Env* base_env,
+                         std::shared_ptr<CompactionTransport> transport,
+                         size_t chunk_size)
+      : EnvWrapper(base_env),
+        transport_(std::move(transport)),
+        chunk_size_(std::max<size_t>(chunk_size, 4096)) {}
+
+  Status NewRandomAccessFile(const std::string& fname,
+                             std::unique_ptr<RandomAccessFile>* result,
+                             const EnvOptions& /*options*/) override {
+    result->reset(
+        new TransportRandomAccessFile(fname, transport_.get(), chunk_size_));
+    return Status::OK();
+  }
+
+  Status NewWritableFile(const std::string& fname,
+                         std::unique_ptr<WritableFile>* result,
+                         const EnvOptions& /*options*/) override {
+    // Create the file on the host now so errors surface on open
+    Status s = transport_->WriteChunk(fname, Slice());
+    if (s.ok()) {
+      result->reset(
+          new TransportWritableFile(fname, transport_.get(), chunk_size_));
+    }
+    return s;
+  }
+
+ private:
+  std::shared_ptr<CompactionTransport> transport_;
+  const size_t chunk_size_;
+};
+
+}  // namespace
+
+Env* NewCompactionTransportEnv(Env* base_env,
+                               std::shared_ptr<CompactionTransport> transport,
+                               size_t chunk_size) {
+  return new CompactionTransportEnv(base_env, std::move(transport),
+                                    chunk_size);
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,162 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Forwards straight to the service, as an RPC stub would
+class LoopbackTransport : public CompactionTransport {
+ public:
+  explicit LoopbackTransport(CompactionTransportService* service)
+      : service_(service), reads(0), writes(0) {}
+
+  Status ReadChunk(const std::string& fname, uint64_t offset, size_t n,
+                   std::string* chunk) override {
+    ++reads;
+    return service_->ReadChunk(fname, offset, n, chunk);
+  }
+  Status WriteChunk(const std::string& fname, const Slice& chunk) override {
+    ++writes;
+    return service_->WriteChunk(fname, chunk);
+  }
+  Status FinishOutput(const std::string& fname) override {
+    return service_->FinishOutput(fname);
+  }
+
+  CompactionTransportService* service_;
+  size_t reads, writes;
+};
+
+class CompactionTransportTest : public testing::Test {
+ public:
+  CompactionTransportTest()
+      : host_env_(NewMemEnv(Env::Default())),
+        service_(host_env_.get(), EnvOptions(), {"/db"}, 4096),
+        transport_(std::make_shared<LoopbackTransport>(&service_)),
+        worker_env_(
+            NewCompactionTransportEnv(Env::Default(), transport_, 4096)) {}
+
+  std::unique_ptr<Env> host_env_;
+  CompactionTransportService service_;
+  std::shared_ptr<LoopbackTransport> transport_;
+  std::unique_ptr<Env> worker_env_;
+};
+
+TEST_F(CompactionTransportTest, StreamInput) {
+  Random rnd(301);
+  std::string data;
+  test::RandomString(&rnd, 10000, &data);
+  ASSERT_OK(host_env_->CreateDirIfMissing("/db"));
+  ASSERT_OK(WriteStringToFile(host_env_.get(), data, "/db/input.sst"));
+  ASSERT_OK(service_.RegisterJob(1, {"/db/input.sst", "/db/missing.sst"}, {}));
+
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(
+      worker_env_->NewRandomAccessFile("/db/input.sst", &file, EnvOptions()));
+  std::string scratch(data.size() + 100, '\0');
+  Slice result;
+  // Small forward reads share one chunk
+  for (size_t offset = 0; offset < 4000; offset += 100) {
+    ASSERT_OK(file->Read(offset, 100, &result, &scratch[0]));
+    ASSERT_EQ(data.substr(offset, 100), result.ToString());
+  }
+  ASSERT_EQ(1u, transport_->reads);
+  // Large reads bypass the chunk, in pieces the host accepts
+  ASSERT_OK(file->Read(0, data.size(), &result, &scratch[0]));
+  ASSERT_EQ(data, result.ToString());
+  ASSERT_EQ(4u, transport_->reads);
+  // Short read at end of file
+  ASSERT_OK(file->Read(9950, 100, &result, &scratch[0]));
+  ASSERT_EQ(data.substr(9950), result.ToString());
+
+  // Missing files fail on first read
+  ASSERT_OK(
+      worker_env_->NewRandomAccessFile("/db/missing.sst", &file, EnvOptions()));
+  ASSERT_NOK(file->Read(0, 10, &result, &scratch[0]));
+
+  // The host never sends more than its chunk size
+  std::string chunk;
+  ASSERT_OK(service_.ReadChunk("/db/input.sst", 0, data.size(), &chunk));
+  ASSERT_EQ(data.substr(0, 4096), chunk);
+
+  service_.UnregisterJob(1);
+  ASSERT_TRUE(
+      service_.ReadChunk("/db/input.sst", 0, 100, &chunk).IsInvalidArgument());
+}
+
+TEST_F(CompactionTransportTest, StreamOutput) {
+  Random rnd(301);
+  std::string data;
+  test::RandomString(&rnd, 10000, &data);
+
+  std::unique_ptr<WritableFile> file;
+  ASSERT_OK(host_env_->CreateDirIfMissing("/db"));
+  ASSERT_OK(service_.RegisterJob(1, {}, {"/db/output.sst"}));
+  ASSERT_OK(
+      worker_env_->NewWritableFile("/db/output.sst", &file, EnvOptions()));
+  ASSERT_OK(host_env_->FileExists("/db/output.sst"));
+  for (size_t offset = 0; offset < data.size(); offset += 1000) {
+    ASSERT_OK(file->Append(data.substr(offset, 1000)));
+  }
+  ASSERT_EQ(data.size(), file->GetFileSize());
+  ASSERT_OK(file->Close());
+  // One create plus chunks of at least 4096 bytes
+  ASSERT_EQ(3u, transport_->writes);
+
+  std::string read;
+  ASSERT_OK(ReadFileToString(host_env_.get(), "/db/output.sst", &read));
+  ASSERT_EQ(data, read);
+  // A finished output is not reopened
+  ASSERT_TRUE(
+      service_.WriteChunk("/db/output.sst", "x").IsInvalidArgument());
+  service_.UnregisterJob(1);
+}
+
+TEST_F(CompactionTransportTest, RejectUnregisteredFiles) {
+  ASSERT_OK(host_env_->CreateDirIfMissing("/db"));
+  ASSERT_OK(WriteStringToFile(host_env_.get(), "secret", "/etc.conf"));
+  ASSERT_OK(WriteStringToFile(host_env_.get(), "data", "/db/input.sst"));
+
+  // Files outside of the DB paths are never registered
+  ASSERT_TRUE(
+      service_.RegisterJob(1, {"/etc.conf"}, {}).IsInvalidArgument());
+  ASSERT_TRUE(service_.RegisterJob(1, {"/db/../etc.conf"}, {})
+                  .IsInvalidArgument());
+  ASSERT_TRUE(service_.RegisterJob(1, {}, {"/dbx/output.sst"})
+                  .IsInvalidArgument());
+
+  std::string chunk;
+  ASSERT_TRUE(
+      service_.ReadChunk("/etc.conf", 0, 100, &chunk).IsInvalidArgument());
+  ASSERT_TRUE(
+      service_.ReadChunk("/db/input.sst", 0, 100, &chunk).IsInvalidArgument());
+  ASSERT_TRUE(
+      service_.WriteChunk("/db/output.sst", "x").IsInvalidArgument());
+  ASSERT_TRUE(host_env_->FileExists("/db/output.sst").IsNotFound());
+
+  // Inputs are read only, an output belongs to one job
+  ASSERT_OK(service_.RegisterJob(1, {"/db/input.sst"}, {"/db/output.sst"}));
+  ASSERT_TRUE(
+      service_.WriteChunk("/db/input.sst", "x").IsInvalidArgument());
+  ASSERT_TRUE(service_.RegisterJob(2, {}, {"/db/output.sst"})
+                  .IsInvalidArgument());
+  ASSERT_OK(service_.RegisterJob(2, {"/db/input.sst"}, {}));
+  service_.UnregisterJob(1);
+  ASSERT_OK(service_.ReadChunk("/db/input.sst", 0, 100, &chunk));
+  ASSERT_EQ("data", chunk);
+  service_.UnregisterJob(2);
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,442 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include <string.h>
+
+#include "db/compaction.h"
+#include "rocksdb/terark_namespace.h"
+#include "table/block_based_table_builder.h"
+#include "table/format.h"
+#include "util/coding.h"
+#include "util/compression.h"
+#include "util/string_util.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Layout of an encoded CompactionWorkerContext or CompactionWorkerResult:
+//   fixed32 magic, varint32 format version, byte compression type, payload
+// The payload is compressed with compress_format_version 2, which records the
+// uncompressed size. Fields follow in declaration order, bump
+// kCompactionWorkerFormatVersion whenever the layout changes.
+namespace {
+
+const uint32_t kCompactionWorkerMagic = 0x57435442;  // "BTCW"
+const uint32_t kCompactionWorkerFormatVersion = 1;
+const uint32_t kCompressFormatVersion = 2;
+
+void PutBool(std::string* dst, bool value) { dst->push_back(value ? 1 : 0); }
+
+void PutDouble(std::string* dst, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof bits);
+  PutFixed64(dst, bits);
+}
+
+void PutFloat(std::string* dst, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof bits);
+  PutFixed32(dst, bits);
+}
+
+void PutStatus(std::string* dst, const Status& status) {
+  dst->push_back(static_cast<char>(status.code()));
+  dst->push_back(static_cast<char>(status.subcode()));
+  dst->push_back(static_cast<char>(status.severity()));
+  PutLengthPrefixedSlice(
+      dst, status.getState() == nullptr ? Slice() : Slice(status.getState()));
+}
+
+void PutFileMetaData(std::string* dst, const FileMetaData& f) {
+  PutVarint64(dst, f.fd.packed_number_and_path_id);
+  PutVarint64(dst, f.fd.file_size);
+  PutVarint64(dst, f.fd.smallest_seqno);
+  PutVarint64(dst, f.fd.largest_seqno);
+  PutLengthPrefixedSlice(dst, *f.smallest.rep());
+  PutLengthPrefixedSlice(dst, *f.largest.rep());
+  auto& prop = f.prop;
+  PutVarint64(dst, prop.num_entries);
+  PutVarint64(dst, prop.num_deletions);
+  PutVarint64(dst, prop.raw_key_size);
+  PutVarint64(dst, prop.raw_value_size);
+  dst->push_back(static_cast<char>(prop.flags));
+  dst->push_back(static_cast<char>(prop.purpose));
+  PutVarint32(dst, prop.max_read_amp);
+  PutFloat(dst, prop.read_amp);
+  PutVarint64(dst, prop.dependence.size());
+  for (auto& d : prop.dependence) {
+    PutVarint64Varint64(dst, d.file_number, d.entry_count);
+  }
+  PutVarint64(dst, prop.inheritance.size());
+  for (auto n : prop.inheritance) {
+    PutVarint64(dst, n);
+  }
+}
+
+// Compresses "raw" behind the common header
+void FinishEncoding(const std::string& raw, CompressionType compression,
+                    std::string* dst) {
+  std::string compressed;
+  CompressionContext ctx(compression);
+  Slice payload = CompressBlock(raw, ctx, &compression, kCompressFormatVersion,
+                                &compressed);
+  PutFixed32(dst, kCompactionWorkerMagic);
+  PutVarint32(dst, kCompactionWorkerFormatVersion);
+  dst->push_back(static_cast<char>(compression));
+  dst->append(payload.data(), payload.size());
+}
+
+class Decoder {
+ public:
+  Decoder() : ok_(true) {}
+
+  Status Init(const Slice& src, CompressionType* compression) {
+    input_ = src;
+    uint32_t magic = 0, version = 0;
+    if (!GetFixed32(&input_, &magic) || magic != kCompactionWorkerMagic ||
+        !GetVarint32(&input_, &version) || input_.empty()) {
+      return Status::Corruption("Bad compaction worker encoding");
+    }
+    if (version > kCompactionWorkerFormatVersion) {
+      return Status::NotSupported("Compaction worker format version",
+                                  ToString(version));
+    }
+    auto type = static_cast<CompressionType>(input_[0]);
+    input_.remove_prefix(1);
+    if (compression != nullptr) {
+      *compression = type;
+    }
+    if (type != kNoCompression) {
+      ImmutableCFOptions ioptions{Options()};
+      UncompressionContext ctx(type);
+      Status s = UncompressBlockContentsForCompressionType(
+          ctx, input_.data(), input_.size(), &contents_,
+          kCompressFormatVersion, ioptions);
+      if (!s.ok()) {
+        return s;
+      }
+      input_ = contents_.data;
+    }
+    return Status::OK();
+  }
+
+  Status status() const {
+    return ok_ ? Status::OK()
+               : Status::Corruption("Truncated compaction worker encoding");
+  }
+
+  void Get(uint64_t* value) { ok_ = ok_ && GetVarint64(&input_, value); }
+  void Get(uint32_t* value) { ok_ = ok_ && GetVarint32(&input_, value); }
+  void Get(int* value) {
+    uint32_t v = 0;
+    Get(&v);
+    *value = static_cast<int>(v);
+  }
+  void Get(uint16_t* value) {
+    uint32_t v = 0;
+    Get(&v);
+    *value = static_cast<uint16_t>(v);
+  }
+  void Get(uint8_t* value) {
+    ok_ = ok_ && !input_.empty();
+    if (ok_) {
+      *value = static_cast<uint8_t>(input_[0]);
+      input_.remove_prefix(1);
+    }
+  }
+  void Get(bool* value) {
+    uint8_t v = 0;
+    Get(&v);
+    *value = v != 0;
+  }
+  void Get(double* value) {
+    uint64_t bits = 0;
+    ok_ = ok_ && GetFixed64(&input_, &bits);
+    memcpy(value, &bits, sizeof bits);
+  }
+  void Get(float* value) {
+    uint32_t bits = 0;
+    ok_ = ok_ && GetFixed32(&input_, &bits);
+    memcpy(value, &bits, sizeof bits);
+  }
+  void Get(std::string* value) {
+    Slice slice;
+    ok_ = ok_ && GetLengthPrefixedSlice(&input_, &slice);
+    if (ok_) {
+      value->assign(slice.data(), slice.size());
+    }
+  }
+  void Get(CompactionWorkerContext::EncodedString* value) { Get(&value->data); }
+  void Get(InternalKey* value) { Get(value->rep()); }
+  void Get(CompressionType* value) {
+    uint8_t v = 0;
+    Get(&v);
+    *value = static_cast<CompressionType>(v);
+  }
+  void Get(Status* value) {
+    uint8_t code = 0, subcode = 0, sev = 0;
+    std::string state;
+    Get(&code);
+    Get(&subcode);
+    Get(&sev);
+    Get(&state);
+    if (ok_) {
+      *value = Status(code, subcode, sev,
+                      state.empty() ? nullptr : state.c_str());
+    }
+  }
+  void Get(FileMetaData* f) {
+    Get(&f->fd.packed_number_and_path_id);
+    Get(&f->fd.file_size);
+    Get(&f->fd.smallest_seqno);
+    Get(&f->fd.largest_seqno);
+    Get(&f->smallest);
+    Get(&f->largest);
+    auto& prop = f->prop;
+    Get(&prop.num_entries);
+    Get(&prop.num_deletions);
+    Get(&prop.raw_key_size);
+    Get(&prop.raw_value_size);
+    Get(&prop.flags);
+    Get(&prop.purpose);
+    Get(&prop.max_read_amp);
+    Get(&prop.read_amp);
+    uint64_t size = 0;
+    Get(&size);
+    prop.dependence.clear();
+    for (uint64_t i = 0; ok_ && i < size; ++i) {
+      Dependence d;
+      Get(&d.file_number);
+      Get(&d.entry_count);
+      prop.dependence.emplace_back(d);
+    }
+    size = 0;
+    Get(&size);
+    prop.inheritance.clear();
+    for (uint64_t i = 0; ok_ && i < size; ++i) {
+      uint64_t n = 0;
+      Get(&n);
+      prop.inheritance.emplace_back(n);
+    }
+  }
+  template <class T>
+  void Get(std::vector<T>* values) {
+    uint64_t size = 0;
+    Get(&size);
+    values->clear();
+    // Every element takes at least one byte, reject absurd sizes early
+    ok_ = ok_ && size <= input_.size();
+    for (uint64_t i = 0; ok_ && i < size; ++i) {
+      values->emplace_back();
+      Get(&values->back());
+    }
+  }
+  template <class T1, class T2>
+  void Get(std::pair<T1, T2>* value) {
+    Get(&value->first);
+    Get(&value->second);
+  }
+  void Get(CompactionWorkerContext::NameParam* value) {
+    Get(&value->name);
+    Get(&value->param);
+  }
+  void Get(CompactionWorkerResult::FileInfo* value) {
+    Get(&value->smallest);
+    Get(&value->largest);
+    Get(&value->file_name);
+    Get(&value->smallest_seqno);
+    Get(&value->largest_seqno);
+    uint64_t file_size = 0;
+    Get(&file_size);
+    value->file_size = static_cast<size_t>(file_size);
+    Get(&value->marked_for_compaction);
+  }
+
+ private:
+  Slice input_;
+  BlockContents contents_;
+  bool ok_;
+};
+
+}  // namespace
+
+bool IsCompactionWorkerEncoding(const Slice& src) {
+  uint32_t magic;
+  Slice input = src;
+  return GetFixed32(&input, &magic) && magic == kCompactionWorkerMagic;
+}
+
+void CompactionWorkerContext::EncodeTo(std::string* dst,
+                                       CompressionType _compression) const {
+  std::string raw;
+  PutLengthPrefixedSlice(&raw, user_comparator);
+  PutLengthPrefixedSlice(&raw, merge_operator);
+  PutLengthPrefixedSlice(&raw, merge_operator_data.data);
+  PutLengthPrefixedSlice(&raw, value_meta_extractor_factory);
+  PutLengthPrefixedSlice(&raw, value_meta_extractor_factory_options.data);
+  PutLengthPrefixedSlice(&raw, compaction_filter);
+  PutLengthPrefixedSlice(&raw, compaction_filter_factory);
+  PutBool(&raw, compaction_filter_context.is_full_compaction);
+  PutBool(&raw, compaction_filter_context.is_manual_compaction);
+  PutBool(&raw, compaction_filter_context.is_bottommost_level);
+  PutVarint32(&raw, compaction_filter_context.column_family_id);
+  PutLengthPrefixedSlice(&raw, compaction_filter_data.data);
+  PutVarint64(&raw, blob_config.blob_size);
+  PutDouble(&raw, blob_config.large_key_ratio);
+  PutVarint32(&raw, separation_type);
+  PutLengthPrefixedSlice(&raw, table_factory);
+  PutLengthPrefixedSlice(&raw, table_factory_options);
+  PutVarint32(&raw, bloom_locality);
+  PutVarint64(&raw, cf_paths.size());
+  for (auto& path : cf_paths) {
+    PutLengthPrefixedSlice(&raw, path);
+  }
+  PutLengthPrefixedSlice(&raw, prefix_extractor);
+  PutLengthPrefixedSlice(&raw, prefix_extractor_options);
+  PutBool(&raw, has_start);
+  PutBool(&raw, has_end);
+  PutLengthPrefixedSlice(&raw, start.data);
+  PutLengthPrefixedSlice(&raw, end.data);
+  PutVarint64(&raw, last_sequence);
+  PutVarint64(&raw, earliest_write_conflict_snapshot);
+  PutVarint64(&raw, preserve_deletes_seqnum);
+  PutVarint64(&raw, file_metadata.size());
+  for (auto& pair : file_metadata) {
+    PutVarint64(&raw, pair.first);
+    PutFileMetaData(&raw, pair.second);
+  }
+  PutVarint64(&raw, inputs.size());
+  for (auto& pair : inputs) {
+    PutVarint32Varint64(&raw, static_cast<uint32_t>(pair.first), pair.second);
+  }
+  PutLengthPrefixedSlice(&raw, cf_name);
+  PutVarint64(&raw, target_file_size);
+  raw.push_back(static_cast<char>(compression));
+  PutVarint32(&raw, static_cast<uint32_t>(compression_opts.window_bits));
+  PutVarint32(&raw, static_cast<uint32_t>(compression_opts.level));
+  PutVarint32(&raw, static_cast<uint32_t>(compression_opts.strategy));
+  PutVarint32(&raw, compression_opts.max_dict_bytes);
+  PutVarint32(&raw, compression_opts.zstd_max_train_bytes);
+  PutBool(&raw, compression_opts.enabled);
+  PutVarint64(&raw, existing_snapshots.size());
+  for (auto seq : existing_snapshots) {
+    PutVarint64(&raw, seq);
+  }
+  PutLengthPrefixedSlice(&raw, smallest_user_key.data);
+  PutLengthPrefixedSlice(&raw, largest_user_key.data);
+  PutVarint32Varint32Varint32(&raw, static_cast<uint32_t>(level),
+                              static_cast<uint32_t>(output_level),
+                              static_cast<uint32_t>(number_levels));
+  PutBool(&raw, skip_filters);
+  PutBool(&raw, bottommost_level);
+  PutBool(&raw, allow_ingest_behind);
+  PutBool(&raw, preserve_deletes);
+  PutVarint64(&raw, int_tbl_prop_collector_factories.size());
+  for (auto& collector : int_tbl_prop_collector_factories) {
+    PutLengthPrefixedSlice(&raw, collector.name);
+    PutLengthPrefixedSlice(&raw, collector.param.data);
+  }
+  FinishEncoding(raw, _compression, dst);
+}
+
+Status CompactionWorkerContext::DecodeFrom(const Slice& src,
+                                           CompressionType* _compression) {
+  Decoder d;
+  Status s = d.Init(src, _compression);
+  if (!s.ok()) {
+    return s;
+  }
+  d.Get(&user_comparator);
+  d.Get(&merge_operator);
+  d.Get(&merge_operator_data);
+  d.Get(&value_meta_extractor_factory);
+  d.Get(&value_meta_extractor_factory_options);
+  d.Get(&compaction_filter);
+  d.Get(&compaction_filter_factory);
+  d.Get(&compaction_filter_context.is_full_compaction);
+  d.Get(&compaction_filter_context.is_manual_compaction);
+  d.Get(&compaction_filter_context.is_bottommost_level);
+  d.Get(&compaction_filter_context.column_family_id);
+  d.Get(&compaction_filter_data);
+  uint64_t blob_size = 0;
+  d.Get(&blob_size);
+  blob_config.blob_size = static_cast<size_t>(blob_size);
+  d.Get(&blob_config.large_key_ratio);
+  d.Get(&separation_type);
+  d.Get(&table_factory);
+  d.Get(&table_factory_options);
+  d.Get(&bloom_locality);
+  d.Get(&cf_paths);
+  d.Get(&prefix_extractor);
+  d.Get(&prefix_extractor_options);
+  d.Get(&has_start);
+  d.Get(&has_end);
+  d.Get(&start);
+  d.Get(&end);
+  d.Get(&last_sequence);
+  d.Get(&earliest_write_conflict_snapshot);
+  d.Get(&preserve_deletes_seqnum);
+  d.Get(&file_metadata);
+  d.Get(&inputs);
+  d.Get(&cf_name);
+  d.Get(&target_file_size);
+  d.Get(&compression);
+  d.Get(&compression_opts.window_bits);
+  d.Get(&compression_opts.level);
+  d.Get(&compression_opts.strategy);
+  d.Get(&compression_opts.max_dict_bytes);
+  d.Get(&compression_opts.zstd_max_train_bytes);
+  d.Get(&compression_opts.enabled);
+  d.Get(&existing_snapshots);
+  d.Get(&smallest_user_key);
+  d.Get(&largest_user_key);
+  d.Get(&level);
+  d.Get(&output_level);
+  d.Get(&number_levels);
+  d.Get(&skip_filters);
+  d.Get(&bottommost_level);
+  d.Get(&allow_ingest_behind);
+  d.Get(&preserve_deletes);
+  d.Get(&int_tbl_prop_collector_factories);
+  return d.status();
+}
+
+void CompactionWorkerResult::EncodeTo(std::string* dst,
+                                      CompressionType compression) const {
+  std::string raw;
+  PutStatus(&raw, status);
+  PutLengthPrefixedSlice(&raw, *actual_start.rep());
+  PutLengthPrefixedSlice(&raw, *actual_end.rep());
+  PutVarint64(&raw, files.size());
+  for (auto& f : files) {
+    PutLengthPrefixedSlice(&raw, *f.smallest.rep());
+    PutLengthPrefixedSlice(&raw, *f.largest.rep());
+    PutLengthPrefixedSlice(&raw, f.file_name);
+    PutVarint64Varint64(&raw, f.smallest_seqno, f.largest_seqno);
+    PutVarint64(&raw, f.file_size);
+    PutBool(&raw, f.marked_for_compaction);
+  }
+  PutLengthPrefixedSlice(&raw, stat_all);
+  PutVarint64(&raw, time_us);
+  FinishEncoding(raw, compression, dst);
+}
+
+Status CompactionWorkerResult::DecodeFrom(const Slice& src) {
+  Decoder d;
+  Status s = d.Init(src, nullptr);
+  if (!s.ok()) {
+    return s;
+  }
+  d.Get(&status);
+  d.Get(&actual_start);
+  d.Get(&actual_end);
+  d.Get(&files);
+  d.Get(&stat_all);
+  uint64_t _time_us = 0;
+  d.Get(&_time_us);
+  time_us = static_cast<size_t>(_time_us);
+  return d.status();
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,205 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction.h"
+#include "rocksdb/convenience.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class CompactionWorkerContextTest : public testing::Test {
+ public:
+  static CompactionWorkerContext MakeContext() {
+    CompactionWorkerContext context;
+    context.user_comparator = "leveldb.BytewiseComparator";
+    context.merge_operator_data = std::string("\0\1\2", 3);
+    context.compaction_filter_context.is_manual_compaction = true;
+    context.compaction_filter_context.column_family_id = 7;
+    context.blob_config = BlobConfig{4096, 0.25};
+    context.separation_type = 1;
+    context.table_factory = "BlockBasedTable";
+    context.bloom_locality = 1;
+    context.cf_paths = {"/a", "/b"};
+    context.has_start = true;
+    context.has_end = false;
+    context.start = std::string("start");
+    context.last_sequence = 12345678901ull;
+    context.earliest_write_conflict_snapshot = kMaxSequenceNumber;
+    context.preserve_deletes_seqnum = 0;
+    for (uint64_t i = 1; i <= 100; ++i) {
+      FileMetaData f;
+      f.fd = FileDescriptor(i, 0, i * 1000, i, i + 10);
+      f.smallest = InternalKey("a" + ToString(i), i, kTypeValue);
+      f.largest = InternalKey("z" + ToString(i), i + 10, kTypeDeletion);
+      f.prop.num_entries = i * 10;
+      f.prop.purpose = i % 2 == 0 ? kMapSst : kEssenceSst;
+      f.prop.max_read_amp = 3;
+      f.prop.read_amp = 1.5f;
+      f.prop.dependence = {{i + 200, i}, {i + 300, i}};
+      f.prop.inheritance = {i + 400};
+      context.file_metadata.emplace_back(i, f);
+      context.inputs.emplace_back(static_cast<int>(i % 3), i);
+    }
+    context.cf_name = "default";
+    context.target_file_size = 64 << 20;
+    context.compression = kNoCompression;
+    context.compression_opts.level = -1;
+    context.compression_opts.max_dict_bytes = 16384;
+    context.existing_snapshots = {10, 20, 30};
+    context.smallest_user_key = std::string("a");
+    context.largest_user_key = std::string("z");
+    context.level = -1;
+    context.output_level = 2;
+    context.number_levels = 7;
+    context.skip_filters = false;
+    context.bottommost_level = true;
+    context.allow_ingest_behind = false;
+    context.preserve_deletes = false;
+    context.int_tbl_prop_collector_factories.push_back(
+        {"collector", context.merge_operator_data});
+    return context;
+  }
+
+  static void AssertEqual(const CompactionWorkerContext& a,
+                          const CompactionWorkerContext& b) {
+    ASSERT_EQ(a.user_comparator, b.user_comparator);
+    ASSERT_EQ(a.merge_operator_data.data, b.merge_operator_data.data);
+    ASSERT_EQ(a.compaction_filter_context.is_manual_compaction,
+              b.compaction_filter_context.is_manual_compaction);
+    ASSERT_EQ(a.compaction_filter_context.column_family_id,
+              b.compaction_filter_context.column_family_id);
+    ASSERT_EQ(a.blob_config.blob_size, b.blob_config.blob_size);
+    ASSERT_EQ(a.blob_config.large_key_ratio, b.blob_config.large_key_ratio);
+    ASSERT_EQ(a.separation_type, b.separation_type);
+    ASSERT_EQ(a.table_factory, b.table_factory);
+    ASSERT_EQ(a.cf_paths, b.cf_paths);
+    ASSERT_EQ(a.has_start, b.has_start);
+    ASSERT_EQ(a.has_end, b.has_end);
+    ASSERT_EQ(a.start.data, b.start.data);
+    ASSERT_EQ(a.last_sequence, b.last_sequence);
+    ASSERT_EQ(a.earliest_write_conflict_snapshot,
+              b.earliest_write_conflict_snapshot);
+    ASSERT_EQ(a.file_metadata.size(), b.file_metadata.size());
+    for (size_t i = 0; i < a.file_metadata.size(); ++i) {
+      auto& fa = a.file_metadata[i];
+      auto& fb = b.file_metadata[i];
+      ASSERT_EQ(fa.first, fb.first);
+      ASSERT_EQ(fa.second.fd.packed_number_and_path_id,
+                fb.second.fd.packed_number_and_path_id);
+      ASSERT_EQ(fa.second.fd.file_size, fb.second.fd.file_size);
+      ASSERT_EQ(fa.second.fd.largest_seqno, fb.second.fd.largest_seqno);
+      ASSERT_EQ(*fa.second.smallest.rep(), *fb.second.smallest.rep());
+      ASSERT_EQ(*fa.second.largest.rep(), *fb.second.largest.rep());
+      ASSERT_EQ(fa.second.prop.num_entries, fb.second.prop.num_entries);
+      ASSERT_EQ(fa.second.prop.purpose, fb.second.prop.purpose);
+      ASSERT_EQ(fa.second.prop.max_read_amp, fb.second.prop.max_read_amp);
+      ASSERT_EQ(fa.second.prop.read_amp, fb.second.prop.read_amp);
+      ASSERT_EQ(fa.second.prop.dependence.size(),
+                fb.second.prop.dependence.size());
+      ASSERT_EQ(fa.second.prop.dependence[1].file_number,
+                fb.second.prop.dependence[1].file_number);
+      ASSERT_EQ(fa.second.prop.inheritance, fb.second.prop.inheritance);
+    }
+    ASSERT_EQ(a.inputs, b.inputs);
+    ASSERT_EQ(a.cf_name, b.cf_name);
+    ASSERT_EQ(a.target_file_size, b.target_file_size);
+    ASSERT_EQ(a.compression_opts.level, b.compression_opts.level);
+    ASSERT_EQ(a.compression_opts.max_dict_bytes,
+              b.compression_opts.max_dict_bytes);
+    ASSERT_EQ(a.existing_snapshots, b.existing_snapshots);
+    ASSERT_EQ(a.largest_user_key.data, b.largest_user_key.data);
+    ASSERT_EQ(a.level, b.level);
+    ASSERT_EQ(a.output_level, b.output_level);
+    ASSERT_EQ(a.number_levels, b.number_levels);
+    ASSERT_EQ(a.bottommost_level, b.bottommost_level);
+    ASSERT_EQ(a.int_tbl_prop_collector_factories.size(),
+              b.int_tbl_prop_collector_factories.size());
+    ASSERT_EQ(a.int_tbl_prop_collector_factories[0].name,
+              b.int_tbl_prop_collector_factories[0].name);
+    ASSERT_EQ(a.int_tbl_prop_collector_factories[0].param.data,
+              b.int_tbl_prop_collector_factories[0].param.data);
+  }
+};
+
+TEST_F(CompactionWorkerContextTest, ContextRoundTrip) {
+  CompactionWorkerContext context = MakeContext();
+  for (auto type : GetSupportedCompressions()) {
+    std::string encoded;
+    context.EncodeTo(&encoded, type);
+    ASSERT_TRUE(IsCompactionWorkerEncoding(encoded));
+
+    CompactionWorkerContext decoded;
+    CompressionType decoded_type;
+    ASSERT_OK(decoded.DecodeFrom(encoded, &decoded_type));
+    AssertEqual(context, decoded);
+    if (decoded_type != type) {
+      // Fallen back for a poor ratio
+      ASSERT_EQ(kNoCompression, decoded_type);
+    }
+  }
+}
+
+TEST_F(CompactionWorkerContextTest, ResultRoundTrip) {
+  CompactionWorkerResult result;
+  result.status = Status::Incomplete("partial", "detail");
+  result.actual_start = InternalKey("a", 1, kTypeValue);
+  for (size_t i = 0; i < 10; ++i) {
+    CompactionWorkerResult::FileInfo f;
+    f.smallest = InternalKey("a" + ToString(i), i, kTypeValue);
+    f.largest = InternalKey("z" + ToString(i), i, kTypeValue);
+    f.file_name = "Worker-" + ToString(i);
+    f.smallest_seqno = i;
+    f.largest_seqno = i + 1;
+    f.file_size = i << 20;
+    f.marked_for_compaction = i % 2 == 0;
+    result.files.emplace_back(f);
+  }
+  result.stat_all = "stat";
+  result.time_us = 42;
+
+  std::string encoded;
+  result.EncodeTo(&encoded);
+  CompactionWorkerResult decoded;
+  ASSERT_OK(decoded.DecodeFrom(encoded));
+  ASSERT_EQ(result.status.ToString(), decoded.status.ToString());
+  ASSERT_EQ(*result.actual_start.rep(), *decoded.actual_start.rep());
+  ASSERT_TRUE(decoded.actual_end.rep()->empty());
+  ASSERT_EQ(result.files.size(), decoded.files.size());
+  for (size_t i = 0; i < result.files.size(); ++i) {
+    ASSERT_EQ(*result.files[i].largest.rep(), *decoded.files[i].largest.rep());
+    ASSERT_EQ(result.files[i].file_name, decoded.files[i].file_name);
+    ASSERT_EQ(result.files[i].largest_seqno, decoded.files[i].largest_seqno);
+    ASSERT_EQ(result.files[i].file_size, decoded.files[i].file_size);
+    ASSERT_EQ(result.files[i].marked_for_compaction,
+              decoded.files[i].marked_for_compaction);
+  }
+  ASSERT_EQ(result.stat_all, decoded.stat_all);
+  ASSERT_EQ(result.time_us, decoded.time_us);
+}
+
+TEST_F(CompactionWorkerContextTest, BadEncoding) {
+  ASSERT_FALSE(IsCompactionWorkerEncoding("{\"user_comparator\":\"\"}"));
+
+  std::string encoded;
+  MakeContext().EncodeTo(&encoded);
+  CompactionWorkerContext decoded;
+  ASSERT_TRUE(decoded.DecodeFrom(Slice(encoded.data(), encoded.size() / 2))
+                  .IsCorruption());
+
+  // Format version from the future
+  std::string future = encoded;
+  future[4] = 100;
+  ASSERT_TRUE(decoded.DecodeFrom(future).IsNotSupported());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
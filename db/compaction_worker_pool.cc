@@ -0,0 +1,188 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#include "db/compaction.h"
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/sync_point.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+class CompactionWorkerPoolDispatcher : public CompactionDispatcher {
+ public:
+  CompactionWorkerPoolDispatcher(
+      std::vector<std::shared_ptr<CompactionWorkerClient>>&& workers,
+      const CompactionWorkerPoolOptions& options, Env* env)
+      : options_(options), env_(env), next_job_id_(1), next_worker_(0) {
+    for (auto& client : workers) {
+      workers_.emplace_back(std::move(client));
+    }
+  }
+
+  std::function<CompactionWorkerResult()> StartCompaction(
+      const CompactionWorkerContext& context) override {
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->dispatcher = this;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job->worker = PickWorker();
+      if (job->worker == nullptr) {
+        return MakeFallback("No remote compaction worker available");
+      }
+      ++job->worker->in_flight;
+      job->job_id = next_job_id_++;
+    }
+    std::string data;
+    context.EncodeTo(&data);
+    job->start_micros = env_->NowMicros();
+    try {
+      job->future = job->worker->client->DoCompaction(job->job_id,
+                                                      std::move(data));
+    } catch (const std::exception& ex) {
+      Finish(job.get(), false);
+      return MakeFallback(ex.what());
+    }
+    return [job]() { return job->dispatcher->Wait(job.get()); };
+  }
+
+  const char* Name() const override { return "CompactionWorkerPoolDispatcher"; }
+
+ private:
+  struct Worker {
+    explicit Worker(std::shared_ptr<CompactionWorkerClient>&& _client)
+        : client(std::move(_client)), in_flight(0), unhealthy_until(0) {}
+
+    std::shared_ptr<CompactionWorkerClient> client;
+    size_t in_flight;
+    uint64_t unhealthy_until;
+  };
+
+  struct Job {
+    CompactionWorkerPoolDispatcher* dispatcher = nullptr;
+    Worker* worker = nullptr;
+    uint64_t job_id = 0;
+    uint64_t start_micros = 0;
+    std::future<std::string> future;
+    bool finished = false;
+  };
+
+  static std::function<CompactionWorkerResult()> MakeFallback(
+      const std::string& reason) {
+    return [reason]() {
+      CompactionWorkerResult result;
+      result.status = Status::TryAgain("Remote compaction", reason);
+      return result;
+    };
+  }
+
+  // REQUIRES: mutex_ held
+  Worker* PickWorker() {
+    uint64_t now = env_->NowMicros();
+    Worker* best = nullptr;
+    // Rotate the start to spread ties
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      Worker* w = &workers_[(next_worker_ + i) % workers_.size()];
+      if (w->unhealthy_until > now ||
+          w->in_flight >= options_.max_jobs_per_worker) {
+        continue;
+      }
+      if (best == nullptr || w->in_flight < best->in_flight) {
+        best = w;
+      }
+    }
+    if (!workers_.empty()) {
+      next_worker_ = (next_worker_ + 1) % workers_.size();
+    }
+    return best;
+  }
+
+  void Finish(Job* job, bool healthy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (job->finished) {
+      return;
+    }
+    job->finished = true;
+    --job->worker->in_flight;
+    if (!healthy) {
+      job->worker->unhealthy_until =
+          env_->NowMicros() + options_.unhealthy_backoff_micros;
+    }
+  }
+
+  // Futures from std::async block in their destructor, keep stragglers
+  // around until they are done
+  void Abandon(std::future<std::string>&& future) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto ready = [](std::future<std::string>& f) {
+      return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+    abandoned_.erase(
+        std::remove_if(abandoned_.begin(), abandoned_.end(), ready),
+        abandoned_.end());
+    abandoned_.emplace_back(std::move(future));
+  }
+
+  CompactionWorkerResult Wait(Job* job) {
+    CompactionWorkerResult result;
+    if (options_.remote_timeout_micros > 0) {
+      uint64_t elapsed = env_->NowMicros() - job->start_micros;
+      uint64_t budget = elapsed < options_.remote_timeout_micros
+                            ? options_.remote_timeout_micros - elapsed
+                            : 0;
+      if (job->future.wait_for(std::chrono::microseconds(budget)) !=
+          std::future_status::ready) {
+        TEST_SYNC_POINT("CompactionWorkerPoolDispatcher::Wait:Timeout");
+        job->worker->client->Cancel(job->job_id);
+        Finish(job, false);
+        Abandon(std::move(job->future));
+        result.status = Status::TryAgain("Remote compaction timed out",
+                                         job->worker->client->Name());
+        return result;
+      }
+    }
+    Status s;
+    try {
+      std::string encoded_result = job->future.get();
+      s = result.DecodeFrom(encoded_result);
+      if (s.ok()) {
+        s = result.status;
+      }
+    } catch (const std::exception& ex) {
+      s = Status::IOError("Remote compaction", ex.what());
+    }
+    Finish(job, s.ok());
+    if (!s.ok()) {
+      result = CompactionWorkerResult();
+      result.status = Status::TryAgain(job->worker->client->Name(),
+                                       s.ToString());
+    }
+    return result;
+  }
+
+  const CompactionWorkerPoolOptions options_;
+  Env* env_;
+  std::mutex mutex_;
+  std::vector<Worker> workers_;
+  std::vector<std::future<std::string>> abandoned_;
+  uint64_t next_job_id_;
+  size_t next_worker_;
+};
+
+}  // namespace
+
+std::shared_ptr<CompactionDispatcher> NewCompactionWorkerPoolDispatcher(
+    std::vector<std::shared_ptr<CompactionWorkerClient>> workers,
+    const CompactionWorkerPoolOptions& options, Env* env) {
+  return std::make_shared<CompactionWorkerPoolDispatcher>(std::move(workers),
+                                                          options, env);
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,193 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction.h"
+#include "db/db_test_util.h"
+#include "port/stack_trace.h"
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/sync_point.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Answers every job with "status", or never when "hang" is set
+class FakeWorkerClient : public CompactionWorkerClient {
+ public:
+  FakeWorkerClient(Status status, bool hang = false)
+      : status_(status), hang_(hang), jobs(0), cancelled(0) {}
+
+  const char* Name() const override { return "FakeWorker"; }
+
+  std::future<std::string> DoCompaction(uint64_t /*job_id*/,
+                                        std::string data) override {
+    ++jobs;
+    CompactionWorkerContext context;
+    EXPECT_OK(context.DecodeFrom(data));
+    promises_.emplace_back();
+    auto future = promises_.back().get_future();
+    if (!hang_) {
+      CompactionWorkerResult result;
+      result.status = status_;
+      std::string encoded;
+      result.EncodeTo(&encoded);
+      promises_.back().set_value(encoded);
+    }
+    return future;
+  }
+
+  void Cancel(uint64_t /*job_id*/) override { ++cancelled; }
+
+  Status status_;
+  bool hang_;
+  std::vector<std::promise<std::string>> promises_;
+  size_t jobs, cancelled;
+};
+
+class CompactionWorkerPoolTest : public DBTestBase {
+ public:
+  CompactionWorkerPoolTest() : DBTestBase("/compaction_worker_pool_test") {}
+
+  void CompactAndVerify(std::shared_ptr<CompactionDispatcher> dispatcher) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.compaction_dispatcher = dispatcher;
+    DestroyAndReopen(options);
+    for (int i = 0; i < 2; ++i) {
+      for (int k = 0; k < 100; ++k) {
+        ASSERT_OK(Put(Key(k), "v" + ToString(i)));
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+    ASSERT_EQ(0, NumTableFilesAtLevel(0));
+    for (int k = 0; k < 100; ++k) {
+      ASSERT_EQ("v1", Get(Key(k)));
+    }
+  }
+};
+
+TEST_F(CompactionWorkerPoolTest, PickLeastLoaded) {
+  auto a = std::make_shared<FakeWorkerClient>(Status::OK(), true);
+  auto b = std::make_shared<FakeWorkerClient>(Status::OK(), true);
+  CompactionWorkerPoolOptions pool_options;
+  pool_options.max_jobs_per_worker = 2;
+  auto dispatcher = NewCompactionWorkerPoolDispatcher({a, b}, pool_options);
+
+  CompactionWorkerContext context;
+  std::vector<std::function<CompactionWorkerResult()>> results;
+  for (int i = 0; i < 4; ++i) {
+    results.emplace_back(dispatcher->StartCompaction(context));
+  }
+  ASSERT_EQ(2u, a->jobs);
+  ASSERT_EQ(2u, b->jobs);
+  // Both workers are full
+  ASSERT_TRUE(dispatcher->StartCompaction(context)().status.IsTryAgain());
+
+  // Finish one job of "a", it takes the next one
+  CompactionWorkerResult result;
+  std::string encoded;
+  result.EncodeTo(&encoded);
+  a->promises_[0].set_value(encoded);
+  ASSERT_OK(results[0]().status);
+  results.emplace_back(dispatcher->StartCompaction(context));
+  ASSERT_EQ(3u, a->jobs);
+  ASSERT_EQ(2u, b->jobs);
+
+  for (auto& p : a->promises_) {
+    try {
+      p.set_value(encoded);
+    } catch (const std::future_error&) {
+    }
+  }
+  for (auto& p : b->promises_) {
+    p.set_value(encoded);
+  }
+}
+
+TEST_F(CompactionWorkerPoolTest, SkipUnhealthy) {
+  auto bad = std::make_shared<FakeWorkerClient>(Status::IOError("down"));
+  auto good = std::make_shared<FakeWorkerClient>(Status::OK());
+  auto dispatcher = NewCompactionWorkerPoolDispatcher({bad, good});
+
+  CompactionWorkerContext context;
+  ASSERT_TRUE(dispatcher->StartCompaction(context)().status.IsTryAgain());
+  ASSERT_OK(dispatcher->StartCompaction(context)().status);
+  ASSERT_EQ(1u, bad->jobs);
+  // "bad" is backed off, everything goes to "good"
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(dispatcher->StartCompaction(context)().status);
+  }
+  ASSERT_EQ(1u, bad->jobs);
+  ASSERT_EQ(5u, good->jobs);
+}
+
+TEST_F(CompactionWorkerPoolTest, FallbackOnFailure) {
+  auto bad = std::make_shared<FakeWorkerClient>(Status::IOError("down"));
+  CompactAndVerify(NewCompactionWorkerPoolDispatcher({bad}));
+  ASSERT_EQ(1u, bad->jobs);
+}
+
+TEST_F(CompactionWorkerPoolTest, FallbackOnTimeout) {
+  auto slow = std::make_shared<FakeWorkerClient>(Status::OK(), true);
+  CompactionWorkerPoolOptions pool_options;
+  pool_options.remote_timeout_micros = 10000;
+  int timeouts = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionWorkerPoolDispatcher::Wait:Timeout",
+      [&](void* /*arg*/) { ++timeouts; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  CompactAndVerify(NewCompactionWorkerPoolDispatcher({slow}, pool_options));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_EQ(1, timeouts);
+  ASSERT_EQ(1u, slow->cancelled);
+  for (auto& p : slow->promises_) {
+    p.set_value(std::string());
+  }
+}
+
+TEST_F(CompactionWorkerPoolTest, RemoteSubcompactions) {
+  auto bad = std::make_shared<FakeWorkerClient>(Status::IOError("down"));
+  CompactionWorkerPoolOptions pool_options;
+  pool_options.unhealthy_backoff_micros = 0;
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.max_background_compactions = 1;
+  options.max_subcompactions = 4;
+  options.target_file_size_base = 4 << 10;
+  options.compaction_dispatcher =
+      NewCompactionWorkerPoolDispatcher({bad}, pool_options);
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  std::vector<std::string> values(200);
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      for (int k = i; k < 200; k += 4) {
+        values[k] = RandomString(&rnd, 100);
+        ASSERT_OK(Put(Key(k), values[k]));
+      }
+      ASSERT_OK(Flush());
+    }
+    size_t jobs = bad->jobs;
+    ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+    if (round == 1) {
+      // One local background slot, yet every range went to the worker
+      ASSERT_GT(bad->jobs - jobs, 1u);
+    }
+  }
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  for (int k = 0; k < 200; ++k) {
+    ASSERT_EQ(values[k], Get(Key(k)));
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  TERARKDB_NAMESPACE::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -319,6 +319,40 @@ TEST_F(CorruptionTest, TableFile) {
   ASSERT_NOK(dbi->VerifyChecksum());
 }
 
+class ScrubErrorListener : public EventListener {
+ public:
+  void OnBackgroundError(BackgroundErrorReason reason,
+                         Status* bg_error) override {
+    if (reason == BackgroundErrorReason::kChecksumScrub) {
+      EXPECT_TRUE(bg_error->IsCorruption());
+      ++errors;
+    }
+  }
+
+  std::atomic<int> errors{0};
+};
+
+TEST_F(CorruptionTest, ChecksumScrub) {
+  auto listener = std::make_shared<ScrubErrorListener>();
+  Options options = options_;
+  options.paranoid_checks = false;
+  options.checksum_scrub_bytes_per_sec = 1 << 30;
+  options.listeners.push_back(listener);
+  Reopen(&options);
+  Build(100);
+  DBImpl* dbi = reinterpret_cast<DBImpl*>(db_);
+  dbi->TEST_FlushMemTable();
+  dbi->ScrubChecksums();
+  ASSERT_EQ(0, listener->errors);
+
+  Corrupt(kTableFile, 100, 1);
+  dbi->ScrubChecksums();
+  ASSERT_EQ(1, listener->errors);
+  // Only reported without paranoid_checks
+  std::string tmp1, tmp2;
+  ASSERT_OK(db_->Put(WriteOptions(), Key(1000, &tmp1), Value(1000, &tmp2)));
+}
+
 TEST_F(CorruptionTest, TableFileIndexData) {
   Options options;
   // very big, we'll trigger flushes manually
@@ -815,6 +815,455 @@ TEST_F(DBBasicTest, MultiGetSimple) {
   } while (ChangeCompactOptions());
 }
 
+TEST_F(DBBasicTest, MultiGetUnsortedKeys) {
+  CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_OK(Put(i % 2, Key(i), "v" + ToString(i)));
+  }
+  ASSERT_OK(Flush(0));
+  ASSERT_OK(Flush(1));
+
+  std::vector<Slice> keys;
+  std::vector<std::string> key_data;
+  std::vector<ColumnFamilyHandle*> cfs;
+  // Descending keys, column families interleaved, plus a missing key
+  for (int i = 19; i >= 0; --i) {
+    key_data.emplace_back(Key(i));
+    cfs.push_back(handles_[i % 2]);
+  }
+  key_data.emplace_back(Key(3));
+  cfs.push_back(handles_[0]);
+  for (auto& k : key_data) {
+    keys.emplace_back(k);
+  }
+
+  std::vector<std::string> values;
+  std::vector<Status> s = db_->MultiGet(ReadOptions(), cfs, keys, &values);
+  ASSERT_EQ(keys.size(), values.size());
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_OK(s[19 - i]);
+    ASSERT_EQ("v" + ToString(i), values[19 - i]);
+  }
+  ASSERT_TRUE(s[20].IsNotFound());
+}
+
+TEST_F(DBBasicTest, MultiGetMultiCFSuperVersionChanged) {
+  CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
+  ASSERT_OK(Put(0, "k0", "v0"));
+  ASSERT_OK(Put(1, "k1", "v1"));
+
+  int attempts = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::MultiGet:AfterRefSuperVersion", [&](void* /*arg*/) {
+        if (attempts++ == 0) {
+          // Replace the super version of one column family after it has been
+          // referenced, MultiGet must reference both of them again
+          ASSERT_OK(Put(1, "k1", "v1_new"));
+          ASSERT_OK(Flush(1));
+        }
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  std::vector<Slice> keys({"k0", "k1"});
+  std::vector<ColumnFamilyHandle*> cfs({handles_[0], handles_[1]});
+  std::vector<std::string> values;
+  std::vector<Status> s = db_->MultiGet(ReadOptions(), cfs, keys, &values);
+  ASSERT_EQ(2, attempts);
+  ASSERT_OK(s[0]);
+  ASSERT_OK(s[1]);
+  ASSERT_EQ("v0", values[0]);
+  ASSERT_EQ("v1_new", values[1]);
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBBasicTest, MultiGetSeparateValue) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  CreateAndReopenWithCF({"pikachu"}, options);
+  Random rnd(301);
+  const int kNumKeys = 100;
+  std::vector<std::string> expect(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    expect[i] = RandomString(&rnd, 64 + i);
+    ASSERT_OK(Put(1, Key(i), expect[i]));
+    if (i % 30 == 29) {
+      ASSERT_OK(Flush(1));
+    }
+  }
+  ASSERT_OK(Flush(1));
+
+  std::vector<std::string> key_data;
+  // Reverse order and a missing key, MultiFetch must restore positions
+  for (int i = kNumKeys; i >= 0; --i) {
+    key_data.emplace_back(Key(i));
+  }
+  std::vector<Slice> keys(key_data.begin(), key_data.end());
+  std::vector<ColumnFamilyHandle*> cfs(keys.size(), handles_[1]);
+  std::vector<std::string> values;
+  std::vector<Status> s = db_->MultiGet(ReadOptions(), cfs, keys, &values);
+  ASSERT_EQ(values.size(), keys.size());
+  ASSERT_TRUE(s[0].IsNotFound());
+  for (int i = 1; i <= kNumKeys; ++i) {
+    ASSERT_OK(s[i]);
+    ASSERT_EQ(values[i], expect[kNumKeys - i]);
+  }
+}
+
+TEST_F(DBBasicTest, BlobCache) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.blob_cache = NewLRUCache(1 << 20);
+  options.statistics = CreateDBStatistics();
+  CreateAndReopenWithCF({"pikachu"}, options);
+  Random rnd(301);
+  const int kNumKeys = 10;
+  std::vector<std::string> expect(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    expect[i] = RandomString(&rnd, 64 + i);
+    ASSERT_OK(Put(1, Key(i), expect[i]));
+  }
+  ASSERT_OK(Flush(1));
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(expect[i], Get(1, Key(i)));
+  }
+  ASSERT_EQ(kNumKeys, TestGetTickerCount(options, BLOB_CACHE_MISS));
+  ASSERT_EQ(0, TestGetTickerCount(options, BLOB_CACHE_HIT));
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(expect[i], Get(1, Key(i)));
+  }
+  ASSERT_EQ(kNumKeys, TestGetTickerCount(options, BLOB_CACHE_MISS));
+  ASSERT_EQ(kNumKeys, TestGetTickerCount(options, BLOB_CACHE_HIT));
+}
+
+TEST_F(DBBasicTest, RowCacheSeparatedValue) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.row_cache = NewLRUCache(1 << 20);
+  options.statistics = CreateDBStatistics();
+  CreateAndReopenWithCF({"pikachu"}, options);
+  Random rnd(301);
+  const int kNumKeys = 10;
+  std::vector<std::string> expect(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    expect[i] = RandomString(&rnd, 64 + i);
+    ASSERT_OK(Put(1, Key(i), expect[i]));
+  }
+  ASSERT_OK(Delete(1, Key(kNumKeys)));
+  ASSERT_OK(Flush(1));
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(expect[i], Get(1, Key(i)));
+  }
+  ASSERT_EQ("NOT_FOUND", Get(1, Key(kNumKeys)));
+  ASSERT_EQ(kNumKeys + 1, TestGetTickerCount(options, ROW_CACHE_MISS));
+  ASSERT_EQ(0, TestGetTickerCount(options, ROW_CACHE_HIT));
+
+  // Hits return the fetched values without touching the blobs
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(expect[i], Get(1, Key(i)));
+  }
+  ASSERT_EQ("NOT_FOUND", Get(1, Key(kNumKeys)));
+  ASSERT_EQ(kNumKeys + 1, TestGetTickerCount(options, ROW_CACHE_MISS));
+  ASSERT_EQ(kNumKeys + 1, TestGetTickerCount(options, ROW_CACHE_HIT));
+
+  // MultiGet fills the row cache per key, then hits it
+  std::vector<std::string> multiget_keys;
+  for (int i = kNumKeys + 1; i <= kNumKeys + 5; ++i) {
+    multiget_keys.push_back(Key(i));
+    ASSERT_OK(Put(1, Key(i), "v" + Key(i)));
+  }
+  ASSERT_OK(Flush(1));
+  std::vector<ColumnFamilyHandle*> cfs(multiget_keys.size(), handles_[1]);
+  std::vector<Slice> key_slices(multiget_keys.begin(), multiget_keys.end());
+  for (int round = 1; round <= 2; ++round) {
+    std::vector<std::string> values;
+    std::vector<Status> statuses =
+        db_->MultiGet(ReadOptions(), cfs, key_slices, &values);
+    for (size_t i = 0; i < multiget_keys.size(); ++i) {
+      ASSERT_OK(statuses[i]);
+      ASSERT_EQ("v" + multiget_keys[i], values[i]);
+    }
+    ASSERT_EQ(kNumKeys + 6, TestGetTickerCount(options, ROW_CACHE_MISS));
+    ASSERT_EQ(kNumKeys + 1 + (round - 1) * 5,
+              TestGetTickerCount(options, ROW_CACHE_HIT));
+  }
+
+  // Reads older than the file are not served from the row cache
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Put(1, Key(0), "new"));
+  ASSERT_OK(Flush(1));
+  ASSERT_EQ("new", Get(1, Key(0)));
+  ASSERT_EQ(expect[0], Get(1, Key(0), snapshot));
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(DBBasicTest, NegativeLookupCache) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.negative_lookup_cache_size = 1024;
+  options.statistics = CreateDBStatistics();
+  Reopen(options);
+
+  ASSERT_OK(Put("a", "va"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(0, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(1, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+
+  // Other writes keep the entry, a write of the key invalidates it
+  ASSERT_OK(Put("c", "vc"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(2, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Put("b", "vb"));
+  ASSERT_EQ("vb", Get("b"));
+  ASSERT_EQ(2, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+
+  // Misses at snapshots older than a write of the key are not cached
+  ASSERT_EQ("NOT_FOUND", Get("b", snapshot));
+  ASSERT_EQ("NOT_FOUND", Get("b", snapshot));
+  ASSERT_EQ(2, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+  ASSERT_EQ("vb", Get("b"));
+  db_->ReleaseSnapshot(snapshot);
+
+  ASSERT_OK(Delete("b"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(3, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+
+  // A new super version invalidates every entry
+  ASSERT_OK(Flush());
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(3, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(4, TestGetTickerCount(options, NEGATIVE_LOOKUP_CACHE_HIT));
+  ASSERT_EQ("va", Get("a"));
+  ASSERT_EQ("vc", Get("c"));
+}
+
+TEST_F(DBBasicTest, BlobForwardScan) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  Reopen(options);
+  Random rnd(301);
+  const int kNumKeys = 100;
+  std::vector<std::string> expect(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    expect[i] = RandomString(&rnd, 64 + i);
+    ASSERT_OK(Put(Key(i), expect[i]));
+    if (i % 50 == 49) {
+      ASSERT_OK(Flush());
+    }
+  }
+
+  ReadOptions read_options;
+  read_options.blob_readahead_size = 64 << 10;
+  std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+  int i = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++i) {
+    ASSERT_EQ(Key(i), iter->key().ToString());
+    ASSERT_EQ(expect[i], iter->value().ToString());
+    if (i == kNumKeys / 2) {
+      // Install a new version in the middle of the scan
+      ASSERT_OK(Put(Key(kNumKeys), expect[0]));
+      ASSERT_OK(Flush());
+    }
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(kNumKeys, i);
+  for (iter->SeekToLast(), --i; iter->Valid(); iter->Prev(), --i) {
+    ASSERT_EQ(expect[i], iter->value().ToString());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(-1, i);
+}
+
+namespace {
+// The first 4 bytes of a value
+class PrefixValueExtractor : public ValueExtractor {
+ public:
+  Status Extract(const Slice& /*key*/, const Slice& value,
+                 std::string* output) const override {
+    output->assign(value.data(), std::min<size_t>(value.size(), 4));
+    return Status::OK();
+  }
+};
+
+class PrefixValueExtractorFactory : public ValueExtractorFactory {
+ public:
+  std::unique_ptr<ValueExtractor> CreateValueExtractor(
+      const Context& /*context*/) const override {
+    return std::unique_ptr<ValueExtractor>(new PrefixValueExtractor);
+  }
+  const char* Name() const override { return "PrefixValueExtractorFactory"; }
+};
+}  // namespace
+
+TEST_F(DBBasicTest, ValueProjection) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.blob_cache = NewLRUCache(1 << 20);
+  options.value_meta_extractor_factory =
+      std::make_shared<PrefixValueExtractorFactory>();
+  options.statistics = CreateDBStatistics();
+  Reopen(options);
+  Random rnd(301);
+  const int kNumKeys = 10;
+  std::vector<std::string> expect(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    expect[i] = RandomString(&rnd, 64 + i);
+    ASSERT_OK(Put(Key(i), expect[i]));
+  }
+  ASSERT_OK(Flush());
+  // Still in the memtable
+  ASSERT_OK(Put(Key(kNumKeys), "abcdefgh"));
+
+  PrefixValueExtractor projection;
+  for (bool is_meta : {false, true}) {
+    ReadOptions read_options;
+    read_options.value_projection = &projection;
+    read_options.value_projection_is_meta = is_meta;
+    uint64_t misses = TestGetTickerCount(options, BLOB_CACHE_MISS);
+    uint64_t hits = TestGetTickerCount(options, BLOB_CACHE_HIT);
+    std::string value;
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_OK(db_->Get(read_options, Key(i), &value));
+      ASSERT_EQ(expect[i].substr(0, 4), value);
+    }
+    ASSERT_OK(db_->Get(read_options, Key(kNumKeys), &value));
+    ASSERT_EQ("abcd", value);
+
+    std::vector<std::string> key_data;
+    for (int i = 0; i <= kNumKeys; ++i) {
+      key_data.emplace_back(Key(i));
+    }
+    std::vector<Slice> keys(key_data.begin(), key_data.end());
+    std::vector<std::string> values;
+    std::vector<Status> s = db_->MultiGet(read_options, keys, &values);
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_OK(s[i]);
+      ASSERT_EQ(expect[i].substr(0, 4), values[i]);
+    }
+    ASSERT_OK(s[kNumKeys]);
+    ASSERT_EQ("abcd", values[kNumKeys]);
+
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    int i = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++i) {
+      ASSERT_EQ(i < kNumKeys ? expect[i].substr(0, 4) : "abcd",
+                iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(kNumKeys + 1, i);
+
+    if (is_meta) {
+      // Answered by the value meta, the blobs are not read
+      ASSERT_EQ(misses, TestGetTickerCount(options, BLOB_CACHE_MISS));
+      ASSERT_EQ(hits, TestGetTickerCount(options, BLOB_CACHE_HIT));
+    } else {
+      ASSERT_LT(misses + hits, TestGetTickerCount(options, BLOB_CACHE_MISS) +
+                                   TestGetTickerCount(options, BLOB_CACHE_HIT));
+    }
+  }
+}
+
+TEST_F(DBBasicTest, AdaptiveSeparateThreshold) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.num_levels = 7;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.blob_gc_ratio = 0.05;
+  // Level amp 7 meets the target, all values should stay inline
+  options.blob_target_write_amp = 7;
+  Reopen(options);
+  Random rnd(301);
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 64)));
+    if (i % 10 == 9) {
+      ASSERT_OK(Flush());
+    }
+  }
+  auto cfd =
+      static_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())->cfd();
+  auto& files = cfd->current()->storage_info()->LevelFiles(0);
+  ASSERT_EQ(2U, files.size());
+  // No history on first flush, newest file first
+  ASSERT_EQ(128U, files[0]->prop.separate_threshold);
+  ASSERT_TRUE(files[0]->prop.dependence.empty());
+  ASSERT_EQ(16U, files[1]->prop.separate_threshold);
+  ASSERT_FALSE(files[1]->prop.dependence.empty());
+
+  // The threshold of the newest file is kept until new history is recorded
+  Reopen(options);
+  for (int i = 20; i < 30; ++i) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 64)));
+  }
+  ASSERT_OK(Flush());
+  cfd = static_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())->cfd();
+  auto& reopened_files = cfd->current()->storage_info()->LevelFiles(0);
+  ASSERT_EQ(3U, reopened_files.size());
+  ASSERT_EQ(128U, reopened_files[0]->prop.separate_threshold);
+  ASSERT_TRUE(reopened_files[0]->prop.dependence.empty());
+}
+
+TEST_F(DBBasicTest, GetAsyncAndMultiGetAsync) {
+  CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
+  ASSERT_OK(Put(1, "k1", "v1"));
+  ASSERT_OK(Put(1, "k2", "v2"));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(Put(1, "k3", "v3"));
+
+  int done = 0;
+  std::string value;
+  db_->GetAsync(ReadOptions(), handles_[1], "k1", &value,
+                [&](Status&& s, std::string&& key, std::string* v) {
+                  ASSERT_OK(s);
+                  ASSERT_EQ("k1", key);
+                  ASSERT_EQ(&value, v);
+                  ++done;
+                });
+  db_->GetAsync(ReadOptions(), handles_[1], "k4",
+                [&](Status&& s, std::string&& /*key*/, std::string* /*v*/) {
+                  ASSERT_TRUE(s.IsNotFound());
+                  ++done;
+                });
+  std::vector<std::string> values;
+  db_->MultiGetAsync(
+      ReadOptions(), std::vector<ColumnFamilyHandle*>(4, handles_[1]),
+      {"k3", "k4", "k2", "k1"}, &values,
+      [&](std::vector<Status>&& statuses, std::vector<std::string>&& keys,
+          std::vector<std::string>* v) {
+        ASSERT_EQ(&values, v);
+        ASSERT_EQ(4U, statuses.size());
+        ASSERT_EQ("k4", keys[1]);
+        ASSERT_OK(statuses[0]);
+        ASSERT_TRUE(statuses[1].IsNotFound());
+        ASSERT_OK(statuses[2]);
+        ASSERT_OK(statuses[3]);
+        ++done;
+      });
+  DB::WaitAsync();
+  ASSERT_EQ(3, done);
+  ASSERT_EQ("v1", value);
+  ASSERT_EQ("v3", values[0]);
+  ASSERT_EQ("v2", values[2]);
+  ASSERT_EQ("v1", values[3]);
+}
+
 TEST_F(DBBasicTest, MultiGetEmpty) {
   do {
     CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
@@ -853,7 +1302,7 @@ TEST_F(DBBasicTest, ChecksumTest) {
   options.enable_lazy_compaction = false;
   options.blob_size = -1;
   // change when new checksum type added
-  int max_checksum = static_cast<int>(kxxHash64);
+  int max_checksum = static_cast<int>(kXXH3);
   const int kNumPerFile = 2;
 
   // generate one table with each type of checksum
@@ -868,7 +1317,7 @@ TEST_F(DBBasicTest, ChecksumTest) {
   }
 
   // verify data with each type of checksum
-  for (int i = 0; i <= kxxHash64; ++i) {
+  for (int i = 0; i <= max_checksum; ++i) {
     table_options.checksum = static_cast<ChecksumType>(i);
     options.table_factory.reset(NewBlockBasedTableFactory(table_options));
     Reopen(options);
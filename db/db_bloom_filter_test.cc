@@ -11,6 +11,7 @@
 #include "port/stack_trace.h"
 #include "rocksdb/perf_context.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -1664,6 +1665,72 @@ TEST_F(DBBloomFilterTest, DynamicBloomFilterOptions) {
   }
 }
 
+TEST_F(DBBloomFilterTest, AutoPrefixFilter) {
+  Options options;
+  options.create_if_missing = true;
+  options.enable_lazy_compaction = false;
+  options.blob_size = -1;
+  options.disable_auto_compactions = true;
+  options.statistics = CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  auto user_key = [](int user) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "user%04d", user);
+    return std::string(buf);
+  };
+  // The even users only, ten fields each
+  for (int user = 0; user < 400; user += 2) {
+    for (int field = 0; field < 10; ++field) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), ":f%02d", field);
+      ASSERT_OK(Put(user_key(user) + buf, "value"));
+    }
+  }
+  ASSERT_OK(Flush());
+
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  ASSERT_EQ(1U, props.size());
+  auto& user_props = props.begin()->second->user_collected_properties;
+  auto pos = user_props.find(BlockBasedTablePropertyNames::kAutoPrefixLength);
+  ASSERT_TRUE(pos != user_props.end());
+  Slice input(pos->second);
+  uint64_t auto_prefix_length = 0;
+  ASSERT_TRUE(GetVarint64(&input, &auto_prefix_length));
+  ASSERT_EQ(8U, auto_prefix_length);
+  ASSERT_TRUE(user_props.count(
+      BlockBasedTablePropertyNames::kKeyPrefixLengthHistogram));
+
+  // Seeks bounded within a user skip the table when it has no such user
+  for (int user = 0; user < 400; ++user) {
+    std::string upper_bound_str = user_key(user) + ";";
+    Slice upper_bound(upper_bound_str);
+    ReadOptions read_options;
+    read_options.iterate_upper_bound = &upper_bound;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    ASSERT_EQ(user % 2 == 0 ? 10 : 0, CountIter(iter, user_key(user)));
+  }
+  ASSERT_EQ(400, TestGetTickerCount(options, BLOOM_FILTER_PREFIX_CHECKED));
+  ASSERT_GE(TestGetTickerCount(options, BLOOM_FILTER_PREFIX_USEFUL), 190);
+  ASSERT_LE(TestGetTickerCount(options, BLOOM_FILTER_PREFIX_USEFUL), 200);
+
+  // A bound past the prefix leaves the filter out
+  {
+    std::string upper_bound_str = user_key(4);
+    Slice upper_bound(upper_bound_str);
+    ReadOptions read_options;
+    read_options.iterate_upper_bound = &upper_bound;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    ASSERT_EQ(10, CountIter(iter, user_key(1)));
+  }
+  ASSERT_EQ(400, TestGetTickerCount(options, BLOOM_FILTER_PREFIX_CHECKED));
+}
+
 #endif  // ROCKSDB_LITE
 
 }  // namespace TERARKDB_NAMESPACE
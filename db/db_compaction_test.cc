@@ -311,6 +311,107 @@ TEST_P(DBCompactionTestWithParam, CompactionDeletionTrigger) {
 }
 #endif  // ROCKSDB_VALGRIND_RUN
 
+TEST_F(DBCompactionTest, SubcompactionTasksPerThread) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.max_background_jobs = 8;
+  options.max_subcompactions = 2;
+  options.subcompaction_tasks_per_thread = 4;
+  options.target_file_size_base = 32 << 10;
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  const int kNumKeys = 800;
+  std::vector<std::string> values(kNumKeys);
+  for (int k = 0; k < kNumKeys; ++k) {
+    values[k] = RandomString(&rnd, 1000);
+    ASSERT_OK(Put(Key(k), values[k]));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  for (int f = 0; f < 4; ++f) {
+    for (int k = f; k < kNumKeys; k += 4) {
+      values[k] = RandomString(&rnd, 1000);
+      ASSERT_OK(Put(Key(k), values[k]));
+    }
+    ASSERT_OK(Flush());
+  }
+
+  std::atomic<int> num_subcompactions(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::Run():Inprogress",
+      [&](void* /*arg*/) { num_subcompactions.fetch_add(1); });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  // More subcompactions than max_subcompactions, the threads take turns
+  ASSERT_GT(num_subcompactions.load(), 2);
+  for (int k = 0; k < kNumKeys; ++k) {
+    ASSERT_EQ(Get(Key(k)), values[k]);
+  }
+}
+
+TEST_F(DBCompactionTest, CompactionScheduleWeight) {
+  class CompactionOrderListener : public EventListener {
+   public:
+    virtual void OnCompactionBegin(DB* /*db*/,
+                                   const CompactionJobInfo& ci) override {
+      std::lock_guard<std::mutex> lock(mutex_);
+      order_.push_back(ci.cf_name);
+    }
+    std::vector<std::string> order() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return order_;
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<std::string> order_;
+  };
+  auto listener = std::make_shared<CompactionOrderListener>();
+
+  const int kNumKeysPerFile = 100;
+  Options options = CurrentOptions();
+  options.level0_file_num_compaction_trigger = 2;
+  options.max_background_compactions = 1;
+  options.memtable_factory.reset(new SpecialSkipListFactory(kNumKeysPerFile));
+  options.listeners.push_back(listener);
+
+  env_->SetBackgroundThreads(1, Env::LOW);
+  test::SleepingBackgroundTask sleeping_task_low;
+  env_->Schedule(&test::SleepingBackgroundTask::DoSleepTask, &sleeping_task_low,
+                 Env::Priority::LOW);
+  sleeping_task_low.WaitUntilSleeping();
+
+  CreateAndReopenWithCF({"one", "two"}, options);
+  ASSERT_OK(dbfull()->SetOptions(handles_[2],
+                                 {{"compaction_schedule_weight", "10"}}));
+
+  // "one" is queued first, "two" outweighs it at the same score
+  for (int cf = 1; cf <= 2; cf++) {
+    for (int num = 0; num < options.level0_file_num_compaction_trigger; num++) {
+      for (int i = 0; i < kNumKeysPerFile; i++) {
+        ASSERT_OK(Put(cf, Key(i), ""));
+      }
+      // put extra key to trigger flush
+      ASSERT_OK(Put(cf, "", ""));
+      dbfull()->TEST_WaitForFlushMemTable(handles_[cf]);
+      ASSERT_EQ(NumTableFilesAtLevel(0, cf), num + 1);
+    }
+  }
+
+  sleeping_task_low.WakeUp();
+  sleeping_task_low.WaitUntilDone();
+  dbfull()->TEST_WaitForCompact();
+
+  auto order = listener->order();
+  ASSERT_GE(order.size(), 2U);
+  ASSERT_EQ(order[0], "two");
+  ASSERT_EQ(order[1], "one");
+}
+
 TEST_F(DBCompactionTest, LazyCompactionTest) {
   Options options = CurrentOptions();
   options.disable_auto_compactions = true;
@@ -1860,6 +1961,91 @@ TEST_F(DBCompactionTest, DeleteFileRangeFileEndpointsOverlapBug) {
   db_->ReleaseSnapshot(snapshot);
 }
 
+TEST_F(DBCompactionTest, LazyCompactionMapSstIndex) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.enable_lazy_compaction = true;
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 20;
+  auto put_file = [&](int round) {
+    for (int i = round; i < kNumKeys; i += 2) {
+      ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+    }
+    ASSERT_OK(Flush());
+  };
+  // A plain file on level 1, then an overlapping one linked by a map sst
+  put_file(0);
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  put_file(1);
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+
+  std::atomic<int> index_hits(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "TableCache::Get:MapSstIndex", [&](void* /*arg*/) { ++index_hits; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  auto check = [&] {
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+    }
+    ASSERT_EQ("NOT_FOUND", Get(Key(kNumKeys)));
+  };
+  // Disabled by default
+  check();
+  ASSERT_EQ(0, index_hits.load());
+
+  // Loaded by the first lookup
+  options.map_sst_index_memory_budget = 1 << 20;
+  Reopen(options);
+  check();
+  ASSERT_GE(index_hits.load(), kNumKeys);
+
+  // Too small for the map sst
+  options.map_sst_index_memory_budget = 1;
+  Reopen(options);
+  index_hits = 0;
+  check();
+  ASSERT_EQ(0, index_hits.load());
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBCompactionTest, LazyCompactionReadAmpDebt) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.enable_lazy_compaction = true;
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 10;
+  auto put_file = [&](int round) {
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_OK(Put(Key(i), "v" + ToString(round)));
+    }
+    ASSERT_OK(Flush());
+  };
+  // A plain file on level 1, then overlapping files linked by a map sst
+  put_file(0);
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  const int kNumFiles = 4;
+  for (int round = 1; round <= kNumFiles; ++round) {
+    put_file(round);
+  }
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  uint64_t debt;
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kReadAmpDebt, &debt));
+  ASSERT_GT(debt, 0U);
+
+  ASSERT_OK(dbfull()->SetOptions({{"max_map_sst_read_amp", "2"},
+                                  {"disable_auto_compactions", "false"}}));
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kReadAmpDebt, &debt));
+  ASSERT_EQ(0U, debt);
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ("v" + ToString(kNumFiles), Get(Key(i)));
+  }
+}
+
 TEST_F(DBCompactionTest, LazyCompactionDeleteFileRangeFile) {
   const int kNumL0Files = 10;
   const int kValSize = 8 << 10;  // 8KB
@@ -3534,6 +3720,128 @@ TEST_F(DBCompactionTest, CompactBottomLevelFilesWithDeletions) {
   TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
 }
 
+TEST_F(DBCompactionTest, ColdRecompress) {
+  const int kNumKeys = 100;
+  Options options = CurrentOptions();
+  options.cold_recompress_seconds = 3600;
+  DestroyAndReopen(options);
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(1, NumTableFilesAtLevel(1));
+
+  int cold_compactions = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "LevelCompactionPicker::PickCompaction:Return", [&](void* arg) {
+        Compaction* compaction = reinterpret_cast<Compaction*>(arg);
+        if (compaction != nullptr &&
+            compaction->compaction_reason() ==
+                CompactionReason::kColdRecompress) {
+          ++cold_compactions;
+        }
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // Not cold yet
+  dbfull()->ScheduleColdRecompress();
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ(0, cold_compactions);
+
+  std::vector<LiveFileMetaData> before, after;
+  db_->GetLiveFilesMetaData(&before);
+  env_->addon_time_.fetch_add(2 * options.cold_recompress_seconds);
+  dbfull()->ScheduleColdRecompress();
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ(1, cold_compactions);
+  db_->GetLiveFilesMetaData(&after);
+  ASSERT_EQ(1u, before.size());
+  ASSERT_EQ(1u, after.size());
+  ASSERT_EQ(1, after[0].level);
+  ASSERT_NE(before[0].name, after[0].name);
+
+  // The rewritten file starts a new cold period
+  dbfull()->ScheduleColdRecompress();
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ(1, cold_compactions);
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+  }
+}
+
+TEST_F(DBCompactionTest, HotPathLevels) {
+  const int kNumKeys = 100;
+  Options options = CurrentOptions();
+  options.db_paths.emplace_back(dbname_, 1 << 30);
+  options.db_paths.emplace_back(dbname_ + "_cold", 1 << 30);
+  DestroyAndReopen(options);
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(1, NumTableFilesAtLevel(1));
+
+  int migrations = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "LevelCompactionPicker::PickCompaction:Return", [&](void* arg) {
+        Compaction* compaction = reinterpret_cast<Compaction*>(arg);
+        if (compaction != nullptr &&
+            compaction->compaction_reason() ==
+                CompactionReason::kPathMigration) {
+          ++migrations;
+        }
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // Placed by target size, everything fits in the first path
+  std::vector<LiveFileMetaData> files;
+  db_->GetLiveFilesMetaData(&files);
+  ASSERT_EQ(1u, files.size());
+  ASSERT_EQ(options.db_paths[0].path, files[0].db_path);
+
+  // L1 turns cold and moves to the last path
+  ASSERT_OK(dbfull()->SetOptions({{"hot_path_levels", "1"}}));
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ(1, migrations);
+  files.clear();
+  db_->GetLiveFilesMetaData(&files);
+  ASSERT_EQ(1u, files.size());
+  ASSERT_EQ(1, files[0].level);
+  ASSERT_EQ(options.db_paths[1].path, files[0].db_path);
+
+  // New L0 files stay on the first path
+  ASSERT_OK(Put(Key(kNumKeys), "new"));
+  ASSERT_OK(Flush());
+  files.clear();
+  db_->GetLiveFilesMetaData(&files);
+  ASSERT_EQ(2u, files.size());
+  for (auto& file : files) {
+    ASSERT_EQ(options.db_paths[file.level == 0 ? 0 : 1].path, file.db_path);
+  }
+
+  // And L1 moves back once it is hot again
+  ASSERT_OK(dbfull()->SetOptions({{"hot_path_levels", "2"}}));
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ(2, migrations);
+  files.clear();
+  db_->GetLiveFilesMetaData(&files);
+  for (auto& file : files) {
+    ASSERT_EQ(options.db_paths[0].path, file.db_path);
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+  }
+  ASSERT_EQ("new", Get(Key(kNumKeys)));
+}
+
 TEST_F(DBCompactionTest, CompactRangeDelayedByL0FileCount) {
   // Verify that, when `CompactRangeOptions::allow_write_stall == false`, manual
   // compaction only triggers flush after it's sure stall won't be triggered for
@@ -4175,6 +4483,222 @@ TEST_P(DBCompactionTestWithParam, FixFileIngestionCompactionDeadlock) {
   Close();
 }
 
+TEST_F(DBCompactionTest, BlobGarbageProperties) {
+  std::string bigval(100, 'v');
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  options.blob_size = 32;  // turn on kv separation
+  options.statistics = CreateDBStatistics();
+
+  // gc job banned, the garbage stays
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::ProcessGarbageCollection::Start",
+      [&](void* arg) { *(bool*)arg = true; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), bigval));
+  }
+  ASSERT_OK(Flush());
+  uint64_t blob_size, garbage_size;
+  ASSERT_TRUE(
+      db_->GetIntProperty(DB::Properties::kTotalBlobFilesSize, &blob_size));
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateBlobGarbageSize,
+                                  &garbage_size));
+  ASSERT_GT(blob_size, 0U);
+  ASSERT_EQ(0U, garbage_size);
+
+  // The overwritten values are garbage once compacted
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), bigval));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_TRUE(
+      db_->GetIntProperty(DB::Properties::kTotalBlobFilesSize, &blob_size));
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateBlobGarbageSize,
+                                  &garbage_size));
+  ASSERT_GT(garbage_size, 0U);
+  ASSERT_LT(garbage_size, blob_size);
+  ASSERT_EQ(0U, TestGetTickerCount(options, GC_WRITE_BYTES));
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBCompactionTest, SpaceAmplificationTriggersGarbageCollection) {
+  std::string bigval(100, 'v');
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  options.blob_size = 32;  // turn on kv separation
+  options.blob_gc_ratio = 0.5;
+  options.statistics = CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  uint64_t space_amp;
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateSpaceAmplification,
+                                  &space_amp));
+  ASSERT_EQ(0U, space_amp);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), bigval));
+  }
+  ASSERT_OK(Flush());
+  // Overwrites too few values for the garbage to reach blob_gc_ratio
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_OK(Put(Key(i), bigval));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateSpaceAmplification,
+                                  &space_amp));
+  ASSERT_GT(space_amp, 120U);
+
+  ASSERT_OK(dbfull()->SetOptions({{"disable_auto_compactions", "false"}}));
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ(0U, TestGetTickerCount(options, GC_WRITE_BYTES));
+
+  ASSERT_OK(dbfull()->SetOptions({{"max_space_amplification_percent", "110"}}));
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_GT(TestGetTickerCount(options, GC_WRITE_BYTES), 0U);
+  uint64_t new_space_amp;
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateSpaceAmplification,
+                                  &new_space_amp));
+  ASSERT_LT(new_space_amp, space_amp);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(bigval, Get(Key(i)));
+  }
+}
+
+TEST_F(DBCompactionTest, BlobGarbageCollectionDropsShadowedVersions) {
+  std::string old_val(100, 'a');
+  std::string new_val(100, 'b');
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  options.blob_size = 32;  // turn on kv separation
+
+  // gc job banned until the snapshot is released
+  std::atomic<bool> gc_banned{true};
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::ProcessGarbageCollection::Start",
+      [&](void* arg) { *(bool*)arg = gc_banned; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), old_val));
+  }
+  const Snapshot* kept = db_->GetSnapshot();
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), new_val));
+  }
+  for (int i = 100; i < 200; ++i) {
+    ASSERT_OK(Put(Key(i), old_val));
+  }
+  const Snapshot* released = db_->GetSnapshot();
+  for (int i = 100; i < 200; ++i) {
+    ASSERT_OK(Put(Key(i), new_val));
+  }
+  for (int i = 200; i < 300; ++i) {
+    ASSERT_OK(Put(Key(i), old_val));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 200; i < 300; ++i) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  ASSERT_OK(Flush());
+  // Both snapshots keep their versions in the SSTs
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(1, NumTableFilesAtLevel(-1));
+
+  db_->ReleaseSnapshot(released);
+  gc_banned = false;
+  ASSERT_OK(Put("z", "v"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+
+  // The versions only the released snapshot saw are gone with the garbage,
+  // the ones the kept snapshot sees stay
+  uint64_t num_entries = 0;
+  for (auto& blob : dbfull()
+                        ->TEST_GetVersionSet()
+                        ->GetColumnFamilySet()
+                        ->GetDefault()
+                        ->current()
+                        ->storage_info()
+                        ->LevelFiles(-1)) {
+    num_entries += blob->prop.num_entries;
+  }
+  ASSERT_EQ(300U, num_entries);
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_EQ(new_val, Get(Key(i)));
+    ASSERT_EQ(i < 100 ? old_val : "NOT_FOUND", Get(Key(i), kept));
+  }
+  db_->ReleaseSnapshot(kept);
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBCompactionTest, BlobOutputAlignedToSst) {
+  std::string bigval(200, 'v');
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  options.blob_size = 32;  // turn on kv separation
+  options.target_file_size_base = 16 << 10;
+  options.target_blob_file_size = 4 << 20;
+  options.blob_file_defragment_size = 4 << 10;
+  options.align_blob_output_to_sst = true;
+
+  // gc job banned
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::ProcessGarbageCollection::Start",
+      [&](void* arg) { *(bool*)arg = true; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+  DestroyAndReopen(options);
+
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 4000; ++i) {
+      ASSERT_OK(Put(Key(i), bigval));
+    }
+    ASSERT_OK(Flush());
+  }
+  CompactRangeOptions cro;
+  cro.separation_type = kCompactionForceRebuildBlob;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+
+  // Every SST holds more than a fragment of values, so it gets blobs of its
+  // own, far below target_blob_file_size
+  auto vstorage = dbfull()
+                      ->TEST_GetVersionSet()
+                      ->GetColumnFamilySet()
+                      ->GetDefault()
+                      ->current()
+                      ->storage_info();
+  auto& ssts = vstorage->LevelFiles(1);
+  ASSERT_GT(ssts.size(), 1U);
+  ASSERT_EQ(static_cast<int>(ssts.size()), NumTableFilesAtLevel(-1));
+  const Comparator* ucmp = options.comparator;
+  for (auto& blob : vstorage->LevelFiles(-1)) {
+    size_t covering = 0;
+    for (auto& sst : ssts) {
+      if (ucmp->Compare(sst->smallest.user_key(), blob->smallest.user_key()) <=
+              0 &&
+          ucmp->Compare(blob->largest.user_key(), sst->largest.user_key()) <=
+              0) {
+        ++covering;
+      }
+    }
+    ASSERT_EQ(1U, covering);
+  }
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
 TEST_F(DBCompactionTest, BlobOverlapThredhold) {
   std::string bigval =
       "012345678901234567890123456789012345678901234567890123456789012345678901"
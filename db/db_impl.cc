@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <cmath>
 #include <map>
 #include <set>
 #include <stdexcept>
@@ -46,6 +47,7 @@
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
 #include "monitoring/in_memory_stats_history.h"
+#include "monitoring/io_purpose.h"
 #include "monitoring/iostats_context_imp.h"
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/persistent_stats_history.h"
@@ -59,6 +61,7 @@
 #include "rocksdb/convenience.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/stats_history.h"
@@ -83,7 +86,6 @@
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
-#include "utilities/trace/bytedance_metrics_reporter.h"
 
 #if !defined(_MSC_VER) && !defined(__APPLE__)
 #include <sys/unistd.h>
@@ -152,6 +154,8 @@ void DumpSupportInfo(Logger* logger) {
   }
   ROCKS_LOG_HEADER(logger, "Fast CRC32 supported: %s",
                    crc32c::IsFastCrc32Supported().c_str());
+  ROCKS_LOG_HEADER(logger, "CRC32C kernel: %s",
+                   crc32c::KernelName().c_str());
 }
 
 int64_t kDefaultLowPriThrottledRate = 2 * 1024 * 1024;
@@ -174,9 +178,14 @@ static std::string next_latency_metric_name = "dbiter_next_latency";
 static std::string seekforprev_latency_metric_name =
     "dbiter_seekforprev_latency";
 static std::string prev_latency_metric_name = "dbiter_prev_latency";
+static std::string write_wal_latency_metric_name = "dbimpl_write_wal_latency";
+static std::string wal_sync_latency_metric_name = "dbimpl_wal_sync_latency";
+static std::string write_memtable_latency_metric_name =
+    "dbimpl_write_memtable_latency";
 
 static std::string write_throughput_metric_name = "dbimpl_writeimpl_throughput";
 static std::string write_batch_size_metric_name = "dbimpl_writeimpl_batch_size";
+static std::string write_group_size_metric_name = "dbimpl_write_group_size";
 
 DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
                const bool seq_per_batch, const bool batch_per_txn)
@@ -187,6 +196,7 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
       immutable_db_options_(initial_db_options_),
       mutable_db_options_(initial_db_options_),
       stats_(immutable_db_options_.statistics.get()),
+      perf_trace_sample_rate_(0),
       db_lock_(nullptr),
       mutex_(stats_, env_, DB_MUTEX_WAIT_MICROS,
              immutable_db_options_.use_adaptive_mutex),
@@ -204,6 +214,7 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
       max_total_in_memory_state_(0),
       is_snapshot_supported_(true),
       write_buffer_manager_(immutable_db_options_.write_buffer_manager.get()),
+      write_buffer_client_(write_buffer_manager_->RegisterClient()),
       write_thread_(immutable_db_options_),
       nonmem_write_thread_(immutable_db_options_),
       write_controller_(mutable_db_options_.delayed_write_rate),
@@ -273,10 +284,7 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
       error_handler_(this, immutable_db_options_, &mutex_),
       atomic_flush_install_cv_(&mutex_),
       bytedance_tags_("dbname=" + dbname),
-      metrics_reporter_factory_(
-          options.metrics_reporter_factory == nullptr
-              ? std::make_shared<ByteDanceMetricsReporterFactory>()
-              : options.metrics_reporter_factory),
+      metrics_reporter_factory_(immutable_db_options_.metrics_reporter_factory),
       console_runner_(this, dbname, env_, immutable_db_options_.info_log.get()),
 
       write_qps_reporter_(*metrics_reporter_factory_->BuildCountReporter(
@@ -324,11 +332,24 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
       prev_latency_reporter_(*metrics_reporter_factory_->BuildHistReporter(
           prev_latency_metric_name, bytedance_tags_,
           immutable_db_options_.info_log.get())),
+      write_wal_latency_reporter_(*metrics_reporter_factory_->BuildHistReporter(
+          write_wal_latency_metric_name, bytedance_tags_,
+          immutable_db_options_.info_log.get())),
+      wal_sync_latency_reporter_(*metrics_reporter_factory_->BuildHistReporter(
+          wal_sync_latency_metric_name, bytedance_tags_,
+          immutable_db_options_.info_log.get())),
+      write_memtable_latency_reporter_(
+          *metrics_reporter_factory_->BuildHistReporter(
+              write_memtable_latency_metric_name, bytedance_tags_,
+              immutable_db_options_.info_log.get())),
       write_throughput_reporter_(*metrics_reporter_factory_->BuildCountReporter(
           write_throughput_metric_name, bytedance_tags_,
           immutable_db_options_.info_log.get())),
       write_batch_size_reporter_(*metrics_reporter_factory_->BuildHistReporter(
           write_batch_size_metric_name, bytedance_tags_,
+          immutable_db_options_.info_log.get())),
+      write_group_size_reporter_(*metrics_reporter_factory_->BuildHistReporter(
+          write_group_size_metric_name, bytedance_tags_,
           immutable_db_options_.info_log.get())) {
   // !batch_per_trx_ implies seq_per_batch_ because it is only unset for
   // WriteUnprepared, which should use seq_per_batch_.
@@ -730,6 +751,7 @@ DBImpl::~DBImpl() {
     closed_ = true;
     CloseHelper();
   }
+  write_buffer_manager_->UnregisterClient(write_buffer_client_);
 }
 
 void DBImpl::MaybeIgnoreError(Status* s) const {
@@ -798,7 +820,7 @@ void DBImpl::PersistStats() {
     return;
   }
   TEST_SYNC_POINT("DBImpl::PersistStats:StartRunning");
-  uint64_t now_seconds = env_->NowMicros() / 1000 * 1000;
+  uint64_t now_seconds = env_->NowMicros() / 1000U / 1000U;
   Statistics* statistics = immutable_db_options_.statistics.get();
   if (!statistics) {
     return;
@@ -817,17 +839,18 @@ void DBImpl::PersistStats() {
   if (immutable_db_options_.persist_stats_to_disk) {
     WriteBatch batch;
     if (stats_slice_initialized_) {
+      // calculate the delta from last time
+      std::map<std::string, uint64_t> stats_delta;
       for (const auto& stat : stats_map) {
-        char key[100];
-        int length =
-            EncodePersistentStatsKey(now_seconds, stat.first, 100, key);
-        // calculate the delta from last time
         if (stats_slice_.find(stat.first) != stats_slice_.end()) {
-          uint64_t delta = stat.second - stats_slice_[stat.first];
-          batch.Put(persist_stats_cf_handle_, Slice(key, std::min(100, length)),
-                    ToString(delta));
+          stats_delta[stat.first] = stat.second - stats_slice_[stat.first];
         }
       }
+      if (!persist_stats_rollup_) {
+        persist_stats_rollup_.reset(new PersistentStatsRollup);
+      }
+      persist_stats_rollup_->Add(this, persist_stats_cf_handle_, now_seconds,
+                                 stats_delta, &batch);
     }
     stats_slice_initialized_ = true;
     std::swap(stats_slice_, stats_map);
@@ -841,7 +864,6 @@ void DBImpl::PersistStats() {
                      "Writing to persistent stats CF failed -- %s\n",
                      s.ToString().c_str());
     }
-    // TODO(Zhongyi): add purging for persisted data
   } else {
     InstrumentedMutexLock l(&stats_history_mutex_);
     // calculate the delta from last time
@@ -896,19 +918,47 @@ bool DBImpl::FindStatsByTime(uint64_t start_time, uint64_t end_time,
 Status DBImpl::GetStatsHistory(
     uint64_t start_time, uint64_t end_time,
     std::unique_ptr<StatsHistoryIterator>* stats_iterator) {
+  return GetStatsHistory(start_time, end_time,
+                         StatsHistoryGranularity::kSnapshot, {},
+                         stats_iterator);
+}
+
+Status DBImpl::GetStatsHistory(
+    uint64_t start_time, uint64_t end_time,
+    StatsHistoryGranularity granularity,
+    const std::vector<std::string>& stats_names,
+    std::unique_ptr<StatsHistoryIterator>* stats_iterator) {
   if (!stats_iterator) {
     return Status::InvalidArgument("stats_iterator not preallocated.");
   }
   if (immutable_db_options_.persist_stats_to_disk) {
-    stats_iterator->reset(
-        new PersistentStatsHistoryIterator(start_time, end_time, this));
+    stats_iterator->reset(new PersistentStatsHistoryIterator(
+        start_time, end_time, granularity, stats_names, this));
+  } else if (granularity != StatsHistoryGranularity::kSnapshot) {
+    return Status::NotSupported(
+        "Stats rollups are kept only with persist_stats_to_disk");
   } else {
-    stats_iterator->reset(
-        new InMemoryStatsHistoryIterator(start_time, end_time, this));
+    stats_iterator->reset(new InMemoryStatsHistoryIterator(
+        start_time, end_time, stats_names, this));
   }
   return (*stats_iterator)->status();
 }
 
+// The files with an expiry histogram follow the current ttl_gc_ratio, the
+// recorded time point is from the ratio at the time the file was built
+static uint64_t GetTtlBeginCompactTime(const TablePropertyCache& prop,
+                                       double ttl_gc_ratio) {
+  auto& histogram = prop.ttl_expiry_histogram;
+  if (histogram.empty()) {
+    return prop.earliest_time_begin_compact;
+  }
+  double pos = std::ceil(ttl_gc_ratio * kTtlExpiryHistogramSize);
+  if (pos > histogram.size()) {
+    return port::kMaxUint64;
+  }
+  return histogram[pos < 1 ? 0 : static_cast<size_t>(pos) - 1];
+}
+
 void DBImpl::ScheduleTtlGC() {
   TEST_SYNC_POINT("DBImpl:ScheduleTtlGC");
   uint64_t nowSeconds = env_->NowMicros() / 1000U / 1000U;
@@ -933,6 +983,42 @@ void DBImpl::ScheduleTtlGC() {
     }
     return should_mark;
   };
+  // An expired SST is dropped as if all of its entries were compacted away,
+  // which holds only when no older entry of its keys is left to show up and
+  // no snapshot still reads it
+  auto can_drop_expired = [&](VersionStorageInfo* vstorage, int level,
+                              size_t index, FileMetaData* meta) {
+    if (meta->prop.is_map_sst() || meta->prop.has_range_deletions() ||
+        (!snapshots_.empty() &&
+         snapshots_.GetNewest() >= meta->fd.smallest_seqno)) {
+      return false;
+    }
+    Slice smallest = meta->smallest.user_key();
+    Slice largest = meta->largest.user_key();
+    if (level == 0) {
+      auto ucmp = vstorage->InternalComparator()->user_comparator();
+      auto& l0_files = vstorage->LevelFiles(0);
+      for (size_t i = index + 1; i < l0_files.size(); ++i) {
+        if (ucmp->Compare(l0_files[i]->smallest.user_key(), largest) <= 0 &&
+            ucmp->Compare(l0_files[i]->largest.user_key(), smallest) >= 0) {
+          return false;
+        }
+      }
+    }
+    for (int l = level + 1; l < vstorage->num_non_empty_levels(); ++l) {
+      if (vstorage->OverlapInLevel(l, &smallest, &largest)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  JobContext job_context(next_job_id_.fetch_add(1), true);
+  struct ExpiredDrop {
+    ColumnFamilyData* cfd;
+    VersionEdit edit;
+    std::vector<FileMetaData*> files;
+  };
+  std::vector<ExpiredDrop> expired_drops;
   mutex_.Lock();
   for (auto cfd : *versions_->GetColumnFamilySet()) {
     uint64_t new_mark_count = 0;
@@ -942,18 +1028,41 @@ void DBImpl::ScheduleTtlGC() {
         cfd->ioptions()->ttl_extractor_factory == nullptr) {
       continue;
     }
+    double ttl_gc_ratio = cfd->GetLatestMutableCFOptions()->ttl_gc_ratio;
+    uint64_t ttl_window_seconds =
+        cfd->GetLatestMutableCFOptions()->ttl_window_seconds;
+    ExpiredDrop expired;
     VersionStorageInfo* vstorage = cfd->current()->storage_info();
     for (int l = 0; l < vstorage->num_non_empty_levels(); l++) {
-      for (auto meta : vstorage->LevelFiles(l)) {
+      auto& level_files = vstorage->LevelFiles(l);
+      for (size_t i = 0; i < level_files.size(); i++) {
+        auto meta = level_files[i];
         if (meta->being_compacted) {
           continue;
         }
         ++total_count;
         old_mark_count += meta->marked_for_compaction;
         TEST_SYNC_POINT("DBImpl:Exist-SST");
+        auto& histogram = meta->prop.ttl_expiry_histogram;
+        if (ttl_window_seconds > 0 &&
+            histogram.size() == kTtlExpiryHistogramSize) {
+          // Every entry has a ttl, the SST waits for the end of the window
+          // its last entry expires in
+          uint64_t window_end =
+              (histogram.back() / ttl_window_seconds + 1) * ttl_window_seconds;
+          if (window_end > nowSeconds) {
+            continue;
+          }
+          if (can_drop_expired(vstorage, l, i, meta)) {
+            expired.edit.DeleteFile(l, meta->fd.GetNumber());
+            expired.files.push_back(meta);
+            continue;
+          }
+        }
         if (!meta->marked_for_compaction &&
             should_marked_for_compacted(
-                l, meta->fd.GetNumber(), meta->prop.earliest_time_begin_compact,
+                l, meta->fd.GetNumber(),
+                GetTtlBeginCompactTime(meta->prop, ttl_gc_ratio),
                 meta->prop.latest_time_end_compact, nowSeconds)) {
           meta->marked_for_compaction = true;
         }
@@ -976,6 +1085,51 @@ void DBImpl::ScheduleTtlGC() {
                      ", new marked = %" PRIu64 ", file count: %" PRIu64,
                      cfd->GetName().c_str(), old_mark_count, new_mark_count,
                      total_count);
+    if (!expired.files.empty()) {
+      ROCKS_LOG_BUFFER(&log_buffer_info,
+                       "[%s] SSTs of passed ttl windows to drop = %zu",
+                       cfd->GetName().c_str(), expired.files.size());
+      // Keeps the picker away from the files until they are dropped
+      for (auto meta : expired.files) {
+        meta->being_compacted = true;
+      }
+      expired.edit.SetColumnFamily(cfd->GetID());
+      expired.cfd = cfd;
+      cfd->Ref();
+      expired_drops.emplace_back(std::move(expired));
+    }
+  }
+  // LogAndApply() releases the mutex, the column families are not iterated
+  // over any more
+  for (auto& drop : expired_drops) {
+    ColumnFamilyData* cfd = drop.cfd;
+    if (!cfd->IsDropped()) {
+      Status s =
+          versions_->LogAndApply(cfd, *cfd->GetLatestMutableCFOptions(),
+                                 &drop.edit, &mutex_, directories_.GetDbDir());
+      if (s.ok()) {
+        job_context.superversion_contexts.emplace_back(
+            SuperVersionContext(true));
+        InstallSuperVersionAndScheduleWork(
+            cfd, &job_context.superversion_contexts.back(),
+            *cfd->GetLatestMutableCFOptions(), FlushReason::kDeleteFiles);
+        TEST_SYNC_POINT("DBImpl:ScheduleTtlGC-drop");
+      } else {
+        ROCKS_LOG_BUFFER(&log_buffer_info,
+                         "[%s] Dropping the SSTs of passed ttl windows "
+                         "failed: %s",
+                         cfd->GetName().c_str(), s.ToString().c_str());
+      }
+    }
+    for (auto meta : drop.files) {
+      meta->being_compacted = false;
+    }
+    if (cfd->Unref()) {
+      delete cfd;
+    }
+  }
+  if (!expired_drops.empty()) {
+    FindObsoleteFiles(&job_context, false);
   }
   if (unscheduled_compactions_ > 0) {
     MaybeScheduleFlushOrCompaction();
@@ -983,6 +1137,114 @@ void DBImpl::ScheduleTtlGC() {
   mutex_.Unlock();
   log_buffer_info.FlushBufferToLog();
   log_buffer_debug.FlushBufferToLog();
+  if (job_context.HaveSomethingToDelete()) {
+    PurgeObsoleteFiles(job_context);
+  }
+  job_context.Clean(&mutex_);
+}
+
+void DBImpl::ScheduleColdRecompress() {
+  TEST_SYNC_POINT("DBImpl:ScheduleColdRecompress");
+  InstrumentedMutexLock l(&mutex_);
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (!cfd->initialized() || cfd->IsDropped() ||
+        cfd->GetLatestMutableCFOptions()->cold_recompress_seconds == 0) {
+      continue;
+    }
+    // Files turn cold as time goes by, not only on version changes
+    cfd->current()->storage_info()->ComputeCompactionScore(
+        *cfd->ioptions(), *cfd->GetLatestMutableCFOptions());
+    SchedulePendingCompaction(cfd);
+  }
+  if (unscheduled_compactions_ > 0) {
+    MaybeScheduleFlushOrCompaction();
+  }
+}
+
+void DBImpl::ScrubChecksums() {
+  TEST_SYNC_POINT("DBImpl::ScrubChecksums:Start");
+#ifndef ROCKSDB_LITE
+  const int64_t budget = static_cast<int64_t>(
+      immutable_db_options_.checksum_scrub_bytes_per_sec *
+      PeriodicWorkScheduler::kDefaultChecksumScrubPeriodSec);
+  // Credit left by an idle period does not add up to a burst
+  scrub_credit_ = std::min(scrub_credit_ + budget, budget);
+  if (scrub_credit_ <= 0) {
+    return;
+  }
+
+  struct ScrubFile {
+    uint64_t file_number;
+    uint64_t file_size;
+    std::string fname;
+    size_t options_index;
+  };
+  std::vector<ScrubFile> files;
+  std::vector<Options> options;
+  autovector<Version*> versions;
+  {
+    InstrumentedMutexLock l(&mutex_);
+    DBOptions db_options =
+        BuildDBOptions(immutable_db_options_, mutable_db_options_);
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      if (cfd->IsDropped() || !cfd->initialized()) {
+        continue;
+      }
+      // Keeps the files alive until they are scrubbed
+      Version* current = cfd->current();
+      current->Ref();
+      versions.push_back(current);
+      options.emplace_back(db_options, cfd->GetLatestCFOptions());
+      VersionStorageInfo* vstorage = current->storage_info();
+      for (int i = -1; i < vstorage->num_non_empty_levels(); i++) {
+        for (auto f : vstorage->LevelFiles(i)) {
+          if (f->fd.GetNumber() < scrub_next_file_number_) {
+            continue;
+          }
+          files.push_back(
+              {f->fd.GetNumber(), f->fd.GetFileSize(),
+               TableFileName(cfd->ioptions()->cf_paths, f->fd.GetNumber(),
+                             f->fd.GetPathId()),
+               options.size() - 1});
+        }
+      }
+    }
+  }
+  std::sort(files.begin(), files.end(),
+            [](const ScrubFile& a, const ScrubFile& b) {
+              return a.file_number < b.file_number;
+            });
+
+  size_t scrubbed = 0;
+  for (auto& file : files) {
+    if (scrub_credit_ <= 0 || shutting_down_.load(std::memory_order_acquire)) {
+      break;
+    }
+    Status s = TERARKDB_NAMESPACE::VerifySstFileChecksum(
+        options[file.options_index], env_options_, file.fname);
+    scrub_next_file_number_ = file.file_number + 1;
+    scrub_credit_ -= static_cast<int64_t>(file.file_size);
+    ++scrubbed;
+    // Some table formats can not verify themselves
+    if (!s.ok() && !s.IsNotSupported()) {
+      ROCKS_LOG_ERROR(immutable_db_options_.info_log,
+                      "Checksum scrub of %s failed: %s", file.fname.c_str(),
+                      s.ToString().c_str());
+      InstrumentedMutexLock l(&mutex_);
+      error_handler_.SetBGError(s, BackgroundErrorReason::kChecksumScrub);
+    }
+  }
+  if (scrubbed == files.size()) {
+    ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                   "Checksum scrub round finished");
+    scrub_next_file_number_ = 0;
+  }
+
+  InstrumentedMutexLock l(&mutex_);
+  for (auto v : versions) {
+    v->Unref();
+  }
+#endif  // !ROCKSDB_LITE
 }
 
 void DBImpl::DumpStats() {
@@ -1045,7 +1307,21 @@ void DBImpl::DumpStats() {
                      "------- Malloc STATS -------");
       ROCKS_LOG_WARN(immutable_db_options_.info_log, "%s", stats.c_str());
     }
+    MemoryAllocatorStats allocator_stats;
+    auto* allocator = immutable_db_options_.compaction_buffer_allocator.get();
+    if (allocator != nullptr && allocator->GetStats(&allocator_stats).ok()) {
+      ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                     "Compaction buffer allocator %s: allocated %" PRIu64
+                     " resident %" PRIu64,
+                     allocator->Name(), allocator_stats.allocated_bytes,
+                     allocator_stats.resident_bytes);
+    }
   }
+  stats.clear();
+  if (GetPropertyHandleHotKeys(&stats)) {
+    ROCKS_LOG_WARN(immutable_db_options_.info_log, "%s", stats.c_str());
+  }
+  ReportHotKeys();
 #endif  // !ROCKSDB_LITE
 
   PrintStatistics();
@@ -1359,14 +1635,17 @@ Status DBImpl::SyncWAL() {
   TEST_SYNC_POINT("DBWALTest::SyncWALNotWaitWrite:1");
   RecordTick(stats_, WAL_FILE_SYNCED);
   Status status;
-  for (log::Writer* log : logs_to_sync) {
-    status = log->file()->SyncWithoutFlush(immutable_db_options_.use_fsync);
-    if (!status.ok()) {
-      break;
+  {
+    LatencyHistGuard sync_guard(&wal_sync_latency_reporter_);
+    for (log::Writer* log : logs_to_sync) {
+      status = log->file()->SyncWithoutFlush(immutable_db_options_.use_fsync);
+      if (!status.ok()) {
+        break;
+      }
+    }
+    if (status.ok() && need_log_dir_sync) {
+      status = directories_.GetWalDir()->Fsync();
     }
-  }
-  if (status.ok() && need_log_dir_sync) {
-    status = directories_.GetWalDir()->Fsync();
   }
   TEST_SYNC_POINT("DBWALTest::SyncWALNotWaitWrite:2");
 
@@ -1647,13 +1926,18 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
                        ReadCallback* callback) {
   LatencyHistGuard guard(&read_latency_reporter_);
   read_qps_reporter_.AddCount(1);
+  IOPurposeGuard io_purpose_guard(kIOPurposeGet);
 
   assert(lazy_val != nullptr);
+  PerfTraceScope perf_trace(this, kPerfTraceGet, column_family->GetID());
   StopWatch sw(env_, stats_, DB_GET);
   PERF_TIMER_GUARD(get_snapshot_time);
 
   auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family);
   auto cfd = cfh->cfd();
+  if (immutable_db_options_.hot_key_tracker) {
+    immutable_db_options_.hot_key_tracker->RecordKey(cfd->GetID(), key);
+  }
 
   if (tracer_) {
     // TODO: This mutex should be removed later, to improve performance when
@@ -1703,6 +1987,23 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   TEST_SYNC_POINT("DBImpl::GetImpl:3");
   TEST_SYNC_POINT("DBImpl::GetImpl:4");
 
+  NegativeLookupCache* negative_lookup_cache = cfd->negative_lookup_cache();
+  if (negative_lookup_cache != nullptr &&
+      (callback != nullptr || read_options.read_tier != kReadAllTier ||
+       read_options.ignore_range_deletions)) {
+    negative_lookup_cache = nullptr;
+  }
+  if (negative_lookup_cache != nullptr) {
+    if (negative_lookup_cache->Contains(key, sv->version_number, snapshot)) {
+      RecordTick(stats_, NEGATIVE_LOOKUP_CACHE_HIT);
+      PERF_TIMER_STOP(get_snapshot_time);
+      ReturnAndCleanupSuperVersion(cfd, sv);
+      RecordTick(stats_, NUMBER_KEYS_READ);
+      return Status::NotFound();
+    }
+    RecordTick(stats_, NEGATIVE_LOOKUP_CACHE_MISS);
+  }
+
   // Prepare to store a list of merge operations if merge occurs.
   MergeContext merge_context;
   SequenceNumber max_covering_tombstone_seq = 0;
@@ -1717,6 +2018,7 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   bool skip_memtable = (read_options.read_tier == kPersistedTier &&
                         has_unpersisted_data_.load(std::memory_order_relaxed));
   bool done = false;
+  bool value_projected = false;
   if (!skip_memtable) {
     if (sv->mem->Get(lkey, lazy_val, &s, &merge_context,
                      &max_covering_tombstone_seq, read_options, callback)) {
@@ -1738,13 +2040,19 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
     PERF_TIMER_GUARD(get_from_output_files_time);
     sv->current->Get(read_options, key, lkey, lazy_val, &s, &merge_context,
                      &max_covering_tombstone_seq, value_found, nullptr, nullptr,
-                     callback);
+                     callback, &value_projected);
     RecordTick(stats_, MEMTABLE_MISS);
   }
 
   if (s.ok()) {
     lazy_val->pin(LazyBufferPinLevel::DB);
     s = lazy_val->fetch();
+    if (s.ok() && read_options.value_projection != nullptr &&
+        !value_projected) {
+      s = ProjectValue(read_options.value_projection, key, lazy_val);
+    }
+  } else if (s.IsNotFound() && negative_lookup_cache != nullptr) {
+    negative_lookup_cache->Insert(key, sv->version_number, snapshot);
   }
 
   {
@@ -1860,9 +2168,21 @@ std::vector<Status> DBImpl::MultiGet(
     const std::vector<Slice>& keys, std::vector<std::string>* values) {
   LatencyHistGuard guard(&read_latency_reporter_);
   read_qps_reporter_.AddCount(keys.size());
+  IOPurposeGuard io_purpose_guard(kIOPurposeGet);
+  // The column family of the first key
+  PerfTraceScope perf_trace(
+      this, kPerfTraceMultiGet,
+      column_family.empty() ? 0 : column_family[0]->GetID());
   StopWatch sw(env_, stats_, DB_MULTIGET);
   PERF_TIMER_GUARD(get_snapshot_time);
 
+  if (tracer_) {
+    InstrumentedMutexLock lock(&trace_mutex_);
+    if (tracer_) {
+      tracer_->MultiGet(column_family, keys);
+    }
+  }
+
   SequenceNumber snapshot;
 
   struct MultiGetColumnFamilyData {
@@ -1881,20 +2201,54 @@ std::vector<Status> DBImpl::MultiGet(
     }
   }
 
-  mutex_.Lock();
-  if (read_options.snapshot != nullptr) {
-    snapshot =
-        reinterpret_cast<const SnapshotImpl*>(read_options.snapshot)->number_;
-  } else {
-    snapshot = last_seq_same_as_publish_seq_
-                   ? versions_->LastSequence()
-                   : versions_->LastPublishedSequence();
-  }
-  for (auto mgd_iter : multiget_cf_data) {
-    mgd_iter.second->super_version =
-        mgd_iter.second->cfd->GetSuperVersion()->Ref();
+  // Reference the super versions through the thread local cache first.
+  // Without an explicit snapshot the sequence is read after that, and it is
+  // only consistent across column families if none of the super versions
+  // has been replaced meanwhile. Fall back to the db mutex after a few tries
+  const int kMaxThreadLocalAttempts = 3;
+  bool thread_local_sv = true;
+  for (int attempt = 0;; ++attempt) {
+    thread_local_sv = attempt < kMaxThreadLocalAttempts;
+    if (!thread_local_sv) {
+      mutex_.Lock();
+    }
+    for (auto mgd_iter : multiget_cf_data) {
+      auto cfd = mgd_iter.second->cfd;
+      mgd_iter.second->super_version = thread_local_sv
+                                           ? GetAndRefSuperVersion(cfd)
+                                           : cfd->GetSuperVersion()->Ref();
+    }
+    if (read_options.snapshot != nullptr) {
+      snapshot =
+          reinterpret_cast<const SnapshotImpl*>(read_options.snapshot)->number_;
+    } else {
+      snapshot = last_seq_same_as_publish_seq_
+                     ? versions_->LastSequence()
+                     : versions_->LastPublishedSequence();
+    }
+    if (!thread_local_sv) {
+      mutex_.Unlock();
+      break;
+    }
+    TEST_SYNC_POINT("DBImpl::MultiGet:AfterRefSuperVersion");
+    bool consistent = true;
+    if (read_options.snapshot == nullptr && multiget_cf_data.size() > 1) {
+      for (auto mgd_iter : multiget_cf_data) {
+        if (mgd_iter.second->super_version->version_number !=
+            mgd_iter.second->cfd->GetSuperVersionNumber()) {
+          consistent = false;
+          break;
+        }
+      }
+    }
+    if (consistent) {
+      break;
+    }
+    for (auto mgd_iter : multiget_cf_data) {
+      ReturnAndCleanupSuperVersion(mgd_iter.second->cfd,
+                                   mgd_iter.second->super_version);
+    }
   }
-  mutex_.Unlock();
 
   // Note: this always resizes the values array
   size_t num_keys = keys.size();
@@ -1911,41 +2265,67 @@ std::vector<Status> DBImpl::MultiGet(
   // merge_operands will contain the sequence of merges in the latter case.
   size_t num_found = 0;
   size_t counting = num_keys;
-  auto get_one = [&](size_t i) {
-    // Contain a list of merge operations if merge occurs.
-    MergeContext merge_context;
-    Status& s = stat_list[i];
-    std::string* value = &(*values)[i];
-    LazyBuffer lazy_val(value);
-
-    LookupKey lkey(keys[i], snapshot);
+  // Separated values are collected here and fetched in batch by version
+  std::vector<std::pair<size_t, LazyBuffer>> pending_values;
+  // Per key state, kept from the memtable lookup to the SST lookup
+  std::vector<MergeContext> merge_contexts(num_keys);
+  std::vector<LazyBuffer> lazy_vals;
+  lazy_vals.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    lazy_vals.emplace_back(&(*values)[i]);
+  }
+  std::vector<std::unique_ptr<LookupKey>> lkeys(num_keys);
+  std::vector<SequenceNumber> max_covering_tombstone_seqs(num_keys, 0);
+  // Values answered by their value meta are already projected
+  std::unique_ptr<bool[]> value_projected(new bool[num_keys]());
+  auto project = [&](size_t i, LazyBuffer* lazy_val) {
+    if (read_options.value_projection == nullptr || value_projected[i]) {
+      return Status::OK();
+    }
+    return ProjectValue(read_options.value_projection, keys[i], lazy_val);
+  };
+  auto super_version_of = [&](size_t i) {
     auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
-    SequenceNumber max_covering_tombstone_seq = 0;
     auto mgd_iter = multiget_cf_data.find(cfh->cfd()->GetID());
     assert(mgd_iter != multiget_cf_data.end());
-    auto mgd = mgd_iter->second;
-    auto super_version = mgd->super_version;
+    return mgd_iter->second->super_version;
+  };
+  // Returns true if the lookup of key i ended in the memtables
+  auto get_from_memtable = [&](size_t i) {
+    lkeys[i].reset(new LookupKey(keys[i], snapshot));
+    auto super_version = super_version_of(i);
     bool skip_memtable =
         (read_options.read_tier == kPersistedTier &&
          has_unpersisted_data_.load(std::memory_order_relaxed));
-    bool done = false;
     if (!skip_memtable) {
-      if (super_version->mem->Get(lkey, &lazy_val, &s, &merge_context,
-                                  &max_covering_tombstone_seq, read_options)) {
-        done = true;
+      if (super_version->mem->Get(*lkeys[i], &lazy_vals[i], &stat_list[i],
+                                  &merge_contexts[i],
+                                  &max_covering_tombstone_seqs[i],
+                                  read_options)) {
         RecordTick(stats_, MEMTABLE_HIT);
-      } else if (super_version->imm->Get(lkey, &lazy_val, &s, &merge_context,
-                                         &max_covering_tombstone_seq,
+        return true;
+      } else if (super_version->imm->Get(*lkeys[i], &lazy_vals[i],
+                                         &stat_list[i], &merge_contexts[i],
+                                         &max_covering_tombstone_seqs[i],
                                          read_options)) {
-        done = true;
         RecordTick(stats_, MEMTABLE_HIT);
+        return true;
       }
     }
-    if (!done) {
-      PERF_TIMER_GUARD(get_from_output_files_time);
-      super_version->current->Get(read_options, keys[i], lkey, &lazy_val, &s,
-                                  &merge_context, &max_covering_tombstone_seq);
-      RecordTick(stats_, MEMTABLE_MISS);
+    RecordTick(stats_, MEMTABLE_MISS);
+    return false;
+  };
+  auto finish_one = [&](size_t i) {
+    Status& s = stat_list[i];
+    std::string* value = &(*values)[i];
+    LazyBuffer& lazy_val = lazy_vals[i];
+    if (s.ok() && super_version_of(i)->current->IsSeparatePending(lazy_val)) {
+      pending_values.emplace_back(i, std::move(lazy_val));
+      counting--;
+      return;
+    }
+    if (s.ok()) {
+      s = project(i, &lazy_val);
     }
     if (s.ok()) {
       s = std::move(lazy_val).dump(value);
@@ -1956,6 +2336,34 @@ std::vector<Status> DBImpl::MultiGet(
     }
     counting--;
   };
+#ifdef BOOSTLIB
+  auto get_one = [&](size_t i) {
+    if (!get_from_memtable(i)) {
+      PERF_TIMER_GUARD(get_from_output_files_time);
+      super_version_of(i)->current->Get(
+          read_options, keys[i], *lkeys[i], &lazy_vals[i], &stat_list[i],
+          &merge_contexts[i], &max_covering_tombstone_seqs[i], nullptr,
+          nullptr, nullptr, nullptr, &value_projected[i]);
+    }
+    finish_one(i);
+  };
+#endif
+  // Look keys up in key order per column family, neighboring lookups then
+  // walk the same index path and hit the same blocks while they are hot
+  std::vector<size_t> key_order(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    key_order[i] = i;
+  }
+  std::sort(key_order.begin(), key_order.end(), [&](size_t a, size_t b) {
+    auto cfd_a = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[a])
+                     ->cfd();
+    auto cfd_b = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[b])
+                     ->cfd();
+    if (cfd_a != cfd_b) {
+      return cfd_a->GetID() < cfd_b->GetID();
+    }
+    return cfd_a->user_comparator()->Compare(keys[a], keys[b]) < 0;
+  });
 #ifdef BOOSTLIB
   if (read_options.aio_concurrency && immutable_db_options_.use_aio_reads) {
 #if 0
@@ -1970,7 +2378,7 @@ std::vector<Status> DBImpl::MultiGet(
 #else
     auto tls = &gt_fibers;
     tls->update_fiber_count(read_options.aio_concurrency);
-    for (size_t i = 0; i < num_keys; ++i) {
+    for (size_t i : key_order) {
       tls->push([&, i]() { get_one(i); });
     }
     while (counting) {
@@ -1980,33 +2388,108 @@ std::vector<Status> DBImpl::MultiGet(
 #endif
   } else {
 #endif
-    for (size_t i = 0; i < num_keys; ++i) {
-      get_one(i);
+    // Keys missing the memtables are looked up in batch by version, keys
+    // in the same SST then share its filter, index and data block reads
+    std::vector<size_t> missed;
+    for (size_t i : key_order) {
+      if (get_from_memtable(i)) {
+        finish_one(i);
+      } else {
+        missed.push_back(i);
+      }
+    }
+    if (!missed.empty()) {
+      PERF_TIMER_GUARD(get_from_output_files_time);
+      std::unordered_map<Version*, std::vector<Version::GetRequest>>
+          version_requests;
+      for (size_t i : missed) {
+        version_requests[super_version_of(i)->current].push_back(
+            {keys[i], lkeys[i].get(), &lazy_vals[i], &stat_list[i],
+             &merge_contexts[i], &max_covering_tombstone_seqs[i], nullptr,
+             &value_projected[i]});
+      }
+      for (auto& pair : version_requests) {
+        pair.first->MultiGet(read_options, pair.second);
+      }
+    }
+    for (size_t i : missed) {
+      finish_one(i);
     }
 #ifdef BOOSTLIB
   }
 #endif
 
+  if (!pending_values.empty()) {
+    PERF_TIMER_GUARD(get_from_output_files_time);
+    struct VersionFetch {
+      std::vector<size_t> pending;
+      std::vector<LazyBuffer*> values;
+      std::vector<Status> statuses;
+    };
+    std::unordered_map<Version*, VersionFetch> version_fetch;
+    for (size_t j = 0; j < pending_values.size(); ++j) {
+      auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(
+          column_family[pending_values[j].first]);
+      auto mgd = multiget_cf_data.find(cfh->cfd()->GetID())->second;
+      auto& fetch = version_fetch[mgd->super_version->current];
+      fetch.pending.emplace_back(j);
+      fetch.values.emplace_back(&pending_values[j].second);
+    }
+    Version::FetchExecutor executor;
+#ifdef BOOSTLIB
+    // Run each blob SST group on its own fiber, so aio reads of different
+    // blob SSTs are in flight together instead of one after another
+    size_t fetching = 0;
+    if (read_options.aio_concurrency && immutable_db_options_.use_aio_reads) {
+      executor = [&fetching](std::function<void()>&& task) {
+        ++fetching;
+        gt_fibers.push([&fetching, task = std::move(task)]() {
+          task();
+          --fetching;
+        });
+      };
+    }
+#endif
+    for (auto& pair : version_fetch) {
+      pair.first->MultiFetch(pair.second.values, &pair.second.statuses,
+                             executor);
+    }
+#ifdef BOOSTLIB
+    while (fetching) {
+      gt_fibers.m_fy.unchecked_yield();
+    }
+#endif
+    for (auto& pair : version_fetch) {
+      auto& fetch = pair.second;
+      for (size_t k = 0; k < fetch.pending.size(); ++k) {
+        auto& pending = pending_values[fetch.pending[k]];
+        std::string* value = &(*values)[pending.first];
+        Status& s = stat_list[pending.first];
+        s = std::move(fetch.statuses[k]);
+        if (s.ok()) {
+          s = project(pending.first, &pending.second);
+        }
+        if (s.ok()) {
+          s = std::move(pending.second).dump(value);
+        }
+        if (s.ok()) {
+          bytes_read += value->size();
+          num_found++;
+        }
+      }
+    }
+  }
+
   // Post processing (decrement reference counts and record statistics)
   PERF_TIMER_GUARD(get_post_process_time);
-  autovector<SuperVersion*> superversions_to_delete;
-
-  // TODO(icanadi) do we need lock here or just around Cleanup()?
-  mutex_.Lock();
   for (auto mgd_iter : multiget_cf_data) {
     auto mgd = mgd_iter.second;
-    if (mgd->super_version->Unref()) {
-      mgd->super_version->Cleanup();
-      superversions_to_delete.push_back(mgd->super_version);
+    if (thread_local_sv) {
+      ReturnAndCleanupSuperVersion(mgd->cfd, mgd->super_version);
+    } else {
+      CleanupSuperVersion(mgd->super_version);
     }
-  }
-  mutex_.Unlock();
-
-  for (auto td : superversions_to_delete) {
-    delete td;
-  }
-  for (auto mgd : multiget_cf_data) {
-    delete mgd.second;
+    delete mgd;
   }
 
   RecordTick(stats_, NUMBER_MULTIGET_CALLS);
@@ -2020,6 +2503,147 @@ std::vector<Status> DBImpl::MultiGet(
   return stat_list;
 }  // namespace TERARKDB_NAMESPACE
 
+std::vector<Status> DBImpl::MultiGetSeqno(
+    const ReadOptions& read_options,
+    const std::vector<ColumnFamilyHandle*>& column_family,
+    const std::vector<Slice>& keys, std::vector<EntrySeqno>* entries) {
+  const size_t num_keys = keys.size();
+  std::vector<Status> stat_list(num_keys);
+  entries->assign(num_keys, EntrySeqno());
+
+  struct SeqnoColumnFamilyData {
+    ColumnFamilyData* cfd;
+    SuperVersion* super_version;
+    std::vector<size_t> indexes;
+    std::vector<Slice> keys;
+  };
+  std::unordered_map<uint32_t, SeqnoColumnFamilyData> cf_data;
+  for (size_t i = 0; i < num_keys; ++i) {
+    auto cfd =
+        reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i])->cfd();
+    auto& data = cf_data[cfd->GetID()];
+    data.cfd = cfd;
+    data.indexes.push_back(i);
+    data.keys.push_back(keys[i]);
+  }
+  for (auto& pair : cf_data) {
+    pair.second.super_version = GetAndRefSuperVersion(pair.second.cfd);
+  }
+  SequenceNumber snapshot;
+  if (read_options.snapshot != nullptr) {
+    snapshot =
+        reinterpret_cast<const SnapshotImpl*>(read_options.snapshot)->number_;
+  } else {
+    snapshot = last_seq_same_as_publish_seq_
+                   ? versions_->LastSequence()
+                   : versions_->LastPublishedSequence();
+  }
+
+  std::vector<SequenceNumber> seqs;
+  std::vector<Status> statuses;
+  for (auto& pair : cf_data) {
+    auto& data = pair.second;
+    GetSeqnoImpl(data.super_version, read_options, snapshot, data.keys,
+                 false /* cache_only */, &seqs, &statuses);
+    for (size_t k = 0; k < data.indexes.size(); ++k) {
+      size_t i = data.indexes[k];
+      EntrySeqno& entry = (*entries)[i];
+      if (statuses[k].ok() || statuses[k].IsNotFound()) {
+        entry.found = seqs[k] != kMaxSequenceNumber;
+        entry.deleted = entry.found && statuses[k].IsNotFound();
+        entry.seqno = entry.found ? seqs[k] : 0;
+      } else {
+        stat_list[i] = statuses[k];
+      }
+    }
+    ReturnAndCleanupSuperVersion(data.cfd, data.super_version);
+  }
+  return stat_list;
+}
+
+Status DBImpl::GetSeqnoImpl(SuperVersion* sv, const ReadOptions& read_options,
+                            SequenceNumber snapshot,
+                            const std::vector<Slice>& keys, bool cache_only,
+                            std::vector<SequenceNumber>* seqs,
+                            std::vector<Status>* statuses) {
+  const size_t num_keys = keys.size();
+  std::vector<std::unique_ptr<LookupKey>> lkeys(num_keys);
+  std::vector<MergeContext> merge_contexts(num_keys);
+  std::vector<SequenceNumber> max_covering_tombstone_seqs(num_keys, 0);
+  std::vector<size_t> missed;
+  seqs->assign(num_keys, kMaxSequenceNumber);
+  statuses->assign(num_keys, Status::OK());
+  Status result;
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    lkeys[i].reset(new LookupKey(keys[i], snapshot));
+    Status& s = (*statuses)[i];
+    SequenceNumber* seq = &(*seqs)[i];
+    // The latest memtable, then the immutable ones, then their history
+    sv->mem->Get(*lkeys[i], nullptr, &s, &merge_contexts[i],
+                 &max_covering_tombstone_seqs[i], seq, read_options,
+                 nullptr /*read_callback*/);
+    if (*seq == kMaxSequenceNumber &&
+        (s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
+      sv->imm->Get(*lkeys[i], nullptr, &s, &merge_contexts[i],
+                   &max_covering_tombstone_seqs[i], seq, read_options,
+                   nullptr /*read_callback*/);
+    }
+    if (*seq == kMaxSequenceNumber &&
+        (s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
+      sv->imm->GetFromHistory(*lkeys[i], nullptr, &s, &merge_contexts[i],
+                              &max_covering_tombstone_seqs[i], seq,
+                              read_options);
+    }
+    if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
+      // unexpected error reading memtable.
+      ROCKS_LOG_ERROR(immutable_db_options_.info_log,
+                      "Unexpected status returned from MemTable::Get: %s\n",
+                      s.ToString().c_str());
+      if (result.ok()) {
+        result = s;
+      }
+      continue;
+    }
+    if (*seq == kMaxSequenceNumber) {
+      s = Status::OK();
+      missed.push_back(i);
+    }
+  }
+  if (cache_only || missed.empty()) {
+    return result;
+  }
+
+  // Version::MultiGet takes the keys in order, the ones in the same SST then
+  // share its filter, index and data block reads
+  const Comparator* ucmp = sv->current->cfd()->user_comparator();
+  std::sort(missed.begin(), missed.end(), [&](size_t a, size_t b) {
+    return ucmp->Compare(keys[a], keys[b]) < 0;
+  });
+  std::vector<Version::GetRequest> requests;
+  requests.reserve(missed.size());
+  for (size_t i : missed) {
+    requests.push_back({keys[i], lkeys[i].get(), nullptr /* value */,
+                        &(*statuses)[i], &merge_contexts[i],
+                        &max_covering_tombstone_seqs[i], &(*seqs)[i]});
+  }
+  sv->current->MultiGet(read_options, requests);
+  for (size_t i : missed) {
+    const Status& s = (*statuses)[i];
+    if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
+      // unexpected error reading SST files
+      ROCKS_LOG_ERROR(immutable_db_options_.info_log,
+                      "Unexpected status returned from Version::MultiGet: %s\n",
+                      s.ToString().c_str());
+      if (result.ok()) {
+        result = s;
+      }
+    }
+  }
+  return result;
+}
+
+
 Status DBImpl::CreateColumnFamily(const ColumnFamilyOptions& cf_options,
                                   const std::string& column_family,
                                   ColumnFamilyHandle** handle) {
@@ -2389,6 +3013,8 @@ bool DBImpl::KeyMayExist(const ReadOptions& read_options,
   auto s = GetImpl(roptions, column_family, key, &lazy_val, value_found);
   if (s.ok()) {
     s = std::move(lazy_val).dump(value);
+  } else if (s.IsIncomplete() && value_found != nullptr) {
+    *value_found = false;
   }
 
   // If block_cache is enabled and the index block of the table didn't
@@ -2574,39 +3200,43 @@ const Snapshot* DBImpl::GetSnapshotForWriteConflictBoundary() {
 SnapshotImpl* DBImpl::GetSnapshotImpl(bool is_write_conflict_boundary) {
   int64_t unix_time = 0;
   env_->GetCurrentTime(&unix_time);  // Ignore error
-  SnapshotImpl* s = new SnapshotImpl;
-
-  InstrumentedMutexLock l(&mutex_);
   // returns null if the underlying memtable does not support snapshot.
-  if (!is_snapshot_supported_) {
-    delete s;
+  if (!is_snapshot_supported_.load(std::memory_order_acquire)) {
     return nullptr;
   }
-  auto snapshot_seq = last_seq_same_as_publish_seq_
-                          ? versions_->LastSequence()
-                          : versions_->LastPublishedSequence();
-  return snapshots_.New(s, snapshot_seq, unix_time, is_write_conflict_boundary);
+  // The DB mutex is not needed, the snapshot list orders the sequence number
+  // with the flushes and compactions reading it
+  SnapshotImpl* s = new SnapshotImpl;
+  return snapshots_.New(
+      s,
+      [this] {
+        return last_seq_same_as_publish_seq_
+                   ? versions_->LastSequence()
+                   : versions_->LastPublishedSequence();
+      },
+      unix_time, is_write_conflict_boundary);
 }
 
 void DBImpl::ReleaseSnapshot(const Snapshot* s) {
   const SnapshotImpl* casted_s = reinterpret_cast<const SnapshotImpl*>(s);
-  {
+  snapshots_.Delete(casted_s);
+  // Only releasing the oldest snapshot may let the bottommost files be
+  // compacted, the others don't need the DB mutex
+  if (casted_s->number_ < snapshots_.GetOldest()) {
     InstrumentedMutexLock l(&mutex_);
-    snapshots_.Delete(casted_s);
-    uint64_t oldest_snapshot;
-    if (snapshots_.empty()) {
+    uint64_t oldest_snapshot = snapshots_.GetOldest();
+    if (oldest_snapshot == kMaxSequenceNumber) {
       oldest_snapshot = last_seq_same_as_publish_seq_
                             ? versions_->LastSequence()
                             : versions_->LastPublishedSequence();
-    } else {
-      oldest_snapshot = snapshots_.oldest()->number_;
     }
     for (auto* cfd : *versions_->GetColumnFamilySet()) {
-      cfd->current()->storage_info()->UpdateOldestSnapshot(oldest_snapshot);
-      if (!cfd->current()
-               ->storage_info()
-               ->BottommostFilesMarkedForCompaction()
-               .empty()) {
+      auto* vstorage = cfd->current()->storage_info();
+      // Concurrent releases may get here out of order
+      if (oldest_snapshot > vstorage->oldest_snapshot_seqnum()) {
+        vstorage->UpdateOldestSnapshot(oldest_snapshot);
+      }
+      if (!vstorage->BottommostFilesMarkedForCompaction().empty()) {
         SchedulePendingCompaction(cfd);
         SchedulePendingGarbageCollection(cfd);
         MaybeScheduleFlushOrCompaction();
@@ -2781,6 +3411,72 @@ bool DBImpl::GetPropertyHandleOptionsStatistics(std::string* value) {
   return true;
 }
 
+bool DBImpl::GetPropertyHandleIOProfile(std::string* value) {
+  assert(value != nullptr);
+  return env_->GetIOProfile(value).ok();
+}
+
+bool DBImpl::GetPropertyHandleHotKeys(std::string* value) {
+  assert(value != nullptr);
+  if (!immutable_db_options_.hot_key_tracker) {
+    return false;
+  }
+  HotKeysInfo info;
+  GetHotKeys(&info);
+  char buf[256];
+  snprintf(buf, sizeof(buf), "Hot keys (estimated total %" PRIu64 "):\n",
+           info.total_keys);
+  value->append(buf);
+  for (auto& key : info.keys) {
+    snprintf(buf, sizeof(buf), "%" PRIu64 " [%s] ", key.count,
+             key.cf_name.c_str());
+    value->append(buf);
+    value->append(Slice(key.key).ToString(true /* hex */));
+    value->append("\n");
+  }
+  snprintf(buf, sizeof(buf), "Hot blocks (estimated total %" PRIu64 "):\n",
+           info.total_blocks);
+  value->append(buf);
+  for (auto& block : info.blocks) {
+    snprintf(buf, sizeof(buf),
+             "%" PRIu64 " file %" PRIu64 " offset %" PRIu64 "\n", block.count,
+             block.file_number, block.offset);
+    value->append(buf);
+  }
+  return true;
+}
+
+void DBImpl::GetHotKeys(HotKeysInfo* info) {
+  assert(immutable_db_options_.hot_key_tracker);
+  immutable_db_options_.hot_key_tracker->GetHotKeys(info);
+  info->db_name = dbname_;
+  InstrumentedMutexLock l(&mutex_);
+  for (auto& key : info->keys) {
+    auto cfd = versions_->GetColumnFamilySet()->GetColumnFamily(key.cf_id);
+    if (cfd != nullptr && !cfd->IsDropped()) {
+      key.cf_name = cfd->GetName();
+    }
+  }
+}
+
+void DBImpl::ReportHotKeys() {
+  if (!immutable_db_options_.hot_key_tracker) {
+    return;
+  }
+#ifndef ROCKSDB_LITE
+  if (!immutable_db_options_.listeners.empty()) {
+    HotKeysInfo info;
+    GetHotKeys(&info);
+    if (!info.keys.empty() || !info.blocks.empty()) {
+      for (auto& listener : immutable_db_options_.listeners) {
+        listener->OnHotKeysDetected(info);
+      }
+    }
+  }
+#endif  // !ROCKSDB_LITE
+  immutable_db_options_.hot_key_tracker->Decay();
+}
+
 #ifndef ROCKSDB_LITE
 Status DBImpl::ResetStats() {
   InstrumentedMutexLock l(&mutex_);
@@ -2856,8 +3552,15 @@ void DBImpl::CleanupSuperVersion(SuperVersion* sv) {
 
 void DBImpl::ReturnAndCleanupSuperVersion(ColumnFamilyData* cfd,
                                           SuperVersion* sv) {
-  if (!cfd->ReturnThreadLocalSuperVersion(sv)) {
-    CleanupSuperVersion(sv);
+  cfd->ReturnThreadLocalSuperVersion(sv);
+  // The SuperVersions replaced while readers were in their epochs are
+  // released by the readers leaving last
+  if (cfd->HasRetiredSuperVersions()) {
+    autovector<SuperVersion*> expired;
+    cfd->PopExpiredSuperVersions(&expired);
+    for (auto expired_sv : expired) {
+      CleanupSuperVersion(expired_sv);
+    }
   }
 }
 
@@ -3586,12 +4289,6 @@ void DB::GetAsync(const ReadOptions& ro, ColumnFamilyHandle* cfh,
   });
 }
 
-void DB::GetAsync(const ReadOptions& ro, std::string key, std::string* value,
-                  GetAsyncCallback cb) {
-  using std::move;
-  GetAsync(ro, DefaultColumnFamily(), move(key), value, move(cb));
-}
-
 void DB::GetAsync(const ReadOptions& ro, ColumnFamilyHandle* cfh,
                   std::string key, GetAsyncCallback cb) {
   using namespace boost::fibers;
@@ -3605,9 +4302,45 @@ void DB::GetAsync(const ReadOptions& ro, ColumnFamilyHandle* cfh,
   });
 }
 
-void DB::GetAsync(const ReadOptions& ro, std::string key, GetAsyncCallback cb) {
-  using std::move;
-  GetAsync(ro, DefaultColumnFamily(), move(key), move(cb));
+void DB::MultiGetAsync(const ReadOptions& ro,
+                       const std::vector<ColumnFamilyHandle*>& column_family,
+                       std::vector<std::string> keys,
+                       std::vector<std::string>* values,
+                       MultiGetAsyncCallback cb) {
+  assert(column_family.size() == keys.size());
+  // Shared by the tasks of the keys, which all run on the fibers of this
+  // thread, the last one calls cb
+  struct State {
+    ReadOptions ro;
+    std::vector<std::string> keys;
+    std::vector<Status> statuses;
+    size_t pending;
+    MultiGetAsyncCallback cb;
+  };
+  auto state = std::make_shared<State>();
+  state->ro = ro;
+  state->keys = std::move(keys);
+  state->statuses.resize(state->keys.size());
+  state->pending = state->keys.size();
+  state->cb = std::move(cb);
+  values->resize(state->keys.size());
+  auto tls = &gt_fibers;
+  tls->update_fiber_count(ro.aio_concurrency);
+  if (state->keys.empty()) {
+    tls->push([state, values]() {
+      state->cb(std::move(state->statuses), std::move(state->keys), values);
+    });
+    return;
+  }
+  for (size_t i = 0; i < state->keys.size(); ++i) {
+    tls->push([this, cfh = column_family[i], state, values, i]() {
+      state->statuses[i] =
+          this->Get(state->ro, cfh, state->keys[i], &(*values)[i]);
+      if (--state->pending == 0) {
+        state->cb(std::move(state->statuses), std::move(state->keys), values);
+      }
+    });
+  }
 }
 
 ///@returns == 0 indicate there is nothing to wait
@@ -3618,8 +4351,72 @@ void DB::GetAsync(const ReadOptions& ro, std::string key, GetAsyncCallback cb) {
 int DB::WaitAsync(int timeout_us) { return gt_fibers.wait(timeout_us); }
 
 int DB::WaitAsync() { return gt_fibers.wait(); }
+#else
+void DB::CallOnMainStack(const std::function<void()>& fn) { fn(); }
+
+void DB::SubmitAsyncTask(std::function<void()> fn) { fn(); }
+
+void DB::SubmitAsyncTask(std::function<void()> fn,
+                         size_t /*aio_concurrency*/) {
+  fn();
+}
+
+bool DB::TrySubmitAsyncTask(const std::function<void()>& fn) {
+  fn();
+  return true;
+}
+
+bool DB::TrySubmitAsyncTask(const std::function<void()>& fn,
+                            size_t /*aio_concurrency*/) {
+  fn();
+  return true;
+}
+
+void DB::GetAsync(const ReadOptions& ro, ColumnFamilyHandle* cfh,
+                  std::string key, std::string* value, GetAsyncCallback cb) {
+  Status s = Get(ro, cfh, key, value);
+  cb(std::move(s), std::move(key), value);
+}
+
+void DB::GetAsync(const ReadOptions& ro, ColumnFamilyHandle* cfh,
+                  std::string key, GetAsyncCallback cb) {
+  std::string value;
+  Status s = Get(ro, cfh, key, &value);
+  cb(std::move(s), std::move(key), &value);
+}
+
+void DB::MultiGetAsync(const ReadOptions& ro,
+                       const std::vector<ColumnFamilyHandle*>& column_family,
+                       std::vector<std::string> keys,
+                       std::vector<std::string>* values,
+                       MultiGetAsyncCallback cb) {
+  std::vector<Slice> key_slices(keys.begin(), keys.end());
+  auto statuses = MultiGet(ro, column_family, key_slices, values);
+  cb(std::move(statuses), std::move(keys), values);
+}
+
+int DB::WaitAsync(int /*timeout_us*/) { return 0; }
+
+int DB::WaitAsync() { return 0; }
 #endif  // BOOSTLIB
 
+void DB::GetAsync(const ReadOptions& ro, std::string key, std::string* value,
+                  GetAsyncCallback cb) {
+  GetAsync(ro, DefaultColumnFamily(), std::move(key), value, std::move(cb));
+}
+
+void DB::GetAsync(const ReadOptions& ro, std::string key, GetAsyncCallback cb) {
+  GetAsync(ro, DefaultColumnFamily(), std::move(key), std::move(cb));
+}
+
+void DB::MultiGetAsync(const ReadOptions& ro, std::vector<std::string> keys,
+                       std::vector<std::string>* values,
+                       MultiGetAsyncCallback cb) {
+  std::vector<ColumnFamilyHandle*> column_family(keys.size(),
+                                                 DefaultColumnFamily());
+  MultiGetAsync(ro, column_family, std::move(keys), values, std::move(cb));
+}
+
 // using future needs boost symbols to be exported, but we don't want to
 // export boost symbols
 #if defined(TERARKDB_WITH_AIO_FUTURE)
@@ -4112,6 +4909,15 @@ Status DBImpl::GetLatestSequenceForKey(SuperVersion* sv, const Slice& key,
   return s;
 }
 
+Status DBImpl::GetLatestSequenceForKeys(SuperVersion* sv,
+                                        const std::vector<Slice>& keys,
+                                        bool cache_only,
+                                        std::vector<SequenceNumber>* seqs) {
+  std::vector<Status> statuses;
+  return GetSeqnoImpl(sv, ReadOptions(), versions_->LastSequence(), keys,
+                      cache_only, seqs, &statuses);
+}
+
 Status DBImpl::IngestExternalFile(
     ColumnFamilyHandle* column_family,
     const std::vector<std::string>& external_files,
@@ -4377,6 +5183,47 @@ Status DBImpl::EndTrace() {
   return s;
 }
 
+Status DBImpl::StartPerfTrace(const PerfTraceOptions& options,
+                              std::unique_ptr<TraceWriter>&& trace_writer) {
+  if (options.sample_rate == 0) {
+    return Status::InvalidArgument("sample_rate must be positive");
+  }
+  InstrumentedMutexLock lock(&trace_mutex_);
+  if (perf_tracer_ != nullptr) {
+    return Status::Busy("A perf trace is running");
+  }
+  perf_tracer_ =
+      std::make_shared<PerfTracer>(env_, options, std::move(trace_writer));
+  perf_trace_sample_rate_.store(options.sample_rate, std::memory_order_relaxed);
+  return Status::OK();
+}
+
+Status DBImpl::EndPerfTrace() {
+  std::shared_ptr<PerfTracer> tracer;
+  {
+    InstrumentedMutexLock lock(&trace_mutex_);
+    if (perf_tracer_ == nullptr) {
+      return Status::NotFound("No perf trace is running");
+    }
+    perf_trace_sample_rate_.store(0, std::memory_order_relaxed);
+    tracer.swap(perf_tracer_);
+  }
+  // Sampled operations still running keep adding to the tracer, the samples
+  // after Close() are dropped
+  return tracer->Close();
+}
+
+Status DBImpl::StartTableAccessTrace(
+    const TableAccessTraceOptions& options,
+    std::unique_ptr<TraceWriter>&& trace_writer) {
+  return immutable_db_options_.table_access_tracer->StartTrace(
+      env_, options, std::move(trace_writer));
+}
+
+Status DBImpl::EndTableAccessTrace() {
+  return immutable_db_options_.table_access_tracer->EndTrace();
+}
+
 Status DBImpl::TraceIteratorSeek(const uint32_t& cf_id, const Slice& key) {
   Status s;
   if (tracer_) {
@@ -70,6 +70,7 @@ class ArenaWrappedDBIter;
 class InMemoryStatsHistoryIterator;
 class MemTable;
 class PersistentStatsHistoryIterator;
+class PersistentStatsRollup;
 class PeriodicWorkScheduler;
 #ifndef NDEBUG
 class PeriodicWorkTestScheduler;
@@ -134,6 +135,13 @@ class DBImpl : public DB {
       const std::vector<Slice>& keys,
       std::vector<std::string>* values) override;
 
+  using DB::MultiGetSeqno;
+  virtual std::vector<Status> MultiGetSeqno(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys,
+      std::vector<EntrySeqno>* entries) override;
+
   virtual Status CreateColumnFamily(const ColumnFamilyOptions& cf_options,
                                     const std::string& column_family,
                                     ColumnFamilyHandle** handle) override;
@@ -270,6 +278,11 @@ class DBImpl : public DB {
   Status GetStatsHistory(
       uint64_t start_time, uint64_t end_time,
       std::unique_ptr<StatsHistoryIterator>* stats_iterator) override;
+  Status GetStatsHistory(
+      uint64_t start_time, uint64_t end_time,
+      StatsHistoryGranularity granularity,
+      const std::vector<std::string>& stats_names,
+      std::unique_ptr<StatsHistoryIterator>* stats_iterator) override;
 #ifndef ROCKSDB_LITE
   using DB::ResetStats;
   virtual Status ResetStats() override;
@@ -355,6 +368,26 @@ class DBImpl : public DB {
                                  bool cache_only, SequenceNumber* seq,
                                  bool* found_record_for_key);
 
+  // GetLatestSequenceForKey() of a batch of keys. The keys not found in the
+  // memtables are looked up in the SST files through one Version::MultiGet,
+  // which reads the sequence of the latest record of a key but not its
+  // value. (*seqs)[i] is kMaxSequenceNumber if no record for keys[i] was
+  // found.
+  //
+  // Returns OK on success, other status on the first unexpected error.
+  Status GetLatestSequenceForKeys(SuperVersion* sv,
+                                  const std::vector<Slice>& keys,
+                                  bool cache_only,
+                                  std::vector<SequenceNumber>* seqs);
+
+  // The sequences of the latest entries of keys at snapshot, kMaxSequenceNumber
+  // for none. A status is NotFound for a deletion or no entry, OK for the
+  // others or an error. Returns the first error.
+  Status GetSeqnoImpl(SuperVersion* sv, const ReadOptions& read_options,
+                      SequenceNumber snapshot, const std::vector<Slice>& keys,
+                      bool cache_only, std::vector<SequenceNumber>* seqs,
+                      std::vector<Status>* statuses);
+
   using DB::IngestExternalFile;
   virtual Status IngestExternalFile(
       ColumnFamilyHandle* column_family,
@@ -370,6 +403,22 @@ class DBImpl : public DB {
 
   using DB::EndTrace;
   virtual Status EndTrace() override;
+
+  using DB::StartPerfTrace;
+  virtual Status StartPerfTrace(
+      const PerfTraceOptions& options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override;
+
+  using DB::EndPerfTrace;
+  virtual Status EndPerfTrace() override;
+
+  using DB::StartTableAccessTrace;
+  virtual Status StartTableAccessTrace(
+      const TableAccessTraceOptions& options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override;
+
+  using DB::EndTableAccessTrace;
+  virtual Status EndTableAccessTrace() override;
   Status TraceIteratorSeek(const uint32_t& cf_id, const Slice& key);
   Status TraceIteratorSeekForPrev(const uint32_t& cf_id, const Slice& key);
 #endif  // ROCKSDB_LITE
@@ -609,6 +658,16 @@ class DBImpl : public DB {
 
   const WriteController& write_controller() { return write_controller_; }
 
+  // The memtable quota of this DB in a fair share write buffer manager.
+  // Returns false if the manager does not share by ingest rate.
+  bool GetWriteBufferQuota(uint64_t* quota) const {
+    if (write_buffer_client_ == nullptr) {
+      return false;
+    }
+    *quota = write_buffer_manager_->ClientQuota(write_buffer_client_);
+    return true;
+  }
+
   InternalIterator* NewInternalIterator(
       const ReadOptions&, ColumnFamilyData* cfd, SuperVersion* super_version,
       Arena* arena, RangeDelAggregator* range_del_agg, SequenceNumber sequence,
@@ -806,6 +865,13 @@ class DBImpl : public DB {
 
   void ScheduleTtlGC();
 
+  // Rechecks bottommost files against cold_recompress_seconds
+  void ScheduleColdRecompress();
+
+  // Verifies the checksums of the next live files within the
+  // checksum_scrub_bytes_per_sec budget
+  void ScrubChecksums();
+
  protected:
   Env* const env_;
   const std::string dbname_;
@@ -824,6 +890,9 @@ class DBImpl : public DB {
       recovered_transactions_;
   std::unique_ptr<Tracer> tracer_;
   InstrumentedMutex trace_mutex_;
+  // Set along with perf_tracer_, 0 when no perf trace is running
+  std::atomic<uint32_t> perf_trace_sample_rate_;
+  std::shared_ptr<PerfTracer> perf_tracer_;
 
   // Except in DB::Open(), WriteOptionsFile can only be called when:
   // Persist options to options file.
@@ -939,8 +1008,10 @@ class DBImpl : public DB {
 
  private:
   friend class DB;
+  friend class DBImplSecondary;
   friend class ErrorHandler;
   friend class InternalStats;
+  friend class PerfTraceScope;
   friend class PessimisticTransaction;
   friend class TransactionBaseImpl;
   friend class WriteCommittedTxn;
@@ -1115,6 +1186,13 @@ class DBImpl : public DB {
   //            `num_bytes` going through.
   Status DelayWrite(uint64_t num_bytes, const WriteOptions& write_options);
 
+  // Adds the micros a write was delayed to the stall stats of the causes,
+  // which are pairs of column family id and the limit it hit
+  // REQUIRES: mutex_ is held
+  void RecordWriteStallCauses(
+      const autovector<std::pair<uint32_t, WriteStallCause>>& causes,
+      uint64_t micros);
+
   Status ThrottleLowPriWritesIfNeeded(const WriteOptions& write_options,
                                       WriteBatch* my_batch);
 
@@ -1170,16 +1248,26 @@ class DBImpl : public DB {
   // REQUIRES: mutex locked
   Status HandleWriteBufferFull(WriteContext* write_context);
 
+  // Whether the write buffer manager asks this DB to flush a memtable.
+  // REQUIRES: mutex locked
+  bool WriteBufferManagerShouldFlush();
+
   // REQUIRES: mutex locked
   Status PreprocessWrite(const WriteOptions& write_options, bool* need_log_sync,
                          WriteContext* write_context);
 
+  // Collects the WAL record of a write group into log_parts. A group of
+  // several batches is written as tmp_batch's header followed by the body of
+  // each batch, so the batches are never copied into one buffer. Returns the
+  // batch whose header leads the record.
   WriteBatch* MergeBatch(const WriteThread::WriteGroup& write_group,
                          WriteBatch* tmp_batch, size_t* write_with_wal,
-                         WriteBatch** to_be_cached_state);
+                         WriteBatch** to_be_cached_state,
+                         autovector<Slice>* log_parts);
 
-  Status WriteToWAL(const WriteBatch& merged_batch, log::Writer* log_writer,
-                    uint64_t* log_used, uint64_t* log_size);
+  Status WriteToWAL(const autovector<Slice>& log_parts,
+                    log::Writer* log_writer, uint64_t* log_used,
+                    uint64_t* log_size);
 
   Status WriteToWAL(const WriteThread::WriteGroup& write_group,
                     log::Writer* log_writer, uint64_t* log_used,
@@ -1231,6 +1319,12 @@ class DBImpl : public DB {
                             FlushRequest* req);
 
   void SchedulePendingFlush(const FlushRequest& req, FlushReason flush_reason);
+  // Queues again the flushes failed and left to be retried, see
+  // DBOptions::max_bgerror_resume_count
+  void ScheduleFlushRetries();
+  // Queues again the column families whose compactions or garbage
+  // collections failed and were left to be retried
+  void ScheduleCompactionRetries();
   void SchedulePendingCompaction(ColumnFamilyData* cfd);
   void SchedulePendingGarbageCollection(ColumnFamilyData* cfd);
   void SchedulePendingPurge(const std::string& fname,
@@ -1286,6 +1380,10 @@ class DBImpl : public DB {
 
   void AddToGarbageCollectionQueue(ColumnFamilyData* cfd);
   ColumnFamilyData* PopFirstFromGarbageCollectionQueue();
+  // Takes the next column family of the compaction or the garbage collection
+  // queue, see ColumnFamilyOptions::compaction_schedule_weight
+  ColumnFamilyData* PopFromScheduleQueue(std::deque<ColumnFamilyData*>* queue,
+                                         bool garbage_collection);
 
   FlushRequest PopFirstFromFlushQueue();
 
@@ -1443,7 +1541,7 @@ class DBImpl : public DB {
   // threads. Protected by db mutex.
   autovector<log::Writer*> logs_to_free_;
 
-  bool is_snapshot_supported_;
+  std::atomic<bool> is_snapshot_supported_;
 
   std::map<uint64_t, std::map<std::string, uint64_t>> stats_history_;
 
@@ -1451,6 +1549,9 @@ class DBImpl : public DB {
 
   bool stats_slice_initialized_ = false;
 
+  // Minute, hour and day rollups of persist_stats_to_disk
+  std::unique_ptr<PersistentStatsRollup> persist_stats_rollup_;
+
   // Class to maintain directories for all database paths other than main one.
   class Directories {
    public:
@@ -1478,6 +1579,9 @@ class DBImpl : public DB {
   Directories directories_;
 
   WriteBufferManager* write_buffer_manager_;
+  // Fair share account of this DB in write_buffer_manager_, nullptr if the
+  // manager does not share by ingest rate.
+  WriteBufferManager::Client* write_buffer_client_;
 
   WriteThread write_thread_;
   WriteBatch tmp_batch_;
@@ -1745,6 +1849,15 @@ class DBImpl : public DB {
                               const DBPropertyInfo& property_info,
                               bool is_locked, uint64_t* value);
   bool GetPropertyHandleOptionsStatistics(std::string* value);
+  bool GetPropertyHandleIOProfile(std::string* value);
+  bool GetPropertyHandleHotKeys(std::string* value);
+
+  // The heavy hitters of hot_key_tracker with their column family names
+  void GetHotKeys(HotKeysInfo* info);
+
+  // Reports the heavy hitters to the listeners and decays their counts,
+  // called by DumpStats()
+  void ReportHotKeys();
 
   bool HasPendingManualCompaction();
   bool HasExclusiveManualCompaction();
@@ -1764,6 +1877,13 @@ class DBImpl : public DB {
   PeriodicWorkScheduler* periodic_work_scheduler_;
 #endif
 
+  // Only touched by ScrubChecksums() on the scheduler thread. Files are
+  // scrubbed in file number order, a round ends when none is left past
+  // scrub_next_file_number_
+  uint64_t scrub_next_file_number_ = 0;
+  // Bytes left to scrub, negative after a file larger than the budget
+  int64_t scrub_credit_ = 0;
+
   // When set, we use a separate queue for writes that dont write to memtable.
   // In 2PC these are the writes at Prepare phase.
   const bool two_write_queues_;
@@ -1842,9 +1962,13 @@ class DBImpl : public DB {
   LatencyReporter next_latency_reporter_;
   LatencyReporter seekforprev_latency_reporter_;
   LatencyReporter prev_latency_reporter_;
+  LatencyReporter write_wal_latency_reporter_;
+  LatencyReporter wal_sync_latency_reporter_;
+  LatencyReporter write_memtable_latency_reporter_;
 
   ThroughputReporter write_throughput_reporter_;
   DistributionReporter write_batch_size_reporter_;
+  DistributionReporter write_group_size_reporter_;
 };
 
 extern Options SanitizeOptions(const std::string& db, const Options& src);
@@ -17,6 +17,7 @@
 #include "db/error_handler.h"
 #include "db/event_helpers.h"
 #include "db/map_builder.h"
+#include "monitoring/io_purpose.h"
 #include "monitoring/iostats_context_imp.h"
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/thread_status_updater.h"
@@ -1994,21 +1995,12 @@ void DBImpl::AddToCompactionQueue(ColumnFamilyData* cfd) {
   cfd->Ref();
   compaction_queue_.push_back(cfd);
   cfd->set_queued_for_compaction(true);
+  cfd->compaction_schedule()->skipped = 0;
 }
 
 ColumnFamilyData* DBImpl::PopFirstFromCompactionQueue() {
   assert(!compaction_queue_.empty());
-  auto max_iter = compaction_queue_.begin();
-  double max_load = (*max_iter)->current()->GetCompactionLoad();
-  for (auto it = std::next(max_iter); it != compaction_queue_.end(); ++it) {
-    double tmp_load = (*it)->current()->GetCompactionLoad();
-    if (max_load < tmp_load) {
-      max_load = tmp_load;
-      max_iter = it;
-    }
-  }
-  auto cfd = *max_iter;
-  compaction_queue_.erase(max_iter);
+  auto cfd = PopFromScheduleQueue(&compaction_queue_, false);
   assert(cfd->queued_for_compaction());
   cfd->set_queued_for_compaction(false);
   return cfd;
@@ -2019,27 +2011,70 @@ void DBImpl::AddToGarbageCollectionQueue(ColumnFamilyData* cfd) {
   cfd->Ref();
   garbage_collection_queue_.push_back(cfd);
   cfd->set_queued_for_garbage_collection(true);
+  cfd->garbage_collection_schedule()->skipped = 0;
 }
 
 ColumnFamilyData* DBImpl::PopFirstFromGarbageCollectionQueue() {
   assert(!garbage_collection_queue_.empty());
-  auto max_iter = garbage_collection_queue_.begin();
-  double max_load = (*max_iter)->current()->GetGarbageCollectionLoad();
-  for (auto it = std::next(max_iter); it != garbage_collection_queue_.end();
-       ++it) {
-    double tmp_load = (*it)->current()->GetGarbageCollectionLoad();
-    if (max_load < tmp_load) {
-      max_load = tmp_load;
-      max_iter = it;
-    }
-  }
-  auto cfd = *max_iter;
-  garbage_collection_queue_.erase(max_iter);
+  auto cfd = PopFromScheduleQueue(&garbage_collection_queue_, true);
   assert(cfd->queued_for_garbage_collection());
   cfd->set_queued_for_garbage_collection(false);
   return cfd;
 }
 
+ColumnFamilyData* DBImpl::PopFromScheduleQueue(
+    std::deque<ColumnFamilyData*>* queue, bool garbage_collection) {
+  auto get_schedule = [garbage_collection](ColumnFamilyData* cfd) {
+    return garbage_collection ? cfd->garbage_collection_schedule()
+                              : cfd->compaction_schedule();
+  };
+  uint64_t total_consumed = 0;
+  for (auto cfd : *queue) {
+    total_consumed += get_schedule(cfd)->consumed_bytes;
+  }
+  double mean_consumed =
+      std::max(1.0, static_cast<double>(total_consumed) / queue->size());
+
+  // Stall risk goes first. Then the score, scaled by the weight of the
+  // column family and down by its share of the recently consumed bytes. A
+  // column family passed over as many times as the queue is long is taken
+  // regardless, the one queued earliest first
+  auto pick_iter = queue->end();
+  double pick_load = 0;
+  double pick_score = 0;
+  for (auto it = queue->begin(); it != queue->end(); ++it) {
+    auto cfd = *it;
+    auto schedule = get_schedule(cfd);
+    if (schedule->skipped >= queue->size()) {
+      pick_iter = it;
+      break;
+    }
+    auto version = cfd->current();
+    double load, score;
+    if (garbage_collection) {
+      load = 0;
+      score = version->GetGarbageCollectionLoad();
+    } else {
+      load = version->GetCompactionLoad();
+      score = version->storage_info()->CompactionScore(0);
+    }
+    score *= cfd->GetLatestMutableCFOptions()->compaction_schedule_weight;
+    score /= 1 + schedule->consumed_bytes / mean_consumed;
+    if (pick_iter == queue->end() || pick_load < load ||
+        (pick_load == load && pick_score < score)) {
+      pick_iter = it;
+      pick_load = load;
+      pick_score = score;
+    }
+  }
+  auto cfd = *pick_iter;
+  queue->erase(pick_iter);
+  for (auto other : *queue) {
+    ++get_schedule(other)->skipped;
+  }
+  return cfd;
+}
+
 DBImpl::FlushRequest DBImpl::PopFirstFromFlushQueue() {
   assert(!flush_queue_.empty());
   FlushRequest flush_req = flush_queue_.front();
@@ -2065,6 +2100,44 @@ void DBImpl::SchedulePendingFlush(const FlushRequest& flush_req,
   flush_queue_.push_back(flush_req);
 }
 
+void DBImpl::ScheduleFlushRetries() {
+  mutex_.AssertHeld();
+  // The memtables of the failed flushes were rolled back, pending again
+  autovector<ColumnFamilyData*> cfds;
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (!cfd->IsDropped() && cfd->imm()->IsFlushPending() &&
+        !cfd->queued_for_flush()) {
+      cfds.push_back(cfd);
+    }
+  }
+  if (cfds.empty()) {
+    return;
+  }
+  if (immutable_db_options_.atomic_flush) {
+    FlushRequest flush_req;
+    GenerateFlushRequest(cfds, &flush_req);
+    SchedulePendingFlush(flush_req, cfds[0]->GetFlushReason());
+  } else {
+    for (auto cfd : cfds) {
+      FlushRequest flush_req;
+      GenerateFlushRequest({cfd}, &flush_req);
+      SchedulePendingFlush(flush_req, cfd->GetFlushReason());
+    }
+  }
+}
+
+void DBImpl::ScheduleCompactionRetries() {
+  mutex_.AssertHeld();
+  // A failed job took its column family off the queue, nothing else would
+  // queue it again before the next flush or version change
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (!cfd->IsDropped() && cfd->initialized()) {
+      SchedulePendingCompaction(cfd);
+      SchedulePendingGarbageCollection(cfd);
+    }
+  }
+}
+
 void DBImpl::SchedulePendingCompaction(ColumnFamilyData* cfd) {
   if (!cfd->queued_for_compaction() && cfd->NeedsCompaction()) {
     AddToCompactionQueue(cfd);
@@ -2093,6 +2166,7 @@ void DBImpl::SchedulePendingPurge(const std::string& fname,
 
 void DBImpl::BGWorkFlush(void* db) {
   IOSTATS_SET_THREAD_POOL_ID(Env::Priority::HIGH);
+  IOPurposeGuard io_purpose_guard(kIOPurposeFlush);
   TEST_SYNC_POINT("DBImpl::BGWorkFlush");
   reinterpret_cast<DBImpl*>(db)->BackgroundCallFlush();
   TEST_SYNC_POINT("DBImpl::BGWorkFlush:done");
@@ -2102,6 +2176,7 @@ void DBImpl::BGWorkCompaction(void* arg) {
   CompactionArg ca = *(reinterpret_cast<CompactionArg*>(arg));
   delete reinterpret_cast<CompactionArg*>(arg);
   IOSTATS_SET_THREAD_POOL_ID(Env::Priority::LOW);
+  IOPurposeGuard io_purpose_guard(kIOPurposeCompaction);
   TEST_SYNC_POINT("DBImpl::BGWorkCompaction");
   auto prepicked_compaction =
       static_cast<PrepickedCompaction*>(ca.prepicked_compaction);
@@ -2114,6 +2189,7 @@ void DBImpl::BGWorkGarbageCollection(void* arg) {
   CompactionArg ca = *(reinterpret_cast<CompactionArg*>(arg));
   delete reinterpret_cast<CompactionArg*>(arg);
   IOSTATS_SET_THREAD_POOL_ID(Env::Priority::LOW);
+  IOPurposeGuard io_purpose_guard(kIOPurposeGarbageCollection);
   TEST_SYNC_POINT("DBImpl::BGWorkGarbageCollection");
   reinterpret_cast<DBImpl*>(ca.db)->BackgroundCallGarbageCollection();
 }
@@ -2122,6 +2198,7 @@ void DBImpl::BGWorkBottomCompaction(void* arg) {
   CompactionArg ca = *(static_cast<CompactionArg*>(arg));
   delete static_cast<CompactionArg*>(arg);
   IOSTATS_SET_THREAD_POOL_ID(Env::Priority::BOTTOM);
+  IOPurposeGuard io_purpose_guard(kIOPurposeCompaction);
   TEST_SYNC_POINT("DBImpl::BGWorkBottomCompaction");
   auto* prepicked_compaction = ca.prepicked_compaction;
   assert(prepicked_compaction && prepicked_compaction->compaction &&
@@ -2268,6 +2345,9 @@ void DBImpl::BackgroundCallFlush() {
 
     Status s =
         BackgroundFlush(&made_progress, &job_context, &log_buffer, &reason);
+    if (s.ok() && made_progress) {
+      error_handler_.ResetRetries(BackgroundErrorReason::kFlush);
+    }
     if (!s.ok() && !s.IsShutdownInProgress() &&
         reason != FlushReason::kErrorRecovery) {
       // Wait a little bit before retrying background flush in
@@ -2276,6 +2356,8 @@ void DBImpl::BackgroundCallFlush() {
       // the problem.
       uint64_t error_cnt =
           default_cf_internal_stats_->BumpAndGetBackgroundErrorCount();
+      uint64_t wait_micros =
+          error_handler_.RetryWaitMicros(BackgroundErrorReason::kFlush);
       bg_cv_.SignalAll();  // In case a waiter can proceed despite the error
       mutex_.Unlock();
       ROCKS_LOG_ERROR(immutable_db_options_.info_log,
@@ -2284,8 +2366,12 @@ void DBImpl::BackgroundCallFlush() {
                       s.ToString().c_str(), error_cnt);
       log_buffer.FlushBufferToLog();
       LogFlush(immutable_db_options_.info_log);
-      env_->SleepForMicroseconds(1000000);
+      env_->SleepForMicroseconds(static_cast<int>(wait_micros));
       mutex_.Lock();
+      if (error_handler_.IsRetrying(BackgroundErrorReason::kFlush) &&
+          !error_handler_.IsBGWorkStopped()) {
+        ScheduleFlushRetries();
+      }
     }
 
     TEST_SYNC_POINT("DBImpl::BackgroundCallFlush:FlushFinish:0");
@@ -2351,6 +2437,9 @@ void DBImpl::BackgroundCallCompaction(PrepickedCompaction* prepicked_compaction,
     Status s = BackgroundCompaction(&made_progress, &job_context, &log_buffer,
                                     prepicked_compaction);
     TEST_SYNC_POINT("BackgroundCallCompaction:1");
+    if (s.ok() && made_progress) {
+      error_handler_.ResetRetries(BackgroundErrorReason::kCompaction);
+    }
     if (!s.ok() && !s.IsShutdownInProgress()) {
       // Wait a little bit before retrying background compaction in
       // case this is an environmental problem and we do not want to
@@ -2358,6 +2447,8 @@ void DBImpl::BackgroundCallCompaction(PrepickedCompaction* prepicked_compaction,
       // the problem.
       uint64_t error_cnt =
           default_cf_internal_stats_->BumpAndGetBackgroundErrorCount();
+      uint64_t wait_micros =
+          error_handler_.RetryWaitMicros(BackgroundErrorReason::kCompaction);
       bg_cv_.SignalAll();  // In case a waiter can proceed despite the error
       mutex_.Unlock();
       log_buffer.FlushBufferToLog();
@@ -2366,8 +2457,12 @@ void DBImpl::BackgroundCallCompaction(PrepickedCompaction* prepicked_compaction,
                       "Accumulated background error counts: %" PRIu64,
                       s.ToString().c_str(), error_cnt);
       LogFlush(immutable_db_options_.info_log);
-      env_->SleepForMicroseconds(1000000);
+      env_->SleepForMicroseconds(static_cast<int>(wait_micros));
       mutex_.Lock();
+      if (error_handler_.IsRetrying(BackgroundErrorReason::kCompaction) &&
+          !error_handler_.IsBGWorkStopped()) {
+        ScheduleCompactionRetries();
+      }
     }
 
     ReleaseFileNumberFromPendingOutputs(pending_outputs_inserted_elem);
@@ -2450,6 +2545,9 @@ void DBImpl::BackgroundCallGarbageCollection() {
     Status s =
         BackgroundGarbageCollection(&made_progress, &job_context, &log_buffer);
     TEST_SYNC_POINT("BackgroundCallGarbageCollection:1");
+    if (s.ok() && made_progress) {
+      error_handler_.ResetRetries(BackgroundErrorReason::kCompaction);
+    }
     if (!s.ok() && !s.IsShutdownInProgress()) {
       // Wait a little bit before retrying background garbage collection in
       // case this is an environmental problem and we do not want to
@@ -2457,6 +2555,8 @@ void DBImpl::BackgroundCallGarbageCollection() {
       // the problem.
       uint64_t error_cnt =
           default_cf_internal_stats_->BumpAndGetBackgroundErrorCount();
+      uint64_t wait_micros =
+          error_handler_.RetryWaitMicros(BackgroundErrorReason::kCompaction);
       bg_cv_.SignalAll();  // In case a waiter can proceed despite the error
       mutex_.Unlock();
       log_buffer.FlushBufferToLog();
@@ -2465,8 +2565,12 @@ void DBImpl::BackgroundCallGarbageCollection() {
                       "Accumulated background error counts: %" PRIu64,
                       s.ToString().c_str(), error_cnt);
       LogFlush(immutable_db_options_.info_log);
-      env_->SleepForMicroseconds(1000000);
+      env_->SleepForMicroseconds(static_cast<int>(wait_micros));
       mutex_.Lock();
+      if (error_handler_.IsRetrying(BackgroundErrorReason::kCompaction) &&
+          !error_handler_.IsBGWorkStopped()) {
+        ScheduleCompactionRetries();
+      }
     }
 
     ReleaseFileNumberFromPendingOutputs(pending_outputs_inserted_elem);
@@ -2842,6 +2946,8 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
     TEST_SYNC_POINT("DBImpl::BackgroundCompaction:NonTrivial:AfterRun");
     mutex_.Lock();
     bg_compaction_scheduled_ -= sub_compaction_scheduled;
+    c->column_family_data()->compaction_schedule()->Consume(
+        c->CalculateTotalInputSize());
     status = compaction_job.Install(*c->mutable_cf_options());
     if (status.ok()) {
       InstallSuperVersionAndScheduleWork(
@@ -3049,9 +3155,14 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
     output_level = c->output_level();
     TEST_SYNC_POINT_CALLBACK("DBImpl::BackgroundGarbageCollection:NonTrivial",
                              &output_level);
-    SequenceNumber earliest_write_conflict_snapshot = kMaxSequenceNumber;
-    std::vector<SequenceNumber> snapshot_seqs;
-    auto snapshot_checker = DisableGCSnapshotChecker::Instance();
+    // The snapshots tell GC which shadowed versions are still read
+    SequenceNumber earliest_write_conflict_snapshot;
+    std::vector<SequenceNumber> snapshot_seqs =
+        snapshots_.GetAll(&earliest_write_conflict_snapshot);
+    auto snapshot_checker = snapshot_checker_.get();
+    if (use_custom_gc_ && snapshot_checker == nullptr) {
+      snapshot_checker = DisableGCSnapshotChecker::Instance();
+    }
 
     CompactionJob garbage_collection_job(
         job_context->job_id, c.get(), immutable_db_options_,
@@ -3063,7 +3174,9 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
         &event_logger_, c->mutable_cf_options()->paranoid_file_checks,
         c->mutable_cf_options()->report_bg_io_stats, dbname_,
         &garbage_collection_job_stats);
-    garbage_collection_job.Prepare(0 /* sub_compaction_slots */);
+    int sub_compaction_scheduled = garbage_collection_job.Prepare(
+        GetSubCompactionSlots(c->max_subcompactions()));
+    bg_compaction_scheduled_ += sub_compaction_scheduled;
     NotifyOnCompactionBegin(c->column_family_data(), c.get(), status,
                             garbage_collection_job_stats, job_context->job_id);
 
@@ -3071,6 +3184,9 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
     garbage_collection_job.Run();
     TEST_SYNC_POINT("DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun");
     mutex_.Lock();
+    bg_compaction_scheduled_ -= sub_compaction_scheduled;
+    c->column_family_data()->garbage_collection_schedule()->Consume(
+        c->CalculateTotalInputSize());
     status = garbage_collection_job.Install(*c->mutable_cf_options());
     if (status.ok()) {
       InstallSuperVersionAndScheduleWork(
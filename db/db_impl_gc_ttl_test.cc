@@ -100,6 +100,48 @@ TEST_F(DBImplGCTTL_Test, BlockBasedTableTest) {
   run();
   read();
 }
+
+TEST_F(DBImplGCTTL_Test, DropPassedTtlWindow) {
+  init();
+  options.env = mock_env_.get();
+  options.disable_auto_compactions = true;
+  options.ttl_window_seconds = 100;
+  SetUp();
+  mock_env_->set_current_time(1000);
+  Reopen(options);
+  int drop = 0;
+  SyncPoint::GetInstance()->SetCallBack("DBImpl:ScheduleTtlGC-drop",
+                                        [&](void* /*arg*/) { drop++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // The first half of the keys expires in the window [1100, 1200), the
+  // second half in [1200, 1300)
+  for (int i = 0; i < 200; i++) {
+    char ts_string[8];
+    EncodeFixed64(ts_string, i < 100 ? 1150 : 1250);
+    std::string key = "key";
+    AppendNumberTo(&key, 1000 + i);
+    ASSERT_OK(Put(key, "value" + ToString(i) + std::string(ts_string, 8)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ("0,2", FilesPerLevel());
+
+  // Windows that have not passed are neither dropped nor marked
+  dbfull()->TEST_WaitForStatsDumpRun(
+      [&] { mock_env_->set_current_time(1199); });
+  ASSERT_EQ(0, drop);
+  ASSERT_EQ("0,2", FilesPerLevel());
+
+  dbfull()->TEST_WaitForStatsDumpRun(
+      [&] { mock_env_->set_current_time(1200); });
+  ASSERT_EQ(1, drop);
+  ASSERT_EQ("0,1", FilesPerLevel());
+  ASSERT_EQ("NOT_FOUND", Get("key1000"));
+  ASSERT_NE("NOT_FOUND", Get("key1100"));
+  SyncPoint::GetInstance()->DisableProcessing();
+}
+
 #ifdef TERARK_ZIP
 TEST_F(DBImplGCTTL_Test, TerarkTableTest) {
   init();
@@ -13,6 +13,10 @@
 #endif
 #include <inttypes.h>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #include "db/builder.h"
 #include "db/error_handler.h"
 #include "db/map_builder.h"
@@ -22,10 +26,12 @@
 #include "rocksdb/wal_filter.h"
 #include "table/block_based_table_factory.h"
 #include "util/c_style_callback.h"
+#include "util/compression.h"
 #include "util/rate_limiter.h"
 #include "util/sst_file_manager_impl.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
+#include "utilities/trace/bytedance_metrics_reporter.h"
 #if !defined(_MSC_VER) && !defined(__APPLE__)
 #include <sys/unistd.h>
 #include <table/terark_zip_table.h>
@@ -65,6 +71,10 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
     result.write_buffer_manager.reset(
         new WriteBufferManager(result.db_write_buffer_size));
   }
+  if (!result.metrics_reporter_factory) {
+    result.metrics_reporter_factory =
+        std::make_shared<ByteDanceMetricsReporterFactory>();
+  }
   auto bg_job_limits = DBImpl::GetBGJobLimits(
       result.max_background_flushes, result.max_background_compactions,
       result.max_background_garbage_collections, result.max_background_jobs,
@@ -108,6 +118,14 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
     result.wal_recovery_mode = WALRecoveryMode::kTolerateCorruptedTailRecords;
   }
 
+  if (result.wal_compression != kNoCompression &&
+      (result.wal_compression != kZSTD || !ZSTD_Supported())) {
+    ROCKS_LOG_WARN(result.info_log.get(),
+                   "Unsupported WAL compression %d, WAL is not compressed",
+                   static_cast<int>(result.wal_compression));
+    result.wal_compression = kNoCompression;
+  }
+
   if (result.recycle_log_file_num && result.prepare_log_writer_num) {
     result.recycle_log_file_num =
         std::max(result.prepare_log_writer_num, result.recycle_log_file_num);
@@ -394,7 +412,9 @@ Status DBImpl::Recover(
     }
   }
 
-  Status s = versions_->Recover(column_families, read_only);
+  // Tables of another instance go away as it compacts, see DBImplSecondary
+  Status s = versions_->Recover(column_families, read_only,
+                                read_only && !OwnTablesAndLogs());
 
   if (immutable_db_options_.paranoid_checks && s.ok()) {
     s = CheckConsistency(read_only);
@@ -556,9 +576,12 @@ Status DBImpl::PersistentStatsProcessFormatVersion() {
     // 2. sst's format version is greater than current format version, meaning
     // this sst is encoded with a newer RocksDB release, and current compatible
     // version is below the sst's compatible version
+    // 3. sst's format version is below current compatible version, meaning
+    // this sst is encoded in a format the current release no longer reads
     if (!s_format.ok() || !s_compatible.ok() ||
         (kStatsCFCurrentFormatVersion < format_version_recovered &&
-         kStatsCFCompatibleFormatVersion < compatible_version_recovered)) {
+         kStatsCFCompatibleFormatVersion < compatible_version_recovered) ||
+        format_version_recovered < kStatsCFCompatibleFormatVersion) {
       if (!s_format.ok() || !s_compatible.ok()) {
         ROCKS_LOG_INFO(
             immutable_db_options_.info_log,
@@ -627,6 +650,137 @@ Status DBImpl::InitPersistStatsColumnFamily() {
   return s;
 }
 
+namespace {
+
+// Reads and checksums the records of one WAL on a background thread, so the
+// next records are decoded while the current ones are replayed. Records are
+// handed out in log order, each with the read status the reader had right
+// after reading it.
+class LogRecordPrefetcher {
+ public:
+  LogRecordPrefetcher(log::Reader* reader, const Status* read_status,
+                      WALRecoveryMode wal_recovery_mode,
+                      size_t max_buffered_bytes)
+      : reader_(reader),
+        read_status_(read_status),
+        wal_recovery_mode_(wal_recovery_mode),
+        max_buffered_bytes_(std::max<size_t>(max_buffered_bytes, 1)),
+        chunk_bytes_(std::min<size_t>(max_buffered_bytes_, 1 << 20)),
+        buffered_bytes_(0),
+        done_(false),
+        stop_(false),
+        pos_(0) {
+    thread_ = port::Thread([this] { ReadLoop(); });
+  }
+
+  ~LogRecordPrefetcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+
+  // Same contract as log::Reader::ReadRecord. A read error seen up to the
+  // returned record is stored to *status unless it already holds one.
+  bool Next(Slice* record, Status* status) {
+    if (pos_ == current_.items.size()) {
+      current_ = Chunk();
+      pos_ = 0;
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return !chunks_.empty() || done_; });
+      if (chunks_.empty()) {
+        if (status->ok()) {
+          *status = final_status_;
+        }
+        return false;
+      }
+      current_ = std::move(chunks_.front());
+      chunks_.pop_front();
+      buffered_bytes_ -= current_.bytes;
+      lock.unlock();
+      cv_.notify_all();
+    }
+    auto& item = current_.items[pos_++];
+    if (status->ok()) {
+      *status = item.status;
+    }
+    *record = item.record;
+    return true;
+  }
+
+ private:
+  struct Item {
+    Item(const Slice& _record, const Status& _status)
+        : record(_record.data(), _record.size()), status(_status) {}
+
+    std::string record;
+    Status status;
+  };
+  struct Chunk {
+    std::vector<Item> items;
+    size_t bytes = 0;
+  };
+
+  void ReadLoop() {
+    std::string scratch;
+    Slice record;
+    Chunk chunk;
+    bool more = true;
+    while (more) {
+      more = reader_->ReadRecord(&record, &scratch, wal_recovery_mode_);
+      if (more) {
+        chunk.items.emplace_back(record, *read_status_);
+        chunk.bytes += record.size();
+        // Replay stops at the first read error
+        more = read_status_->ok();
+      }
+      if (!more || chunk.bytes >= chunk_bytes_) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] {
+          return stop_ || buffered_bytes_ < max_buffered_bytes_;
+        });
+        if (stop_) {
+          return;
+        }
+        if (!chunk.items.empty()) {
+          buffered_bytes_ += chunk.bytes;
+          chunks_.emplace_back(std::move(chunk));
+          chunk = Chunk();
+        }
+        if (!more) {
+          final_status_ = *read_status_;
+          done_ = true;
+        }
+        lock.unlock();
+        cv_.notify_all();
+      }
+    }
+  }
+
+  log::Reader* reader_;
+  const Status* read_status_;
+  const WALRecoveryMode wal_recovery_mode_;
+  const size_t max_buffered_bytes_;
+  const size_t chunk_bytes_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Chunk> chunks_;
+  size_t buffered_bytes_;
+  Status final_status_;
+  bool done_;
+  bool stop_;
+  port::Thread thread_;
+
+  // Only touched by the replay thread
+  Chunk current_;
+  size_t pos_;
+};
+
+}  // namespace
+
 // REQUIRES: log_numbers are sorted in ascending order
 Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
                                SequenceNumber* next_sequence, bool read_only) {
@@ -747,24 +901,47 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     } else {
       reporter.status = &status;
     }
+    // With read ahead the log is read on another thread, which reports into
+    // its own status. LogRecordPrefetcher hands that status back in order.
+    const bool prefetch = immutable_db_options_.wal_recovery_readahead_size > 0;
+    Status read_status;
+    LogReporter read_reporter;
+    read_reporter.env = env_;
+    read_reporter.info_log = reporter.info_log;
+    read_reporter.fname = reporter.fname;
+    read_reporter.status = reporter.status == nullptr ? nullptr : &read_status;
     // We intentially make log::Reader do checksumming even if
     // paranoid_checks==false so that corruptions cause entire commits
     // to be skipped instead of propagating bad information (like overly
     // large sequence numbers).
     log::Reader reader(immutable_db_options_.info_log, std::move(file_reader),
-                       &reporter, true /*checksum*/, log_number,
-                       false /* retry_after_eof */);
+                       prefetch ? &read_reporter : &reporter,
+                       true /*checksum*/, log_number,
+                       false /* retry_after_eof */,
+                       static_cast<size_t>(std::max(
+                           mutable_db_options_.max_background_jobs, 1)));
+    std::unique_ptr<LogRecordPrefetcher> prefetcher;
+    if (prefetch) {
+      prefetcher.reset(new LogRecordPrefetcher(
+          &reader, &read_status, immutable_db_options_.wal_recovery_mode,
+          static_cast<size_t>(
+              immutable_db_options_.wal_recovery_readahead_size)));
+    }
 
     // Determine if we should tolerate incomplete records at the tail end of the
     // Read all the records and add to a memtable
     std::string scratch;
     Slice record;
     WriteBatch batch;
+    auto read_record = [&] {
+      if (prefetcher) {
+        return prefetcher->Next(&record, &status);
+      }
+      return reader.ReadRecord(&record, &scratch,
+                               immutable_db_options_.wal_recovery_mode);
+    };
 
-    while (!stop_replay_by_wal_filter &&
-           reader.ReadRecord(&record, &scratch,
-                             immutable_db_options_.wal_recovery_mode) &&
-           status.ok()) {
+    while (!stop_replay_by_wal_filter && read_record() && status.ok()) {
       if (record.size() < WriteBatchInternal::kHeader) {
         reporter.Corruption(record.size(),
                             Status::Corruption("log record too small"));
@@ -1351,7 +1528,8 @@ Status DBImpl::Open(const DBOptions& db_options, const std::string& dbname,
             new log::Writer(
                 std::move(file_writer), new_log_number,
                 impl->immutable_db_options_.recycle_log_file_num > 0,
-                impl->immutable_db_options_.manual_wal_flush));
+                impl->immutable_db_options_.manual_wal_flush,
+                impl->immutable_db_options_.wal_compression));
       }
 
       autovector<const ColumnFamilyOptions*> cf_options_list;
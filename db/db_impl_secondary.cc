@@ -0,0 +1,265 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "db/db_impl_secondary.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+#include "db/column_family.h"
+#include "db/version_set.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/filename.h"
+
+namespace TERARKDB_NAMESPACE {
+
+#ifndef ROCKSDB_LITE
+
+DBImplSecondary::DBImplSecondary(const DBOptions& db_options,
+                                 const std::string& dbname)
+    : DBImplReadOnly(db_options, dbname) {
+  // Obsolete files are left to the primary instance, see
+  // ReleaseObsoleteTables()
+  disable_delete_obsolete_files_ = 1;
+  ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                 "Opening the db as a secondary instance");
+  LogFlush(immutable_db_options_.info_log);
+}
+
+DBImplSecondary::~DBImplSecondary() {}
+
+Status DBImplSecondary::TryCatchUpWithPrimary() {
+  std::lock_guard<std::mutex> catch_up_lock(catch_up_mutex_);
+  std::unordered_set<ColumnFamilyData*> cfds_changed;
+  std::vector<std::pair<uint64_t, uint64_t>> logs;
+  Status s;
+  {
+    InstrumentedMutexLock l(&mutex_);
+    s = versions_->TailManifest(&mutex_, &cfds_changed);
+  }
+  // A WAL file is deleted only after the flush of its data is in the
+  // MANIFEST, so it is listed after the MANIFEST is read
+  if (s.ok()) {
+    s = GetLiveLogFiles(&logs);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  SuperVersionContext sv_context(/* create_superversion */ true);
+  {
+    InstrumentedMutexLock l(&mutex_);
+    // A flush moves data from the memtables to an SST file, so the
+    // memtables are rebuilt when a version changes too
+    bool rebuild_memtables = !cfds_changed.empty() || logs != replayed_logs_;
+    if (rebuild_memtables) {
+      replayed_logs_.clear();
+      s = ReplayLogFiles(logs);
+    }
+    if (s.ok()) {
+      if (rebuild_memtables) {
+        replayed_logs_ = logs;
+      }
+      for (auto cfd : *versions_->GetColumnFamilySet()) {
+        if (cfd->IsDropped() ||
+            (!rebuild_memtables && cfds_changed.count(cfd) == 0)) {
+          continue;
+        }
+        sv_context.NewSuperVersion();
+        cfd->InstallSuperVersion(&sv_context, &mutex_);
+      }
+    }
+    ReleaseObsoleteTables();
+  }
+  sv_context.Clean();
+  if (s.ok()) {
+    ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                   "Caught up with the primary, last sequence %" PRIu64,
+                   versions_->LastSequence());
+  }
+  return s;
+}
+
+Status DBImplSecondary::GetLiveLogFiles(
+    std::vector<std::pair<uint64_t, uint64_t>>* logs) {
+  uint64_t min_log_number = std::numeric_limits<uint64_t>::max();
+  {
+    InstrumentedMutexLock l(&mutex_);
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      if (!cfd->IsDropped()) {
+        min_log_number = std::min(min_log_number, cfd->GetLogNumber());
+      }
+    }
+  }
+  std::vector<std::string> filenames;
+  Status s = env_->GetChildren(immutable_db_options_.wal_dir, &filenames);
+  if (!s.ok()) {
+    return s;
+  }
+  for (auto& filename : filenames) {
+    uint64_t number;
+    FileType type;
+    if (!ParseFileName(filename, &number, &type) || type != kLogFile ||
+        number < min_log_number) {
+      continue;
+    }
+    uint64_t size = 0;
+    // Gone when the primary has flushed its data meanwhile, which the next
+    // call picks up from the MANIFEST
+    if (env_->GetFileSize(LogFileName(immutable_db_options_.wal_dir, number),
+                          &size)
+            .ok()) {
+      logs->emplace_back(number, size);
+    }
+  }
+  std::sort(logs->begin(), logs->end());
+  return s;
+}
+
+Status DBImplSecondary::ReplayLogFiles(
+    const std::vector<std::pair<uint64_t, uint64_t>>& logs) {
+  mutex_.AssertHeld();
+  // Readers keep the old memtables through their super versions
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (!cfd->IsDropped()) {
+      cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
+                             /* needs_dup_key_check */ false,
+                             versions_->LastSequence());
+    }
+  }
+  if (logs.empty()) {
+    return Status::OK();
+  }
+  std::vector<uint64_t> log_numbers;
+  for (auto& log : logs) {
+    log_numbers.push_back(log.first);
+  }
+  // The writes of a column family in a WAL older than its log number are
+  // flushed already and skipped
+  SequenceNumber next_sequence(kMaxSequenceNumber);
+  return RecoverLogFiles(log_numbers, &next_sequence, true /* read_only */);
+}
+
+void DBImplSecondary::ReleaseObsoleteTables() {
+  mutex_.AssertHeld();
+  std::vector<ObsoleteFileInfo> files;
+  std::vector<std::string> manifest_filenames;
+  versions_->GetObsoleteFiles(&files, &manifest_filenames,
+                              std::numeric_limits<uint64_t>::max());
+  for (auto& file : files) {
+    if (file.metadata->table_reader_handle) {
+      table_cache_->Release(file.metadata->table_reader_handle);
+    }
+    TableCache::Evict(table_cache_.get(), file.metadata->fd.GetNumber());
+    file.DeleteMetadata();
+  }
+}
+
+Status DB::OpenAsSecondary(const Options& options, const std::string& dbname,
+                           const std::string& secondary_path, DB** dbptr) {
+  *dbptr = nullptr;
+
+  DBOptions db_options(options);
+  ColumnFamilyOptions cf_options(options);
+  std::vector<ColumnFamilyDescriptor> column_families;
+  column_families.push_back(
+      ColumnFamilyDescriptor(kDefaultColumnFamilyName, cf_options));
+  std::vector<ColumnFamilyHandle*> handles;
+
+  Status s = DB::OpenAsSecondary(db_options, dbname, secondary_path,
+                                 column_families, &handles, dbptr);
+  if (s.ok()) {
+    assert(handles.size() == 1);
+    // i can delete the handle since DBImpl is always holding a
+    // reference to default column family
+    delete handles[0];
+  }
+  return s;
+}
+
+Status DB::OpenAsSecondary(
+    const DBOptions& db_options, const std::string& dbname,
+    const std::string& secondary_path,
+    const std::vector<ColumnFamilyDescriptor>& column_families,
+    std::vector<ColumnFamilyHandle*>* handles, DB** dbptr) {
+  *dbptr = nullptr;
+  handles->clear();
+
+  DBOptions secondary_options(db_options);
+  if (secondary_options.info_log == nullptr) {
+    // The info log of the primary instance is left alone
+    Status s = CreateLoggerFromOptions(secondary_path, secondary_options,
+                                       &secondary_options.info_log);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  SuperVersionContext sv_context(/* create_superversion */ true);
+  DBImplSecondary* impl = new DBImplSecondary(secondary_options, dbname);
+  impl->mutex_.Lock();
+  Status s = impl->Recover(column_families, true /* read only */,
+                           false /* error_if_log_file_exist */);
+  if (s.ok()) {
+    // set column family handles
+    for (auto cf : column_families) {
+      auto cfd =
+          impl->versions_->GetColumnFamilySet()->GetColumnFamily(cf.name);
+      if (cfd == nullptr) {
+        s = Status::InvalidArgument("Column family not found: ", cf.name);
+        break;
+      }
+      handles->push_back(new ColumnFamilyHandleImpl(cfd, impl, &impl->mutex_));
+    }
+  }
+  if (s.ok()) {
+    for (auto cfd : *impl->versions_->GetColumnFamilySet()) {
+      sv_context.NewSuperVersion();
+      cfd->InstallSuperVersion(&sv_context, &impl->mutex_);
+    }
+  }
+  impl->mutex_.Unlock();
+  sv_context.Clean();
+  if (s.ok()) {
+    *dbptr = impl;
+    for (auto* h : *handles) {
+      impl->NewThreadStatusCfInfo(
+          reinterpret_cast<ColumnFamilyHandleImpl*>(h)->cfd());
+    }
+  } else {
+    for (auto h : *handles) {
+      delete h;
+    }
+    handles->clear();
+    delete impl;
+  }
+  return s;
+}
+
+#else  // !ROCKSDB_LITE
+
+Status DB::OpenAsSecondary(const Options& /*options*/,
+                           const std::string& /*dbname*/,
+                           const std::string& /*secondary_path*/,
+                           DB** /*dbptr*/) {
+  return Status::NotSupported("Not supported in ROCKSDB_LITE.");
+}
+
+Status DB::OpenAsSecondary(
+    const DBOptions& /*db_options*/, const std::string& /*dbname*/,
+    const std::string& /*secondary_path*/,
+    const std::vector<ColumnFamilyDescriptor>& /*column_families*/,
+    std::vector<ColumnFamilyHandle*>* /*handles*/, DB** /*dbptr*/) {
+  return Status::NotSupported("Not supported in ROCKSDB_LITE.");
+}
+#endif  // !ROCKSDB_LITE
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,66 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#ifndef ROCKSDB_LITE
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "db/db_impl_readonly.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// A read only instance that follows a running primary instance, see
+// DB::OpenAsSecondary.
+//
+// TryCatchUpWithPrimary() applies the MANIFEST records appended since the
+// previous call on the current versions, so the open tables, Map SST and
+// blob dependences included, are kept. The memtables are rebuilt from the
+// WAL files that are not flushed yet.
+class DBImplSecondary : public DBImplReadOnly {
+ public:
+  DBImplSecondary(const DBOptions& options, const std::string& dbname);
+  virtual ~DBImplSecondary();
+
+  virtual Status TryCatchUpWithPrimary() override;
+
+ protected:
+  // The files belong to the primary instance
+  virtual bool OwnTablesAndLogs() const override { return false; }
+
+ private:
+  friend class DB;
+
+  // Number and size of the WAL files that may hold unflushed data
+  Status GetLiveLogFiles(std::vector<std::pair<uint64_t, uint64_t>>* logs);
+
+  // Replaces the memtables with ones holding the writes of logs
+  // REQUIRES: mutex_ held
+  Status ReplayLogFiles(
+      const std::vector<std::pair<uint64_t, uint64_t>>& logs);
+
+  // Closes the tables no version references anymore, the files are left
+  // to the primary instance
+  // REQUIRES: mutex_ held
+  void ReleaseObsoleteTables();
+
+  // Serializes TryCatchUpWithPrimary(), mutex_ is released while tables are
+  // loaded
+  std::mutex catch_up_mutex_;
+  // The WAL files in the memtables
+  std::vector<std::pair<uint64_t, uint64_t>> replayed_logs_;
+
+  // No copying allowed
+  DBImplSecondary(const DBImplSecondary&);
+  void operator=(const DBImplSecondary&);
+};
+}  // namespace TERARKDB_NAMESPACE
+
+#endif  // !ROCKSDB_LITE
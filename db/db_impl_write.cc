@@ -16,6 +16,7 @@
 #include "db/error_handler.h"
 #include "db/event_helpers.h"
 #include "monitoring/perf_context_imp.h"
+#include "monitoring/usdt.h"
 #include "options/options_helper.h"
 #include "rocksdb/metrics_reporter.h"
 #include "rocksdb/terark_namespace.h"
@@ -80,6 +81,8 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   write_qps_reporter_.AddCount(WriteBatchInternal::Count(my_batch));
   write_throughput_reporter_.AddCount(WriteBatchInternal::ByteSize(my_batch));
   write_batch_size_reporter_.AddRecord(WriteBatchInternal::ByteSize(my_batch));
+  // A batch may span column families
+  PerfTraceScope perf_trace(this, kPerfTraceWrite, 0);
 
   assert(!seq_per_batch_ || batch_cnt != 0);
   if (my_batch == nullptr) {
@@ -230,6 +233,8 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   TEST_SYNC_POINT("DBImpl::WriteImpl:BeforeLeaderEnters");
   last_batch_group_size_ =
       write_thread_.EnterAsBatchGroupLeader(&w, &write_group);
+  write_buffer_manager_->RecordIngest(write_buffer_client_,
+                                      last_batch_group_size_);
 
   if (status.ok()) {
     // Rules for when we can update the memtable concurrently
@@ -245,6 +250,7 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     // more than once to a particular key.
     bool parallel = immutable_db_options_.allow_concurrent_memtable_write &&
                     write_group.size > 1;
+    write_group_size_reporter_.AddRecord(write_group.size);
     size_t total_count = 0;
     size_t valid_batches = 0;
     size_t total_byte_size = 0;
@@ -320,6 +326,7 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
 
     if (status.ok()) {
       PERF_TIMER_GUARD(write_memtable_time);
+      LatencyHistGuard memtable_guard(&write_memtable_latency_reporter_);
 
       if (!parallel) {
         // w.sequence will be set inside InsertInto
@@ -448,6 +455,8 @@ Status DBImpl::PipelinedWriteImpl(const WriteOptions& write_options,
     // This can set non-OK status if callback fail.
     last_batch_group_size_ =
         write_thread_.EnterAsBatchGroupLeader(&w, &wal_write_group);
+    write_buffer_manager_->RecordIngest(write_buffer_client_,
+                                        last_batch_group_size_);
     const SequenceNumber current_sequence =
         write_thread_.UpdateLastSequence(versions_->LastSequence()) + 1;
     size_t total_count = 0;
@@ -511,6 +520,7 @@ Status DBImpl::PipelinedWriteImpl(const WriteOptions& write_options,
   WriteThread::WriteGroup memtable_write_group;
   if (w.state == WriteThread::STATE_MEMTABLE_WRITER_LEADER) {
     PERF_TIMER_GUARD(write_memtable_time);
+    LatencyHistGuard memtable_guard(&write_memtable_latency_reporter_);
     assert(w.status.ok());
     write_thread_.EnterAsMemTableWriter(&w, &memtable_write_group);
     if (memtable_write_group.size > 1 &&
@@ -732,7 +742,7 @@ Status DBImpl::PreprocessWrite(const WriteOptions& write_options,
   if (UNLIKELY(status.ok() &&
                ((!single_column_family_mode_ &&
                  alive_log_files_.back().size > GetMaxWalSize()) ||
-                write_buffer_manager_->ShouldFlush()))) {
+                WriteBufferManagerShouldFlush()))) {
     // Before a new memtable is added in SwitchMemtable(),
     // write_buffer_manager_->ShouldFlush() will keep returning true. If another
     // thread is writing to another DB with the same write buffer, they may also
@@ -789,10 +799,12 @@ Status DBImpl::PreprocessWrite(const WriteOptions& write_options,
 
 WriteBatch* DBImpl::MergeBatch(const WriteThread::WriteGroup& write_group,
                                WriteBatch* tmp_batch, size_t* write_with_wal,
-                               WriteBatch** to_be_cached_state) {
+                               WriteBatch** to_be_cached_state,
+                               autovector<Slice>* log_parts) {
   assert(write_with_wal != nullptr);
   assert(tmp_batch != nullptr);
   assert(*to_be_cached_state == nullptr);
+  assert(log_parts->empty());
   WriteBatch* merged_batch = nullptr;
   *write_with_wal = 0;
   auto* leader = write_group.leader;
@@ -806,16 +818,19 @@ WriteBatch* DBImpl::MergeBatch(const WriteThread::WriteGroup& write_group,
     if (WriteBatchInternal::IsLatestPersistentState(merged_batch)) {
       *to_be_cached_state = merged_batch;
     }
+    log_parts->push_back(WriteBatchInternal::Contents(merged_batch));
     *write_with_wal = 1;
   } else {
-    // WAL needs all of the batches flattened into a single batch.
-    // We could avoid copying here with an iov-like AddRecord
-    // interface
+    // WAL needs all of the batches as a single batch. tmp_batch only carries
+    // the header, the bodies are handed to the log writer in place.
     merged_batch = tmp_batch;
+    assert(WriteBatchInternal::ByteSize(merged_batch) ==
+           WriteBatchInternal::kHeader);
+    log_parts->push_back(WriteBatchInternal::Contents(merged_batch));
     for (auto writer : write_group) {
       if (!writer->CallbackFailed()) {
-        WriteBatchInternal::Append(merged_batch, writer->batch,
-                                   /*WAL_only*/ true);
+        WriteBatchInternal::AppendWALParts(merged_batch, writer->batch,
+                                           log_parts);
         if (WriteBatchInternal::IsLatestPersistentState(writer->batch)) {
           // We only need to cache the last of such write batch
           *to_be_cached_state = writer->batch;
@@ -829,12 +844,15 @@ WriteBatch* DBImpl::MergeBatch(const WriteThread::WriteGroup& write_group,
 
 // When two_write_queues_ is disabled, this function is called from the only
 // write thread. Otherwise this must be called holding log_write_mutex_.
-Status DBImpl::WriteToWAL(const WriteBatch& merged_batch,
+Status DBImpl::WriteToWAL(const autovector<Slice>& log_parts,
                           log::Writer* log_writer, uint64_t* log_used,
                           uint64_t* log_size) {
   assert(log_size != nullptr);
-  Slice log_entry = WriteBatchInternal::Contents(&merged_batch);
-  *log_size = log_entry.size();
+  LatencyHistGuard guard(&write_wal_latency_reporter_);
+  *log_size = 0;
+  for (auto& part : log_parts) {
+    *log_size += part.size();
+  }
   // When two_write_queues_ WriteToWAL has to be protected from concurretn calls
   // from the two queues anyway and log_write_mutex_ is already held. Otherwise
   // if manual_wal_flush_ is enabled we need to protect log_writer->AddRecord
@@ -846,17 +864,19 @@ Status DBImpl::WriteToWAL(const WriteBatch& merged_batch,
   if (UNLIKELY(needs_locking)) {
     log_write_mutex_.Lock();
   }
-  Status status = log_writer->AddRecord(log_entry);
+  TERARKDB_PROBE2(wal_write_start, log_writer->get_log_number(), *log_size);
+  Status status = log_writer->AddRecord(log_parts);
+  TERARKDB_PROBE2(wal_write_done, log_writer->get_log_number(), status.ok());
   if (UNLIKELY(needs_locking)) {
     log_write_mutex_.Unlock();
   }
   if (log_used != nullptr) {
     *log_used = logfile_number_;
   }
-  total_log_size_ += log_entry.size();
+  total_log_size_ += *log_size;
   // TODO(myabandeh): it might be unsafe to access alive_log_files_.back() here
   // since alive_log_files_ might be modified concurrently
-  alive_log_files_.back().AddSize(log_entry.size());
+  alive_log_files_.back().AddSize(*log_size);
   log_empty_ = false;
   return status;
 }
@@ -871,8 +891,10 @@ Status DBImpl::WriteToWAL(const WriteThread::WriteGroup& write_group,
   // Same holds for all in the batch group
   size_t write_with_wal = 0;
   WriteBatch* to_be_cached_state = nullptr;
-  WriteBatch* merged_batch = MergeBatch(write_group, &tmp_batch_,
-                                        &write_with_wal, &to_be_cached_state);
+  autovector<Slice> log_parts;
+  WriteBatch* merged_batch =
+      MergeBatch(write_group, &tmp_batch_, &write_with_wal,
+                 &to_be_cached_state, &log_parts);
   if (merged_batch == write_group.leader->batch) {
     write_group.leader->log_used = logfile_number_;
   } else if (write_with_wal > 1) {
@@ -887,7 +909,7 @@ Status DBImpl::WriteToWAL(const WriteThread::WriteGroup& write_group,
   WriteBatchInternal::SetSequence(merged_batch, sequence);
 
   uint64_t log_size;
-  status = WriteToWAL(*merged_batch, log_writer, log_used, &log_size);
+  status = WriteToWAL(log_parts, log_writer, log_used, &log_size);
   if (to_be_cached_state) {
     cached_recoverable_state_ = *to_be_cached_state;
     cached_recoverable_state_empty_ = false;
@@ -895,6 +917,7 @@ Status DBImpl::WriteToWAL(const WriteThread::WriteGroup& write_group,
 
   if (status.ok() && need_log_sync) {
     StopWatch sw(env_, stats_, WAL_FILE_SYNC_MICROS);
+    LatencyHistGuard sync_guard(&wal_sync_latency_reporter_);
     // It's safe to access logs_ with unlocked mutex_ here because:
     //  - we've set getting_synced=true for all logs,
     //    so other threads won't pop from logs_ while we're here,
@@ -902,6 +925,7 @@ Status DBImpl::WriteToWAL(const WriteThread::WriteGroup& write_group,
     //    writer thread, so no one will push to logs_,
     //  - as long as other threads don't modify it, it's safe to read
     //    from std::deque from multiple threads concurrently.
+    TERARKDB_PROBE1(wal_sync_start, logs_.size());
     for (auto& log : logs_) {
       status = log.writer->file()->Sync(immutable_db_options_.use_fsync);
       if (!status.ok()) {
@@ -914,6 +938,7 @@ Status DBImpl::WriteToWAL(const WriteThread::WriteGroup& write_group,
       // we can avoid the disk I/O in the write code path.
       status = directories_.GetWalDir()->Fsync();
     }
+    TERARKDB_PROBE1(wal_sync_done, status.ok());
   }
 
   if (merged_batch == &tmp_batch_) {
@@ -944,8 +969,10 @@ Status DBImpl::ConcurrentWriteToWAL(const WriteThread::WriteGroup& write_group,
   WriteBatch tmp_batch;
   size_t write_with_wal = 0;
   WriteBatch* to_be_cached_state = nullptr;
+  autovector<Slice> log_parts;
   WriteBatch* merged_batch =
-      MergeBatch(write_group, &tmp_batch, &write_with_wal, &to_be_cached_state);
+      MergeBatch(write_group, &tmp_batch, &write_with_wal,
+                 &to_be_cached_state, &log_parts);
 
   // We need to lock log_write_mutex_ since logs_ and alive_log_files might be
   // pushed back concurrently
@@ -963,7 +990,7 @@ Status DBImpl::ConcurrentWriteToWAL(const WriteThread::WriteGroup& write_group,
 
   log::Writer* log_writer = logs_.back().writer;
   uint64_t log_size;
-  status = WriteToWAL(*merged_batch, log_writer, log_used, &log_size);
+  status = WriteToWAL(log_parts, log_writer, log_used, &log_size);
   if (to_be_cached_state) {
     cached_recoverable_state_ = *to_be_cached_state;
     cached_recoverable_state_empty_ = false;
@@ -1139,6 +1166,24 @@ Status DBImpl::SwitchWAL(WriteContext* write_context) {
   return status;
 }
 
+bool DBImpl::WriteBufferManagerShouldFlush() {
+  mutex_.AssertHeld();
+  if (!write_buffer_manager_->ShouldFlush()) {
+    return false;
+  }
+  if (write_buffer_client_ == nullptr) {
+    return true;
+  }
+  size_t memory_usage = 0;
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (!cfd->IsDropped()) {
+      memory_usage += cfd->mem()->ApproximateMemoryUsage();
+    }
+  }
+  return write_buffer_manager_->ShouldFlush(write_buffer_client_,
+                                            memory_usage);
+}
+
 Status DBImpl::HandleWriteBufferFull(WriteContext* write_context) {
   mutex_.AssertHeld();
   assert(write_context != nullptr);
@@ -1265,6 +1310,14 @@ Status DBImpl::DelayWrite(uint64_t num_bytes,
                           const WriteOptions& write_options) {
   uint64_t time_delayed = 0;
   bool delayed = false;
+  // The limits behind the stall, before the wait clears them
+  autovector<std::pair<uint32_t, WriteStallCause>> stall_causes;
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (!cfd->IsDropped() &&
+        cfd->write_stall_cause() != WriteStallCause::kNone) {
+      stall_causes.emplace_back(cfd->GetID(), cfd->write_stall_cause());
+    }
+  }
   {
     StopWatch sw(env_, stats_, WRITE_STALL, &time_delayed);
     uint64_t delay = write_controller_.GetDelay(env_, num_bytes);
@@ -1320,6 +1373,7 @@ Status DBImpl::DelayWrite(uint64_t num_bytes,
     default_cf_internal_stats_->AddDBStats(InternalStats::WRITE_STALL_MICROS,
                                            time_delayed);
     RecordTick(stats_, STALL_MICROS, time_delayed);
+    RecordWriteStallCauses(stall_causes, time_delayed);
   }
 
   // If DB is not in read-only mode and write_controller is not stopping
@@ -1337,6 +1391,49 @@ Status DBImpl::DelayWrite(uint64_t num_bytes,
   return s;
 }
 
+void DBImpl::RecordWriteStallCauses(
+    const autovector<std::pair<uint32_t, WriteStallCause>>& causes,
+    uint64_t micros) {
+  mutex_.AssertHeld();
+  bool ticked[static_cast<size_t>(WriteStallCause::kReadAmpLimit) + 1] = {};
+  for (auto& cause : causes) {
+    InternalStats::InternalCFStatsType cf_stats_type;
+    Tickers ticker;
+    switch (cause.second) {
+      case WriteStallCause::kMemtableLimit:
+        cf_stats_type = InternalStats::MEMTABLE_LIMIT_STALL_MICROS;
+        ticker = STALL_MEMTABLE_LIMIT_MICROS;
+        break;
+      case WriteStallCause::kL0FileCountLimit:
+        cf_stats_type = InternalStats::L0_FILE_COUNT_LIMIT_STALL_MICROS;
+        ticker = STALL_L0_FILE_COUNT_LIMIT_MICROS;
+        break;
+      case WriteStallCause::kPendingCompactionBytes:
+        cf_stats_type =
+            InternalStats::PENDING_COMPACTION_BYTES_LIMIT_STALL_MICROS;
+        ticker = STALL_PENDING_COMPACTION_BYTES_MICROS;
+        break;
+      case WriteStallCause::kReadAmpLimit:
+        cf_stats_type = InternalStats::READ_AMP_LIMIT_STALL_MICROS;
+        ticker = STALL_READ_AMP_LIMIT_MICROS;
+        break;
+      default:
+        continue;
+    }
+    // A limit hit by several column families is ticked once
+    size_t index = static_cast<size_t>(cause.second);
+    if (!ticked[index]) {
+      ticked[index] = true;
+      RecordTick(stats_, ticker, micros);
+    }
+    auto cfd = versions_->GetColumnFamilySet()->GetColumnFamily(cause.first);
+    if (cfd != nullptr && !cfd->IsDropped()) {
+      cfd->internal_stats()->AddCFStats(cf_stats_type, micros);
+      cfd->internal_stats()->GetWriteStallHist()->Add(micros);
+    }
+  }
+}
+
 Status DBImpl::ThrottleLowPriWritesIfNeeded(const WriteOptions& write_options,
                                             WriteBatch* my_batch) {
   assert(write_options.low_pri);
@@ -1452,7 +1549,8 @@ Status DBImpl::NewLogWriter(std::unique_ptr<log::Writer>* new_log,
         immutable_db_options_.listeners));
     new_log->reset(new log::Writer(
         std::move(file_writer), new_log_number,
-        immutable_db_options_.recycle_log_file_num > 0, manual_wal_flush_));
+        immutable_db_options_.recycle_log_file_num > 0, manual_wal_flush_,
+        immutable_db_options_.wal_compression));
   }
   return s;
 }
@@ -17,6 +17,7 @@
 #include "db/forward_iterator.h"
 #include "db/merge_context.h"
 #include "db/merge_helper.h"
+#include "monitoring/io_purpose.h"
 #include "monitoring/perf_context_imp.h"
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
@@ -122,6 +123,13 @@ class DBIter final : public Iterator {
         iter_(iter),
         sequence_(s),
         separate_helper_(separate_helper),
+        blob_readahead_size_(read_options.blob_readahead_size),
+        value_projection_(read_options.value_projection),
+        value_meta_projection_(
+            read_options.value_projection != nullptr &&
+            read_options.value_projection_is_meta &&
+            cf_options.value_meta_extractor_factory != nullptr),
+        value_projected_(false),
         direction_(kForward),
         valid_(false),
         current_entry_is_merged_(false),
@@ -145,6 +153,9 @@ class DBIter final : public Iterator {
   virtual ~DBIter() {
     RecordTick(statistics_, NO_ITERATOR_DELETED);
     ResetValueAndCounter();
+    // Deleting iter_ may unref the Version pinning the blob files read by
+    // blob_state_, so the blob readers go first
+    blob_state_.reset();
     merge_context_.Clear();
     local_stats_.BumpGlobalStatistics(statistics_);
     if (!arena_mode_) {
@@ -162,6 +173,7 @@ class DBIter final : public Iterator {
                    old_sv->current == self->separate_helper_);
             (void)old_sv;
             self->PinLazyBuffer();
+            self->blob_state_.reset();
             self->separate_helper_ =
                 new_sv == nullptr ? nullptr : new_sv->current;
           },
@@ -174,6 +186,7 @@ class DBIter final : public Iterator {
     assert(iter_ == nullptr);
     iter_ = iter;
     separate_helper_ = separate_helper;
+    blob_state_.reset();
     SetSVDestructCallback(sv_destruct_callback);
   }
   virtual ReadRangeDelAggregator* GetRangeDelAggregator() {
@@ -191,7 +204,22 @@ class DBIter final : public Iterator {
   }
   virtual Slice value() const override {
     assert(valid_);
-    auto s = value_.fetch();
+    Status s;
+    if (blob_readahead_size_ > 0 && direction_ == kForward &&
+        separate_helper_ != nullptr) {
+      s = separate_helper_->FetchForward(const_cast<LazyBuffer*>(&value_),
+                                         blob_readahead_size_, &blob_state_);
+    } else {
+      s = value_.fetch();
+    }
+    if (s.ok() && value_projection_ != nullptr && !value_projected_) {
+      s = value_projection_->Extract(saved_key_.GetUserKey(), value_.slice(),
+                                     &projection_buffer_);
+      if (s.ok()) {
+        value_projected_ = true;
+        const_cast<LazyBuffer&>(value_).reset(projection_buffer_);
+      }
+    }
     if (!s.ok()) {
       valid_ = false;
       status_ = s;
@@ -244,6 +272,7 @@ class DBIter final : public Iterator {
   bool FindValueForCurrentKey();
   bool FindValueForCurrentKeyUsingSeek();
   bool FindUserKeyBeforeSavedKey();
+  void SeekBeforeSavedKey();
   inline bool FindNextUserEntry(bool skipping, bool prefix_check);
   bool FindNextUserEntryInternal(bool skipping, bool prefix_check);
   bool ParseKey(ParsedInternalKey* key);
@@ -256,6 +285,22 @@ class DBIter final : public Iterator {
                                                ikey.sequence, iter_->value());
     }
   }
+  // The value of the key when ikey is its latest entry, a separated value is
+  // answered by its value meta under value_meta_projection_
+  LazyBuffer GetLatestValue(const ParsedInternalKey& ikey) {
+    if (!value_meta_projection_ || separate_helper_ == nullptr ||
+        ikey.type != kTypeValueIndex) {
+      return GetValue(ikey, kTypeValueIndex);
+    }
+    LazyBuffer index = iter_->value();
+    auto s = index.fetch();
+    if (!s.ok()) {
+      return LazyBuffer(std::move(s));
+    }
+    value_projected_ = true;
+    return LazyBuffer(SeparateHelper::DecodeValueMeta(index.slice()),
+                      true /* copy */);
+  }
 
   void PrevInternal();
   bool TooManyInternalKeysSkipped(bool increment = true);
@@ -280,6 +325,7 @@ class DBIter final : public Iterator {
     }
     num_internal_keys_skipped_ = 0;
     value_.reset();
+    value_projected_ = false;
     if (value_buffer_.capacity() > 1048576) {
       std::string().swap(value_buffer_);
     }
@@ -294,6 +340,16 @@ class DBIter final : public Iterator {
   InternalIterator* iter_;
   SequenceNumber sequence_;
   const SeparateHelper* separate_helper_;
+  // Forward scans fetch separated values through blob SST iterators kept in
+  // blob_state_ when blob_readahead_size_ is set
+  const size_t blob_readahead_size_;
+  mutable std::unique_ptr<SeparateHelper::ForwardState> blob_state_;
+  // See ReadOptions::value_projection and value_projection_is_meta
+  const ValueExtractor* const value_projection_;
+  const bool value_meta_projection_;
+  // value_ already holds the projection
+  mutable bool value_projected_;
+  mutable std::string projection_buffer_;
 
   mutable Status status_;
   IterKey saved_key_;
@@ -355,6 +411,7 @@ void DBIter::Next() {
                              ? nullptr
                              : (db_impl_->next_qps_reporter().AddCount(1),
                                 &db_impl_->next_latency_reporter()));
+  IOPurposeGuard io_purpose_guard(kIOPurposeIterator);
 
   assert(valid_);
   assert(status_.ok());
@@ -484,7 +541,7 @@ bool DBIter::FindNextUserEntryInternal(bool skipping, bool prefix_check) {
             if (start_seqnum_ > 0) {
               if (ikey_.sequence >= start_seqnum_) {
                 saved_key_.SetInternalKey(ikey_);
-                value_ = GetValue(ikey_, kTypeValueIndex);
+                value_ = GetLatestValue(ikey_);
                 valid_ = true;
                 return true;
               } else {
@@ -504,7 +561,7 @@ bool DBIter::FindNextUserEntryInternal(bool skipping, bool prefix_check) {
                 reseek_done = false;
                 PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
               } else {
-                value_ = GetValue(ikey_, kTypeValueIndex);
+                value_ = GetLatestValue(ikey_);
                 valid_ = true;
                 return true;
               }
@@ -687,6 +744,7 @@ void DBIter::Prev() {
                              ? nullptr
                              : (db_impl_->prev_qps_reporter().AddCount(1),
                                 &db_impl_->prev_latency_reporter()));
+  IOPurposeGuard io_purpose_guard(kIOPurposeIterator);
 
   assert(valid_);
   assert(status_.ok());
@@ -760,24 +818,7 @@ bool DBIter::ReverseToBackward() {
   if (current_entry_is_merged_ &&
       ((prefix_extractor_ != nullptr && !total_order_seek_) ||
        !iter_->Valid())) {
-    IterKey last_key;
-    // Using kMaxSequenceNumber and kValueTypeForSeek
-    // (not kValueTypeForSeekForPrev) to seek to a key strictly smaller
-    // than saved_key_.
-    last_key.SetInternalKey(ParsedInternalKey(
-        saved_key_.GetUserKey(), kMaxSequenceNumber, kValueTypeForSeek));
-    if (prefix_extractor_ != nullptr && !total_order_seek_) {
-      iter_->SeekForPrev(last_key.GetInternalKey());
-    } else {
-      // Some iterators may not support SeekForPrev(), so we avoid using it
-      // when prefix seek mode is disabled. This is somewhat expensive
-      // (an extra Prev(), as well as an extra change of direction of iter_),
-      // so we may need to reconsider it later.
-      iter_->Seek(last_key.GetInternalKey());
-      if (!iter_->Valid() && iter_->status().ok()) {
-        iter_->SeekToLast();
-      }
-    }
+    SeekBeforeSavedKey();
   }
 
   direction_ = kReverse;
@@ -1008,12 +1049,14 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
       range_del_agg_.ShouldDelete(
           ikey, RangeDelPositioningMode::kBackwardTraversal)) {
     valid_ = false;
+    SeekBeforeSavedKey();
     return true;
   }
   if (ikey.type == kTypeValue || ikey.type == kTypeValueIndex) {
-    value_ = GetValue(ikey, kTypeValueIndex);
+    value_ = GetLatestValue(ikey);
     value_.pin(LazyBufferPinLevel::Internal);
     valid_ = true;
+    SeekBeforeSavedKey();
     return true;
   }
 
@@ -1058,6 +1101,7 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
       }
       value_.pin(LazyBufferPinLevel::Internal);
       valid_ = true;
+      SeekBeforeSavedKey();
       return true;
     } else if (ikey.type == kTypeMerge || ikey.type == kTypeMergeIndex) {
       merge_context_.PushOperand(GetValue(ikey, kTypeMergeIndex));
@@ -1078,21 +1122,7 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
   }
   value_.pin(LazyBufferPinLevel::Internal);
 
-  // Make sure we leave iter_ in a good state. If it's valid and we don't care
-  // about prefixes, that's already good enough. Otherwise it needs to be
-  // seeked to the current key.
-  if ((prefix_extractor_ != nullptr && !total_order_seek_) || !iter_->Valid()) {
-    if (prefix_extractor_ != nullptr && !total_order_seek_) {
-      iter_->SeekForPrev(last_key);
-    } else {
-      iter_->Seek(last_key);
-      if (!iter_->Valid() && iter_->status().ok()) {
-        iter_->SeekToLast();
-      }
-    }
-    RecordTick(statistics_, NUMBER_OF_RESEEKS_IN_ITERATION);
-  }
-
+  SeekBeforeSavedKey();
   valid_ = true;
   return true;
 }
@@ -1125,19 +1155,11 @@ bool DBIter::FindUserKeyBeforeSavedKey() {
 
     if (num_skipped >= max_skip_ && CanReseekToSkip()) {
       num_skipped = 0;
-      IterKey last_key;
-      last_key.SetInternalKey(ParsedInternalKey(
-          saved_key_.GetUserKey(), kMaxSequenceNumber, kValueTypeForSeek));
-      // It would be more efficient to use SeekForPrev() here, but some
-      // iterators may not support it.
-      iter_->Seek(last_key.GetInternalKey());
+      SeekBeforeSavedKey();
       RecordTick(statistics_, NUMBER_OF_RESEEKS_IN_ITERATION);
-      if (!iter_->Valid()) {
-        break;
-      }
-    } else {
-      ++num_skipped;
+      continue;
     }
+    ++num_skipped;
 
     iter_->Prev();
   }
@@ -1150,6 +1172,20 @@ bool DBIter::FindUserKeyBeforeSavedKey() {
   return true;
 }
 
+// Position iter_ on the last entry with a user key smaller than saved_key_.
+// Memtable iterators emulate SeekForPrev() when their rep can't do it, the
+// rest of the iterators able to go backwards support it natively, so this
+// takes one seek instead of stepping back through the versions of saved_key_.
+void DBIter::SeekBeforeSavedKey() {
+  IterKey last_key;
+  // Using kMaxSequenceNumber and kValueTypeForSeek (not
+  // kValueTypeForSeekForPrev) to seek to a key strictly smaller than
+  // saved_key_.
+  last_key.SetInternalKey(ParsedInternalKey(
+      saved_key_.GetUserKey(), kMaxSequenceNumber, kValueTypeForSeek));
+  iter_->SeekForPrev(last_key.GetInternalKey());
+}
+
 bool DBIter::TooManyInternalKeysSkipped(bool increment) {
   if ((max_skippable_internal_keys_ > 0) &&
       (num_internal_keys_skipped_ > max_skippable_internal_keys_)) {
@@ -1186,6 +1222,9 @@ void DBIter::Seek(const Slice& target) {
                              ? nullptr
                              : (db_impl_->seek_qps_reporter().AddCount(1),
                                 &db_impl_->seek_latency_reporter()));
+  IOPurposeGuard io_purpose_guard(kIOPurposeIterator);
+  PerfTraceScope perf_trace(db_impl_, kPerfTraceSeek,
+                            cfd_ == nullptr ? 0 : cfd_->GetID());
 
   StopWatch sw(env_, statistics_, DB_SEEK);
   status_ = Status::OK();
@@ -1250,6 +1289,9 @@ void DBIter::SeekForPrev(const Slice& target) {
       db_impl_ == nullptr ? nullptr
                           : (db_impl_->seekforprev_qps_reporter().AddCount(1),
                              &db_impl_->seekforprev_latency_reporter()));
+  IOPurposeGuard io_purpose_guard(kIOPurposeIterator);
+  PerfTraceScope perf_trace(db_impl_, kPerfTraceSeekForPrev,
+                            cfd_ == nullptr ? 0 : cfd_->GetID());
 
   StopWatch sw(env_, statistics_, DB_SEEK);
   status_ = Status::OK();
@@ -1312,6 +1354,7 @@ void DBIter::SeekToFirst() {
                              ? nullptr
                              : (db_impl_->seek_qps_reporter().AddCount(1),
                                 &db_impl_->seek_latency_reporter()));
+  IOPurposeGuard io_purpose_guard(kIOPurposeIterator);
   if (iterate_lower_bound_ != nullptr) {
     Seek(*iterate_lower_bound_);
     return;
@@ -1360,6 +1403,7 @@ void DBIter::SeekToLast() {
       db_impl_ == nullptr ? nullptr
                           : (db_impl_->seekforprev_qps_reporter().AddCount(1),
                              &db_impl_->seek_latency_reporter()));
+  IOPurposeGuard io_purpose_guard(kIOPurposeIterator);
   if (iterate_upper_bound_ != nullptr) {
     // Seek to last key strictly less than ReadOptions.iterate_upper_bound.
     SeekForPrev(*iterate_upper_bound_);
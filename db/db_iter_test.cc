@@ -3179,6 +3179,34 @@ TEST_F(DBIteratorTest, ReverseToForwardWithDisappearingKeys) {
   EXPECT_LT(internal_iter->steps(), 20);
 }
 
+TEST_F(DBIteratorTest, ReverseScanSkipsNewerVersions) {
+  Options options;
+  TestIterator* internal_iter = new TestIterator(BytewiseComparator());
+  for (std::string key : {"a", "b", "c"}) {
+    for (size_t i = 0; i < 50; ++i) {
+      internal_iter->Add(key, kTypeValue, key + ToString(i), i);
+    }
+  }
+  internal_iter->Finish();
+
+  // Half of the versions of every key are newer than the snapshot
+  std::unique_ptr<Iterator> db_iter(NewDBIterator(
+      env_, ReadOptions(), ImmutableCFOptions(options),
+      MutableCFOptions(options), BytewiseComparator(), internal_iter, nullptr,
+      24, nullptr, options.max_sequential_skip_in_iterations,
+      nullptr /*read_callback*/));
+
+  db_iter->SeekToLast();
+  for (std::string key : {"c", "b", "a"}) {
+    ASSERT_TRUE(db_iter->Valid());
+    ASSERT_EQ(key, db_iter->key().ToString());
+    ASSERT_EQ(key + "24", db_iter->value().ToString());
+    db_iter->Prev();
+  }
+  ASSERT_FALSE(db_iter->Valid());
+  ASSERT_OK(db_iter->status());
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -1614,6 +1614,108 @@ TEST_P(DBIteratorTest, ReadAhead) {
   delete iter;
 }
 
+TEST_P(DBIteratorTest, AsyncPrefetch) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = -1;
+  options.write_buffer_size = 4 << 20;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  table_options.no_block_cache = true;
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  Reopen(options);
+
+  std::string value(1024, 'a');
+  for (int i = 0; i < 100; i++) {
+    Put(Key(i), value);
+  }
+  ASSERT_OK(Flush());
+
+  size_t num_hints = 0;
+  size_t hinted_bytes = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "BlockBasedTableIterator:AsyncPrefetch", [&](void* arg) {
+        num_hints++;
+        hinted_bytes += *reinterpret_cast<size_t*>(arg);
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  ReadOptions read_options;
+  read_options.async_prefetch_depth = 8;
+  auto* iter = NewIterator(read_options);
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(value, iter->value());
+    count++;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(100, count);
+  // Adjacent blocks are hinted together, about once per half window, and
+  // every block is hinted at most once
+  ASSERT_GT(num_hints, 0u);
+  ASSERT_LT(num_hints, 50u);
+  ASSERT_GT(hinted_bytes, 90 * value.size());
+  ASSERT_LT(hinted_bytes, 110 * (value.size() + 64));
+
+  // Seeking back to the start hints again
+  num_hints = 0;
+  for (int i = 0; i < 100; i += 10) {
+    iter->Seek(Key(i));
+    for (int j = 0; j < 5; j++, iter->Next()) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(Key(i + j), iter->key().ToString());
+    }
+  }
+  ASSERT_GT(num_hints, 0u);
+  delete iter;
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_P(DBIteratorTest, IteratorsShareTableReadersOfVersion) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = -1;
+  options.max_open_files = 100;
+  Reopen(options);
+
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+    ASSERT_OK(Flush());
+  }
+
+  std::atomic<int> find_table_count(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "TableCache::FindTable:0", [&](void* /*arg*/) { find_table_count++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  auto CountKeys = [&]() {
+    std::unique_ptr<Iterator> iter(NewIterator(ReadOptions()));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      count++;
+    }
+    EXPECT_OK(iter->status());
+    return count;
+  };
+  ASSERT_EQ(3, CountKeys());
+  ASSERT_EQ(3, find_table_count.load());
+  // Later iterators over the same version reuse the readers
+  ASSERT_EQ(3, CountKeys());
+  ASSERT_EQ(3, find_table_count.load());
+
+  // A new version resolves its readers again
+  ASSERT_OK(Put(Key(3), "v3"));
+  ASSERT_OK(Flush());
+  find_table_count = 0;
+  ASSERT_EQ(4, CountKeys());
+  ASSERT_EQ(4, find_table_count.load());
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
 // Insert a key, create a snapshot iterator, overwrite key lots of times,
 // seek to a smaller key. Expect DBIter to fall back to a seek instead of
 // going through all the overwrites linearly.
@@ -275,6 +275,110 @@ TEST_F(DBMemTableTest, ColumnFamilyId) {
   }
 }
 
+#ifndef ROCKSDB_LITE
+TEST_F(DBMemTableTest, HashDualListBucketGrowth) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  // Start from 4 buckets, which double many times as the keys come in
+  options.memtable_factory.reset(NewConcurrentHashDualListReqFactory(4));
+  options.prefix_extractor.reset(NewFixedPrefixTransform(4));
+  DestroyAndReopen(options);
+
+  auto key = [](int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "p%03d_k%05d", i % 100, i);
+    return std::string(buf);
+  };
+  const int kNumKeys = 5000;
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_OK(Put(key(i), "v1"));
+  }
+  for (int i = 0; i < kNumKeys; i += 3) {
+    ASSERT_OK(Put(key(i), "v2"));
+  }
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(i % 3 == 0 ? "v2" : "v1", Get(key(i)));
+  }
+  ASSERT_EQ("NOT_FOUND", Get("p000_missing"));
+
+  // A prefix is read from its bucket
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  int count = 0;
+  for (iter->Seek("p042"); iter->Valid() && iter->key().starts_with("p042");
+       iter->Next()) {
+    ASSERT_EQ(key(42 + count * 100), iter->key().ToString());
+    ++count;
+  }
+  ASSERT_EQ(kNumKeys / 100, count);
+
+  // The whole memtable is flushed in order
+  ASSERT_OK(Flush());
+  for (int i = 0; i < kNumKeys; i += 7) {
+    ASSERT_EQ(i % 3 == 0 ? "v2" : "v1", Get(key(i)));
+  }
+  ReadOptions read_options;
+  read_options.total_order_seek = true;
+  iter.reset(db_->NewIterator(read_options));
+  std::string last;
+  count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_LT(last, iter->key().ToString());
+    last = iter->key().ToString();
+    ++count;
+  }
+  ASSERT_EQ(kNumKeys, count);
+}
+
+TEST_F(DBMemTableTest, HashDualListConcurrentBucketGrowth) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.allow_concurrent_memtable_write = true;
+  options.memtable_factory.reset(NewConcurrentHashDualListReqFactory(4));
+  options.prefix_extractor.reset(NewFixedPrefixTransform(4));
+  DestroyAndReopen(options);
+
+  auto key = [](int t, int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "p%03d_t%d_k%05d", i % 100, t, i);
+    return std::string(buf);
+  };
+  // The writers insert into the same groups of writes while the buckets
+  // double many times under them
+  const int kNumThreads = 4;
+  const int kNumKeys = 4000;
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kNumKeys; ++i) {
+        WriteBatch batch;
+        ASSERT_OK(batch.Put(key(t, i), key(t, i)));
+        ASSERT_OK(db_->Write(WriteOptions(), &batch));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_EQ(key(t, i), Get(key(t, i)));
+    }
+  }
+  ReadOptions read_options;
+  read_options.total_order_seek = true;
+  std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+  std::string last;
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_LT(last, iter->key().ToString());
+    last = iter->key().ToString();
+    ++count;
+  }
+  ASSERT_EQ(kNumThreads * kNumKeys, count);
+}
+#endif  // ROCKSDB_LITE
+
 #ifdef WITH_TERARK_ZIP
 TEST(PatriciaMemTableTest, Normal) {
   SequenceNumber seq = 123;
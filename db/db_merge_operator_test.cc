@@ -153,6 +153,57 @@ TEST_F(DBMergeOperatorTest, MergeErrorOnWrite) {
   VerifyDBInternal({{"k1", "corrupted"}, {"k1", "v2"}, {"k1", "v1"}});
 }
 
+TEST_F(DBMergeOperatorTest, FoldMergeInMemtable) {
+  Options options;
+  options.create_if_missing = true;
+  options.merge_operator = MergeOperators::CreateUInt64AddOperator();
+  options.memtable_merge_fold_threshold = 2;
+  options.env = env_;
+  Reopen(options);
+
+  auto encode = [](uint64_t v) {
+    std::string result;
+    PutFixed64(&result, v);
+    return result;
+  };
+  auto get = [&]() {
+    std::string value;
+    EXPECT_OK(db_->Get(ReadOptions(), "k1", &value));
+    EXPECT_EQ(8U, value.size());
+    return DecodeFixed64(value.data());
+  };
+
+  // Operands of the same batch are folded once the key is hot
+  WriteBatch batch;
+  for (uint64_t i = 1; i <= 100; ++i) {
+    ASSERT_OK(batch.Merge("k1", encode(i)));
+  }
+  ASSERT_OK(db_->Write(WriteOptions(), &batch));
+  uint64_t num_entries;
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kNumEntriesActiveMemTable,
+                                  &num_entries));
+  ASSERT_EQ(2U, num_entries);
+  ASSERT_EQ(5050U, get());
+
+  // Published operands are never touched, so snapshots stay intact
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Merge("k1", encode(1)));
+  ASSERT_OK(Merge("k1", encode(1)));
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kNumEntriesActiveMemTable,
+                                  &num_entries));
+  ASSERT_EQ(4U, num_entries);
+  ASSERT_EQ(5052U, get());
+  ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  std::string value;
+  ASSERT_OK(db_->Get(read_options, "k1", &value));
+  ASSERT_EQ(5050U, DecodeFixed64(value.data()));
+  db_->ReleaseSnapshot(snapshot);
+
+  ASSERT_OK(Flush());
+  ASSERT_EQ(5052U, get());
+}
+
 TEST_F(DBMergeOperatorTest, MergeErrorOnIteration) {
   Options options;
   options.create_if_missing = true;
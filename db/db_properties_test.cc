@@ -1624,6 +1624,69 @@ TEST_F(DBPropertiesTest, BlockCacheProperties) {
   ASSERT_EQ(0, value);
 }
 
+
+TEST_F(DBPropertiesTest, HotKeys) {
+  class TestListener : public EventListener {
+   public:
+    void OnHotKeysDetected(const HotKeysInfo& info) override {
+      infos.push_back(info);
+    }
+
+    std::vector<HotKeysInfo> infos;
+  };
+  std::shared_ptr<TestListener> listener = std::make_shared<TestListener>();
+
+  Options options = CurrentOptions();
+  std::string value;
+  ASSERT_FALSE(db_->GetProperty(DB::Properties::kHotKeys, &value));
+
+  options.hot_key_sample_rate = 1;
+  options.hot_key_top_k = 4;
+  options.disable_auto_compactions = true;
+  options.blob_size = -1;
+  options.table_factory.reset(NewBlockBasedTableFactory());
+  options.listeners.push_back(listener);
+  Reopen(options);
+
+  // Nothing sampled, nothing reported
+  dbfull()->DumpStats();
+  ASSERT_TRUE(listener->infos.empty());
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put("key" + ToString(i), "v"));
+  }
+  for (int i = 0; i < 50; ++i) {
+    ASSERT_OK(Put("hot", ToString(i)));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 50; ++i) {
+    ASSERT_EQ("49", Get("hot"));
+  }
+  ASSERT_TRUE(db_->GetProperty(DB::Properties::kHotKeys, &value));
+  ASSERT_NE(std::string::npos, value.find(Slice("hot").ToString(true)));
+
+  dbfull()->DumpStats();
+  ASSERT_EQ(1U, listener->infos.size());
+  HotKeysInfo info = listener->infos[0];
+  ASSERT_EQ(dbname_, info.db_name);
+  ASSERT_EQ(4U, info.keys.size());
+  ASSERT_EQ("hot", info.keys[0].key);
+  ASSERT_EQ(kDefaultColumnFamilyName, info.keys[0].cf_name);
+  ASSERT_GE(info.keys[0].count, 100U);
+  ASSERT_EQ(200U, info.total_keys);
+  // All the reads of "hot" go to the same data block
+  ASSERT_FALSE(info.blocks.empty());
+  ASSERT_GE(info.blocks[0].count, 50U);
+  ASSERT_GE(info.total_blocks, 50U);
+
+  // The counts are halved after every report
+  listener->infos.clear();
+  dbfull()->DumpStats();
+  ASSERT_EQ(1U, listener->infos.size());
+  ASSERT_EQ("hot", listener->infos[0].keys[0].key);
+  ASSERT_EQ(info.keys[0].count / 2, listener->infos[0].keys[0].count);
+  ASSERT_EQ(info.total_keys / 2, listener->infos[0].total_keys);
+}
 #endif  // ROCKSDB_LITE
 }  // namespace TERARKDB_NAMESPACE
 
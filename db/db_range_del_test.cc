@@ -1428,6 +1428,81 @@ TEST_F(DBRangeDelTest, SnapshotPreventsDroppedKeys) {
   db_->ReleaseSnapshot(snapshot);
 }
 
+TEST_F(DBRangeDelTest, CompactionSkipsCoveredFiles) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  Reopen(options);
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_OK(Put(Key(i), "a"));
+  }
+  ASSERT_OK(Flush());
+  const Snapshot* snapshot = db_->GetSnapshot();
+  for (int i = 10; i < 20; ++i) {
+    ASSERT_OK(Put(Key(i), "b"));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(Put(Key(30), "c"));
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(), Key(0),
+                             Key(25)));
+  ASSERT_OK(Flush());
+  ASSERT_EQ(3, NumTableFilesAtLevel(0));
+
+  size_t num_skipped = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::SkipCoveredInputFiles", [&](void* arg) {
+        num_skipped += static_cast<std::unordered_set<uint64_t>*>(arg)->size();
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // The snapshot still sees the first file
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(1, num_skipped);
+  ASSERT_EQ("a", Get(Key(0), snapshot));
+  ASSERT_EQ("NOT_FOUND", Get(Key(0)));
+  ASSERT_EQ("NOT_FOUND", Get(Key(10)));
+  ASSERT_EQ("c", Get(Key(30)));
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(DBRangeDelTest, CompactionKeepsFilesSeenBySnapshotInside) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  Reopen(options);
+
+  // The snapshot falls between the first and the last key of the file
+  ASSERT_OK(Put(Key(0), "a"));
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Put(Key(1), "b"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(Put(Key(30), "c"));
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(), Key(0),
+                             Key(25)));
+  ASSERT_OK(Flush());
+  ASSERT_EQ(2, NumTableFilesAtLevel(0));
+
+  size_t num_skipped = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::SkipCoveredInputFiles", [&](void* arg) {
+        num_skipped += static_cast<std::unordered_set<uint64_t>*>(arg)->size();
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(0, num_skipped);
+  ASSERT_EQ("a", Get(Key(0), snapshot));
+  ASSERT_EQ("NOT_FOUND", Get(Key(1), snapshot));
+  ASSERT_EQ("NOT_FOUND", Get(Key(0)));
+  ASSERT_EQ("NOT_FOUND", Get(Key(1)));
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  db_->ReleaseSnapshot(snapshot);
+}
+
 TEST_F(DBRangeDelTest, RangeTombstoneWrittenToMinimalSsts) {
   // Adapted from
   // https://github.com/cockroachdb/cockroach/blob/de8b3ea603dd1592d9dc26443c2cc92c356fbc2f/pkg/storage/engine/rocksdb_test.go#L1267-L1398.
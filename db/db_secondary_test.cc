@@ -0,0 +1,126 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include <string>
+
+#include "db/db_test_util.h"
+#include "port/stack_trace.h"
+#include "rocksdb/statistics.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+#ifndef ROCKSDB_LITE
+class DBSecondaryTest : public DBTestBase {
+ public:
+  DBSecondaryTest() : DBTestBase("/db_secondary_test"), secondary_(nullptr) {
+    secondary_path_ = test::PerThreadDBPath(env_, "db_secondary_test_2nd");
+  }
+
+  ~DBSecondaryTest() {
+    CloseSecondary();
+    test::DestroyDir(env_, secondary_path_);
+  }
+
+  void OpenSecondary(const Options& options) {
+    ASSERT_OK(DB::OpenAsSecondary(options, dbname_, secondary_path_,
+                                  &secondary_));
+  }
+
+  void CloseSecondary() {
+    delete secondary_;
+    secondary_ = nullptr;
+  }
+
+  std::string SecondaryGet(const std::string& k) {
+    std::string result;
+    Status s = secondary_->Get(ReadOptions(), k, &result);
+    if (s.IsNotFound()) {
+      result = "NOT_FOUND";
+    } else if (!s.ok()) {
+      result = s.ToString();
+    }
+    return result;
+  }
+
+  std::string secondary_path_;
+  DB* secondary_;
+};
+
+TEST_F(DBSecondaryTest, CatchUpWithoutReopen) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  Reopen(options);
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_OK(Flush());
+  OpenSecondary(options);
+  ASSERT_EQ("v1", SecondaryGet("foo"));
+  ASSERT_TRUE(db_->TryCatchUpWithPrimary().IsNotSupported());
+
+  // Writes still in the WAL
+  ASSERT_OK(Put("foo", "v2"));
+  ASSERT_OK(Put("bar", "v1"));
+  ASSERT_EQ("v1", SecondaryGet("foo"));
+  ASSERT_OK(secondary_->TryCatchUpWithPrimary());
+  ASSERT_EQ("v2", SecondaryGet("foo"));
+  ASSERT_EQ("v1", SecondaryGet("bar"));
+
+  // Flushed and compacted
+  ASSERT_OK(Flush());
+  ASSERT_OK(Delete("bar"));
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_OK(secondary_->TryCatchUpWithPrimary());
+  ASSERT_EQ("v2", SecondaryGet("foo"));
+  ASSERT_EQ("NOT_FOUND", SecondaryGet("bar"));
+
+  // The reopened primary writes a new MANIFEST
+  Reopen(options);
+  ASSERT_OK(Put("foo", "v3"));
+  ASSERT_OK(Put("baz", "v1"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(secondary_->TryCatchUpWithPrimary());
+  ASSERT_EQ("v3", SecondaryGet("foo"));
+  ASSERT_EQ("v1", SecondaryGet("baz"));
+  ASSERT_EQ("NOT_FOUND", SecondaryGet("bar"));
+
+  // Nothing new
+  ASSERT_OK(secondary_->TryCatchUpWithPrimary());
+  ASSERT_EQ("v3", SecondaryGet("foo"));
+}
+
+TEST_F(DBSecondaryTest, TablesStayOpen) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  Reopen(options);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+    ASSERT_OK(Flush());
+  }
+  Options secondary_options = options;
+  secondary_options.statistics = CreateDBStatistics();
+  OpenSecondary(secondary_options);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ("v" + ToString(i), SecondaryGet(Key(i)));
+  }
+  uint64_t opens = TestGetTickerCount(secondary_options, NO_FILE_OPENS);
+
+  ASSERT_OK(Put(Key(4), "v4"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(secondary_->TryCatchUpWithPrimary());
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ("v" + ToString(i), SecondaryGet(Key(i)));
+  }
+  // Only the new table is opened
+  ASSERT_EQ(opens + 1, TestGetTickerCount(secondary_options, NO_FILE_OPENS));
+}
+#endif  // ROCKSDB_LITE
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  TERARKDB_NAMESPACE::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
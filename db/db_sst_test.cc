@@ -840,6 +840,47 @@ TEST_F(DBSSTTest, OpenDBWithInfiniteMaxOpenFiles) {
   }
 }
 
+TEST_F(DBSSTTest, LazyLoadTableReaders) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.max_open_files = -1;
+  Options cold_options = options;
+  cold_options.lazy_load_table_readers = true;
+  CreateAndReopenWithCF({"cold"}, options);
+  for (int cf = 0; cf < 2; ++cf) {
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_OK(Put(cf, Key(i), "v" + ToString(i)));
+      ASSERT_OK(Flush(cf));
+    }
+  }
+  ReopenWithColumnFamilies({"default", "cold"},
+                           std::vector<Options>{options, cold_options});
+
+  auto open_files = [&](int cf) {
+    std::vector<std::vector<FileMetaData>> files;
+    dbfull()->TEST_GetFilesMetaData(handles_[cf], &files);
+    int count = 0;
+    for (const auto& level : files) {
+      for (const auto& file : level) {
+        count += file.table_reader_handle != nullptr;
+      }
+    }
+    return count;
+  };
+  ASSERT_EQ(3, open_files(0));
+  // The cold column family opens its files on first access, through the
+  // table cache, and its new files are not opened either
+  ASSERT_EQ(0, open_files(1));
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ("v" + ToString(i), Get(1, Key(i)));
+  }
+  ASSERT_OK(Put(1, Key(3), "v3"));
+  ASSERT_OK(Flush(1));
+  ASSERT_EQ("v3", Get(1, Key(3)));
+  ASSERT_EQ("4", FilesPerLevel(1));
+  ASSERT_EQ(0, open_files(1));
+}
+
 TEST_F(DBSSTTest, GetTotalSstFilesSize) {
   // We don't propagate oldest-key-time table property on compaction and
   // just write 0 as default value. This affect the exact table size, since
@@ -327,6 +327,46 @@ TEST_F(DBTablePropertiesTest, GetColumnFamilyNameProperty) {
   }
 }
 
+TEST_F(DBTablePropertiesTest, UnpinnedTableProperties) {
+  Options options = CurrentOptions();
+  options.pin_table_properties_in_reader = false;
+  options.prefix_extractor.reset(NewFixedPrefixTransform(3));
+  options.table_properties_collector_factories.emplace_back(
+      std::make_shared<TerarkPropertiesCollectorFactory>());
+  BlockBasedTableOptions table_options;
+  table_options.index_type = BlockBasedTableOptions::kHashSearch;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  ASSERT_OK(Put("abc1", "v1"));
+  ASSERT_OK(Put("abc2", "v2"));
+  ASSERT_OK(Put("abd1", "v3"));
+  ASSERT_OK(Flush());
+  Reopen(options);
+
+  // The hash index and prefix checks run from the resident properties
+  ASSERT_EQ("v2", Get("abc2"));
+  ASSERT_EQ("NOT_FOUND", Get("abc3"));
+  ReadOptions read_options;
+  read_options.prefix_same_as_start = true;
+  std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+  int count = 0;
+  for (iter->Seek("abc"); iter->Valid(); iter->Next()) {
+    ++count;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(2, count);
+
+  // The full properties are read from the file on demand
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  ASSERT_EQ(1U, props.size());
+  auto& tp = *props.begin()->second;
+  ASSERT_EQ(3U, tp.num_entries);
+  ASSERT_EQ(options.prefix_extractor->Name(), tp.prefix_extractor_name);
+  ASSERT_EQ(1U, tp.user_collected_properties.count("terark"));
+}
+
 TEST_F(DBTablePropertiesTest, DeletionTriggeredCompactionMarking) {
   int kNumKeys = 1000;
   int kWindowSize = 100;
@@ -530,6 +530,45 @@ TEST_F(DBTestTailingIterator, SeekToFirstWithUpperBoundBug) {
   ASSERT_EQ(iter->key().ToString(), "aa");
 }
 
+TEST_F(DBTestTailingIterator, TailingIteratorRenewLevelIterator) {
+  ReadOptions read_options;
+  read_options.tailing = true;
+
+  ASSERT_OK(db_->Put(WriteOptions(), "aa", "1"));
+  ASSERT_OK(db_->Put(WriteOptions(), "bb", "2"));
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+
+  bool level_iter_renewed = false;
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "ForwardIterator::RenewIterators:Renew",
+      [&](void* /*arg*/) { level_iter_renewed = true; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+
+  std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+  iter->Seek("aa");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(iter->key().ToString(), "aa");
+
+  // The new L0 file changes the super version, L1 stays the same
+  ASSERT_OK(db_->Put(WriteOptions(), "cc", "3"));
+  ASSERT_OK(Flush());
+
+  iter->Seek("bb");
+  ASSERT_TRUE(level_iter_renewed);
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(iter->key().ToString(), "bb");
+  iter->Next();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(iter->key().ToString(), "cc");
+  iter->Next();
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_OK(iter->status());
+
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 #endif  // !defined(ROCKSDB_LITE)
@@ -3563,7 +3563,21 @@ TEST_P(DBTestWithParam, ThreadStatusSingleCompaction) {
       {"CompactionJob::Run():Start", "DBTest::ThreadStatusSingleCompaction:1"},
       {"DBTest::ThreadStatusSingleCompaction:2", "CompactionJob::Run():End"},
   });
+  // The progress of the compaction when all of its input is read
+  double progress = -1;
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::Run():End", [&](void* /*arg*/) {
+        std::vector<ThreadStatus> thread_list;
+        ASSERT_OK(env_->GetThreadList(&thread_list));
+        for (auto& ts : thread_list) {
+          if (ts.operation_type == ThreadStatus::OP_COMPACTION) {
+            progress = ThreadStatus::GetOperationProgress(ts.operation_type,
+                                                          ts.op_properties);
+          }
+        }
+      });
   for (int tests = 0; tests < 2; ++tests) {
+    progress = -1;
     DestroyAndReopen(options);
     TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearTrace();
     TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
@@ -3602,11 +3616,18 @@ TEST_P(DBTestWithParam, ThreadStatusSingleCompaction) {
     ASSERT_EQ(num_running_compactions, 1);
     // TODO(yhchiang): adding assert to verify each compaction stage.
     TEST_SYNC_POINT("DBTest::ThreadStatusSingleCompaction:2");
+    dbfull()->TEST_WaitForCompact();
+    if (options.enable_thread_tracking) {
+      ASSERT_GT(progress, 90);
+    } else {
+      ASSERT_LT(progress, 0);
+    }
 
     // repeat the test with disabling thread tracking.
     options.enable_thread_tracking = false;
     TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
   }
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
 }
 
 TEST_P(DBTestWithParam, PreShutdownManualCompaction) {
@@ -5312,19 +5333,27 @@ TEST_F(DBTest, HardLimit) {
 #if !defined(ROCKSDB_LITE) && !defined(ROCKSDB_DISABLE_STALL_NOTIFICATION)
 class WriteStallListener : public EventListener {
  public:
-  WriteStallListener() : condition_(WriteStallCondition::kNormal) {}
+  WriteStallListener()
+      : condition_(WriteStallCondition::kNormal),
+        cause_(WriteStallCause::kNone) {}
   void OnStallConditionsChanged(const WriteStallInfo& info) override {
     MutexLock l(&mutex_);
     condition_ = info.condition.cur;
+    cause_ = info.cause.cur;
   }
   bool CheckCondition(WriteStallCondition expected) {
     MutexLock l(&mutex_);
     return expected == condition_;
   }
+  bool CheckCause(WriteStallCause expected) {
+    MutexLock l(&mutex_);
+    return expected == cause_;
+  }
 
  private:
   port::Mutex mutex_;
   WriteStallCondition condition_;
+  WriteStallCause cause_;
 };
 
 TEST_F(DBTest, SoftLimit) {
@@ -5422,6 +5451,7 @@ TEST_F(DBTest, SoftLimit) {
   }
   ASSERT_TRUE(dbfull()->TEST_write_controler().NeedsDelay());
   ASSERT_TRUE(listener->CheckCondition(WriteStallCondition::kDelayed));
+  ASSERT_TRUE(listener->CheckCause(WriteStallCause::kL0FileCountLimit));
 
   sleeping_task_low.WakeUp();
   sleeping_task_low.WaitUntilDone();
@@ -5433,6 +5463,7 @@ TEST_F(DBTest, SoftLimit) {
   ASSERT_EQ(NumTableFilesAtLevel(1), 1);
   ASSERT_TRUE(!dbfull()->TEST_write_controler().NeedsDelay());
   ASSERT_TRUE(listener->CheckCondition(WriteStallCondition::kNormal));
+  ASSERT_TRUE(listener->CheckCause(WriteStallCause::kNone));
 
   // Only allow one compactin going through.
   TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
@@ -5514,6 +5545,50 @@ TEST_F(DBTest, SoftLimit) {
   sleeping_task_low.WaitUntilDone();
 }
 
+TEST_F(DBTest, WriteStallCauseStats) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.statistics = CreateDBStatistics();
+  options.level0_file_num_compaction_trigger = 2;
+  options.level0_slowdown_writes_trigger = 2;
+  options.level0_stop_writes_trigger = 999999;
+  options.delayed_write_rate = 1 << 20;
+  WriteStallListener* listener = new WriteStallListener();
+  options.listeners.emplace_back(listener);
+  Reopen(options);
+
+  // Block compactions
+  test::SleepingBackgroundTask sleeping_task_low;
+  env_->SetBackgroundThreads(1, Env::LOW);
+  env_->Schedule(&test::SleepingBackgroundTask::DoSleepTask, &sleeping_task_low,
+                 Env::Priority::LOW);
+  sleeping_task_low.WaitUntilSleeping();
+
+  for (int i = 0; i < 2; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+    ASSERT_OK(Flush());
+  }
+  ASSERT_TRUE(dbfull()->TEST_write_controler().NeedsDelay());
+
+  // Enough bytes to be delayed at 1MB/s
+  for (int i = 0; i < 64; i++) {
+    ASSERT_OK(Put(Key(i), std::string(10000, 'x')));
+  }
+  ASSERT_GT(TestGetTickerCount(options, STALL_MICROS), 0);
+  ASSERT_GT(TestGetTickerCount(options, STALL_L0_FILE_COUNT_LIMIT_MICROS), 0);
+  ASSERT_EQ(0, TestGetTickerCount(options, STALL_MEMTABLE_LIMIT_MICROS));
+  ASSERT_EQ(0,
+            TestGetTickerCount(options, STALL_PENDING_COMPACTION_BYTES_MICROS));
+  std::map<std::string, std::string> cf_stats;
+  ASSERT_TRUE(db_->GetMapProperty(DB::Properties::kCFStats, &cf_stats));
+  ASSERT_NE("0", cf_stats["io_stalls.level0_file_count_limit_micros"]);
+  ASSERT_EQ("0", cf_stats["io_stalls.memtable_limit_micros"]);
+  ASSERT_TRUE(listener->CheckCause(WriteStallCause::kL0FileCountLimit));
+
+  sleeping_task_low.WakeUp();
+  sleeping_task_low.WaitUntilDone();
+}
+
 TEST_F(DBTest, LastWriteBufferDelay) {
   Options options = CurrentOptions();
   options.env = env_;
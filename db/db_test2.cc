@@ -14,9 +14,12 @@
 #include "db/read_callback.h"
 #include "port/port.h"
 #include "port/stack_trace.h"
+#include "rocksdb/metrics_reporter.h"
 #include "rocksdb/persistent_cache.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/wal_filter.h"
+#include "util/coding.h"
+#include "util/trace_replay.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -2695,6 +2698,71 @@ TEST_F(DBTest2, TraceAndReplay) {
   ASSERT_OK(DestroyDB(dbname2, options));
 }
 
+TEST_F(DBTest2, MultiThreadTraceReplay) {
+  Options options = CurrentOptions();
+  ReadOptions ro;
+  TraceOptions trace_opts;
+  EnvOptions env_opts;
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  std::string trace_filename = dbname_ + "/rocksdb.trace";
+  std::unique_ptr<TraceWriter> trace_writer;
+  ASSERT_OK(NewFileTraceWriter(env_, env_opts, trace_filename, &trace_writer));
+  ASSERT_OK(db_->StartTrace(trace_opts, std::move(trace_writer)));
+  // Every key is overwritten, the replay keeps the order on a key
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(i % 2, Key(i % 50), "v" + ToString(i)));
+  }
+  std::vector<Slice> keys = {"a", "b"};
+  std::vector<std::string> values;
+  db_->MultiGet(ro, {handles_[0], handles_[1]}, keys, &values);
+  ASSERT_OK(db_->EndTrace());
+
+  std::string dbname2 = test::TmpDir(env_) + "/db_replay_mt";
+  ASSERT_OK(DestroyDB(dbname2, options));
+  DB* db2_init = nullptr;
+  options.create_if_missing = true;
+  ASSERT_OK(DB::Open(options, dbname2, &db2_init));
+  ColumnFamilyHandle* cf;
+  ASSERT_OK(
+      db2_init->CreateColumnFamily(ColumnFamilyOptions(), "pikachu", &cf));
+  delete cf;
+  delete db2_init;
+
+  DB* db2 = nullptr;
+  std::vector<ColumnFamilyDescriptor> column_families;
+  column_families.push_back(
+      ColumnFamilyDescriptor("default", ColumnFamilyOptions()));
+  column_families.push_back(
+      ColumnFamilyDescriptor("pikachu", ColumnFamilyOptions()));
+  std::vector<ColumnFamilyHandle*> handles;
+  ASSERT_OK(DB::Open(DBOptions(), dbname2, column_families, &handles, &db2));
+
+  std::unique_ptr<TraceReader> trace_reader;
+  ASSERT_OK(NewFileTraceReader(env_, env_opts, trace_filename, &trace_reader));
+  Replayer replayer(db2, handles_, std::move(trace_reader));
+  ASSERT_TRUE(replayer.SetFastForward(0.0).IsInvalidArgument());
+  ASSERT_OK(replayer.SetFastForward(10.0));
+  ASSERT_OK(replayer.MultiThreadReplay(4));
+
+  std::string value;
+  for (int i = 50; i < 100; ++i) {
+    ASSERT_OK(db2->Get(ro, handles[i % 2], Key(i % 50), &value));
+    ASSERT_EQ("v" + ToString(i), value);
+  }
+  std::map<TraceType, HistogramData> latency;
+  replayer.GetLatencyHistograms(&latency);
+  ASSERT_EQ(2U, latency.size());
+  ASSERT_EQ(100U, latency[kTraceWrite].count);
+  ASSERT_EQ(1U, latency[kTraceMultiGet].count);
+
+  for (auto handle : handles) {
+    delete handle;
+  }
+  delete db2;
+  ASSERT_OK(DestroyDB(dbname2, options));
+}
+
 TEST_F(DBTest2, TraceWithLimit) {
   Options options = CurrentOptions();
   options.merge_operator = MergeOperators::CreatePutOperator();
@@ -3098,6 +3166,296 @@ TEST_F(DBTest2, TestCompactFiles) {
 }
 #endif  // ROCKSDB_LITE
 
+namespace {
+// Counts the records of each reporter, keyed by "name tags"
+class CountingMetricsReporterFactory : public MetricsReporterFactory {
+ public:
+  class Hist : public HistReporterHandle {
+   public:
+    void AddRecord(size_t /*val*/) override { ++count; }
+    std::atomic<size_t> count{0};
+  };
+  class Count : public CountReporterHandle {
+   public:
+    void AddCount(size_t /*val*/) override {}
+  };
+
+  HistReporterHandle* BuildHistReporter(const std::string& name,
+                                        const std::string& tags,
+                                        Logger* /*log*/) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return &hist_[name + " " + tags];
+  }
+  CountReporterHandle* BuildCountReporter(const std::string& /*name*/,
+                                          const std::string& /*tags*/,
+                                          Logger* /*log*/) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_.emplace_back();
+    return &count_.back();
+  }
+
+  size_t Records(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hist_.find(key);
+    return it == hist_.end() ? 0 : it->second.count.load();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<std::string, Hist> hist_;
+  std::list<Count> count_;
+};
+}  // namespace
+
+TEST_F(DBTest2, MetricsReporterPerColumnFamily) {
+  auto factory = std::make_shared<CountingMetricsReporterFactory>();
+  Options options = CurrentOptions();
+  options.metrics_reporter_factory = factory;
+  CreateAndReopenWithCF({"pikachu"}, options);
+  std::string cf_tags = "dbname=" + dbname_ + "|cfname=pikachu";
+
+  ASSERT_OK(Put(1, "foo", "v1"));
+  ASSERT_OK(Flush(1));
+  ASSERT_EQ("v1", Get(1, "foo"));
+  ASSERT_OK(db_->SyncWAL());
+
+  ASSERT_GT(factory->Records("dbimpl_write_group_size dbname=" + dbname_), 0);
+  ASSERT_GT(
+      factory->Records("dbimpl_write_memtable_latency dbname=" + dbname_), 0);
+  ASSERT_GT(factory->Records("dbimpl_write_wal_latency dbname=" + dbname_), 0);
+  ASSERT_GT(factory->Records("dbimpl_wal_sync_latency dbname=" + dbname_), 0);
+  ASSERT_GT(factory->Records("cfd_flush_build_table_latency " + cf_tags), 0);
+  ASSERT_GT(factory->Records("cfd_superversion_acquire_latency " + cf_tags),
+            0);
+}
+
+#ifndef ROCKSDB_LITE
+namespace {
+class MemoryTraceWriter : public TraceWriter {
+ public:
+  explicit MemoryTraceWriter(std::vector<Trace>* traces) : traces_(traces) {}
+
+  Status Write(const Slice& data) override {
+    Trace trace;
+    trace.ts = DecodeFixed64(data.data());
+    trace.type = static_cast<TraceType>(data[kTraceTimestampSize]);
+    trace.payload.assign(data.data() + kTraceMetadataSize,
+                         data.size() - kTraceMetadataSize);
+    traces_->push_back(std::move(trace));
+    size_ += data.size();
+    return Status::OK();
+  }
+  Status Close() override { return Status::OK(); }
+  uint64_t GetFileSize() override { return size_; }
+
+ private:
+  std::vector<Trace>* traces_;
+  uint64_t size_ = 0;
+};
+}  // namespace
+
+TEST_F(DBTest2, PerfTraceSampling) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  Reopen(options);
+  ASSERT_OK(Put("foo", "v"));
+  ASSERT_OK(Flush());
+
+  std::vector<Trace> traces;
+  PerfTraceOptions trace_options;
+  trace_options.sample_rate = 4;
+  ASSERT_OK(db_->StartPerfTrace(
+      trace_options,
+      std::unique_ptr<TraceWriter>(new MemoryTraceWriter(&traces))));
+  ASSERT_TRUE(db_->StartPerfTrace(trace_options,
+                                  std::unique_ptr<TraceWriter>(
+                                      new MemoryTraceWriter(&traces)))
+                  .IsBusy());
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_EQ("v", Get("foo"));
+  }
+  ASSERT_EQ(PerfLevel::kEnableCount, GetPerfLevel());
+  ASSERT_FALSE(get_perf_context()->per_level_perf_context_enabled);
+  // A thread timing its operations itself is not sampled
+  SetPerfLevel(PerfLevel::kEnableTime);
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_EQ("v", Get("foo"));
+  }
+  SetPerfLevel(PerfLevel::kEnableCount);
+  ASSERT_OK(db_->EndPerfTrace());
+  ASSERT_TRUE(db_->EndPerfTrace().IsNotFound());
+
+  ASSERT_EQ(12U, traces.size());
+  ASSERT_EQ(kTraceBegin, traces.front().type);
+  ASSERT_EQ(kTraceEnd, traces.back().type);
+  for (size_t i = 1; i + 1 < traces.size(); ++i) {
+    PerfTraceOp op;
+    uint32_t cf_id;
+    uint64_t latency_micros;
+    std::string perf_context, iostats_context;
+    ASSERT_OK(PerfTracer::DecodeSample(traces[i], &op, &cf_id,
+                                       &latency_micros, &perf_context,
+                                       &iostats_context));
+    ASSERT_EQ(kPerfTraceGet, op);
+    ASSERT_EQ(0U, cf_id);
+    // The level and the number of files read
+    ASSERT_NE(std::string::npos,
+              perf_context.find("get_from_table_count = 1@level0"));
+  }
+}
+
+TEST_F(DBTest2, TableAccessTrace) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.blob_cache = NewLRUCache(1 << 20);
+  Reopen(options);
+  Random rnd(301);
+  const int kNumKeys = 10;
+  std::vector<std::string> expect(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    expect[i] = RandomString(&rnd, 64 + i);
+    ASSERT_OK(Put(Key(i), expect[i]));
+  }
+  ASSERT_OK(Flush());
+
+  std::vector<Trace> traces;
+  TableAccessTraceOptions trace_options;
+  ASSERT_OK(db_->StartTableAccessTrace(
+      trace_options,
+      std::unique_ptr<TraceWriter>(new MemoryTraceWriter(&traces))));
+  ASSERT_TRUE(db_->StartTableAccessTrace(trace_options,
+                                         std::unique_ptr<TraceWriter>(
+                                             new MemoryTraceWriter(&traces)))
+                  .IsBusy());
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_EQ(expect[i], Get(Key(i)));
+    }
+  }
+  ASSERT_OK(db_->EndTableAccessTrace());
+  ASSERT_TRUE(db_->EndTableAccessTrace().IsNotFound());
+
+  ASSERT_EQ(2U * kNumKeys + 2, traces.size());
+  ASSERT_EQ(kTraceBegin, traces.front().type);
+  ASSERT_EQ(kTraceEnd, traces.back().type);
+  std::vector<TableAccessRecord> records(traces.size() - 2);
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_OK(TableAccessTracer::DecodeAccess(traces[i + 1], &records[i]));
+    ASSERT_EQ(kTableAccessBlob, records[i].type);
+    ASSERT_EQ(kTableAccessFetch, records[i].caller);
+  }
+  // Misses first, then the same records from the blob cache
+  for (int i = 0; i < kNumKeys; ++i) {
+    auto& miss = records[i];
+    auto& hit = records[i + kNumKeys];
+    ASSERT_FALSE(miss.is_cache_hit);
+    ASSERT_TRUE(hit.is_cache_hit);
+    ASSERT_EQ(miss.file_number, hit.file_number);
+    ASSERT_EQ(miss.record, hit.record);
+    ASSERT_EQ(expect[i].size(), miss.size);
+    ASSERT_EQ(expect[i].size(), hit.size);
+  }
+}
+
+TEST_F(DBTest2, GetLatestSequenceForKeys) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  Reopen(options);
+
+  ASSERT_OK(Put("a", "v"));
+  SequenceNumber put_seq = db_->GetLatestSequenceNumber();
+  ASSERT_OK(Put("b", "v"));
+  ASSERT_OK(Merge("c", "v"));
+  ASSERT_OK(Merge("c", "w"));
+  ASSERT_OK(Flush());
+  SequenceNumber flushed_seq = db_->GetLatestSequenceNumber();
+  ASSERT_OK(Delete("b"));
+  SequenceNumber delete_seq = db_->GetLatestSequenceNumber();
+
+  std::vector<Slice> keys = {"c", "b", "missing", "a"};
+  std::vector<SequenceNumber> seqs;
+  auto cfd =
+      reinterpret_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())
+          ->cfd();
+  SuperVersion* sv = dbfull()->GetAndRefSuperVersion(cfd);
+  ASSERT_OK(dbfull()->GetLatestSequenceForKeys(sv, keys, true /* cache_only */,
+                                               &seqs));
+  ASSERT_EQ(seqs.size(), 4);
+  ASSERT_EQ(kMaxSequenceNumber, seqs[0]);
+  ASSERT_EQ(delete_seq, seqs[1]);
+  ASSERT_EQ(kMaxSequenceNumber, seqs[2]);
+  ASSERT_EQ(kMaxSequenceNumber, seqs[3]);
+
+  // The latest record of each key in the SST, without merging the operands
+  ASSERT_OK(dbfull()->GetLatestSequenceForKeys(sv, keys, false /* cache_only */,
+                                               &seqs));
+  ASSERT_EQ(flushed_seq, seqs[0]);
+  ASSERT_EQ(delete_seq, seqs[1]);
+  ASSERT_EQ(kMaxSequenceNumber, seqs[2]);
+  ASSERT_EQ(put_seq, seqs[3]);
+  dbfull()->ReturnAndCleanupSuperVersion(cfd, sv);
+}
+
+TEST_F(DBTest2, MultiGetSeqno) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.blob_cache = NewLRUCache(1 << 20);
+  options.statistics = CreateDBStatistics();
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  Random rnd(301);
+  ASSERT_OK(Put(0, "a", RandomString(&rnd, 100)));
+  SequenceNumber a_seq = db_->GetLatestSequenceNumber();
+  ASSERT_OK(Put(1, "b", RandomString(&rnd, 100)));
+  SequenceNumber b_seq = db_->GetLatestSequenceNumber();
+  ASSERT_OK(Put(0, "c", RandomString(&rnd, 100)));
+  ASSERT_OK(Flush(0));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(Delete(0, "c"));
+  SequenceNumber c_seq = db_->GetLatestSequenceNumber();
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Put(0, "a", "v"));
+
+  // The separated values are never fetched
+  uint64_t blob_reads =
+      TestGetTickerCount(options, BLOB_CACHE_HIT) +
+      TestGetTickerCount(options, BLOB_CACHE_MISS);
+  ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  std::vector<EntrySeqno> entries;
+  auto statuses = db_->MultiGetSeqno(
+      read_options, {handles_[0], handles_[1], handles_[0], handles_[1]},
+      {"a", "b", "c", "a"}, &entries);
+  ASSERT_EQ(statuses.size(), 4);
+  for (auto& s : statuses) {
+    ASSERT_OK(s);
+  }
+  ASSERT_TRUE(entries[0].found);
+  ASSERT_FALSE(entries[0].deleted);
+  ASSERT_EQ(a_seq, entries[0].seqno);
+  ASSERT_TRUE(entries[1].found);
+  ASSERT_FALSE(entries[1].deleted);
+  ASSERT_EQ(b_seq, entries[1].seqno);
+  ASSERT_TRUE(entries[2].found);
+  ASSERT_TRUE(entries[2].deleted);
+  ASSERT_EQ(c_seq, entries[2].seqno);
+  ASSERT_FALSE(entries[3].found);
+  ASSERT_EQ(blob_reads, TestGetTickerCount(options, BLOB_CACHE_HIT) +
+                            TestGetTickerCount(options, BLOB_CACHE_MISS));
+
+  EntrySeqno entry;
+  ASSERT_OK(db_->GetSeqno(ReadOptions(), handles_[0], "a", &entry));
+  ASSERT_TRUE(entry.found);
+  ASSERT_EQ(db_->GetLatestSequenceNumber(), entry.seqno);
+  db_->ReleaseSnapshot(snapshot);
+}
+#endif  // ROCKSDB_LITE
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
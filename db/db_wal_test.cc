@@ -600,6 +600,31 @@ TEST_F(DBWALTest, RecoverWithLargeLog) {
   } while (ChangeWalOptions());
 }
 
+TEST_F(DBWALTest, RecoverWithLargeLogReadahead) {
+  {
+    Options options = CurrentOptions();
+    CreateAndReopenWithCF({"pikachu"}, options);
+    ASSERT_OK(Put(1, "big1", std::string(200000, '1')));
+    ASSERT_OK(Put(1, "big2", std::string(200000, '2')));
+    ASSERT_OK(Put(1, "small3", std::string(10, '3')));
+    ASSERT_OK(Put(1, "small4", std::string(10, '4')));
+    ASSERT_EQ(NumTableFilesAtLevel(0, 1), 0);
+  }
+
+  // Read one record ahead at a time while memtables are flushed in the
+  // middle of the log
+  Options options;
+  options.write_buffer_size = 100000;
+  options.wal_recovery_readahead_size = 1;
+  options = CurrentOptions(options);
+  ReopenWithColumnFamilies({"default", "pikachu"}, options);
+  ASSERT_EQ(NumTableFilesAtLevel(0, 1), 3);
+  ASSERT_EQ(std::string(200000, '1'), Get(1, "big1"));
+  ASSERT_EQ(std::string(200000, '2'), Get(1, "big2"));
+  ASSERT_EQ(std::string(10, '3'), Get(1, "small3"));
+  ASSERT_EQ(std::string(10, '4'), Get(1, "small4"));
+}
+
 // In https://reviews.facebook.net/D20661 we change
 // recovery behavior: previously for each log file each column family
 // memtable was flushed, even it was empty. Now it's changed:
@@ -1078,6 +1103,30 @@ TEST_F(DBWALTest, kPointInTimeRecovery) {
 // Test scope:
 // - We expect to open the data store under all scenarios
 // - We expect to have recovered records past the corruption zone
+// Reading the WAL ahead on another thread must stop replay at exactly the
+// same record as reading it inline.
+TEST_F(DBWALTest, kPointInTimeRecoveryWithReadahead) {
+  const int j = RecoveryTestHelper::kWALFileOffset + 1;
+  for (auto trunc : {true, false}) { /* Corruption style */
+    for (int i = 1; i < 3; i++) {    /* Offset of corruption */
+      size_t recovered_row_counts[2];
+      for (int readahead = 0; readahead < 2; ++readahead) {
+        Options options = CurrentOptions();
+        RecoveryTestHelper::FillData(this, &options);
+        RecoveryTestHelper::CorruptWAL(this, options, /*off=*/i * .3,
+                                       /*len%=*/.1, j, trunc);
+
+        options.wal_recovery_mode = WALRecoveryMode::kPointInTimeRecovery;
+        options.wal_recovery_readahead_size = readahead ? 4096 : 0;
+        options.create_if_missing = false;
+        ASSERT_OK(TryReopen(options));
+        recovered_row_counts[readahead] = RecoveryTestHelper::GetData(this);
+      }
+      ASSERT_EQ(recovered_row_counts[0], recovered_row_counts[1]);
+    }
+  }
+}
+
 TEST_F(DBWALTest, kSkipAnyCorruptedRecords) {
   const int jstart = RecoveryTestHelper::kWALFileOffset;
   const int jend = jstart + RecoveryTestHelper::kWALFilesCount;
@@ -161,6 +161,47 @@ TEST_P(DBWriteTest, LockWalInEffect) {
   ASSERT_OK(dbfull()->UnlockWAL());
 }
 
+TEST_P(DBWriteTest, GroupCommitDelay) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumWrites = 200;
+  Options options = GetOptions();
+  options.max_write_group_commit_delay_usec = 10000;
+  Reopen(options);
+  std::atomic<int> wait_count{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "WriteThread::AwaitGroupCommit:Wait", [&](void* arg) {
+        auto* w = reinterpret_cast<WriteThread::Writer*>(arg);
+        ASSERT_TRUE(w->sync);
+        wait_count++;
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  std::vector<port::Thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.push_back(port::Thread(
+        [&](int index) {
+          WriteOptions write_options;
+          write_options.sync = true;
+          for (int j = 0; j < kNumWrites; j++) {
+            ASSERT_OK(dbfull()->Put(
+                write_options,
+                "key" + ToString(index) + "_" + ToString(j), "value"));
+          }
+        },
+        i));
+  }
+  for (int i = 0; i < kNumThreads; i++) {
+    threads[i].join();
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_GT(wait_count.load(), 0);
+  for (int i = 0; i < kNumThreads; i++) {
+    for (int j = 0; j < kNumWrites; j++) {
+      ASSERT_EQ("value", Get("key" + ToString(i) + "_" + ToString(j)));
+    }
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(DBWriteTestInstance, DBWriteTest,
                         testing::Values(DBTestBase::kDefault,
                                         DBTestBase::kConcurrentWALWrites,
@@ -227,6 +227,20 @@ Status SeparateHelper::TransToSeparate(
   }
 }
 
+Status ProjectValue(const ValueExtractor* projection, const Slice& user_key,
+                    LazyBuffer* value) {
+  auto s = value->fetch();
+  if (!s.ok()) {
+    return s;
+  }
+  std::string projected;
+  s = projection->Extract(user_key, value->slice(), &projected);
+  if (s.ok()) {
+    value->reset(projected, true /* copy */);
+  }
+  return s;
+}
+
 Slice ArenaPinSlice(const Slice& slice, Arena* arena) {
   char* buf = static_cast<char*>(arena->Allocate(slice.size() + 1));
   memcpy(buf, slice.data(), slice.size());
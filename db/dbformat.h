@@ -10,6 +10,7 @@
 #pragma once
 #include <stdio.h>
 
+#include <memory>
 #include <numeric>
 #include <string>
 #include <utility>
@@ -157,6 +158,24 @@ inline ValueType ExtractValueType(const Slice& internal_key) {
   return static_cast<ValueType>(c);
 }
 
+// Zero padded big endian prefix of a user key. Under the bytewise
+// comparator, keys whose fences differ compare like their fences
+inline uint64_t UserKeyFence(const Slice& user_key) {
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(user_key.data());
+  if (user_key.size() >= sizeof(uint64_t)) {
+    return (uint64_t(p[0]) << 56) | (uint64_t(p[1]) << 48) |
+           (uint64_t(p[2]) << 40) | (uint64_t(p[3]) << 32) |
+           (uint64_t(p[4]) << 24) | (uint64_t(p[5]) << 16) |
+           (uint64_t(p[6]) << 8) | uint64_t(p[7]);
+  }
+  uint64_t fence = 0;
+  for (size_t i = 0; i < user_key.size(); ++i) {
+    fence |= uint64_t(p[i]) << (56 - i * 8);
+  }
+  return fence;
+}
+
 // A comparator for internal keys that uses a specified comparator for
 // the user key portion and breaks ties by decreasing sequence number.
 class InternalKeyComparator
@@ -829,8 +848,27 @@ class SeparateHelper {
 
   virtual LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                                      const LazyBuffer& value) const = 0;
+
+  // State kept by a forward scan between FetchForward calls
+  class ForwardState {
+   public:
+    virtual ~ForwardState() = default;
+  };
+
+  // Fetch "value" returned by TransToCombined for a forward scan. Blob SST
+  // iterators reading ahead "readahead_size" bytes are kept in "*state", so
+  // values of consecutive keys share data blocks.
+  virtual Status FetchForward(LazyBuffer* value, size_t /*readahead_size*/,
+                              std::unique_ptr<ForwardState>* /*state*/) const {
+    return value->fetch();
+  }
 };
 
+// Replace the fetched "*value" of "user_key" by the output of "projection",
+// see ReadOptions::value_projection
+extern Status ProjectValue(const ValueExtractor* projection,
+                           const Slice& user_key, LazyBuffer* value);
+
 extern Slice ArenaPinSlice(const Slice& slice, Arena* arena);
 extern Slice ArenaPinInternalKey(const Slice& user_key, SequenceNumber seq,
                                  ValueType type, Arena* arena);
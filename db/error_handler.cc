@@ -8,6 +8,7 @@
 #include "db/db_impl.h"
 #include "db/event_helpers.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/logging.h"
 #include "util/sst_file_manager_impl.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -97,6 +98,13 @@ std::map<std::tuple<BackgroundErrorReason, Status::Code, bool>,
         {std::make_tuple(BackgroundErrorReason::kWriteCallback,
                          Status::Code::kIOError, false),
          Status::Severity::kNoError},
+        // Errors found by the checksum scrubber
+        {std::make_tuple(BackgroundErrorReason::kChecksumScrub,
+                         Status::Code::kCorruption, true),
+         Status::Severity::kUnrecoverableError},
+        {std::make_tuple(BackgroundErrorReason::kChecksumScrub,
+                         Status::Code::kCorruption, false),
+         Status::Severity::kNoError},
 };
 
 std::map<std::tuple<BackgroundErrorReason, bool>, Status::Severity>
@@ -121,8 +129,78 @@ std::map<std::tuple<BackgroundErrorReason, bool>, Status::Severity>
          Status::Severity::kFatalError},
         {std::make_tuple(BackgroundErrorReason::kMemTable, false),
          Status::Severity::kFatalError},
+        // Errors found by the checksum scrubber
+        {std::make_tuple(BackgroundErrorReason::kChecksumScrub, true),
+         Status::Severity::kNoError},
+        {std::make_tuple(BackgroundErrorReason::kChecksumScrub, false),
+         Status::Severity::kNoError},
 };
 
+int* ErrorHandler::Retries(BackgroundErrorReason reason) {
+  switch (reason) {
+    case BackgroundErrorReason::kFlush:
+      return &flush_retries_;
+    case BackgroundErrorReason::kCompaction:
+      return &compaction_retries_;
+    default:
+      return nullptr;
+  }
+}
+
+bool ErrorHandler::IsRetrying(BackgroundErrorReason reason) {
+  db_mutex_->AssertHeld();
+  int* retries = Retries(reason);
+  return retries != nullptr && *retries > 0;
+}
+
+void ErrorHandler::ResetRetries(BackgroundErrorReason reason) {
+  db_mutex_->AssertHeld();
+  int* retries = Retries(reason);
+  if (retries != nullptr) {
+    *retries = 0;
+  }
+}
+
+uint64_t ErrorHandler::RetryWaitMicros(BackgroundErrorReason reason) {
+  db_mutex_->AssertHeld();
+  int* retries = Retries(reason);
+  if (retries == nullptr || *retries == 0) {
+    return 1000000;
+  }
+  // Backs off exponentially, up to 64 times the interval. Clamped so that it
+  // fits the int of Env::SleepForMicroseconds
+  const uint64_t kMaxWaitMicros = port::kMaxInt32;
+  int shift = std::min(*retries - 1, 6);
+  uint64_t interval = db_options_.bgerror_resume_retry_interval;
+  if (interval > (kMaxWaitMicros >> shift)) {
+    return kMaxWaitMicros;
+  }
+  return interval << shift;
+}
+
+// I/O errors other than running out of space may be transient, e.g. an
+// unreachable remote storage. Up to max_bgerror_resume_count of them in a row
+// are not taken as background error, the failed jobs are run again after
+// RetryWaitMicros() instead
+bool ErrorHandler::RetryBGJob(const Status& bg_err,
+                              BackgroundErrorReason reason) {
+  int* retries = Retries(reason);
+  if (retries == nullptr || recovery_in_prog_ || !bg_err.IsIOError() ||
+      bg_err.subcode() == Status::SubCode::kNoSpace ||
+      bg_err.subcode() == Status::SubCode::kSpaceLimit ||
+      *retries >= db_options_.max_bgerror_resume_count) {
+    return false;
+  }
+  ++*retries;
+  ROCKS_LOG_WARN(db_options_.info_log,
+                 "Background %s error: %s, retry %d of %d",
+                 reason == BackgroundErrorReason::kFlush ? "flush"
+                                                         : "compaction",
+                 bg_err.ToString().c_str(), *retries,
+                 db_options_.max_bgerror_resume_count);
+  return true;
+}
+
 void ErrorHandler::CancelErrorRecovery() {
 #ifndef ROCKSDB_LITE
   db_mutex_->AssertHeld();
@@ -147,6 +225,8 @@ void ErrorHandler::CancelErrorRecovery() {
 // This is the main function for looking at an error during a background
 // operation and deciding the severity, and error recovery strategy. The high
 // level algorithm is as follows -
+// 0. Leave a transient I/O error of a flush or compaction to be retried, see
+//    RetryBGJob()
 // 1. Classify the severity of the error based on the ErrorSeverityMap,
 //    DefaultErrorSeverityMap and DefaultReasonMap defined earlier
 // 2. Call a Status code specific override function to adjust the severity
@@ -170,6 +250,10 @@ Status ErrorHandler::SetBGError(const Status& bg_err,
     return Status::OK();
   }
 
+  if (RetryBGJob(bg_err, reason)) {
+    return bg_error_;
+  }
+
   // Check if recovery is currently in progress. If it is, we will save this
   // error so we can check it at the end to see if recovery succeeded or not
   if (recovery_in_prog_ && recovery_error_.ok()) {
@@ -24,7 +24,9 @@ class ErrorHandler {
         recovery_error_(Status::OK()),
         db_mutex_(db_mutex),
         auto_recovery_(false),
-        recovery_in_prog_(false) {}
+        recovery_in_prog_(false),
+        flush_retries_(0),
+        compaction_retries_(0) {}
   ~ErrorHandler() {}
 
   void EnableAutoRecovery() { auto_recovery_ = true; }
@@ -53,6 +55,15 @@ class ErrorHandler {
 
   bool IsRecoveryInProgress() { return recovery_in_prog_; }
 
+  // Whether the last failures of the background jobs of reason were left to
+  // be retried, see DBOptions::max_bgerror_resume_count
+  bool IsRetrying(BackgroundErrorReason reason);
+  // Called once a background job of reason succeeded
+  void ResetRetries(BackgroundErrorReason reason);
+  // The wait before running again a background job failed for reason, at
+  // most port::kMaxInt32
+  uint64_t RetryWaitMicros(BackgroundErrorReason reason);
+
   Status RecoverFromBGError(bool is_manual = false);
   void CancelErrorRecovery();
 
@@ -67,7 +78,13 @@ class ErrorHandler {
   // A flag indicating whether automatic recovery from errors is enabled
   bool auto_recovery_;
   bool recovery_in_prog_;
+  // The failures in a row retried of the flushes, and of the compactions and
+  // garbage collections
+  int flush_retries_;
+  int compaction_retries_;
 
+  int* Retries(BackgroundErrorReason reason);
+  bool RetryBGJob(const Status& bg_err, BackgroundErrorReason reason);
   Status OverrideNoSpaceError(Status bg_error, bool* auto_recovery);
   void RecoverFromNoSpace();
 };
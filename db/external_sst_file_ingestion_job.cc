@@ -14,6 +14,8 @@
 #include <inttypes.h>
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -31,19 +33,47 @@
 
 namespace TERARKDB_NAMESPACE {
 
+namespace {
+// Calls func for every index in [0, n) on up to max_threads threads, the
+// calling thread included
+void ParallelForEachFile(size_t n, int max_threads,
+                         const std::function<void(size_t)>& func) {
+  std::atomic<size_t> next_idx(0);
+  auto worker = [&]() {
+    for (size_t i = next_idx.fetch_add(1); i < n; i = next_idx.fetch_add(1)) {
+      func(i);
+    }
+  };
+  std::vector<port::Thread> threads;
+  for (int i = 1; i < max_threads && static_cast<size_t>(i) < n; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+}  // namespace
+
 Status ExternalSstFileIngestionJob::Prepare(
     const std::vector<std::string>& external_files_paths,
     uint64_t next_file_number, SuperVersion* sv) {
   Status status;
+  // Bulk loads pass thousands of files, open and copy them concurrently
+  int max_threads = std::max(1, db_options_.max_file_opening_threads);
+  std::vector<Status> file_status(external_files_paths.size());
 
   // Read the information of files we are ingesting
-  for (const std::string& file_path : external_files_paths) {
-    IngestedFileInfo file_to_ingest;
-    status = GetIngestedFileInfo(file_path, &file_to_ingest, sv);
-    if (!status.ok()) {
-      return status;
+  files_to_ingest_.resize(external_files_paths.size());
+  ParallelForEachFile(files_to_ingest_.size(), max_threads, [&](size_t i) {
+    file_status[i] = GetIngestedFileInfo(external_files_paths[i],
+                                         &files_to_ingest_[i], sv);
+  });
+  for (auto& s : file_status) {
+    if (!s.ok()) {
+      files_to_ingest_.clear();
+      return s;
     }
-    files_to_ingest_.push_back(file_to_ingest);
   }
 
   for (const IngestedFileInfo& f : files_to_ingest_) {
@@ -90,38 +120,53 @@ Status ExternalSstFileIngestionJob::Prepare(
   // Copy/Move external files into DB
   for (IngestedFileInfo& f : files_to_ingest_) {
     f.fd = FileDescriptor(next_file_number++, 0, f.file_size);
-
+  }
+  std::atomic<bool> failed(false);
+  ParallelForEachFile(files_to_ingest_.size(), max_threads, [&](size_t i) {
+    if (failed.load(std::memory_order_relaxed)) {
+      return;
+    }
+    IngestedFileInfo& f = files_to_ingest_[i];
     const std::string path_outside_db = f.external_file_path;
     const std::string path_inside_db = TableFileName(
         cfd_->ioptions()->cf_paths, f.fd.GetNumber(), f.fd.GetPathId());
 
+    Status s;
     if (ingestion_options_.move_files) {
-      status = env_->LinkFile(path_outside_db, path_inside_db);
-      if (status.IsNotSupported()) {
+      s = env_->LinkFile(path_outside_db, path_inside_db);
+      if (s.IsNotSupported()) {
         // Original file is on a different FS, use copy instead of hard linking
-        status = CopyFile(env_, path_outside_db, path_inside_db, 0,
-                          db_options_.use_fsync);
+        s = CopyFile(env_, path_outside_db, path_inside_db, 0,
+                     db_options_.use_fsync);
         f.copy_file = true;
       } else {
         f.copy_file = false;
       }
     } else {
-      status = CopyFile(env_, path_outside_db, path_inside_db, 0,
-                        db_options_.use_fsync);
+      s = CopyFile(env_, path_outside_db, path_inside_db, 0,
+                   db_options_.use_fsync);
       f.copy_file = true;
     }
     TEST_SYNC_POINT("ExternalSstFileIngestionJob::Prepare:FileAdded");
-    if (!status.ok()) {
-      break;
+    if (!s.ok()) {
+      file_status[i] = s;
+      failed.store(true, std::memory_order_relaxed);
+      return;
     }
     f.internal_file_path = path_inside_db;
+  });
+  for (auto& s : file_status) {
+    if (!s.ok()) {
+      status = s;
+      break;
+    }
   }
 
   if (!status.ok()) {
     // We failed, remove all files that we copied into the db
     for (IngestedFileInfo& f : files_to_ingest_) {
       if (f.internal_file_path.empty()) {
-        break;
+        continue;
       }
       Status s = env_->DeleteFile(f.internal_file_path);
       if (!s.ok()) {
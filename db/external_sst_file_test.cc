@@ -1337,6 +1337,86 @@ TEST_F(ExternalSSTFileTest, IngestNonExistingFile) {
   ASSERT_EQ(1, num_sst_files);
 }
 
+TEST_F(ExternalSSTFileTest, IngestManyFilesInParallel) {
+  Options options = CurrentOptions();
+  options.max_file_opening_threads = 4;
+  DestroyAndReopen(options);
+
+  const int kNumFiles = 40;
+  const int kKeysPerFile = 10;
+  std::vector<std::string> files;
+  SstFileWriter sst_file_writer(EnvOptions(), options);
+  // Pass the files in reverse key order
+  for (int i = kNumFiles - 1; i >= 0; --i) {
+    std::string file = sst_files_dir_ + "parallel_" + ToString(i) + ".sst";
+    ASSERT_OK(sst_file_writer.Open(file));
+    for (int k = i * kKeysPerFile; k < (i + 1) * kKeysPerFile; k++) {
+      ASSERT_OK(sst_file_writer.Put(Key(k), Key(k) + "_val"));
+    }
+    ASSERT_OK(sst_file_writer.Finish());
+    files.push_back(file);
+  }
+
+  std::atomic<int> files_added(0);
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "ExternalSstFileIngestionJob::Prepare:FileAdded",
+      [&](void* /* arg */) { files_added.fetch_add(1); });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+
+  ASSERT_OK(db_->IngestExternalFile(files, IngestExternalFileOptions()));
+  ASSERT_EQ(kNumFiles, files_added.load());
+  for (int k = 0; k < kNumFiles * kKeysPerFile; k++) {
+    ASSERT_EQ(Key(k) + "_val", Get(Key(k)));
+  }
+
+  // A missing file fails the whole ingestion before anything is copied
+  files_added.store(0);
+  files.push_back("non_existing_file");
+  ASSERT_NOK(db_->IngestExternalFile(files, IngestExternalFileOptions()));
+  ASSERT_EQ(0, files_added.load());
+
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(ExternalSSTFileTest, ParallelSstFileWriter) {
+  Options options = CurrentOptions();
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 1000;
+  ParallelSstFileWriter writer(EnvOptions(), options, nullptr,
+                               3 /* max_threads */,
+                               1024 /* target_file_size */);
+  ASSERT_OK(writer.Open(sst_files_dir_ + "bulk_"));
+  for (int k = 0; k < kNumKeys; k++) {
+    ASSERT_OK(writer.Put(Key(k), Key(k) + "_val"));
+  }
+  ASSERT_TRUE(writer.Put(Key(0), "out_of_order").IsInvalidArgument());
+  std::vector<ExternalSstFileInfo> file_infos;
+  ASSERT_OK(writer.Finish(&file_infos));
+  ASSERT_GT(file_infos.size(), 1U);
+
+  std::vector<std::string> files;
+  uint64_t num_entries = 0;
+  for (size_t i = 0; i < file_infos.size(); i++) {
+    if (i > 0) {
+      ASSERT_LT(file_infos[i - 1].largest_key, file_infos[i].smallest_key);
+    }
+    num_entries += file_infos[i].num_entries;
+    files.push_back(file_infos[i].file_path);
+  }
+  ASSERT_EQ(static_cast<uint64_t>(kNumKeys), num_entries);
+
+  ASSERT_OK(db_->IngestExternalFile(files, IngestExternalFileOptions()));
+  for (int k = 0; k < kNumKeys; k++) {
+    ASSERT_EQ(Key(k) + "_val", Get(Key(k)));
+  }
+
+  // Nothing was added
+  ASSERT_OK(writer.Open(sst_files_dir_ + "empty_"));
+  ASSERT_TRUE(writer.Finish().IsInvalidArgument());
+}
+
 TEST_F(ExternalSSTFileTest, CompactDuringAddFileRandom) {
   Options options = CurrentOptions();
   options.disable_auto_compactions = false;
@@ -16,6 +16,7 @@
 #include <inttypes.h>
 
 #include <algorithm>
+#include <thread>
 #include <vector>
 
 #include "db/builder.h"
@@ -24,6 +25,7 @@
 #include "db/event_helpers.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
+#include "db/map_builder.h"
 #include "db/memtable.h"
 #include "db/memtable_list.h"
 #include "db/merge_context.h"
@@ -52,11 +54,121 @@
 #include "util/log_buffer.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/parallel_for.h"
 #include "util/stop_watch.h"
 #include "util/sync_point.h"
 
 namespace TERARKDB_NAMESPACE {
 
+namespace {
+
+// A memtable whose ApproximateMemoryUsage is below this many bytes per
+// partition is never split, since a single thread flushes it fast enough.
+const size_t kMinFlushPartitionBytes = 64ull << 20;
+
+// Restricts the flush input to the user keys in [lower, upper), so one
+// partition sees every version of its keys and nothing else.
+class FlushPartitionIterator : public InternalIterator {
+ public:
+  FlushPartitionIterator(InternalIterator* iter, const Comparator* ucmp,
+                         const std::string* lower, const std::string* upper)
+      : iter_(iter), ucmp_(ucmp), lower_(lower), upper_(upper) {}
+
+  // iter_ is allocated in the same arena as this iterator
+  ~FlushPartitionIterator() override { iter_->~InternalIterator(); }
+
+  bool Valid() const override {
+    if (!iter_->Valid()) {
+      return false;
+    }
+    Slice user_key = ExtractUserKey(iter_->key());
+    return (lower_ == nullptr || ucmp_->Compare(user_key, *lower_) >= 0) &&
+           (upper_ == nullptr || ucmp_->Compare(user_key, *upper_) < 0);
+  }
+  void SeekToFirst() override {
+    if (lower_ == nullptr) {
+      iter_->SeekToFirst();
+    } else {
+      SeekUserKey(*lower_);
+    }
+  }
+  void SeekToLast() override {
+    if (upper_ == nullptr) {
+      iter_->SeekToLast();
+      return;
+    }
+    SeekUserKey(*upper_);
+    if (iter_->Valid()) {
+      iter_->Prev();
+    } else {
+      iter_->SeekToLast();
+    }
+  }
+  void Seek(const Slice& target) override {
+    if (lower_ != nullptr &&
+        ucmp_->Compare(ExtractUserKey(target), *lower_) < 0) {
+      SeekToFirst();
+    } else {
+      iter_->Seek(target);
+    }
+  }
+  void SeekForPrev(const Slice& target) override {
+    if (upper_ != nullptr &&
+        ucmp_->Compare(ExtractUserKey(target), *upper_) >= 0) {
+      SeekToLast();
+    } else {
+      iter_->SeekForPrev(target);
+    }
+  }
+  void Next() override { iter_->Next(); }
+  void Prev() override { iter_->Prev(); }
+  Slice key() const override { return iter_->key(); }
+  LazyBuffer value() const override { return iter_->value(); }
+  Status status() const override { return iter_->status(); }
+
+ private:
+  void SeekUserKey(const std::string& user_key) {
+    InternalKey ikey(user_key, kMaxSequenceNumber, kValueTypeForSeek);
+    iter_->Seek(ikey.Encode());
+  }
+
+  InternalIterator* iter_;
+  const Comparator* ucmp_;
+  const std::string* lower_;
+  const std::string* upper_;
+};
+
+// Cut the flush input into at most num_partitions ranges holding about the
+// same number of entries. A boundary is always the first version of a user
+// key, so no user key spans two partitions.
+void PickFlushPartitionBoundaries(InternalIterator* iter,
+                                  const Comparator* ucmp, uint64_t num_entries,
+                                  size_t num_partitions,
+                                  std::vector<std::string>* boundaries) {
+  const uint64_t entries_per_partition =
+      std::max<uint64_t>(num_entries / num_partitions, 1);
+  std::string last_user_key;
+  bool has_last = false;
+  uint64_t count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++count) {
+    Slice user_key = ExtractUserKey(iter->key());
+    if (has_last && ucmp->Compare(user_key, last_user_key) == 0) {
+      continue;
+    }
+    if (has_last &&
+        count >= entries_per_partition * (boundaries->size() + 1)) {
+      boundaries->emplace_back(user_key.data(), user_key.size());
+      if (boundaries->size() + 1 >= num_partitions) {
+        break;
+      }
+    }
+    last_user_key.assign(user_key.data(), user_key.size());
+    has_last = true;
+  }
+}
+
+}  // namespace
+
 const char* GetFlushReasonString(FlushReason flush_reason) {
   switch (flush_reason) {
     case FlushReason::kOthers:
@@ -148,11 +260,17 @@ void FlushJob::ReportStartedFlush() {
 
 void FlushJob::ReportFlushInputSize(const autovector<MemTable*>& mems) {
   uint64_t input_size = 0;
+  uint64_t data_size = 0;
   for (auto* mem : mems) {
     input_size += mem->ApproximateMemoryUsage();
+    data_size += mem->get_data_size();
   }
   ThreadStatusUtil::IncreaseThreadOperationProperty(
       ThreadStatus::FLUSH_BYTES_MEMTABLES, input_size);
+  ThreadStatusUtil::SetThreadOperationProperty(
+      ThreadStatus::FLUSH_PROGRESS_BYTES_TOTAL, data_size);
+  ThreadStatusUtil::SetThreadOperationProperty(
+      ThreadStatus::FLUSH_PROGRESS_BYTES_DONE, 0);
 }
 
 void FlushJob::RecordFlushIOStats() {
@@ -304,6 +422,8 @@ Status FlushJob::WriteLevel0Table() {
   db_mutex_->AssertHeld();
   const uint64_t start_micros = db_options_.env->NowMicros();
   Status s;
+  // Leading entries of meta_ are SST files, the rest are blob files
+  size_t num_sst_files = 1;
   {
     auto write_hint = cfd_->CalculateSSTWriteHint(0);
     db_mutex_->Unlock();
@@ -389,21 +509,159 @@ Status FlushJob::WriteLevel0Table() {
         }
         return range_del_iters;
       };
-      s = BuildTable(
-          dbname_, versions_, db_options_.env, *cfd_->ioptions(),
-          mutable_cf_options_, env_options_, cfd_->table_cache(),
-          c_style_callback(get_arena_input_iter), &get_arena_input_iter,
-          c_style_callback(get_range_del_iters), &get_range_del_iters, &meta_,
-          cfd_->internal_comparator(),
-          cfd_->int_tbl_prop_collector_factories(mutable_cf_options_),
-          cfd_->int_tbl_prop_collector_factories_for_blob(mutable_cf_options_),
-          cfd_->GetID(), cfd_->GetName(), existing_snapshots_,
-          earliest_write_conflict_snapshot_, snapshot_checker_,
-          output_compression_, cfd_->ioptions()->compression_opts,
-          mutable_cf_options_.paranoid_file_checks, cfd_->internal_stats(),
-          TableFileCreationReason::kFlush, event_logger_, job_context_->job_id,
-          Env::IO_HIGH, &table_properties_, 0 /* level */, flush_load_,
-          current_time, oldest_key_time, write_hint);
+      BlobConfig blob_config = cfd_->GetBlobConfig(mutable_cf_options_);
+      auto build_table = [&](InternalIterator* (*get_input_iter)(void*,
+                                                                 Arena&),
+                             void* get_input_iter_arg,
+                             std::vector<FileMetaData>* meta_vec,
+                             std::vector<TableProperties>* prop_vec,
+                             CompactionIterationStats* iter_stats) {
+        LatencyHistGuard guard(cfd_->latency_reporters().flush_build_table);
+        return BuildTable(
+            dbname_, versions_, db_options_.env, *cfd_->ioptions(),
+            mutable_cf_options_, env_options_, cfd_->table_cache(),
+            get_input_iter, get_input_iter_arg,
+            c_style_callback(get_range_del_iters), &get_range_del_iters,
+            meta_vec, cfd_->internal_comparator(),
+            cfd_->int_tbl_prop_collector_factories(mutable_cf_options_),
+            cfd_->int_tbl_prop_collector_factories_for_blob(
+                mutable_cf_options_),
+            cfd_->GetID(), cfd_->GetName(), existing_snapshots_,
+            earliest_write_conflict_snapshot_, snapshot_checker_,
+            output_compression_, cfd_->ioptions()->compression_opts,
+            mutable_cf_options_.paranoid_file_checks, cfd_->internal_stats(),
+            TableFileCreationReason::kFlush, event_logger_,
+            job_context_->job_id, Env::IO_HIGH, prop_vec, 0 /* level */,
+            flush_load_, current_time, oldest_key_time, write_hint,
+            &blob_config, iter_stats);
+      };
+
+      // Split a large flush into several files written in parallel, linked
+      // by one map sst, so L0 still gets a single sorted run. Map ssts need
+      // lazy compaction. An atomic flush installs exactly one file per column
+      // family, and range tombstones would have to be cut at every boundary,
+      // so both keep the single file path.
+      std::vector<std::string> boundaries;
+      size_t min_partition_bytes = kMinFlushPartitionBytes;
+      TEST_SYNC_POINT_CALLBACK("FlushJob::WriteLevel0Table:MinPartitionBytes",
+                               &min_partition_bytes);
+      size_t max_partitions = static_cast<size_t>(std::min<uint64_t>(
+          {db_options_.max_flush_partitions, total_num_entries,
+           total_memory_usage / std::max<size_t>(min_partition_bytes, 1)}));
+      if (write_manifest_ && max_partitions > 1 &&
+          cfd_->ioptions()->enable_lazy_compaction &&
+          get_range_del_iters().empty()) {
+        Arena boundary_arena;
+        ScopedArenaIterator iter(get_arena_input_iter(boundary_arena));
+        PickFlushPartitionBoundaries(iter.get(), cfd_->user_comparator(),
+                                     total_num_entries, max_partitions,
+                                     &boundaries);
+      }
+
+      if (boundaries.empty()) {
+        CompactionIterationStats iter_stats;
+        s = build_table(c_style_callback(get_arena_input_iter),
+                        &get_arena_input_iter, &meta_, &table_properties_,
+                        &iter_stats);
+        cfd_->RecordValueSizes(iter_stats);
+      } else {
+        ROCKS_LOG_INFO(db_options_.info_log,
+                       "[%s] [JOB %d] Level-0 flush split into %" ROCKSDB_PRIszt
+                       " partitions",
+                       cfd_->GetName().c_str(), job_context_->job_id,
+                       boundaries.size() + 1);
+        struct FlushPartition {
+          std::vector<FileMetaData> meta;
+          std::vector<TableProperties> table_properties;
+          CompactionIterationStats iter_stats;
+          // Written by a pool thread, not counted by IOSTATS here
+          uint64_t bytes_written = 0;
+          Status status;
+        };
+        std::vector<FlushPartition> partitions(boundaries.size() + 1);
+        const uint32_t output_path_id = meta_[0].fd.GetPathId();
+        partitions[0].meta = std::move(meta_);
+        meta_.clear();
+        for (size_t i = 1; i < partitions.size(); ++i) {
+          partitions[i].meta.emplace_back();
+          partitions[i].meta.front().fd =
+              FileDescriptor(versions_->NewFileNumber(), 0, 0);
+        }
+        const std::thread::id flush_thread = std::this_thread::get_id();
+        auto build_partition = [&](size_t i) {
+          auto& partition = partitions[i];
+          const std::string* lower = i == 0 ? nullptr : &boundaries[i - 1];
+          const std::string* upper =
+              i == boundaries.size() ? nullptr : &boundaries[i];
+          auto get_partition_input_iter = [&](Arena& arena) {
+            InternalIterator* input = get_arena_input_iter(arena);
+            return new (arena.AllocateAligned(sizeof(FlushPartitionIterator)))
+                FlushPartitionIterator(input, cfd_->user_comparator(), lower,
+                                       upper);
+          };
+          uint64_t prev_bytes_written = IOSTATS(bytes_written);
+          partition.status = build_table(
+              c_style_callback(get_partition_input_iter),
+              &get_partition_input_iter, &partition.meta,
+              &partition.table_properties, &partition.iter_stats);
+          if (std::this_thread::get_id() != flush_thread) {
+            partition.bytes_written =
+                IOSTATS(bytes_written) - prev_bytes_written;
+          }
+        };
+        ParallelForInEnv(db_options_.env, Env::Priority::HIGH,
+                         partitions.size(), build_partition);
+
+        // The map sst first, then the SST files it links, then the blob
+        // files they depend on. Partitions that produced nothing are dropped.
+        std::vector<FileMetaData*> partition_files;
+        for (size_t i = 0; i < partitions.size(); ++i) {
+          auto& partition = partitions[i];
+          IOSTATS_ADD(bytes_written, partition.bytes_written);
+          cfd_->RecordValueSizes(partition.iter_stats);
+          if (s.ok()) {
+            s = partition.status;
+          }
+          assert(!partition.status.ok() ||
+                 partition.meta.size() == partition.table_properties.size());
+          if (partition.meta.front().fd.GetFileSize() > 0) {
+            partition_files.push_back(&partition.meta.front());
+          }
+        }
+        if (s.ok() && partition_files.size() > 1) {
+          MapBuilder map_builder(job_context_->job_id, db_options_,
+                                 env_options_, versions_, stats_, dbname_);
+          FileMetaData map_meta;
+          std::unique_ptr<TableProperties> map_prop;
+          s = map_builder.Build(partition_files, output_path_id, cfd_, base_,
+                                &map_meta, &map_prop);
+          if (s.ok()) {
+            meta_.emplace_back(std::move(map_meta));
+            table_properties_.emplace_back(*map_prop);
+          }
+        }
+        for (auto& partition : partitions) {
+          if (partition.meta.front().fd.GetFileSize() > 0) {
+            meta_.emplace_back(partition.meta.front());
+            table_properties_.emplace_back(partition.table_properties.front());
+          }
+        }
+        if (meta_.empty()) {
+          meta_.emplace_back(partitions[0].meta.front());
+          table_properties_.emplace_back(
+              partitions[0].table_properties.front());
+        }
+        for (auto& partition : partitions) {
+          if (partition.meta.front().fd.GetFileSize() == 0) {
+            continue;
+          }
+          for (size_t i = 1; i < partition.meta.size(); ++i) {
+            meta_.emplace_back(std::move(partition.meta[i]));
+            table_properties_.emplace_back(
+                std::move(partition.table_properties[i]));
+          }
+        }
+      }
       if (s.ok() && cfd_->ioptions()->ttl_extractor_factory != nullptr) {
         ROCKS_LOG_INFO(db_options_.info_log,
                        "FlushOutput earliest_time_begin_compact = %" PRIu64
@@ -441,9 +699,9 @@ Status FlushJob::WriteLevel0Table() {
     // Add file to L0
     for (size_t i = 0; i < meta_.size(); ++i) {
       auto& f = meta_[i];
-      edit_->AddFile(i == 0 ? 0 : -1, f.fd.GetNumber(), f.fd.GetPathId(),
-                     f.fd.GetFileSize(), f.smallest, f.largest,
-                     f.fd.smallest_seqno, f.fd.largest_seqno,
+      edit_->AddFile(i < num_sst_files ? 0 : -1, f.fd.GetNumber(),
+                     f.fd.GetPathId(), f.fd.GetFileSize(), f.smallest,
+                     f.largest, f.fd.smallest_seqno, f.fd.largest_seqno,
                      f.marked_for_compaction, f.prop);
     }
   }
@@ -17,6 +17,7 @@
 #include "table/mock_table.h"
 #include "util/file_reader_writer.h"
 #include "util/string_util.h"
+#include "util/sync_point.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
 
@@ -199,6 +200,125 @@ TEST_F(FlushJobTest, NonEmpty) {
   job_context.Clean(&mutex_);
 }
 
+// Flushes a memtable holding every key of key0000..key0999 twice, the
+// second round in order and the first one in reverse when reverse_first
+void PartitionedFlushTest(FlushJobTest* t, bool lazy_compaction,
+                          bool reverse_first,
+                          std::vector<FileMetaData>* metas,
+                          ColumnFamilyData** cfd_ptr) {
+  t->cf_options_.enable_lazy_compaction = lazy_compaction;
+  t->cf_options_.force_consistency_checks = true;
+  t->versions_.reset(new VersionSet(
+      t->dbname_, &t->db_options_, t->env_options_, /* seq_per_batch */ false,
+      t->table_cache_.get(), &t->write_buffer_manager_,
+      &t->write_controller_));
+  std::vector<ColumnFamilyDescriptor> column_families;
+  for (const auto& cf_name : t->column_family_names_) {
+    column_families.emplace_back(cf_name, t->cf_options_);
+  }
+  ASSERT_OK(t->versions_->Recover(column_families, false));
+
+  JobContext job_context(0);
+  auto cfd = t->versions_->GetColumnFamilySet()->GetDefault();
+  *cfd_ptr = cfd;
+  auto new_mem = cfd->ConstructNewMemtable(*cfd->GetLatestMutableCFOptions(),
+                                           /* needs_dup_key_check */ false,
+                                           kMaxSequenceNumber);
+  new_mem->Ref();
+  // Two versions of every key, so a boundary must not split a user key
+  SequenceNumber seq = 1;
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      char key[16];
+      snprintf(key, sizeof(key), "key%04d",
+               round == 0 && reverse_first ? 999 - i : i);
+      new_mem->Add(seq++, kTypeValue, key, "value" + ToString(round));
+    }
+  }
+
+  autovector<MemTable*> to_delete;
+  cfd->imm()->Add(new_mem, &to_delete);
+  for (auto& m : to_delete) {
+    delete m;
+  }
+
+  SyncPoint::GetInstance()->SetCallBack(
+      "FlushJob::WriteLevel0Table:MinPartitionBytes",
+      [](void* arg) { *reinterpret_cast<size_t*>(arg) = 1; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  t->db_options_.max_flush_partitions = 4;
+  EventLogger event_logger(t->db_options_.info_log.get());
+  SnapshotChecker* snapshot_checker = nullptr;  // not relavant
+  FlushJob flush_job(
+      t->dbname_, cfd, t->db_options_, *cfd->GetLatestMutableCFOptions(),
+      nullptr /* memtable_id */, t->env_options_, t->versions_.get(),
+      &t->mutex_, &t->shutting_down_, {}, kMaxSequenceNumber, snapshot_checker,
+      &job_context, nullptr, nullptr, nullptr, kNoCompression,
+      t->db_options_.statistics.get(), &event_logger, true,
+      true /* sync_output_directory */, true /* write_manifest */,
+      0 /* flush_load */);
+  t->mutex_.Lock();
+  flush_job.PickMemTable();
+  ASSERT_OK(flush_job.Run(nullptr /* prep_tracker */));
+  t->mutex_.Unlock();
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  *metas = flush_job.GetFileMetas();
+  ASSERT_EQ(metas->size(), flush_job.GetTableProperties().size());
+  job_context.Clean(&t->mutex_);
+}
+
+TEST_F(FlushJobTest, PartitionedFlush) {
+  std::vector<FileMetaData> metas;
+  ColumnFamilyData* cfd = nullptr;
+  // The partitions overlap in seqno, the map sst keeps L0 consistent
+  PartitionedFlushTest(this, true /* lazy_compaction */,
+                       true /* reverse_first */, &metas, &cfd);
+  ASSERT_FALSE(HasFatalFailure());
+
+  ASSERT_EQ(5U, metas.size());
+  ASSERT_TRUE(metas[0].prop.is_map_sst());
+  ASSERT_EQ(4U, metas[0].prop.dependence.size());
+  ASSERT_EQ("key0000", metas[0].smallest.user_key().ToString());
+  ASSERT_EQ("key0999", metas[0].largest.user_key().ToString());
+  ASSERT_EQ(1, metas[0].fd.smallest_seqno);
+  ASSERT_EQ(2000, metas[0].fd.largest_seqno);
+  uint64_t num_entries = 0;
+  for (size_t i = 1; i < metas.size(); ++i) {
+    ASSERT_FALSE(metas[i].prop.is_map_sst());
+    num_entries += metas[i].prop.num_entries;
+    if (i > 1) {
+      ASSERT_LT(metas[i - 1].largest.user_key().compare(
+                    metas[i].smallest.user_key()),
+                0);
+    }
+  }
+  // Older versions are dropped since there is no snapshot
+  ASSERT_EQ(1000, num_entries);
+  auto vstorage = cfd->current()->storage_info();
+  ASSERT_EQ(1, vstorage->NumLevelFiles(0));
+  ASSERT_EQ(metas[0].fd.GetNumber(),
+            vstorage->LevelFiles(0)[0]->fd.GetNumber());
+  for (size_t i = 1; i < metas.size(); ++i) {
+    ASSERT_EQ(1U, vstorage->dependence_map().count(metas[i].fd.GetNumber()));
+  }
+}
+
+TEST_F(FlushJobTest, PartitionedFlushNeedsLazyCompaction) {
+  std::vector<FileMetaData> metas;
+  ColumnFamilyData* cfd = nullptr;
+  PartitionedFlushTest(this, false /* lazy_compaction */,
+                       false /* reverse_first */, &metas, &cfd);
+  ASSERT_FALSE(HasFatalFailure());
+
+  ASSERT_EQ(1U, metas.size());
+  ASSERT_FALSE(metas[0].prop.is_map_sst());
+  ASSERT_EQ(1000, metas[0].prop.num_entries);
+  ASSERT_EQ(1, cfd->current()->storage_info()->NumLevelFiles(0));
+}
+
 TEST_F(FlushJobTest, FlushMemTablesSingleColumnFamily) {
   const size_t num_mems = 2;
   const size_t num_mems_to_flush = 1;
@@ -6,6 +6,7 @@
 #ifndef ROCKSDB_LITE
 #include "db/forward_iterator.h"
 
+#include <algorithm>
 #include <limits>
 #include <string>
 #include <utility>
@@ -42,8 +43,8 @@ class ForwardLevelIterator : public InternalIterator {
                        const SliceTransform* prefix_extractor)
       : cfd_(cfd),
         read_options_(read_options),
-        files_(files),
-        dependence_map_(dependence_map),
+        files_(&files),
+        dependence_map_(&dependence_map),
         valid_(false),
         file_index_(std::numeric_limits<uint32_t>::max()),
         file_iter_(nullptr),
@@ -55,7 +56,7 @@ class ForwardLevelIterator : public InternalIterator {
   }
 
   void SetFileIndex(uint32_t file_index) {
-    assert(file_index < files_.size());
+    assert(file_index < files_->size());
     status_ = Status::OK();
     if (file_index != file_index_) {
       file_index_ = file_index;
@@ -63,7 +64,7 @@ class ForwardLevelIterator : public InternalIterator {
     }
   }
   void Reset() {
-    assert(file_index_ < files_.size());
+    assert(file_index_ < files_->size());
 
     // Reset current pointer
     delete file_iter_;
@@ -72,7 +73,7 @@ class ForwardLevelIterator : public InternalIterator {
                                          kMaxSequenceNumber /* upper_bound */);
     file_iter_ = cfd_->table_cache()->NewIterator(
         read_options_, *(cfd_->soptions()), cfd_->internal_comparator(),
-        *files_[file_index_], dependence_map_,
+        *(*files_)[file_index_], *dependence_map_,
         read_options_.ignore_range_deletions ? nullptr : &range_del_agg,
         prefix_extractor_, nullptr /* table_reader_ptr */, nullptr, false);
     valid_ = false;
@@ -81,6 +82,30 @@ class ForwardLevelIterator : public InternalIterator {
           "Range tombstones unsupported with ForwardIterator");
     }
   }
+  // Points the iterator at the files of a new version. The open table
+  // iterator survives if its file is still in the level, except for map
+  // ssts, which reference the dependence map of the old version
+  void Renew(const std::vector<FileMetaData*>& files,
+             const DependenceMap& dependence_map) {
+    uint32_t file_index = std::numeric_limits<uint32_t>::max();
+    if (file_iter_ != nullptr && status().ok()) {
+      assert(file_index_ < files_->size());
+      FileMetaData* f = (*files_)[file_index_];
+      auto find = std::find(files.begin(), files.end(), f);
+      if (find != files.end() && !f->prop.is_map_sst()) {
+        file_index = static_cast<uint32_t>(find - files.begin());
+      }
+    }
+    files_ = &files;
+    dependence_map_ = &dependence_map;
+    valid_ = false;
+    status_ = Status::OK();
+    if (file_index == std::numeric_limits<uint32_t>::max()) {
+      delete file_iter_;
+      file_iter_ = nullptr;
+    }
+    file_index_ = file_index;
+  }
   void SeekToLast() override {
     status_ = Status::NotSupported("ForwardLevelIterator::SeekToLast()");
     valid_ = false;
@@ -131,7 +156,7 @@ class ForwardLevelIterator : public InternalIterator {
       if (valid_) {
         return;
       }
-      if (file_index_ + 1 >= files_.size()) {
+      if (file_index_ + 1 >= files_->size()) {
         valid_ = false;
         return;
       }
@@ -163,8 +188,8 @@ class ForwardLevelIterator : public InternalIterator {
  private:
   const ColumnFamilyData* const cfd_;
   const ReadOptions& read_options_;
-  const std::vector<FileMetaData*>& files_;
-  const DependenceMap& dependence_map_;
+  const std::vector<FileMetaData*>* files_;
+  const DependenceMap* dependence_map_;
 
   bool valid_;
   uint32_t file_index_;
@@ -614,7 +639,9 @@ void ForwardIterator::RenewIterators() {
   for (inew = 0; inew < l0_files_new.size(); inew++) {
     found = false;
     for (iold = 0; iold < l0_files.size(); iold++) {
-      if (l0_files[iold] == l0_files_new[inew]) {
+      // Iterators of map ssts reference the dependence map of the old version
+      if (l0_files[iold] == l0_files_new[inew] &&
+          !l0_files_new[inew]->prop.is_map_sst()) {
         found = true;
         break;
       }
@@ -643,11 +670,12 @@ void ForwardIterator::RenewIterators() {
   l0_iters_.clear();
   l0_iters_ = l0_iters_new;
 
-  for (auto* l : level_iters_) {
+  std::vector<ForwardLevelIterator*> level_iters_old;
+  level_iters_old.swap(level_iters_);
+  BuildLevelIterators(vstorage_new, &level_iters_old);
+  for (auto* l : level_iters_old) {
     DeleteIterator(l);
   }
-  level_iters_.clear();
-  BuildLevelIterators(vstorage_new);
   current_ = nullptr;
   is_prev_set_ = false;
   SVUpdate(svnew);
@@ -659,7 +687,9 @@ void ForwardIterator::RenewIterators() {
   }
 }
 
-void ForwardIterator::BuildLevelIterators(const VersionStorageInfo* vstorage) {
+void ForwardIterator::BuildLevelIterators(
+    const VersionStorageInfo* vstorage,
+    std::vector<ForwardLevelIterator*>* level_iters_old) {
   level_iters_.reserve(vstorage->num_levels() - 1);
   for (int32_t level = 1; level < vstorage->num_levels(); ++level) {
     const auto& level_files = vstorage->LevelFiles(level);
@@ -672,6 +702,15 @@ void ForwardIterator::BuildLevelIterators(const VersionStorageInfo* vstorage) {
       if (!level_files.empty()) {
         has_iter_trimmed_for_upper_bound_ = true;
       }
+    } else if (level_iters_old != nullptr &&
+               size_t(level - 1) < level_iters_old->size() &&
+               (*level_iters_old)[level - 1] != nullptr) {
+      // Keep the open table iterator of the level if its file survived
+      auto* level_iter = (*level_iters_old)[level - 1];
+      (*level_iters_old)[level - 1] = nullptr;
+      level_iter->Renew(level_files, vstorage->dependence_map());
+      level_iters_.push_back(level_iter);
+      TEST_SYNC_POINT_CALLBACK("ForwardIterator::RenewIterators:Renew", this);
     } else {
       level_iters_.push_back(new ForwardLevelIterator(
           cfd_, read_options_, level_files, vstorage->dependence_map(),
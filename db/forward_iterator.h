@@ -113,7 +113,11 @@ class ForwardIterator : public InternalIterator, public SVDestructCallback {
 
   void RebuildIterators(bool refresh_sv);
   void RenewIterators();
-  void BuildLevelIterators(const VersionStorageInfo* vstorage);
+  // Level iterators found in level_iters_old are renewed instead of rebuilt,
+  // the ones taken are set to nullptr
+  void BuildLevelIterators(
+      const VersionStorageInfo* vstorage,
+      std::vector<ForwardLevelIterator*>* level_iters_old = nullptr);
   void ResetIncompleteIterators();
   void SeekInternal(const Slice& internal_key, bool seek_to_first);
   void UpdateCurrent();
@@ -224,6 +224,13 @@ static const std::string num_deletes_imm_mem_tables =
 static const std::string estimate_num_keys = "estimate-num-keys";
 static const std::string estimate_table_readers_mem =
     "estimate-table-readers-mem";
+static const std::string estimate_table_index_mem = "estimate-table-index-mem";
+static const std::string estimate_table_dict_mem = "estimate-table-dict-mem";
+static const std::string table_builder_mem = "table-builder-mem";
+static const std::string estimate_blob_reference_mem =
+    "estimate-blob-reference-mem";
+static const std::string cur_size_all_mem_table_reps =
+    "cur-size-all-mem-table-reps";
 static const std::string is_file_deletions_enabled =
     "is-file-deletions-enabled";
 static const std::string num_snapshots = "num-snapshots";
@@ -240,6 +247,12 @@ static const std::string total_sst_files_size = "total-sst-files-size";
 static const std::string live_sst_files_size = "live-sst-files-size";
 static const std::string estimate_pending_comp_bytes =
     "estimate-pending-compaction-bytes";
+static const std::string read_amp_debt = "read-amp-debt";
+static const std::string total_blob_files_size = "total-blob-files-size";
+static const std::string estimate_blob_garbage_size =
+    "estimate-blob-garbage-size";
+static const std::string estimate_space_amplification =
+    "estimate-space-amplification";
 static const std::string aggregated_table_properties =
     "aggregated-table-properties";
 static const std::string aggregated_table_properties_at_level =
@@ -253,6 +266,11 @@ static const std::string block_cache_capacity = "block-cache-capacity";
 static const std::string block_cache_usage = "block-cache-usage";
 static const std::string block_cache_pinned_usage = "block-cache-pinned-usage";
 static const std::string options_statistics = "options-statistics";
+static const std::string io_profile = "io-profile";
+static const std::string hot_keys = "hot-keys";
+static const std::string write_buffer_quota = "write-buffer-quota";
+static const std::string delayed_write_rate_target =
+    "delayed-write-rate-target";
 
 const std::string DB::Properties::kNumFilesAtLevelPrefix =
     rocksdb_prefix + num_files_at_level_prefix;
@@ -299,6 +317,16 @@ const std::string DB::Properties::kEstimateNumKeys =
     rocksdb_prefix + estimate_num_keys;
 const std::string DB::Properties::kEstimateTableReadersMem =
     rocksdb_prefix + estimate_table_readers_mem;
+const std::string DB::Properties::kEstimateTableIndexMem =
+    rocksdb_prefix + estimate_table_index_mem;
+const std::string DB::Properties::kEstimateTableDictMem =
+    rocksdb_prefix + estimate_table_dict_mem;
+const std::string DB::Properties::kTableBuilderMem =
+    rocksdb_prefix + table_builder_mem;
+const std::string DB::Properties::kEstimateBlobReferenceMem =
+    rocksdb_prefix + estimate_blob_reference_mem;
+const std::string DB::Properties::kCurSizeAllMemTableReps =
+    rocksdb_prefix + cur_size_all_mem_table_reps;
 const std::string DB::Properties::kIsFileDeletionsEnabled =
     rocksdb_prefix + is_file_deletions_enabled;
 const std::string DB::Properties::kNumSnapshots =
@@ -322,6 +350,14 @@ const std::string DB::Properties::kLiveSstFilesSize =
 const std::string DB::Properties::kBaseLevel = rocksdb_prefix + base_level_str;
 const std::string DB::Properties::kEstimatePendingCompactionBytes =
     rocksdb_prefix + estimate_pending_comp_bytes;
+const std::string DB::Properties::kReadAmpDebt =
+    rocksdb_prefix + read_amp_debt;
+const std::string DB::Properties::kTotalBlobFilesSize =
+    rocksdb_prefix + total_blob_files_size;
+const std::string DB::Properties::kEstimateBlobGarbageSize =
+    rocksdb_prefix + estimate_blob_garbage_size;
+const std::string DB::Properties::kEstimateSpaceAmplification =
+    rocksdb_prefix + estimate_space_amplification;
 const std::string DB::Properties::kAggregatedTableProperties =
     rocksdb_prefix + aggregated_table_properties;
 const std::string DB::Properties::kAggregatedTablePropertiesAtLevel =
@@ -338,6 +374,12 @@ const std::string DB::Properties::kBlockCachePinnedUsage =
     rocksdb_prefix + block_cache_pinned_usage;
 const std::string DB::Properties::kOptionsStatistics =
     rocksdb_prefix + options_statistics;
+const std::string DB::Properties::kIOProfile = rocksdb_prefix + io_profile;
+const std::string DB::Properties::kHotKeys = rocksdb_prefix + hot_keys;
+const std::string DB::Properties::kWriteBufferQuota =
+    rocksdb_prefix + write_buffer_quota;
+const std::string DB::Properties::kDelayedWriteRateTarget =
+    rocksdb_prefix + delayed_write_rate_target;
 
 const std::unordered_map<std::string, DBPropertyInfo>
     InternalStats::ppt_name_to_info = {
@@ -412,6 +454,21 @@ const std::unordered_map<std::string, DBPropertyInfo>
         {DB::Properties::kEstimateTableReadersMem,
          {true, nullptr, &InternalStats::HandleEstimateTableReadersMem, nullptr,
           nullptr}},
+        {DB::Properties::kEstimateTableIndexMem,
+         {true, nullptr, &InternalStats::HandleEstimateTableIndexMem, nullptr,
+          nullptr}},
+        {DB::Properties::kEstimateTableDictMem,
+         {true, nullptr, &InternalStats::HandleEstimateTableDictMem, nullptr,
+          nullptr}},
+        {DB::Properties::kTableBuilderMem,
+         {false, nullptr, &InternalStats::HandleTableBuilderMem, nullptr,
+          nullptr}},
+        {DB::Properties::kEstimateBlobReferenceMem,
+         {true, nullptr, &InternalStats::HandleEstimateBlobReferenceMem,
+          nullptr, nullptr}},
+        {DB::Properties::kCurSizeAllMemTableReps,
+         {false, nullptr, &InternalStats::HandleCurSizeAllMemTableReps, nullptr,
+          nullptr}},
         {DB::Properties::kIsFileDeletionsEnabled,
          {false, nullptr, &InternalStats::HandleIsFileDeletionsEnabled, nullptr,
           nullptr}},
@@ -447,6 +504,18 @@ const std::unordered_map<std::string, DBPropertyInfo>
         {DB::Properties::kEstimatePendingCompactionBytes,
          {false, nullptr, &InternalStats::HandleEstimatePendingCompactionBytes,
           nullptr, nullptr}},
+        {DB::Properties::kReadAmpDebt,
+         {false, nullptr, &InternalStats::HandleReadAmpDebt, nullptr,
+          nullptr}},
+        {DB::Properties::kTotalBlobFilesSize,
+         {false, nullptr, &InternalStats::HandleTotalBlobFilesSize, nullptr,
+          nullptr}},
+        {DB::Properties::kEstimateBlobGarbageSize,
+         {false, nullptr, &InternalStats::HandleEstimateBlobGarbageSize,
+          nullptr, nullptr}},
+        {DB::Properties::kEstimateSpaceAmplification,
+         {false, nullptr, &InternalStats::HandleEstimateSpaceAmplification,
+          nullptr, nullptr}},
         {DB::Properties::kNumRunningFlushes,
          {false, nullptr, &InternalStats::HandleNumRunningFlushes, nullptr,
           nullptr}},
@@ -471,6 +540,18 @@ const std::unordered_map<std::string, DBPropertyInfo>
         {DB::Properties::kOptionsStatistics,
          {false, nullptr, nullptr, nullptr,
           &DBImpl::GetPropertyHandleOptionsStatistics}},
+        {DB::Properties::kIOProfile,
+         {false, nullptr, nullptr, nullptr,
+          &DBImpl::GetPropertyHandleIOProfile}},
+        {DB::Properties::kHotKeys,
+         {false, nullptr, nullptr, nullptr,
+          &DBImpl::GetPropertyHandleHotKeys}},
+        {DB::Properties::kWriteBufferQuota,
+         {false, nullptr, &InternalStats::HandleWriteBufferQuota, nullptr,
+          nullptr}},
+        {DB::Properties::kDelayedWriteRateTarget,
+         {false, nullptr, &InternalStats::HandleDelayedWriteRateTarget,
+          nullptr, nullptr}},
 };
 
 const DBPropertyInfo* GetPropertyInfo(const Slice& property) {
@@ -811,6 +892,36 @@ bool InternalStats::HandleEstimatePendingCompactionBytes(uint64_t* value,
   return true;
 }
 
+bool InternalStats::HandleReadAmpDebt(uint64_t* value, DBImpl* /*db*/,
+                                      Version* /*version*/) {
+  const auto* vstorage = cfd_->current()->storage_info();
+  *value = vstorage->read_amp_debt();
+  return true;
+}
+
+bool InternalStats::HandleTotalBlobFilesSize(uint64_t* value, DBImpl* /*db*/,
+                                             Version* /*version*/) {
+  const auto* vstorage = cfd_->current()->storage_info();
+  *value = vstorage->blob_file_size();
+  return true;
+}
+
+bool InternalStats::HandleEstimateBlobGarbageSize(uint64_t* value,
+                                                  DBImpl* /*db*/,
+                                                  Version* /*version*/) {
+  const auto* vstorage = cfd_->current()->storage_info();
+  *value = vstorage->EstimateBlobGarbageSize();
+  return true;
+}
+
+bool InternalStats::HandleEstimateSpaceAmplification(uint64_t* value,
+                                                     DBImpl* /*db*/,
+                                                     Version* /*version*/) {
+  const auto* vstorage = cfd_->current()->storage_info();
+  *value = vstorage->space_amplification_percent();
+  return true;
+}
+
 bool InternalStats::HandleEstimateTableReadersMem(uint64_t* value,
                                                   DBImpl* /*db*/,
                                                   Version* version) {
@@ -818,6 +929,48 @@ bool InternalStats::HandleEstimateTableReadersMem(uint64_t* value,
   return true;
 }
 
+bool InternalStats::HandleEstimateTableIndexMem(uint64_t* value,
+                                                DBImpl* /*db*/,
+                                                Version* version) {
+  size_t index_usage = 0, dict_usage = 0;
+  if (version != nullptr) {
+    version->GetIndexAndDictMemoryUsage(&index_usage, &dict_usage);
+  }
+  *value = index_usage;
+  return true;
+}
+
+bool InternalStats::HandleEstimateTableDictMem(uint64_t* value, DBImpl* /*db*/,
+                                               Version* version) {
+  size_t index_usage = 0, dict_usage = 0;
+  if (version != nullptr) {
+    version->GetIndexAndDictMemoryUsage(&index_usage, &dict_usage);
+  }
+  *value = dict_usage;
+  return true;
+}
+
+bool InternalStats::HandleTableBuilderMem(uint64_t* value, DBImpl* /*db*/,
+                                          Version* /*version*/) {
+  *value = cfd_->ioptions()->table_factory->GetBuilderMemoryUsage();
+  return true;
+}
+
+bool InternalStats::HandleEstimateBlobReferenceMem(uint64_t* value,
+                                                   DBImpl* /*db*/,
+                                                   Version* version) {
+  *value = version->storage_info()->ApproximateBlobReferenceMemoryUsage();
+  return true;
+}
+
+bool InternalStats::HandleCurSizeAllMemTableReps(uint64_t* value,
+                                                 DBImpl* /*db*/,
+                                                 Version* /*version*/) {
+  *value = cfd_->mem()->ApproximateRepMemoryUsage() +
+           cfd_->imm()->ApproximateUnflushedMemTableRepsMemoryUsage();
+  return true;
+}
+
 bool InternalStats::HandleEstimateLiveDataSize(uint64_t* value, DBImpl* /*db*/,
                                                Version* version) {
   const auto* vstorage = version->storage_info();
@@ -855,6 +1008,18 @@ bool InternalStats::HandleIsWriteStopped(uint64_t* value, DBImpl* db,
   return true;
 }
 
+bool InternalStats::HandleWriteBufferQuota(uint64_t* value, DBImpl* db,
+                                           Version* /*version*/) {
+  return db->GetWriteBufferQuota(value);
+}
+
+bool InternalStats::HandleDelayedWriteRateTarget(uint64_t* value,
+                                                 DBImpl* /*db*/,
+                                                 Version* /*version*/) {
+  *value = cfd_->delayed_write_rate_target();
+  return true;
+}
+
 bool InternalStats::HandleBlockCacheStat(Cache** block_cache) {
   assert(block_cache != nullptr);
   auto* table_factory = cfd_->ioptions()->table_factory;
@@ -1142,6 +1307,16 @@ void InternalStats::DumpCFMapStatsIOStalls(
 
   (*cf_stats)["io_stalls.total_stop"] = std::to_string(total_stop);
   (*cf_stats)["io_stalls.total_slowdown"] = std::to_string(total_slowdown);
+
+  (*cf_stats)["io_stalls.memtable_limit_micros"] =
+      std::to_string(cf_stats_value_[MEMTABLE_LIMIT_STALL_MICROS]);
+  (*cf_stats)["io_stalls.level0_file_count_limit_micros"] =
+      std::to_string(cf_stats_value_[L0_FILE_COUNT_LIMIT_STALL_MICROS]);
+  (*cf_stats)["io_stalls.pending_compaction_bytes_limit_micros"] =
+      std::to_string(
+          cf_stats_value_[PENDING_COMPACTION_BYTES_LIMIT_STALL_MICROS]);
+  (*cf_stats)["io_stalls.read_amp_limit_micros"] =
+      std::to_string(cf_stats_value_[READ_AMP_LIMIT_STALL_MICROS]);
 }
 
 void InternalStats::DumpCFStats(std::string* value) {
@@ -1209,6 +1384,9 @@ void InternalStats::DumpCFStatsNoFileHistogram(std::string* value) {
   snprintf(buf, sizeof(buf), "AddFile(GB): cumulative %.3f, interval %.3f\n",
            add_file_ingest / kGB, interval_add_file_inget / kGB);
   value->append(buf);
+  snprintf(buf, sizeof(buf), "Read amp debt: %" PRIu64 "\n",
+           cfd_->current()->storage_info()->read_amp_debt());
+  value->append(buf);
 
   uint64_t interval_ingest_files_addfile =
       ingest_files_addfile - cf_stats_snapshot_.ingest_files_addfile;
@@ -1302,6 +1480,16 @@ void InternalStats::DumpCFStatsNoFileHistogram(std::string* value) {
            total_stall_count - cf_stats_snapshot_.stall_count);
   value->append(buf);
 
+  snprintf(buf, sizeof(buf),
+           "Stalls(secs): %.3f memtable_limit, %.3f level0_file_count_limit, "
+           "%.3f pending_compaction_bytes_limit, %.3f read_amp_limit\n",
+           cf_stats_value_[MEMTABLE_LIMIT_STALL_MICROS] / kMicrosInSec,
+           cf_stats_value_[L0_FILE_COUNT_LIMIT_STALL_MICROS] / kMicrosInSec,
+           cf_stats_value_[PENDING_COMPACTION_BYTES_LIMIT_STALL_MICROS] /
+               kMicrosInSec,
+           cf_stats_value_[READ_AMP_LIMIT_STALL_MICROS] / kMicrosInSec);
+  value->append(buf);
+
   cf_stats_snapshot_.seconds_up = seconds_up;
   cf_stats_snapshot_.ingest_bytes_flush = flush_ingest;
   cf_stats_snapshot_.ingest_bytes_addfile = add_file_ingest;
@@ -1328,6 +1516,14 @@ void InternalStats::DumpCFFileHistogram(std::string* value) {
       value->append(buf2);
     }
   }
+
+  if (!write_stall_latency_.Empty()) {
+    char buf2[5000];
+    snprintf(buf2, sizeof(buf2),
+             "** Write stall histogram (micros):\n%s\n",
+             write_stall_latency_.ToString().c_str());
+    value->append(buf2);
+  }
 }
 
 #else
@@ -106,6 +106,12 @@ class InternalStats {
     INGESTED_NUM_KEYS_TOTAL,
     READ_AMP_LIMIT_SLOWDOWNS,
     READ_AMP_LIMIT_STOPS,
+    // Micros the writes waited for a limit of this column family, counted
+    // per delayed write
+    MEMTABLE_LIMIT_STALL_MICROS,
+    L0_FILE_COUNT_LIMIT_STALL_MICROS,
+    PENDING_COMPACTION_BYTES_LIMIT_STALL_MICROS,
+    READ_AMP_LIMIT_STALL_MICROS,
     INTERNAL_CF_STATS_ENUM_MAX,
   };
 
@@ -290,6 +296,7 @@ class InternalStats {
     for (auto& h : file_read_latency_) {
       h.Clear();
     }
+    write_stall_latency_.Clear();
     cf_stats_snapshot_.Clear();
     db_stats_snapshot_.Clear();
     bg_error_count_ = 0;
@@ -328,6 +335,9 @@ class InternalStats {
     return &file_read_latency_[level];
   }
 
+  // Micros of the writes delayed by this column family
+  HistogramImpl* GetWriteStallHist() { return &write_stall_latency_; }
+
   uint64_t GetBackgroundErrorCount() const { return bg_error_count_; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return ++bg_error_count_; }
@@ -374,6 +384,7 @@ class InternalStats {
   // Per-ColumnFamily/level compaction stats
   std::vector<CompactionStats> comp_stats_;
   std::vector<HistogramImpl> file_read_latency_;
+  HistogramImpl write_stall_latency_;
 
   // Used to compute per-interval statistics
   struct CFStatsSnapshot {
@@ -513,8 +524,23 @@ class InternalStats {
   bool HandleLiveSstFilesSize(uint64_t* value, DBImpl* db, Version* version);
   bool HandleEstimatePendingCompactionBytes(uint64_t* value, DBImpl* db,
                                             Version* version);
+  bool HandleReadAmpDebt(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleTotalBlobFilesSize(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleEstimateBlobGarbageSize(uint64_t* value, DBImpl* db,
+                                     Version* version);
+  bool HandleEstimateSpaceAmplification(uint64_t* value, DBImpl* db,
+                                        Version* version);
   bool HandleEstimateTableReadersMem(uint64_t* value, DBImpl* db,
                                      Version* version);
+  bool HandleEstimateTableIndexMem(uint64_t* value, DBImpl* db,
+                                   Version* version);
+  bool HandleEstimateTableDictMem(uint64_t* value, DBImpl* db,
+                                  Version* version);
+  bool HandleTableBuilderMem(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleEstimateBlobReferenceMem(uint64_t* value, DBImpl* db,
+                                      Version* version);
+  bool HandleCurSizeAllMemTableReps(uint64_t* value, DBImpl* db,
+                                    Version* version);
   bool HandleEstimateLiveDataSize(uint64_t* value, DBImpl* db,
                                   Version* version);
   bool HandleMinLogNumberToKeep(uint64_t* value, DBImpl* db, Version* version);
@@ -523,6 +549,9 @@ class InternalStats {
   bool HandleActualDelayedWriteRate(uint64_t* value, DBImpl* db,
                                     Version* version);
   bool HandleIsWriteStopped(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleWriteBufferQuota(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleDelayedWriteRateTarget(uint64_t* value, DBImpl* db,
+                                    Version* version);
   bool HandleEstimateOldestKeyTime(uint64_t* value, DBImpl* db,
                                    Version* version);
   bool HandleBlockCacheCapacity(uint64_t* value, DBImpl* db, Version* version);
@@ -561,6 +590,10 @@ class InternalStats {
     INGESTED_NUM_FILES_TOTAL,
     INGESTED_LEVEL0_NUM_FILES_TOTAL,
     INGESTED_NUM_KEYS_TOTAL,
+    MEMTABLE_LIMIT_STALL_MICROS,
+    L0_FILE_COUNT_LIMIT_STALL_MICROS,
+    PENDING_COMPACTION_BYTES_LIMIT_STALL_MICROS,
+    READ_AMP_LIMIT_STALL_MICROS,
     INTERNAL_CF_STATS_ENUM_MAX,
   };
 
@@ -613,6 +646,8 @@ class InternalStats {
 
   HistogramImpl* GetFileReadHist(int /*level*/) { return nullptr; }
 
+  HistogramImpl* GetWriteStallHist() { return nullptr; }
+
   uint64_t GetBackgroundErrorCount() const { return 0; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return 0; }
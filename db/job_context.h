@@ -57,21 +57,15 @@ struct SuperVersionContext {
 #endif
   }
 
-  void PushWriteStallNotification(WriteStallCondition old_cond,
-                                  WriteStallCondition new_cond,
-                                  const std::string& name,
+  void PushWriteStallNotification(const WriteStallInfo& info,
                                   const ImmutableCFOptions* ioptions) {
 #if !defined(ROCKSDB_LITE) && !defined(ROCKSDB_DISABLE_STALL_NOTIFICATION)
     WriteStallNotification notif;
-    notif.write_stall_info.cf_name = name;
-    notif.write_stall_info.condition.prev = old_cond;
-    notif.write_stall_info.condition.cur = new_cond;
+    notif.write_stall_info = info;
     notif.immutable_cf_options = ioptions;
     write_stall_notifications.push_back(notif);
 #else
-    (void)old_cond;
-    (void)new_cond;
-    (void)name;
+    (void)info;
     (void)ioptions;
 #endif  // !defined(ROCKSDB_LITE) &&
         // !defined(ROCKSDB_DISABLE_STALL_NOTIFICATION)
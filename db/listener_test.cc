@@ -414,6 +414,57 @@ TEST_F(EventListenerTest, DisableBGCompaction) {
   ASSERT_GE(listener->slowdown_count, kSlowdownTrigger * 9);
 }
 
+class TestCompactionStatsListener : public EventListener {
+ public:
+  void OnCompactionCompleted(DB* /*db*/, const CompactionJobInfo& ci) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.push_back(ci.stats);
+  }
+
+  std::vector<CompactionJobStats> stats_;
+  std::mutex mutex_;
+};
+
+TEST_F(EventListenerTest, CompactionPhaseTimes) {
+  for (bool report_bg_io_stats : {false, true}) {
+    Options options = CurrentOptions();
+    options.create_if_missing = true;
+    options.disable_auto_compactions = true;
+    options.report_bg_io_stats = report_bg_io_stats;
+    TestCompactionStatsListener* listener = new TestCompactionStatsListener();
+    options.listeners.emplace_back(listener);
+    DestroyAndReopen(options);
+
+    Random rnd(301);
+    for (int i = 0; i < 3; ++i) {
+      for (int k = 0; k < 100; ++k) {
+        ASSERT_OK(Put(Key(k), RandomString(&rnd, 1000)));
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+    dbfull()->TEST_WaitForCompact();
+
+    ASSERT_EQ(1, listener->stats_.size());
+    const CompactionJobStats& stats = listener->stats_[0];
+    ASSERT_GT(stats.cpu_micros, 0);
+    if (report_bg_io_stats) {
+      ASSERT_GT(stats.input_read_time.wall_nanos, 0);
+      ASSERT_GT(stats.compaction_iterator_time.wall_nanos, 0);
+      ASSERT_GT(stats.table_add_time.wall_nanos, 0);
+      ASSERT_GT(stats.table_finish_time.wall_nanos, 0);
+      ASSERT_GT(stats.table_finish_time.cpu_nanos, 0);
+      ASSERT_GE(stats.compaction_iterator_time.wall_nanos,
+                stats.compaction_filter_time.wall_nanos);
+    } else {
+      ASSERT_EQ(0, stats.input_read_time.wall_nanos);
+      ASSERT_EQ(0, stats.compaction_iterator_time.wall_nanos);
+      ASSERT_EQ(0, stats.table_add_time.wall_nanos);
+      ASSERT_EQ(0, stats.table_finish_time.wall_nanos);
+    }
+  }
+}
+
 class TestCompactionReasonListener : public EventListener {
  public:
   void OnCompactionCompleted(DB* /*db*/, const CompactionJobInfo& ci) override {
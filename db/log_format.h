@@ -31,8 +31,11 @@ enum RecordType {
   kRecyclableFirstType = 6,
   kRecyclableMiddleType = 7,
   kRecyclableLastType = 8,
+
+  // Compression of the records that follow, first in a compressed log
+  kSetCompressionType = 9,
 };
-static const int kMaxRecordType = kRecyclableLastType;
+static const int kMaxRecordType = kSetCompressionType;
 
 static const unsigned int kBlockSize = 32768;
 
@@ -43,5 +46,12 @@ static const int kHeaderSize = 4 + 2 + 1;
 // log number (4 bytes).
 static const int kRecyclableHeaderSize = 4 + 2 + 1 + 4;
 
+// The payload of a record in a compressed log is a flags byte followed by
+// the compressed record. The records of a frame are compressed as a stream,
+// and a new frame is started after kCompressionFrameSize input bytes.
+static const char kCompressedRecordNewFrame = 0x1;
+static const char kCompressedRecordFrameEnd = 0x2;
+static const unsigned int kCompressionFrameSize = 8 * kBlockSize;
+
 }  // namespace log
 }  // namespace TERARKDB_NAMESPACE
@@ -11,9 +11,13 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
+#include "port/port.h"
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 #include "util/util.h"
@@ -26,7 +30,7 @@ Reader::Reporter::~Reporter() {}
 Reader::Reader(std::shared_ptr<Logger> info_log,
                std::unique_ptr<SequentialFileReader>&& _file,
                Reporter* reporter, bool checksum, uint64_t log_num,
-               bool retry_after_eof)
+               bool retry_after_eof, size_t decompression_threads)
     : info_log_(info_log),
       file_(std::move(_file)),
       reporter_(reporter),
@@ -40,6 +44,12 @@ Reader::Reader(std::shared_ptr<Logger> info_log,
       end_of_buffer_offset_(0),
       log_number_(log_num),
       recycled_(false),
+      first_record_offset_(0),
+      compression_type_(kNoCompression),
+      compression_type_recorded_(false),
+      decompression_threads_(std::max<size_t>(decompression_threads, 1)),
+      frame_intact_(false),
+      last_record_end_(0),
       retry_after_eof_(retry_after_eof) {}
 
 Reader::~Reader() { delete[] backing_store_; }
@@ -53,6 +63,140 @@ Reader::~Reader() { delete[] backing_store_; }
 // restrict the inconsistency to only the last log
 bool Reader::ReadRecord(Slice* record, std::string* scratch,
                         WALRecoveryMode wal_recovery_mode) {
+  while (true) {
+    if (pending_.empty()) {
+      if (!compression_type_recorded_) {
+        if (!ReadRawRecord(record, scratch, wal_recovery_mode)) {
+          return false;
+        }
+        if (!compression_type_recorded_) {
+          return true;
+        }
+        // The first record of a compressed log, read the rest of its frames
+        pending_.emplace_back();
+        PendingRecord& first = pending_.back();
+        first.data.assign(record->data(), record->size());
+        first.offset = last_record_offset_;
+        first.end = end_of_buffer_offset_ - buffer_.size();
+      }
+      ReadCompressedRecords(wal_recovery_mode);
+    }
+    PendingRecord pending = std::move(pending_.front());
+    pending_.pop_front();
+    for (auto& drop : pending.drops) {
+      ReportDrop(drop.first, drop.second);
+    }
+    scratch->clear();
+    record->clear();
+    if (pending.eof) {
+      return false;
+    }
+    if (!pending.ok) {
+      ReportCorruption(pending.data.size(), "failed to decompress record");
+      continue;
+    }
+    *scratch = std::move(pending.data);
+    *record = Slice(*scratch);
+    last_record_offset_ = pending.offset;
+    last_record_end_ = pending.end;
+    return true;
+  }
+}
+
+void Reader::ReadCompressedRecords(WALRecoveryMode wal_recovery_mode) {
+  // Drops are reported along with the records read after them
+  class DeferredReporter : public Reporter {
+   public:
+    void Corruption(size_t bytes, const Status& status) override {
+      drops.emplace_back(bytes, status);
+    }
+
+    std::vector<std::pair<size_t, Status>> drops;
+  } deferred;
+  Reporter* reporter = reporter_;
+  reporter_ = &deferred;
+  size_t frames = 0;
+  std::string scratch;
+  Slice record;
+  while (frames < decompression_threads_) {
+    pending_.emplace_back();
+    PendingRecord& pending = pending_.back();
+    if (!ReadRawRecord(&record, &scratch, wal_recovery_mode)) {
+      pending.eof = true;
+      pending.drops.swap(deferred.drops);
+      break;
+    }
+    pending.drops.swap(deferred.drops);
+    pending.data.assign(record.data(), record.size());
+    pending.offset = last_record_offset_;
+    pending.end = end_of_buffer_offset_ - buffer_.size();
+    if (!record.empty() && (record[0] & kCompressedRecordFrameEnd)) {
+      ++frames;
+    }
+  }
+  reporter_ = reporter;
+
+  // Split the records into frames. The first frame may continue the last one
+  // read ahead before, and the last one may be continued by the next read
+  // ahead, so both are decompressed with uncompress_.
+  std::vector<std::pair<size_t, size_t>> runs;
+  size_t begin = 0;
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    const PendingRecord& pending = pending_[i];
+    if (pending.eof || i + 1 == pending_.size() ||
+        (!pending.data.empty() &&
+         (pending.data[0] & kCompressedRecordFrameEnd))) {
+      runs.emplace_back(begin, i + 1);
+      begin = i + 1;
+    }
+  }
+  frame_intact_ = DecompressRecords(runs[0].first, runs[0].second,
+                                    frame_intact_, uncompress_.get());
+  if (runs.size() > 1) {
+    std::vector<port::Thread> threads;
+    for (size_t r = 1; r + 1 < runs.size(); ++r) {
+      threads.emplace_back([this, &runs, r] {
+        ZSTDStreamingUncompress uncompress;
+        DecompressRecords(runs[r].first, runs[r].second, false, &uncompress);
+      });
+    }
+    frame_intact_ = DecompressRecords(runs.back().first, runs.back().second,
+                                      false, uncompress_.get());
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+}
+
+bool Reader::DecompressRecords(size_t begin, size_t end, bool intact,
+                               ZSTDStreamingUncompress* uncompress) {
+  std::string output;
+  for (size_t i = begin; i < end; ++i) {
+    PendingRecord& pending = pending_[i];
+    if (pending.eof) {
+      continue;
+    }
+    // The records after a drop can only be decompressed from a new frame
+    if (!pending.drops.empty()) {
+      intact = false;
+    }
+    const char flags = pending.data.empty() ? 0 : pending.data[0];
+    const bool new_frame = (flags & kCompressedRecordNewFrame) != 0;
+    pending.ok = compression_type_ == kZSTD && !pending.data.empty() &&
+                 (new_frame || intact) &&
+                 uncompress->Uncompress(Slice(pending.data.data() + 1,
+                                              pending.data.size() - 1),
+                                        new_frame, &output);
+    if (pending.ok) {
+      pending.data.swap(output);
+    }
+    intact = pending.ok && (flags & kCompressedRecordFrameEnd) == 0;
+  }
+  return intact;
+}
+
+bool Reader::ReadRawRecord(Slice* record, std::string* scratch,
+                           WALRecoveryMode wal_recovery_mode) {
   scratch->clear();
   record->clear();
   bool in_fragmented_record = false;
@@ -118,6 +262,21 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         }
         break;
 
+      case kSetCompressionType:
+        if (compression_type_recorded_ || in_fragmented_record ||
+            fragment.size() != 1) {
+          ReportCorruption(fragment.size(), "misplaced compression type");
+          break;
+        }
+        compression_type_recorded_ = true;
+        compression_type_ = static_cast<CompressionType>(fragment[0]);
+        first_record_offset_ = physical_record_offset + kHeaderSize + 1;
+        if (compression_type_ != kZSTD || !ZSTD_Supported()) {
+          ReportDrop(0, Status::NotSupported("Unsupported log compression"));
+        }
+        uncompress_.reset(new ZSTDStreamingUncompress);
+        break;
+
       case kBadHeader:
         if (wal_recovery_mode == WALRecoveryMode::kAbsoluteConsistency) {
           // in clean shutdown we don't expect any error in the log files
@@ -199,6 +358,13 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
 
 uint64_t Reader::LastRecordOffset() { return last_record_offset_; }
 
+uint64_t Reader::LastRecordEnd() {
+  if (compression_type_recorded_) {
+    return last_record_end_;
+  }
+  return end_of_buffer_offset_ - buffer_.size();
+}
+
 void Reader::UnmarkEOF() {
   if (read_error_) {
     return;
@@ -333,7 +499,7 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, size_t* drop_size) {
     const uint32_t length = a | (b << 8);
     int header_size = kHeaderSize;
     if (type >= kRecyclableFullType && type <= kRecyclableLastType) {
-      if (end_of_buffer_offset_ - buffer_.size() == 0) {
+      if (end_of_buffer_offset_ - buffer_.size() == first_record_offset_) {
         recycled_ = true;
       }
       header_size = kRecyclableHeaderSize;
@@ -10,7 +10,11 @@
 #pragma once
 #include <stdint.h>
 
+#include <deque>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "db/log_format.h"
 #include "rocksdb/options.h"
@@ -22,6 +26,7 @@ namespace TERARKDB_NAMESPACE {
 
 class SequentialFileReader;
 class Logger;
+class ZSTDStreamingUncompress;
 using std::unique_ptr;
 
 namespace log {
@@ -52,10 +57,15 @@ class Reader {
   // live while this Reader is in use.
   //
   // If "checksum" is true, verify checksums if available.
+  //
+  // The records of a compressed log are read ahead up to
+  // "decompression_threads" frames at a time, which are decompressed in
+  // parallel.
   Reader(std::shared_ptr<Logger> info_log,
          // @lint-ignore TXT2 T25377293 Grandfathered in
          std::unique_ptr<SequentialFileReader>&& file, Reporter* reporter,
-         bool checksum, uint64_t log_num, bool retry_after_eof);
+         bool checksum, uint64_t log_num, bool retry_after_eof,
+         size_t decompression_threads = 1);
 
   ~Reader();
 
@@ -73,6 +83,13 @@ class Reader {
   // Undefined before the first call to ReadRecord.
   uint64_t LastRecordOffset();
 
+  // Returns the physical offset just past the last record returned by
+  // ReadRecord, where the next record starts unless the block trailer is
+  // padding.
+  //
+  // Undefined before the first call to ReadRecord.
+  uint64_t LastRecordEnd();
+
   // returns true if the reader has encountered an eof condition.
   bool IsEOF() { return eof_; }
 
@@ -88,7 +105,7 @@ class Reader {
  private:
   std::shared_ptr<Logger> info_log_;
   const std::unique_ptr<SequentialFileReader> file_;
-  Reporter* const reporter_;
+  Reporter* reporter_;
   bool const checksum_;
   char* const backing_store_;
   Slice buffer_;
@@ -109,6 +126,33 @@ class Reader {
 
   // Whether this is a recycled log file
   bool recycled_;
+  // Offset of the first record after the kSetCompressionType record, where
+  // a recycled log is detected
+  uint64_t first_record_offset_;
+
+  // The log compression, from its kSetCompressionType record
+  CompressionType compression_type_;
+  bool compression_type_recorded_;
+  const size_t decompression_threads_;
+
+  // A compressed record read ahead, or the end of the records read ahead
+  struct PendingRecord {
+    // Drops reported before the record
+    std::vector<std::pair<size_t, Status>> drops;
+    bool eof = false;
+    bool ok = false;
+    std::string data;
+    uint64_t offset = 0;
+    uint64_t end = 0;
+  };
+  std::deque<PendingRecord> pending_;
+  // Continues the frame at the end of the records read ahead
+  std::unique_ptr<ZSTDStreamingUncompress> uncompress_;
+  // Whether the frame at the end of the records read ahead is intact, so the
+  // next records can be decompressed
+  bool frame_intact_;
+  // LastRecordEnd() of a compressed log
+  uint64_t last_record_end_;
 
   // Whether retry after encountering EOF
   // TODO (yanqin) add support for retry policy, e.g. sleep, max retry limit,
@@ -136,6 +180,20 @@ class Reader {
   // Return type, or one of the preceding special values
   unsigned int ReadPhysicalRecord(Slice* result, size_t* drop_size);
 
+  // Reads the next logical record as it is stored
+  bool ReadRawRecord(Slice* record, std::string* scratch,
+                     WALRecoveryMode wal_recovery_mode);
+
+  // Reads compressed records ahead into pending_, up to
+  // decompression_threads_ whole frames, and decompresses them
+  void ReadCompressedRecords(WALRecoveryMode wal_recovery_mode);
+
+  // Decompresses pending_[begin, end) in order with "uncompress", where
+  // "intact" tells whether the frame of pending_[begin] is intact
+  // Returns whether the frame is intact after the records.
+  bool DecompressRecords(size_t begin, size_t end, bool intact,
+                         ZSTDStreamingUncompress* uncompress);
+
   // Read some more
   bool ReadMore(size_t* drop_size, int* error);
 
@@ -12,6 +12,7 @@
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 #include "util/random.h"
@@ -180,6 +181,8 @@ class LogTest : public ::testing::TestWithParam<int> {
 
   void Write(const std::string& msg) { writer_.AddRecord(Slice(msg)); }
 
+  void Write(const autovector<Slice>& parts) { writer_.AddRecord(parts); }
+
   size_t WrittenBytes() const { return dest_contents().size(); }
 
   std::string Read(const WALRecoveryMode wal_recovery_mode =
@@ -300,6 +303,23 @@ TEST_P(LogTest, Fragmentation) {
   ASSERT_EQ("EOF", Read());
 }
 
+TEST_P(LogTest, GatherParts) {
+  // Parts of a record cross block boundaries and include empty slices
+  std::vector<std::string> pieces = {"head", "", BigString("a", 40000), "x",
+                                     BigString("b", 30000), ""};
+  autovector<Slice> parts;
+  std::string expected;
+  for (auto& piece : pieces) {
+    parts.push_back(piece);
+    expected.append(piece);
+  }
+  Write(parts);
+  Write("small");
+  ASSERT_EQ(expected, Read());
+  ASSERT_EQ("small", Read());
+  ASSERT_EQ("EOF", Read());
+}
+
 TEST_P(LogTest, MarginalTrailer) {
   // Make a trailer that is exactly the same length as an empty record.
   int header_size = GetParam() ? kRecyclableHeaderSize : kHeaderSize;
@@ -814,6 +834,134 @@ TEST_P(RetriableLogTest, TailLog_FullHeader) {
 
 INSTANTIATE_TEST_CASE_P(bool, RetriableLogTest, ::testing::Values(0, 2));
 
+class CompressedLogTest : public ::testing::TestWithParam<int> {
+ public:
+  class StringSource : public SequentialFile {
+   public:
+    explicit StringSource(const std::string& contents) : contents_(contents) {}
+
+    Status Read(size_t n, Slice* result, char* scratch) override {
+      n = std::min(n, contents_.size());
+      memcpy(scratch, contents_.data(), n);
+      *result = Slice(scratch, n);
+      contents_.remove_prefix(n);
+      return Status::OK();
+    }
+
+    Status Skip(uint64_t n) override {
+      contents_.remove_prefix(std::min<uint64_t>(n, contents_.size()));
+      return Status::OK();
+    }
+
+   private:
+    Slice contents_;
+  };
+
+  class ReportCollector : public Reader::Reporter {
+   public:
+    void Corruption(size_t bytes, const Status& /*status*/) override {
+      dropped_bytes_ += bytes;
+      ++drops_;
+    }
+
+    size_t dropped_bytes_ = 0;
+    int drops_ = 0;
+  };
+
+  // Writes the records to contents_, compressed
+  void WriteRecords() {
+    Slice sink_contents;
+    std::unique_ptr<WritableFileWriter> dest(test::GetWritableFileWriter(
+        new test::StringSink(&sink_contents), "" /* don't care */));
+    Writer writer(std::move(dest), 123, GetParam(), false /* manual_flush */,
+                  kZSTD);
+    Random rnd(301);
+    for (int i = 0; i < 3000; ++i) {
+      records_.push_back(RandomSkewedString(i, &rnd));
+      ASSERT_OK(writer.AddRecord(records_.back()));
+    }
+    // Records longer than a block, empty, and made of several parts
+    records_.push_back(BigString("large", 3 * kBlockSize + 17));
+    ASSERT_OK(writer.AddRecord(records_.back()));
+    records_.push_back("");
+    ASSERT_OK(writer.AddRecord(records_.back()));
+    autovector<Slice> parts;
+    parts.push_back("multi");
+    parts.push_back("");
+    parts.push_back("part");
+    records_.push_back("multipart");
+    ASSERT_OK(writer.AddRecord(parts));
+    contents_ = sink_contents.ToString();
+  }
+
+  // Reads contents_ until EOF
+  std::vector<std::string> ReadRecords(size_t decompression_threads,
+                                       ReportCollector* report) {
+    std::unique_ptr<SequentialFileReader> source(
+        test::GetSequentialFileReader(new StringSource(contents_), ""));
+    Reader reader(nullptr, std::move(source), report, true /* checksum */,
+                  123 /* log_number */, false /* retry_after_eof */,
+                  decompression_threads);
+    std::vector<std::string> result;
+    std::string scratch;
+    Slice record;
+    while (reader.ReadRecord(&record, &scratch,
+                             WALRecoveryMode::kSkipAnyCorruptedRecords)) {
+      result.push_back(record.ToString());
+    }
+    return result;
+  }
+
+  std::vector<std::string> records_;
+  std::string contents_;
+};
+
+TEST_P(CompressedLogTest, ReadWrite) {
+  if (!ZSTD_Supported()) {
+    return;
+  }
+  WriteRecords();
+  size_t raw_size = 0;
+  for (auto& record : records_) {
+    raw_size += record.size();
+  }
+  ASSERT_LT(contents_.size(), raw_size / 2);
+  ASSERT_EQ(static_cast<char>(kSetCompressionType), contents_[6]);
+  for (size_t threads : {1, 4}) {
+    ReportCollector report;
+    ASSERT_TRUE(records_ == ReadRecords(threads, &report));
+    ASSERT_EQ(0, report.drops_);
+  }
+}
+
+TEST_P(CompressedLogTest, Corruption) {
+  if (!ZSTD_Supported()) {
+    return;
+  }
+  WriteRecords();
+  // Corrupt a record in the middle of the log
+  contents_[contents_.size() / 2] ^= 0x55;
+  for (size_t threads : {1, 4}) {
+    ReportCollector report;
+    std::vector<std::string> result = ReadRecords(threads, &report);
+    ASSERT_GT(report.drops_, 0);
+    // The rest of the corrupted frame is dropped, the next frames are read
+    ASSERT_LT(result.size(), records_.size());
+    ASSERT_GT(result.size(), records_.size() / 2);
+    ASSERT_EQ(records_.back(), result.back());
+    size_t i = 0;
+    for (auto& record : result) {
+      while (i < records_.size() && records_[i] != record) {
+        ++i;
+      }
+      ASSERT_LT(i, records_.size());
+      ++i;
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(bool, CompressedLogTest, ::testing::Values(0, 1));
+
 }  // namespace log
 }  // namespace TERARKDB_NAMESPACE
 
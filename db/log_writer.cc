@@ -11,9 +11,12 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 
@@ -21,16 +24,24 @@ namespace TERARKDB_NAMESPACE {
 namespace log {
 
 Writer::Writer(std::unique_ptr<WritableFileWriter>&& dest, uint64_t log_number,
-               bool recycle_log_files, bool manual_flush)
+               bool recycle_log_files, bool manual_flush,
+               CompressionType compression_type)
     : dest_(std::move(dest)),
       block_offset_(0),
       log_number_(log_number),
       recycle_log_files_(recycle_log_files),
+      compression_type_(compression_type),
+      compression_type_recorded_(false),
       manual_flush_(manual_flush) {
   for (int i = 0; i <= kMaxRecordType; i++) {
     char t = static_cast<char>(i);
     type_crc_[i] = crc32c::Value(&t, 1);
   }
+  if (compression_type_ != kNoCompression) {
+    assert(compression_type_ == kZSTD);
+    // The fastest level, the log is compressed on the write path
+    compress_.reset(new ZSTDStreamingCompress(1, kCompressionFrameSize));
+  }
 }
 
 Writer::~Writer() { WriteBuffer(); }
@@ -38,8 +49,51 @@ Writer::~Writer() { WriteBuffer(); }
 Status Writer::WriteBuffer() { return dest_->Flush(); }
 
 Status Writer::AddRecord(const Slice& slice) {
-  const char* ptr = slice.data();
-  size_t left = slice.size();
+  autovector<Slice> parts;
+  parts.push_back(slice);
+  return AddRecord(parts);
+}
+
+Status Writer::AddRecord(const autovector<Slice>& parts) {
+  if (compress_ == nullptr) {
+    return AddRawRecord(parts);
+  }
+  Status s;
+  if (!compression_type_recorded_) {
+    assert(block_offset_ == 0);
+    char type = static_cast<char>(compression_type_);
+    autovector<Slice> payload;
+    payload.push_back(Slice(&type, 1));
+    const autovector<Slice>& parts_of_type = payload;
+    s = EmitPhysicalRecord(kSetCompressionType, parts_of_type.begin(), 0, 1);
+    if (!s.ok()) {
+      return s;
+    }
+    compression_type_recorded_ = true;
+  }
+  compressed_.assign(1, '\0');
+  bool new_frame = false;
+  bool frame_end = false;
+  if (!compress_->Compress(parts.begin(), parts.end(), &compressed_,
+                           &new_frame, &frame_end)) {
+    return Status::Corruption("Failed to compress log record");
+  }
+  compressed_[0] = static_cast<char>(
+      (new_frame ? kCompressedRecordNewFrame : 0) |
+      (frame_end ? kCompressedRecordFrameEnd : 0));
+  autovector<Slice> compressed_parts;
+  compressed_parts.push_back(compressed_);
+  return AddRawRecord(compressed_parts);
+}
+
+Status Writer::AddRawRecord(const autovector<Slice>& parts) {
+  size_t left = 0;
+  for (auto& part : parts) {
+    left += part.size();
+  }
+  // Position of the next payload byte
+  auto part = parts.begin();
+  size_t offset = 0;
 
   // Header size varies depending on whether we are recycling or not.
   const int header_size =
@@ -86,9 +140,18 @@ Status Writer::AddRecord(const Slice& slice) {
       type = recycle_log_files_ ? kRecyclableMiddleType : kMiddleType;
     }
 
-    s = EmitPhysicalRecord(type, ptr, fragment_length);
-    ptr += fragment_length;
+    s = EmitPhysicalRecord(type, part, offset, fragment_length);
     left -= fragment_length;
+    for (size_t n = fragment_length; n > 0;) {
+      size_t part_left = part->size() - offset;
+      if (n < part_left) {
+        offset += n;
+        break;
+      }
+      n -= part_left;
+      ++part;
+      offset = 0;
+    }
     begin = false;
   } while (s.ok() && left > 0);
   return s;
@@ -96,7 +159,9 @@ Status Writer::AddRecord(const Slice& slice) {
 
 bool Writer::TEST_BufferIsEmpty() { return dest_->TEST_BufferIsEmpty(); }
 
-Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
+Status Writer::EmitPhysicalRecord(RecordType t,
+                                  autovector<Slice>::const_iterator part,
+                                  size_t offset, size_t n) {
   assert(n <= 0xffff);  // Must fit in two bytes
 
   size_t header_size;
@@ -108,7 +173,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
   buf[6] = static_cast<char>(t);
 
   uint32_t crc = type_crc_[t];
-  if (t < kRecyclableFullType) {
+  if (t < kRecyclableFullType || t == kSetCompressionType) {
     // Legacy record format
     assert(block_offset_ + kHeaderSize + n <= kBlockSize);
     header_size = kHeaderSize;
@@ -126,15 +191,34 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
     crc = crc32c::Extend(crc, buf + 7, 4);
   }
 
+  // Calls fn on each piece of the payload
+  auto for_each_piece = [&](auto&& fn) {
+    auto it = part;
+    size_t it_offset = offset;
+    for (size_t left = n; left > 0; ++it, it_offset = 0) {
+      size_t len = std::min(it->size() - it_offset, left);
+      if (len > 0 && !fn(Slice(it->data() + it_offset, len))) {
+        return;
+      }
+      left -= len;
+    }
+  };
+
   // Compute the crc of the record type and the payload.
-  crc = crc32c::Extend(crc, ptr, n);
+  for_each_piece([&](const Slice& piece) {
+    crc = crc32c::Extend(crc, piece.data(), piece.size());
+    return true;
+  });
   crc = crc32c::Mask(crc);  // Adjust for storage
   EncodeFixed32(buf, crc);
 
   // Write the header and the payload
   Status s = dest_->Append(Slice(buf, header_size));
   if (s.ok()) {
-    s = dest_->Append(Slice(ptr, n));
+    for_each_piece([&](const Slice& piece) {
+      s = dest_->Append(piece);
+      return s.ok();
+    });
     if (s.ok()) {
       if (!manual_flush_) {
         s = dest_->Flush();
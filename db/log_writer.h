@@ -11,15 +11,19 @@
 #include <stdint.h>
 
 #include <memory>
+#include <string>
 
 #include "db/log_format.h"
+#include "rocksdb/options.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/autovector.h"
 
 namespace TERARKDB_NAMESPACE {
 
 class WritableFileWriter;
+class ZSTDStreamingCompress;
 
 using std::unique_ptr;
 
@@ -67,19 +71,32 @@ namespace log {
  * Same as above, with the addition of
  * Log number = 32bit log file number, so that we can distinguish between
  * records written by the most recent log writer vs a previous one.
+ *
+ * Compressed log:
+ *
+ * A compressed log starts with a kSetCompressionType record whose payload
+ * is the compression type byte. The payload of every following logical
+ * record is a flags byte and the record compressed as part of a stream of
+ * frames (see kCompressedRecordNewFrame), before fragmentation.
  */
 class Writer {
  public:
   // Create a writer that will append data to "*dest".
   // "*dest" must be initially empty.
   // "*dest" must remain live while this Writer is in use.
+  // Records are compressed with "compression_type", kZSTD or kNoCompression.
   explicit Writer(std::unique_ptr<WritableFileWriter>&& dest,
                   uint64_t log_number, bool recycle_log_files,
-                  bool manual_flush = false);
+                  bool manual_flush = false,
+                  CompressionType compression_type = kNoCompression);
   ~Writer();
 
   Status AddRecord(const Slice& slice);
 
+  // Add one record whose payload is the concatenation of parts, without
+  // gathering them into a contiguous buffer first.
+  Status AddRecord(const autovector<Slice>& parts);
+
   WritableFileWriter* file() { return dest_.get(); }
   const WritableFileWriter* file() const { return dest_.get(); }
 
@@ -100,7 +117,20 @@ class Writer {
   // record type stored in the header.
   uint32_t type_crc_[kMaxRecordType + 1];
 
-  Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
+  // Set for a compressed log
+  std::unique_ptr<ZSTDStreamingCompress> compress_;
+  CompressionType compression_type_;
+  bool compression_type_recorded_;
+  std::string compressed_;
+
+  // Fragment the record into physical records
+  Status AddRawRecord(const autovector<Slice>& parts);
+
+  // Emit length bytes starting at offset in *part and continuing through the
+  // following parts.
+  Status EmitPhysicalRecord(RecordType type,
+                            autovector<Slice>::const_iterator part,
+                            size_t offset, size_t length);
 
   // If true, it does not flush after each write. Instead it relies on the upper
   // layer to manually does the flush by calling ::WriteBuffer()
@@ -32,6 +32,7 @@
 #include "util/c_style_callback.h"
 #include "util/iterator_cache.h"
 #include "util/sst_file_manager_impl.h"
+#include "util/sync_point.h"
 #include "version_set.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -119,6 +120,8 @@ struct RangeWithDepend {
   bool has_delete_range;
   bool marked_for_compaction;
   bool stable;
+  // Encoded value of the input map element, kept while the range is stable
+  Slice raw_value;
   std::vector<MapSstElement::LinkTarget> dependence;
 
   RangeWithDepend() = default;
@@ -140,7 +143,8 @@ struct RangeWithDepend {
     dependence.emplace_back(MapSstElement::LinkTarget{f->fd.GetNumber(), 0});
   }
 
-  RangeWithDepend(const MapSstElement& map_element, Arena* arena) {
+  RangeWithDepend(const MapSstElement& map_element, const Slice& value,
+                  Arena* arena) {
     point[0] = ArenaPinSlice(map_element.smallest_key, arena);
     point[1] = ArenaPinSlice(map_element.largest_key, arena);
     include[0] = map_element.include_smallest;
@@ -148,6 +152,7 @@ struct RangeWithDepend {
     has_delete_range = map_element.has_delete_range;
     marked_for_compaction = map_element.marked_for_compaction;
     stable = true;
+    raw_value = ArenaPinSlice(value, arena);
     dependence = map_element.link;
   }
   RangeWithDepend(const Range& range, Arena* arena) {
@@ -303,6 +308,26 @@ class MapSstElementIterator : public MapSstRangeIterator {
         }
         return;
       }
+      if (where_->stable && !where_->raw_value.empty()) {
+        // Untouched element of an input map sst, copy the record verbatim
+        map_elements_.largest_key = where_->point[1];
+        size_t range_size = 0;
+        for (auto& link : where_->dependence) {
+          auto ib = dependence_build_.emplace(link.file_number, link.size);
+          if (!ib.second) {
+            ib.first->second += link.size;
+          }
+          range_size += link.size;
+        }
+        sst_read_amp_ = std::max(sst_read_amp_, where_->dependence.size());
+        sst_read_amp_ratio_ += where_->dependence.size() * range_size;
+        sst_read_amp_size_ += range_size;
+        buffer_.assign(where_->raw_value.data(), where_->raw_value.size());
+        TEST_SYNC_POINT_CALLBACK("MapSstElementIterator::CopyRawValue",
+                                 &map_elements_.largest_key);
+        ++where_;
+        break;
+      }
       auto& start = map_elements_.smallest_key = where_->point[0];
       auto& end = map_elements_.largest_key = where_->point[1];
       assert(icomp_.Compare(start, end) <= 0);
@@ -565,7 +590,7 @@ Status LoadRangeWithDepend(std::vector<RangeWithDepend>& ranges, Arena* arena,
           return Status::Corruption(
               "LoadRangeWithDepend: Map sst invalid key or value");
         }
-        ranges.emplace_back(map_element, arena);
+        ranges.emplace_back(map_element, value.slice(), arena);
       }
     } else {
       ranges.emplace_back(f, arena);
@@ -630,8 +655,11 @@ Status AdjustRange(const InternalKeyComparator* ic, InternalIterator* iter,
                                             kMaxSequenceNumber,
                                             static_cast<ValueType>(0), arena);
       range->include[0] = false;
+      range->raw_value.clear();
     }
     // right
+    Slice right = range->point[1];
+    bool include_right = range->include[1];
     if (ic->Compare(range->point[1], largest) >= 0) {
       range->point[1] = largest;
       range->include[1] = true;
@@ -653,6 +681,10 @@ Status AdjustRange(const InternalKeyComparator* ic, InternalIterator* iter,
     } else {
       assert(range->include[1]);
     }
+    if (range->include[1] != include_right ||
+        ic->Compare(range->point[1], right) != 0) {
+      range->raw_value.clear();
+    }
     if (new_ranges.empty()) {
       new_ranges.emplace_back(std::move(*range));
       continue;
@@ -768,6 +800,7 @@ std::vector<RangeWithDepend> PartitionRangeWithDepend(
     auto& has_delete_range = output.back().has_delete_range;
     auto& marked_for_compaction = output.back().marked_for_compaction;
     auto& stable = output.back().stable;
+    auto& raw_value = output.back().raw_value;
     assert(a != nullptr || b != nullptr);
     switch (type) {
       case PartitionType::kMerge:
@@ -784,11 +817,13 @@ std::vector<RangeWithDepend> PartitionRangeWithDepend(
             has_delete_range = a->has_delete_range;
             marked_for_compaction = a->marked_for_compaction;
             stable = a->stable;
+            raw_value = a->raw_value;
           }
         } else {
           has_delete_range = b->has_delete_range;
           marked_for_compaction = b->marked_for_compaction;
           stable = b->stable;
+          raw_value = b->raw_value;
           dependence = b->dependence;
         }
         break;
@@ -797,6 +832,7 @@ std::vector<RangeWithDepend> PartitionRangeWithDepend(
           has_delete_range = a->has_delete_range;
           marked_for_compaction = a->marked_for_compaction;
           stable = a->stable;
+          raw_value = a->raw_value;
           dependence = a->dependence;
         } else {
           assert(b->dependence.empty());
@@ -807,6 +843,7 @@ std::vector<RangeWithDepend> PartitionRangeWithDepend(
           has_delete_range = a->has_delete_range;
           marked_for_compaction = a->marked_for_compaction;
           stable = a->stable;
+          raw_value = a->raw_value;
           dependence = a->dependence;
           assert(b->dependence.empty());
         }
@@ -973,7 +1010,8 @@ Status MapBuilder::Build(const std::vector<CompactionInputFiles>& inputs,
                          Version* version, VersionEdit* edit,
                          FileMetaData* file_meta_ptr,
                          std::unique_ptr<TableProperties>* prop_ptr,
-                         std::set<FileMetaData*>* deleted_files) {
+                         std::set<FileMetaData*>* deleted_files,
+                         SequenceNumber range_deletion_drop_seqno) {
   assert(output_level != 0 || inputs.front().level == 0);
   assert(!inputs.front().files.empty());
   auto vstorage = version->storage_info();
@@ -1149,6 +1187,109 @@ Status MapBuilder::Build(const std::vector<CompactionInputFiles>& inputs,
     }
     tombstone_iter.set(builder.Finish());
   }
+  if (range_deletion_drop_seqno > 0 && !tombstones.empty() &&
+      !level_ranges.empty()) {
+    assert(!optimize_range_deletion);
+    auto uc = icomp.user_comparator();
+    auto& input_ranges = level_ranges.front();
+    // No point key of the files linked in [start_key, end_key) is as new as
+    // seqno, so the tombstone deletes all of them
+    auto all_covered = [&](const Slice& start_key, const Slice& end_key,
+                           SequenceNumber seqno, bool* covered) {
+      *covered = false;
+      InternalKey seek_key(start_key, kMaxSequenceNumber, kValueTypeForSeek);
+      auto it = std::lower_bound(
+          input_ranges.begin(), input_ranges.end(), start_key,
+          [uc](const RangeWithDepend& r, const Slice& key) {
+            return uc->Compare(ExtractUserKey(r.point[1]), key) < 0;
+          });
+      for (; it != input_ranges.end() &&
+             uc->Compare(ExtractUserKey(it->point[0]), end_key) < 0;
+           ++it) {
+        for (auto& link : it->dependence) {
+          const FileMetaData* f = nullptr;
+          auto iter =
+              iterator_cache.GetIterator(link.file_number, nullptr, &f);
+          if (!iter->status().ok()) {
+            return iter->status();
+          }
+          if (f == nullptr || f->prop.is_map_sst()) {
+            return Status::OK();
+          }
+          if (f->fd.largest_seqno < seqno) {
+            continue;
+          }
+          for (iter->Seek(seek_key.Encode());
+               iter->Valid() &&
+               uc->Compare(ExtractUserKey(iter->key()), end_key) < 0;
+               iter->Next()) {
+            if (GetInternalKeySeqno(iter->key()) >= seqno) {
+              return Status::OK();
+            }
+          }
+          if (!iter->status().ok()) {
+            return iter->status();
+          }
+        }
+      }
+      *covered = true;
+      return Status::OK();
+    };
+    std::vector<RangeWithDepend> ranges;
+    Slice last_end_key;
+    for (tombstone_iter->SeekToFirst(); tombstone_iter->Valid();
+         tombstone_iter->Next()) {
+      auto seqno = GetInternalKeySeqno(tombstone_iter->key());
+      if (seqno >= range_deletion_drop_seqno) {
+        continue;
+      }
+      auto start_key = ExtractUserKey(tombstone_iter->key());
+      auto v = tombstone_iter->value();
+      s = v.fetch();
+      if (!s.ok()) {
+        return s;
+      }
+      auto end_key = v.slice();
+      bool covered;
+      s = all_covered(start_key, end_key, seqno, &covered);
+      if (!s.ok()) {
+        return s;
+      }
+      if (!covered) {
+        continue;
+      }
+      if (!ranges.empty() && uc->Compare(start_key, last_end_key) <= 0) {
+        if (uc->Compare(end_key, last_end_key) > 0) {
+          ranges.back().point[1] = ArenaPinInternalKey(
+              end_key, kMaxSequenceNumber, static_cast<ValueType>(0), arena);
+        }
+      } else {
+        ranges.emplace_back();
+        auto& r = ranges.back();
+        r.point[0] = ArenaPinInternalKey(start_key, kMaxSequenceNumber,
+                                         static_cast<ValueType>(0), arena);
+        r.point[1] = ArenaPinInternalKey(end_key, kMaxSequenceNumber,
+                                         static_cast<ValueType>(0), arena);
+        r.include[0] = false;
+        r.include[1] = true;
+        r.has_delete_range = false;
+        r.marked_for_compaction = false;
+        r.stable = false;
+      }
+      last_end_key = ExtractUserKey(ranges.back().point[1]);
+    }
+    if (!ranges.empty()) {
+      ROCKS_LOG_INFO(db_options_.info_log,
+                     "[%s] [JOB %d] MapBuilder drops %" ROCKSDB_PRIszt
+                     " ranges covered by range deletions",
+                     cfd->GetName().c_str(), job_id_, ranges.size());
+      input_ranges = PartitionRangeWithDepend(input_ranges, ranges, icomp,
+                                              PartitionType::kDelete);
+      if (input_ranges.empty()) {
+        level_ranges.pop_front();
+      }
+    }
+  }
   if (optimize_range_deletion && !tombstones.empty() && !level_ranges.empty()) {
     std::vector<RangeWithDepend> ranges;
     auto uc = icomp.user_comparator();
@@ -1578,12 +1719,61 @@ Status MapBuilder::Build(const std::vector<CompactionInputFiles>& inputs,
   return s;
 }
 
+Status MapBuilder::Build(const std::vector<FileMetaData*>& files,
+                         uint32_t output_path_id, ColumnFamilyData* cfd,
+                         Version* version, FileMetaData* file_meta,
+                         std::unique_ptr<TableProperties>* prop) {
+  assert(!files.empty());
+  auto& icomp = cfd->internal_comparator();
+  assert(std::is_sorted(files.begin(), files.end(),
+                        TERARK_FIELD_P(largest) < icomp));
+  IteratorCacheContext iterator_cache_ctx = {
+      cfd, &version->GetMutableCFOptions(), version, &env_options_};
+  DependenceMap empty_dependence_map;
+  IteratorCache iterator_cache(empty_dependence_map, &iterator_cache_ctx,
+                               IteratorCacheContext::CreateIter);
+  Arena* arena = iterator_cache.GetArena();
+  FileMetaDataBoundBuilder bound_builder(&icomp);
+  std::vector<RangeWithDepend> ranges;
+  ranges.reserve(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    auto f = files[i];
+    assert(!f->prop.is_map_sst());
+    iterator_cache.PutFileMetaData(f);
+    bound_builder.Update(f);
+    // Every range covers its whole file, up to the first key of the next one
+    ranges.emplace_back(f, arena);
+    auto& r = ranges.back();
+    r.point[0] = ArenaPinInternalKey(f->smallest.user_key(), kMaxSequenceNumber,
+                                     static_cast<ValueType>(0), arena);
+    r.include[0] = false;
+    if (i + 1 < files.size()) {
+      assert(icomp.user_comparator()->Compare(
+                 f->largest.user_key(), files[i + 1]->smallest.user_key()) <
+             0);
+      r.point[1] = ArenaPinInternalKey(files[i + 1]->smallest.user_key(),
+                                       kMaxSequenceNumber,
+                                       static_cast<ValueType>(0), arena);
+    } else {
+      r.point[1] = ArenaPinInternalKey(f->largest.user_key(), 0,
+                                       static_cast<ValueType>(0), arena);
+    }
+  }
+  MapSstElementIterator output_iter(ranges, iterator_cache, icomp);
+  return WriteOutputFile(bound_builder, &output_iter, nullptr /* tombstone */,
+                         output_path_id, cfd, version->GetMutableCFOptions(),
+                         file_meta, prop);
+}
+
 Status MapBuilder::WriteOutputFile(
     const FileMetaDataBoundBuilder& bound_builder,
     MapSstRangeIterator* range_iter, InternalIterator* tombstone_iter,
     uint32_t output_path_id, ColumnFamilyData* cfd,
     const MutableCFOptions& mutable_cf_options, FileMetaData* file_meta,
     std::unique_ptr<TableProperties>* prop) {
+  LatencyHistGuard guard(cfd->latency_reporters().map_sst_build);
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_MAP_SST_BUILD);
   std::vector<std::unique_ptr<IntTblPropCollectorFactory>> collectors;
 
   // no need to lock because VersionSet::next_file_number_ is atomic
@@ -1616,7 +1806,8 @@ Status MapBuilder::WriteOutputFile(
 
   file_meta->fd = FileDescriptor(file_number, output_path_id, 0);
 
-  writable_file->SetIOPriority(Env::IO_LOW);
+  // map sst is small, and it's often what frees L0 in lazy compaction
+  writable_file->SetIOPriority(Env::IO_MID);
   writable_file->SetWriteLifeTimeHint(Env::WLTH_SHORT);
   // map sst always small
   writable_file->SetPreallocationBlockSize(4ULL << 20);
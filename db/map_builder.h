@@ -58,6 +58,9 @@ class MapBuilder {
   // added_files is sorted
   // file_meta::fd::file_size == 0 if don't need create map files
   // file_meta , porp , deleted_files nullptr if ignore
+  // range tombstones older than range_deletion_drop_seqno remove the ranges
+  // they cover from the map, when no point key in there is as new as the
+  // tombstone. Only safe for the bottommost level, 0 to disable
   Status Build(const std::vector<CompactionInputFiles>& inputs,
                const std::vector<Range>& deleted_range,
                const std::vector<FileMetaData*>& added_files, int output_level,
@@ -65,7 +68,8 @@ class MapBuilder {
                bool optimize_range_deletion, Version* version,
                VersionEdit* edit, FileMetaData* file_meta = nullptr,
                std::unique_ptr<TableProperties>* porp = nullptr,
-               std::set<FileMetaData*>* deleted_files = nullptr);
+               std::set<FileMetaData*>* deleted_files = nullptr,
+               SequenceNumber range_deletion_drop_seqno = 0);
 
   // All params are references or pointers
   // push_range use user key
@@ -75,6 +79,15 @@ class MapBuilder {
                VersionEdit* edit,
                std::vector<MapBuilderOutput>* output = nullptr);
 
+  // All params are references or pointers
+  // files are sorted and don't overlap, they become the dependence of a new
+  // map sst, so they can be installed as one sorted run. The caller adds the
+  // map sst and files to the version
+  Status Build(const std::vector<FileMetaData*>& files,
+               uint32_t output_path_id, ColumnFamilyData* cfd,
+               Version* version, FileMetaData* file_meta,
+               std::unique_ptr<TableProperties>* prop);
+
  private:
   Status WriteOutputFile(const FileMetaDataBoundBuilder& bound_builder,
                          MapSstRangeIterator* range_iter,
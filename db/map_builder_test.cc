@@ -375,6 +375,112 @@ TEST_F(MapBuilderTest, MapSstInput) {
   ASSERT_OK(s);
 }
 
+TEST_F(MapBuilderTest, DropRangeDeletionCovered) {
+  Init();
+  MapBuilder map_builder(0, db_options_, env_options_, versions_.get(), stats_,
+                         dbname_);
+  input_files_.resize(2);
+  stl_wrappers::KVMap kv_contents1, kv_contents2;
+  kv_contents1 = CreateFile(0, 9, false /*is_range_delete*/);
+  stl_wrappers::KVMap del_contents1, del_contents2;
+  del_contents1 = CreateFile(2, 5, true);
+  del_contents2 = CreateFile(6, 8, true);
+  del_contents1.insert(del_contents2.begin(), del_contents2.end());
+  // Newer than the tombstone of [6, 8), which stays in the map
+  kv_contents2 = CreateFile(7, 7, false);
+  AddMockFile(kv_contents2, 0 /*level*/, true, del_contents1);
+  AddMockFile(kv_contents1, 1, false, stl_wrappers::KVMap());
+  UpdateVersionStorageInfo();
+  std::vector<Range> deleted_range;
+  std::vector<FileMetaData*> added_files;
+  std::unique_ptr<FileMetaData> output_file(new FileMetaData);
+  Status s = map_builder.Build(input_files_, deleted_range, added_files, 1, 0,
+                               cfd_, false, cfd_->current(), &edit,
+                               output_file.get(), nullptr, nullptr,
+                               kMaxSequenceNumber);
+  ASSERT_OK(s);
+  ASSERT_GT(output_file->fd.GetNumber(), 0U);
+
+  DependenceMap empty_dependence_map;
+  std::unique_ptr<InternalIterator> iter(cfd_->table_cache()->NewIterator(
+      ReadOptions(), env_options_, cfd_->internal_comparator(), *output_file,
+      empty_dependence_map, nullptr /* range_del_agg */,
+      mutable_cf_options_.prefix_extractor.get(), nullptr, nullptr,
+      false /* for_compaction */, nullptr /* arena */, false /* skip_filter */,
+      1));
+  ASSERT_OK(iter->status());
+  auto ucmp = cfd_->user_comparator();
+  auto covers = [ucmp](const MapSstElement& e, const Slice& key) {
+    return ucmp->Compare(ExtractUserKey(e.smallest_key), key) <= 0 &&
+           ucmp->Compare(key, ExtractUserKey(e.largest_key)) <= 0;
+  };
+  bool covers_7 = false;
+  MapSstElement element;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    auto value = iter->value();
+    ASSERT_OK(value.fetch());
+    ASSERT_TRUE(element.Decode(iter->key(), value.slice()));
+    ASSERT_FALSE(covers(element, "3"));
+    ASSERT_FALSE(covers(element, "4"));
+    covers_7 |= covers(element, "7");
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_TRUE(covers_7);
+}
+
+// The last element of an input map is extended to the next file on the right,
+// so it is encoded again instead of copied
+TEST_F(MapBuilderTest, MapSstInputRightBoundMoved) {
+  Init();
+  MapBuilder map_builder(0, db_options_, env_options_, versions_.get(), stats_,
+                         dbname_);
+  input_files_.resize(3);
+  stl_wrappers::KVMap del_contents;
+  AddMockFile(CreateFile(0, 4, false /*is_range_delete*/), 0 /*level*/, false,
+              del_contents);
+  AddMockFile(CreateFile(3, 4, false), 1, false, del_contents);
+  AddMockFile(CreateFile(5, 6, false), 2, false, del_contents);
+  UpdateVersionStorageInfo();
+  std::vector<Range> deleted_range;
+  std::vector<FileMetaData*> added_files;
+  std::vector<CompactionInputFiles> inputs(input_files_.begin(),
+                                           input_files_.begin() + 2);
+  std::unique_ptr<FileMetaData> map_file(new FileMetaData);
+  Status s = map_builder.Build(inputs, deleted_range, added_files, 1, 0, cfd_,
+                               false, cfd_->current(), &edit, map_file.get(),
+                               nullptr, nullptr);
+  ASSERT_OK(s);
+  ASSERT_TRUE(map_file->prop.is_map_sst());
+
+  std::vector<std::string> copied;
+  SyncPoint::GetInstance()->SetCallBack(
+      "MapSstElementIterator::CopyRawValue", [&](void* arg) {
+        auto largest_key = static_cast<Slice*>(arg);
+        copied.emplace_back(ExtractUserKey(*largest_key).ToString());
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  // kNoRangeDeletions=0 kHasSnapshots=0 kMapHandleRangeDeletions=0
+  map_file->prop.flags = 0;
+  inputs.resize(1);
+  inputs[0].files = {map_file.get()};
+  inputs.emplace_back(input_files_[2]);
+  std::unique_ptr<FileMetaData> output_file(new FileMetaData);
+  s = map_builder.Build(inputs, deleted_range, added_files, 1, 0, cfd_, false,
+                        cfd_->current(), &edit, output_file.get(), nullptr,
+                        nullptr);
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_OK(s);
+  ASSERT_GT(output_file->fd.GetNumber(), 0U);
+
+  // The elements of the map before its last are kept verbatim, the last one
+  // now ends at the first key of the file on its right
+  ASSERT_FALSE(copied.empty());
+  for (auto& key : copied) {
+    ASSERT_LT(key, "5");
+  }
+}
+
 // only one dependence file
 TEST_F(MapBuilderTest, NoNeedBuildMapSst) {
   Init();
@@ -16,10 +16,12 @@
 #include "db/dbformat.h"
 #include "db/merge_context.h"
 #include "db/merge_helper.h"
+#include "db/negative_lookup_cache.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/read_callback.h"
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/statistics.h"
+#include "monitoring/usdt.h"
 #include "port/port.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/env.h"
@@ -54,6 +56,8 @@ ImmutableMemTableOptions::ImmutableMemTableOptions(
       inplace_update_num_locks(mutable_cf_options.inplace_update_num_locks),
       inplace_callback(ioptions.inplace_callback),
       max_successive_merges(mutable_cf_options.max_successive_merges),
+      memtable_merge_fold_threshold(
+          mutable_cf_options.memtable_merge_fold_threshold),
       statistics(ioptions.statistics),
       merge_operator(ioptions.merge_operator),
       info_log(ioptions.info_log) {}
@@ -75,14 +79,17 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
                write_buffer_manager->cost_to_cache()))
                  ? &mem_tracker_
                  : nullptr,
-             mutable_cf_options.memtable_huge_page_size),
+             mutable_cf_options.memtable_huge_page_size,
+             write_buffer_manager != nullptr
+                 ? write_buffer_manager->arena_block_pool()
+                 : nullptr),
       table_(mutable_cf_options.memtable_factory->CreateMemTableRep(
-          comparator_, needs_dup_key_check, &arena_,
-          mutable_cf_options.prefix_extractor.get(), ioptions.info_log,
-          column_family_id)),
+          comparator_, needs_dup_key_check, &arena_, ioptions,
+          mutable_cf_options, column_family_id)),
       range_del_table_(SkipListFactory().CreateMemTableRep(
           comparator_, needs_dup_key_check, &arena_, nullptr /* transform */,
           ioptions.info_log, column_family_id)),
+      range_del_index_(comparator_.comparator.user_comparator()),
       data_size_(0),
       num_entries_(0),
       num_deletes_(0),
@@ -138,6 +145,7 @@ size_t MemTable::ApproximateMemoryUsage() {
   autovector<size_t> usages = {
       arena_.ApproximateMemoryUsage(), table_->ApproximateMemoryUsage(),
       range_del_table_->ApproximateMemoryUsage(),
+      range_del_index_.ApproximateMemoryUsage(),
       TERARKDB_NAMESPACE::ApproximateMemoryUsage(insert_hints_)};
   size_t total_usage = 0;
   for (size_t usage : usages) {
@@ -169,6 +177,7 @@ bool MemTable::ShouldFlushNow() const {
   // shouldn't flush.
   auto allocated_memory = table_->ApproximateMemoryUsage() +
                           range_del_table_->ApproximateMemoryUsage() +
+                          range_del_index_.ApproximateMemoryUsage() +
                           arena_.MemoryAllocatedBytes();
 
   // if we can still allocate one more block without exceeding the
@@ -611,6 +620,11 @@ bool MemTable::Add(SequenceNumber s, ValueType type,
                    const Slice& key, /* user key */
                    const Slice& value, bool allow_concurrent,
                    MemTablePostProcessInfo* post_process_info) {
+  TERARKDB_PROBE2(memtable_insert, key.size(), value.size());
+  if (negative_lookup_cache_ != nullptr) {
+    // Before the write is published
+    negative_lookup_cache_->Invalidate(key, s);
+  }
   std::unique_ptr<MemTableRep>& table =
       type == kTypeRangeDeletion ? range_del_table_ : table_;
 
@@ -695,6 +709,7 @@ bool MemTable::Add(SequenceNumber s, ValueType type,
     }
   }
   if (type == kTypeRangeDeletion) {
+    range_del_index_.Add(key, value, s);
     num_range_del_.store(num_range_del_.load(std::memory_order_relaxed) + 1,
                          std::memory_order_relaxed);
   }
@@ -756,13 +771,25 @@ static bool SaveValue(void* arg, const Slice& internal_key, const char* value) {
       return true;  // to continue to the next seq
     }
 
-    s->seq = seq;
+    // The sequence of the latest entry, not of the merge operands under it
+    if (s->seq == kMaxSequenceNumber) {
+      s->seq = seq;
+    }
 
     if ((type == kTypeValue || type == kTypeMerge || type == kTypeValueIndex ||
          type == kTypeMergeIndex) &&
         max_covering_tombstone_seq > seq) {
       type = kTypeRangeDeletion;
     }
+    if (s->value == nullptr) {
+      // Only the sequence of the latest entry is asked for
+      *s->status = type == kTypeDeletion || type == kTypeSingleDeletion ||
+                           type == kTypeRangeDeletion
+                       ? Status::NotFound()
+                       : Status::OK();
+      *s->found_final_value = true;
+      return false;
+    }
     switch (type) {
       case kTypeValueIndex:
         assert(false);
@@ -841,6 +868,9 @@ static bool SaveValue(void* arg, const Slice& internal_key, const char* value) {
           *s->found_final_value = true;
           return false;
         }
+        MergeHelper::TimedPartialMergeBatch(merge_operator, s->key->user_key(),
+                                            merge_context, s->logger,
+                                            s->statistics, s->env_);
         return true;
       }
       default:
@@ -865,13 +895,12 @@ bool MemTable::Get(const LookupKey& key, LazyBuffer* value, Status* s,
   }
   PERF_TIMER_GUARD(get_from_memtable_time);
 
-  std::unique_ptr<FragmentedRangeTombstoneIterator> range_del_iter(
-      NewRangeTombstoneIterator(read_opts,
-                                GetInternalKeySeqno(key.internal_key())));
-  if (range_del_iter != nullptr) {
-    *max_covering_tombstone_seq =
-        std::max(*max_covering_tombstone_seq,
-                 range_del_iter->MaxCoveringTombstoneSeqnum(key.user_key()));
+  if (!read_opts.ignore_range_deletions &&
+      num_range_del_.load(std::memory_order_relaxed) != 0) {
+    *max_covering_tombstone_seq = std::max(
+        *max_covering_tombstone_seq,
+        range_del_index_.MaxCoveringTombstoneSeqnum(
+            key.user_key(), GetInternalKeySeqno(key.internal_key())));
   }
 
   Slice user_key = key.user_key();
@@ -920,6 +949,9 @@ bool MemTable::Get(const LookupKey& key, LazyBuffer* value, Status* s,
 
 void MemTable::Update(SequenceNumber seq, const Slice& key,
                       const Slice& value) {
+  if (negative_lookup_cache_ != nullptr) {
+    negative_lookup_cache_->Invalidate(key, seq);
+  }
   LookupKey lkey(key, seq);
   Slice mem_key = lkey.memtable_key();
 
@@ -965,6 +997,9 @@ void MemTable::Update(SequenceNumber seq, const Slice& key,
 
 bool MemTable::UpdateCallback(SequenceNumber seq, const Slice& key,
                               const Slice& delta) {
+  if (negative_lookup_cache_ != nullptr) {
+    negative_lookup_cache_->Invalidate(key, seq);
+  }
   LookupKey lkey(key, seq);
   Slice memkey = lkey.memtable_key();
 
@@ -1057,6 +1092,70 @@ size_t MemTable::CountSuccessiveMergeEntries(const LookupKey& key) {
   return num_successive_merges;
 }
 
+bool MemTable::FoldMerge(SequenceNumber seq, SequenceNumber min_fold_seq,
+                         const Slice& key, const Slice& value) {
+  const MergeOperator* merge_operator = moptions_.merge_operator;
+  if (moptions_.memtable_merge_fold_threshold == 0 ||
+      merge_operator == nullptr) {
+    return false;
+  }
+  LookupKey lkey(key, seq);
+  Slice memkey = lkey.memtable_key();
+
+  std::unique_ptr<MemTableRep::Iterator> iter(
+      table_->GetDynamicPrefixIterator());
+  iter->Seek(lkey.internal_key(), memkey.data());
+  if (!iter->Valid() ||
+      !comparator_.comparator.user_comparator()->Equal(
+          ExtractUserKey(iter->key()), lkey.user_key())) {
+    return false;
+  }
+  SequenceNumber head_seq;
+  ValueType type;
+  UnPackSequenceAndType(ExtractInternalKeyFooter(iter->key()), &head_seq,
+                        &type);
+  if (type != kTypeMerge || head_seq < min_fold_seq) {
+    return false;
+  }
+  char* old_value_ptr = const_cast<char*>(iter->value());
+  Slice old_value = GetLengthPrefixedSlice(old_value_ptr);
+
+  // Only hot keys are worth the PartialMerge()
+  size_t num_successive_merges = 1;
+  for (iter->Next(); iter->Valid() && num_successive_merges <
+                                          moptions_.memtable_merge_fold_threshold;
+       iter->Next()) {
+    Slice internal_key = iter->key();
+    if (!comparator_.comparator.user_comparator()->Equal(
+            ExtractUserKey(internal_key), lkey.user_key())) {
+      break;
+    }
+    ValueType prev_type = GetInternalKeyType(internal_key);
+    if (prev_type != kTypeMerge && prev_type != kTypeMergeIndex) {
+      break;
+    }
+    ++num_successive_merges;
+  }
+  if (num_successive_merges < moptions_.memtable_merge_fold_threshold) {
+    return false;
+  }
+
+  LazyBuffer merged_value;
+  if (!merge_operator->PartialMerge(key, LazyBuffer(old_value),
+                                    LazyBuffer(value), &merged_value,
+                                    moptions_.info_log) ||
+      !merged_value.fetch().ok() ||
+      merged_value.size() > old_value.size()) {
+    return false;
+  }
+  const Slice& new_value = merged_value.slice();
+  char* p = EncodeVarint32(old_value_ptr,
+                           static_cast<uint32_t>(new_value.size()));
+  memmove(p, new_value.data(), new_value.size());
+  RecordTick(moptions_.statistics, NUMBER_KEYS_UPDATED);
+  return true;
+}
+
 void MemTable::RefLogContainingPrepSection(uint64_t log) {
   assert(log > 0);
   auto cur = min_prep_log_referenced_.load();
@@ -37,6 +37,7 @@ class Mutex;
 template <class TValue>
 class MemTableIteratorBase;
 class MergeContext;
+class NegativeLookupCache;
 
 struct ImmutableMemTableOptions {
   explicit ImmutableMemTableOptions(const ImmutableCFOptions& ioptions,
@@ -51,6 +52,7 @@ struct ImmutableMemTableOptions {
                                    Slice delta_value,
                                    std::string* merged_value);
   size_t max_successive_merges;
+  size_t memtable_merge_fold_threshold;
   Statistics* statistics;
   MergeOperator* merge_operator;
   Logger* info_log;
@@ -134,6 +136,12 @@ class MemTable {
   // operations on the same MemTable (unless this Memtable is immutable).
   size_t ApproximateMemoryUsage();
 
+  // The part of ApproximateMemoryUsage() the memtable rep holds outside the
+  // arena, e.g. the tries of a Patricia memtable
+  size_t ApproximateRepMemoryUsage() {
+    return table_->ApproximateMemoryUsage();
+  }
+
   // This method heuristically determines if the memtable should continue to
   // host more data.
   bool ShouldScheduleFlush() const {
@@ -237,6 +245,19 @@ class MemTable {
   // key in the memtable.
   size_t CountSuccessiveMergeEntries(const LookupKey& key);
 
+  // Folds the merge operand value into the newest entry for key in place if
+  // that entry is a merge operand with a sequence number of at least
+  // min_fold_seq, the key has at least memtable_merge_fold_threshold
+  // successive merge operands, and MergeOperator::PartialMerge() yields a
+  // result no larger than the old operand. Returns false if nothing was done,
+  // and the operand should be added as usual.
+  //
+  // REQUIRES: no reader can see entries at or above min_fold_seq, and
+  // external synchronization to prevent simultaneous operations on the same
+  // MemTable.
+  bool FoldMerge(SequenceNumber seq, SequenceNumber min_fold_seq,
+                 const Slice& key, const Slice& value);
+
   // Update counters and flush status after inserting a whole write batch
   // Used in concurrent memtable inserts.
   void BatchPostProcess(const MemTablePostProcessInfo& update_counters) {
@@ -257,6 +278,13 @@ class MemTable {
     return num_entries_.load(std::memory_order_relaxed);
   }
 
+  // Get total encoded size of the entries in the mem table.
+  // REQUIRES: external synchronization to prevent simultaneous
+  // operations on the same MemTable (unless this Memtable is immutable).
+  uint64_t get_data_size() const {
+    return data_size_.load(std::memory_order_relaxed);
+  }
+
   // Get total number of deletes in the mem table.
   // REQUIRES: external synchronization to prevent simultaneous
   // operations on the same MemTable (unless this Memtable is immutable).
@@ -340,6 +368,12 @@ class MemTable {
   }
   bool IsImmutable() { return is_immutable_; };
 
+  // Writes to this memtable invalidate the negative lookups of their keys in
+  // cache. REQUIRES: called before the first write
+  void SetNegativeLookupCache(NegativeLookupCache* cache) {
+    negative_lookup_cache_ = cache;
+  }
+
   // Notify the underlying storage that all data it contained has been
   // persisted.
   // REQUIRES: external synchronization to prevent simultaneous
@@ -414,6 +448,8 @@ class MemTable {
   std::unique_ptr<MemTableRep> table_;
   std::unique_ptr<MemTableRep> range_del_table_;
   std::shared_ptr<FragmentedRangeTombstoneList> fragmented_range_dels_;
+  // Serves the range tombstone lookups of Get()
+  RangeTombstoneIndex range_del_index_;
 
   // Total data size of all data inserted
   std::atomic<uint64_t> data_size_;
@@ -476,6 +512,8 @@ class MemTable {
   // Memtable id to track flush.
   uint64_t id_ = 0;
 
+  NegativeLookupCache* negative_lookup_cache_ = nullptr;
+
   // Sequence number of the atomic flush that is responsible for this memtable.
   // The sequence number of atomic flush is a seq, such that no writes with
   // sequence numbers greater than or equal to seq are flushed, while all
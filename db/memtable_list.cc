@@ -513,6 +513,14 @@ size_t MemTableList::ApproximateUnflushedMemTablesMemoryUsage() {
   return total_size;
 }
 
+size_t MemTableList::ApproximateUnflushedMemTableRepsMemoryUsage() {
+  size_t total_size = 0;
+  for (auto& memtable : current_->memlist_) {
+    total_size += memtable->ApproximateRepMemoryUsage();
+  }
+  return total_size;
+}
+
 size_t MemTableList::ApproximateMemoryUsage() { return current_memory_usage_; }
 
 uint64_t MemTableList::ApproximateOldestKeyTime() const {
@@ -237,6 +237,9 @@ class MemTableList {
   // the unflushed mem-tables.
   size_t ApproximateUnflushedMemTablesMemoryUsage();
 
+  // MemTable::ApproximateRepMemoryUsage() of the unflushed memtables
+  size_t ApproximateUnflushedMemTableRepsMemoryUsage();
+
   // Returns an estimate of the timestamp of the earliest key.
   uint64_t ApproximateOldestKeyTime() const;
 
@@ -107,6 +107,35 @@ Status MergeHelper::TimedFullMerge(const MergeOperator* merge_operator,
   return Status::OK();
 }
 
+bool MergeHelper::TimedPartialMergeBatch(const MergeOperator* merge_operator,
+                                         const Slice& key,
+                                         MergeContext* merge_context,
+                                         Logger* logger, Statistics* statistics,
+                                         Env* env) {
+  assert(merge_operator != nullptr);
+  size_t num_operands = merge_context->GetNumOperands();
+  if (num_operands < kPartialMergeBatchSize ||
+      num_operands % kPartialMergeBatchSize != 0) {
+    return false;
+  }
+  bool success;
+  LazyBuffer merge_result;
+  {
+    StopWatchNano timer(env, statistics != nullptr);
+    PERF_TIMER_GUARD(merge_operator_time_nanos);
+    success = merge_operator->PartialMergeMulti(
+        key, merge_context->GetOperands(), &merge_result, logger);
+    RecordTick(statistics, MERGE_OPERATION_TOTAL_TIME,
+               statistics ? timer.ElapsedNanos() : 0);
+  }
+  if (!success) {
+    return false;
+  }
+  merge_context->Clear();
+  merge_context->PushOperand(std::move(merge_result));
+  return true;
+}
+
 // PRE:  iter points to the first merge type entry
 // POST: iter points to the first entry beyond the merge process (or the end)
 //       keys_, operands_ are updated to reflect the merge result.
@@ -281,6 +310,16 @@ Status MergeHelper::MergeUntil(const Slice& user_key,
           assert(compaction_filter_value_.file_number() == uint64_t(-1));
           merge_context_.PushOperand(std::move(compaction_filter_value_));
         }
+        if (TimedPartialMergeBatch(user_merge_operator_, orig_ikey.user_key,
+                                   &merge_context_, logger_, stats_, env_)) {
+          // The combined operand takes the newest key of the batch
+          std::string newest_key = std::move(keys_.back());
+          keys_.clear();
+          keys_.emplace_front(std::move(newest_key));
+          ParseInternalKey(keys_.back(), &orig_ikey);
+          orig_ikey.type = kTypeMerge;
+          UpdateInternalKey(&keys_.back(), orig_ikey.sequence, orig_ikey.type);
+        }
       } else if (filter == CompactionFilter::Decision::kRemoveAndSkipUntil) {
         // Compaction filter asked us to remove this key altogether
         // (not just this operand), along with some keys following it.
@@ -54,6 +54,22 @@ class MergeHelper {
                                Statistics* statistics, Env* env,
                                bool update_num_ops_stats = false);
 
+  // Operands of one key are combined through PartialMergeMulti() each time
+  // this many of them are pending, so reads and compactions of keys with
+  // long runs of merges carry one pre-merged operand instead of all of them.
+  static const size_t kPartialMergeBatchSize = 32;
+
+  // Wrapper around MergeOperator::PartialMergeMulti() that records perf
+  // statistics. Replaces the operands of merge_context by their partial merge
+  // once their number is a multiple of kPartialMergeBatchSize. Returns false
+  // and leaves the operands untouched otherwise, or if the operator can't
+  // combine them.
+  static bool TimedPartialMergeBatch(const MergeOperator* merge_operator,
+                                     const Slice& key,
+                                     MergeContext* merge_context,
+                                     Logger* logger, Statistics* statistics,
+                                     Env* env);
+
   // Merge entries until we hit
   //     - a corrupted key
   //     - a Put/Delete,
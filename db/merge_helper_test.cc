@@ -139,6 +139,40 @@ TEST_F(MergeHelperTest, NoPartialMerge) {
   ASSERT_EQ(2U, merge_helper_->values().size());
 }
 
+// Long runs of operands are combined in batches while they are collected.
+TEST_F(MergeHelperTest, PartialMergeLongRun) {
+  merge_op_ = MergeOperators::CreateUInt64AddOperator();
+
+  const size_t kNumOperands = MergeHelper::kPartialMergeBatchSize * 2 + 5;
+  for (size_t i = 0; i < kNumOperands; ++i) {
+    AddKeyVal("a", 1000 - i, kTypeMerge, test::EncodeInt(1U));
+  }
+  AddKeyVal("b", 10, kTypeValue, test::EncodeInt(4U));  // <- iter_ after merge
+
+  ASSERT_TRUE(Run(0, false).IsMergeInProgress());
+  ASSERT_EQ(ks_[kNumOperands], iter_->key());
+  ASSERT_EQ(test::KeyStr("a", 1000, kTypeMerge), merge_helper_->keys()[0]);
+  ASSERT_EQ(test::EncodeInt(kNumOperands), merge_helper_->values()[0].slice());
+  ASSERT_EQ(1U, merge_helper_->keys().size());
+  ASSERT_EQ(1U, merge_helper_->values().size());
+}
+
+// Operands of operators without partial merge are all kept, however long
+// the run is.
+TEST_F(MergeHelperTest, NoPartialMergeLongRun) {
+  merge_op_ = MergeOperators::CreateStringAppendTESTOperator();
+
+  const size_t kNumOperands = MergeHelper::kPartialMergeBatchSize + 1;
+  for (size_t i = 0; i < kNumOperands; ++i) {
+    AddKeyVal("a", 1000 - i, kTypeMerge, "v");
+  }
+
+  ASSERT_TRUE(Run(0, false).IsMergeInProgress());
+  ASSERT_FALSE(iter_->Valid());
+  ASSERT_EQ(kNumOperands, merge_helper_->keys().size());
+  ASSERT_EQ(kNumOperands, merge_helper_->values().size());
+}
+
 // A single operand can not be merged.
 TEST_F(MergeHelperTest, SingleOperand) {
   merge_op_ = MergeOperators::CreateUInt64AddOperator();
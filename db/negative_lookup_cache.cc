@@ -0,0 +1,72 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/negative_lookup_cache.h"
+
+#include "rocksdb/terark_namespace.h"
+#include "util/xxhash.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+inline uint64_t KeyHash(const Slice& key) {
+  return XXH64(key.data(), key.size(), 0);
+}
+}  // namespace
+
+NegativeLookupCache::NegativeLookupCache(size_t size) {
+  size_t n = 1;
+  while (n < size) {
+    n <<= 1;
+  }
+  slots_.reset(new Slot[n]);
+  mask_ = n - 1;
+}
+
+uint64_t NegativeLookupCache::Check(uint64_t hash, uint64_t sv_number,
+                                    SequenceNumber seq) {
+  // Murmur3 finalizer
+  uint64_t h = hash ^ (sv_number * 0x9e3779b97f4a7c15ULL) ^ seq;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  // 0 marks an empty slot
+  return h | 1;
+}
+
+bool NegativeLookupCache::Contains(const Slice& user_key, uint64_t sv_number,
+                                   SequenceNumber read_seq) const {
+  uint64_t hash = KeyHash(user_key);
+  const Slot& slot = slots_[hash & mask_];
+  uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+  if (seq > read_seq ||
+      slot.check.load(std::memory_order_relaxed) !=
+          Check(hash, sv_number, seq)) {
+    return false;
+  }
+  return slot.write_seq.load(std::memory_order_relaxed) <= seq;
+}
+
+void NegativeLookupCache::Insert(const Slice& user_key, uint64_t sv_number,
+                                 SequenceNumber read_seq) {
+  uint64_t hash = KeyHash(user_key);
+  Slot& slot = slots_[hash & mask_];
+  slot.seq.store(read_seq, std::memory_order_relaxed);
+  slot.check.store(Check(hash, sv_number, read_seq),
+                   std::memory_order_relaxed);
+}
+
+void NegativeLookupCache::Invalidate(const Slice& user_key,
+                                     SequenceNumber seq) {
+  Slot& slot = slots_[KeyHash(user_key) & mask_];
+  uint64_t write_seq = slot.write_seq.load(std::memory_order_relaxed);
+  while (write_seq < seq && !slot.write_seq.compare_exchange_weak(
+                                write_seq, seq, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
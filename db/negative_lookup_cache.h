@@ -0,0 +1,65 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/types.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Remembers user keys that were recently not found in a column family, see
+// DBOptions::negative_lookup_cache_size.
+//
+// A direct mapped table of key hashes. An entry records the sequence number
+// of the lookup that missed and the SuperVersion it read from. It answers
+// for later lookups reading at or after that sequence number through the
+// same SuperVersion, as long as no write of a key in the same slot happened
+// after it. Writes bump the slot's write sequence in MemTable::Add, before
+// they are published, so a reader that can see a write also sees the bump.
+// Installing a new SuperVersion (flush, compaction, ingestion) invalidates
+// every entry.
+//
+// Entries are three relaxed atomics without a lock, a check word mixing the
+// key hash, SuperVersion number and sequence number rejects torn entries.
+class NegativeLookupCache {
+ public:
+  // size is rounded up to a power of two
+  explicit NegativeLookupCache(size_t size);
+
+  // True if a lookup of user_key through super version sv_number, at
+  // sequence number read_seq, is known to find nothing
+  bool Contains(const Slice& user_key, uint64_t sv_number,
+                SequenceNumber read_seq) const;
+
+  // Record that a lookup of user_key through super version sv_number, at
+  // sequence number read_seq, found nothing
+  void Insert(const Slice& user_key, uint64_t sv_number,
+              SequenceNumber read_seq);
+
+  // Called for each write of user_key at sequence number seq
+  void Invalidate(const Slice& user_key, SequenceNumber seq);
+
+  size_t size() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> check{0};
+    std::atomic<uint64_t> write_seq{0};
+  };
+
+  static uint64_t Check(uint64_t hash, uint64_t sv_number,
+                        SequenceNumber seq);
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
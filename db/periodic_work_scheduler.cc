@@ -11,8 +11,15 @@
 #ifndef ROCKSDB_LITE
 namespace TERARKDB_NAMESPACE {
 
-PeriodicWorkScheduler::PeriodicWorkScheduler(Env* env) : timer_mu_(env) {
-  timer = std::unique_ptr<Timer>(new Timer(env));
+PeriodicWorkScheduler::PeriodicWorkScheduler(Env* env, bool shared_timer)
+    : timer_mu_(env) {
+  if (shared_timer) {
+    shared_timer_ = Timer::Shared(env);
+    timer = shared_timer_.get();
+  } else {
+    owned_timer_.reset(new Timer(env));
+    timer = owned_timer_.get();
+  }
 }
 
 void PeriodicWorkScheduler::Register(DBImpl* dbi,
@@ -45,6 +52,16 @@ void PeriodicWorkScheduler::Register(DBImpl* dbi,
              initial_delay.fetch_add(1) % kDefaultScheduleGCTTLPeriodSec *
                  kMicrosInSecond,
              kDefaultScheduleGCTTLPeriodSec * kMicrosInSecond);
+  timer->Add([dbi]() { dbi->ScheduleColdRecompress(); },
+             GetTaskName(dbi, "schedule_cold_recompress"),
+             kDefaultScheduleColdRecompressPeriodSec * kMicrosInSecond,
+             kDefaultScheduleColdRecompressPeriodSec * kMicrosInSecond);
+  if (dbi->immutable_db_options().checksum_scrub_bytes_per_sec > 0) {
+    timer->Add([dbi]() { dbi->ScrubChecksums(); },
+               GetTaskName(dbi, "checksum_scrub"),
+               kDefaultChecksumScrubPeriodSec * kMicrosInSecond,
+               kDefaultChecksumScrubPeriodSec * kMicrosInSecond);
+  }
 }
 
 void PeriodicWorkScheduler::Unregister(DBImpl* dbi) {
@@ -53,7 +70,9 @@ void PeriodicWorkScheduler::Unregister(DBImpl* dbi) {
   timer->Cancel(GetTaskName(dbi, "pst_st"));
   timer->Cancel(GetTaskName(dbi, "flush_info_log"));
   timer->Cancel(GetTaskName(dbi, "schedule_gc_ttl"));
-  if (!timer->HasPendingTask()) {
+  timer->Cancel(GetTaskName(dbi, "schedule_cold_recompress"));
+  timer->Cancel(GetTaskName(dbi, "checksum_scrub"));
+  if (owned_timer_ != nullptr && !timer->HasPendingTask()) {
     timer->Shutdown();
   }
 }
@@ -62,7 +81,7 @@ PeriodicWorkScheduler* PeriodicWorkScheduler::Default() {
   // Always use the default Env for the scheduler, as we only use the NowMicros
   // which is the same for all env.
   // The Env could only be overridden in test.
-  static PeriodicWorkScheduler scheduler(Env::Default());
+  static PeriodicWorkScheduler scheduler(Env::Default(), true);
   return &scheduler;
 }
 
@@ -90,7 +109,8 @@ PeriodicWorkTestScheduler* PeriodicWorkTestScheduler::Default(Env* env) {
         MutexLock timer_mu_guard(&scheduler.timer_mu_);
         scheduler.timer->Shutdown();
       }
-      scheduler.timer.reset(new Timer(env));
+      scheduler.owned_timer_.reset(new Timer(env));
+      scheduler.timer = scheduler.owned_timer_.get();
     }
   }
   return &scheduler;
@@ -111,7 +131,7 @@ size_t PeriodicWorkTestScheduler::TEST_GetValidTaskNum() const {
 }
 
 PeriodicWorkTestScheduler::PeriodicWorkTestScheduler(Env* env)
-    : PeriodicWorkScheduler(env) {}
+    : PeriodicWorkScheduler(env, false) {}
 
 #endif  // !NDEBUG
 }  // namespace TERARKDB_NAMESPACE
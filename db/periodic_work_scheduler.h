@@ -17,9 +17,10 @@ namespace TERARKDB_NAMESPACE {
 // DumpStats(), PersistStats(), and FlushInfoLog() for all DB instances. All DB
 // instances use the same object from `Default()`.
 //
-// Internally, it uses a single threaded timer object to run the periodic work
-// functions. Timer thread will always be started since the info log flushing
-// cannot be disabled.
+// Internally, it runs the periodic work functions on the shared timer of the
+// default Env, together with the periodic work of utilities such as the
+// transaction deadlock detector, so a process has one timer thread however
+// many DB instances it opens.
 class PeriodicWorkScheduler {
  public:
   static PeriodicWorkScheduler* Default();
@@ -41,9 +42,15 @@ class PeriodicWorkScheduler {
   // log.
   static const uint64_t kDefaultFlushInfoLogPeriodSec = 10;
   static const uint64_t kDefaultScheduleGCTTLPeriodSec = 10;
+  static const uint64_t kDefaultScheduleColdRecompressPeriodSec = 600;
+  static const uint64_t kDefaultChecksumScrubPeriodSec = 60;
 
  protected:
-  std::unique_ptr<Timer> timer;
+  Timer* timer;
+  // Set when timer is private to the scheduler, as the ones of tests are
+  std::unique_ptr<Timer> owned_timer_;
+  // Set when timer is the shared timer of the env
+  std::shared_ptr<Timer> shared_timer_;
   // `timer_mu_` serves two purposes currently:
   // (1) to ensure calls to `Start()` and `Shutdown()` are serialized, as
   //     they are currently not implemented in a thread-safe way; and
@@ -51,7 +58,7 @@ class PeriodicWorkScheduler {
   //     the `Timer::Cancel()`s and `Timer::Shutdown()` run atomically.
   port::Mutex timer_mu_;
 
-  explicit PeriodicWorkScheduler(Env* env);
+  PeriodicWorkScheduler(Env* env, bool shared_timer);
 
  private:
   static std::string GetTaskName(DBImpl* dbi, const std::string& func_name);
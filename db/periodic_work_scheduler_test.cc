@@ -6,6 +6,7 @@
 #include "db/periodic_work_scheduler.h"
 
 #include "db/db_test_util.h"
+#include "rocksdb/stats_history.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/cast_util.h"
 
@@ -68,7 +69,7 @@ TEST_F(PeriodicWorkSchedulerTest, Basic) {
 
   auto scheduler = dbfull()->TEST_GetPeriodicWorkScheduler();
   ASSERT_NE(nullptr, scheduler);
-  ASSERT_EQ(4, scheduler->TEST_GetValidTaskNum());
+  ASSERT_EQ(5, scheduler->TEST_GetValidTaskNum());
 
   ASSERT_EQ(1, dump_st_counter);
   ASSERT_EQ(1, pst_st_counter);
@@ -102,7 +103,7 @@ TEST_F(PeriodicWorkSchedulerTest, Basic) {
   ASSERT_EQ(4, flush_info_log_counter);
 
   scheduler = dbfull()->TEST_GetPeriodicWorkScheduler();
-  ASSERT_EQ(2u, scheduler->TEST_GetValidTaskNum());
+  ASSERT_EQ(3u, scheduler->TEST_GetValidTaskNum());
 
   // Re-enable one task
   ASSERT_OK(dbfull()->SetDBOptions({{"stats_dump_period_sec", "5"}}));
@@ -111,7 +112,7 @@ TEST_F(PeriodicWorkSchedulerTest, Basic) {
 
   scheduler = dbfull()->TEST_GetPeriodicWorkScheduler();
   ASSERT_NE(nullptr, scheduler);
-  ASSERT_EQ(3, scheduler->TEST_GetValidTaskNum());
+  ASSERT_EQ(4, scheduler->TEST_GetValidTaskNum());
   dbfull()->TEST_WaitForStatsDumpRun(
       [&] { mock_env_->MockSleepForSeconds(static_cast<int>(kPeriodSec)); });
   ASSERT_EQ(5, dump_st_counter);
@@ -149,7 +150,7 @@ TEST_F(PeriodicWorkSchedulerTest, MultiInstances) {
 
   auto dbi = static_cast_with_check<DBImpl>(dbs[kInstanceNum - 1]);
   auto scheduler = dbi->TEST_GetPeriodicWorkScheduler();
-  ASSERT_EQ(kInstanceNum * 4, scheduler->TEST_GetValidTaskNum());
+  ASSERT_EQ(kInstanceNum * 5, scheduler->TEST_GetValidTaskNum());
 
   int expected_run = kInstanceNum;
   dbi->TEST_WaitForStatsDumpRun(
@@ -220,6 +221,75 @@ TEST_F(PeriodicWorkSchedulerTest, MultiEnv) {
   delete db;
   Close();
 }
+
+TEST_F(PeriodicWorkSchedulerTest, PersistentStatsRollups) {
+  Close();
+  Options options;
+  options.create_if_missing = true;
+  options.env = mock_env_.get();
+  options.statistics = CreateDBStatistics();
+  options.persist_stats_to_disk = true;
+  // Snapshots are taken by hand
+  options.stats_persist_period_sec = 0;
+  // The start of a day
+  const uint64_t kStartTime = 1000 * 24 * 3600;
+  mock_env_->set_current_time(kStartTime);
+  Reopen(options);
+
+  // Not counted by the writes of the snapshots themselves
+  const std::string kSeeks = "rocksdb.number.db.seek";
+  auto seek_twice = [&]() {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    iter->Seek("a");
+    iter->Seek("b");
+  };
+  dbfull()->PersistStats();
+  const int kSnapshots = 6;
+  for (int i = 0; i < kSnapshots; ++i) {
+    seek_twice();
+    mock_env_->MockSleepForSeconds(30);
+    dbfull()->PersistStats();
+  }
+
+  auto check = [&](StatsHistoryGranularity granularity, int expected_records,
+                   uint64_t expected_seeks) {
+    std::unique_ptr<StatsHistoryIterator> iter;
+    ASSERT_OK(db_->GetStatsHistory(kStartTime, kStartTime + 3600, granularity,
+                                   {kSeeks}, &iter));
+    int records = 0;
+    uint64_t seeks = 0;
+    for (; iter->Valid(); iter->Next()) {
+      ++records;
+      const auto& stats = iter->GetStatsMap();
+      ASSERT_EQ(1U, stats.size());
+      seeks += stats.at(kSeeks);
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(expected_records, records);
+    ASSERT_EQ(expected_seeks, seeks);
+  };
+  // Taken at 30, 60, ..., 180 seconds
+  check(StatsHistoryGranularity::kSnapshot, kSnapshots, 2 * kSnapshots);
+  check(StatsHistoryGranularity::kMinute, 4, 2 * kSnapshots);
+  check(StatsHistoryGranularity::kHour, 1, 2 * kSnapshots);
+  check(StatsHistoryGranularity::kDay, 1, 2 * kSnapshots);
+
+  // The rollup of the minute is picked up after a reopen
+  Reopen(options);
+  dbfull()->PersistStats();
+  seek_twice();
+  mock_env_->MockSleepForSeconds(10);
+  dbfull()->PersistStats();
+  check(StatsHistoryGranularity::kMinute, 4, 2 * kSnapshots + 2);
+
+  std::unique_ptr<StatsHistoryIterator> iter;
+  ASSERT_OK(db_->GetStatsHistory(kStartTime, kStartTime + 3600,
+                                 StatsHistoryGranularity::kMinute, {}, &iter));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(kStartTime, iter->GetStatsTime());
+  ASSERT_GT(iter->GetStatsMap().size(), 1U);
+  Close();
+}
 #endif  // !ROCKSDB_LITE
 }  // namespace TERARKDB_NAMESPACE
 
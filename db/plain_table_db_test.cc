@@ -1113,6 +1113,69 @@ TEST_P(PlainTableDBTest, CompactionTrigger) {
   ASSERT_EQ(NumTableFilesAtLevel(1), 1);
 }
 
+TEST_P(PlainTableDBTest, LazyCompactionAndSeparatedValues) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.enable_lazy_compaction = true;
+  options.blob_size = 16;
+  options.memtable_factory.reset(new SkipListFactory);
+  DestroyAndReopen(&options);
+
+  // Five keys per prefix
+  auto key = [](int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%08d%04d", i / 5, i);
+    return std::string(buf);
+  };
+  auto value = [](int i, int round) {
+    return std::string(32, static_cast<char>('a' + round)) + ToString(i);
+  };
+  auto expected = [&](int i) {
+    if (i >= 40 && i < 60) {
+      return std::string("NOT_FOUND");
+    }
+    return value(i, 1 - i % 2);
+  };
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(key(i), value(i, 0)));
+  }
+  dbfull()->TEST_FlushMemTable();
+  for (int i = 0; i < 100; i += 2) {
+    ASSERT_OK(Put(key(i), value(i, 1)));
+  }
+  ASSERT_OK(dbfull()->DeleteRange(WriteOptions(),
+                                  dbfull()->DefaultColumnFamily(), key(40),
+                                  key(60)));
+  dbfull()->TEST_FlushMemTable();
+  // The outputs are map SSTs depending on the plain tables
+  ASSERT_OK(dbfull()->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(expected(i), Get(key(i)));
+  }
+
+  ReadOptions ro;
+  ro.total_order_seek = true;
+  std::unique_ptr<Iterator> iter(dbfull()->NewIterator(ro));
+  int i = 99;
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev(), i--) {
+    if (i == 59) {
+      i = 39;
+    }
+    ASSERT_EQ(key(i), iter->key().ToString());
+    ASSERT_EQ(expected(i), iter->value().ToString());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(-1, i);
+
+  iter->Seek(key(45));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(key(60), iter->key().ToString());
+  iter->SeekForPrev(key(45));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(key(39), iter->key().ToString());
+}
+
 TEST_P(PlainTableDBTest, AdaptiveTable) {
   Options options = CurrentOptions();
   options.create_if_missing = true;
@@ -1156,6 +1219,56 @@ TEST_P(PlainTableDBTest, AdaptiveTable) {
   ASSERT_NE("v5", Get("3000000000000bar"));
 }
 
+TEST_P(PlainTableDBTest, AdaptiveTableFactorySelector) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  std::shared_ptr<TableFactory> plain_factory(NewPlainTableFactory());
+  std::shared_ptr<TableFactory> block_based_factory(
+      NewBlockBasedTableFactory());
+  // Level 0 is written as plain tables, the other levels as block based
+  std::shared_ptr<TableFactorySelector> selector(
+      NewLevelTableFactorySelector({plain_factory, block_based_factory}));
+  options.table_factory.reset(
+      NewAdaptiveTableFactory(block_based_factory, block_based_factory,
+                              plain_factory, nullptr, selector));
+  DestroyAndReopen(&options);
+
+  auto count_formats = [&](size_t* plain, size_t* block_based) {
+    *plain = *block_based = 0;
+    TablePropertiesCollection ptc;
+    ASSERT_OK(
+        reinterpret_cast<DB*>(dbfull())->GetPropertiesOfAllTables(&ptc));
+    for (auto& row : ptc) {
+      auto& props = row.second->user_collected_properties;
+      if (props.count(PlainTablePropertyNames::kEncodingType) > 0) {
+        ++*plain;
+      } else if (props.count(BlockBasedTablePropertyNames::kIndexType) > 0) {
+        ++*block_based;
+      }
+    }
+  };
+
+  ASSERT_OK(Put("1000000000000foo", "v1"));
+  ASSERT_OK(Put("0000000000000bar", "v2"));
+  dbfull()->TEST_FlushMemTable();
+  size_t plain, block_based;
+  count_formats(&plain, &block_based);
+  ASSERT_EQ(1U, plain);
+  ASSERT_EQ(0U, block_based);
+
+  ASSERT_OK(Put("2000000000000foo", "v3"));
+  dbfull()->TEST_FlushMemTable();
+  ASSERT_OK(dbfull()->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  count_formats(&plain, &block_based);
+  ASSERT_EQ(0U, plain);
+  ASSERT_LT(0U, block_based);
+
+  Reopen(&options);
+  ASSERT_EQ("v1", Get("1000000000000foo"));
+  ASSERT_EQ("v2", Get("0000000000000bar"));
+  ASSERT_EQ("v3", Get("2000000000000foo"));
+}
+
 INSTANTIATE_TEST_CASE_P(PlainTableDBTest, PlainTableDBTest, ::testing::Bool());
 
 }  // namespace TERARKDB_NAMESPACE
@@ -16,6 +16,7 @@
 #include "rocksdb/terark_namespace.h"
 #include "util/autovector.h"
 #include "util/kv_map.h"
+#include "util/mutexlock.h"
 #include "util/vector_iterator.h"
 #include "utilities/util/valvec.hpp"
 
@@ -417,4 +418,53 @@ FragmentedRangeTombstoneIterator::SplitBySnapshot(
   return splits;
 }
 
+RangeTombstoneIndex::FragmentMap::iterator RangeTombstoneIndex::Split(
+    const Slice& key) {
+  auto next = fragments_.upper_bound(key);
+  if (next == fragments_.begin()) {
+    memory_usage_.fetch_add(sizeof(FragmentMap::value_type) + key.size(),
+                            std::memory_order_relaxed);
+    return fragments_.emplace_hint(next, key.ToString(),
+                                   std::vector<SequenceNumber>());
+  }
+  auto prev = std::prev(next);
+  if (fragments_.key_comp()(prev->first, key)) {
+    // The new fragment inherits the tombstones of the one it is cut from
+    memory_usage_.fetch_add(sizeof(FragmentMap::value_type) + key.size() +
+                                prev->second.size() * sizeof(SequenceNumber),
+                            std::memory_order_relaxed);
+    return fragments_.emplace_hint(next, key.ToString(), prev->second);
+  }
+  return prev;
+}
+
+void RangeTombstoneIndex::Add(const Slice& start_key, const Slice& end_key,
+                              SequenceNumber seq) {
+  if (!fragments_.key_comp()(start_key, end_key)) {
+    return;
+  }
+  WriteLock l(&mutex_);
+  auto end = Split(end_key);
+  size_t covered = 0;
+  for (auto iter = Split(start_key); iter != end; ++iter, ++covered) {
+    auto& seqs = iter->second;
+    // Tombstones mostly arrive in sequence order
+    seqs.insert(std::upper_bound(seqs.begin(), seqs.end(), seq), seq);
+  }
+  memory_usage_.fetch_add(covered * sizeof(SequenceNumber),
+                          std::memory_order_relaxed);
+}
+
+SequenceNumber RangeTombstoneIndex::MaxCoveringTombstoneSeqnum(
+    const Slice& user_key, SequenceNumber upper_bound) const {
+  ReadLock l(&mutex_);
+  auto iter = fragments_.upper_bound(user_key);
+  if (iter == fragments_.begin()) {
+    return 0;
+  }
+  const auto& seqs = std::prev(iter)->second;
+  auto seq_iter = std::upper_bound(seqs.begin(), seqs.end(), upper_bound);
+  return seq_iter == seqs.begin() ? 0 : *std::prev(seq_iter);
+}
+
 }  // namespace TERARKDB_NAMESPACE
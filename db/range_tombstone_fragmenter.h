@@ -5,13 +5,16 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "db/dbformat.h"
+#include "port/port.h"
 #include "rocksdb/status.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/internal_iterator.h"
@@ -254,4 +257,49 @@ class FragmentedRangeTombstoneIterator {
   mutable InternalKey current_start_key_;
 };
 
+// An incrementally maintained index of range tombstones for point lookups.
+// The user key space is cut into disjoint fragments, each holding the
+// ascending sequence numbers of the tombstones covering it, so adding a
+// tombstone only touches the fragments it covers and a lookup is a binary
+// search. Unlike FragmentedRangeTombstoneList it never has to be rebuilt
+// from scratch. All methods are thread safe.
+class RangeTombstoneIndex {
+ public:
+  explicit RangeTombstoneIndex(const Comparator* ucmp)
+      : fragments_(UserKeyLess{ucmp}), memory_usage_(0) {}
+
+  // Adds the tombstone [start_key, end_key) @ seq
+  void Add(const Slice& start_key, const Slice& end_key, SequenceNumber seq);
+
+  // Returns the largest sequence number not greater than upper_bound among
+  // the tombstones covering user_key, or 0 if there is none.
+  SequenceNumber MaxCoveringTombstoneSeqnum(const Slice& user_key,
+                                            SequenceNumber upper_bound) const;
+
+  size_t ApproximateMemoryUsage() const {
+    return memory_usage_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct UserKeyLess {
+    typedef void is_transparent;
+    bool operator()(const Slice& a, const Slice& b) const {
+      return ucmp->Compare(a, b) < 0;
+    }
+    const Comparator* ucmp;
+  };
+  // fragment start key -> seqnums of the tombstones covering
+  // [start key, next start key). An empty list marks a gap.
+  typedef std::map<std::string, std::vector<SequenceNumber>, UserKeyLess>
+      FragmentMap;
+
+  // Makes key the start of a fragment and returns that fragment. REQUIRES:
+  // mutex_ is held for write.
+  FragmentMap::iterator Split(const Slice& key);
+
+  mutable port::RWMutex mutex_;
+  FragmentMap fragments_;
+  std::atomic<size_t> memory_usage_;
+};
+
 }  // namespace TERARKDB_NAMESPACE
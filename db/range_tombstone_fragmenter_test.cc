@@ -545,6 +545,64 @@ TEST_F(RangeTombstoneFragmenterTest, SeekOutOfBounds) {
                     {{"", {}, true /* out of range */}, {"z", {"l", "n", 4}}});
 }
 
+TEST_F(RangeTombstoneFragmenterTest, RangeTombstoneIndex) {
+  RangeTombstoneIndex index(BytewiseComparator());
+  // Same tombstones as OverlapAndRepeatedStartKey, out of order
+  index.Add("j", "l", 2);
+  index.Add("c", "i", 6);
+  index.Add("a", "e", 10);
+  index.Add("j", "n", 4);
+  index.Add("c", "g", 8);
+  index.Add("x", "x", 12);  // empty
+
+  struct {
+    const char* user_key;
+    SequenceNumber upper_bound;
+    SequenceNumber result;
+  } cases[] = {{"a", kMaxSequenceNumber, 10}, {"c", kMaxSequenceNumber, 10},
+               {"e", kMaxSequenceNumber, 8},  {"i", kMaxSequenceNumber, 0},
+               {"j", kMaxSequenceNumber, 4},  {"m", kMaxSequenceNumber, 4},
+               {"a", 9, 0},                   {"c", 9, 8},
+               {"e", 7, 6},                   {"g", 7, 6},
+               {"c", 5, 0},                   {"j", 3, 2},
+               {"m", 3, 0},                   {"x", kMaxSequenceNumber, 0},
+               {"", kMaxSequenceNumber, 0}};
+  for (const auto& c : cases) {
+    EXPECT_EQ(c.result,
+              index.MaxCoveringTombstoneSeqnum(c.user_key, c.upper_bound))
+        << c.user_key << "@" << c.upper_bound;
+  }
+  ASSERT_GT(index.ApproximateMemoryUsage(), 0);
+}
+
+TEST_F(RangeTombstoneFragmenterTest, RangeTombstoneIndexRandom) {
+  Random rnd(301);
+  std::vector<RangeTombstone> tombstones;
+  RangeTombstoneIndex index(BytewiseComparator());
+  for (SequenceNumber seq = 1; seq <= 200; ++seq) {
+    std::string start(1, static_cast<char>('a' + rnd.Uniform(26)));
+    std::string end(1, static_cast<char>('a' + rnd.Uniform(26)));
+    if (start >= end) {
+      continue;
+    }
+    tombstones.emplace_back(start, end, seq);
+    index.Add(start, end, seq);
+  }
+
+  FragmentedRangeTombstoneList fragment_list(MakeRangeDelIter(tombstones),
+                                             bytewise_icmp);
+  for (SequenceNumber upper_bound : {SequenceNumber(10), SequenceNumber(100),
+                                     kMaxSequenceNumber}) {
+    FragmentedRangeTombstoneIterator iter(&fragment_list, bytewise_icmp,
+                                          upper_bound);
+    for (char c = 'a'; c <= 'z'; ++c) {
+      std::string user_key(1, c);
+      ASSERT_EQ(iter.MaxCoveringTombstoneSeqnum(user_key),
+                index.MaxCoveringTombstoneSeqnum(user_key, upper_bound));
+    }
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -665,6 +665,7 @@ class Repairer {
       t->meta.prop.num_deletions = props->num_deletions;
       t->meta.prop.raw_key_size = props->raw_key_size;
       t->meta.prop.raw_value_size = props->raw_value_size;
+      t->meta.prop.creation_time = props->creation_time;
       t->meta.prop.flags |= props->num_range_deletions > 0
                                 ? 0
                                 : TablePropertyCache::kNoRangeDeletions;
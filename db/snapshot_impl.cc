@@ -3,6 +3,11 @@
 //  COPYING file in the root directory) and Apache 2.0 License
 //  (found in the LICENSE.Apache file in the root directory).
 
+#include "db/snapshot_impl.h"
+
+#include <algorithm>
+#include <utility>
+
 #include "rocksdb/db.h"
 #include "rocksdb/snapshot.h"
 #include "rocksdb/terark_namespace.h"
@@ -23,4 +28,121 @@ ManagedSnapshot::~ManagedSnapshot() {
 
 const Snapshot* ManagedSnapshot::snapshot() { return snapshot_; }
 
+SnapshotList::SnapshotList() : count_(0) {
+  for (size_t i = 0; i < kNumShards; ++i) {
+    SnapshotImpl& list = shards_[i].list;
+    list.prev_ = &list;
+    list.next_ = &list;
+    list.number_ = 0xFFFFFFFFL;  // placeholder marker, for debugging
+    // Set all the variables to make UBSAN happy.
+    list.list_ = nullptr;
+    list.shard_ = i;
+    list.unix_time_ = 0;
+    list.is_write_conflict_boundary_ = false;
+  }
+}
+
+SnapshotImpl* SnapshotList::New(
+    SnapshotImpl* s, const std::function<SequenceNumber()>& get_seq,
+    uint64_t unix_time, bool is_write_conflict_boundary) {
+  int cpuid = port::PhysicalCoreID();
+  s->shard_ = cpuid < 0 ? 0 : static_cast<size_t>(cpuid) % kNumShards;
+  Shard& shard = shards_[s->shard_];
+  std::lock_guard<SpinMutex> lock(shard.mutex);
+  s->number_ = get_seq();
+  s->unix_time_ = unix_time;
+  s->is_write_conflict_boundary_ = is_write_conflict_boundary;
+  s->list_ = this;
+  // Another thread on this core may have read an older sequence number
+  // before us, so search backward from the newest for the position
+  SnapshotImpl* prev = shard.list.prev_;
+  while (prev != &shard.list && prev->number_ > s->number_) {
+    prev = prev->prev_;
+  }
+  s->prev_ = prev;
+  s->next_ = prev->next_;
+  s->prev_->next_ = s;
+  s->next_->prev_ = s;
+  if (prev == &shard.list) {
+    shard.oldest.store(s->number_, std::memory_order_release);
+  }
+  count_.fetch_add(1, std::memory_order_release);
+  return s;
+}
+
+void SnapshotList::Delete(const SnapshotImpl* s) {
+  assert(s->list_ == this);
+  Shard& shard = shards_[s->shard_];
+  std::lock_guard<SpinMutex> lock(shard.mutex);
+  s->prev_->next_ = s->next_;
+  s->next_->prev_ = s->prev_;
+  if (s->prev_ == &shard.list) {
+    shard.oldest.store(
+        s->next_ == &shard.list ? kMaxSequenceNumber : s->next_->number_,
+        std::memory_order_release);
+  }
+  count_.fetch_sub(1, std::memory_order_release);
+}
+
+std::vector<SequenceNumber> SnapshotList::GetAll(
+    SequenceNumber* oldest_write_conflict_snapshot,
+    const SequenceNumber& max_seq) const {
+  std::vector<SequenceNumber> ret;
+
+  if (oldest_write_conflict_snapshot != nullptr) {
+    *oldest_write_conflict_snapshot = kMaxSequenceNumber;
+  }
+
+  if (empty()) {
+    return ret;
+  }
+  for (auto& shard : shards_) {
+    std::lock_guard<SpinMutex> lock(shard.mutex);
+    for (const SnapshotImpl* s = shard.list.next_;
+         s != &shard.list && s->number_ <= max_seq; s = s->next_) {
+      ret.push_back(s->number_);
+      if (oldest_write_conflict_snapshot != nullptr &&
+          s->is_write_conflict_boundary_) {
+        *oldest_write_conflict_snapshot =
+            std::min(*oldest_write_conflict_snapshot, s->number_);
+      }
+    }
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+SequenceNumber SnapshotList::GetOldest() const {
+  SequenceNumber oldest = kMaxSequenceNumber;
+  for (auto& shard : shards_) {
+    oldest = std::min(oldest, shard.oldest.load(std::memory_order_acquire));
+  }
+  return oldest;
+}
+
+SequenceNumber SnapshotList::GetNewest() const {
+  SequenceNumber newest = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<SpinMutex> lock(shard.mutex);
+    if (shard.list.prev_ != &shard.list) {
+      newest = std::max(newest, shard.list.prev_->number_);
+    }
+  }
+  return newest;
+}
+
+int64_t SnapshotList::GetOldestSnapshotTime() const {
+  SequenceNumber oldest = kMaxSequenceNumber;
+  int64_t oldest_time = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<SpinMutex> lock(shard.mutex);
+    if (shard.list.next_ != &shard.list &&
+        shard.list.next_->number_ < oldest) {
+      oldest = shard.list.next_->number_;
+      oldest_time = shard.list.next_->unix_time_;
+    }
+  }
+  return oldest_time;
+}
+
 }  // namespace TERARKDB_NAMESPACE
@@ -8,16 +8,21 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #pragma once
+#include <atomic>
+#include <functional>
 #include <vector>
 
+#include "db/dbformat.h"
+#include "port/port.h"
 #include "rocksdb/db.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/mutexlock.h"
 
 namespace TERARKDB_NAMESPACE {
 
 class SnapshotList;
 
-// Snapshots are kept in a doubly-linked list in the DB.
+// Snapshots are kept in doubly-linked lists in the DB.
 // Each SnapshotImpl corresponds to a particular sequence number.
 class SnapshotImpl : public Snapshot {
  public:
@@ -37,6 +42,7 @@ class SnapshotImpl : public Snapshot {
   SnapshotImpl* next_;
 
   SnapshotList* list_;  // just for sanity checks
+  size_t shard_;
 
   int64_t unix_time_;
 
@@ -44,110 +50,61 @@ class SnapshotImpl : public Snapshot {
   bool is_write_conflict_boundary_;
 };
 
+// The snapshots are spread over shards by the CPU taking them, each shard is
+// a list sorted by sequence number under its own spin lock. Taking and
+// releasing a snapshot locks one shard only and never the DB mutex, the
+// queries over all snapshots lock the shards one after the other.
 class SnapshotList {
  public:
-  SnapshotList() {
-    list_.prev_ = &list_;
-    list_.next_ = &list_;
-    list_.number_ = 0xFFFFFFFFL;  // placeholder marker, for debugging
-    // Set all the variables to make UBSAN happy.
-    list_.list_ = nullptr;
-    list_.unix_time_ = 0;
-    list_.is_write_conflict_boundary_ = false;
-    count_ = 0;
-  }
+  SnapshotList();
 
   // No copy-construct.
   SnapshotList(const SnapshotList&) = delete;
 
-  bool empty() const { return list_.next_ == &list_; }
-  SnapshotImpl* oldest() const {
-    assert(!empty());
-    return list_.next_;
-  }
-  SnapshotImpl* newest() const {
-    assert(!empty());
-    return list_.prev_;
-  }
-
-  SnapshotImpl* New(SnapshotImpl* s, SequenceNumber seq, uint64_t unix_time,
-                    bool is_write_conflict_boundary) {
-    s->number_ = seq;
-    s->unix_time_ = unix_time;
-    s->is_write_conflict_boundary_ = is_write_conflict_boundary;
-    s->list_ = this;
-    s->next_ = &list_;
-    s->prev_ = list_.prev_;
-    s->prev_->next_ = s;
-    s->next_->prev_ = s;
-    count_++;
-    return s;
-  }
+  bool empty() const { return count_.load(std::memory_order_acquire) == 0; }
+
+  // Inserts s with the sequence number returned by get_seq. get_seq is called
+  // under the lock of the shard, so that a concurrent GetAll() either
+  // returns s or starts before get_seq is called.
+  SnapshotImpl* New(SnapshotImpl* s,
+                    const std::function<SequenceNumber()>& get_seq,
+                    uint64_t unix_time, bool is_write_conflict_boundary);
 
   // Do not responsible to free the object.
-  void Delete(const SnapshotImpl* s) {
-    assert(s->list_ == this);
-    s->prev_->next_ = s->next_;
-    s->next_->prev_ = s->prev_;
-    count_--;
-  }
+  void Delete(const SnapshotImpl* s);
 
   // retrieve all snapshot numbers up until max_seq. They are sorted in
   // ascending order.
   std::vector<SequenceNumber> GetAll(
       SequenceNumber* oldest_write_conflict_snapshot = nullptr,
-      const SequenceNumber& max_seq = kMaxSequenceNumber) const {
-    std::vector<SequenceNumber> ret;
-
-    if (oldest_write_conflict_snapshot != nullptr) {
-      *oldest_write_conflict_snapshot = kMaxSequenceNumber;
-    }
-
-    if (empty()) {
-      return ret;
-    }
-    const SnapshotImpl* s = &list_;
-    while (s->next_ != &list_) {
-      if (s->next_->number_ > max_seq) {
-        break;
-      }
-      ret.push_back(s->next_->number_);
-
-      if (oldest_write_conflict_snapshot != nullptr &&
-          *oldest_write_conflict_snapshot == kMaxSequenceNumber &&
-          s->next_->is_write_conflict_boundary_) {
-        // If this is the first write-conflict boundary snapshot in the list,
-        // it is the oldest
-        *oldest_write_conflict_snapshot = s->next_->number_;
-      }
-
-      s = s->next_;
-    }
-    return ret;
-  }
+      const SequenceNumber& max_seq = kMaxSequenceNumber) const;
+
+  // get the sequence number of the oldest snapshot, kMaxSequenceNumber if
+  // there is none. Lock free, it reads the cached oldest of each shard.
+  SequenceNumber GetOldest() const;
 
   // get the sequence number of the most recent snapshot
-  SequenceNumber GetNewest() {
-    if (empty()) {
-      return 0;
-    }
-    return newest()->number_;
-  }
-
-  int64_t GetOldestSnapshotTime() const {
-    if (empty()) {
-      return 0;
-    } else {
-      return oldest()->unix_time_;
-    }
-  }
-
-  uint64_t count() const { return count_; }
+  SequenceNumber GetNewest() const;
+
+  int64_t GetOldestSnapshotTime() const;
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
 
  private:
-  // Dummy head of doubly-linked list of snapshots
-  SnapshotImpl list_;
-  uint64_t count_;
+  static const size_t kNumShards = 16;
+
+  struct Shard {
+    mutable SpinMutex mutex;
+    // Dummy head of doubly-linked list of snapshots
+    SnapshotImpl list;
+    // number_ of list.next_, kMaxSequenceNumber when the shard is empty
+    std::atomic<SequenceNumber> oldest{kMaxSequenceNumber};
+    // One shard per cache line
+    char padding[CACHE_LINE_SIZE];
+  };
+
+  Shard shards_[kNumShards];
+  std::atomic<uint64_t> count_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
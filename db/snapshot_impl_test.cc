@@ -0,0 +1,103 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/snapshot_impl.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class SnapshotListTest : public testing::Test {};
+
+TEST_F(SnapshotListTest, Basic) {
+  SnapshotList list;
+  ASSERT_TRUE(list.empty());
+  ASSERT_EQ(kMaxSequenceNumber, list.GetOldest());
+  ASSERT_EQ(0U, list.GetNewest());
+  ASSERT_EQ(0, list.GetOldestSnapshotTime());
+
+  // Inserted out of order, as threads reading the sequence number in a
+  // different order than they lock the list
+  std::vector<std::unique_ptr<SnapshotImpl>> snapshots;
+  for (SequenceNumber seq : {30, 10, 20, 40}) {
+    snapshots.emplace_back(new SnapshotImpl);
+    list.New(snapshots.back().get(), [seq] { return seq; }, seq * 100,
+             seq == 20 || seq == 40);
+  }
+  ASSERT_EQ(4U, list.count());
+  ASSERT_EQ(10U, list.GetOldest());
+  ASSERT_EQ(40U, list.GetNewest());
+  ASSERT_EQ(1000, list.GetOldestSnapshotTime());
+  SequenceNumber oldest_write_conflict_snapshot;
+  ASSERT_EQ(std::vector<SequenceNumber>({10, 20, 30, 40}),
+            list.GetAll(&oldest_write_conflict_snapshot));
+  ASSERT_EQ(20U, oldest_write_conflict_snapshot);
+  ASSERT_EQ(std::vector<SequenceNumber>({10, 20}), list.GetAll(nullptr, 25));
+
+  list.Delete(snapshots[1].get());
+  ASSERT_EQ(20U, list.GetOldest());
+  list.Delete(snapshots[3].get());
+  ASSERT_EQ(30U, list.GetNewest());
+  list.Delete(snapshots[0].get());
+  list.Delete(snapshots[2].get());
+  ASSERT_TRUE(list.empty());
+  ASSERT_EQ(kMaxSequenceNumber, list.GetOldest());
+}
+
+TEST_F(SnapshotListTest, ConcurrentNewAndDelete) {
+  SnapshotList list;
+  std::atomic<SequenceNumber> last_sequence{2};
+  SnapshotImpl pinned;
+  list.New(&pinned, [] { return 1; }, 0, false);
+
+  std::atomic<bool> stop{false};
+  std::vector<port::Thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      std::vector<SnapshotImpl*> taken;
+      while (!stop) {
+        for (int j = 0; j < 10; ++j) {
+          taken.push_back(list.New(
+              new SnapshotImpl, [&] { return last_sequence.fetch_add(1); }, 0,
+              false));
+        }
+        for (auto* s : taken) {
+          list.Delete(s);
+          delete s;
+        }
+        taken.clear();
+      }
+    });
+  }
+  for (int i = 0; i < 1000; ++i) {
+    // The pinned snapshot stays the oldest, the others are sorted
+    ASSERT_EQ(1U, list.GetOldest());
+    auto all = list.GetAll();
+    ASSERT_EQ(1U, all.front());
+    for (size_t j = 1; j < all.size(); ++j) {
+      ASSERT_LT(all[j - 1], all[j]);
+    }
+  }
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(1U, list.count());
+  list.Delete(&pinned);
+  ASSERT_TRUE(list.empty());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -9,15 +9,21 @@
 
 #include "db/table_cache.h"
 
+#include <inttypes.h>
+
+#include <algorithm>
+
 #include "db/dbformat.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/version_edit.h"
 #include "monitoring/perf_context_imp.h"
+#include "monitoring/usdt.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/get_context.h"
 #include "table/internal_iterator.h"
 #include "table/iterator_wrapper.h"
+#include "table/scoped_arena_iterator.h"
 #include "table/table_builder.h"
 #include "table/table_reader.h"
 #include "table/two_level_iterator.h"
@@ -25,6 +31,7 @@
 #include "util/coding.h"
 #include "util/file_reader_writer.h"
 #include "util/filename.h"
+#include "util/logging.h"
 #include "util/stop_watch.h"
 #include "util/sync_point.h"
 
@@ -51,6 +58,14 @@ static void DeleteTableReader(void* arg1, void* arg2) {
   delete table_reader;
 }
 
+// A value resolved by TableCache::Get, separated values are stored fetched
+struct RowCacheEntry {
+  SequenceNumber seq;
+  ValueType type;
+  uint64_t blob_file_number;
+  std::string value;
+};
+
 static Slice GetSliceForFileNumber(const uint64_t* file_number) {
   return Slice(reinterpret_cast<const char*>(file_number),
                sizeof(*file_number));
@@ -97,6 +112,7 @@ class LazyCreateIterator : public Snapshot {
   bool for_compaction_;
   bool skip_filters_;
   int level_;
+  TableReaderHandleCache* reader_cache_;
 
  public:
   LazyCreateIterator(TableCache* table_cache, const ReadOptions& options,
@@ -105,7 +121,8 @@ class LazyCreateIterator : public Snapshot {
                      RangeDelAggregator* range_del_agg,
                      const SliceTransform* prefix_extractor,
                      bool for_compaction, bool skip_filters,
-                     bool ignore_range_deletions, int level)
+                     bool ignore_range_deletions, int level,
+                     TableReaderHandleCache* reader_cache)
       : table_cache_(table_cache),
         options_(options),
         snapshot_(0),
@@ -115,7 +132,8 @@ class LazyCreateIterator : public Snapshot {
         prefix_extractor_(prefix_extractor),
         for_compaction_(for_compaction),
         skip_filters_(skip_filters),
-        level_(level) {
+        level_(level),
+        reader_cache_(reader_cache) {
     if (options.snapshot != nullptr) {
       snapshot_ = options.snapshot->GetSequenceNumber();
       options_.snapshot = this;
@@ -134,7 +152,7 @@ class LazyCreateIterator : public Snapshot {
     return table_cache_->NewIterator(
         options_, env_options_, icomparator_, *_f, _dependence_map,
         range_del_agg_, prefix_extractor_, _reader_ptr, nullptr,
-        for_compaction_, _arena, skip_filters_, level_);
+        for_compaction_, _arena, skip_filters_, level_, reader_cache_);
   }
 };
 
@@ -151,6 +169,12 @@ TableCache::TableCache(const ImmutableCFOptions& ioptions,
     // disambiguate its entries.
     PutVarint64(&row_cache_id_, ioptions_.row_cache->NewId());
   }
+  if (ioptions_.blob_cache) {
+    PutVarint64(&blob_cache_id_, ioptions_.blob_cache->NewId());
+  }
+  if (ioptions_.map_sst_index_memory_budget > 0) {
+    map_sst_index_cache_ = NewLRUCache(ioptions_.map_sst_index_memory_budget);
+  }
 }
 
 TableCache::~TableCache() {}
@@ -214,7 +238,9 @@ Status TableCache::GetTableReaderImpl(
       // its wrapped file's Read() to copy data into the provided scratch
       // buffer, which mmap files don't use.
       // TODO(ajkr): try madvise for mmap files in place of buffered readahead.
-      file = NewReadaheadRandomAccessFile(std::move(file), readahead);
+      file = NewReadaheadRandomAccessFile(std::move(file), readahead,
+                                          for_compaction ? ioptions_.env
+                                                         : nullptr);
     }
     if (!sequential_mode && ioptions_.advise_random_on_open) {
       file->Hint(RandomAccessFile::RANDOM);
@@ -265,12 +291,14 @@ Status TableCache::FindTable(const EnvOptions& env_options,
       return Status::Incomplete("Table not found in table_cache, no_io is set");
     }
     std::unique_ptr<TableReader> table_reader;
+    TERARKDB_PROBE1(table_cache_miss_start, fd.GetNumber());
     s = GetTableReader(env_options, internal_comparator, fd,
                        false /* sequential mode */, 0 /* readahead */,
                        record_read_stats, file_read_hist, &table_reader,
                        prefix_extractor, skip_filters, level,
                        prefetch_index_and_filter_in_cache,
                        false /* for_compaction */, force_memory);
+    TERARKDB_PROBE2(table_cache_miss_done, fd.GetNumber(), s.ok());
     if (!s.ok()) {
       assert(table_reader == nullptr);
       RecordTick(ioptions_.statistics, NO_FILE_ERRORS);
@@ -295,7 +323,7 @@ InternalIterator* TableCache::NewIterator(
     const DependenceMap& dependence_map, RangeDelAggregator* range_del_agg,
     const SliceTransform* prefix_extractor, TableReader** table_reader_ptr,
     HistogramImpl* file_read_hist, bool for_compaction, Arena* arena,
-    bool skip_filters, int level) {
+    bool skip_filters, int level, TableReaderHandleCache* reader_cache) {
   PERF_TIMER_GUARD(new_table_iterator_nanos);
 
   Status s;
@@ -343,6 +371,9 @@ InternalIterator* TableCache::NewIterator(
     }
   } else {
     table_reader = fd.table_reader;
+    if (table_reader == nullptr && reader_cache != nullptr) {
+      table_reader = reader_cache->Get(fd.GetNumber());
+    }
     if (table_reader == nullptr) {
       s = FindTable(env_options, icomparator, fd, &handle, prefix_extractor,
                     options.read_tier == kBlockCacheTier /* no_io */,
@@ -351,6 +382,11 @@ InternalIterator* TableCache::NewIterator(
                     file_meta.prop.is_map_sst());
       if (s.ok()) {
         table_reader = GetTableReaderFromHandle(handle);
+        // Readers kept by a Version must not push others out of the cache
+        if (reader_cache != nullptr &&
+            cache_->GetUsage() < cache_->GetCapacity()) {
+          reader_cache->Put(fd.GetNumber(), &handle);
+        }
       }
     }
   }
@@ -381,13 +417,13 @@ InternalIterator* TableCache::NewIterator(
           lazy_create_iter = new (buffer) LazyCreateIterator(
               this, options, env_options, icomparator, range_del_agg,
               prefix_extractor, for_compaction, skip_filters,
-              ignore_range_deletions, level);
+              ignore_range_deletions, level, reader_cache);
 
         } else {
           lazy_create_iter = new LazyCreateIterator(
               this, options, env_options, icomparator, range_del_agg,
               prefix_extractor, for_compaction, skip_filters,
-              ignore_range_deletions, level);
+              ignore_range_deletions, level, reader_cache);
         }
         auto map_sst_iter = NewMapSstIterator(
             &file_meta, result, dependence_map, icomparator, lazy_create_iter,
@@ -479,7 +515,14 @@ Status TableCache::Get(const ReadOptions& options,
   Status s;
   TableReader* t = fd.table_reader;
   Cache::Handle* handle = nullptr;
-  if (t == nullptr) {
+  Cache::Handle* index_handle = nullptr;
+  bool use_map_sst_index =
+      map_sst_index_cache_ != nullptr && file_meta.prop.is_map_sst();
+  if (use_map_sst_index) {
+    index_handle = GetMapSstIndex(file_meta, nullptr, prefix_extractor,
+                                  false /* build */);
+  }
+  if (t == nullptr && index_handle == nullptr) {
     s = FindTable(env_options_, internal_comparator, fd, &handle,
                   prefix_extractor,
                   options.read_tier == kBlockCacheTier /* no_io */,
@@ -490,11 +533,46 @@ Status TableCache::Get(const ReadOptions& options,
       t = GetTableReaderFromHandle(handle);
     }
   }
+  if (s.ok() && use_map_sst_index && index_handle == nullptr &&
+      options.read_tier != kBlockCacheTier) {
+    index_handle =
+        GetMapSstIndex(file_meta, t, prefix_extractor, true /* build */);
+  }
+  const MapSstIndex* index =
+      index_handle == nullptr
+          ? nullptr
+          : reinterpret_cast<const MapSstIndex*>(
+                map_sst_index_cache_->Value(index_handle));
   if (s.ok()) {
-    t->UpdateMaxCoveringTombstoneSeq(options, ExtractUserKey(k),
-                                     get_context->max_covering_tombstone_seq());
+    if (index == nullptr) {
+      // Indexed map SSTs have no range deletions
+      t->UpdateMaxCoveringTombstoneSeq(
+          options, ExtractUserKey(k),
+          get_context->max_covering_tombstone_seq());
+    }
     if (!file_meta.prop.is_map_sst()) {
-      s = t->Get(options, k, get_context, prefix_extractor, skip_filters);
+      // A read newer than every entry of the file gets the newest entry of
+      // the key, which is the same for all such reads
+      bool use_row_cache = ioptions_.row_cache != nullptr &&
+                           inheritance == nullptr &&
+                           get_context->RowCacheable() &&
+                           GetInternalKeySeqno(k) >= fd.largest_seqno;
+      std::string row_cache_key;
+      bool row_cache_hit = false;
+      if (use_row_cache) {
+        row_cache_key = row_cache_id_;
+        PutVarint64(&row_cache_key, fd.GetNumber());
+        Slice user_key = ExtractUserKey(k);
+        row_cache_key.append(user_key.data(), user_key.size());
+        row_cache_hit = GetFromRowCache(row_cache_key, dependence_map,
+                                        user_key, get_context);
+      }
+      if (!row_cache_hit) {
+        s = t->Get(options, k, get_context, prefix_extractor, skip_filters);
+        if (use_row_cache && s.ok()) {
+          InsertRowCache(row_cache_key, get_context);
+        }
+      }
     } else if (dependence_map.empty()) {
       s = Status::Corruption(
           "TableCache::Get: Composite sst depend files missing");
@@ -600,20 +678,199 @@ Status TableCache::Get(const ReadOptions& options,
         get_context->SetMinSequenceAndType(min_seq_type_backup);
         return is_largest_user_key;
       };
-      t->RangeScan(&k, prefix_extractor, &get_from_map,
-                   c_style_callback(get_from_map));
+      if (index != nullptr) {
+        TEST_SYNC_POINT("TableCache::Get:MapSstIndex");
+        auto& elements = index->elements;
+        auto it = std::lower_bound(
+            elements.begin(), elements.end(), k,
+            [&](const MapSstIndex::Element& e, const Slice& key) {
+              return internal_comparator.Compare(e.first, key) < 0;
+            });
+        for (; it != elements.end() &&
+               get_from_map(it->first, LazyBuffer(it->second));
+             ++it) {
+        }
+      } else {
+        t->RangeScan(&k, prefix_extractor, &get_from_map,
+                     c_style_callback(get_from_map));
+      }
     }
   } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
     // Couldn't find Table in cache but treat as kFound if no_io set
     get_context->MarkKeyMayExist();
     s = Status::OK();
   }
+  if (index_handle != nullptr) {
+    map_sst_index_cache_->Release(index_handle);
+  }
   if (handle != nullptr) {
     ReleaseHandle(handle);
   }
   return s;
 }
 
+void TableCache::MultiGet(const ReadOptions& options,
+                          const InternalKeyComparator& internal_comparator,
+                          const FileMetaData& file_meta,
+                          const DependenceMap& dependence_map,
+                          size_t num_keys, const Slice* keys,
+                          GetContext** get_contexts, Status* statuses,
+                          const SliceTransform* prefix_extractor,
+                          HistogramImpl* file_read_hist, bool skip_filters,
+                          int level) {
+  if (file_meta.prop.is_map_sst()) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      statuses[i] = Get(options, internal_comparator, file_meta,
+                        dependence_map, keys[i], get_contexts[i],
+                        prefix_extractor, file_read_hist, skip_filters, level);
+    }
+    return;
+  }
+  auto& fd = file_meta.fd;
+  Status s;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    s = FindTable(env_options_, internal_comparator, fd, &handle,
+                  prefix_extractor,
+                  options.read_tier == kBlockCacheTier /* no_io */,
+                  true /* record_read_stats */, file_read_hist, skip_filters,
+                  level, true /* prefetch_index_and_filter_in_cache */);
+    if (s.ok()) {
+      t = GetTableReaderFromHandle(handle);
+    }
+  }
+  if (s.ok()) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      t->UpdateMaxCoveringTombstoneSeq(
+          options, ExtractUserKey(keys[i]),
+          get_contexts[i]->max_covering_tombstone_seq());
+    }
+    if (ioptions_.row_cache == nullptr) {
+      t->MultiGet(options, num_keys, keys, get_contexts, statuses,
+                  prefix_extractor, skip_filters);
+    } else {
+      // The row cache is used per key as in Get, the misses are read in a
+      // batch and inserted afterwards
+      std::vector<std::string> row_cache_keys(num_keys);
+      std::vector<size_t> miss_index;
+      std::vector<Slice> miss_keys;
+      std::vector<GetContext*> miss_contexts;
+      for (size_t i = 0; i < num_keys; ++i) {
+        statuses[i] = Status::OK();
+        if (get_contexts[i]->RowCacheable() &&
+            GetInternalKeySeqno(keys[i]) >= fd.largest_seqno) {
+          std::string& row_cache_key = row_cache_keys[i];
+          row_cache_key = row_cache_id_;
+          PutVarint64(&row_cache_key, fd.GetNumber());
+          Slice user_key = ExtractUserKey(keys[i]);
+          row_cache_key.append(user_key.data(), user_key.size());
+          if (GetFromRowCache(row_cache_key, dependence_map, user_key,
+                              get_contexts[i])) {
+            continue;
+          }
+        }
+        miss_index.push_back(i);
+        miss_keys.push_back(keys[i]);
+        miss_contexts.push_back(get_contexts[i]);
+      }
+      if (!miss_index.empty()) {
+        std::vector<Status> miss_statuses(miss_index.size());
+        t->MultiGet(options, miss_keys.size(), miss_keys.data(),
+                    miss_contexts.data(), miss_statuses.data(),
+                    prefix_extractor, skip_filters);
+        for (size_t j = 0; j < miss_index.size(); ++j) {
+          size_t i = miss_index[j];
+          statuses[i] = std::move(miss_statuses[j]);
+          if (!row_cache_keys[i].empty() && statuses[i].ok()) {
+            InsertRowCache(row_cache_keys[i], get_contexts[i]);
+          }
+        }
+      }
+    }
+  } else {
+    for (size_t i = 0; i < num_keys; ++i) {
+      if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+        // Couldn't find Table in cache but treat as kFound if no_io set
+        get_contexts[i]->MarkKeyMayExist();
+        statuses[i] = Status::OK();
+      } else {
+        statuses[i] = s;
+      }
+    }
+  }
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+}
+
+Cache::Handle* TableCache::GetMapSstIndex(
+    const FileMetaData& file_meta, TableReader* t,
+    const SliceTransform* prefix_extractor, bool build) {
+  assert(map_sst_index_cache_ != nullptr);
+  assert(file_meta.prop.is_map_sst());
+  uint64_t file_number = file_meta.fd.GetNumber();
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  Slice key(buf, sizeof(buf));
+  Cache::Handle* handle = map_sst_index_cache_->Lookup(key);
+  if (handle != nullptr || !build) {
+    return handle;
+  }
+  // Map SSTs with range deletions keep the regular path, which consults
+  // their tombstones
+  if (t->GetTableProperties()->num_range_deletions > 0 ||
+      file_meta.fd.GetFileSize() > map_sst_index_cache_->GetCapacity()) {
+    return nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(map_sst_index_mutex_);
+    if (!map_sst_index_loading_.insert(file_number).second) {
+      // Another Get is loading it
+      return nullptr;
+    }
+  }
+  ReadOptions map_options;
+  map_options.total_order_seek = true;
+  map_options.fill_cache = false;
+  std::unique_ptr<MapSstIndex> index(new MapSstIndex);
+  size_t charge = sizeof(MapSstIndex);
+  Status s;
+  {
+    Arena arena;
+    ScopedArenaIterator iter(
+        t->NewIterator(map_options, prefix_extractor, &arena));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      LazyBuffer value = iter->value();
+      s = value.fetch();
+      if (!s.ok()) {
+        break;
+      }
+      index->elements.emplace_back(iter->key().ToString(),
+                                   value.slice().ToString());
+      charge += sizeof(MapSstIndex::Element) + iter->key().size() +
+                value.size();
+    }
+    if (s.ok()) {
+      s = iter->status();
+    }
+  }
+  if (s.ok()) {
+    s = map_sst_index_cache_->Insert(key, index.release(), charge,
+                                     &DeleteEntry<MapSstIndex>, &handle);
+  }
+  if (!s.ok()) {
+    // Reads of this map SST go through the table cache
+    handle = nullptr;
+    ROCKS_LOG_WARN(ioptions_.info_log,
+                   "Load map sst %" PRIu64 " index fail: %s", file_number,
+                   s.ToString().c_str());
+  }
+  std::lock_guard<std::mutex> lock(map_sst_index_mutex_);
+  map_sst_index_loading_.erase(file_number);
+  return handle;
+}
+
 Status TableCache::GetTableProperties(
     const EnvOptions& env_options,
     const InternalKeyComparator& internal_comparator,
@@ -670,6 +927,31 @@ size_t TableCache::GetMemoryUsageByTableReader(
   return ret;
 }
 
+void TableCache::AddIndexAndDictMemoryUsage(
+    const EnvOptions& env_options,
+    const InternalKeyComparator& internal_comparator, const FileDescriptor& fd,
+    const SliceTransform* prefix_extractor, size_t* index_usage,
+    size_t* dict_usage) {
+  auto table_reader = fd.table_reader;
+  if (table_reader) {
+    *index_usage += table_reader->ApproximateIndexMemoryUsage();
+    *dict_usage += table_reader->ApproximateDictMemoryUsage();
+    return;
+  }
+
+  Cache::Handle* table_handle = nullptr;
+  Status s = FindTable(env_options, internal_comparator, fd, &table_handle,
+                       prefix_extractor, true);
+  if (!s.ok()) {
+    return;
+  }
+  assert(table_handle);
+  auto table = GetTableReaderFromHandle(table_handle);
+  *index_usage += table->ApproximateIndexMemoryUsage();
+  *dict_usage += table->ApproximateDictMemoryUsage();
+  ReleaseHandle(table_handle);
+}
+
 void TableCache::Evict(Cache* cache, uint64_t file_number) {
   cache->Erase(GetSliceForFileNumber(&file_number));
 }
@@ -682,4 +964,144 @@ void TableCache::TEST_AddMockTableReader(TableReader* table_reader,
   s = cache_->Insert(key, table_reader, 1, &DeleteEntry<TableReader>);
 }
 
+bool TableCache::GetFromBlobCache(uint64_t file_number, const Slice& k,
+                                  LazyBuffer* value) {
+  Cache* blob_cache = ioptions_.blob_cache.get();
+  assert(blob_cache != nullptr);
+  std::string cache_key = blob_cache_id_;
+  PutVarint64(&cache_key, file_number);
+  cache_key.append(k.data(), k.size());
+  auto handle = blob_cache->Lookup(cache_key);
+  if (handle == nullptr) {
+    RecordTick(ioptions_.statistics, BLOB_CACHE_MISS);
+    return false;
+  }
+  RecordTick(ioptions_.statistics, BLOB_CACHE_HIT);
+  auto found = reinterpret_cast<std::string*>(blob_cache->Value(handle));
+  Cleanable cleanable;
+  cleanable.RegisterCleanup(&UnrefEntry, blob_cache, handle);
+  value->reset(*found, std::move(cleanable), file_number);
+  return true;
+}
+
+void TableCache::InsertBlobCache(uint64_t file_number, const Slice& k,
+                                 const Slice& value) {
+  Cache* blob_cache = ioptions_.blob_cache.get();
+  assert(blob_cache != nullptr);
+  std::string cache_key = blob_cache_id_;
+  PutVarint64(&cache_key, file_number);
+  cache_key.append(k.data(), k.size());
+  auto cached = new std::string(value.data(), value.size());
+  size_t charge = cache_key.size() + cached->size() + sizeof(std::string);
+  blob_cache->Insert(cache_key, cached, charge, &DeleteEntry<std::string>);
+}
+
+bool TableCache::GetFromRowCache(const Slice& key,
+                                 const DependenceMap& dependence_map,
+                                 const Slice& user_key,
+                                 GetContext* get_context) {
+  Cache* row_cache = ioptions_.row_cache.get();
+  assert(row_cache != nullptr);
+  auto handle = row_cache->Lookup(key);
+  if (handle != nullptr) {
+    auto entry = reinterpret_cast<RowCacheEntry*>(row_cache->Value(handle));
+    if (entry->blob_file_number == uint64_t(-1) ||
+        dependence_map.count(entry->blob_file_number) > 0) {
+      RecordTick(ioptions_.statistics, ROW_CACHE_HIT);
+      Cleanable cleanable;
+      cleanable.RegisterCleanup(&UnrefEntry, row_cache, handle);
+      // Separated values are stored fetched, replay them as inline values.
+      // The range deletions of the newer files still apply
+      ValueType type =
+          entry->type == kTypeValueIndex ? kTypeValue : entry->type;
+      bool matched = false;
+      get_context->SaveValue(ParsedInternalKey(user_key, entry->seq, type),
+                             LazyBuffer(entry->value, std::move(cleanable)),
+                             &matched);
+      return true;
+    }
+    row_cache->Release(handle);
+  }
+  RecordTick(ioptions_.statistics, ROW_CACHE_MISS);
+  return false;
+}
+
+void TableCache::InsertRowCache(const Slice& key, GetContext* get_context) {
+  Cache* row_cache = ioptions_.row_cache.get();
+  assert(row_cache != nullptr);
+  SequenceNumber seq;
+  ValueType type;
+  UnPackSequenceAndType(get_context->first_seq_type(), &seq, &type);
+  // Merges and the entries hidden by a range deletion are not cached
+  bool found = get_context->State() == GetContext::kFound;
+  if (found ? type != kTypeValue && type != kTypeValueIndex
+            : get_context->State() != GetContext::kDeleted ||
+                  (type != kTypeDeletion && type != kTypeSingleDeletion)) {
+    return;
+  }
+  std::unique_ptr<RowCacheEntry> entry(new RowCacheEntry);
+  entry->seq = seq;
+  entry->type = type;
+  entry->blob_file_number = uint64_t(-1);
+  if (found) {
+    LazyBuffer* value = get_context->lazy_val();
+    if (!value->fetch().ok()) {
+      return;
+    }
+    entry->value.assign(value->data(), value->size());
+    if (type == kTypeValueIndex) {
+      entry->blob_file_number = value->file_number();
+    }
+  }
+  size_t charge = key.size() + entry->value.size() + sizeof(RowCacheEntry);
+  row_cache->Insert(key, entry.release(), charge,
+                    &DeleteEntry<RowCacheEntry>);
+}
+
+TableReaderHandleCache::~TableReaderHandleCache() {
+  for (auto& pair : handles_) {
+    Cache::Handle* handle = pair.second.load(std::memory_order_relaxed);
+    if (handle != nullptr) {
+      table_cache_->ReleaseHandle(handle);
+    }
+  }
+}
+
+void TableReaderHandleCache::Init() {
+  handles_.reserve(dependence_map_.size());
+  for (auto& pair : dependence_map_) {
+    // Inherited file numbers point to the file which replaced them
+    uint64_t file_number = pair.second->fd.GetNumber();
+    handles_.emplace(std::piecewise_construct,
+                     std::forward_as_tuple(file_number),
+                     std::forward_as_tuple(nullptr));
+  }
+}
+
+TableReader* TableReaderHandleCache::Get(uint64_t file_number) {
+  std::call_once(init_once_, &TableReaderHandleCache::Init, this);
+  auto find = handles_.find(file_number);
+  if (find == handles_.end()) {
+    return nullptr;
+  }
+  Cache::Handle* handle = find->second.load(std::memory_order_acquire);
+  return handle == nullptr ? nullptr
+                           : table_cache_->GetTableReaderFromHandle(handle);
+}
+
+void TableReaderHandleCache::Put(uint64_t file_number,
+                                 Cache::Handle** handle) {
+  std::call_once(init_once_, &TableReaderHandleCache::Init, this);
+  auto find = handles_.find(file_number);
+  if (find == handles_.end()) {
+    return;
+  }
+  Cache::Handle* expected = nullptr;
+  if (find->second.compare_exchange_strong(expected, *handle,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    *handle = nullptr;
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
\ No newline at end of file
@@ -12,7 +12,13 @@
 #pragma once
 #include <stdint.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "db/dbformat.h"
@@ -34,6 +40,15 @@ class Arena;
 struct FileDescriptor;
 class GetContext;
 class HistogramImpl;
+class TableReaderHandleCache;
+
+// Elements of a map SST kept in memory as (largest key, link value) pairs,
+// sorted by largest key. Point lookups search it instead of reading the map
+// SST through the table cache.
+struct MapSstIndex {
+  typedef std::pair<std::string, std::string> Element;
+  std::vector<Element> elements;
+};
 
 class TableCache {
  public:
@@ -52,6 +67,9 @@ class TableCache {
   //    aggregator. If an error occurs, returns it in a NewErrorInternalIterator
   // @param skip_filters Disables loading/accessing the filter block
   // @param level The level this table is at, -1 for "not set / don't know"
+  // @param reader_cache If non-nullptr, table readers of this file and its
+  //    dependence files are looked up there first and kept there while the
+  //    table cache has room. The iterator must not outlive reader_cache
   InternalIterator* NewIterator(
       const ReadOptions& options, const EnvOptions& toptions,
       const InternalKeyComparator& internal_comparator,
@@ -60,7 +78,8 @@ class TableCache {
       const SliceTransform* prefix_extractor = nullptr,
       TableReader** table_reader_ptr = nullptr,
       HistogramImpl* file_read_hist = nullptr, bool for_compaction = false,
-      Arena* arena = nullptr, bool skip_filters = false, int level = -1);
+      Arena* arena = nullptr, bool skip_filters = false, int level = -1,
+      TableReaderHandleCache* reader_cache = nullptr);
 
   // If a seek to internal key "k" in specified file finds an entry,
   // call (*handle_result)(arg, found_key, found_value) repeatedly until
@@ -76,8 +95,19 @@ class TableCache {
              const Slice& k, GetContext* get_context,
              const SliceTransform* prefix_extractor = nullptr,
              HistogramImpl* file_read_hist = nullptr, bool skip_filters = false,
-             int level = -1,
-             const FileMetaData* inheritance = nullptr);
+             int level = -1, const FileMetaData* inheritance = nullptr);
+
+  // Batched Get of num_keys keys sorted by internal_comparator, each with
+  // its own get_contexts[i] and statuses[i]. Keys that hit a map SST are
+  // looked up one by one through Get
+  void MultiGet(const ReadOptions& options,
+                const InternalKeyComparator& internal_comparator,
+                const FileMetaData& file_meta,
+                const DependenceMap& dependence_map, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor = nullptr,
+                HistogramImpl* file_read_hist = nullptr,
+                bool skip_filters = false, int level = -1);
 
   // Evict any entry for the specified file number
   static void Evict(Cache* cache, uint64_t file_number);
@@ -123,9 +153,42 @@ class TableCache {
       const FileDescriptor& fd,
       const SliceTransform* prefix_extractor = nullptr);
 
+  // Adds the index and the dictionary parts of the memory usage of the table
+  // reader of the file to *index_usage and *dict_usage, nothing if the table
+  // reader is not loaded.
+  void AddIndexAndDictMemoryUsage(
+      const EnvOptions& toptions,
+      const InternalKeyComparator& internal_comparator,
+      const FileDescriptor& fd, const SliceTransform* prefix_extractor,
+      size_t* index_usage, size_t* dict_usage);
+
   // Release the handle from a cache
   void ReleaseHandle(Cache::Handle* handle);
 
+  // Lookup separated value of internal key "k" in blob "file_number" from
+  // blob cache, the value is pinned by cache handle on hit.
+  // REQUIRES: ioptions.blob_cache != nullptr
+  bool GetFromBlobCache(uint64_t file_number, const Slice& k,
+                        LazyBuffer* value);
+
+  // Insert separated value of internal key "k" in blob "file_number" into
+  // blob cache.
+  // REQUIRES: ioptions.blob_cache != nullptr
+  void InsertBlobCache(uint64_t file_number, const Slice& k,
+                       const Slice& value);
+
+  // Resolve the lookup of "get_context" from the row cache entry "key".
+  // Entries of separated values are only used while their blob is still in
+  // "dependence_map". Returns false on miss.
+  // REQUIRES: ioptions.row_cache != nullptr
+  bool GetFromRowCache(const Slice& key, const DependenceMap& dependence_map,
+                       const Slice& user_key, GetContext* get_context);
+
+  // Insert the resolved result of "get_context" as row cache entry "key" if
+  // it was decided by the newest entry of the user key.
+  // REQUIRES: ioptions.row_cache != nullptr
+  void InsertRowCache(const Slice& key, GetContext* get_context);
+
   // Capacity of the backing Cache that indicates inifinite TableCache capacity.
   // For example when max_open_files is -1 we set the backing Cache to this.
   static const int kInfiniteCapacity = 0x400000;
@@ -163,11 +226,53 @@ class TableCache {
                             bool prefetch_index_and_filter_in_cache,
                             bool for_compaction, bool force_memory);
 
+  // Find the MapSstIndex of map SST "file_meta", loading it from "t" on the
+  // first lookup when "build" is set. Returns a handle of
+  // map_sst_index_cache_, nullptr if the map SST is not indexed.
+  // REQUIRES: map_sst_index_cache_ != nullptr
+  Cache::Handle* GetMapSstIndex(const FileMetaData& file_meta, TableReader* t,
+                                const SliceTransform* prefix_extractor,
+                                bool build);
+
   const ImmutableCFOptions& ioptions_;
   const EnvOptions& env_options_;
   Cache* const cache_;
   std::string row_cache_id_;
+  std::string blob_cache_id_;
   bool immortal_tables_;
+  // Limited to ioptions.map_sst_index_memory_budget, nullptr if disabled
+  std::shared_ptr<Cache> map_sst_index_cache_;
+  // Map SSTs whose index is being loaded, so only one Get loads each
+  std::mutex map_sst_index_mutex_;
+  std::unordered_set<uint64_t> map_sst_index_loading_;
+};
+
+// Table readers of the files of one Version, found in the table cache at most
+// once and shared by all read iterators over the Version. A reader stays
+// referenced from the first Put until this cache is destroyed.
+class TableReaderHandleCache {
+ public:
+  // REQUIRES: dependence_map is not modified once Get or Put is called
+  TableReaderHandleCache(TableCache* table_cache,
+                         const DependenceMap& dependence_map)
+      : table_cache_(table_cache), dependence_map_(dependence_map) {}
+  ~TableReaderHandleCache();
+
+  // Returns nullptr if the reader of file_number is not in the cache yet
+  TableReader* Get(uint64_t file_number);
+
+  // Keeps *handle as the reader of file_number and sets *handle to nullptr,
+  // unless another thread was first, then the caller still owns *handle
+  void Put(uint64_t file_number, Cache::Handle** handle);
+
+ private:
+  void Init();
+
+  TableCache* table_cache_;
+  const DependenceMap& dependence_map_;
+  std::once_flag init_once_;
+  // One slot per file of the Version, filled at most once
+  std::unordered_map<uint64_t, std::atomic<Cache::Handle*>> handles_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
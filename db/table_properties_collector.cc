@@ -147,6 +147,23 @@ class TtlIntTblPropCollector : public IntTblPropCollector {
       PushItem(properties, TablePropertiesNames::kLatestTimeEndCompact,
                latest_time_end_compact);
     }
+    if (!histogram_.Empty()) {
+      std::string expiry_time_points;
+      for (size_t i = 0; i < kTtlExpiryHistogramSize; ++i) {
+        double expired = (i + 1.0) / kTtlExpiryHistogramSize * total_entries_;
+        if (expired > ttl_entries_) {
+          break;
+        }
+        PutVarint64(&expiry_time_points,
+                    now_time_seconds +
+                        static_cast<uint64_t>(histogram_.Percentile(
+                            expired / ttl_entries_ * 100.0)));
+      }
+      if (!expiry_time_points.empty()) {
+        properties->emplace(TablePropertiesNames::kTtlExpiryHistogram,
+                            std::move(expiry_time_points));
+      }
+    }
     return Status::OK();
   }
 
@@ -277,6 +294,21 @@ void GetCompactionTimePoint(const UserCollectedProperties& props,
   }
 }
 
+void GetTtlExpiryHistogram(const UserCollectedProperties& props,
+                           std::vector<uint64_t>* expiry_time_points) {
+  assert(expiry_time_points != nullptr);
+  expiry_time_points->clear();
+  auto find = props.find(TablePropertiesNames::kTtlExpiryHistogram);
+  if (find == props.end()) {
+    return;
+  }
+  Slice raw = find->second;
+  uint64_t time_point;
+  while (!raw.empty() && GetVarint64(&raw, &time_point)) {
+    expiry_time_points->push_back(time_point);
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 TERARK_FACTORY_INSTANTIATE_GNS(
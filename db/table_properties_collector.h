@@ -153,6 +153,9 @@ class UserKeyTablePropertiesCollectorFactory
   std::shared_ptr<TablePropertiesCollectorFactory> user_collector_factory_;
 };
 
+// The longest ttl of an entry, longer ones are cut to it
+extern const uint64_t kFiftyYearSecondsNumber;
+
 extern IntTblPropCollectorFactory* NewTtlIntTblPropCollectorFactory(
     const TtlExtractorFactory* ttl_extractor_factory, Env* env,
     double ttl_gc_ratio, size_t ttl_max_scan_cap);
@@ -200,6 +200,8 @@ class VersionBuilder::Rep {
   bool has_invalid_levels_;
   FileComparator level_zero_cmp_;
   FileComparator level_nonzero_cmp_;
+  // Files added to each level by the edits applied on top of base_vstorage_
+  std::vector<std::vector<FileMetaData*>> added_files_;
   Status status_;
 
  public:
@@ -609,6 +611,8 @@ class VersionBuilder::Rep {
       }
     }
 
+    added_files_.assign(num_levels_, std::vector<FileMetaData*>());
+
     if (debugger_) {
       debugger_->PushVersion(base_vstorage_);
     }
@@ -652,6 +656,9 @@ class VersionBuilder::Rep {
         assert(level < 0 ||
                context_->levels[level].count(f->fd.GetNumber()) == 0);
         PutSst(f, level);
+        if (level >= 0) {
+          added_files_[level].push_back(f);
+        }
       } else {
         uint64_t number = pair.second.fd.GetNumber();
         if (invalid_levels_[level].count(number) == 0) {
@@ -667,6 +674,47 @@ class VersionBuilder::Rep {
     CalculateDependence(false, edit->is_open_db());
   }
 
+  // Files of the level in the order of cmp. The files of the base version are
+  // normally sorted already, so only the files added by the edits get sorted,
+  // then merged into the base files that survived.
+  void GetOrderedLevelFiles(int level, const FileComparator& cmp,
+                            std::vector<FileMetaData*>* files) {
+    auto& level_files = context_->levels[level];
+    files->reserve(level_files.size());
+    auto alive = [&level_files](FileMetaData* f) {
+      auto find = level_files.find(f->fd.GetNumber());
+      return find != level_files.end() && find->second == f;
+    };
+    std::vector<FileMetaData*> added;
+    for (auto f : added_files_[level]) {
+      if (alive(f)) {
+        added.push_back(f);
+      }
+    }
+    for (auto f : base_vstorage_->LevelFiles(level)) {
+      if (alive(f)) {
+        files->push_back(f);
+      }
+    }
+    if (files->size() + added.size() != level_files.size() ||
+        !std::is_sorted(files->begin(), files->end(), cmp)) {
+      // The base version doesn't match the context, sort everything
+      files->clear();
+      for (const auto& pair : level_files) {
+        files->push_back(pair.second);
+      }
+      std::sort(files->begin(), files->end(), cmp);
+      return;
+    }
+    if (!added.empty()) {
+      std::sort(added.begin(), added.end(), cmp);
+      size_t base_count = files->size();
+      files->insert(files->end(), added.begin(), added.end());
+      std::inplace_merge(files->begin(), files->begin() + base_count,
+                         files->end(), cmp);
+    }
+  }
+
   // Save the current state in *v.
   // WARNING: this func will call out of mutex
   void SaveTo(VersionStorageInfo* vstorage) {
@@ -680,28 +728,27 @@ class VersionBuilder::Rep {
     };
 
     std::vector<double> read_amp(num_levels_);
+    std::vector<uint64_t> read_amp_depth(num_levels_);
 
     for (int level = 0; level < num_levels_; level++) {
       auto& cmp = (level == 0) ? level_zero_cmp_ : level_nonzero_cmp_;
 
-      auto& unordered_added_files = context_->levels[level];
-      vstorage->Reserve(level, unordered_added_files.size());
+      vstorage->Reserve(level, context_->levels[level].size());
 
       // Sort files for the level.
       std::vector<FileMetaData*> ordered_added_files;
-      ordered_added_files.reserve(unordered_added_files.size());
-      for (const auto& pair : unordered_added_files) {
-        ordered_added_files.push_back(pair.second);
-      }
-      std::sort(ordered_added_files.begin(), ordered_added_files.end(), cmp);
+      GetOrderedLevelFiles(level, cmp, &ordered_added_files);
 
       for (auto f : ordered_added_files) {
         vstorage->AddFile(level, f, c_style_callback(exists), &exists,
                           info_log_);
         if (level == 0) {
           read_amp[level] += f->prop.read_amp;
+          read_amp_depth[level] += f->prop.max_read_amp;
         } else {
           read_amp[level] = std::max<double>(read_amp[level], f->prop.read_amp);
+          read_amp_depth[level] =
+              std::max<uint64_t>(read_amp_depth[level], f->prop.max_read_amp);
         }
       }
     }
@@ -714,6 +761,7 @@ class VersionBuilder::Rep {
       vstorage->UpdateAccumulatedStats(item.f);
     }
     vstorage->set_read_amplification(read_amp);
+    vstorage->set_read_amp_depth(read_amp_depth);
     vstorage->oldest_snapshot_seqnum(base_vstorage_->oldest_snapshot_seqnum());
 
     CheckConsistency(vstorage, true);
@@ -826,6 +874,7 @@ class VersionBuilder::Rep {
           file_meta->prop.num_deletions = properties->num_deletions;
           file_meta->prop.raw_key_size = properties->raw_key_size;
           file_meta->prop.raw_value_size = properties->raw_value_size;
+          file_meta->prop.creation_time = properties->creation_time;
         }
       }
     });
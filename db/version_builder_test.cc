@@ -397,6 +397,40 @@ TEST_F(VersionBuilderTest, ApplyDeleteAndSaveTo) {
   UnrefFilesInVersion(&new_vstorage);
 }
 
+TEST_F(VersionBuilderTest, ApplyAndSaveToKeepsOrder) {
+  Add(1, 1U, "150", "199", 100U);
+  Add(1, 2U, "300", "349", 100U);
+  Add(1, 3U, "500", "549", 100U);
+  Add(2, 4U, "150", "549", 100U);
+  UpdateVersionStorageInfo();
+
+  EnvOptions env_options;
+  VersionBuilder version_builder(env_options, nullptr, &vstorage_);
+  VersionStorageInfo new_vstorage(&icmp_, ucmp_, options_.num_levels,
+                                  kCompactionStyleLevel, false);
+
+  VersionEdit version_edit;
+  version_edit.AddFile(1, 6U, 0, 100U, GetInternalKey("600"),
+                       GetInternalKey("649"), 200, 200, false, {});
+  version_edit.AddFile(1, 5U, 0, 100U, GetInternalKey("100"),
+                       GetInternalKey("120"), 200, 200, false, {});
+  version_edit.AddFile(1, 7U, 0, 100U, GetInternalKey("400"),
+                       GetInternalKey("449"), 200, 200, false, {});
+  version_edit.DeleteFile(1, 2U);
+  version_builder.Apply(&version_edit);
+  version_builder.SaveTo(&new_vstorage);
+
+  std::vector<uint64_t> level1;
+  for (auto f : new_vstorage.LevelFiles(1)) {
+    level1.push_back(f->fd.GetNumber());
+  }
+  ASSERT_EQ(std::vector<uint64_t>({5U, 1U, 7U, 3U, 6U}), level1);
+  ASSERT_EQ(1U, new_vstorage.LevelFiles(2).size());
+  ASSERT_EQ(4U, new_vstorage.LevelFiles(2)[0]->fd.GetNumber());
+
+  UnrefFilesInVersion(&new_vstorage);
+}
+
 TEST_F(VersionBuilderTest, EstimatedActiveKeys) {
   // const uint32_t kTotalSamples = 20;
   const uint32_t kNumLevels = 5;
@@ -208,6 +208,12 @@ bool VersionEdit::EncodeTo(std::string* dst) const {
                           f.prop.raw_value_size);
       PutVarint64(&encode_property_cache, f.prop.earliest_time_begin_compact);
       PutVarint64(&encode_property_cache, f.prop.latest_time_end_compact);
+      PutVarint64(&encode_property_cache, f.prop.separate_threshold);
+      PutVarint64(&encode_property_cache, f.prop.creation_time);
+      PutVarint64(&encode_property_cache, f.prop.ttl_expiry_histogram.size());
+      for (auto time_point : f.prop.ttl_expiry_histogram) {
+        PutVarint64(&encode_property_cache, time_point);
+      }
       PutLengthPrefixedSlice(dst, encode_property_cache);
     }
     TEST_SYNC_POINT_CALLBACK("VersionEdit::EncodeTo:NewFile4:CustomizeFields",
@@ -385,6 +391,27 @@ const char* VersionEdit::DecodeNewFile4From(Slice* input) {
                 return error_msg;
               }
             }
+            if (!field.empty()) {
+              if (!GetVarint64(&field, &f.prop.separate_threshold)) {
+                return error_msg;
+              }
+            }
+            if (!field.empty()) {
+              if (!GetVarint64(&field, &f.prop.creation_time)) {
+                return error_msg;
+              }
+            }
+            if (!field.empty()) {
+              if (!GetVarint64(&field, &size) || size > field.size()) {
+                return error_msg;
+              }
+              f.prop.ttl_expiry_histogram.resize(size);
+              for (auto& time_point : f.prop.ttl_expiry_histogram) {
+                if (!GetVarint64(&field, &time_point)) {
+                  return error_msg;
+                }
+              }
+            }
             if (f.prop.num_entries > 0 || f.prop.raw_key_size > 0 ||
                 f.prop.raw_value_size > 0) {
               f.need_upgrade = false;
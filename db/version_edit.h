@@ -98,6 +98,9 @@ struct TablePropertyCache {
   std::vector<uint64_t> inheritance;   // inheritance set
   uint64_t earliest_time_begin_compact = port::kMaxUint64;
   uint64_t latest_time_end_compact = port::kMaxUint64;
+  uint64_t separate_threshold = 0;  // value separation threshold, 0 unknown
+  uint64_t creation_time = 0;       // TableProperties::creation_time
+  std::vector<uint64_t> ttl_expiry_histogram;  // see GetTtlExpiryHistogram
 
   bool is_map_sst() const { return purpose == kMapSst; }
   bool has_range_deletions() const { return (flags & kNoRangeDeletions) == 0; }
@@ -233,9 +236,13 @@ struct FdWithKeyRange {
 struct LevelFilesBrief {
   size_t num_files;
   FdWithKeyRange* files;
+  // Optional, the first 8 bytes of the largest user key of each file as a
+  // big endian integer, see DoGenerateLevelFilesBrief
+  uint64_t* largest_fences;
   LevelFilesBrief() {
     num_files = 0;
     files = nullptr;
+    largest_fences = nullptr;
   }
 };
 
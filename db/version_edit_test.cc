@@ -102,6 +102,26 @@ TEST_F(VersionEditTest, EncodeDecodeNewFile4) {
   ASSERT_EQ(3U, new_files[2].second.prop.dependence[1].file_number);
 }
 
+TEST_F(VersionEditTest, EncodeDecodeTtlExpiryHistogram) {
+  VersionEdit edit;
+  TablePropertyCache prop = GetPropCache(0);
+  prop.earliest_time_begin_compact = 1000;
+  prop.ttl_expiry_histogram = {1000, 2000, 3000};
+  edit.AddFile(6, 303, 0, 100, InternalKey("foo", 100, kTypeValue),
+               InternalKey("zoo", 200, kTypeValue), 100, 200, false, prop);
+  TestEncodeDecode(edit);
+
+  std::string encoded;
+  edit.EncodeTo(&encoded);
+  VersionEdit parsed;
+  Status s = parsed.DecodeFrom(encoded);
+  ASSERT_TRUE(s.ok()) << s.ToString();
+  auto& new_files = parsed.GetNewFiles();
+  ASSERT_EQ(1000U, new_files[0].second.prop.earliest_time_begin_compact);
+  ASSERT_EQ(std::vector<uint64_t>({1000, 2000, 3000}),
+            new_files[0].second.prop.ttl_expiry_histogram);
+}
+
 TEST_F(VersionEditTest, ForwardCompatibleNewFile4) {
   static const uint64_t kBig = 1ull << 50;
   VersionEdit edit;
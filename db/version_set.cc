@@ -34,6 +34,7 @@
 #include "monitoring/file_read_sample.h"
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/persistent_stats_history.h"
+#include "monitoring/usdt.h"
 #include "rocksdb/env.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/terark_namespace.h"
@@ -55,17 +56,50 @@
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
+#include "util/trace_replay.h"
+#include "util/xxhash.h"
 #include "utilities/util/valvec.hpp"
 
 namespace TERARKDB_NAMESPACE {
 
 namespace {
 
+// First index in [left, right) whose fence is not less than (kUpper: is
+// greater than) fence. Branch free, the loop count only depends on the size
+template <bool kUpper>
+uint32_t FindFence(const uint64_t* fences, uint32_t left, uint32_t right,
+                   uint64_t fence) {
+  if (left >= right) {
+    return left;
+  }
+  const uint64_t* base = fences + left;
+  uint32_t n = right - left;
+  while (n > 1) {
+    uint32_t half = n / 2;
+    base = (kUpper ? base[half] <= fence : base[half] < fence) ? base + half
+                                                               : base;
+    n -= half;
+  }
+  return static_cast<uint32_t>(base - fences) +
+         (kUpper ? *base <= fence : *base < fence);
+}
+
 // Find File in LevelFilesBrief data structure
 // Within an index range defined by left and right
 int FindFileInRange(const InternalKeyComparator& icmp,
                     const LevelFilesBrief& file_level, const Slice& key,
                     uint32_t left, uint32_t right) {
+  if (file_level.largest_fences != nullptr && left + 1 < right &&
+      icmp.user_comparator() == BytewiseComparator()) {
+    // Files whose fence is less than the key's end before it, files whose
+    // fence is greater end after it, only the files sharing the fence of the
+    // key need full key comparisons
+    uint64_t fence = UserKeyFence(ExtractUserKey(key));
+    uint32_t lo = FindFence<false>(file_level.largest_fences, left, right,
+                                   fence);
+    right = FindFence<true>(file_level.largest_fences, lo, right, fence);
+    left = lo;
+  }
   return static_cast<int>(
       terark::lower_bound_ex_n(file_level.files, left, right, key,
                                TERARK_FIELD(largest_key), "" < icmp));
@@ -403,6 +437,8 @@ void DoGenerateLevelFilesBrief(LevelFilesBrief* file_level,
   file_level->num_files = num;
   char* mem = arena->AllocateAligned(num * sizeof(FdWithKeyRange));
   file_level->files = new (mem) FdWithKeyRange[num];
+  file_level->largest_fences = reinterpret_cast<uint64_t*>(
+      arena->AllocateAligned(num * sizeof(uint64_t)));
 
   for (size_t i = 0; i < num; i++) {
     Slice smallest_key = files[i]->smallest.Encode();
@@ -420,6 +456,7 @@ void DoGenerateLevelFilesBrief(LevelFilesBrief* file_level,
     f.file_metadata = files[i];
     f.smallest_key = Slice(mem, smallest_size);
     f.largest_key = Slice(mem + smallest_size, largest_size);
+    file_level->largest_fences[i] = UserKeyFence(files[i]->largest.user_key());
   }
 }
 
@@ -485,7 +522,8 @@ class LevelIterator final : public InternalIterator, public Snapshot {
                 const DependenceMap& dependence_map,
                 const SliceTransform* prefix_extractor, bool should_sample,
                 HistogramImpl* file_read_hist, bool for_compaction,
-                bool skip_filters, int level, RangeDelAggregator* range_del_agg)
+                bool skip_filters, int level, RangeDelAggregator* range_del_agg,
+                TableReaderHandleCache* reader_cache = nullptr)
       : table_cache_(table_cache),
         read_options_(read_options),
         snapshot_(0),
@@ -500,7 +538,8 @@ class LevelIterator final : public InternalIterator, public Snapshot {
         skip_filters_(skip_filters),
         file_index_(flevel_->num_files),
         level_(level),
-        range_del_agg_(range_del_agg) {
+        range_del_agg_(range_del_agg),
+        reader_cache_(reader_cache) {
     // Empty level is not supported.
     assert(flevel_ != nullptr && flevel_->num_files > 0);
     if (read_options_.snapshot != nullptr) {
@@ -561,7 +600,8 @@ class LevelIterator final : public InternalIterator, public Snapshot {
         read_options_, env_options_, icomparator_, *file_meta.file_metadata,
         dependence_map_, range_del_agg_, prefix_extractor_,
         nullptr /* don't need reference to table */, file_read_hist_,
-        for_compaction_, nullptr /* arena */, skip_filters_, level_);
+        for_compaction_, nullptr /* arena */, skip_filters_, level_,
+        reader_cache_);
   }
 
   TableCache* table_cache_;
@@ -581,6 +621,7 @@ class LevelIterator final : public InternalIterator, public Snapshot {
   size_t file_index_;
   int level_;
   RangeDelAggregator* range_del_agg_;
+  TableReaderHandleCache* reader_cache_;
   IteratorWrapper file_iter_;  // May be nullptr
 };
 
@@ -710,6 +751,14 @@ class BaseReferencedVersionBuilder {
         version_(cfd->current()) {
     version_->Ref();
   }
+  // Builds on base instead of the current version
+  BaseReferencedVersionBuilder(ColumnFamilyData* cfd, Version* base)
+      : version_builder_(new VersionBuilder(
+            base->version_set()->env_options(), cfd->table_cache(),
+            base->storage_info(), cfd->ioptions()->info_log)),
+        version_(base) {
+    version_->Ref();
+  }
   ~BaseReferencedVersionBuilder() {
     delete version_builder_;
     version_->Unref();
@@ -920,6 +969,24 @@ size_t Version::GetMemoryUsageByTableReaders() {
   return total_usage;
 }
 
+void Version::GetIndexAndDictMemoryUsage(size_t* index_usage,
+                                         size_t* dict_usage) {
+  *index_usage = 0;
+  *dict_usage = 0;
+  for (auto& file_level : storage_info_.level_files_brief_) {
+    for (size_t i = 0; i < file_level.num_files; i++) {
+      cfd_->table_cache()->AddIndexAndDictMemoryUsage(
+          env_options_, cfd_->internal_comparator(), file_level.files[i].fd,
+          mutable_cf_options_.prefix_extractor.get(), index_usage, dict_usage);
+    }
+  }
+  for (auto file_meta : storage_info_.LevelFiles(-1)) {
+    cfd_->table_cache()->AddIndexAndDictMemoryUsage(
+        env_options_, cfd_->internal_comparator(), file_meta->fd,
+        mutable_cf_options_.prefix_extractor.get(), index_usage, dict_usage);
+  }
+}
+
 double Version::GetCompactionLoad() const {
   double read_amp = storage_info_.read_amplification();
   int level_add = cfd_->ioptions()->num_levels - 1;
@@ -1099,7 +1166,7 @@ void Version::AddIteratorsForLevel(const ReadOptions& read_options,
           *file.file_metadata, storage_info_.dependence_map(), range_del_agg,
           mutable_cf_options_.prefix_extractor.get(), nullptr,
           cfd_->internal_stats()->GetFileReadHist(level), false, arena,
-          false /* skip_filters */, 0 /* level */));
+          false /* skip_filters */, 0 /* level */, &reader_cache_));
     }
     if (should_sample) {
       // Count ones for every L0 files. This is done per iterator creation
@@ -1122,7 +1189,7 @@ void Version::AddIteratorsForLevel(const ReadOptions& read_options,
         mutable_cf_options_.prefix_extractor.get(), should_sample_file_read(),
         cfd_->internal_stats()->GetFileReadHist(level),
         false /* for_compaction */, IsFilterSkipped(level), level,
-        range_del_agg));
+        range_del_agg, &reader_cache_));
   }
 }
 
@@ -1241,6 +1308,7 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
           cfd_ == nullptr ? kCompactionStyleLevel
                           : cfd_->ioptions()->compaction_style,
           cfd_ == nullptr ? false : cfd_->ioptions()->force_consistency_checks),
+      reader_cache_(table_cache_, storage_info_.dependence_map()),
       vset_(vset),
       next_(this),
       prev_(this),
@@ -1249,12 +1317,34 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
       mutable_cf_options_(mutable_cf_options),
       version_number_(version_number) {}
 
+namespace {
+void TraceBlobAccess(const ImmutableCFOptions& ioptions,
+                     TableAccessCaller caller, uint64_t file_number,
+                     const Slice& internal_key, const LazyBuffer& value,
+                     bool is_cache_hit) {
+  auto tracer = ioptions.table_access_tracer.get();
+  if (tracer == nullptr || !tracer->IsTracing()) {
+    return;
+  }
+  tracer->Add(kTableAccessBlob, caller, file_number,
+              XXH64(internal_key.data(), internal_key.size(), 0),
+              value.valid() ? value.size() : 0, is_cache_hit);
+}
+}  // namespace
+
 Status Version::fetch_buffer(LazyBuffer* buffer) const {
+  LatencyHistGuard guard(cfd_->latency_reporters().blob_fetch);
+  PERF_COUNTER_ADD(blob_fetch_count, 1);
+  PERF_TIMER_GUARD(blob_fetch_time);
   auto context = get_context(buffer);
   Slice user_key(reinterpret_cast<const char*>(context->data[0]),
                  context->data[1]);
   uint64_t sequence = context->data[2];
   auto pair = *reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
+  TERARKDB_PROBE1(blob_fetch_start, pair.second->fd.GetNumber());
+  if (should_sample_file_read()) {
+    sample_file_read_inc(pair.second);
+  }
   bool value_found = false;
   SequenceNumber context_seq;
   GetContext get_context(cfd_->internal_comparator().user_comparator(), nullptr,
@@ -1263,6 +1353,16 @@ Status Version::fetch_buffer(LazyBuffer* buffer) const {
                          nullptr, nullptr, nullptr, env_, &context_seq);
   IterKey iter_key;
   iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
+  bool use_blob_cache = cfd_->ioptions()->blob_cache != nullptr;
+  if (use_blob_cache &&
+      table_cache_->GetFromBlobCache(pair.second->fd.GetNumber(),
+                                     iter_key.GetInternalKey(), buffer)) {
+    TraceBlobAccess(*cfd_->ioptions(), kTableAccessFetch,
+                    pair.second->fd.GetNumber(), iter_key.GetInternalKey(),
+                    *buffer, true);
+    TERARKDB_PROBE2(blob_fetch_done, pair.second->fd.GetNumber(), true);
+    return Status::OK();
+  }
   auto s = table_cache_->Get(
       ReadOptions(), cfd_->internal_comparator(), *pair.second,
       storage_info_.dependence_map(), iter_key.GetInternalKey(), &get_context,
@@ -1283,6 +1383,18 @@ Status Version::fetch_buffer(LazyBuffer* buffer) const {
     }
   }
   assert(buffer->file_number() == pair.second->fd.GetNumber());
+  if (use_blob_cache) {
+    s = buffer->fetch();
+    if (!s.ok()) {
+      return s;
+    }
+    table_cache_->InsertBlobCache(pair.second->fd.GetNumber(),
+                                  iter_key.GetInternalKey(), buffer->slice());
+  }
+  TraceBlobAccess(*cfd_->ioptions(), kTableAccessFetch,
+                  pair.second->fd.GetNumber(), iter_key.GetInternalKey(),
+                  *buffer, false);
+  TERARKDB_PROBE2(blob_fetch_done, pair.second->fd.GetNumber(), false);
   return Status::OK();
 }
 
@@ -1306,12 +1418,170 @@ LazyBuffer Version::TransToCombined(const Slice& user_key, uint64_t sequence,
   }
 }
 
+bool Version::IsSeparatePending(const LazyBuffer& value) const {
+  return !value.valid() && LazyBufferState::get_state(&value) ==
+                               static_cast<const LazyBufferState*>(this);
+}
+
+void Version::MultiFetch(const std::vector<LazyBuffer*>& values,
+                         std::vector<Status>* statuses,
+                         const FetchExecutor& executor) const {
+  struct FetchItem {
+    FileMetaData* blob;
+    Slice user_key;
+    SequenceNumber sequence;
+    size_t index;
+  };
+  statuses->assign(values.size(), Status::OK());
+  std::vector<FetchItem> items;
+  items.reserve(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    assert(IsSeparatePending(*values[i]));
+    auto context = get_context(values[i]);
+    auto pair = reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
+    items.emplace_back(FetchItem{
+        pair->second,
+        Slice(reinterpret_cast<const char*>(context->data[0]),
+              context->data[1]),
+        context->data[2], i});
+  }
+  auto ucmp = cfd_->internal_comparator().user_comparator();
+  std::sort(items.begin(), items.end(),
+            [ucmp](const FetchItem& l, const FetchItem& r) {
+              if (l.blob->fd.GetNumber() != r.blob->fd.GetNumber()) {
+                return l.blob->fd.GetNumber() < r.blob->fd.GetNumber();
+              }
+              int c = ucmp->Compare(l.user_key, r.user_key);
+              return c != 0 ? c < 0 : l.sequence > r.sequence;
+            });
+
+  auto fetch_group = [this, &values, statuses](
+                         const FetchItem* begin, const FetchItem* end) {
+    if (end - begin == 1) {
+      (*statuses)[begin->index] = values[begin->index]->fetch();
+      return;
+    }
+    // Blob SST is ordered by internal key, seek forward through one iterator
+    std::unique_ptr<InternalIterator> iter(table_cache_->NewIterator(
+        ReadOptions(), env_options_, cfd_->internal_comparator(),
+        *begin->blob, storage_info_.dependence_map(), nullptr,
+        mutable_cf_options_.prefix_extractor.get()));
+    for (auto item = begin; item != end; ++item) {
+      (*statuses)[item->index] =
+          SeekFetch(iter.get(), item->blob, item->user_key, item->sequence,
+                    values[item->index]);
+    }
+  };
+
+  for (size_t begin = 0, end; begin < items.size(); begin = end) {
+    for (end = begin + 1;
+         end < items.size() && items[end].blob == items[begin].blob; ++end) {
+    }
+    if (!executor) {
+      fetch_group(items.data() + begin, items.data() + end);
+      continue;
+    }
+    // Each group owns its items, the task may outlive this call
+    executor([fetch_group, group = std::vector<FetchItem>(
+                               items.begin() + begin, items.begin() + end)] {
+      fetch_group(group.data(), group.data() + group.size());
+    });
+  }
+}
+
+Status Version::SeekFetch(InternalIterator* iter, FileMetaData* blob,
+                          const Slice& user_key, SequenceNumber sequence,
+                          LazyBuffer* value) const {
+  uint64_t file_number = blob->fd.GetNumber();
+  bool use_blob_cache = cfd_->ioptions()->blob_cache != nullptr;
+  IterKey iter_key;
+  iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
+  if (use_blob_cache &&
+      table_cache_->GetFromBlobCache(file_number, iter_key.GetInternalKey(),
+                                     value)) {
+    TraceBlobAccess(*cfd_->ioptions(), kTableAccessSeekFetch, file_number,
+                    iter_key.GetInternalKey(), *value, true);
+    return Status::OK();
+  }
+  ParsedInternalKey pikey;
+  iter->Seek(iter_key.GetInternalKey());
+  if (!iter->Valid() || !ParseInternalKey(iter->key(), &pikey) ||
+      pikey.sequence != sequence || pikey.type != kTypeValue ||
+      cfd_->internal_comparator().user_comparator()->Compare(
+          pikey.user_key, user_key) != 0) {
+    // Leave the uncommon cases to the regular fetch path
+    return value->fetch();
+  }
+  if (should_sample_file_read()) {
+    sample_file_read_inc(blob);
+  }
+  LazyBuffer blob_value = iter->value();
+  Status s = blob_value.fetch();
+  if (s.ok()) {
+    value->reset(blob_value.slice(), true, file_number);
+    if (use_blob_cache) {
+      table_cache_->InsertBlobCache(file_number, iter_key.GetInternalKey(),
+                                    value->slice());
+    }
+    TraceBlobAccess(*cfd_->ioptions(), kTableAccessSeekFetch, file_number,
+                    iter_key.GetInternalKey(), *value, false);
+  }
+  return s;
+}
+
+namespace {
+// Blob SST iterators of a forward scan, keyed by file number
+class BlobForwardState : public SeparateHelper::ForwardState {
+ public:
+  // Values of a scan usually come from a few blob SSTs, drop all iterators
+  // when the scan spreads across too many of them
+  static constexpr size_t kMaxIterators = 16;
+
+  std::unordered_map<uint64_t, std::unique_ptr<InternalIterator>> iterators;
+};
+}  // namespace
+
+Status Version::FetchForward(LazyBuffer* value, size_t readahead_size,
+                             std::unique_ptr<ForwardState>* state) const {
+  if (!IsSeparatePending(*value)) {
+    return value->fetch();
+  }
+  if (*state == nullptr) {
+    state->reset(new BlobForwardState);
+  }
+  auto& iterators = static_cast<BlobForwardState*>(state->get())->iterators;
+  auto context = get_context(value);
+  auto pair = reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
+  FileMetaData* blob = pair->second;
+  auto find = iterators.find(blob->fd.GetNumber());
+  if (find == iterators.end()) {
+    if (iterators.size() >= BlobForwardState::kMaxIterators) {
+      iterators.clear();
+    }
+    ReadOptions read_options;
+    read_options.readahead_size = readahead_size;
+    find = iterators
+               .emplace(blob->fd.GetNumber(),
+                        std::unique_ptr<InternalIterator>(
+                            table_cache_->NewIterator(
+                                read_options, env_options_,
+                                cfd_->internal_comparator(), *blob,
+                                storage_info_.dependence_map(), nullptr,
+                                mutable_cf_options_.prefix_extractor.get())))
+               .first;
+  }
+  return SeekFetch(
+      find->second.get(), blob,
+      Slice(reinterpret_cast<const char*>(context->data[0]), context->data[1]),
+      context->data[2], value);
+}
+
 void Version::Get(const ReadOptions& read_options, const Slice& user_key,
                   const LookupKey& k, LazyBuffer* value, Status* status,
                   MergeContext* merge_context,
                   SequenceNumber* max_covering_tombstone_seq, bool* value_found,
                   bool* key_exists, SequenceNumber* seq,
-                  ReadCallback* callback) {
+                  ReadCallback* callback, bool* value_projected) {
   Slice ikey = k.internal_key();
 
   assert(status->ok() || status->IsMergeInProgress());
@@ -1326,6 +1596,9 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
       status->ok() ? GetContext::kNotFound : GetContext::kMerge, user_key,
       value, value_found, merge_context, this, max_covering_tombstone_seq,
       this->env_, seq, callback);
+  if (UseValueMetaProjection(read_options)) {
+    get_context.SetValueMetaProjection();
+  }
 
   FilePicker fp(
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
@@ -1356,6 +1629,7 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
                         fp.IsHitFileLastInLevel()),
         fp.GetCurrentLevel());
     // TODO: examine the behavior for corrupted key
+    PERF_COUNTER_BY_LEVEL_ADD(get_from_table_count, 1, fp.GetCurrentLevel());
     if (timer_enabled) {
       PERF_COUNTER_BY_LEVEL_ADD(get_from_table_nanos, timer.ElapsedNanos(),
                                 fp.GetCurrentLevel());
@@ -1387,6 +1661,9 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
         }
         PERF_COUNTER_BY_LEVEL_ADD(user_key_return_count, 1,
                                   fp.GetHitFileLevel());
+        if (value_projected != nullptr) {
+          *value_projected = get_context.value_projected();
+        }
         return;
       case GetContext::kDeleted:
         // Use empty error message for speed
@@ -1424,6 +1701,170 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
   }
 }
 
+void Version::MultiGet(const ReadOptions& read_options,
+                       const std::vector<GetRequest>& requests) {
+  const size_t num_keys = requests.size();
+  std::vector<std::unique_ptr<GetContext>> get_contexts(num_keys);
+  std::vector<std::unique_ptr<FilePicker>> file_pickers(num_keys);
+  std::vector<FdWithKeyRange*> files(num_keys);
+  // Keys still to look up in files, in key order
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < num_keys; ++i) {
+    auto& r = requests[i];
+    assert(r.status->ok() || r.status->IsMergeInProgress());
+    get_contexts[i].reset(new GetContext(
+        user_comparator(), merge_operator_, info_log_, db_statistics_,
+        r.status->ok() ? GetContext::kNotFound : GetContext::kMerge,
+        r.user_key, r.value, nullptr /* value_found */, r.merge_context, this,
+        r.max_covering_tombstone_seq, this->env_, r.seq));
+    if (UseValueMetaProjection(read_options)) {
+      get_contexts[i]->SetValueMetaProjection();
+    }
+    file_pickers[i].reset(new FilePicker(
+        storage_info_.files_, r.user_key, r.lkey->internal_key(),
+        &storage_info_.level_files_brief_,
+        storage_info_.num_non_empty_levels_, &storage_info_.file_indexer_,
+        user_comparator(), internal_comparator()));
+    files[i] = file_pickers[i]->GetNextFile();
+    if (files[i] != nullptr) {
+      pending.push_back(i);
+    }
+  }
+  // Keys done with a result of their own, the rest are finished below
+  std::vector<bool> returned(num_keys, false);
+
+  std::unordered_map<FdWithKeyRange*, size_t> group_index;
+  std::vector<std::pair<FdWithKeyRange*, std::vector<size_t>>> groups;
+  std::vector<Slice> keys;
+  std::vector<GetContext*> contexts;
+  std::vector<Status> statuses;
+  while (!pending.empty()) {
+    group_index.clear();
+    groups.clear();
+    for (size_t i : pending) {
+      auto ib = group_index.emplace(files[i], groups.size());
+      if (ib.second) {
+        groups.emplace_back(files[i], std::vector<size_t>());
+      }
+      groups[ib.first->second].second.push_back(i);
+    }
+    pending.clear();
+    for (auto& group : groups) {
+      FdWithKeyRange* f = group.first;
+      auto& indexes = group.second;
+      FilePicker& fp = *file_pickers[indexes.front()];
+      keys.clear();
+      contexts.clear();
+      for (size_t i : indexes) {
+        if (get_contexts[i]->sample()) {
+          sample_file_read_inc(f->file_metadata);
+        }
+        keys.push_back(requests[i].lkey->internal_key());
+        contexts.push_back(get_contexts[i].get());
+      }
+      statuses.resize(indexes.size());
+
+      bool timer_enabled =
+          GetPerfLevel() >= PerfLevel::kEnableTimeExceptForMutex &&
+          get_perf_context()->per_level_perf_context_enabled;
+      StopWatchNano timer(env_, timer_enabled /* auto_start */);
+      table_cache_->MultiGet(
+          read_options, *internal_comparator(), *f->file_metadata,
+          storage_info_.dependence_map(), keys.size(), keys.data(),
+          contexts.data(), statuses.data(),
+          mutable_cf_options_.prefix_extractor.get(),
+          cfd_->internal_stats()->GetFileReadHist(fp.GetHitFileLevel()),
+          IsFilterSkipped(static_cast<int>(fp.GetHitFileLevel()),
+                          fp.IsHitFileLastInLevel()),
+          fp.GetCurrentLevel());
+      PERF_COUNTER_BY_LEVEL_ADD(get_from_table_count, 1, fp.GetCurrentLevel());
+      if (timer_enabled) {
+        PERF_COUNTER_BY_LEVEL_ADD(get_from_table_nanos, timer.ElapsedNanos(),
+                                  fp.GetCurrentLevel());
+      }
+
+      for (size_t k = 0; k < indexes.size(); ++k) {
+        size_t i = indexes[k];
+        Status* status = requests[i].status;
+        GetContext& get_context = *get_contexts[i];
+        *status = std::move(statuses[k]);
+        if (!status->ok()) {
+          returned[i] = true;
+          continue;
+        }
+        if (get_context.State() != GetContext::kNotFound &&
+            get_context.State() != GetContext::kMerge &&
+            db_statistics_ != nullptr) {
+          get_context.ReportCounters();
+        }
+        switch (get_context.State()) {
+          case GetContext::kNotFound:
+          case GetContext::kMerge:
+            break;
+          case GetContext::kFound:
+            if (fp.GetHitFileLevel() == 0) {
+              RecordTick(db_statistics_, GET_HIT_L0);
+            } else if (fp.GetHitFileLevel() == 1) {
+              RecordTick(db_statistics_, GET_HIT_L1);
+            } else if (fp.GetHitFileLevel() >= 2) {
+              RecordTick(db_statistics_, GET_HIT_L2_AND_UP);
+            }
+            PERF_COUNTER_BY_LEVEL_ADD(user_key_return_count, 1,
+                                      fp.GetHitFileLevel());
+            if (requests[i].value_projected != nullptr) {
+              *requests[i].value_projected = get_context.value_projected();
+            }
+            returned[i] = true;
+            continue;
+          case GetContext::kDeleted:
+            *status = Status::NotFound();
+            returned[i] = true;
+            continue;
+          case GetContext::kCorrupt:
+            *status = std::move(get_context).CorruptReason();
+            returned[i] = true;
+            continue;
+        }
+        if (!get_context.is_finished()) {
+          files[i] = file_pickers[i]->GetNextFile();
+          if (files[i] != nullptr) {
+            pending.push_back(i);
+          }
+        }
+      }
+    }
+    // Groups are formed in key order again
+    std::sort(pending.begin(), pending.end());
+  }
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (returned[i]) {
+      continue;
+    }
+    auto& r = requests[i];
+    GetContext& get_context = *get_contexts[i];
+    if (db_statistics_ != nullptr) {
+      get_context.ReportCounters();
+    }
+    if (GetContext::kMerge == get_context.State()) {
+      if (!merge_operator_) {
+        *r.status = Status::InvalidArgument(
+            "merge_operator is not properly initialized.");
+        continue;
+      }
+      *r.status = MergeHelper::TimedFullMerge(
+          merge_operator_, r.user_key, nullptr,
+          r.merge_context->GetOperands(), r.value, info_log_, db_statistics_,
+          env_, true);
+      if (r.status->ok()) {
+        r.value->pin(LazyBufferPinLevel::Internal);
+      }
+    } else {
+      *r.status = Status::NotFound();  // Use an empty error message for speed
+    }
+  }
+}
+
 void Version::GetKey(const Slice& user_key, const Slice& ikey, Status* status,
                      ValueType* type, SequenceNumber* seq, LazyBuffer* value,
                      const FileMetaData& blob) {
@@ -1835,9 +2276,67 @@ void VersionStorageInfo::ComputeCompactionScore(
   is_pick_compaction_fail = false;
   ComputeFilesMarkedForCompaction();
   ComputeBottommostFilesMarkedForCompaction();
+  ComputeColdFilesMarkedForRecompress(immutable_cf_options, mutable_cf_options);
+  ComputeFilesMarkedForPathMigration(immutable_cf_options, mutable_cf_options);
+  ComputeSpaceAmplification(mutable_cf_options);
   EstimateCompactionBytesNeeded(mutable_cf_options);
 }
 
+void VersionStorageInfo::ComputeSpaceAmplification(
+    const MutableCFOptions& mutable_cf_options) {
+  space_amp_gc_needed_ = false;
+  space_amp_sorted_run_ = {-1, nullptr};
+  // The SSTs hidden behind map SSTs are live as far as the map SST ranges
+  // reach into them, the rest waits for a composite compaction
+  uint64_t live_sst_size = 0;
+  uint64_t max_dead_size = 0;
+  std::pair<int, FileMetaData*> dead_sorted_run{-1, nullptr};
+  for (int level = 0; level < num_levels_; ++level) {
+    uint64_t level_dead_size = 0;
+    for (auto f : files_[level]) {
+      if (!f->prop.is_map_sst()) {
+        live_sst_size += f->fd.GetFileSize();
+        continue;
+      }
+      uint64_t dead_size = 0;
+      for (auto& dependence : f->prop.dependence) {
+        uint64_t size =
+            FileSize(nullptr, dependence.file_number, dependence.entry_count);
+        uint64_t file_size = FileSize(nullptr, dependence.file_number, 0);
+        live_sst_size += size;
+        dead_size += file_size > size ? file_size - size : 0;
+      }
+      if (level == 0 && !f->being_compacted && dead_size > max_dead_size) {
+        max_dead_size = dead_size;
+        dead_sorted_run = {0, f};
+      }
+      level_dead_size += dead_size;
+    }
+    if (level > 0 && level_dead_size > max_dead_size) {
+      max_dead_size = level_dead_size;
+      dead_sorted_run = {level, nullptr};
+    }
+  }
+  uint64_t blob_garbage_size = EstimateBlobGarbageSize();
+  uint64_t live_size = live_sst_size + blob_file_size_ - blob_garbage_size;
+  space_amplification_percent_ =
+      live_size == 0 ? 0 : (lsm_file_size_ + blob_file_size_) * 100 / live_size;
+
+  uint64_t limit = mutable_cf_options.max_space_amplification_percent;
+  if (limit == 0 || space_amplification_percent_ <= limit) {
+    return;
+  }
+  // Remedies the larger part of the excess
+  uint64_t sst_excess_size =
+      lsm_file_size_ > live_sst_size ? lsm_file_size_ - live_sst_size : 0;
+  if (blob_garbage_size >= sst_excess_size) {
+    space_amp_gc_needed_ = blob_garbage_size > 0;
+  } else {
+    // A level with map SSTs always counts for composite compaction
+    space_amp_sorted_run_ = dead_sorted_run;
+  }
+}
+
 void VersionStorageInfo::ComputeFilesMarkedForCompaction() {
   files_marked_for_compaction_.clear();
   int last_qualify_level = 0;
@@ -2214,6 +2713,65 @@ void VersionStorageInfo::ComputeBottommostFilesMarkedForCompaction() {
             bottommost_files_marked_for_compaction_.end(), FileNumberComp());
 }
 
+void VersionStorageInfo::ComputeColdFilesMarkedForRecompress(
+    const ImmutableCFOptions& immutable_cf_options,
+    const MutableCFOptions& mutable_cf_options) {
+  cold_files_marked_for_recompress_.clear();
+  uint64_t cold_seconds = mutable_cf_options.cold_recompress_seconds;
+  if (cold_seconds == 0 ||
+      immutable_cf_options.compaction_style != kCompactionStyleLevel ||
+      immutable_cf_options.enable_lazy_compaction) {
+    return;
+  }
+  int64_t now = 0;
+  if (!immutable_cf_options.env->GetCurrentTime(&now).ok() ||
+      static_cast<uint64_t>(now) < cold_seconds) {
+    return;
+  }
+  uint64_t threshold = static_cast<uint64_t>(now) - cold_seconds;
+  std::vector<std::pair<uint64_t, std::pair<int, FileMetaData*>>> cold_files;
+  for (auto& level_and_file : bottommost_files_) {
+    auto meta = level_and_file.second;
+    if (level_and_file.first == 0 || meta->being_compacted ||
+        meta->prop.is_map_sst()) {
+      continue;
+    }
+    uint64_t creation_time = meta->prop.creation_time;
+    if (creation_time > 0 && creation_time <= threshold) {
+      cold_files.emplace_back(creation_time, level_and_file);
+    }
+  }
+  std::sort(cold_files.begin(), cold_files.end(),
+            [](const std::pair<uint64_t, std::pair<int, FileMetaData*>>& a,
+               const std::pair<uint64_t, std::pair<int, FileMetaData*>>& b) {
+              return a.first < b.first;
+            });
+  for (auto& item : cold_files) {
+    cold_files_marked_for_recompress_.push_back(item.second);
+  }
+}
+
+void VersionStorageInfo::ComputeFilesMarkedForPathMigration(
+    const ImmutableCFOptions& immutable_cf_options,
+    const MutableCFOptions& mutable_cf_options) {
+  files_marked_for_path_migration_.clear();
+  uint32_t path_id;
+  if (immutable_cf_options.enable_lazy_compaction ||
+      !GetHotPathId(immutable_cf_options, mutable_cf_options, 0, &path_id)) {
+    return;
+  }
+  // The coldest data first, it gains the most from moving
+  for (int level = num_levels() - 1; level >= 0; level--) {
+    GetHotPathId(immutable_cf_options, mutable_cf_options, level, &path_id);
+    for (auto* f : files_[level]) {
+      if (!f->being_compacted && !f->prop.is_map_sst() &&
+          f->fd.GetPathId() != path_id) {
+        files_marked_for_path_migration_.emplace_back(level, f);
+      }
+    }
+  }
+}
+
 void Version::Ref() { ++refs_; }
 
 bool Version::Unref() {
@@ -2818,6 +3376,19 @@ uint64_t VersionStorageInfo::EstimateLiveDataSize() const {
                           : 0)));
 }
 
+size_t VersionStorageInfo::ApproximateBlobReferenceMemoryUsage() const {
+  size_t usage = dependence_map_.size() *
+                 (sizeof(uint64_t) + sizeof(FileMetaData*));
+  for (int level = -1; level < num_levels(); ++level) {
+    for (auto f : files_[level]) {
+      usage += f->prop.dependence.capacity() * sizeof(Dependence) +
+               f->prop.inheritance.capacity() * sizeof(uint64_t);
+    }
+  }
+  usage += files_[-1].size() * sizeof(FileMetaData);
+  return usage;
+}
+
 bool VersionStorageInfo::RangeMightExistAfterSortedRun(
     const Slice& smallest_user_key, const Slice& largest_user_key,
     int last_level, int last_l0_idx) {
@@ -2941,6 +3512,8 @@ VersionSet::VersionSet(const std::string& dbname,
       current_version_number_(0),
       manifest_file_size_(0),
       manifest_edit_count_(0),
+      manifest_snapshot_size_(0),
+      manifest_tail_offset_(0),
       seq_per_batch_(seq_per_batch),
       env_options_(storage_options) {}
 
@@ -2993,6 +3566,12 @@ void VersionSet::AppendVersion(ColumnFamilyData* column_family_data,
   v->next_->prev_ = v;
 }
 
+bool VersionSet::LoadEssenceSst(ColumnFamilyData* cfd) {
+  return column_family_set_->get_table_cache()->GetCapacity() ==
+             TableCache::kInfiniteCapacity &&
+         !cfd->ioptions()->lazy_load_table_readers;
+}
+
 Status VersionSet::ProcessManifestWrites(std::deque<ManifestWriter>& writers,
                                          InstrumentedMutex* mu,
                                          Directory* db_directory,
@@ -3150,9 +3729,23 @@ Status VersionSet::ProcessManifestWrites(std::deque<ManifestWriter>& writers,
   Status s;
 
   assert(pending_manifest_file_number_ == 0);
+  // Recovery replays the whole tail after the snapshot, so start over with a
+  // fresh snapshot once the tail outgrows the state it describes
+  const uint64_t kMinManifestTailSize = 1 << 20;
+  uint64_t manifest_tail_size = manifest_file_size_ > manifest_snapshot_size_
+                                    ? manifest_file_size_ -
+                                          manifest_snapshot_size_
+                                    : 0;
+  bool manifest_tail_too_large =
+      db_options_->max_manifest_tail_ratio > 0 && manifest_snapshot_size_ > 0 &&
+      manifest_tail_size > kMinManifestTailSize &&
+      manifest_tail_size > db_options_->max_manifest_tail_ratio *
+                               static_cast<double>(manifest_snapshot_size_);
+  uint64_t new_manifest_snapshot_size = 0;
   if (!descriptor_log_ ||
       manifest_file_size_ > db_options_->max_manifest_file_size ||
-      manifest_edit_count_ > db_options_->max_manifest_edit_count) {
+      manifest_edit_count_ > db_options_->max_manifest_edit_count ||
+      manifest_tail_too_large) {
     pending_manifest_file_number_ = NewFileNumber();
     batch_edits.back()->SetNextFile(next_file_number_.load());
     new_descriptor_log = true;
@@ -3185,9 +3778,6 @@ Status VersionSet::ProcessManifestWrites(std::deque<ManifestWriter>& writers,
     TEST_SYNC_POINT("VersionSet::LogAndApply:WriteManifest");
 
     if (!first_writer.edit_list.front()->IsColumnFamilyManipulation()) {
-      bool load_essence_sst =
-          column_family_set_->get_table_cache()->GetCapacity() ==
-          TableCache::kInfiniteCapacity;
       for (int i = 0; i < static_cast<int>(versions.size()); ++i) {
         assert(!builder_guards.empty() &&
                builder_guards.size() == versions.size());
@@ -3198,7 +3788,7 @@ Status VersionSet::ProcessManifestWrites(std::deque<ManifestWriter>& writers,
             cfd->internal_stats(),
             mutable_cf_options_ptrs[i]->optimize_filters_for_hits,
             mutable_cf_options_ptrs[i]->prefix_extractor.get(),
-            load_essence_sst);
+            LoadEssenceSst(cfd));
       }
     }
 
@@ -3220,9 +3810,13 @@ Status VersionSet::ProcessManifestWrites(std::deque<ManifestWriter>& writers,
         std::unique_ptr<WritableFileWriter> file_writer(new WritableFileWriter(
             std::move(descriptor_file), descriptor_fname, opt_env_opts, nullptr,
             db_options_->listeners));
-        descriptor_log_.reset(
-            new log::Writer(std::move(file_writer), 0, false));
+        // Records of a group are flushed together by SyncManifest
+        descriptor_log_.reset(new log::Writer(std::move(file_writer), 0,
+                                              false, true /* manual_flush */));
         s = WriteSnapshot(descriptor_log_.get());
+        if (s.ok()) {
+          new_manifest_snapshot_size = descriptor_log_->file()->GetFileSize();
+        }
       }
     }
 
@@ -3348,6 +3942,7 @@ Status VersionSet::ProcessManifestWrites(std::deque<ManifestWriter>& writers,
     manifest_file_size_ = new_manifest_file_size;
     if (new_descriptor_log) {
       manifest_edit_count_ = 0;
+      manifest_snapshot_size_ = new_manifest_snapshot_size;
     } else {
       manifest_edit_count_ += batch_edits.size();
     }
@@ -3683,7 +4278,7 @@ Status VersionSet::ApplyOneVersionEdit(
 
 Status VersionSet::Recover(
     const std::vector<ColumnFamilyDescriptor>& column_families,
-    bool read_only) {
+    bool read_only, bool tail_manifest) {
   std::unordered_map<std::string, ColumnFamilyOptions> cf_name_to_options;
   for (auto cf : column_families) {
     cf_name_to_options.insert({cf.name, cf.options});
@@ -3760,6 +4355,7 @@ Status VersionSet::Recover(
   // initialized earlier.
   default_cfd->set_initialized();
   builders.insert({0, new BaseReferencedVersionBuilder(default_cfd)});
+  uint64_t tail_offset = 0;
 
   {
     VersionSet::LogReporter reporter;
@@ -3811,6 +4407,7 @@ Status VersionSet::Recover(
           }
           replay_buffer.clear();
           num_entries_decoded = 0;
+          tail_offset = reader.LastRecordEnd();
         }
         TEST_SYNC_POINT("VersionSet::Recover:AtomicGroup");
       } else {
@@ -3827,6 +4424,7 @@ Status VersionSet::Recover(
             &previous_log_number, &have_next_file, &next_file,
             &have_last_sequence, &last_sequence, &min_log_number_to_keep,
             &max_column_family);
+        tail_offset = reader.LastRecordEnd();
       }
       if (!s.ok()) {
         break;
@@ -3886,7 +4484,7 @@ Status VersionSet::Recover(
       if (cfd->IsDropped()) {
         continue;
       }
-      if (read_only) {
+      if (read_only && !tail_manifest) {
         cfd->table_cache()->SetTablesAreImmortal();
       }
       assert(cfd->initialized());
@@ -3894,16 +4492,13 @@ Status VersionSet::Recover(
       assert(builders_iter != builders.end());
       auto* builder = builders_iter->second->version_builder();
 
-      bool load_essence_sst =
-          GetColumnFamilySet()->get_table_cache()->GetCapacity() ==
-          TableCache::kInfiniteCapacity;
       // if unlimited table cache, pre-load all table handle. otherwise only
       // pre-load map sst.
       // Need to do it out of the mutex.
       builder->LoadTableHandlers(
           cfd->internal_stats(), false /* prefetch_index_and_filter_in_cache */,
           cfd->GetLatestMutableCFOptions()->prefix_extractor.get(),
-          load_essence_sst, db_options_->max_file_opening_threads);
+          LoadEssenceSst(cfd), db_options_->max_file_opening_threads);
 
       builder->UpgradeFileMetaData(
           cfd->GetLatestMutableCFOptions()->prefix_extractor.get(),
@@ -3921,6 +4516,7 @@ Status VersionSet::Recover(
 
     manifest_file_size_ = current_manifest_file_size;
     manifest_edit_count_ = current_manifest_edit_count;
+    manifest_tail_offset_ = tail_offset;
     next_file_number_.store(next_file + 1);
     last_allocated_sequence_ = last_sequence;
     last_published_sequence_ = last_sequence;
@@ -3957,6 +4553,268 @@ Status VersionSet::Recover(
   return s;
 }
 
+Status VersionSet::TailManifest(
+    InstrumentedMutex* mu,
+    std::unordered_set<ColumnFamilyData*>* cfds_changed) {
+  mu->AssertHeld();
+  std::string manifest_filename;
+  Status s =
+      ReadFileToString(env_, CurrentFileName(dbname_), &manifest_filename);
+  if (!s.ok()) {
+    return s;
+  }
+  if (manifest_filename.empty() || manifest_filename.back() != '\n') {
+    return Status::Corruption("CURRENT file does not end with newline");
+  }
+  manifest_filename.resize(manifest_filename.size() - 1);
+  uint64_t manifest_number = 0;
+  FileType type;
+  if (!ParseFileName(manifest_filename, &manifest_number, &type) ||
+      type != kDescriptorFile) {
+    return Status::Corruption("CURRENT file corrupted");
+  }
+  // A new MANIFEST starts with a snapshot of all column families, they are
+  // rebuilt from it instead of applying it on their current versions
+  const bool new_manifest = manifest_number != manifest_file_number_;
+  const uint64_t offset = new_manifest ? 0 : manifest_tail_offset_;
+  // Records are framed in blocks, the reader starts at the block of offset
+  const uint64_t block_offset = offset - offset % log::kBlockSize;
+  // The writer pads a block tail too short for a header
+  uint64_t expected_offset = offset;
+  if (log::kBlockSize - offset % log::kBlockSize <
+      static_cast<uint64_t>(log::kHeaderSize)) {
+    expected_offset = block_offset + log::kBlockSize;
+  }
+
+  manifest_filename = dbname_ + "/" + manifest_filename;
+  std::unique_ptr<SequentialFileReader> manifest_file_reader;
+  {
+    std::unique_ptr<SequentialFile> manifest_file;
+    s = env_->NewSequentialFile(manifest_filename, &manifest_file,
+                                env_->OptimizeForManifestRead(env_options_));
+    if (s.ok() && block_offset > 0) {
+      s = manifest_file->Skip(block_offset);
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    manifest_file_reader.reset(
+        new SequentialFileReader(std::move(manifest_file), manifest_filename));
+  }
+
+  // The records ahead of offset in its block are not applied again, one
+  // that started in an earlier block is reported as a corruption
+  struct TailReporter : public log::Reader::Reporter {
+    Status* status;
+    bool skipping;
+    virtual void Corruption(size_t /*bytes*/, const Status& st) override {
+      if (!skipping && status->ok()) {
+        *status = st;
+      }
+    }
+  };
+  TailReporter reporter;
+  reporter.status = &s;
+  reporter.skipping = block_offset < offset;
+
+  std::unordered_map<uint32_t, std::unique_ptr<BaseReferencedVersionBuilder>>
+      builders;
+  std::unordered_map<uint32_t, uint64_t> log_numbers;
+  bool have_next_file = false;
+  bool have_last_sequence = false;
+  bool have_prev_log_number = false;
+  uint64_t next_file = 0;
+  SequenceNumber last_sequence = 0;
+  uint64_t prev_log_number = 0;
+  uint64_t min_log_number_to_keep = 0;
+  uint32_t max_column_family = 0;
+  auto apply = [&](VersionEdit& edit) {
+    edit.set_open_db(new_manifest);
+    ColumnFamilyData* cfd =
+        column_family_set_->GetColumnFamily(edit.column_family_);
+    if (cfd != nullptr) {
+      if (edit.is_column_family_drop_) {
+        builders.erase(cfd->GetID());
+        log_numbers.erase(cfd->GetID());
+        cfd->SetDropped();
+      } else {
+        auto& builder = builders[cfd->GetID()];
+        if (!builder) {
+          if (new_manifest) {
+            builder.reset(new BaseReferencedVersionBuilder(
+                cfd, new Version(cfd, this, env_options_,
+                                 *cfd->GetLatestMutableCFOptions(),
+                                 current_version_number_++)));
+          } else {
+            builder.reset(new BaseReferencedVersionBuilder(cfd));
+          }
+        }
+        builder->version_builder()->Apply(&edit);
+        if (edit.has_log_number_) {
+          log_numbers[cfd->GetID()] = edit.log_number_;
+        }
+      }
+    }
+    if (edit.has_prev_log_number_) {
+      prev_log_number = edit.prev_log_number_;
+      have_prev_log_number = true;
+    }
+    if (edit.has_next_file_number_) {
+      next_file = edit.next_file_number_;
+      have_next_file = true;
+    }
+    if (edit.has_max_column_family_) {
+      max_column_family = edit.max_column_family_;
+    }
+    if (edit.has_min_log_number_to_keep_) {
+      min_log_number_to_keep =
+          std::max(min_log_number_to_keep, edit.min_log_number_to_keep_);
+    }
+    if (edit.has_last_sequence_) {
+      last_sequence = edit.last_sequence_;
+      have_last_sequence = true;
+    }
+  };
+
+  uint64_t tail_offset = offset;
+  {
+    log::Reader reader(nullptr, std::move(manifest_file_reader), &reporter,
+                       true /* checksum */, 0 /* log_number */,
+                       false /* retry_after_eof */);
+    Slice record;
+    std::string scratch;
+    std::vector<VersionEdit> replay_buffer;
+    size_t num_entries_decoded = 0;
+    while (reader.ReadRecord(&record, &scratch) && s.ok()) {
+      uint64_t record_offset = block_offset + reader.LastRecordOffset();
+      if (record_offset < offset) {
+        continue;
+      }
+      if (reporter.skipping) {
+        reporter.skipping = false;
+        if (record_offset != expected_offset) {
+          s = Status::Corruption("MANIFEST record lost at tail offset",
+                                 manifest_filename);
+          break;
+        }
+      }
+      VersionEdit edit;
+      s = edit.DecodeFrom(record);
+      if (!s.ok()) {
+        break;
+      }
+      if (edit.is_in_atomic_group_) {
+        if (replay_buffer.empty()) {
+          replay_buffer.resize(edit.remaining_entries_ + 1);
+        }
+        ++num_entries_decoded;
+        if (num_entries_decoded + edit.remaining_entries_ !=
+            static_cast<uint32_t>(replay_buffer.size())) {
+          s = Status::Corruption("corrupted atomic group");
+          break;
+        }
+        replay_buffer[num_entries_decoded - 1] = std::move(edit);
+        if (num_entries_decoded == replay_buffer.size()) {
+          for (auto& e : replay_buffer) {
+            apply(e);
+          }
+          replay_buffer.clear();
+          num_entries_decoded = 0;
+          tail_offset = block_offset + reader.LastRecordEnd();
+        }
+      } else {
+        if (!replay_buffer.empty()) {
+          s = Status::Corruption("corrupted atomic group");
+          break;
+        }
+        apply(edit);
+        tail_offset = block_offset + reader.LastRecordEnd();
+      }
+    }
+    // An atomic group the primary is still writing is read again next time
+  }
+  if (s.ok() && new_manifest) {
+    // Dropped before the new MANIFEST was written
+    for (auto cfd : *column_family_set_) {
+      if (!cfd->IsDropped() && builders.count(cfd->GetID()) == 0 &&
+          cfd->GetID() != 0) {
+        cfd->SetDropped();
+      }
+    }
+  }
+  for (auto& pair : builders) {
+    auto* builder = pair.second->version_builder();
+    if (s.ok() && !builder->CheckConsistencyForNumLevels()) {
+      s = Status::InvalidArgument(
+          "db has more levels than options.num_levels");
+    }
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (!builders.empty()) {
+    std::vector<std::pair<ColumnFamilyData*, const SliceTransform*>>
+        prefix_extractors;
+    for (auto& pair : builders) {
+      auto cfd = column_family_set_->GetColumnFamily(pair.first);
+      prefix_extractors.emplace_back(
+          cfd, cfd->GetLatestMutableCFOptions()->prefix_extractor.get());
+    }
+    // The table cache is shared with the current versions, so the tables
+    // already open stay open and only the new ones are loaded
+    mu->Unlock();
+    for (auto& pair : prefix_extractors) {
+      auto* builder = builders[pair.first->GetID()]->version_builder();
+      builder->LoadTableHandlers(
+          pair.first->internal_stats(),
+          false /* prefetch_index_and_filter_in_cache */, pair.second,
+          LoadEssenceSst(pair.first), db_options_->max_file_opening_threads);
+      builder->UpgradeFileMetaData(pair.second,
+                                   db_options_->max_file_opening_threads);
+    }
+    mu->Lock();
+    for (auto& pair : prefix_extractors) {
+      auto cfd = pair.first;
+      Version* v = new Version(cfd, this, env_options_,
+                               *cfd->GetLatestMutableCFOptions(),
+                               current_version_number_++);
+      builders[cfd->GetID()]->version_builder()->SaveTo(v->storage_info());
+      v->PrepareApply(*cfd->GetLatestMutableCFOptions());
+      AppendVersion(cfd, v);
+      auto find = log_numbers.find(cfd->GetID());
+      if (find != log_numbers.end() && find->second > cfd->GetLogNumber()) {
+        cfd->SetLogNumber(find->second);
+      }
+      cfds_changed->insert(cfd);
+    }
+  }
+
+  if (have_next_file && next_file + 1 > next_file_number_.load()) {
+    next_file_number_.store(next_file + 1);
+  }
+  if (have_last_sequence && last_sequence > last_sequence_.load()) {
+    last_allocated_sequence_ = last_sequence;
+    last_published_sequence_ = last_sequence;
+    last_sequence_ = last_sequence;
+  }
+  if (have_prev_log_number) {
+    prev_log_number_ = prev_log_number;
+  }
+  column_family_set_->UpdateMaxColumnFamily(max_column_family);
+  MarkMinLogNumberToKeep2PC(min_log_number_to_keep);
+  if (new_manifest) {
+    ROCKS_LOG_INFO(db_options_->info_log,
+                   "Following manifest file: %s, last_sequence is %" PRIu64
+                   "\n",
+                   manifest_filename.c_str(), last_sequence_.load());
+  }
+  manifest_file_number_ = manifest_number;
+  manifest_file_size_ = tail_offset;
+  manifest_tail_offset_ = tail_offset;
+  return s;
+}
+
 Status VersionSet::ListColumnFamilies(std::vector<std::string>* column_families,
                                       const std::string& dbname, Env* env) {
   // these are just for performance reasons, not correcntes,
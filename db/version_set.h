@@ -20,6 +20,7 @@
 #pragma once
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
@@ -131,6 +132,10 @@ class VersionStorageInfo {
   void ComputeCompactionScore(const ImmutableCFOptions& immutable_cf_options,
                               const MutableCFOptions& mutable_cf_options);
 
+  // Estimates the space amplification, and what to compact for it beyond
+  // max_space_amplification_percent
+  void ComputeSpaceAmplification(const MutableCFOptions& mutable_cf_options);
+
   // Estimate est_comp_needed_bytes_
   void EstimateCompactionBytesNeeded(
       const MutableCFOptions& mutable_cf_options);
@@ -151,6 +156,24 @@ class VersionStorageInfo {
   // REQUIRES: DB mutex held
   void ComputeBottommostFilesMarkedForCompaction();
 
+  // This computes cold_files_marked_for_recompress_ and is called by
+  // ComputeCompactionScore()
+  //
+  // Among bottommost files, marks the ones created more than
+  // cold_recompress_seconds ago. Level style without lazy compaction only.
+  void ComputeColdFilesMarkedForRecompress(
+      const ImmutableCFOptions& immutable_cf_options,
+      const MutableCFOptions& mutable_cf_options);
+
+  // This computes files_marked_for_path_migration_ and is called by
+  // ComputeCompactionScore()
+  //
+  // Marks the SSTs not on the path hot_path_levels places their level on.
+  // Level style without lazy compaction only.
+  void ComputeFilesMarkedForPathMigration(
+      const ImmutableCFOptions& immutable_cf_options,
+      const MutableCFOptions& mutable_cf_options);
+
   // Generate level_files_brief_ from files_
   void GenerateLevelFilesBrief();
   // Sort all files for this version based on their file size and
@@ -272,6 +295,24 @@ class VersionStorageInfo {
     return blob_marked_for_compaction_;
   }
 
+  // The size of the SSTs and blob SSTs over the estimated size of the live
+  // data in them, in percent, 0 without data
+  uint64_t space_amplification_percent() const {
+    return space_amplification_percent_;
+  }
+
+  // Set when the space amplification beyond max_space_amplification_percent
+  // is mostly blob garbage
+  bool space_amp_gc_needed() const { return space_amp_gc_needed_; }
+
+  // The sorted run to compact for the space amplification beyond
+  // max_space_amplification_percent, when it mostly comes from the SSTs
+  // partially reached by map SSTs. The level is -1 if none, the file is set
+  // for level 0 only
+  const std::pair<int, FileMetaData*>& space_amp_sorted_run() const {
+    return space_amp_sorted_run_;
+  }
+
   bool has_space_amplification() const { return !space_amplification_.empty(); }
 
   bool has_space_amplification(int level) const {
@@ -308,6 +349,26 @@ class VersionStorageInfo {
                            read_amplification_.end(), 0.);
   }
 
+  void set_read_amp_depth(const std::vector<uint64_t>& depth) {
+    read_amp_depth_ = depth;
+  }
+
+  // SSTs linked by the deepest key range of the map SSTs in "level", summed
+  // over the files of level 0
+  uint64_t read_amp_depth(int level) const { return read_amp_depth_[level]; }
+
+  // SSTs a point lookup reads beyond one per sorted run, caused by overlap in
+  // map SSTs of lazy compaction
+  uint64_t read_amp_debt() const {
+    uint64_t debt = 0;
+    for (int level = 0; level < static_cast<int>(read_amp_depth_.size());
+         ++level) {
+      uint64_t runs = level == 0 ? files_[0].size() : !files_[level].empty();
+      debt += read_amp_depth_[level] - std::min(runs, read_amp_depth_[level]);
+    }
+    return debt;
+  }
+
   // REQUIRES: This version has been saved (see VersionSet::SaveTo)
   int num_non_empty_levels() const {
     assert(finalized_);
@@ -366,6 +427,22 @@ class VersionStorageInfo {
     return bottommost_files_marked_for_compaction_;
   }
 
+  // REQUIRES: This version has been saved (see VersionSet::SaveTo)
+  // REQUIRES: DB mutex held during access
+  const autovector<std::pair<int, FileMetaData*>>&
+  ColdFilesMarkedForRecompress() const {
+    assert(finalized_);
+    return cold_files_marked_for_recompress_;
+  }
+
+  // REQUIRES: This version has been saved (see VersionSet::SaveTo)
+  // REQUIRES: DB mutex held during access
+  const autovector<std::pair<int, FileMetaData*>>&
+  FilesMarkedForPathMigration() const {
+    assert(finalized_);
+    return files_marked_for_path_migration_;
+  }
+
   int base_level() const { return base_level_; }
   double level_multiplier() const { return level_multiplier_; }
 
@@ -465,6 +542,11 @@ class VersionStorageInfo {
   // Returns an estimate of the amount of live data in bytes.
   uint64_t EstimateLiveDataSize() const;
 
+  // Bytes of the metadata resolving values to the SSTs holding them: the
+  // dependence and inheritance lists, the dependence map and the metadata of
+  // the SSTs only reachable through it
+  size_t ApproximateBlobReferenceMemoryUsage() const;
+
   uint64_t estimated_compaction_needed_bytes() const {
     return estimated_compaction_needed_bytes_;
   }
@@ -492,6 +574,17 @@ class VersionStorageInfo {
     return version_builder_context_.reset(context);
   }
   uint64_t blob_file_count() { return blob_file_count_; }
+  uint64_t blob_file_size() const { return blob_file_size_; }
+  // Bytes of the blob SSTs taken by antiquated values, assuming values of
+  // the same size
+  uint64_t EstimateBlobGarbageSize() const {
+    if (blob_num_entries_ == 0) {
+      return 0;
+    }
+    return static_cast<uint64_t>(
+        double(std::min(blob_num_antiquation_, blob_num_entries_)) /
+        blob_num_entries_ * blob_file_size_);
+  }
   void CalculateTopkGarbageBlobs();
   void ComputeBlobOverlapScore();
 
@@ -569,6 +662,15 @@ class VersionStorageInfo {
   // seqnums of unmarked bottommost files.
   SequenceNumber bottommost_files_mark_threshold_ = kMaxSequenceNumber;
 
+  // Bottommost files older than cold_recompress_seconds, oldest first.
+  // Protected by DB mutex and calculated in ComputeCompactionScore()
+  autovector<std::pair<int, FileMetaData*>> cold_files_marked_for_recompress_;
+
+  // Files on another path than hot_path_levels places their level on,
+  // deepest level first. Protected by DB mutex and calculated in
+  // ComputeCompactionScore()
+  autovector<std::pair<int, FileMetaData*>> files_marked_for_path_migration_;
+
   // Monotonically increases as we release old snapshots. Zero indicates no
   // snapshots have been released yet. When no snapshots remain we set it to the
   // current seqnum, which needs to be protected as a snapshot can still be
@@ -589,8 +691,12 @@ class VersionStorageInfo {
     kMarkedForCompaction = 1ULL << 2,
   };
   std::unordered_map<int, int> space_amplification_;
+  uint64_t space_amplification_percent_ = 0;
+  bool space_amp_gc_needed_ = false;
+  std::pair<int, FileMetaData*> space_amp_sorted_run_{-1, nullptr};
   std::unordered_map<uint64_t, uint64_t> blob_overlap_scores_;
   std::vector<double> read_amplification_;
+  std::vector<uint64_t> read_amp_depth_;
 
   int l0_delay_trigger_count_ = 0;  // Count used to trigger slow down and stop
                                     // for number of L0 files.
@@ -662,13 +768,65 @@ class Version : public SeparateHelper, private LazyBufferState {
   //                      *key_exists will be set to false.
   // If seq is non-null, *seq will be set to the sequence number found
   // for the key if a key was found.
+  // If value_projected is non-null, *value_projected will be set to whether
+  // the found value is already the ReadOptions::value_projection of the
+  // value, read from the value meta of a separated value.
   //
   // REQUIRES: lock is not held
   void Get(const ReadOptions&, const Slice& user_key, const LookupKey& key,
            LazyBuffer* value, Status* status, MergeContext* merge_context,
            SequenceNumber* max_covering_tombstone_seq,
            bool* value_found = nullptr, bool* key_exists = nullptr,
-           SequenceNumber* seq = nullptr, ReadCallback* callback = nullptr);
+           SequenceNumber* seq = nullptr, ReadCallback* callback = nullptr,
+           bool* value_projected = nullptr);
+
+  // One key of MultiGet, the fields are the arguments of Get
+  struct GetRequest {
+    Slice user_key;
+    const LookupKey* lkey;
+    LazyBuffer* value;
+    Status* status;
+    MergeContext* merge_context;
+    SequenceNumber* max_covering_tombstone_seq;
+    // If set with a null value, only the sequence of the latest record is
+    // read, as Get() does with seq
+    SequenceNumber* seq = nullptr;
+    bool* value_projected = nullptr;
+  };
+
+  // Get of a batch of keys sorted by user key. Keys that are in the same
+  // file at the same time are looked up through one TableReader::MultiGet
+  //
+  // REQUIRES: lock is not held
+  void MultiGet(const ReadOptions&, const std::vector<GetRequest>& requests);
+
+  // Whether the latest separated values read with read_options are answered
+  // by their value meta, see ReadOptions::value_projection_is_meta
+  bool UseValueMetaProjection(const ReadOptions& read_options) const {
+    return read_options.value_projection != nullptr &&
+           read_options.value_projection_is_meta && cfd_ != nullptr &&
+           cfd_->ioptions()->value_meta_extractor_factory != nullptr;
+  }
+
+  // Return true if value is a separated value produced by this version's
+  // TransToCombined and has not been fetched yet.
+  bool IsSeparatePending(const LazyBuffer& value) const;
+
+  typedef std::function<void(std::function<void()>&&)> FetchExecutor;
+
+  // Fetch a batch of separated values produced by this version. Values are
+  // grouped by blob SST and fetched in key order, so neighbouring values share
+  // the data blocks read through one table iterator instead of issuing one
+  // random read per value.
+  // If executor is set, every blob SST group is handed to it as a task and
+  // MultiFetch returns without waiting, the caller must keep values and
+  // statuses alive until all submitted tasks finished. This lets aio reads
+  // of different blob SSTs stay in flight together on the fiber pool.
+  // REQUIRES: IsSeparatePending(*values[i]) for each i
+  // REQUIRES: lock is not held
+  void MultiFetch(const std::vector<LazyBuffer*>& values,
+                  std::vector<Status>* statuses,
+                  const FetchExecutor& executor = FetchExecutor()) const;
 
   void GetKey(const Slice& user_key, const Slice& ikey, Status* status,
               ValueType* type, SequenceNumber* seq, LazyBuffer* value,
@@ -725,6 +883,9 @@ class Version : public SeparateHelper, private LazyBufferState {
 
   size_t GetMemoryUsageByTableReaders();
 
+  // Index and dictionary parts of GetMemoryUsageByTableReaders()
+  void GetIndexAndDictMemoryUsage(size_t* index_usage, size_t* dict_usage);
+
   // REQUIRES: lock is held
   double GetCompactionLoad() const;
 
@@ -791,6 +952,8 @@ class Version : public SeparateHelper, private LazyBufferState {
   const MergeOperator* merge_operator_;
 
   VersionStorageInfo storage_info_;
+  // Table readers shared by the read iterators over this version
+  TableReaderHandleCache reader_cache_;
   VersionSet* vset_;  // VersionSet to which this Version belongs
   Version* next_;     // Next version in linked list
   Version* prev_;     // Previous version in linked list
@@ -818,6 +981,15 @@ class Version : public SeparateHelper, private LazyBufferState {
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                              const LazyBuffer& value) const override;
 
+  Status FetchForward(LazyBuffer* value, size_t readahead_size,
+                      std::unique_ptr<ForwardState>* state) const override;
+
+  // Fetch the separated value of "user_key"@"sequence" by seeking "iter" over
+  // the blob SST "blob", fall back to the regular fetch path if not found.
+  Status SeekFetch(InternalIterator* iter, FileMetaData* blob,
+                   const Slice& user_key, SequenceNumber sequence,
+                   LazyBuffer* value) const;
+
   // No copying allowed
   Version(const Version&);
   void operator=(const Version&);
@@ -924,9 +1096,21 @@ class VersionSet {
 
   // Recover the last saved descriptor from persistent storage.
   // If read_only == true, Recover() will not complain if some column families
-  // are not opened
+  // are not opened. If tail_manifest == true the MANIFEST is followed by
+  // TailManifest() afterwards, the tables then belong to another instance and
+  // are not made immortal.
   Status Recover(const std::vector<ColumnFamilyDescriptor>& column_families,
-                 bool read_only = false);
+                 bool read_only = false, bool tail_manifest = false);
+
+  // Applies the records another instance appended to the MANIFEST since
+  // Recover() or the previous call, and follows CURRENT to a new MANIFEST.
+  // Column families that got a new Version are added to *cfds_changed.
+  // Records of column families that were not opened are skipped, a dropped
+  // column family keeps its last Version.
+  // REQUIRES: *mu is held, Recover() was called with tail_manifest == true.
+  // *mu is released while the new table readers are loaded.
+  Status TailManifest(InstrumentedMutex* mu,
+                      std::unordered_set<ColumnFamilyData*>* cfds_changed);
 
   // Reads a manifest file and returns a list of column families in
   // column_families.
@@ -1132,6 +1316,10 @@ class VersionSet {
 
   void AppendVersion(ColumnFamilyData* column_family_data, Version* v);
 
+  // Whether all table readers of the column family are opened when its
+  // versions are built, rather than only the map SSTs
+  bool LoadEssenceSst(ColumnFamilyData* cfd);
+
   ColumnFamilyData* CreateColumnFamily(const ColumnFamilyOptions& cf_options,
                                        VersionEdit* edit);
 
@@ -1194,6 +1382,13 @@ class VersionSet {
   // VersionEdit count of manifest file
   uint64_t manifest_edit_count_;
 
+  // Size of the snapshot at the head of manifest file, 0 if unknown
+  uint64_t manifest_snapshot_size_;
+
+  // End of the last record applied by Recover() or TailManifest(), a partly
+  // written record or atomic group is read again by the next TailManifest()
+  uint64_t manifest_tail_offset_;
+
   std::vector<ObsoleteFileInfo> obsolete_files_;
   std::vector<std::string> obsolete_manifests_;
 
@@ -77,6 +77,39 @@ TEST_F(GenerateLevelFilesBriefTest, Multiple) {
   ASSERT_EQ(0, Compare());
 }
 
+TEST_F(GenerateLevelFilesBriefTest, Fences) {
+  // Keys shorter than, as long as and longer than a fence, some of them
+  // sharing their first 8 bytes
+  std::vector<std::string> keys;
+  for (int i = 0; i < 100; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04d", i);
+    keys.push_back(buf);
+    keys.push_back(std::string("prefix") + buf);
+  }
+  std::sort(keys.begin(), keys.end());
+  for (size_t i = 0; i + 1 < keys.size(); i += 2) {
+    Add(keys[i].c_str(), keys[i + 1].c_str());
+  }
+  DoGenerateLevelFilesBrief(&file_level_, files_, &arena_);
+  ASSERT_NE(nullptr, file_level_.largest_fences);
+  LevelFilesBrief no_fences = file_level_;
+  no_fences.largest_fences = nullptr;
+
+  InternalKeyComparator cmp(BytewiseComparator());
+  keys.push_back("");
+  keys.push_back("prefix");
+  keys.push_back("prefix0049a");
+  keys.push_back("zzz");
+  for (auto& key : keys) {
+    for (SequenceNumber seq : {50, 100, 150}) {
+      InternalKey target(key, seq, kTypeValue);
+      ASSERT_EQ(FindFile(cmp, no_fences, target.Encode()),
+                FindFile(cmp, file_level_, target.Encode()));
+    }
+  }
+}
+
 class CountingLogger : public Logger {
  public:
   CountingLogger() : log_count(0) {}
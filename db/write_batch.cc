@@ -1003,6 +1003,9 @@ Status WriteBatch::PopSavePoint() {
 
 class MemTableInserter : public WriteBatch::Handler {
   SequenceNumber sequence_;
+  // Entries from this sequence on are written by this inserter and cannot
+  // be seen by readers or snapshots until the write is published
+  const SequenceNumber first_sequence_;
   ColumnFamilyMemTables* const cf_mems_;
   FlushScheduler* const flush_scheduler_;
   const bool ignore_missing_column_families_;
@@ -1074,6 +1077,7 @@ class MemTableInserter : public WriteBatch::Handler {
                    bool* has_valid_writes = nullptr, bool seq_per_batch = false,
                    bool batch_per_txn = true)
       : sequence_(_sequence),
+        first_sequence_(_sequence),
         cf_mems_(cf_mems),
         flush_scheduler_(flush_scheduler),
         ignore_missing_column_families_(ignore_missing_column_families),
@@ -1184,6 +1188,16 @@ class MemTableInserter : public WriteBatch::Handler {
     return true;
   }
 
+  // Samples the keys written for DBOptions::hot_key_sample_rate, the ones
+  // replayed from the WAL are skipped
+  void RecordHotKey(uint32_t column_family_id, const Slice& key) {
+    if (db_ != nullptr && recovering_log_number_ == 0 &&
+        db_->immutable_db_options().hot_key_tracker) {
+      db_->immutable_db_options().hot_key_tracker->RecordKey(column_family_id,
+                                                             key);
+    }
+  }
+
   Status PutCFImpl(uint32_t column_family_id, const Slice& key,
                    const Slice& value, ValueType value_type) {
     // optimize for non-recovery mode
@@ -1207,6 +1221,7 @@ class MemTableInserter : public WriteBatch::Handler {
       return seek_status;
     }
     Status ret_status;
+    RecordHotKey(column_family_id, key);
 
     MemTable* mem = cf_mems_->GetMemTable();
     auto* moptions = mem->GetImmutableMemTableOptions();
@@ -1460,6 +1475,7 @@ class MemTableInserter : public WriteBatch::Handler {
     }
 
     Status ret_status;
+    RecordHotKey(column_family_id, key);
     MemTable* mem = cf_mems_->GetMemTable();
     auto* moptions = mem->GetImmutableMemTableOptions();
     bool perform_merge = false;
@@ -1532,6 +1548,12 @@ class MemTableInserter : public WriteBatch::Handler {
       }
     }
 
+    if (!perform_merge && !seq_per_batch_ &&
+        moptions->memtable_merge_fold_threshold > 0 &&
+        mem->FoldMerge(sequence_, first_sequence_, key, value)) {
+      perform_merge = true;
+    }
+
     if (!perform_merge) {
       // Add merge operator to memtable
       bool mem_res = mem->Add(sequence_, kTypeMerge, key, value);
@@ -1830,6 +1852,35 @@ Status WriteBatchInternal::Append(WriteBatch* dst, const WriteBatch* src,
   return Status::OK();
 }
 
+void WriteBatchInternal::AppendWALParts(WriteBatch* dst, const WriteBatch* src,
+                                        autovector<Slice>* parts) {
+  size_t src_len;
+  int src_count;
+  uint32_t src_flags;
+
+  const SavePoint& batch_end = src->GetWalTerminationPoint();
+
+  if (!batch_end.is_cleared()) {
+    src_len = batch_end.size - WriteBatchInternal::kHeader;
+    src_count = batch_end.count;
+    src_flags = batch_end.content_flags;
+  } else {
+    src_len = src->rep_.size() - WriteBatchInternal::kHeader;
+    src_count = Count(src);
+    src_flags = src->content_flags_.load(std::memory_order_relaxed);
+  }
+
+  SetCount(dst, Count(dst) + src_count);
+  assert(src->rep_.size() >= WriteBatchInternal::kHeader);
+  if (src_len > 0) {
+    parts->emplace_back(src->rep_.data() + WriteBatchInternal::kHeader,
+                        src_len);
+  }
+  dst->content_flags_.store(
+      dst->content_flags_.load(std::memory_order_relaxed) | src_flags,
+      std::memory_order_relaxed);
+}
+
 size_t WriteBatchInternal::AppendedByteSize(size_t leftByteSize,
                                             size_t rightByteSize) {
   if (leftByteSize == 0 || rightByteSize == 0) {
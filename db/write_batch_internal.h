@@ -182,6 +182,12 @@ class WriteBatchInternal {
   static Status Append(WriteBatch* dst, const WriteBatch* src,
                        const bool WAL_only = false);
 
+  // Like Append(dst, src, /*WAL_only*/ true), but only updates the count and
+  // content flags of dst and pushes the WAL part of src's body to parts
+  // instead of copying it. The data of src must outlive parts.
+  static void AppendWALParts(WriteBatch* dst, const WriteBatch* src,
+                             autovector<Slice>* parts);
+
   // Returns the byte size of appending a WriteBatch with ByteSize
   // leftByteSize and a WriteBatch with ByteSize rightByteSize
   static size_t AppendedByteSize(size_t leftByteSize, size_t rightByteSize);
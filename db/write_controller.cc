@@ -29,6 +29,18 @@ std::unique_ptr<WriteControllerToken> WriteController::GetDelayToken(
   return std::unique_ptr<WriteControllerToken>(new DelayWriteToken(this));
 }
 
+std::unique_ptr<WriteControllerToken> WriteController::GetSmoothDelayToken(
+    uint64_t write_rate) {
+  if (total_delayed_++ == 0) {
+    last_refill_time_ = 0;
+    bytes_left_ = 0;
+  }
+  smooth_delay_rates_.insert(write_rate);
+  set_delayed_write_rate(*smooth_delay_rates_.begin());
+  return std::unique_ptr<WriteControllerToken>(
+      new SmoothDelayWriteToken(this, write_rate));
+}
+
 std::unique_ptr<WriteControllerToken>
 WriteController::GetCompactionPressureToken() {
   ++total_compaction_pressure_;
@@ -122,6 +134,16 @@ DelayWriteToken::~DelayWriteToken() {
   assert(controller_->total_delayed_.load() >= 0);
 }
 
+SmoothDelayWriteToken::~SmoothDelayWriteToken() {
+  auto& rates = controller_->smooth_delay_rates_;
+  auto iter = rates.find(write_rate_);
+  assert(iter != rates.end());
+  rates.erase(iter);
+  if (!rates.empty()) {
+    controller_->set_delayed_write_rate(*rates.begin());
+  }
+}
+
 CompactionPressureToken::~CompactionPressureToken() {
   controller_->total_compaction_pressure_--;
   assert(controller_->total_compaction_pressure_ >= 0);
@@ -9,6 +9,7 @@
 
 #include <atomic>
 #include <memory>
+#include <set>
 
 #include "rocksdb/rate_limiter.h"
 #include "rocksdb/terark_namespace.h"
@@ -46,6 +47,12 @@ class WriteController {
   // which returns number of microseconds to sleep.
   std::unique_ptr<WriteControllerToken> GetDelayToken(
       uint64_t delayed_write_rate);
+  // Like GetDelayToken(), but the token keeps its own write rate and writes
+  // are metered at the lowest rate among the live smooth delay tokens. The
+  // refill state is only reset when writes start being delayed, so swapping
+  // tokens changes the rate without a burst or a pause.
+  std::unique_ptr<WriteControllerToken> GetSmoothDelayToken(
+      uint64_t delayed_write_rate);
   // When an actor (column family) requests a moderate token, compaction
   // threads will be increased
   std::unique_ptr<WriteControllerToken> GetCompactionPressureToken();
@@ -92,6 +99,7 @@ class WriteController {
   friend class WriteControllerToken;
   friend class StopWriteToken;
   friend class DelayWriteToken;
+  friend class SmoothDelayWriteToken;
   friend class CompactionPressureToken;
 
   std::atomic<int> total_stopped_;
@@ -103,6 +111,8 @@ class WriteController {
   uint64_t max_delayed_write_rate_;
   // current write rate
   uint64_t delayed_write_rate_;
+  // rates asked for by the live smooth delay tokens
+  std::multiset<uint64_t> smooth_delay_rates_;
 
   std::unique_ptr<RateLimiter> low_pri_rate_limiter_;
 };
@@ -136,6 +146,16 @@ class DelayWriteToken : public WriteControllerToken {
   virtual ~DelayWriteToken();
 };
 
+class SmoothDelayWriteToken : public DelayWriteToken {
+ public:
+  SmoothDelayWriteToken(WriteController* controller, uint64_t write_rate)
+      : DelayWriteToken(controller), write_rate_(write_rate) {}
+  virtual ~SmoothDelayWriteToken();
+
+ private:
+  uint64_t write_rate_;
+};
+
 class CompactionPressureToken : public WriteControllerToken {
  public:
   explicit CompactionPressureToken(WriteController* controller)
@@ -128,6 +128,31 @@ TEST_F(WriteControllerTest, SanityTest) {
   ASSERT_FALSE(controller.IsStopped());
 }
 
+TEST_F(WriteControllerTest, SmoothDelayTokenTest) {
+  WriteController controller(10000000u);
+  TimeSetEnv env;
+
+  auto token_1 = controller.GetSmoothDelayToken(10000000u);
+  ASSERT_EQ(10000000u, controller.delayed_write_rate());
+  ASSERT_EQ(static_cast<uint64_t>(2000000),
+            controller.GetDelay(&env, 20000000u));
+
+  // The slowest token wins, but the sleep debt is kept.
+  auto token_2 = controller.GetSmoothDelayToken(5000000u);
+  ASSERT_EQ(5000000u, controller.delayed_write_rate());
+  auto token_3 = controller.GetSmoothDelayToken(8000000u);
+  ASSERT_EQ(5000000u, controller.delayed_write_rate());
+  ASSERT_GT(controller.GetDelay(&env, 1000u), 2000000u);
+
+  token_2.reset();
+  ASSERT_EQ(8000000u, controller.delayed_write_rate());
+  ASSERT_TRUE(controller.NeedsDelay());
+  token_3.reset();
+  ASSERT_EQ(10000000u, controller.delayed_write_rate());
+  token_1.reset();
+  ASSERT_FALSE(controller.NeedsDelay());
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
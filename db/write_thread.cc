@@ -5,11 +5,13 @@
 
 #include "db/write_thread.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
 #include "db/column_family.h"
 #include "monitoring/perf_context_imp.h"
+#include "monitoring/usdt.h"
 #include "port/port.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/random.h"
@@ -22,6 +24,10 @@ WriteThread::WriteThread(const ImmutableDBOptions& db_options)
                           ? db_options.write_thread_max_yield_usec
                           : 0),
       slow_yield_usec_(db_options.write_thread_slow_yield_usec),
+      max_write_batch_group_size_bytes_(
+          db_options.max_write_batch_group_size_bytes),
+      max_group_commit_delay_nanos_(
+          db_options.max_write_group_commit_delay_usec * 1000),
       allow_concurrent_memtable_write_(
           db_options.allow_concurrent_memtable_write),
       enable_pipelined_write_(db_options.enable_pipelined_write),
@@ -30,7 +36,16 @@ WriteThread::WriteThread(const ImmutableDBOptions& db_options)
       last_sequence_(0),
       write_stall_dummy_(),
       stall_mu_(),
-      stall_cv_(&stall_mu_) {}
+      stall_cv_(&stall_mu_),
+      last_arrival_nanos_(0),
+      arrival_interval_nanos_(2 * max_group_commit_delay_nanos_) {}
+
+static uint64_t SteadyNowNanos() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
 
 uint8_t WriteThread::BlockingAwaitState(Writer* w, uint8_t goal_mask) {
   // We're going to block.  Lazily create the mutex.  We guarantee
@@ -363,6 +378,48 @@ void WriteThread::EndWriteStall() {
   stall_cv_.SignalAll();
 }
 
+void WriteThread::RecordArrival() {
+  uint64_t now = SteadyNowNanos();
+  uint64_t last = last_arrival_nanos_.exchange(now, std::memory_order_relaxed);
+  if (last == 0 || now <= last) {
+    return;
+  }
+  // An interval longer than twice the window predicts nothing useful, so cap
+  // the sample to let the average recover quickly after an idle period.
+  uint64_t interval = std::min(now - last, 2 * max_group_commit_delay_nanos_);
+  // Exponential moving average with weight 1/8 for the new sample
+  auto v = arrival_interval_nanos_.load(std::memory_order_relaxed);
+  v = v - v / 8 + interval / 8;
+  arrival_interval_nanos_.store(v, std::memory_order_relaxed);
+}
+
+void WriteThread::AwaitGroupCommit(Writer* leader) {
+  if (max_group_commit_delay_nanos_ == 0 || !leader->sync ||
+      leader->disable_wal) {
+    return;
+  }
+  uint64_t interval = arrival_interval_nanos_.load(std::memory_order_relaxed);
+  if (interval >= max_group_commit_delay_nanos_) {
+    // The next writer is not expected within the window
+    return;
+  }
+  PERF_TIMER_GUARD(write_thread_wait_nanos);
+  TEST_SYNC_POINT_CALLBACK("WriteThread::AwaitGroupCommit:Wait", leader);
+  uint64_t deadline = SteadyNowNanos() + max_group_commit_delay_nanos_;
+  while (true) {
+    std::this_thread::yield();
+    uint64_t now = SteadyNowNanos();
+    if (now >= deadline) {
+      break;
+    }
+    uint64_t last = last_arrival_nanos_.load(std::memory_order_relaxed);
+    if (now > last && now - last > 2 * interval) {
+      // Arrivals paused, waiting longer is unlikely to grow the group
+      break;
+    }
+  }
+}
+
 static WriteThread::AdaptationContext jbg_ctx("JoinBatchGroup");
 void WriteThread::JoinBatchGroup(Writer* w) {
   TEST_SYNC_POINT_CALLBACK("WriteThread::JoinBatchGroup:Start", w);
@@ -370,6 +427,10 @@ void WriteThread::JoinBatchGroup(Writer* w) {
 
   bool linked_as_leader = LinkOne(w, &newest_writer_);
 
+  if (max_group_commit_delay_nanos_ > 0) {
+    RecordArrival();
+  }
+
   if (linked_as_leader) {
     SetState(w, STATE_GROUP_LEADER);
   }
@@ -405,14 +466,17 @@ size_t WriteThread::EnterAsBatchGroupLeader(Writer* leader,
   assert(leader->batch != nullptr);
   assert(write_group != nullptr);
 
+  AwaitGroupCommit(leader);
+
   size_t size = WriteBatchInternal::ByteSize(leader->batch);
 
   // Allow the group to grow up to a maximum size, but if the
   // original write is small, limit the growth so we do not slow
   // down the small write too much.
-  size_t max_size = 1 << 20;
-  if (size <= (128 << 10)) {
-    max_size = size + (128 << 10);
+  size_t max_size = max_write_batch_group_size_bytes_;
+  const uint64_t min_batch_size_bytes = max_write_batch_group_size_bytes_ / 8;
+  if (size <= min_batch_size_bytes) {
+    max_size = size + min_batch_size_bytes;
   }
 
   leader->write_group = write_group;
@@ -474,6 +538,7 @@ size_t WriteThread::EnterAsBatchGroupLeader(Writer* leader,
     write_group->size++;
   }
   TEST_SYNC_POINT_CALLBACK("WriteThread::EnterAsBatchGroupLeader:End", w);
+  TERARKDB_PROBE2(write_group_leader, write_group->size, size);
   return size;
 }
 
@@ -489,9 +554,10 @@ void WriteThread::EnterAsMemTableWriter(Writer* leader,
   // Allow the group to grow up to a maximum size, but if the
   // original write is small, limit the growth so we do not slow
   // down the small write too much.
-  size_t max_size = 1 << 20;
-  if (size <= (128 << 10)) {
-    max_size = size + (128 << 10);
+  size_t max_size = max_write_batch_group_size_bytes_;
+  const uint64_t min_batch_size_bytes = max_write_batch_group_size_bytes_ / 8;
+  if (size <= min_batch_size_bytes) {
+    max_size = size + min_batch_size_bytes;
   }
 
   leader->write_group = write_group;
@@ -356,6 +356,12 @@ class WriteThread {
   const uint64_t max_yield_usec_;
   const uint64_t slow_yield_usec_;
 
+  // Upper bound of the bytes a write group may cover
+  const uint64_t max_write_batch_group_size_bytes_;
+
+  // See AwaitGroupCommit. Zero disables the group commit window.
+  const uint64_t max_group_commit_delay_nanos_;
+
   // Allow multiple writers write to memtable concurrently.
   const bool allow_concurrent_memtable_write_;
 
@@ -385,6 +391,22 @@ class WriteThread {
   port::Mutex stall_mu_;
   port::CondVar stall_cv_;
 
+  // Arrival time of the newest writer in JoinBatchGroup, and the exponential
+  // moving average of the interval between arrivals.  Only maintained when
+  // the group commit window is enabled.  Updates are racy on purpose, a lost
+  // sample does not matter for a prediction.
+  std::atomic<uint64_t> last_arrival_nanos_;
+  std::atomic<uint64_t> arrival_interval_nanos_;
+
+  // Feeds the arrival of a writer into the arrival rate estimate.
+  void RecordArrival();
+
+  // Called by a leader before it forms its group.  If the leader is a sync
+  // write and the arrival rate predicts that more writers join within
+  // max_group_commit_delay_nanos_, yields until the arrivals pause or the
+  // window ends, so that one WAL sync covers more writes.
+  void AwaitGroupCommit(Writer* leader);
+
   // Waits for w->state & goal_mask using w->StateMutex().  Returns
   // the state that satisfies goal_mask.
   uint8_t BlockingAwaitState(Writer* w, uint8_t goal_mask);
@@ -370,6 +370,7 @@ void AssignEnvOptions(EnvOptions* env_options, const DBOptions& options) {
   env_options->writable_file_max_buffer_size =
       options.writable_file_max_buffer_size;
   env_options->allow_fallocate = options.allow_fallocate;
+  env_options->use_async_writes = options.use_async_file_writes;
 }
 
 }  // namespace
@@ -380,6 +381,8 @@ EnvOptions Env::OptimizeForLogWrite(const EnvOptions& env_options,
   optimized_env_options.bytes_per_sync = db_options.wal_bytes_per_sync;
   optimized_env_options.writable_file_max_buffer_size =
       db_options.writable_file_max_buffer_size;
+  // Every log record is flushed right away, nothing would overlap
+  optimized_env_options.use_async_writes = false;
   return optimized_env_options;
 }
 
@@ -9,12 +9,24 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
+#include "port/port.h"
 #include "util/aligned_buffer.h"
 #include "util/coding.h"
+#include "util/parallel_for.h"
 #include "util/random.h"
 
+// The AES kernels need a compiler that knows the aes and vaes targets
+#if defined(__GNUC__) && defined(__x86_64__) &&      \
+    ((defined(__clang__) && __clang_major__ >= 6) || \
+     (!defined(__clang__) && __GNUC__ >= 8))
+#define ROCKSDB_AESNI
+#include <immintrin.h>
+#endif
+
 #endif
 
 #include "rocksdb/terark_namespace.h"
@@ -945,6 +957,398 @@ Status CTREncryptionProvider::CreateCipherStreamFromPrefix(
   return Status::OK();
 }
 
+#ifdef ROCKSDB_AESNI
+namespace {
+
+const size_t kAESBlockSize = 16;
+const int kAESMaxRounds = 14;
+
+// Encrypts the counter blocks ctr .. ctr + n - 1, whose upper 8 bytes are
+// iv_hi, and xors them into data. keys are the rounds + 1 round keys.
+typedef void (*AESCTRKernel)(const char* keys, int rounds, uint64_t ctr,
+                             uint64_t iv_hi, char* data, size_t n);
+
+__attribute__((target("aes,sse2"))) void AESCTRXor(const char* keys,
+                                                    int rounds, uint64_t ctr,
+                                                    uint64_t iv_hi, char* data,
+                                                    size_t n) {
+  __m128i rk[kAESMaxRounds + 1];
+  for (int r = 0; r <= rounds; ++r) {
+    rk[r] = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(keys + r * kAESBlockSize));
+  }
+  size_t i = 0;
+  // 8 independent blocks hide the latency of aesenc
+  for (; i + 8 <= n; i += 8) {
+    __m128i b[8];
+    for (int j = 0; j < 8; ++j) {
+      b[j] = _mm_xor_si128(
+          _mm_set_epi64x(static_cast<int64_t>(iv_hi),
+                         static_cast<int64_t>(ctr + i + j)),
+          rk[0]);
+    }
+    for (int r = 1; r < rounds; ++r) {
+      for (int j = 0; j < 8; ++j) {
+        b[j] = _mm_aesenc_si128(b[j], rk[r]);
+      }
+    }
+    for (int j = 0; j < 8; ++j) {
+      __m128i* p = reinterpret_cast<__m128i*>(data + (i + j) * kAESBlockSize);
+      b[j] = _mm_aesenclast_si128(b[j], rk[rounds]);
+      _mm_storeu_si128(p, _mm_xor_si128(b[j], _mm_loadu_si128(p)));
+    }
+  }
+  for (; i < n; ++i) {
+    __m128i b = _mm_xor_si128(_mm_set_epi64x(static_cast<int64_t>(iv_hi),
+                                             static_cast<int64_t>(ctr + i)),
+                              rk[0]);
+    for (int r = 1; r < rounds; ++r) {
+      b = _mm_aesenc_si128(b, rk[r]);
+    }
+    b = _mm_aesenclast_si128(b, rk[rounds]);
+    __m128i* p = reinterpret_cast<__m128i*>(data + i * kAESBlockSize);
+    _mm_storeu_si128(p, _mm_xor_si128(b, _mm_loadu_si128(p)));
+  }
+}
+
+__attribute__((target("avx512f,vaes"))) void AESCTRXorVAES(
+    const char* keys, int rounds, uint64_t ctr, uint64_t iv_hi, char* data,
+    size_t n) {
+  __m512i rk[kAESMaxRounds + 1];
+  for (int r = 0; r <= rounds; ++r) {
+    const char* k = keys + r * kAESBlockSize;
+    int64_t lo, hi;
+    memcpy(&lo, k, sizeof(lo));
+    memcpy(&hi, k + sizeof(lo), sizeof(hi));
+    rk[r] = _mm512_set_epi64(hi, lo, hi, lo, hi, lo, hi, lo);
+  }
+  const __m512i iv = _mm512_set1_epi64(static_cast<int64_t>(iv_hi));
+  // The counters of the 4 blocks of a register are in the even lanes
+  const __m512i inc = _mm512_set_epi64(0, 3, 0, 2, 0, 1, 0, 0);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i b[4];
+    for (int j = 0; j < 4; ++j) {
+      __m512i c = _mm512_add_epi64(
+          _mm512_set1_epi64(static_cast<int64_t>(ctr + i + j * 4)), inc);
+      b[j] = _mm512_xor_si512(_mm512_mask_blend_epi64(0xAA, c, iv), rk[0]);
+    }
+    for (int r = 1; r < rounds; ++r) {
+      for (int j = 0; j < 4; ++j) {
+        b[j] = _mm512_aesenc_epi128(b[j], rk[r]);
+      }
+    }
+    for (int j = 0; j < 4; ++j) {
+      char* p = data + (i + j * 4) * kAESBlockSize;
+      b[j] = _mm512_aesenclast_epi128(b[j], rk[rounds]);
+      _mm512_storeu_si512(p, _mm512_xor_si512(b[j], _mm512_loadu_si512(p)));
+    }
+  }
+  if (i < n) {
+    AESCTRXor(keys, rounds, ctr + i, iv_hi, data + i * kAESBlockSize, n - i);
+  }
+}
+
+bool HasAESNI() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes");
+}
+
+AESCTRKernel ChooseAESCTRKernel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("vaes")) {
+    return AESCTRXorVAES;
+  }
+  return AESCTRXor;
+}
+
+static const AESCTRKernel kAESCTRKernel = ChooseAESCTRKernel();
+
+#define AES_EXPAND_KEY128(prev, rcon)                                       \
+  ExpandKey(prev, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prev, rcon), \
+                                    0xff))
+
+class AESBlockCipher : public BlockCipher {
+ public:
+  explicit AESBlockCipher(const Slice& key) {
+    if (key.size() == 16) {
+      ExpandKey128(key.data());
+    } else {
+      ExpandKey256(key.data());
+    }
+  }
+
+  size_t BlockSize() override { return kAESBlockSize; }
+
+  __attribute__((target("aes,sse2"))) Status Encrypt(char* data) override {
+    __m128i b = _mm_xor_si128(Load(data), Load(enc_keys_));
+    for (int r = 1; r < rounds_; ++r) {
+      b = _mm_aesenc_si128(b, Load(enc_keys_ + r * kAESBlockSize));
+    }
+    b = _mm_aesenclast_si128(b, Load(enc_keys_ + rounds_ * kAESBlockSize));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), b);
+    return Status::OK();
+  }
+
+  __attribute__((target("aes,sse2"))) Status Decrypt(char* data) override {
+    __m128i b = _mm_xor_si128(Load(data), Load(dec_keys_));
+    for (int r = 1; r < rounds_; ++r) {
+      b = _mm_aesdec_si128(b, Load(dec_keys_ + r * kAESBlockSize));
+    }
+    b = _mm_aesdeclast_si128(b, Load(dec_keys_ + rounds_ * kAESBlockSize));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), b);
+    return Status::OK();
+  }
+
+  // Encrypts the counter blocks of a CTRCipherStream and xors them into
+  // data, n blocks from the block whose counter is ctr
+  void CTRXor(uint64_t ctr, uint64_t iv_hi, char* data, size_t n) const {
+    kAESCTRKernel(enc_keys_, rounds_, ctr, iv_hi, data, n);
+  }
+
+ private:
+  __attribute__((target("sse2"))) static __m128i Load(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+
+  __attribute__((target("sse2"))) static __m128i ExpandKey(__m128i key,
+                                                          __m128i t) {
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, t);
+  }
+
+  __attribute__((target("aes,sse2"))) void ExpandKey128(const char* key) {
+    rounds_ = 10;
+    __m128i k[11];
+    k[0] = Load(key);
+    k[1] = AES_EXPAND_KEY128(k[0], 0x01);
+    k[2] = AES_EXPAND_KEY128(k[1], 0x02);
+    k[3] = AES_EXPAND_KEY128(k[2], 0x04);
+    k[4] = AES_EXPAND_KEY128(k[3], 0x08);
+    k[5] = AES_EXPAND_KEY128(k[4], 0x10);
+    k[6] = AES_EXPAND_KEY128(k[5], 0x20);
+    k[7] = AES_EXPAND_KEY128(k[6], 0x40);
+    k[8] = AES_EXPAND_KEY128(k[7], 0x80);
+    k[9] = AES_EXPAND_KEY128(k[8], 0x1b);
+    k[10] = AES_EXPAND_KEY128(k[9], 0x36);
+    StoreKeys(k);
+  }
+
+  __attribute__((target("aes,sse2"))) void ExpandKey256(const char* key) {
+    rounds_ = 14;
+    __m128i k[15];
+    k[0] = Load(key);
+    k[1] = Load(key + kAESBlockSize);
+#define AES_EXPAND_KEY256(i, rcon)                                          \
+  k[i] = ExpandKey(                                                         \
+      k[i - 2],                                                             \
+      _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k[i - 1], rcon), 0xff));  \
+  if (i + 1 < 15) {                                                         \
+    k[i + 1] = ExpandKey(                                                   \
+        k[i - 1],                                                           \
+        _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k[i], 0), 0xaa));       \
+  }
+    // A round key derives from the two before it
+    AES_EXPAND_KEY256(2, 0x01);
+    AES_EXPAND_KEY256(4, 0x02);
+    AES_EXPAND_KEY256(6, 0x04);
+    AES_EXPAND_KEY256(8, 0x08);
+    AES_EXPAND_KEY256(10, 0x10);
+    AES_EXPAND_KEY256(12, 0x20);
+    AES_EXPAND_KEY256(14, 0x40);
+#undef AES_EXPAND_KEY256
+    StoreKeys(k);
+  }
+
+  // The decryption keys are the encryption ones in reverse order, through
+  // InvMixColumns but the first and the last
+  __attribute__((target("aes,sse2"))) void StoreKeys(const __m128i* k) {
+    for (int r = 0; r <= rounds_; ++r) {
+      __m128i d = k[rounds_ - r];
+      if (r != 0 && r != rounds_) {
+        d = _mm_aesimc_si128(d);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(enc_keys_ + r * 16), k[r]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dec_keys_ + r * 16), d);
+    }
+  }
+
+  int rounds_;
+  char enc_keys_[(kAESMaxRounds + 1) * kAESBlockSize];
+  char dec_keys_[(kAESMaxRounds + 1) * kAESBlockSize];
+};
+
+#undef AES_EXPAND_KEY128
+
+// Buffers from this size are encrypted by several threads
+const size_t kAESParallelMinSize = 1 << 20;
+const size_t kAESMaxThreads = 4;
+
+// Helps the writer threads encrypt big buffers. Never destroyed, a file may
+// be written until exit
+ThreadPool* AESParallelPool() {
+  static ThreadPool* pool =
+      NewThreadPool(static_cast<int>(kAESMaxThreads - 1));
+  return pool;
+}
+
+// Same keystream as a CTRCipherStream over the AES cipher, whole buffers
+// are encrypted at once
+class AESCTRCipherStream final : public BlockAccessCipherStream {
+ public:
+  AESCTRCipherStream(const AESBlockCipher& cipher, const char* iv,
+                     uint64_t initialCounter)
+      : cipher_(cipher),
+        iv_hi_(DecodeFixed64(iv + 8)),
+        initialCounter_(initialCounter) {}
+
+  size_t BlockSize() override { return kAESBlockSize; }
+
+  Status Encrypt(uint64_t fileOffset, char* data, size_t dataSize) override {
+    size_t num_threads =
+        std::min<size_t>(dataSize / (kAESParallelMinSize / 2), kAESMaxThreads);
+    if (dataSize < kAESParallelMinSize || num_threads < 2) {
+      Xor(fileOffset, data, dataSize);
+      return Status::OK();
+    }
+    size_t chunk =
+        (dataSize / num_threads + kAESBlockSize - 1) & ~(kAESBlockSize - 1);
+    ParallelForInPool(AESParallelPool(), (dataSize + chunk - 1) / chunk,
+                      [&](size_t i) {
+                        size_t begin = i * chunk;
+                        Xor(fileOffset + begin, data + begin,
+                            std::min(chunk, dataSize - begin));
+                      });
+    return Status::OK();
+  }
+
+  // For CTR decryption & encryption are the same
+  Status Decrypt(uint64_t fileOffset, char* data, size_t dataSize) override {
+    return Encrypt(fileOffset, data, dataSize);
+  }
+
+ protected:
+  void AllocateScratch(std::string& scratch) override {
+    scratch.reserve(kAESBlockSize);
+  }
+
+  Status EncryptBlock(uint64_t blockIndex, char* data,
+                      char* /*scratch*/) override {
+    cipher_.CTRXor(blockIndex + initialCounter_, iv_hi_, data, 1);
+    return Status::OK();
+  }
+
+  Status DecryptBlock(uint64_t blockIndex, char* data,
+                      char* scratch) override {
+    return EncryptBlock(blockIndex, data, scratch);
+  }
+
+ private:
+  void Xor(uint64_t fileOffset, char* data, size_t dataSize) const {
+    uint64_t blockIndex = fileOffset / kAESBlockSize;
+    size_t blockOffset = fileOffset % kAESBlockSize;
+    if (blockOffset != 0 || dataSize < kAESBlockSize) {
+      // The partial first block
+      char block[kAESBlockSize] = {0};
+      size_t n = std::min(dataSize, kAESBlockSize - blockOffset);
+      memcpy(block + blockOffset, data, n);
+      cipher_.CTRXor(blockIndex + initialCounter_, iv_hi_, block, 1);
+      memcpy(data, block + blockOffset, n);
+      data += n;
+      dataSize -= n;
+      ++blockIndex;
+    }
+    size_t numBlocks = dataSize / kAESBlockSize;
+    if (numBlocks > 0) {
+      cipher_.CTRXor(blockIndex + initialCounter_, iv_hi_, data, numBlocks);
+      data += numBlocks * kAESBlockSize;
+      dataSize -= numBlocks * kAESBlockSize;
+      blockIndex += numBlocks;
+    }
+    if (dataSize > 0) {
+      // The partial last block
+      char block[kAESBlockSize] = {0};
+      memcpy(block, data, dataSize);
+      cipher_.CTRXor(blockIndex + initialCounter_, iv_hi_, block, 1);
+      memcpy(data, block, dataSize);
+    }
+  }
+
+  const AESBlockCipher& cipher_;
+  const uint64_t iv_hi_;
+  const uint64_t initialCounter_;
+};
+
+// Holds the cipher for the CTREncryptionProvider base, which is constructed
+// after it
+struct AESBlockCipherHolder {
+  explicit AESBlockCipherHolder(const Slice& key) : aes_cipher_(key) {}
+  AESBlockCipher aes_cipher_;
+};
+
+class AESCTREncryptionProvider : private AESBlockCipherHolder,
+                                 public CTREncryptionProvider {
+ public:
+  explicit AESCTREncryptionProvider(const Slice& key)
+      : AESBlockCipherHolder(key), CTREncryptionProvider(aes_cipher_) {}
+
+ protected:
+  Status CreateCipherStreamFromPrefix(
+      const std::string& /*fname*/, const EnvOptions& /*options*/,
+      uint64_t initialCounter, const Slice& iv, const Slice& /*prefix*/,
+      std::unique_ptr<BlockAccessCipherStream>* result) override {
+    result->reset(
+        new AESCTRCipherStream(aes_cipher_, iv.data(), initialCounter));
+    return Status::OK();
+  }
+};
+
+}  // namespace
+#endif  // ROCKSDB_AESNI
+
+static Status CheckAESKey(const Slice& key) {
+#ifdef ROCKSDB_AESNI
+  if (!HasAESNI()) {
+    return Status::NotSupported("The CPU does not have AES-NI");
+  }
+  if (key.size() != 16 && key.size() != 32) {
+    return Status::InvalidArgument("AES key must be 16 or 32 bytes");
+  }
+  return Status::OK();
+#else
+  (void)key;
+  return Status::NotSupported("Not compiled with AES-NI");
+#endif
+}
+
+Status NewAESBlockCipher(const Slice& key,
+                         std::unique_ptr<BlockCipher>* result) {
+  Status s = CheckAESKey(key);
+#ifdef ROCKSDB_AESNI
+  if (s.ok()) {
+    result->reset(new AESBlockCipher(key));
+  }
+#else
+  (void)result;
+#endif
+  return s;
+}
+
+Status NewAESCTREncryptionProvider(
+    const Slice& key, std::unique_ptr<EncryptionProvider>* result) {
+  Status s = CheckAESKey(key);
+#ifdef ROCKSDB_AESNI
+  if (s.ok()) {
+    result->reset(new AESCTREncryptionProvider(key));
+  }
+#else
+  (void)result;
+#endif
+  return s;
+}
+
 #endif  // ROCKSDB_LITE
 
 }  // namespace TERARKDB_NAMESPACE
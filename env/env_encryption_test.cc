@@ -0,0 +1,148 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include <memory>
+#include <string>
+
+#include "rocksdb/env.h"
+#include "rocksdb/env_encryption.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+std::string FromHex(const std::string& hex) {
+  std::string bytes;
+  for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+    bytes.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), 0, 16)));
+  }
+  return bytes;
+}
+}  // namespace
+
+class EnvEncryptionTest : public testing::Test {};
+
+TEST_F(EnvEncryptionTest, AESBlockCipher) {
+  std::unique_ptr<BlockCipher> cipher;
+  Status s = NewAESBlockCipher(FromHex("000102030405060708090a0b0c0d0e0f"),
+                               &cipher);
+  if (s.IsNotSupported()) {
+    return;
+  }
+  ASSERT_OK(s);
+  ASSERT_EQ(16U, cipher->BlockSize());
+  // FIPS-197 appendix C
+  std::string plain = FromHex("00112233445566778899aabbccddeeff");
+  std::string data = plain;
+  ASSERT_OK(cipher->Encrypt(&data[0]));
+  ASSERT_EQ(FromHex("69c4e0d86a7b0430d8cdb78070b4c55a"), data);
+  ASSERT_OK(cipher->Decrypt(&data[0]));
+  ASSERT_EQ(plain, data);
+
+  ASSERT_OK(NewAESBlockCipher(
+      FromHex("000102030405060708090a0b0c0d0e0f"
+              "101112131415161718191a1b1c1d1e1f"),
+      &cipher));
+  ASSERT_OK(cipher->Encrypt(&data[0]));
+  ASSERT_EQ(FromHex("8ea2b7ca516745bfeafc49904b496089"), data);
+  ASSERT_OK(cipher->Decrypt(&data[0]));
+  ASSERT_EQ(plain, data);
+
+  ASSERT_TRUE(NewAESBlockCipher("short", &cipher).IsInvalidArgument());
+}
+
+TEST_F(EnvEncryptionTest, AESCTRSameAsGenericCTR) {
+  std::string key = FromHex("603deb1015ca71be2b73aef0857d7781"
+                            "1f352c073b6108d72d9810a30914dff4");
+  std::unique_ptr<BlockCipher> cipher;
+  std::unique_ptr<EncryptionProvider> provider;
+  Status s = NewAESCTREncryptionProvider(key, &provider);
+  if (s.IsNotSupported()) {
+    return;
+  }
+  ASSERT_OK(s);
+  ASSERT_OK(NewAESBlockCipher(key, &cipher));
+  CTREncryptionProvider generic(*cipher);
+
+  // A prefix made by one provider is read by the other
+  std::string prefix(provider->GetPrefixLength(), '\0');
+  ASSERT_OK(provider->CreateNewPrefix("f", &prefix[0], prefix.size()));
+  std::string prefix_copy = prefix;
+  Slice prefix_slice(prefix), prefix_copy_slice(prefix_copy);
+  std::unique_ptr<BlockAccessCipherStream> fast, slow;
+  ASSERT_OK(
+      provider->CreateCipherStream("f", EnvOptions(), prefix_slice, &fast));
+  ASSERT_OK(generic.CreateCipherStream("f", EnvOptions(), prefix_copy_slice,
+                                       &slow));
+
+  Random rnd(301);
+  std::string plain(3 << 20, '\0');
+  for (auto& c : plain) {
+    c = static_cast<char>(rnd.Uniform(256));
+  }
+  // Partial blocks at both ends, several kernel widths, and the threaded
+  // path for the large buffers
+  const size_t offsets[] = {0, 1, 15, 16, 4097};
+  const size_t sizes[] = {1, 15, 16, 17, 255, 256, 1000, (2 << 20) + 7};
+  for (size_t offset : offsets) {
+    for (size_t size : sizes) {
+      std::string a = plain.substr(0, size);
+      std::string b = a;
+      ASSERT_OK(fast->Encrypt(offset, &a[0], a.size()));
+      ASSERT_OK(slow->Encrypt(offset, &b[0], b.size()));
+      ASSERT_TRUE(a == b) << "offset " << offset << " size " << size;
+      ASSERT_NE(plain.substr(0, size), a);
+      ASSERT_OK(fast->Decrypt(offset, &a[0], a.size()));
+      ASSERT_EQ(plain.substr(0, size), a);
+    }
+  }
+}
+
+TEST_F(EnvEncryptionTest, AESCTREncryptedEnv) {
+  std::unique_ptr<EncryptionProvider> provider;
+  Status s = NewAESCTREncryptionProvider(std::string(16, 'k'), &provider);
+  if (s.IsNotSupported()) {
+    return;
+  }
+  ASSERT_OK(s);
+  std::unique_ptr<Env> mem_env(NewMemEnv(Env::Default()));
+  std::unique_ptr<Env> env(NewEncryptedEnv(mem_env.get(), provider.get()));
+
+  Random rnd(301);
+  std::string data(1 << 20, '\0');
+  for (auto& c : data) {
+    c = static_cast<char>(rnd.Uniform(256));
+  }
+  ASSERT_OK(WriteStringToFile(env.get(), data, "/f"));
+  std::string raw;
+  ASSERT_OK(ReadFileToString(mem_env.get(), "/f", &raw));
+  ASSERT_EQ(data.size() + provider->GetPrefixLength(), raw.size());
+  ASSERT_EQ(std::string::npos, raw.find(data.substr(0, 64)));
+
+  std::string read;
+  ASSERT_OK(ReadFileToString(env.get(), "/f", &read));
+  ASSERT_EQ(data, read);
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else  // ROCKSDB_LITE
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as EncryptedEnv is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_LITE
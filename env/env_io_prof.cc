@@ -1,6 +1,17 @@
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
 #include <rocksdb/env.h>
 
+#include <atomic>
+
+#include "monitoring/histogram.h"
+#include "monitoring/io_purpose.h"
+#include "rocksdb/statistics.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/filename.h"
 #include "utilities/ioprof/ioprof.h"
 #ifdef BOOSTLIB
 #include <boost/current_function.hpp>
@@ -10,31 +21,172 @@
 
 namespace TERARKDB_NAMESPACE {
 
+namespace {
+enum IOFileKind { kIOFileWal, kIOFileSst, kIOFileManifest, kIOFileOther,
+                  kIOFileKindMax };
+const char* const kIOFileKindNames[kIOFileKindMax] = {"wal", "sst", "manifest",
+                                                      "other"};
+
+enum IOOpType { kIOOpRead, kIOOpWrite, kIOOpSync, kIOOpTypeMax };
+const char* const kIOOpTypeNames[kIOOpTypeMax] = {"read", "write", "sync"};
+const Histograms kIOOpHistograms[kIOOpTypeMax] = {
+    IO_PROF_READ_MICROS, IO_PROF_WRITE_MICROS, IO_PROF_SYNC_MICROS};
+
+IOFileKind GetIOFileKind(const std::string& fname) {
+  uint64_t number;
+  FileType type;
+  if (!ParseFileName(fname.substr(fname.find_last_of('/') + 1), &number,
+                     &type)) {
+    return kIOFileOther;
+  }
+  switch (type) {
+    case kLogFile:
+      return kIOFileWal;
+    case kTableFile:
+      return kIOFileSst;
+    case kDescriptorFile:
+      return kIOFileManifest;
+    default:
+      return kIOFileOther;
+  }
+}
+}  // namespace
+
+// Bytes and latencies of the file operations by file kind, purpose of the
+// calling thread and operation type
+class IOProfStats {
+ public:
+  IOProfStats(Env* env, std::shared_ptr<Statistics> stats)
+      : env_(env), stats_(std::move(stats)) {}
+
+  Env* env() const { return env_; }
+
+  void Record(IOFileKind kind, IOOpType op, uint64_t micros, uint64_t bytes) {
+    Bucket& bucket = buckets_[kind][GetThreadIOPurpose()][op];
+    bucket.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    bucket.latency.Add(micros);
+    if (stats_ != nullptr) {
+      stats_->measureTime(kIOOpHistograms[op], micros);
+    }
+  }
+
+  std::string ToString() const {
+    std::string result;
+    char buf[512];
+    for (int kind = 0; kind < kIOFileKindMax; ++kind) {
+      for (int purpose = 0; purpose < kIOPurposeMax; ++purpose) {
+        for (int op = 0; op < kIOOpTypeMax; ++op) {
+          const Bucket& bucket = buckets_[kind][purpose][op];
+          if (bucket.latency.Empty()) {
+            continue;
+          }
+          snprintf(buf, sizeof(buf),
+                   "%-8s %-10s %-5s count %" PRIu64 " bytes %" PRIu64
+                   " micros avg %.1f P50 %.1f P99 %.1f max %" PRIu64 "\n",
+                   kIOFileKindNames[kind],
+                   IOPurposeName(static_cast<IOPurpose>(purpose)),
+                   kIOOpTypeNames[op], bucket.latency.num(),
+                   bucket.bytes.load(std::memory_order_relaxed),
+                   bucket.latency.Average(), bucket.latency.Median(),
+                   bucket.latency.Percentile(99), bucket.latency.max());
+          result.append(buf);
+        }
+      }
+    }
+    return result;
+  }
+
+ private:
+  struct Bucket {
+    std::atomic<uint64_t> bytes{0};
+    HistogramImpl latency;
+  };
+
+  Env* env_;
+  std::shared_ptr<Statistics> stats_;
+  Bucket buckets_[kIOFileKindMax][kIOPurposeMax][kIOOpTypeMax];
+};
+
+namespace {
+// Times one file operation into IOProfStats
+class IOProfTimer {
+ public:
+  IOProfTimer(IOProfStats* stats, IOFileKind kind, IOOpType op,
+              uint64_t bytes = 0)
+      : stats_(stats),
+        kind_(kind),
+        op_(op),
+        bytes_(bytes),
+        start_(stats->env()->NowMicros()) {}
+  ~IOProfTimer() {
+    stats_->Record(kind_, op_, stats_->env()->NowMicros() - start_, bytes_);
+  }
+
+  void SetBytes(uint64_t bytes) { bytes_ = bytes; }
+
+ private:
+  IOProfStats* stats_;
+  IOFileKind kind_;
+  IOOpType op_;
+  uint64_t bytes_;
+  uint64_t start_;
+};
+}  // namespace
+
 class IOProfSequentialFile : public SequentialFileWrapper {
  public:
-  IOProfSequentialFile(SequentialFile* file) : SequentialFileWrapper(file) {}
+  IOProfSequentialFile(SequentialFile* file, IOProfStats* stats,
+                       IOFileKind kind)
+      : SequentialFileWrapper(file), stats_(stats), kind_(kind) {}
   Status Read(size_t n, Slice* result, char* scratch) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
-    return SequentialFileWrapper::Read(n, result, scratch);
+    IOProfTimer timer(stats_, kind_, kIOOpRead);
+    Status s = SequentialFileWrapper::Read(n, result, scratch);
+    timer.SetBytes(result->size());
+    return s;
   }
 
   Status PositionedRead(uint64_t offset, size_t n, Slice* result,
                         char* scratch) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
-    return SequentialFileWrapper::PositionedRead(offset, n, result, scratch);
+    IOProfTimer timer(stats_, kind_, kIOOpRead);
+    Status s =
+        SequentialFileWrapper::PositionedRead(offset, n, result, scratch);
+    timer.SetBytes(result->size());
+    return s;
   }
+
+ private:
+  IOProfStats* stats_;
+  IOFileKind kind_;
 };
 
 class IOProfRandomAccessFile : public RandomAccessFileWrapper {
  public:
-  IOProfRandomAccessFile(RandomAccessFile* file)
-      : RandomAccessFileWrapper(file) {}
+  IOProfRandomAccessFile(RandomAccessFile* file, IOProfStats* stats,
+                         IOFileKind kind)
+      : RandomAccessFileWrapper(file), stats_(stats), kind_(kind) {}
   Status Read(uint64_t offset, size_t n, Slice* result,
               char* scratch) const override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
-    return RandomAccessFileWrapper::Read(offset, n, result, scratch);
+    IOProfTimer timer(stats_, kind_, kIOOpRead);
+    Status s = RandomAccessFileWrapper::Read(offset, n, result, scratch);
+    timer.SetBytes(result->size());
+    return s;
   };
 
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) override {
+    IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpRead);
+    Status s = RandomAccessFileWrapper::MultiRead(reqs, num_reqs);
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < num_reqs; ++i) {
+      bytes += reqs[i].result.size();
+    }
+    timer.SetBytes(bytes);
+    return s;
+  }
+
   Status Prefetch(uint64_t offset, size_t n) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     return RandomAccessFileWrapper::Prefetch(offset, n);
@@ -43,22 +195,34 @@ class IOProfRandomAccessFile : public RandomAccessFileWrapper {
   Status FsRead(uint64_t offset, size_t len, Slice* result,
                 void* buf) const override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
-    return RandomAccessFileWrapper::FsRead(offset, len, result, buf);
+    IOProfTimer timer(stats_, kind_, kIOOpRead);
+    Status s = RandomAccessFileWrapper::FsRead(offset, len, result, buf);
+    timer.SetBytes(result->size());
+    return s;
   }
+
+ private:
+  IOProfStats* stats_;
+  IOFileKind kind_;
 };
 
 class IOProfRandomRWFile : public RandomRWFileWrapper {
  public:
-  IOProfRandomRWFile(RandomRWFile* file) : RandomRWFileWrapper(file) {}
+  IOProfRandomRWFile(RandomRWFile* file, IOProfStats* stats, IOFileKind kind)
+      : RandomRWFileWrapper(file), stats_(stats), kind_(kind) {}
   Status Write(uint64_t offset, const Slice& data) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpWrite, data.size());
     return RandomRWFileWrapper::Write(offset, data);
   };
 
   Status Read(uint64_t offset, size_t n, Slice* result,
               char* scratch) const override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
-    return RandomRWFileWrapper::Read(offset, n, result, scratch);
+    IOProfTimer timer(stats_, kind_, kIOOpRead);
+    Status s = RandomRWFileWrapper::Read(offset, n, result, scratch);
+    timer.SetBytes(result->size());
+    return s;
   };
 
   Status Flush() override {
@@ -68,24 +232,33 @@ class IOProfRandomRWFile : public RandomRWFileWrapper {
 
   Status Sync() override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpSync);
     return RandomRWFileWrapper::Sync();
   }
 
   Status Fsync() override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpSync);
     return RandomRWFileWrapper::Fsync();
   }
+
+ private:
+  IOProfStats* stats_;
+  IOFileKind kind_;
 };
 
 class IOProfWritableFile : public WritableFileWrapper {
  public:
-  IOProfWritableFile(WritableFile* file) : WritableFileWrapper(file) {}
+  IOProfWritableFile(WritableFile* file, IOProfStats* stats, IOFileKind kind)
+      : WritableFileWrapper(file), stats_(stats), kind_(kind) {}
   Status Append(const Slice& data) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpWrite, data.size());
     return WritableFileWrapper::Append(data);
   }
   Status PositionedAppend(const Slice& data, uint64_t offset) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpWrite, data.size());
     return WritableFileWrapper::PositionedAppend(data, offset);
   }
   Status Truncate(uint64_t size) override {
@@ -98,14 +271,17 @@ class IOProfWritableFile : public WritableFileWrapper {
   }
   Status Sync() override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpSync);
     return WritableFileWrapper::Sync();
   }
   Status Fsync() override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpSync);
     return WritableFileWrapper::Fsync();
   }
   Status RangeSync(uint64_t offset, uint64_t nbytes) override {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
+    IOProfTimer timer(stats_, kind_, kIOOpSync, nbytes);
     return WritableFileWrapper::RangeSync(offset, nbytes);
   }
   void PrepareWrite(size_t offset, size_t len) override {
@@ -117,11 +293,21 @@ class IOProfWritableFile : public WritableFileWrapper {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     return WritableFileWrapper::Allocate(offset, len);
   }
+
+ private:
+  IOProfStats* stats_;
+  IOFileKind kind_;
 };
 
 class IOProfEnv : public EnvWrapper {
  public:
-  IOProfEnv(Env* base_env) : EnvWrapper(base_env) {}
+  IOProfEnv(Env* base_env, std::shared_ptr<Statistics> stats)
+      : EnvWrapper(base_env), stats_(base_env, std::move(stats)) {}
+
+  Status GetIOProfile(std::string* profile) override {
+    *profile = stats_.ToString();
+    return Status::OK();
+  }
 
   Status NewSequentialFile(const std::string& f,
                            std::unique_ptr<SequentialFile>* r,
@@ -130,7 +316,8 @@ class IOProfEnv : public EnvWrapper {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     Status s = EnvWrapper::NewSequentialFile(f, &rt, options);
     if (s.ok()) {
-      r->reset(new IOProfSequentialFile(rt.release()));
+      r->reset(
+          new IOProfSequentialFile(rt.release(), &stats_, GetIOFileKind(f)));
     }
     return s;
   }
@@ -142,7 +329,8 @@ class IOProfEnv : public EnvWrapper {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     Status s = EnvWrapper::NewRandomAccessFile(f, &rt, options);
     if (s.ok()) {
-      r->reset(new IOProfRandomAccessFile(rt.release()));
+      r->reset(
+          new IOProfRandomAccessFile(rt.release(), &stats_, GetIOFileKind(f)));
     }
     return s;
   }
@@ -153,7 +341,8 @@ class IOProfEnv : public EnvWrapper {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     Status s = EnvWrapper::NewWritableFile(f, &rt, options);
     if (s.ok()) {
-      r->reset(new IOProfWritableFile(rt.release()));
+      r->reset(
+          new IOProfWritableFile(rt.release(), &stats_, GetIOFileKind(f)));
     }
     return s;
   }
@@ -164,7 +353,8 @@ class IOProfEnv : public EnvWrapper {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     Status s = EnvWrapper::NewRandomRWFile(f, &rt, options);
     if (s.ok()) {
-      r->reset(new IOProfRandomRWFile(rt.release()));
+      r->reset(
+          new IOProfRandomRWFile(rt.release(), &stats_, GetIOFileKind(f)));
     }
     return s;
   }
@@ -194,8 +384,13 @@ class IOProfEnv : public EnvWrapper {
     IOProfiler::Scope _scope_(BOOST_CURRENT_FUNCTION);
     return EnvWrapper::DeleteDir(d);
   }
+
+ private:
+  IOProfStats stats_;
 };
 
-Env* NewIOProfEnv(Env* base_env) { return new IOProfEnv(base_env); }
+Env* NewIOProfEnv(Env* base_env, std::shared_ptr<Statistics> stats) {
+  return new IOProfEnv(base_env, std::move(stats));
+}
 
 }  // namespace TERARKDB_NAMESPACE
\ No newline at end of file
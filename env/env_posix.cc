@@ -861,6 +861,16 @@ class PosixEnv : public Env {
 #endif
   }
 
+  virtual uint64_t NowCPUNanos() override {
+#if defined(OS_LINUX) || defined(OS_FREEBSD) || defined(OS_AIX)
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return 0;
+#endif
+  }
+
   virtual void SleepForMicroseconds(int micros) override {
 #ifdef BOOSTLIB
     boost::this_fiber::sleep_for(std::chrono::microseconds(micros));
@@ -38,6 +38,7 @@
 #endif
 
 #include "env/env_chroot.h"
+#include "monitoring/io_purpose.h"
 #include "port/port.h"
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
@@ -1137,6 +1138,97 @@ TEST_P(EnvPosixTestWithParam, InvalidateCache) {
 #endif  // not TRAVIS
 #endif  // OS_LINUX || OS_WIN
 
+TEST_P(EnvPosixTestWithParam, MultiRead) {
+  EnvOptions soptions;
+  std::string fname = test::PerThreadDBPath(env_, "testfile");
+
+  const size_t kSectorSize = 512;
+  const size_t kNumSectors = 8;
+  std::string data;
+  for (size_t i = 0; i < kNumSectors; ++i) {
+    data.append(kSectorSize, static_cast<char>('a' + i));
+  }
+  {
+    std::unique_ptr<WritableFile> wfile;
+    ASSERT_OK(env_->NewWritableFile(fname, &wfile, soptions));
+    ASSERT_OK(wfile->Append(data));
+    ASSERT_OK(wfile->Close());
+  }
+
+  std::atomic<int> advised(0);
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "PosixRandomAccessFile::MultiRead:AfterAdvise",
+      [&](void* /*arg*/) { advised++; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname, &file, soptions));
+  // Out of order, and the last one runs past the end of the file
+  const uint64_t offsets[] = {5 * kSectorSize, 100, 3 * kSectorSize - 7,
+                              kNumSectors * kSectorSize - 10};
+  const size_t kNumReqs = sizeof(offsets) / sizeof(offsets[0]);
+  std::vector<std::string> scratches(kNumReqs, std::string(kSectorSize, 0));
+  std::vector<ReadRequest> reqs(kNumReqs);
+  for (size_t i = 0; i < kNumReqs; ++i) {
+    reqs[i].offset = offsets[i];
+    reqs[i].len = kSectorSize;
+    reqs[i].scratch = &scratches[i][0];
+  }
+  ASSERT_OK(file->MultiRead(reqs.data(), reqs.size()));
+  for (size_t i = 0; i < kNumReqs; ++i) {
+    ASSERT_OK(reqs[i].status);
+    size_t expected_len =
+        std::min(kSectorSize, data.size() - static_cast<size_t>(offsets[i]));
+    ASSERT_EQ(data.substr(static_cast<size_t>(offsets[i]), expected_len),
+              reqs[i].result.ToString());
+  }
+#ifdef OS_LINUX
+  if (!file->use_aio_reads()) {
+    ASSERT_EQ(1, advised.load());
+  }
+#endif
+
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_OK(env_->DeleteFile(fname));
+}
+
+TEST_F(EnvPosixTest, IOProfile) {
+  std::unique_ptr<Env> env(NewIOProfEnv(env_));
+  EnvOptions soptions;
+  std::string dbname = test::PerThreadDBPath(env.get(), "io_profile");
+  ASSERT_OK(env->CreateDirIfMissing(dbname));
+  std::string fname = dbname + "/000012.sst";
+  std::string profile;
+  ASSERT_OK(env->GetIOProfile(&profile));
+  ASSERT_TRUE(profile.empty());
+  {
+    IOPurposeGuard io_purpose_guard(kIOPurposeCompaction);
+    std::unique_ptr<WritableFile> wfile;
+    ASSERT_OK(env->NewWritableFile(fname, &wfile, soptions));
+    ASSERT_OK(wfile->Append(std::string(4096, 'x')));
+    ASSERT_OK(wfile->Sync());
+    ASSERT_OK(wfile->Close());
+  }
+  {
+    std::unique_ptr<RandomAccessFile> file;
+    ASSERT_OK(env->NewRandomAccessFile(fname, &file, soptions));
+    char scratch[100];
+    Slice result;
+    ASSERT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  }
+  ASSERT_OK(env->GetIOProfile(&profile));
+#ifdef ROCKSDB_SUPPORT_THREAD_LOCAL
+  ASSERT_NE(std::string::npos, profile.find("sst      compaction write "
+                                            "count 1 bytes 4096"));
+  ASSERT_NE(std::string::npos, profile.find("sst      compaction sync "));
+#endif
+  ASSERT_NE(std::string::npos,
+            profile.find("sst      other      read  count 1 bytes 100"));
+  ASSERT_OK(env->DeleteFile(fname));
+  ASSERT_OK(env->DeleteDir(dbname));
+}
+
 class TestLogger : public Logger {
  public:
   using Logger::Logv;
@@ -386,6 +386,23 @@ Status PosixRandomAccessFile::Read(uint64_t offset, size_t n, Slice* result,
                      use_direct_io_, GetRequiredBufferAlignment());
 }
 
+Status PosixRandomAccessFile::MultiRead(ReadRequest* reqs, size_t num_reqs) {
+  if (!use_direct_io_ && !use_aio_reads_ && num_reqs > 1) {
+    // Hand all the ranges to the kernel up front, so that the reads of the
+    // uncached ones are in flight together instead of waiting one by one
+    for (size_t i = 0; i < num_reqs; ++i) {
+      Fadvise(fd_, static_cast<off_t>(reqs[i].offset), reqs[i].len,
+              POSIX_FADV_WILLNEED);
+    }
+    TEST_SYNC_POINT("PosixRandomAccessFile::MultiRead:AfterAdvise");
+  }
+  for (size_t i = 0; i < num_reqs; ++i) {
+    ReadRequest& req = reqs[i];
+    req.status = Read(req.offset, req.len, &req.result, req.scratch);
+  }
+  return Status::OK();
+}
+
 Status PosixRandomAccessFile::Prefetch(uint64_t offset, size_t n) {
   Status s;
   if (!use_direct_io_) {
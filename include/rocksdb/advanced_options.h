@@ -136,21 +136,34 @@ struct CompressionOptions {
   // Default: false.
   bool enabled;
 
+  // Number of threads compressing the data blocks of a block based table.
+  // When greater than 1, each table builder starts that many threads, which
+  // compress the next blocks while the keys are added, and the blocks are
+  // still written in order. Only used with the binary search index and
+  // without block based filters, otherwise the blocks are compressed in the
+  // thread building the table.
+  //
+  // Default: 1.
+  uint32_t parallel_threads;
+
   CompressionOptions()
       : window_bits(-14),
         level(kDefaultCompressionLevel),
         strategy(0),
         max_dict_bytes(0),
         zstd_max_train_bytes(0),
-        enabled(false) {}
+        enabled(false),
+        parallel_threads(1) {}
   CompressionOptions(int wbits, int _lev, int _strategy, int _max_dict_bytes,
-                     int _zstd_max_train_bytes, bool _enabled)
+                     int _zstd_max_train_bytes, bool _enabled,
+                     uint32_t _parallel_threads = 1)
       : window_bits(wbits),
         level(_lev),
         strategy(_strategy),
         max_dict_bytes(_max_dict_bytes),
         zstd_max_train_bytes(_zstd_max_train_bytes),
-        enabled(_enabled) {}
+        enabled(_enabled),
+        parallel_threads(_parallel_threads) {}
 };
 
 enum UpdateStatus {     // Return status For inplace update callback
@@ -211,9 +224,29 @@ struct AdvancedColumnFamilyOptions {
   // LazyCompaction, default false
   bool enable_lazy_compaction = false;
 
-  // Read TableProperties from file if false
+  // Read TableProperties from file if false. Table readers then keep only the
+  // few properties used on the read path resident, with their names shared
+  // between files, which saves memory with many open files.
   bool pin_table_properties_in_reader = true;
 
+  // With an unlimited table cache (max_open_files = -1), DB::Open and every
+  // version change open the table readers of all files ahead of time, which
+  // makes open time and memory grow with the number of column families. Set
+  // this on the column families rarely read, e.g. the cold tenants of a DB
+  // with many column families, to open their files on first access instead.
+  // Map SSTs are still opened ahead of time.
+  //
+  // Default: false
+  bool lazy_load_table_readers = false;
+
+  // Memory for the elements of map SSTs kept in memory, so point lookups
+  // search them without going through the table cache. A map SST is loaded
+  // by the first lookup that reaches it and dropped in LRU order once the
+  // budget is used up. Map SSTs with range deletions are never loaded.
+  //
+  // Default: 0 (disabled)
+  size_t map_sst_index_memory_budget = 0;
+
   // Allows thread-safe inplace updates. If this is true, there is no way to
   // achieve point-in-time consistency using snapshot or iterator (assuming
   // concurrent updates). Hence iterator and multi-get will return results
@@ -592,6 +625,21 @@ struct AdvancedColumnFamilyOptions {
   // Dynamically changeable through SetOptions() API
   size_t max_successive_merges = 0;
 
+  // When a merge operand is added for a key that already has at least this
+  // many successive merge operands at the head of the memtable, and the head
+  // operand was written by the same write group (or during WAL recovery),
+  // the new operand is folded into the head operand in place with
+  // MergeOperator::PartialMerge() instead of being inserted. No reader or
+  // snapshot can see the head operand yet, so this is invisible to them.
+  // Folding is skipped when PartialMerge() fails or the result does not fit
+  // in the head operand, e.g. for operators other than fixed-width
+  // AssociativeMergeOperator counters. Not used with seq_per_batch.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  size_t memtable_merge_fold_threshold = 0;
+
   // This flag specifies that the implementation should optimize the filters
   // mainly for cases where keys are found rather than also optimize for keys
   // missed. This would be used in cases where the application knows that
@@ -610,10 +658,24 @@ struct AdvancedColumnFamilyOptions {
 
   // Enable lazy level compaction fast push range_deletions
   // It is recommended to disabled when RangeDeletion writes frequently
+  // Once pushed to the bottommost level, the ranges covered by range
+  // deletions older than every snapshot are dropped from the map sst without
+  // rewriting data
   //
   // Default: false
   bool optimize_range_deletion = false;
 
+  // Level and universal compaction (without enable_lazy_compaction) rewrite
+  // only the key ranges where input files overlap each other, and link the
+  // rest of the inputs into a map sst, when the overlapping input files make
+  // up less than this fraction of the input bytes. This generalizes trivial
+  // move to inputs that barely overlap, e.g. time ordered keys.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  double partial_compaction_overlap_ratio = 0;
+
   // After writing every SST file, reopen it and read all the keys.
   //
   // Default: false
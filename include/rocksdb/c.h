@@ -302,6 +302,22 @@ extern ROCKSDB_LIBRARY_API void rocksdb_multi_get_cf(
     const size_t* keys_list_sizes, char** values_list,
     size_t* values_list_sizes, char** errs);
 
+// Same as rocksdb_multi_get, except that each non-NULL values[i] is a
+// pinnable slice holding the value without copying it, to be destroyed by
+// rocksdb_pinnableslice_destroy(). values[i] is NULL if keys_list[i] is
+// not found or errs[i] is set.
+extern ROCKSDB_LIBRARY_API void rocksdb_multi_get_pinned(
+    rocksdb_t* db, const rocksdb_readoptions_t* options, size_t num_keys,
+    const char* const* keys_list, const size_t* keys_list_sizes,
+    rocksdb_pinnableslice_t** values, char** errs);
+
+extern ROCKSDB_LIBRARY_API void rocksdb_multi_get_pinned_cf(
+    rocksdb_t* db, const rocksdb_readoptions_t* options,
+    const rocksdb_column_family_handle_t* const* column_families,
+    size_t num_keys, const char* const* keys_list,
+    const size_t* keys_list_sizes, rocksdb_pinnableslice_t** values,
+    char** errs);
+
 extern ROCKSDB_LIBRARY_API rocksdb_iterator_t* rocksdb_create_iterator(
     rocksdb_t* db, const rocksdb_readoptions_t* options);
 
@@ -408,6 +424,12 @@ extern ROCKSDB_LIBRARY_API const char* rocksdb_iter_key(
     const rocksdb_iterator_t*, size_t* klen);
 extern ROCKSDB_LIBRARY_API const char* rocksdb_iter_value(
     const rocksdb_iterator_t*, size_t* vlen);
+// Returns whether the iterator is valid and, if so, the key and the value
+// of the current entry in one call. Like those of rocksdb_iter_key() and
+// rocksdb_iter_value(), the pointers are valid until the iterator is moved.
+extern ROCKSDB_LIBRARY_API unsigned char rocksdb_iter_entry(
+    const rocksdb_iterator_t*, const char** key, size_t* klen,
+    const char** value, size_t* vlen);
 extern ROCKSDB_LIBRARY_API void rocksdb_iter_get_error(
     const rocksdb_iterator_t*, char** errptr);
 
@@ -450,6 +472,17 @@ extern ROCKSDB_LIBRARY_API void rocksdb_writebatch_putv_cf(
     int num_keys, const char* const* keys_list, const size_t* keys_list_sizes,
     int num_values, const char* const* values_list,
     const size_t* values_list_sizes);
+// Puts the num_entries pairs of keys_list[i] and values_list[i] in one call
+extern ROCKSDB_LIBRARY_API void rocksdb_writebatch_put_many(
+    rocksdb_writebatch_t* b, size_t num_entries, const char* const* keys_list,
+    const size_t* keys_list_sizes, const char* const* values_list,
+    const size_t* values_list_sizes);
+extern ROCKSDB_LIBRARY_API void rocksdb_writebatch_put_many_cf(
+    rocksdb_writebatch_t* b,
+    rocksdb_column_family_handle_t* const* column_families,
+    size_t num_entries, const char* const* keys_list,
+    const size_t* keys_list_sizes, const char* const* values_list,
+    const size_t* values_list_sizes);
 extern ROCKSDB_LIBRARY_API void rocksdb_writebatch_merge(rocksdb_writebatch_t*,
                                                          const char* key,
                                                          size_t klen,
@@ -855,6 +888,8 @@ extern ROCKSDB_LIBRARY_API void rocksdb_options_set_max_manifest_file_size(
     rocksdb_options_t*, size_t);
 extern ROCKSDB_LIBRARY_API void rocksdb_options_set_max_manifest_edit_count(
     rocksdb_options_t*, size_t);
+extern ROCKSDB_LIBRARY_API void rocksdb_options_set_max_manifest_tail_ratio(
+    rocksdb_options_t*, double);
 extern ROCKSDB_LIBRARY_API void rocksdb_options_set_table_cache_numshardbits(
     rocksdb_options_t*, int);
 extern ROCKSDB_LIBRARY_API void
@@ -898,6 +933,8 @@ extern ROCKSDB_LIBRARY_API void
 rocksdb_options_set_access_hint_on_compaction_start(rocksdb_options_t*, int);
 extern ROCKSDB_LIBRARY_API void rocksdb_options_set_use_adaptive_mutex(
     rocksdb_options_t*, unsigned char);
+extern ROCKSDB_LIBRARY_API void rocksdb_options_set_use_async_file_writes(
+    rocksdb_options_t*, unsigned char);
 extern ROCKSDB_LIBRARY_API void rocksdb_options_set_bytes_per_sync(
     rocksdb_options_t*, uint64_t);
 extern ROCKSDB_LIBRARY_API void rocksdb_options_set_wal_bytes_per_sync(
@@ -37,6 +37,29 @@ namespace TERARKDB_NAMESPACE {
 
 class Cache;
 
+// A TinyLFU style admission filter in front of a sharded cache (LRU, LIRS or
+// CLOCK). Every lookup, hit or miss, is counted in a frequency sketch of
+// 4-bit counters that are halved periodically. Once a shard is full, an
+// insert whose key has been looked up fewer than min_frequency times recently
+// is rejected, so one-touch blocks of scans don't flush hot ones.
+//
+// A rejected insert returns Status::Incomplete like an insert beyond a
+// strict capacity limit does.
+struct CacheAdmissionOptions {
+  // Number of sketch counters, about 4 bits each. Should be a few times the
+  // number of entries the cache holds. 0 disables the admission filter.
+  size_t sketch_counters = 0;
+
+  // Lookups of a key within the sketch window needed to admit it into a full
+  // shard. The lookup miss that precedes an insert counts as well, so 2
+  // rejects keys seen only once.
+  uint32_t min_frequency = 2;
+
+  // If not nullptr, CACHE_ADMISSION_REJECT and CACHE_ADMISSION_REJECT_BYTES
+  // are recorded here.
+  std::shared_ptr<Statistics> statistics;
+};
+
 struct LRUCacheOptions {
   // Capacity of the cache.
   size_t capacity = 0;
@@ -62,6 +85,16 @@ struct LRUCacheOptions {
   // BlockBasedTableOptions::cache_index_and_filter_blocks_with_high_priority.
   double high_pri_pool_ratio = 0.0;
 
+  // If greater than high_pri_pool_ratio, the high-pri pool adapts to the
+  // working set of high-pri entries instead of having a fixed size. A burst
+  // of high-pri entries grows the pool up to this ratio of capacity rather
+  // than overflowing older ones to the low-pri pool, and the pool shrinks
+  // back towards high_pri_pool_ratio when the peak usage measured over the
+  // recent inserts drops. Useful with
+  // BlockBasedTableOptions::cache_index_and_filter_blocks_with_high_priority
+  // to keep L0 and L1 filters cached after large flushes.
+  double high_pri_pool_max_ratio = 0.0;
+
   bool is_diagnose = false;
 
   size_t topk = 10;
@@ -75,6 +108,9 @@ struct LRUCacheOptions {
   // internally (currently only XPRESS).
   std::shared_ptr<MemoryAllocator> memory_allocator;
 
+  // Admission filter, disabled by default.
+  CacheAdmissionOptions admission_options;
+
   LRUCacheOptions() {}
   LRUCacheOptions(size_t _capacity, int _num_shard_bits,
                   bool _strict_capacity_limit, double _high_pri_pool_ratio,
@@ -92,6 +128,7 @@ struct LIRSCacheOptions {
   bool strict_capacity_limit = false;
   double irr_ratio = 0.9;
   std::shared_ptr<MemoryAllocator> memory_allocator;
+  CacheAdmissionOptions admission_options;
   LIRSCacheOptions() {}
   LIRSCacheOptions(size_t _capacity, int _num_shard_bits,
                    bool _strict_capacity_limit, double _irr_ratio,
@@ -142,6 +179,30 @@ extern std::shared_ptr<Cache> NewClockCache(size_t capacity,
                                             int num_shard_bits = -1,
                                             bool strict_capacity_limit = false);
 
+// Same as above, with an admission filter in front of the cache.
+extern std::shared_ptr<Cache> NewClockCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    const CacheAdmissionOptions& admission_options);
+
+// Returns a view of "shared" for one tenant, e.g. set it as the
+// BlockBasedTableOptions::block_cache or TerarkZipTableOptions::recordCache
+// of one column family, and give every column family its own view of the
+// same cache. Entries inserted through the view are charged to the tenant.
+// Its most recently used entries, up to min_reserved bytes, are pinned so
+// other tenants can't evict them. Beyond soft_max bytes, its inserts go in
+// with low priority and unpinned, so they are the first to be evicted, or
+// fail if SetStrictCapacityLimit(true) is called on the view.
+//
+// GetUsage(), GetCapacity() and GetPinnedUsage() of the view report the
+// tenant's usage, soft_max and reserved bytes, so the block-cache-* DB
+// properties become per column family.
+//
+// Every entry of "shared" has to be inserted through a view. Returns nullptr
+// if min_reserved > soft_max.
+extern std::shared_ptr<Cache> NewCacheQuota(std::shared_ptr<Cache> shared,
+                                            size_t min_reserved,
+                                            size_t soft_max);
+
 class Cache {
  public:
   // Depending on implementation, cache entries with high priority could be less
@@ -11,6 +11,7 @@
 #include <functional>
 #include <future>
 #include <string>
+#include <vector>
 
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
@@ -20,6 +21,7 @@ namespace TERARKDB_NAMESPACE {
 // using boost::noncopyable;
 struct CompactionWorkerContext;
 struct CompactionWorkerResult;
+enum CompressionType : unsigned char;
 
 class CompactionDispatcher : boost::noncopyable {
  public:
@@ -39,6 +41,11 @@ class RemoteCompactionDispatcher : public CompactionDispatcher {
   virtual const char* Name() const override;
 
   virtual std::future<std::string> DoCompaction(std::string data) = 0;
+
+  // Compression of the data passed to DoCompaction, the worker compresses
+  // its result the same way. No compression by default.
+  virtual CompressionType payload_compression() const;
+
   class Worker : boost::noncopyable {
    public:
     Worker(EnvOptions env_options, Env* env);
@@ -56,4 +63,101 @@ class RemoteCompactionDispatcher : public CompactionDispatcher {
 extern std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
     std::string cmd);
 
+// A long lived remote worker of a worker pool dispatcher.
+class CompactionWorkerClient : boost::noncopyable {
+ public:
+  virtual ~CompactionWorkerClient() = default;
+
+  virtual const char* Name() const = 0;
+
+  // Ship an encoded CompactionWorkerContext to the worker, the future holds
+  // the encoded CompactionWorkerResult. Should not block.
+  virtual std::future<std::string> DoCompaction(uint64_t job_id,
+                                                std::string data) = 0;
+
+  // Best effort, the dispatcher has stopped waiting for "job_id".
+  virtual void Cancel(uint64_t /*job_id*/) {}
+};
+
+struct CompactionWorkerPoolOptions {
+  // Remote jobs taking longer are cancelled and the compaction runs
+  // locally. 0 waits forever.
+  uint64_t remote_timeout_micros = 0;
+
+  // The compaction runs locally when every healthy worker already has this
+  // many jobs in flight.
+  size_t max_jobs_per_worker = 4;
+
+  // A worker that failed or timed out gets no jobs for this long.
+  uint64_t unhealthy_backoff_micros = 60 * 1000 * 1000;
+};
+
+// Returns a dispatcher that places each sub compaction on the healthy worker
+// with the fewest jobs in flight. When no worker can take it, or the remote
+// job fails or exceeds remote_timeout_micros, the compaction falls back to
+// local execution.
+extern std::shared_ptr<CompactionDispatcher> NewCompactionWorkerPoolDispatcher(
+    std::vector<std::shared_ptr<CompactionWorkerClient>> workers,
+    const CompactionWorkerPoolOptions& options = CompactionWorkerPoolOptions(),
+    Env* env = Env::Default());
+
+// Moves compaction input and output files between the DB host and a remote
+// worker chunk by chunk, so the worker needs no shared filesystem. Wrap the
+// RPC framework of choice (gRPC, bRPC, ...) on the worker side and forward
+// each call to a CompactionTransportService on the DB host. Every call
+// blocks until the host has answered, so a slow host throttles the worker.
+class CompactionTransport : boost::noncopyable {
+ public:
+  virtual ~CompactionTransport() = default;
+
+  // Read up to "n" bytes of host file "fname" starting at "offset" into
+  // "*chunk". A short chunk means end of file.
+  virtual Status ReadChunk(const std::string& fname, uint64_t offset, size_t n,
+                           std::string* chunk) = 0;
+
+  // Append "chunk" to host file "fname", creating it on the first call.
+  virtual Status WriteChunk(const std::string& fname, const Slice& chunk) = 0;
+
+  // All chunks of "fname" have been sent, the host should sync and close it.
+  virtual Status FinishOutput(const std::string& fname) = 0;
+};
+
+// Serves CompactionTransport requests from the files of the DB host. Only
+// the files registered for a running job are served, and they must lie in
+// one of "paths", usually the cf_paths of the DB. Reads return at most
+// "chunk_size" bytes, which should match the chunk size of the worker.
+// Thread safe.
+class CompactionTransportService : boost::noncopyable {
+ public:
+  CompactionTransportService(Env* env, EnvOptions env_options,
+                             std::vector<std::string> paths,
+                             size_t chunk_size = 1 << 20);
+  ~CompactionTransportService();
+
+  // Allow the worker of "job_id" to read "inputs" and write "outputs". An
+  // output may belong to only one job.
+  Status RegisterJob(uint64_t job_id, const std::vector<std::string>& inputs,
+                     const std::vector<std::string>& outputs);
+  // Revoke the files of "job_id", outputs left unfinished are closed.
+  void UnregisterJob(uint64_t job_id);
+
+  Status ReadChunk(const std::string& fname, uint64_t offset, size_t n,
+                   std::string* chunk);
+  Status WriteChunk(const std::string& fname, const Slice& chunk);
+  Status FinishOutput(const std::string& fname);
+
+ private:
+  struct Rep;
+  Rep* rep_;
+};
+
+// Returns an Env that opens RandomAccessFile and WritableFile through
+// "transport", everything else goes to "base_env". Pass it to
+// RemoteCompactionDispatcher::Worker to compact without shared storage.
+// Input files are fetched and output files are sent in "chunk_size" pieces.
+// The caller must delete the result when it is no longer needed.
+extern Env* NewCompactionTransportEnv(
+    Env* base_env, std::shared_ptr<CompactionTransport> transport,
+    size_t chunk_size = 1 << 20);
+
 }  // namespace TERARKDB_NAMESPACE
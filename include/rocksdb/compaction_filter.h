@@ -188,6 +188,30 @@ class CompactionFilter
     return Decision::kKeep;
   }
 
+  // Batched FilterV2() for ValueType::kValue records, used instead of it when
+  // FilterBatchSize() is not zero. The decision for keys[i] and values[i]
+  // goes to decisions[i], a changed value to new_values[i].
+  // kRemoveAndSkipUntil can't be returned here, it is taken as kKeep.
+  virtual void FilterBatch(int level, size_t n, const Slice* keys,
+                           const LazyBuffer* values, LazyBuffer* new_values,
+                           Decision* decisions) const {
+    std::string skip_until;
+    for (size_t i = 0; i < n; ++i) {
+      decisions[i] = FilterV2(level, keys[i], ValueType::kValue, Slice(),
+                              values[i], &new_values[i], &skip_until);
+      if (decisions[i] == Decision::kRemoveAndSkipUntil) {
+        decisions[i] = Decision::kKeep;
+      }
+    }
+  }
+
+  // Compactions read up to this many records ahead of the one they process
+  // and pass the values among them that need filtering to one FilterBatch()
+  // call. Records read ahead are copied, values of older versions included,
+  // so this pays off when the cost of a filter call dominates. Zero, the
+  // default, filters one record at a time.
+  virtual size_t FilterBatchSize() const { return 0; }
+
   // By default, compaction will only call Filter() on keys written after the
   // most recent call to GetSnapshot(). However, if the compaction filter
   // overrides IgnoreSnapshots to make it return true, the compaction filter
@@ -20,6 +20,9 @@ struct CompactionJobStats {
 
   // the elapsed time of this compaction in microseconds.
   uint64_t elapsed_micros;
+  // the CPU time of this compaction in microseconds, summed over the
+  // subcompactions. 0 if the Env can't tell, see Env::NowCPUNanos().
+  uint64_t cpu_micros;
 
   // the number of compaction input records.
   uint64_t num_input_records;
@@ -78,6 +81,34 @@ struct CompactionJobStats {
   // Time spent on preparing file write (fallocate, etc)
   uint64_t file_prepare_write_nanos;
 
+  // Wall and CPU time spent in a phase of the compaction.
+  struct PhaseTime {
+    uint64_t wall_nanos;
+    uint64_t cpu_nanos;
+  };
+
+  // Time spent in each phase of the compaction. The phases run once per
+  // record are timed on a sample of the records and scaled up, so they are
+  // estimates. A phase includes the phases it calls.
+  //
+  // Reading and decompressing the input files.
+  PhaseTime input_read_time;
+  // Producing the output records, input_read_time, compaction_filter_time
+  // and merge_time included. So is blob_output_time unless the table
+  // builder writes the blobs in its second pass.
+  PhaseTime compaction_iterator_time;
+  // CompactionFilter::FilterV2() and FilterBatch().
+  PhaseTime compaction_filter_time;
+  // Merging the operands of merge records.
+  PhaseTime merge_time;
+  // TableBuilder::Add(), the first pass of TerarkZipTableBuilder.
+  PhaseTime table_add_time;
+  // TableBuilder::Finish(), the second pass of TerarkZipTableBuilder which
+  // builds the index, compresses the values and iterates the input again.
+  PhaseTime table_finish_time;
+  // Writing separated values to blob files.
+  PhaseTime blob_output_time;
+
   // 0-terminated strings storing the first 8 bytes of the smallest and
   // largest key in the output.
   static const size_t kMaxPrefixLength = 8;
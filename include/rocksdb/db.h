@@ -65,6 +65,7 @@ class WriteBatch;
 class Env;
 class EventListener;
 class StatsHistoryIterator;
+enum class StatsHistoryGranularity : unsigned char;
 class TraceWriter;
 
 using std::unique_ptr;
@@ -152,6 +153,17 @@ typedef std::unordered_map<std::string, std::shared_ptr<const TableProperties>>
 // A DB is a persistent ordered map from keys to values.
 // A DB is safe for concurrent access from multiple threads without
 // any external synchronization.
+// The latest entry of a key found by DB::MultiGetSeqno()
+struct EntrySeqno {
+  // False if no entry of the key is visible
+  bool found = false;
+  // The entry is a deletion, else a value or a merge operand
+  bool deleted = false;
+  // The sequence number of the entry, 0 if the entry was compacted into the
+  // bottommost level with its sequence number dropped
+  SequenceNumber seqno = 0;
+};
+
 class DB {
  public:
   // Open the database with the specified "name".
@@ -187,6 +199,28 @@ class DB {
       std::vector<ColumnFamilyHandle*>* handles, DB** dbptr,
       bool error_if_log_file_exist = false);
 
+  // Open the database as a secondary instance of the primary instance at
+  // name. A secondary instance is read only like OpenForReadOnly, but it
+  // follows the MANIFEST and the WAL of the running primary instance on
+  // TryCatchUpWithPrimary() instead of being reopened. It never writes nor
+  // deletes a file under name, its info log goes to secondary_path unless
+  // options.info_log is set.
+  //
+  // Not supported in ROCKSDB_LITE, in which case the function will
+  // return Status::NotSupported.
+  static Status OpenAsSecondary(const Options& options, const std::string& name,
+                                const std::string& secondary_path,
+                                DB** dbptr);
+
+  // Open a secondary instance with a subset of the column families, which
+  // has to include the default column family. A column family dropped by
+  // the primary instance keeps the data it had when it was dropped.
+  static Status OpenAsSecondary(
+      const DBOptions& db_options, const std::string& name,
+      const std::string& secondary_path,
+      const std::vector<ColumnFamilyDescriptor>& column_families,
+      std::vector<ColumnFamilyHandle*>* handles, DB** dbptr);
+
   // Open DB with column families.
   // db_options specify database specific options
   // column_families is the vector of all column families in the database,
@@ -376,7 +410,16 @@ class DB {
                      std::string* value) {
     return Get(options, DefaultColumnFamily(), key, value);
   }
-#ifdef BOOSTLIB
+
+  // Async reads. The tasks run on the fibers of the calling thread, up to
+  // ReadOptions::aio_concurrency of them, and with use_aio_reads every file
+  // read of a task yields to the other fibers until it completes, so one
+  // thread keeps many reads in flight. Tasks, including the callbacks, run
+  // only when the thread waits: in WaitAsync() or in a read of a fiber.
+  // Any read, e.g. an iterator scan, runs on the fibers by
+  // SubmitAsyncTask().
+  // Without BOOSTLIB, the tasks and the callbacks run before the calls
+  // return and WaitAsync() returns 0.
   static void CallOnMainStack(const std::function<void()>&);
   static void SubmitAsyncTask(std::function<void()>);
   static void SubmitAsyncTask(std::function<void()>, size_t concurrency);
@@ -395,9 +438,26 @@ class DB {
                 GetAsyncCallback);
   void GetAsync(const ReadOptions&, std::string key, GetAsyncCallback);
 
+  // Called once all keys are read, statuses and *values are in the order
+  // of keys
+  typedef std::function<void(std::vector<Status>&&,
+                             std::vector<std::string>&& keys,
+                             std::vector<std::string>* values)>
+      MultiGetAsyncCallback;
+
+  // Every key is read by its own task. *values is resized to the number of
+  // keys and must live until cb is called.
+  void MultiGetAsync(const ReadOptions&,
+                     const std::vector<ColumnFamilyHandle*>& column_family,
+                     std::vector<std::string> keys,
+                     std::vector<std::string>* values,
+                     MultiGetAsyncCallback cb);
+  void MultiGetAsync(const ReadOptions&, std::vector<std::string> keys,
+                     std::vector<std::string>* values,
+                     MultiGetAsyncCallback cb);
+
   static int WaitAsync(int timeout_us);
   static int WaitAsync();
-#endif  // BOOSTLIB
 
 #if defined(TERARKDB_WITH_AIO_FUTURE)
   future<std::tuple<Status, std::string, std::string*>> GetFuture(
@@ -437,6 +497,29 @@ class DB {
         keys, values);
   }
 
+  // Finds the latest entry of every key visible to options.snapshot, without
+  // reading, merging or fetching its value, so a separated value costs no
+  // blob read. Without a snapshot, all the keys are read at one sequence.
+  // The status of a key is OK whether it has an entry or not, and the error
+  // of the lookup otherwise.
+  // Note: keys will not be "de-duplicated".
+  virtual std::vector<Status> MultiGetSeqno(
+      const ReadOptions& /*options*/,
+      const std::vector<ColumnFamilyHandle*>& /*column_family*/,
+      const std::vector<Slice>& keys, std::vector<EntrySeqno>* entries) {
+    entries->assign(keys.size(), EntrySeqno());
+    return std::vector<Status>(keys.size(),
+                               Status::NotSupported("MultiGetSeqno"));
+  }
+  Status GetSeqno(const ReadOptions& options,
+                  ColumnFamilyHandle* column_family, const Slice& key,
+                  EntrySeqno* entry) {
+    std::vector<EntrySeqno> entries;
+    Status s = MultiGetSeqno(options, {column_family}, {key}, &entries)[0];
+    *entry = entries[0];
+    return s;
+  }
+
   // If the key definitely does not exist in the database, then this method
   // returns false, else true. If the caller wants to obtain value when the key
   // is found in memory, a bool for 'value_found' must be passed. 'value_found'
@@ -609,6 +692,30 @@ class DB {
     //      filter and index blocks).
     static const std::string kEstimateTableReadersMem;
 
+    //  "rocksdb.estimate-table-index-mem" - returns estimated memory used by
+    //      the indexes of the open SST tables, of an mmap'd index (e.g.
+    //      TerarkZip) only the pages resident in the page cache.
+    static const std::string kEstimateTableIndexMem;
+
+    //  "rocksdb.estimate-table-dict-mem" - returns estimated memory used by
+    //      the compression dictionaries of the open SST tables.
+    static const std::string kEstimateTableDictMem;
+
+    //  "rocksdb.table-builder-mem" - returns the working memory held by the
+    //      table builders of the table factory of the column family (e.g. the
+    //      softZipWorkingMemLimit accounting of TerarkZip).
+    static const std::string kTableBuilderMem;
+
+    //  "rocksdb.estimate-blob-reference-mem" - returns estimated memory used
+    //      by the metadata resolving separated values and Map SST entries to
+    //      the SSTs holding them.
+    static const std::string kEstimateBlobReferenceMem;
+
+    //  "rocksdb.cur-size-all-mem-table-reps" - returns the part of
+    //      "rocksdb.cur-size-all-mem-tables" the memtable reps hold outside
+    //      the memtable arenas (e.g. the tries of Patricia memtables).
+    static const std::string kCurSizeAllMemTableReps;
+
     //  "rocksdb.is-file-deletions-enabled" - returns 0 if deletion of obsolete
     //      files is enabled; otherwise, returns a non-zero number.
     static const std::string kIsFileDeletionsEnabled;
@@ -665,6 +772,26 @@ class DB {
     //      based.
     static const std::string kEstimatePendingCompactionBytes;
 
+    //  "rocksdb.read-amp-debt" - returns number of SSTs a point lookup may
+    //      read beyond one per sorted run, caused by overlapping ranges in
+    //      map SSTs of lazy compaction.
+    static const std::string kReadAmpDebt;
+
+    //  "rocksdb.total-blob-files-size" - returns total size (bytes) of the
+    //      blob SSTs holding the separated values.
+    static const std::string kTotalBlobFilesSize;
+
+    //  "rocksdb.estimate-blob-garbage-size" - returns estimated size (bytes)
+    //      of the values in the blob SSTs that garbage collection can drop.
+    static const std::string kEstimateBlobGarbageSize;
+
+    //  "rocksdb.estimate-space-amplification" - returns the size of the SSTs
+    //      and blob SSTs over the estimated size of the live data in them, in
+    //      percent. The live data excludes the blob garbage and the parts of
+    //      the SSTs behind map SSTs out of the map SST ranges. Returns 0
+    //      without data.
+    static const std::string kEstimateSpaceAmplification;
+
     //  "rocksdb.aggregated-table-properties" - returns a string representation
     //      of the aggregated table properties of the target column family.
     static const std::string kAggregatedTableProperties;
@@ -695,6 +822,24 @@ class DB {
     // "rocksdb.options-statistics" - returns multi-line string
     //      of options.statistics
     static const std::string kOptionsStatistics;
+
+    // "rocksdb.io-profile" - returns multi-line string of file I/O bytes and
+    //      latencies by file kind and purpose, when the DB runs on an Env
+    //      created by NewIOProfEnv.
+    static const std::string kIOProfile;
+
+    // "rocksdb.hot-keys" - returns multi-line string of the hottest keys and
+    //      data blocks with their estimated access counts, when
+    //      DBOptions::hot_key_sample_rate is set.
+    static const std::string kHotKeys;
+
+    //  "rocksdb.write-buffer-quota" - returns the memtable quota of this DB
+    //      in a fair share WriteBufferManager.
+    static const std::string kWriteBufferQuota;
+
+    //  "rocksdb.delayed-write-rate-target" - returns the write rate the
+    //      column family asks for while it delays writes, 0 otherwise.
+    static const std::string kDelayedWriteRateTarget;
   };
 #endif /* ROCKSDB_LITE */
 
@@ -731,6 +876,11 @@ class DB {
   //  "rocksdb.num-deletes-imm-mem-tables"
   //  "rocksdb.estimate-num-keys"
   //  "rocksdb.estimate-table-readers-mem"
+  //  "rocksdb.estimate-table-index-mem"
+  //  "rocksdb.estimate-table-dict-mem"
+  //  "rocksdb.table-builder-mem"
+  //  "rocksdb.estimate-blob-reference-mem"
+  //  "rocksdb.cur-size-all-mem-table-reps"
   //  "rocksdb.is-file-deletions-enabled"
   //  "rocksdb.num-snapshots"
   //  "rocksdb.oldest-snapshot-time"
@@ -743,6 +893,10 @@ class DB {
   //  "rocksdb.live-sst-files-size"
   //  "rocksdb.base-level"
   //  "rocksdb.estimate-pending-compaction-bytes"
+  //  "rocksdb.read-amp-debt"
+  //  "rocksdb.total-blob-files-size"
+  //  "rocksdb.estimate-blob-garbage-size"
+  //  "rocksdb.estimate-space-amplification"
   //  "rocksdb.num-running-compactions"
   //  "rocksdb.num-running-flushes"
   //  "rocksdb.actual-delayed-write-rate"
@@ -750,6 +904,8 @@ class DB {
   //  "rocksdb.block-cache-capacity"
   //  "rocksdb.block-cache-usage"
   //  "rocksdb.block-cache-pinned-usage"
+  //  "rocksdb.write-buffer-quota"
+  //  "rocksdb.delayed-write-rate-target"
   virtual bool GetIntProperty(ColumnFamilyHandle* column_family,
                               const Slice& property, uint64_t* value) = 0;
   virtual bool GetIntProperty(const Slice& property, uint64_t* value) {
@@ -1003,6 +1159,15 @@ class DB {
   // The sequence number of the most recent transaction.
   virtual SequenceNumber GetLatestSequenceNumber() const = 0;
 
+  // Secondary instance only, see OpenAsSecondary. Makes the writes the
+  // primary instance has done since the previous call visible. The new
+  // MANIFEST records are applied on the current versions and the WAL is
+  // replayed into the memtables, so the table cache and the block cache stay
+  // warm.
+  virtual Status TryCatchUpWithPrimary() {
+    return Status::NotSupported("Supported only by secondary instance");
+  }
+
   // Instructs DB to preserve deletes with sequence numbers >= passed seqnum.
   // Has no effect if DBOptions.preserve_deletes is set to false.
   // This function assumes that user calls this function with monotonically
@@ -1275,6 +1440,31 @@ class DB {
   virtual Status EndTrace() {
     return Status::NotSupported("EndTrace() is not implemented.");
   }
+
+  // Trace a sample of the operations with their PerfContext and
+  // IOStatsContext, see PerfTraceOptions. Use EndPerfTrace() to stop.
+  virtual Status StartPerfTrace(
+      const PerfTraceOptions& /*options*/,
+      std::unique_ptr<TraceWriter>&& /*trace_writer*/) {
+    return Status::NotSupported("StartPerfTrace() is not implemented.");
+  }
+
+  virtual Status EndPerfTrace() {
+    return Status::NotSupported("EndPerfTrace() is not implemented.");
+  }
+
+  // Trace the reads of the records that bypass the block cache, the value
+  // records of TerarkZip tables and the separated values of blob SSTs, see
+  // TableAccessTraceOptions. Use EndTableAccessTrace() to stop.
+  virtual Status StartTableAccessTrace(
+      const TableAccessTraceOptions& /*options*/,
+      std::unique_ptr<TraceWriter>&& /*trace_writer*/) {
+    return Status::NotSupported("StartTableAccessTrace() is not implemented.");
+  }
+
+  virtual Status EndTableAccessTrace() {
+    return Status::NotSupported("EndTableAccessTrace() is not implemented.");
+  }
 #endif  // ROCKSDB_LITE
 
   // Needed for StackableDB
@@ -1289,6 +1479,17 @@ class DB {
     return Status::NotSupported("GetStatsHistory() is not implemented.");
   }
 
+  // Like GetStatsHistory() above, at "granularity" and with only the stats
+  // named in "stats_names" decoded, all of them if it is empty. The time of a
+  // minute, hour or day record is the start of its bucket.
+  virtual Status GetStatsHistory(
+      uint64_t /*start_time*/, uint64_t /*end_time*/,
+      StatsHistoryGranularity /*granularity*/,
+      const std::vector<std::string>& /*stats_names*/,
+      std::unique_ptr<StatsHistoryIterator>* /*stats_iterator*/) {
+    return Status::NotSupported("GetStatsHistory() is not implemented.");
+  }
+
  private:
   // No copying allowed
   DB(const DB&);
@@ -50,6 +50,7 @@ struct DBOptions;
 struct ImmutableDBOptions;
 struct MutableDBOptions;
 class RateLimiter;
+class Statistics;
 class ThreadStatusUpdater;
 struct ThreadStatus;
 
@@ -81,6 +82,10 @@ struct EnvOptions {
   // If false, fallocate() calls are bypassed
   bool allow_fallocate = true;
 
+  // If true, WritableFileWriter writes full buffers and range syncs from a
+  // background thread. Has no effect with direct I/O.
+  bool use_async_writes = false;
+
   // If true, set the FD_CLOEXEC on open fd.
   bool set_fd_cloexec = true;
 
@@ -329,8 +334,10 @@ class Env {
 
   static std::string PriorityToString(Priority priority);
 
-  // Priority for requesting bytes in rate limiter scheduler
-  enum IOPriority { IO_LOW = 0, IO_HIGH = 1, IO_TOTAL = 2 };
+  // Priority for requesting bytes in rate limiter scheduler. Flush writes at
+  // IO_HIGH, L0 compactions that keep writes from stalling at IO_MID, the
+  // other compactions and GC at IO_LOW
+  enum IOPriority { IO_LOW = 0, IO_MID = 1, IO_HIGH = 2, IO_TOTAL = 3 };
 
   // Arrange to run "(*function)(arg)" once in a background thread, in
   // the thread pool specified by pri. By default, jobs go to the 'LOW'
@@ -384,6 +391,10 @@ class Env {
   // that are MONOTONIC.
   virtual uint64_t NowNanos() { return NowMicros() * 1000; }
 
+  // Returns the CPU time the calling thread has used in nano-seconds, 0 if
+  // the platform can't tell.
+  virtual uint64_t NowCPUNanos() { return 0; }
+
   // Sleep/delay the thread for the prescribed number of micro-seconds.
   virtual void SleepForMicroseconds(int micros) = 0;
 
@@ -465,6 +476,11 @@ class Env {
     return Status::NotSupported("Not supported.");
   }
 
+  // Returns the file I/O breakdown collected by the env, see NewIOProfEnv.
+  virtual Status GetIOProfile(std::string* /*profile*/) {
+    return Status::NotSupported("Not supported.");
+  }
+
   // Returns the pointer to ThreadStatusUpdater.  This function will be
   // used in RocksDB internally to update thread status and supports
   // GetThreadList().
@@ -580,6 +596,22 @@ class SequentialFileWrapper : public SequentialFile {
 };
 
 // A file abstraction for randomly reading the contents of a file.
+// A request of RandomAccessFile::MultiRead
+struct ReadRequest {
+  // File offset in bytes
+  uint64_t offset;
+  // Length to read in bytes
+  size_t len;
+  // A buffer that MultiRead() can optionally place data in. It can
+  // ignore this and allocate its own buffer
+  char* scratch;
+  // Output parameter set by MultiRead() to point to the data buffer, and
+  // the number of valid bytes
+  Slice result;
+  // Status of read
+  Status status;
+};
+
 class RandomAccessFile {
  public:
   RandomAccessFile() {}
@@ -598,6 +630,23 @@ class RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
 
+  // Read a batch of ranges, the outcome of each one goes to its request.
+  // Implementations may overlap the I/O of the requests, the default reads
+  // them one by one. Returns a non-OK status only if the batch as a whole
+  // failed, in which case the per-request statuses are unspecified.
+  //
+  // Safe for concurrent use by multiple threads.
+  // If Direct I/O enabled, offset, len, and scratch should be aligned
+  // properly.
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) {
+    assert(reqs != nullptr || num_reqs == 0);
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      req.status = Read(req.offset, req.len, &req.result, req.scratch);
+    }
+    return Status::OK();
+  }
+
   // Readahead the file starting from offset by n bytes for caching.
   virtual Status Prefetch(uint64_t /*offset*/, size_t /*n*/) {
     return Status::OK();
@@ -673,6 +722,10 @@ class RandomAccessFileWrapper : public RandomAccessFile {
     return t_->Read(offset, n, result, scratch);
   };
 
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) override {
+    return t_->MultiRead(reqs, num_reqs);
+  }
+
   Status Prefetch(uint64_t offset, size_t n) override {
     return t_->Prefetch(offset, n);
   }
@@ -1319,6 +1372,7 @@ class EnvWrapper : public Env {
   }
   uint64_t NowMicros() override { return target_->NowMicros(); }
   uint64_t NowNanos() override { return target_->NowNanos(); }
+  uint64_t NowCPUNanos() override { return target_->NowCPUNanos(); }
 
   void SleepForMicroseconds(int micros) override {
     target_->SleepForMicroseconds(micros);
@@ -1364,6 +1418,10 @@ class EnvWrapper : public Env {
     return target_->GetThreadList(thread_list);
   }
 
+  Status GetIOProfile(std::string* profile) override {
+    return target_->GetIOProfile(profile);
+  }
+
   ThreadStatusUpdater* GetThreadStatusUpdater() const override {
     return target_->GetThreadStatusUpdater();
   }
@@ -1421,6 +1479,43 @@ Env* NewTimedEnv(Env* base_env);
 
 // Returns a new environment for IO profiling
 // This is a env forwarding method defined in env/env_io_prof.cc
-Env* NewIOProfEnv(Env* base_env);
+//
+// Besides the per call reports of IOProfiler, the env keeps byte counts and
+// latency histograms of reads, writes and syncs by file type (WAL, SST,
+// manifest, other) and by what the calling thread is doing (Get, iterator,
+// flush, compaction, GC), available from GetIOProfile() and the DB property
+// "rocksdb.io-profile". With stats set, the latencies also go to the
+// IO_PROF_*_MICROS histograms.
+Env* NewIOProfEnv(Env* base_env, std::shared_ptr<Statistics> stats = nullptr);
+
+struct RemoteReadCacheOptions {
+  // Directory of the cached copies of the remote files, e.g. on a local
+  // SSD. The copies left there by a previous env are removed.
+  std::string cache_dir;
+  // Env of cache_dir, Env::Default() if nullptr
+  Env* local_env = nullptr;
+  // Remote files are fetched and cached in blocks of this size
+  size_t block_size = 1 << 20;
+  // Bytes fetched ahead of a read that continues the previous one
+  size_t readahead_size = 8 << 20;
+  // Maximum number of ranged reads one file read issues at the same time
+  int max_parallel_reads = 4;
+  // Beyond this many cached bytes, the copies of the least recently used
+  // files are removed
+  uint64_t capacity = 64ull << 30;
+};
+
+// Returns a new environment that reads the files of remote_env, e.g. an
+// HDFS or librados env, through a read-through cache in a local directory.
+// A random access file fetches the blocks it misses, coalescing adjacent
+// ones and issuing up to max_parallel_reads ranged reads at the same time,
+// and reads ahead when read sequentially. Files must not change once they
+// are read, except through DeleteFile() and RenameFile() of this env.
+// Everything else, sequential reads included, goes to remote_env.
+// This is a factory method for RemoteReadCacheEnv defined in
+// utilities/env_remote_read_cache.cc.
+Status NewRemoteReadCacheEnv(Env* remote_env,
+                             const RemoteReadCacheOptions& options,
+                             Env** result);
 
 }  // namespace TERARKDB_NAMESPACE
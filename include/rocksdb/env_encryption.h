@@ -7,6 +7,7 @@
 
 #if !defined(ROCKSDB_LITE)
 
+#include <memory>
 #include <string>
 
 #include "env.h"
@@ -202,6 +203,20 @@ class CTREncryptionProvider : public EncryptionProvider {
       std::unique_ptr<BlockAccessCipherStream>* result);
 };
 
+// Creates an AES block cipher using the AES-NI instructions. The key is 16
+// or 32 bytes, for AES-128 or AES-256. Returns NotSupported if the CPU does
+// not have AES-NI.
+Status NewAESBlockCipher(const Slice& key,
+                         std::unique_ptr<BlockCipher>* result);
+
+// Creates a CTREncryptionProvider over an AES block cipher, see
+// NewAESBlockCipher(), whose cipher streams encrypt whole buffers at once:
+// 8 blocks at a time with AES-NI, or 16 with VAES on CPUs with AVX-512, and
+// buffers of 1MB or more are split among threads. The files are the same
+// as the ones of a CTREncryptionProvider over the same cipher.
+Status NewAESCTREncryptionProvider(
+    const Slice& key, std::unique_ptr<EncryptionProvider>* result);
+
 }  // namespace TERARKDB_NAMESPACE
 
 #endif  // !defined(ROCKSDB_LITE)
@@ -148,4 +148,15 @@ class FilterPolicy {
 // trailing spaces in keys.
 extern const FilterPolicy* NewBloomFilterPolicy(
     int bits_per_key, bool use_block_based_builder = false);
+
+// Return a new filter policy that uses a xor filter for full filters, also
+// the partitioned ones. A xor filter keeps an 8 bit fingerprint per key at
+// 9.84 bits per key, false positive rate ~ 0.4%, and a 16 bit one from 20
+// bits_per_key, false positive rate ~ 0.0015%. A bloom filter needs about
+// 30% more memory for the same false positive rate.
+//
+// Filters built by this policy and by NewBloomFilterPolicy are readable by
+// both, the policy can be switched on an existing database. Block based
+// filters (Set 1) are bloom filters.
+extern const FilterPolicy* NewXorFilterPolicy(int bits_per_key);
 }  // namespace TERARKDB_NAMESPACE
@@ -89,6 +89,11 @@ class LazyBufferState {
   // context -> Cleanable
   static const LazyBufferState* cleanable_state();
 
+  // Same as cleanable_state, but the Cleanable does not depend SuperVersion,
+  // pin with LazyBufferPinLevel::DB keeps the slice without copying
+  // context -> Cleanable
+  static const LazyBufferState* cleanable_db_state();
+
   // Reserve buffer capacity
   static bool reserve_buffer(LazyBuffer* buffer, size_t size);
 
@@ -97,6 +102,9 @@ class LazyBufferState {
 
   // Get &buffer->context_
   static LazyBufferContext* get_context(LazyBuffer* buffer);
+
+  // Get buffer->state_
+  static const LazyBufferState* get_state(const LazyBuffer* buffer);
 };
 
 class LazyBuffer {
@@ -159,6 +167,11 @@ class LazyBuffer {
   LazyBuffer(const Slice& _slice, Cleanable&& _cleanable,
              uint64_t _file_number = uint64_t(-1)) noexcept;
 
+  // Init from cleanup function for slice, the slice lives up to "_pin_level"
+  LazyBuffer(const Slice& _slice, Cleanable&& _cleanable,
+             LazyBufferPinLevel _pin_level,
+             uint64_t _file_number = uint64_t(-1)) noexcept;
+
   // Init from customize state
   LazyBuffer(const LazyBufferState* _state, const LazyBufferContext& _context,
              const Slice& _slice = Slice::Invalid(),
@@ -286,6 +299,11 @@ class LazyBuffer {
   void reset(const Slice& _slice, Cleanable&& _cleanable,
              uint64_t _file_number = uint64_t(-1));
 
+  // Reset cleanup function for slice, the slice lives up to "_pin_level"
+  void reset(const Slice& _slice, Cleanable&& _cleanable,
+             LazyBufferPinLevel _pin_level,
+             uint64_t _file_number = uint64_t(-1));
+
   // Reset to customize state
   void reset(const LazyBufferState* _state, const LazyBufferContext& _context,
              const Slice& _slice = Slice::Invalid(),
@@ -352,6 +370,11 @@ inline LazyBufferContext* LazyBufferState::get_context(LazyBuffer* buffer) {
   return &buffer->context_;
 }
 
+inline const LazyBufferState* LazyBufferState::get_state(
+    const LazyBuffer* buffer) {
+  return buffer->state_;
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
@@ -399,6 +422,15 @@ inline LazyBuffer::LazyBuffer(const Slice& _slice, Cleanable&& _cleanable,
   ::new (&context_) Cleanable(std::move(_cleanable));
 }
 
+inline LazyBuffer::LazyBuffer(const Slice& _slice, Cleanable&& _cleanable,
+                              LazyBufferPinLevel _pin_level,
+                              uint64_t _file_number) noexcept
+    : LazyBuffer(_slice, std::move(_cleanable), _file_number) {
+  if (_pin_level == LazyBufferPinLevel::DB) {
+    state_ = LazyBufferState::cleanable_db_state();
+  }
+}
+
 inline LazyBuffer::LazyBuffer(const LazyBufferState* _state,
                               const LazyBufferContext& _context,
                               const Slice& _slice,
@@ -488,6 +520,15 @@ inline void LazyBuffer::reset(const Slice& _slice, Cleanable&& _cleanable,
   file_number_ = _file_number;
 }
 
+inline void LazyBuffer::reset(const Slice& _slice, Cleanable&& _cleanable,
+                              LazyBufferPinLevel _pin_level,
+                              uint64_t _file_number) {
+  reset(_slice, std::move(_cleanable), _file_number);
+  if (_pin_level == LazyBufferPinLevel::DB) {
+    state_ = LazyBufferState::cleanable_db_state();
+  }
+}
+
 inline void LazyBuffer::reset(const LazyBufferState* _state,
                               const LazyBufferContext& _context,
                               const Slice& _slice, uint64_t _file_number) {
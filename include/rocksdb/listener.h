@@ -99,6 +99,10 @@ enum class CompactionReason : int {
   kGarbageCollection,
   // Found RangeDeletion
   kRangeDeletion,
+  // [Level] Rewrite bottommost files older than cold_recompress_seconds
+  kColdRecompress,
+  // [Level] Move files to the path that hot_path_levels places them on
+  kPathMigration,
   // total number of compaction reasons, new reasons must be added above this.
   kNumOfReasons,
 };
@@ -124,6 +128,7 @@ enum class BackgroundErrorReason {
   kCompaction,
   kWriteCallback,
   kMemTable,
+  kChecksumScrub,
 };
 
 enum class WriteStallCondition {
@@ -132,6 +137,15 @@ enum class WriteStallCondition {
   kStopped,
 };
 
+// The limit of a column family that delays or stops the writes
+enum class WriteStallCause {
+  kNone,
+  kMemtableLimit,
+  kL0FileCountLimit,
+  kPendingCompactionBytes,
+  kReadAmpLimit,
+};
+
 struct WriteStallInfo {
   // the name of the column family
   std::string cf_name;
@@ -140,6 +154,49 @@ struct WriteStallInfo {
     WriteStallCondition cur;
     WriteStallCondition prev;
   } condition;
+  // the limit behind the condition, kNone while it is kNormal
+  struct {
+    WriteStallCause cur;
+    WriteStallCause prev;
+  } cause;
+  // what the current condition was decided on
+  int num_unflushed_memtables;
+  int num_l0_files;
+  uint64_t pending_compaction_bytes;
+  double read_amplification;
+};
+
+struct HotKeyInfo {
+  // the column family of the key, cf_name is empty when it was dropped
+  uint32_t cf_id;
+  std::string cf_name;
+  std::string key;
+  // estimated number of reads and writes, see HotKeysInfo
+  uint64_t count;
+};
+
+struct HotBlockInfo {
+  // the table file and the offset of the data block in it
+  uint64_t file_number;
+  uint64_t offset;
+  // estimated number of reads, see HotKeysInfo
+  uint64_t count;
+};
+
+// The heavy hitters found by DBOptions::hot_key_sample_rate. The counts are
+// estimated from the samples and halved after every report, so they weigh
+// recent accesses most.
+struct HotKeysInfo {
+  // the name of the database
+  std::string db_name;
+  // the keys of Get() and of the Put() and Merge() writes, hottest first
+  std::vector<HotKeyInfo> keys;
+  // estimated number of all the keys read and written
+  uint64_t total_keys;
+  // the data blocks of the block based tables, hottest first
+  std::vector<HotBlockInfo> blocks;
+  // estimated number of all the data blocks read
+  uint64_t total_blocks;
 };
 
 #ifndef ROCKSDB_LITE
@@ -448,8 +505,20 @@ class EventListener {
   // Note that the this function must be implemented in a way such that
   // it should not run for an extended period of time before the function
   // returns.  Otherwise, RocksDB may be blocked.
+  //
+  // A change of the cause of a stall under the same condition, see
+  // WriteStallInfo::cause, is reported as well.
   virtual void OnStallConditionsChanged(const WriteStallInfo& /*info*/) {}
 
+  // A callback function for RocksDB which will be called every
+  // stats_dump_period_sec with the hottest keys and data blocks, when
+  // DBOptions::hot_key_sample_rate is set and anything was sampled.
+  //
+  // Note that the this function must be implemented in a way such that
+  // it should not run for an extended period of time before the function
+  // returns.  Otherwise, RocksDB may be blocked.
+  virtual void OnHotKeysDetected(const HotKeysInfo& /*info*/) {}
+
   // A callback function for RocksDB which will be called whenever a file read
   // operation finishes.
   virtual void OnFileReadFinish(const FileOperationInfo& /* info */) {}
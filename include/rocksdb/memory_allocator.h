@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "rocksdb/status.h"
@@ -12,6 +13,14 @@
 
 namespace TERARKDB_NAMESPACE {
 
+struct MemoryAllocatorStats {
+  // Bytes allocated and not deallocated yet
+  uint64_t allocated_bytes = 0;
+  // Bytes of physical memory held for the allocations, including the
+  // fragmentation and the cached free memory
+  uint64_t resident_bytes = 0;
+};
+
 // MemoryAllocator is an interface that a client can implement to supply custom
 // memory allocation and deallocation methods. See rocksdb/cache.h for more
 // information.
@@ -35,6 +44,11 @@ class MemoryAllocator {
     // default implementation just returns the allocation size
     return allocation_size;
   }
+
+  // Fills stats if the allocator keeps its own, NotSupported otherwise
+  virtual Status GetStats(MemoryAllocatorStats* /*stats*/) const {
+    return Status::NotSupported();
+  }
 };
 
 struct JemallocAllocatorOptions {
@@ -52,6 +66,12 @@ struct JemallocAllocatorOptions {
   // Upper bound of allocation size to use tcache, if limit_tcache_size=true.
   // When used with block cache, it is recommneded to set it to block_size.
   size_t tcache_size_upper_bound = 16 * 1024;
+
+  // Whether to exclude the memory of the arena from core dump. If false,
+  // the allocator only gives its users an arena and tcaches of their own,
+  // e.g. to keep the buffers of one purpose from fragmenting the heap of the
+  // others.
+  bool dont_dump = true;
 };
 
 // Generate memory allocators which allocates through Jemalloc and utilize
@@ -65,7 +85,7 @@ struct JemallocAllocatorOptions {
 // The memory allocator hooks memory allocation of the arena, and call
 // madvice() with MADV_DONTDUMP flag to exclude the piece of memory from
 // core dump. Side benefit of using single arena would be reduce of jemalloc
-// metadata for some workload.
+// metadata for some workload. GetStats() returns the stats of the arena.
 //
 // To mitigate mutex contention for using one single arena, jemalloc tcache
 // (thread-local cache) is enabled to cache unused allocations for future use.
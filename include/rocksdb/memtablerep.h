@@ -436,10 +436,10 @@ extern MemTableRepFactory* NewPatriciaTrieRepFactory(
     class Status* s);
 
 // The factory is to create memtables based on a hash table:
-// it contains a fixed array of buckets, each pointing to a
+// it contains an array of buckets, each pointing to a
 // dualinked list. It also support concurrent updated
 //
-// @bucket_count: number of fixed array buckets
+// @bucket_count: number of initial buckets, rounded up to a power of two
 // @huge_page_tlb_size: if <=0, allocate the hash table bytes from malloc.
 //                      Otherwise from huge page TLB. The user needs to reserve
 //                      huge pages for it to be allocated, like:
@@ -452,11 +452,16 @@ extern MemTableRepFactory* NewPatriciaTrieRepFactory(
 //                                 may cost many time.
 // @if_log_bucket_dist_when_flush: if true, log distribution of number of
 //                                 entries when flushing.
+// @enable_bucket_growth: if true, double the buckets without locking once
+//                        they hold two keys on average, so that the lists
+//                        stay short as the memtable grows. The new buckets
+//                        are allocated from the memtable arena.
 extern MemTableRepFactory* NewConcurrentHashDualListReqFactory(
     size_t bucket_count = 50000, size_t huge_page_tlb_size = 0,
     int bucket_entries_logging_threshold = 4096,
     size_t num_hash_buckets_preallocated = 0,
-    bool if_log_bucket_dist_when_flush = true);
+    bool if_log_bucket_dist_when_flush = true,
+    bool enable_bucket_growth = true);
 
 #endif  // ROCKSDB_LITE
 
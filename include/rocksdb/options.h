@@ -45,6 +45,7 @@ enum InfoLogLevel : unsigned char;
 class SstFileManager;
 class FilterPolicy;
 class Logger;
+class MemoryAllocator;
 class MergeOperator;
 class Snapshot;
 class MemTableRepFactory;
@@ -53,6 +54,7 @@ class Slice;
 class Statistics;
 class InternalKeyComparator;
 class WalFilter;
+class WorkStealingThreadPool;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -302,6 +304,28 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // Default: 0 (init from DBOptions::max_subcompactions.)
   uint32_t max_subcompactions = 8;
 
+  // Split a compaction into up to this many subcompactions per thread. A
+  // thread that finishes its subcompaction early takes the next pending one,
+  // so a skewed key range doesn't leave the other threads idle. The number of
+  // subcompactions is still capped by the number of output files.
+  //
+  // Default: 1 (one subcompaction per thread)
+  //
+  // Dynamically changeable through SetOptions() API
+  uint32_t subcompaction_tasks_per_thread = 1;
+
+  // Scheduling weight of this column family in the compaction and the garbage
+  // collection queues of the DB. Column families close to a write stall go
+  // first, the others are ordered by their compaction score times this
+  // weight, scaled down by their share of the recently compacted bytes. Use a
+  // larger weight for latency sensitive column families. With 0 the column
+  // family only runs when passed over as many times as the queue is long.
+  //
+  // Default: 1
+  //
+  // Dynamically changeable through SetOptions() API
+  uint32_t compaction_schedule_weight = 1;
+
   // Don't separate Value if value.size < blob_size
   // Set size_t(-1) to disable Key Value separation
   // valid [8 , size_t(-1)]
@@ -311,11 +335,26 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // valid [0 , 1]
   double blob_large_key_ratio = 0.25;
 
+  // Target value write amplification of the adaptive separation threshold
+  // Flush and compaction track the value size distribution, the threshold
+  // (never below blob_size) is moved so that the estimated amplification
+  // inline_ratio * num_levels + (1 - inline_ratio) / blob_gc_ratio
+  // approaches this target
+  // 0 to separate by blob_size only
+  double blob_target_write_amp = 0;
+
   // Key Value separation gc ratio
   // Startup GC when garbage ratio larger than blob_gc_ratio
   // valid [0 , 0.5]
   double blob_gc_ratio = 0.05;
 
+  // Weight of read hotness in the blob GC score
+  // score = garbage_ratio * (1 + blob_gc_hotness_weight * hotness), hotness
+  // in [0, 1) grows with the sampled reads per entry per hour of the blob, so
+  // hot blobs with moderate garbage are collected before cold blobs
+  // 0 to pick by garbage ratio only
+  double blob_gc_hotness_weight = 0;
+
   // Blob file size
   // Default : same as bottommost level sst file size
   uint64_t target_blob_file_size = 0;
@@ -328,6 +367,17 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // 0 to unlimited
   size_t max_dependence_blob_overlap = 1024;
 
+  // Cut the blob files written by a compaction where its SSTs are cut, once
+  // they hold blob_file_defragment_size bytes, so that a blob file is only
+  // referenced by one SST and the blobs rebuilt past
+  // max_dependence_blob_overlap do not overlap again
+  bool align_blob_output_to_sst = false;
+
+  // Max SSTs a key range of map SSTs may link, composite compaction
+  // merges the ranges beyond it first
+  // 0 to unlimited
+  size_t max_map_sst_read_amp = 0;
+
   // This is a factory that provides TableFactory objects.
   // Default: a block-based table factory that provides a default
   // implementation of TableBuilder and TableReader with default
@@ -360,6 +410,63 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // Default: 0
   size_t ttl_max_scan_gap = 0;
 
+  // Time-series mode for column families with ttl_extractor_factory. The
+  // SSTs whose entries all have a ttl are bucketed into windows of this many
+  // seconds by the time their last entry expires:
+  //  - compaction cuts its output files where the expiry window of the keys
+  //    changes, so an output file holds the entries of one window when the
+  //    keys of a window are adjacent, as with time ordered keys
+  //  - such an SST is not rewritten by the ttl_gc_ratio marking, it is
+  //    dropped wholesale once its window has passed, when no older SST
+  //    overlaps it and no snapshot can read it. Otherwise it falls back to
+  //    the marking.
+  // If the value is 0, time windows are disabled.
+  // Default: 0
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t ttl_window_seconds = 0;
+
+  // Bottommost SSTs created more than this many seconds ago are rewritten
+  // in place by a background compaction (CompactionReason::kColdRecompress)
+  // so the table factory can recompress cold data with stronger settings.
+  // At most one such compaction runs per column family, and only when no
+  // other compaction is running in it. Only for level style compaction
+  // without enable_lazy_compaction.
+  // If the value is 0, cold recompression is disabled.
+  // Default: 0
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t cold_recompress_seconds = 0;
+
+  // Places files by hotness instead of by target size when cf_paths (or
+  // db_paths) has more than one path. SSTs of levels below hot_path_levels
+  // go on the first path, SSTs of deeper levels and blob files rewritten by
+  // garbage collection go on the last path. Blob files separated by flush
+  // or compaction go with the SSTs that are written along with them. When
+  // levels cool down, SSTs left on the wrong path are moved in the
+  // background, one file at a time when no other compaction runs in the
+  // column family (CompactionReason::kPathMigration). Put the WAL on the
+  // fast device with wal_dir. Only for level style compaction.
+  // If the value is 0, files are placed by target size.
+  // Default: 0
+  //
+  // Dynamically changeable through SetOptions() API
+  int hot_path_levels = 0;
+
+  // Bounds the space amplification, the size of the SSTs and blob SSTs over
+  // the estimated size of the live data in them, in percent (see the
+  // "rocksdb.estimate-space-amplification" property). The live data is
+  // estimated from the ranges of the map SSTs reaching into the SSTs behind
+  // them and from the blob garbage. Beyond the bound, garbage collection
+  // runs regardless of blob_gc_ratio when blob garbage is most of the
+  // excess, otherwise the sorted run of map SSTs reaching the least of
+  // their SSTs is compacted first (CompactionReason::kCompositeAmplification).
+  // If the value is 0, the space amplification is not bounded.
+  // Default: 0
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t max_space_amplification_percent = 0;
+
   // Create ColumnFamilyOptions with default values for all fields
   ColumnFamilyOptions();
   // Create ColumnFamilyOptions from Options
@@ -466,6 +573,27 @@ struct DBOptions {
   // Default: nullptr
   std::shared_ptr<SstFileManager> sst_file_manager = nullptr;
 
+  // If not nullptr, the parallel parts of the background jobs run in this
+  // pool instead of the pool of env at the priority of the job: the
+  // subcompactions and the verification of the output files of a
+  // compaction, and the index and value store builds of TerarkZip tables.
+  // A thread of the pool scheduling more work keeps it in its own queue and
+  // the idle threads steal it, see NewWorkStealingThreadPool(). Can be
+  // shared between multiple dbs.
+  //
+  // Default: nullptr
+  std::shared_ptr<WorkStealingThreadPool> parallel_task_pool = nullptr;
+
+  // If not nullptr, the write buffers of the SST and blob files output by
+  // flushes and compactions are allocated from it instead of the global
+  // malloc, e.g. a jemalloc arena of their own, see
+  // NewJemallocNodumpAllocator(). These buffers are large and short lived,
+  // and fragment the heap shared with the long lived allocations. Can be
+  // shared between multiple dbs.
+  //
+  // Default: nullptr
+  std::shared_ptr<MemoryAllocator> compaction_buffer_allocator = nullptr;
+
   // Any internal progress/error information generated by the db will
   // be written to info_log if it is non-nullptr, or to a file stored
   // in the same directory as the DB contents if info_log is nullptr.
@@ -631,6 +759,20 @@ struct DBOptions {
   // Default: -1
   int max_background_flushes = -1;
 
+  // Maximum number of files a single flush job may split its memtables into.
+  // When the memtables picked by a flush are large, their key range is cut
+  // into up to this many partitions at user key boundaries and each
+  // partition is written to its own file, in parallel on the HIGH priority
+  // thread pool and the flush thread, so one big memtable does not leave a
+  // single flush thread as the bottleneck. The partitions are linked by one
+  // map sst, which is the only file the flush adds to L0.
+  // Only column families with enable_lazy_compaction split their flushes.
+  // Flushes that carry range deletions, or that are part of an atomic flush,
+  // always produce one file.
+  //
+  // Default: 1 (never split)
+  uint32_t max_flush_partitions = 1;
+
   // Specify the maximal size of the info log file. If the log file
   // is larger than `max_log_file_size`, a new info log file will
   // be created.
@@ -669,6 +811,12 @@ struct DBOptions {
   uint64_t max_manifest_file_size = 1024 * 1024 * 1024;
   uint64_t max_manifest_edit_count = 4096;
 
+  // manifest file is also rolled over once the edits appended after the
+  // snapshot at its head grow beyond this multiple of the snapshot, which
+  // keeps the tail replayed by recovery in proportion to the state itself.
+  // Tails smaller than 1MB never trigger a roll over. 0 disables the limit.
+  double max_manifest_tail_ratio = 4;
+
   // Number of shards used for table cache.
   int table_cache_numshardbits = 6;
 
@@ -726,6 +874,14 @@ struct DBOptions {
   // If false, fallocate() calls are bypassed
   bool allow_fallocate = true;
 
+  // If true, files other than the WAL are written through a background
+  // thread per file: once the write buffer fills up, it is handed to that
+  // thread together with the bytes_per_sync range syncs, and the writer
+  // keeps filling a second buffer. Flush(), Sync() and Close() wait for the
+  // outstanding write. Ignored with direct I/O.
+  // Default: false
+  bool use_async_file_writes = false;
+
   // Disable child process inherit open files. Default: true
   bool is_fd_close_on_exec = true;
 
@@ -755,10 +911,49 @@ struct DBOptions {
   // which have previously set persist_stats_to_disk to true, the column family
   // creation will fail, but the hidden column family will survive, as well as
   // the previously persisted statistics.
-  // When peristing stats to disk, the stat name will be limited at 100 bytes.
+  // The snapshots are kept for a day, and rolled up per minute (kept for 7
+  // days), per hour (90 days) and per day (forever), see
+  // StatsHistoryGranularity.
   // Default: false
   bool persist_stats_to_disk = false;
 
+  // If not zero, a background scrubber walks all live SST and blob files and
+  // verifies their checksums through TableReader::VerifyChecksum(), reading
+  // at most this many bytes per second on average. A mismatch is reported
+  // to EventListener::OnBackgroundError() with
+  // BackgroundErrorReason::kChecksumScrub, and stops writes if
+  // paranoid_checks is set.
+  // Default: 0 (off)
+  uint64_t checksum_scrub_bytes_per_sec = 0;
+
+  // If not zero, one in this many keys of Get(), Put() and Merge(), and one
+  // in this many data block reads of the block based tables, are sampled to
+  // find the hottest keys and blocks. They are reported through the
+  // "rocksdb.hot-keys" property and EventListener::OnHotKeysDetected().
+  // Writes through DB::Write() are sampled too, keys read by iterators and
+  // MultiGet() are not.
+  // Default: 0 (off)
+  uint32_t hot_key_sample_rate = 0;
+
+  // The number of hottest keys and of hottest blocks kept, see
+  // hot_key_sample_rate.
+  // Default: 16
+  size_t hot_key_top_k = 16;
+
+  // If not zero, a flush, compaction or garbage collection failed by an I/O
+  // error other than running out of space is retried up to this many times
+  // in a row before the error is handled as background error, which may stop
+  // writes, see paranoid_checks. The failed flushes do not stop writes
+  // meanwhile, they are stalled only as the immutable memtables pile up.
+  // Default: 0 (off)
+  int max_bgerror_resume_count = 0;
+
+  // The wait before the first retry of a failed background job, see
+  // max_bgerror_resume_count. It doubles with each further retry in a row,
+  // up to 64 times this.
+  // Default: 1 second
+  uint64_t bgerror_resume_retry_interval = 1000000;
+
   // if not zero, periodically take stats snapshots and store in memory, the
   // memory size for stats snapshots is capped at stats_history_buffer_size
   // Default: 1MB
@@ -926,6 +1121,18 @@ struct DBOptions {
   // Dynamically changeable through SetDBOptions() API.
   uint64_t delayed_write_rate = 0;
 
+  // If true, a column family that delays writes derives its write rate from
+  // how close it is to a stop condition, instead of stepping the shared rate
+  // up and down by a fixed ratio on every recalculation. The rate falls
+  // continuously from `delayed_write_rate` at the slowdown triggers to
+  // 16KB/s at the stop triggers, taking the worst of L0 files, pending
+  // compaction bytes, read amplification, unflushed memtables and blob
+  // garbage. Writes are metered at the lowest rate any column family asks
+  // for.
+  //
+  // Default: false
+  bool smooth_write_delay = false;
+
   // By default, a single write thread queue is maintained. The thread gets
   // to the head of the queue becomes write batch group leader and responsible
   // for writing to WAL and memtable for the batch group.
@@ -978,6 +1185,26 @@ struct DBOptions {
   // Default: 3
   uint64_t write_thread_slow_yield_usec = 3;
 
+  // The maximum limit of number of bytes that are written in a single batch
+  // of WAL or memtable write. It is followed when the leader write size
+  // is larger than 1/8 of this limit.
+  // A larger limit lets one WAL write and sync cover more writers, which
+  // raises write throughput on fast devices at the cost of the latency of
+  // the small writes queued behind a big group.
+  //
+  // Default: 1 MB
+  uint64_t max_write_batch_group_size_bytes = 1 << 20;
+
+  // If non-zero, the leader of a write group holding a sync write may wait
+  // up to this many microseconds for more writers to join before it writes
+  // and syncs the WAL, so that one fsync covers more writes. The leader only
+  // waits when the recent arrival rate of writers predicts that another one
+  // comes within the window, so sparse writes are not delayed. This bounds
+  // the latency added to each sync write.
+  //
+  // Default: 0 (disabled)
+  uint64_t max_write_group_commit_delay_usec = 0;
+
   // Deprecated
   bool skip_stats_update_on_db_open = false;
 
@@ -985,6 +1212,14 @@ struct DBOptions {
   // Default: kPointInTimeRecovery
   WALRecoveryMode wal_recovery_mode = WALRecoveryMode::kPointInTimeRecovery;
 
+  // If non-zero, WAL recovery reads and checksums log records on a separate
+  // thread, keeping up to this many bytes of records buffered ahead of the
+  // memtable replay. Reading the log then overlaps with inserting into
+  // memtables and with the flushes triggered during recovery.
+  //
+  // Default: 0 (read and replay on the same thread)
+  uint64_t wal_recovery_readahead_size = 0;
+
   // if set to false then recovery will fail when a prepared
   // transaction is encountered in the WAL
   bool allow_2pc = false;
@@ -994,6 +1229,31 @@ struct DBOptions {
   // Not supported in ROCKSDB_LITE mode!
   std::shared_ptr<Cache> row_cache = nullptr;
 
+  // A global cache for separated values, keyed by blob file number and
+  // internal key. Large values are kept here instead of the block cache, so
+  // they don't evict index and data blocks of the key sst.
+  // Default: nullptr (disabled)
+  std::shared_ptr<Cache> blob_cache = nullptr;
+
+  // If non-zero, each column family remembers the hashes of up to this many
+  // user keys that Get() recently did not find. Repeated lookups of such
+  // keys return NotFound without probing memtables, filters or files, until
+  // the key is written or a new SuperVersion is installed by a flush,
+  // compaction or file ingestion. Costs 24 bytes per entry and a hash of the
+  // key on every write. Lookups with a ReadCallback, a read_tier other than
+  // kReadAllTier or ignore_range_deletions bypass the cache.
+  //
+  // A 64 bit key hash identifies an entry, so two keys with the same hash
+  // may share a negative answer.
+  //
+  // Default: 0 (disabled)
+  size_t negative_lookup_cache_size = 0;
+
+  // Builds the latency and QPS reporters of the DB and of each column
+  // family, a reporter is tagged with the db name and, for a column family,
+  // the column family name.
+  //
+  // Default: nullptr, the ByteDanceMetricsReporterFactory
   std::shared_ptr<MetricsReporterFactory> metrics_reporter_factory = nullptr;
 
 #ifndef ROCKSDB_LITE
@@ -1071,6 +1331,16 @@ struct DBOptions {
   // file.
   bool manual_wal_flush = false;
 
+  // Compression of the WAL records, kZSTD or kNoCompression. Records are
+  // compressed as a stream, in frames that are ended after a bounded number
+  // of bytes, so that recovery decompresses several frames in parallel, on
+  // up to max_background_jobs threads. The compression type is recorded at
+  // the start of each log, which older versions cannot read. Unsupported
+  // types are sanitized to kNoCompression.
+  //
+  // Default: kNoCompression
+  CompressionType wal_compression = kNoCompression;
+
   // If true, RocksDB supports flushing multiple column families and committing
   // their results atomically to MANIFEST. Note that it is not
   // necessary to set atomic_flush to true if WAL is always enabled since WAL
@@ -1182,6 +1452,21 @@ struct ReadOptions {
   // Default: 0
   size_t readahead_size;
 
+  // If non-zero, forward iteration fetches separated values through one
+  // iterator per blob SST, each with a table reader performing reads of the
+  // given size. Blob SSTs are ordered by key, so values of consecutive keys
+  // share data blocks instead of issuing one random read each.
+  // Default: 0
+  size_t blob_readahead_size;
+
+  // If non-zero, forward iteration over block based tables keeps prefetch
+  // hints outstanding for the next async_prefetch_depth data blocks, found
+  // from the index. Adjacent blocks are coalesced into one hint, so the
+  // device sees a few large reads in flight instead of one block at a time.
+  // Ignored with direct reads, and when readahead_size is non-zero.
+  // Default: 0
+  size_t async_prefetch_depth;
+
   // A threshold for the number of keys that can be skipped before failing an
   // iterator seek as incomplete. The default value of 0 should be used to
   // never fail a request as incomplete, even on skipping too many keys.
@@ -1246,7 +1531,10 @@ struct ReadOptions {
   // Default: false
   bool ignore_range_deletions;
 
-  // now only used by MultiGet
+  // Number of fibers of the calling thread serving MultiGet, GetAsync and
+  // MultiGetAsync, the reads of a fiber yield to the others when
+  // DBOptions::use_aio_reads is true. 0 disables the fibers of MultiGet.
+  // Only has effect with BOOSTLIB.
   int aio_concurrency;
 
   // A callback to determine whether relevant keys for this scan exist in a
@@ -1264,6 +1552,21 @@ struct ReadOptions {
   // Default: 0 (don't filter by seqnum, return user keys)
   SequenceNumber iter_start_seqnum;
 
+  // If non-nullptr, Get, MultiGet and iterators return the output of
+  // value_projection->Extract(user_key, value) instead of the value, e.g.
+  // one field of a serialized record. The extractor must outlive the reads
+  // and iterators using it.
+  // Default: nullptr
+  const ValueExtractor* value_projection;
+
+  // Set if value_projection extracts the same bytes as the extractors of
+  // the column family's value_meta_extractor_factory. The value meta of a
+  // separated value is kept beside its index, so the projection of the
+  // latest separated value of a key is then read without fetching the value
+  // from its blob SST. Ignored without value_meta_extractor_factory.
+  // Default: false
+  bool value_projection_is_meta;
+
   ReadOptions();
   ReadOptions(bool cksum, bool cache);
 };
@@ -1462,4 +1765,28 @@ struct TraceOptions {
   uint64_t max_trace_file_size = uint64_t{64} * 1024 * 1024 * 1024;
 };
 
+// PerfTraceOptions is used for StartPerfTrace
+struct PerfTraceOptions {
+  // Every sample_rate-th Get, MultiGet, iterator Seek, SeekForPrev and Write
+  // of a thread is traced with its PerfContext and IOStatsContext, which
+  // the sampled operation resets. Threads with a PerfLevel above
+  // kEnableCount time their operations themselves and are never sampled.
+  uint32_t sample_rate = 1000;
+  // Samples are written by a background thread, a sample finding this many
+  // waiting is dropped
+  size_t max_pending_samples = 1024;
+  // The trace stops growing at this size in bytes. Default is 64GB
+  uint64_t max_trace_file_size = uint64_t{64} * 1024 * 1024 * 1024;
+};
+
+// TableAccessTraceOptions is used for StartTableAccessTrace
+struct TableAccessTraceOptions {
+  // One in sampling_frequency records is traced, chosen by the hash of the
+  // record so a traced record keeps all of its accesses. 0 and 1 trace all
+  // of them.
+  uint32_t sampling_frequency = 1;
+  // The trace stops growing at this size in bytes. Default is 64GB
+  uint64_t max_trace_file_size = uint64_t{64} * 1024 * 1024 * 1024;
+};
+
 }  // namespace TERARKDB_NAMESPACE
@@ -32,10 +32,13 @@ struct PerfContextByLevel {
 
   // total number of user key returned (only include keys that are found, does
   // not include keys that are deleted or merged without a final put
-  uint64_t user_key_return_count;
+  uint64_t user_key_return_count = 0;
+
+  // total number of SST files queried by Get and MultiGet
+  uint64_t get_from_table_count = 0;
 
   // total nanos spent on reading data from SST files
-  uint64_t get_from_table_nanos;
+  uint64_t get_from_table_nanos = 0;
 
   void Reset();  // reset all performance counters to zero
 };
@@ -108,6 +111,8 @@ struct PerfContext {
   // total nanos spent after Get() finds a key
   uint64_t get_post_process_time;
   uint64_t get_from_output_files_time;  // total nanos reading from output files
+  uint64_t blob_fetch_count;  // number of values fetched from blob SSTs
+  uint64_t blob_fetch_time;   // total nanos spent on fetching blob values
   // total nanos spent on seeking memtable
   uint64_t seek_on_memtable_time;
   // number of seeks issued on memtable
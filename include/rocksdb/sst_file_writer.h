@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
@@ -135,6 +136,51 @@ class SstFileWriter {
   struct Rep;
   std::unique_ptr<Rep> rep_;
 };
+
+// ParallelSstFileWriter builds a set of external sst files with
+// non-overlapping ranges from one sorted stream of keys, for offline bulk
+// loads. The stream is cut into files of about target_file_size bytes of raw
+// keys and values. Up to max_threads files are built concurrently, each by
+// its own SstFileWriter, in the table format of options.table_factory. All
+// the files can be passed to a single IngestExternalFile call.
+//
+// The entries of the files waiting for or being built are buffered in
+// memory, which bounds the memory use to about max_threads *
+// target_file_size.
+class ParallelSstFileWriter {
+ public:
+  ParallelSstFileWriter(const EnvOptions& env_options, const Options& options,
+                        ColumnFamilyHandle* column_family = nullptr,
+                        int max_threads = 4,
+                        uint64_t target_file_size = 64 << 20);
+
+  ~ParallelSstFileWriter();
+
+  // Prepare to write files named file_prefix followed by the file index and
+  // ".sst", e.g. "/path/to/bulk_0.sst" for "/path/to/bulk_"
+  Status Open(const std::string& file_prefix);
+
+  // Add a Put key with value
+  // REQUIRES: key is after any previously added key according to comparator.
+  Status Put(const Slice& user_key, const Slice& value);
+
+  // Add a Merge key with value
+  // REQUIRES: key is after any previously added key according to comparator.
+  Status Merge(const Slice& user_key, const Slice& value);
+
+  // Add a deletion key
+  // REQUIRES: key is after any previously added key according to comparator.
+  Status Delete(const Slice& user_key);
+
+  // Wait for all files to be built. If file_infos is not null, it's filled
+  // with the information of the created files, in key order. If building any
+  // file failed, the first error is returned and all files are deleted.
+  Status Finish(std::vector<ExternalSstFileInfo>* file_infos = nullptr);
+
+ private:
+  struct Rep;
+  std::unique_ptr<Rep> rep_;
+};
 }  // namespace TERARKDB_NAMESPACE
 
 #endif  // !ROCKSDB_LITE
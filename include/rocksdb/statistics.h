@@ -258,6 +258,38 @@ enum Tickers : uint32_t {
   GC_TOUCH_FILES,
   GC_SKIP_GET_BY_SEQ,
   GC_SKIP_GET_BY_FILE,
+
+  // # of separated value hits/misses in blob cache
+  BLOB_CACHE_HIT,
+  BLOB_CACHE_MISS,
+
+  // # of TerarkZipTable pread value hits/misses in record cache
+  TERARK_ZIP_RECORD_CACHE_HIT,
+  TERARK_ZIP_RECORD_CACHE_MISS,
+
+  // # of inserts/bytes rejected by a cache admission filter
+  CACHE_ADMISSION_REJECT,
+  CACHE_ADMISSION_REJECT_BYTES,
+
+  // # of Get() answered/not answered by the negative lookup cache
+  NEGATIVE_LOOKUP_CACHE_HIT,
+  NEGATIVE_LOOKUP_CACHE_MISS,
+
+  // Bytes granted by the rate limiter to each IO priority
+  RATE_LIMITER_LOW_PRI_BYTES,
+  RATE_LIMITER_MID_PRI_BYTES,
+  RATE_LIMITER_HIGH_PRI_BYTES,
+
+  // Bytes of blob SSTs read/written by garbage collection
+  GC_READ_BYTES,
+  GC_WRITE_BYTES,
+
+  // STALL_MICROS by the limit that delayed or stopped the writes. A write
+  // held back by several column families counts for each of their limits.
+  STALL_MEMTABLE_LIMIT_MICROS,
+  STALL_L0_FILE_COUNT_LIMIT_MICROS,
+  STALL_PENDING_COMPACTION_BYTES_MICROS,
+  STALL_READ_AMP_LIMIT_MICROS,
   TICKER_ENUM_MAX
 };
 
@@ -320,6 +352,12 @@ enum Histograms : uint32_t {
   PICK_GARBAGE_COLLECTION_TIME,
   INSTALL_SUPER_VERSION_TIME,
   BUILD_VERSION_TIME,
+  // Time TerarkZipTable builds waited for zip working memory
+  TERARK_ZIP_MEMORY_WAIT_MICROS,
+  // File operations timed by the env of NewIOProfEnv
+  IO_PROF_READ_MICROS,
+  IO_PROF_WRITE_MICROS,
+  IO_PROF_SYNC_MICROS,
 
   HISTOGRAM_ENUM_MAX,
 };
@@ -387,6 +425,11 @@ class Statistics {
   }
 
   StatsLevel stats_level_ = kExceptDetailedTimers;
+  // Each thread times one in every timer_sample_rate_ operations that only
+  // feed a histogram, which saves the clock reads of the others. The
+  // histograms then count the sampled operations only, their percentiles
+  // stay representative. 1 times every operation.
+  uint32_t timer_sample_rate_ = 1;
 };
 
 // Create a concrete DBStatistics object
@@ -19,6 +19,17 @@ namespace TERARKDB_NAMESPACE {
 
 class DBImpl;
 
+// Resolution of the stats history records
+enum class StatsHistoryGranularity : unsigned char {
+  // The stats taken every stats_persist_period_sec
+  kSnapshot = 0,
+  // Sums of the snapshots taken within a minute, an hour or a day (UTC), only
+  // kept with persist_stats_to_disk
+  kMinute = 1,
+  kHour = 2,
+  kDay = 3,
+};
+
 class StatsHistoryIterator {
  public:
   StatsHistoryIterator() {}
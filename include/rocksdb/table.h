@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rocksdb/cache.h"
 #include "rocksdb/env.h"
@@ -38,6 +39,7 @@ class RandomAccessFile;
 struct TableReaderOptions;
 struct TableBuilderOptions;
 class TableBuilder;
+class TableFactorySelector;
 class TableReader;
 class WritableFileWriter;
 struct EnvOptions;
@@ -50,6 +52,8 @@ enum ChecksumType : char {
   kCRC32c = 0x1,
   kxxHash = 0x2,
   kxxHash64 = 0x3,
+  // XXH3 64 bits, truncated. The fastest on modern CPUs, at every block size.
+  kXXH3 = 0x4,
 };
 
 // For advanced user only
@@ -144,6 +148,13 @@ struct BlockBasedTableOptions {
   //       same type of object there.
   std::shared_ptr<Cache> block_cache_compressed = nullptr;
 
+  // If not kNoCompression, blocks stored uncompressed in the file are
+  // compressed with this type before going into block_cache_compressed, so
+  // the compressed cache also extends the memory of uncompressed tables.
+  // Hits are decompressed and promoted into block_cache as usual. Blocks
+  // which don't compress well are not kept. LZ4 or ZSTD are good choices.
+  CompressionType block_cache_compressed_compression = kNoCompression;
+
   // Approximate size of user data packed per block.  Note that the
   // block size specified here corresponds to uncompressed data.  The
   // actual size of the unit read from disk may be smaller if
@@ -199,6 +210,15 @@ struct BlockBasedTableOptions {
   // This must generally be true for gets to be efficient.
   bool whole_key_filtering = true;
 
+  // If true and no prefix_extractor is configured, the full filter of every
+  // table also holds the key prefixes of a length picked from the table's
+  // first keys, so that seeks bounded by iterate_upper_bound within one such
+  // prefix can skip the table. Only applies to full filters that are not
+  // partitioned, with the bytewise comparator.
+  //
+  // Default: true
+  bool auto_prefix_filtering = true;
+
   // Verify that decompressing the compressed block gives back the input. This
   // is a verification mode that we use to detect bugs in compression
   // algorithms.
@@ -259,6 +279,17 @@ struct BlockBasedTableOptions {
 
   // Align data blocks on lesser of page size and block size
   bool block_align = false;
+
+  // Declares the leading fixed size columns of the values, as byte widths
+  // separated by ':', e.g. "4:8:8". When set, every compressed data block is
+  // compressed with each column of its values stored apart from the other
+  // columns and from the keys, which suits values of a fixed layout such as
+  // records or documents with fixed fields. A value shorter than the columns
+  // just fills the leading ones. The blocks are restored to rows when they
+  // are uncompressed, so reads and the block cache are not affected.
+  // Tables written with this option can not be read by older versions.
+  // Default: "" (values are compressed as rows)
+  std::string value_column_widths;
 };
 
 // Table Properties that are specific to block-based table properties.
@@ -269,6 +300,12 @@ struct BlockBasedTablePropertyNames {
   static const std::string kWholeKeyFiltering;
   // value is "1" for true and "0" for false.
   static const std::string kPrefixFiltering;
+  // value is the varint64 prefix length in the filter of auto prefix
+  // filtering, missing when no length was picked.
+  static const std::string kAutoPrefixLength;
+  // value is a sequence of varint64, the count of distinct adjacent keys
+  // sharing each common prefix length, capped at the largest length.
+  static const std::string kKeyPrefixLengthHistogram;
 };
 
 // Create default block based table factory.
@@ -360,6 +397,13 @@ struct PlainTableOptions {
 // it work. Look-up will starts with prefix hash lookup for key prefix. Inside
 // the hash bucket found, a binary search is executed for hash conflicts.
 // Finally, a linear search is used.
+//
+// Seeks with ReadOptions::total_order_seek, SeekForPrev(), SeekToLast() and
+// Prev() scan from a sampled record instead, and range deletions are kept in
+// a meta block, so the tables can hold separated values and be the
+// dependencies of map SSTs under lazy compaction. To keep only the hottest
+// levels in plain tables, pass this factory as the fallback of
+// NewTerarkZipTableFactory() with a terarkZipMinLevel above them.
 
 extern TableFactory* NewPlainTableFactory(
     const PlainTableOptions& options = PlainTableOptions());
@@ -423,9 +467,14 @@ struct CuckooTableOptions {
   // power of two, and bit and is used to calculate hash, which is faster in
   // general.
   bool use_module_hash = true;
+  // If this option is set to true, only the files of the bottommost level
+  // are built as Cuckoo Tables, the other levels are built as block based
+  // tables. Their keys may then have several versions and any type.
+  bool bottommost_level_only = false;
 };
 
 // Cuckoo Table Factory for SST table format using Cache Friendly Cuckoo Hashing
+// Map SSTs of lazy compaction are built and read as block based tables.
 extern TableFactory* NewCuckooTableFactory(
     const CuckooTableOptions& table_options = CuckooTableOptions());
 
@@ -532,6 +581,10 @@ class TableFactory
 
   // Return if table builder need second pass iter
   virtual bool IsBuilderNeedSecondPass() const { return false; }
+
+  // Return the working memory the table builders of this factory hold for
+  // the tables being built, 0 if it is not tracked
+  virtual size_t GetBuilderMemoryUsage() const { return 0; }
 };
 
 #ifndef ROCKSDB_LITE
@@ -544,11 +597,50 @@ class TableFactory
 // @plain_table_factory: plain table factory to use. If NULL, use a default one.
 // @cuckoo_table_factory: cuckoo table factory to use. If NULL, use a default
 // one.
+// @table_factory_selector: chooses the table factory of each new file. If
+// NULL, or if it returns NULL, use table_factory_to_write. Files that are
+// not block based, plain or cuckoo tables are read by
+// table_factory_to_write, it must be able to read all the other formats
+// the selector chooses, e.g. a TerarkZip table factory selected for the
+// bottommost level.
 extern TableFactory* NewAdaptiveTableFactory(
     std::shared_ptr<TableFactory> table_factory_to_write = nullptr,
     std::shared_ptr<TableFactory> block_based_table_factory = nullptr,
     std::shared_ptr<TableFactory> plain_table_factory = nullptr,
-    std::shared_ptr<TableFactory> cuckoo_table_factory = nullptr);
+    std::shared_ptr<TableFactory> cuckoo_table_factory = nullptr,
+    std::shared_ptr<TableFactorySelector> table_factory_selector = nullptr);
+
+// Chooses the table factory building each new file of an adaptive table
+// factory
+class TableFactorySelector {
+ public:
+  struct Context {
+    // Output level of the file, -1 if unknown
+    int level;
+    int num_levels;
+    SstPurpose sst_purpose;
+    // From 0 when the compactions keep up, to 1 when the writes are about to
+    // stop
+    double compaction_load;
+  };
+
+  virtual ~TableFactorySelector() {}
+
+  virtual const char* Name() const = 0;
+
+  // Returns nullptr to use the table factory to write
+  virtual TableFactory* Select(const Context& context) const = 0;
+};
+
+// Builds the files of level i with level_factories[i], and of the levels
+// past its end with its last element. Once the compaction load reaches
+// busy_load, the files of all levels but the bottommost are built with
+// busy_factory instead, if it is not nullptr, saving CPU at the expense of
+// space. Map SSTs and blob files are left to the table factory to write.
+extern TableFactorySelector* NewLevelTableFactorySelector(
+    std::vector<std::shared_ptr<TableFactory>> level_factories,
+    std::shared_ptr<TableFactory> busy_factory = nullptr,
+    double busy_load = 1);
 
 bool IsCompactionWorkerNode();
 
@@ -71,6 +71,7 @@ struct TablePropertiesNames {
   static const std::string kInheritanceTree;
   static const std::string kEarliestTimeBeginCompact;
   static const std::string kLatestTimeEndCompact;
+  static const std::string kTtlExpiryHistogram;
 };
 
 extern const std::string kPropertiesBlock;
@@ -287,5 +288,11 @@ extern uint64_t GetMergeOperands(const UserCollectedProperties& props,
 extern void GetCompactionTimePoint(const UserCollectedProperties& props,
                                    uint64_t* earliest_time_begin_compact,
                                    uint64_t* latest_time_end_compact);
+// The i-th time point, in seconds, is when (i + 1) / kTtlExpiryHistogramSize
+// of the entries in the table have expired. Time points that the entries with
+// ttl can't reach are left out.
+static const size_t kTtlExpiryHistogramSize = 10;
+extern void GetTtlExpiryHistogram(const UserCollectedProperties& props,
+                                  std::vector<uint64_t>* expiry_time_points);
 
 }  // namespace TERARKDB_NAMESPACE
@@ -73,6 +73,10 @@ struct ThreadStatus {
     STAGE_PICK_MEMTABLES_TO_FLUSH,
     STAGE_MEMTABLE_ROLLBACK,
     STAGE_MEMTABLE_INSTALL_FLUSH_RESULTS,
+    STAGE_GARBAGE_COLLECTION,
+    STAGE_MAP_SST_BUILD,
+    STAGE_TERARK_ZIP_VALUES,
+    STAGE_TERARK_ZIP_WRITE_SST,
     NUM_OP_STAGES
   };
 
@@ -83,6 +87,10 @@ struct ThreadStatus {
     COMPACTION_TOTAL_INPUT_BYTES,
     COMPACTION_BYTES_READ,
     COMPACTION_BYTES_WRITTEN,
+    // Uncompressed input bytes processed by all the subcompactions, and the
+    // estimate of all of them, see GetOperationProgress()
+    COMPACTION_PROGRESS_BYTES_DONE,
+    COMPACTION_PROGRESS_BYTES_TOTAL,
     NUM_COMPACTION_PROPERTIES
   };
 
@@ -90,6 +98,9 @@ struct ThreadStatus {
     FLUSH_JOB_ID = 0,
     FLUSH_BYTES_MEMTABLES,
     FLUSH_BYTES_WRITTEN,
+    // Memtable bytes processed, and the data size of all the memtables
+    FLUSH_PROGRESS_BYTES_DONE,
+    FLUSH_PROGRESS_BYTES_TOTAL,
     NUM_FLUSH_PROPERTIES
   };
 
@@ -184,6 +195,11 @@ struct ThreadStatus {
   static std::map<std::string, uint64_t> InterpretOperationProperties(
       OperationType op_type, const uint64_t* op_properties);
 
+  // The percentage of the specified operation done, estimated from its
+  // progress properties, or a negative number if it is not known.
+  static double GetOperationProgress(OperationType op_type,
+                                     const uint64_t* op_properties);
+
   // Obtain the name of a state given its type.
   static const std::string& GetStateName(StateType state_type);
 };
@@ -10,6 +10,7 @@
 
 #include <functional>
 
+#include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -55,4 +56,37 @@ class ThreadPool {
 // with `num_threads` background threads.
 extern ThreadPool* NewThreadPool(int num_threads);
 
+// A ThreadPool whose threads each own a queue of jobs per priority instead
+// of sharing one queue:
+//  - a job scheduled by a thread of the pool goes to the queue of that
+//    thread, which runs its newest job first while it is cache hot
+//  - the other jobs are spread over the queues round robin
+//  - a thread without jobs steals the oldest job of another thread, the
+//    jobs of higher priority first, the threads of its NUMA node first
+//  - threads sleep only when no job is queued and a job wakes up one
+//    sleeping thread, if any
+// SubmitJob() schedules at Env::LOW.
+class WorkStealingThreadPool : public ThreadPool {
+ public:
+  // Schedules function(arg) at priority pri. UnSchedule(tag) runs
+  // unschedFunction(arg), if not nullptr, for the jobs of tag still queued.
+  virtual void Schedule(void (*function)(void* arg), void* arg,
+                        Env::Priority pri, void* tag = nullptr,
+                        void (*unschedFunction)(void* arg) = nullptr) = 0;
+
+  // Removes the jobs of tag that did not start yet, returns their number
+  virtual int UnSchedule(void* tag) = 0;
+};
+
+struct WorkStealingThreadPoolOptions {
+  int num_threads = 1;
+
+  // Binds the threads to the CPUs of the NUMA nodes round robin. Only has
+  // effect on Linux.
+  bool numa_affinity = false;
+};
+
+extern WorkStealingThreadPool* NewWorkStealingThreadPool(
+    const WorkStealingThreadPoolOptions& options);
+
 }  // namespace TERARKDB_NAMESPACE
@@ -38,6 +38,16 @@ class Checkpoint {
   virtual Status CreateCheckpoint(const std::string& checkpoint_dir,
                                   uint64_t log_size_for_flush = 0);
 
+  // Like CreateCheckpoint, but SST files already present in
+  // base_checkpoint_dir, usually the previous checkpoint on the same backup
+  // disk, are hard linked from there. Only the SST files created since the
+  // base checkpoint are linked or copied from the DB, which makes periodic
+  // checkpoints to another filesystem incremental. The base checkpoint is
+  // not modified and may be deleted afterwards.
+  virtual Status CreateIncrementalCheckpoint(
+      const std::string& checkpoint_dir,
+      const std::string& base_checkpoint_dir, uint64_t log_size_for_flush = 0);
+
   virtual ~Checkpoint() {}
 };
 
@@ -0,0 +1,210 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Awaitable reads for C++20 coroutines, e.g.
+//
+//   Status s = co_await AwaitGet(db, pool, read_options, cf, key, &value);
+//   for (bool valid = co_await AwaitSeek(iter, pool, start); valid;
+//        valid = co_await AwaitNext(iter, pool)) {
+//     ...
+//   }
+//
+// A Get or MultiGet is first tried with KeyMayExist() on the calling thread,
+// without suspending. Only when a value is not found in the memtables and
+// the block cache, the coroutine is suspended and the read is submitted to pool, the
+// coroutine is resumed on the pool thread that completed it. Iterator moves
+// always run in pool, as any of them may read blocks. The coroutine must
+// not be resumed by anyone else while it awaits. If pool is nullptr the
+// reads run on the calling thread.
+//
+// Only defined when the compiler supports C++20 coroutines.
+
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ROCKSDB_HAS_COROUTINES
+#endif
+#endif
+
+#ifdef ROCKSDB_HAS_COROUTINES
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/iterator.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/threadpool.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Resumes the awaiting coroutine with the result of read, unless try_inline
+// sets the result first
+template <typename Result>
+class ReadAwaitable {
+ public:
+  ReadAwaitable(ThreadPool* pool, std::function<bool(Result*)> try_inline,
+                std::function<Result()> read)
+      : pool_(pool),
+        try_inline_(std::move(try_inline)),
+        read_(std::move(read)) {}
+
+  bool await_ready() {
+    if (try_inline_ && try_inline_(&result_)) {
+      return true;
+    }
+    if (pool_ == nullptr) {
+      result_ = read_();
+      return true;
+    }
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    pool_->SubmitJob([this, handle] {
+      result_ = read_();
+      handle.resume();
+    });
+  }
+
+  Result await_resume() { return std::move(result_); }
+
+ private:
+  ThreadPool* pool_;
+  std::function<bool(Result*)> try_inline_;
+  std::function<Result()> read_;
+  Result result_;
+};
+
+// co_await returns the status of db->Get(read_options, column_family, key,
+// value). key and *value must live until then.
+inline ReadAwaitable<Status> AwaitGet(DB* db, ThreadPool* pool,
+                                      const ReadOptions& read_options,
+                                      ColumnFamilyHandle* column_family,
+                                      const Slice& key, std::string* value) {
+  return ReadAwaitable<Status>(
+      pool,
+      [=](Status* s) {
+        if (read_options.read_tier == kBlockCacheTier) {
+          *s = db->Get(read_options, column_family, key, value);
+          return true;
+        }
+        bool value_found = false;
+        if (db->KeyMayExist(read_options, column_family, key, value,
+                            &value_found)) {
+          if (!value_found) {
+            return false;
+          }
+          *s = Status::OK();
+          return true;
+        }
+        // Nothing left to read, the Get only tells why
+        *s = db->Get(read_options, column_family, key, value);
+        return true;
+      },
+      [=] { return db->Get(read_options, column_family, key, value); });
+}
+
+inline ReadAwaitable<Status> AwaitGet(DB* db, ThreadPool* pool,
+                                      const ReadOptions& read_options,
+                                      const Slice& key, std::string* value) {
+  return AwaitGet(db, pool, read_options, db->DefaultColumnFamily(), key,
+                  value);
+}
+
+// co_await returns the statuses of db->MultiGet(read_options,
+// column_family, keys, values). Only the keys whose values are not found in
+// the memtables and the block cache are read in pool. keys and *values must
+// live until then.
+inline ReadAwaitable<std::vector<Status>> AwaitMultiGet(
+    DB* db, ThreadPool* pool, const ReadOptions& read_options,
+    const std::vector<ColumnFamilyHandle*>& column_family,
+    const std::vector<Slice>& keys, std::vector<std::string>* values) {
+  // Shared by both steps, the indexes of the keys that need I/O
+  auto missed = std::make_shared<std::vector<size_t>>();
+  auto statuses = std::make_shared<std::vector<Status>>();
+  return ReadAwaitable<std::vector<Status>>(
+      pool,
+      [=, &column_family, &keys](std::vector<Status>* result) {
+        if (read_options.read_tier == kBlockCacheTier) {
+          *result = db->MultiGet(read_options, column_family, keys, values);
+          return true;
+        }
+        statuses->resize(keys.size());
+        values->resize(keys.size());
+        // The keys that surely do not exist, the MultiGet only tells why
+        std::vector<size_t> absent;
+        for (size_t i = 0; i < keys.size(); ++i) {
+          bool value_found = false;
+          if (!db->KeyMayExist(read_options, column_family[i], keys[i],
+                               &(*values)[i], &value_found)) {
+            absent.push_back(i);
+          } else if (!value_found) {
+            missed->push_back(i);
+          }
+        }
+        if (!absent.empty()) {
+          std::vector<ColumnFamilyHandle*> absent_column_family;
+          std::vector<Slice> absent_keys;
+          for (size_t i : absent) {
+            absent_column_family.push_back(column_family[i]);
+            absent_keys.push_back(keys[i]);
+          }
+          std::vector<std::string> absent_values;
+          auto absent_statuses = db->MultiGet(
+              read_options, absent_column_family, absent_keys, &absent_values);
+          for (size_t j = 0; j < absent.size(); ++j) {
+            (*statuses)[absent[j]] = std::move(absent_statuses[j]);
+            (*values)[absent[j]] = std::move(absent_values[j]);
+          }
+        }
+        if (missed->empty()) {
+          *result = std::move(*statuses);
+          return true;
+        }
+        return false;
+      },
+      [=, &column_family, &keys] {
+        std::vector<ColumnFamilyHandle*> missed_column_family;
+        std::vector<Slice> missed_keys;
+        for (size_t i : *missed) {
+          missed_column_family.push_back(column_family[i]);
+          missed_keys.push_back(keys[i]);
+        }
+        std::vector<std::string> missed_values;
+        auto missed_statuses = db->MultiGet(read_options, missed_column_family,
+                                            missed_keys, &missed_values);
+        for (size_t j = 0; j < missed->size(); ++j) {
+          (*statuses)[(*missed)[j]] = std::move(missed_statuses[j]);
+          (*values)[(*missed)[j]] = std::move(missed_values[j]);
+        }
+        return std::move(*statuses);
+      });
+}
+
+// co_await returns iter->Valid() after iter->Seek(target). target must live
+// until then.
+inline ReadAwaitable<bool> AwaitSeek(Iterator* iter, ThreadPool* pool,
+                                     const Slice& target) {
+  return ReadAwaitable<bool>(pool, nullptr, [=] {
+    iter->Seek(target);
+    return iter->Valid();
+  });
+}
+
+// co_await returns iter->Valid() after iter->Next()
+inline ReadAwaitable<bool> AwaitNext(Iterator* iter, ThreadPool* pool) {
+  return ReadAwaitable<bool>(pool, nullptr, [=] {
+    iter->Next();
+    return iter->Valid();
+  });
+}
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // ROCKSDB_HAS_COROUTINES
@@ -34,6 +34,14 @@ namespace TERARKDB_NAMESPACE {
 //          Open2 at t=3 with ttl=5. Now k1,k2 should be deleted at t>=5
 // read_only=true opens in the usual read-only mode. Compactions will not be
 //  triggered(neither manual nor automatic), so no expired entries removed
+// use_ttl_extractor=true also sets the ttl_extractor_factory of the column
+//  families to one reading the timestamps, so flushes and compactions
+//  record when the rows of every table expire and whole tables are
+//  scheduled for compaction when their rows expire, see
+//  ColumnFamilyOptions::ttl_gc_ratio and ttl_window_seconds. A
+//  ttl_extractor_factory set by the application is kept.
+// Get returns the stored value without the timestamp in place: a value
+//  pinned by the block cache stays pinned and is never copied.
 //
 // CONSTRAINTS:
 // Not specifying/passing or non-positive TTL behaves like TTL = infinity
@@ -53,13 +61,13 @@ class DBWithTTL : public StackableDB {
 
   static Status Open(const Options& options, const std::string& dbname,
                      DBWithTTL** dbptr, int32_t ttl = 0,
-                     bool read_only = false);
+                     bool read_only = false, bool use_ttl_extractor = false);
 
   static Status Open(const DBOptions& db_options, const std::string& dbname,
                      const std::vector<ColumnFamilyDescriptor>& column_families,
                      std::vector<ColumnFamilyHandle*>* handles,
                      DBWithTTL** dbptr, std::vector<int32_t> ttls,
-                     bool read_only = false);
+                     bool read_only = false, bool use_ttl_extractor = false);
 
   virtual void SetTtl(int32_t ttl) = 0;
 
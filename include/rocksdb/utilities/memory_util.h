@@ -30,7 +30,20 @@ class MemoryUtil {
     kTableReadersTotal = 2,
     // Memory usage by Cache.
     kCacheTotal = 3,
-    kNumUsageTypes = 4
+    // Memory usage of the indexes of the table readers, a part of
+    // kTableReadersTotal.
+    kTableIndexTotal = 4,
+    // Memory usage of the compression dictionaries of the table readers.
+    kTableDictTotal = 5,
+    // Working memory of the table builders, of a table factory shared by
+    // column families once per column family.
+    kTableBuilderTotal = 6,
+    // Memory usage of the metadata of separated values and Map SSTs.
+    kBlobReferenceTotal = 7,
+    // Memory usage of the un-flushed mem-table reps outside their arenas,
+    // a part of kMemTableUnFlushed.
+    kMemTableRepTotal = 8,
+    kNumUsageTypes = 9
   };
 
   // Returns the approximate memory usage of different types in the input
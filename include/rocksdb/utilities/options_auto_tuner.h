@@ -0,0 +1,70 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <memory>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Bounds of the options the tuner may change. An option is only tuned when
+// its max is larger than its min, and never leaves [min, max].
+struct OptionsAutoTunerOptions {
+  // Seconds between the tuning rounds, run by the timer shared with the
+  // periodic work of the DB. 0 leaves the rounds to OptionsAutoTuner::Tune()
+  uint64_t period_sec = 60;
+
+  // An option is multiplied or divided by step in a round
+  double step = 1.25;
+
+  // GC is made more eager when the estimated garbage exceeds this share of
+  // the blob files, and lazier below half of it
+  double target_blob_garbage_ratio = 0.2;
+
+  // Reads are considered amplified when "rocksdb.read-amp-debt" exceeds it
+  uint64_t target_read_amp_debt = 16;
+
+  double min_blob_gc_ratio = 0;
+  double max_blob_gc_ratio = 0;
+
+  size_t min_blob_size = 0;
+  size_t max_blob_size = 0;
+
+  size_t min_max_dependence_blob_overlap = 0;
+  size_t max_max_dependence_blob_overlap = 0;
+};
+
+// Adjusts the KV separation and blob GC options of column families with
+// DB::SetOptions, from the GC debt, read amplification debt and write stalls
+// they report through DB properties:
+//  * blob_gc_ratio goes down while the garbage is above target, and up while
+//    it is well below, trading space for GC writes
+//  * blob_size goes down while writes stall, moving more values out of the
+//    LSM, and up while the garbage is above target
+//  * max_dependence_blob_overlap goes up while writes stall, so compactions
+//    rebuild fewer blobs, and down while the read debt is above target
+class OptionsAutoTuner {
+ public:
+  virtual ~OptionsAutoTuner() {}
+
+  // Runs a tuning round now
+  virtual Status Tune() = 0;
+};
+
+// Tunes column_families of db. The tuner must be destroyed before the column
+// families and db.
+Status NewOptionsAutoTuner(
+    DB* db, const std::vector<ColumnFamilyHandle*>& column_families,
+    const OptionsAutoTunerOptions& options,
+    std::unique_ptr<OptionsAutoTuner>* result);
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,80 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// File based replication: a follower receives the MANIFEST records and the
+// new SST and blob files of a leader DB and installs them as they are, so
+// it never redoes a flush or a compaction. The cost of a round is the size
+// of the files created since the previous one.
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class DB;
+class Env;
+
+// Position of a follower in the MANIFEST stream of its leader
+struct ReplicationCursor {
+  // Number of the MANIFEST file the follower has, 0 for none
+  uint64_t manifest_number = 0;
+  // Bytes of that MANIFEST file the follower has
+  uint64_t manifest_offset = 0;
+};
+
+// The receiving end of ShipReplicationUpdates, e.g. a follower directory or
+// a connection to a remote follower
+class ReplicationSink {
+ public:
+  virtual ~ReplicationSink() {}
+
+  // Where the follower stands, ShipReplicationUpdates starts from there
+  virtual Status GetCursor(ReplicationCursor* cursor) = 0;
+
+  // A table file, SST or blob, referenced by the MANIFEST data that
+  // follows. src_path is readable until the call returns. fname is the base
+  // name of the file. A sink may skip files it already has.
+  virtual Status AddTableFile(const std::string& src_path,
+                              const std::string& fname,
+                              uint64_t file_size) = 0;
+
+  // MANIFEST records to write at offset of MANIFEST-<manifest_number>. At
+  // offset 0 a new MANIFEST starts, whose records begin with a full
+  // snapshot of the leader, and becomes the current one.
+  virtual Status AppendManifest(uint64_t manifest_number, uint64_t offset,
+                                const Slice& data) = 0;
+
+  // Ends a round. live_table_files are the base names of all table files
+  // the MANIFEST references now, the sink may drop any other one.
+  virtual Status Finish(const std::vector<std::string>& live_table_files) = 0;
+};
+
+// Ships to sink the table files and MANIFEST records that db has written
+// since the cursor of sink. File deletions of db are disabled for the
+// duration of the call. Only data in SST files is shipped, recent writes
+// still in memtables are left to WAL based replication, see
+// DB::GetUpdatesSince. Column families with multiple db_paths or cf_paths
+// are not supported.
+extern Status ShipReplicationUpdates(DB* db, ReplicationSink* sink);
+
+// A sink that keeps follower_dir an openable copy of the leader. Table
+// files are hard linked, or copied when follower_dir is on another
+// filesystem. Open the follower with DB::OpenAsSecondary and call
+// TryCatchUpWithPrimary() after each round to see the new data, or open it
+// read only and reopen it. Obsolete files are deleted by Finish.
+extern Status NewDirectoryReplicationSink(
+    Env* env, const std::string& follower_dir,
+    std::unique_ptr<ReplicationSink>* sink);
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // !ROCKSDB_LITE
@@ -0,0 +1,76 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Secondary index of a column family kept in a companion column family.
+// A ValueExtractor picks the indexed field out of every value of the
+// primary column family, and the index column family maps the field to
+// the primary keys holding it. The application only writes the primary
+// column family:
+//  - the keys of every flush of the primary column family are indexed
+//    with their latest values after the flush, off the write path
+//  - compactions of the index column family drop the entries whose
+//    primary key no longer holds the field
+// So the index lags the primary column family by its memtables, and may
+// hold stale entries until they are compacted. Lookup() checks every
+// candidate against the primary column family and never returns a stale
+// one.
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class ColumnFamilyHandle;
+class CompactionFilterFactory;
+class DB;
+class EventListener;
+class ValueExtractorFactory;
+struct ReadOptions;
+
+class SecondaryIndex {
+ public:
+  virtual ~SecondaryIndex() {}
+
+  // Add to DBOptions::listeners before opening the db
+  virtual std::shared_ptr<EventListener> GetListener() = 0;
+
+  // Set as compaction_filter_factory of the index column family, whose
+  // comparator has to be the bytewise one
+  virtual std::shared_ptr<CompactionFilterFactory>
+  GetCompactionFilterFactory() = 0;
+
+  // Starts maintaining the index of primary in index after the db is
+  // opened. The handles have to outlive Detach().
+  virtual Status Attach(DB* db, ColumnFamilyHandle* primary,
+                        ColumnFamilyHandle* index) = 0;
+
+  // Stops maintaining the index, call it before closing the db. Waits for
+  // the index maintenance in flight.
+  virtual void Detach() = 0;
+
+  // The primary keys holding field, in key order
+  virtual Status Lookup(const ReadOptions& read_options, const Slice& field,
+                        std::vector<std::string>* primary_keys) = 0;
+
+  // Indexes all the keys of the primary column family, e.g. to build the
+  // index of existing data. Stale entries are left to compactions.
+  virtual Status Rebuild() = 0;
+};
+
+// A secondary index on the fields extracted by the extractors of
+// extractor_factory
+extern std::shared_ptr<SecondaryIndex> NewSecondaryIndex(
+    std::shared_ptr<const ValueExtractorFactory> extractor_factory);
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // !ROCKSDB_LITE
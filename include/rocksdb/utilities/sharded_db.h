@@ -0,0 +1,84 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/options.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// ShardedDB splits one logical key space into ranges, each stored in its own
+// DB with its own WAL, memtables, DB mutex and compactions, so that writes
+// and compactions of different ranges run in parallel.
+//
+// Shard i holds the keys in [lower bound of shard i, lower bound of shard
+// i + 1), the first shard starts at the smallest key. The bounds are kept in
+// the SHARDS file of the directory, and change with SplitShard() and
+// MergeShards(), which move the data through sst ingestion.
+//
+// A write touching several shards is atomic per shard only, and reads across
+// shards do not see one snapshot: each shard is read at its own latest
+// state.
+//
+// An iterator keeps reading the shards it was created over across
+// SplitShard() and MergeShards(), the DB of a shard merged away is closed
+// and destroyed when the last iterator over it is deleted.
+class ShardedDB {
+ public:
+  // Opens the sharded DB at dbname, creating it with a shard per range cut by
+  // split_keys if missing. split_keys must be sorted by options.comparator,
+  // and are ignored when the DB exists.
+  static Status Open(const Options& options, const std::string& dbname,
+                     const std::vector<std::string>& split_keys,
+                     ShardedDB** dbptr);
+
+  virtual ~ShardedDB() {}
+
+  virtual Status Put(const WriteOptions& options, const Slice& key,
+                     const Slice& value) = 0;
+  virtual Status Delete(const WriteOptions& options, const Slice& key) = 0;
+  virtual Status Merge(const WriteOptions& options, const Slice& key,
+                       const Slice& value) = 0;
+  // Splits updates into a batch per shard, written concurrently. Range
+  // deletions are not supported
+  virtual Status Write(const WriteOptions& options, WriteBatch* updates) = 0;
+
+  virtual Status Get(const ReadOptions& options, const Slice& key,
+                     std::string* value) = 0;
+  // The keys of different shards are read concurrently
+  virtual std::vector<Status> MultiGet(const ReadOptions& options,
+                                       const std::vector<Slice>& keys,
+                                       std::vector<std::string>* values) = 0;
+  // Iterates the shards in key order. options.snapshot must be null
+  virtual Iterator* NewIterator(const ReadOptions& options) = 0;
+
+  virtual Status Flush(const FlushOptions& options) = 0;
+
+  // Moves the keys of shard from split_key on into a new shard, inserted
+  // after it. Reads and writes go on meanwhile, the writes to the split shard
+  // one at a time
+  virtual Status SplitShard(size_t shard, const Slice& split_key) = 0;
+  // Moves the keys of shard + 1 into shard, and drops shard + 1. Reads and
+  // writes go on meanwhile, the writes to shard + 1 one at a time
+  virtual Status MergeShards(size_t shard) = 0;
+
+  virtual size_t NumShards() = 0;
+  // The lower bounds of the shards after the first
+  virtual std::vector<std::string> GetSplitKeys() = 0;
+  // The DB of a shard, valid until the next SplitShard() or MergeShards()
+  virtual DB* GetShard(size_t shard) = 0;
+};
+
+// Destroys the contents of the sharded DB at dbname
+Status DestroyShardedDB(const std::string& dbname, const Options& options);
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // ROCKSDB_LITE
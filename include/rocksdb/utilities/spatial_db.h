@@ -175,6 +175,9 @@ struct SpatialDBOptions {
   uint64_t cache_size = 1 * 1024 * 1024 * 1024LL;  // 1GB
   int num_threads = 16;
   bool bulk_load = true;
+  // Queries whose tiles span several key ranges of the spatial index scan
+  // the ranges with up to query_threads threads
+  int query_threads = 1;
 };
 
 // Cursor is used to return data from the query to the client. To get all the
@@ -215,10 +218,31 @@ struct SpatialIndexOptions {
   // total of (1 << tile_bits)^2 tiles. It is recommended to configure a size of
   // each  tile to be approximately the size of the query on that spatial index
   uint32_t tile_bits;
+  // The space filling curve ordering the tiles in the spatial index.
+  // Neighbouring tiles are closer on the Hilbert curve than in the Z-order of
+  // quad keys, so a query reads fewer key ranges of the index.
+  // Don't change the values here, they are persisted on disk
+  enum KeyType {
+    kQuadKey = 0x0,
+    kHilbertKey = 0x1,
+  };
+  KeyType key_type = kQuadKey;
   SpatialIndexOptions() {}
   SpatialIndexOptions(const std::string& _name,
-                      const BoundingBox<double>& _bbox, uint32_t _tile_bits)
-      : name(_name), bbox(_bbox), tile_bits(_tile_bits) {}
+                      const BoundingBox<double>& _bbox, uint32_t _tile_bits,
+                      KeyType _key_type = kQuadKey)
+      : name(_name), bbox(_bbox), tile_bits(_tile_bits), key_type(_key_type) {}
+};
+
+// An element to insert with SpatialDB::BulkLoad()
+struct SpatialElement {
+  BoundingBox<double> bbox;
+  std::string blob;
+  FeatureSet feature_set;
+  SpatialElement() = default;
+  SpatialElement(const BoundingBox<double>& _bbox, const std::string& _blob,
+                 const FeatureSet& _feature_set)
+      : bbox(_bbox), blob(_blob), feature_set(_feature_set) {}
 };
 
 class SpatialDB : public StackableDB {
@@ -244,6 +268,15 @@ class SpatialDB : public StackableDB {
                         const FeatureSet& feature_set,
                         const std::vector<std::string>& spatial_indexes) = 0;
 
+  // Inserts elements into the specified spatial_indexes, as Insert() does
+  // for each of them. The elements are written to table files with
+  // num_threads threads and ingested, bypassing the memtables and the
+  // compactions of the inserted data. Fails on a read only db.
+  // REQUIRES: spatial_indexes.size() > 0
+  virtual Status BulkLoad(const std::vector<SpatialElement>& elements,
+                          const std::vector<std::string>& spatial_indexes,
+                          int num_threads = 1) = 0;
+
   // Calling Compact() after inserting a bunch of elements should speed up
   // reading. This is especially useful if you use SpatialDBOptions::bulk_load
   // Num threads determines how many threads we'll use for compactions. Setting
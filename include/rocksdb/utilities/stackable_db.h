@@ -98,6 +98,15 @@ class StackableDB : public DB {
     return db_->MultiGet(options, column_family, keys, values);
   }
 
+  using DB::MultiGetSeqno;
+  virtual std::vector<Status> MultiGetSeqno(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys,
+      std::vector<EntrySeqno>* entries) override {
+    return db_->MultiGetSeqno(options, column_family, keys, entries);
+  }
+
   using DB::IngestExternalFile;
   virtual Status IngestExternalFile(
       ColumnFamilyHandle* column_family,
@@ -306,6 +315,30 @@ class StackableDB : public DB {
     return db_->GetLatestSequenceNumber();
   }
 
+  virtual Status TryCatchUpWithPrimary() override {
+    return db_->TryCatchUpWithPrimary();
+  }
+
+#ifndef ROCKSDB_LITE
+  virtual Status StartPerfTrace(
+      const PerfTraceOptions& options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override {
+    return db_->StartPerfTrace(options, std::move(trace_writer));
+  }
+
+  virtual Status EndPerfTrace() override { return db_->EndPerfTrace(); }
+
+  virtual Status StartTableAccessTrace(
+      const TableAccessTraceOptions& options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override {
+    return db_->StartTableAccessTrace(options, std::move(trace_writer));
+  }
+
+  virtual Status EndTableAccessTrace() override {
+    return db_->EndTableAccessTrace();
+  }
+#endif  // ROCKSDB_LITE
+
   virtual bool SetPreserveDeletesSequenceNumber(
       SequenceNumber seqnum) override {
     return db_->SetPreserveDeletesSequenceNumber(seqnum);
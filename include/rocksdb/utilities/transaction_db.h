@@ -82,12 +82,29 @@ struct TransactionDBOptions {
   // mutex/condvar implementation.
   std::shared_ptr<TransactionDBMutexFactory> custom_mutex_factory;
 
+  // If positive, the deadlocks of transactions with
+  // TransactionOptions::deadlock_detect are found by a background thread
+  // every deadlock_detect_interval_ms instead of by each transaction before it
+  // waits for a lock, so waiters do not serialize on the wait-for graph. The
+  // youngest transaction of a cycle fails with Status::Busy(kDeadlock), up to
+  // two intervals after the cycle closes. Lock timeouts apply either way.
+  uint64_t deadlock_detect_interval_ms = 0;
+
   // The policy for when to write the data into the DB. The default policy is to
   // write only the committed data (WRITE_COMMITTED). The data could be written
   // before the commit phase. The DB then needs to provide the mechanisms to
   // tell apart committed from uncommitted data.
   TxnDBWritePolicy write_policy = TxnDBWritePolicy::WRITE_COMMITTED;
 
+  // WRITE_PREPARED and WRITE_UNPREPARED only. The commit cache tells
+  // readers without a lock whether the 2^write_prepared_commit_cache_bits
+  // latest transactions are committed, 8 bytes per entry. The commits evicted
+  // from it while a snapshot is open are checked under a mutex, so with many
+  // concurrent writers and long snapshots a larger cache keeps the reads off
+  // the mutex, see the TXN_OLD_COMMIT_MAP_MUTEX_OVERHEAD ticker. 0 keeps the
+  // default of 23 bits (64MB), at most 30.
+  size_t write_prepared_commit_cache_bits = 0;
+
   // TODO(myabandeh): remove this option
   // Note: this is a temporary option as a hot fix in rollback of writeprepared
   // txns in myrocks. MyRocks uses merge operands for autoinc column id without
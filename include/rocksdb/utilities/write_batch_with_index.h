@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rocksdb/comparator.h"
 #include "rocksdb/iterator.h"
@@ -249,6 +250,22 @@ class WriteBatchWithIndex : public WriteBatchBase {
                            ColumnFamilyHandle* column_family, const Slice& key,
                            LazyBuffer* value);
 
+  // Batched version of GetFromBatchAndDB(), with the same semantics as
+  // DB::MultiGet(). The keys are looked up in this batch in sorted order
+  // through one index iterator per column family, and the keys the batch
+  // cannot resolve are read from the DB with a single MultiGet(). Merge
+  // operands found in the batch are applied on top of the DB values.
+  std::vector<Status> MultiGetFromBatchAndDB(
+      DB* db, const ReadOptions& read_options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys, std::vector<std::string>* values);
+
+  // default column family
+  std::vector<Status> MultiGetFromBatchAndDB(DB* db,
+                                             const ReadOptions& read_options,
+                                             const std::vector<Slice>& keys,
+                                             std::vector<std::string>* values);
+
   // Records the state of the batch for future calls to RollbackToSavePoint().
   // May be called multiple times to set multiple save points.
   void SetSavePoint() override;
@@ -20,20 +20,39 @@
 
 namespace TERARKDB_NAMESPACE {
 
+class ArenaBlockPool;
+
 class WriteBufferManager {
  public:
   // _buffer_size = 0 indicates no limit. Memory won't be capped.
   // memory_usage() won't be valid and ShouldFlush() will always return true.
   // if `cache` is provided, we'll put dummy entries in the cache and cost
   // the memory allocated to the cache. It can be used even if _buffer_size = 0.
+  // If `fair_share` is true and the manager is shared by several DBs, each DB
+  // gets a quota of the buffer size according to its recent ingest rate, and
+  // when the buffer is full only the DBs over their quota flush. See
+  // ShouldFlush(Client*, size_t).
+  // If `arena_block_pool_size` > 0, the memtables using this manager give
+  // their arena blocks back to a pool when they are freed, and the new
+  // memtables take them from it, so that the write path doesn't page fault
+  // on fresh memory. Up to `arena_block_pool_size` bytes of free blocks are
+  // kept, and when the manager is enabled, only as long as they and the
+  // memtables fit in the buffer size.
   explicit WriteBufferManager(size_t _buffer_size,
-                              std::shared_ptr<Cache> cache = {});
+                              std::shared_ptr<Cache> cache = {},
+                              bool fair_share = false,
+                              size_t arena_block_pool_size = 0);
   ~WriteBufferManager();
 
   bool enabled() const { return buffer_size_ != 0; }
 
+  bool fair_share() const { return fair_share_rep_ != nullptr; }
+
   bool cost_to_cache() const { return cache_rep_ != nullptr; }
 
+  // nullptr if arena_block_pool_size is 0
+  ArenaBlockPool* arena_block_pool() const { return arena_block_pool_.get(); }
+
   // Only valid if enabled()
   size_t memory_usage() const {
     return memory_used_.load(std::memory_order_relaxed);
@@ -85,6 +104,27 @@ class WriteBufferManager {
     }
   }
 
+  // A DB sharing this manager in fair share mode.
+  struct Client;
+
+  // Registers a DB for fair share accounting. Returns nullptr if fair share
+  // is off. The client must be unregistered before the manager is destroyed.
+  Client* RegisterClient();
+  void UnregisterClient(Client* client);
+
+  // Records `bytes` written by the client, which drives its quota.
+  void RecordIngest(Client* client, size_t bytes);
+
+  // The current memtable quota of the client, in bytes
+  size_t ClientQuota(const Client* client) const;
+
+  // Fair share variant of ShouldFlush(), where `client_memory_usage` is the
+  // mutable memtable memory of the client's DB. When the buffer is full, it
+  // only returns true for clients using more than their share of it, so
+  // slow DBs flush their memtables and the hot ones keep theirs growing.
+  // Should only be called from write thread
+  bool ShouldFlush(Client* client, size_t client_memory_usage);
+
  private:
   const size_t buffer_size_;
   const size_t mutable_limit_;
@@ -93,10 +133,17 @@ class WriteBufferManager {
   std::atomic<size_t> memory_active_;
   struct CacheRep;
   std::unique_ptr<CacheRep> cache_rep_;
+  struct FairShareRep;
+  std::unique_ptr<FairShareRep> fair_share_rep_;
+  std::unique_ptr<ArenaBlockPool> arena_block_pool_;
 
   void ReserveMemWithCache(size_t mem);
   void FreeMemWithCache(size_t mem);
 
+  // Recomputes the client quotas from their ingest since the last update.
+  // REQUIRES: fair_share_rep_->mutex_ held
+  void UpdateClientQuotas(bool force);
+
   // No copying allowed
   WriteBufferManager(const WriteBufferManager&) = delete;
   WriteBufferManager& operator=(const WriteBufferManager&) = delete;
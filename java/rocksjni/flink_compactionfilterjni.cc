@@ -141,10 +141,15 @@ class JavaTimeProvider
 
 static FlinkCompactionFilter::ListElementFilterFactory*
 createListElementFilterFactory(JNIEnv* env, jint ji_list_elem_len,
+                               jboolean jlength_prefixed,
                                jobject jlist_filter_factory) {
   FlinkCompactionFilter::ListElementFilterFactory* list_filter_factory =
       nullptr;
-  if (ji_list_elem_len > 0) {
+  if (jlength_prefixed) {
+    list_filter_factory =
+        new FlinkCompactionFilter::LengthPrefixedListElementFilterFactory(
+            static_cast<std::size_t>(0));
+  } else if (ji_list_elem_len > 0) {
     auto fixed_size = static_cast<std::size_t>(ji_list_elem_len);
     list_filter_factory =
         new FlinkCompactionFilter::FixedListElementFilterFactory(
@@ -210,13 +215,13 @@ jlong Java_org_rocksdb_FlinkCompactionFilter_createNewFlinkCompactionFilter0(
 /*
  * Class:     org_rocksdb_FlinkCompactionFilter
  * Method:    configureFlinkCompactionFilter
- * Signature: (JIIJJILorg/rocksdb/FlinkCompactionFilter$ListElementFilter;)Z
+ * Signature: (JIIJJIZLorg/rocksdb/FlinkCompactionFilter$ListElementFilterFactory;)Z
  */
 jboolean Java_org_rocksdb_FlinkCompactionFilter_configureFlinkCompactionFilter(
     JNIEnv* env, jclass /* jcls */, jlong handle, jint ji_state_type,
     jint ji_timestamp_offset, jlong jl_ttl_milli,
     jlong jquery_time_after_num_entries, jint ji_list_elem_len,
-    jobject jlist_filter_factory) {
+    jboolean jlength_prefixed, jobject jlist_filter_factory) {
   auto state_type =
       static_cast<FlinkCompactionFilter::StateType>(ji_state_type);
   auto timestamp_offset = static_cast<size_t>(ji_timestamp_offset);
@@ -227,7 +232,7 @@ jboolean Java_org_rocksdb_FlinkCompactionFilter_configureFlinkCompactionFilter(
       *(reinterpret_cast<std::shared_ptr<FlinkCompactionFilter::ConfigHolder>*>(
           handle));
   auto list_filter_factory = createListElementFilterFactory(
-      env, ji_list_elem_len, jlist_filter_factory);
+      env, ji_list_elem_len, jlength_prefixed, jlist_filter_factory);
   auto config = new FlinkCompactionFilter::Config{
       state_type, timestamp_offset, ttl, query_time_after_num_entries,
       std::unique_ptr<FlinkCompactionFilter::ListElementFilterFactory>(
@@ -9,6 +9,9 @@
 #include <jni.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "include/org_rocksdb_RocksIterator.h"
 #include "rocksdb/iterator.h"
@@ -184,3 +187,71 @@ jbyteArray Java_org_rocksdb_RocksIterator_value0(JNIEnv* env, jobject /*jobj*/,
       const_cast<jbyte*>(reinterpret_cast<const jbyte*>(value_slice.data())));
   return jkeyValue;
 }
+
+/*
+ * Class:     org_rocksdb_RocksIterator
+ * Method:    seekDirect0
+ * Signature: (JLjava/nio/ByteBuffer;II)V
+ */
+void Java_org_rocksdb_RocksIterator_seekDirect0(JNIEnv* env, jobject /*jobj*/,
+                                                jlong handle, jobject jtarget,
+                                                jint jtarget_off,
+                                                jint jtarget_len) {
+  char* target = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+      env, jtarget, jtarget_off, jtarget_len);
+  if (target == nullptr) {
+    // exception thrown: IllegalArgumentException
+    return;
+  }
+
+  auto* it = reinterpret_cast<TERARKDB_NAMESPACE::Iterator*>(handle);
+  it->Seek(TERARKDB_NAMESPACE::Slice(target, jtarget_len));
+}
+
+/*
+ * Copies as much of slice as fits into the region of the direct buffer
+ *
+ * @return the size of slice, or -1 if an exception was thrown
+ */
+static jint copy_to_direct_buffer(JNIEnv* env,
+                                  const TERARKDB_NAMESPACE::Slice& slice,
+                                  jobject jbuffer, jint jbuffer_off,
+                                  jint jbuffer_len) {
+  char* buffer = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+      env, jbuffer, jbuffer_off, jbuffer_len);
+  if (buffer == nullptr) {
+    // exception thrown: IllegalArgumentException
+    return -1;
+  }
+  const jint size = static_cast<jint>(slice.size());
+  memcpy(buffer, slice.data(), std::min(jbuffer_len, size));
+  return size;
+}
+
+/*
+ * Class:     org_rocksdb_RocksIterator
+ * Method:    keyDirect0
+ * Signature: (JLjava/nio/ByteBuffer;II)I
+ */
+jint Java_org_rocksdb_RocksIterator_keyDirect0(JNIEnv* env, jobject /*jobj*/,
+                                               jlong handle, jobject jbuffer,
+                                               jint jbuffer_off,
+                                               jint jbuffer_len) {
+  auto* it = reinterpret_cast<TERARKDB_NAMESPACE::Iterator*>(handle);
+  return copy_to_direct_buffer(env, it->key(), jbuffer, jbuffer_off,
+                               jbuffer_len);
+}
+
+/*
+ * Class:     org_rocksdb_RocksIterator
+ * Method:    valueDirect0
+ * Signature: (JLjava/nio/ByteBuffer;II)I
+ */
+jint Java_org_rocksdb_RocksIterator_valueDirect0(JNIEnv* env, jobject /*jobj*/,
+                                                 jlong handle, jobject jbuffer,
+                                                 jint jbuffer_off,
+                                                 jint jbuffer_len) {
+  auto* it = reinterpret_cast<TERARKDB_NAMESPACE::Iterator*>(handle);
+  return copy_to_direct_buffer(env, it->value(), jbuffer, jbuffer_off,
+                               jbuffer_len);
+}
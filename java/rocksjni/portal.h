@@ -3476,8 +3476,42 @@ class TickerTypeJni {
         return 0x63;
       case TERARKDB_NAMESPACE::Tickers::GC_SKIP_GET_BY_FILE:
         return 0x64;
-      case TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX:
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_HIT:
         return 0x65;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_MISS:
+        return 0x66;
+      case TERARKDB_NAMESPACE::Tickers::TERARK_ZIP_RECORD_CACHE_HIT:
+        return 0x67;
+      case TERARKDB_NAMESPACE::Tickers::TERARK_ZIP_RECORD_CACHE_MISS:
+        return 0x68;
+      case TERARKDB_NAMESPACE::Tickers::CACHE_ADMISSION_REJECT:
+        return 0x69;
+      case TERARKDB_NAMESPACE::Tickers::CACHE_ADMISSION_REJECT_BYTES:
+        return 0x6A;
+      case TERARKDB_NAMESPACE::Tickers::NEGATIVE_LOOKUP_CACHE_HIT:
+        return 0x6B;
+      case TERARKDB_NAMESPACE::Tickers::NEGATIVE_LOOKUP_CACHE_MISS:
+        return 0x6C;
+      case TERARKDB_NAMESPACE::Tickers::RATE_LIMITER_LOW_PRI_BYTES:
+        return 0x6D;
+      case TERARKDB_NAMESPACE::Tickers::RATE_LIMITER_MID_PRI_BYTES:
+        return 0x6E;
+      case TERARKDB_NAMESPACE::Tickers::RATE_LIMITER_HIGH_PRI_BYTES:
+        return 0x6F;
+      case TERARKDB_NAMESPACE::Tickers::GC_READ_BYTES:
+        return 0x70;
+      case TERARKDB_NAMESPACE::Tickers::GC_WRITE_BYTES:
+        return 0x71;
+      case TERARKDB_NAMESPACE::Tickers::STALL_MEMTABLE_LIMIT_MICROS:
+        return 0x72;
+      case TERARKDB_NAMESPACE::Tickers::STALL_L0_FILE_COUNT_LIMIT_MICROS:
+        return 0x73;
+      case TERARKDB_NAMESPACE::Tickers::STALL_PENDING_COMPACTION_BYTES_MICROS:
+        return 0x74;
+      case TERARKDB_NAMESPACE::Tickers::STALL_READ_AMP_LIMIT_MICROS:
+        return 0x75;
+      case TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX:
+        return 0x76;
 
       default:
         // undefined/default
@@ -3692,6 +3726,40 @@ class TickerTypeJni {
       case 0x64:
         return TERARKDB_NAMESPACE::Tickers::GC_SKIP_GET_BY_FILE;
       case 0x65:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_HIT;
+      case 0x66:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_MISS;
+      case 0x67:
+        return TERARKDB_NAMESPACE::Tickers::TERARK_ZIP_RECORD_CACHE_HIT;
+      case 0x68:
+        return TERARKDB_NAMESPACE::Tickers::TERARK_ZIP_RECORD_CACHE_MISS;
+      case 0x69:
+        return TERARKDB_NAMESPACE::Tickers::CACHE_ADMISSION_REJECT;
+      case 0x6A:
+        return TERARKDB_NAMESPACE::Tickers::CACHE_ADMISSION_REJECT_BYTES;
+      case 0x6B:
+        return TERARKDB_NAMESPACE::Tickers::NEGATIVE_LOOKUP_CACHE_HIT;
+      case 0x6C:
+        return TERARKDB_NAMESPACE::Tickers::NEGATIVE_LOOKUP_CACHE_MISS;
+      case 0x6D:
+        return TERARKDB_NAMESPACE::Tickers::RATE_LIMITER_LOW_PRI_BYTES;
+      case 0x6E:
+        return TERARKDB_NAMESPACE::Tickers::RATE_LIMITER_MID_PRI_BYTES;
+      case 0x6F:
+        return TERARKDB_NAMESPACE::Tickers::RATE_LIMITER_HIGH_PRI_BYTES;
+      case 0x70:
+        return TERARKDB_NAMESPACE::Tickers::GC_READ_BYTES;
+      case 0x71:
+        return TERARKDB_NAMESPACE::Tickers::GC_WRITE_BYTES;
+      case 0x72:
+        return TERARKDB_NAMESPACE::Tickers::STALL_MEMTABLE_LIMIT_MICROS;
+      case 0x73:
+        return TERARKDB_NAMESPACE::Tickers::STALL_L0_FILE_COUNT_LIMIT_MICROS;
+      case 0x74:
+        return TERARKDB_NAMESPACE::Tickers::STALL_PENDING_COMPACTION_BYTES_MICROS;
+      case 0x75:
+        return TERARKDB_NAMESPACE::Tickers::STALL_READ_AMP_LIMIT_MICROS;
+      case 0x76:
         return TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX;
 
       default:
@@ -3781,8 +3849,16 @@ class HistogramTypeJni {
         return 0x22;
       case TERARKDB_NAMESPACE::Histograms::BUILD_VERSION_TIME:
         return 0x23;
-      case TERARKDB_NAMESPACE::Histograms::HISTOGRAM_ENUM_MAX:
+      case TERARKDB_NAMESPACE::Histograms::TERARK_ZIP_MEMORY_WAIT_MICROS:
         return 0x24;
+      case TERARKDB_NAMESPACE::Histograms::IO_PROF_READ_MICROS:
+        return 0x25;
+      case TERARKDB_NAMESPACE::Histograms::IO_PROF_WRITE_MICROS:
+        return 0x26;
+      case TERARKDB_NAMESPACE::Histograms::IO_PROF_SYNC_MICROS:
+        return 0x27;
+      case TERARKDB_NAMESPACE::Histograms::HISTOGRAM_ENUM_MAX:
+        return 0x28;
 
       default:
         // undefined/default
@@ -3868,6 +3944,14 @@ class HistogramTypeJni {
       case 0x23:
         return TERARKDB_NAMESPACE::Histograms::BUILD_VERSION_TIME;
       case 0x24:
+        return TERARKDB_NAMESPACE::Histograms::TERARK_ZIP_MEMORY_WAIT_MICROS;
+      case 0x25:
+        return TERARKDB_NAMESPACE::Histograms::IO_PROF_READ_MICROS;
+      case 0x26:
+        return TERARKDB_NAMESPACE::Histograms::IO_PROF_WRITE_MICROS;
+      case 0x27:
+        return TERARKDB_NAMESPACE::Histograms::IO_PROF_SYNC_MICROS;
+      case 0x28:
         return TERARKDB_NAMESPACE::Histograms::HISTOGRAM_ENUM_MAX;
 
       default:
@@ -3972,9 +4056,19 @@ class MemoryUsageTypeJni {
         return 0x2;
       case TERARKDB_NAMESPACE::MemoryUtil::UsageType::kCacheTotal:
         return 0x3;
+      case TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableIndexTotal:
+        return 0x4;
+      case TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableDictTotal:
+        return 0x5;
+      case TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableBuilderTotal:
+        return 0x6;
+      case TERARKDB_NAMESPACE::MemoryUtil::UsageType::kBlobReferenceTotal:
+        return 0x7;
+      case TERARKDB_NAMESPACE::MemoryUtil::UsageType::kMemTableRepTotal:
+        return 0x8;
       default:
         // undefined: use kNumUsageTypes
-        return 0x4;
+        return 0x9;
     }
   }
 
@@ -3991,6 +4085,16 @@ class MemoryUsageTypeJni {
         return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableReadersTotal;
       case 0x3:
         return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kCacheTotal;
+      case 0x4:
+        return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableIndexTotal;
+      case 0x5:
+        return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableDictTotal;
+      case 0x6:
+        return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kTableBuilderTotal;
+      case 0x7:
+        return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kBlobReferenceTotal;
+      case 0x8:
+        return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kMemTableRepTotal;
       default:
         // undefined/default: use kNumUsageTypes
         return TERARKDB_NAMESPACE::MemoryUtil::UsageType::kNumUsageTypes;
@@ -4791,6 +4895,38 @@ class JniUtil {
     return createJavaByteArrayWithSizeCheck(env, bytes.data(), bytes.size());
   }
 
+  /**
+   * Gets the native memory of a region of a direct java.nio.ByteBuffer,
+   * which is read or written in place without any copy
+   *
+   * @param env A pointer to the java environment
+   * @param jbuffer The direct java.nio.ByteBuffer
+   * @param offset The offset of the region in the buffer
+   * @param length The length of the region
+   *
+   * @return the address of the region or nullptr if an
+   *     IllegalArgumentException was thrown, as the buffer is not direct or
+   *     the region is out of its bounds
+   */
+  static char* directBufferRegion(JNIEnv* env, jobject jbuffer, jint offset,
+                                  jint length) {
+    char* address =
+        static_cast<char*>(env->GetDirectBufferAddress(jbuffer));
+    if (address == nullptr) {
+      IllegalArgumentExceptionJni::ThrowNew(
+          env, Status::InvalidArgument("Could not access DirectBuffer"));
+      return nullptr;
+    }
+    const jlong capacity = env->GetDirectBufferCapacity(jbuffer);
+    if (offset < 0 || length < 0 ||
+        static_cast<jlong>(offset) + length > capacity) {
+      IllegalArgumentExceptionJni::ThrowNew(
+          env, Status::InvalidArgument("DirectBuffer region out of bounds"));
+      return nullptr;
+    }
+    return address + offset;
+  }
+
   /*
    * Helper for operations on a key and value
    * for example WriteBatch->Put
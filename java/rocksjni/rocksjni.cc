@@ -1017,6 +1017,223 @@ jint Java_org_rocksdb_RocksDB_get__JJ_3BII_3BIIJ(
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// TERARKDB_NAMESPACE::DB::Get(), Put() and MultiGet() on direct ByteBuffers
+//
+// The keys and values are read and written in the native memory of the
+// buffers, a zero handle stands for the default options or column family.
+
+namespace {
+// RocksDB.NOT_FOUND
+const jint kDirectNotFound = -1;
+// returned when a Java exception was thrown
+const jint kDirectStatusError = -2;
+}  // namespace
+
+/*
+ * Class:     org_rocksdb_RocksDB
+ * Method:    getDirect
+ * Signature: (JJLjava/nio/ByteBuffer;IILjava/nio/ByteBuffer;IIJ)I
+ */
+jint Java_org_rocksdb_RocksDB_getDirect(JNIEnv* env, jobject /*jdb*/,
+                                        jlong jdb_handle, jlong jropt_handle,
+                                        jobject jkey, jint jkey_off,
+                                        jint jkey_len, jobject jval,
+                                        jint jval_off, jint jval_len,
+                                        jlong jcf_handle) {
+  auto* db = reinterpret_cast<TERARKDB_NAMESPACE::DB*>(jdb_handle);
+  auto* cf_handle =
+      reinterpret_cast<TERARKDB_NAMESPACE::ColumnFamilyHandle*>(jcf_handle);
+  static const TERARKDB_NAMESPACE::ReadOptions default_read_options;
+  const auto& read_options =
+      jropt_handle == 0
+          ? default_read_options
+          : *reinterpret_cast<TERARKDB_NAMESPACE::ReadOptions*>(jropt_handle);
+
+  char* key = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+      env, jkey, jkey_off, jkey_len);
+  if (key == nullptr) {
+    // exception thrown: IllegalArgumentException
+    return kDirectStatusError;
+  }
+  char* value = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+      env, jval, jval_off, jval_len);
+  if (value == nullptr) {
+    // exception thrown: IllegalArgumentException
+    return kDirectStatusError;
+  }
+
+  TERARKDB_NAMESPACE::LazyBuffer lazy_value;
+  TERARKDB_NAMESPACE::Status s = db->Get(
+      read_options, cf_handle != nullptr ? cf_handle : db->DefaultColumnFamily(),
+      TERARKDB_NAMESPACE::Slice(key, jkey_len), &lazy_value);
+  if (s.ok()) {
+    s = lazy_value.fetch();
+  }
+  if (s.IsNotFound()) {
+    return kDirectNotFound;
+  }
+  if (!s.ok()) {
+    TERARKDB_NAMESPACE::RocksDBExceptionJni::ThrowNew(env, s);
+    return kDirectStatusError;
+  }
+
+  const TERARKDB_NAMESPACE::Slice& value_slice = lazy_value.slice();
+  const jint value_len = static_cast<jint>(value_slice.size());
+  memcpy(value, value_slice.data(), std::min(jval_len, value_len));
+  return value_len;
+}
+
+/*
+ * Class:     org_rocksdb_RocksDB
+ * Method:    putDirect
+ * Signature: (JJLjava/nio/ByteBuffer;IILjava/nio/ByteBuffer;IIJ)V
+ */
+void Java_org_rocksdb_RocksDB_putDirect(JNIEnv* env, jobject /*jdb*/,
+                                        jlong jdb_handle, jlong jwopt_handle,
+                                        jobject jkey, jint jkey_off,
+                                        jint jkey_len, jobject jval,
+                                        jint jval_off, jint jval_len,
+                                        jlong jcf_handle) {
+  auto* db = reinterpret_cast<TERARKDB_NAMESPACE::DB*>(jdb_handle);
+  auto* cf_handle =
+      reinterpret_cast<TERARKDB_NAMESPACE::ColumnFamilyHandle*>(jcf_handle);
+  static const TERARKDB_NAMESPACE::WriteOptions default_write_options;
+  const auto& write_options =
+      jwopt_handle == 0
+          ? default_write_options
+          : *reinterpret_cast<TERARKDB_NAMESPACE::WriteOptions*>(jwopt_handle);
+
+  char* key = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+      env, jkey, jkey_off, jkey_len);
+  if (key == nullptr) {
+    // exception thrown: IllegalArgumentException
+    return;
+  }
+  char* value = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+      env, jval, jval_off, jval_len);
+  if (value == nullptr) {
+    // exception thrown: IllegalArgumentException
+    return;
+  }
+
+  TERARKDB_NAMESPACE::Status s = db->Put(
+      write_options,
+      cf_handle != nullptr ? cf_handle : db->DefaultColumnFamily(),
+      TERARKDB_NAMESPACE::Slice(key, jkey_len),
+      TERARKDB_NAMESPACE::Slice(value, jval_len));
+  if (!s.ok()) {
+    TERARKDB_NAMESPACE::RocksDBExceptionJni::ThrowNew(env, s);
+  }
+}
+
+/*
+ * Class:     org_rocksdb_RocksDB
+ * Method:    multiGetDirect
+ * Signature: (JJ[J[Ljava/nio/ByteBuffer;[I[I[Ljava/nio/ByteBuffer;[I[I)[I
+ */
+jintArray Java_org_rocksdb_RocksDB_multiGetDirect(
+    JNIEnv* env, jobject /*jdb*/, jlong jdb_handle, jlong jropt_handle,
+    jlongArray jcolumn_family_handles, jobjectArray jkeys,
+    jintArray jkey_offs, jintArray jkey_lens, jobjectArray jvalues,
+    jintArray jvalue_offs, jintArray jvalue_lens) {
+  auto* db = reinterpret_cast<TERARKDB_NAMESPACE::DB*>(jdb_handle);
+  static const TERARKDB_NAMESPACE::ReadOptions default_read_options;
+  const auto& read_options =
+      jropt_handle == 0
+          ? default_read_options
+          : *reinterpret_cast<TERARKDB_NAMESPACE::ReadOptions*>(jropt_handle);
+
+  const jsize num_keys = env->GetArrayLength(jkeys);
+  if (env->GetArrayLength(jcolumn_family_handles) != num_keys ||
+      env->GetArrayLength(jkey_offs) != num_keys ||
+      env->GetArrayLength(jkey_lens) != num_keys ||
+      env->GetArrayLength(jvalues) != num_keys ||
+      env->GetArrayLength(jvalue_offs) != num_keys ||
+      env->GetArrayLength(jvalue_lens) != num_keys) {
+    TERARKDB_NAMESPACE::IllegalArgumentExceptionJni::ThrowNew(
+        env, TERARKDB_NAMESPACE::Status::InvalidArgument(
+                 "multiGetDirect arrays of different lengths"));
+    return nullptr;
+  }
+
+  std::vector<jlong> cfh(num_keys);
+  std::vector<jint> key_offs(num_keys);
+  std::vector<jint> key_lens(num_keys);
+  std::vector<jint> value_offs(num_keys);
+  std::vector<jint> value_lens(num_keys);
+  env->GetLongArrayRegion(jcolumn_family_handles, 0, num_keys, cfh.data());
+  env->GetIntArrayRegion(jkey_offs, 0, num_keys, key_offs.data());
+  env->GetIntArrayRegion(jkey_lens, 0, num_keys, key_lens.data());
+  env->GetIntArrayRegion(jvalue_offs, 0, num_keys, value_offs.data());
+  env->GetIntArrayRegion(jvalue_lens, 0, num_keys, value_lens.data());
+  if (env->ExceptionCheck()) {
+    // exception thrown: ArrayIndexOutOfBoundsException
+    return nullptr;
+  }
+
+  std::vector<TERARKDB_NAMESPACE::ColumnFamilyHandle*> cf_handles(num_keys);
+  std::vector<TERARKDB_NAMESPACE::Slice> keys(num_keys);
+  std::vector<char*> value_regions(num_keys);
+  for (jsize i = 0; i < num_keys; i++) {
+    auto* cf_handle =
+        reinterpret_cast<TERARKDB_NAMESPACE::ColumnFamilyHandle*>(cfh[i]);
+    cf_handles[i] =
+        cf_handle != nullptr ? cf_handle : db->DefaultColumnFamily();
+
+    jobject jkey = env->GetObjectArrayElement(jkeys, i);
+    char* key = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+        env, jkey, key_offs[i], key_lens[i]);
+    env->DeleteLocalRef(jkey);
+    if (key == nullptr) {
+      // exception thrown: IllegalArgumentException
+      return nullptr;
+    }
+    keys[i] = TERARKDB_NAMESPACE::Slice(key, key_lens[i]);
+
+    jobject jvalue = env->GetObjectArrayElement(jvalues, i);
+    value_regions[i] = TERARKDB_NAMESPACE::JniUtil::directBufferRegion(
+        env, jvalue, value_offs[i], value_lens[i]);
+    env->DeleteLocalRef(jvalue);
+    if (value_regions[i] == nullptr) {
+      // exception thrown: IllegalArgumentException
+      return nullptr;
+    }
+  }
+
+  std::vector<std::string> values;
+  std::vector<TERARKDB_NAMESPACE::Status> s =
+      db->MultiGet(read_options, cf_handles, keys, &values);
+
+  std::vector<jint> results(num_keys);
+  for (jsize i = 0; i < num_keys; i++) {
+    if (s[i].IsNotFound()) {
+      results[i] = kDirectNotFound;
+      continue;
+    }
+    if (!s[i].ok()) {
+      TERARKDB_NAMESPACE::RocksDBExceptionJni::ThrowNew(env, s[i]);
+      return nullptr;
+    }
+    results[i] = static_cast<jint>(values[i].size());
+    memcpy(value_regions[i], values[i].data(),
+           std::min(value_lens[i], results[i]));
+  }
+
+  jintArray jresults = env->NewIntArray(num_keys);
+  if (jresults == nullptr) {
+    // exception thrown: OutOfMemoryError
+    return nullptr;
+  }
+  env->SetIntArrayRegion(jresults, 0, num_keys, results.data());
+  if (env->ExceptionCheck()) {
+    // exception thrown: ArrayIndexOutOfBoundsException
+    env->DeleteLocalRef(jresults);
+    return nullptr;
+  }
+  return jresults;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // TERARKDB_NAMESPACE::DB::Delete()
 
@@ -32,7 +32,11 @@ public class FlinkCompactionFilter
   private native static void disposeFlinkCompactionFilterConfigHolder(long configHolderHandle);
   private native static boolean configureFlinkCompactionFilter(
           long configHolderHandle, int stateType, int timestampOffset, long ttl, long queryTimeAfterNumEntries,
-          int fixedElementLength, ListElementFilterFactory listElementFilterFactory);
+          int fixedElementLength, boolean lengthPrefixedElements,
+          ListElementFilterFactory listElementFilterFactory);
+
+  /** Byte length of the big endian element length in front of each element of a length prefixed list. */
+  public static final int LIST_ELEMENT_HEADER_LENGTH = 4;
 
    public interface ListElementFilter {
     /**
@@ -63,16 +67,26 @@ public class FlinkCompactionFilter
     /** Number of state entries to process by compaction filter before updating current timestamp. */
     final long queryTimeAfterNumEntries;
     final int fixedElementLength;
+    final boolean lengthPrefixedElements;
     final ListElementFilterFactory listElementFilterFactory;
 
      private Config(
             StateType stateType, int timestampOffset, long ttl, long queryTimeAfterNumEntries,
             int fixedElementLength, ListElementFilterFactory listElementFilterFactory) {
+      this(stateType, timestampOffset, ttl, queryTimeAfterNumEntries, fixedElementLength, false,
+          listElementFilterFactory);
+    }
+
+     private Config(
+            StateType stateType, int timestampOffset, long ttl, long queryTimeAfterNumEntries,
+            int fixedElementLength, boolean lengthPrefixedElements,
+            ListElementFilterFactory listElementFilterFactory) {
       this.stateType = stateType;
       this.timestampOffset = timestampOffset;
       this.ttl = ttl;
       this.queryTimeAfterNumEntries = queryTimeAfterNumEntries;
       this.fixedElementLength = fixedElementLength;
+      this.lengthPrefixedElements = lengthPrefixedElements;
       this.listElementFilterFactory = listElementFilterFactory;
     }
 
@@ -100,6 +114,17 @@ public class FlinkCompactionFilter
     public static Config createForList(long ttl, long queryTimeAfterNumEntries, ListElementFilterFactory listElementFilterFactory) {
       return new Config(StateType.List, 0, ttl, queryTimeAfterNumEntries, -1, listElementFilterFactory);
     }
+
+     /**
+     * List state whose elements have a variable byte length, each serialized with its
+     * {@link #LIST_ELEMENT_HEADER_LENGTH} bytes big endian length in front and its last access
+     * timestamp first. The list is filtered natively, without calling back into Java per element
+     * like {@link #createForList} does.
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static Config createForLengthPrefixedList(long ttl, long queryTimeAfterNumEntries) {
+      return new Config(StateType.List, LIST_ELEMENT_HEADER_LENGTH, ttl, queryTimeAfterNumEntries, -1, true, null);
+    }
   }
 
    private static class ConfigHolder extends RocksObject {
@@ -158,7 +183,8 @@ public class FlinkCompactionFilter
     public void configure(Config config) {
       boolean already_configured = !configureFlinkCompactionFilter(
               configHolder.nativeHandle_, config.stateType.ordinal(), config.timestampOffset,
-              config.ttl, config.queryTimeAfterNumEntries, config.fixedElementLength, config.listElementFilterFactory);
+              config.ttl, config.queryTimeAfterNumEntries, config.fixedElementLength,
+              config.lengthPrefixedElements, config.listElementFilterFactory);
       if (already_configured) {
         throw new IllegalStateException("Compaction filter is already configured");
       }
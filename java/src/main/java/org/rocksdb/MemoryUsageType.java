@@ -28,10 +28,30 @@ public enum MemoryUsageType {
    * Memory usage by Cache.
    */
   kCacheTotal((byte) 3),
+  /**
+   * Memory usage of the indexes of the table readers.
+   */
+  kTableIndexTotal((byte) 4),
+  /**
+   * Memory usage of the compression dictionaries of the table readers.
+   */
+  kTableDictTotal((byte) 5),
+  /**
+   * Working memory of the table builders.
+   */
+  kTableBuilderTotal((byte) 6),
+  /**
+   * Memory usage of the metadata of separated values and Map SSTs.
+   */
+  kBlobReferenceTotal((byte) 7),
+  /**
+   * Memory usage of the un-flushed mem-table reps outside their arenas.
+   */
+  kMemTableRepTotal((byte) 8),
   /**
    * Max usage types - copied to keep 1:1 with native.
    */
-  kNumUsageTypes((byte) 4);
+  kNumUsageTypes((byte) 9);
 
   /**
    * Returns the byte value of the enumerations value
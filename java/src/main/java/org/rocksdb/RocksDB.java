@@ -7,6 +7,7 @@ package org.rocksdb;
 
 import java.util.*;
 import java.io.IOException;
+import java.nio.ByteBuffer;
 import java.util.concurrent.atomic.AtomicInteger;
 import java.util.concurrent.atomic.AtomicReference;
 
@@ -453,6 +454,12 @@ public class RocksDB extends RocksObject {
     }
   }
 
+  static void checkDirect(final ByteBuffer buffer) {
+    if (!buffer.isDirect()) {
+      throw new IllegalArgumentException("ByteBuffer must be direct");
+    }
+  }
+
   /**
    * Set the database entry for "key" to "value".
    *
@@ -630,6 +637,56 @@ public class RocksDB extends RocksObject {
         vOffset, vLen, columnFamilyHandle.nativeHandle_);
   }
 
+  /**
+   * Set the database entry for "key" to "value", reading both in place
+   * from direct buffers without copying them to the Java heap.
+   *
+   * The key and the value are the remaining bytes of the buffers, whose
+   * positions are advanced to their limits.
+   *
+   * @param writeOpts {@link org.rocksdb.WriteOptions} instance.
+   * @param key the direct buffer of the key
+   * @param value the direct buffer of the value
+   *
+   * @throws RocksDBException thrown if error happens in underlying
+   *    native library.
+   * @throws IllegalArgumentException thrown if a buffer is not direct.
+   */
+  public void put(final WriteOptions writeOpts, final ByteBuffer key,
+      final ByteBuffer value) throws RocksDBException {
+    put(null, writeOpts, key, value);
+  }
+
+  /**
+   * Set the database entry for "key" to "value" in the specified column
+   * family, reading both in place from direct buffers without copying them
+   * to the Java heap.
+   *
+   * The key and the value are the remaining bytes of the buffers, whose
+   * positions are advanced to their limits.
+   *
+   * @param columnFamilyHandle {@link org.rocksdb.ColumnFamilyHandle}
+   *     instance, null for the default column family
+   * @param writeOpts {@link org.rocksdb.WriteOptions} instance.
+   * @param key the direct buffer of the key
+   * @param value the direct buffer of the value
+   *
+   * @throws RocksDBException thrown if error happens in underlying
+   *    native library.
+   * @throws IllegalArgumentException thrown if a buffer is not direct.
+   */
+  public void put(final ColumnFamilyHandle columnFamilyHandle,
+      final WriteOptions writeOpts, final ByteBuffer key,
+      final ByteBuffer value) throws RocksDBException {
+    checkDirect(key);
+    checkDirect(value);
+    putDirect(nativeHandle_, writeOpts.nativeHandle_, key, key.position(),
+        key.remaining(), value, value.position(), value.remaining(),
+        columnFamilyHandle == null ? 0 : columnFamilyHandle.nativeHandle_);
+    key.position(key.limit());
+    value.position(value.limit());
+  }
+
   /**
    * If the key definitely does not exist in the database, then this method
    * returns false, else true.
@@ -1222,6 +1279,63 @@ public class RocksDB extends RocksObject {
         vOffset, vLen, columnFamilyHandle.nativeHandle_);
   }
 
+  /**
+   * Get the value associated with the specified key, reading the key from
+   * and writing the value to direct buffers in place.
+   *
+   * The key is the remaining bytes of {@code key}, whose position is
+   * advanced to its limit. The value is written from the position of
+   * {@code value}, whose limit is set to the end of the value written.
+   *
+   * @param opt {@link org.rocksdb.ReadOptions} instance.
+   * @param key the direct buffer of the key
+   * @param value the direct buffer receiving the value
+   * @return The size of the actual value that matches the specified
+   *     {@code key} in byte.  If the return value is greater than the
+   *     remaining bytes of {@code value}, then it indicates that the
+   *     buffer is insufficient and partial result will be returned.
+   *     RocksDB.NOT_FOUND will be returned if the value not found.
+   *
+   * @throws RocksDBException thrown if error happens in underlying
+   *    native library.
+   * @throws IllegalArgumentException thrown if a buffer is not direct.
+   */
+  public int get(final ReadOptions opt, final ByteBuffer key,
+      final ByteBuffer value) throws RocksDBException {
+    return get(null, opt, key, value);
+  }
+
+  /**
+   * Get the value associated with the specified key within column family,
+   * reading the key from and writing the value to direct buffers in place.
+   *
+   * @param columnFamilyHandle {@link org.rocksdb.ColumnFamilyHandle}
+   *     instance, null for the default column family
+   * @param opt {@link org.rocksdb.ReadOptions} instance.
+   * @param key the direct buffer of the key
+   * @param value the direct buffer receiving the value
+   * @return the same as {@link #get(ReadOptions, ByteBuffer, ByteBuffer)}
+   *
+   * @throws RocksDBException thrown if error happens in underlying
+   *    native library.
+   * @throws IllegalArgumentException thrown if a buffer is not direct.
+   */
+  public int get(final ColumnFamilyHandle columnFamilyHandle,
+      final ReadOptions opt, final ByteBuffer key, final ByteBuffer value)
+      throws RocksDBException {
+    checkDirect(key);
+    checkDirect(value);
+    final int result = getDirect(nativeHandle_, opt.nativeHandle_, key,
+        key.position(), key.remaining(), value, value.position(),
+        value.remaining(),
+        columnFamilyHandle == null ? 0 : columnFamilyHandle.nativeHandle_);
+    if (result != NOT_FOUND) {
+      value.limit(Math.min(value.limit(), value.position() + result));
+    }
+    key.position(key.limit());
+    return result;
+  }
+
   /**
    * The simplified version of get which returns a new byte array storing
    * the value associated with the specified input key if any.  null will be
@@ -1580,6 +1694,75 @@ public class RocksDB extends RocksObject {
     return keyValueMap;
   }
 
+  /**
+   * Gets the values of a batch of keys in a single call into the native
+   * library, reading the keys from and writing the values to direct
+   * buffers in place, without allocating anything per key.
+   *
+   * The keys are the remaining bytes of the buffers of {@code keys}. Each
+   * value is written from the position of its buffer in {@code values},
+   * whose limit is set to the end of the value written. The positions of
+   * the buffers are left unchanged.
+   *
+   * @param opt Read options.
+   * @param columnFamilyHandleList {@link java.util.List} containing
+   *     {@link org.rocksdb.ColumnFamilyHandle} instances, null elements or
+   *     a null list for the default column family.
+   * @param keys the direct buffers of the keys.
+   * @param values the direct buffers receiving the values.
+   * @return the sizes of the values, as returned by
+   *     {@link #get(ReadOptions, ByteBuffer, ByteBuffer)}.
+   *
+   * @throws RocksDBException thrown if error happens in underlying
+   *    native library.
+   * @throws IllegalArgumentException thrown if the lists are not of the same
+   *    size or a buffer is not direct.
+   */
+  public int[] multiGet(final ReadOptions opt,
+      final List<ColumnFamilyHandle> columnFamilyHandleList,
+      final List<ByteBuffer> keys, final List<ByteBuffer> values)
+      throws RocksDBException {
+    final int size = keys.size();
+    if (values.size() != size || (columnFamilyHandleList != null
+        && columnFamilyHandleList.size() != size)) {
+      throw new IllegalArgumentException(
+          "For each key there must be a value buffer and a ColumnFamilyHandle.");
+    }
+    final long[] cfHandles = new long[size];
+    final ByteBuffer[] keysArray = new ByteBuffer[size];
+    final int[] keyOffsets = new int[size];
+    final int[] keyLengths = new int[size];
+    final ByteBuffer[] valuesArray = new ByteBuffer[size];
+    final int[] valueOffsets = new int[size];
+    final int[] valueLengths = new int[size];
+    for (int i = 0; i < size; i++) {
+      final ColumnFamilyHandle cfHandle =
+          columnFamilyHandleList == null ? null : columnFamilyHandleList.get(i);
+      cfHandles[i] = cfHandle == null ? 0 : cfHandle.nativeHandle_;
+      final ByteBuffer key = keys.get(i);
+      checkDirect(key);
+      keysArray[i] = key;
+      keyOffsets[i] = key.position();
+      keyLengths[i] = key.remaining();
+      final ByteBuffer value = values.get(i);
+      checkDirect(value);
+      valuesArray[i] = value;
+      valueOffsets[i] = value.position();
+      valueLengths[i] = value.remaining();
+    }
+
+    final int[] results = multiGetDirect(nativeHandle_, opt.nativeHandle_,
+        cfHandles, keysArray, keyOffsets, keyLengths, valuesArray,
+        valueOffsets, valueLengths);
+    for (int i = 0; i < size; i++) {
+      if (results[i] != NOT_FOUND) {
+        valuesArray[i].limit(
+            Math.min(valuesArray[i].limit(), valueOffsets[i] + results[i]));
+      }
+    }
+    return results;
+  }
+
   /**
    * Remove the database entry (if any) for "key".  Returns OK on
    * success, and a non-OK status on error.  It is not an error if "key"
@@ -2927,6 +3110,10 @@ public class RocksDB extends RocksObject {
   protected native void put(long handle, long writeOptHandle, byte[] key,
       int keyOffset, int keyLength, byte[] value, int valueOffset,
       int valueLength, long cfHandle) throws RocksDBException;
+  protected native void putDirect(long handle, long writeOptHandle,
+      ByteBuffer key, int keyOffset, int keyLength, ByteBuffer value,
+      int valueOffset, int valueLength, long cfHandle)
+      throws RocksDBException;
   protected native void write0(final long handle, long writeOptHandle,
       long wbHandle) throws RocksDBException;
   protected native void write1(final long handle, long writeOptHandle,
@@ -2968,6 +3155,15 @@ public class RocksDB extends RocksObject {
   protected native int get(long handle, long readOptHandle, byte[] key,
       int keyOffset, int keyLength, byte[] value, int valueOffset,
       int valueLength, long cfHandle) throws RocksDBException;
+  protected native int getDirect(long handle, long readOptHandle,
+      ByteBuffer key, int keyOffset, int keyLength, ByteBuffer value,
+      int valueOffset, int valueLength, long cfHandle)
+      throws RocksDBException;
+  protected native int[] multiGetDirect(final long dbHandle,
+      final long rOptHandle, final long[] columnFamilyHandles,
+      final ByteBuffer[] keys, final int[] keyOffsets, final int[] keyLengths,
+      final ByteBuffer[] values, final int[] valueOffsets,
+      final int[] valueLengths) throws RocksDBException;
   protected native byte[][] multiGet(final long dbHandle, final byte[][] keys,
       final int[] keyOffsets, final int[] keyLengths);
   protected native byte[][] multiGet(final long dbHandle, final byte[][] keys,
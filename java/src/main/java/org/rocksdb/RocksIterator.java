@@ -5,6 +5,8 @@
 
 package org.rocksdb;
 
+import java.nio.ByteBuffer;
+
 /**
  * <p>An iterator that yields a sequence of key/value pairs from a source.
  * Multiple implementations are provided by this library.
@@ -50,6 +52,60 @@ public class RocksIterator extends AbstractRocksIterator<RocksDB> {
     return value0(nativeHandle_);
   }
 
+  /**
+   * <p>Copies the key for the current entry into a direct buffer, from its
+   * position. The limit of the buffer is set to the end of the key
+   * written.</p>
+   *
+   * <p>REQUIRES: {@link #isValid()}</p>
+   *
+   * @param key the direct buffer receiving the key.
+   * @return the size of the key. If it is greater than the remaining bytes
+   *     of {@code key}, then only a prefix of the key is copied.
+   */
+  public int key(final ByteBuffer key) {
+    assert(isOwningHandle());
+    RocksDB.checkDirect(key);
+    final int result = keyDirect0(nativeHandle_, key, key.position(),
+        key.remaining());
+    key.limit(Math.min(key.position() + result, key.limit()));
+    return result;
+  }
+
+  /**
+   * <p>Copies the value for the current entry into a direct buffer, from
+   * its position. The limit of the buffer is set to the end of the value
+   * written.</p>
+   *
+   * <p>REQUIRES: {@link #isValid()}</p>
+   *
+   * @param value the direct buffer receiving the value.
+   * @return the size of the value. If it is greater than the remaining
+   *     bytes of {@code value}, then only a prefix of the value is copied.
+   */
+  public int value(final ByteBuffer value) {
+    assert(isOwningHandle());
+    RocksDB.checkDirect(value);
+    final int result = valueDirect0(nativeHandle_, value, value.position(),
+        value.remaining());
+    value.limit(Math.min(value.position() + result, value.limit()));
+    return result;
+  }
+
+  /**
+   * <p>Position at the first key in the source that at or past the
+   * remaining bytes of the direct buffer {@code target}, which is read in
+   * place. The position of {@code target} is advanced to its limit.</p>
+   *
+   * @param target the direct buffer of the key to seek to.
+   */
+  public void seek(final ByteBuffer target) {
+    assert(isOwningHandle());
+    RocksDB.checkDirect(target);
+    seekDirect0(nativeHandle_, target, target.position(), target.remaining());
+    target.position(target.limit());
+  }
+
   @Override protected final native void disposeInternal(final long handle);
   @Override final native boolean isValid0(long handle);
   @Override final native void seekToFirst0(long handle);
@@ -62,4 +118,10 @@ public class RocksIterator extends AbstractRocksIterator<RocksDB> {
 
   private native byte[] key0(long handle);
   private native byte[] value0(long handle);
+  private native void seekDirect0(long handle, ByteBuffer target,
+      int targetOffset, int targetLen);
+  private native int keyDirect0(long handle, ByteBuffer buffer,
+      int bufferOffset, int bufferLen);
+  private native int valueDirect0(long handle, ByteBuffer buffer,
+      int bufferOffset, int bufferLen);
 }
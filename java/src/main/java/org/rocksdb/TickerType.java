@@ -492,7 +492,41 @@ public enum TickerType {
 
     SKIP_GC_GET_BY_FILE((byte) 0x64),
 
-    TICKER_ENUM_MAX((byte) 0x65);
+    BLOB_CACHE_HIT((byte) 0x65),
+
+    BLOB_CACHE_MISS((byte) 0x66),
+
+    TERARK_ZIP_RECORD_CACHE_HIT((byte) 0x67),
+
+    TERARK_ZIP_RECORD_CACHE_MISS((byte) 0x68),
+
+    CACHE_ADMISSION_REJECT((byte) 0x69),
+
+    CACHE_ADMISSION_REJECT_BYTES((byte) 0x6A),
+
+    NEGATIVE_LOOKUP_CACHE_HIT((byte) 0x6B),
+
+    NEGATIVE_LOOKUP_CACHE_MISS((byte) 0x6C),
+
+    RATE_LIMITER_LOW_PRI_BYTES((byte) 0x6D),
+
+    RATE_LIMITER_MID_PRI_BYTES((byte) 0x6E),
+
+    RATE_LIMITER_HIGH_PRI_BYTES((byte) 0x6F),
+
+    GC_READ_BYTES((byte) 0x70),
+
+    GC_WRITE_BYTES((byte) 0x71),
+
+    STALL_MEMTABLE_LIMIT_MICROS((byte) 0x72),
+
+    STALL_L0_FILE_COUNT_LIMIT_MICROS((byte) 0x73),
+
+    STALL_PENDING_COMPACTION_BYTES_MICROS((byte) 0x74),
+
+    STALL_READ_AMP_LIMIT_MICROS((byte) 0x75),
+
+    TICKER_ENUM_MAX((byte) 0x76);
 
 
     private final byte value;
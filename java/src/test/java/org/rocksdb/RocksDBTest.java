@@ -88,6 +88,70 @@ public class RocksDBTest {
     }
   }
 
+  private static ByteBuffer directBuffer(final String s) {
+    final byte[] bytes = s.getBytes();
+    final ByteBuffer buffer = ByteBuffer.allocateDirect(bytes.length);
+    buffer.put(bytes);
+    buffer.flip();
+    return buffer;
+  }
+
+  private static String bufferString(final ByteBuffer buffer) {
+    final byte[] bytes = new byte[buffer.remaining()];
+    buffer.duplicate().get(bytes);
+    return new String(bytes);
+  }
+
+  @Test
+  public void directBufferPutGet() throws RocksDBException {
+    try (final RocksDB db = RocksDB.open(dbFolder.getRoot().getAbsolutePath());
+         final WriteOptions writeOpts = new WriteOptions();
+         final ReadOptions readOpts = new ReadOptions()) {
+      final ByteBuffer key = directBuffer("key1");
+      db.put(writeOpts, key, directBuffer("value1"));
+      assertThat(key.remaining()).isEqualTo(0);
+      assertThat(db.get("key1".getBytes())).isEqualTo("value1".getBytes());
+
+      final ByteBuffer value = ByteBuffer.allocateDirect(16);
+      assertThat(db.get(readOpts, directBuffer("key1"), value)).isEqualTo(6);
+      assertThat(bufferString(value)).isEqualTo("value1");
+
+      // partial result
+      final ByteBuffer small = ByteBuffer.allocateDirect(3);
+      assertThat(db.get(readOpts, directBuffer("key1"), small)).isEqualTo(6);
+      assertThat(bufferString(small)).isEqualTo("val");
+
+      assertThat(db.get(readOpts, directBuffer("key2"),
+          ByteBuffer.allocateDirect(16))).isEqualTo(RocksDB.NOT_FOUND);
+
+      try {
+        db.get(readOpts, ByteBuffer.wrap("key1".getBytes()), value);
+        fail("heap buffers are rejected");
+      } catch (final IllegalArgumentException e) {
+        // expected
+      }
+    }
+  }
+
+  @Test
+  public void directBufferMultiGet() throws RocksDBException {
+    try (final RocksDB db = RocksDB.open(dbFolder.getRoot().getAbsolutePath());
+         final ReadOptions readOpts = new ReadOptions()) {
+      db.put("key1".getBytes(), "value1".getBytes());
+      db.put("key3".getBytes(), "value3".getBytes());
+
+      final List<ByteBuffer> keys = Arrays.asList(directBuffer("key1"),
+          directBuffer("key2"), directBuffer("key3"));
+      final List<ByteBuffer> values = Arrays.asList(
+          ByteBuffer.allocateDirect(16), ByteBuffer.allocateDirect(16),
+          ByteBuffer.allocateDirect(16));
+      final int[] results = db.multiGet(readOpts, null, keys, values);
+      assertThat(results).containsExactly(6, RocksDB.NOT_FOUND, 6);
+      assertThat(bufferString(values.get(0))).isEqualTo("value1");
+      assertThat(bufferString(values.get(2))).isEqualTo("value3");
+    }
+  }
+
   private static Segment sliceSegment(String key) {
     ByteBuffer rawKey = ByteBuffer.allocate(key.length() + 4);
     rawKey.put((byte)0);
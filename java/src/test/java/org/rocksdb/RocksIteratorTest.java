@@ -9,6 +9,8 @@ import org.junit.Rule;
 import org.junit.Test;
 import org.junit.rules.TemporaryFolder;
 
+import java.nio.ByteBuffer;
+
 import static org.assertj.core.api.Assertions.assertThat;
 
 public class RocksIteratorTest {
@@ -95,6 +97,28 @@ public class RocksIteratorTest {
         assertThat(iterator.isValid()).isTrue();
         assertThat(iterator.key()).isEqualTo("key2".getBytes());
       }
+
+      try (final RocksIterator iterator = db.newIterator()) {
+        final ByteBuffer target = ByteBuffer.allocateDirect(16);
+        target.put("key1.5".getBytes());
+        target.flip();
+        iterator.seek(target);
+        assertThat(target.remaining()).isEqualTo(0);
+        assertThat(iterator.isValid()).isTrue();
+
+        final ByteBuffer key = ByteBuffer.allocateDirect(16);
+        assertThat(iterator.key(key)).isEqualTo(4);
+        final byte[] keyBytes = new byte[key.remaining()];
+        key.get(keyBytes);
+        assertThat(keyBytes).isEqualTo("key2".getBytes());
+
+        // partial result
+        final ByteBuffer value = ByteBuffer.allocateDirect(2);
+        assertThat(iterator.value(value)).isEqualTo(6);
+        final byte[] valueBytes = new byte[value.remaining()];
+        value.get(valueBytes);
+        assertThat(valueBytes).isEqualTo("va".getBytes());
+      }
     }
   }
 }
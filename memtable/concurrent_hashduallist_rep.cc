@@ -19,11 +19,35 @@
 namespace TERARKDB_NAMESPACE {
 namespace {
 
+// Reverses the bits of v, which turns hashes into keys of the split order
+uint64_t ReverseBits(uint64_t v) {
+  v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+  v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+  v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+  v = ((v >> 8) & 0x00FF00FF00FF00FFull) | ((v & 0x00FF00FF00FF00FFull) << 8);
+  v = ((v >> 16) & 0x0000FFFF0000FFFFull) |
+      ((v & 0x0000FFFF0000FFFFull) << 16);
+  return (v >> 32) | (v << 32);
+}
+
+// All the nodes live in one list ordered by split key, the bit reversed hash
+// of their prefix, and then by user key (split-ordered list). A bucket is a
+// dummy node in that list, followed by the nodes whose hash modulo the bucket
+// count is the bucket index. When the bucket count doubles, bucket i + count
+// takes the second half of the nodes of bucket i, which come after its own
+// dummy node already, so growing the table moves no node and takes no lock:
+// the new buckets get their dummy nodes on first use.
 class ConcurrentHashDualListRep : public MemTableRep {
+  // The buckets are kept in segments which are never moved: segment 0 holds
+  // the initial buckets, segment k the buckets added by the k-th doubling
+  static constexpr size_t kMaxSegments = 32;
+  // The average number of user keys per bucket which doubles the buckets
+  static constexpr size_t kMaxBucketLoad = 2;
+
   struct Node {
     static constexpr uintptr_t vertical_tag = 1ull;
 
-    Node() {
+    Node() : split_key_(0) {
       next_[0].store(nullptr, std::memory_order_relaxed);
       next_[1].store(nullptr, std::memory_order_relaxed);
     }
@@ -44,12 +68,12 @@ class ConcurrentHashDualListRep : public MemTableRep {
 
     bool CASLevelNext(Node *expected, Node *x) {
       return next_[0].compare_exchange_strong(expected, x,
-                                              std::memory_order_relaxed);
+                                              std::memory_order_release);
     }
 
     bool CASVerticalNext(Node *expected, Node *x) {
       return next_[1].compare_exchange_strong(expected, x,
-                                              std::memory_order_relaxed);
+                                              std::memory_order_release);
     }
 
     Node *LevelNext() const {
@@ -94,28 +118,37 @@ class ConcurrentHashDualListRep : public MemTableRep {
       return !(v & 1);
     }
 
+    // Dummy nodes head the buckets and have no key
+    bool IsDummy() const { return (split_key_ & 1) == 0; }
+
     Node(const Node &) = delete;
     Node &operator=(const Node &) = delete;
 
     std::atomic<Node *> next_[2];
 
+    // The bit reversed hash of the prefix with the lowest bit set, or the bit
+    // reversed bucket index for dummy nodes
+    uint64_t split_key_;
+
     char key[1];
   };
 
+  // Iterates the nodes of one split key, which are sorted by user key
   class DuaLinkListIterator : public MemTableRep::Iterator {
    public:
     DuaLinkListIterator(const ConcurrentHashDualListRep *const memtable_rep,
-                        Pointer *bucket = nullptr)
+                        Node *head = nullptr, uint64_t split_key = 0)
         : memtable_rep_(memtable_rep),
-          bucket_(bucket),
+          head_(head),
+          split_key_(split_key),
           level_node_(nullptr),
           vertical_node_(nullptr) {}
 
     ~DuaLinkListIterator() = default;
 
     bool Valid() const override {
-      return (bucket_ != nullptr && level_node_ != nullptr &&
-              vertical_node_ != nullptr);
+      return (level_node_ != nullptr && vertical_node_ != nullptr &&
+              level_node_->split_key_ == split_key_);
     }
 
     const char *EncodedKey() const override {
@@ -136,10 +169,14 @@ class ConcurrentHashDualListRep : public MemTableRep {
 
     void Seek(const Slice &internal_key, const char *memtable_key) override {
       SeekToHead();
-      while (memtable_rep_->UserKeyIsAfterNode(internal_key, level_node_)) {
+      while (memtable_rep_->UserKeyIsAfterNode(split_key_, internal_key,
+                                               level_node_)) {
         level_node_ = level_node_->LevelNext();
       }
       vertical_node_ = level_node_;
+      if (!Valid()) {
+        return;
+      }
       while (memtable_rep_->KeyIsAfterNode(internal_key, vertical_node_)) {
         vertical_node_ = vertical_node_->VerticalNext();
       }
@@ -157,24 +194,27 @@ class ConcurrentHashDualListRep : public MemTableRep {
     bool IsSeekForPrevSupported() const override { return false; }
 
    protected:
-    void Reset(Pointer *bucket) {
-      if (bucket) {
-        bucket_ = bucket;
-        level_node_ = vertical_node_ =
-            reinterpret_cast<Node *>(bucket_->load(std::memory_order_acquire));
-      } else {
-        level_node_ = vertical_node_ = nullptr;
-      }
+    void Reset(Node *head, uint64_t split_key) {
+      head_ = head;
+      split_key_ = split_key;
+      level_node_ = vertical_node_ = nullptr;
     }
 
    private:
     friend class ConcurrentHashDualListRep;
     const ConcurrentHashDualListRep *const memtable_rep_;
-    Pointer *bucket_;
+    Node *head_;
+    uint64_t split_key_;
     Node *level_node_;
     Node *vertical_node_;
 
-    void SeekToHead() { Reset(bucket_); }
+    void SeekToHead() {
+      level_node_ = head_;
+      while (level_node_ != nullptr && level_node_->split_key_ < split_key_) {
+        level_node_ = level_node_->LevelNext();
+      }
+      vertical_node_ = level_node_;
+    }
   };
 
   class DynamicIterator : public DuaLinkListIterator {
@@ -186,8 +226,8 @@ class ConcurrentHashDualListRep : public MemTableRep {
 
     void Seek(const Slice &k, const char *memtable_key) override {
       assert(memtable_rep_);
-      Pointer &bucket = memtable_rep_->GetBucket(k);
-      Reset(&bucket);
+      uint64_t hash = memtable_rep_->GetHash(memtable_rep_->GetPrefix(k));
+      Reset(memtable_rep_->FindBucketHead(hash), SplitKey(hash));
       DuaLinkListIterator::Seek(k, memtable_key);
     }
 
@@ -214,11 +254,15 @@ class ConcurrentHashDualListRep : public MemTableRep {
                             Allocator *allocator,
                             std::unique_ptr<Pointer[], BucketCleaner> &&_mem,
                             const SliceTransform *transform, size_t bucket_size,
+                            bool enable_bucket_growth,
                             size_t huge_page_tlb_size, Logger *logger,
                             int bucket_entries_logging_threshold,
                             bool if_log_bucket_dist_when_flush)
       : MemTableRep(allocator),
+        initial_bucket_size_(bucket_size),
+        max_bucket_size_(bucket_size),
         bucket_size_(bucket_size),
+        num_level_nodes_(0),
         mem_(std::move(_mem)),
         transform_(transform),
         compare_(compare),
@@ -227,18 +271,23 @@ class ConcurrentHashDualListRep : public MemTableRep {
         // bucket_entries_logging_threshold_(bucket_entries_logging_threshold),
         if_log_bucket_dist_when_flush_(if_log_bucket_dist_when_flush) {
     assert(allocator_);
-    if (mem_) {
-      buckets_ = mem_.get();
-    } else {
-      char *mem = allocator_->AllocateAligned(sizeof(Pointer) * bucket_size_,
-                                              huge_page_tlb_size_, logger_);
-
-      buckets_ = new (mem) Pointer[bucket_size_];
-
-      for (size_t i = 0; i < bucket_size_; ++i) {
-        buckets_[i].store(nullptr, std::memory_order_relaxed);
+    assert(bucket_size > 0 && (bucket_size & (bucket_size - 1)) == 0);
+    if (enable_bucket_growth) {
+      // Bucket indexes stay below 2^62, keeping the lowest bit of the split
+      // keys of dummy nodes clear
+      for (size_t i = 1; i < kMaxSegments &&
+                         max_bucket_size_ <= port::kMaxSizet / 4 / 2;
+           ++i) {
+        max_bucket_size_ *= 2;
       }
     }
+    for (auto &segment : segments_) {
+      segment.store(nullptr, std::memory_order_relaxed);
+    }
+    Pointer *buckets = mem_ ? mem_.get() : NewBuckets(initial_bucket_size_);
+    segments_[0].store(buckets, std::memory_order_relaxed);
+    head_ = NewDummyNode(0);
+    buckets[0].store(head_, std::memory_order_release);
   }
 
   KeyHandle Allocate(const size_t len, char **buf) override {
@@ -249,10 +298,12 @@ class ConcurrentHashDualListRep : public MemTableRep {
   }
 
   bool Contains(const Slice &internal_key) const override {
-    Pointer &bucket = GetBucket(internal_key);
-    Node *head = static_cast<Node *>(bucket.load(std::memory_order_acquire));
-    Node *x = FindGreaterOrEqualInBucket(head, internal_key);
-    return x != nullptr && Equal(internal_key, x->key);
+    uint64_t hash = GetHash(GetPrefix(internal_key));
+    uint64_t split_key = SplitKey(hash);
+    Node *x = FindGreaterOrEqualInBucket(FindBucketHead(hash), split_key,
+                                         internal_key);
+    return x != nullptr && x->split_key_ == split_key &&
+           Equal(internal_key, x->key);
   }
 
   void Insert(KeyHandle handle) override { return InsertImpl(handle, false); }
@@ -267,11 +318,8 @@ class ConcurrentHashDualListRep : public MemTableRep {
            bool (*callback_func)(void *arg, const Slice &key,
                                  const char *value)) override {
     auto internal_key = k.internal_key();
-    Pointer &bucket = GetBucket(internal_key);
-    if (!bucket.load(std::memory_order_acquire)) {
-      return;
-    }
-    DuaLinkListIterator iter(this, &bucket);
+    uint64_t hash = GetHash(GetPrefix(internal_key));
+    DuaLinkListIterator iter(this, FindBucketHead(hash), SplitKey(hash));
     for (iter.Seek(k.internal_key(), nullptr);
          iter.Valid() && callback_func(callback_args, iter.key(), iter.value());
          iter.Next()) {
@@ -293,58 +341,45 @@ class ConcurrentHashDualListRep : public MemTableRep {
  private:
   void InsertImpl(KeyHandle handle, bool concurrent) {
     Node *x = static_cast<Node *>(handle);
-    assert(x && !Contains(GetLengthPrefixedSlice(x->key)));
     auto internal_key = GetLengthPrefixedSlice(x->key);
-    Pointer &bucket = GetBucket(internal_key);
+    uint64_t hash = GetHash(GetPrefix(internal_key));
+    uint64_t split_key = SplitKey(hash);
+    x->split_key_ = split_key;
+    assert(!Contains(internal_key));
+    Node *head = GetBucketHead(hash);
     Node *prev = nullptr;
     for (;;) {
-      prev =
-          prev == nullptr
-              ? reinterpret_cast<Node *>(bucket.load(std::memory_order_acquire))
-              : prev;
-      prev = FindLessOrEqualInBucket(prev, internal_key);
-      assert(prev == nullptr || KeyIsAfterNode(internal_key, prev));
-      if (!UserKeyEqual(internal_key, prev)) {
+      // The dummy node of the bucket comes before the key, so prev is set
+      prev = FindLessOrEqualInBucket(prev == nullptr ? head : prev, split_key,
+                                     internal_key);
+      assert(prev != nullptr);
+      if (!UserKeyEqual(split_key, internal_key, prev)) {
         if (concurrent) {
-          Node *next = nullptr;
-          if (prev == nullptr) {
-            next = reinterpret_cast<Node *>(
-                bucket.load(std::memory_order_relaxed));
-          } else {
-            next = prev->NoBarrier_LevelNext();
-          }
-          if (UserKeyEqual(internal_key, next)) {
+          Node *next = prev->LevelNext();
+          bool replace = UserKeyEqual(split_key, internal_key, next);
+          if (replace) {
             x->NoBarrier_SetVerticalNext(next);
             next->MarkNodeVertical(true);
             x->NoBarrier_SetLevelNext(next->LevelNext());
           } else {
             x->NoBarrier_SetLevelNext(next);
           }
-          if (!KeyIsAfterNode(internal_key, next)) {
-            if (prev == nullptr) {
-              void *vnext = next;
-              if (bucket.compare_exchange_strong(vnext, (void *)x,
-                                                 std::memory_order_relaxed)) {
-                return;
-              }
-            } else if (prev->CASLevelNext(next, x)) {
-              return;
-            }
-            if (prev && !prev->NodeAtLevel()) {
-              prev = nullptr;
+          if (!KeyIsAfterNode(split_key, internal_key, next) &&
+              prev->CASLevelNext(next, x)) {
+            if (!replace) {
+              AddLevelNode();
             }
+            return;
+          }
+          if (!prev->NodeAtLevel()) {
+            prev = nullptr;
           }
           port::AsmVolatilePause();
           continue;
         } else {
-          Node *next = nullptr;
-          if (prev == nullptr) {
-            next = reinterpret_cast<Node *>(
-                bucket.load(std::memory_order_relaxed));
-          } else {
-            next = prev->NoBarrier_LevelNext();
-          }
-          if (UserKeyEqual(internal_key, next)) {
+          Node *next = prev->NoBarrier_LevelNext();
+          bool replace = UserKeyEqual(split_key, internal_key, next);
+          if (replace) {
             assert(next && next->NodeAtLevel());
             x->NoBarrier_SetVerticalNext(next);
             next->MarkNodeVertical(false);
@@ -352,10 +387,9 @@ class ConcurrentHashDualListRep : public MemTableRep {
           }
           assert(!next || next->NodeAtLevel());
           x->NoBarrier_SetLevelNext(next);
-          if (prev == nullptr) {
-            bucket.store(x, std::memory_order_release);
-          } else {
-            prev->SetLevelNext(x);
+          prev->SetLevelNext(x);
+          if (!replace) {
+            AddLevelNode();
           }
           return;
         }
@@ -378,33 +412,168 @@ class ConcurrentHashDualListRep : public MemTableRep {
     }
   }
 
+  // Counts a new user key, and doubles the buckets once they are loaded
+  void AddLevelNode() {
+    if (max_bucket_size_ == initial_bucket_size_) {
+      return;
+    }
+    size_t count = num_level_nodes_.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t bucket_size = bucket_size_.load(std::memory_order_relaxed);
+    if (count > bucket_size * kMaxBucketLoad &&
+        bucket_size < max_bucket_size_) {
+      bucket_size_.compare_exchange_strong(bucket_size, bucket_size * 2,
+                                           std::memory_order_release);
+    }
+  }
+
   Slice GetPrefix(const Slice &internal_key) const {
     assert(transform_);
     return transform_->Transform(ExtractUserKey(internal_key));
   }
 
-  size_t GetHash(const Slice &key) const {
-    return MurmurHash(key.data(), key.size(), 0) % bucket_size_;
+  uint64_t GetHash(const Slice &key) const {
+    return MurmurHash(key.data(), static_cast<int>(key.size()), 0);
   }
 
-  Pointer &GetBucket(const Slice &internal_key) const {
-    size_t i = GetHash(GetPrefix(internal_key));
-    assert(i < bucket_size_);
-    return buckets_[i];
+  // The split key of the nodes whose prefix has the hash
+  static uint64_t SplitKey(uint64_t hash) {
+    return ReverseBits(hash | (1ull << 63));
   }
 
-  Pointer &GetBucket(const char *key) const {
-    assert(key != nullptr);
-    return GetBucket(GetLengthPrefixedSlice(key));
+  // The bucket i splits from: i without its highest bit
+  static size_t ParentBucket(size_t i) {
+    assert(i > 0);
+    size_t highest = i;
+    while (highest & (highest - 1)) {
+      highest &= highest - 1;
+    }
+    return i ^ highest;
   }
 
-  Node *FindGreaterOrEqualInBucket(Node *x, const Slice &internal_key) const {
+  size_t SegmentOf(size_t i, size_t *offset) const {
+    if (i < initial_bucket_size_) {
+      *offset = i;
+      return 0;
+    }
+    size_t segment = 1;
+    size_t begin = initial_bucket_size_;
+    while (i >= begin * 2) {
+      begin *= 2;
+      ++segment;
+    }
+    assert(segment < kMaxSegments);
+    *offset = i - begin;
+    return segment;
+  }
+
+  Pointer *NewBuckets(size_t count) {
+    char *mem = allocator_->AllocateAligned(sizeof(Pointer) * count,
+                                            huge_page_tlb_size_, logger_);
+    Pointer *buckets = new (mem) Pointer[count];
+    for (size_t i = 0; i < count; ++i) {
+      buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+    return buckets;
+  }
+
+  Node *NewDummyNode(size_t i) {
+    char *mem = allocator_->AllocateAligned(sizeof(Node));
+    Node *x = new (mem) Node();
+    x->split_key_ = ReverseBits(i);
+    assert(x->IsDummy());
+    return x;
+  }
+
+  // The slot of bucket i, allocating its segment when missing
+  Pointer *GetBucketSlot(size_t i) {
+    size_t offset;
+    size_t segment = SegmentOf(i, &offset);
+    Pointer *buckets = segments_[segment].load(std::memory_order_acquire);
+    if (buckets == nullptr) {
+      // The loser of a race leaves its segment in the arena
+      Pointer *new_buckets = NewBuckets(initial_bucket_size_
+                                        << (segment - 1));
+      if (segments_[segment].compare_exchange_strong(
+              buckets, new_buckets, std::memory_order_acq_rel)) {
+        buckets = new_buckets;
+      }
+    }
+    return buckets + offset;
+  }
+
+  // The dummy node of the bucket of hash, inserting it when missing
+  Node *GetBucketHead(uint64_t hash) {
+    size_t i = hash & (bucket_size_.load(std::memory_order_acquire) - 1);
+    Pointer *slot = GetBucketSlot(i);
+    Node *head = static_cast<Node *>(slot->load(std::memory_order_acquire));
+    return head != nullptr ? head : InitializeBucket(i, slot);
+  }
+
+  // Readers start from the nearest initialized bucket instead, whose nodes
+  // include the ones of the missing bucket
+  Node *FindBucketHead(uint64_t hash) const {
+    size_t i = hash & (bucket_size_.load(std::memory_order_acquire) - 1);
+    for (;;) {
+      size_t offset;
+      Pointer *buckets =
+          segments_[SegmentOf(i, &offset)].load(std::memory_order_acquire);
+      if (buckets != nullptr) {
+        Node *head =
+            static_cast<Node *>(buckets[offset].load(std::memory_order_acquire));
+        if (head != nullptr) {
+          return head;
+        }
+      }
+      i = ParentBucket(i);
+    }
+  }
+
+  Node *InitializeBucket(size_t i, Pointer *slot) {
+    size_t parent = ParentBucket(i);
+    Pointer *parent_slot = GetBucketSlot(parent);
+    Node *parent_head =
+        static_cast<Node *>(parent_slot->load(std::memory_order_acquire));
+    if (parent_head == nullptr) {
+      parent_head = InitializeBucket(parent, parent_slot);
+    }
+    uint64_t split_key = ReverseBits(i);
+    Node *head = nullptr;
+    Node *prev = parent_head;
+    for (;;) {
+      Node *next = prev->LevelNext();
+      while (next != nullptr && next->split_key_ < split_key) {
+        prev = next;
+        next = prev->LevelNext();
+      }
+      if (next != nullptr && next->split_key_ == split_key) {
+        // Inserted by another thread
+        head = next;
+        break;
+      }
+      if (head == nullptr) {
+        head = NewDummyNode(i);
+      }
+      head->NoBarrier_SetLevelNext(next);
+      if (prev->CASLevelNext(next, head)) {
+        break;
+      }
+      if (!prev->NodeAtLevel()) {
+        prev = parent_head;
+      }
+      port::AsmVolatilePause();
+    }
+    slot->store(head, std::memory_order_release);
+    return head;
+  }
+
+  Node *FindGreaterOrEqualInBucket(Node *x, uint64_t split_key,
+                                   const Slice &internal_key) const {
     while (true) {
-      if (UserKeyIsAfterNode(internal_key, x)) {
+      if (UserKeyIsAfterNode(split_key, internal_key, x)) {
         // Keep searching in this list
         assert(x);
         x = x->LevelNext();
-      } else if (!UserKeyEqual(internal_key, x)) {
+      } else if (!UserKeyEqual(split_key, internal_key, x)) {
         return x;
       } else {
         break;
@@ -412,7 +581,7 @@ class ConcurrentHashDualListRep : public MemTableRep {
     }
     Node *y = x;
     while (true) {
-      assert(UserKeyEqual(internal_key, y));
+      assert(UserKeyEqual(split_key, internal_key, y));
       if (KeyIsAfterNode(internal_key, y)) {
         y = y->VerticalNext();
       } else {
@@ -426,22 +595,23 @@ class ConcurrentHashDualListRep : public MemTableRep {
     }
   }
 
-  Node *FindLessOrEqualInBucket(Node *prev, const Slice &internal_key) const {
+  Node *FindLessOrEqualInBucket(Node *prev, uint64_t split_key,
+                                const Slice &internal_key) const {
     // assert(prev == nullptr || KeyIsAfterNode(internal_key, prev));
     Node *x = prev;
     prev = nullptr;
     while (true) {
-      if (UserKeyIsAfterNode(internal_key, x)) {
+      if (UserKeyIsAfterNode(split_key, internal_key, x)) {
         assert(x);
         prev = x;
         x = x->LevelNext();
-      } else if (UserKeyEqual(internal_key, x)) {
+      } else if (UserKeyEqual(split_key, internal_key, x)) {
         break;
       } else {
         return prev;
       }
     }
-    assert(UserKeyEqual(internal_key, x));
+    assert(UserKeyEqual(split_key, internal_key, x));
     while (true) {
       // assert(UserKeyEqual(x, prev));
       if (KeyIsAfterNode(internal_key, x)) {
@@ -455,13 +625,33 @@ class ConcurrentHashDualListRep : public MemTableRep {
     }
   }
 
+  // Compares n with the key in the level order, by split key first. The
+  // split key of the key is never the one of a dummy node
+  int LevelCompare(const Node *n, uint64_t split_key,
+                   const Slice &internal_key) const {
+    if (n->split_key_ != split_key) {
+      return n->split_key_ < split_key ? -1 : 1;
+    }
+    return CompareUserKey(GetLengthPrefixedSlice(n->key), internal_key);
+  }
+
+  // For the nodes of one user key
   bool KeyIsAfterNode(const Slice &internal_key, const Node *n) const {
     return n != nullptr && compare_(n->key, internal_key) < 0;
   }
 
-  bool UserKeyIsAfterNode(const Slice &internal_key, const Node *n) const {
-    return n != nullptr &&
-           CompareUserKey(GetLengthPrefixedSlice(n->key), internal_key) < 0;
+  bool KeyIsAfterNode(uint64_t split_key, const Slice &internal_key,
+                      const Node *n) const {
+    if (n == nullptr) {
+      return false;
+    }
+    int c = LevelCompare(n, split_key, internal_key);
+    return c < 0 || (c == 0 && compare_(n->key, internal_key) < 0);
+  }
+
+  bool UserKeyIsAfterNode(uint64_t split_key, const Slice &internal_key,
+                          const Node *n) const {
+    return n != nullptr && LevelCompare(n, split_key, internal_key) < 0;
   }
 
   int CompareUserKey(const Slice &ileft, const Slice &iright) const {
@@ -469,24 +659,24 @@ class ConcurrentHashDualListRep : public MemTableRep {
         ExtractUserKey(ileft), ExtractUserKey(iright));
   }
 
-  bool UserKeyEqual(const Slice &internal_key, const Node *n) const {
-    return n != nullptr &&
-           CompareUserKey(GetLengthPrefixedSlice(n->key), internal_key) == 0;
-  }
-
-  bool UserKeyEqual(const Node *l, const Node *r) const {
-    if (l == nullptr || r == nullptr) {
-      return l == r;
-    }
-    return CompareUserKey(GetLengthPrefixedSlice(l->key),
-                          GetLengthPrefixedSlice(r->key)) == 0;
+  bool UserKeyEqual(uint64_t split_key, const Slice &internal_key,
+                    const Node *n) const {
+    return n != nullptr && LevelCompare(n, split_key, internal_key) == 0;
   }
 
   bool Equal(const Slice &a, const Key &b) const { return compare_(b, a) == 0; }
 
-  size_t bucket_size_;
+  // Rounded up to a power of two by the factory
+  const size_t initial_bucket_size_;
+  size_t max_bucket_size_;
+  std::atomic<size_t> bucket_size_;
+  // The user keys, which the bucket count follows
+  std::atomic<size_t> num_level_nodes_;
+
+  std::atomic<Pointer *> segments_[kMaxSegments];
 
-  Pointer *buckets_;
+  // The dummy node of bucket 0, the first node of the list
+  Node *head_;
 
   std::unique_ptr<Pointer[], BucketCleaner> mem_;
 
@@ -506,19 +696,27 @@ MemTableRep::Iterator *ConcurrentHashDualListRep::GetIterator(
   auto list = new MemtableSkipList(compare_, new_arena);
   HistogramImpl keys_per_bucket_hist;
 
-  for (size_t i = 0; i < bucket_size_; ++i) {
-    size_t count = 0;
-    DuaLinkListIterator iter(this, buckets_ + i);
-    for (iter.SeekToHead(); iter.Valid(); iter.Next()) {
-      list->Insert(iter.EncodedKey());
-      ++count;
+  // Walks the whole list, counting the keys between dummy nodes
+  size_t count = 0;
+  for (Node *level = head_; level != nullptr; level = level->LevelNext()) {
+    if (level->IsDummy()) {
+      if (level != head_ && if_log_bucket_dist_when_flush_) {
+        keys_per_bucket_hist.Add(count);
+      }
+      count = 0;
+      continue;
     }
-    if (if_log_bucket_dist_when_flush_) {
-      keys_per_bucket_hist.Add(count);
+    for (Node *x = level; x != nullptr; x = x->VerticalNext()) {
+      list->Insert(x->key);
+      ++count;
     }
   }
   if (if_log_bucket_dist_when_flush_ && logger_ != nullptr) {
-    Info(logger_, "ConcurrentHashDualList Entry distribution among buckets: %s",
+    keys_per_bucket_hist.Add(count);
+    Info(logger_,
+         "ConcurrentHashDualList %" ROCKSDB_PRIszt
+         " buckets, entry distribution among initialized buckets: %s",
+         bucket_size_.load(std::memory_order_relaxed),
          keys_per_bucket_hist.ToString().c_str());
   }
   if (alloc_arena == nullptr) {
@@ -546,17 +744,18 @@ MemTableRep *ConcurrentHashDualListReqFactory::CreateMemTableRep(
   }
   return new ConcurrentHashDualListRep(
       compare, allocator, std::move(mem), transform, bucket_count_,
-      huge_page_tlb_size_, logger, bucket_entries_logging_threshold_,
+      enable_bucket_growth_, huge_page_tlb_size_, logger, bucket_entries_logging_threshold_,
       if_log_bucket_dist_when_flush_);
 }
 
 MemTableRepFactory *NewConcurrentHashDualListReqFactory(
     size_t bucket_count, size_t huge_page_tlb_size,
     int bucket_entries_logging_threshold, size_t num_hash_buckets_preallocated,
-    bool if_log_bucket_dist_when_flush) {
+    bool if_log_bucket_dist_when_flush, bool enable_bucket_growth) {
   return new ConcurrentHashDualListReqFactory(
       bucket_count, huge_page_tlb_size, bucket_entries_logging_threshold,
-      num_hash_buckets_preallocated, if_log_bucket_dist_when_flush);
+      num_hash_buckets_preallocated, if_log_bucket_dist_when_flush,
+      enable_bucket_growth);
 }
 
 MemTableRepFactory *NewConcurrentHashDualListReqFactory(
@@ -598,9 +797,21 @@ MemTableRepFactory *NewConcurrentHashDualListReqFactory(
     }
   }
 
+  bool enable_bucket_growth = true;
+  f = options.find("enable_bucket_growth");
+  if (options.end() != f) {
+    try {
+      enable_bucket_growth = ParseBoolean("", f->second);
+    } catch (const std::exception &) {
+      *s = Status::InvalidArgument("NewConcurrentHashDualListReqFactory",
+                                   "enable_bucket_growth");
+    }
+  }
+
   return new ConcurrentHashDualListReqFactory(
       bucket_count, huge_page_tlb_size, bucket_entries_logging_threshold,
-      num_hash_buckets_preallocated, if_log_bucket_dist_when_flush);
+      num_hash_buckets_preallocated, if_log_bucket_dist_when_flush,
+      enable_bucket_growth);
 }
 
 ROCKSDB_REGISTER_MEM_TABLE("dualhash_linklist",
@@ -45,12 +45,14 @@ class ConcurrentHashDualListReqFactory : public MemTableRepFactory {
                                    size_t huge_page_tlb_size,
                                    int bucket_entries_logging_threshold,
                                    size_t num_hash_buckets_preallocated,
-                                   bool if_log_bucket_dist_when_flush)
-      : bucket_count_(bucket_count),
+                                   bool if_log_bucket_dist_when_flush,
+                                   bool enable_bucket_growth)
+      : bucket_count_(RoundUpBucketCount(bucket_count)),
         huge_page_tlb_size_(huge_page_tlb_size),
         bucket_entries_logging_threshold_(bucket_entries_logging_threshold),
         num_hash_buckets_preallocated_(num_hash_buckets_preallocated),
         if_log_bucket_dist_when_flush_(if_log_bucket_dist_when_flush),
+        enable_bucket_growth_(enable_bucket_growth),
         bucket_cleaner_(this) {
     for (size_t i = 0; i < num_hash_buckets_preallocated_; ++i) {
       Pointer* mem = new Pointer[bucket_count_];
@@ -80,11 +82,21 @@ class ConcurrentHashDualListReqFactory : public MemTableRepFactory {
   virtual bool IsPrefixExtractorRequired() const override { return true; }
 
  private:
+  // The buckets are indexed by the low bits of the hash
+  static size_t RoundUpBucketCount(size_t bucket_count) {
+    size_t count = 1;
+    while (count < bucket_count) {
+      count *= 2;
+    }
+    return count;
+  }
+
   const size_t bucket_count_;
   const size_t huge_page_tlb_size_;
   int bucket_entries_logging_threshold_;
   const size_t num_hash_buckets_preallocated_;
   bool if_log_bucket_dist_when_flush_;
+  bool enable_bucket_growth_;
   BucketCleaner bucket_cleaner_;
   std::list<std::unique_ptr<Pointer[]>> preallocated_buckets_;
   InstrumentedMutex mutex_;
@@ -56,7 +56,15 @@ DEFINE_string(benchmarks, "fillrandom",
               "do random\n"
               "\t                          reads\n"
               "\tseqreadwrite           -- 1 thread writes while N - 1 threads "
-              "do scans\n");
+              "do scans\n"
+              "\tfillconcurrent         -- N threads write random values "
+              "concurrently\n"
+              "\tmixedconcurrent        -- N threads mix random reads and "
+              "writes,\n"
+              "\t                          see --write_percent\n"
+              "\tflushscan              -- scan the memtablerep and decode "
+              "every\n"
+              "\t                          entry as a flush does\n");
 
 DEFINE_string(memtablerep, "skiplist",
               "Which implementation of memtablerep to use. See "
@@ -67,7 +75,12 @@ DEFINE_string(memtablerep, "skiplist",
               "\thashskiplist        -- backed by a hash skip list\n"
               "\thashlinklist        -- backed by a hash linked list\n"
               "\tcuckoo              -- backed by a cuckoo hash table\n"
-              "\tpatricia_trie       -- backed by a patricia trie\n");
+              "\tpatricia_trie       -- backed by a patricia trie\n"
+              "\tpatricia_trie_fullkey -- backed by a patricia trie indexed "
+              "by full\n"
+              "\t                         internal keys\n"
+              "\thashduallist        -- backed by a concurrent hash dual "
+              "list\n");
 
 DEFINE_int64(bucket_count, 1000000,
              "bucket_count parameter to pass into NewHashSkiplistRepFactory or "
@@ -93,6 +106,12 @@ DEFINE_bool(if_log_bucket_dist_when_flash, true,
             "if_log_bucket_dist_when_flash parameter to pass into "
             "NewHashLinkListRepFactory");
 
+DEFINE_bool(hashduallist_bucket_growth, true,
+            "enable_bucket_growth parameter to pass into "
+            "NewConcurrentHashDualListReqFactory, turn it off to compare "
+            "with\n"
+            "the fixed bucket count");
+
 DEFINE_int32(
     threshold_use_skiplist, 256,
     "threshold_use_skiplist parameter to pass into NewHashLinkListRepFactory");
@@ -114,6 +133,14 @@ DEFINE_int32(
     "Number of concurrent threads to run. If the benchmark includes writes,\n"
     "then at most one thread will be a writer");
 
+DEFINE_int32(write_percent, 50,
+             "Percentage of writes for the mixedconcurrent benchmark");
+
+DEFINE_bool(thread_scaling, false,
+            "Run the concurrent benchmarks with 1, 2, 4 ... --num_threads "
+            "threads,\n"
+            "each with a fresh memtablerep, to see how they scale");
+
 DEFINE_int32(num_operations, 1000000,
              "Number of operations to do for write and random read benchmarks");
 
@@ -208,7 +235,8 @@ class KeyGenerator {
   Random64* rand_;
   WriteMode mode_;
   const uint64_t num_;
-  uint64_t next_;
+  // atomic so that concurrent writers never get the same unique key
+  std::atomic<uint64_t> next_;
   std::vector<uint64_t> values_;
 };
 
@@ -404,6 +432,81 @@ class SeqConcurrentReadBenchmarkThread : public SeqReadBenchmarkThread {
   std::atomic_int* threads_done_;
 };
 
+// Mixes random reads and writes, every thread may write. Counters are
+// shared between threads so they are atomic, unlike the ones above.
+class MixedBenchmarkThread {
+ public:
+  MixedBenchmarkThread(MemTableRep* table, KeyGenerator* key_gen,
+                       std::atomic<uint64_t>* bytes_written,
+                       std::atomic<uint64_t>* bytes_read,
+                       std::atomic<uint64_t>* sequence, uint64_t num_ops,
+                       std::atomic<uint64_t>* read_hits, int write_percent,
+                       bool concurrent, uint64_t seed)
+      : table_(table),
+        key_gen_(key_gen),
+        bytes_written_(bytes_written),
+        bytes_read_(bytes_read),
+        sequence_(sequence),
+        num_ops_(num_ops),
+        read_hits_(read_hits),
+        write_percent_(write_percent),
+        concurrent_(concurrent),
+        seed_(seed) {}
+
+  void operator()() {
+    Random64 rand(seed_);
+    InternalKeyComparator internal_key_comp(BytewiseComparator());
+    uint64_t bytes_written = 0;
+    uint64_t bytes_read = 0;
+    uint64_t read_hits = 0;
+    std::string user_key;
+    for (uint64_t i = 0; i < num_ops_; ++i) {
+      user_key.clear();
+      if (static_cast<int>(rand.Uniform(100)) < write_percent_) {
+        PutFixed64(&user_key, key_gen_->Next());
+        InternalKey internal_key(user_key, ++*sequence_, kTypeValue);
+        Slice bytes = generator_.Generate(FLAGS_item_size);
+        if (concurrent_) {
+          table_->InsertKeyValueConcurrently(internal_key.Encode(), bytes);
+        } else {
+          table_->InsertKeyValue(internal_key.Encode(), bytes);
+        }
+        bytes_written +=
+            MemTableRep::EncodeKeyValueSize(internal_key.Encode(), bytes);
+      } else {
+        PutFixed64(&user_key, rand.Uniform(FLAGS_num_operations));
+        LookupKey lookup_key(user_key, sequence_->load());
+        CallbackVerifyArgs verify_args;
+        verify_args.found = false;
+        verify_args.key = &lookup_key;
+        verify_args.table = table_;
+        verify_args.comparator = &internal_key_comp;
+        table_->Get(lookup_key, &verify_args, ReadBenchmarkThread::callback);
+        if (verify_args.found) {
+          bytes_read += VarintLength(16) + 16 + FLAGS_item_size;
+          ++read_hits;
+        }
+      }
+    }
+    *bytes_written_ += bytes_written;
+    *bytes_read_ += bytes_read;
+    *read_hits_ += read_hits;
+  }
+
+ private:
+  MemTableRep* table_;
+  KeyGenerator* key_gen_;
+  std::atomic<uint64_t>* bytes_written_;
+  std::atomic<uint64_t>* bytes_read_;
+  std::atomic<uint64_t>* sequence_;
+  uint64_t num_ops_;
+  std::atomic<uint64_t>* read_hits_;
+  int write_percent_;
+  bool concurrent_;
+  uint64_t seed_;
+  RandomGenerator generator_;
+};
+
 class Benchmark {
  public:
   explicit Benchmark(MemTableRep* table, KeyGenerator* key_gen,
@@ -554,6 +657,94 @@ class ReadWriteBenchmark : public Benchmark {
   }
 };
 
+// N threads run MixedBenchmarkThread on one memtablerep, fillconcurrent is
+// the special case of 100% writes
+class MixedBenchmark : public Benchmark {
+ public:
+  explicit MixedBenchmark(MemTableRep* table, KeyGenerator* key_gen,
+                          uint64_t* sequence, uint32_t num_threads,
+                          int write_percent, bool concurrent)
+      : Benchmark(table, key_gen, sequence, num_threads),
+        write_percent_(write_percent),
+        concurrent_(concurrent) {
+    num_write_ops_per_thread_ = FLAGS_num_operations / num_threads;
+    num_read_ops_per_thread_ = num_write_ops_per_thread_;
+  }
+
+  void RunThreads(std::vector<port::Thread>* threads, uint64_t* bytes_written,
+                  uint64_t* bytes_read, bool /*write*/,
+                  uint64_t* read_hits) override {
+    std::atomic<uint64_t> total_written{0};
+    std::atomic<uint64_t> total_read{0};
+    std::atomic<uint64_t> total_hits{0};
+    std::atomic<uint64_t> sequence{*sequence_};
+    StopWatchNano timer(Env::Default(), true);
+    for (uint32_t i = 0; i < num_threads_; ++i) {
+      threads->emplace_back(MixedBenchmarkThread(
+          table_, key_gen_, &total_written, &total_read, &sequence,
+          num_write_ops_per_thread_, &total_hits, write_percent_, concurrent_,
+          FLAGS_seed + i));
+    }
+    for (auto& thread : *threads) {
+      thread.join();
+    }
+    *bytes_written = total_written;
+    *bytes_read = total_read;
+    *read_hits = total_hits;
+    *sequence_ = sequence;
+    auto elapsed_time = std::max<double>(1, timer.ElapsedNanos() / 1000);
+    uint64_t num_ops = num_write_ops_per_thread_ * num_threads_;
+    std::cout << "Throughput: "
+              << static_cast<uint64_t>(num_ops / (elapsed_time / 1000000))
+              << " ops/s" << std::endl;
+  }
+
+ private:
+  int write_percent_;
+  bool concurrent_;
+};
+
+// Iterate the whole memtablerep and touch every key and value, which is what
+// a flush does, unlike readseq which only walks the iterator
+class FlushScanBenchmark : public Benchmark {
+ public:
+  explicit FlushScanBenchmark(MemTableRep* table, uint64_t* sequence)
+      : Benchmark(table, nullptr, sequence, 1) {
+    num_read_ops_per_thread_ = 1;
+  }
+
+  void RunThreads(std::vector<port::Thread>* /*threads*/,
+                  uint64_t* /*bytes_written*/, uint64_t* bytes_read,
+                  bool /*write*/, uint64_t* read_hits) override {
+    std::unique_ptr<MemTableRep::Iterator> iter(table_->GetIterator());
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      Slice key = iter->key();
+      Slice value = GetLengthPrefixedSlice(iter->value());
+      *bytes_read += key.size() + value.size();
+      ++*read_hits;
+    }
+    std::cout << "Entries scanned: " << *read_hits << std::endl;
+  }
+};
+
+// Print memory used by the memtablerep (including its arena) per entry
+void PrintMemoryUsage(MemTableRep* table, Arena* arena) {
+  uint64_t num_entries = 0;
+  std::unique_ptr<MemTableRep::Iterator> iter(table->GetIterator());
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ++num_entries;
+  }
+  size_t memory_usage =
+      arena->ApproximateMemoryUsage() + table->ApproximateMemoryUsage();
+  std::cout << "Memory usage: " << memory_usage << " bytes, entries: "
+            << num_entries;
+  if (num_entries > 0) {
+    std::cout << ", bytes/entry: "
+              << static_cast<double>(memory_usage) / num_entries;
+  }
+  std::cout << std::endl;
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 void PrintWarnings() {
@@ -581,9 +772,17 @@ int main(int argc, char** argv) {
   if (FLAGS_memtablerep == "skiplist") {
     factory.reset(new TERARKDB_NAMESPACE::SkipListFactory);
 #ifndef ROCKSDB_LITE
-  } else if (FLAGS_memtablerep == "patricia_trie") {
+  } else if (FLAGS_memtablerep == "patricia_trie" ||
+             FLAGS_memtablerep == "patricia_trie_fullkey") {
 #ifdef WITH_TERARK_ZIP
-    factory.reset(TERARKDB_NAMESPACE::NewPatriciaTrieRepFactory());
+    if (FLAGS_memtablerep == "patricia_trie") {
+      factory.reset(TERARKDB_NAMESPACE::NewPatriciaTrieRepFactory());
+    } else {
+      TERARKDB_NAMESPACE::Status s;
+      factory.reset(TERARKDB_NAMESPACE::NewPatriciaTrieRepFactory(
+          {{"key_catagory", "full"}}, &s));
+      assert(s.ok());
+    }
 #else
     fprintf(stderr,
             "ERROR: NewPatriciaTrieRepFactory only works WITH_TERARK_ZIP=ON\n");
@@ -610,6 +809,14 @@ int main(int argc, char** argv) {
         static_cast<uint32_t>(FLAGS_hash_function_count)));
     options.prefix_extractor.reset(
         TERARKDB_NAMESPACE::NewFixedPrefixTransform(FLAGS_prefix_length));
+  } else if (FLAGS_memtablerep == "hashduallist") {
+    factory.reset(TERARKDB_NAMESPACE::NewConcurrentHashDualListReqFactory(
+        FLAGS_bucket_count, FLAGS_huge_page_tlb_size,
+        FLAGS_bucket_entries_logging_threshold, 0 /* preallocated */,
+        FLAGS_if_log_bucket_dist_when_flash,
+        FLAGS_hashduallist_bucket_growth));
+    options.prefix_extractor.reset(
+        TERARKDB_NAMESPACE::NewFixedPrefixTransform(FLAGS_prefix_length));
 #endif  // ROCKSDB_LITE
   } else {
     fprintf(stdout, "Unknown memtablerep: %s\n", FLAGS_memtablerep.c_str());
@@ -619,17 +826,21 @@ int main(int argc, char** argv) {
   TERARKDB_NAMESPACE::InternalKeyComparator internal_key_comp(
       TERARKDB_NAMESPACE::BytewiseComparator());
   TERARKDB_NAMESPACE::MemTable::KeyComparator key_comp(internal_key_comp);
-  TERARKDB_NAMESPACE::Arena arena;
   TERARKDB_NAMESPACE::WriteBufferManager wb(FLAGS_write_buffer_size);
   uint64_t sequence;
   const bool needs_dup_key_check = false;
+  std::unique_ptr<TERARKDB_NAMESPACE::MemTableRep> memtablerep;
+  // every memtablerep gets its own arena so its memory usage can be reported
+  std::unique_ptr<TERARKDB_NAMESPACE::Arena> arena;
   auto createMemtableRep = [&] {
     sequence = 0;
-    return factory->CreateMemTableRep(key_comp, needs_dup_key_check, &arena,
+    memtablerep.reset();
+    arena.reset(new TERARKDB_NAMESPACE::Arena());
+    return factory->CreateMemTableRep(key_comp, needs_dup_key_check,
+                                      arena.get(),
                                       options.prefix_extractor.get(),
                                       options.info_log.get());
   };
-  std::unique_ptr<TERARKDB_NAMESPACE::MemTableRep> memtablerep;
   TERARKDB_NAMESPACE::Random64 rng(FLAGS_seed);
   const char* benchmarks = FLAGS_benchmarks.c_str();
   while (benchmarks != nullptr) {
@@ -644,7 +855,39 @@ int main(int argc, char** argv) {
       benchmarks = sep + 1;
     }
     std::unique_ptr<TERARKDB_NAMESPACE::Benchmark> benchmark;
-    if (name == TERARKDB_NAMESPACE::Slice("fillseq")) {
+    bool print_memory_usage = true;
+    if (name == TERARKDB_NAMESPACE::Slice("fillconcurrent") ||
+        name == TERARKDB_NAMESPACE::Slice("mixedconcurrent")) {
+      bool fill = name == TERARKDB_NAMESPACE::Slice("fillconcurrent");
+      bool concurrent = factory->IsInsertConcurrentlySupported();
+      uint32_t max_threads = concurrent ? FLAGS_num_threads : 1;
+      if (max_threads < static_cast<uint32_t>(FLAGS_num_threads)) {
+        std::cout << "WARNING: " << FLAGS_memtablerep
+                  << " does not support concurrent insert, use 1 thread"
+                  << std::endl;
+      }
+      std::vector<uint32_t> thread_counts;
+      if (FLAGS_thread_scaling) {
+        for (uint32_t n = 1; n < max_threads; n *= 2) {
+          thread_counts.push_back(n);
+        }
+      }
+      thread_counts.push_back(max_threads);
+      std::cout << "Running " << name.ToString() << std::endl;
+      // a fresh memtablerep for each thread count, reads of mixedconcurrent
+      // hit the keys written so far
+      for (uint32_t n : thread_counts) {
+        memtablerep.reset(createMemtableRep());
+        key_gen.reset(new TERARKDB_NAMESPACE::KeyGenerator(
+            &rng, TERARKDB_NAMESPACE::UNIQUE_RANDOM, FLAGS_num_operations));
+        TERARKDB_NAMESPACE::MixedBenchmark(
+            memtablerep.get(), key_gen.get(), &sequence, n,
+            fill ? 100 : FLAGS_write_percent, concurrent)
+            .Run();
+        TERARKDB_NAMESPACE::PrintMemoryUsage(memtablerep.get(), arena.get());
+      }
+      continue;
+    } else if (name == TERARKDB_NAMESPACE::Slice("fillseq")) {
       memtablerep.reset(createMemtableRep());
       key_gen.reset(new TERARKDB_NAMESPACE::KeyGenerator(
           &rng, TERARKDB_NAMESPACE::SEQUENTIAL, FLAGS_num_operations));
@@ -661,11 +904,17 @@ int main(int argc, char** argv) {
           &rng, TERARKDB_NAMESPACE::RANDOM, FLAGS_num_operations));
       benchmark.reset(new TERARKDB_NAMESPACE::ReadBenchmark(
           memtablerep.get(), key_gen.get(), &sequence));
+      print_memory_usage = false;
     } else if (name == TERARKDB_NAMESPACE::Slice("readseq")) {
       key_gen.reset(new TERARKDB_NAMESPACE::KeyGenerator(
           &rng, TERARKDB_NAMESPACE::SEQUENTIAL, FLAGS_num_operations));
       benchmark.reset(new TERARKDB_NAMESPACE::SeqReadBenchmark(
           memtablerep.get(), &sequence));
+      print_memory_usage = false;
+    } else if (name == TERARKDB_NAMESPACE::Slice("flushscan")) {
+      benchmark.reset(new TERARKDB_NAMESPACE::FlushScanBenchmark(
+          memtablerep.get(), &sequence));
+      print_memory_usage = false;
     } else if (name == TERARKDB_NAMESPACE::Slice("readwrite")) {
       memtablerep.reset(createMemtableRep());
       key_gen.reset(new TERARKDB_NAMESPACE::KeyGenerator(
@@ -687,6 +936,9 @@ int main(int argc, char** argv) {
     }
     std::cout << "Running " << name.ToString() << std::endl;
     benchmark->Run();
+    if (print_memory_usage) {
+      TERARKDB_NAMESPACE::PrintMemoryUsage(memtablerep.get(), arena.get());
+    }
   }
 
   return 0;
@@ -1,6 +1,10 @@
 #include "terark_zip_memtable.h"
 
+#include <thread>
+
+#include "monitoring/perf_context_imp.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/string_util.h"
 
 #if defined(_MSC_VER)
 //#include <windows.h>
@@ -86,20 +90,45 @@ PatriciaTrieRep::PatriciaTrieRep(details::ConcurrentType concurrent_type,
                                  details::PatriciaKeyType patricia_key_type,
                                  bool handle_duplicate,
                                  intptr_t write_buffer_size,
-                                 Allocator* allocator)
+                                 Allocator* allocator, size_t shard_count)
     : MemTableRep(allocator) {
   immutable_ = false;
   patricia_key_type_ = patricia_key_type;
   handle_duplicate_ = handle_duplicate;
   write_buffer_size_ = write_buffer_size;
-  if (concurrent_type == details::ConcurrentType::Native)
+  if (concurrent_type == details::ConcurrentType::Native) {
     concurrent_level_ = terark::Patricia::MultiWriteMultiRead;
-  else
+    shard_count_ = std::max<size_t>(
+        1, std::min<size_t>(shard_count, details::kMaxShardCount));
+  } else {
+    // single writer never contends, sharding is useless
     concurrent_level_ = terark::Patricia::OneWriteMultiRead;
-  trie_vec_[0] =
-      new MainPatricia(sizeof(uint32_t), write_buffer_size_, concurrent_level_);
-  trie_vec_size_ = 1;
-  overhead_ = trie_vec_[0]->mem_size_inline();
+    shard_count_ = 1;
+  }
+  // shards split the write buffer, later tries grow as usual
+  intptr_t shard_buffer_size = write_buffer_size_;
+  if (shard_buffer_size > 0) {
+    shard_buffer_size =
+        std::max<intptr_t>(shard_buffer_size / shard_count_, 1 << 20);
+  }
+  overhead_ = 0;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    trie_vec_[i] = new MainPatricia(sizeof(uint32_t), shard_buffer_size,
+                                    concurrent_level_);
+    shard_trie_[i].store(i, std::memory_order_relaxed);
+    overhead_ += trie_vec_[i]->mem_size_inline();
+  }
+  trie_vec_size_ = shard_count_;
+}
+
+void PatriciaTrieRep::EnableBloom(uint32_t total_bits, uint32_t locality,
+                                  size_t huge_page_size, Logger* logger) {
+  assert(bloom_ == nullptr);
+  if (total_bits > 0) {
+    bloom_.reset(new DynamicBloom(allocator_, total_bits, locality,
+                                  6 /* hard coded 6 probes */, nullptr,
+                                  huge_page_size, logger));
+  }
 }
 
 PatriciaTrieRep::~PatriciaTrieRep() {
@@ -158,6 +187,9 @@ size_t PatriciaTrieRep::ApproximateMemoryUsage() {
 bool PatriciaTrieRep::Contains(const Slice& internal_key) const {
   terark::fstring find_key(internal_key.data(), internal_key.size() - 8);
   uint64_t tag = ExtractInternalKeyFooter(internal_key);
+  if (bloom_ && !bloom_->MayContain(Slice(find_key.data(), find_key.size()))) {
+    return false;
+  }
   for (size_t i = 0; i < trie_vec_size_; ++i) {
     auto* trie = trie_vec_[i];
     auto token = trie->tls_reader_token();
@@ -204,6 +236,14 @@ void PatriciaTrieRep::Get(const LookupKey& k, void* callback_args,
   auto find_key = terark::fstring(internal_key.data(), internal_key.size() - 8);
   auto tag = ExtractInternalKeyFooter(internal_key);
 
+  if (bloom_) {
+    if (!bloom_->MayContain(Slice(find_key.data(), find_key.size()))) {
+      PERF_COUNTER_ADD(bloom_memtable_miss_count, 1);
+      return;
+    }
+    PERF_COUNTER_ADD(bloom_memtable_hit_count, 1);
+  }
+
   auto do_callback = [&](HeapItem* heap) -> bool {
     build_key(find_key, heap->tag, buffer);
     auto trie = heap->trie();
@@ -378,7 +418,8 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
       return details::InsertResult::Fail;
   };
 
-  auto fn_create_new_trie = [&]() {
+  auto fn_create_new_trie = [&](size_t shard) {
+    TERARK_VERIFY(trie_vec_size_ < trie_vec_.size());
     if (write_buffer_size_ > 0) {
       if (write_buffer_size_ < size_limit_) write_buffer_size_ *= 2;
       if (write_buffer_size_ > size_limit_) write_buffer_size_ = size_limit_;
@@ -388,6 +429,7 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
     }
     trie_vec_[trie_vec_size_] = new MainPatricia(
         sizeof(uint32_t), write_buffer_size_, concurrent_level_);
+    shard_trie_[shard].store(trie_vec_size_, std::memory_order_release);
     trie_vec_size_++;
   };
   // tool lambda fn end
@@ -410,10 +452,20 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
       }
     }
   }
+  if (bloom_) {
+    // Add before the key becomes visible, so a reader never misses it
+    Slice user_key(key.data(), key.size());
+    if (concurrent_level_ == terark::Patricia::MultiWriteMultiRead) {
+      bloom_->AddConcurrently(user_key);
+    } else {
+      bloom_->Add(user_key);
+    }
+  }
   details::InsertResult insert_result = details::InsertResult::Fail;
+  size_t shard = CurrentShard();
   for (;;) {
-    size_t curr_trie_vec_size = trie_vec_size_;
-    insert_result = fn_insert_impl(trie_vec_[curr_trie_vec_size - 1]);
+    size_t curr_trie = shard_trie_[shard].load(std::memory_order_acquire);
+    insert_result = fn_insert_impl(trie_vec_[curr_trie]);
     if (insert_result == details::InsertResult::Duplicated) {
       return !handle_duplicate_;
     }
@@ -422,8 +474,8 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
     } else {
       assert(insert_result == details::InsertResult::Fail);
       std::unique_lock<std::mutex> lock(mutex_);
-      if (curr_trie_vec_size == trie_vec_size_) {
-        fn_create_new_trie();
+      if (curr_trie == shard_trie_[shard].load(std::memory_order_relaxed)) {
+        fn_create_new_trie(shard);
       }
     }
   }
@@ -431,6 +483,21 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
   return true;
 }
 
+size_t PatriciaTrieRep::CurrentShard() const {
+  if (shard_count_ == 1) {
+    return 0;
+  }
+  // writers on one core rarely run simultaneously, so core id keeps the
+  // writers of a shard (and their cached tls tokens) mostly uncontended
+  int cpuid = port::PhysicalCoreID();
+  if (cpuid < 0) {
+    static thread_local size_t tls_shard =
+        std::hash<std::thread::id>()(std::this_thread::get_id());
+    return tls_shard % shard_count_;
+  }
+  return size_t(cpuid) % shard_count_;
+}
+
 template <bool heap_mode>
 typename PatriciaRepIterator<heap_mode>::HeapItem::VectorData
 PatriciaRepIterator<heap_mode>::HeapItem::GetVector() {
@@ -817,7 +884,7 @@ MemTableRep* PatriciaTrieRepFactory::CreateMemTableRep(
   if (IsForwardBytewiseComparator(key_cmp.icomparator()->user_comparator())) {
     return new PatriciaTrieRep(concurrent_type_, patricia_key_type_,
                                needs_dup_key_check, write_buffer_size_,
-                               allocator);
+                               allocator, shard_count_);
   } else {
     return fallback_->CreateMemTableRep(key_cmp, needs_dup_key_check, allocator,
                                         transform, logger);
@@ -829,9 +896,19 @@ MemTableRep* PatriciaTrieRepFactory::CreateMemTableRep(
     Allocator* allocator, const ImmutableCFOptions& ioptions,
     const MutableCFOptions& mutable_cf_options, uint32_t column_family_id) {
   if (IsForwardBytewiseComparator(key_cmp.icomparator()->user_comparator())) {
-    return new PatriciaTrieRep(concurrent_type_, patricia_key_type_,
-                               needs_dup_key_check, write_buffer_size_,
-                               allocator);
+    auto rep = new PatriciaTrieRep(concurrent_type_, patricia_key_type_,
+                                   needs_dup_key_check, write_buffer_size_,
+                                   allocator, shard_count_);
+    if (whole_key_bloom_ratio_ > 0) {
+      rep->EnableBloom(
+          static_cast<uint32_t>(
+              static_cast<double>(mutable_cf_options.write_buffer_size) *
+              whole_key_bloom_ratio_) *
+              8u,
+          ioptions.bloom_locality, mutable_cf_options.memtable_huge_page_size,
+          ioptions.info_log);
+    }
+    return rep;
   } else {
     return fallback_->CreateMemTableRep(key_cmp, needs_dup_key_check, allocator,
                                         ioptions, mutable_cf_options,
@@ -842,10 +919,12 @@ MemTableRep* PatriciaTrieRepFactory::CreateMemTableRep(
 static MemTableRepFactory* CreatePatriciaTrieRepFactory(
     std::shared_ptr<class MemTableRepFactory>& fallback,
     details::ConcurrentType concurrent_type,
-    details::PatriciaKeyType patricia_key_type, int64_t write_buffer_size) {
+    details::PatriciaKeyType patricia_key_type, int64_t write_buffer_size,
+    size_t shard_count = 1, double whole_key_bloom_ratio = 0) {
   if (!fallback) fallback.reset(new SkipListFactory());
   return new PatriciaTrieRepFactory(fallback, concurrent_type,
-                                    patricia_key_type, write_buffer_size);
+                                    patricia_key_type, write_buffer_size,
+                                    shard_count, whole_key_bloom_ratio);
 }
 
 MemTableRepFactory* NewPatriciaTrieRepFactory(
@@ -891,8 +970,38 @@ MemTableRepFactory* NewPatriciaTrieRepFactory(
     patricia_key_type = details::PatriciaKeyType::FullKey;
   }
 
+  size_t shard_count = 1;
+  auto n = options.find("shard_count");
+  if (n != options.end()) {
+    if (n->second == "auto") {
+      shard_count = std::thread::hardware_concurrency();
+    } else {
+      try {
+        shard_count = ParseSizeT(n->second);
+      } catch (const std::exception&) {
+        *s = Status::InvalidArgument("NewPatriciaTrieRepFactory",
+                                     "invalid shard_count: " + n->second);
+        return nullptr;
+      }
+    }
+  }
+
+  double whole_key_bloom_ratio = 0;
+  auto b = options.find("whole_key_bloom_ratio");
+  if (b != options.end()) {
+    try {
+      whole_key_bloom_ratio = ParseDouble(b->second);
+    } catch (const std::exception&) {
+      *s = Status::InvalidArgument("NewPatriciaTrieRepFactory",
+                                   "invalid whole_key_bloom_ratio: " +
+                                       b->second);
+      return nullptr;
+    }
+  }
+
   return CreatePatriciaTrieRepFactory(fallback, concurrent_type,
-                                      patricia_key_type, write_buffer_size);
+                                      patricia_key_type, write_buffer_size,
+                                      shard_count, whole_key_bloom_ratio);
 }
 
 }  // namespace TERARKDB_NAMESPACE
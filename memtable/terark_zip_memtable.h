@@ -23,6 +23,7 @@
 #include "terark/io/byte_swap.hpp"
 #include "terark/thread/instance_tls_owner.hpp"
 #include "util/arena.h"
+#include "util/dynamic_bloom.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -45,7 +46,10 @@ class MemWriterToken : public terark::Patricia::WriterToken {
 
 namespace terark_memtable_details {
 
-typedef std::array<terark::MainPatricia*, 32> tries_t;
+typedef std::array<terark::MainPatricia*, 128> tries_t;
+
+// Max number of write shards, each shard owns its own chain of tries
+static const size_t kMaxShardCount = 32;
 
 enum class ConcurrentType { Native, None };
 
@@ -76,17 +80,29 @@ class PatriciaTrieRep : public MemTableRep {
   std::atomic_bool immutable_;
   terark_memtable_details::tries_t trie_vec_;
   size_t trie_vec_size_;
+  // Writers are spread over shards by core id, every shard appends to the
+  // trie at shard_trie_[shard] so the tries are not contended by all cores
+  size_t shard_count_;
+  std::array<std::atomic<size_t>, terark_memtable_details::kMaxShardCount>
+      shard_trie_;
   size_t overhead_;  // this overhead is for new memtable size check
   int64_t write_buffer_size_;
   static const int64_t size_limit_ = 1LL << 30;
   std::mutex mutex_;
+  // Optional bloom on user keys, lets Get and Contains skip the tries
+  std::unique_ptr<DynamicBloom> bloom_;
 
  public:
   // Create a new patricia trie memtable rep with following options
   PatriciaTrieRep(terark_memtable_details::ConcurrentType concurrent_type,
                   terark_memtable_details::PatriciaKeyType patricia_key_type,
                   bool handle_duplicate, intptr_t write_buffer_size,
-                  Allocator* allocator);
+                  Allocator* allocator, size_t shard_count = 1);
+
+  // Enable the whole key bloom with `total_bits` bits allocated from the
+  // allocator of this rep. Must be called before the first insert.
+  void EnableBloom(uint32_t total_bits, uint32_t locality,
+                   size_t huge_page_size, Logger* logger);
 
   ~PatriciaTrieRep();
 
@@ -125,6 +141,10 @@ class PatriciaTrieRep : public MemTableRep {
   }
 
   virtual void MarkReadOnly() override;
+
+ private:
+  // Return the shard of current thread
+  size_t CurrentShard() const;
 };
 
 // Heap iterator for traversing multi tries simultaneously.
@@ -267,6 +287,10 @@ class PatriciaTrieRepFactory : public MemTableRepFactory {
   terark_memtable_details::ConcurrentType concurrent_type_;
   terark_memtable_details::PatriciaKeyType patricia_key_type_;
   int64_t write_buffer_size_;
+  size_t shard_count_;
+  // Size of the whole key bloom as a fraction of write_buffer_size, 0 means
+  // no bloom
+  double whole_key_bloom_ratio_;
 
  public:
   PatriciaTrieRepFactory(
@@ -275,11 +299,17 @@ class PatriciaTrieRepFactory : public MemTableRepFactory {
           terark_memtable_details::ConcurrentType::Native,
       terark_memtable_details::PatriciaKeyType patricia_key_type =
           terark_memtable_details::PatriciaKeyType::UserKey,
-      int64_t write_buffer_size = 512LL * 1048576)
+      int64_t write_buffer_size = 512LL * 1048576, size_t shard_count = 1,
+      double whole_key_bloom_ratio = 0)
       : fallback_(fallback),
         concurrent_type_(concurrent_type),
         patricia_key_type_(patricia_key_type),
-        write_buffer_size_(write_buffer_size) {}
+        write_buffer_size_(write_buffer_size),
+        shard_count_(std::max<size_t>(
+            1,
+            std::min(shard_count, terark_memtable_details::kMaxShardCount))),
+        whole_key_bloom_ratio_(
+            std::max(0.0, std::min(whole_key_bloom_ratio, 0.25))) {}
 
   virtual ~PatriciaTrieRepFactory() {}
 
@@ -11,8 +11,12 @@
 #include <string>
 
 #include "db/dbformat.h"
+#include "db/merge_context.h"
 #include "gtest/gtest.h"
+#include "rocksdb/perf_context.h"
 #include "rocksdb/terark_namespace.h"
+#include "table/scoped_arena_iterator.h"
+#include "util/testharness.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -209,6 +213,109 @@ TEST_F(TerarkZipMemtableTest, MultiThreadingTest) {
          dur, total_size);
   delete mem_;
 }
+
+// Test insertion into core sharded tries, every record must be visible
+// through the merging iterator in order
+TEST_F(TerarkZipMemtableTest, ShardedMultiThreadingTest) {
+  Options options;
+  options.allow_concurrent_memtable_write = true;
+  Status s;
+  options.memtable_factory.reset(
+      NewPatriciaTrieRepFactory({{"shard_count", "8"}}, &s));
+  ASSERT_OK(s);
+
+  InternalKeyComparator cmp(BytewiseComparator());
+  ImmutableCFOptions ioptions(options);
+  WriteBufferManager wb(options.db_write_buffer_size);
+  std::unique_ptr<MemTable> mem(new MemTable(cmp, ioptions,
+                                             MutableCFOptions(options), true,
+                                             &wb, kMaxSequenceNumber, 0));
+
+  size_t records = 1 << 16;
+  int thread_cnt = 16;
+  std::vector<std::thread> threads;
+  std::vector<MemTablePostProcessInfo> infos(thread_cnt);
+  std::atomic<SequenceNumber> atomic_seq{0};
+  for (int t = 0; t < thread_cnt; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = t; i < records; i += thread_cnt) {
+        char key[32];
+        snprintf(key, sizeof(key), "key %08zd", i);
+        auto ret = mem->Add(atomic_seq++, kTypeValue, key,
+                            "value " + std::to_string(i), true, &infos[t]);
+        ASSERT_TRUE(ret);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  Arena arena;
+  ReadOptions ro;
+  ScopedArenaIterator iter(mem->NewIterator(ro, &arena));
+  size_t count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    char key[32];
+    snprintf(key, sizeof(key), "key %08zd", count);
+    ASSERT_EQ(ExtractUserKey(iter->key()).ToString(), key);
+    ++count;
+  }
+  ASSERT_EQ(count, records);
+
+  NewPatriciaTrieRepFactory({{"shard_count", "x"}}, &s);
+  ASSERT_TRUE(s.IsInvalidArgument());
+}
+
+TEST_F(TerarkZipMemtableTest, WholeKeyBloomTest) {
+  Options options;
+  Status s;
+  options.memtable_factory.reset(
+      NewPatriciaTrieRepFactory({{"whole_key_bloom_ratio", "0.1"}}, &s));
+  ASSERT_OK(s);
+
+  InternalKeyComparator cmp(BytewiseComparator());
+  ImmutableCFOptions ioptions(options);
+  WriteBufferManager wb(options.db_write_buffer_size);
+  std::unique_ptr<MemTable> mem(new MemTable(cmp, ioptions,
+                                             MutableCFOptions(options), true,
+                                             &wb, kMaxSequenceNumber, 0));
+
+  size_t records = 1 << 12;
+  for (size_t i = 0; i < records; ++i) {
+    char key[32];
+    snprintf(key, sizeof(key), "key %08zd", i * 2);
+    ASSERT_TRUE(mem->Add(i, kTypeValue, key, "value " + std::to_string(i)));
+  }
+
+  SetPerfLevel(kEnableCount);
+  get_perf_context()->Reset();
+  for (size_t i = 0; i < records * 2; ++i) {
+    char key[32];
+    snprintf(key, sizeof(key), "key %08zd", i);
+    LazyBuffer value;
+    MergeContext merge_context;
+    SequenceNumber max_covering_tombstone_seq = 0;
+    s = Status::OK();
+    bool found = mem->Get(LookupKey(key, kMaxSequenceNumber), &value, &s,
+                          &merge_context, &max_covering_tombstone_seq,
+                          ReadOptions());
+    ASSERT_EQ(i % 2 == 0, found);
+    if (found) {
+      ASSERT_OK(s);
+      ASSERT_OK(value.fetch());
+      ASSERT_EQ("value " + std::to_string(i / 2), value.slice().ToString());
+    }
+  }
+  // Every present key passes the bloom, most absent ones are filtered
+  ASSERT_GE(get_perf_context()->bloom_memtable_hit_count, records);
+  ASSERT_GT(get_perf_context()->bloom_memtable_miss_count, records / 2);
+  SetPerfLevel(kDisable);
+
+  NewPatriciaTrieRepFactory({{"whole_key_bloom_ratio", "x"}}, &s);
+  ASSERT_TRUE(s.IsInvalidArgument());
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -9,9 +9,13 @@
 
 #include "rocksdb/write_buffer_manager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <mutex>
+#include <vector>
 
 #include "rocksdb/terark_namespace.h"
+#include "util/arena_block_pool.h"
 #include "util/coding.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -51,8 +55,37 @@ struct WriteBufferManager::CacheRep {
 struct WriteBufferManager::CacheRep {};
 #endif  // ROCKSDB_LITE
 
+namespace {
+// Quotas are recomputed at most once per period.
+const uint64_t kQuotaUpdatePeriodNanos = 100 * 1000 * 1000;
+
+uint64_t SteadyNowNanos() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+}  // namespace
+
+struct WriteBufferManager::Client {
+  // Bytes written since the last quota update
+  std::atomic<size_t> ingest_bytes{0};
+  // Exponential moving average of ingest_bytes per update period.
+  // Protected by FairShareRep::mutex_
+  size_t ingest_rate = 0;
+  std::atomic<size_t> quota{0};
+};
+
+struct WriteBufferManager::FairShareRep {
+  std::mutex mutex_;
+  std::vector<Client*> clients_;
+  std::atomic<uint64_t> last_update_nanos_{0};
+};
+
 WriteBufferManager::WriteBufferManager(size_t _buffer_size,
-                                       std::shared_ptr<Cache> cache)
+                                       std::shared_ptr<Cache> cache,
+                                       bool fair_share,
+                                       size_t arena_block_pool_size)
     : buffer_size_(_buffer_size),
       mutable_limit_(buffer_size_ * 7 / 8),
       memory_used_(0),
@@ -66,9 +99,16 @@ WriteBufferManager::WriteBufferManager(size_t _buffer_size,
 #else
   (void)cache;
 #endif  // ROCKSDB_LITE
+  if (fair_share && enabled()) {
+    fair_share_rep_.reset(new FairShareRep);
+  }
+  if (arena_block_pool_size > 0) {
+    arena_block_pool_.reset(new ArenaBlockPool(arena_block_pool_size, this));
+  }
 }
 
 WriteBufferManager::~WriteBufferManager() {
+  assert(fair_share_rep_ == nullptr || fair_share_rep_->clients_.empty());
 #ifndef ROCKSDB_LITE
   if (cache_rep_) {
     for (auto* handle : cache_rep_->dummy_handles_) {
@@ -130,4 +170,104 @@ void WriteBufferManager::FreeMemWithCache(size_t mem) {
   (void)mem;
 #endif  // ROCKSDB_LITE
 }
+
+WriteBufferManager::Client* WriteBufferManager::RegisterClient() {
+  if (fair_share_rep_ == nullptr) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(fair_share_rep_->mutex_);
+  Client* client = new Client;
+  fair_share_rep_->clients_.push_back(client);
+  UpdateClientQuotas(true /* force */);
+  return client;
+}
+
+void WriteBufferManager::UnregisterClient(Client* client) {
+  if (client == nullptr) {
+    return;
+  }
+  assert(fair_share_rep_ != nullptr);
+  std::lock_guard<std::mutex> lock(fair_share_rep_->mutex_);
+  auto& clients = fair_share_rep_->clients_;
+  auto it = std::find(clients.begin(), clients.end(), client);
+  assert(it != clients.end());
+  clients.erase(it);
+  delete client;
+  UpdateClientQuotas(true /* force */);
+}
+
+void WriteBufferManager::RecordIngest(Client* client, size_t bytes) {
+  if (client != nullptr) {
+    client->ingest_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+size_t WriteBufferManager::ClientQuota(const Client* client) const {
+  if (client == nullptr) {
+    return buffer_size_;
+  }
+  return client->quota.load(std::memory_order_relaxed);
+}
+
+bool WriteBufferManager::ShouldFlush(Client* client,
+                                     size_t client_memory_usage) {
+  if (!ShouldFlush()) {
+    return false;
+  }
+  if (client == nullptr) {
+    return true;
+  }
+  if (mutable_memtable_memory_usage() >= buffer_size_) {
+    // Way over the limit, whoever writes has to give memory back
+    return true;
+  }
+  uint64_t now = SteadyNowNanos();
+  if (now - fair_share_rep_->last_update_nanos_.load(
+                std::memory_order_relaxed) >= kQuotaUpdatePeriodNanos) {
+    std::lock_guard<std::mutex> lock(fair_share_rep_->mutex_);
+    UpdateClientQuotas(false /* force */);
+  }
+  // Mirror mutable_limit_, the quotas add up to buffer_size_
+  return client_memory_usage > ClientQuota(client) / 8 * 7;
+}
+
+void WriteBufferManager::UpdateClientQuotas(bool force) {
+  uint64_t now = SteadyNowNanos();
+  auto& last_update = fair_share_rep_->last_update_nanos_;
+  if (!force &&
+      now - last_update.load(std::memory_order_relaxed) <
+          kQuotaUpdatePeriodNanos) {
+    // Somebody else updated while we waited for the mutex
+    return;
+  }
+  last_update.store(now, std::memory_order_relaxed);
+
+  auto& clients = fair_share_rep_->clients_;
+  if (clients.empty()) {
+    return;
+  }
+  size_t total_rate = 0;
+  for (auto* client : clients) {
+    size_t ingest = client->ingest_bytes.exchange(0, std::memory_order_relaxed);
+    client->ingest_rate = client->ingest_rate - client->ingest_rate / 4 +
+                          ingest / 4;
+    total_rate += client->ingest_rate;
+  }
+  // Every client keeps a floor of a quarter of an even split, so an idle DB
+  // can still take writes without flushing on every one of them. The rest is
+  // shared by ingest rate.
+  size_t floor = buffer_size_ / 4 / clients.size();
+  size_t shared = buffer_size_ - floor * clients.size();
+  for (auto* client : clients) {
+    size_t quota = floor;
+    if (total_rate == 0) {
+      quota += shared / clients.size();
+    } else {
+      quota += static_cast<size_t>(static_cast<double>(shared) *
+                                   client->ingest_rate / total_rate);
+    }
+    client->quota.store(quota, std::memory_order_relaxed);
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
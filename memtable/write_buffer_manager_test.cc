@@ -9,6 +9,7 @@
 
 #include "rocksdb/write_buffer_manager.h"
 
+#include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/testharness.h"
 
@@ -144,6 +145,47 @@ TEST_F(WriteBufferManagerTest, NoCapCacheCost) {
   ASSERT_GE(cache->GetPinnedUsage(), 1024 * 1024);
   ASSERT_LT(cache->GetPinnedUsage(), 1024 * 1024 + 10000);
 }
+
+TEST_F(WriteBufferManagerTest, FairShare) {
+  const size_t kMB = 1024 * 1024;
+  std::unique_ptr<WriteBufferManager> plain(new WriteBufferManager(10 * kMB));
+  ASSERT_EQ(nullptr, plain->RegisterClient());
+
+  std::unique_ptr<WriteBufferManager> wbf(
+      new WriteBufferManager(10 * kMB, {}, true /* fair_share */));
+  ASSERT_TRUE(wbf->fair_share());
+  auto* hot = wbf->RegisterClient();
+  auto* cold = wbf->RegisterClient();
+  ASSERT_NE(nullptr, hot);
+  ASSERT_NE(nullptr, cold);
+  // Without ingest the buffer is split evenly
+  ASSERT_EQ(5 * kMB, wbf->ClientQuota(hot));
+  ASSERT_EQ(5 * kMB, wbf->ClientQuota(cold));
+
+  wbf->ReserveMem(9 * kMB);
+  ASSERT_TRUE(wbf->ShouldFlush());
+  // Only the DB over its share flushes
+  ASSERT_FALSE(wbf->ShouldFlush(hot, 1 * kMB));
+  ASSERT_TRUE(wbf->ShouldFlush(cold, 8 * kMB));
+
+  wbf->RecordIngest(hot, 100 * kMB);
+  Env::Default()->SleepForMicroseconds(200 * 1000);
+  ASSERT_FALSE(wbf->ShouldFlush(hot, 1 * kMB));
+  ASSERT_GT(wbf->ClientQuota(hot), wbf->ClientQuota(cold));
+  ASSERT_LE(wbf->ClientQuota(hot) + wbf->ClientQuota(cold), 10 * kMB);
+  // The idle DB keeps a floor of its even split
+  ASSERT_GE(wbf->ClientQuota(cold), 10 * kMB / 4 / 2);
+  ASSERT_TRUE(wbf->ShouldFlush(cold, 2 * kMB));
+  ASSERT_FALSE(wbf->ShouldFlush(hot, 6 * kMB));
+
+  // Below the global limit nobody flushes
+  wbf->ScheduleFreeMem(4 * kMB);
+  ASSERT_FALSE(wbf->ShouldFlush(cold, 2 * kMB));
+
+  wbf->UnregisterClient(cold);
+  ASSERT_EQ(10 * kMB, wbf->ClientQuota(hot));
+  wbf->UnregisterClient(hot);
+}
 #endif  // ROCKSDB_LITE
 }  // namespace TERARKDB_NAMESPACE
 
@@ -0,0 +1,156 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "monitoring/hot_key_tracker.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "rocksdb/listener.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace TERARKDB_NAMESPACE {
+
+HeavyHitterTracker::HeavyHitterTracker(uint32_t sample_rate, size_t top_k)
+    : sample_rate_(static_cast<int>(std::min<uint32_t>(
+          std::max<uint32_t>(sample_rate, 1),
+          std::numeric_limits<int>::max()))),
+      top_k_(top_k),
+      sketch_(kDepth * kWidth, 0),
+      total_(0) {}
+
+void HeavyHitterTracker::RecordSampled(const Slice& item) {
+  size_t slots[kDepth];
+  for (size_t i = 0; i < kDepth; ++i) {
+    slots[i] = i * kWidth +
+               Hash(item.data(), item.size(), static_cast<uint32_t>(i) * 1021 +
+                                                  0x9e3779b9) %
+                   kWidth;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++total_;
+  uint32_t estimate = std::numeric_limits<uint32_t>::max();
+  for (size_t slot : slots) {
+    estimate = std::min(estimate, sketch_[slot]);
+  }
+  if (estimate == std::numeric_limits<uint32_t>::max()) {
+    return;
+  }
+  ++estimate;
+  // Conservative update, only the counters below the new estimate grow, so
+  // the collisions of the other rows overestimate less
+  for (size_t slot : slots) {
+    sketch_[slot] = std::max(sketch_[slot], estimate);
+  }
+  if (top_k_ == 0) {
+    return;
+  }
+  std::string key = item.ToString();
+  auto it = top_.find(key);
+  if (it != top_.end()) {
+    it->second = estimate;
+    return;
+  }
+  if (top_.size() < top_k_) {
+    top_.emplace(std::move(key), estimate);
+    return;
+  }
+  auto min_it = std::min_element(
+      top_.begin(), top_.end(),
+      [](const std::pair<const std::string, uint32_t>& a,
+         const std::pair<const std::string, uint32_t>& b) {
+        return a.second < b.second;
+      });
+  if (min_it->second < estimate) {
+    top_.erase(min_it);
+    top_.emplace(std::move(key), estimate);
+  }
+}
+
+void HeavyHitterTracker::GetTopK(
+    std::vector<std::pair<std::string, uint64_t>>* items,
+    uint64_t* total) const {
+  items->clear();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    items->reserve(top_.size());
+    for (auto& pair : top_) {
+      items->emplace_back(pair.first,
+                          static_cast<uint64_t>(pair.second) * sample_rate_);
+    }
+    *total = total_ * sample_rate_;
+  }
+  std::sort(items->begin(), items->end(),
+            [](const std::pair<std::string, uint64_t>& a,
+               const std::pair<std::string, uint64_t>& b) {
+              return a.second > b.second ||
+                     (a.second == b.second && a.first < b.first);
+            });
+}
+
+void HeavyHitterTracker::Decay() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& counter : sketch_) {
+    counter >>= 1;
+  }
+  for (auto it = top_.begin(); it != top_.end();) {
+    it->second >>= 1;
+    if (it->second == 0) {
+      it = top_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  total_ >>= 1;
+}
+
+void HotKeyTracker::RecordKeySampled(uint32_t cf_id, const Slice& key) {
+  std::string item;
+  item.reserve(5 + key.size());
+  PutVarint32(&item, cf_id);
+  item.append(key.data(), key.size());
+  keys_.RecordSampled(item);
+}
+
+void HotKeyTracker::RecordBlockSampled(uint64_t file_number,
+                                       uint64_t offset) {
+  char item[16];
+  EncodeFixed64(item, file_number);
+  EncodeFixed64(item + 8, offset);
+  blocks_.RecordSampled(Slice(item, sizeof(item)));
+}
+
+void HotKeyTracker::GetHotKeys(HotKeysInfo* info) const {
+  std::vector<std::pair<std::string, uint64_t>> items;
+  keys_.GetTopK(&items, &info->total_keys);
+  info->keys.clear();
+  for (auto& pair : items) {
+    Slice item(pair.first);
+    HotKeyInfo key_info;
+    if (!GetVarint32(&item, &key_info.cf_id)) {
+      assert(false);
+      continue;
+    }
+    key_info.key = item.ToString();
+    key_info.count = pair.second;
+    info->keys.emplace_back(std::move(key_info));
+  }
+  blocks_.GetTopK(&items, &info->total_blocks);
+  info->blocks.clear();
+  for (auto& pair : items) {
+    assert(pair.first.size() == 16);
+    HotBlockInfo block_info;
+    block_info.file_number = DecodeFixed64(pair.first.data());
+    block_info.offset = DecodeFixed64(pair.first.data() + 8);
+    block_info.count = pair.second;
+    info->blocks.emplace_back(block_info);
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
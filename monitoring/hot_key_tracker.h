@@ -0,0 +1,99 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/random.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Finds the items recorded most often. One in sample_rate records is
+// sampled into a count-min sketch, and the top_k items with the highest
+// estimates are kept with their estimates. The counts decay by half on
+// every Decay(), so old heavy hitters fade out.
+//
+// Thread safe. A record that is not sampled costs a thread local random
+// number, a sampled one takes a mutex.
+class HeavyHitterTracker {
+ public:
+  HeavyHitterTracker(uint32_t sample_rate, size_t top_k);
+
+  // Whether the next record is sampled, so the item of a record that is not
+  // is never built
+  bool ShouldSample() const {
+    return sample_rate_ <= 1 || Random::GetTLSInstance()->OneIn(sample_rate_);
+  }
+
+  void RecordSampled(const Slice& item);
+
+  // The estimated number of records of the heaviest hitters, highest
+  // first, scaled by the sample rate. *total is the estimated number of
+  // all records.
+  void GetTopK(std::vector<std::pair<std::string, uint64_t>>* items,
+               uint64_t* total) const;
+
+  void Decay();
+
+ private:
+  static const size_t kDepth = 4;
+  static const size_t kWidth = 2048;
+
+  const int sample_rate_;
+  const size_t top_k_;
+  mutable std::mutex mutex_;
+  // kDepth rows of kWidth counters
+  std::vector<uint32_t> sketch_;
+  std::unordered_map<std::string, uint32_t> top_;
+  uint64_t total_;
+};
+
+struct HotKeysInfo;
+
+// The heavy hitters among the keys of the reads and writes of a db, and
+// among the data blocks of its block based tables.
+class HotKeyTracker {
+ public:
+  HotKeyTracker(uint32_t sample_rate, size_t top_k)
+      : keys_(sample_rate, top_k), blocks_(sample_rate, top_k) {}
+
+  void RecordKey(uint32_t cf_id, const Slice& key) {
+    if (keys_.ShouldSample()) {
+      RecordKeySampled(cf_id, key);
+    }
+  }
+
+  void RecordBlock(uint64_t file_number, uint64_t offset) {
+    if (blocks_.ShouldSample()) {
+      RecordBlockSampled(file_number, offset);
+    }
+  }
+
+  // Column family names are left empty
+  void GetHotKeys(HotKeysInfo* info) const;
+
+  void Decay() {
+    keys_.Decay();
+    blocks_.Decay();
+  }
+
+ private:
+  void RecordKeySampled(uint32_t cf_id, const Slice& key);
+  void RecordBlockSampled(uint64_t file_number, uint64_t offset);
+
+  HeavyHitterTracker keys_;
+  HeavyHitterTracker blocks_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
@@ -39,6 +39,16 @@ void InMemoryStatsHistoryIterator::AdvanceIteratorByTime(uint64_t start_time,
   if (db_impl_ != nullptr) {
     valid_ =
         db_impl_->FindStatsByTime(start_time, end_time, &time_, &stats_map_);
+    if (valid_ && !stats_names_.empty()) {
+      std::map<std::string, uint64_t> selected;
+      for (const auto& name : stats_names_) {
+        auto it = stats_map_.find(name);
+        if (it != stats_map_.end()) {
+          selected.insert(*it);
+        }
+      }
+      stats_map_.swap(selected);
+    }
   } else {
     valid_ = false;
   }
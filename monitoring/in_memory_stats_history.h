@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "rocksdb/stats_history.h"
 #include "rocksdb/terark_namespace.h"
 
@@ -16,11 +19,14 @@ namespace TERARKDB_NAMESPACE {
 class InMemoryStatsHistoryIterator final : public StatsHistoryIterator {
  public:
   // Setup InMemoryStatsHistoryIterator to return stats snapshots between
-  // seconds timestamps [start_time, end_time)
+  // seconds timestamps [start_time, end_time), with only the stats named in
+  // "stats_names", all of them if it is empty
   InMemoryStatsHistoryIterator(uint64_t start_time, uint64_t end_time,
+                               const std::vector<std::string>& stats_names,
                                DBImpl* db_impl)
       : start_time_(start_time),
         end_time_(end_time),
+        stats_names_(stats_names),
         valid_(true),
         db_impl_(db_impl) {
     AdvanceIteratorByTime(start_time_, end_time_);
@@ -49,6 +55,7 @@ class InMemoryStatsHistoryIterator final : public StatsHistoryIterator {
   uint64_t time_;
   uint64_t start_time_;
   uint64_t end_time_;
+  std::vector<std::string> stats_names_;
   std::map<std::string, uint64_t> stats_map_;
   Status status_;
   bool valid_;
@@ -0,0 +1,33 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "monitoring/io_purpose.h"
+
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+#ifdef ROCKSDB_SUPPORT_THREAD_LOCAL
+__thread IOPurpose io_purpose = kIOPurposeOther;
+#endif
+
+const char* IOPurposeName(IOPurpose purpose) {
+  switch (purpose) {
+    case kIOPurposeGet:
+      return "get";
+    case kIOPurposeIterator:
+      return "iterator";
+    case kIOPurposeFlush:
+      return "flush";
+    case kIOPurposeCompaction:
+      return "compaction";
+    case kIOPurposeGarbageCollection:
+      return "gc";
+    default:
+      return "other";
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,52 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+#pragma once
+
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// What the calling thread is doing, for attributing its file I/O. Set by the
+// entry points of reads and background jobs, see IOPurposeGuard.
+enum IOPurpose : unsigned char {
+  kIOPurposeOther = 0,
+  kIOPurposeGet,
+  kIOPurposeIterator,
+  kIOPurposeFlush,
+  kIOPurposeCompaction,
+  kIOPurposeGarbageCollection,
+  kIOPurposeMax
+};
+
+extern const char* IOPurposeName(IOPurpose purpose);
+
+#ifdef ROCKSDB_SUPPORT_THREAD_LOCAL
+extern __thread IOPurpose io_purpose;
+
+inline IOPurpose GetThreadIOPurpose() { return io_purpose; }
+
+// Sets the purpose of the calling thread for its lifetime, nested guards
+// restore the outer purpose
+class IOPurposeGuard {
+ public:
+  explicit IOPurposeGuard(IOPurpose purpose) : saved_(io_purpose) {
+    io_purpose = purpose;
+  }
+  ~IOPurposeGuard() { io_purpose = saved_; }
+
+ private:
+  IOPurpose saved_;
+};
+#else
+inline IOPurpose GetThreadIOPurpose() { return kIOPurposeOther; }
+
+class IOPurposeGuard {
+ public:
+  explicit IOPurposeGuard(IOPurpose /*purpose*/) {}
+};
+#endif
+
+}  // namespace TERARKDB_NAMESPACE
@@ -63,6 +63,8 @@ void PerfContext::Reset() {
   get_from_memtable_count = 0;
   get_post_process_time = 0;
   get_from_output_files_time = 0;
+  blob_fetch_count = 0;
+  blob_fetch_time = 0;
   seek_on_memtable_time = 0;
   seek_on_memtable_count = 0;
   next_on_memtable_count = 0;
@@ -141,6 +143,9 @@ void PerfContextByLevel::Reset() {
   bloom_filter_useful = 0;
   bloom_filter_full_positive = 0;
   bloom_filter_full_true_positive = 0;
+  user_key_return_count = 0;
+  get_from_table_count = 0;
+  get_from_table_nanos = 0;
 #endif
 }
 
@@ -169,6 +174,8 @@ std::string PerfContext::ToString(bool exclude_zero_counters) const {
   PERF_CONTEXT_OUTPUT(get_from_memtable_count);
   PERF_CONTEXT_OUTPUT(get_post_process_time);
   PERF_CONTEXT_OUTPUT(get_from_output_files_time);
+  PERF_CONTEXT_OUTPUT(blob_fetch_count);
+  PERF_CONTEXT_OUTPUT(blob_fetch_time);
   PERF_CONTEXT_OUTPUT(seek_on_memtable_time);
   PERF_CONTEXT_OUTPUT(seek_on_memtable_count);
   PERF_CONTEXT_OUTPUT(next_on_memtable_count);
@@ -221,6 +228,9 @@ std::string PerfContext::ToString(bool exclude_zero_counters) const {
   PERF_CONTEXT_BY_LEVEL_OUTPUT_ONE_COUNTER(bloom_filter_useful);
   PERF_CONTEXT_BY_LEVEL_OUTPUT_ONE_COUNTER(bloom_filter_full_positive);
   PERF_CONTEXT_BY_LEVEL_OUTPUT_ONE_COUNTER(bloom_filter_full_true_positive);
+  PERF_CONTEXT_BY_LEVEL_OUTPUT_ONE_COUNTER(user_key_return_count);
+  PERF_CONTEXT_BY_LEVEL_OUTPUT_ONE_COUNTER(get_from_table_count);
+  PERF_CONTEXT_BY_LEVEL_OUTPUT_ONE_COUNTER(get_from_table_nanos);
   return ss.str();
 #endif
 }
@@ -8,6 +8,13 @@
 
 #include "monitoring/persistent_stats_history.h"
 
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <utility>
@@ -15,6 +22,7 @@
 #include "db/db_impl.h"
 #include "port/likely.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
 #include "util/string_util.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -29,8 +37,10 @@ const std::string kCompatibleVersionKeyString =
 // designates what type of encoding will be used when writing to stats CF;
 // compatible format version designates the minimum format version that
 // can decode the stats CF encoded using the current format version.
-const uint64_t kStatsCFCurrentFormatVersion = 1;
-const uint64_t kStatsCFCompatibleFormatVersion = 1;
+//
+// Format version 2 packs a snapshot into one value and adds the rollups.
+const uint64_t kStatsCFCurrentFormatVersion = 2;
+const uint64_t kStatsCFCompatibleFormatVersion = 2;
 
 Status DecodePersistentStatsVersionNumber(DBImpl* db, StatsVersionKeyType type,
                                           uint64_t* version_number) {
@@ -57,14 +67,97 @@ Status DecodePersistentStatsVersionNumber(DBImpl* db, StatsVersionKeyType type,
   return Status::OK();
 }
 
-int EncodePersistentStatsKey(uint64_t now_seconds, const std::string& key,
-                             int size, char* buf) {
-  char timestamp[kNowSecondsStringLength + 1];
+std::string EncodePersistentStatsKey(StatsHistoryGranularity granularity,
+                                     uint64_t bucket_start) {
+  static const char kGranularityLetter[] = {'s', 'm', 'h', 'd'};
+  char buf[kNowSecondsStringLength + 8];
   // make time stamp string equal in length to allow sorting by time
-  snprintf(timestamp, sizeof(timestamp), "%010d",
-           static_cast<int>(now_seconds));
-  timestamp[kNowSecondsStringLength] = '\0';
-  return snprintf(buf, size, "%s#%s", timestamp, key.c_str());
+  int len = snprintf(buf, sizeof(buf), "%c#%010" PRIu64,
+                     kGranularityLetter[static_cast<int>(granularity)],
+                     bucket_start);
+  return std::string(buf, len);
+}
+
+static uint64_t BucketSeconds(StatsHistoryGranularity granularity) {
+  switch (granularity) {
+    case StatsHistoryGranularity::kMinute:
+      return 60;
+    case StatsHistoryGranularity::kHour:
+      return 60 * 60;
+    case StatsHistoryGranularity::kDay:
+      return 24 * 60 * 60;
+    default:
+      return 1;
+  }
+}
+
+uint64_t PersistentStatsBucketStart(StatsHistoryGranularity granularity,
+                                    uint64_t now_seconds) {
+  return now_seconds - now_seconds % BucketSeconds(granularity);
+}
+
+uint64_t PersistentStatsRetention(StatsHistoryGranularity granularity) {
+  const uint64_t kDaySeconds = 24 * 60 * 60;
+  switch (granularity) {
+    case StatsHistoryGranularity::kSnapshot:
+      return kDaySeconds;
+    case StatsHistoryGranularity::kMinute:
+      return 7 * kDaySeconds;
+    case StatsHistoryGranularity::kHour:
+      return 90 * kDaySeconds;
+    default:
+      return 0;
+  }
+}
+
+void EncodePersistentStats(const std::map<std::string, uint64_t>& stats,
+                           std::string* dst) {
+  PutVarint32(dst, static_cast<uint32_t>(stats.size()));
+  for (const auto& stat : stats) {
+    PutLengthPrefixedSlice(dst, stat.first);
+  }
+  for (const auto& stat : stats) {
+    PutVarint64(dst, stat.second);
+  }
+}
+
+Status DecodePersistentStats(Slice value, const std::vector<std::string>& names,
+                             std::map<std::string, uint64_t>* stats) {
+  uint32_t count = 0;
+  if (!GetVarint32(&value, &count)) {
+    return Status::Corruption("Persistent stats", "bad stats count");
+  }
+  // Both the names column and "names" are sorted
+  std::vector<std::pair<uint32_t, Slice>> selected;
+  auto it = names.begin();
+  for (uint32_t i = 0; i < count; ++i) {
+    Slice name;
+    if (!GetLengthPrefixedSlice(&value, &name)) {
+      return Status::Corruption("Persistent stats", "bad stats name");
+    }
+    if (names.empty()) {
+      selected.emplace_back(i, name);
+      continue;
+    }
+    while (it != names.end() && Slice(*it).compare(name) < 0) {
+      ++it;
+    }
+    if (it != names.end() && Slice(*it) == name) {
+      selected.emplace_back(i, name);
+    }
+  }
+  auto next = selected.begin();
+  for (uint32_t i = 0; i < count && next != selected.end(); ++i) {
+    uint64_t stat_value;
+    if (!GetVarint64(&value, &stat_value)) {
+      return Status::Corruption("Persistent stats", "bad stats value");
+    }
+    if (next->first == i) {
+      (*stats)[next->second.ToString()] = stat_value;
+      ++next;
+    }
+  }
+  return Status::OK();
 }
 
 void OptimizeForPersistentStats(ColumnFamilyOptions* cfo) {
@@ -77,6 +170,70 @@ void OptimizeForPersistentStats(ColumnFamilyOptions* cfo) {
   cfo->compression = kNoCompression;
 }
 
+void PersistentStatsRollup::Add(DBImpl* db, ColumnFamilyHandle* cf,
+                                uint64_t now_seconds,
+                                const std::map<std::string, uint64_t>& delta,
+                                WriteBatch* batch) {
+  std::string value;
+  EncodePersistentStats(delta, &value);
+  batch->Put(cf,
+             EncodePersistentStatsKey(StatsHistoryGranularity::kSnapshot,
+                                      now_seconds),
+             value);
+  bool purge = false;
+  for (size_t i = 0; i < sizeof(buckets_) / sizeof(buckets_[0]); ++i) {
+    auto granularity = static_cast<StatsHistoryGranularity>(i + 1);
+    auto& bucket = buckets_[i];
+    uint64_t start = PersistentStatsBucketStart(granularity, now_seconds);
+    std::string key = EncodePersistentStatsKey(granularity, start);
+    if (bucket.start != start) {
+      purge |= granularity == StatsHistoryGranularity::kHour;
+      bucket.start = start;
+      bucket.stats.clear();
+      // Filled in part before a reopen
+      std::string existing;
+      if (db->Get(ReadOptions(), cf, key, &existing).ok()) {
+        DecodePersistentStats(existing, {}, &bucket.stats);
+      }
+    }
+    for (const auto& stat : delta) {
+      bucket.stats[stat.first] += stat.second;
+    }
+    value.clear();
+    EncodePersistentStats(bucket.stats, &value);
+    batch->Put(cf, key, value);
+  }
+  if (purge) {
+    for (int i = 0; i <= static_cast<int>(StatsHistoryGranularity::kDay); ++i) {
+      auto granularity = static_cast<StatsHistoryGranularity>(i);
+      uint64_t retention = PersistentStatsRetention(granularity);
+      if (retention > 0 && now_seconds > retention) {
+        batch->DeleteRange(
+            cf, EncodePersistentStatsKey(granularity, 0),
+            EncodePersistentStatsKey(granularity, now_seconds - retention));
+      }
+    }
+  }
+}
+
+PersistentStatsHistoryIterator::PersistentStatsHistoryIterator(
+    uint64_t start_time, uint64_t end_time,
+    StatsHistoryGranularity granularity, std::vector<std::string> stats_names,
+    DBImpl* db_impl)
+    : time_(0), stats_names_(std::move(stats_names)), valid_(false) {
+  std::sort(stats_names_.begin(), stats_names_.end());
+  if (db_impl == nullptr || start_time >= end_time) {
+    return;
+  }
+  upper_bound_ = EncodePersistentStatsKey(granularity, end_time);
+  upper_bound_slice_ = upper_bound_;
+  ReadOptions ro;
+  ro.iterate_upper_bound = &upper_bound_slice_;
+  iter_.reset(db_impl->NewIterator(ro, db_impl->PersistentStatsColumnFamily()));
+  iter_->Seek(EncodePersistentStatsKey(granularity, start_time));
+  ParseCurrent();
+}
+
 PersistentStatsHistoryIterator::~PersistentStatsHistoryIterator() {}
 
 bool PersistentStatsHistoryIterator::Valid() const { return valid_; }
@@ -84,8 +241,8 @@ bool PersistentStatsHistoryIterator::Valid() const { return valid_; }
 Status PersistentStatsHistoryIterator::status() const { return status_; }
 
 void PersistentStatsHistoryIterator::Next() {
-  // increment start_time by 1 to avoid infinite loop
-  AdvanceIteratorByTime(GetStatsTime() + 1, end_time_);
+  iter_->Next();
+  ParseCurrent();
 }
 
 uint64_t PersistentStatsHistoryIterator::GetStatsTime() const { return time_; }
@@ -95,79 +252,24 @@ PersistentStatsHistoryIterator::GetStatsMap() const {
   return stats_map_;
 }
 
-std::pair<uint64_t, std::string> parseKey(const Slice& key,
-                                          uint64_t start_time) {
-  std::pair<uint64_t, std::string> result;
-  std::string key_str = key.ToString();
-  std::string::size_type pos = key_str.find("#");
-  // TODO(Zhongyi): add counters to track parse failures?
-  if (pos == std::string::npos) {
-    result.first = port::kMaxUint64;
-    result.second.clear();
-  } else {
-    uint64_t parsed_time = ParseUint64(key_str.substr(0, pos));
-    // skip entries with timestamp smaller than start_time
-    if (parsed_time < start_time) {
-      result.first = port::kMaxUint64;
-      result.second = "";
-    } else {
-      result.first = parsed_time;
-      std::string key_resize = key_str.substr(pos + 1);
-      result.second = key_resize;
-    }
+void PersistentStatsHistoryIterator::ParseCurrent() {
+  stats_map_.clear();
+  valid_ = iter_->Valid();
+  if (!valid_) {
+    status_ = iter_->status();
+    return;
   }
-  return result;
-}
-
-// advance the iterator to the next time between [start_time, end_time)
-// if success, update time_ and stats_map_ with new_time and stats_map
-void PersistentStatsHistoryIterator::AdvanceIteratorByTime(uint64_t start_time,
-                                                           uint64_t end_time) {
-  // try to find next entry in stats_history_ map
-  if (db_impl_ != nullptr) {
-    ReadOptions ro;
-    Iterator* iter =
-        db_impl_->NewIterator(ro, db_impl_->PersistentStatsColumnFamily());
-
-    char timestamp[kNowSecondsStringLength + 1];
-    snprintf(timestamp, sizeof(timestamp), "%010d",
-             static_cast<int>(std::max(time_, start_time)));
-    timestamp[kNowSecondsStringLength] = '\0';
-
-    iter->Seek(timestamp);
-    // no more entries with timestamp >= start_time is found or version key
-    // is found to be incompatible
-    if (!iter->Valid()) {
-      valid_ = false;
-      delete iter;
-      return;
-    }
-    time_ = parseKey(iter->key(), start_time).first;
-    valid_ = true;
-    // check parsed time and invalid if it exceeds end_time
-    if (time_ > end_time) {
-      valid_ = false;
-      delete iter;
-      return;
-    }
-    // find all entries with timestamp equal to time_
-    std::map<std::string, uint64_t> new_stats_map;
-    std::pair<uint64_t, std::string> kv;
-    for (; iter->Valid(); iter->Next()) {
-      kv = parseKey(iter->key(), start_time);
-      if (kv.first != time_) {
-        break;
-      }
-      if (kv.second.compare(kFormatVersionKeyString) == 0) {
-        continue;
-      }
-      new_stats_map[kv.second] = ParseUint64(iter->value().ToString());
-    }
-    stats_map_.swap(new_stats_map);
-    delete iter;
-  } else {
+  // granularity letter + '#' + timestamp
+  Slice key = iter_->key();
+  if (key.size() != kNowSecondsStringLength + 2) {
+    status_ = Status::Corruption("Persistent stats", "bad key");
     valid_ = false;
+    return;
   }
+  key.remove_prefix(2);
+  time_ = ParseUint64(key.ToString());
+  status_ = DecodePersistentStats(iter_->value(), stats_names_, &stats_map_);
+  valid_ = status_.ok();
 }
 
 }  // namespace TERARKDB_NAMESPACE
@@ -8,6 +8,11 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "db/db_impl.h"
 #include "rocksdb/stats_history.h"
 #include "rocksdb/terark_namespace.h"
@@ -31,25 +36,58 @@ enum StatsVersionKeyType : uint32_t {
 Status DecodePersistentStatsVersionNumber(DBImpl* db, StatsVersionKeyType type,
                                           uint64_t* version_number);
 
-// Encode timestamp and stats key into buf
-// Format: timestamp(10 digit) + '#' + key
-// Total length of encoded key will be capped at 100 bytes
-int EncodePersistentStatsKey(uint64_t timestamp, const std::string& key,
-                             int size, char* buf);
+// Persistent stats are kept per StatsHistoryGranularity. A record is keyed
+// by a granularity letter, '#' and the 10 digit start of its bucket, and
+// packs all stats of the bucket into one value, see EncodePersistentStats()
+std::string EncodePersistentStatsKey(StatsHistoryGranularity granularity,
+                                     uint64_t bucket_start);
+
+// Start of the bucket of "granularity" the time falls into
+uint64_t PersistentStatsBucketStart(StatsHistoryGranularity granularity,
+                                    uint64_t now_seconds);
+
+// Seconds the records of "granularity" are kept, 0 if forever
+uint64_t PersistentStatsRetention(StatsHistoryGranularity granularity);
+
+// Format: varint32 count, the names column (length prefixed, in order), then
+// the values column (varint64)
+void EncodePersistentStats(const std::map<std::string, uint64_t>& stats,
+                           std::string* dst);
+
+// Decodes the stats named in the sorted "names" only, all of them if "names"
+// is empty, into *stats
+Status DecodePersistentStats(Slice value, const std::vector<std::string>& names,
+                             std::map<std::string, uint64_t>* stats);
 
 void OptimizeForPersistentStats(ColumnFamilyOptions* cfo);
 
+// Adds each stats snapshot to the minute, hour and day rollups of the
+// persistent stats CF. The rollups being filled are kept in memory, and
+// loaded from the CF when a bucket is entered, so they survive a reopen.
+class PersistentStatsRollup {
+ public:
+  // Puts the snapshot "delta" taken at now_seconds, the rollups it is added
+  // to, and drops the records past their retention once an hour
+  void Add(DBImpl* db, ColumnFamilyHandle* cf, uint64_t now_seconds,
+           const std::map<std::string, uint64_t>& delta, WriteBatch* batch);
+
+ private:
+  struct Bucket {
+    uint64_t start = port::kMaxUint64;
+    std::map<std::string, uint64_t> stats;
+  };
+  // kMinute, kHour, kDay
+  Bucket buckets_[3];
+};
+
 class PersistentStatsHistoryIterator final : public StatsHistoryIterator {
  public:
+  // Returns the records of "granularity" starting in [start_time, end_time),
+  // only the stats named in "stats_names" are decoded, all if it is empty
   PersistentStatsHistoryIterator(uint64_t start_time, uint64_t end_time,
-                                 DBImpl* db_impl)
-      : time_(0),
-        start_time_(start_time),
-        end_time_(end_time),
-        valid_(true),
-        db_impl_(db_impl) {
-    AdvanceIteratorByTime(start_time_, end_time_);
-  }
+                                 StatsHistoryGranularity granularity,
+                                 std::vector<std::string> stats_names,
+                                 DBImpl* db_impl);
   ~PersistentStatsHistoryIterator() override;
   bool Valid() const override;
   Status status() const override;
@@ -60,9 +98,8 @@ class PersistentStatsHistoryIterator final : public StatsHistoryIterator {
   const std::map<std::string, uint64_t>& GetStatsMap() const override;
 
  private:
-  // advance the iterator to the next stats history record with timestamp
-  // between [start_time, end_time)
-  void AdvanceIteratorByTime(uint64_t start_time, uint64_t end_time);
+  // Decodes the record at iter_, or turns invalid at the end
+  void ParseCurrent();
 
   // No copying allowed
   PersistentStatsHistoryIterator(const PersistentStatsHistoryIterator&) =
@@ -73,12 +110,13 @@ class PersistentStatsHistoryIterator final : public StatsHistoryIterator {
       delete;
 
   uint64_t time_;
-  uint64_t start_time_;
-  uint64_t end_time_;
+  std::vector<std::string> stats_names_;
+  std::string upper_bound_;
+  Slice upper_bound_slice_;
+  std::unique_ptr<Iterator> iter_;
   std::map<std::string, uint64_t> stats_map_;
   Status status_;
   bool valid_;
-  DBImpl* db_impl_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -139,6 +139,23 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {GC_TOUCH_FILES, "rocksdb.num.gc.touch_files"},
     {GC_SKIP_GET_BY_SEQ, "rocksdb.num.gc.skip_by_seqno"},
     {GC_SKIP_GET_BY_FILE, "rocksdb.num.gc.skip_by_file_meta"},
+    {BLOB_CACHE_HIT, "rocksdb.blob.cache.hit"},
+    {BLOB_CACHE_MISS, "rocksdb.blob.cache.miss"},
+    {TERARK_ZIP_RECORD_CACHE_HIT, "rocksdb.terark.zip.record.cache.hit"},
+    {TERARK_ZIP_RECORD_CACHE_MISS, "rocksdb.terark.zip.record.cache.miss"},
+    {CACHE_ADMISSION_REJECT, "rocksdb.cache.admission.reject"},
+    {CACHE_ADMISSION_REJECT_BYTES, "rocksdb.cache.admission.reject.bytes"},
+    {NEGATIVE_LOOKUP_CACHE_HIT, "rocksdb.negative.lookup.cache.hit"},
+    {NEGATIVE_LOOKUP_CACHE_MISS, "rocksdb.negative.lookup.cache.miss"},
+    {RATE_LIMITER_LOW_PRI_BYTES, "rocksdb.rate_limiter.low.pri.bytes"},
+    {RATE_LIMITER_MID_PRI_BYTES, "rocksdb.rate_limiter.mid.pri.bytes"},
+    {RATE_LIMITER_HIGH_PRI_BYTES, "rocksdb.rate_limiter.high.pri.bytes"},
+    {GC_READ_BYTES, "rocksdb.gc.read.bytes"},
+    {GC_WRITE_BYTES, "rocksdb.gc.write.bytes"},
+    {STALL_MEMTABLE_LIMIT_MICROS, "rocksdb.stall.memtable.limit.micros"},
+    {STALL_L0_FILE_COUNT_LIMIT_MICROS, "rocksdb.stall.l0.file.count.limit.micros"},
+    {STALL_PENDING_COMPACTION_BYTES_MICROS, "rocksdb.stall.pending.compaction.bytes.micros"},
+    {STALL_READ_AMP_LIMIT_MICROS, "rocksdb.stall.read.amp.limit.micros"},
 };
 
 const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
@@ -178,6 +195,10 @@ const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
     {PICK_GARBAGE_COLLECTION_TIME, "rocksdb.pick.gc.micros"},
     {INSTALL_SUPER_VERSION_TIME, "rocksdb.install.super.version.micros"},
     {BUILD_VERSION_TIME, "rocksdb.build.version.micros"},
+    {TERARK_ZIP_MEMORY_WAIT_MICROS, "rocksdb.terark.zip.memory.wait.micros"},
+    {IO_PROF_READ_MICROS, "rocksdb.io.prof.read.micros"},
+    {IO_PROF_WRITE_MICROS, "rocksdb.io.prof.write.micros"},
+    {IO_PROF_SYNC_MICROS, "rocksdb.io.prof.sync.micros"},
 };
 
 std::shared_ptr<Statistics> CreateDBStatistics() {
@@ -7,7 +7,9 @@
 #include "rocksdb/statistics.h"
 
 #include "port/stack_trace.h"
+#include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/stop_watch.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
 
@@ -39,6 +41,25 @@ TEST_F(StatisticsTest, SanityHistograms) {
   }
 }
 
+TEST_F(StatisticsTest, TimerSampling) {
+  auto stats = CreateDBStatistics();
+  stats->timer_sample_rate_ = 4;
+  for (int i = 0; i < 100; ++i) {
+    StopWatch sw(Env::Default(), stats.get(), DB_GET);
+  }
+  HistogramData data;
+  stats->histogramData(DB_GET, &data);
+  ASSERT_EQ(25, data.count);
+
+  // Timed anyway when the caller wants the elapsed time
+  uint64_t elapsed = 0;
+  for (int i = 0; i < 100; ++i) {
+    StopWatch sw(Env::Default(), stats.get(), DB_WRITE, &elapsed);
+  }
+  stats->histogramData(DB_WRITE, &data);
+  ASSERT_EQ(100, data.count);
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
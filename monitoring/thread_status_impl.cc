@@ -4,6 +4,7 @@
 //  (found in the LICENSE.Apache file in the root directory).
 //
 
+#include <algorithm>
 #include <sstream>
 
 #include "rocksdb/env.h"
@@ -117,6 +118,29 @@ std::map<std::string, uint64_t> ThreadStatus::InterpretOperationProperties(
   return property_map;
 }
 
+double ThreadStatus::GetOperationProgress(ThreadStatus::OperationType op_type,
+                                          const uint64_t* op_properties) {
+  uint64_t done;
+  uint64_t total;
+  switch (op_type) {
+    case OP_COMPACTION:
+      done = op_properties[COMPACTION_PROGRESS_BYTES_DONE];
+      total = op_properties[COMPACTION_PROGRESS_BYTES_TOTAL];
+      break;
+    case OP_FLUSH:
+      done = op_properties[FLUSH_PROGRESS_BYTES_DONE];
+      total = op_properties[FLUSH_PROGRESS_BYTES_TOTAL];
+      break;
+    default:
+      return -1;
+  }
+  if (total == 0) {
+    return -1;
+  }
+  // The total is an estimate
+  return std::min(100.0, 100.0 * done / total);
+}
+
 #else
 
 std::string ThreadStatus::GetThreadTypeName(
@@ -160,5 +184,11 @@ std::map<std::string, uint64_t> ThreadStatus::InterpretOperationProperties(
   return std::map<std::string, uint64_t>();
 }
 
+double ThreadStatus::GetOperationProgress(
+    ThreadStatus::OperationType /*op_type*/,
+    const uint64_t* /*op_properties*/) {
+  return -1;
+}
+
 #endif  // ROCKSDB_USING_THREAD_STATUS
 }  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,56 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+// USDT (DTrace compatible) static probes of the provider "terarkdb". Unlike
+// the function probes of terark-tools/systemtap they survive inlining and
+// rebuilds, list them with
+//   bpftrace -l 'usdt:/path/to/librocksdb.so:terarkdb:*'
+//
+// A probe compiles to a nop and a note in .note.stapsdt, its arguments are
+// only read by an attached tracer, so arguments should be values at hand.
+// The probes are built when sys/sdt.h is present (ROCKSDB_USDT) and are
+// nothing otherwise.
+//
+// The operations timed by a *_start/*_done pair fire *_done on the same
+// thread, *_done is skipped when the operation fails before it is done.
+//
+//   write_group_leader(group_size, group_bytes)
+//   wal_write_start(log_number, bytes)  wal_write_done(log_number, ok)
+//   wal_sync_start(num_logs)            wal_sync_done(ok)
+//   memtable_insert(key_size, value_size)
+//   superversion_acquire_start(cf_id)   superversion_acquire_done(cf_id,
+//                                                                  refreshed)
+//   table_cache_miss_start(file_number) table_cache_miss_done(file_number, ok)
+//   block_read_start(offset, size)      block_read_done(offset, ok)
+//   blob_fetch_start(file_number)       blob_fetch_done(file_number,
+//                                                       cache_hit)
+//   compaction_start(job_id, cf_id, start_level, output_level)
+//   compaction_done(job_id, ok, bytes_written)
+//   gc_start(job_id, cf_id)             gc_done(job_id, ok, bytes_written)
+
+#ifdef ROCKSDB_USDT
+#include <sys/sdt.h>
+
+#define TERARKDB_PROBE(name) DTRACE_PROBE(terarkdb, name)
+#define TERARKDB_PROBE1(name, a1) DTRACE_PROBE1(terarkdb, name, a1)
+#define TERARKDB_PROBE2(name, a1, a2) DTRACE_PROBE2(terarkdb, name, a1, a2)
+#define TERARKDB_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3(terarkdb, name, a1, a2, a3)
+#define TERARKDB_PROBE4(name, a1, a2, a3, a4) \
+  DTRACE_PROBE4(terarkdb, name, a1, a2, a3, a4)
+#else
+// The arguments are not evaluated, sizeof only keeps the variables that
+// exist for a probe from being unused
+#define TERARKDB_PROBE(name) ((void)0)
+#define TERARKDB_PROBE1(name, a1) ((void)sizeof(a1))
+#define TERARKDB_PROBE2(name, a1, a2) ((void)sizeof(a1), (void)sizeof(a2))
+#define TERARKDB_PROBE3(name, a1, a2, a3) \
+  ((void)sizeof(a1), (void)sizeof(a2), (void)sizeof(a3))
+#define TERARKDB_PROBE4(name, a1, a2, a3, a4)                \
+  ((void)sizeof(a1), (void)sizeof(a2), (void)sizeof(a3), \
+   (void)sizeof(a4))
+#endif  // ROCKSDB_USDT
@@ -45,6 +45,8 @@ ImmutableCFOptions::ImmutableCFOptions(const ImmutableDBOptions& db_options,
           cf_options.max_write_buffer_number_to_maintain),
       enable_lazy_compaction(cf_options.enable_lazy_compaction),
       pin_table_properties_in_reader(cf_options.pin_table_properties_in_reader),
+      lazy_load_table_readers(cf_options.lazy_load_table_readers),
+      map_sst_index_memory_budget(cf_options.map_sst_index_memory_budget),
       inplace_update_support(cf_options.inplace_update_support),
       inplace_callback(cf_options.inplace_callback),
       info_log(db_options.info_log.get()),
@@ -52,6 +54,9 @@ ImmutableCFOptions::ImmutableCFOptions(const ImmutableDBOptions& db_options,
       rate_limiter(db_options.rate_limiter.get()),
       info_log_level(db_options.info_log_level),
       env(db_options.env),
+      parallel_task_pool(db_options.parallel_task_pool.get()),
+      compaction_buffer_allocator(
+          db_options.compaction_buffer_allocator.get()),
       allow_mmap_reads(db_options.allow_mmap_reads),
       allow_mmap_writes(db_options.allow_mmap_writes),
       db_paths(db_options.db_paths),
@@ -81,6 +86,9 @@ ImmutableCFOptions::ImmutableCFOptions(const ImmutableDBOptions& db_options,
       preserve_deletes(db_options.preserve_deletes),
       listeners(db_options.listeners),
       row_cache(db_options.row_cache),
+      blob_cache(db_options.blob_cache),
+      hot_key_tracker(db_options.hot_key_tracker),
+      table_access_tracer(db_options.table_access_tracer),
       memtable_insert_with_hint_prefix_extractor(
           cf_options.memtable_insert_with_hint_prefix_extractor.get()),
       cf_paths(cf_options.cf_paths) {
@@ -184,6 +192,9 @@ void MutableCFOptions::Dump(Logger* log) const {
   ROCKS_LOG_INFO(log,
                  "                    max_successive_merges: %" ROCKSDB_PRIszt,
                  max_successive_merges);
+  ROCKS_LOG_INFO(log,
+                 "            memtable_merge_fold_threshold: %" ROCKSDB_PRIszt,
+                 memtable_merge_fold_threshold);
   ROCKS_LOG_INFO(log,
                  "                 inplace_update_num_locks: %" ROCKSDB_PRIszt,
                  inplace_update_num_locks);
@@ -194,18 +205,30 @@ void MutableCFOptions::Dump(Logger* log) const {
                  disable_auto_compactions);
   ROCKS_LOG_INFO(log, "                       max_subcompactions: %u",
                  max_subcompactions);
+  ROCKS_LOG_INFO(log, "           subcompaction_tasks_per_thread: %u",
+                 subcompaction_tasks_per_thread);
+  ROCKS_LOG_INFO(log, "               compaction_schedule_weight: %u",
+                 compaction_schedule_weight);
   ROCKS_LOG_INFO(log, "                                blob_size: %zd",
                  blob_size);
   ROCKS_LOG_INFO(log, "                     blob_large_key_ratio: %f",
                  blob_large_key_ratio);
+  ROCKS_LOG_INFO(log, "                    blob_target_write_amp: %f",
+                 blob_target_write_amp);
   ROCKS_LOG_INFO(log, "                            blob_gc_ratio: %f",
                  blob_gc_ratio);
+  ROCKS_LOG_INFO(log, "                   blob_gc_hotness_weight: %f",
+                 blob_gc_hotness_weight);
   ROCKS_LOG_INFO(log, "                    target_blob_file_size: %" PRIu64,
                  target_blob_file_size);
   ROCKS_LOG_INFO(log, "                blob_file_defragment_size: %" PRIu64,
                  blob_file_defragment_size);
   ROCKS_LOG_INFO(log, "              max_dependence_blob_overlap: %zu",
                  max_dependence_blob_overlap);
+  ROCKS_LOG_INFO(log, "                 align_blob_output_to_sst: %d",
+                 align_blob_output_to_sst);
+  ROCKS_LOG_INFO(log, "                     max_map_sst_read_amp: %zu",
+                 max_map_sst_read_amp);
   ROCKS_LOG_INFO(log, "      soft_pending_compaction_bytes_limit: %" PRIu64,
                  soft_pending_compaction_bytes_limit);
   ROCKS_LOG_INFO(log, "      hard_pending_compaction_bytes_limit: %" PRIu64,
@@ -230,6 +253,14 @@ void MutableCFOptions::Dump(Logger* log) const {
                  ttl_gc_ratio);
   ROCKS_LOG_INFO(log, "                         ttl_max_scan_gap: %zd",
                  ttl_max_scan_gap);
+  ROCKS_LOG_INFO(log, "                       ttl_window_seconds: %" PRIu64,
+                 ttl_window_seconds);
+  ROCKS_LOG_INFO(log, "                  cold_recompress_seconds: %" PRIu64,
+                 cold_recompress_seconds);
+  ROCKS_LOG_INFO(log, "                          hot_path_levels: %d",
+                 hot_path_levels);
+  ROCKS_LOG_INFO(log, "          max_space_amplification_percent: %" PRIu64,
+                 max_space_amplification_percent);
   std::string result;
   char buf[10];
   for (const auto m : max_bytes_for_level_multiplier_additional) {
@@ -254,6 +285,8 @@ void MutableCFOptions::Dump(Logger* log) const {
                  optimize_filters_for_hits);
   ROCKS_LOG_INFO(log, "                  optimize_range_deletion: %d",
                  optimize_range_deletion);
+  ROCKS_LOG_INFO(log, "         partial_compaction_overlap_ratio: %f",
+                 partial_compaction_overlap_ratio);
   ROCKS_LOG_INFO(log, "                              compression: %d",
                  static_cast<int>(compression));
 
@@ -286,16 +319,23 @@ MutableCFOptions::MutableCFOptions(const ColumnFamilyOptions& options, Env* env)
           options.memtable_prefix_bloom_size_ratio),
       memtable_huge_page_size(options.memtable_huge_page_size),
       max_successive_merges(options.max_successive_merges),
+      memtable_merge_fold_threshold(options.memtable_merge_fold_threshold),
       inplace_update_num_locks(options.inplace_update_num_locks),
       prefix_extractor(options.prefix_extractor),
       disable_auto_compactions(options.disable_auto_compactions),
       max_subcompactions(options.max_subcompactions),
+      subcompaction_tasks_per_thread(options.subcompaction_tasks_per_thread),
+      compaction_schedule_weight(options.compaction_schedule_weight),
       blob_size(options.blob_size),
       blob_large_key_ratio(options.blob_large_key_ratio),
+      blob_target_write_amp(options.blob_target_write_amp),
       blob_gc_ratio(options.blob_gc_ratio),
+      blob_gc_hotness_weight(options.blob_gc_hotness_weight),
       target_blob_file_size(options.target_blob_file_size),
       blob_file_defragment_size(options.blob_file_defragment_size),
       max_dependence_blob_overlap(options.max_dependence_blob_overlap),
+      align_blob_output_to_sst(options.align_blob_output_to_sst),
+      max_map_sst_read_amp(options.max_map_sst_read_amp),
       soft_pending_compaction_bytes_limit(
           options.soft_pending_compaction_bytes_limit),
       hard_pending_compaction_bytes_limit(
@@ -318,9 +358,16 @@ MutableCFOptions::MutableCFOptions(const ColumnFamilyOptions& options, Env* env)
       report_bg_io_stats(options.report_bg_io_stats),
       optimize_filters_for_hits(options.optimize_filters_for_hits),
       optimize_range_deletion(options.optimize_range_deletion),
+      partial_compaction_overlap_ratio(
+          options.partial_compaction_overlap_ratio),
       compression(options.compression),
       ttl_gc_ratio(options.ttl_gc_ratio),
-      ttl_max_scan_gap(options.ttl_max_scan_gap) {
+      ttl_max_scan_gap(options.ttl_max_scan_gap),
+      ttl_window_seconds(options.ttl_window_seconds),
+      cold_recompress_seconds(options.cold_recompress_seconds),
+      hot_path_levels(options.hot_path_levels),
+      max_space_amplification_percent(
+          options.max_space_amplification_percent) {
   RefreshDerivedOptions(options.num_levels);
 
   int_tbl_prop_collector_factories = std::make_shared<
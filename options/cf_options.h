@@ -55,6 +55,10 @@ struct ImmutableCFOptions {
 
   bool pin_table_properties_in_reader;
 
+  bool lazy_load_table_readers;
+
+  size_t map_sst_index_memory_budget;
+
   bool inplace_update_support;
 
   UpdateStatus (*inplace_callback)(char* existing_value,
@@ -72,6 +76,10 @@ struct ImmutableCFOptions {
 
   Env* env;
 
+  WorkStealingThreadPool* parallel_task_pool;
+
+  MemoryAllocator* compaction_buffer_allocator;
+
   // Allow the OS to mmap file for reading sst tables. Default: false
   bool allow_mmap_reads;
 
@@ -127,6 +135,15 @@ struct ImmutableCFOptions {
 
   std::shared_ptr<Cache> row_cache;
 
+  std::shared_ptr<Cache> blob_cache;
+
+  // Samples the data block reads, see DBOptions::hot_key_sample_rate
+  std::shared_ptr<HotKeyTracker> hot_key_tracker;
+
+  // Traces the reads of TerarkZip value records and blobs, see
+  // DB::StartTableAccessTrace()
+  std::shared_ptr<TableAccessTracer> table_access_tracer;
+
   const SliceTransform* memtable_insert_with_hint_prefix_extractor;
 
   std::vector<DbPath> cf_paths;
@@ -150,16 +167,23 @@ struct MutableCFOptions {
         memtable_prefix_bloom_size_ratio(0),
         memtable_huge_page_size(0),
         max_successive_merges(0),
+        memtable_merge_fold_threshold(0),
         inplace_update_num_locks(0),
         prefix_extractor(nullptr),
         disable_auto_compactions(false),
         max_subcompactions(0),
+        subcompaction_tasks_per_thread(1),
+        compaction_schedule_weight(1),
         blob_size(0),
         blob_large_key_ratio(0),
+        blob_target_write_amp(0),
         blob_gc_ratio(0),
+        blob_gc_hotness_weight(0),
         target_blob_file_size(0),
         blob_file_defragment_size(0),
         max_dependence_blob_overlap(0),
+        align_blob_output_to_sst(false),
+        max_map_sst_read_amp(0),
         soft_pending_compaction_bytes_limit(0),
         hard_pending_compaction_bytes_limit(0),
         level0_file_num_compaction_trigger(0),
@@ -175,9 +199,14 @@ struct MutableCFOptions {
         report_bg_io_stats(false),
         optimize_filters_for_hits(false),
         optimize_range_deletion(false),
+        partial_compaction_overlap_ratio(0),
         compression(Snappy_Supported() ? kSnappyCompression : kNoCompression),
         ttl_gc_ratio(1.000),
-        ttl_max_scan_gap(0) {}
+        ttl_max_scan_gap(0),
+        ttl_window_seconds(0),
+        cold_recompress_seconds(0),
+        hot_path_levels(0),
+        max_space_amplification_percent(0) {}
 
   explicit MutableCFOptions(const Options& options);
 
@@ -208,18 +237,25 @@ struct MutableCFOptions {
   double memtable_prefix_bloom_size_ratio;
   size_t memtable_huge_page_size;
   size_t max_successive_merges;
+  size_t memtable_merge_fold_threshold;
   size_t inplace_update_num_locks;
   std::shared_ptr<const SliceTransform> prefix_extractor;
 
   // Compaction related options
   bool disable_auto_compactions;
   uint32_t max_subcompactions;
+  uint32_t subcompaction_tasks_per_thread;
+  uint32_t compaction_schedule_weight;
   size_t blob_size;
   double blob_large_key_ratio;
+  double blob_target_write_amp;
   double blob_gc_ratio;
+  double blob_gc_hotness_weight;
   uint64_t target_blob_file_size;
   uint64_t blob_file_defragment_size;
   size_t max_dependence_blob_overlap;
+  bool align_blob_output_to_sst;
+  size_t max_map_sst_read_amp;
   uint64_t soft_pending_compaction_bytes_limit;
   uint64_t hard_pending_compaction_bytes_limit;
   int level0_file_num_compaction_trigger;
@@ -240,6 +276,7 @@ struct MutableCFOptions {
 
   bool optimize_filters_for_hits;
   bool optimize_range_deletion;
+  double partial_compaction_overlap_ratio;
   CompressionType compression;
 
   // Derived options
@@ -248,6 +285,10 @@ struct MutableCFOptions {
 
   double ttl_gc_ratio;
   size_t ttl_max_scan_gap;
+  uint64_t ttl_window_seconds;
+  uint64_t cold_recompress_seconds;
+  int hot_path_levels;
+  uint64_t max_space_amplification_percent;
 
   std::shared_ptr<std::vector<std::unique_ptr<IntTblPropCollectorFactory>>>
       int_tbl_prop_collector_factories;
@@ -15,10 +15,12 @@
 #include "port/port.h"
 #include "rocksdb/cache.h"
 #include "rocksdb/env.h"
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/sst_file_manager.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/wal_filter.h"
 #include "util/logging.h"
+#include "util/trace_replay.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -32,6 +34,8 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       env(options.env),
       rate_limiter(options.rate_limiter),
       sst_file_manager(options.sst_file_manager),
+      parallel_task_pool(options.parallel_task_pool),
+      compaction_buffer_allocator(options.compaction_buffer_allocator),
       info_log(options.info_log),
       info_log_level(options.info_log_level),
       max_file_opening_threads(options.max_file_opening_threads),
@@ -41,6 +45,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       db_log_dir(options.db_log_dir),
       wal_dir(options.wal_dir),
       max_background_flushes(options.max_background_flushes),
+      max_flush_partitions(options.max_flush_partitions),
       max_log_file_size(options.max_log_file_size),
       log_file_time_to_roll(options.log_file_time_to_roll),
       keep_log_file_num(options.keep_log_file_num),
@@ -48,6 +53,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       prepare_log_writer_num(options.prepare_log_writer_num),
       max_manifest_file_size(options.max_manifest_file_size),
       max_manifest_edit_count(options.max_manifest_edit_count),
+      max_manifest_tail_ratio(options.max_manifest_tail_ratio),
       table_cache_numshardbits(options.table_cache_numshardbits),
       wal_ttl_seconds(options.WAL_ttl_seconds),
       wal_size_limit_mb(options.WAL_size_limit_MB),
@@ -59,6 +65,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
           options.use_direct_io_for_flush_and_compaction),
       use_aio_reads(options.use_aio_reads),
       allow_fallocate(options.allow_fallocate),
+      use_async_file_writes(options.use_async_file_writes),
       is_fd_close_on_exec(options.is_fd_close_on_exec),
       advise_random_on_open(options.advise_random_on_open),
       allow_mmap_populate(options.allow_mmap_populate),
@@ -72,16 +79,25 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       use_adaptive_mutex(options.use_adaptive_mutex),
       listeners(options.listeners),
       enable_thread_tracking(options.enable_thread_tracking),
+      smooth_write_delay(options.smooth_write_delay),
       enable_pipelined_write(options.enable_pipelined_write),
       allow_concurrent_memtable_write(options.allow_concurrent_memtable_write),
       enable_write_thread_adaptive_yield(
           options.enable_write_thread_adaptive_yield),
       write_thread_max_yield_usec(options.write_thread_max_yield_usec),
       write_thread_slow_yield_usec(options.write_thread_slow_yield_usec),
+      max_write_batch_group_size_bytes(
+          options.max_write_batch_group_size_bytes),
+      max_write_group_commit_delay_usec(
+          options.max_write_group_commit_delay_usec),
       skip_stats_update_on_db_open(options.skip_stats_update_on_db_open),
       wal_recovery_mode(options.wal_recovery_mode),
+      wal_recovery_readahead_size(options.wal_recovery_readahead_size),
       allow_2pc(options.allow_2pc),
       row_cache(options.row_cache),
+      blob_cache(options.blob_cache),
+      negative_lookup_cache_size(options.negative_lookup_cache_size),
+      metrics_reporter_factory(options.metrics_reporter_factory),
 #ifndef ROCKSDB_LITE
       wal_filter(options.wal_filter),
 #endif  // ROCKSDB_LITE
@@ -92,9 +108,20 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       preserve_deletes(options.preserve_deletes),
       two_write_queues(options.two_write_queues),
       manual_wal_flush(options.manual_wal_flush),
+      wal_compression(options.wal_compression),
       atomic_flush(options.atomic_flush),
       avoid_unnecessary_blocking_io(options.avoid_unnecessary_blocking_io),
-      persist_stats_to_disk(options.persist_stats_to_disk) {
+      persist_stats_to_disk(options.persist_stats_to_disk),
+      checksum_scrub_bytes_per_sec(options.checksum_scrub_bytes_per_sec),
+      hot_key_sample_rate(options.hot_key_sample_rate),
+      hot_key_top_k(options.hot_key_top_k),
+      max_bgerror_resume_count(options.max_bgerror_resume_count),
+      bgerror_resume_retry_interval(options.bgerror_resume_retry_interval),
+      table_access_tracer(std::make_shared<TableAccessTracer>()) {
+  if (hot_key_sample_rate > 0) {
+    hot_key_tracker =
+        std::make_shared<HotKeyTracker>(hot_key_sample_rate, hot_key_top_k);
+  }
 }
 
 void ImmutableDBOptions::Dump(Logger* log) const {
@@ -123,6 +150,8 @@ void ImmutableDBOptions::Dump(Logger* log) const {
   ROCKS_LOG_HEADER(log,
                    "                Options.max_manifest_edit_count: %" PRIu64,
                    max_manifest_edit_count);
+  ROCKS_LOG_HEADER(log, "                Options.max_manifest_tail_ratio: %f",
+                   max_manifest_tail_ratio);
   ROCKS_LOG_HEADER(
       log, "                  Options.log_file_time_to_roll: %" ROCKSDB_PRIszt,
       log_file_time_to_roll);
@@ -137,6 +166,8 @@ void ImmutableDBOptions::Dump(Logger* log) const {
       prepare_log_writer_num);
   ROCKS_LOG_HEADER(log, "                        Options.allow_fallocate: %d",
                    allow_fallocate);
+  ROCKS_LOG_HEADER(log, "                  Options.use_async_file_writes: %d",
+                   use_async_file_writes);
   ROCKS_LOG_HEADER(log, "                       Options.allow_mmap_reads: %d",
                    allow_mmap_reads);
   ROCKS_LOG_HEADER(log, "                      Options.allow_mmap_writes: %d",
@@ -159,6 +190,9 @@ void ImmutableDBOptions::Dump(Logger* log) const {
                    table_cache_numshardbits);
   ROCKS_LOG_HEADER(log, "                 Options.max_background_flushes: %d",
                    max_background_flushes);
+  ROCKS_LOG_HEADER(log,
+                   "                   Options.max_flush_partitions: %" PRIu32,
+                   max_flush_partitions);
   ROCKS_LOG_HEADER(log,
                    "                        Options.WAL_ttl_seconds: %" PRIu64,
                    wal_ttl_seconds);
@@ -205,10 +239,21 @@ void ImmutableDBOptions::Dump(Logger* log) const {
   Header(
       log, "    Options.sst_file_manager.rate_bytes_per_sec: %" PRIi64,
       sst_file_manager ? sst_file_manager->GetDeleteRateBytesPerSecond() : 0);
+  ROCKS_LOG_HEADER(log, "                     Options.parallel_task_pool: %p",
+                   parallel_task_pool.get());
+  ROCKS_LOG_HEADER(log, "            Options.compaction_buffer_allocator: %s",
+                   compaction_buffer_allocator
+                       ? compaction_buffer_allocator->Name()
+                       : "None");
   ROCKS_LOG_HEADER(log, "                      Options.wal_recovery_mode: %d",
                    wal_recovery_mode);
+  ROCKS_LOG_HEADER(log,
+                   "            Options.wal_recovery_readahead_size: %" PRIu64,
+                   wal_recovery_readahead_size);
   ROCKS_LOG_HEADER(log, "                 Options.enable_thread_tracking: %d",
                    enable_thread_tracking);
+  ROCKS_LOG_HEADER(log, "                     Options.smooth_write_delay: %d",
+                   smooth_write_delay);
   ROCKS_LOG_HEADER(log, "                 Options.enable_pipelined_write: %d",
                    enable_pipelined_write);
   ROCKS_LOG_HEADER(log, "        Options.allow_concurrent_memtable_write: %d",
@@ -221,6 +266,12 @@ void ImmutableDBOptions::Dump(Logger* log) const {
   ROCKS_LOG_HEADER(log,
                    "           Options.write_thread_slow_yield_usec: %" PRIu64,
                    write_thread_slow_yield_usec);
+  ROCKS_LOG_HEADER(log,
+                   "       Options.max_write_batch_group_size_bytes: %" PRIu64,
+                   max_write_batch_group_size_bytes);
+  ROCKS_LOG_HEADER(log,
+                   "      Options.max_write_group_commit_delay_usec: %" PRIu64,
+                   max_write_group_commit_delay_usec);
   if (row_cache) {
     ROCKS_LOG_HEADER(
         log, "                              Options.row_cache: %" PRIu64,
@@ -229,6 +280,17 @@ void ImmutableDBOptions::Dump(Logger* log) const {
     ROCKS_LOG_HEADER(log,
                      "                              Options.row_cache: None");
   }
+  if (blob_cache) {
+    ROCKS_LOG_HEADER(
+        log, "                             Options.blob_cache: %" PRIu64,
+        blob_cache->GetCapacity());
+  } else {
+    ROCKS_LOG_HEADER(log,
+                     "                             Options.blob_cache: None");
+  }
+  ROCKS_LOG_HEADER(
+      log, "             Options.negative_lookup_cache_size: %" ROCKSDB_PRIszt,
+      negative_lookup_cache_size);
 #ifndef ROCKSDB_LITE
   ROCKS_LOG_HEADER(log, "                             Options.wal_filter: %s",
                    wal_filter ? wal_filter->Name() : "None");
@@ -244,12 +306,27 @@ void ImmutableDBOptions::Dump(Logger* log) const {
                    two_write_queues);
   ROCKS_LOG_HEADER(log, "                       Options.manual_wal_flush: %d",
                    manual_wal_flush);
+  ROCKS_LOG_HEADER(log, "                        Options.wal_compression: %d",
+                   static_cast<int>(wal_compression));
   ROCKS_LOG_HEADER(log, "                           Options.atomic_flush: %d",
                    atomic_flush);
   ROCKS_LOG_HEADER(log, "          Options.avoid_unnecessary_blocking_io: %d",
                    avoid_unnecessary_blocking_io);
   ROCKS_LOG_HEADER(log, "                Options.persist_stats_to_disk: %u",
                    persist_stats_to_disk);
+  ROCKS_LOG_HEADER(log,
+                   "           Options.checksum_scrub_bytes_per_sec: %" PRIu64,
+                   checksum_scrub_bytes_per_sec);
+  ROCKS_LOG_HEADER(log, "                  Options.hot_key_sample_rate: %" PRIu32,
+                   hot_key_sample_rate);
+  ROCKS_LOG_HEADER(log,
+                   "                        Options.hot_key_top_k: %" ROCKSDB_PRIszt,
+                   hot_key_top_k);
+  ROCKS_LOG_HEADER(log, "             Options.max_bgerror_resume_count: %d",
+                   max_bgerror_resume_count);
+  ROCKS_LOG_HEADER(log,
+                   "          Options.bgerror_resume_retry_interval: %" PRIu64,
+                   bgerror_resume_retry_interval);
 }
 
 MutableDBOptions::MutableDBOptions()
@@ -8,12 +8,15 @@
 #include <string>
 #include <vector>
 
+#include "monitoring/hot_key_tracker.h"
 #include "rocksdb/listener.h"
 #include "rocksdb/options.h"
 #include "rocksdb/terark_namespace.h"
 
 namespace TERARKDB_NAMESPACE {
 
+class TableAccessTracer;
+
 struct ImmutableDBOptions {
   ImmutableDBOptions();
   explicit ImmutableDBOptions(const DBOptions& options);
@@ -27,6 +30,8 @@ struct ImmutableDBOptions {
   Env* env;
   std::shared_ptr<RateLimiter> rate_limiter;
   std::shared_ptr<SstFileManager> sst_file_manager;
+  std::shared_ptr<WorkStealingThreadPool> parallel_task_pool;
+  std::shared_ptr<MemoryAllocator> compaction_buffer_allocator;
   std::shared_ptr<Logger> info_log;
   InfoLogLevel info_log_level;
   int max_file_opening_threads;
@@ -37,6 +42,7 @@ struct ImmutableDBOptions {
   std::string wal_dir;
   uint32_t max_subcompactions;
   int max_background_flushes;
+  uint32_t max_flush_partitions;
   size_t max_log_file_size;
   size_t log_file_time_to_roll;
   size_t keep_log_file_num;
@@ -44,6 +50,7 @@ struct ImmutableDBOptions {
   size_t prepare_log_writer_num;
   uint64_t max_manifest_file_size;
   uint64_t max_manifest_edit_count;
+  double max_manifest_tail_ratio;
   int table_cache_numshardbits;
   uint64_t wal_ttl_seconds;
   uint64_t wal_size_limit_mb;
@@ -54,6 +61,7 @@ struct ImmutableDBOptions {
   bool use_direct_io_for_flush_and_compaction;
   bool use_aio_reads;
   bool allow_fallocate;
+  bool use_async_file_writes;
   bool is_fd_close_on_exec;
   bool advise_random_on_open;
   bool allow_mmap_populate;
@@ -66,15 +74,22 @@ struct ImmutableDBOptions {
   bool use_adaptive_mutex;
   std::vector<std::shared_ptr<EventListener>> listeners;
   bool enable_thread_tracking;
+  bool smooth_write_delay;
   bool enable_pipelined_write;
   bool allow_concurrent_memtable_write;
   bool enable_write_thread_adaptive_yield;
   uint64_t write_thread_max_yield_usec;
   uint64_t write_thread_slow_yield_usec;
+  uint64_t max_write_batch_group_size_bytes;
+  uint64_t max_write_group_commit_delay_usec;
   bool skip_stats_update_on_db_open;
   WALRecoveryMode wal_recovery_mode;
+  uint64_t wal_recovery_readahead_size;
   bool allow_2pc;
   std::shared_ptr<Cache> row_cache;
+  std::shared_ptr<Cache> blob_cache;
+  size_t negative_lookup_cache_size;
+  std::shared_ptr<MetricsReporterFactory> metrics_reporter_factory;
 #ifndef ROCKSDB_LITE
   WalFilter* wal_filter;
 #endif  // ROCKSDB_LITE
@@ -85,9 +100,21 @@ struct ImmutableDBOptions {
   bool preserve_deletes;
   bool two_write_queues;
   bool manual_wal_flush;
+  CompressionType wal_compression;
   bool atomic_flush;
   bool avoid_unnecessary_blocking_io;
   bool persist_stats_to_disk;
+  uint64_t checksum_scrub_bytes_per_sec;
+  uint32_t hot_key_sample_rate;
+  size_t hot_key_top_k;
+  int max_bgerror_resume_count;
+  uint64_t bgerror_resume_retry_interval;
+  // Shared by the column families of the db, nullptr unless
+  // hot_key_sample_rate is set
+  std::shared_ptr<HotKeyTracker> hot_key_tracker;
+  // Shared by the column families of the db, see
+  // DB::StartTableAccessTrace()
+  std::shared_ptr<TableAccessTracer> table_access_tracer;
 };
 
 struct MutableDBOptions {
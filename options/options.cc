@@ -48,6 +48,8 @@ AdvancedColumnFamilyOptions::AdvancedColumnFamilyOptions(const Options& options)
           options.max_write_buffer_number_to_maintain),
       enable_lazy_compaction(options.enable_lazy_compaction),
       pin_table_properties_in_reader(options.pin_table_properties_in_reader),
+      lazy_load_table_readers(options.lazy_load_table_readers),
+      map_sst_index_memory_budget(options.map_sst_index_memory_budget),
       inplace_update_support(options.inplace_update_support),
       inplace_update_num_locks(options.inplace_update_num_locks),
       inplace_callback(options.inplace_callback),
@@ -83,8 +85,11 @@ AdvancedColumnFamilyOptions::AdvancedColumnFamilyOptions(const Options& options)
       table_properties_collector_factories(
           options.table_properties_collector_factories),
       max_successive_merges(options.max_successive_merges),
+      memtable_merge_fold_threshold(options.memtable_merge_fold_threshold),
       optimize_filters_for_hits(options.optimize_filters_for_hits),
       optimize_range_deletion(options.optimize_range_deletion),
+      partial_compaction_overlap_ratio(
+          options.partial_compaction_overlap_ratio),
       paranoid_file_checks(options.paranoid_file_checks),
       force_consistency_checks(options.force_consistency_checks),
       report_bg_io_stats(options.report_bg_io_stats) {
@@ -192,6 +197,9 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
   ROCKS_LOG_HEADER(
       log, "                 Options.bottommost_compression_opts.enabled: %s",
       bottommost_compression_opts.enabled ? "true" : "false");
+  ROCKS_LOG_HEADER(
+      log, "        Options.bottommost_compression_opts.parallel_threads: %u",
+      bottommost_compression_opts.parallel_threads);
   ROCKS_LOG_HEADER(log, "           Options.compression_opts.window_bits: %d",
                    compression_opts.window_bits);
   ROCKS_LOG_HEADER(log, "                 Options.compression_opts.level: %d",
@@ -206,6 +214,8 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
       compression_opts.zstd_max_train_bytes);
   ROCKS_LOG_HEADER(log, "               Options.compression_opts.enabled: %s",
                    compression_opts.enabled ? "true" : "false");
+  ROCKS_LOG_HEADER(log, "      Options.compression_opts.parallel_threads: %u",
+                   compression_opts.parallel_threads);
   ROCKS_LOG_HEADER(log, "     Options.level0_file_num_compaction_trigger: %d",
                    level0_file_num_compaction_trigger);
   ROCKS_LOG_HEADER(log, "         Options.level0_slowdown_writes_trigger: %d",
@@ -252,12 +262,20 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    disable_auto_compactions);
   ROCKS_LOG_HEADER(log, "                     Options.max_subcompactions: %u",
                    max_subcompactions);
+  ROCKS_LOG_HEADER(log, "         Options.subcompaction_tasks_per_thread: %u",
+                   subcompaction_tasks_per_thread);
+  ROCKS_LOG_HEADER(log, "             Options.compaction_schedule_weight: %u",
+                   compaction_schedule_weight);
   ROCKS_LOG_HEADER(log, "                              Options.blob_size: %zd",
                    blob_size);
   ROCKS_LOG_HEADER(log, "                   Options.blob_large_key_ratio: %f",
                    blob_large_key_ratio);
+  ROCKS_LOG_HEADER(log, "                  Options.blob_target_write_amp: %f",
+                   blob_target_write_amp);
   ROCKS_LOG_HEADER(log, "                          Options.blob_gc_ratio: %f",
                    blob_gc_ratio);
+  ROCKS_LOG_HEADER(log, "                 Options.blob_gc_hotness_weight: %f",
+                   blob_gc_hotness_weight);
   ROCKS_LOG_HEADER(log,
                    "                  Options.target_blob_file_size: %" PRIu64,
                    target_blob_file_size);
@@ -266,10 +284,25 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    blob_file_defragment_size);
   ROCKS_LOG_HEADER(log, "            Options.max_dependence_blob_overlap: %zu",
                    max_dependence_blob_overlap);
+  ROCKS_LOG_HEADER(log, "               Options.align_blob_output_to_sst: %d",
+                   align_blob_output_to_sst);
+  ROCKS_LOG_HEADER(log, "                   Options.max_map_sst_read_amp: %zu",
+                   max_map_sst_read_amp);
   ROCKS_LOG_HEADER(log, "                           Options.ttl_gc_ratio: %f",
                    ttl_gc_ratio);
   ROCKS_LOG_HEADER(log, "                       Options.ttl_max_scan_gap: %zd",
                    ttl_max_scan_gap);
+  ROCKS_LOG_HEADER(log,
+                   "                     Options.ttl_window_seconds: %" PRIu64,
+                   ttl_window_seconds);
+  ROCKS_LOG_HEADER(log,
+                   "                Options.cold_recompress_seconds: %" PRIu64,
+                   cold_recompress_seconds);
+  ROCKS_LOG_HEADER(log, "                        Options.hot_path_levels: %d",
+                   hot_path_levels);
+  ROCKS_LOG_HEADER(
+      log, "        Options.max_space_amplification_percent: %" PRIu64,
+      max_space_amplification_percent);
 
   const auto& it_compaction_style =
       compaction_style_to_string.find(compaction_style);
@@ -331,6 +364,11 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    enable_lazy_compaction);
   ROCKS_LOG_HEADER(log, "         Options.pin_table_properties_in_reader: %d",
                    pin_table_properties_in_reader);
+  ROCKS_LOG_HEADER(log, "                Options.lazy_load_table_readers: %d",
+                   lazy_load_table_readers);
+  ROCKS_LOG_HEADER(
+      log, "            Options.map_sst_index_memory_budget: %" ROCKSDB_PRIszt,
+      map_sst_index_memory_budget);
   ROCKS_LOG_HEADER(log, "                 Options.inplace_update_support: %d",
                    inplace_update_support);
   ROCKS_LOG_HEADER(
@@ -349,10 +387,15 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
   ROCKS_LOG_HEADER(
       log, "                  Options.max_successive_merges: %" ROCKSDB_PRIszt,
       max_successive_merges);
+  ROCKS_LOG_HEADER(
+      log, "          Options.memtable_merge_fold_threshold: %" ROCKSDB_PRIszt,
+      memtable_merge_fold_threshold);
   ROCKS_LOG_HEADER(log, "              Options.optimize_filters_for_hits: %d",
                    optimize_filters_for_hits);
   ROCKS_LOG_HEADER(log, "                Options.optimize_range_deletion: %d",
                    optimize_range_deletion);
+  ROCKS_LOG_HEADER(log, "       Options.partial_compaction_overlap_ratio: %f",
+                   partial_compaction_overlap_ratio);
   ROCKS_LOG_HEADER(log, "                   Options.paranoid_file_checks: %d",
                    paranoid_file_checks);
   ROCKS_LOG_HEADER(log, "               Options.force_consistency_checks: %d",
@@ -560,6 +603,8 @@ ReadOptions::ReadOptions()
       iterate_lower_bound(nullptr),
       iterate_upper_bound(nullptr),
       readahead_size(0),
+      blob_readahead_size(0),
+      async_prefetch_depth(0),
       max_skippable_internal_keys(0),
       read_tier(kReadAllTier),
       verify_checksums(true),
@@ -571,13 +616,17 @@ ReadOptions::ReadOptions()
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
-      iter_start_seqnum(0) {}
+      iter_start_seqnum(0),
+      value_projection(nullptr),
+      value_projection_is_meta(false) {}
 
 ReadOptions::ReadOptions(bool cksum, bool cache)
     : snapshot(nullptr),
       iterate_lower_bound(nullptr),
       iterate_upper_bound(nullptr),
       readahead_size(0),
+      blob_readahead_size(0),
+      async_prefetch_depth(0),
       max_skippable_internal_keys(0),
       read_tier(kReadAllTier),
       verify_checksums(cksum),
@@ -589,6 +638,8 @@ ReadOptions::ReadOptions(bool cksum, bool cache)
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
-      iter_start_seqnum(0) {}
+      iter_start_seqnum(0),
+      value_projection(nullptr),
+      value_projection_is_meta(false) {}
 
 }  // namespace TERARKDB_NAMESPACE
@@ -41,6 +41,9 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.env = immutable_db_options.env;
   options.rate_limiter = immutable_db_options.rate_limiter;
   options.sst_file_manager = immutable_db_options.sst_file_manager;
+  options.parallel_task_pool = immutable_db_options.parallel_task_pool;
+  options.compaction_buffer_allocator =
+      immutable_db_options.compaction_buffer_allocator;
   options.info_log = immutable_db_options.info_log;
   options.info_log_level = immutable_db_options.info_log_level;
   options.max_open_files = mutable_db_options.max_open_files;
@@ -65,6 +68,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.bytes_per_sync = mutable_db_options.bytes_per_sync;
   options.wal_bytes_per_sync = mutable_db_options.wal_bytes_per_sync;
   options.max_background_flushes = immutable_db_options.max_background_flushes;
+  options.max_flush_partitions = immutable_db_options.max_flush_partitions;
   options.max_log_file_size = immutable_db_options.max_log_file_size;
   options.log_file_time_to_roll = immutable_db_options.log_file_time_to_roll;
   options.keep_log_file_num = immutable_db_options.keep_log_file_num;
@@ -73,6 +77,8 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.max_manifest_file_size = immutable_db_options.max_manifest_file_size;
   options.max_manifest_edit_count =
       immutable_db_options.max_manifest_edit_count;
+  options.max_manifest_tail_ratio =
+      immutable_db_options.max_manifest_tail_ratio;
   options.table_cache_numshardbits =
       immutable_db_options.table_cache_numshardbits;
   options.WAL_ttl_seconds = immutable_db_options.wal_ttl_seconds;
@@ -86,11 +92,21 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
       immutable_db_options.use_direct_io_for_flush_and_compaction;
   options.use_aio_reads = immutable_db_options.use_aio_reads;
   options.allow_fallocate = immutable_db_options.allow_fallocate;
+  options.use_async_file_writes =
+      immutable_db_options.use_async_file_writes;
   options.is_fd_close_on_exec = immutable_db_options.is_fd_close_on_exec;
   options.stats_dump_period_sec = mutable_db_options.stats_dump_period_sec;
   options.stats_persist_period_sec =
       mutable_db_options.stats_persist_period_sec;
   options.persist_stats_to_disk = immutable_db_options.persist_stats_to_disk;
+  options.checksum_scrub_bytes_per_sec =
+      immutable_db_options.checksum_scrub_bytes_per_sec;
+  options.hot_key_sample_rate = immutable_db_options.hot_key_sample_rate;
+  options.hot_key_top_k = immutable_db_options.hot_key_top_k;
+  options.max_bgerror_resume_count =
+      immutable_db_options.max_bgerror_resume_count;
+  options.bgerror_resume_retry_interval =
+      immutable_db_options.bgerror_resume_retry_interval;
   options.stats_history_buffer_size =
       mutable_db_options.stats_history_buffer_size;
   options.advise_random_on_open = immutable_db_options.advise_random_on_open;
@@ -111,6 +127,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.use_adaptive_mutex = immutable_db_options.use_adaptive_mutex;
   options.listeners = immutable_db_options.listeners;
   options.enable_thread_tracking = immutable_db_options.enable_thread_tracking;
+  options.smooth_write_delay = immutable_db_options.smooth_write_delay;
   options.delayed_write_rate = mutable_db_options.delayed_write_rate;
   options.enable_pipelined_write = immutable_db_options.enable_pipelined_write;
   options.allow_concurrent_memtable_write =
@@ -121,11 +138,22 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
       immutable_db_options.write_thread_max_yield_usec;
   options.write_thread_slow_yield_usec =
       immutable_db_options.write_thread_slow_yield_usec;
+  options.max_write_batch_group_size_bytes =
+      immutable_db_options.max_write_batch_group_size_bytes;
+  options.max_write_group_commit_delay_usec =
+      immutable_db_options.max_write_group_commit_delay_usec;
   options.skip_stats_update_on_db_open =
       immutable_db_options.skip_stats_update_on_db_open;
   options.wal_recovery_mode = immutable_db_options.wal_recovery_mode;
+  options.wal_recovery_readahead_size =
+      immutable_db_options.wal_recovery_readahead_size;
   options.allow_2pc = immutable_db_options.allow_2pc;
   options.row_cache = immutable_db_options.row_cache;
+  options.blob_cache = immutable_db_options.blob_cache;
+  options.negative_lookup_cache_size =
+      immutable_db_options.negative_lookup_cache_size;
+  options.metrics_reporter_factory =
+      immutable_db_options.metrics_reporter_factory;
 #ifndef ROCKSDB_LITE
   options.wal_filter = immutable_db_options.wal_filter;
 #endif  // ROCKSDB_LITE
@@ -140,6 +168,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.preserve_deletes = immutable_db_options.preserve_deletes;
   options.two_write_queues = immutable_db_options.two_write_queues;
   options.manual_wal_flush = immutable_db_options.manual_wal_flush;
+  options.wal_compression = immutable_db_options.wal_compression;
   options.atomic_flush = immutable_db_options.atomic_flush;
   options.avoid_unnecessary_blocking_io =
       immutable_db_options.avoid_unnecessary_blocking_io;
@@ -160,6 +189,8 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.memtable_prefix_bloom_size_ratio;
   cf_opts.memtable_huge_page_size = mutable_cf_options.memtable_huge_page_size;
   cf_opts.max_successive_merges = mutable_cf_options.max_successive_merges;
+  cf_opts.memtable_merge_fold_threshold =
+      mutable_cf_options.memtable_merge_fold_threshold;
   cf_opts.inplace_update_num_locks =
       mutable_cf_options.inplace_update_num_locks;
   cf_opts.prefix_extractor = mutable_cf_options.prefix_extractor;
@@ -169,15 +200,22 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.disable_auto_compactions;
   cf_opts.blob_size = mutable_cf_options.blob_size;
   cf_opts.blob_large_key_ratio = mutable_cf_options.blob_large_key_ratio;
+  cf_opts.blob_target_write_amp = mutable_cf_options.blob_target_write_amp;
   cf_opts.blob_gc_ratio = mutable_cf_options.blob_gc_ratio;
+  cf_opts.blob_gc_hotness_weight = mutable_cf_options.blob_gc_hotness_weight;
   cf_opts.target_blob_file_size = mutable_cf_options.target_blob_file_size;
   cf_opts.blob_file_defragment_size =
       mutable_cf_options.blob_file_defragment_size;
   cf_opts.max_dependence_blob_overlap =
       mutable_cf_options.max_dependence_blob_overlap;
+  cf_opts.align_blob_output_to_sst =
+      mutable_cf_options.align_blob_output_to_sst;
+  cf_opts.max_map_sst_read_amp = mutable_cf_options.max_map_sst_read_amp;
   cf_opts.optimize_filters_for_hits =
       mutable_cf_options.optimize_filters_for_hits;
   cf_opts.optimize_range_deletion = mutable_cf_options.optimize_range_deletion;
+  cf_opts.partial_compaction_overlap_ratio =
+      mutable_cf_options.partial_compaction_overlap_ratio;
   cf_opts.soft_pending_compaction_bytes_limit =
       mutable_cf_options.soft_pending_compaction_bytes_limit;
   cf_opts.hard_pending_compaction_bytes_limit =
@@ -198,6 +236,11 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.max_bytes_for_level_multiplier;
   cf_opts.ttl_gc_ratio = mutable_cf_options.ttl_gc_ratio;
   cf_opts.ttl_max_scan_gap = mutable_cf_options.ttl_max_scan_gap;
+  cf_opts.ttl_window_seconds = mutable_cf_options.ttl_window_seconds;
+  cf_opts.cold_recompress_seconds = mutable_cf_options.cold_recompress_seconds;
+  cf_opts.hot_path_levels = mutable_cf_options.hot_path_levels;
+  cf_opts.max_space_amplification_percent =
+      mutable_cf_options.max_space_amplification_percent;
 
   cf_opts.max_bytes_for_level_multiplier_additional =
       mutable_cf_options.max_bytes_for_level_multiplier_additional;
@@ -212,6 +255,10 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
   cf_opts.report_bg_io_stats = mutable_cf_options.report_bg_io_stats;
   cf_opts.compression = mutable_cf_options.compression;
   cf_opts.max_subcompactions = mutable_cf_options.max_subcompactions;
+  cf_opts.subcompaction_tasks_per_thread =
+      mutable_cf_options.subcompaction_tasks_per_thread;
+  cf_opts.compaction_schedule_weight =
+      mutable_cf_options.compaction_schedule_weight;
 
   cf_opts.table_factory = options.table_factory;
   // TODO(yhchiang): find some way to handle the following derived options
@@ -245,7 +292,8 @@ std::unordered_map<std::string, ChecksumType>
     OptionsHelper::checksum_type_string_map = {{"kNoChecksum", kNoChecksum},
                                                {"kCRC32c", kCRC32c},
                                                {"kxxHash", kxxHash},
-                                               {"kxxHash64", kxxHash64}};
+                                               {"kxxHash64", kxxHash64},
+                                               {"kXXH3", kXXH3}};
 
 std::unordered_map<std::string, CompressionType>
     OptionsHelper::compression_type_string_map = {
@@ -952,8 +1000,7 @@ Status ParseCompressionOptions(const std::string& value,
                                    name);
   }
   end = value.find(':', start);
-  compression_opts.strategy =
-      ParseInt(value.substr(start, value.size() - start));
+  compression_opts.strategy = ParseInt(value.substr(start, end - start));
   // max_dict_bytes is optional for backwards compatibility
   if (end != std::string::npos) {
     start = end + 1;
@@ -961,9 +1008,9 @@ Status ParseCompressionOptions(const std::string& value,
       return Status::InvalidArgument(
           "unable to parse the specified CF option " + name);
     }
-    compression_opts.max_dict_bytes =
-        ParseInt(value.substr(start, value.size() - start));
     end = value.find(':', start);
+    compression_opts.max_dict_bytes =
+        ParseInt(value.substr(start, end - start));
   }
   // zstd_max_train_bytes is optional for backwards compatibility
   if (end != std::string::npos) {
@@ -972,9 +1019,9 @@ Status ParseCompressionOptions(const std::string& value,
       return Status::InvalidArgument(
           "unable to parse the specified CF option " + name);
     }
-    compression_opts.zstd_max_train_bytes =
-        ParseInt(value.substr(start, value.size() - start));
     end = value.find(':', start);
+    compression_opts.zstd_max_train_bytes =
+        ParseInt(value.substr(start, end - start));
   }
   // enabled is optional for backwards compatibility
   if (end != std::string::npos) {
@@ -983,8 +1030,19 @@ Status ParseCompressionOptions(const std::string& value,
       return Status::InvalidArgument(
           "unable to parse the specified CF option " + name);
     }
+    end = value.find(':', start);
     compression_opts.enabled =
-        ParseBoolean("", value.substr(start, value.size() - start));
+        ParseBoolean("", value.substr(start, end - start));
+  }
+  // parallel_threads is optional for backwards compatibility
+  if (end != std::string::npos) {
+    start = end + 1;
+    if (start >= value.size()) {
+      return Status::InvalidArgument(
+          "unable to parse the specified CF option " + name);
+    }
+    compression_opts.parallel_threads =
+        ParseUint32(value.substr(start, value.size() - start));
   }
   return Status::OK();
 }
@@ -1058,9 +1116,8 @@ Status ParseColumnFamilyOption(const std::string& name,
         return Status::InvalidArgument(
             "unable to parse the specified CF option " + name);
       }
-      new_options->table_factory.reset(NewTerarkZipTableFactory(
-          tzto, std::shared_ptr<TERARKDB_NAMESPACE::TableFactory>(
-                    NewBlockBasedTableFactory())));
+      new_options->table_factory.reset(
+          NewTerarkZipTableFactory(tzto, NewTerarkZipFallbackTableFactory()));
 #endif
     } else {
       auto iter = cf_options_type_info.find(name);
@@ -1513,6 +1570,7 @@ std::unordered_map<std::string, OptionTypeInfo>
          // not yet supported
           Env* env;
           std::shared_ptr<Cache> row_cache;
+          std::shared_ptr<Cache> blob_cache;
           std::shared_ptr<DeleteScheduler> delete_scheduler;
           std::shared_ptr<Logger> info_log;
           std::shared_ptr<RateLimiter> rate_limiter;
@@ -1532,6 +1590,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"allow_fallocate",
          {offsetof(struct DBOptions, allow_fallocate), OptionType::kBoolean,
           OptionVerificationType::kNormal, false, 0}},
+        {"use_async_file_writes",
+         {offsetof(struct DBOptions, use_async_file_writes),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"allow_mmap_writes",
          {offsetof(struct DBOptions, allow_mmap_writes), OptionType::kBoolean,
           OptionVerificationType::kNormal, false, 0}},
@@ -1550,6 +1611,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"allow_2pc",
          {offsetof(struct DBOptions, allow_2pc), OptionType::kBoolean,
           OptionVerificationType::kNormal, false, 0}},
+        {"negative_lookup_cache_size",
+         {offsetof(struct DBOptions, negative_lookup_cache_size),
+          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
         {"allow_os_buffer",
          {0, OptionType::kBoolean, OptionVerificationType::kDeprecated, true,
           0}},
@@ -1568,6 +1632,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"enable_thread_tracking",
          {offsetof(struct DBOptions, enable_thread_tracking),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"smooth_write_delay",
+         {offsetof(struct DBOptions, smooth_write_delay), OptionType::kBoolean,
+          OptionVerificationType::kNormal, false, 0}},
         {"error_if_exists",
          {offsetof(struct DBOptions, error_if_exists), OptionType::kBoolean,
           OptionVerificationType::kNormal, false, 0}},
@@ -1619,6 +1686,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"max_background_flushes",
          {offsetof(struct DBOptions, max_background_flushes), OptionType::kInt,
           OptionVerificationType::kNormal, false, 0}},
+        {"max_flush_partitions",
+         {offsetof(struct DBOptions, max_flush_partitions),
+          OptionType::kUInt32T, OptionVerificationType::kNormal, false, 0}},
         {"max_file_opening_threads",
          {offsetof(struct DBOptions, max_file_opening_threads),
           OptionType::kInt, OptionVerificationType::kNormal, false, 0}},
@@ -1685,6 +1755,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"max_manifest_edit_count",
          {offsetof(struct DBOptions, max_manifest_edit_count),
           OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"max_manifest_tail_ratio",
+         {offsetof(struct DBOptions, max_manifest_tail_ratio),
+          OptionType::kDouble, OptionVerificationType::kNormal, false, 0}},
         {"max_wal_size",
          {offsetof(struct DBOptions, max_wal_size), OptionType::kUInt64T,
           OptionVerificationType::kNormal, true,
@@ -1708,6 +1781,21 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"persist_stats_to_disk",
          {offsetof(struct DBOptions, persist_stats_to_disk),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"checksum_scrub_bytes_per_sec",
+         {offsetof(struct DBOptions, checksum_scrub_bytes_per_sec),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"hot_key_sample_rate",
+         {offsetof(struct DBOptions, hot_key_sample_rate),
+          OptionType::kUInt32T, OptionVerificationType::kNormal, false, 0}},
+        {"hot_key_top_k",
+         {offsetof(struct DBOptions, hot_key_top_k), OptionType::kSizeT,
+          OptionVerificationType::kNormal, false, 0}},
+        {"max_bgerror_resume_count",
+         {offsetof(struct DBOptions, max_bgerror_resume_count),
+          OptionType::kInt, OptionVerificationType::kNormal, false, 0}},
+        {"bgerror_resume_retry_interval",
+         {offsetof(struct DBOptions, bgerror_resume_retry_interval),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
         {"stats_history_buffer_size",
          {offsetof(struct DBOptions, stats_history_buffer_size),
           OptionType::kSizeT, OptionVerificationType::kNormal, true,
@@ -1725,6 +1813,9 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct DBOptions, wal_recovery_mode),
           OptionType::kWALRecoveryMode, OptionVerificationType::kNormal, false,
           0}},
+        {"wal_recovery_readahead_size",
+         {offsetof(struct DBOptions, wal_recovery_readahead_size),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
         {"enable_write_thread_adaptive_yield",
          {offsetof(struct DBOptions, enable_write_thread_adaptive_yield),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -1734,6 +1825,12 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"write_thread_max_yield_usec",
          {offsetof(struct DBOptions, write_thread_max_yield_usec),
           OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"max_write_batch_group_size_bytes",
+         {offsetof(struct DBOptions, max_write_batch_group_size_bytes),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"max_write_group_commit_delay_usec",
+         {offsetof(struct DBOptions, max_write_group_commit_delay_usec),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
         {"access_hint_on_compaction_start",
          {offsetof(struct DBOptions, access_hint_on_compaction_start),
           OptionType::kAccessHint, OptionVerificationType::kNormal, false, 0}},
@@ -1773,6 +1870,10 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct DBOptions, manual_wal_flush), OptionType::kBoolean,
           OptionVerificationType::kNormal, false,
           offsetof(struct ImmutableDBOptions, manual_wal_flush)}},
+        {"wal_compression",
+         {offsetof(struct DBOptions, wal_compression),
+          OptionType::kCompressionType, OptionVerificationType::kNormal, false,
+          offsetof(struct ImmutableDBOptions, wal_compression)}},
         {"seq_per_batch",
          {0, OptionType::kBoolean, OptionVerificationType::kDeprecated, false,
           0}},
@@ -1913,6 +2014,14 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::max_subcompactions),
           OptionType::kUInt32T, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, max_subcompactions)}},
+        {"subcompaction_tasks_per_thread",
+         {offset_of(&ColumnFamilyOptions::subcompaction_tasks_per_thread),
+          OptionType::kUInt32T, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, subcompaction_tasks_per_thread)}},
+        {"compaction_schedule_weight",
+         {offset_of(&ColumnFamilyOptions::compaction_schedule_weight),
+          OptionType::kUInt32T, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, compaction_schedule_weight)}},
         {"blob_size",
          {offset_of(&ColumnFamilyOptions::blob_size), OptionType::kSizeT,
           OptionVerificationType::kNormal, true,
@@ -1921,10 +2030,18 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::blob_large_key_ratio),
           OptionType::kDouble, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, blob_large_key_ratio)}},
+        {"blob_target_write_amp",
+         {offset_of(&ColumnFamilyOptions::blob_target_write_amp),
+          OptionType::kDouble, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, blob_target_write_amp)}},
         {"blob_gc_ratio",
          {offset_of(&ColumnFamilyOptions::blob_gc_ratio), OptionType::kDouble,
           OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, blob_gc_ratio)}},
+        {"blob_gc_hotness_weight",
+         {offset_of(&ColumnFamilyOptions::blob_gc_hotness_weight),
+          OptionType::kDouble, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, blob_gc_hotness_weight)}},
         {"target_blob_file_size",
          {offset_of(&ColumnFamilyOptions::target_blob_file_size),
           OptionType::kUInt64T, OptionVerificationType::kNormal, true,
@@ -1937,6 +2054,14 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::max_dependence_blob_overlap),
           OptionType::kSizeT, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, max_dependence_blob_overlap)}},
+        {"align_blob_output_to_sst",
+         {offset_of(&ColumnFamilyOptions::align_blob_output_to_sst),
+          OptionType::kBoolean, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, align_blob_output_to_sst)}},
+        {"max_map_sst_read_amp",
+         {offset_of(&ColumnFamilyOptions::max_map_sst_read_amp),
+          OptionType::kSizeT, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, max_map_sst_read_amp)}},
         {"filter_deletes",
          {0, OptionType::kBoolean, OptionVerificationType::kDeprecated, true,
           0}},
@@ -1946,6 +2071,12 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"pin_table_properties_in_reader",
          {offset_of(&ColumnFamilyOptions::pin_table_properties_in_reader),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"lazy_load_table_readers",
+         {offset_of(&ColumnFamilyOptions::lazy_load_table_readers),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"map_sst_index_memory_budget",
+         {offset_of(&ColumnFamilyOptions::map_sst_index_memory_budget),
+          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
         {"inplace_update_support",
          {offset_of(&ColumnFamilyOptions::inplace_update_support),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -1960,6 +2091,11 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::optimize_range_deletion),
           OptionType::kBoolean, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, optimize_range_deletion)}},
+        {"partial_compaction_overlap_ratio",
+         {offset_of(&ColumnFamilyOptions::partial_compaction_overlap_ratio),
+          OptionType::kDouble, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions,
+                   partial_compaction_overlap_ratio)}},
         {"paranoid_file_checks",
          {offset_of(&ColumnFamilyOptions::paranoid_file_checks),
           OptionType::kBoolean, OptionVerificationType::kNormal, true,
@@ -2043,6 +2179,10 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::max_successive_merges),
           OptionType::kSizeT, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, max_successive_merges)}},
+        {"memtable_merge_fold_threshold",
+         {offset_of(&ColumnFamilyOptions::memtable_merge_fold_threshold),
+          OptionType::kSizeT, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, memtable_merge_fold_threshold)}},
         {"memtable_huge_page_size",
          {offset_of(&ColumnFamilyOptions::memtable_huge_page_size),
           OptionType::kSizeT, OptionVerificationType::kNormal, true,
@@ -2162,7 +2302,24 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"ttl_max_scan_gap",
          {offset_of(&ColumnFamilyOptions::ttl_max_scan_gap), OptionType::kSizeT,
           OptionVerificationType::kNormal, true,
-          offsetof(struct MutableCFOptions, ttl_max_scan_gap)}}};
+          offsetof(struct MutableCFOptions, ttl_max_scan_gap)}},
+        {"ttl_window_seconds",
+         {offset_of(&ColumnFamilyOptions::ttl_window_seconds),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, ttl_window_seconds)}},
+        {"cold_recompress_seconds",
+         {offset_of(&ColumnFamilyOptions::cold_recompress_seconds),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, cold_recompress_seconds)}},
+        {"hot_path_levels",
+         {offset_of(&ColumnFamilyOptions::hot_path_levels), OptionType::kInt,
+          OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, hot_path_levels)}},
+        {"max_space_amplification_percent",
+         {offset_of(&ColumnFamilyOptions::max_space_amplification_percent),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions,
+                   max_space_amplification_percent)}}};
 
 std::unordered_map<std::string, OptionTypeInfo>
     OptionsHelper::universal_compaction_options_type_info = {
@@ -2220,7 +2377,11 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"high_pri_pool_ratio",
          {offset_of(&LRUCacheOptions::high_pri_pool_ratio), OptionType::kDouble,
           OptionVerificationType::kNormal, true,
-          offsetof(struct LRUCacheOptions, high_pri_pool_ratio)}}};
+          offsetof(struct LRUCacheOptions, high_pri_pool_ratio)}},
+        {"high_pri_pool_max_ratio",
+         {offset_of(&LRUCacheOptions::high_pri_pool_max_ratio),
+          OptionType::kDouble, OptionVerificationType::kNormal, true,
+          offsetof(struct LRUCacheOptions, high_pri_pool_max_ratio)}}};
 
 std::unordered_map<std::string, TerarkZipTableOptions::EntropyAlgo>
     OptionsHelper::entropy_algo_string_map = {
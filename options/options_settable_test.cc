@@ -98,6 +98,8 @@ TEST_F(OptionsSettableTest, BlockBasedTableOptionsAllFieldsSettable) {
        sizeof(std::shared_ptr<Cache>)},
       {offsetof(struct BlockBasedTableOptions, filter_policy),
        sizeof(std::shared_ptr<const FilterPolicy>)},
+      {offsetof(struct BlockBasedTableOptions, value_column_widths),
+       sizeof(std::string)},
   };
 
   // In this test, we catch a new option of BlockBasedTableOptions that is not
@@ -147,16 +149,19 @@ TEST_F(OptionsSettableTest, BlockBasedTableOptionsAllFieldsSettable) {
       "data_block_hash_table_util_ratio=0.75;"
       "checksum=kxxHash;hash_index_allow_collision=1;no_block_cache=1;"
       "block_cache=1M;block_cache_compressed=1k;block_size=1024;"
+      "block_cache_compressed_compression=kLZ4Compression;"
       "block_size_deviation=8;block_restart_interval=4; "
       "metadata_block_size=1024;"
       "partition_filters=false;"
       "index_block_restart_interval=4;"
       "filter_policy=bloomfilter:4:true;whole_key_filtering=1;"
+      "auto_prefix_filtering=true;"
       "format_version=1;"
       "hash_index_allow_collision=false;"
       "verify_compression=true;read_amp_bytes_per_bit=0;"
       "enable_index_compression=false;"
-      "block_align=true",
+      "block_align=true;"
+      "value_column_widths=4:8",
       new_bbto));
 
   ASSERT_EQ(unset_bytes_base,
@@ -166,6 +171,7 @@ TEST_F(OptionsSettableTest, BlockBasedTableOptionsAllFieldsSettable) {
   ASSERT_TRUE(new_bbto->block_cache.get() != nullptr);
   ASSERT_TRUE(new_bbto->block_cache_compressed.get() != nullptr);
   ASSERT_TRUE(new_bbto->filter_policy.get() != nullptr);
+  ASSERT_EQ(new_bbto->value_column_widths, "4:8");
 
   bbto->~BlockBasedTableOptions();
   new_bbto->~BlockBasedTableOptions();
@@ -189,6 +195,10 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
        sizeof(std::shared_ptr<RateLimiter>)},
       {offsetof(struct DBOptions, sst_file_manager),
        sizeof(std::shared_ptr<SstFileManager>)},
+      {offsetof(struct DBOptions, parallel_task_pool),
+       sizeof(std::shared_ptr<WorkStealingThreadPool>)},
+      {offsetof(struct DBOptions, compaction_buffer_allocator),
+       sizeof(std::shared_ptr<MemoryAllocator>)},
       {offsetof(struct DBOptions, info_log), sizeof(std::shared_ptr<Logger>)},
       {offsetof(struct DBOptions, statistics),
        sizeof(std::shared_ptr<Statistics>)},
@@ -200,6 +210,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
       {offsetof(struct DBOptions, listeners),
        sizeof(std::vector<std::shared_ptr<EventListener>>)},
       {offsetof(struct DBOptions, row_cache), sizeof(std::shared_ptr<Cache>)},
+      {offsetof(struct DBOptions, blob_cache), sizeof(std::shared_ptr<Cache>)},
       {offsetof(struct DBOptions, metrics_reporter_factory),
        sizeof(std::shared_ptr<MetricsReporterFactory>)},
       {offsetof(struct DBOptions, wal_filter), sizeof(const WalFilter*)},
@@ -255,6 +266,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "skip_stats_update_on_db_open=false;"
                              "max_manifest_file_size=4295009941;"
                              "max_manifest_edit_count=429500994;"
+                             "max_manifest_tail_ratio=2.5;"
                              "db_log_dir=path/to/db_log_dir;"
                              "skip_log_error_on_recovery=true;"
                              "use_aio_reads=true;"
@@ -263,11 +275,13 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "is_fd_close_on_exec=false;"
                              "bytes_per_sync=4295013613;"
                              "enable_thread_tracking=false;"
+                             "smooth_write_delay=true;"
                              "recycle_log_file_num=0;"
                              "prepare_log_writer_num=0;"
                              "create_missing_column_families=true;"
                              "log_file_time_to_roll=3097;"
                              "max_background_flushes=35;"
+                             "max_flush_partitions=4;"
                              "create_if_missing=false;"
                              "error_if_exists=true;"
                              "delayed_write_rate=4294976214;"
@@ -276,8 +290,14 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "stats_dump_period_sec=70127;"
                              "stats_persist_period_sec=54321;"
                              "persist_stats_to_disk=true;"
+                             "checksum_scrub_bytes_per_sec=31337;"
+                             "hot_key_sample_rate=17;"
+                             "hot_key_top_k=19;"
+                             "max_bgerror_resume_count=23;"
+                             "bgerror_resume_retry_interval=29;"
                              "stats_history_buffer_size=14159;"
                              "allow_fallocate=true;"
+                             "use_async_file_writes=false;"
                              "allow_mmap_reads=false;"
                              "use_direct_reads=false;"
                              "use_direct_io_for_flush_and_compaction=false;"
@@ -290,13 +310,17 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "enable_pipelined_write=false;"
                              "allow_concurrent_memtable_write=true;"
                              "wal_recovery_mode=kPointInTimeRecovery;"
+                             "wal_recovery_readahead_size=33554432;"
                              "enable_write_thread_adaptive_yield=true;"
                              "write_thread_slow_yield_usec=5;"
                              "write_thread_max_yield_usec=1000;"
+                             "max_write_batch_group_size_bytes=4194304;"
+                             "max_write_group_commit_delay_usec=20;"
                              "access_hint_on_compaction_start=NONE;"
                              "info_log_level=DEBUG_LEVEL;"
                              "dump_malloc_stats=false;"
                              "allow_2pc=false;"
+                             "negative_lookup_cache_size=4096;"
                              "avoid_flush_during_recovery=false;"
                              "avoid_flush_during_shutdown=false;"
                              "allow_ingest_behind=false;"
@@ -304,6 +328,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "concurrent_prepare=false;"
                              "two_write_queues=false;"
                              "manual_wal_flush=false;"
+                             "wal_compression=kZSTD;"
                              "seq_per_batch=false;"
                              "atomic_flush=false;"
                              "avoid_unnecessary_blocking_io=false",
@@ -419,6 +444,8 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
   ASSERT_OK(GetColumnFamilyOptionsFromString(
       *options,
       "max_subcompactions=1;"
+      "subcompaction_tasks_per_thread=4;"
+      "compaction_schedule_weight=2;"
       "compaction_filter_factory=mpudlojcujCompactionFilterFactory;"
       "table_factory=PlainTable;"
       "prefix_extractor=rocksdb.CappedPrefix.13;"
@@ -431,6 +458,7 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "target_file_size_base=4294976376;"
       "memtable_huge_page_size=2557;"
       "max_successive_merges=5497;"
+      "memtable_merge_fold_threshold=16;"
       "max_sequential_skip_in_iterations=4294971408;"
       "arena_block_size=1893;"
       "target_file_size_multiplier=35;"
@@ -459,6 +487,8 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "level_compaction_dynamic_level_bytes=false;"
       "enable_lazy_compaction=true;"
       "pin_table_properties_in_reader=false;"
+      "lazy_load_table_readers=true;"
+      "map_sst_index_memory_budget=1048576;"
       "inplace_update_support=true;"
       "compaction_style=kCompactionStyleUniversal;"
       "compaction_pri=kMinOverlappingRatio;"
@@ -466,16 +496,25 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "disable_auto_compactions=false;"
       "blob_size=1028;"
       "blob_large_key_ratio=0.5;"
+      "blob_target_write_amp=0;"
       "blob_size=1024;"
       "blob_gc_ratio=0.05;"
+      "blob_gc_hotness_weight=0;"
       "target_blob_file_size=0;"
       "blob_file_defragment_size=0;"
       "max_dependence_blob_overlap=1024;"
+      "align_blob_output_to_sst=true;"
+      "max_map_sst_read_amp=0;"
       "optimize_filters_for_hits=false;"
       "optimize_range_deletion=false;"
+      "partial_compaction_overlap_ratio=0.25;"
       "report_bg_io_stats=true;"
       "ttl_gc_ratio=3.000;"
-      "ttl_max_scan_gap=1;",
+      "ttl_max_scan_gap=1;"
+      "ttl_window_seconds=3600;"
+      "cold_recompress_seconds=86400;"
+      "hot_path_levels=3;"
+      "max_space_amplification_percent=250;",
       new_options));
 
   ASSERT_EQ(unset_bytes_base,
@@ -483,6 +522,10 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
                           kColumnFamilyOptionsBlacklist));
   EXPECT_EQ(new_options->ttl_gc_ratio, 3.000);
   EXPECT_EQ(new_options->ttl_max_scan_gap, 1);
+  EXPECT_EQ(new_options->ttl_window_seconds, 3600);
+  EXPECT_EQ(new_options->cold_recompress_seconds, 86400);
+  EXPECT_EQ(new_options->hot_path_levels, 3);
+  EXPECT_EQ(new_options->max_space_amplification_percent, 250);
   options->~ColumnFamilyOptions();
   new_options->~ColumnFamilyOptions();
 
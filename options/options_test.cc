@@ -65,7 +65,7 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
        "kZSTDNotFinalCompression"},
       {"bottommost_compression", "kLZ4Compression"},
       {"bottommost_compression_opts", "5:6:7:8:9:true"},
-      {"compression_opts", "4:5:6:7:8:true"},
+      {"compression_opts", "4:5:6:7:8:true:3"},
       {"num_levels", "8"},
       {"level0_file_num_compaction_trigger", "8"},
       {"level0_slowdown_writes_trigger", "9"},
@@ -172,6 +172,7 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_cf_opt.compression_opts.max_dict_bytes, 7);
   ASSERT_EQ(new_cf_opt.compression_opts.zstd_max_train_bytes, 8);
   ASSERT_EQ(new_cf_opt.compression_opts.enabled, true);
+  ASSERT_EQ(new_cf_opt.compression_opts.parallel_threads, 3U);
   ASSERT_EQ(new_cf_opt.bottommost_compression, kLZ4Compression);
   ASSERT_EQ(new_cf_opt.bottommost_compression_opts.window_bits, 5);
   ASSERT_EQ(new_cf_opt.bottommost_compression_opts.level, 6);
@@ -179,6 +180,7 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_cf_opt.bottommost_compression_opts.max_dict_bytes, 8);
   ASSERT_EQ(new_cf_opt.bottommost_compression_opts.zstd_max_train_bytes, 9);
   ASSERT_EQ(new_cf_opt.bottommost_compression_opts.enabled, true);
+  ASSERT_EQ(new_cf_opt.bottommost_compression_opts.parallel_threads, 1U);
   ASSERT_EQ(new_cf_opt.num_levels, 8);
   ASSERT_EQ(new_cf_opt.level0_file_num_compaction_trigger, 8);
   ASSERT_EQ(new_cf_opt.level0_slowdown_writes_trigger, 9);
@@ -573,6 +575,11 @@ TEST_F(OptionsTest, GetBlockBasedTableOptionsFromString) {
             new_opt.cache_index_and_filter_blocks);
   ASSERT_EQ(table_opt.filter_policy, new_opt.filter_policy);
 
+  // xor filter policy
+  ASSERT_OK(GetBlockBasedTableOptionsFromString(
+      table_opt, "filter_policy=xorfilter:10", &new_opt));
+  ASSERT_TRUE(new_opt.filter_policy != nullptr);
+
   // Check block cache options are overwritten when specified
   // in new format as a struct.
   ASSERT_OK(GetBlockBasedTableOptionsFromString(
@@ -807,6 +814,21 @@ TEST_F(OptionsTest, GetOptionsFromStringTest) {
   ASSERT_EQ(new_options.create_if_missing, true);
   ASSERT_EQ(new_options.max_open_files, 1);
   ASSERT_TRUE(new_options.rate_limiter.get() != nullptr);
+
+  // The six and seven fields forms
+  ColumnFamilyOptions new_cf_options;
+  ASSERT_OK(GetColumnFamilyOptionsFromString(
+      ColumnFamilyOptions(),
+      "compression_opts=4:5:6:7:8:true;"
+      "bottommost_compression_opts=5:6:7:8:9:false:2",
+      &new_cf_options));
+  ASSERT_EQ(new_cf_options.compression_opts.zstd_max_train_bytes, 8);
+  ASSERT_EQ(new_cf_options.compression_opts.enabled, true);
+  ASSERT_EQ(new_cf_options.compression_opts.parallel_threads, 1U);
+  ASSERT_EQ(new_cf_options.bottommost_compression_opts.zstd_max_train_bytes,
+            9);
+  ASSERT_EQ(new_cf_options.bottommost_compression_opts.enabled, false);
+  ASSERT_EQ(new_cf_options.bottommost_compression_opts.parallel_threads, 2U);
 }
 
 TEST_F(OptionsTest, DBOptionsSerialization) {
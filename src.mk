@@ -3,6 +3,7 @@ LIB_SOURCES =                                                   \
   cache/clock_cache.cc                                          \
   cache/lirs_cache.cc                                           \
   cache/lru_cache.cc                                            \
+  cache/quota_cache.cc                                          \
   cache/sharded_cache.cc                                        \
   db/builder.cc                                                 \
   db/c.cc                                                       \
@@ -14,6 +15,9 @@ LIB_SOURCES =                                                   \
   db/compaction_picker.cc                                       \
   db/compaction_picker_universal.cc                             \
   db/compaction_dispatcher.cc                                   \
+  db/compaction_transport.cc                                    \
+  db/compaction_worker_context.cc                               \
+  db/compaction_worker_pool.cc                                  \
   db/convenience.cc                                             \
   db/db_filesnapshot.cc                                         \
   db/db_impl.cc                                                 \
@@ -23,6 +27,7 @@ LIB_SOURCES =                                                   \
   db/db_impl_files.cc                                           \
   db/db_impl_open.cc                                            \
   db/db_impl_readonly.cc                                        \
+  db/db_impl_secondary.cc                                       \
   db/db_impl_write.cc                                           \
   db/db_info_dumper.cc                                          \
   db/db_iter.cc                                                 \
@@ -46,6 +51,7 @@ LIB_SOURCES =                                                   \
   db/memtable_list.cc                                           \
   db/merge_helper.cc                                            \
   db/merge_operator.cc                                          \
+  db/negative_lookup_cache.cc                                   \
   db/periodic_work_scheduler.cc                                 \
   db/range_del_aggregator.cc                                    \
   db/range_tombstone_fragmenter.cc                              \
@@ -82,8 +88,10 @@ LIB_SOURCES =                                                   \
   memtable/write_buffer_manager.cc                              \
   monitoring/histogram.cc                                       \
   monitoring/histogram_windowing.cc                             \
+  monitoring/hot_key_tracker.cc                                 \
   monitoring/in_memory_stats_history.cc                         \
   monitoring/instrumented_mutex.cc                              \
+  monitoring/io_purpose.cc                                      \
   monitoring/iostats_context.cc                                 \
   monitoring/perf_context.cc                                    \
   monitoring/perf_level.cc                                      \
@@ -116,6 +124,7 @@ LIB_SOURCES =                                                   \
   table/block_fetcher.cc                                        \
   table/block_prefix_index.cc                                   \
   table/bloom_block.cc                                          \
+  table/columnar_block.cc                                       \
   table/cuckoo_table_builder.cc                                 \
   table/cuckoo_table_factory.cc                                 \
   table/cuckoo_table_reader.cc                                  \
@@ -148,6 +157,7 @@ LIB_SOURCES =                                                   \
   table/two_level_iterator.cc                                   \
   tools/dump/db_dump_tool.cc                                    \
   util/arena.cc                                                 \
+  util/arena_block_pool.cc                                      \
   util/auto_roll_logger.cc                                      \
   util/bloom.cc                                                 \
   util/build_version.cc                                         \
@@ -159,6 +169,7 @@ LIB_SOURCES =                                                   \
   util/crc32c.cc                                                \
   util/delete_scheduler.cc                                      \
   util/dynamic_bloom.cc                                         \
+  util/epoch_manager.cc                                         \
   util/event_logger.cc                                          \
   util/file_reader_writer.cc                                    \
   util/file_util.cc                                             \
@@ -182,6 +193,8 @@ LIB_SOURCES =                                                   \
   util/threadpool_imp.cc                                        \
   util/trace_replay.cc                                          \
   util/transaction_test_util.cc                                 \
+  util/work_stealing_thread_pool.cc                             \
+  util/xor_filter.cc                                            \
   util/xxhash.cc                                                \
   utilities/backupable/backupable_db.cc                         \
   utilities/cassandra/cassandra_compaction_filter.cc            \
@@ -201,6 +214,7 @@ LIB_SOURCES =                                                   \
   utilities/document/json_document.cc                           \
   utilities/document/json_document_builder.cc                   \
   utilities/env_mirror.cc                                       \
+  utilities/env_remote_read_cache.cc                            \
   utilities/env_timed.cc                                        \
   utilities/flink/flink_compaction_filter.cc                    \
   utilities/geodb/geodb_impl.cc                                 \
@@ -215,6 +229,7 @@ LIB_SOURCES =                                                   \
   utilities/merge_operators/uint64add.cc                        \
   utilities/merge_operators/bytesxor.cc                         \
   utilities/option_change_migration/option_change_migration.cc  \
+  utilities/options/options_auto_tuner.cc                       \
   utilities/options/options_util.cc                             \
   utilities/persistent_cache/block_cache_tier.cc                \
   utilities/persistent_cache/block_cache_tier_file.cc           \
@@ -222,6 +237,11 @@ LIB_SOURCES =                                                   \
   utilities/persistent_cache/persistent_cache_tier.cc           \
   utilities/persistent_cache/volatile_tier_impl.cc              \
   utilities/redis/redis_lists.cc                                \
+  utilities/redis/redis_store.cc                                \
+  utilities/replication/replication.cc                          \
+  utilities/secondary_index/secondary_index.cc                  \
+  utilities/sharded_db/sharded_db.cc                            \
+  utilities/simulator_cache/cache_simulator.cc                  \
   utilities/simulator_cache/sim_cache.cc                        \
   utilities/spatialdb/spatial_db.cc                             \
   utilities/table_properties_collectors/compact_on_deletion_collector.cc \
@@ -289,6 +309,9 @@ MAIN_SOURCES =                                                          \
   db/compaction_job_stats_test.cc                                       \
   db/compaction_job_test.cc                                             \
   db/compaction_picker_test.cc                                          \
+  db/compaction_transport_test.cc                                       \
+  db/compaction_worker_context_test.cc                                  \
+  db/compaction_worker_pool_test.cc                                     \
   db/comparator_db_test.cc                                              \
   db/corruption_test.cc                                                 \
   db/cuckoo_table_db_test.cc                                            \
@@ -311,6 +334,7 @@ MAIN_SOURCES =                                                          \
   db/db_options_test.cc                                                 \
   db/db_properties_test.cc                                              \
   db/db_range_del_test.cc                                               \
+  db/db_secondary_test.cc                                               \
   db/db_sst_test.cc                                                     \
   db/db_statistics_test.cc                                              \
   db/db_table_properties_test.cc                                        \
@@ -355,6 +379,7 @@ MAIN_SOURCES =                                                          \
   db/range_del_aggregator_test.cc                                       \
   db/range_del_aggregator_bench.cc                                      \
   db/range_tombstone_fragmenter_test.cc                                 \
+  db/snapshot_impl_test.cc                                              \
   db/table_properties_collector_test.cc                                 \
   db/util_merge_operators_test.cc                                       \
   db/version_builder_test.cc                                            \
@@ -365,6 +390,7 @@ MAIN_SOURCES =                                                          \
   db/write_callback_test.cc                                             \
   db/write_controller_test.cc                                           \
   env/env_basic_test.cc                                                 \
+  env/env_encryption_test.cc                                            \
   env/env_test.cc                                                       \
   env/mock_env_test.cc                                                  \
   memtable/inlineskiplist_test.cc                                       \
@@ -408,6 +434,7 @@ MAIN_SOURCES =                                                          \
   util/coding_test.cc                                                   \
   util/crc32c_test.cc                                                   \
   util/dynamic_bloom_test.cc                                            \
+  util/epoch_manager_test.cc                                            \
   util/event_logger_test.cc                                             \
   util/filelock_test.cc                                                 \
   util/log_write_bench.cc                                               \
@@ -418,6 +445,7 @@ MAIN_SOURCES =                                                          \
   util/timer_test.cc                                                    \
   util/thread_list_test.cc                                              \
   util/thread_local_test.cc                                             \
+  util/work_stealing_thread_pool_test.cc                                \
   utilities/backupable/backupable_db_test.cc                            \
   utilities/cassandra/cassandra_format_test.cc                          \
   utilities/cassandra/cassandra_functional_test.cc                      \
@@ -426,9 +454,11 @@ MAIN_SOURCES =                                                          \
   utilities/checkpoint/checkpoint_test.cc                               \
   utilities/column_aware_encoding_exp.cc                                \
   utilities/column_aware_encoding_test.cc                               \
+  utilities/coroutine_test.cc                                           \
   utilities/date_tiered/date_tiered_test.cc                             \
   utilities/document/document_db_test.cc                                \
   utilities/document/json_document_test.cc                              \
+  utilities/env_remote_read_cache_test.cc                               \
   utilities/geodb/geodb_test.cc                                         \
   utilities/flink/flink_compaction_filter_test.cc                       \
   utilities/lua/rocks_lua_test.cc                                       \
@@ -436,8 +466,13 @@ MAIN_SOURCES =                                                          \
   utilities/merge_operators/string_append/stringappend_test.cc          \
   utilities/object_registry_test.cc                                     \
   utilities/option_change_migration/option_change_migration_test.cc     \
+  utilities/options/options_auto_tuner_test.cc                          \
   utilities/options/options_util_test.cc                                \
   utilities/redis/redis_lists_test.cc                                   \
+  utilities/replication/replication_test.cc                             \
+  utilities/secondary_index/secondary_index_test.cc                     \
+  utilities/sharded_db/sharded_db_test.cc                               \
+  utilities/simulator_cache/cache_simulator_test.cc                     \
   utilities/simulator_cache/sim_cache_test.cc                           \
   utilities/spatialdb/spatial_db_test.cc                                \
   utilities/table_properties_collectors/compact_on_deletion_collector_test.cc  \
@@ -5,6 +5,9 @@
 #ifndef ROCKSDB_LITE
 #include "table/adaptive_table_factory.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "port/port.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/format.h"
@@ -17,11 +20,13 @@ AdaptiveTableFactory::AdaptiveTableFactory(
     std::shared_ptr<TableFactory> table_factory_to_write,
     std::shared_ptr<TableFactory> block_based_table_factory,
     std::shared_ptr<TableFactory> plain_table_factory,
-    std::shared_ptr<TableFactory> cuckoo_table_factory)
+    std::shared_ptr<TableFactory> cuckoo_table_factory,
+    std::shared_ptr<TableFactorySelector> table_factory_selector)
     : table_factory_to_write_(table_factory_to_write),
       block_based_table_factory_(block_based_table_factory),
       plain_table_factory_(plain_table_factory),
-      cuckoo_table_factory_(cuckoo_table_factory) {
+      cuckoo_table_factory_(cuckoo_table_factory),
+      table_factory_selector_(table_factory_selector) {
   if (!plain_table_factory_) {
     plain_table_factory_.reset(NewPlainTableFactory());
   }
@@ -46,7 +51,7 @@ Status AdaptiveTableFactory::NewTableReader(
     const TableReaderOptions& table_reader_options,
     std::unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
     std::unique_ptr<TableReader>* table,
-    bool /*prefetch_index_and_filter_in_cache*/) const {
+    bool prefetch_index_and_filter_in_cache) const {
   Footer footer;
   auto s = ReadFooterFromFile(file.get(), nullptr /* prefetch_buffer */,
                               file_size, &footer);
@@ -64,6 +69,13 @@ Status AdaptiveTableFactory::NewTableReader(
   } else if (footer.table_magic_number() == kCuckooTableMagicNumber) {
     return cuckoo_table_factory_->NewTableReader(
         table_reader_options, std::move(file), file_size, table);
+  } else if (table_factory_to_write_ != block_based_table_factory_ &&
+             table_factory_to_write_ != plain_table_factory_ &&
+             table_factory_to_write_ != cuckoo_table_factory_) {
+    // e.g. TerarkZip, which also falls back on its own by magic number
+    return table_factory_to_write_->NewTableReader(
+        table_reader_options, std::move(file), file_size, table,
+        prefetch_index_and_filter_in_cache);
   } else {
     return Status::NotSupported("Unidentified table format");
   }
@@ -72,8 +84,20 @@ Status AdaptiveTableFactory::NewTableReader(
 TableBuilder* AdaptiveTableFactory::NewTableBuilder(
     const TableBuilderOptions& table_builder_options, uint32_t column_family_id,
     WritableFileWriter* file) const {
-  return table_factory_to_write_->NewTableBuilder(table_builder_options,
-                                                  column_family_id, file);
+  TableFactory* factory = nullptr;
+  if (table_factory_selector_) {
+    TableFactorySelector::Context context;
+    context.level = table_builder_options.level;
+    context.num_levels = table_builder_options.ioptions.num_levels;
+    context.sst_purpose = table_builder_options.sst_purpose;
+    context.compaction_load = table_builder_options.compaction_load;
+    factory = table_factory_selector_->Select(context);
+  }
+  if (factory == nullptr) {
+    factory = table_factory_to_write_.get();
+  }
+  return factory->NewTableBuilder(table_builder_options, column_family_id,
+                                  file);
 }
 
 std::string AdaptiveTableFactory::GetPrintableTableOptions() const {
@@ -108,6 +132,10 @@ std::string AdaptiveTableFactory::GetPrintableTableOptions() const {
         cuckoo_table_factory_->Name() ? cuckoo_table_factory_->Name() : "",
         cuckoo_table_factory_->GetPrintableTableOptions().c_str());
   }
+  if (table_factory_selector_) {
+    pos += snprintf(pos, end - pos, "  table factory selector: %s\n",
+                    table_factory_selector_->Name());
+  }
   assert(pos <= end);
   ret.resize(pos - &ret[0]);
   return ret;
@@ -124,10 +152,52 @@ extern TableFactory* NewAdaptiveTableFactory(
     std::shared_ptr<TableFactory> table_factory_to_write,
     std::shared_ptr<TableFactory> block_based_table_factory,
     std::shared_ptr<TableFactory> plain_table_factory,
-    std::shared_ptr<TableFactory> cuckoo_table_factory) {
-  return new AdaptiveTableFactory(table_factory_to_write,
-                                  block_based_table_factory,
-                                  plain_table_factory, cuckoo_table_factory);
+    std::shared_ptr<TableFactory> cuckoo_table_factory,
+    std::shared_ptr<TableFactorySelector> table_factory_selector) {
+  return new AdaptiveTableFactory(
+      table_factory_to_write, block_based_table_factory, plain_table_factory,
+      cuckoo_table_factory, table_factory_selector);
+}
+
+namespace {
+class LevelTableFactorySelector : public TableFactorySelector {
+ public:
+  LevelTableFactorySelector(
+      std::vector<std::shared_ptr<TableFactory>> level_factories,
+      std::shared_ptr<TableFactory> busy_factory, double busy_load)
+      : level_factories_(std::move(level_factories)),
+        busy_factory_(std::move(busy_factory)),
+        busy_load_(busy_load) {}
+
+  const char* Name() const override { return "LevelTableFactorySelector"; }
+
+  TableFactory* Select(const Context& context) const override {
+    if (context.sst_purpose != kEssenceSst || context.level < 0) {
+      return nullptr;
+    }
+    if (busy_factory_ && context.compaction_load >= busy_load_ &&
+        context.level < context.num_levels - 1) {
+      return busy_factory_.get();
+    }
+    if (level_factories_.empty()) {
+      return nullptr;
+    }
+    size_t i = std::min<size_t>(context.level, level_factories_.size() - 1);
+    return level_factories_[i].get();
+  }
+
+ private:
+  std::vector<std::shared_ptr<TableFactory>> level_factories_;
+  std::shared_ptr<TableFactory> busy_factory_;
+  double busy_load_;
+};
+}  // namespace
+
+TableFactorySelector* NewLevelTableFactorySelector(
+    std::vector<std::shared_ptr<TableFactory>> level_factories,
+    std::shared_ptr<TableFactory> busy_factory, double busy_load) {
+  return new LevelTableFactorySelector(std::move(level_factories),
+                                       std::move(busy_factory), busy_load);
 }
 
 }  // namespace TERARKDB_NAMESPACE
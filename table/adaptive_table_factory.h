@@ -31,7 +31,8 @@ class AdaptiveTableFactory : public TableFactory {
       std::shared_ptr<TableFactory> table_factory_to_write,
       std::shared_ptr<TableFactory> block_based_table_factory,
       std::shared_ptr<TableFactory> plain_table_factory,
-      std::shared_ptr<TableFactory> cuckoo_table_factory);
+      std::shared_ptr<TableFactory> cuckoo_table_factory,
+      std::shared_ptr<TableFactorySelector> table_factory_selector);
 
   const char* Name() const override { return "AdaptiveTableFactory"; }
 
@@ -62,6 +63,7 @@ class AdaptiveTableFactory : public TableFactory {
   std::shared_ptr<TableFactory> block_based_table_factory_;
   std::shared_ptr<TableFactory> plain_table_factory_;
   std::shared_ptr<TableFactory> cuckoo_table_factory_;
+  std::shared_ptr<TableFactorySelector> table_factory_selector_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -204,11 +204,18 @@ void DataBlockIter::Prev() {
 }
 
 void DataBlockIter::Seek(const Slice& target) {
-  Slice seek_key = target;
   PERF_TIMER_GUARD(block_seek_nanos);
   if (data_ == nullptr) {  // Not init yet
     return;
   }
+  if (data_block_hash_index_ != nullptr && SeekByHashIndex(target)) {
+    return;
+  }
+  BinarySeekImpl(target);
+}
+
+void DataBlockIter::BinarySeekImpl(const Slice& target) {
+  Slice seek_key = target;
   uint32_t index = 0;
   bool ok = BinarySeek<DecodeKey>(seek_key, 0, num_restarts_ - 1, &index,
                                   comparator_);
@@ -226,6 +233,59 @@ void DataBlockIter::Seek(const Slice& target) {
   }
 }
 
+// Seek through the hash index, for a `target` whose user_key is in the
+// block. The hash index maps the user_key to the only restart interval
+// holding it, the result is the first key >= target from there on.
+//
+// Returns false, leaving the iter to a binary search, if the user_key has
+// a collision, is not in the hash index, or is a false positive of it.
+bool DataBlockIter::SeekByHashIndex(const Slice& target) {
+  Slice user_key = ExtractUserKey(target);
+  uint32_t map_offset = restarts_ + num_restarts_ * sizeof(uint32_t);
+  uint8_t entry = data_block_hash_index_->Lookup(data_, map_offset, user_key);
+  if (entry == kCollision || entry == kNoEntry) {
+    return false;
+  }
+
+  uint32_t restart_index = entry;
+  assert(restart_index < num_restarts_);
+  SeekToRestartPoint(restart_index);
+  const char* limit = nullptr;
+  if (restart_index + 1 < num_restarts_) {
+    limit = data_ + GetRestartPoint(restart_index + 1);
+  } else {
+    limit = data_ + restarts_;
+  }
+
+  bool matched = false;
+  while (ParseNextDataKey(limit)) {
+    int cmp = user_comparator_->Compare(key_.GetUserKey(), user_key);
+    if (cmp > 0) {
+      // Keys before it are smaller than target, if the user_key is here
+      return matched;
+    }
+    if (cmp == 0) {
+      matched = true;
+      if (Compare(key_, target) >= 0) {
+        return true;
+      }
+    }
+  }
+  if (!status_.ok()) {
+    return true;
+  }
+  if (!matched) {
+    return false;
+  }
+  // Every version of the user_key is smaller than target, the result is the
+  // first key of the next restart interval
+  if (restart_index + 1 < num_restarts_) {
+    SeekToRestartPoint(restart_index + 1);
+    ParseNextDataKey();
+  }
+  return true;
+}
+
 // Optimized Seek for point lookup for an internal key `target`
 // target = "seek_user_key @ type | seqno".
 //
@@ -256,7 +316,7 @@ bool DataBlockIter::SeekForGetImpl(const Slice& target) {
 
   if (entry == kCollision) {
     // HashSeek not effective, falling back
-    Seek(target);
+    BinarySeekImpl(target);
     return true;
   }
 
@@ -335,7 +395,7 @@ bool DataBlockIter::SeekForGetImpl(const Slice& target) {
       value_type != ValueType::kTypeDeletion &&
       value_type != ValueType::kTypeSingleDeletion &&
       value_type != ValueType::kTypeValueIndex) {
-    Seek(target);
+    BinarySeekImpl(target);
     return true;
   }
 
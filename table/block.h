@@ -477,6 +477,8 @@ class DataBlockIter final : public BlockIter<Slice> {
   }
 
   bool SeekForGetImpl(const Slice& target);
+  bool SeekByHashIndex(const Slice& target);
+  void BinarySeekImpl(const Slice& target);
 };
 
 class IndexBlockIter final : public BlockIter<BlockHandle> {
@@ -12,8 +12,11 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -32,6 +35,7 @@
 #include "table/block_based_table_factory.h"
 #include "table/block_based_table_reader.h"
 #include "table/block_builder.h"
+#include "table/columnar_block.h"
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "table/full_filter_block.h"
@@ -57,7 +61,7 @@ namespace {
 
 // Create a filter block builder based on its type.
 FilterBlockBuilder* CreateFilterBlockBuilder(
-    const ImmutableCFOptions& /*opt*/, const MutableCFOptions& mopt,
+    const ImmutableCFOptions& opt, const MutableCFOptions& mopt,
     const BlockBasedTableOptions& table_opt,
     const bool use_delta_encoding_for_index_values,
     PartitionedIndexBuilder* const p_index_builder) {
@@ -86,9 +90,13 @@ FilterBlockBuilder* CreateFilterBlockBuilder(
           filter_bits_builder, table_opt.index_block_restart_interval,
           use_delta_encoding_for_index_values, p_index_builder, partition_size);
     } else {
-      return new FullFilterBlockBuilder(mopt.prefix_extractor.get(),
-                                        table_opt.whole_key_filtering,
-                                        filter_bits_builder);
+      // Seeks compare the auto prefix with the upper bound bytewise
+      bool auto_prefix_filtering =
+          table_opt.auto_prefix_filtering &&
+          opt.user_comparator == BytewiseComparator();
+      return new FullFilterBlockBuilder(
+          mopt.prefix_extractor.get(), table_opt.whole_key_filtering,
+          filter_bits_builder, auto_prefix_filtering);
     }
   }
 }
@@ -241,6 +249,64 @@ class BlockBasedTableBuilder::BlockBasedTablePropertiesCollector
   bool prefix_filtering_;
 };
 
+// Compresses the data blocks on worker threads while Add() keeps filling the
+// next ones. The blocks are written in file order by the thread calling Add()
+// and Finish(), only that thread touches the file, the index and the
+// properties.
+struct BlockBasedTableBuilder::ParallelCompressionRep {
+  struct BlockRep {
+    std::string raw;
+    // The index entry of the block. The first key of the next block is known
+    // when that block is started, the last block has none.
+    std::string last_key;
+    std::string next_block_first_key;
+    bool has_next_block = false;
+
+    // Set by the worker, visible once compressed is set under the mutex
+    bool compressed = false;
+    Status status;
+    std::string columnar_output;
+    std::string compressed_output;
+    Slice contents;
+    CompressionType type = kNoCompression;
+  };
+
+  explicit ParallelCompressionRep(uint32_t num_threads)
+      : max_inflight_blocks(2 * num_threads) {}
+
+  ~ParallelCompressionRep() { Stop(); }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      shutdown = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) {
+      t.join();
+    }
+    workers.clear();
+  }
+
+  const size_t max_inflight_blocks;
+  std::mutex mutex;
+  // Signaled when a block is pending, compressed, or on shutdown
+  std::condition_variable cv;
+  // Not taken by a worker yet, guarded by mutex
+  std::deque<BlockRep*> pending;
+  bool shutdown = false;
+  std::vector<port::Thread> workers;
+
+  // The rest is only touched by the builder thread.
+  // Blocks not written yet, in file order
+  std::deque<std::unique_ptr<BlockRep>> inflight;
+  uint64_t inflight_raw_bytes = 0;
+  // Raw and written sizes of the blocks written so far, FileSize() counts
+  // the blocks in flight at that compression ratio
+  uint64_t written_raw_bytes = 0;
+  uint64_t written_bytes = 0;
+};
+
 struct BlockBasedTableBuilder::Rep {
   const ImmutableCFOptions ioptions;
   const MutableCFOptions moptions;
@@ -273,6 +339,10 @@ struct BlockBasedTableBuilder::Rep {
   BlockHandle pending_handle;  // Handle to add to index block
 
   std::string compressed_output;
+  // Leading value columns the data blocks are compressed by, and the buffer
+  // of the columnar block
+  std::vector<uint32_t> value_column_widths;
+  std::string columnar_output;
   std::unique_ptr<FlushBlockPolicy> flush_block_policy;
   uint32_t column_family_id;
   const std::string& column_family_name;
@@ -281,6 +351,9 @@ struct BlockBasedTableBuilder::Rep {
 
   std::vector<std::unique_ptr<IntTblPropCollector>> table_properties_collectors;
 
+  // Set when the data blocks are compressed in parallel
+  std::unique_ptr<ParallelCompressionRep> pc_rep;
+
   Rep(const TableBuilderOptions& builder_opt,
       const BlockBasedTableOptions& table_opt, uint32_t _column_family_id,
       WritableFileWriter* f)
@@ -345,12 +418,16 @@ struct BlockBasedTableBuilder::Rep {
       verify_ctx.reset(new UncompressionContext(UncompressionContext::NoCache(),
                                                 compression_ctx.type()));
     }
+    // Sanitized by the table factory
+    ParseValueColumnWidths(table_options.value_column_widths,
+                           &value_column_widths);
   }
 
   Rep(const Rep&) = delete;
   Rep& operator=(const Rep&) = delete;
 
-  ~Rep() {}
+  // The workers use the other members
+  ~Rep() { pc_rep.reset(); }
 };
 
 BlockBasedTableBuilder::BlockBasedTableBuilder(
@@ -372,6 +449,24 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
   rep_ =
       new Rep(builder_options, sanitized_table_options, column_family_id, file);
 
+  // The index entry of a block compressed in parallel is only added when it
+  // is written. The hash and the partitioned indexes, and the block based
+  // filters, follow the block boundaries as the keys are added, they keep
+  // compressing in the builder thread.
+  uint32_t parallel_threads = builder_options.compression_opts.parallel_threads;
+  if (parallel_threads > 1 && rep_->compression_ctx.type() != kNoCompression &&
+      sanitized_table_options.index_type ==
+          BlockBasedTableOptions::kBinarySearch &&
+      (rep_->filter_builder == nullptr ||
+       !rep_->filter_builder->IsBlockBased())) {
+    rep_->pc_rep.reset(new ParallelCompressionRep(parallel_threads));
+    for (uint32_t i = 0; i < parallel_threads; ++i) {
+      CompressionOptions compression_opts = builder_options.compression_opts;
+      rep_->pc_rep->workers.emplace_back(
+          [this, compression_opts] { CompressionWorker(compression_opts); });
+    }
+  }
+
   if (rep_->filter_builder != nullptr) {
     rep_->filter_builder->StartBlock(0);
   }
@@ -416,7 +511,15 @@ Status BlockBasedTableBuilder::Add(const Slice& key,
     // "the quick brown fox" and "the who".  We can use "the r" as the key for
     // the index block entry since it is >= all entries in the first block and
     // < all entries in subsequent blocks.
-    if (ok()) {
+    if (r->pc_rep != nullptr) {
+      // Added when the block is written
+      if (ok()) {
+        auto* block = r->pc_rep->inflight.back().get();
+        block->next_block_first_key.assign(key.data(), key.size());
+        block->has_next_block = true;
+        WriteCompressedDataBlocks(false /* finishing */);
+      }
+    } else if (ok()) {
       r->index_builder->AddIndexEntry(&r->last_key, &key, r->pending_handle);
     }
   }
@@ -472,7 +575,24 @@ void BlockBasedTableBuilder::Flush() {
   assert(!r->closed);
   if (!ok()) return;
   if (r->data_block.empty()) return;
-  WriteBlock(&r->data_block, &r->pending_handle, true /* is_data_block */);
+  if (r->pc_rep != nullptr) {
+    auto* pc = r->pc_rep.get();
+    std::unique_ptr<ParallelCompressionRep::BlockRep> block(
+        new ParallelCompressionRep::BlockRep);
+    Slice raw = r->data_block.Finish();
+    block->raw.assign(raw.data(), raw.size());
+    r->data_block.Reset();
+    block->last_key = r->last_key;
+    pc->inflight_raw_bytes += block->raw.size();
+    {
+      std::lock_guard<std::mutex> lock(pc->mutex);
+      pc->pending.push_back(block.get());
+    }
+    pc->inflight.push_back(std::move(block));
+    pc->cv.notify_all();
+  } else {
+    WriteBlock(&r->data_block, &r->pending_handle, true /* is_data_block */);
+  }
   if (r->filter_builder != nullptr) {
     r->filter_builder->StartBlock(r->offset);
   }
@@ -497,9 +617,42 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
   assert(ok());
   Rep* r = rep_;
 
-  auto type = r->compression_ctx.type();
   Slice block_contents;
+  CompressionType type;
+  Status s = CompressAndVerifyBlock(
+      raw_block_contents, is_data_block, &r->compression_ctx,
+      r->verify_ctx.get(), &r->columnar_output, &r->compressed_output,
+      &block_contents, &type);
+  if (!s.ok()) {
+    r->status = s;
+  }
+
+  WriteRawBlock(block_contents, type, handle, is_data_block);
+  r->compressed_output.clear();
+}
+
+Status BlockBasedTableBuilder::CompressAndVerifyBlock(
+    const Slice& raw_block_contents, bool is_data_block,
+    CompressionContext* compression_ctx, UncompressionContext* verify_ctx,
+    std::string* columnar_output, std::string* compressed_output,
+    Slice* block_contents, CompressionType* compression_type) const {
+  const Rep* r = rep_;
+  Status status;
+
+  auto type = compression_ctx->type();
   bool abort_compression = false;
+  // The columnar layout is only written compressed, an uncompressed block is
+  // read without restoring it
+  Slice compression_input = raw_block_contents;
+  bool columnar = false;
+  if (is_data_block && type != kNoCompression &&
+      !r->value_column_widths.empty() &&
+      raw_block_contents.size() < kCompressionSizeLimit &&
+      EncodeColumnarBlock(raw_block_contents, r->value_column_widths,
+                          columnar_output)) {
+    compression_input = *columnar_output;
+    columnar = true;
+  }
 
   StopWatchNano timer(
       r->ioptions.env,
@@ -508,23 +661,23 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
   if (raw_block_contents.size() < kCompressionSizeLimit) {
     Slice compression_dict;
     if (is_data_block && r->compression_dict && r->compression_dict->size()) {
-      r->compression_ctx.dict() = *r->compression_dict;
+      compression_ctx->dict() = *r->compression_dict;
       if (r->table_options.verify_compression) {
-        assert(r->verify_ctx != nullptr);
-        r->verify_ctx->dict() = *r->compression_dict;
+        assert(verify_ctx != nullptr);
+        verify_ctx->dict() = *r->compression_dict;
       }
     } else {
       // Clear dictionary
-      r->compression_ctx.dict() = Slice();
+      compression_ctx->dict() = Slice();
       if (r->table_options.verify_compression) {
-        assert(r->verify_ctx != nullptr);
-        r->verify_ctx->dict() = Slice();
+        assert(verify_ctx != nullptr);
+        verify_ctx->dict() = Slice();
       }
     }
 
-    block_contents =
-        CompressBlock(raw_block_contents, r->compression_ctx, &type,
-                      r->table_options.format_version, &r->compressed_output);
+    *block_contents =
+        CompressBlock(compression_input, *compression_ctx, &type,
+                      r->table_options.format_version, compressed_output);
 
     // Some of the compression algorithms are known to be unreliable. If
     // the verify_compression flag is set then try to de-compress the
@@ -533,22 +686,22 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
       // Retrieve the uncompressed contents into a new buffer
       BlockContents contents;
       Status stat = UncompressBlockContentsForCompressionType(
-          *r->verify_ctx, block_contents.data(), block_contents.size(),
+          *verify_ctx, block_contents->data(), block_contents->size(),
           &contents, r->table_options.format_version, r->ioptions);
 
       if (stat.ok()) {
-        bool compressed_ok = contents.data.compare(raw_block_contents) == 0;
+        bool compressed_ok = contents.data.compare(compression_input) == 0;
         if (!compressed_ok) {
           // The result of the compression was invalid. abort.
           abort_compression = true;
           ROCKS_LOG_ERROR(r->ioptions.info_log,
                           "Decompressed block did not match raw block");
-          r->status =
+          status =
               Status::Corruption("Decompressed block did not match raw block");
         }
       } else {
         // Decompression reported an error. abort.
-        r->status = Status::Corruption("Could not decompress");
+        status = Status::Corruption("Could not decompress");
         abort_compression = true;
       }
     }
@@ -562,8 +715,11 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
   if (abort_compression) {
     RecordTick(r->ioptions.statistics, NUMBER_BLOCK_NOT_COMPRESSED);
     type = kNoCompression;
-    block_contents = raw_block_contents;
-  } else if (type != kNoCompression) {
+    *block_contents = raw_block_contents;
+  } else if (type == kNoCompression) {
+    // Not compressed well enough, CompressBlock() handed the input back
+    *block_contents = raw_block_contents;
+  } else {
     if (ShouldReportDetailedTime(r->ioptions.env, r->ioptions.statistics)) {
       MeasureTime(r->ioptions.statistics, COMPRESSION_TIMES_NANOS,
                   timer.ElapsedNanos());
@@ -571,10 +727,82 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
     MeasureTime(r->ioptions.statistics, BYTES_COMPRESSED,
                 raw_block_contents.size());
     RecordTick(r->ioptions.statistics, NUMBER_BLOCK_COMPRESSED);
+    if (columnar) {
+      type = static_cast<CompressionType>(type | kColumnarBlockFlag);
+    }
   }
+  *compression_type = type;
+  return status;
+}
 
-  WriteRawBlock(block_contents, type, handle, is_data_block);
-  r->compressed_output.clear();
+void BlockBasedTableBuilder::CompressionWorker(
+    const CompressionOptions& compression_opts) {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc = r->pc_rep.get();
+  CompressionContext compression_ctx(r->compression_ctx.type(),
+                                     compression_opts);
+  std::unique_ptr<UncompressionContext> verify_ctx;
+  if (r->table_options.verify_compression) {
+    verify_ctx.reset(new UncompressionContext(UncompressionContext::NoCache(),
+                                              compression_ctx.type()));
+  }
+  std::unique_lock<std::mutex> lock(pc->mutex);
+  while (true) {
+    pc->cv.wait(lock, [pc] { return pc->shutdown || !pc->pending.empty(); });
+    if (pc->shutdown) {
+      return;
+    }
+    ParallelCompressionRep::BlockRep* block = pc->pending.front();
+    pc->pending.pop_front();
+    lock.unlock();
+    block->status = CompressAndVerifyBlock(
+        block->raw, true /* is_data_block */, &compression_ctx,
+        verify_ctx.get(), &block->columnar_output, &block->compressed_output,
+        &block->contents, &block->type);
+    lock.lock();
+    block->compressed = true;
+    pc->cv.notify_all();
+  }
+}
+
+void BlockBasedTableBuilder::WriteCompressedDataBlocks(bool finishing) {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc = r->pc_rep.get();
+  while (!pc->inflight.empty()) {
+    ParallelCompressionRep::BlockRep* block = pc->inflight.front().get();
+    if (!finishing && !block->has_next_block) {
+      break;
+    }
+    {
+      std::unique_lock<std::mutex> lock(pc->mutex);
+      if (!block->compressed) {
+        if (!finishing &&
+            pc->inflight.size() <= pc->max_inflight_blocks) {
+          break;
+        }
+        pc->cv.wait(lock, [block] { return block->compressed; });
+      }
+    }
+    if (ok() && !block->status.ok()) {
+      r->status = block->status;
+    }
+    if (ok()) {
+      BlockHandle handle;
+      WriteRawBlock(block->contents, block->type, &handle,
+                    true /* is_data_block */);
+      if (ok()) {
+        Slice next_block_first_key(block->next_block_first_key);
+        r->index_builder->AddIndexEntry(
+            &block->last_key,
+            block->has_next_block ? &next_block_first_key : nullptr, handle);
+      }
+      pc->written_raw_bytes += block->raw.size();
+      pc->written_bytes += block->contents.size() + kBlockTrailerSize;
+      r->props.data_size = r->offset;
+    }
+    pc->inflight_raw_bytes -= block->raw.size();
+    pc->inflight.pop_front();
+  }
 }
 
 void BlockBasedTableBuilder::WriteRawBlock(const Slice& block_contents,
@@ -622,6 +850,12 @@ void BlockBasedTableBuilder::WriteRawBlock(const Slice& block_contents,
         XXH64_freeState(state);
         break;
       }
+      case kXXH3:
+        EncodeFixed32(
+            trailer_without_type,
+            ComputeXXH3BlockChecksum(block_contents.data(),
+                                     block_contents.size(), trailer[0]));
+        break;
     }
 
     assert(r->status.ok());
@@ -841,6 +1075,13 @@ void BlockBasedTableBuilder::WritePropertiesBlock(
                                          rep_->ioptions.info_log,
                                          &property_block_builder);
 
+    // Add what the filter learned of the keys
+    if (rep_->filter_builder != nullptr) {
+      UserCollectedProperties filter_properties;
+      rep_->filter_builder->AddProperties(&filter_properties);
+      property_block_builder.Add(filter_properties);
+    }
+
     WriteRawBlock(property_block_builder.Finish(), kNoCompression,
                   &properties_block_handle);
   }
@@ -884,6 +1125,11 @@ Status BlockBasedTableBuilder::Finish(
   Flush();
   assert(!r->closed);
   r->closed = true;
+  if (r->pc_rep != nullptr) {
+    // Also adds the index entry of the last data block
+    WriteCompressedDataBlocks(true /* finishing */);
+    r->pc_rep->Stop();
+  }
 
   if (prop != nullptr) {
     r->props.purpose = prop->purpose;
@@ -900,7 +1146,7 @@ Status BlockBasedTableBuilder::Finish(
 
   // To make sure properties block is able to keep the accurate size of index
   // block, we will finish writing all index entries first.
-  if (ok() && !empty_data_block) {
+  if (ok() && !empty_data_block && r->pc_rep == nullptr) {
     r->index_builder->AddIndexEntry(
         &r->last_key, nullptr /* no next data block */, r->pending_handle);
   }
@@ -960,13 +1206,27 @@ void BlockBasedTableBuilder::Abandon() {
   Rep* r = rep_;
   assert(!r->closed);
   r->closed = true;
+  if (r->pc_rep != nullptr) {
+    r->pc_rep->Stop();
+  }
 }
 
 uint64_t BlockBasedTableBuilder::NumEntries() const {
   return rep_->props.num_entries;
 }
 
-uint64_t BlockBasedTableBuilder::FileSize() const { return rep_->offset; }
+uint64_t BlockBasedTableBuilder::FileSize() const {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc = r->pc_rep.get();
+  if (pc == nullptr || pc->inflight_raw_bytes == 0) {
+    return r->offset;
+  }
+  double ratio = pc->written_raw_bytes == 0
+                     ? 1.0
+                     : static_cast<double>(pc->written_bytes) /
+                           static_cast<double>(pc->written_raw_bytes);
+  return r->offset + static_cast<uint64_t>(pc->inflight_raw_bytes * ratio);
+}
 
 bool BlockBasedTableBuilder::NeedCompact() const {
   for (const auto& collector : rep_->table_properties_collectors) {
@@ -98,6 +98,24 @@ class BlockBasedTableBuilder : public TableBuilder {
   // Compress and write block content to the file.
   void WriteBlock(const Slice& block_contents, BlockHandle* handle,
                   bool is_data_block);
+  // Compress raw_block_contents into *block_contents and *type, the way
+  // WriteBlock() writes it. *block_contents points into raw_block_contents or
+  // the output buffers. Only reads rep_, the compression workers call it
+  // concurrently.
+  Status CompressAndVerifyBlock(const Slice& raw_block_contents,
+                                bool is_data_block,
+                                CompressionContext* compression_ctx,
+                                UncompressionContext* verify_ctx,
+                                std::string* columnar_output,
+                                std::string* compressed_output,
+                                Slice* block_contents,
+                                CompressionType* type) const;
+  // Body of a thread compressing data blocks in parallel
+  void CompressionWorker(const CompressionOptions& compression_opts);
+  // Write the data blocks compressed in parallel in file order, with their
+  // index entries. Waits for the oldest block when too many are in flight,
+  // or for all of them when finishing.
+  void WriteCompressedDataBlocks(bool finishing);
   // Directly write data to the file.
   void WriteRawBlock(const Slice& data, CompressionType, BlockHandle* handle,
                      bool is_data_block = false);
@@ -113,6 +131,7 @@ class BlockBasedTableBuilder : public TableBuilder {
   void WriteRangeDelBlock(MetaIndexBuilder* meta_index_builder);
 
   struct Rep;
+  struct ParallelCompressionRep;
   class BlockBasedTablePropertiesCollectorFactory;
   class BlockBasedTablePropertiesCollector;
   Rep* rep_;
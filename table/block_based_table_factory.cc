@@ -27,7 +27,9 @@
 #include "rocksdb/terark_namespace.h"
 #include "table/block_based_table_builder.h"
 #include "table/block_based_table_reader.h"
+#include "table/columnar_block.h"
 #include "table/format.h"
+#include "util/compression.h"
 #include "util/mutexlock.h"
 #include "util/string_util.h"
 
@@ -259,6 +261,12 @@ Status BlockBasedTableFactory::SanitizeOptions(
         "data_block_hash_table_util_ratio should be greater than 0 when "
         "data_block_index_type is set to kDataBlockBinaryAndHash");
   }
+  std::vector<uint32_t> value_column_widths;
+  Status s = ParseValueColumnWidths(table_options_.value_column_widths,
+                                    &value_column_widths);
+  if (!s.ok()) {
+    return s;
+  }
   return Status::OK();
 }
 
@@ -324,6 +332,11 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
     ret.append("  block_cache_compressed_options:\n");
     ret.append(table_options_.block_cache_compressed->GetPrintableOptions());
   }
+  snprintf(buffer, kBufferSize, "  block_cache_compressed_compression: %s\n",
+           CompressionTypeToString(
+               table_options_.block_cache_compressed_compression)
+               .c_str());
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  persistent_cache: %p\n",
            static_cast<void*>(table_options_.persistent_cache.get()));
   ret.append(buffer);
@@ -361,6 +374,9 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  whole_key_filtering: %d\n",
            table_options_.whole_key_filtering);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  auto_prefix_filtering: %d\n",
+           table_options_.auto_prefix_filtering);
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  verify_compression: %d\n",
            table_options_.verify_compression);
   ret.append(buffer);
@@ -376,6 +392,9 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  block_align: %d\n",
            table_options_.block_align);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  value_column_widths: %s\n",
+           table_options_.value_column_widths.c_str());
+  ret.append(buffer);
   return ret;
 }
 
@@ -473,6 +492,13 @@ std::string ParseBlockBasedTableOption(const std::string& name,
     } else if (name == "filter_policy") {
       // Expect the following format
       // bloomfilter:int:bool
+      // xorfilter:int
+      const std::string kXorName = "xorfilter:";
+      if (value.compare(0, kXorName.size(), kXorName) == 0) {
+        int bits_per_key = ParseInt(trim(value.substr(kXorName.size())));
+        new_options->filter_policy.reset(NewXorFilterPolicy(bits_per_key));
+        return "";
+      }
       const std::string kName = "bloomfilter:";
       if (value.compare(0, kName.size(), kName) != 0) {
         return "Invalid filter policy name";
@@ -604,6 +630,10 @@ const std::string BlockBasedTablePropertyNames::kWholeKeyFiltering =
     "rocksdb.block.based.table.whole.key.filtering";
 const std::string BlockBasedTablePropertyNames::kPrefixFiltering =
     "rocksdb.block.based.table.prefix.filtering";
+const std::string BlockBasedTablePropertyNames::kAutoPrefixLength =
+    "rocksdb.block.based.table.auto.prefix.length";
+const std::string BlockBasedTablePropertyNames::kKeyPrefixLengthHistogram =
+    "rocksdb.block.based.table.key.prefix.length.histogram";
 const std::string kHashIndexPrefixesBlock = "rocksdb.hashindex.prefixes";
 const std::string kHashIndexPrefixesMetadataBlock =
     "rocksdb.hashindex.metadata";
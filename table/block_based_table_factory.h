@@ -132,6 +132,11 @@ static std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct BlockBasedTableOptions,
                    data_block_hash_table_util_ratio),
           OptionType::kDouble, OptionVerificationType::kNormal, false, 0}},
+        {"block_cache_compressed_compression",
+         {offsetof(struct BlockBasedTableOptions,
+                   block_cache_compressed_compression),
+          OptionType::kCompressionType, OptionVerificationType::kNormal,
+          false, 0}},
         {"checksum",
          {offsetof(struct BlockBasedTableOptions, checksum),
           OptionType::kChecksumType, OptionVerificationType::kNormal, false,
@@ -167,6 +172,9 @@ static std::unordered_map<std::string, OptionTypeInfo>
         {"whole_key_filtering",
          {offsetof(struct BlockBasedTableOptions, whole_key_filtering),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"auto_prefix_filtering",
+         {offsetof(struct BlockBasedTableOptions, auto_prefix_filtering),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"skip_table_builder_flush",
          {0, OptionType::kBoolean, OptionVerificationType::kDeprecated, false,
           0}},
@@ -185,6 +193,9 @@ static std::unordered_map<std::string, OptionTypeInfo>
         {"block_align",
          {offsetof(struct BlockBasedTableOptions, block_align),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"value_column_widths",
+         {offsetof(struct BlockBasedTableOptions, value_column_widths),
+          OptionType::kString, OptionVerificationType::kNormal, false, 0}},
         {"pin_top_level_index_and_filter",
          {offsetof(struct BlockBasedTableOptions,
                    pin_top_level_index_and_filter),
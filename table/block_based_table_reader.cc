@@ -29,6 +29,7 @@
 #include "rocksdb/terark_namespace.h"
 #include "table/block.h"
 #include "table/block_based_filter_block.h"
+#include "table/block_based_table_builder.h"
 #include "table/block_based_table_factory.h"
 #include "table/block_fetcher.h"
 #include "table/block_prefix_index.h"
@@ -75,7 +76,8 @@ Status ReadBlockFromFile(
     RandomAccessFileReader* file, FilePrefetchBuffer* prefetch_buffer,
     const Footer& footer, const ReadOptions& options, const BlockHandle& handle,
     std::unique_ptr<Block>* result, const ImmutableCFOptions& ioptions,
-    bool do_uncompress, bool maybe_compressed, const Slice& compression_dict,
+    bool do_uncompress, bool maybe_compressed,
+    const UncompressionDict& compression_dict,
     const PersistentCacheOptions& cache_options, SequenceNumber global_seqno,
     size_t read_amp_bytes_per_bit, MemoryAllocator* memory_allocator) {
   BlockContents contents;
@@ -184,19 +186,17 @@ Cache::Handle* GetEntryFromCache(Cache* block_cache, const Slice& key,
 // For hash based index, return true if prefix_extractor and
 // prefix_extractor_block mismatch, false otherwise. This flag will be used
 // as total_order_seek via NewIndexIterator
-bool PrefixExtractorChanged(const TablePropertiesBase* table_properties_base,
+bool PrefixExtractorChanged(const std::string& table_prefix_extractor_name,
                             const SliceTransform* prefix_extractor) {
   // BlockBasedTableOptions::kHashSearch requires prefix_extractor to be set.
   // Turn off hash index in prefix_extractor is not set; if  prefix_extractor
   // is set but prefix_extractor_block is not set, also disable hash index
-  if (prefix_extractor == nullptr || table_properties_base == nullptr ||
-      table_properties_base->prefix_extractor_name.empty()) {
+  if (prefix_extractor == nullptr || table_prefix_extractor_name.empty()) {
     return true;
   }
 
   // prefix_extractor and prefix_extractor_block are both non-empty
-  if (table_properties_base->prefix_extractor_name.compare(
-          prefix_extractor->Name()) != 0) {
+  if (table_prefix_extractor_name.compare(prefix_extractor->Name()) != 0) {
     return true;
   } else {
     return false;
@@ -226,7 +226,8 @@ class PartitionIndexReader : public IndexReader, public Cleanable {
     auto s = ReadBlockFromFile(
         file, prefetch_buffer, footer, ReadOptions(), index_handle,
         &index_block, ioptions, true /* decompress */,
-        true /*maybe_compressed*/, Slice() /*compression dict*/, cache_options,
+        true /*maybe_compressed*/,
+        UncompressionDict::GetEmptyDict() /*compression dict*/, cache_options,
         kDisableGlobalSequenceNumber, 0 /* read_amp_bytes_per_bit */,
         memory_allocator);
 
@@ -318,10 +319,7 @@ class PartitionIndexReader : public IndexReader, public Cleanable {
     for (; biter.Valid(); biter.Next()) {
       handle = biter.value();
       BlockBasedTable::CachableEntry<Block> block;
-      Slice compression_dict;
-      if (rep->compression_dict_block) {
-        compression_dict = rep->compression_dict_block->data;
-      }
+      const UncompressionDict& compression_dict = rep->get_uncompression_dict();
       const bool is_index = true;
       // TODO: Support counter batch update for partitioned index and
       // filter blocks
@@ -407,7 +405,8 @@ class BinarySearchIndexReader : public IndexReader {
     auto s = ReadBlockFromFile(
         file, prefetch_buffer, footer, ReadOptions(), index_handle,
         &index_block, ioptions, true /* decompress */,
-        true /*maybe_compressed*/, Slice() /*compression dict*/, cache_options,
+        true /*maybe_compressed*/,
+        UncompressionDict::GetEmptyDict() /*compression dict*/, cache_options,
         kDisableGlobalSequenceNumber, 0 /* read_amp_bytes_per_bit */,
         memory_allocator);
 
@@ -481,7 +480,8 @@ class HashIndexReader : public IndexReader {
     auto s = ReadBlockFromFile(
         file, prefetch_buffer, footer, ReadOptions(), index_handle,
         &index_block, ioptions, true /* decompress */,
-        true /*maybe_compressed*/, Slice() /*compression dict*/, cache_options,
+        true /*maybe_compressed*/,
+        UncompressionDict::GetEmptyDict() /*compression dict*/, cache_options,
         kDisableGlobalSequenceNumber, 0 /* read_amp_bytes_per_bit */,
         memory_allocator);
 
@@ -516,7 +516,8 @@ class HashIndexReader : public IndexReader {
       return Status::OK();
     }
 
-    Slice dummy_comp_dict;
+    const UncompressionDict& dummy_comp_dict =
+        UncompressionDict::GetEmptyDict();
     // Read contents for the blocks
     BlockContents prefixes_contents;
     BlockFetcher prefixes_block_fetcher(
@@ -911,7 +912,7 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
       assert(table_properties != nullptr);
       rep->table_properties.reset(table_properties);
       rep->blocks_maybe_compressed =
-          rep->table_properties_base.compression_name !=
+          table_properties->compression_name !=
           CompressionTypeToString(kNoCompression);
     }
   } else {
@@ -925,8 +926,23 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
   }
 #endif  // ROCKSDB_LITE
   if (rep->table_properties) {
-    rep->found_table_properties = true;
-    rep->table_properties_base = *rep->table_properties;
+    auto& hot = rep->hot_properties;
+    hot.index_key_is_user_key = rep->table_properties->index_key_is_user_key;
+    hot.index_value_is_delta_encoded =
+        rep->table_properties->index_value_is_delta_encoded;
+    hot.prefix_extractor_name =
+        InternTablePropertyString(rep->table_properties->prefix_extractor_name);
+    if (rep->filter_type == Rep::FilterType::kFullFilter) {
+      auto& props = rep->table_properties->user_collected_properties;
+      auto pos = props.find(BlockBasedTablePropertyNames::kAutoPrefixLength);
+      if (pos != props.end()) {
+        Slice input(pos->second);
+        uint64_t auto_prefix_length = 0;
+        if (GetVarint64(&input, &auto_prefix_length)) {
+          hot.auto_prefix_length = static_cast<size_t>(auto_prefix_length);
+        }
+      }
+    }
   }
 
   // Read the compression dictionary meta block
@@ -950,7 +966,7 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
         rep->file.get(), prefetch_buffer.get(), rep->footer, read_options,
         compression_dict_handle, compression_dict_cont.get(), rep->ioptions,
         false /* decompress */, false /*maybe_compressed*/,
-        Slice() /*compression dict*/, cache_options);
+        UncompressionDict::GetEmptyDict() /*compression dict*/, cache_options);
     s = compression_block_fetcher.ReadBlockContents();
 
     if (!s.ok()) {
@@ -961,6 +977,14 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
           s.ToString().c_str());
     } else {
       rep->compression_dict_block = std::move(compression_dict_cont);
+      bool using_zstd =
+          rep->table_properties != nullptr &&
+          (rep->table_properties->compression_name ==
+               CompressionTypeToString(kZSTD) ||
+           rep->table_properties->compression_name ==
+               CompressionTypeToString(kZSTDNotFinalCompression));
+      rep->uncompression_dict.reset(new UncompressionDict(
+          rep->compression_dict_block->data, using_zstd));
     }
   }
 
@@ -1014,7 +1038,8 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
   }
 
   bool need_upper_bound_check =
-      PrefixExtractorChanged(rep->table_properties.get(), prefix_extractor);
+      PrefixExtractorChanged(*rep->hot_properties.prefix_extractor_name,
+                             prefix_extractor);
 
   BlockBasedTableOptions::IndexType index_type = rep->index_type =
       GetIndexType(rep->table_properties.get());
@@ -1193,6 +1218,16 @@ size_t BlockBasedTable::ApproximateMemoryUsage() const {
   return usage;
 }
 
+size_t BlockBasedTable::ApproximateIndexMemoryUsage() const {
+  return rep_->index_reader ? rep_->index_reader->ApproximateMemoryUsage() : 0;
+}
+
+size_t BlockBasedTable::ApproximateDictMemoryUsage() const {
+  return rep_->compression_dict_block
+             ? rep_->compression_dict_block->data.size()
+             : 0;
+}
+
 uint64_t BlockBasedTable::FileNumber() const { return rep_->file_number; }
 
 // Load the meta-block from the file. On success, return the loaded meta block
@@ -1208,7 +1243,8 @@ Status BlockBasedTable::ReadMetaBlock(
       rep->file.get(), prefetch_buffer, rep->footer, ReadOptions(),
       rep->footer.metaindex_handle(), &meta, rep->ioptions,
       true /* decompress */, true /*maybe_compressed*/,
-      Slice() /*compression dict*/, rep->persistent_cache_options,
+      UncompressionDict::GetEmptyDict() /*compression dict*/,
+      rep->persistent_cache_options,
       kDisableGlobalSequenceNumber, 0 /* read_amp_bytes_per_bit */,
       GetMemoryAllocator(rep->table_options));
 
@@ -1231,8 +1267,9 @@ Status BlockBasedTable::GetDataBlockFromCache(
     const Slice& block_cache_key, const Slice& compressed_block_cache_key,
     Cache* block_cache, Cache* block_cache_compressed, Rep* rep,
     const ReadOptions& read_options,
-    BlockBasedTable::CachableEntry<Block>* block, const Slice& compression_dict,
-    size_t read_amp_bytes_per_bit, bool is_index, GetContext* get_context) {
+    BlockBasedTable::CachableEntry<Block>* block,
+    const UncompressionDict& compression_dict, size_t read_amp_bytes_per_bit,
+    bool is_index, GetContext* get_context) {
   Status s;
   BlockContents* compressed_block = nullptr;
   Cache::Handle* block_cache_compressed_handle = nullptr;
@@ -1353,7 +1390,7 @@ Status BlockBasedTable::PutDataBlockToCache(
     const ReadOptions& /*read_options*/, const ImmutableCFOptions& ioptions,
     CachableEntry<Block>* cached_block, BlockContents* raw_block_contents,
     CompressionType raw_block_comp_type, uint32_t format_version,
-    const Slice& compression_dict, SequenceNumber seq_no,
+    const UncompressionDict& compression_dict, SequenceNumber seq_no,
     size_t read_amp_bytes_per_bit, MemoryAllocator* memory_allocator,
     bool is_index, Cache::Priority priority, GetContext* get_context) {
   assert(raw_block_comp_type == kNoCompression ||
@@ -1471,7 +1508,7 @@ FilterBlockReader* BlockBasedTable::ReadFilter(
   }
   BlockContents block;
 
-  Slice dummy_comp_dict;
+  const UncompressionDict& dummy_comp_dict = UncompressionDict::GetEmptyDict();
 
   BlockFetcher block_fetcher(
       rep->file.get(), prefetch_buffer, rep->footer, ReadOptions(),
@@ -1499,10 +1536,8 @@ FilterBlockReader* BlockBasedTable::ReadFilter(
           rep->prefix_filtering ? prefix_extractor : nullptr,
           rep->whole_key_filtering, std::move(block), nullptr,
           rep->ioptions.statistics, rep->internal_comparator, this,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_key_is_user_key == 0,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_value_is_delta_encoded == 0);
+          !rep_->hot_properties.index_key_is_user_key,
+          !rep_->hot_properties.index_value_is_delta_encoded);
     }
 
     case Rep::FilterType::kBlockFilter:
@@ -1748,10 +1783,11 @@ TBlockIter* BlockBasedTable::NewDataBlockIterator(
   const bool no_io = (ro.read_tier == kBlockCacheTier);
   Cache* block_cache = rep->table_options.block_cache.get();
   CachableEntry<Block> block;
-  Slice compression_dict;
+  const UncompressionDict& compression_dict = rep->get_uncompression_dict();
   if (s.ok()) {
-    if (rep->compression_dict_block) {
-      compression_dict = rep->compression_dict_block->data;
+    if (!is_index && rep->ioptions.hot_key_tracker) {
+      rep->ioptions.hot_key_tracker->RecordBlock(rep->file_number,
+                                                 handle.offset());
     }
     s = MaybeReadBlockAndLoadToCache(prefetch_buffer, rep, ro, handle,
                                      compression_dict, &block, is_index,
@@ -1849,9 +1885,48 @@ TBlockIter* BlockBasedTable::NewDataBlockIterator(
   return iter;
 }
 
+void BlockBasedTable::PutRecompressedBlockToCache(
+    const Slice& compressed_block_cache_key, Cache* block_cache_compressed,
+    Rep* rep, const Slice& raw, const Slice& compression_dict) {
+  Statistics* statistics = rep->ioptions.statistics;
+  CompressionContext compression_ctx(
+      rep->table_options.block_cache_compressed_compression,
+      CompressionOptions(), compression_dict);
+  CompressionType type;
+  std::string compressed_output;
+  Slice compressed =
+      CompressBlock(raw, compression_ctx, &type,
+                    rep->table_options.format_version, &compressed_output);
+  if (type == kNoCompression) {
+    // Not worth the space, the block lives in block_cache only
+    return;
+  }
+  // Same layout as a raw block read from the file, the compression type
+  // follows the data
+  CacheAllocationPtr ubuf = AllocateBlock(
+      compressed.size() + 1, GetMemoryAllocator(rep->table_options));
+  memcpy(ubuf.get(), compressed.data(), compressed.size());
+  ubuf.get()[compressed.size()] = static_cast<char>(type);
+  BlockContents* block_cont_for_comp_cache =
+      new BlockContents(std::move(ubuf), compressed.size());
+#ifndef NDEBUG
+  block_cont_for_comp_cache->is_raw_block = true;
+#endif  // NDEBUG
+  Status s = block_cache_compressed->Insert(
+      compressed_block_cache_key, block_cont_for_comp_cache,
+      block_cont_for_comp_cache->ApproximateMemoryUsage(),
+      &DeleteCachedEntry<BlockContents>);
+  if (s.ok()) {
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_ADD);
+  } else {
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_ADD_FAILURES);
+    delete block_cont_for_comp_cache;
+  }
+}
+
 Status BlockBasedTable::MaybeReadBlockAndLoadToCache(
     FilePrefetchBuffer* prefetch_buffer, Rep* rep, const ReadOptions& ro,
-    const BlockHandle& handle, Slice compression_dict,
+    const BlockHandle& handle, const UncompressionDict& compression_dict,
     CachableEntry<Block>* block_entry, bool is_index, GetContext* get_context) {
   assert(block_entry != nullptr);
   const bool no_io = (ro.read_tier == kBlockCacheTier);
@@ -1909,6 +1984,15 @@ Status BlockBasedTable::MaybeReadBlockAndLoadToCache(
         raw_block_comp_type = block_fetcher.get_compression_type();
       }
 
+      if (s.ok() && raw_block_comp_type == kNoCompression &&
+          block_cache_compressed != nullptr &&
+          rep->table_options.block_cache_compressed_compression !=
+              kNoCompression) {
+        // Keep a compressed copy of the uncompressed block as second tier
+        PutRecompressedBlockToCache(ckey, block_cache_compressed, rep,
+                                    raw_block_contents.data,
+                                    compression_dict.dict());
+      }
       if (s.ok()) {
         SequenceNumber seq_no = rep->get_global_seqno(is_index);
         // If filling cache is allowed and a cache is configured, try to put the
@@ -2053,8 +2137,7 @@ bool BlockBasedTable::PrefixMayMatch(
         // and we're not really sure that we're past the end
         // of the file
         may_match = iiter->status().IsIncomplete();
-      } else if ((rep_->found_table_properties &&
-                          rep_->table_properties_base.index_key_is_user_key
+      } else if ((rep_->hot_properties.index_key_is_user_key
                       ? iiter->key()
                       : ExtractUserKey(iiter->key()))
                      .starts_with(ExtractUserKey(internal_prefix))) {
@@ -2099,11 +2182,58 @@ bool BlockBasedTable::PrefixMayMatch(
   return may_match;
 }
 
+bool BlockBasedTable::AutoPrefixMayMatch(const Slice& internal_key,
+                                         const ReadOptions& read_options) {
+  size_t prefix_length = rep_->hot_properties.auto_prefix_length;
+  const Slice* upper_bound = read_options.iterate_upper_bound;
+  if (prefix_length == 0 || !rep_->filter_policy ||
+      read_options.total_order_seek || upper_bound == nullptr) {
+    return true;
+  }
+  Slice user_key = ExtractUserKey(internal_key);
+  if (user_key.size() < prefix_length) {
+    return true;
+  }
+  // The keys in [user_key, upper_bound) all start with the prefix when the
+  // bound does not pass the smallest key after the prefix
+  Slice prefix(user_key.data(), prefix_length);
+  std::string prefix_successor = prefix.ToString();
+  while (!prefix_successor.empty() &&
+         static_cast<unsigned char>(prefix_successor.back()) == 0xff) {
+    prefix_successor.pop_back();
+  }
+  if (prefix_successor.empty()) {
+    return true;
+  }
+  prefix_successor.back() = static_cast<char>(
+      static_cast<unsigned char>(prefix_successor.back()) + 1);
+  if (upper_bound->compare(prefix_successor) > 0) {
+    return true;
+  }
+
+  bool may_match = true;
+  auto filter_entry = GetFilter();
+  FilterBlockReader* filter = filter_entry.value;
+  if (filter != nullptr && !filter->IsBlockBased()) {
+    may_match = filter->PrefixMayMatch(prefix, nullptr, kNotValid, false,
+                                       &internal_key);
+    Statistics* statistics = rep_->ioptions.statistics;
+    RecordTick(statistics, BLOOM_FILTER_PREFIX_CHECKED);
+    if (!may_match) {
+      RecordTick(statistics, BLOOM_FILTER_PREFIX_USEFUL);
+    }
+  }
+  if (!rep_->filter_entry.IsSet()) {
+    filter_entry.Release(rep_->table_options.block_cache.get());
+  }
+  return may_match;
+}
+
 template <class TBlockIter, typename TValue>
 void BlockBasedTableIteratorBase<TBlockIter, TValue>::Seek(
     const Slice& target) {
   is_out_of_bound_ = false;
-  if (!CheckPrefixMayMatch(target)) {
+  if (!CheckPrefixMayMatch(target) || !CheckAutoPrefixMayMatch(target)) {
     ResetDataIter();
     return;
   }
@@ -2234,7 +2364,10 @@ void BlockBasedTableIteratorBase<TBlockIter, TValue>::InitDataBlock() {
     if (!for_compaction_ && read_options_.readahead_size == 0) {
       num_file_reads_++;
       if (num_file_reads_ > 2) {
-        if (!rep->file->use_direct_io() &&
+        if (read_options_.async_prefetch_depth > 0 &&
+            !rep->file->use_direct_io()) {
+          AsyncPrefetch(data_block_handle);
+        } else if (!rep->file->use_direct_io() &&
             (data_block_handle.offset() +
                  static_cast<size_t>(data_block_handle.size()) +
                  kBlockTrailerSize >
@@ -2266,6 +2399,84 @@ void BlockBasedTableIteratorBase<TBlockIter, TValue>::InitDataBlock() {
   }
 }
 
+template <class TBlockIter, typename TValue>
+void BlockBasedTableIteratorBase<TBlockIter, TValue>::AsyncPrefetch(
+    const BlockHandle& data_block_handle) {
+  const uint64_t offset = data_block_handle.offset();
+  if (offset >= prefetch_start_ && offset < prefetch_trigger_) {
+    // At least half of the window is still ahead
+    return;
+  }
+  auto* rep = table_->get_rep();
+  const size_t depth = read_options_.async_prefetch_depth;
+  // Bytes below prefetch_limit_ were hinted by the previous window, unless
+  // the iterator moved backward
+  const uint64_t hinted = offset >= prefetch_start_ ? prefetch_limit_ : 0;
+  uint64_t run_offset = 0;
+  uint64_t run_end = 0;
+  uint64_t limit = 0;
+  uint64_t trigger = port::kMaxUint64;
+  size_t steps = 0;
+  auto hint = [&] {
+    size_t n = static_cast<size_t>(run_end - run_offset);
+    TEST_SYNC_POINT_CALLBACK("BlockBasedTableIterator:AsyncPrefetch", &n);
+    // Discarding the return status intentionally, the block is read from
+    // disk anyway if the hint fails.
+    rep->file->Prefetch(run_offset, n);
+  };
+  BlockHandle handle = data_block_handle;
+  for (size_t i = 0;;) {
+    uint64_t end = handle.offset() + handle.size() + kBlockTrailerSize;
+    if (i == depth / 2) {
+      trigger = handle.offset();
+    }
+    if (end > hinted) {
+      uint64_t begin = std::max(handle.offset(), hinted);
+      if (begin != run_end) {
+        // Not adjacent to the pending run
+        if (run_end > run_offset) {
+          hint();
+        }
+        run_offset = begin;
+      }
+      run_end = end;
+    }
+    limit = end;
+    // The index key is not less than the keys of its block, so the blocks
+    // after the first one reaching the upper bound are never read
+    if (++i == depth ||
+        (read_options_.iterate_upper_bound != nullptr &&
+         icomp_.user_comparator()->Compare(
+             key_includes_seq_ ? ExtractUserKey(index_iter_->key())
+                               : index_iter_->key(),
+             *read_options_.iterate_upper_bound) >= 0)) {
+      break;
+    }
+    index_iter_->Next();
+    ++steps;
+    if (!index_iter_->Valid()) {
+      break;
+    }
+    handle = index_iter_->value();
+  }
+  if (run_end > run_offset) {
+    hint();
+  }
+  prefetch_start_ = offset;
+  prefetch_limit_ = std::max(limit, hinted);
+  prefetch_trigger_ = std::min(trigger, limit);
+
+  // Move the index iterator back to the current block
+  if (steps > 0 && !index_iter_->Valid()) {
+    index_iter_->SeekToLast();
+    --steps;
+  }
+  for (; steps > 0; --steps) {
+    index_iter_->Prev();
+  }
+  assert(index_iter_->Valid());
+}
+
 template <class TBlockIter, typename TValue>
 void BlockBasedTableIteratorBase<TBlockIter, TValue>::FindKeyForward() {
   assert(!is_out_of_bound_);
@@ -2333,7 +2544,8 @@ InternalIterator* BlockBasedTable::NewIterator(
     const ReadOptions& read_options, const SliceTransform* prefix_extractor,
     Arena* arena, bool skip_filters, bool for_compaction) {
   bool need_upper_bound_check =
-      PrefixExtractorChanged(&rep_->table_properties_base, prefix_extractor);
+      PrefixExtractorChanged(*rep_->hot_properties.prefix_extractor_name,
+                             prefix_extractor);
   const bool kIsNotIndex = false;
   if (arena == nullptr) {
     return new BlockBasedTableIterator<DataBlockIter, LazyBuffer>(
@@ -2386,7 +2598,7 @@ bool BlockBasedTable::FullFilterKeyMayMatch(
     may_match = filter->KeyMayMatch(user_key, prefix_extractor, kNotValid,
                                     no_io, const_ikey_ptr);
   } else if (!read_options.total_order_seek && prefix_extractor &&
-             rep_->table_properties_base.prefix_extractor_name.compare(
+             rep_->hot_properties.prefix_extractor_name->compare(
                  prefix_extractor->Name()) == 0 &&
              prefix_extractor->InDomain(user_key) &&
              !filter->PrefixMayMatch(prefix_extractor->Transform(user_key),
@@ -2401,6 +2613,37 @@ bool BlockBasedTable::FullFilterKeyMayMatch(
   return may_match;
 }
 
+namespace {
+// Values of point lookups, context->data[0] is the DataBlockIter
+class DataBlockIterLazyBufferState : public LazyBufferState {
+ public:
+  virtual void destroy(LazyBuffer* /*buffer*/) const override {}
+
+  virtual Status pin_buffer(LazyBuffer* buffer) const override {
+    if (buffer->size() <= sizeof(LazyBufferContext)) {
+      buffer->reset(buffer->slice(), true, buffer->file_number());
+      return Status::OK();
+    }
+    auto context = get_context(buffer);
+    DataBlockIter* iter = reinterpret_cast<DataBlockIter*>(context->data[0]);
+    assert(iter != nullptr);
+    Cleanable release_cached_entry = iter->RefCache();
+    if (release_cached_entry.Empty()) {
+      return Status::NotSupported();
+    }
+    buffer->reset(buffer->slice(), std::move(release_cached_entry),
+                  buffer->file_number());
+    return Status::OK();
+  }
+
+  Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
+    return Status::OK();
+  }
+};
+
+DataBlockIterLazyBufferState data_block_iter_lazy_buffer_state;
+}  // namespace
+
 Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
                             GetContext* get_context,
                             const SliceTransform* prefix_extractor,
@@ -2429,7 +2672,7 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
     bool need_upper_bound_check = false;
     if (rep_->index_type == BlockBasedTableOptions::kHashSearch) {
       need_upper_bound_check = PrefixExtractorChanged(
-          &rep_->table_properties_base, prefix_extractor);
+          *rep_->hot_properties.prefix_extractor_name, prefix_extractor);
     }
     auto iiter =
         NewIndexIterator(read_options, need_upper_bound_check, &iiter_on_stack,
@@ -2484,34 +2727,6 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
           break;
         }
 
-        class LazyBufferStateImpl : public LazyBufferState {
-         public:
-          virtual void destroy(LazyBuffer* /*buffer*/) const override {}
-
-          virtual Status pin_buffer(LazyBuffer* buffer) const override {
-            if (buffer->size() <= sizeof(LazyBufferContext)) {
-              buffer->reset(buffer->slice(), true, buffer->file_number());
-              return Status::OK();
-            }
-            auto context = get_context(buffer);
-            DataBlockIter* iter =
-                reinterpret_cast<DataBlockIter*>(context->data[0]);
-            assert(iter != nullptr);
-            Cleanable release_cached_entry = iter->RefCache();
-            if (release_cached_entry.Empty()) {
-              return Status::NotSupported();
-            }
-            buffer->reset(buffer->slice(), std::move(release_cached_entry),
-                          buffer->file_number());
-            return Status::OK();
-          }
-
-          Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
-            return Status::OK();
-          }
-        };
-        static LazyBufferStateImpl static_state;
-
         // Call the *saver function on each entry/block until it returns false
         for (; biter.Valid(); biter.Next()) {
           ParsedInternalKey parsed_key;
@@ -2521,7 +2736,7 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
 
           if (!get_context->SaveValue(
                   parsed_key,
-                  LazyBuffer(&static_state,
+                  LazyBuffer(&data_block_iter_lazy_buffer_state,
                              {reinterpret_cast<uint64_t>(&biter)},
                              biter.value(), rep_->file_number),
                   &matched)) {
@@ -2555,6 +2770,136 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
   return s;
 }
 
+void BlockBasedTable::MultiGet(const ReadOptions& read_options,
+                               size_t num_keys, const Slice* keys,
+                               GetContext** get_contexts, Status* statuses,
+                               const SliceTransform* prefix_extractor,
+                               bool skip_filters) {
+  if (num_keys == 0) {
+    return;
+  }
+  const bool no_io = read_options.read_tier == kBlockCacheTier;
+  CachableEntry<FilterBlockReader> filter_entry;
+  if (!skip_filters) {
+    filter_entry =
+        GetFilter(prefix_extractor, /*prefetch_buffer*/ nullptr, no_io,
+                  get_contexts[0]);
+  }
+  FilterBlockReader* filter = filter_entry.value;
+
+  // Probe the full filter for the whole batch first, while it is hot
+  autovector<size_t, 64> candidates;
+  for (size_t i = 0; i < num_keys; ++i) {
+    assert(keys[i].size() >= 8);  // key must be internal key
+    statuses[i] = Status::OK();
+    if (FullFilterKeyMayMatch(read_options, filter, keys[i], no_io,
+                              prefix_extractor)) {
+      candidates.push_back(i);
+    } else {
+      RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+      PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_useful, 1, rep_->level);
+    }
+  }
+
+  if (!candidates.empty()) {
+    IndexBlockIter iiter_on_stack;
+    bool need_upper_bound_check = false;
+    if (rep_->index_type == BlockBasedTableOptions::kHashSearch) {
+      need_upper_bound_check = PrefixExtractorChanged(
+          *rep_->hot_properties.prefix_extractor_name, prefix_extractor);
+    }
+    auto iiter = NewIndexIterator(read_options, need_upper_bound_check,
+                                  &iiter_on_stack, /* index_entry */ nullptr,
+                                  get_contexts[candidates[0]]);
+    std::unique_ptr<InternalIteratorBase<BlockHandle>> iiter_unique_ptr;
+    if (iiter != &iiter_on_stack) {
+      iiter_unique_ptr.reset(iiter);
+    }
+
+    // Keys sharing a data block search the block read for the first of them
+    DataBlockIter biter;
+    bool biter_loaded = false;
+    uint64_t biter_offset = 0;
+    for (size_t i : candidates) {
+      const Slice& key = keys[i];
+      GetContext* get_context = get_contexts[i];
+      Status& s = statuses[i];
+      bool matched = false;
+      bool done = false;
+      for (iiter->Seek(key); iiter->Valid() && !done; iiter->Next()) {
+        BlockHandle handle = iiter->value();
+
+        if (filter != nullptr && filter->IsBlockBased() == true &&
+            !filter->KeyMayMatch(ExtractUserKey(key), prefix_extractor,
+                                 handle.offset(), no_io)) {
+          RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+          PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_useful, 1, rep_->level);
+          break;
+        }
+        if (!biter_loaded || handle.offset() != biter_offset) {
+          biter.Invalidate(Status::OK());
+          NewDataBlockIterator<DataBlockIter>(
+              rep_, read_options, handle, &biter, false,
+              true /* key_includes_seq */, get_context);
+          biter_loaded = true;
+          biter_offset = handle.offset();
+        }
+
+        if (no_io && biter.status().IsIncomplete()) {
+          // couldn't get block from block_cache
+          get_context->MarkKeyMayExist();
+          // Try the cache again for the next key
+          biter_loaded = false;
+          break;
+        }
+        if (!biter.status().ok()) {
+          s = biter.status();
+          biter_loaded = false;
+          break;
+        }
+
+        if (!biter.SeekForGet(key)) {
+          break;
+        }
+        for (; biter.Valid(); biter.Next()) {
+          ParsedInternalKey parsed_key;
+          if (!ParseInternalKey(biter.key(), &parsed_key)) {
+            s = Status::Corruption(Slice());
+          }
+
+          if (!get_context->SaveValue(
+                  parsed_key,
+                  LazyBuffer(&data_block_iter_lazy_buffer_state,
+                             {reinterpret_cast<uint64_t>(&biter)},
+                             biter.value(), rep_->file_number),
+                  &matched)) {
+            done = true;
+            break;
+          }
+        }
+        if (s.ok()) {
+          s = biter.status();
+        }
+        if (done) {
+          break;
+        }
+      }
+      if (matched && filter != nullptr && !filter->IsBlockBased()) {
+        RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_FULL_TRUE_POSITIVE);
+        PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_full_true_positive, 1,
+                                  rep_->level);
+      }
+      if (s.ok()) {
+        s = iiter->status();
+      }
+    }
+  }
+
+  if (!rep_->filter_entry.IsSet()) {
+    filter_entry.Release(rep_->table_options.block_cache.get());
+  }
+}
+
 Status BlockBasedTable::Prefetch(const Slice* const begin,
                                  const Slice* const end) {
   auto& comparator = rep_->internal_comparator;
@@ -2583,9 +2928,7 @@ Status BlockBasedTable::Prefetch(const Slice* const begin,
   for (begin ? iiter->Seek(*begin) : iiter->SeekToFirst(); iiter->Valid();
        iiter->Next()) {
     BlockHandle block_handle = iiter->value();
-    const bool is_user_key =
-        rep_->found_table_properties &&
-        rep_->table_properties_base.index_key_is_user_key > 0;
+    const bool is_user_key = rep_->hot_properties.index_key_is_user_key;
     if (end &&
         ((!is_user_key && comparator.Compare(iiter->key(), *end) >= 0) ||
          (is_user_key &&
@@ -2654,7 +2997,8 @@ Status BlockBasedTable::VerifyChecksumInBlocks(
     }
     BlockHandle handle = index_iter->value();
     BlockContents contents;
-    Slice dummy_comp_dict;
+    const UncompressionDict& dummy_comp_dict =
+        UncompressionDict::GetEmptyDict();
     BlockFetcher block_fetcher(
         rep_->file.get(), nullptr /* prefetch buffer */, rep_->footer,
         ReadOptions(), handle, &contents, rep_->ioptions,
@@ -2680,7 +3024,8 @@ Status BlockBasedTable::VerifyChecksumInBlocks(
     Slice input = index_iter->value();
     s = handle.DecodeFrom(&input);
     BlockContents contents;
-    Slice dummy_comp_dict;
+    const UncompressionDict& dummy_comp_dict =
+        UncompressionDict::GetEmptyDict();
     BlockFetcher block_fetcher(
         rep_->file.get(), nullptr /* prefetch buffer */, rep_->footer,
         ReadOptions(), handle, &contents, rep_->ioptions,
@@ -2715,9 +3060,7 @@ bool BlockBasedTable::TEST_KeyInCache(const ReadOptions& options,
   Status s;
   s = GetDataBlockFromCache(
       cache_key, ckey, block_cache, nullptr, rep_, options, &block,
-      rep_->compression_dict_block ? rep_->compression_dict_block->data
-                                   : Slice(),
-      0 /* read_amp_bytes_per_bit */);
+      rep_->get_uncompression_dict(), 0 /* read_amp_bytes_per_bit */);
   assert(s.ok());
   bool in_cache = block.value != nullptr;
   if (in_cache) {
@@ -2770,20 +3113,16 @@ Status BlockBasedTable::CreateIndexReader(
           this, file, prefetch_buffer, footer, footer.index_handle(),
           rep_->ioptions, icomparator, index_reader,
           rep_->persistent_cache_options, level,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_key_is_user_key == 0,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_value_is_delta_encoded == 0,
+          !rep_->hot_properties.index_key_is_user_key,
+          !rep_->hot_properties.index_value_is_delta_encoded,
           GetMemoryAllocator(rep_->table_options));
     }
     case BlockBasedTableOptions::kBinarySearch: {
       return BinarySearchIndexReader::Create(
           file, prefetch_buffer, footer, footer.index_handle(), rep_->ioptions,
           icomparator, index_reader, rep_->persistent_cache_options,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_key_is_user_key == 0,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_value_is_delta_encoded == 0,
+          !rep_->hot_properties.index_key_is_user_key,
+          !rep_->hot_properties.index_value_is_delta_encoded,
           GetMemoryAllocator(rep_->table_options));
     }
     case BlockBasedTableOptions::kHashSearch: {
@@ -2803,10 +3142,8 @@ Status BlockBasedTable::CreateIndexReader(
               file, prefetch_buffer, footer, footer.index_handle(),
               rep_->ioptions, icomparator, index_reader,
               rep_->persistent_cache_options,
-              !rep_->found_table_properties ||
-                  rep_->table_properties_base.index_key_is_user_key == 0,
-              !rep_->found_table_properties ||
-                  rep_->table_properties_base.index_value_is_delta_encoded == 0,
+              !rep_->hot_properties.index_key_is_user_key,
+              !rep_->hot_properties.index_value_is_delta_encoded,
               GetMemoryAllocator(rep_->table_options));
         }
         meta_index_iter = meta_iter_guard.get();
@@ -2817,10 +3154,8 @@ Status BlockBasedTable::CreateIndexReader(
           rep_->ioptions, icomparator, footer.index_handle(), meta_index_iter,
           index_reader, rep_->hash_index_allow_collision,
           rep_->persistent_cache_options,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_key_is_user_key == 0,
-          !rep_->found_table_properties ||
-              rep_->table_properties_base.index_value_is_delta_encoded == 0,
+          !rep_->hot_properties.index_key_is_user_key,
+          !rep_->hot_properties.index_value_is_delta_encoded,
           GetMemoryAllocator(rep_->table_options));
     }
     default: {
@@ -2846,7 +3181,7 @@ uint64_t BlockBasedTable::ApproximateOffsetOf(const Slice& key) {
     // metaindex block (which is right near the end of the file).
     result = 0;
     if (rep_->table_properties) {
-      result = rep_->table_properties_base.data_size;
+      result = rep_->table_properties->data_size;
     }
     // table_properties is not present in the table.
     if (result == 0) {
@@ -2964,31 +3299,33 @@ Status BlockBasedTable::DumpTable(WritableFile* out_file,
   }
 
   // Output TableProperties
-  const TERARKDB_NAMESPACE::TablePropertiesBase* table_properties_base =
-      &rep_->table_properties_base;
+  // Read from the file when not pinned
+  std::shared_ptr<const TableProperties> table_properties =
+      GetTableProperties();
 
-  if (rep_->found_table_properties) {
+  if (table_properties != nullptr) {
     out_file->Append(
         "Table Properties:\n"
         "--------------------------------------\n"
         "  ");
-    out_file->Append(table_properties_base->ToString("\n  ", ": ").c_str());
+    out_file->Append(table_properties->ToString("\n  ", ": ").c_str());
     out_file->Append("\n");
 
     // Output Filter blocks
-    if (!rep_->filter && !table_properties_base->filter_policy_name.empty()) {
+    if (!rep_->filter && !table_properties->filter_policy_name.empty()) {
       // Support only BloomFilter as off now
       TERARKDB_NAMESPACE::BlockBasedTableOptions table_options;
       table_options.filter_policy.reset(
           TERARKDB_NAMESPACE::NewBloomFilterPolicy(1));
-      if (table_properties_base->filter_policy_name.compare(
+      if (table_properties->filter_policy_name.compare(
               table_options.filter_policy->Name()) == 0) {
         std::string filter_block_key = kFilterBlockPrefix;
-        filter_block_key.append(table_properties_base->filter_policy_name);
+        filter_block_key.append(table_properties->filter_policy_name);
         BlockHandle handle;
         if (FindMetaBlock(meta_iter.get(), filter_block_key, &handle).ok()) {
           BlockContents block;
-          Slice dummy_comp_dict;
+          const UncompressionDict& dummy_comp_dict =
+              UncompressionDict::GetEmptyDict();
           BlockFetcher block_fetcher(
               rep_->file.get(), nullptr /* prefetch_buffer */, rep_->footer,
               ReadOptions(), handle, &block, rep_->ioptions,
@@ -3102,8 +3439,7 @@ Status BlockBasedTable::DumpIndexBlock(WritableFile* out_file) {
     Slice key = blockhandles_iter->key();
     Slice user_key;
     InternalKey ikey;
-    if (rep_->found_table_properties &&
-        rep_->table_properties_base.index_key_is_user_key != 0) {
+    if (rep_->hot_properties.index_key_is_user_key) {
       user_key = key;
     } else {
       ikey.DecodeFrom(key);
@@ -106,6 +106,12 @@ class BlockBasedTable : public TableReader {
                       const SliceTransform* options_prefix_extractor,
                       const bool need_upper_bound_check);
 
+  // Checks the auto prefix of the table filter for a seek whose range up to
+  // iterate_upper_bound lies within the prefix of `internal_key`. Returns
+  // true when the filter is not applicable.
+  bool AutoPrefixMayMatch(const Slice& internal_key,
+                          const ReadOptions& read_options);
+
   // Returns a new iterator over the table contents.
   // The result of NewIterator() is initially invalid (caller must
   // call one of the Seek methods on the iterator before using it).
@@ -124,6 +130,13 @@ class BlockBasedTable : public TableReader {
              GetContext* get_context, const SliceTransform* prefix_extractor,
              bool skip_filters = false) override;
 
+  // Reads every distinct data block once for the batch, keys sorted by the
+  // internal comparator share the index and filter lookups
+  void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts,
+                Status* statuses, const SliceTransform* prefix_extractor,
+                bool skip_filters = false) override;
+
   // Pre-fetch the disk blocks that correspond to the key range specified by
   // (kbegin, kend). The call will return error status in the event of
   // IO or iteration error.
@@ -148,6 +161,8 @@ class BlockBasedTable : public TableReader {
   std::shared_ptr<const TableProperties> GetTableProperties() const override;
 
   size_t ApproximateMemoryUsage() const override;
+  size_t ApproximateIndexMemoryUsage() const override;
+  size_t ApproximateDictMemoryUsage() const override;
 
   uint64_t FileNumber() const override;
 
@@ -263,7 +278,7 @@ class BlockBasedTable : public TableReader {
   //    block.
   static Status MaybeReadBlockAndLoadToCache(
       FilePrefetchBuffer* prefetch_buffer, Rep* rep, const ReadOptions& ro,
-      const BlockHandle& handle, Slice compression_dict,
+      const BlockHandle& handle, const UncompressionDict& compression_dict,
       CachableEntry<Block>* block_entry, bool is_index = false,
       GetContext* get_context = nullptr);
 
@@ -306,7 +321,7 @@ class BlockBasedTable : public TableReader {
       Cache* block_cache, Cache* block_cache_compressed, Rep* rep,
       const ReadOptions& read_options,
       BlockBasedTable::CachableEntry<Block>* block,
-      const Slice& compression_dict, size_t read_amp_bytes_per_bit,
+      const UncompressionDict& compression_dict, size_t read_amp_bytes_per_bit,
       bool is_index = false, GetContext* get_context = nullptr);
 
   // Put a raw block (maybe compressed) to the corresponding block caches.
@@ -325,11 +340,18 @@ class BlockBasedTable : public TableReader {
       const ReadOptions& read_options, const ImmutableCFOptions& ioptions,
       CachableEntry<Block>* block, BlockContents* raw_block_contents,
       CompressionType raw_block_comp_type, uint32_t format_version,
-      const Slice& compression_dict, SequenceNumber seq_no,
+      const UncompressionDict& compression_dict, SequenceNumber seq_no,
       size_t read_amp_bytes_per_bit, MemoryAllocator* memory_allocator,
       bool is_index = false, Cache::Priority pri = Cache::Priority::LOW,
       GetContext* get_context = nullptr);
 
+  // Compress a block which is uncompressed in the file with
+  // block_cache_compressed_compression and put it to the compressed block
+  // cache, unless it doesn't compress well.
+  static void PutRecompressedBlockToCache(
+      const Slice& compressed_block_cache_key, Cache* block_cache_compressed,
+      Rep* rep, const Slice& raw, const Slice& compression_dict);
+
   // Calls (*handle_result)(arg, ...) repeatedly, starting with the entry found
   // after a call to Seek(key), until handle_result returns false.
   // May not make such a call if filter policy says that key is not present.
@@ -446,7 +468,6 @@ struct BlockBasedTable::Rep {
         filter_policy(skip_filters ? nullptr : _table_opt.filter_policy.get()),
         internal_comparator(_internal_comparator),
         filter_type(FilterType::kNoFilter),
-        found_table_properties(false),
         index_type(BlockBasedTableOptions::IndexType::kBinarySearch),
         hash_index_allow_collision(false),
         whole_key_filtering(_table_opt.whole_key_filtering),
@@ -489,15 +510,26 @@ struct BlockBasedTable::Rep {
   FilterType filter_type;
   BlockHandle filter_handle;
 
+  // Released after open unless pin_table_properties_in_reader
   std::shared_ptr<const TableProperties> table_properties;
-  TablePropertiesBase table_properties_base;
-  bool found_table_properties;
+  // The properties used on the read path, always resident. They default to
+  // the values of files without properties
+  struct {
+    bool index_key_is_user_key = false;
+    bool index_value_is_delta_encoded = false;
+    // Interned, empty when not recorded
+    const std::string* prefix_extractor_name = InternTablePropertyString("");
+    // The prefix length in the full filter, 0 when none
+    size_t auto_prefix_length = 0;
+  } hot_properties;
 
   // Block containing the data for the compression dictionary. We take ownership
   // for the entire block struct, even though we only use its Slice member. This
   // is easier because the Slice member depends on the continued existence of
   // another member ("allocation").
   std::unique_ptr<const BlockContents> compression_dict_block;
+  // The dictionary above, digested once for the files compressed by ZSTD
+  std::unique_ptr<const UncompressionDict> uncompression_dict;
   BlockBasedTableOptions::IndexType index_type;
   bool hash_index_allow_collision;
   bool whole_key_filtering;
@@ -541,6 +573,11 @@ struct BlockBasedTable::Rep {
   SequenceNumber get_global_seqno(bool is_index) const {
     return is_index ? kDisableGlobalSequenceNumber : global_seqno;
   }
+
+  const UncompressionDict& get_uncompression_dict() const {
+    return uncompression_dict != nullptr ? *uncompression_dict
+                                         : UncompressionDict::GetEmptyDict();
+  }
 };
 
 template <class TBlockIter, typename TValue = LazyBuffer>
@@ -610,6 +647,16 @@ class BlockBasedTableIteratorBase : public InternalIteratorBase<TValue> {
     return true;
   }
 
+  bool CheckAutoPrefixMayMatch(const Slice& ikey) {
+    if (!check_filter_ && !is_index_ && !for_compaction_ &&
+        prefix_extractor_ == nullptr &&
+        !table_->AutoPrefixMayMatch(ikey, read_options_)) {
+      ResetDataIter();
+      return false;
+    }
+    return true;
+  }
+
   void ResetDataIter() {
     if (block_iter_points_to_real_block_) {
       block_iter_.Invalidate(Status::OK());
@@ -626,6 +673,9 @@ class BlockBasedTableIteratorBase : public InternalIteratorBase<TValue> {
   }
 
   void InitDataBlock();
+  // Hints the blocks of the next read_options_.async_prefetch_depth index
+  // entries, starting from the current one, to the file
+  void AsyncPrefetch(const BlockHandle& data_block_handle);
   void FindKeyForward();
   void FindKeyBackward();
 
@@ -658,6 +708,11 @@ class BlockBasedTableIteratorBase : public InternalIteratorBase<TValue> {
   size_t readahead_limit_ = 0;
   int num_file_reads_ = 0;
   std::unique_ptr<FilePrefetchBuffer> prefetch_buffer_;
+  // File range hinted by AsyncPrefetch, and the offset past which the next
+  // window is hinted
+  uint64_t prefetch_start_ = 0;
+  uint64_t prefetch_limit_ = 0;
+  uint64_t prefetch_trigger_ = 0;
 };
 
 template <class TBlockIter, typename TValue = Slice>
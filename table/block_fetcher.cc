@@ -15,6 +15,7 @@
 
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/statistics.h"
+#include "monitoring/usdt.h"
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/block.h"
@@ -55,6 +56,9 @@ inline void BlockFetcher::CheckBlockChecksum() {
             XXH64(data, static_cast<int>(block_size_) + 1, 0) &
             uint64_t{0xffffffff});
         break;
+      case kXXH3:
+        actual = ComputeXXH3BlockChecksum(data, block_size_, data[block_size_]);
+        break;
       default:
         status_ = Status::Corruption(
             "unknown checksum type " + ToString(footer_.checksum()) + " in " +
@@ -217,9 +221,12 @@ Status BlockFetcher::ReadBlockContents() {
 
     {
       PERF_TIMER_GUARD(block_read_time);
+      TERARKDB_PROBE2(block_read_start, handle_.offset(),
+                      block_size_ + kBlockTrailerSize);
       // Actual file read
       status_ = file_->Read(handle_.offset(), block_size_ + kBlockTrailerSize,
                             &slice_, used_buf_);
+      TERARKDB_PROBE2(block_read_done, handle_.offset(), status_.ok());
     }
     PERF_COUNTER_ADD(block_read_count, 1);
     PERF_COUNTER_ADD(block_read_byte, block_size_ + kBlockTrailerSize);
@@ -250,7 +257,7 @@ Status BlockFetcher::ReadBlockContents() {
   if (do_uncompress_ && compression_type_ != kNoCompression) {
     // compressed page, uncompress, update cache
     UncompressionContext uncompression_ctx(compression_type_,
-                                           compression_dict_);
+                                           uncompression_dict_);
     status_ = UncompressBlockContents(uncompression_ctx, slice_.data(),
                                       block_size_, contents_, footer_.version(),
                                       ioptions_, memory_allocator_);
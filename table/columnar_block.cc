@@ -0,0 +1,194 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "table/columnar_block.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "rocksdb/table.h"
+#include "rocksdb/terark_namespace.h"
+#include "table/data_block_footer.h"
+#include "util/coding.h"
+#include "util/memory_allocator.h"
+
+namespace TERARKDB_NAMESPACE {
+
+Status ParseValueColumnWidths(const std::string& spec,
+                              std::vector<uint32_t>* widths) {
+  widths->clear();
+  size_t begin = 0;
+  while (begin < spec.size()) {
+    size_t end = spec.find(':', begin);
+    if (end == std::string::npos) {
+      end = spec.size();
+    }
+    uint64_t width = 0;
+    for (size_t i = begin; i < end; ++i) {
+      if (spec[i] < '0' || spec[i] > '9' || width > UINT32_MAX / 10) {
+        return Status::InvalidArgument("Bad value_column_widths", spec);
+      }
+      width = width * 10 + (spec[i] - '0');
+    }
+    if (end == begin || width == 0 || width > UINT32_MAX) {
+      return Status::InvalidArgument("Bad value_column_widths", spec);
+    }
+    widths->push_back(static_cast<uint32_t>(width));
+    begin = end + 1;
+  }
+  return Status::OK();
+}
+
+bool EncodeColumnarBlock(const Slice& block,
+                         const std::vector<uint32_t>& widths,
+                         std::string* output) {
+  if (block.size() < sizeof(uint32_t)) {
+    return false;
+  }
+  BlockBasedTableOptions::DataBlockIndexType index_type;
+  uint32_t num_restarts;
+  UnPackIndexTypeAndNumRestarts(
+      DecodeFixed32(block.data() + block.size() - sizeof(uint32_t)),
+      &index_type, &num_restarts);
+  uint64_t tail_size = (uint64_t{num_restarts} + 1) * sizeof(uint32_t);
+  if (index_type != BlockBasedTableOptions::kDataBlockBinarySearch ||
+      tail_size > block.size()) {
+    return false;
+  }
+  const char* p = block.data();
+  const char* limit = block.data() + block.size() - tail_size;
+  std::string rows;
+  std::vector<std::string> columns(widths.size() + 1);
+  uint32_t num_entries = 0;
+  while (p < limit) {
+    const char* entry = p;
+    uint32_t shared, non_shared, value_length;
+    if ((p = GetVarint32Ptr(p, limit, &shared)) == nullptr ||
+        (p = GetVarint32Ptr(p, limit, &non_shared)) == nullptr ||
+        (p = GetVarint32Ptr(p, limit, &value_length)) == nullptr ||
+        static_cast<uint64_t>(limit - p) <
+            uint64_t{non_shared} + value_length) {
+      return false;
+    }
+    p += non_shared;
+    rows.append(entry, p - entry);
+    uint32_t offset = 0;
+    for (size_t i = 0; i < widths.size() && offset < value_length; ++i) {
+      uint32_t n = std::min(widths[i], value_length - offset);
+      columns[i].append(p + offset, n);
+      offset += n;
+    }
+    columns.back().append(p + offset, value_length - offset);
+    p += value_length;
+    ++num_entries;
+  }
+  output->clear();
+  PutVarint32(output, static_cast<uint32_t>(widths.size()));
+  for (uint32_t width : widths) {
+    PutVarint32(output, width);
+  }
+  PutVarint32(output, num_entries);
+  PutVarint32(output, static_cast<uint32_t>(rows.size()));
+  output->append(rows);
+  for (auto& column : columns) {
+    output->append(column);
+  }
+  output->append(limit, tail_size);
+  return true;
+}
+
+Status DecodeColumnarBlock(const Slice& input, MemoryAllocator* allocator,
+                           BlockContents* contents) {
+  Slice in = input;
+  uint32_t num_widths;
+  if (!GetVarint32(&in, &num_widths) || num_widths > in.size()) {
+    return Status::Corruption("Bad columnar block header");
+  }
+  std::vector<uint32_t> widths(num_widths);
+  for (auto& width : widths) {
+    if (!GetVarint32(&in, &width)) {
+      return Status::Corruption("Bad columnar block header");
+    }
+  }
+  uint32_t num_entries, rows_size;
+  if (!GetVarint32(&in, &num_entries) || !GetVarint32(&in, &rows_size) ||
+      rows_size > in.size()) {
+    return Status::Corruption("Bad columnar block header");
+  }
+  Slice rows(in.data(), rows_size);
+  in.remove_prefix(rows_size);
+
+  // The first pass sizes the column streams and the block
+  std::vector<uint64_t> column_sizes(widths.size() + 1, 0);
+  uint64_t block_size = 0;
+  const char* limit = rows.data() + rows.size();
+  const char* p = rows.data();
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    const char* entry = p;
+    uint32_t shared, non_shared, value_length;
+    if ((p = GetVarint32Ptr(p, limit, &shared)) == nullptr ||
+        (p = GetVarint32Ptr(p, limit, &non_shared)) == nullptr ||
+        (p = GetVarint32Ptr(p, limit, &value_length)) == nullptr ||
+        static_cast<uint64_t>(limit - p) < non_shared) {
+      return Status::Corruption("Bad columnar block rows");
+    }
+    p += non_shared;
+    block_size += (p - entry) + uint64_t{value_length};
+    uint32_t offset = 0;
+    for (size_t j = 0; j < widths.size() && offset < value_length; ++j) {
+      uint32_t n = std::min(widths[j], value_length - offset);
+      column_sizes[j] += n;
+      offset += n;
+    }
+    column_sizes.back() += value_length - offset;
+  }
+  if (p != limit) {
+    return Status::Corruption("Bad columnar block rows");
+  }
+  std::vector<const char*> columns(column_sizes.size());
+  const char* column = in.data();
+  uint64_t remaining = in.size();
+  for (size_t j = 0; j < column_sizes.size(); ++j) {
+    if (column_sizes[j] > remaining) {
+      return Status::Corruption("Truncated columnar block");
+    }
+    columns[j] = column;
+    column += column_sizes[j];
+    remaining -= column_sizes[j];
+  }
+  block_size += remaining;
+
+  // The second pass interleaves the streams back into entries
+  CacheAllocationPtr buf = AllocateBlock(block_size, allocator);
+  char* dst = buf.get();
+  p = rows.data();
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    const char* entry = p;
+    uint32_t shared, non_shared, value_length;
+    p = GetVarint32Ptr(p, limit, &shared);
+    p = GetVarint32Ptr(p, limit, &non_shared);
+    p = GetVarint32Ptr(p, limit, &value_length);
+    p += non_shared;
+    memcpy(dst, entry, p - entry);
+    dst += p - entry;
+    uint32_t offset = 0;
+    for (size_t j = 0; j < widths.size() && offset < value_length; ++j) {
+      uint32_t n = std::min(widths[j], value_length - offset);
+      memcpy(dst, columns[j], n);
+      columns[j] += n;
+      dst += n;
+      offset += n;
+    }
+    memcpy(dst, columns.back(), value_length - offset);
+    columns.back() += value_length - offset;
+    dst += value_length - offset;
+  }
+  memcpy(dst, column, remaining);
+  *contents = BlockContents(std::move(buf), block_size);
+  return Status::OK();
+}
+
+}  // namespace TERARKDB_NAMESPACE
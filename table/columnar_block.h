@@ -0,0 +1,45 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+#include "table/format.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Parses BlockBasedTableOptions::value_column_widths, "4:8:8" declares three
+// leading columns of 4, 8 and 8 bytes. An empty spec declares none.
+Status ParseValueColumnWidths(const std::string& spec,
+                              std::vector<uint32_t>* widths);
+
+// Rewrites a finished data block before its compression so the column
+// streams are compressed apart from each other: the entry headers with the
+// key deltas, every declared leading column of the values, and the rest of
+// the values are each stored contiguously. The restart array is kept as
+// is. Returns false for a block it can not rewrite, that is a block with a
+// hash index.
+//
+//   varint32 num_widths, varint32 widths[num_widths]
+//   varint32 num_entries
+//   varint32 rows_size, rows[rows_size]
+//   column streams, rest of the values stream
+//   restart array and block footer
+bool EncodeColumnarBlock(const Slice& block,
+                         const std::vector<uint32_t>& widths,
+                         std::string* output);
+
+// Restores the data block EncodeColumnarBlock() was given
+Status DecodeColumnarBlock(const Slice& input, MemoryAllocator* allocator,
+                           BlockContents* contents);
+
+}  // namespace TERARKDB_NAMESPACE
@@ -10,19 +10,33 @@
 #include "rocksdb/terark_namespace.h"
 #include "table/cuckoo_table_builder.h"
 #include "table/cuckoo_table_reader.h"
+#include "table/format.h"
 
 namespace TERARKDB_NAMESPACE {
 
+extern const uint64_t kCuckooTableMagicNumber;
+
 Status CuckooTableFactory::NewTableReader(
     const TableReaderOptions& table_reader_options,
     std::unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
     std::unique_ptr<TableReader>* table,
-    bool /*prefetch_index_and_filter_in_cache*/) const {
+    bool prefetch_index_and_filter_in_cache) const {
+  Footer footer;
+  Status s = ReadFooterFromFile(file.get(), nullptr /* prefetch_buffer */,
+                                file_size, &footer);
+  if (!s.ok()) {
+    return s;
+  }
+  if (footer.table_magic_number() != kCuckooTableMagicNumber) {
+    return map_sst_factory_->NewTableReader(
+        table_reader_options, std::move(file), file_size, table,
+        prefetch_index_and_filter_in_cache);
+  }
   std::unique_ptr<CuckooTableReader> new_reader(new CuckooTableReader(
       table_reader_options.ioptions, std::move(file),
       table_reader_options.file_number, file_size,
       table_reader_options.internal_comparator.user_comparator(), nullptr));
-  Status s = new_reader->status();
+  s = new_reader->status();
   if (s.ok()) {
     *table = std::move(new_reader);
   }
@@ -32,6 +46,13 @@ Status CuckooTableFactory::NewTableReader(
 TableBuilder* CuckooTableFactory::NewTableBuilder(
     const TableBuilderOptions& table_builder_options, uint32_t column_family_id,
     WritableFileWriter* file) const {
+  int level = table_builder_options.level;
+  if (table_builder_options.sst_purpose == kMapSst ||
+      (table_options_.bottommost_level_only && level >= 0 &&
+       level < table_builder_options.ioptions.num_levels - 1)) {
+    return map_sst_factory_->NewTableBuilder(table_builder_options,
+                                             column_family_id, file);
+  }
   // Ignore the skipFIlters flag. Does not apply to this file format
   //
 
@@ -63,6 +84,9 @@ std::string CuckooTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  identity_as_first_hash: %d\n",
            table_options_.identity_as_first_hash);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  bottommost_level_only: %d\n",
+           table_options_.bottommost_level_only);
+  ret.append(buffer);
   return ret;
 }
 
@@ -97,6 +121,9 @@ static TableFactory* CuckooCreator(const std::string& options, Status* s) {
   if (!(opt = get_option("identity_as_first_hash")).empty()) {
     cto.identity_as_first_hash = std::atoi(opt.c_str());
   }
+  if (!(opt = get_option("bottommost_level_only")).empty()) {
+    cto.bottommost_level_only = std::atoi(opt.c_str());
+  }
   return NewCuckooTableFactory(cto);
 }
 
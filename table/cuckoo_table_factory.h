@@ -6,6 +6,7 @@
 #pragma once
 #ifndef ROCKSDB_LITE
 
+#include <memory>
 #include <string>
 
 #include "rocksdb/options.h"
@@ -52,10 +53,15 @@ static inline uint64_t CuckooHash(
 // - Does not support Snapshot.
 // - Does not support Merge operations.
 // - Does not support prefix bloom filters.
+//
+// Map SSTs, whose keys are ranges of other SSTs, are built as block based
+// tables, so that lazy compaction still works. With bottommost_level_only,
+// the files of the upper levels are block based tables too.
 class CuckooTableFactory : public TableFactory {
  public:
   explicit CuckooTableFactory(const CuckooTableOptions& table_options)
-      : table_options_(table_options) {}
+      : table_options_(table_options),
+        map_sst_factory_(NewBlockBasedTableFactory()) {}
   ~CuckooTableFactory() {}
 
   const char* Name() const override { return "CuckooTable"; }
@@ -88,6 +94,7 @@ class CuckooTableFactory : public TableFactory {
 
  private:
   CuckooTableOptions table_options_;
+  std::shared_ptr<TableFactory> map_sst_factory_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
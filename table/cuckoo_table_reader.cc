@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include "rocksdb/comparator.h"
 #include "rocksdb/iterator.h"
 #include "rocksdb/table.h"
 #include "rocksdb/terark_namespace.h"
@@ -56,6 +57,7 @@ CuckooTableReader::CuckooTableReader(
       table_size_(0),
       ioptions_(ioptions),
       ucomp_(comparator),
+      is_bytewise_(comparator == BytewiseComparator()),
       get_slice_hash_(get_slice_hash) {
   if (!ioptions.allow_mmap_reads) {
     status_ = Status::InvalidArgument("File is not mmaped");
@@ -67,8 +69,10 @@ CuckooTableReader::CuckooTableReader(
   if (!status_.ok()) {
     return;
   }
+  // Freed on return when not pinned
+  std::shared_ptr<const TableProperties> props_holder(props);
   if (ioptions.pin_table_properties_in_reader) {
-    table_props_.reset(props);
+    table_props_ = props_holder;
   }
   auto& user_props = props->user_collected_properties;
   auto hash_funs = user_props.find(CuckooTablePropertyNames::kNumHashFunc);
@@ -171,6 +175,7 @@ Status CuckooTableReader::Get(const ReadOptions& /*readOptions*/,
                               bool /*skip_filters*/) {
   assert(key.size() == key_length_ + (is_last_level_ ? 8 : 0));
   Slice user_key = ExtractUserKey(key);
+  const char* unused_key = unused_key_.data();
   for (uint32_t hash_cnt = 0; hash_cnt < num_hash_func_; ++hash_cnt) {
     uint64_t offset =
         bucket_length_ * CuckooHash(user_key, hash_cnt, use_module_hash_,
@@ -179,13 +184,12 @@ Status CuckooTableReader::Get(const ReadOptions& /*readOptions*/,
     const char* bucket = &file_data_.data()[offset];
     for (uint32_t block_idx = 0; block_idx < cuckoo_block_size_;
          ++block_idx, bucket += bucket_length_) {
-      if (ucomp_->Equal(Slice(unused_key_.data(), user_key.size()),
-                        Slice(bucket, user_key.size()))) {
+      if (UserKeyEqual(bucket, Slice(unused_key, user_key.size()))) {
         return Status::OK();
       }
       // Here, we compare only the user key part as we support only one entry
       // per user key and we don't support snapshot.
-      if (ucomp_->Equal(user_key, Slice(bucket, user_key.size()))) {
+      if (UserKeyEqual(bucket, user_key)) {
         LazyBuffer value(Slice(bucket + key_length_, value_length_), false,
                          file_number_);
         bool dont_care __attribute__((__unused__));
@@ -225,6 +229,20 @@ void CuckooTableReader::Prepare(const Slice& key) {
   }
 }
 
+void CuckooTableReader::MultiGet(const ReadOptions& read_options,
+                                 size_t num_keys, const Slice* keys,
+                                 GetContext** get_contexts, Status* statuses,
+                                 const SliceTransform* prefix_extractor,
+                                 bool skip_filters) {
+  for (size_t i = 0; i < num_keys; ++i) {
+    Prepare(keys[i]);
+  }
+  for (size_t i = 0; i < num_keys; ++i) {
+    statuses[i] = Get(read_options, keys[i], get_contexts[i], prefix_extractor,
+                      skip_filters);
+  }
+}
+
 class CuckooTableIterator : public InternalIterator {
  public:
   explicit CuckooTableIterator(CuckooTableReader* reader);
@@ -340,9 +358,20 @@ void CuckooTableIterator::Seek(const Slice& target) {
   PrepareKVAtCurrIdx();
 }
 
-void CuckooTableIterator::SeekForPrev(const Slice& /*target*/) {
-  // Not supported
-  assert(false);
+void CuckooTableIterator::SeekForPrev(const Slice& target) {
+  Seek(target);
+  if (!Valid()) {
+    SeekToLast();
+    return;
+  }
+  // Seek() compares the user keys only, of equal user keys the larger
+  // sequence number sorts first
+  int cmp = reader_->ucomp_->Compare(ExtractUserKey(key()),
+                                     ExtractUserKey(target));
+  if (cmp > 0 || (cmp == 0 && ExtractInternalKeyFooter(key()) <
+                                  ExtractInternalKeyFooter(target))) {
+    Prev();
+  }
 }
 
 bool CuckooTableIterator::Valid() const {
@@ -9,6 +9,8 @@
 
 #pragma once
 #ifndef ROCKSDB_LITE
+#include <string.h>
+
 #include <memory>
 #include <string>
 #include <utility>
@@ -52,6 +54,13 @@ class CuckooTableReader : public TableReader {
                                 bool for_compaction = false) override;
   void Prepare(const Slice& target) override;
 
+  // Prefetches the first cuckoo block of every key before probing any, so
+  // the cache misses of the batch overlap
+  void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor,
+                bool skip_filters = false) override;
+
   // Report an approximation of how much memory has been used.
   size_t ApproximateMemoryUsage() const override;
 
@@ -65,13 +74,21 @@ class CuckooTableReader : public TableReader {
  private:
   friend class CuckooTableIterator;
   void LoadAllKeys(std::vector<std::pair<Slice, uint32_t>>* key_to_bucket_id);
+
+  // All the user keys have the same size, with the bytewise comparator a
+  // bucket is probed with one memcmp instead of a virtual call
+  bool UserKeyEqual(const char* bucket, const Slice& user_key) const {
+    return is_bytewise_
+               ? memcmp(bucket, user_key.data(), user_key.size()) == 0
+               : ucomp_->Equal(user_key, Slice(bucket, user_key.size()));
+  }
+
   std::unique_ptr<RandomAccessFileReader> file_;
   Slice file_data_;
   bool is_last_level_;
   bool identity_as_first_hash_;
   bool use_module_hash_;
   std::shared_ptr<const TableProperties> table_props_;
-  TablePropertiesBase table_props_base_;
   Status status_;
   uint32_t num_hash_func_;
   std::string unused_key_;
@@ -85,6 +102,7 @@ class CuckooTableReader : public TableReader {
   uint64_t table_size_;
   const ImmutableCFOptions& ioptions_;
   const Comparator* ucomp_;
+  bool is_bytewise_;
   uint64_t (*get_slice_hash_)(const Slice& s, uint32_t index,
                               uint64_t max_num_buckets);
 };
@@ -132,6 +132,27 @@ class CuckooReaderTest : public testing::Test {
           reader.Get(ReadOptions(), Slice(keys[i]), &get_context, nullptr));
       ASSERT_STREQ(values[i].c_str(), value.data());
     }
+    // Same with one batch
+    std::vector<Slice> mget_keys;
+    std::vector<LazyBuffer> mget_values(num_items);
+    std::vector<std::unique_ptr<GetContext>> get_context_holders;
+    std::vector<GetContext*> get_contexts;
+    std::vector<Status> statuses(num_items);
+    for (uint32_t i = 0; i < num_items; ++i) {
+      mget_keys.emplace_back(keys[i]);
+      get_context_holders.emplace_back(new GetContext(
+          ucomp, nullptr, nullptr, nullptr, GetContext::kNotFound,
+          Slice(user_keys[i]), &mget_values[i], nullptr, nullptr, nullptr,
+          nullptr, nullptr));
+      get_contexts.push_back(get_context_holders.back().get());
+    }
+    reader.MultiGet(ReadOptions(), num_items, mget_keys.data(),
+                    get_contexts.data(), statuses.data(), nullptr);
+    for (uint32_t i = 0; i < num_items; ++i) {
+      ASSERT_OK(statuses[i]);
+      ASSERT_EQ(GetContext::kFound, get_contexts[i]->State());
+      ASSERT_STREQ(values[i].c_str(), mget_values[i].data());
+    }
   }
   void UpdateKeys(bool with_zero_seqno) {
     for (uint32_t i = 0; i < num_items; i++) {
@@ -194,6 +215,31 @@ class CuckooReaderTest : public testing::Test {
       it->Next();
     }
     ASSERT_EQ(static_cast<uint32_t>(cnt), num_items);
+
+    cnt = static_cast<int>(num_items) / 2;
+    it->SeekForPrev(keys[cnt]);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_TRUE(Slice(keys[cnt]) == it->key());
+    // A newer version of the user key sorts before the one in the file
+    std::string target;
+    AppendInternalKey(&target, ParsedInternalKey(user_keys[cnt],
+                                                 kMaxSequenceNumber,
+                                                 kValueTypeForSeek));
+    it->SeekForPrev(target);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_TRUE(Slice(keys[cnt - 1]) == it->key());
+    target.clear();
+    AppendInternalKey(&target, ParsedInternalKey(user_keys[0],
+                                                 kMaxSequenceNumber,
+                                                 kValueTypeForSeek));
+    it->SeekForPrev(target);
+    ASSERT_FALSE(it->Valid());
+    target.clear();
+    AppendInternalKey(&target, ParsedInternalKey(user_keys[num_items - 1], 0,
+                                                 kTypeDeletion));
+    it->SeekForPrev(target);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_TRUE(Slice(keys[num_items - 1]) == it->key());
     delete it;
 
     Arena arena;
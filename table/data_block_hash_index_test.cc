@@ -721,6 +721,59 @@ TEST(DataBlockHashIndex, BlockBoundary) {
   }
 }
 
+TEST(DataBlockHashIndex, BlockSeekMatchesBinarySeek) {
+  Random rnd(1019);
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  GenerateRandomKVs(&keys, &values, 0, 200, 1 /* step */, 3 /* padding */,
+                    3 /* keys_share_prefix */);
+
+  const InternalKeyComparator icmp(BytewiseComparator());
+  std::vector<std::unique_ptr<Block>> blocks;
+  std::vector<std::unique_ptr<BlockBuilder>> builders;
+  for (auto index_type : {BlockBasedTableOptions::kDataBlockBinarySearch,
+                          BlockBasedTableOptions::kDataBlockBinaryAndHash}) {
+    builders.emplace_back(new BlockBuilder(
+        4 /* block_restart_interval */, true /* use_delta_encoding */,
+        false /* use_value_delta_encoding */, index_type));
+    // Every user key has two versions, some of them across restart intervals
+    for (size_t i = 0; i < keys.size(); i++) {
+      builders.back()->Add(
+          InternalKey(keys[i], 20, kTypeValue).Encode().ToString(), values[i]);
+      builders.back()->Add(
+          InternalKey(keys[i], 10, kTypeValue).Encode().ToString(), values[i]);
+    }
+    BlockContents contents;
+    contents.data = builders.back()->Finish();
+    blocks.emplace_back(
+        new Block(std::move(contents), kDisableGlobalSequenceNumber));
+  }
+
+  std::unique_ptr<DataBlockIter> binary_iter(
+      blocks[0]->NewIterator<DataBlockIter>(&icmp, icmp.user_comparator()));
+  std::unique_ptr<DataBlockIter> hash_iter(
+      blocks[1]->NewIterator<DataBlockIter>(&icmp, icmp.user_comparator()));
+  auto check_seek = [&](const std::string& ukey, SequenceNumber seq) {
+    InternalKey seek_ikey(ukey, seq, kValueTypeForSeek);
+    binary_iter->Seek(seek_ikey.Encode());
+    hash_iter->Seek(seek_ikey.Encode());
+    ASSERT_EQ(binary_iter->Valid(), hash_iter->Valid());
+    if (binary_iter->Valid()) {
+      ASSERT_EQ(binary_iter->key(), hash_iter->key());
+      ASSERT_EQ(binary_iter->value(), hash_iter->value());
+    }
+  };
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (SequenceNumber seq : {30, 20, 15, 10, 5}) {
+      check_seek(keys[i], seq);
+    }
+    // Missing keys fall back to the binary search
+    check_seek(keys[i] + RandomString(&rnd, 1), 30);
+  }
+  check_seek("", 30);
+  check_seek(keys.back() + "~", 30);
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
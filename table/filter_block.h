@@ -30,6 +30,7 @@
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/table.h"
+#include "rocksdb/table_properties.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/hash.h"
 
@@ -63,6 +64,9 @@ class FilterBlockBuilder {
     return ret;
   }
   virtual Slice Finish(const BlockHandle& tmp, Status* status) = 0;
+  // Adds what the filter learned of the keys to the table properties, called
+  // after the last Finish()
+  virtual void AddProperties(UserCollectedProperties* /*properties*/) const {}
 
  private:
   // No copying allowed
@@ -20,6 +20,7 @@
 #include "table/block.h"
 #include "table/block_based_table_reader.h"
 #include "table/block_fetcher.h"
+#include "table/columnar_block.h"
 #include "table/persistent_cache_helper.h"
 #include "util/coding.h"
 #include "util/compression.h"
@@ -29,6 +30,7 @@
 #include "util/memory_allocator.h"
 #include "util/stop_watch.h"
 #include "util/string_util.h"
+#include "util/xxh3.h"
 #include "util/xxhash.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -281,6 +283,12 @@ Status ReadFooterFromFile(RandomAccessFileReader* file,
   return Status::OK();
 }
 
+uint32_t ComputeXXH3BlockChecksum(const char* data, size_t size, char type) {
+  const uint32_t kRandomPrime = 0x6b9083d9;
+  uint32_t v = static_cast<uint32_t>(XXH3_64bits(data, size));
+  return v ^ (static_cast<uint8_t>(type) * kRandomPrime);
+}
+
 Status UncompressBlockContentsForCompressionType(
     const UncompressionContext& uncompression_ctx, const char* data, size_t n,
     BlockContents* contents, uint32_t format_version,
@@ -406,7 +414,16 @@ Status UncompressBlockContents(const UncompressionContext& uncompression_ctx,
                                const ImmutableCFOptions& ioptions,
                                MemoryAllocator* allocator) {
   assert(data[n] != kNoCompression);
-  assert(data[n] == uncompression_ctx.type());
+  assert(get_block_compression_type(data, n) == uncompression_ctx.type());
+  if (static_cast<unsigned char>(data[n]) & kColumnarBlockFlag) {
+    BlockContents columnar;
+    Status s = UncompressBlockContentsForCompressionType(
+        uncompression_ctx, data, n, &columnar, format_version, ioptions);
+    if (!s.ok()) {
+      return s;
+    }
+    return DecodeColumnarBlock(columnar.data, allocator, contents);
+  }
   return UncompressBlockContentsForCompressionType(uncompression_ctx, data, n,
                                                    contents, format_version,
                                                    ioptions, allocator);
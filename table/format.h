@@ -190,9 +190,22 @@ Status ReadFooterFromFile(RandomAccessFileReader* file,
 // 1-byte type + 32-bit crc
 static const size_t kBlockTrailerSize = 5;
 
+// The kXXH3 checksum of a block followed by its type byte. The block is
+// hashed in one shot and the type mixed in afterwards, XXH3 has no cheap
+// streaming over a one byte tail.
+extern uint32_t ComputeXXH3BlockChecksum(const char* data, size_t size,
+                                         char type);
+
+// Set in the type byte of the trailer of a compressed data block whose
+// contents were rewritten by EncodeColumnarBlock() before the compression
+static const unsigned char kColumnarBlockFlag = 0x80;
+
+// The compression of a raw block, without kColumnarBlockFlag
 inline CompressionType get_block_compression_type(const char* block_data,
                                                   size_t block_size) {
-  return static_cast<CompressionType>(block_data[block_size]);
+  return static_cast<CompressionType>(
+      static_cast<unsigned char>(block_data[block_size]) &
+      ~kColumnarBlockFlag);
 }
 
 struct BlockContents {
@@ -17,26 +17,54 @@
 #include "port/port.h"
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/terark_namespace.h"
+#include "table/block_based_table_factory.h"
 #include "util/coding.h"
 
 namespace TERARKDB_NAMESPACE {
 
+namespace {
+// The keys the auto prefix length is picked from
+const size_t kAutoPrefixSampleKeys = 4096;
+// Smaller tables get no auto prefix
+const size_t kMinAutoPrefixSampleKeys = 64;
+const size_t kMinKeysPerAutoPrefix = 4;
+
+size_t CommonPrefixLength(const Slice& a, const Slice& b) {
+  size_t limit = std::min(a.size(), b.size());
+  size_t i = 0;
+  while (i < limit && a[i] == b[i]) {
+    ++i;
+  }
+  return i;
+}
+}  // namespace
+
+const size_t FullFilterBlockBuilder::kMaxAutoPrefixLength;
+
 FullFilterBlockBuilder::FullFilterBlockBuilder(
     const SliceTransform* prefix_extractor, bool whole_key_filtering,
-    FilterBitsBuilder* filter_bits_builder)
+    FilterBitsBuilder* filter_bits_builder, bool auto_prefix_filtering)
     : prefix_extractor_(prefix_extractor),
       whole_key_filtering_(whole_key_filtering),
       last_whole_key_recorded_(false),
       last_prefix_recorded_(false),
-      num_added_(0) {
+      num_added_(0),
+      auto_prefix_filtering_(auto_prefix_filtering &&
+                             prefix_extractor == nullptr),
+      auto_prefix_picked_(false),
+      auto_prefix_length_(0),
+      num_auto_prefix_keys_(0) {
   assert(filter_bits_builder != nullptr);
   filter_bits_builder_.reset(filter_bits_builder);
+  if (auto_prefix_filtering_) {
+    key_prefix_length_histogram_.resize(kMaxAutoPrefixLength + 1);
+  }
 }
 
 void FullFilterBlockBuilder::Add(const Slice& key) {
   const bool add_prefix = prefix_extractor_ && prefix_extractor_->InDomain(key);
   if (whole_key_filtering_) {
-    if (!add_prefix) {
+    if (!add_prefix && !auto_prefix_filtering_) {
       AddKey(key);
     } else {
       // if both whole_key and prefix are added to bloom then we will have whole
@@ -54,6 +82,9 @@ void FullFilterBlockBuilder::Add(const Slice& key) {
   if (add_prefix) {
     AddPrefix(key);
   }
+  if (auto_prefix_filtering_) {
+    AddAutoPrefix(key);
+  }
 }
 
 // Add key to filter if needed
@@ -81,6 +112,79 @@ inline void FullFilterBlockBuilder::AddPrefix(const Slice& key) {
   }
 }
 
+void FullFilterBlockBuilder::AddAutoPrefix(const Slice& key) {
+  Slice last_key(last_auto_prefix_key_str_);
+  size_t common = CommonPrefixLength(last_key, key);
+  if (num_auto_prefix_keys_ > 0) {
+    if (common == key.size() && common == last_key.size()) {
+      // Another version of the last key
+      return;
+    }
+    ++key_prefix_length_histogram_[std::min(common, kMaxAutoPrefixLength)];
+  }
+  ++num_auto_prefix_keys_;
+  if (!auto_prefix_picked_) {
+    auto_prefix_samples_.emplace_back(
+        key.data(), std::min(key.size(), kMaxAutoPrefixLength));
+    if (auto_prefix_samples_.size() >= kAutoPrefixSampleKeys) {
+      PickAutoPrefix();
+    }
+  } else if (auto_prefix_length_ > 0 && key.size() >= auto_prefix_length_ &&
+             (num_auto_prefix_keys_ == 1 || common < auto_prefix_length_)) {
+    // The keys sharing the prefix with the last one are added already
+    AddKey(Slice(key.data(), auto_prefix_length_));
+  }
+  last_auto_prefix_key_str_.assign(key.data(), key.size());
+}
+
+void FullFilterBlockBuilder::PickAutoPrefix() {
+  assert(!auto_prefix_picked_);
+  auto_prefix_picked_ = true;
+  auto_prefix_length_ = PickAutoPrefixLength(auto_prefix_samples_);
+  if (auto_prefix_length_ > 0) {
+    Slice last_prefix;
+    for (auto& sample : auto_prefix_samples_) {
+      if (sample.size() < auto_prefix_length_) {
+        continue;
+      }
+      Slice prefix(sample.data(), auto_prefix_length_);
+      if (last_prefix.empty() || prefix != last_prefix) {
+        AddKey(prefix);
+        last_prefix = prefix;
+      }
+    }
+  }
+  std::vector<std::string>().swap(auto_prefix_samples_);
+}
+
+size_t FullFilterBlockBuilder::PickAutoPrefixLength(
+    const std::vector<std::string>& keys) {
+  if (keys.size() < kMinAutoPrefixSampleKeys) {
+    return 0;
+  }
+  std::vector<size_t> common_count(kMaxAutoPrefixLength + 1);
+  for (size_t i = 1; i < keys.size(); ++i) {
+    size_t common = CommonPrefixLength(keys[i - 1], keys[i]);
+    ++common_count[std::min(common, kMaxAutoPrefixLength)];
+  }
+  // A key starts a new prefix of length l when it shares less than l bytes
+  // with the key before it
+  size_t best_length = 0;
+  size_t best_prefixes = 1;
+  size_t prefixes = 1;
+  for (size_t length = 1; length <= kMaxAutoPrefixLength; ++length) {
+    prefixes += common_count[length - 1];
+    if (prefixes * kMinKeysPerAutoPrefix > keys.size()) {
+      break;
+    }
+    if (prefixes > best_prefixes) {
+      best_length = length;
+      best_prefixes = prefixes;
+    }
+  }
+  return best_length;
+}
+
 void FullFilterBlockBuilder::Reset() {
   last_whole_key_recorded_ = false;
   last_prefix_recorded_ = false;
@@ -91,6 +195,9 @@ Slice FullFilterBlockBuilder::Finish(const BlockHandle& /*tmp*/,
   Reset();
   // In this impl we ignore BlockHandle
   *status = Status::OK();
+  if (auto_prefix_filtering_ && !auto_prefix_picked_) {
+    PickAutoPrefix();
+  }
   if (num_added_ != 0) {
     num_added_ = 0;
     return filter_bits_builder_->Finish(&filter_data_);
@@ -98,6 +205,25 @@ Slice FullFilterBlockBuilder::Finish(const BlockHandle& /*tmp*/,
   return Slice();
 }
 
+void FullFilterBlockBuilder::AddProperties(
+    UserCollectedProperties* properties) const {
+  if (!auto_prefix_filtering_ || num_auto_prefix_keys_ == 0) {
+    return;
+  }
+  if (auto_prefix_length_ > 0) {
+    std::string length;
+    PutVarint64(&length, auto_prefix_length_);
+    properties->emplace(BlockBasedTablePropertyNames::kAutoPrefixLength,
+                        std::move(length));
+  }
+  std::string histogram;
+  for (uint64_t count : key_prefix_length_histogram_) {
+    PutVarint64(&histogram, count);
+  }
+  properties->emplace(BlockBasedTablePropertyNames::kKeyPrefixLengthHistogram,
+                      std::move(histogram));
+}
+
 FullFilterBlockReader::FullFilterBlockReader(
     const SliceTransform* prefix_extractor, bool _whole_key_filtering,
     const Slice& contents, FilterBitsReader* filter_bits_reader,
@@ -36,11 +36,16 @@ class FilterBitsReader;
 // The full filter can be very large. At the end of it, we put
 // num_probes: how many hash functions are used in bloom filter
 //
+// Without a prefix extractor, auto_prefix_filtering picks a prefix length
+// from the common prefixes of the first keys, and adds the prefixes of that
+// length to the filter too. The length goes to the table properties, with the
+// histogram of the common prefix lengths of adjacent keys.
 class FullFilterBlockBuilder : public FilterBlockBuilder {
  public:
   explicit FullFilterBlockBuilder(const SliceTransform* prefix_extractor,
                                   bool whole_key_filtering,
-                                  FilterBitsBuilder* filter_bits_builder);
+                                  FilterBitsBuilder* filter_bits_builder,
+                                  bool auto_prefix_filtering = false);
   // bits_builder is created in filter_policy, it should be passed in here
   // directly. and be deleted here
   ~FullFilterBlockBuilder() {}
@@ -51,6 +56,17 @@ class FullFilterBlockBuilder : public FilterBlockBuilder {
   virtual size_t NumAdded() const override { return num_added_; }
   virtual Slice Finish(const BlockHandle& tmp, Status* status) override;
   using FilterBlockBuilder::Finish;
+  virtual void AddProperties(
+      UserCollectedProperties* properties) const override;
+
+  // The longest common prefix tracked for the auto prefix
+  static const size_t kMaxAutoPrefixLength = 32;
+
+  // The prefix length splitting the sorted distinct keys into the most
+  // prefixes, still kMinKeysPerAutoPrefix keys each on average, the shortest
+  // one of them. Keys are looked at up to kMaxAutoPrefixLength bytes, 0 when
+  // there are too few keys or no such prefix
+  static size_t PickAutoPrefixLength(const std::vector<std::string>& keys);
 
  protected:
   virtual void AddKey(const Slice& key);
@@ -71,7 +87,20 @@ class FullFilterBlockBuilder : public FilterBlockBuilder {
   uint32_t num_added_;
   std::unique_ptr<const char[]> filter_data_;
 
+  bool auto_prefix_filtering_;
+  bool auto_prefix_picked_;
+  size_t auto_prefix_length_;
+  uint64_t num_auto_prefix_keys_;
+  std::string last_auto_prefix_key_str_;
+  // The first keys, cut to kMaxAutoPrefixLength, until the length is picked
+  std::vector<std::string> auto_prefix_samples_;
+  // Entry i counts the adjacent distinct keys sharing i bytes, the last one
+  // kMaxAutoPrefixLength bytes or more
+  std::vector<uint64_t> key_prefix_length_histogram_;
+
   void AddPrefix(const Slice& key);
+  void AddAutoPrefix(const Slice& key);
+  void PickAutoPrefix();
 
   // No copying allowed
   FullFilterBlockBuilder(const FullFilterBlockBuilder&);
@@ -55,6 +55,9 @@ GetContext::GetContext(const Comparator* ucmp,
       env_(env),
       seq_(seq),
       min_seq_type_(0),
+      first_seq_type_(0),
+      value_meta_projection_(false),
+      value_projected_(false),
       callback_(callback),
       is_index_(false),
       is_finished_(false) {
@@ -170,6 +173,11 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
       }
     }
 
+    if (state_ == kNotFound) {
+      first_seq_type_ =
+          PackSequenceAndType(parsed_key.sequence, parsed_key.type);
+    }
+
     auto type = parsed_key.type;
     // Key matches. Process it
     if ((type == kTypeValue || type == kTypeMerge || type == kTypeValueIndex ||
@@ -179,6 +187,16 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
       type = kTypeRangeDeletion;
       value.clear();
     }
+    if (lazy_val_ == nullptr && seq_ != nullptr) {
+      // Only the sequence of the latest record is asked for, the merges and
+      // separated values behind it are not resolved
+      state_ = type == kTypeDeletion || type == kTypeSingleDeletion ||
+                       type == kTypeRangeDeletion
+                   ? kDeleted
+                   : kFound;
+      is_finished_ = true;
+      return false;
+    }
     auto OK = [this](Status&& s) {
       if (LIKELY(s.ok())) {
         return true;
@@ -201,6 +219,17 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
           }
           return Finish();
         }
+        if (value_meta_projection_ && kNotFound == state_) {
+          // The value meta is stored beside the index, the blob SST is not
+          // read
+          state_ = kFound;
+          value_projected_ = true;
+          if (LIKELY(lazy_val_ != nullptr) && OK(value.fetch())) {
+            lazy_val_->reset(SeparateHelper::DecodeValueMeta(value.slice()),
+                             true /* copy */);
+          }
+          return Finish();
+        }
         value = separate_helper_->TransToCombined(user_key_,
                                                   parsed_key.sequence, value);
         FALLTHROUGH_INTENDED;
@@ -294,6 +323,11 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
           }
           return Finish();
         }
+        if (merge_operator_ != nullptr) {
+          MergeHelper::TimedPartialMergeBatch(merge_operator_, user_key_,
+                                              merge_context_, logger_,
+                                              statistics_, env_);
+        }
         return true;
 
       default:
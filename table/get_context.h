@@ -86,11 +86,28 @@ class GetContext {
 
   bool is_finished() const { return is_finished_; }
 
+  // The latest separated value is answered by its value meta, see
+  // ReadOptions::value_projection_is_meta
+  void SetValueMetaProjection() { value_meta_projection_ = true; }
+  // The found value is the value meta of a separated value
+  bool value_projected() const { return value_projected_; }
+
   void SetMinSequenceAndType(uint64_t min_seq_type) {
     min_seq_type_ = min_seq_type;
   }
   uint64_t GetMinSequenceAndType() const { return min_seq_type_; }
 
+  // The result will only depend on the newest entry of the key in a file, so
+  // it can be served and filled by the row cache
+  bool RowCacheable() const {
+    return state_ == kNotFound && lazy_val_ != nullptr &&
+           separate_helper_ != nullptr && callback_ == nullptr &&
+           min_seq_type_ == 0 && !value_meta_projection_;
+  }
+  // Sequence and type of the entry which resolved a kNotFound state
+  uint64_t first_seq_type() const { return first_seq_type_; }
+  LazyBuffer* lazy_val() { return lazy_val_; }
+
   bool CheckCallback(SequenceNumber seq) {
     if (callback_) {
       return callback_->IsVisible(seq);
@@ -121,6 +138,9 @@ class GetContext {
   SequenceNumber* seq_;
   // For Merge, don't accept key while seq type less than min_seq_type
   uint64_t min_seq_type_;
+  uint64_t first_seq_type_;
+  bool value_meta_projection_;
+  bool value_projected_;
   ReadCallback* callback_;
   bool sample_;
   bool is_index_;
@@ -173,6 +173,27 @@ TEST_F(MergerTest, SeekToLastTest) {
   }
 }
 
+TEST_F(MergerTest, SmallFanInNextTest) {
+  Generate(6, 500, 3);
+  SeekToFirst();
+  AssertEquivalence();
+  Next(5000);
+  for (int i = 0; i < 10; ++i) {
+    SeekToRandom();
+    AssertEquivalence();
+    Next(500);
+  }
+}
+
+TEST_F(MergerTest, SmallFanInRandomTest) {
+  Generate(8, 200, 10);
+  for (int i = 0; i < 10; ++i) {
+    SeekToRandom();
+    AssertEquivalence();
+    NextAndPrev(2000);
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -32,6 +32,86 @@ namespace TERARKDB_NAMESPACE {
 namespace {
 typedef BinaryHeap<IteratorWrapper*, MaxIteratorComparator> MergerMaxIterHeap;
 typedef BinaryHeap<IteratorWrapper*, MinIteratorComparator> MergerMinIterHeap;
+
+// Replaces MergerMinIterHeap for a few children: they are kept sorted by
+// current key in a small array, smallest first. A top which stays smallest
+// after Next costs one comparison, and moving it down walks the array
+// without the heap's index arithmetic.
+class MergerSmallMinIterArray {
+ public:
+  static const size_t kMaxSize = 8;
+
+  explicit MergerSmallMinIterArray(const InternalKeyComparator* comparator)
+      : comparator_(comparator),
+        bytewise_(comparator->user_comparator() == BytewiseComparator()),
+        size_(0) {}
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  IteratorWrapper* top() const {
+    assert(size_ > 0);
+    return items_[0];
+  }
+  IteratorWrapper* at(size_t i) const { return items_[i]; }
+
+  void push(IteratorWrapper* iter) {
+    assert(size_ < kMaxSize);
+    uint64_t fence = Fence(iter);
+    size_t i = size_++;
+    for (; i > 0 && Less(iter, fence, i - 1); --i) {
+      items_[i] = items_[i - 1];
+      fences_[i] = fences_[i - 1];
+    }
+    items_[i] = iter;
+    fences_[i] = fence;
+  }
+
+  // The key of the top changed, move it to its place
+  void replace_top(IteratorWrapper* iter) {
+    assert(size_ > 0 && items_[0] == iter);
+    uint64_t fence = Fence(iter);
+    size_t i = 0;
+    for (; i + 1 < size_ && !Less(iter, fence, i + 1); ++i) {
+      items_[i] = items_[i + 1];
+      fences_[i] = fences_[i + 1];
+    }
+    items_[i] = iter;
+    fences_[i] = fence;
+  }
+
+  void pop() {
+    assert(size_ > 0);
+    --size_;
+    for (size_t i = 0; i < size_; ++i) {
+      items_[i] = items_[i + 1];
+      fences_[i] = fences_[i + 1];
+    }
+  }
+
+  void clear() { size_ = 0; }
+
+ private:
+  uint64_t Fence(IteratorWrapper* iter) const {
+    return bytewise_ ? UserKeyFence(ExtractUserKey(iter->key())) : 0;
+  }
+
+  // Whether iter, whose fence is given, sorts before items_[i]. Distinct
+  // fences decide under the bytewise comparator, only ties need the keys
+  bool Less(IteratorWrapper* iter, uint64_t fence, size_t i) const {
+    if (fence != fences_[i]) {
+      return fence < fences_[i];
+    }
+    return comparator_->Compare(iter->key(), items_[i]->key()) < 0;
+  }
+
+  const InternalKeyComparator* comparator_;
+  // Fences are only meaningful for the bytewise comparator, with any other
+  // comparator they are all zero and every comparison falls through
+  const bool bytewise_;
+  size_t size_;
+  IteratorWrapper* items_[kMaxSize];
+  uint64_t fences_[kMaxSize];
+};
 }  // namespace
 
 const size_t kNumIterReserve = 4;
@@ -46,6 +126,9 @@ class MergingIterator : public InternalIterator {
         current_(nullptr),
         direction_(kForward),
         minHeap_(comparator_),
+        smallMinHeap_(comparator_),
+        use_small_heap_(static_cast<size_t>(n) <=
+                        MergerSmallMinIterArray::kMaxSize),
         prefix_seek_mode_(prefix_seek_mode) {
     children_.resize(n);
     for (int i = 0; i < n; i++) {
@@ -54,7 +137,7 @@ class MergingIterator : public InternalIterator {
     for (auto& child : children_) {
       if (child.Valid()) {
         assert(child.status().ok());
-        minHeap_.push(&child);
+        MinHeapPush(&child);
       } else {
         considerStatus(child.status());
       }
@@ -71,10 +154,19 @@ class MergingIterator : public InternalIterator {
   virtual void AddIterator(InternalIterator* iter) {
     assert(direction_ == kForward);
     children_.emplace_back(iter);
+    if (use_small_heap_ &&
+        children_.size() > MergerSmallMinIterArray::kMaxSize) {
+      // Too many children for the array, continue with the heap
+      for (size_t i = 0; i < smallMinHeap_.size(); ++i) {
+        minHeap_.push(smallMinHeap_.at(i));
+      }
+      smallMinHeap_.clear();
+      use_small_heap_ = false;
+    }
     auto new_wrapper = children_.back();
     if (new_wrapper.Valid()) {
       assert(new_wrapper.status().ok());
-      minHeap_.push(&new_wrapper);
+      MinHeapPush(&new_wrapper);
       current_ = CurrentForward();
     } else {
       considerStatus(new_wrapper.status());
@@ -100,7 +192,7 @@ class MergingIterator : public InternalIterator {
       child.SeekToFirst();
       if (child.Valid()) {
         assert(child.status().ok());
-        minHeap_.push(&child);
+        MinHeapPush(&child);
       } else {
         considerStatus(child.status());
       }
@@ -139,7 +231,7 @@ class MergingIterator : public InternalIterator {
       if (child.Valid()) {
         assert(child.status().ok());
         PERF_TIMER_GUARD(seek_min_heap_time);
-        minHeap_.push(&child);
+        MinHeapPush(&child);
       } else {
         considerStatus(child.status());
       }
@@ -203,11 +295,19 @@ class MergingIterator : public InternalIterator {
       // replace_top() to restore the heap property.  When the same child
       // iterator yields a sequence of keys, this is cheap.
       assert(current_->status().ok());
-      minHeap_.replace_top(current_);
+      if (use_small_heap_) {
+        smallMinHeap_.replace_top(current_);
+      } else {
+        minHeap_.replace_top(current_);
+      }
     } else {
       // current stopped being valid, remove it from the heap.
       considerStatus(current_->status());
-      minHeap_.pop();
+      if (use_small_heap_) {
+        smallMinHeap_.pop();
+      } else {
+        minHeap_.pop();
+      }
     }
     current_ = CurrentForward();
   }
@@ -302,6 +402,9 @@ class MergingIterator : public InternalIterator {
   enum Direction { kForward, kReverse };
   Direction direction_;
   MergerMinIterHeap minHeap_;
+  // Used instead of minHeap_ while there are few children
+  MergerSmallMinIterArray smallMinHeap_;
+  bool use_small_heap_;
   bool prefix_seek_mode_;
 
   // Max heap is used for reverse iteration, which is way less common than
@@ -310,8 +413,19 @@ class MergingIterator : public InternalIterator {
 
   void SwitchToForward();
 
+  void MinHeapPush(IteratorWrapper* child) {
+    if (use_small_heap_) {
+      smallMinHeap_.push(child);
+    } else {
+      minHeap_.push(child);
+    }
+  }
+
   IteratorWrapper* CurrentForward() const {
     assert(direction_ == kForward);
+    if (use_small_heap_) {
+      return !smallMinHeap_.empty() ? smallMinHeap_.top() : nullptr;
+    }
     return !minHeap_.empty() ? minHeap_.top() : nullptr;
   }
 
@@ -337,7 +451,7 @@ void MergingIterator::SwitchToForward() {
       }
     }
     if (child.Valid()) {
-      minHeap_.push(&child);
+      MinHeapPush(&child);
     }
   }
   direction_ = kForward;
@@ -345,6 +459,7 @@ void MergingIterator::SwitchToForward() {
 
 void MergingIterator::ClearHeaps() {
   minHeap_.clear();
+  smallMinHeap_.clear();
   if (maxHeap_) {
     maxHeap_->clear();
   }
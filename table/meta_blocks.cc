@@ -231,7 +231,8 @@ Status ReadProperties(const Slice& handle_value, RandomAccessFileReader* file,
   ReadOptions read_options;
   read_options.verify_checksums = false;
   Status s;
-  Slice compression_dict;
+  const UncompressionDict& compression_dict =
+      UncompressionDict::GetEmptyDict();
   PersistentCacheOptions cache_options;
 
   BlockFetcher block_fetcher(file, prefetch_buffer, footer, read_options,
@@ -456,7 +457,8 @@ Status ReadTableProperties(RandomAccessFileReader* file, uint64_t file_size,
   BlockContents metaindex_contents;
   ReadOptions read_options;
   read_options.verify_checksums = false;
-  Slice compression_dict;
+  const UncompressionDict& compression_dict =
+      UncompressionDict::GetEmptyDict();
   PersistentCacheOptions cache_options;
 
   BlockFetcher block_fetcher(file, nullptr /* prefetch_buffer */, footer,
@@ -526,7 +528,8 @@ Status FindMetaBlock(RandomAccessFileReader* file, uint64_t file_size,
   BlockContents metaindex_contents;
   ReadOptions read_options;
   read_options.verify_checksums = false;
-  Slice compression_dict;
+  const UncompressionDict& compression_dict =
+      UncompressionDict::GetEmptyDict();
   PersistentCacheOptions cache_options;
   BlockFetcher block_fetcher(
       file, nullptr /* prefetch_buffer */, footer, read_options,
@@ -569,7 +572,8 @@ Status ReadMetaBlock(RandomAccessFileReader* file,
   BlockContents metaindex_contents;
   ReadOptions read_options;
   read_options.verify_checksums = false;
-  Slice compression_dict;
+  const UncompressionDict& compression_dict =
+      UncompressionDict::GetEmptyDict();
   PersistentCacheOptions cache_options;
 
   BlockFetcher block_fetcher(file, prefetch_buffer, footer, read_options,
@@ -112,4 +112,51 @@ Status PersistentCacheHelper::LookupUncompressedPage(
   return Status::OK();
 }
 
+namespace {
+void DeleteAdmissionEntry(const Slice& /*key*/, void* /*value*/) {}
+}  // namespace
+
+void PersistentCacheHelper::InsertRecord(
+    const PersistentCacheOptions& cache_options, const Slice& record_key,
+    const char* data, const size_t size) {
+  assert(cache_options.persistent_cache);
+
+  // construct the record key
+  std::string key = cache_options.key_prefix;
+  key.append(record_key.data(), record_key.size());
+  Cache* admission_cache = cache_options.admission_cache;
+  if (admission_cache != nullptr) {
+    auto handle = admission_cache->Lookup(key);
+    if (handle == nullptr) {
+      // first miss, only remember the key
+      admission_cache->Insert(key, nullptr, key.size(), &DeleteAdmissionEntry);
+      return;
+    }
+    admission_cache->Release(handle);
+    admission_cache->Erase(key);
+  }
+  // insert record to cache
+  cache_options.persistent_cache->Insert(key, data, size);
+}
+
+Status PersistentCacheHelper::LookupRecord(
+    const PersistentCacheOptions& cache_options, const Slice& record_key,
+    std::unique_ptr<char[]>* data, size_t* size) {
+  assert(cache_options.persistent_cache);
+
+  // construct the record key
+  std::string key = cache_options.key_prefix;
+  key.append(record_key.data(), record_key.size());
+  // Lookup record
+  Status s = cache_options.persistent_cache->Lookup(key, data, size);
+  if (!s.ok()) {
+    // cache miss
+    RecordTick(cache_options.statistics, PERSISTENT_CACHE_MISS);
+    return s;
+  }
+  // cache hit
+  RecordTick(cache_options.statistics, PERSISTENT_CACHE_HIT);
+  return Status::OK();
+}
+
 }  // namespace TERARKDB_NAMESPACE
@@ -40,6 +40,17 @@ class PersistentCacheHelper {
   static Status LookupUncompressedPage(
       const PersistentCacheOptions& cache_options, const BlockHandle& handle,
       BlockContents* contents);
+
+  // insert a value record, keyed by key_prefix (the file) and record_key (the
+  // record in the file). admitted on its second miss if admission_cache is set
+  static void InsertRecord(const PersistentCacheOptions& cache_options,
+                           const Slice& record_key, const char* data,
+                           const size_t size);
+
+  // lookup a value record inserted by InsertRecord
+  static Status LookupRecord(const PersistentCacheOptions& cache_options,
+                             const Slice& record_key,
+                             std::unique_ptr<char[]>* data, size_t* size);
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -7,6 +7,7 @@
 #include <string>
 
 #include "monitoring/statistics.h"
+#include "rocksdb/cache.h"
 #include "rocksdb/persistent_cache.h"
 #include "rocksdb/terark_namespace.h"
 
@@ -30,6 +31,9 @@ struct PersistentCacheOptions {
   std::shared_ptr<PersistentCache> persistent_cache;
   std::string key_prefix;
   Statistics* statistics = nullptr;
+  // Key only cache of recently missed records. When set, a record is written
+  // to persistent_cache on its second miss only
+  Cache* admission_cache = nullptr;
 };
 
 }  // namespace TERARKDB_NAMESPACE
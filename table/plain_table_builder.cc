@@ -62,6 +62,7 @@ PlainTableBuilder::PlainTableBuilder(
     : ioptions_(builder_options.ioptions),
       moptions_(builder_options.moptions),
       bloom_block_(num_probes),
+      range_del_block_(1 /* block_restart_interval */),
       file_(file),
       bloom_bits_per_key_(bloom_bits_per_key),
       huge_page_tlb_size_(huge_page_tlb_size),
@@ -177,6 +178,23 @@ Status PlainTableBuilder::Add(const Slice& key, const LazyBuffer& lazy_value) {
   return Status::OK();
 }
 
+Status PlainTableBuilder::AddTombstone(const Slice& key,
+                                       const LazyBuffer& lazy_value) {
+  auto s = lazy_value.fetch();
+  if (!s.ok()) {
+    return s;
+  }
+  const Slice& value = lazy_value.slice();
+  assert(ExtractValueType(key) == kTypeRangeDeletion);
+  range_del_block_.Add(key, value);
+  ++properties_.num_range_deletions;
+  properties_.raw_key_size += key.size();
+  properties_.raw_value_size += value.size();
+  NotifyCollectTableCollectorsOnAdd(
+      key, value, offset_, table_properties_collectors_, ioptions_.info_log);
+  return Status::OK();
+}
+
 Status PlainTableBuilder::Finish(
     const TablePropertyCache* prop,
     const std::vector<SequenceNumber>* snapshots,
@@ -202,9 +220,10 @@ Status PlainTableBuilder::Finish(
   //  Write the following blocks
   //  1. [meta block: bloom] - optional
   //  2. [meta block: index] - optional
-  //  3. [meta block: properties]
-  //  4. [metaindex block]
-  //  5. [footer]
+  //  3. [meta block: range deletions] - optional
+  //  4. [meta block: properties]
+  //  5. [metaindex block]
+  //  6. [footer]
 
   MetaIndexBuilder meta_index_builer;
 
@@ -248,6 +267,16 @@ Status PlainTableBuilder::Finish(
                           index_block_handle);
   }
 
+  if (!range_del_block_.empty()) {
+    BlockHandle range_del_block_handle;
+    Status s = WriteBlock(range_del_block_.Finish(), file_, &offset_,
+                          &range_del_block_handle);
+    if (!s.ok()) {
+      return s;
+    }
+    meta_index_builer.Add(kRangeDelBlock, range_del_block_handle);
+  }
+
   // Calculate bloom block size and index block size
   PropertyBlockBuilder property_block_builder;
   // -- Add basic properties
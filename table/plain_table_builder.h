@@ -15,6 +15,7 @@
 #include "rocksdb/table.h"
 #include "rocksdb/table_properties.h"
 #include "rocksdb/terark_namespace.h"
+#include "table/block_builder.h"
 #include "table/bloom_block.h"
 #include "table/plain_table_index.h"
 #include "table/plain_table_key_coding.h"
@@ -49,6 +50,9 @@ class PlainTableBuilder : public TableBuilder {
   // REQUIRES: Finish(), Abandon() have not been called
   Status Add(const Slice& key, const LazyBuffer& value) override;
 
+  // Range deletions are kept in a meta block, as in the block based table
+  Status AddTombstone(const Slice& key, const LazyBuffer& value) override;
+
   // Finish building the table.  Stops using the file passed to the
   // constructor after this function returns.
   // REQUIRES: Finish(), Abandon() have not been called
@@ -82,6 +86,7 @@ class PlainTableBuilder : public TableBuilder {
       table_properties_collectors_;
 
   BloomBlockBuilder bloom_block_;
+  BlockBuilder range_del_block_;
   std::unique_ptr<PlainTableIndexBuilder> index_builder_;
 
   WritableFileWriter* file_;
@@ -6,6 +6,7 @@
 
 #include "table/plain_table_reader.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -75,6 +76,12 @@ class PlainTableIterator : public InternalIterator {
   Status status() const override;
 
  private:
+  // Seeks without the prefix hash index
+  void SeekInTotalOrder(const Slice& target);
+
+  // Positions at the last record starting before limit
+  void SeekToLastBefore(uint32_t limit);
+
   PlainTableReader* table_;
   PlainTableKeyDecoder decoder_;
   bool use_prefix_seek_;
@@ -182,6 +189,11 @@ Status PlainTableReader::Open(const ImmutableCFOptions& ioptions,
     return s;
   }
 
+  s = new_reader->ReadRangeDelBlock();
+  if (!s.ok()) {
+    return s;
+  }
+
   if (!full_scan_mode) {
     s = new_reader->PopulateIndex(props, bloom_bits_per_key, hash_table_ratio,
                                   index_sparseness, huge_page_tlb_size);
@@ -212,6 +224,75 @@ InternalIterator* PlainTableReader::NewIterator(
   }
 }
 
+FragmentedRangeTombstoneIterator* PlainTableReader::NewRangeTombstoneIterator(
+    const ReadOptions& read_options) {
+  if (fragmented_range_dels_ == nullptr) {
+    return nullptr;
+  }
+  SequenceNumber snapshot = kMaxSequenceNumber;
+  if (read_options.snapshot != nullptr) {
+    snapshot = read_options.snapshot->GetSequenceNumber();
+  }
+  return new FragmentedRangeTombstoneIterator(
+      fragmented_range_dels_, internal_comparator_, snapshot);
+}
+
+Status PlainTableReader::ReadRangeDelBlock() {
+  BlockContents range_del_block_contents;
+  Status s = ReadMetaBlock(file_info_.file.get(), nullptr /* prefetch_buffer */,
+                           file_size_, kPlainTableMagicNumber, ioptions_,
+                           kRangeDelBlock, &range_del_block_contents,
+                           true /* compression_type_missing */);
+  if (!s.ok()) {
+    // Not found, the table has no range deletion
+    return Status::OK();
+  }
+  // The fragmented list copies the tombstones, the block may go away
+  Block range_del_block(std::move(range_del_block_contents),
+                        kDisableGlobalSequenceNumber);
+  std::unique_ptr<InternalIteratorBase<Slice>> iter(
+      range_del_block.NewIterator<DataBlockIter>(
+          &internal_comparator_, internal_comparator_.user_comparator()));
+  s = iter->status();
+  if (!s.ok()) {
+    return s;
+  }
+  fragmented_range_dels_ = std::make_shared<FragmentedRangeTombstoneList>(
+      std::move(iter), internal_comparator_);
+  return Status::OK();
+}
+
+Status PlainTableReader::PopulateSampledOffsets() {
+  std::call_once(sampled_offsets_once_, [this] {
+    PlainTableKeyDecoder decoder(&file_info_, encoding_type_, user_key_len_,
+                                 prefix_extractor_);
+    uint32_t pos = data_start_offset_;
+    uint64_t num_records = 0;
+    bool sample_pending = false;
+    while (pos < file_info_.data_end_offset) {
+      uint32_t record_offset = pos;
+      ParsedInternalKey key;
+      Slice value;
+      bool seekable = false;
+      Status s = Next(&decoder, &pos, &key, nullptr, &value, &seekable);
+      if (!s.ok()) {
+        sampled_offsets_status_ = s;
+        sampled_offsets_.clear();
+        return;
+      }
+      if (num_records++ % kSampleInterval == 0) {
+        sample_pending = true;
+      }
+      if (sample_pending && seekable) {
+        sampled_offsets_.push_back(record_offset);
+        sample_pending = false;
+      }
+    }
+    sampled_offsets_.shrink_to_fit();
+  });
+  return sampled_offsets_status_;
+}
+
 Status PlainTableReader::PopulateIndexRecordList(
     PlainTableIndexBuilder* index_builder, vector<uint32_t>* prefix_hashes) {
   Slice prev_key_prefix_slice;
@@ -670,21 +751,13 @@ void PlainTableIterator::SeekToFirst() {
 }
 
 void PlainTableIterator::SeekToLast() {
-  assert(false);
-  status_ = Status::NotSupported("SeekToLast() is not supported in PlainTable");
-  next_offset_ = offset_ = table_->file_info_.data_end_offset;
+  SeekToLastBefore(table_->file_info_.data_end_offset);
 }
 
 void PlainTableIterator::Seek(const Slice& target) {
   if (use_prefix_seek_ != !table_->IsTotalOrderMode()) {
-    // This check is done here instead of NewIterator() to permit creating an
-    // iterator with total_order_seek = true even if we won't be able to Seek()
-    // it. This is needed for compaction: it creates iterator with
-    // total_order_seek = true but usually never does Seek() on it,
-    // only SeekToFirst().
-    status_ = Status::InvalidArgument(
-        "total_order_seek not implemented for PlainTable.");
-    offset_ = next_offset_ = table_->file_info_.data_end_offset;
+    // total_order_seek on a table with a prefix hash index
+    SeekInTotalOrder(target);
     return;
   }
 
@@ -744,11 +817,85 @@ void PlainTableIterator::Seek(const Slice& target) {
   }
 }
 
-void PlainTableIterator::SeekForPrev(const Slice& /*target*/) {
-  assert(false);
-  status_ =
-      Status::NotSupported("SeekForPrev() is not supported in PlainTable");
-  offset_ = next_offset_ = table_->file_info_.data_end_offset;
+void PlainTableIterator::SeekInTotalOrder(const Slice& target) {
+  status_ = table_->PopulateSampledOffsets();
+  if (!status_.ok()) {
+    offset_ = next_offset_ = table_->file_info_.data_end_offset;
+    return;
+  }
+  ParsedInternalKey parsed_target;
+  if (!ParseInternalKey(target, &parsed_target)) {
+    status_ = Status::Corruption(Slice());
+    offset_ = next_offset_ = table_->file_info_.data_end_offset;
+    return;
+  }
+  // Find the first sample not less than target, the records from the sample
+  // before it on are scanned
+  const auto& samples = table_->sampled_offsets_;
+  size_t low = 0;
+  size_t high = samples.size();
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    ParsedInternalKey mid_key;
+    uint32_t tmp;
+    status_ = decoder_.NextKeyNoValue(samples[mid], &mid_key, nullptr, &tmp);
+    if (!status_.ok()) {
+      offset_ = next_offset_ = table_->file_info_.data_end_offset;
+      return;
+    }
+    if (table_->internal_comparator_.Compare(mid_key, parsed_target) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  next_offset_ = low == 0 ? table_->data_start_offset_ : samples[low - 1];
+  for (Next(); status_.ok() && Valid(); Next()) {
+    if (table_->internal_comparator_.Compare(key(), target) >= 0) {
+      break;
+    }
+  }
+}
+
+void PlainTableIterator::SeekToLastBefore(uint32_t limit) {
+  status_ = table_->PopulateSampledOffsets();
+  if (!status_.ok()) {
+    offset_ = next_offset_ = table_->file_info_.data_end_offset;
+    return;
+  }
+  const auto& samples = table_->sampled_offsets_;
+  auto it = std::lower_bound(samples.begin(), samples.end(), limit);
+  if (it == samples.begin()) {
+    offset_ = next_offset_ = table_->file_info_.data_end_offset;
+    return;
+  }
+  uint32_t pos = *--it;
+  ParsedInternalKey parsed_key;
+  for (;;) {
+    uint32_t record_offset = pos;
+    status_ = table_->Next(&decoder_, &pos, &parsed_key, &key_, &value_);
+    if (!status_.ok()) {
+      offset_ = next_offset_ = table_->file_info_.data_end_offset;
+      return;
+    }
+    if (pos >= limit) {
+      offset_ = record_offset;
+      next_offset_ = pos;
+      return;
+    }
+  }
+}
+
+void PlainTableIterator::SeekForPrev(const Slice& target) {
+  SeekInTotalOrder(target);
+  if (!status_.ok()) {
+    return;
+  }
+  if (!Valid()) {
+    SeekToLast();
+  } else if (table_->internal_comparator_.Compare(key(), target) > 0) {
+    Prev();
+  }
 }
 
 void PlainTableIterator::Next() {
@@ -764,7 +911,10 @@ void PlainTableIterator::Next() {
   }
 }
 
-void PlainTableIterator::Prev() { assert(false); }
+void PlainTableIterator::Prev() {
+  assert(Valid());
+  SeekToLastBefore(offset_);
+}
 
 Slice PlainTableIterator::key() const {
   assert(Valid());
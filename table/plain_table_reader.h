@@ -8,11 +8,13 @@
 #include <stdint.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "db/dbformat.h"
+#include "db/range_tombstone_fragmenter.h"
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
 #include "rocksdb/slice_transform.h"
@@ -87,6 +89,9 @@ class PlainTableReader : public TableReader {
                                 bool skip_filters = false,
                                 bool for_compaction = false) override;
 
+  FragmentedRangeTombstoneIterator* NewRangeTombstoneIterator(
+      const ReadOptions& read_options) override;
+
   void Prepare(const Slice& target) override;
 
   Status Get(const ReadOptions& readOptions, const Slice& key,
@@ -140,6 +145,8 @@ class PlainTableReader : public TableReader {
 
   Status MmapDataIfNeeded();
 
+  Status ReadRangeDelBlock();
+
  private:
   const InternalKeyComparator internal_comparator_;
   EncodingType encoding_type_;
@@ -173,6 +180,18 @@ class PlainTableReader : public TableReader {
   Cache::Handle* table_cache_handle_;
   port::Mutex table_cache_mutex_;
 
+  std::shared_ptr<const FragmentedRangeTombstoneList> fragmented_range_dels_;
+
+  // Offsets of every kSampleInterval-th record, or of the first seekable
+  // record after it with prefix encoding. The prefix hash index can't serve
+  // seeks across prefixes, so total order seeks, SeekToLast() and Prev()
+  // search these instead. Built by the first of them, which a map SST
+  // depending on this table issues.
+  static const uint32_t kSampleInterval = 16;
+  std::once_flag sampled_offsets_once_;
+  std::vector<uint32_t> sampled_offsets_;
+  Status sampled_offsets_status_;
+
   bool IsFixedLength() const {
     return user_key_len_ != kPlainTableVariableLength;
   }
@@ -243,6 +262,9 @@ class PlainTableReader : public TableReader {
 
   bool IsTotalOrderMode() const { return (prefix_extractor_ == nullptr); }
 
+  // Fills sampled_offsets_ once
+  Status PopulateSampledOffsets();
+
   // No copying allowed
   explicit PlainTableReader(const TableReader&) = delete;
   void operator=(const TableReader&) = delete;
@@ -5,14 +5,19 @@
 
 #include "rocksdb/sst_file_writer.h"
 
+#include <algorithm>
+#include <deque>
 #include <vector>
 
 #include "db/dbformat.h"
+#include "port/port.h"
 #include "rocksdb/table.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/block_based_table_builder.h"
 #include "table/sst_file_writer_collectors.h"
 #include "util/file_reader_writer.h"
+#include "util/mutexlock.h"
+#include "util/string_util.h"
 #include "util/sync_point.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -307,6 +312,233 @@ Status SstFileWriter::Finish(ExternalSstFileInfo* file_info) {
 }
 
 uint64_t SstFileWriter::FileSize() { return rep_->file_info.file_size; }
+
+struct ParallelSstFileWriter::Rep {
+  struct Entry {
+    std::string key;
+    std::string value;
+    ValueType type;
+  };
+  // The entries of one output file
+  struct Chunk {
+    std::string file_path;
+    std::vector<Entry> entries;
+    ExternalSstFileInfo file_info;
+    Status status;
+  };
+
+  Rep(const EnvOptions& _env_options, const Options& _options,
+      ColumnFamilyHandle* _cfh, int _max_threads, uint64_t _target_file_size)
+      : env_options(_env_options),
+        options(_options),
+        cfh(_cfh),
+        max_threads(std::max(1, _max_threads)),
+        target_file_size(std::max<uint64_t>(1, _target_file_size)),
+        opened(false),
+        has_last_key(false),
+        current_size(0),
+        in_flight(0),
+        closing(false),
+        cv(&mu) {}
+
+  ~Rep() { StopThreads(); }
+
+  Status Add(const Slice& user_key, const Slice& value, ValueType type) {
+    if (!opened) {
+      return Status::InvalidArgument("File is not opened");
+    }
+    if (has_last_key &&
+        options.comparator->Compare(user_key, last_key) <= 0) {
+      // Make sure that keys are added in order, across files too
+      return Status::InvalidArgument("Keys must be added in order");
+    }
+    if (current == nullptr) {
+      current.reset(new Chunk);
+      current->file_path = file_prefix + ToString(in_building.size()) + ".sst";
+    }
+    current->entries.push_back(
+        Entry{user_key.ToString(), value.ToString(), type});
+    last_key.assign(user_key.data(), user_key.size());
+    has_last_key = true;
+    current_size += user_key.size() + value.size();
+    if (current_size >= target_file_size) {
+      Seal();
+    }
+    return Status::OK();
+  }
+
+  // Hands the current chunk to the builder threads, waits while all of them
+  // are busy so that the buffered entries stay bounded
+  void Seal() {
+    if (current == nullptr) {
+      return;
+    }
+    Chunk* chunk = current.get();
+    in_building.push_back(std::move(current));
+    current_size = 0;
+    MutexLock l(&mu);
+    while (in_flight >= static_cast<size_t>(max_threads)) {
+      cv.Wait();
+    }
+    ++in_flight;
+    queue.push_back(chunk);
+    cv.SignalAll();
+  }
+
+  void BackgroundBuild() {
+    while (true) {
+      Chunk* chunk;
+      {
+        MutexLock l(&mu);
+        while (queue.empty() && !closing) {
+          cv.Wait();
+        }
+        if (queue.empty()) {
+          return;
+        }
+        chunk = queue.front();
+        queue.pop_front();
+      }
+      Build(chunk);
+      MutexLock l(&mu);
+      --in_flight;
+      cv.SignalAll();
+    }
+  }
+
+  void Build(Chunk* chunk) {
+    SstFileWriter writer(env_options, options, cfh);
+    Status s = writer.Open(chunk->file_path);
+    for (auto& entry : chunk->entries) {
+      if (!s.ok()) {
+        break;
+      }
+      switch (entry.type) {
+        case kTypeValue:
+          s = writer.Put(entry.key, entry.value);
+          break;
+        case kTypeMerge:
+          s = writer.Merge(entry.key, entry.value);
+          break;
+        default:
+          s = writer.Delete(entry.key);
+          break;
+      }
+    }
+    if (s.ok()) {
+      s = writer.Finish(&chunk->file_info);
+    }
+    // Release the buffered entries as soon as the file is built
+    std::vector<Entry>().swap(chunk->entries);
+    chunk->status = s;
+  }
+
+  void StopThreads() {
+    {
+      MutexLock l(&mu);
+      closing = true;
+      cv.SignalAll();
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    threads.clear();
+  }
+
+  EnvOptions env_options;
+  Options options;
+  ColumnFamilyHandle* cfh;
+  int max_threads;
+  uint64_t target_file_size;
+  std::string file_prefix;
+  bool opened;
+  bool has_last_key;
+  std::string last_key;
+  std::unique_ptr<Chunk> current;
+  uint64_t current_size;
+  // Chunks handed to the builder threads, in key order. They are kept
+  // until Finish collects their results
+  std::vector<std::unique_ptr<Chunk>> in_building;
+
+  port::Mutex mu;
+  // Chunks queued or being built
+  size_t in_flight;
+  std::deque<Chunk*> queue;
+  bool closing;
+  port::CondVar cv;
+  std::vector<port::Thread> threads;
+};
+
+ParallelSstFileWriter::ParallelSstFileWriter(const EnvOptions& env_options,
+                                             const Options& options,
+                                             ColumnFamilyHandle* column_family,
+                                             int max_threads,
+                                             uint64_t target_file_size)
+    : rep_(new Rep(env_options, options, column_family, max_threads,
+                   target_file_size)) {}
+
+ParallelSstFileWriter::~ParallelSstFileWriter() {}
+
+Status ParallelSstFileWriter::Open(const std::string& file_prefix) {
+  Rep* r = rep_.get();
+  if (r->opened) {
+    return Status::InvalidArgument("Writer is already opened");
+  }
+  r->file_prefix = file_prefix;
+  r->opened = true;
+  r->closing = false;
+  for (int i = 0; i < r->max_threads; ++i) {
+    r->threads.emplace_back(&Rep::BackgroundBuild, r);
+  }
+  return Status::OK();
+}
+
+Status ParallelSstFileWriter::Put(const Slice& user_key, const Slice& value) {
+  return rep_->Add(user_key, value, kTypeValue);
+}
+
+Status ParallelSstFileWriter::Merge(const Slice& user_key,
+                                    const Slice& value) {
+  return rep_->Add(user_key, value, kTypeMerge);
+}
+
+Status ParallelSstFileWriter::Delete(const Slice& user_key) {
+  return rep_->Add(user_key, Slice(), kTypeDeletion);
+}
+
+Status ParallelSstFileWriter::Finish(
+    std::vector<ExternalSstFileInfo>* file_infos) {
+  Rep* r = rep_.get();
+  if (!r->opened) {
+    return Status::InvalidArgument("File is not opened");
+  }
+  r->Seal();
+  r->StopThreads();
+  r->opened = false;
+
+  Status s;
+  if (r->in_building.empty()) {
+    s = Status::InvalidArgument("Cannot create sst file with no entries");
+  }
+  for (auto& chunk : r->in_building) {
+    if (s.ok() && !chunk->status.ok()) {
+      s = chunk->status;
+    }
+  }
+  if (file_infos != nullptr) {
+    file_infos->clear();
+  }
+  for (auto& chunk : r->in_building) {
+    if (!s.ok()) {
+      r->options.env->DeleteFile(chunk->file_path);
+    } else if (file_infos != nullptr) {
+      file_infos->push_back(chunk->file_info);
+    }
+  }
+  r->in_building.clear();
+  r->has_last_key = false;
+  return s;
+}
 #endif  // !ROCKSDB_LITE
 
 }  // namespace TERARKDB_NAMESPACE
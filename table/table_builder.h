@@ -18,6 +18,7 @@
 #include "db/dbformat.h"
 #include "db/table_properties_collector.h"
 #include "options/cf_options.h"
+#include "rocksdb/listener.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table_properties.h"
 #include "rocksdb/terark_namespace.h"
@@ -86,7 +87,8 @@ struct TableBuilderOptions {
       const std::string* _compression_dict, bool _skip_filters,
       const std::string& _column_family_name, int _level,
       double _compaction_load, uint64_t _creation_time = 0,
-      int64_t _oldest_key_time = 0, SstPurpose _sst_purpose = kEssenceSst)
+      int64_t _oldest_key_time = 0, SstPurpose _sst_purpose = kEssenceSst,
+      CompactionReason _compaction_reason = CompactionReason::kUnknown)
       : ioptions(_ioptions),
         moptions(_moptions),
         internal_comparator(_internal_comparator),
@@ -100,7 +102,8 @@ struct TableBuilderOptions {
         compaction_load(_compaction_load),
         creation_time(_creation_time),
         oldest_key_time(_oldest_key_time),
-        sst_purpose(_sst_purpose) {}
+        sst_purpose(_sst_purpose),
+        compaction_reason(_compaction_reason) {}
   const ImmutableCFOptions& ioptions;
   const MutableCFOptions& moptions;
   const InternalKeyComparator& internal_comparator;
@@ -118,6 +121,8 @@ struct TableBuilderOptions {
   const uint64_t creation_time;
   const int64_t oldest_key_time;
   const SstPurpose sst_purpose;
+  // kUnknown for flush and other non compaction builds
+  const CompactionReason compaction_reason;
   Slice smallest_user_key;
   Slice largest_user_key;
 
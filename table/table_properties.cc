@@ -5,6 +5,9 @@
 
 #include "rocksdb/table_properties.h"
 
+#include <mutex>
+#include <unordered_set>
+
 #include "port/port.h"
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
@@ -18,6 +21,14 @@ namespace TERARKDB_NAMESPACE {
 const uint32_t TablePropertiesCollectorFactory::Context::kUnknownColumnFamily =
     port::kMaxInt32;
 
+const std::string* InternTablePropertyString(const Slice& str) {
+  static std::mutex mutex;
+  // Leaked, readers may outlive static destruction
+  static auto* strings = new std::unordered_set<std::string>;
+  std::lock_guard<std::mutex> lock(mutex);
+  return &*strings->emplace(str.data(), str.size()).first;
+}
+
 namespace {
 void AppendProperty(std::string& props, const std::string& key,
                     const std::string& value, const std::string& prop_delim,
@@ -235,6 +246,8 @@ const std::string TablePropertiesNames::kEarliestTimeBeginCompact =
     "rocksdb.compact.earliest-time-begin";
 const std::string TablePropertiesNames::kLatestTimeEndCompact =
     "rocksdb.compact.latest-time-end";
+const std::string TablePropertiesNames::kTtlExpiryHistogram =
+    "rocksdb.compact.ttl-expiry-histogram";
 
 extern const std::string kPropertiesBlock = "rocksdb.properties";
 // Old property block name for backward compatibility
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "rocksdb/iterator.h"
 #include "rocksdb/status.h"
 #include "rocksdb/terark_namespace.h"
@@ -29,4 +31,9 @@ Status SeekToCompressionDictBlock(InternalIteratorBase<Slice>* meta_iter,
 Status SeekToRangeDelBlock(InternalIteratorBase<Slice>* meta_iter,
                            bool* is_found, BlockHandle* block_handle);
 
+// Returns the process-wide copy of a table property string, such as the name
+// of a prefix extractor, for readers that keep few properties resident
+// without a copy per file. The copies live until exit.
+const std::string* InternTablePropertyString(const Slice& str);
+
 }  // namespace TERARKDB_NAMESPACE
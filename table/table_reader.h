@@ -74,6 +74,11 @@ class TableReader {
   // Report an approximation of how much memory has been used.
   virtual size_t ApproximateMemoryUsage() const = 0;
 
+  // Parts of the memory usage: bytes of the index in memory, of an mmap'd
+  // index only the resident pages, and bytes of the compression dictionaries
+  virtual size_t ApproximateIndexMemoryUsage() const { return 0; }
+  virtual size_t ApproximateDictMemoryUsage() const { return 0; }
+
   virtual uint64_t FileNumber() const = 0;
 
   // Calls get_context->SaveValue() repeatedly, starting with
@@ -92,6 +97,20 @@ class TableReader {
                      const SliceTransform* prefix_extractor,
                      bool skip_filters = false) = 0;
 
+  // Looks up num_keys keys, sorted by the internal comparator, statuses[i]
+  // is the status Get would return for keys[i]. Implementations may share
+  // filter, index and data block reads within the batch
+  virtual void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                        const Slice* keys, GetContext** get_contexts,
+                        Status* statuses,
+                        const SliceTransform* prefix_extractor,
+                        bool skip_filters = false) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      statuses[i] = Get(readOptions, keys[i], get_contexts[i],
+                        prefix_extractor, skip_filters);
+    }
+  }
+
   // Logic same as for(it->Seek(begin); it->Valid() && callback(*it); ++it) {}
   // Specialization for performance
   virtual void RangeScan(const Slice* begin,
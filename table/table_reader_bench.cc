@@ -11,6 +11,13 @@ int main() {
 }
 #else
 
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <sys/resource.h>
+
 #include "db/db_impl.h"
 #include "db/dbformat.h"
 #include "monitoring/histogram.h"
@@ -23,6 +30,7 @@ int main() {
 #include "table/internal_iterator.h"
 #include "table/plain_table_factory.h"
 #include "table/table_builder.h"
+#include "table/terark_zip_table.h"
 #include "util/file_reader_writer.h"
 #include "util/gflags_compat.h"
 #include "util/testharness.h"
@@ -255,6 +263,189 @@ void TableReaderBenchmark(Options& opts, EnvOptions& env_options,
     DestroyDB(dbname, opts);
   }
 }
+
+// Builds a table of num_keys1 * num_keys2 keys directly through the table
+// factory and measures the build, the Get of existing and missing keys,
+// Seek followed by seek_nexts Next and a full reverse scan. The results are
+// printed as one JSON object per table when json is true, so they can be
+// compared across runs.
+void TableSuiteBenchmark(Options& opts, EnvOptions& env_options,
+                         ReadOptions& read_options, int num_keys1,
+                         int num_keys2, int num_iter, int value_size,
+                         int seek_nexts, bool json) {
+  TERARKDB_NAMESPACE::InternalKeyComparator ikc(opts.comparator);
+  std::string file_name =
+      test::PerThreadDBPath("rocksdb_table_reader_benchmark");
+  Env* env = Env::Default();
+  Status s;
+  const ImmutableCFOptions ioptions(opts);
+  const ColumnFamilyOptions cfo(opts);
+  const MutableCFOptions moptions(cfo, env);
+
+  std::unique_ptr<WritableFile> file;
+  s = env->NewWritableFile(file_name, &file, env_options);
+  if (!s.ok()) {
+    fprintf(stderr, "Create File Error: %s\n", s.ToString().c_str());
+    exit(1);
+  }
+  std::vector<std::unique_ptr<IntTblPropCollectorFactory> >
+      int_tbl_prop_collector_factories;
+  std::unique_ptr<WritableFileWriter> file_writer(
+      new WritableFileWriter(std::move(file), file_name, env_options));
+  int unknown_level = -1;
+  uint64_t build_start = env->NowMicros();
+  std::unique_ptr<TableBuilder> tb(opts.table_factory->NewTableBuilder(
+      TableBuilderOptions(
+          ioptions, moptions, ikc, &int_tbl_prop_collector_factories,
+          CompressionType::kNoCompression, CompressionOptions(),
+          nullptr /* compression_dict */, false /* skip_filters */,
+          kDefaultColumnFamilyName, unknown_level, 0 /* compaction_load */),
+      0 /* column_family_id */, file_writer.get()));
+  Random rnd(301);
+  std::string value;
+  uint64_t raw_size = 0;
+  for (int i = 0; i < num_keys1; i++) {
+    for (int j = 0; j < num_keys2; j++) {
+      std::string key = MakeKey(i * 2, j, false /* through_db */);
+      if (value_size > 0) {
+        test::CompressibleString(&rnd, 0.5, value_size, &value);
+      } else {
+        value = key;
+      }
+      tb->Add(key, LazyBuffer(value));
+      raw_size += key.size() + value.size();
+    }
+  }
+  s = tb->Finish(nullptr, nullptr);
+  if (s.ok()) {
+    s = file_writer->Close();
+  }
+  if (!s.ok()) {
+    fprintf(stderr, "Build Table Error: %s\n", s.ToString().c_str());
+    exit(1);
+  }
+  uint64_t build_micros = env->NowMicros() - build_start;
+  tb.reset();
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  uint64_t peak_rss_kb = static_cast<uint64_t>(usage.ru_maxrss);
+
+  std::unique_ptr<RandomAccessFile> raf;
+  s = env->NewRandomAccessFile(file_name, &raf, env_options);
+  if (!s.ok()) {
+    fprintf(stderr, "Create File Error: %s\n", s.ToString().c_str());
+    exit(1);
+  }
+  uint64_t file_size = 0;
+  env->GetFileSize(file_name, &file_size);
+  std::unique_ptr<RandomAccessFileReader> file_reader(
+      new RandomAccessFileReader(std::move(raf), file_name));
+  std::unique_ptr<TableReader> table_reader;
+  uint64_t open_start = env->NowMicros();
+  s = opts.table_factory->NewTableReader(
+      TableReaderOptions(ioptions, moptions.prefix_extractor.get(),
+                         env_options, ikc),
+      std::move(file_reader), file_size, &table_reader);
+  if (!s.ok()) {
+    fprintf(stderr, "Open Table Error: %s\n", s.ToString().c_str());
+    exit(1);
+  }
+  uint64_t open_micros = env->NowMicros() - open_start;
+
+  // Get of existing and missing keys, in nanos
+  HistogramImpl hit_hist, miss_hist;
+  uint64_t num_gets = static_cast<uint64_t>(num_keys1) * num_keys2 * num_iter;
+  for (int miss = 0; miss < 2; miss++) {
+    HistogramImpl& hist = miss ? miss_hist : hit_hist;
+    for (uint64_t n = 0; n < num_gets; n++) {
+      int r1 = rnd.Uniform(num_keys1) * 2 + miss;
+      int r2 = rnd.Uniform(num_keys2);
+      std::string key = MakeKey(r1, r2, false /* through_db */);
+      LazyBuffer lazy_val;
+      MergeContext merge_context;
+      SequenceNumber max_covering_tombstone_seq = 0;
+      uint64_t start = env->NowNanos();
+      GetContext get_context(ioptions.user_comparator, ioptions.merge_operator,
+                             ioptions.info_log, ioptions.statistics,
+                             GetContext::kNotFound, ExtractUserKey(key),
+                             &lazy_val, nullptr, &merge_context, nullptr,
+                             &max_covering_tombstone_seq, env);
+      s = table_reader->Get(read_options, key, &get_context, nullptr);
+      if (s.ok()) {
+        s = lazy_val.fetch();
+      }
+      hist.Add(env->NowNanos() - start);
+      if (!s.ok()) {
+        fprintf(stderr, "Get Error: %s\n", s.ToString().c_str());
+        exit(1);
+      }
+    }
+  }
+
+  // Seek followed by seek_nexts Next
+  std::unique_ptr<InternalIterator> iter(
+      table_reader->NewIterator(read_options, nullptr));
+  uint64_t num_seeks = num_gets;
+  uint64_t seek_start = env->NowNanos();
+  for (uint64_t n = 0; n < num_seeks; n++) {
+    std::string key = MakeKey(rnd.Uniform(num_keys1) * 2,
+                              rnd.Uniform(num_keys2), false /* through_db */);
+    iter->Seek(key);
+    for (int k = 0; k < seek_nexts && iter->Valid(); k++) {
+      iter->value().fetch();
+      iter->Next();
+    }
+  }
+  uint64_t seek_nanos = env->NowNanos() - seek_start;
+
+  // Reverse scan of the whole table
+  uint64_t num_prev = 0;
+  uint64_t reverse_start = env->NowNanos();
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    iter->value().fetch();
+    num_prev++;
+  }
+  uint64_t reverse_nanos = env->NowNanos() - reverse_start;
+  size_t reader_memory = table_reader->ApproximateMemoryUsage();
+  iter.reset();
+  table_reader.reset();
+  env->DeleteFile(file_name);
+
+  double seek_ops = seek_nanos > 0 ? num_seeks * 1e9 / seek_nanos : 0;
+  double reverse_ops = reverse_nanos > 0 ? num_prev * 1e9 / reverse_nanos : 0;
+  if (json) {
+    fprintf(stdout,
+            "{\"table_factory\": \"%s\", \"num_keys\": %" PRIu64
+            ", \"raw_bytes\": %" PRIu64 ", \"file_bytes\": %" PRIu64
+            ", \"build_micros\": %" PRIu64 ", \"open_micros\": %" PRIu64
+            ", \"peak_rss_kb\": %" PRIu64 ", \"reader_memory_bytes\": %zu"
+            ", \"get_hit_nanos_p50\": %.1f, \"get_hit_nanos_p99\": %.1f"
+            ", \"get_miss_nanos_p50\": %.1f, \"get_miss_nanos_p99\": %.1f"
+            ", \"seek_next_ops_per_sec\": %.1f"
+            ", \"reverse_scan_keys_per_sec\": %.1f}\n",
+            opts.table_factory->Name(),
+            static_cast<uint64_t>(num_keys1) * num_keys2, raw_size, file_size,
+            build_micros, open_micros, peak_rss_kb, reader_memory,
+            hit_hist.Percentile(50), hit_hist.Percentile(99),
+            miss_hist.Percentile(50), miss_hist.Percentile(99), seek_ops,
+            reverse_ops);
+  } else {
+    fprintf(stdout,
+            "Table: %s  keys: %d x %d\n"
+            "Build: %.3f seconds, peak RSS %" PRIu64 " KB\n"
+            "File: %" PRIu64 " bytes of %" PRIu64
+            " raw bytes, opened in %.3f seconds, reader memory %zu bytes\n"
+            "Seek + %d Next: %.1f ops/sec\n"
+            "Reverse scan: %.1f keys/sec\n"
+            "Get hit (unit: nanosecond):\n%s"
+            "Get miss (unit: nanosecond):\n%s",
+            opts.table_factory->Name(), num_keys1, num_keys2,
+            build_micros / 1e6, peak_rss_kb, file_size, raw_size,
+            open_micros / 1e6, reader_memory, seek_nexts, seek_ops,
+            reverse_ops, hit_hist.ToString().c_str(),
+            miss_hist.ToString().c_str());
+  }
+}
 }  // namespace
 }  // namespace TERARKDB_NAMESPACE
 
@@ -272,11 +463,35 @@ DEFINE_bool(through_db, false,
             "a table reader.");
 DEFINE_bool(mmap_read, true, "Whether use mmap read");
 DEFINE_string(table_factory, "block_based",
-              "Table factory to use: `block_based` (default), `plain_table` or "
-              "`cuckoo_hash`.");
+              "Table factory to use: `block_based` (default), `plain_table`, "
+              "`cuckoo_hash` or `terark_zip`.");
 DEFINE_string(time_unit, "microsecond",
               "The time unit used for measuring performance. User can specify "
               "`microsecond` (default) or `nanosecond`");
+DEFINE_bool(suite, false,
+            "Build the table directly and measure the build, Get of existing "
+            "and missing keys, Seek + Next and reverse scan instead.");
+DEFINE_bool(json, false, "Print the results of --suite as JSON.");
+DEFINE_int32(value_size, 0,
+             "Value size of --suite, 0 uses the key as the value.");
+DEFINE_int32(seek_nexts, 16, "Number of Next after each Seek of --suite.");
+#ifdef WITH_TERARK_ZIP
+DEFINE_string(terark_index_type,
+              TERARKDB_NAMESPACE::TerarkZipTableOptions().indexType,
+              "TerarkZipTableOptions::indexType, `auto` picks it per part.");
+DEFINE_double(terark_sample_ratio,
+              TERARKDB_NAMESPACE::TerarkZipTableOptions().sampleRatio,
+              "TerarkZipTableOptions::sampleRatio of the value dictionary.");
+DEFINE_int32(terark_checksum_level,
+             TERARKDB_NAMESPACE::TerarkZipTableOptions().checksumLevel,
+             "TerarkZipTableOptions::checksumLevel, 0 to 3.");
+DEFINE_string(terark_entropy_algo, "none",
+              "TerarkZipTableOptions::entropyAlgo: `none`, `huffman` or "
+              "`fse`.");
+DEFINE_bool(terark_enable_entropy_store,
+            TERARKDB_NAMESPACE::TerarkZipTableOptions().enableEntropyStore,
+            "TerarkZipTableOptions::enableEntropyStore.");
+#endif  // WITH_TERARK_ZIP
 
 int main(int argc, char** argv) {
   SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
@@ -324,6 +539,31 @@ int main(int argc, char** argv) {
 #endif  // ROCKSDB_LITE
   } else if (FLAGS_table_factory == "block_based") {
     tf.reset(new TERARKDB_NAMESPACE::BlockBasedTableFactory());
+  } else if (FLAGS_table_factory == "terark_zip") {
+#ifdef WITH_TERARK_ZIP
+    options.allow_mmap_reads = FLAGS_mmap_read;
+    env_options.use_mmap_reads = FLAGS_mmap_read;
+
+    TERARKDB_NAMESPACE::TerarkZipTableOptions tzto;
+    tzto.localTempDir = TERARKDB_NAMESPACE::test::TmpDir();
+    tzto.indexType = FLAGS_terark_index_type;
+    tzto.sampleRatio = FLAGS_terark_sample_ratio;
+    tzto.checksumLevel = FLAGS_terark_checksum_level;
+    tzto.enableEntropyStore = FLAGS_terark_enable_entropy_store;
+    if (FLAGS_terark_entropy_algo == "huffman") {
+      tzto.entropyAlgo = TERARKDB_NAMESPACE::TerarkZipTableOptions::kHuffman;
+    } else if (FLAGS_terark_entropy_algo == "fse") {
+      tzto.entropyAlgo = TERARKDB_NAMESPACE::TerarkZipTableOptions::kFSE;
+    } else if (FLAGS_terark_entropy_algo != "none") {
+      fprintf(stderr, "Invalid entropy algo %s\n",
+              FLAGS_terark_entropy_algo.c_str());
+      exit(1);
+    }
+    tf.reset(TERARKDB_NAMESPACE::NewTerarkZipTableFactory(tzto, nullptr));
+#else
+    fprintf(stderr, "TerarkZipTable was not enabled\n");
+    exit(1);
+#endif  // WITH_TERARK_ZIP
   } else {
     fprintf(stderr, "Invalid table type %s\n", FLAGS_table_factory.c_str());
   }
@@ -333,6 +573,12 @@ int main(int argc, char** argv) {
     bool measured_by_nanosecond = FLAGS_time_unit == "nanosecond";
 
     options.table_factory = tf;
+    if (FLAGS_suite) {
+      TERARKDB_NAMESPACE::TableSuiteBenchmark(
+          options, env_options, ro, FLAGS_num_keys1, FLAGS_num_keys2,
+          FLAGS_iter, FLAGS_value_size, FLAGS_seek_nexts, FLAGS_json);
+      return 0;
+    }
     TERARKDB_NAMESPACE::TableReaderBenchmark(
         options, env_options, ro, FLAGS_num_keys1, FLAGS_num_keys2, FLAGS_iter,
         FLAGS_prefix_len, FLAGS_query_empty, FLAGS_iterator, FLAGS_through_db,
@@ -39,6 +39,7 @@
 #include "table/block_based_table_reader.h"
 #include "table/block_builder.h"
 #include "table/block_fetcher.h"
+#include "table/columnar_block.h"
 #include "table/format.h"
 #include "table/get_context.h"
 #include "table/internal_iterator.h"
@@ -275,7 +276,7 @@ class TableConstructor : public Constructor {
     builder.reset(ioptions.table_factory->NewTableBuilder(
         TableBuilderOptions(ioptions, moptions, internal_comparator,
                             &int_tbl_prop_collector_factories,
-                            options.compression, CompressionOptions(),
+                            options.compression, options.compression_opts,
                             nullptr /* compression_dict */,
                             false /* skip_filters */, column_family_name,
                             level_, 0 /* compaction_load */),
@@ -663,7 +664,6 @@ class HarnessTest : public testing::Test {
 // Plain table is not supported in ROCKSDB_LITE
 #ifndef ROCKSDB_LITE
       case PLAIN_TABLE_SEMI_FIXED_PREFIX:
-        support_prev_ = false;
         only_support_prefix_seek_ = true;
         options_.prefix_extractor.reset(new FixedOrLessPrefixTransform(2));
         options_.table_factory.reset(NewPlainTableFactory());
@@ -673,7 +673,6 @@ class HarnessTest : public testing::Test {
             new InternalKeyComparator(options_.comparator));
         break;
       case PLAIN_TABLE_FULL_STR_PREFIX:
-        support_prev_ = false;
         only_support_prefix_seek_ = true;
         options_.prefix_extractor.reset(NewNoopTransform());
         options_.table_factory.reset(NewPlainTableFactory());
@@ -683,7 +682,6 @@ class HarnessTest : public testing::Test {
             new InternalKeyComparator(options_.comparator));
         break;
       case PLAIN_TABLE_TOTAL_ORDER:
-        support_prev_ = false;
         only_support_prefix_seek_ = false;
         options_.prefix_extractor = nullptr;
 
@@ -1132,6 +1130,69 @@ TEST_P(BlockBasedTableTest, IndexUncompressed) {
 }
 #endif  // SNAPPY
 
+TEST_P(BlockBasedTableTest, ParallelCompression) {
+  CompressionType compression = kNoCompression;
+  for (auto type : {kSnappyCompression, kZlibCompression, kLZ4Compression,
+                    kZSTD}) {
+    if (CompressionTypeSupported(type)) {
+      compression = type;
+      break;
+    }
+  }
+  if (compression == kNoCompression) {
+    fprintf(stderr, "skipping parallel compression test\n");
+    return;
+  }
+
+  Random rnd(301);
+  TableConstructor c(BytewiseComparator(), true /* convert_to_internal_key_ */);
+  std::string tmp;
+  for (int i = 0; i < 2000; ++i) {
+    c.Add("key" + ToString(100000 + i),
+          test::CompressibleString(&rnd, 0.25, 300, &tmp));
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  Options options;
+  options.compression = compression;
+  options.compression_opts.parallel_threads = 4;
+  options.statistics = CreateDBStatistics();
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.block_size = 1024;
+  table_options.enable_index_compression = false;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  ImmutableCFOptions ioptions(options);
+  MutableCFOptions moptions(options);
+  ioptions.statistics = options.statistics.get();
+  c.Finish(options, ioptions, moptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+
+  auto& props = *c.GetTableReader()->GetTableProperties();
+  ASSERT_GT(props.num_data_blocks, 100U);
+  ASSERT_EQ(props.num_data_blocks,
+            options.statistics->getTickerCount(NUMBER_BLOCK_COMPRESSED));
+
+  // Every block is found through its index entry, in order
+  std::unique_ptr<InternalIterator> iter(
+      c.NewIterator(moptions.prefix_extractor.get()));
+  iter->SeekToFirst();
+  for (auto& kv : kvmap) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(kv.first, iter->key().ToString());
+    auto value = iter->value();
+    ASSERT_OK(value.fetch());
+    ASSERT_EQ(kv.second, value.slice().ToString());
+    iter->Next();
+  }
+  ASSERT_FALSE(iter->Valid());
+  iter->Seek(keys[keys.size() / 2]);
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(keys[keys.size() / 2], iter->key().ToString());
+  iter.reset();
+  c.ResetTableReader();
+}
+
 TEST_P(BlockBasedTableTest, BlockBasedTableProperties2) {
   TableConstructor c(&reverse_key_comparator);
   std::vector<std::string> keys;
@@ -3350,7 +3411,8 @@ TEST_P(BlockBasedTableTest, PropertiesBlockRestartPointTest) {
                                 BlockContents* contents) {
       ReadOptions read_options;
       read_options.verify_checksums = false;
-      Slice compression_dict;
+      const UncompressionDict& compression_dict =
+          UncompressionDict::GetEmptyDict();
       PersistentCacheOptions cache_options;
 
       BlockFetcher block_fetcher(
@@ -3437,7 +3499,8 @@ TEST_P(BlockBasedTableTest, PropertiesMetaBlockLast) {
   // read metaindex
   auto metaindex_handle = footer.metaindex_handle();
   BlockContents metaindex_contents;
-  Slice compression_dict;
+  const UncompressionDict& compression_dict =
+      UncompressionDict::GetEmptyDict();
   PersistentCacheOptions pcache_opts;
   BlockFetcher block_fetcher(
       table_reader.get(), nullptr /* prefetch_buffer */, footer, ReadOptions(),
@@ -3534,6 +3597,170 @@ TEST_F(BBTTailPrefetchTest, FilePrefetchBufferMinOffset) {
   ASSERT_EQ(480, buffer.min_offset_read());
 }
 
+TEST_P(BlockBasedTableTest, MultiGet) {
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.block_size = 256;
+  table_options.no_block_cache = true;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+
+  Options options;
+  options.comparator = BytewiseComparator();
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+
+  TableConstructor c(options.comparator);
+  for (int i = 0; i < 200; i++) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "k%04d", i * 2);
+    InternalKey k(buf, 0, kTypeValue);
+    c.Add(k.Encode().ToString(), std::string(40, 'a' + i % 26));
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  const ImmutableCFOptions ioptions(options);
+  const MutableCFOptions moptions(options);
+  const InternalKeyComparator internal_comparator(options.comparator);
+  c.Finish(options, ioptions, moptions, table_options, internal_comparator,
+           &keys, &kvmap);
+  auto reader = c.GetTableReader();
+
+  // Existing and missing keys, sorted
+  const size_t kBatch = 64;
+  std::vector<std::string> user_keys;
+  std::vector<std::string> internal_keys;
+  for (size_t i = 0; i < kBatch; i++) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "k%04d", static_cast<int>(i * 3));
+    user_keys.emplace_back(buf);
+    internal_keys.emplace_back(
+        InternalKey(buf, kMaxSequenceNumber, kValueTypeForSeek)
+            .Encode()
+            .ToString());
+  }
+
+  // One by one
+  std::vector<std::string> expected(kBatch);
+  std::vector<GetContext::GetState> expected_states;
+  get_perf_context()->Reset();
+  for (size_t i = 0; i < kBatch; i++) {
+    LazyBuffer value(&expected[i]);
+    GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                           GetContext::kNotFound, user_keys[i], &value,
+                           nullptr, nullptr, nullptr, nullptr, nullptr,
+                           nullptr);
+    ASSERT_OK(reader->Get(ReadOptions(), internal_keys[i], &get_context,
+                          moptions.prefix_extractor.get()));
+    ASSERT_OK(std::move(value).dump(&expected[i]));
+    expected_states.push_back(get_context.State());
+  }
+  uint64_t get_block_reads = get_perf_context()->block_read_count;
+
+  // In batch
+  std::vector<std::string> results(kBatch);
+  std::vector<LazyBuffer> values;
+  std::vector<std::unique_ptr<GetContext>> get_contexts;
+  std::vector<GetContext*> context_ptrs;
+  std::vector<Slice> key_slices;
+  for (size_t i = 0; i < kBatch; i++) {
+    values.emplace_back(&results[i]);
+  }
+  for (size_t i = 0; i < kBatch; i++) {
+    get_contexts.emplace_back(new GetContext(
+        options.comparator, nullptr, nullptr, nullptr, GetContext::kNotFound,
+        user_keys[i], &values[i], nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr));
+    context_ptrs.push_back(get_contexts.back().get());
+    key_slices.emplace_back(internal_keys[i]);
+  }
+  std::vector<Status> statuses(kBatch);
+  get_perf_context()->Reset();
+  reader->MultiGet(ReadOptions(), kBatch, key_slices.data(),
+                   context_ptrs.data(), statuses.data(),
+                   moptions.prefix_extractor.get());
+  uint64_t multi_get_block_reads = get_perf_context()->block_read_count;
+
+  for (size_t i = 0; i < kBatch; i++) {
+    ASSERT_OK(statuses[i]);
+    ASSERT_EQ(expected_states[i], get_contexts[i]->State());
+    ASSERT_OK(std::move(values[i]).dump(&results[i]));
+    ASSERT_EQ(expected[i], results[i]);
+  }
+  // Found keys sharing a block read it once
+  ASSERT_LT(multi_get_block_reads, get_block_reads);
+}
+
+TEST_P(BlockBasedTableTest, ValueColumnWidths) {
+  Options options;
+  if (Snappy_Supported()) {
+    options.compression = kSnappyCompression;
+  } else if (Zlib_Supported()) {
+    options.compression = kZlibCompression;
+  } else if (LZ4_Supported()) {
+    options.compression = kLZ4Compression;
+  } else {
+    return;
+  }
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.value_column_widths = "4:8";
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+
+  // Fixed columns followed by a variable rest, and values too short to fill
+  // the columns
+  TableConstructor c(BytewiseComparator(), true /* convert_to_internal_key */);
+  Random rnd(301);
+  for (int i = 0; i < 2000; i++) {
+    char id[4];
+    EncodeFixed32(id, i);
+    std::string value(id, sizeof(id));
+    if (i % 7 == 0) {
+      value.resize(i % 3);
+    } else {
+      value.append(ToString(i % 10 + 10000000));
+      value.append(RandomString(&rnd, i % 20));
+    }
+    c.Add("key" + ToString(100000 + i), value);
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  const ImmutableCFOptions ioptions(options);
+  const MutableCFOptions moptions(options);
+  c.Finish(options, ioptions, moptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+  ASSERT_GT(c.GetTableReader()->GetTableProperties()->num_data_blocks, 1);
+
+  std::unique_ptr<InternalIterator> iter(
+      c.NewIterator(moptions.prefix_extractor.get()));
+  auto expected = kvmap.begin();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++expected) {
+    ASSERT_TRUE(expected != kvmap.end());
+    ASSERT_EQ(iter->key().ToString(), expected->first);
+    auto v = iter->value();
+    ASSERT_OK(v.fetch());
+    ASSERT_EQ(v.slice().ToString(), expected->second);
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_TRUE(expected == kvmap.end());
+
+  // A block round trips through the columnar layout
+  std::vector<uint32_t> widths;
+  ASSERT_OK(ParseValueColumnWidths("4:8", &widths));
+  ASSERT_EQ(widths.size(), 2);
+  ASSERT_TRUE(ParseValueColumnWidths("4::8", &widths).IsInvalidArgument());
+  ASSERT_OK(ParseValueColumnWidths("4:8", &widths));
+  BlockBuilder block_builder(16);
+  for (auto& kv : kvmap) {
+    block_builder.Add(kv.first, kv.second);
+  }
+  Slice block = block_builder.Finish();
+  std::string columnar;
+  ASSERT_TRUE(EncodeColumnarBlock(block, widths, &columnar));
+  ASSERT_NE(columnar, block.ToString());
+  BlockContents contents;
+  ASSERT_OK(DecodeColumnarBlock(columnar, nullptr, &contents));
+  ASSERT_EQ(contents.data, block);
+  columnar.resize(columnar.size() / 2);
+  ASSERT_TRUE(DecodeColumnarBlock(columnar, nullptr, &contents).IsCorruption());
+}
+
 TEST_P(BlockBasedTableTest, DataBlockHashIndex) {
   const int kNumKeys = 500;
   const int kKeySize = 8;
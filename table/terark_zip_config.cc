@@ -144,8 +144,10 @@ void TerarkZipAutoConfigForBulkLoad(struct TerarkZipTableOptions& tzo,
   tzo.smallTaskMemory = memBytesLimit / 16;
   tzo.indexNestLevel = 3;
 
+  auto fallback = NewTerarkZipFallbackTableFactory();
   cfo.table_factory = SingleTerarkZipTableFactory(
-      tzo, std::shared_ptr<TableFactory>(NewAdaptiveTableFactory()));
+      tzo, std::shared_ptr<TableFactory>(
+               NewAdaptiveTableFactory(fallback, fallback)));
   cfo.write_buffer_size = tzo.smallTaskMemory;
   cfo.num_levels = 7;
   cfo.max_write_buffer_number = 16;
@@ -332,6 +334,10 @@ bool TerarkZipCFOptionsFromEnv(ColumnFamilyOptions& cfo,
   MyOverrideBool(tzo, optimizeCpuL3Cache);
   MyOverrideBool(tzo, forceMetaInMemory);
   MyOverrideBool(tzo, enableEntropyStore);
+  MyOverrideBool(tzo, indexInHugePage);
+  MyOverrideBool(tzo, skipExpiredRecords);
+  MyOverrideBool(tzo, inMemoryValueBuffer);
+  MyOverrideBool(tzo, deferChecksumVerify);
 
   MyOverrideDouble(tzo, sampleRatio);
   MyOverrideDouble(tzo, indexCacheRatio);
@@ -347,6 +353,10 @@ bool TerarkZipCFOptionsFromEnv(ColumnFamilyOptions& cfo,
   MyOverrideXiB(tzo, singleIndexMinSize);
   MyOverrideXiB(tzo, singleIndexMaxSize);
   MyOverrideXiB(tzo, cacheCapacityBytes);
+  MyOverrideXiB(tzo, indexResidentBytes);
+  MyOverrideInt(tzo, levelDictReuseCount);
+  MyOverrideInt(tzo, openParallelism);
+  MyOverrideXiB(tzo, persistentCacheAdmissionBytes);
   MyOverrideInt(tzo, cbtEntryPerTrie);
   MyOverrideInt(tzo, cbtMinKeySize);
   MyOverrideInt(tzo, cacheShards);
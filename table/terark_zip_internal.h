@@ -10,6 +10,7 @@
 #include <atomic>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/noncopyable.hpp>
+#include <map>
 #include <mutex>
 #include <terark/fstring.hpp>
 #include <terark/stdtypes.hpp>
@@ -54,11 +55,13 @@ extern const uint64_t kTerarkZipTableMagicNumber;
 
 extern const std::string kTerarkZipTableValueDictBlock;
 extern const std::string kTerarkZipTableOffsetBlock;
+extern const std::string kTerarkZipTableExpireBlock;
 extern const std::string kTerarkEmptyTableKey;
 extern const std::string kTerarkZipTableBuildTimestamp;
 extern const std::string kTerarkZipTableDictInfo;
 extern const std::string kTerarkZipTableDictSize;
 extern const std::string kTerarkZipTableEntropy;
+extern const std::string kTerarkZipTableIndexType;
 
 template <class ByteArray>
 inline Slice SliceOf(const ByteArray& ba) {
@@ -191,8 +194,34 @@ class TerarkZipTableFactory : public TableFactory, boost::noncopyable {
 
   bool IsBuilderNeedSecondPass() const override { return true; }
 
+  size_t GetBuilderMemoryUsage() const override {
+    return builder_working_mem_.load(std::memory_order_relaxed);
+  }
+  // The softZipWorkingMemLimit accounting of the builders of this factory
+  std::atomic<size_t>* builder_working_mem() const {
+    return &builder_working_mem_;
+  }
+
   LruReadonlyCache* cache() const { return cache_.get(); }
 
+  // Key only cache deciding which records go to persistentCache, nullptr if
+  // every missed record goes there
+  Cache* persistent_cache_admission() const {
+    return persistent_cache_admission_.get();
+  }
+
+  // levelDictReuseCount, the DictZip sample to reuse for the column family
+  // and level, nullptr if the builder should train a new one
+  std::shared_ptr<const std::string> AcquireLevelDict(uint32_t cf_id,
+                                                      int level) const;
+  void SaveLevelDict(uint32_t cf_id, int level, std::string&& sample) const;
+
+  // Decompressed dicts by hash of their dict block, shared between readers
+  std::shared_ptr<valvec<byte_t>> GetSharedDict(uint64_t hash) const;
+  // Returns the dict already shared under "hash" if any
+  std::shared_ptr<valvec<byte_t>> AddSharedDict(
+      uint64_t hash, std::shared_ptr<valvec<byte_t>> dict) const;
+
   Status GetOptionString(std::string* opt_string,
                          const std::string& delimiter) const
       TERARK_ROCKSDB_5008(override);
@@ -203,8 +232,18 @@ class TerarkZipTableFactory : public TableFactory, boost::noncopyable {
   TableFactory* adaptive_factory_;  // just for open table
   mutable std::mutex cache_create_mutex_;
   mutable boost::intrusive_ptr<LruReadonlyCache> cache_;
+  std::shared_ptr<Cache> persistent_cache_admission_;
   mutable size_t nth_new_terark_table_ = 0;
   mutable size_t nth_new_fallback_table_ = 0;
+  struct LevelDict {
+    std::shared_ptr<const std::string> sample;
+    size_t uses = 0;
+  };
+  mutable std::mutex dict_mutex_;
+  mutable std::map<std::pair<uint32_t, int>, LevelDict> level_dicts_;
+  mutable std::unordered_map<uint64_t, std::weak_ptr<valvec<byte_t>>>
+      shared_dicts_;
+  mutable std::atomic<size_t> builder_working_mem_{0};
 
  private:
   mutable CollectInfo collect_;
@@ -66,6 +66,7 @@ const uint64_t kTerarkZipTableMagicNumber = 0x1122334455667788;
 const std::string kTerarkZipTableValueDictBlock =
     "TerarkZipTableValueDictBlock";
 const std::string kTerarkZipTableOffsetBlock = "TerarkZipTableOffsetBlock";
+const std::string kTerarkZipTableExpireBlock = "TerarkZipTableExpireBlock";
 const std::string kTerarkEmptyTableKey = "ThisIsAnEmptyTable";
 
 using terark::XXHash64;
@@ -74,6 +75,7 @@ const std::string kTerarkZipTableBuildTimestamp = "terark.build.timestamp";
 const std::string kTerarkZipTableDictInfo = "terark.build.dict_info";
 const std::string kTerarkZipTableDictSize = "terark.build.dict_size";
 const std::string kTerarkZipTableEntropy = "terark.build.entropy";
+const std::string kTerarkZipTableIndexType = "terark.build.index_type";
 
 const size_t CollectInfo::queue_size = 1024;
 
@@ -178,6 +180,14 @@ std::shared_ptr<TableFactory> SingleTerarkZipTableFactory(
   return factory;
 }
 
+std::shared_ptr<TableFactory> NewTerarkZipFallbackTableFactory() {
+  BlockBasedTableOptions table_options;
+  table_options.data_block_index_type =
+      BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  return std::shared_ptr<TableFactory>(
+      NewBlockBasedTableFactory(table_options));
+}
+
 bool IsForwardBytewiseComparator(const fstring name) {
   if (name.startsWith("RocksDB_SE_")) {
     return true;
@@ -225,10 +235,62 @@ TerarkZipTableFactory::TerarkZipTableFactory(
     // turn off warmUpIndexOnOpen if forceMetaInMemory
     table_options_.warmUpIndexOnOpen = !tzto.forceMetaInMemory;
   }
+  if (tzto.persistentCache && tzto.persistentCacheAdmissionBytes > 0) {
+    persistent_cache_admission_ =
+        NewLRUCache(tzto.persistentCacheAdmissionBytes);
+  }
 }
 
 TerarkZipTableFactory::~TerarkZipTableFactory() { delete adaptive_factory_; }
 
+std::shared_ptr<const std::string> TerarkZipTableFactory::AcquireLevelDict(
+    uint32_t cf_id, int level) const {
+  std::lock_guard<std::mutex> lock(dict_mutex_);
+  auto find = level_dicts_.find(std::make_pair(cf_id, level));
+  if (find == level_dicts_.end() ||
+      find->second.uses >= table_options_.levelDictReuseCount) {
+    return nullptr;
+  }
+  ++find->second.uses;
+  return find->second.sample;
+}
+
+void TerarkZipTableFactory::SaveLevelDict(uint32_t cf_id, int level,
+                                          std::string&& sample) const {
+  auto shared = std::make_shared<const std::string>(std::move(sample));
+  std::lock_guard<std::mutex> lock(dict_mutex_);
+  auto& level_dict = level_dicts_[std::make_pair(cf_id, level)];
+  level_dict.sample = std::move(shared);
+  level_dict.uses = 0;
+}
+
+std::shared_ptr<valvec<byte_t>> TerarkZipTableFactory::GetSharedDict(
+    uint64_t hash) const {
+  std::lock_guard<std::mutex> lock(dict_mutex_);
+  auto find = shared_dicts_.find(hash);
+  return find == shared_dicts_.end() ? nullptr : find->second.lock();
+}
+
+std::shared_ptr<valvec<byte_t>> TerarkZipTableFactory::AddSharedDict(
+    uint64_t hash, std::shared_ptr<valvec<byte_t>> dict) const {
+  std::lock_guard<std::mutex> lock(dict_mutex_);
+  auto& weak = shared_dicts_[hash];
+  if (auto exists = weak.lock()) {
+    return exists;
+  }
+  weak = dict;
+  if (shared_dicts_.size() >= 64 && (shared_dicts_.size() & 63) == 0) {
+    for (auto it = shared_dicts_.begin(); it != shared_dicts_.end();) {
+      if (it->second.expired()) {
+        it = shared_dicts_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  return dict;
+}
+
 Status TerarkZipTableFactory::NewTableReader(
     const TableReaderOptions& table_reader_options,
     unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
@@ -560,6 +622,18 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"enableEntropyStore",
          {offsetof(struct TerarkZipTableOptions, enableEntropyStore),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"indexInHugePage",
+         {offsetof(struct TerarkZipTableOptions, indexInHugePage),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"skipExpiredRecords",
+         {offsetof(struct TerarkZipTableOptions, skipExpiredRecords),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"inMemoryValueBuffer",
+         {offsetof(struct TerarkZipTableOptions, inMemoryValueBuffer),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"deferChecksumVerify",
+         {offsetof(struct TerarkZipTableOptions, deferChecksumVerify),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"cbtHashBits",
          {offsetof(struct TerarkZipTableOptions, cbtHashBits),
           OptionType::kUInt, OptionVerificationType::kNormal, false, 0}},
@@ -617,6 +691,18 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"cbtMinKeyRatio",
          {offsetof(struct TerarkZipTableOptions, cbtMinKeyRatio),
           OptionType::kDouble, OptionVerificationType::kNormal, false, 0}},
+        {"indexResidentBytes",
+         {offsetof(struct TerarkZipTableOptions, indexResidentBytes),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"levelDictReuseCount",
+         {offsetof(struct TerarkZipTableOptions, levelDictReuseCount),
+          OptionType::kUInt32T, OptionVerificationType::kNormal, false, 0}},
+        {"openParallelism",
+         {offsetof(struct TerarkZipTableOptions, openParallelism),
+          OptionType::kUInt32T, OptionVerificationType::kNormal, false, 0}},
+        {"persistentCacheAdmissionBytes",
+         {offsetof(struct TerarkZipTableOptions, persistentCacheAdmissionBytes),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
 };
 
 // delimiter must be "\n"
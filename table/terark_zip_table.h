@@ -16,6 +16,9 @@
 
 namespace TERARKDB_NAMESPACE {
 
+class Cache;
+class PersistentCache;
+
 struct TerarkZipTableOptions {
   // copy of DictZipBlobStore::Options::EntropyAlgo
   enum EntropyAlgo : uint32_t {
@@ -77,7 +80,23 @@ struct TerarkZipTableOptions {
   bool forceMetaInMemory = false;
   bool enableEntropyStore = true;
   uint8_t cbtHashBits = 0;
-  uint8_t reserveBytes0[5] = {};
+  /// copy the index out of the file mmap into transparent hugepage backed
+  /// memory on open, fewer TLB misses for random Get on large indexes.
+  /// costs index size of anonymous memory per open SST
+  bool indexInHugePage = false;
+  /// needs ttl_extractor_factory. keeps the latest expire time of each part
+  /// in the SST, readers then hide parts whose records all expired without
+  /// decompressing them, and compaction drops them the same way. like a ttl
+  /// compaction filter, older versions of a hidden key become visible
+  bool skipExpiredRecords = false;
+  /// keep the 1st pass values in memory instead of the temp value files,
+  /// at most smallTaskMemory bytes per builder, spill to temp files beyond
+  bool inMemoryValueBuffer = false;
+  /// skip the dict checksum on open, TableReader::VerifyChecksum() checks
+  /// the dicts and all records later, e.g. DB::VerifyChecksum() run as a
+  /// background scrub after the restart
+  bool deferChecksumVerify = false;
+  uint8_t reserveBytes0[1] = {};
   uint16_t offsetArrayBlockUnits = 0;
 
   double sampleRatio = 0.03;
@@ -86,6 +105,8 @@ struct TerarkZipTableOptions {
   // is about only 10% when set to 0.001
   double indexCacheRatio = 0;  // 0.001;
   std::string localTempDir = "/tmp";
+  /// "auto" picks the nest louds trie type per part by key distribution,
+  /// the choice is recorded in table property "terark.build.index_type"
   std::string indexType = "Mixed_XL_256_32_FL";
 
   uint64_t softZipWorkingMemLimit = 16ull << 30;
@@ -108,7 +129,32 @@ struct TerarkZipTableOptions {
   uint32_t cbtEntryPerTrie = 65536;
   uint32_t cbtMinKeySize = 16;
   double cbtMinKeyRatio = 0.5;
-  uint8_t reserveBytes1[8] = {};
+  /// > 0: multi part SSTs (see singleIndexMaxSize) warm up a part index on
+  ///      its first access instead of on open, and drop the least recently
+  ///      used parts from page cache to keep at most this many index bytes
+  ///      resident per SST. overrides warmUpIndexOnOpen for the index
+  uint64_t indexResidentBytes = 0;
+  /// > 0: the DictZip sample trained for a column family and level is
+  ///      reused by up to this many following SSTs of the same level, then
+  ///      trained again. their readers share one decompressed dict in memory
+  uint32_t levelDictReuseCount = 0;
+  /// > 1: threads loading the part indexes and stores of a multi part SST
+  ///      on open, on top of max_file_opening_threads across SSTs
+  uint32_t openParallelism = 1;
+
+  /// used when pread is on and cacheCapacityBytes == 0: uncompressed values
+  /// read by pread are kept here, any Cache (LRU, LIRS ...) works.
+  /// give each column family its own to bound them separately.
+  /// open files with use_direct_reads to bypass page cache
+  std::shared_ptr<Cache> recordCache;
+  /// a flash tier (e.g. NewPersistentCache on SSD) for values read from HDD,
+  /// looked up after recordCache, keyed by file and record id. it also holds
+  /// separated values of blob SSTs written by this factory
+  std::shared_ptr<PersistentCache> persistentCache;
+  /// > 0: a record goes to persistentCache on its second miss within the
+  ///      last persistentCacheAdmissionBytes bytes of missed record keys
+  /// = 0: a record goes to persistentCache on every miss
+  uint64_t persistentCacheAdmissionBytes = 8 << 20;
 
   class Status Parse(class Slice);
 };
@@ -167,6 +213,10 @@ class TableFactory* NewTerarkZipTableFactory(
 std::shared_ptr<class TableFactory> SingleTerarkZipTableFactory(
     const TerarkZipTableOptions&, std::shared_ptr<class TableFactory> fallback);
 
+/// BlockBasedTableFactory for the fallback tables of a TerarkZipTableFactory,
+/// data blocks carry a hash index for point lookups and exact seeks
+std::shared_ptr<class TableFactory> NewTerarkZipFallbackTableFactory();
+
 bool TerarkZipTablePrintCacheStat(const class TableFactory*, FILE*);
 
 }  // namespace TERARKDB_NAMESPACE
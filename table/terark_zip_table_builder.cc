@@ -19,6 +19,8 @@
 #include <terark/zbs/zip_offset_blob_store.hpp>
 
 #include "db/version_edit.h"
+#include "monitoring/statistics.h"
+#include "monitoring/thread_status_util.h"
 #include "rocksdb/compaction_filter.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/terark_namespace.h"
@@ -26,7 +28,9 @@
 #include "table/terark_zip_common.h"
 #include "util/async_task.h"
 #include "util/c_style_callback.h"
+#include "util/coding.h"
 #include "util/string_util.h"
+#include "util/work_stealing_thread_pool.h"
 #include "util/xxhash.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -46,6 +50,8 @@ namespace {
 struct PendingTask {
   const TerarkZipTableBuilder* tztb;
   long long startTime;
+  // Lower output levels go first, they hold back flushes and L0
+  int priority;
 };
 }  // namespace
 static std::mutex zipMutex;
@@ -166,6 +172,9 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
   tiopt_.indexNestScale = table_options_.indexNestScale;
   tiopt_.indexTempLevel = table_options_.indexTempLevel;
   tiopt_.indexType = table_options_.indexType;
+  if (tiopt_.indexType == "auto") {
+    tiopt_.indexType = TerarkZipTableOptions().indexType;
+  }
   tiopt_.localTempDir = table_options_.localTempDir;
   tiopt_.smallTaskMemory = table_options_.smallTaskMemory;
   tiopt_.compressGlobalDict = !table_options_.disableCompressDict;
@@ -177,8 +186,15 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
     if (IsCompactionWorkerNode()) {
       TerarkZipConfigCompactionWorkerFromEnv(table_options_);
     }
+    if (tbo.compaction_reason == CompactionReason::kColdRecompress) {
+      // Cold data is rarely read, trade build CPU for a smaller file
+      table_options_.sampleRatio = std::max(table_options_.sampleRatio, 0.1);
+      table_options_.useSuffixArrayLocalMatch = true;
+      table_options_.enableEntropyStore = true;
+    }
     singleIndexMaxSize_ = std::min(table_options_.softZipWorkingMemLimit,
                                    table_options_.singleIndexMaxSize);
+    memtableInput_ = tbo.compaction_reason == CompactionReason::kFlush;
     level_ = tbo.level;
     if (tbo.compaction_load > 0) {
       double load =
@@ -196,6 +212,7 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
     properties_.fixed_key_len = 0;
     properties_.num_data_blocks = 1;
     properties_.column_family_id = column_family_id;
+    properties_.creation_time = tbo.creation_time;
     properties_.column_family_name = tbo.column_family_name;
     properties_.comparator_name = ioptions_.user_comparator
                                       ? ioptions_.user_comparator->Name()
@@ -217,6 +234,13 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
 
     tbo.PushIntTblPropCollectors(&collectors_,
                                  (uint32_t)properties_.column_family_id);
+    if (table_options_.skipExpiredRecords &&
+        ioptions_.ttl_extractor_factory != nullptr) {
+      TtlExtractorContext ttl_context;
+      ttl_context.column_family_id = column_family_id;
+      ttl_extractor_ =
+          ioptions_.ttl_extractor_factory->CreateTtlExtractor(ttl_context);
+    }
 
     std::string property_collectors_names = "[";
     for (size_t i = 0;
@@ -350,6 +374,10 @@ void TerarkZipTableBuilder::RangeStatus::AddValueBit() {
   valueBits.push_back(true);
 }
 
+void TerarkZipTableBuilder::RangeStatus::AddTtl(uint64_t ttlSeconds) {
+  maxTtlSeconds = std::max(maxTtlSeconds, ttlSeconds);
+}
+
 TerarkZipTableBuilder::KeyValueStatus::KeyValueStatus(
     TERARKDB_NAMESPACE::TerarkZipTableBuilder::RangeStatus&& s,
     freq_hist_o1&& f) {
@@ -377,9 +405,44 @@ std::shared_ptr<FilePair> TerarkZipTableBuilder::NewFilePair() {
   pair->value.path = tmpSentryFile_.path + buffer;
   pair->value.open();
   ++nameSeed_;
+  filePairValueBuffer_ = nullptr;
+  if (table_options_.inMemoryValueBuffer &&
+      valueBufferSize_ < table_options_.smallTaskMemory) {
+    std::unique_lock<std::mutex> l(valueBufferMutex_);
+    filePairValueBuffer_ = &valueBuffer_[pair.get()];
+  }
   return pair;
 };
 
+void TerarkZipTableBuilder::AddValue(uint64_t seqType, const Slice& value) {
+  if (filePairValueBuffer_ != nullptr) {
+    size_t size = 8 + VarintLength(value.size()) + value.size();
+    if (valueBufferSize_ + size <= table_options_.smallTaskMemory) {
+      PutFixed64(filePairValueBuffer_, seqType);
+      PutLengthPrefixedSlice(filePairValueBuffer_, value);
+      valueBufferSize_ += size;
+      return;
+    }
+    SpillValueBuffer();
+  }
+  filePair_->value.writer << seqType << fstringOf(value);
+}
+
+// Out of memory budget, move the values of current FilePair to its file
+void TerarkZipTableBuilder::SpillValueBuffer() {
+  Slice input(*filePairValueBuffer_);
+  while (!input.empty()) {
+    uint64_t seqType = DecodeFixed64(input.data());
+    input.remove_prefix(8);
+    Slice value;
+    GetLengthPrefixedSlice(&input, &value);
+    filePair_->value.writer << seqType << fstringOf(value);
+  }
+  std::unique_lock<std::mutex> l(valueBufferMutex_);
+  valueBuffer_.erase(filePair_.get());
+  filePairValueBuffer_ = nullptr;
+}
+
 Status TerarkZipTableBuilder::Add(const Slice& key,
                                   const LazyBuffer& lazy_value) try {
   auto s = lazy_value.fetch();
@@ -506,6 +569,12 @@ Status TerarkZipTableBuilder::Add(const Slice& key,
   }
   prevKey_.DecodeFrom(key);
   AddValueBit();
+  if (ttl_extractor_) {
+    s = AddTtl(key, value, value_type);
+    if (!s.ok()) {
+      return s;
+    }
+  }
   valueDataSize_ += value.size() + 8;
   valueBuf_.emplace_back((char*)&seqType, 8);
   valueBuf_.back_append(value.data(), value.size());
@@ -513,15 +582,15 @@ Status TerarkZipTableBuilder::Add(const Slice& key,
     tmpSampleFile_.writer << fstringOf(value);
     sampleLenSum_ += value.size();
   }
+  // Rereading a memtable is cheaper than spilling its values to temp files
   if (filePair_->isFullValue && second_pass_iter_ &&
-      table_options_.debugLevel != 2 && valueDataSize_ > (1ull << 20) &&
-      valueDataSize_ > keyDataSize_ * 2) {
+      table_options_.debugLevel != 2 &&
+      (memtableInput_ || (valueDataSize_ > (1ull << 20) &&
+                          valueDataSize_ > keyDataSize_ * 2))) {
     filePair_->isFullValue = false;
   }
   assert(filePair_->value.fp);
-  filePair_->value.writer << seqType
-                          << fstringOf(filePair_->isFullValue ? value
-                                                              : Slice());
+  AddValue(seqType, filePair_->isFullValue ? value : Slice());
 
   size_t freq_size = properties_.raw_key_size + properties_.raw_value_size;
   if (freq_size >= next_freq_size_) {
@@ -580,17 +649,20 @@ Status TerarkZipTableBuilder::AddTombstone(const Slice& key,
   return Status::Corruption(ex.what());
 }
 
-TerarkZipTableBuilder::WaitHandle::WaitHandle() : myWorkMem(0) {}
-TerarkZipTableBuilder::WaitHandle::WaitHandle(size_t workMem)
-    : myWorkMem(workMem) {}
+TerarkZipTableBuilder::WaitHandle::WaitHandle()
+    : myWorkMem(0), factoryWorkMem(nullptr) {}
+TerarkZipTableBuilder::WaitHandle::WaitHandle(
+    size_t workMem, std::atomic<size_t>* factoryWorkMem)
+    : myWorkMem(workMem), factoryWorkMem(factoryWorkMem) {}
 TerarkZipTableBuilder::WaitHandle::WaitHandle(WaitHandle&& other) noexcept
-    : myWorkMem(other.myWorkMem) {
+    : myWorkMem(other.myWorkMem), factoryWorkMem(other.factoryWorkMem) {
   other.myWorkMem = 0;
 }
 TerarkZipTableBuilder::WaitHandle& TerarkZipTableBuilder::WaitHandle::operator=(
     WaitHandle&& other) noexcept {
   Release();
   myWorkMem = other.myWorkMem;
+  factoryWorkMem = other.factoryWorkMem;
   other.myWorkMem = 0;
   return *this;
 }
@@ -603,6 +675,9 @@ void TerarkZipTableBuilder::WaitHandle::Release(size_t size) {
     std::unique_lock<std::mutex> zipLock(zipMutex);
     assert(sumWorkingMem >= myWorkMem);
     sumWorkingMem -= size;
+    if (factoryWorkMem != nullptr) {
+      factoryWorkMem->fetch_sub(size, std::memory_order_relaxed);
+    }
     zipCond.notify_all();
     myWorkMem -= size;
   }
@@ -638,31 +713,32 @@ TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::WaitForMemory(
         assert(this == waitQueue[0].tztb);
         return false;  // do not wait
       }
-      size_t minRateIdx = size_t(-1);
-      double minRateVal = DBL_MAX;
+      // Most urgent first, the oldest one among equals
+      size_t firstIdx = 0;
       auto wq = waitQueue.data();
-      for (size_t i = 0, n = waitQueue.size(); i < n; ++i) {
-        double rate = myWorkMem / (0.1 + now - wq[i].startTime);
-        if (rate < minRateVal) {
-          minRateVal = rate;
-          minRateIdx = i;
+      for (size_t i = 1, n = waitQueue.size(); i < n; ++i) {
+        if (wq[i].priority < wq[firstIdx].priority ||
+            (wq[i].priority == wq[firstIdx].priority &&
+             wq[i].startTime < wq[firstIdx].startTime)) {
+          firstIdx = i;
         }
       }
-      if (this == wq[minRateIdx].tztb) {
+      if (this == wq[firstIdx].tztb) {
         return false;  // do not wait
       }
-      myStartTime = wq[minRateIdx].startTime;
+      myStartTime = wq[firstIdx].startTime;
     }
     return true;  // wait
   };
   if (!waitInited_) {
     std::unique_lock<std::mutex> zipLock(zipMutex);
     if (!waitInited_) {
-      waitQueue.push_back({this, g_pf.now()});
+      waitQueue.push_back({this, g_pf.now(), std::max(level_, 0)});
       waitInited_ = true;
     }
   }
   std::unique_lock<std::mutex> zipLock(zipMutex);
+  long long waitStartTime = g_pf.now();
   sumWaitingMem += myWorkMem;
   while (shouldWait()) {
     INFO(
@@ -690,7 +766,11 @@ TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::WaitForMemory(
        (properties_.raw_key_size + properties_.raw_value_size) / 1e9);
   sumWaitingMem -= myWorkMem;
   sumWorkingMem += myWorkMem;
-  return WaitHandle{myWorkMem};
+  table_factory_->builder_working_mem()->fetch_add(myWorkMem,
+                                                   std::memory_order_relaxed);
+  MeasureTime(ioptions_.statistics, TERARK_ZIP_MEMORY_WAIT_MICROS,
+              uint64_t(g_pf.uf(waitStartTime, now)));
+  return WaitHandle{myWorkMem, table_factory_->builder_working_mem()};
 }
 
 Status TerarkZipTableBuilder::EmptyTableFinish() {
@@ -814,18 +894,38 @@ TerarkZipTableBuilder::Async(std::function<Status()> func, void* tag) {
           return Status::Corruption(ex.what());
         }
       }));
-  ioptions_.env->Schedule(c_style_callback(*task), task.get(),
-                          TERARKDB_NAMESPACE::Env::Priority::LOW, tag,
-                          c_style_callback(*task));
+  ScheduleParallelTask(ioptions_.env, ioptions_.parallel_task_pool,
+                       c_style_callback(*task), task.get(),
+                       TERARKDB_NAMESPACE::Env::Priority::LOW, tag,
+                       c_style_callback(*task));
   return task;
 }
 
+// Fixed length and uint keys already get a sorted array index from
+// TerarkIndex::Factory, "auto" only picks the nest louds trie type
+static const char* AutoIndexType(const TerarkIndex::KeyStat& stat) {
+  size_t avgKeyLen = stat.sumKeyLen / std::max<size_t>(stat.keyCount, 1);
+  if (avgKeyLen >= 48) {
+    // Long url like keys, the trie is big, prefer size
+    return "Mixed_XL_256_32_FL";
+  }
+  if (avgKeyLen <= 16 && stat.sumKeyLen <= (256ull << 20)) {
+    // Short keys, the trie is small, prefer lookup speed
+    return "Mixed_SE_512_32_FL";
+  }
+  return "Mixed_IL_256_32_FL";
+}
+
 void TerarkZipTableBuilder::BuildIndex(KeyValueStatus& kvs, size_t entropyLen) {
   kvs.status.stat.entropyLen = entropyLen;
   assert(kvs.status.stat.keyCount > 0);
   kvs.indexWait = Async(
       [this, &kvs]() {
         auto& keyStat = kvs.status.stat;
+        TerarkIndexOptions tiopt = tiopt_;
+        if (table_options_.indexType == "auto") {
+          tiopt.indexType = AutoIndexType(keyStat);
+        }
         std::unique_ptr<TerarkKeyReader> tempKeyFileReader(
             TerarkKeyReader::MakeReader(kvs.status.fileVec, true));
         const size_t myWorkMem = TerarkIndex::Factory::MemSizeForBuild(keyStat);
@@ -836,7 +936,7 @@ void TerarkZipTableBuilder::BuildIndex(KeyValueStatus& kvs, size_t entropyLen) {
         long long t1 = g_pf.now();
         try {
           indexPtr.reset(TerarkIndex::Factory::Build(tempKeyFileReader.get(),
-                                                     tiopt_, keyStat, nullptr));
+                                                     tiopt, keyStat, nullptr));
         } catch (const std::exception& ex) {
           WARN_EXCEPT(
               ioptions_.info_log,
@@ -913,6 +1013,7 @@ void TerarkZipTableBuilder::BuildIndex(KeyValueStatus& kvs, size_t entropyLen) {
                 indexPtr->Name().data());
           }
         }
+        kvs.indexType.assign(indexPtr->Name().data(), indexPtr->Name().size());
         long long tt = g_pf.now();
         size_t rawKeySize = kvs.status.stat.sumKeyLen;
         size_t keyCount = kvs.status.stat.keyCount;
@@ -982,7 +1083,7 @@ Status TerarkZipTableBuilder::BuildStore(KeyValueStatus& kvs,
   };
   auto buildCompressedStore = [this, &kvs, zbuilder]() {
     assert(zbuilder != nullptr);
-    std::unique_lock<std::mutex> l(storeBuildMutex_);
+    std::unique_lock<std::mutex> l(zipStoreBuildMutex_);
     assert(tmpZipStoreFileSize_ == 0 ||
            tmpZipStoreFileSize_ ==
                FileStream(tmpZipStoreFile_.fpath, "rb").fsize());
@@ -1087,7 +1188,8 @@ TerarkZipTableBuilder::CompressDict(fstring tmpDictFile, fstring dict,
 }
 
 Status TerarkZipTableBuilder::WaitBuildIndex() {
-  ioptions_.env->UnSchedule(&indexTag, TERARKDB_NAMESPACE::Env::Priority::LOW);
+  UnScheduleParallelTasks(ioptions_.env, ioptions_.parallel_task_pool,
+                          &indexTag);
   Status result = Status::OK();
   for (auto& kvs : prefixBuildInfos_) {
     assert(kvs);
@@ -1102,7 +1204,8 @@ Status TerarkZipTableBuilder::WaitBuildIndex() {
 }
 
 Status TerarkZipTableBuilder::WaitBuildStore() {
-  ioptions_.env->UnSchedule(&storeTag, TERARKDB_NAMESPACE::Env::Priority::LOW);
+  UnScheduleParallelTasks(ioptions_.env, ioptions_.parallel_task_pool,
+                          &storeTag);
   Status result = Status::OK();
   for (auto& kvs : prefixBuildInfos_) {
     assert(kvs);
@@ -1209,6 +1312,22 @@ TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::LoadSample(
     zbuilder.reset();
     return WaitHandle();
   }
+  bool levelDict = table_options_.levelDictReuseCount > 0 && level_ >= 0;
+  if (levelDict) {
+    auto sample = table_factory_->AcquireLevelDict(
+        properties_.column_family_id, level_);
+    if (sample) {
+      auto waitHandle = WaitForMemory("dictZip", sample->size() * 6);
+      INFO(ioptions_.info_log,
+           "TerarkZipTableBuilder::LoadSample():this=%12p:\n"
+           "reuse level dict, dict_len = %zd, level = %d\n",
+           this, sample->size(), level_);
+      tmpSampleFile_.close();
+      zbuilder->addSample(fstring(*sample));
+      zbuilder->finishSample();
+      return waitHandle;
+    }
+  }
 
   size_t sampleMax =
       std::min<size_t>(INT32_MAX, table_options_.softZipWorkingMemLimit / 7);
@@ -1222,11 +1341,18 @@ TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::LoadSample(
                            1 - compaction_load_) *
                   4096);
   size_t realSampleLenSum = 0;
+  std::string levelSample;
+  auto addSample = [&](fstring data) {
+    zbuilder->addSample(data);
+    if (levelDict) {
+      levelSample.append(data.data(), data.size());
+    }
+  };
 
   if (newSampleLen >= sampleLenSum_) {
     for (size_t len = 0; len < sampleLenSum_;) {
       sampleInput >> sample;
-      zbuilder->addSample(sample);
+      addSample(fstring(sample));
       len += sample.size();
     }
     realSampleLenSum = sampleLenSum_;
@@ -1238,10 +1364,9 @@ TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::LoadSample(
       if (randomGenerator_() < upperBoundSample) {
         realSampleLenSum += sample.size();
         if (realSampleLenSum < newSampleLen) {
-          zbuilder->addSample(sample);
+          addSample(fstring(sample));
         } else {
-          zbuilder->addSample(
-              fstring(sample).substr(0, realSampleLenSum - newSampleLen));
+          addSample(fstring(sample).substr(0, realSampleLenSum - newSampleLen));
           break;
         }
       }
@@ -1255,12 +1380,16 @@ TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::LoadSample(
   }
   tmpSampleFile_.close();
   if (realSampleLenSum == 0) {  // prevent from empty
-    zbuilder->addSample(
+    addSample(
         sample.empty()
             ? fstring("Hello World!")
             : fstring(sample).substr(0, std::min(sample.size(), newSampleLen)));
   }
   zbuilder->finishSample();
+  if (levelDict) {
+    table_factory_->SaveLevelDict(properties_.column_family_id, level_,
+                                  std::move(levelSample));
+  }
   return waitHandle;
 }
 
@@ -1354,6 +1483,8 @@ Status TerarkZipTableBuilder::buildZipOffsetBlobStore(
 
 Status TerarkZipTableBuilder::ZipValueToFinish() {
   assert(prefixBuildInfos_.size() == 1);
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_TERARK_ZIP_VALUES);
   auto& kvs = *prefixBuildInfos_.front();
   AutoDeleteFile tmpDictFile{tmpSentryFile_.path + ".dict"};
   std::unique_ptr<DictZipBlobStore::ZipBuilder> zbuilder;
@@ -1396,7 +1527,8 @@ Status TerarkZipTableBuilder::ZipValueToFinish() {
   if (zbuilder) {
     zbuilder->freeDict();
     t4 = g_pf.now();
-    ioptions_.env->UnSchedule(&dictTag, TERARKDB_NAMESPACE::Env::Priority::LOW);
+    UnScheduleParallelTasks(ioptions_.env, ioptions_.parallel_task_pool,
+                            &dictTag);
     assert(dictWait->valid());
     s = dictWait->get();
     if (!s.ok()) {
@@ -1422,6 +1554,8 @@ Status TerarkZipTableBuilder::ZipValueToFinish() {
 
 Status TerarkZipTableBuilder::ZipValueToFinishMulti() {
   assert(prefixBuildInfos_.size() > 1);
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_TERARK_ZIP_VALUES);
   AutoDeleteFile tmpDictFile{tmpSentryFile_.path + ".dict"};
   std::unique_ptr<DictZipBlobStore::ZipBuilder> zbuilder;
   WaitHandle dictWaitHandle;
@@ -1509,38 +1643,60 @@ Status TerarkZipTableBuilder::ZipValueToFinishMulti() {
 
 class TerarkValueReader {
   const valvec<std::shared_ptr<FilePair>>& files;
+  // nullptr for the FilePair values in file
+  std::vector<const std::string*> memories;
   size_t index;
   NativeDataInput<InputBuffer> reader;
+  Slice memory;
   valvec<byte_t> buffer;
 
-  void checkEOF() {
-    if (terark_unlikely(reader.eof())) {
-      FileStream* fp = &files[++index]->value.fp;
+  void attach(size_t i) {
+    index = i;
+    if (memories[i] != nullptr) {
+      memory = *memories[i];
+    } else {
+      FileStream* fp = &files[i]->value.fp;
       fp->rewind();
       reader.attach(fp);
     }
   }
 
+  void checkEOF() {
+    if (terark_unlikely(memories[index] != nullptr ? memory.empty()
+                                                   : reader.eof())) {
+      attach(index + 1);
+    }
+  }
+
  public:
-  TerarkValueReader(const valvec<std::shared_ptr<FilePair>>& _files)
-      : files(_files) {}
+  TerarkValueReader(const valvec<std::shared_ptr<FilePair>>& _files,
+                    std::vector<const std::string*>&& _memories)
+      : files(_files), memories(std::move(_memories)) {
+    assert(memories.size() == files.size());
+  }
 
   uint64_t readUInt64() {
     checkEOF();
+    if (memories[index] != nullptr) {
+      uint64_t value = DecodeFixed64(memory.data());
+      memory.remove_prefix(8);
+      return value;
+    }
     return reader.load_as<uint64_t>();
   }
 
   void appendBuffer(valvec<byte_t>* buffer) {
     checkEOF();
+    if (memories[index] != nullptr) {
+      Slice value;
+      GetLengthPrefixedSlice(&memory, &value);
+      buffer->append(value.data(), value.size());
+      return;
+    }
     reader.load_add(*buffer);
   }
 
-  void rewind() {
-    index = 0;
-    FileStream* fp = &files.front()->value.fp;
-    fp->rewind();
-    reader.attach(fp);
-  }
+  void rewind() { attach(0); }
 };
 
 Status TerarkZipTableBuilder::BuilderWriteValues(
@@ -1576,7 +1732,16 @@ Status TerarkZipTableBuilder::BuilderWriteValues(
     return SliceOf(key);
   };
 
-  TerarkValueReader input(kvs.status.fileVec);
+  std::vector<const std::string*> memories;
+  {
+    std::unique_lock<std::mutex> l(valueBufferMutex_);
+    for (auto& pair : kvs.status.fileVec) {
+      auto find = valueBuffer_.find(pair.get());
+      memories.emplace_back(find == valueBuffer_.end() ? nullptr
+                                                       : &find->second);
+    }
+  }
+  TerarkValueReader input(kvs.status.fileVec, std::move(memories));
   input.rewind();
   if (kvs.isFullValue) {
     if (--kvs.keyFileRef == 0) {
@@ -1638,6 +1803,26 @@ Status TerarkZipTableBuilder::BuilderWriteValues(
     }
   } else {
     assert(second_pass_iter_ != nullptr);
+    // second_pass_iter_ is shared by the stores built in parallel, so the
+    // lock is only held while it is read. The values read are kept in
+    // pending and written with the lock released.
+    std::unique_lock<std::mutex> iterLock(secondPassIterMutex_);
+    static const size_t kPendingWriteLimit = 4 << 20;
+    valvec<byte_t> pending;
+    std::vector<size_t> pendingEnds;
+    auto pendingWrite = [&](fstring v) {
+      pending.append(v);
+      pendingEnds.push_back(pending.size());
+    };
+    auto flushPending = [&] {
+      size_t begin = 0;
+      for (size_t end : pendingEnds) {
+        write(fstring((const char*)pending.data() + begin, end - begin));
+        begin = end;
+      }
+      pending.erase_all();
+      pendingEnds.clear();
+    };
     keyInput.reset(TerarkKeyReader::MakeReader(kvs.status.fileVec, false));
     keyInput->rewind();
 
@@ -1694,17 +1879,17 @@ Status TerarkZipTableBuilder::BuilderWriteValues(
           if (pIKey.sequence == 0 && pIKey.type == kTypeValue) {
             bzvType.set0(recId, size_t(ZipValueType::kZeroSeq));
             ++zeroSeqCount;
-            write(fstringOf(curVal));
+            pendingWrite(fstringOf(curVal));
           } else if (pIKey.type == kTypeValue) {
             bzvType.set0(recId, size_t(ZipValueType::kValue));
             value.append((byte_t*)&pIKey.sequence, 7);
             value.append(fstringOf(curVal));
-            write(value);
+            pendingWrite(value);
           } else if (pIKey.type == kTypeDeletion) {
             bzvType.set0(recId, size_t(ZipValueType::kDelete));
             value.append((byte_t*)&pIKey.sequence, 7);
             value.append(fstringOf(curVal));
-            write(value);
+            pendingWrite(value);
           } else {
             bzvType.set0(recId, size_t(ZipValueType::kMulti));
             size_t headerSize = ZipValueMultiValue::calcHeaderSize(1);
@@ -1712,14 +1897,14 @@ Status TerarkZipTableBuilder::BuilderWriteValues(
             ((ZipValueMultiValue*)value.data())->offsets[0] = 1;
             value.append(bufKey.data() + bufKey.size() - 8, 8);
             value.append(fstringOf(curVal));
-            write(value);
+            pendingWrite(value);
           }
           value.erase_all();
           ITER_MOVE_NEXT(second_pass_iter_);
           if (++recId < stat.keyCount) bufKey = readInternalKey(true);
         } else if (cmpRet > 0) {  // curKey > bufKey
           bzvType.set0(recId, size_t(ZipValueType::kMulti));
-          write(fstring());  // write nothing
+          pendingWrite(fstring());  // write nothing
           value.erase_all();
           if (++recId < stat.keyCount) bufKey = readInternalKey(true);
         } else {  // curKey < bufKey
@@ -1780,16 +1965,32 @@ Status TerarkZipTableBuilder::BuilderWriteValues(
           }
         }
         if (value.size() == headerSize) {
-          write(fstring());  // all write nothing
+          pendingWrite(fstring());  // all write nothing
         } else {
-          write(value);
+          pendingWrite(value);
         }
         value.erase_all();
         if (++recId < stat.keyCount) bufKey = readInternalKey(true);
       }
       bitPos += varNum + 1;
       entryId += varNum;
+      if (pending.size() >= kPendingWriteLimit && second_pass_iter_->Valid()) {
+        // Let the other stores read while this one writes its values
+        std::string resumeKey = second_pass_iter_->key().ToString();
+        iterLock.unlock();
+        flushPending();
+        iterLock.lock();
+        if (!second_pass_iter_->Valid() ||
+            second_pass_iter_->key() != Slice(resumeKey)) {
+          second_pass_iter_->Seek(resumeKey);
+          if (!second_pass_iter_->status().ok()) {
+            return second_pass_iter_->status();
+          }
+        }
+      }
     }
+    iterLock.unlock();
+    flushPending();
     value.erase_all();
     while (recId < stat.keyCount) {
       varNum = kvs.status.valueBits.one_seq_len(bitPos);
@@ -1902,6 +2103,8 @@ Status TerarkZipTableBuilder::WriteSSTFile(
     const std::string& dictInfo, uint64_t dictHash,
     const DictZipBlobStore::ZipStat& dzstat) {
   assert(prefixBuildInfos_.size() == 1);
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_TERARK_ZIP_WRITE_SST);
   terark::MmapWholeFile dictMmap;
   AbstractBlobStore::Dictionary dict(dictSize_, dictHash);
   auto& kvs = *prefixBuildInfos_.front();
@@ -1919,6 +2122,7 @@ Status TerarkZipTableBuilder::WriteSSTFile(
   long long t5 = g_pf.now();
   Status s;
   BlockHandle dataBlock, dictBlock, offsetBlock, tombstoneBlock(0, 0);
+  BlockHandle expireBlock(0, 0);
   {
     size_t real_size =
         mmapIndexFile.size + store->mem_size() + bzvType.mem_size();
@@ -1959,6 +2163,12 @@ Status TerarkZipTableBuilder::WriteSSTFile(
       return s;
     }
   }
+  if (ttl_extractor_) {
+    s = WriteExpireBlock(&expireBlock);
+    if (!s.ok()) {
+      return s;
+    }
+  }
   auto& stat = kvs.status.stat;
   properties_.num_data_blocks = stat.keyCount;
   kv_freq_.finish();
@@ -1970,6 +2180,8 @@ Status TerarkZipTableBuilder::WriteSSTFile(
            dictBlock},
           {&kTerarkZipTableOffsetBlock, offsetBlock},
           {!tombstoneBlock.IsNull() ? &kRangeDelBlock : NULL, tombstoneBlock},
+          {!expireBlock.IsNull() ? &kTerarkZipTableExpireBlock : NULL,
+           expireBlock},
       });
 
   size_t sumKeyLen = stat.sumKeyLen;
@@ -2106,6 +2318,8 @@ Status TerarkZipTableBuilder::WriteSSTFileMulti(
     const std::string& dictInfo, uint64_t dictHash,
     const DictZipBlobStore::ZipStat& dzstat) {
   assert(prefixBuildInfos_.size() > 1);
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_TERARK_ZIP_WRITE_SST);
   terark::MmapWholeFile dictMmap;
   AbstractBlobStore::Dictionary dict(dictSize_, dictHash);
   const size_t realsampleLenSum = dict.memory.size();
@@ -2125,6 +2339,7 @@ Status TerarkZipTableBuilder::WriteSSTFileMulti(
   }
   Status s;
   BlockHandle dataBlock, dictBlock, offsetBlock, tombstoneBlock(0, 0);
+  BlockHandle expireBlock(0, 0);
   offset_info_.Init(prefixBuildInfos_.size());
   size_t typeSize = 0;
   for (auto& kvs : prefixBuildInfos_) {
@@ -2193,6 +2408,12 @@ Status TerarkZipTableBuilder::WriteSSTFileMulti(
       return s;
     }
   }
+  if (ttl_extractor_) {
+    s = WriteExpireBlock(&expireBlock);
+    if (!s.ok()) {
+      return s;
+    }
+  }
   properties_.num_data_blocks = numKeys;
   kv_freq_.finish();
   size_t entropy = freq_hist_o1::estimate_size(kv_freq_.histogram());
@@ -2203,6 +2424,8 @@ Status TerarkZipTableBuilder::WriteSSTFileMulti(
            dictBlock},
           {&kTerarkZipTableOffsetBlock, offsetBlock},
           {!tombstoneBlock.IsNull() ? &kRangeDelBlock : NULL, tombstoneBlock},
+          {!expireBlock.IsNull() ? &kTerarkZipTableExpireBlock : NULL,
+           expireBlock},
       });
   size_t dictBlockSize = dict.memory.empty() ? 0 : dictBlock.size();
   long long t8 = g_pf.now();
@@ -2368,6 +2591,18 @@ Status TerarkZipTableBuilder::WriteMetaData(
   if (!dictInfo.empty()) {
     propBlockBuilder.Add(kTerarkZipTableDictInfo, dictInfo);
   }
+  if (!prefixBuildInfos_.empty()) {
+    std::string indexType;
+    for (size_t i = 0; i < prefixBuildInfos_.size(); ++i) {
+      size_t kvs_index =
+          isReverseBytewiseOrder_ ? prefixBuildInfos_.size() - 1 - i : i;
+      if (i > 0) {
+        indexType.push_back(',');
+      }
+      indexType.append(prefixBuildInfos_[kvs_index]->indexType);
+    }
+    propBlockBuilder.Add(kTerarkZipTableIndexType, indexType);
+  }
   BlockHandle propBlock, metaindexBlock;
   Status s = WriteBlock(propBlockBuilder.Finish(), file_, &offset_, &propBlock);
   if (!s.ok()) {
@@ -2405,9 +2640,12 @@ Status TerarkZipTableBuilder::WriteMetaData(
 
 void TerarkZipTableBuilder::Abandon() {
   closed_ = true;
-  ioptions_.env->UnSchedule(&indexTag, TERARKDB_NAMESPACE::Env::Priority::LOW);
-  ioptions_.env->UnSchedule(&storeTag, TERARKDB_NAMESPACE::Env::Priority::LOW);
-  ioptions_.env->UnSchedule(&dictTag, TERARKDB_NAMESPACE::Env::Priority::LOW);
+  UnScheduleParallelTasks(ioptions_.env, ioptions_.parallel_task_pool,
+                          &indexTag);
+  UnScheduleParallelTasks(ioptions_.env, ioptions_.parallel_task_pool,
+                          &storeTag);
+  UnScheduleParallelTasks(ioptions_.env, ioptions_.parallel_task_pool,
+                          &dictTag);
   for (auto& kvs : prefixBuildInfos_) {
     if (!kvs) {
       continue;
@@ -2502,6 +2740,47 @@ void TerarkZipTableBuilder::AddValueBit() {
   r20_->AddValueBit();
 }
 
+Status TerarkZipTableBuilder::AddTtl(const Slice& key, const Slice& value,
+                                     ValueType type) {
+  // Tombstones must stay visible, only values may expire
+  uint64_t ttlSeconds = port::kMaxUint64;
+  EntryType entry_type = GetEntryType(type);
+  if (entry_type == kEntryMerge || entry_type == kEntryPut ||
+      entry_type == kEntryMergeIndex || entry_type == kEntryValueIndex) {
+    bool has_ttl = false;
+    std::chrono::seconds ttl(0);
+    Slice value_or_meta = value;
+    if (entry_type == kEntryMergeIndex || entry_type == kEntryValueIndex) {
+      value_or_meta = SeparateHelper::DecodeValueMeta(value);
+    }
+    Status s = ttl_extractor_->Extract(entry_type, ExtractUserKey(key),
+                                       value_or_meta, &has_ttl, &ttl);
+    if (!s.ok()) {
+      return s;
+    }
+    if (has_ttl) {
+      ttlSeconds = static_cast<uint64_t>(ttl.count());
+    }
+  }
+  r00_->AddTtl(ttlSeconds);
+  r10_->AddTtl(ttlSeconds);
+  r20_->AddTtl(ttlSeconds);
+  return Status::OK();
+}
+
+Status TerarkZipTableBuilder::WriteExpireBlock(BlockHandle* expireBlock) {
+  uint64_t now = ioptions_.env->NowMicros() / 1000000;
+  std::string block;
+  for (size_t i = 0; i < prefixBuildInfos_.size(); ++i) {
+    size_t kvs_index =
+        isReverseBytewiseOrder_ ? prefixBuildInfos_.size() - 1 - i : i;
+    uint64_t ttl = prefixBuildInfos_[kvs_index]->status.maxTtlSeconds;
+    PutFixed64(&block, ttl > port::kMaxUint64 - now ? port::kMaxUint64
+                                                     : now + ttl);
+  }
+  return WriteBlock(block, file_, &offset_, expireBlock);
+}
+
 bool TerarkZipTableBuilder::MergeRangeStatus(RangeStatus* aa, RangeStatus* bb,
                                              RangeStatus* ab,
                                              size_t entropyLen) {
@@ -11,6 +11,7 @@
 #define TERARK_ZIP_TABLE_BUILDER_H_
 
 #include <future>
+#include <map>
 #include <random>
 #include <terark/bitfield_array.hpp>
 #include <terark/bitmap.hpp>
@@ -29,6 +30,7 @@
 #include "options/options_helper.h"
 #include "options/options_parser.h"
 #include "rocksdb/terark_namespace.h"
+#include "rocksdb/ttl_extractor.h"
 #include "table/block_builder.h"
 #include "table/format.h"
 #include "table/internal_iterator.h"
@@ -96,6 +98,8 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
     uint64_t seqType = 0;
     uint64_t zeroSeqCount = 0;
     size_t prevSamePrefix = 0;
+    // Longest ttl of all entries, kMaxUint64 if any entry never expires
+    uint64_t maxTtlSeconds = 0;
     valvec<std::shared_ptr<FilePair>> fileVec;
 
     RangeStatus(fstring key, size_t globalPrefixLen, uint64_t seqType);
@@ -108,6 +112,7 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
     void AddKey(fstring key, size_t globalPrefixLen, size_t samePrefix,
                 size_t valueLen, bool zeroSeq);
     void AddValueBit();
+    void AddTtl(uint64_t ttlSeconds);
   };
 
   struct KeyValueStatus {
@@ -122,6 +127,7 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
     bool isValueBuild = false;
     bool isUseDictZip = false;
     bool isFullValue = false;
+    std::string indexType;
     std::unique_ptr<AsyncTask<Status>> indexWait;
     std::unique_ptr<AsyncTask<Status>> storeWait;
     std::atomic<size_t> keyFileRef = {2};
@@ -132,14 +138,20 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   void AddPrevUserKey(size_t samePrefix, std::initializer_list<RangeStatus*> r,
                       std::initializer_list<RangeStatus*> e);
   void AddValueBit();
+  void AddValue(uint64_t seqType, const Slice& value);
+  void SpillValueBuffer();
+  Status AddTtl(const Slice& key, const Slice& value, ValueType type);
+  Status WriteExpireBlock(BlockHandle* expireBlock);
   bool MergeRangeStatus(RangeStatus* aa, RangeStatus* bb, RangeStatus* ab,
                         size_t entropyLen);
   struct WaitHandle : boost::noncopyable {
     WaitHandle();
-    WaitHandle(size_t);
+    WaitHandle(size_t, std::atomic<size_t>* factoryWorkMem);
     WaitHandle(WaitHandle&&) noexcept;
     WaitHandle& operator=(WaitHandle&&) noexcept;
     size_t myWorkMem;
+    // Working memory of the builders of the table factory
+    std::atomic<size_t>* factoryWorkMem;
     void Release(size_t size = 0);
     ~WaitHandle();
   };
@@ -215,6 +227,8 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   const ImmutableCFOptions& ioptions_;
   TerarkZipMultiOffsetInfo offset_info_;
   std::vector<std::unique_ptr<IntTblPropCollector>> collectors_;
+  // Set when skipExpiredRecords, feeds the per part expire block
+  std::unique_ptr<TtlExtractor> ttl_extractor_;
   InternalIterator* second_pass_iter_ = nullptr;
   size_t nameSeed_ = 0;
   size_t keyDataSize_ = 0;
@@ -229,6 +243,12 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   freq_hist_o1 kv_freq_;
   valvec<std::unique_ptr<KeyValueStatus>> prefixBuildInfos_;
   std::shared_ptr<FilePair> filePair_;
+  // inMemoryValueBuffer, 1st pass values of each FilePair not yet spilled,
+  // records are fixed64 seqType + length prefixed value
+  std::map<const FilePair*, std::string> valueBuffer_;
+  std::string* filePairValueBuffer_ = nullptr;
+  size_t valueBufferSize_ = 0;
+  std::mutex valueBufferMutex_;
   InternalKey prevKey_;
   TempFileDeleteOnClose tmpSentryFile_;
   TempFileDeleteOnClose tmpSampleFile_;
@@ -238,7 +258,12 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   uint64_t tmpStoreFileSize_ = 0;
   uint64_t tmpZipStoreFileSize_ = 0;
   std::mutex indexBuildMutex_;
+  // Guards tmpStoreFile_, tmpZipStoreFile_ and second_pass_iter_ separately,
+  // so plain stores build while the dictZip store is compressing. The
+  // second_pass_iter_ lock is not held while the values read are written
   std::mutex storeBuildMutex_;
+  std::mutex zipStoreBuildMutex_;
+  std::mutex secondPassIterMutex_;
   FileStream tmpDumpFile_;
   AutoDeleteFile tmpZipDictFile_;
   AutoDeleteFile tmpZipValueFile_;
@@ -261,6 +286,8 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   bool waitInited_ = false;
   bool closed_ = false;  // Either Finish() or Abandon() has been called.
   bool isReverseBytewiseOrder_;
+  // Flush output, the second pass rereads the memtable
+  bool memtableInput_ = false;
   int level_;
 
   long long t0 = 0;
@@ -21,6 +21,10 @@
   M_Boolea(optimizeCpuL3Cache);
   M_Boolea(forceMetaInMemory);
   M_Boolea(enableEntropyStore);
+  M_Boolea(indexInHugePage);
+  M_Boolea(skipExpiredRecords);
+  M_Boolea(inMemoryValueBuffer);
+  M_Boolea(deferChecksumVerify);
   M_NumFmt(cbtHashBits              , "%d");
   M_NumFmt(minPreadLen              , "%d");
   M_NumFmt(offsetArrayBlockUnits    , "%d");
@@ -36,6 +40,10 @@
   M_NumFmt(cbtEntryPerTrie          , "%u");
   M_NumFmt(cbtMinKeySize            , "%u");
   M_NumFmt(cbtMinKeyRatio           , "%lf");
+  M_NumGiB(indexResidentBytes);
+  M_NumFmt(levelDictReuseCount      , "%u");
+  M_NumFmt(openParallelism          , "%u");
+  M_NumGiB(persistentCacheAdmissionBytes);
 
 #undef M_NumFmt
 #undef M_NumGiB
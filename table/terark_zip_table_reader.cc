@@ -9,14 +9,23 @@
 #include <terark/util/hugepage.hpp>
 #include <terark/zbs/blob_store_file_header.hpp>  // for isChecksumVerifyEnabled()
 
+#include "monitoring/statistics.h"
+#include "port/port.h"
+#include "rocksdb/cache.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/get_context.h"
 #include "table/internal_iterator.h"
 #include "table/meta_blocks.h"
+#include "table/persistent_cache_helper.h"
 #include "table/sst_file_writer_collectors.h"
 #include "table/terark_zip_common.h"
+#include "util/coding.h"
 #include "util/util.h"
+#include "util/xxhash.h"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #ifndef _MSC_VER
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -151,6 +160,27 @@ Status DecompressDict(const TableProperties& table_properties, fstring dict,
   return Status::OK();
 }
 
+// SSTs built from one level dict hold the same dict block, their readers
+// share the decompressed dict
+static Status LoadSharedDict(const TerarkZipTableFactory* table_factory,
+                             const TableProperties& table_properties,
+                             fstring dict,
+                             std::shared_ptr<valvec<byte_t>>* output_dict,
+                             TerarkZipTableReaderBase* reader) {
+  uint64_t hash = XXH64(dict.data(), dict.size(), dict.size());
+  *output_dict = table_factory->GetSharedDict(hash);
+  if (*output_dict) {
+    reader->MmapColdize(dict);
+    return Status::OK();
+  }
+  auto new_dict = std::make_shared<valvec<byte_t>>();
+  Status s = DecompressDict(table_properties, dict, new_dict.get(), reader);
+  if (s.ok() && !new_dict->empty()) {
+    *output_dict = table_factory->AddSharedDict(hash, std::move(new_dict));
+  }
+  return s;
+}
+
 static void MmapAdviseRandom(const void* addr, size_t len) {
   size_t low = terark::align_up(size_t(addr), 4096);
   size_t hig = terark::align_down(size_t(addr) + len, 4096);
@@ -250,6 +280,8 @@ class TerarkZipTableIterator : public TerarkZipTableIndexIterator,
   ZipValueType zip_value_type_;
   size_t value_count_;
   size_t value_index_;
+  uint64_t expire_now_;
+  bool expired_;
   Status status_;
   TerarkContext ctx_;
   TerarkContext* ctx_ptr_;
@@ -298,6 +330,8 @@ class TerarkZipTableIterator : public TerarkZipTableIndexIterator,
                          TerarkContext* ctx)
       : table_reader_options_(&tro),
         global_seqno_(global_seqno),
+        expire_now_(tro.ioptions.env->NowMicros() / 1000000),
+        expired_(false),
         ctx_ptr_(ctx == nullptr ? &ctx_ : ctx) {
     subReader_ = subReader;
     if (subReader_ != nullptr) {
@@ -414,7 +448,7 @@ class TerarkZipTableIterator : public TerarkZipTableIndexIterator,
       buffer->reset(user_value_,
                     Cleanable(&TerarkZipTableIterator::ReleaseBuffer,
                               ShareBuffer(), nullptr),
-                    table_reader_options_->file_number);
+                    LazyBufferPinLevel::DB, table_reader_options_->file_number);
     }
     return Status::OK();
   }
@@ -524,6 +558,13 @@ class TerarkZipTableIterator : public TerarkZipTableIndexIterator,
   }
   bool UnzipIterRecord(bool hasRecord) {
     if (hasRecord) {
+      // Whole part expired, step over the record without unzipping it
+      expired_ = subReader_->expireTime_ <= expire_now_;
+      if (expired_) {
+        value_index_ = 0;
+        value_count_ = 1;
+        return true;
+      }
       auto& value_buffer = ValueBuffer();
       fstring user_key = iter_->key();
       try {
@@ -541,6 +582,8 @@ class TerarkZipTableIterator : public TerarkZipTableIndexIterator,
         value_buffer.resize_no_init(mulnum_size);
         *reinterpret_cast<size_t*>(value_buffer.data()) = 1;
         subReader_->GetRecordAppend(recId, cache_offsets_);
+        subReader_->TraceAccess(recId, kTableAccessIterator,
+                                value_buffer.size() - mulnum_size);
       } catch (const std::exception& ex) {  // crc checksum error
         SetIterInvalid();
         status_ = Status::Corruption(
@@ -583,6 +626,11 @@ class TerarkZipTableIterator : public TerarkZipTableIndexIterator,
   virtual void DecodeCurrKeyValue() {
     assert(status_.ok());
     assert(iter_->id() < subReader_->index_->NumKeys());
+    if (expired_) {
+      key_tag_ = port::kMaxUint64;
+      user_value_.clear();
+      return;
+    }
     auto value_slice = ValueSlice();
     switch (zip_value_type_) {
       default:
@@ -719,6 +767,7 @@ class TerarkZipTableMultiIterator : public TerarkZipTableIterator<reverse> {
     if (subReader_ == subReader) {
       return;
     }
+    subIndex_->Touch(subReader);
     subReader_ = subReader;
     if (iter_ != nullptr) {
       call_destructor(iter_);
@@ -814,6 +863,57 @@ Status TerarkZipTableReaderBase::LoadTombstone(RandomAccessFileReader* file,
   return s;
 }
 
+Status TerarkZipTableReaderBase::LoadExpireTime(RandomAccessFileReader* file,
+                                                uint64_t file_size,
+                                                size_t partCount,
+                                                valvec<uint64_t>* expireTime) {
+  BlockContents expireBlock;
+  Status s = ReadMetaBlockAdapte(file, file_size, kTerarkZipTableMagicNumber,
+                                 table_reader_options_.ioptions,
+                                 kTerarkZipTableExpireBlock, &expireBlock);
+  if (!s.ok()) {
+    // SST built without ttl_extractor_factory
+    return Status::OK();
+  }
+  if (expireBlock.data.size() != partCount * sizeof(uint64_t)) {
+    return Status::Corruption("TerarkZipTableReaderBase::LoadExpireTime()",
+                              "Bad expire block size");
+  }
+  expireTime->resize_no_init(partCount);
+  for (size_t i = 0; i < partCount; ++i) {
+    (*expireTime)[i] =
+        DecodeFixed64(expireBlock.data.data() + i * sizeof(uint64_t));
+  }
+  hasExpireTime_ = true;
+  return Status::OK();
+}
+
+bool TerarkZipTableReaderBase::Expired(const TerarkZipSubReader& part) const {
+  return hasExpireTime_ &&
+         part.expireTime_ <=
+             table_reader_options_.ioptions.env->NowMicros() / 1000000;
+}
+
+const PersistentCacheOptions* TerarkZipTableReaderBase::InitPersistentCache(
+    const TerarkZipTableFactory* table_factory,
+    const TerarkZipTableOptions& tzto, Statistics* statistics) {
+  if (!tzto.persistentCache) {
+    return nullptr;
+  }
+  // Same key prefix as BlockBasedTable: an id from the file, stable across
+  // reopens. Without one, fall back to an id unique to this reader
+  char buf[kMaxVarint64Length * 3 + 1];
+  size_t size = file_->file()->GetUniqueId(buf, sizeof buf);
+  std::string key_prefix =
+      size > 0 ? std::string(buf, size)
+               : table_reader_options_.ioptions.env->GenerateUniqueId();
+  persistent_cache_options_ =
+      PersistentCacheOptions(tzto.persistentCache, key_prefix, statistics);
+  persistent_cache_options_.admission_cache =
+      table_factory->persistent_cache_admission();
+  return &persistent_cache_options_;
+}
+
 FragmentedRangeTombstoneIterator*
 TerarkZipTableReaderBase::NewRangeTombstoneIterator(
     const ReadOptions& read_options) {
@@ -858,6 +958,44 @@ void TerarkZipTableReaderBase::MmapColdize(const void* addr, size_t len) {
   }
 }
 
+size_t TerarkZipTableReaderBase::MmapResidentBytes(const void* addr,
+                                                   size_t len) const {
+  auto beg = (const char*)addr;
+  if (len == 0 || beg < file_data_.data() ||
+      beg + len > file_data_.data() + file_data_.size()) {
+    return len;
+  }
+#ifndef _MSC_VER
+  const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t lo = uintptr_t(beg) & ~(pageSize - 1);
+  uintptr_t hi = uintptr_t(beg) + len;
+  std::vector<unsigned char> vec((hi - lo + pageSize - 1) / pageSize);
+  if (mincore((void*)lo, hi - lo, vec.data()) != 0) {
+    return len;
+  }
+  size_t resident = 0;
+  for (size_t i = 0; i < vec.size(); ++i) {
+    resident += vec[i] & 1;
+  }
+  return std::min<size_t>(len, resident * pageSize);
+#else
+  return len;
+#endif
+}
+
+size_t TerarkZipTableReaderBase::DictMemoryUsage(
+    const valvec<byte_t>& dict,
+    const std::shared_ptr<valvec<byte_t>>& sharedDict, Slice dictData) const {
+  if (sharedDict) {
+    return sharedDict->size() / std::max<long>(sharedDict.use_count(), 1);
+  }
+  if (!dict.empty()) {
+    return dict.size();
+  }
+  // Used in place in the file
+  return MmapResidentBytes(dictData.data(), dictData.size());
+}
+
 void TerarkZipSubReader::InitUsePread(int minPreadLen) {
   if (minPreadLen < 0) {
     storeUsePread_ = false;
@@ -886,15 +1024,78 @@ static const byte_t* FsPread(void* vself, size_t offset, size_t len,
   return buf->data();
 }
 
+static void DeleteCachedRecord(const Slice& /*key*/, void* value) {
+  delete reinterpret_cast<std::string*>(value);
+}
+
+void TerarkZipSubReader::PreadRecordAppend(size_t recId,
+                                           valvec<byte_t>* tbuf) const {
+  if (cache_) {
+    store_->pread_record_append(cache_, storeFD_, storeOffset_, recId, tbuf);
+    return;
+  }
+  if (recordCache_ == nullptr) {
+    StoreRecordAppend(recId, tbuf);
+    return;
+  }
+  char buf[16];
+  EncodeFixed64(buf, recordCacheId_);
+  EncodeFixed64(buf + 8, recId);
+  Slice key(buf, sizeof buf);
+  auto handle = recordCache_->Lookup(key, statistics_);
+  if (handle != nullptr) {
+    RecordTick(statistics_, TERARK_ZIP_RECORD_CACHE_HIT);
+    auto record = reinterpret_cast<std::string*>(recordCache_->Value(handle));
+    tbuf->append((const byte_t*)record->data(), record->size());
+    recordCache_->Release(handle);
+    return;
+  }
+  RecordTick(statistics_, TERARK_ZIP_RECORD_CACHE_MISS);
+  size_t oldsize = tbuf->size();
+  StoreRecordAppend(recId, tbuf);
+  auto record = new std::string((const char*)tbuf->data() + oldsize,
+                                tbuf->size() - oldsize);
+  recordCache_->Insert(key, record, sizeof buf + record->size(),
+                       &DeleteCachedRecord);
+}
+
+void TerarkZipSubReader::StoreRecordAppend(size_t recId,
+                                           valvec<byte_t>* tbuf) const {
+  char buf[kMaxVarint64Length * 2];
+  Slice key;
+  if (persistentCacheOptions_ != nullptr) {
+    char* end = EncodeVarint64(buf, subIndex_);
+    end = EncodeVarint64(end, recId);
+    key = Slice(buf, end - buf);
+    std::unique_ptr<char[]> data;
+    size_t size;
+    if (PersistentCacheHelper::LookupRecord(*persistentCacheOptions_, key,
+                                            &data, &size)
+            .ok()) {
+      tbuf->append((const byte_t*)data.get(), size);
+      return;
+    }
+  }
+  size_t oldsize = tbuf->size();
+  if (storeUsePread_) {
+    store_->fspread_record_append(&FsPread, (void*)this, storeOffset_, recId,
+                                  tbuf);
+  } else {
+    store_->get_record_append(recId, tbuf);
+  }
+  if (persistentCacheOptions_ != nullptr) {
+    PersistentCacheHelper::InsertRecord(*persistentCacheOptions_, key,
+                                        (const char*)tbuf->data() + oldsize,
+                                        tbuf->size() - oldsize);
+  }
+}
+
 void TerarkZipSubReader::GetRecordAppend(size_t recId,
                                          valvec<byte_t>* tbuf) const {
   if (storeUsePread_) {
-    auto cache = cache_;
-    if (cache)
-      store_->pread_record_append(cache, storeFD_, storeOffset_, recId, tbuf);
-    else
-      store_->fspread_record_append(&FsPread, (void*)this, storeOffset_, recId,
-                                    tbuf);
+    PreadRecordAppend(recId, tbuf);
+  } else if (persistentCacheOptions_ != nullptr) {
+    StoreRecordAppend(recId, tbuf);
   } else {
     store_->get_record_append(recId, tbuf);
   }
@@ -903,13 +1104,7 @@ void TerarkZipSubReader::GetRecordAppend(size_t recId,
 void TerarkZipSubReader::GetRecordAppend(
     size_t recId, terark::BlobStore::CacheOffsets* co) const {
   if (storeUsePread_) {
-    auto cache = cache_;
-    if (cache)
-      store_->pread_record_append(cache, storeFD_, storeOffset_, recId,
-                                  &co->recData);
-    else
-      store_->fspread_record_append(&FsPread, (void*)this, storeOffset_, recId,
-                                    &co->recData);
+    PreadRecordAppend(recId, &co->recData);
   } else
     store_->get_record_append(recId, co);
 }
@@ -935,18 +1130,24 @@ Status TerarkZipSubReader::Get(SequenceNumber global_seqno,
   bool matched;
   auto ctx_buffer = g_tctx->alloc();
   auto& buf = ctx_buffer.get();
+  auto get_record = [&] {
+    size_t old_size = buf.size();
+    GetRecordAppend(recId, &buf);
+    TraceAccess(recId, kTableAccessGet, buf.size() - old_size);
+  };
   auto set_value = [&](const ParsedInternalKey& k, Slice v) {
     assert(k.type != kTypeMerge);
     static constexpr size_t pin_size = 8192;
     bool pin_value = v.size() >= pin_size;
     if (pin_value) {
+      // The value owns the buffer, DBImpl::Get pins it without copying
       void* ptr = buf.data();
       buf.risk_release_ownership();
       get_context->SaveValue(
           k,
           LazyBuffer(
               v, Cleanable([](void* arg1, void*) { free(arg1); }, ptr, nullptr),
-              file_number_),
+              LazyBufferPinLevel::DB, file_number_),
           &matched);
     } else {
       get_context->SaveValue(k, LazyBuffer(v, false, file_number_), &matched);
@@ -956,7 +1157,7 @@ Status TerarkZipSubReader::Get(SequenceNumber global_seqno,
     case ZipValueType::kZeroSeq:
       buf.erase_all();
       try {
-        GetRecordAppend(recId, &buf);
+        get_record();
       } catch (const std::exception& ex) {
         return Status::Corruption("TerarkZipTableReader::Get()", ex.what());
       }
@@ -966,7 +1167,7 @@ Status TerarkZipSubReader::Get(SequenceNumber global_seqno,
     case ZipValueType::kValue: {  // should be a kTypeValue, the normal case
       buf.erase_all();
       try {
-        GetRecordAppend(recId, &buf);
+        get_record();
       } catch (const std::exception& ex) {
         return Status::Corruption("TerarkZipTableReader::Get()", ex.what());
       }
@@ -982,7 +1183,7 @@ Status TerarkZipSubReader::Get(SequenceNumber global_seqno,
       buf.erase_all();
       buf.reserve(sizeof(SequenceNumber));
       try {
-        GetRecordAppend(recId, &buf);
+        get_record();
       } catch (const std::exception& ex) {
         return Status::Corruption("TerarkZipTableReader::Get()", ex.what());
       }
@@ -996,7 +1197,7 @@ Status TerarkZipSubReader::Get(SequenceNumber global_seqno,
     case ZipValueType::kMulti: {  // more than one value
       buf.resize_no_init(sizeof(uint32_t));
       try {
-        GetRecordAppend(recId, &buf);
+        get_record();
       } catch (const std::exception& ex) {
         return Status::Corruption("TerarkZipTableReader::Get()", ex.what());
       }
@@ -1059,8 +1260,10 @@ Status TerarkEmptyTableReader::Open(RandomAccessFileReader* file,
   }
   assert(nullptr != props);
   props->compression_name = "TERARK";
+  // Freed on return when not pinned
+  std::shared_ptr<const TableProperties> props_holder(props);
   if (ioptions.pin_table_properties_in_reader) {
-    table_properties_.reset(props);
+    table_properties_ = props_holder;
   }
   if (props->comparator_name != fstring(ioptions.user_comparator->Name()) &&
       0) {
@@ -1083,14 +1286,34 @@ Status TerarkEmptyTableReader::Open(RandomAccessFileReader* file,
   return Status::OK();
 }
 
-AbstractBlobStore::Dictionary getVerifyDict(Slice dictData) {
-  if (terark::isChecksumVerifyEnabled()) {
+AbstractBlobStore::Dictionary getVerifyDict(Slice dictData, bool verify) {
+  if (verify && terark::isChecksumVerifyEnabled()) {
     return AbstractBlobStore::Dictionary(fstringOf(dictData));
   } else {
     return AbstractBlobStore::Dictionary(fstringOf(dictData), 0);
   }
 }
 
+// Reloads "store" with a checked dict and reads all of its records, a bad
+// checksum anywhere throws
+static Status VerifyStoreChecksum(AbstractBlobStore* store, Slice dictData) {
+  try {
+    std::unique_ptr<AbstractBlobStore> verify(
+        AbstractBlobStore::load_from_user_memory(
+            store->get_mmap(),
+            AbstractBlobStore::Dictionary(fstringOf(dictData))));
+    valvec<byte_t> buffer;
+    for (size_t i = 0; i < verify->num_records(); ++i) {
+      buffer.erase_all();
+      verify->get_record_append(i, &buffer);
+    }
+  } catch (const std::exception& ex) {
+    return Status::Corruption("TerarkZipTableReader::VerifyChecksum()",
+                              ex.what());
+  }
+  return Status::OK();
+}
+
 Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
                                   uint64_t file_size) {
   file->set_use_fsread(false);
@@ -1112,8 +1335,10 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
   }
   assert(nullptr != props);
   props->compression_name = "TERARK";
+  // Freed on return when not pinned
+  std::shared_ptr<const TableProperties> props_holder(props);
   if (ioptions.pin_table_properties_in_reader) {
-    table_properties_.reset(props);
+    table_properties_ = props_holder;
   }
   if (props->comparator_name != fstring(ioptions.user_comparator->Name()) &&
       0) {
@@ -1133,12 +1358,19 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
                           kTerarkZipTableValueDictBlock, &valueDictBlock);
   Slice dict = valueDictBlock.data;
   if (s.ok()) {
-    s = DecompressDict(*props, fstringOf(valueDictBlock.data), &dict_, this);
+    if (tzto_.levelDictReuseCount > 0) {
+      s = LoadSharedDict(table_factory_, *props,
+                         fstringOf(valueDictBlock.data), &sharedDict_, this);
+    } else {
+      s = DecompressDict(*props, fstringOf(valueDictBlock.data), &dict_, this);
+    }
     if (!s.ok()) {
       return s;
     }
-    dict = dict_.empty() ? valueDictBlock.data : SliceOf(dict_);
+    dict = sharedDict_ ? SliceOf(*sharedDict_)
+                       : dict_.empty() ? valueDictBlock.data : SliceOf(dict_);
   }
+  dictData_ = dict;
   props->user_collected_properties.emplace(kTerarkZipTableDictSize,
                                            lcast(dict.size()));
   // PlainBlobStore & MixedLenBlobStore no dict
@@ -1165,14 +1397,22 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
         fstring(file_data.data() + indexSize, storeSize),
         tzto_.forceMetaInMemory
             ? AbstractBlobStore::Dictionary(fstringOf(dict), 0, false)
-            : getVerifyDict(dict)));
+            : getVerifyDict(dict, !tzto_.deferChecksumVerify)));
     subReader_.store_->set_mmap_aio(file->file()->use_aio_reads());
   } catch (const BadCrc32cException& ex) {
     return Status::Corruption("TerarkZipTableReader::Open()", ex.what());
   } catch (const BadCrc16cException& ex) {
     return Status::Corruption("TerarkZipTableReader::Open()", ex.what());
   }
-  s = LoadIndex(Slice(file_data.data(), indexSize));
+  Slice indexMem(file_data.data(), indexSize);
+  if (tzto_.indexInHugePage) {
+    use_hugepage_resize_no_init(&indexMemory_, indexSize);
+    memcpy(indexMemory_.data(), indexMem.data(), indexSize);
+    MmapColdize(fstringOf(indexMem));
+    indexMem = SliceOf(indexMemory_);
+  }
+  indexData_ = indexMem;
+  s = LoadIndex(indexMem);
   if (!s.ok()) {
     return s;
   }
@@ -1181,6 +1421,16 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
     subReader_.type_.risk_set_data(
         (byte_t*)file_data.data() + indexSize + storeSize, recNum);
   }
+  if (tzto_.skipExpiredRecords) {
+    valvec<uint64_t> expireTime;
+    s = LoadExpireTime(file, file_size, 1, &expireTime);
+    if (!s.ok()) {
+      return s;
+    }
+    if (!expireTime.empty()) {
+      subReader_.expireTime_ = expireTime[0];
+    }
+  }
   subReader_.subIndex_ = 0;
   subReader_.storeFD_ = file_->file()->FileDescriptor();
   subReader_.storeFileObj_ = file_->file();
@@ -1208,8 +1458,17 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
 #endif
 #endif
       subReader_.storeFD_ = subReader_.cache_->open(subReader_.storeFD_);
+    } else if (tzto_.recordCache) {
+      subReader_.recordCache_ = tzto_.recordCache.get();
+      subReader_.recordCacheId_ = subReader_.recordCache_->NewId();
+      subReader_.statistics_ = ioptions.statistics;
     }
   }
+  subReader_.accessTracer_ = ioptions.table_access_tracer.get();
+  if (!subReader_.cache_) {
+    subReader_.persistentCacheOptions_ =
+        InitPersistentCache(table_factory_, tzto_, ioptions.statistics);
+  }
 
   valvec<fstring> meta_data_in_mmap;
   if (tzto_.forceMetaInMemory) {
@@ -1252,7 +1511,9 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
   }
   long long t0 = g_pf.now();
   if (tzto_.warmUpIndexOnOpen) {
-    MmapWarmUp(fstring(file_data.data(), indexSize));
+    if (!tzto_.indexInHugePage) {
+      MmapWarmUp(fstring(file_data.data(), indexSize));
+    }
     if (!tzto_.warmUpValueOnOpen) {
       for (fstring block : subReader_.store_->get_meta_blocks()) {
         MmapWarmUp(block);
@@ -1338,6 +1599,9 @@ InternalIterator* TerarkZipTableReader::NewIterator(
   TERARK_UNUSED_VAR(skip_filters);
   TERARK_UNUSED_VAR(prefix_extractor);
   TERARK_UNUSED_VAR(for_compaction);
+  if (Expired(subReader_)) {
+    return NewEmptyInternalIterator(arena);
+  }
   return NewIteratorSelect(this, ro, isReverseBytewiseOrder_,
                            subReader_.store_->is_offsets_zipped(), arena,
                            nullptr, nullptr);
@@ -1368,6 +1632,9 @@ Status TerarkZipTableReader::Get(const ReadOptions& ro, const Slice& ikey,
                                  bool skip_filters) {
   int flag = skip_filters ? TerarkZipSubReader::FlagSkipFilter
                           : TerarkZipSubReader::FlagNone;
+  if (Expired(subReader_)) {
+    return Status::OK();
+  }
   return subReader_.Get(global_seqno_, ro, ikey, get_context, flag);
 }
 
@@ -1394,6 +1661,10 @@ uint64_t TerarkZipTableReader::ApproximateOffsetOf(const Slice& ikey) {
   return offset;
 }
 
+Status TerarkZipTableReader::VerifyChecksum() {
+  return VerifyStoreChecksum(subReader_.store_.get(), dictData_);
+}
+
 TerarkZipTableReader::~TerarkZipTableReader() {
   if (subReader_.storeUsePread_) {
     if (subReader_.cache_) {
@@ -1417,10 +1688,52 @@ fstring TerarkZipTableMultiReader::SubIndex::PartIndexOperator::operator[](
   return p->bounds_[i];
 };
 
+static inline uint64_t KeyPrefix64(fstring key) {
+  uint64_t prefix = 0;
+  memcpy(&prefix, key.data(), std::min<size_t>(key.size(), 8));
+  return port::kLittleEndian ? byte_swap(prefix) : prefix;
+}
+
+void TerarkZipTableMultiReader::SubIndex::PrefixRange(uint64_t prefix,
+                                                      size_t* lo,
+                                                      size_t* hi) const {
+  const uint64_t* p = boundPrefix_.data();
+#ifdef __AVX2__
+  // Few parts, count smaller/equal prefixes 4 lanes at a time
+  if (partCount_ <= 256) {
+    // Flip the sign bit, AVX2 only has signed 64 bit compare
+    const __m256i sign = _mm256_set1_epi64x(int64_t(1ull << 63));
+    const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x(prefix), sign);
+    size_t lt = 0, le = 0, i = 0;
+    for (; i + 4 <= partCount_; i += 4) {
+      __m256i v = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), sign);
+      int gt =
+          _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)));
+      int eq =
+          _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(k, v)));
+      lt += __builtin_popcount(gt);
+      le += __builtin_popcount(gt | eq);
+    }
+    for (; i < partCount_; ++i) {
+      lt += p[i] < prefix;
+      le += p[i] <= prefix;
+    }
+    *lo = lt;
+    *hi = le;
+    return;
+  }
+#endif
+  *lo = std::lower_bound(p, p + partCount_, prefix) - p;
+  *hi = std::upper_bound(p + *lo, p + partCount_, prefix) - p;
+}
+
 const TerarkZipSubReader*
 TerarkZipTableMultiReader::SubIndex::LowerBoundSubReader(fstring key) const {
   PartIndexOperator ptr = {this};
-  auto index = terark::lower_bound_n(ptr, 0, partCount_, key);
+  size_t lo, hi;
+  PrefixRange(KeyPrefix64(key), &lo, &hi);
+  auto index = terark::lower_bound_n(ptr, lo, hi, key);
   if (index == partCount_) {
     return nullptr;
   }
@@ -1431,13 +1744,50 @@ const TerarkZipSubReader*
 TerarkZipTableMultiReader::SubIndex::LowerBoundSubReaderReverse(
     fstring key) const {
   PartIndexOperator ptr = {this};
-  auto index = terark::upper_bound_n(ptr, 0, partCount_, key);
+  size_t lo, hi;
+  PrefixRange(KeyPrefix64(key), &lo, &hi);
+  auto index = terark::upper_bound_n(ptr, lo, hi, key);
   if (index == 0) {
     return nullptr;
   }
   return &subReader_[index - 1];
 }
 
+void TerarkZipTableMultiReader::SubIndex::Touch(
+    const TerarkZipSubReader* part) const {
+  if (residentLimit_ == 0) {
+    return;
+  }
+  auto& state = residentState_[part->subIndex_];
+  uint8_t s = state.load(std::memory_order_relaxed);
+  if (s == 2 || (s == 1 && state.compare_exchange_strong(s, 2))) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(residentMutex_);
+  if (state.load(std::memory_order_relaxed) != 0) {
+    return;
+  }
+  size_t size = part->storeOffset_ - part->rawReaderOffset_;
+  // CLOCK eviction, recently used parts get a second chance
+  for (size_t n = 0;
+       residentBytes_ + size > residentLimit_ && n < partCount_ * 2; ++n) {
+    auto& victim = subReader_[residentClock_];
+    auto& victimState = residentState_[residentClock_];
+    residentClock_ = (residentClock_ + 1) % partCount_;
+    uint8_t v = victimState.load(std::memory_order_relaxed);
+    if (v == 2) {
+      victimState.compare_exchange_strong(v, 1);
+    } else if (v == 1 && victimState.compare_exchange_strong(v, 0)) {
+      size_t victimSize = victim.storeOffset_ - victim.rawReaderOffset_;
+      fileObj_->InvalidateCache(victim.rawReaderOffset_, victimSize);
+      residentBytes_ -= victimSize;
+    }
+  }
+  MmapWarmUp(baseAddress_ + part->rawReaderOffset_, size);
+  residentBytes_ += size;
+  state.store(2);
+}
+
 TerarkZipTableMultiReader::SubIndex::~SubIndex() {
   if (cache_fi_ >= 0) {
     assert(nullptr != cache_);
@@ -1449,7 +1799,11 @@ Status TerarkZipTableMultiReader::SubIndex::Init(
     fstring offsetMemory, const byte_t* baseAddress,
     AbstractBlobStore::Dictionary dict, int minPreadLen,
     RandomAccessFile* fileObj, LruReadonlyCache* cache, uint64_t file_number,
-    bool warmUpIndexOnOpen, bool reverse) {
+    bool warmUpIndexOnOpen, bool indexInHugePage, uint64_t indexResidentBytes,
+    bool reverse, Cache* recordCache, Statistics* statistics,
+    TableAccessTracer* accessTracer,
+    const PersistentCacheOptions* persistentCacheOptions,
+    size_t openParallelism) {
   TerarkZipMultiOffsetInfo offsetInfo;
   if (!offsetInfo.risk_set_memory(offsetMemory.data(), offsetMemory.size())) {
     return Status::Corruption("bad offset block");
@@ -1459,12 +1813,31 @@ Status TerarkZipTableMultiReader::SubIndex::Init(
 
   cache_ = cache;
   partCount_ = offsetInfo.offset_.size();
+  baseAddress_ = baseAddress;
+  fileObj_ = fileObj;
+  if (indexResidentBytes > 0 && !indexInHugePage) {
+    residentLimit_ = indexResidentBytes;
+    residentState_.reset(new std::atomic<uint8_t>[partCount_]);
+    for (size_t i = 0; i < partCount_; ++i) {
+      residentState_[i].store(0);
+    }
+  }
 
   size_t offset = 0;
   size_t rawSize = 0;
   intptr_t fileFD = fileObj->FileDescriptor();
   hasAnyZipOffset_ = false;
   auto& g_tctx = *terark::GetTlsTerarkContext();
+  byte_t* indexCopy = nullptr;
+  if (indexInHugePage) {
+    size_t indexSize = 0;
+    for (auto& curr : offsetInfo.offset_) {
+      indexSize += curr.key;
+    }
+    use_hugepage_resize_no_init(&indexMemory_, indexSize);
+    indexCopy = indexMemory_.data();
+  }
+  std::vector<byte_t*> indexCopyAt(partCount_, nullptr);
   try {
     valvec<byte_t> buffer;
     cache_fi_ = -1;
@@ -1477,34 +1850,86 @@ Status TerarkZipTableMultiReader::SubIndex::Init(
       part.storeFD_ = fileFD;
       part.rawReaderOffset_ = offset;
       part.rawReaderSize_ = curr.key + curr.value + curr.type;
-      part.index_ =
-          TerarkIndex::LoadMemory(fstring(baseAddress + offset, curr.key));
-      if (warmUpIndexOnOpen) {
-        MmapWarmUp(baseAddress + offset, curr.key);
+      part.storeOffset_ = offset + curr.key;
+      part.file_number_ = file_number;
+      offset += part.rawReaderSize_;
+      if (indexCopy != nullptr) {
+        indexCopyAt[i] = indexCopy;
+        indexCopy += curr.key;
+      }
+    }
+    // Parts only share the read only dict, load them concurrently
+    std::mutex errorMutex;
+    std::string error;
+    std::atomic<size_t> nextPart(0);
+    std::function<void()> loadPartFunc([&]() {
+      while (true) {
+        size_t i = nextPart.fetch_add(1);
+        if (i >= partCount_) {
+          break;
+        }
+        auto& part = subReader_[i];
+        auto& curr = offsetInfo.offset_[i];
+        try {
+          fstring indexMem(baseAddress + part.rawReaderOffset_, curr.key);
+          if (indexCopyAt[i] != nullptr) {
+            memcpy(indexCopyAt[i], indexMem.data(), indexMem.size());
+            indexMem = fstring(indexCopyAt[i], indexMem.size());
+          }
+          part.index_ = TerarkIndex::LoadMemory(indexMem);
+          if (warmUpIndexOnOpen && !indexInHugePage && residentLimit_ == 0) {
+            MmapWarmUp(indexMem);
+          }
+          part.store_.reset(AbstractBlobStore::load_from_user_memory(
+              fstring(baseAddress + part.storeOffset_, curr.value), dict));
+          part.store_->set_mmap_aio(fileObj->use_aio_reads());
+          part.InitUsePread(minPreadLen);
+          assert(curr.type == 0 || bitfield_array<2>::compute_mem_size(
+                                       part.index_->NumKeys()) == curr.type);
+          if (curr.type > 0) {
+            part.type_.risk_set_data(
+                (byte_t*)(baseAddress + part.storeOffset_ + curr.value),
+                part.index_->NumKeys());
+          }
+        } catch (const std::exception& ex) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (error.empty()) {
+            error = ex.what();
+          }
+        }
       }
-      part.storeOffset_ = offset += curr.key;
-      part.store_.reset(AbstractBlobStore::load_from_user_memory(
-          fstring(baseAddress + offset, curr.value), dict));
-      part.store_->set_mmap_aio(fileObj->use_aio_reads());
+    });
+    std::vector<port::Thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(openParallelism, partCount_);
+         ++i) {
+      threads.emplace_back(loadPartFunc);
+    }
+    loadPartFunc();
+    for (auto& t : threads) {
+      t.join();
+    }
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+    for (size_t i = 0; i < partCount_; ++i) {
+      auto& part = subReader_[i];
       if (part.store_->is_offsets_zipped()) {
         hasAnyZipOffset_ = true;
       }
-      part.InitUsePread(minPreadLen);
-      assert(curr.type == 0 || bitfield_array<2>::compute_mem_size(
-                                   part.index_->NumKeys()) == curr.type);
-      offset += curr.value;
-      if (curr.type > 0) {
-        part.type_.risk_set_data((byte_t*)(baseAddress + offset),
-                                 part.index_->NumKeys());
-        offset += curr.type;
-      }
-      part.file_number_ = file_number;
       if (part.storeUsePread_ && cache) {
         if (cache_fi_ < 0) {
           cache_fi_ = cache->open(fileFD);
         }
         part.cache_ = cache;
         part.storeFD_ = cache_fi_;
+      } else if (part.storeUsePread_ && recordCache) {
+        part.recordCache_ = recordCache;
+        part.recordCacheId_ = recordCache->NewId();
+        part.statistics_ = statistics;
+      }
+      part.accessTracer_ = accessTracer;
+      if (!part.cache_) {
+        part.persistentCacheOptions_ = persistentCacheOptions;
       }
       rawSize += part.rawReaderSize_;
       iteratorSize_ = std::max(iteratorSize_, part.index_->IteratorSize());
@@ -1514,6 +1939,7 @@ Status TerarkZipTableMultiReader::SubIndex::Init(
         part.index_->MaxKey(&buffer, &g_tctx);
       }
       bounds_.push_back(buffer);
+      boundPrefix_.push_back(KeyPrefix64(bounds_.back()));
     }
 #if !defined(NDEBUG)
     for (size_t i = 1; i < bounds_.size(); ++i) {
@@ -1549,6 +1975,11 @@ size_t TerarkZipTableMultiReader::SubIndex::GetSubCount() const {
   return partCount_;
 }
 
+void TerarkZipTableMultiReader::SubIndex::SetExpireTime(size_t i,
+                                                        uint64_t expireTime) {
+  subReader_[i].expireTime_ = expireTime;
+}
+
 const TerarkZipSubReader* TerarkZipTableMultiReader::SubIndex::GetSubReader(
     size_t i) const {
   return &subReader_[i];
@@ -1560,6 +1991,15 @@ InternalIterator* TerarkZipTableMultiReader::NewIterator(
   TERARK_UNUSED_VAR(skip_filters);
   TERARK_UNUSED_VAR(prefix_extractor);
   TERARK_UNUSED_VAR(for_compaction);
+  if (hasExpireTime_) {
+    size_t i = 0;
+    while (i < subIndex_.GetSubCount() && Expired(*subIndex_.GetSubReader(i))) {
+      ++i;
+    }
+    if (i == subIndex_.GetSubCount()) {
+      return NewEmptyInternalIterator(arena);
+    }
+  }
   return NewIteratorSelect(this, ro, isReverseBytewiseOrder_,
                            subIndex_.HasAnyZipOffset(), arena, nullptr,
                            nullptr);
@@ -1600,9 +2040,10 @@ Status TerarkZipTableMultiReader::Get(
     subReader = subIndex_.LowerBoundSubReader(
         fstringOf(ikey).substr(0, ikey.size() - 8));
   }
-  if (subReader == nullptr) {
+  if (subReader == nullptr || Expired(*subReader)) {
     return Status::OK();
   }
+  subIndex_.Touch(subReader);
   return subReader->Get(global_seqno_, ro, ikey, get_context, flag);
 }
 
@@ -1654,6 +2095,30 @@ uint64_t TerarkZipTableMultiReader::ApproximateOffsetOf(const Slice& ikey) {
   return offset;
 }
 
+Status TerarkZipTableMultiReader::VerifyChecksum() {
+  for (size_t i = 0; i < subIndex_.GetSubCount(); ++i) {
+    auto part = subIndex_.GetSubReader(i);
+    Status s = VerifyStoreChecksum(part->store_.get(), dictData_);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+size_t TerarkZipTableMultiReader::ApproximateIndexMemoryUsage() const {
+  size_t usage = subIndex_.IndexCopySize();
+  if (usage > 0) {
+    return usage;
+  }
+  for (size_t i = 0, n = subIndex_.GetSubCount(); i < n; ++i) {
+    auto part = subIndex_.GetSubReader(i);
+    usage += MmapResidentBytes(file_data_.data() + part->rawReaderOffset_,
+                               part->storeOffset_ - part->rawReaderOffset_);
+  }
+  return usage;
+}
+
 TerarkZipTableMultiReader::~TerarkZipTableMultiReader() {}
 
 TerarkZipTableMultiReader::TerarkZipTableMultiReader(
@@ -1687,8 +2152,10 @@ Status TerarkZipTableMultiReader::Open(RandomAccessFileReader* file,
   }
   assert(nullptr != props);
   props->compression_name = "TERARK";
+  // Freed on return when not pinned
+  std::shared_ptr<const TableProperties> props_holder(props);
   if (ioptions.pin_table_properties_in_reader) {
-    table_properties_.reset(props);
+    table_properties_ = props_holder;
   }
   if (props->comparator_name != fstring(ioptions.user_comparator->Name()) &&
       0) {
@@ -1713,12 +2180,19 @@ Status TerarkZipTableMultiReader::Open(RandomAccessFileReader* file,
                           kTerarkZipTableValueDictBlock, &valueDictBlock);
   Slice dict;
   if (s.ok()) {
-    s = DecompressDict(*props, fstringOf(valueDictBlock.data), &dict_, this);
+    if (tzto_.levelDictReuseCount > 0) {
+      s = LoadSharedDict(table_factory_, *props,
+                         fstringOf(valueDictBlock.data), &sharedDict_, this);
+    } else {
+      s = DecompressDict(*props, fstringOf(valueDictBlock.data), &dict_, this);
+    }
     if (!s.ok()) {
       return s;
     }
-    dict = dict_.empty() ? valueDictBlock.data : SliceOf(dict_);
+    dict = sharedDict_ ? SliceOf(*sharedDict_)
+                       : dict_.empty() ? valueDictBlock.data : SliceOf(dict_);
   }
+  dictData_ = dict;
   props->user_collected_properties.emplace(kTerarkZipTableDictSize,
                                            lcast(dict.size()));
   s = LoadTombstone(file, file_size);
@@ -1729,13 +2203,35 @@ Status TerarkZipTableMultiReader::Open(RandomAccessFileReader* file,
       fstringOf(offsetBlock.data), (const byte_t*)file_data.data(),
       tzto_.forceMetaInMemory
           ? AbstractBlobStore::Dictionary(fstringOf(dict), 0, false)
-          : getVerifyDict(dict),
+          : getVerifyDict(dict, !tzto_.deferChecksumVerify),
       tzto_.minPreadLen, file_->file(), table_factory_->cache(),
       table_reader_options_.file_number, tzto_.warmUpIndexOnOpen,
-      isReverseBytewiseOrder_);
+      tzto_.indexInHugePage, tzto_.indexResidentBytes, isReverseBytewiseOrder_,
+      tzto_.recordCache.get(), ioptions.statistics,
+      ioptions.table_access_tracer.get(),
+      InitPersistentCache(table_factory_, tzto_, ioptions.statistics),
+      tzto_.openParallelism);
   if (!s.ok()) {
     return s;
   }
+  if (tzto_.skipExpiredRecords) {
+    valvec<uint64_t> expireTime;
+    s = LoadExpireTime(file, file_size, subIndex_.GetSubCount(), &expireTime);
+    if (!s.ok()) {
+      return s;
+    }
+    for (size_t i = 0; i < expireTime.size(); ++i) {
+      subIndex_.SetExpireTime(i, expireTime[i]);
+    }
+  }
+  if (tzto_.indexInHugePage) {
+    // Indexes were copied out, drop them from page cache
+    for (size_t i = 0; i < subIndex_.GetSubCount(); ++i) {
+      auto part = subIndex_.GetSubReader(i);
+      MmapColdize(file_data.data() + part->rawReaderOffset_,
+                  part->storeOffset_ - part->rawReaderOffset_);
+    }
+  }
   valvec<fstring> meta_data_in_mmap;
   if (tzto_.forceMetaInMemory) {
     valvec<std::pair<valvec<fstring>, valvec<fstring>>> meta_data;
@@ -10,7 +10,9 @@
 #ifndef TERARK_ZIP_TABLE_READER_H_
 #define TERARK_ZIP_TABLE_READER_H_
 
+#include <atomic>
 #include <boost/noncopyable.hpp>
+#include <mutex>
 #include <terark/bitfield_array.hpp>
 #include <terark/entropy/entropy_base.hpp>
 #include <terark/idx/terark_zip_index.hpp>
@@ -21,11 +23,13 @@
 #include "rocksdb/options.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/block.h"
+#include "table/persistent_cache_options.h"
 #include "table/table_builder.h"
 #include "table/table_reader.h"
 #include "table/terark_zip_internal.h"
 #include "table/terark_zip_table.h"
 #include "util/arena.h"
+#include "util/trace_replay.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -39,6 +43,8 @@ Status ReadMetaBlockAdapte(class RandomAccessFileReader* file,
                            const std::string& meta_block_name,
                            struct BlockContents* contents);
 
+struct TerarkZipSubReader;
+
 class TerarkZipTableReaderBase : public TableReader, boost::noncopyable {
  private:
   std::shared_ptr<const FragmentedRangeTombstoneList> fragmented_range_dels_;
@@ -53,6 +59,25 @@ class TerarkZipTableReaderBase : public TableReader, boost::noncopyable {
   virtual SequenceNumber GetSequenceNumber() const = 0;
 
   Status LoadTombstone(RandomAccessFileReader* file, uint64_t file_size);
+  // Latest expire time of each part, left empty if the SST has no expire
+  // block
+  Status LoadExpireTime(RandomAccessFileReader* file, uint64_t file_size,
+                        size_t partCount, valvec<uint64_t>* expireTime);
+  bool hasExpireTime_ = false;
+  // All records of "part" expired
+  bool Expired(const TerarkZipSubReader& part) const;
+  // Bytes of the value dict in memory, a dict shared by the SSTs of a level
+  // is split among its users
+  size_t DictMemoryUsage(const valvec<byte_t>& dict,
+                         const std::shared_ptr<valvec<byte_t>>& sharedDict,
+                         Slice dictData) const;
+  // Flash tier for records when TerarkZipTableOptions::persistentCache is
+  // set, keyed by the unique id of file_
+  PersistentCacheOptions persistent_cache_options_;
+  // Returns nullptr if there is no flash tier
+  const PersistentCacheOptions* InitPersistentCache(
+      const TerarkZipTableFactory* table_factory,
+      const TerarkZipTableOptions& tzto, Statistics* statistics);
 
   uint64_t FileNumber() const override {
     return table_reader_options_.file_number;
@@ -69,6 +94,9 @@ class TerarkZipTableReaderBase : public TableReader, boost::noncopyable {
 
   void MmapColdize(const void* addr, size_t len);
   void MmapColdize(terark::fstring mem) { MmapColdize(mem.data(), mem.size()); }
+  // Bytes of [addr, addr + len) in the page cache, all of them if the range
+  // is not mmap'd from the file
+  size_t MmapResidentBytes(const void* addr, size_t len) const;
   template <class Vec>
   void MmapColdize(const Vec& uv) {
     MmapColdize(uv.data(), uv.mem_size());
@@ -131,6 +159,11 @@ class TerarkEmptyTableReader : public TerarkZipTableReaderBase {
 
 struct TerarkZipSubReader {
   LruReadonlyCache* cache_ = nullptr;
+  Cache* recordCache_ = nullptr;
+  uint64_t recordCacheId_ = 0;
+  Statistics* statistics_ = nullptr;
+  TableAccessTracer* accessTracer_ = nullptr;
+  const PersistentCacheOptions* persistentCacheOptions_ = nullptr;
   size_t subIndex_;
   size_t rawReaderOffset_;
   size_t rawReaderSize_;
@@ -143,6 +176,8 @@ struct TerarkZipSubReader {
   unique_ptr<terark::AbstractBlobStore> store_;
   bitfield_array<2> type_;
   uint64_t file_number_;
+  // Seconds since epoch when the last record of this part expires
+  uint64_t expireTime_ = port::kMaxUint64;
 
   enum {
     FlagNone = 0,
@@ -153,6 +188,15 @@ struct TerarkZipSubReader {
 
   void GetRecordAppend(size_t recId, valvec<byte_t>* tbuf) const;
   void GetRecordAppend(size_t recId, terark::BlobStore::CacheOffsets*) const;
+  void PreadRecordAppend(size_t recId, valvec<byte_t>* tbuf) const;
+  void TraceAccess(size_t recId, TableAccessCaller caller, size_t size) const {
+    if (accessTracer_ != nullptr && accessTracer_->IsTracing()) {
+      accessTracer_->Add(kTableAccessTerarkZipValue, caller, file_number_,
+                         recId, size, false);
+    }
+  }
+  // Reads the record from the flash tier, or from the store on a miss
+  void StoreRecordAppend(size_t recId, valvec<byte_t>* tbuf) const;
 
   Status Get(SequenceNumber, const ReadOptions&, const Slice& key, GetContext*,
              int flag) const;
@@ -190,8 +234,15 @@ class TerarkZipTableReader : public TerarkZipTableReaderBase {
 
   uint64_t ApproximateOffsetOf(const Slice& key) override;
   void SetupForCompaction() override {}
+  Status VerifyChecksum() override;
 
   size_t ApproximateMemoryUsage() const override { return file_data_.size(); }
+  size_t ApproximateIndexMemoryUsage() const override {
+    return MmapResidentBytes(indexData_.data(), indexData_.size());
+  }
+  size_t ApproximateDictMemoryUsage() const override {
+    return DictMemoryUsage(dict_, sharedDict_, dictData_);
+  }
 
   virtual ~TerarkZipTableReader();
   TerarkZipTableReader(const TerarkZipTableFactory* table_factory,
@@ -204,7 +255,15 @@ class TerarkZipTableReader : public TerarkZipTableReaderBase {
   TerarkZipSubReader subReader_;
   static const size_t kNumInternalBytes = 8;
   valvec<byte_t> dict_;
+  // Used instead of dict_ when levelDictReuseCount > 0
+  std::shared_ptr<valvec<byte_t>> sharedDict_;
+  // The dict the stores were loaded with
+  Slice dictData_;
   valvec<byte_t> meta_;
+  // Index copy when indexInHugePage
+  valvec<byte_t> indexMemory_;
+  // The index the sub reader was loaded from
+  Slice indexData_;
   const TerarkZipTableFactory* table_factory_;
   SequenceNumber global_seqno_;
   const TerarkZipTableOptions& tzto_;
@@ -238,8 +297,13 @@ class TerarkZipTableMultiReader : public TerarkZipTableReaderBase {
 
   uint64_t ApproximateOffsetOf(const Slice& key) override;
   void SetupForCompaction() override {}
+  Status VerifyChecksum() override;
 
   size_t ApproximateMemoryUsage() const override { return file_data_.size(); }
+  size_t ApproximateIndexMemoryUsage() const override;
+  size_t ApproximateDictMemoryUsage() const override {
+    return DictMemoryUsage(dict_, sharedDict_, dictData_);
+  }
 
   virtual ~TerarkZipTableMultiReader();
   TerarkZipTableMultiReader(const TerarkZipTableFactory* table_factory,
@@ -254,28 +318,56 @@ class TerarkZipTableMultiReader : public TerarkZipTableReaderBase {
     size_t partCount_;
     size_t iteratorSize_ = 0;
     terark::fstrvec bounds_;
+    // Big endian first 8 bytes of each bound, narrows bound search to the
+    // parts sharing the key prefix before any string compare
+    valvec<uint64_t> boundPrefix_;
     valvec<TerarkZipSubReader> subReader_;
+    // Index copies of all parts when indexInHugePage
+    valvec<byte_t> indexMemory_;
     bool hasAnyZipOffset_;
 
+    // Part indexes loaded on demand when indexResidentBytes > 0
+    const byte_t* baseAddress_ = nullptr;
+    RandomAccessFile* fileObj_ = nullptr;
+    uint64_t residentLimit_ = 0;
+    mutable std::mutex residentMutex_;
+    mutable uint64_t residentBytes_ = 0;
+    mutable size_t residentClock_ = 0;
+    // 0 = cold, 1 = resident, 2 = resident and recently used
+    std::unique_ptr<std::atomic<uint8_t>[]> residentState_;
+
     struct PartIndexOperator {
       const SubIndex* p;
       fstring operator[](size_t i) const;
     };
 
+    // [*lo, *hi) are the parts whose bound prefix equals "prefix"
+    void PrefixRange(uint64_t prefix, size_t* lo, size_t* hi) const;
+
    public:
     ~SubIndex();
 
     Status Init(fstring offsetMemory, const byte_t* baseAddress,
                 terark::AbstractBlobStore::Dictionary dict, int minPreadLen,
                 RandomAccessFile* fileObj, LruReadonlyCache* cache,
-                uint64_t file_number, bool warmUpIndexOnOpen, bool reverse);
+                uint64_t file_number, bool warmUpIndexOnOpen,
+                bool indexInHugePage, uint64_t indexResidentBytes,
+                bool reverse, Cache* recordCache, Statistics* statistics,
+                TableAccessTracer* accessTracer,
+                const PersistentCacheOptions* persistentCacheOptions,
+                size_t openParallelism);
 
     size_t GetSubCount() const;
     const TerarkZipSubReader* GetSubReader(size_t i) const;
+    void SetExpireTime(size_t i, uint64_t expireTime);
     const TerarkZipSubReader* LowerBoundSubReader(fstring key) const;
     const TerarkZipSubReader* LowerBoundSubReaderReverse(fstring key) const;
+    // Warms up the index of "part" if it is not resident
+    void Touch(const TerarkZipSubReader* part) const;
     size_t IteratorSize() const { return iteratorSize_; }
     bool HasAnyZipOffset() const { return hasAnyZipOffset_; }
+    // Bytes of the index copies, 0 unless indexInHugePage
+    size_t IndexCopySize() const { return indexMemory_.size(); }
   };
 
  private:
@@ -284,6 +376,10 @@ class TerarkZipTableMultiReader : public TerarkZipTableReaderBase {
   SubIndex subIndex_;
   static const size_t kNumInternalBytes = 8;
   valvec<byte_t> dict_;
+  // Used instead of dict_ when levelDictReuseCount > 0
+  std::shared_ptr<valvec<byte_t>> sharedDict_;
+  // The dict the stores were loaded with
+  Slice dictData_;
   valvec<byte_t> meta_;
   const TerarkZipTableFactory* table_factory_;
   SequenceNumber global_seqno_;
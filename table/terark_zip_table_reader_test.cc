@@ -16,6 +16,7 @@
 #include "rocksdb/perf_context.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/terark_zip_table.h"
+#include "utilities/persistent_cache/volatile_tier_impl.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -79,7 +80,8 @@ class TerarkZipReaderTest : public DBTestBase {
   }
 
   void BasicTest(bool rev, size_t count, uint32_t prefix, size_t blockUnits,
-                 uint32_t minValue, size_t valueLen = 0) {
+                 uint32_t minValue, size_t valueLen = 0,
+                 bool indexInHugePage = false) {
     Options options = CurrentOptions();
     TerarkZipTableOptions tzto;
     tzto.disableSecondPassIter = false;
@@ -88,6 +90,7 @@ class TerarkZipReaderTest : public DBTestBase {
     tzto.minDictZipValueSize = minValue;
     tzto.entropyAlgo = TerarkZipTableOptions::kFSE;
     tzto.localTempDir = dbname_;
+    tzto.indexInHugePage = indexInHugePage;
     options.allow_mmap_reads = true;
     if (rev) {
       options.comparator = ReverseBytewiseComparator();
@@ -150,7 +153,8 @@ class TerarkZipReaderTest : public DBTestBase {
     CheckApproximateOffset(rev, it);
     delete it;
   }
-  void HardZipTest(bool rev, size_t count, uint32_t prefix) {
+  void HardZipTest(bool rev, size_t count, uint32_t prefix,
+                   uint64_t indexResidentBytes = 0) {
     Options options = CurrentOptions();
     TerarkZipTableOptions tzto;
     tzto.disableSecondPassIter = false;
@@ -159,6 +163,7 @@ class TerarkZipReaderTest : public DBTestBase {
     tzto.minDictZipValueSize = 0;
     tzto.singleIndexMinSize = 512;
     tzto.singleIndexMaxSize = 512;
+    tzto.indexResidentBytes = indexResidentBytes;
     options.allow_mmap_reads = true;
     if (rev) {
       options.comparator = ReverseBytewiseComparator();
@@ -582,6 +587,232 @@ TEST_F(TerarkZipReaderTest, BasicTestMultiMany) {
 TEST_F(TerarkZipReaderTest, BasicTestMultiManyRev) {
   BasicTest(true, 333, 3, 0, 0);
 }
+TEST_F(TerarkZipReaderTest, BasicTestIndexInHugePage) {
+  BasicTest(false, 1000, 0, 0, 0, 0, true);
+}
+TEST_F(TerarkZipReaderTest, BasicTestMultiIndexInHugePage) {
+  BasicTest(false, 1000, 1, 0, 0, 0, true);
+}
+TEST_F(TerarkZipReaderTest, RecordCacheTest) {
+  Options options = CurrentOptions();
+  options.statistics = CreateDBStatistics();
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.minPreadLen = 0;
+  tzto.recordCache = NewLRUCache(1 << 20);
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(get_key(i), get_value(i)));
+  }
+  ASSERT_OK(Flush());
+  for (int round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < 1000; ++i) {
+      ASSERT_EQ(get_value(i), Get(get_key(i)));
+    }
+  }
+  ASSERT_GE(TestGetTickerCount(options, TERARK_ZIP_RECORD_CACHE_MISS), 1000u);
+  ASSERT_GE(TestGetTickerCount(options, TERARK_ZIP_RECORD_CACHE_HIT), 1000u);
+  ASSERT_GT(tzto.recordCache->GetUsage(), 0u);
+}
+
+TEST_F(TerarkZipReaderTest, PersistentCacheTest) {
+  Options options = CurrentOptions();
+  options.statistics = CreateDBStatistics();
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.minPreadLen = 0;
+  tzto.persistentCache = std::make_shared<VolatileCacheTier>();
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(get_key(i), get_value(i)));
+  }
+  ASSERT_OK(Flush());
+  // admitted on the second miss, served from the flash tier on the third read
+  for (int round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < 1000; ++i) {
+      ASSERT_EQ(get_value(i), Get(get_key(i)));
+    }
+    if (round < 2) {
+      ASSERT_EQ(0u, TestGetTickerCount(options, PERSISTENT_CACHE_HIT));
+    }
+  }
+  ASSERT_GE(TestGetTickerCount(options, PERSISTENT_CACHE_MISS), 2000u);
+  ASSERT_GE(TestGetTickerCount(options, PERSISTENT_CACHE_HIT), 1000u);
+}
+
+TEST_F(TerarkZipReaderTest, SkipExpiredRecordsTest) {
+  Options options = CurrentOptions();
+  options.allow_mmap_reads = true;
+  options.disable_auto_compactions = true;
+  options.ttl_extractor_factory.reset(new test::TestTtlExtractorFactory(env_));
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.skipExpiredRecords = true;
+  tzto.singleIndexMinSize = 512;
+  tzto.singleIndexMaxSize = 512;
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  uint64_t now = env_->NowMicros() / 1000000;
+  auto ttl_value = [](size_t i, uint64_t expire) {
+    std::string value = get_value(i);
+    PutFixed64(&value, expire);
+    return value;
+  };
+  auto count_keys = [&] {
+    size_t count = 0;
+    std::unique_ptr<Iterator> it(db_->NewIterator(ReadOptions()));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      ++count;
+    }
+    return count;
+  };
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(get_key(i), ttl_value(i, now + 100)));
+  }
+  ASSERT_OK(Flush());
+  for (size_t i = 1000; i < 2000; ++i) {
+    ASSERT_OK(Put(get_key(i), ttl_value(i, now + 100000)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ(ttl_value(0, now + 100), Get(get_key(0)));
+  ASSERT_EQ(2000u, count_keys());
+
+  env_->addon_time_.fetch_add(1000 * 1000000LL);
+  for (size_t i = 0; i < 2000; i += 10) {
+    if (i < 1000) {
+      ASSERT_EQ("NOT_FOUND", Get(get_key(i)));
+    } else {
+      ASSERT_EQ(ttl_value(i, now + 100000), Get(get_key(i)));
+    }
+  }
+  ASSERT_EQ(1000u, count_keys());
+  // Compaction never sees the expired file
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(1000u, count_keys());
+  env_->addon_time_.fetch_sub(1000 * 1000000LL);
+  ASSERT_EQ(1000u, count_keys());
+}
+TEST_F(TerarkZipReaderTest, InMemoryValueBufferTest) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.inMemoryValueBuffer = true;
+  tzto.singleIndexMinSize = 512;
+  tzto.singleIndexMaxSize = 512;
+  // Later parts spill to the temp files
+  tzto.smallTaskMemory = 16 << 10;
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  for (size_t i = 0; i < 2000; ++i) {
+    ASSERT_OK(Put(get_key(i), get_value(i, 64)));
+  }
+  ASSERT_OK(Flush());
+  for (size_t i = 0; i < 2000; ++i) {
+    ASSERT_EQ(get_value(i, 64), Get(get_key(i)));
+  }
+  std::unique_ptr<Iterator> it(db_->NewIterator(ReadOptions()));
+  size_t i = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next(), ++i) {
+    ASSERT_EQ(get_key(i), it->key().ToString());
+    ASSERT_EQ(get_value(i, 64), it->value().ToString());
+  }
+  ASSERT_EQ(2000u, i);
+}
+
+TEST_F(TerarkZipReaderTest, LevelDictReuseTest) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.minDictZipValueSize = 0;
+  tzto.levelDictReuseCount = 2;
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  // The 1st flush samples, the next 2 reuse its dict, the 4th samples again
+  for (size_t f = 0; f < 4; ++f) {
+    for (size_t i = f; i < 4000; i += 4) {
+      ASSERT_OK(Put(get_key(i), get_value(i, 128)));
+    }
+    ASSERT_OK(Flush());
+  }
+  ASSERT_EQ(4, NumTableFilesAtLevel(0));
+  for (size_t i = 0; i < 4000; ++i) {
+    ASSERT_EQ(get_value(i, 128), Get(get_key(i)));
+  }
+  Reopen(options);
+  std::unique_ptr<Iterator> it(db_->NewIterator(ReadOptions()));
+  size_t i = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next(), ++i) {
+    ASSERT_EQ(get_key(i), it->key().ToString());
+    ASSERT_EQ(get_value(i, 128), it->value().ToString());
+  }
+  ASSERT_EQ(4000u, i);
+}
+
+TEST_F(TerarkZipReaderTest, ParallelOpenTest) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.singleIndexMinSize = 512;
+  tzto.singleIndexMaxSize = 512;
+  tzto.openParallelism = 4;
+  tzto.deferChecksumVerify = true;
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  for (size_t i = 0; i < 2000; ++i) {
+    ASSERT_OK(Put(get_key(i), get_value(i, 64)));
+  }
+  ASSERT_OK(Flush());
+  Reopen(options);
+  for (size_t i = 0; i < 2000; ++i) {
+    ASSERT_EQ(get_value(i, 64), Get(get_key(i)));
+  }
+  std::unique_ptr<Iterator> it(db_->NewIterator(ReadOptions()));
+  size_t i = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next(), ++i) {
+    ASSERT_EQ(get_key(i), it->key().ToString());
+  }
+  ASSERT_EQ(2000u, i);
+  // The deferred check
+  ASSERT_OK(db_->VerifyChecksum());
+}
+
+TEST_F(TerarkZipReaderTest, AutoIndexTypeTest) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.indexType = "auto";
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  std::string url = "https://www.example.com/path/to/some/resource?id=";
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(get_key(i), get_value(i)));
+  }
+  ASSERT_OK(Flush());
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(url + get_key(i), get_value(i)));
+  }
+  ASSERT_OK(Flush());
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(get_value(i), Get(get_key(i)));
+    ASSERT_EQ(get_value(i), Get(url + get_key(i)));
+  }
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  ASSERT_EQ(2u, props.size());
+  for (auto& pair : props) {
+    auto find =
+        pair.second->user_collected_properties.find("terark.build.index_type");
+    ASSERT_TRUE(find != pair.second->user_collected_properties.end());
+    ASSERT_FALSE(find->second.empty());
+  }
+}
+
 TEST_F(TerarkZipReaderTest, BasicTestDictZipZO64) {
   BasicTest(false, 100, 0, 64, 0);
 }
@@ -678,6 +909,12 @@ TEST_F(TerarkZipReaderTest, HardZipTestMultiMany) {
 TEST_F(TerarkZipReaderTest, HardZipTestMultiManyRev) {
   HardZipTest(true, 333, 2);
 }
+TEST_F(TerarkZipReaderTest, HardZipTestIndexResident) {
+  HardZipTest(false, 1000, 0, 4096);
+}
+TEST_F(TerarkZipReaderTest, HardZipTestIndexResidentRev) {
+  HardZipTest(true, 1000, 0, 4096);
+}
 
 TEST_F(TerarkZipReaderTest, ZeroLengthBlobStoreTest) {
   ZeroLengthBlobStoreTest(false, 1000, 0);
@@ -27,6 +27,7 @@
 
 DEFINE_string(db_path, "", "data dir");
 DEFINE_uint64(gb_per_thread, 1, "data size in GB");
+DEFINE_uint64(mb_per_thread, 0, "data size in MB, overrides gb_per_thread");
 DEFINE_uint64(threads, 1, "thread count");
 DEFINE_uint64(batch_size, 64, "batch size");
 DEFINE_uint64(value_size, 16384, "batch size");
@@ -275,16 +276,28 @@ int main(int argc, char** argv) {
 
   printf("start writing...\n");
 
+  size_t bytes_per_thread = FLAGS_mb_per_thread > 0
+                                ? FLAGS_mb_per_thread << 20
+                                : FLAGS_gb_per_thread << 30;
+  size_t record_bytes = 16 + FLAGS_value_size;
+  auto start = std::chrono::steady_clock::now();
   std::vector<std::thread> threads;
   for (int i = 0; i < FLAGS_threads; ++i) {
     threads.emplace_back([&]() {
-      batch_write(db, 16 + FLAGS_value_size, 64, FLAGS_gb_per_thread << 30);
+      batch_write(db, record_bytes, 64, bytes_per_thread);
     });
   }
 
   for (auto& t : threads) {
     t.join();
   }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  // Parsed by tools/benchmark_regression.py
+  size_t batches = bytes_per_thread / (record_bytes * 64) * FLAGS_threads;
+  printf("batch_write_bench : %.1f MB/sec %.1f batches/sec\n",
+         batches * record_bytes * 64 / 1048576.0 / seconds, batches / seconds);
 
   for (auto i = 0; i < cf_options.size(); ++i) {
     delete cf_handles[i];
@@ -0,0 +1,277 @@
+#! /usr/bin/env python
+# Copyright (c) 2020-present, Bytedance Inc.  All rights reserved.
+# This source code is licensed under Apache 2.0 License.
+#
+# Runs a fixed matrix of write, read, scan and GC workloads with db_bench and
+# batch_write_bench, stores the throughput of every run as JSON and compares
+# it against a baseline produced the same way.
+#
+# A workload regresses when its mean throughput is more than --threshold
+# below the baseline mean and the drop is also larger than --sigmas standard
+# errors of the two means, so the noise of a machine is not reported.
+#
+# Usage:
+#   tools/benchmark_regression.py --db_bench=./db_bench \
+#       --batch_write_bench=./terark-tools/batch-write-bench/batch_write_bench \
+#       --output=results.json --baseline=baseline.json
+#   tools/benchmark_regression.py ... --update_baseline
+from __future__ import print_function
+
+import argparse
+import json
+import math
+import os
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+# Every workload runs on a fresh db unless it names a "setup" workload, which
+# is run first to load the db with the same flags, the threads aside.
+# "benchmarks" and "flags" go to db_bench.
+WORKLOADS = [
+    {
+        "name": "fillseq",
+        "benchmarks": "fillseq",
+        "flags": {},
+    },
+    {
+        "name": "fillrandom",
+        "benchmarks": "fillrandom",
+        "flags": {},
+    },
+    {
+        "name": "readrandom",
+        "setup": "fillrandom",
+        "benchmarks": "readrandom",
+        "flags": {"threads": 4},
+    },
+    {
+        "name": "seekrandom",
+        "setup": "fillrandom",
+        "benchmarks": "seekrandom",
+        "flags": {"threads": 4, "seek_nexts": 10},
+    },
+    {
+        "name": "readseq",
+        "setup": "fillrandom",
+        "benchmarks": "readseq",
+        "flags": {},
+    },
+    {
+        "name": "readwhilewriting",
+        "setup": "fillrandom",
+        "benchmarks": "readwhilewriting",
+        "flags": {"threads": 4},
+    },
+    {
+        "name": "updaterandom_kv_sep",
+        "setup": "fillrandom",
+        "benchmarks": "updaterandom_kv_sep",
+        "flags": {"blob_size": 128, "value_size": 1024},
+    },
+    {
+        "name": "readwhilegc",
+        "setup": "fillrandom",
+        "benchmarks": "readwhilegc",
+        "flags": {"threads": 4, "blob_size": 128, "value_size": 1024},
+    },
+    {
+        "name": "lazycompaction_readamp",
+        "setup": "fillrandom",
+        "benchmarks": "lazycompaction_readamp",
+        "flags": {"threads": 4, "enable_lazy_compaction": "true"},
+    },
+]
+
+DB_BENCH_REPORT = re.compile(
+    r"^(\S+)\s*:\s*([0-9.]+) micros/op ([0-9]+) ops/sec")
+BATCH_WRITE_REPORT = re.compile(
+    r"^batch_write_bench\s*:\s*([0-9.]+) MB/sec ([0-9.]+) batches/sec")
+
+
+def run(cmd, log):
+    log.write("$ " + " ".join(cmd) + "\n")
+    log.flush()
+    output = subprocess.check_output(cmd, stderr=subprocess.STDOUT)
+    output = output.decode("utf-8", "replace")
+    log.write(output)
+    return output
+
+
+def db_bench_cmd(args, db, benchmarks, flags, use_existing_db):
+    params = {
+        "db": db,
+        "benchmarks": benchmarks,
+        "num": args.num,
+        "key_size": 20,
+        "value_size": 400,
+        "use_existing_db": 1 if use_existing_db else 0,
+        "statistics": 1,
+        "seed": 301,
+    }
+    params.update(flags)
+    return [args.db_bench] + [
+        "--%s=%s" % (k, v) for k, v in sorted(params.items())]
+
+
+def run_db_bench(args, workload, log):
+    by_name = dict((w["name"], w) for w in WORKLOADS)
+    db = tempfile.mkdtemp(prefix="benchmark_regression_", dir=args.db_dir)
+    try:
+        if "setup" in workload:
+            setup = by_name[workload["setup"]]
+            flags = dict(setup["flags"])
+            flags.update(workload["flags"])
+            flags.pop("threads", None)
+            run(db_bench_cmd(args, db, setup["benchmarks"], flags, False),
+                log)
+        output = run(db_bench_cmd(args, db, workload["benchmarks"],
+                                  workload["flags"], "setup" in workload),
+                     log)
+    finally:
+        shutil.rmtree(db, ignore_errors=True)
+    for line in output.splitlines():
+        m = DB_BENCH_REPORT.match(line)
+        if m and m.group(1) == workload["benchmarks"]:
+            return float(m.group(3))
+    raise RuntimeError("no result of %s in the db_bench output" %
+                       workload["name"])
+
+
+def run_batch_write_bench(args, log):
+    db = tempfile.mkdtemp(prefix="benchmark_regression_", dir=args.db_dir)
+    try:
+        output = run([args.batch_write_bench, "--db_path=" + db,
+                      "--mb_per_thread=%d" % args.batch_write_mb,
+                      "--threads=2"], log)
+    finally:
+        shutil.rmtree(db, ignore_errors=True)
+    for line in output.splitlines():
+        m = BATCH_WRITE_REPORT.match(line)
+        if m:
+            return float(m.group(2))
+    raise RuntimeError("no result in the batch_write_bench output")
+
+
+def summarize(samples):
+    mean = sum(samples) / len(samples)
+    var = 0.0
+    if len(samples) > 1:
+        var = sum((x - mean) ** 2 for x in samples) / (len(samples) - 1)
+    return {"ops_per_sec": samples, "mean": mean, "stddev": math.sqrt(var)}
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(
+            ["git", "rev-parse", "HEAD"],
+            cwd=os.path.dirname(os.path.abspath(__file__))).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+
+
+def compare(results, baseline, threshold, sigmas):
+    regressions = []
+    print("%-24s %14s %14s %8s" % ("workload", "baseline", "current",
+                                   "change"))
+    for name, cur in sorted(results.items()):
+        base = baseline.get(name)
+        if base is None:
+            print("%-24s %14s %14.1f %8s" % (name, "-", cur["mean"], "new"))
+            continue
+        change = cur["mean"] / base["mean"] - 1 if base["mean"] > 0 else 0
+        # Standard error of the difference of the two means
+        stderr = math.sqrt(
+            base["stddev"] ** 2 / len(base["ops_per_sec"]) +
+            cur["stddev"] ** 2 / len(cur["ops_per_sec"]))
+        regressed = (change < -threshold and
+                     base["mean"] - cur["mean"] > sigmas * stderr)
+        print("%-24s %14.1f %14.1f %+7.1f%%%s" %
+              (name, base["mean"], cur["mean"], change * 100,
+               "  REGRESSION" if regressed else ""))
+        if regressed:
+            regressions.append(name)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark regression harness")
+    parser.add_argument("--db_bench", required=True)
+    parser.add_argument("--batch_write_bench", default="",
+                        help="skipped when empty")
+    parser.add_argument("--db_dir", default=None,
+                        help="parent of the temporary dbs")
+    parser.add_argument("--output", default="benchmark_results.json")
+    parser.add_argument("--baseline", default="")
+    parser.add_argument("--update_baseline", action="store_true",
+                        help="write the results to --baseline too")
+    parser.add_argument("--workloads", default="",
+                        help="comma separated subset of the matrix")
+    parser.add_argument("--repeats", type=int, default=3)
+    parser.add_argument("--num", type=int, default=1000000)
+    parser.add_argument("--batch_write_mb", type=int, default=256)
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative drop of the mean to report")
+    parser.add_argument("--sigmas", type=float, default=3.0,
+                        help="standard errors the drop has to exceed")
+    parser.add_argument("--log", default="benchmark_regression.log")
+    args = parser.parse_args()
+
+    selected = set(filter(None, args.workloads.split(",")))
+    workloads = [w for w in WORKLOADS
+                 if not selected or w["name"] in selected]
+    run_batch_write = args.batch_write_bench and (
+        not selected or "batch_write_bench" in selected)
+
+    results = {}
+    with open(args.log, "w") as log:
+        for workload in workloads:
+            samples = [run_db_bench(args, workload, log)
+                       for _ in range(args.repeats)]
+            results[workload["name"]] = summarize(samples)
+            print("%-24s %14.1f ops/sec" % (workload["name"],
+                                             results[workload["name"]]
+                                             ["mean"]))
+        if run_batch_write:
+            samples = [run_batch_write_bench(args, log)
+                       for _ in range(args.repeats)]
+            results["batch_write_bench"] = summarize(samples)
+            print("%-24s %14.1f batches/sec" %
+                  ("batch_write_bench", results["batch_write_bench"]["mean"]))
+
+    report = {
+        "metadata": {
+            "commit": git_commit(),
+            "host": socket.gethostname(),
+            "time": int(time.time()),
+            "num": args.num,
+            "repeats": args.repeats,
+        },
+        "results": results,
+    }
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+
+    regressions = []
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)["results"]
+        regressions = compare(results, baseline, args.threshold, args.sigmas)
+    elif args.baseline:
+        print("No baseline at %s" % args.baseline)
+    if args.update_baseline and args.baseline:
+        shutil.copyfile(args.output, args.baseline)
+
+    if regressions:
+        print("Regressed: " + ", ".join(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
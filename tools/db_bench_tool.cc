@@ -28,6 +28,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -117,6 +118,9 @@ DEFINE_string(
     "readrandomwriterandom,"
     "updaterandom,"
     "xorupdaterandom,"
+    "updaterandom_kv_sep,"
+    "readwhilegc,"
+    "lazycompaction_readamp,"
     "randomwithverify,"
     "fill100K,"
     "crc32c,"
@@ -164,6 +168,12 @@ DEFINE_string(
     "keys\n"
     "\txorupdaterandom  -- N threads doing read-XOR-write for "
     "random keys\n"
+    "\tupdaterandom_kv_sep -- N threads overwriting random keys with "
+    "values separated by blob_size, reports the GC load\n"
+    "\treadwhilegc   -- 1 writer overwriting separated values, N threads "
+    "doing random reads, reports the GC load\n"
+    "\tlazycompaction_readamp -- N threads doing random reads, reports the "
+    "SSTs and blocks read per Get by lazy compaction\n"
     "\tappendrandom  -- N threads doing read-modify-write with "
     "growing values\n"
     "\tmergerandom   -- same as updaterandom/appendrandom using merge"
@@ -379,11 +389,32 @@ DEFINE_uint64(subcompactions, 1,
 static const bool FLAGS_subcompactions_dummy __attribute__((__unused__)) =
     RegisterFlagValidator(&FLAGS_subcompactions, &ValidateUint32Range);
 
+DEFINE_uint64(subcompaction_tasks_per_thread, 1,
+              "Maximum number of subcompactions per subcompaction thread, "
+              "threads done early take the pending ones.");
+static const bool FLAGS_subcompaction_tasks_per_thread_dummy
+    __attribute__((__unused__)) = RegisterFlagValidator(
+        &FLAGS_subcompaction_tasks_per_thread, &ValidateUint32Range);
+
+DEFINE_uint64(compaction_schedule_weight, 1,
+              "Weight of the column families in the compaction and the "
+              "garbage collection queues.");
+static const bool FLAGS_compaction_schedule_weight_dummy
+    __attribute__((__unused__)) = RegisterFlagValidator(
+        &FLAGS_compaction_schedule_weight, &ValidateUint32Range);
+
 DEFINE_int32(max_background_flushes,
              TERARKDB_NAMESPACE::Options().max_background_flushes,
              "The maximum number of concurrent background flushes"
              " that can occur in parallel.");
 
+DEFINE_uint64(max_flush_partitions,
+              TERARKDB_NAMESPACE::Options().max_flush_partitions,
+              "The maximum number of files one flush job may split its "
+              "memtables into.");
+static const bool FLAGS_max_flush_partitions_dummy __attribute__((__unused__)) =
+    RegisterFlagValidator(&FLAGS_max_flush_partitions, &ValidateUint32Range);
+
 static TERARKDB_NAMESPACE::CompactionStyle FLAGS_compaction_style_e;
 DEFINE_int32(compaction_style,
              (int32_t)TERARKDB_NAMESPACE::Options().compaction_style,
@@ -429,6 +460,11 @@ DEFINE_double(cache_high_pri_pool_ratio, 0.0,
               "If > 0.0, we also enable "
               "cache_index_and_filter_blocks_with_high_priority.");
 
+DEFINE_double(cache_high_pri_pool_max_ratio, 0.0,
+              "If > cache_high_pri_pool_ratio, the high pri pool grows up to "
+              "this ratio of block cache with the working set of high pri "
+              "blocks.");
+
 DEFINE_bool(use_clock_cache, false,
             "Replace default LRU block cache with clock cache.");
 
@@ -509,10 +545,22 @@ DEFINE_double(data_block_hash_table_util_ratio, 0.75,
 DEFINE_int64(compressed_cache_size, -1,
              "Number of bytes to use as a cache of compressed data.");
 
+DEFINE_string(compressed_cache_compression_type, "none",
+              "Algorithm used to compress blocks stored uncompressed in the "
+              "file before they go into the compressed cache");
+
 DEFINE_int64(row_cache_size, 0,
              "Number of bytes to use as a cache of individual rows"
              " (0 = disabled).");
 
+DEFINE_int64(blob_cache_size, 0,
+             "Number of bytes to use as a LIRS cache of separated values"
+             " (0 = disabled).");
+
+DEFINE_int64(negative_lookup_cache_size, 0,
+             "Number of recently missed keys to remember per column family"
+             " (0 = disabled).");
+
 DEFINE_int32(open_files, TERARKDB_NAMESPACE::Options().max_open_files,
              "Maximum number of files to keep open at the same time"
              " (use default if == 0)");
@@ -585,6 +633,9 @@ DEFINE_bool(verify_checksum, true,
 
 DEFINE_bool(statistics, false, "Database statistics");
 DEFINE_string(statistics_string, "", "Serialized statistics string");
+DEFINE_int32(statistics_timer_sample_rate, 1,
+             "Time one in every this many operations for the histograms of "
+             "--statistics");
 static class std::shared_ptr<TERARKDB_NAMESPACE::Statistics> dbstats;
 
 DEFINE_int64(writes, -1,
@@ -679,6 +730,10 @@ DEFINE_bool(optimize_filters_for_hits, false,
 DEFINE_bool(optimize_range_deletion, false,
             "Optimizes RangeDeletion when use lazy level compaction");
 
+DEFINE_double(partial_compaction_overlap_ratio, 0,
+              "Rewrite only the overlapping key ranges of a compaction when "
+              "overlapping input files are below this fraction of its bytes");
+
 DEFINE_uint64(delete_obsolete_files_period_micros, 0,
               "Ignored. Left here for backward compatibility");
 
@@ -747,6 +802,11 @@ DEFINE_bool(use_stderr_info_logger, false,
             "Write info logs to stderr instead of to LOG file. ");
 
 DEFINE_string(trace_file, "", "Trace workload to a file. ");
+DEFINE_double(trace_replay_fast_forward, 1.0,
+              "Fast forward trace replay, must be > 0.0.");
+DEFINE_int32(trace_replay_threads, 1,
+             "The number of threads to replay, the operations are "
+             "partitioned by key.");
 
 static enum TERARKDB_NAMESPACE::CompressionType StringToCompressionType(
     const char* ctype) {
@@ -785,6 +845,8 @@ static std::string ColumnFamilyName(size_t i) {
 
 DEFINE_string(compression_type, "snappy",
               "Algorithm to use to compress the database");
+DEFINE_string(wal_compression, "none",
+              "Algorithm to use to compress the WAL, none or zstd");
 static enum TERARKDB_NAMESPACE::CompressionType FLAGS_compression_type_e =
     TERARKDB_NAMESPACE::kSnappyCompression;
 
@@ -882,6 +944,10 @@ DEFINE_uint64(delayed_write_rate, 8388608u,
               "Limited bytes allowed to DB when soft_rate_limit or "
               "level0_slowdown_writes_trigger triggers");
 
+DEFINE_bool(smooth_write_delay, false,
+            "Derive the delayed write rate from the distance to the stop "
+            "triggers instead of adjusting it in fixed steps");
+
 DEFINE_bool(enable_pipelined_write, true,
             "Allow WAL and memtable writes to be pipelined");
 
@@ -907,6 +973,14 @@ DEFINE_uint64(write_thread_slow_yield_usec, 3,
               "The threshold at which a slow yield is considered a signal that "
               "other processes or threads want the core.");
 
+DEFINE_uint64(max_write_batch_group_size_bytes,
+              TERARKDB_NAMESPACE::Options().max_write_batch_group_size_bytes,
+              "The maximum number of bytes covered by one write group.");
+
+DEFINE_uint64(max_write_group_commit_delay_usec, 0,
+              "The maximum microseconds a sync write group leader waits for "
+              "more writers to join before syncing the WAL.");
+
 DEFINE_int32(rate_limit_delay_max_milliseconds, 1000,
              "When hard_rate_limit is set then this is the max time a put will"
              " be stalled.");
@@ -965,12 +1039,27 @@ DEFINE_double(blob_large_key_ratio, 1, "Key Value Separate large key ratio");
 
 DEFINE_double(blob_gc_ratio, 0.2, "Blob SST gc ratio");
 
+DEFINE_double(blob_gc_hotness_weight, 0, "Weight of read hotness in GC score");
+
+DEFINE_double(blob_target_write_amp, 0,
+              "Target write amplification of adaptive separation threshold");
+
 DEFINE_uint64(target_blob_file_size, 0, "Blob file size");
 
+DEFINE_int32(blob_gc_stats_interval_seconds, 10,
+             "Interval of the blob garbage reports of updaterandom_kv_sep "
+             "and readwhilegc, 0 disables them");
+
 DEFINE_uint64(blob_file_defragment_size, 0, "Blob file defragment threshold");
 
 DEFINE_uint64(max_dependence_blob_overlap, 0, "Max dependence blob overlap");
 
+DEFINE_bool(align_blob_output_to_sst, false,
+            "Cut the blob files of a compaction where its SSTs are cut");
+
+DEFINE_uint64(max_map_sst_read_amp, 0,
+              "Max SSTs a key range of map SSTs may link, 0 to unlimited");
+
 DEFINE_uint64(wal_ttl_seconds, 0, "Set the TTL for the WAL Files in seconds.");
 DEFINE_uint64(wal_size_limit_MB, 0,
               "Set the size limit for the WAL Files"
@@ -1021,6 +1110,11 @@ DEFINE_uint64(wal_bytes_per_sync,
               " being written, in the background. Issue one request for every"
               " wal_bytes_per_sync written. 0 turns it off.");
 
+DEFINE_uint64(wal_recovery_readahead_size,
+              TERARKDB_NAMESPACE::Options().wal_recovery_readahead_size,
+              "Bytes of WAL records read ahead of memtable replay on a "
+              "separate thread during recovery. 0 turns it off.");
+
 DEFINE_bool(use_single_deletes, true,
             "Use single deletes (used in RandomReplaceKeys only).");
 
@@ -1050,6 +1144,10 @@ DEFINE_int32(max_successive_merges, 0,
              "Maximum number of successive merge"
              " operations on a key in the memtable");
 
+DEFINE_int32(memtable_merge_fold_threshold, 0,
+             "Fold a merge operand into the memtable head operand once the key"
+             " has this many successive merge operands, 0 to disable");
+
 static bool ValidatePrefixSize(const char* flagname, int32_t value) {
   if (value < 0 || value >= 2000000000) {
     fprintf(stderr, "Invalid value for --%s: %d. 0<= PrefixSize <=2000000000\n",
@@ -1663,9 +1761,9 @@ class Stats {
     std::vector<ThreadStatus> thread_list;
     FLAGS_env->GetThreadList(&thread_list);
 
-    fprintf(stderr, "\n%18s %10s %12s %20s %13s %45s %12s %s\n", "ThreadID",
-            "ThreadType", "cfName", "Operation", "ElapsedTime", "Stage",
-            "State", "OperationProperties");
+    fprintf(stderr, "\n%18s %10s %12s %20s %13s %45s %12s %8s %s\n",
+            "ThreadID", "ThreadType", "cfName", "Operation", "ElapsedTime",
+            "Stage", "State", "Progress", "OperationProperties");
 
     int64_t current_time = 0;
     Env::Default()->GetCurrentTime(&current_time);
@@ -1678,6 +1776,13 @@ class Stats {
               ThreadStatus::MicrosToString(ts.op_elapsed_micros).c_str(),
               ThreadStatus::GetOperationStageName(ts.operation_stage).c_str(),
               ThreadStatus::GetStateName(ts.state_type).c_str());
+      double progress = ThreadStatus::GetOperationProgress(ts.operation_type,
+                                                           ts.op_properties);
+      if (progress >= 0) {
+        fprintf(stderr, " %7.1f%%", progress);
+      } else {
+        fprintf(stderr, " %8s", "-");
+      }
 
       auto op_properties = ThreadStatus::InterpretOperationProperties(
           ts.operation_type, ts.op_properties);
@@ -2051,6 +2156,10 @@ class Benchmark {
   int64_t readwrites_;
   int64_t merge_keys_;
   bool report_file_operations_;
+  // Taken when updaterandom_kv_sep or readwhilegc starts, see
+  // StartBlobGCReport()
+  uint64_t gc_report_start_micros_;
+  std::map<uint32_t, uint64_t> gc_report_start_tickers_;
 
   class ErrorHandlerListener : public EventListener {
    public:
@@ -2348,9 +2457,11 @@ class Benchmark {
       }
       return cache;
     } else {
-      return NewLRUCache((size_t)capacity, FLAGS_cache_numshardbits,
-                         false /*strict_capacity_limit*/,
-                         FLAGS_cache_high_pri_pool_ratio);
+      LRUCacheOptions opts((size_t)capacity, FLAGS_cache_numshardbits,
+                           false /*strict_capacity_limit*/,
+                           FLAGS_cache_high_pri_pool_ratio);
+      opts.high_pri_pool_max_ratio = FLAGS_cache_high_pri_pool_max_ratio;
+      return NewLRUCache(opts);
     }
   }
 
@@ -2377,7 +2488,8 @@ class Benchmark {
                 ? FLAGS_num
                 : ((FLAGS_writes > FLAGS_reads) ? FLAGS_writes : FLAGS_reads)),
         merge_keys_(FLAGS_merge_keys < 0 ? FLAGS_num : FLAGS_merge_keys),
-        report_file_operations_(FLAGS_report_file_operations) {
+        report_file_operations_(FLAGS_report_file_operations),
+        gc_report_start_micros_(0) {
     // use simcache instead of cache
     if (FLAGS_simcache_size >= 0) {
       if (FLAGS_cache_numshardbits >= 1) {
@@ -2738,6 +2850,25 @@ class Benchmark {
         method = &Benchmark::UpdateRandom;
       } else if (name == "xorupdaterandom") {
         method = &Benchmark::XORUpdateRandom;
+      } else if (name == "updaterandom_kv_sep" || name == "readwhilegc") {
+        if (FLAGS_blob_size >= static_cast<uint64_t>(FLAGS_value_size)) {
+          fprintf(stderr,
+                  "Warning: --blob_size >= --value_size, values are not "
+                  "separated\n");
+        }
+        if (name == "readwhilegc") {
+          num_threads++;  // Add extra thread for writing
+          method = &Benchmark::ReadWhileGC;
+        } else {
+          method = &Benchmark::UpdateRandomKVSep;
+        }
+        StartBlobGCReport();
+        post_process_method = &Benchmark::BlobGCReport;
+      } else if (name == "lazycompaction_readamp") {
+        if (!FLAGS_enable_lazy_compaction) {
+          fprintf(stderr, "Warning: --enable_lazy_compaction is false\n");
+        }
+        method = &Benchmark::LazyCompactionReadAmp;
       } else if (name == "appendrandom") {
         method = &Benchmark::AppendRandom;
       } else if (name == "mergerandom") {
@@ -2794,7 +2925,9 @@ class Benchmark {
         PrintStats("rocksdb.sstables");
       } else if (name == "replay") {
         if (num_threads > 1) {
-          fprintf(stderr, "Multi-threaded replay is not yet supported\n");
+          fprintf(stderr,
+                  "Please set --trace_replay_threads instead of --threads "
+                  "for a multi-threaded replay\n");
           exit(1);
         }
         if (FLAGS_trace_file == "") {
@@ -3225,7 +3358,13 @@ class Benchmark {
     options.max_background_jobs = FLAGS_max_background_jobs;
     options.max_background_compactions = FLAGS_max_background_compactions;
     options.max_subcompactions = static_cast<uint32_t>(FLAGS_subcompactions);
+    options.subcompaction_tasks_per_thread =
+        static_cast<uint32_t>(FLAGS_subcompaction_tasks_per_thread);
+    options.compaction_schedule_weight =
+        static_cast<uint32_t>(FLAGS_compaction_schedule_weight);
     options.max_background_flushes = FLAGS_max_background_flushes;
+    options.max_flush_partitions =
+        static_cast<uint32_t>(FLAGS_max_flush_partitions);
     options.compaction_style = FLAGS_compaction_style_e;
     options.compaction_pri = FLAGS_compaction_pri_e;
     options.allow_mmap_reads = FLAGS_mmap_read;
@@ -3399,6 +3538,9 @@ class Benchmark {
       }
       block_based_options.block_cache = cache_;
       block_based_options.block_cache_compressed = compressed_cache_;
+      block_based_options.block_cache_compressed_compression =
+          StringToCompressionType(
+              FLAGS_compressed_cache_compression_type.c_str());
       block_based_options.block_size = FLAGS_block_size;
       block_based_options.block_restart_interval = FLAGS_block_restart_interval;
       block_based_options.index_block_restart_interval =
@@ -3511,6 +3653,7 @@ class Benchmark {
     options.hard_pending_compaction_bytes_limit =
         FLAGS_hard_pending_compaction_bytes_limit;
     options.delayed_write_rate = FLAGS_delayed_write_rate;
+    options.smooth_write_delay = FLAGS_smooth_write_delay;
     options.allow_concurrent_memtable_write =
         FLAGS_allow_concurrent_memtable_write;
     options.inplace_update_support = FLAGS_inplace_update_support;
@@ -3520,6 +3663,10 @@ class Benchmark {
     options.enable_pipelined_write = FLAGS_enable_pipelined_write;
     options.write_thread_max_yield_usec = FLAGS_write_thread_max_yield_usec;
     options.write_thread_slow_yield_usec = FLAGS_write_thread_slow_yield_usec;
+    options.max_write_batch_group_size_bytes =
+        FLAGS_max_write_batch_group_size_bytes;
+    options.max_write_group_commit_delay_usec =
+        FLAGS_max_write_group_commit_delay_usec;
     options.rate_limit_delay_max_milliseconds =
         FLAGS_rate_limit_delay_max_milliseconds;
     options.prepare_log_writer_num = FLAGS_prepare_log_writer_num;
@@ -3530,11 +3677,17 @@ class Benchmark {
     options.blob_size = FLAGS_blob_size;
     options.blob_large_key_ratio = FLAGS_blob_large_key_ratio;
     options.blob_gc_ratio = FLAGS_blob_gc_ratio;
+    options.blob_gc_hotness_weight = FLAGS_blob_gc_hotness_weight;
+    options.blob_target_write_amp = FLAGS_blob_target_write_amp;
     options.target_blob_file_size = FLAGS_target_blob_file_size;
     options.blob_file_defragment_size = FLAGS_blob_file_defragment_size;
     options.max_dependence_blob_overlap = FLAGS_max_dependence_blob_overlap;
+    options.align_blob_output_to_sst = FLAGS_align_blob_output_to_sst;
+    options.max_map_sst_read_amp = FLAGS_max_map_sst_read_amp;
     options.optimize_filters_for_hits = FLAGS_optimize_filters_for_hits;
     options.optimize_range_deletion = FLAGS_optimize_range_deletion;
+    options.partial_compaction_overlap_ratio =
+        FLAGS_partial_compaction_overlap_ratio;
 
     // fill storage options
     options.advise_random_on_open = FLAGS_advise_random_on_open;
@@ -3542,6 +3695,9 @@ class Benchmark {
     options.use_adaptive_mutex = FLAGS_use_adaptive_mutex;
     options.bytes_per_sync = FLAGS_bytes_per_sync;
     options.wal_bytes_per_sync = FLAGS_wal_bytes_per_sync;
+    options.wal_recovery_readahead_size = FLAGS_wal_recovery_readahead_size;
+    options.wal_compression =
+        StringToCompressionType(FLAGS_wal_compression.c_str());
 
     // merge operator options
     options.merge_operator =
@@ -3552,6 +3708,8 @@ class Benchmark {
       exit(1);
     }
     options.max_successive_merges = FLAGS_max_successive_merges;
+    options.memtable_merge_fold_threshold =
+        FLAGS_memtable_merge_fold_threshold;
     options.report_bg_io_stats = FLAGS_report_bg_io_stats;
 
     // set universal style compaction configurations, if applicable
@@ -3631,6 +3789,12 @@ class Benchmark {
         options.row_cache = NewLRUCache(FLAGS_row_cache_size);
       }
     }
+    if (FLAGS_blob_cache_size) {
+      options.blob_cache =
+          NewLIRSCache(FLAGS_blob_cache_size, FLAGS_cache_numshardbits);
+    }
+    options.negative_lookup_cache_size =
+        static_cast<size_t>(FLAGS_negative_lookup_cache_size);
     if (FLAGS_enable_io_prio) {
       FLAGS_env->LowerThreadPoolIOPriority(Env::LOW);
       FLAGS_env->LowerThreadPoolIOPriority(Env::HIGH);
@@ -5124,6 +5288,240 @@ class Benchmark {
     thread->stats.AddMessage(msg);
   }
 
+  // Overwrites random keys, the separated values left behind are the
+  // garbage of the blob SSTs
+  void UpdateRandomKVSep(ThreadState* thread) {
+    RandomGenerator gen;
+    int64_t bytes = 0;
+    uint64_t next_report_micros = 0;
+    Duration duration(FLAGS_duration, writes_);
+
+    std::unique_ptr<const char[]> key_guard;
+    Slice key = AllocateKey(&key_guard);
+    while (!duration.Done(1)) {
+      DB* db = SelectDB(thread);
+      GenerateKeyFromInt(thread->rand.Next() % FLAGS_num, FLAGS_num, &key, -1);
+      if (thread->shared->write_rate_limiter) {
+        thread->shared->write_rate_limiter->Request(
+            key.size() + value_size_, Env::IO_HIGH, nullptr /*stats*/,
+            RateLimiter::OpType::kWrite);
+      }
+      Status s = db->Put(write_options_, key, gen.Generate(value_size_));
+      if (!s.ok()) {
+        fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+        exit(1);
+      }
+      bytes += key.size() + value_size_;
+      thread->stats.FinishedOps(nullptr, db, 1, kUpdate);
+      if (thread->tid == 0) {
+        MaybeReportBlobGarbage(db, &next_report_micros);
+      }
+    }
+    thread->stats.AddBytes(bytes);
+  }
+
+  void ReadWhileGC(ThreadState* thread) {
+    if (thread->tid > 0) {
+      ReadRandomPercentiles(thread, false /* count_tables */);
+      return;
+    }
+    // Special thread that keeps overwriting until the readers are done
+    RandomGenerator gen;
+    int64_t bytes = 0;
+    uint64_t next_report_micros = 0;
+    thread->stats.SetExcludeFromMerge();
+
+    std::unique_ptr<const char[]> key_guard;
+    Slice key = AllocateKey(&key_guard);
+    while (true) {
+      {
+        MutexLock l(&thread->shared->mu);
+        if (thread->shared->num_done + 1 >= thread->shared->num_initialized) {
+          break;
+        }
+      }
+      DB* db = SelectDB(thread);
+      GenerateKeyFromInt(thread->rand.Next() % FLAGS_num, FLAGS_num, &key, -1);
+      if (thread->shared->write_rate_limiter) {
+        thread->shared->write_rate_limiter->Request(
+            key.size() + value_size_, Env::IO_HIGH, nullptr /*stats*/,
+            RateLimiter::OpType::kWrite);
+      }
+      Status s = db->Put(write_options_, key, gen.Generate(value_size_));
+      if (!s.ok()) {
+        fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+        exit(1);
+      }
+      bytes += key.size() + value_size_;
+      thread->stats.FinishedOps(&db_, db_.db, 1, kWrite);
+      MaybeReportBlobGarbage(db, &next_report_micros);
+    }
+    thread->stats.AddBytes(bytes);
+  }
+
+  void LazyCompactionReadAmp(ThreadState* thread) {
+    ReadRandomPercentiles(thread, true /* count_tables */);
+    if (thread->tid == 0) {
+      uint64_t debt = 0;
+      SelectDB(thread)->GetIntProperty(DB::Properties::kReadAmpDebt, &debt);
+      char msg[100];
+      snprintf(msg, sizeof(msg), "(read amp debt %" PRIu64 ")", debt);
+      thread->stats.AddMessage(msg);
+    }
+  }
+
+  // Random reads reporting the latency percentiles. With count_tables the
+  // SSTs and the blocks read per Get are reported too, the SSTs a Map SST
+  // links to are counted by their blocks.
+  void ReadRandomPercentiles(ThreadState* thread, bool count_tables) {
+    int64_t read = 0;
+    int64_t found = 0;
+    int64_t bytes = 0;
+    uint64_t tables = 0;
+    uint64_t blocks = 0;
+    HistogramImpl latency;
+    ReadOptions options(FLAGS_verify_checksum, true);
+    std::unique_ptr<const char[]> key_guard;
+    Slice key = AllocateKey(&key_guard);
+    LazyBuffer lazy_val;
+
+    PerfLevel prev_perf_level = GetPerfLevel();
+    if (count_tables) {
+      if (prev_perf_level < PerfLevel::kEnableCount) {
+        SetPerfLevel(PerfLevel::kEnableCount);
+      }
+      get_perf_context()->EnablePerLevelPerfContext();
+    }
+    Duration duration(FLAGS_duration, reads_);
+    while (!duration.Done(1)) {
+      DB* db = SelectDB(thread);
+      GenerateKeyFromInt(GetRandomKey(&thread->rand), FLAGS_num, &key, -1);
+      if (count_tables) {
+        get_perf_context()->Reset();
+      }
+      lazy_val.clear();
+      uint64_t start_micros = FLAGS_env->NowMicros();
+      Status s = db->Get(options, db->DefaultColumnFamily(), key, &lazy_val);
+      latency.Add(FLAGS_env->NowMicros() - start_micros);
+      read++;
+      if (s.ok()) {
+        found++;
+        bytes += key.size() + lazy_val.size();
+      } else if (!s.IsNotFound()) {
+        fprintf(stderr, "Get returned an error: %s\n", s.ToString().c_str());
+        abort();
+      }
+      if (count_tables) {
+        auto* perf_context = get_perf_context();
+        for (auto& pair : *perf_context->level_to_perf_context) {
+          tables += pair.second.get_from_table_count;
+        }
+        blocks += perf_context->block_cache_hit_count +
+                  perf_context->block_read_count;
+      }
+      thread->stats.FinishedOps(nullptr, db, 1, kRead);
+    }
+    if (count_tables) {
+      get_perf_context()->ClearPerLevelPerfContext();
+      SetPerfLevel(prev_perf_level);
+    }
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "(%" PRIu64 " of %" PRIu64
+             " found, Get micros P50 %.1f P99 %.1f P99.9 %.1f)",
+             found, read, latency.Percentile(50), latency.Percentile(99),
+             latency.Percentile(99.9));
+    std::string message = msg;
+    if (count_tables && read > 0) {
+      snprintf(msg, sizeof(msg), " (%.2f SSTs %.2f blocks per Get)",
+               double(tables) / read, double(blocks) / read);
+      message.append(msg);
+    }
+    thread->stats.AddBytes(bytes);
+    thread->stats.AddMessage(message);
+  }
+
+  void MaybeReportBlobGarbage(DB* db, uint64_t* next_report_micros) {
+    if (FLAGS_blob_gc_stats_interval_seconds <= 0) {
+      return;
+    }
+    uint64_t now = FLAGS_env->NowMicros();
+    if (*next_report_micros == 0) {
+      *next_report_micros =
+          now + FLAGS_blob_gc_stats_interval_seconds * 1000000ull;
+      return;
+    }
+    if (now < *next_report_micros) {
+      return;
+    }
+    *next_report_micros = now + FLAGS_blob_gc_stats_interval_seconds * 1000000ull;
+    uint64_t blob_size = 0, garbage_size = 0;
+    db->GetIntProperty(DB::Properties::kTotalBlobFilesSize, &blob_size);
+    db->GetIntProperty(DB::Properties::kEstimateBlobGarbageSize,
+                       &garbage_size);
+    fprintf(stdout,
+            "%.1f seconds: blob SSTs %.1f MB, garbage ratio %.3f\n",
+            (now - gc_report_start_micros_) / 1000000.0, blob_size / 1048576.0,
+            blob_size > 0 ? double(garbage_size) / blob_size : 0.0);
+    fflush(stdout);
+  }
+
+  static const std::vector<Tickers>& BlobGCReportTickers() {
+    static const std::vector<Tickers> tickers = {
+        BYTES_WRITTEN,       WAL_FILE_BYTES, FLUSH_WRITE_BYTES,
+        COMPACT_WRITE_BYTES, GC_READ_BYTES,  GC_WRITE_BYTES};
+    return tickers;
+  }
+
+  void StartBlobGCReport() {
+    gc_report_start_micros_ = FLAGS_env->NowMicros();
+    gc_report_start_tickers_.clear();
+    if (dbstats) {
+      for (auto ticker : BlobGCReportTickers()) {
+        gc_report_start_tickers_[ticker] = dbstats->getTickerCount(ticker);
+      }
+    }
+  }
+
+  // GC throughput and write amplification since StartBlobGCReport()
+  void BlobGCReport() {
+    DB* db = db_.db != nullptr ? db_.db : multi_dbs_[0].db;
+    double seconds =
+        (FLAGS_env->NowMicros() - gc_report_start_micros_) / 1000000.0;
+    uint64_t blob_size = 0, garbage_size = 0;
+    db->GetIntProperty(DB::Properties::kTotalBlobFilesSize, &blob_size);
+    db->GetIntProperty(DB::Properties::kEstimateBlobGarbageSize,
+                       &garbage_size);
+    fprintf(stdout, "Blob SSTs %.1f MB, garbage ratio %.3f\n",
+            blob_size / 1048576.0,
+            blob_size > 0 ? double(garbage_size) / blob_size : 0.0);
+    if (!dbstats) {
+      fprintf(stdout,
+              "Set --statistics for the GC throughput and write "
+              "amplification\n");
+      return;
+    }
+    std::map<Tickers, double> mb;
+    for (auto ticker : BlobGCReportTickers()) {
+      mb[ticker] = (dbstats->getTickerCount(ticker) -
+                    gc_report_start_tickers_[ticker]) /
+                   1048576.0;
+    }
+    fprintf(stdout,
+            "GC read %.1f MB/s, write %.1f MB/s\n"
+            "Write amplification %.2f (GC %.2f), user writes %.1f MB\n",
+            mb[GC_READ_BYTES] / seconds, mb[GC_WRITE_BYTES] / seconds,
+            mb[BYTES_WRITTEN] > 0
+                ? (mb[WAL_FILE_BYTES] + mb[FLUSH_WRITE_BYTES] +
+                   mb[COMPACT_WRITE_BYTES]) /
+                      mb[BYTES_WRITTEN]
+                : 0.0,
+            mb[BYTES_WRITTEN] > 0 ? mb[GC_WRITE_BYTES] / mb[BYTES_WRITTEN]
+                                  : 0.0,
+            mb[BYTES_WRITTEN]);
+  }
+
   // Read-XOR-write for random keys. Xors the existing value with a randomly
   // generated value, and stores the result. Assuming A in the array of bytes
   // representing the existing value, we generate an array B of the same size,
@@ -5755,10 +6153,14 @@ class Benchmark {
     }
     Replayer replayer(db_with_cfh->db, db_with_cfh->cfh,
                       std::move(trace_reader));
-    s = replayer.Replay();
+    s = replayer.SetFastForward(FLAGS_trace_replay_fast_forward);
+    if (s.ok()) {
+      s = replayer.MultiThreadReplay(
+          static_cast<uint32_t>(std::max(1, FLAGS_trace_replay_threads)));
+    }
     if (s.ok()) {
-      fprintf(stdout, "Replay started from trace_file: %s\n",
-              FLAGS_trace_file.c_str());
+      fprintf(stdout, "Replay finished from trace_file: %s\n%s",
+              FLAGS_trace_file.c_str(), replayer.LatencyReport().c_str());
     } else {
       fprintf(stderr, "Starting replay failed. Error: %s\n",
               s.ToString().c_str());
@@ -5798,6 +6200,10 @@ int db_bench_tool(int argc, char** argv) {
   if (FLAGS_statistics) {
     dbstats = TERARKDB_NAMESPACE::CreateDBStatistics();
   }
+  if (dbstats) {
+    dbstats->timer_sample_rate_ =
+        static_cast<uint32_t>(std::max(1, FLAGS_statistics_timer_sample_rate));
+  }
   FLAGS_compaction_pri_e =
       (TERARKDB_NAMESPACE::CompactionPri)FLAGS_compaction_pri;
 
@@ -41,9 +41,12 @@ int main() {
 #include <algorithm>
 #include <chrono>
 #include <exception>
+#include <future>
+#include <map>
 #include <queue>
 #include <thread>
 
+#include "db/compaction.h"
 #include "db/db_impl.h"
 #include "db/version_set.h"
 #include "hdfs/env_hdfs.h"
@@ -51,6 +54,7 @@ int main() {
 #include "options/options_helper.h"
 #include "port/port.h"
 #include "rocksdb/cache.h"
+#include "rocksdb/compaction_dispatcher.h"
 #include "rocksdb/env.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
@@ -78,6 +82,8 @@ int main() {
 #ifdef BOOSTLIB
 #include <boost/range/algorithm.hpp>
 #endif
+#include "util/fault_injection_test_env.h"
+#include "util/filename.h"
 #include "util/testutil.h"
 #include "utilities/merge_operators.h"
 #include "utilities/util/function.hpp"
@@ -603,6 +609,56 @@ DEFINE_uint64(max_manifest_file_size, 16384, "Maximum size of a MANIFEST file");
 
 DEFINE_bool(in_place_update, false, "On true, does inplace update in memtable");
 
+DEFINE_int32(max_bgerror_resume_count,
+             TERARKDB_NAMESPACE::Options().max_bgerror_resume_count,
+             "Number of retries of a flush or compaction failed by an I/O "
+             "error before it becomes a background error");
+
+DEFINE_uint64(chaos_fault_interval_sec, 0,
+              "If non-zero, inject a fault every this many seconds while the "
+              "database operations run, in turns among the kinds enabled by "
+              "--chaos_slow_io, --chaos_io_errors and --chaos_worker_loss");
+
+DEFINE_uint64(chaos_fault_duration_sec, 5,
+              "How long every injected fault lasts");
+
+DEFINE_bool(chaos_slow_io, true,
+            "Slow disk fault: every file read, append and sync is delayed by "
+            "--chaos_slow_io_micros");
+
+DEFINE_uint64(chaos_slow_io_micros, 2000, "The delay of the slow disk fault");
+
+DEFINE_bool(chaos_io_errors, false,
+            "I/O error fault: the creation of table files fails, so flushes "
+            "and compactions fail and are retried, see "
+            "--max_bgerror_resume_count");
+
+DEFINE_bool(chaos_worker_loss, false,
+            "Run the compactions on --chaos_workers in-process remote "
+            "workers. Worker loss fault: one worker stops answering, its jobs "
+            "run locally once --chaos_worker_timeout_sec is over");
+
+DEFINE_int32(chaos_workers, 2, "Number of remote compaction workers");
+
+DEFINE_uint64(chaos_worker_timeout_sec, 10,
+              "Remote compactions taking longer run locally");
+
+DEFINE_uint64(chaos_report_interval_sec, 0,
+              "If non-zero, report the throughput and the latency percentiles "
+              "of the database operations every this many seconds, and "
+              "whenever a fault starts or ends");
+
+DEFINE_string(chaos_report_file, "",
+              "The CSV file the chaos reports go to, stdout if empty");
+
+DEFINE_uint64(chaos_slo_p99_micros, 0,
+              "If non-zero, the report intervals whose p99 operation latency "
+              "is higher miss the latency SLO, and the test fails");
+
+DEFINE_uint64(chaos_slo_min_ops_per_sec, 0,
+              "If non-zero, the report intervals with a lower throughput miss "
+              "the SLO, and the test fails");
+
 enum RepFactory { kSkipList, kHashSkipList, kVectorRep };
 
 namespace {
@@ -705,6 +761,473 @@ static std::string StringToHex(const std::string& str) {
 class StressTest;
 namespace {
 
+// The faults of the chaos mode, injected in turns
+enum ChaosFault : int {
+  kChaosNoFault,
+  kChaosSlowIO,
+  kChaosIOErrors,
+  kChaosWorkerLoss,
+  kNumChaosFaults,
+};
+
+const char* ChaosFaultName(ChaosFault fault) {
+  switch (fault) {
+    case kChaosNoFault:
+      return "none";
+    case kChaosSlowIO:
+      return "slow_io";
+    case kChaosIOErrors:
+      return "io_errors";
+    case kChaosWorkerLoss:
+      return "worker_loss";
+    default:
+      return "unknown";
+  }
+}
+
+// Delays the reads while the disk is slow
+class ChaosRandomAccessFile : public RandomAccessFileWrapper {
+ public:
+  ChaosRandomAccessFile(std::unique_ptr<RandomAccessFile>&& target, Env* env,
+                        const std::atomic<uint64_t>* slow_io_micros)
+      : RandomAccessFileWrapper(target.get()),
+        target_(std::move(target)),
+        env_(env),
+        slow_io_micros_(slow_io_micros) {}
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    Delay();
+    return RandomAccessFileWrapper::Read(offset, n, result, scratch);
+  }
+
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) override {
+    Delay();
+    return RandomAccessFileWrapper::MultiRead(reqs, num_reqs);
+  }
+
+ private:
+  void Delay() const {
+    uint64_t micros = slow_io_micros_->load(std::memory_order_relaxed);
+    if (micros > 0) {
+      env_->SleepForMicroseconds(static_cast<int>(micros));
+    }
+  }
+
+  std::unique_ptr<RandomAccessFile> target_;
+  Env* env_;
+  const std::atomic<uint64_t>* slow_io_micros_;
+};
+
+// Delays the appends and syncs while the disk is slow
+class ChaosWritableFile : public WritableFileWrapper {
+ public:
+  ChaosWritableFile(std::unique_ptr<WritableFile>&& target, Env* env,
+                    const std::atomic<uint64_t>* slow_io_micros)
+      : WritableFileWrapper(target.get()),
+        target_(std::move(target)),
+        env_(env),
+        slow_io_micros_(slow_io_micros) {}
+
+  Status Append(const Slice& data) override {
+    Delay();
+    return WritableFileWrapper::Append(data);
+  }
+  Status PositionedAppend(const Slice& data, uint64_t offset) override {
+    Delay();
+    return WritableFileWrapper::PositionedAppend(data, offset);
+  }
+  Status Sync() override {
+    Delay();
+    return WritableFileWrapper::Sync();
+  }
+  Status Fsync() override {
+    Delay();
+    return WritableFileWrapper::Fsync();
+  }
+
+ private:
+  void Delay() const {
+    uint64_t micros = slow_io_micros_->load(std::memory_order_relaxed);
+    if (micros > 0) {
+      env_->SleepForMicroseconds(static_cast<int>(micros));
+    }
+  }
+
+  std::unique_ptr<WritableFile> target_;
+  Env* env_;
+  const std::atomic<uint64_t>* slow_io_micros_;
+};
+
+// Injects the disk faults of the chaos mode. Only the creation of table
+// files fails, the background jobs writing them are retried, whereas a
+// failed WAL write would stop the test.
+class ChaosEnv : public FaultInjectionTestEnv {
+ public:
+  explicit ChaosEnv(Env* base)
+      : FaultInjectionTestEnv(base),
+        slow_io_micros_(0),
+        fail_table_files_(false) {}
+
+  Status NewWritableFile(const std::string& fname,
+                         std::unique_ptr<WritableFile>* result,
+                         const EnvOptions& soptions) override {
+    if (fail_table_files_.load(std::memory_order_relaxed) &&
+        IsTableFile(fname)) {
+      return Status::IOError("Injected table file creation failure", fname);
+    }
+    Status s = FaultInjectionTestEnv::NewWritableFile(fname, result, soptions);
+    if (s.ok()) {
+      result->reset(new ChaosWritableFile(std::move(*result), target(),
+                                          &slow_io_micros_));
+    }
+    return s;
+  }
+
+  Status NewRandomAccessFile(const std::string& fname,
+                             std::unique_ptr<RandomAccessFile>* result,
+                             const EnvOptions& soptions) override {
+    Status s =
+        FaultInjectionTestEnv::NewRandomAccessFile(fname, result, soptions);
+    if (s.ok()) {
+      result->reset(new ChaosRandomAccessFile(std::move(*result), target(),
+                                              &slow_io_micros_));
+    }
+    return s;
+  }
+
+  void SetSlowIO(uint64_t micros) {
+    slow_io_micros_.store(micros, std::memory_order_relaxed);
+  }
+
+  void SetFailTableFiles(bool fail) {
+    fail_table_files_.store(fail, std::memory_order_relaxed);
+  }
+
+ private:
+  static bool IsTableFile(const std::string& fname) {
+    uint64_t number;
+    FileType type;
+    return ParseFileName(fname.substr(fname.find_last_of('/') + 1), &number,
+                         &type) &&
+           type == kTableFile;
+  }
+
+  std::atomic<uint64_t> slow_io_micros_;
+  std::atomic<bool> fail_table_files_;
+};
+
+#ifdef WITH_TERARK_ZIP
+// A remote compaction worker running its jobs in process. While it is lost
+// the jobs it gets never finish, until the dispatcher gives up on them or
+// the worker is back.
+class ChaosWorkerClient : public CompactionWorkerClient {
+ public:
+  ChaosWorkerClient(Env* env, const std::string& output_dir)
+      : env_(env), output_dir_(output_dir), lost_(false) {}
+
+  ~ChaosWorkerClient() { SetLost(false); }
+
+  const char* Name() const override { return "ChaosWorker"; }
+
+  std::future<std::string> DoCompaction(uint64_t job_id,
+                                        std::string data) override {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    {
+      MutexLock l(&mutex_);
+      if (lost_) {
+        lost_jobs_.emplace(job_id, promise);
+        return future;
+      }
+    }
+    Env* env = env_;
+    std::string output_prefix = output_dir_ + "/" + ToString(job_id) + "_";
+    std::thread([env, output_prefix, promise, data]() {
+      Worker worker(env, output_prefix);
+      try {
+        promise->set_value(worker.DoCompaction(data));
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    }).detach();
+    return future;
+  }
+
+  void Cancel(uint64_t job_id) override {
+    MutexLock l(&mutex_);
+    auto it = lost_jobs_.find(job_id);
+    if (it != lost_jobs_.end()) {
+      FailJob(it->second.get());
+      lost_jobs_.erase(it);
+    }
+  }
+
+  // The jobs left while lost fail once the worker is back
+  void SetLost(bool lost) {
+    MutexLock l(&mutex_);
+    lost_ = lost;
+    if (!lost) {
+      for (auto& job : lost_jobs_) {
+        FailJob(job.second.get());
+      }
+      lost_jobs_.clear();
+    }
+  }
+
+ private:
+  class Worker : public RemoteCompactionDispatcher::Worker {
+   public:
+    Worker(Env* env, const std::string& output_prefix)
+        : RemoteCompactionDispatcher::Worker(EnvOptions(), env),
+          output_prefix_(output_prefix) {}
+
+    std::string GenerateOutputFileName(size_t file_index) override {
+      return output_prefix_ + ToString(file_index) + ".sst";
+    }
+
+   private:
+    std::string output_prefix_;
+  };
+
+  static void FailJob(std::promise<std::string>* promise) {
+    CompactionWorkerResult result;
+    result.status = Status::IOError("Compaction worker lost");
+    std::string encoded;
+    result.EncodeTo(&encoded);
+    promise->set_value(std::move(encoded));
+  }
+
+  Env* env_;
+  std::string output_dir_;
+  port::Mutex mutex_;
+  bool lost_;
+  std::map<uint64_t, std::shared_ptr<std::promise<std::string>>> lost_jobs_;
+};
+#endif  // WITH_TERARK_ZIP
+
+// Injects the faults of the chaos mode in turns while the operations run,
+// and reports the throughput and the latency percentiles of the operations
+// per interval. An interval ends whenever a fault starts or ends, so that
+// every one runs under a single fault.
+class ChaosMonitor {
+ public:
+  explicit ChaosMonitor(ChaosEnv* env)
+      : env_(env),
+        current_(0),
+        fault_(kChaosNoFault),
+        report_file_(stdout),
+        stop_(false),
+        cv_(&mutex_) {
+    if (FLAGS_chaos_slow_io) {
+      faults_.push_back(kChaosSlowIO);
+    }
+    if (FLAGS_chaos_io_errors) {
+      faults_.push_back(kChaosIOErrors);
+    }
+#ifdef WITH_TERARK_ZIP
+    if (FLAGS_chaos_worker_loss) {
+      std::string output_dir = FLAGS_db + "_chaos_worker";
+      env_->CreateDirIfMissing(output_dir);
+      for (int i = 0; i < FLAGS_chaos_workers; ++i) {
+        workers_.emplace_back(
+            std::make_shared<ChaosWorkerClient>(env_, output_dir));
+      }
+      faults_.push_back(kChaosWorkerLoss);
+    }
+#endif  // WITH_TERARK_ZIP
+    memset(intervals_, 0, sizeof(intervals_));
+    memset(slo_misses_, 0, sizeof(slo_misses_));
+  }
+
+  ~ChaosMonitor() {
+    if (report_file_ != stdout) {
+      fclose(report_file_);
+    }
+  }
+
+  void PrepareOptions(Options* options) const {
+#ifdef WITH_TERARK_ZIP
+    if (!workers_.empty()) {
+      CompactionWorkerPoolOptions pool_options;
+      pool_options.remote_timeout_micros =
+          FLAGS_chaos_worker_timeout_sec * 1000000;
+      options->compaction_dispatcher = NewCompactionWorkerPoolDispatcher(
+          std::vector<std::shared_ptr<CompactionWorkerClient>>(
+              workers_.begin(), workers_.end()),
+          pool_options, env_);
+    }
+#else
+    (void)options;
+#endif  // WITH_TERARK_ZIP
+  }
+
+  // Called by the operating threads
+  void AddOp(uint64_t micros) {
+    // An op racing with the end of the interval may land in the next one
+    hist_[current_.load(std::memory_order_relaxed)].Add(micros);
+    fault_hist_[fault_.load(std::memory_order_relaxed)].Add(micros);
+  }
+
+  bool Start() {
+    if (!FLAGS_chaos_report_file.empty()) {
+      report_file_ = fopen(FLAGS_chaos_report_file.c_str(), "w");
+      if (report_file_ == nullptr) {
+        fprintf(stderr, "Cannot open %s\n", FLAGS_chaos_report_file.c_str());
+        report_file_ = stdout;
+        return false;
+      }
+    }
+    fprintf(report_file_,
+            "elapsed_sec,fault,ops,ops_per_sec,p50_micros,p99_micros,"
+            "p999_micros,max_micros,slo_met\n");
+    start_ = interval_start_ = env_->NowMicros();
+    hist_[0].Clear();
+    hist_[1].Clear();
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+  }
+
+  // Lifts the fault and prints the summary per fault. Returns whether every
+  // interval met the SLO.
+  bool Stop() {
+    {
+      MutexLock l(&mutex_);
+      stop_ = true;
+      cv_.Signal();
+    }
+    thread_.join();
+    uint64_t misses = 0;
+    fprintf(stdout, "Chaos summary (micros per op):\n");
+    for (int i = 0; i < kNumChaosFaults; ++i) {
+      const HistogramImpl& hist = fault_hist_[i];
+      if (hist.num() == 0) {
+        continue;
+      }
+      fprintf(stdout,
+              "%-12s: %" PRIu64 " ops, P50 %.0f, P99 %.0f, P99.9 %.0f, "
+              "max %" PRIu64 ", %" PRIu64 " of %" PRIu64
+              " intervals missed the SLO\n",
+              ChaosFaultName(static_cast<ChaosFault>(i)), hist.num(),
+              hist.Percentile(50), hist.Percentile(99), hist.Percentile(99.9),
+              hist.max(), slo_misses_[i], intervals_[i]);
+      misses += slo_misses_[i];
+    }
+    fflush(stdout);
+    return misses == 0;
+  }
+
+ private:
+  void Run() {
+    const uint64_t kNever = port::kMaxUint64;
+    const uint64_t report_interval = FLAGS_chaos_report_interval_sec * 1000000;
+    const uint64_t fault_interval = FLAGS_chaos_fault_interval_sec * 1000000;
+    uint64_t next_report =
+        report_interval > 0 ? start_ + report_interval : kNever;
+    uint64_t next_fault =
+        fault_interval > 0 && !faults_.empty() ? start_ + fault_interval
+                                               : kNever;
+    uint64_t fault_end = kNever;
+    size_t next_kind = 0;
+
+    MutexLock l(&mutex_);
+    while (!stop_) {
+      uint64_t now = env_->NowMicros();
+      uint64_t deadline = std::min({next_report, next_fault, fault_end,
+                                    now + 1000000 /* recheck */});
+      if (deadline > now) {
+        cv_.TimedWait(deadline);
+        continue;
+      }
+      if (now >= fault_end) {
+        SwitchFault(kChaosNoFault, now);
+        fault_end = kNever;
+      }
+      if (now >= next_fault) {
+        SwitchFault(faults_[next_kind++ % faults_.size()], now);
+        fault_end = now + FLAGS_chaos_fault_duration_sec * 1000000;
+        next_fault += fault_interval;
+      }
+      if (now >= next_report) {
+        ReportInterval(now);
+        next_report = now + report_interval;
+      }
+    }
+    uint64_t now = env_->NowMicros();
+    SwitchFault(kChaosNoFault, now);
+    ReportInterval(now);
+  }
+
+  // REQUIRES: mutex_ held
+  void SwitchFault(ChaosFault fault, uint64_t now) {
+    if (fault == fault_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    ReportInterval(now);
+    env_->SetSlowIO(fault == kChaosSlowIO ? FLAGS_chaos_slow_io_micros : 0);
+    env_->SetFailTableFiles(fault == kChaosIOErrors);
+#ifdef WITH_TERARK_ZIP
+    if (!workers_.empty()) {
+      workers_[0]->SetLost(fault == kChaosWorkerLoss);
+    }
+#endif  // WITH_TERARK_ZIP
+    fault_.store(fault, std::memory_order_relaxed);
+    fprintf(stdout, "%s Chaos fault: %s\n",
+            env_->TimeToString(now / 1000000).c_str(), ChaosFaultName(fault));
+  }
+
+  // REQUIRES: mutex_ held
+  void ReportInterval(uint64_t now) {
+    int last = current_.load(std::memory_order_relaxed);
+    current_.store(last ^ 1, std::memory_order_relaxed);
+    HistogramImpl& hist = hist_[last];
+    double seconds = (now - interval_start_) * 1e-6;
+    if (seconds >= 0.001) {
+      ChaosFault fault = fault_.load(std::memory_order_relaxed);
+      double ops_per_sec = hist.num() / seconds;
+      double p99 = hist.Percentile(99);
+      bool slo_met = (FLAGS_chaos_slo_p99_micros == 0 ||
+                      p99 <= FLAGS_chaos_slo_p99_micros) &&
+                     ops_per_sec >= FLAGS_chaos_slo_min_ops_per_sec;
+      ++intervals_[fault];
+      if (!slo_met) {
+        ++slo_misses_[fault];
+      }
+      fprintf(report_file_,
+              "%.3f,%s,%" PRIu64 ",%.0f,%.0f,%.0f,%.0f,%" PRIu64 ",%d\n",
+              (now - start_) * 1e-6, ChaosFaultName(fault), hist.num(),
+              ops_per_sec, hist.Percentile(50), p99, hist.Percentile(99.9),
+              hist.max(), slo_met ? 1 : 0);
+      fflush(report_file_);
+    }
+    hist.Clear();
+    interval_start_ = now;
+  }
+
+  ChaosEnv* env_;
+  std::vector<ChaosFault> faults_;
+#ifdef WITH_TERARK_ZIP
+  std::vector<std::shared_ptr<ChaosWorkerClient>> workers_;
+#endif  // WITH_TERARK_ZIP
+  // The ops of the current interval go to hist_[current_]
+  HistogramImpl hist_[2];
+  std::atomic<int> current_;
+  HistogramImpl fault_hist_[kNumChaosFaults];
+  std::atomic<ChaosFault> fault_;
+  uint64_t intervals_[kNumChaosFaults];
+  uint64_t slo_misses_[kNumChaosFaults];
+  uint64_t start_;
+  uint64_t interval_start_;
+  FILE* report_file_;
+  std::thread thread_;
+  port::Mutex mutex_;
+  bool stop_;
+  port::CondVar cv_;
+};
+
+// Set in main() when the chaos mode is on
+ChaosMonitor* chaos_monitor = nullptr;
+
 class Stats {
  private:
   uint64_t start_;
@@ -784,12 +1307,17 @@ class Stats {
   }
 
   void FinishedSingleOp() {
-    if (FLAGS_histogram) {
+    if (FLAGS_histogram || chaos_monitor != nullptr) {
       auto now = FLAGS_env->NowMicros();
       auto micros = now - last_op_finish_;
-      hist_.Add(micros);
-      if (micros > 20000) {
-        fprintf(stdout, "long op: %" PRIu64 " micros%30s\r", micros, "");
+      if (FLAGS_histogram) {
+        hist_.Add(micros);
+        if (micros > 20000) {
+          fprintf(stdout, "long op: %" PRIu64 " micros%30s\r", micros, "");
+        }
+      }
+      if (chaos_monitor != nullptr) {
+        chaos_monitor->AddOp(micros);
       }
       last_op_finish_ = now;
     }
@@ -1490,6 +2018,7 @@ class StressTest {
   }
 
   bool Run() {
+    bool slo_met = true;
     uint64_t now = FLAGS_env->NowMicros();
     fprintf(stdout, "%s Initializing db_stress\n",
             FLAGS_env->TimeToString(now / 1000000).c_str());
@@ -1535,9 +2064,15 @@ class StressTest {
 
       shared.SetStart();
       shared.GetCondVar()->SignalAll();
+      if (chaos_monitor != nullptr && !chaos_monitor->Start()) {
+        exit(1);
+      }
       while (!shared.AllOperated()) {
         shared.GetCondVar()->Wait();
       }
+      if (chaos_monitor != nullptr) {
+        slo_met = chaos_monitor->Stop();
+      }
 
       now = FLAGS_env->NowMicros();
       if (FLAGS_test_batches_snapshots) {
@@ -1583,6 +2118,10 @@ class StressTest {
       printf("Verification failed :(\n");
       return false;
     }
+    if (!slo_met) {
+      printf("Latency SLO missed :(\n");
+      return false;
+    }
     return true;
   }
 
@@ -2408,6 +2947,7 @@ class StressTest {
       options_.max_open_files = FLAGS_open_files;
       options_.statistics = dbstats;
       options_.env = FLAGS_env;
+      options_.max_bgerror_resume_count = FLAGS_max_bgerror_resume_count;
       options_.use_fsync = FLAGS_use_fsync;
       options_.compaction_readahead_size = FLAGS_compaction_readahead_size;
       options_.allow_mmap_reads = FLAGS_mmap_read;
@@ -2513,6 +3053,10 @@ class StressTest {
       options_.merge_operator = MergeOperators::CreatePutOperator();
     }
 
+    if (chaos_monitor != nullptr) {
+      chaos_monitor->PrepareOptions(&options_);
+    }
+
     fprintf(stdout, "DB path: [%s]\n", FLAGS_db.c_str());
 
     Status s;
@@ -3769,6 +4313,28 @@ int main(int argc, char** argv) {
             "Error: clear_column_family_one_in must be 0 when using backup\n");
     exit(1);
   }
+  if (FLAGS_chaos_fault_interval_sec > 0) {
+    if (FLAGS_chaos_fault_duration_sec >= FLAGS_chaos_fault_interval_sec) {
+      fprintf(stderr,
+              "Error: chaos_fault_duration_sec must be less than "
+              "chaos_fault_interval_sec\n");
+      exit(1);
+    }
+    if (FLAGS_chaos_io_errors &&
+        (FLAGS_max_bgerror_resume_count <= 0 || FLAGS_reopen > 0)) {
+      fprintf(stderr,
+              "Error: chaos_io_errors needs max_bgerror_resume_count > 0 "
+              "and reopen == 0\n");
+      exit(1);
+    }
+#ifndef WITH_TERARK_ZIP
+    if (FLAGS_chaos_worker_loss) {
+      fprintf(stderr,
+              "Error: chaos_worker_loss needs a build with terark zip\n");
+      exit(1);
+    }
+#endif  // !WITH_TERARK_ZIP
+  }
 
   // Choose a location for the test database if none given with --db=<path>
   if (FLAGS_db.empty()) {
@@ -3781,6 +4347,16 @@ int main(int argc, char** argv) {
   rocksdb_kill_odds = FLAGS_kill_random_test;
   rocksdb_kill_prefix_blacklist = SplitString(FLAGS_kill_prefix_blacklist);
 
+  std::unique_ptr<TERARKDB_NAMESPACE::ChaosEnv> chaos_env;
+  std::unique_ptr<TERARKDB_NAMESPACE::ChaosMonitor> monitor;
+  if (FLAGS_chaos_fault_interval_sec > 0 ||
+      FLAGS_chaos_report_interval_sec > 0) {
+    chaos_env.reset(new TERARKDB_NAMESPACE::ChaosEnv(FLAGS_env));
+    FLAGS_env = chaos_env.get();
+    monitor.reset(new TERARKDB_NAMESPACE::ChaosMonitor(chaos_env.get()));
+    TERARKDB_NAMESPACE::chaos_monitor = monitor.get();
+  }
+
   std::unique_ptr<TERARKDB_NAMESPACE::StressTest> stress;
   if (FLAGS_atomic_flush) {
     stress.reset(new TERARKDB_NAMESPACE::AtomicFlushStressTest());
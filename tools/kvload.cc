@@ -0,0 +1,458 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Bulk loads "key\tvalue" lines from stdin without going through the
+// memtable. The input is cut into batches, which flow through a pipeline of
+// stages running concurrently:
+//
+//   parse -> sort -> build sst files -> ingest -> verify (optional)
+//
+// A batch is sorted and deduplicated (the last value of a key wins), then
+// cut into non-overlapping sst files built in parallel by
+// ParallelSstFileWriter, in the table format of the loaded options, and
+// ingested with one IngestExternalFile call. Batches are ingested in input
+// order, so a key repeated across batches keeps its last value too.
+
+#ifndef ROCKSDB_LITE
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/options.h"
+#include "rocksdb/sst_file_writer.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/utilities/options_util.h"
+
+using namespace TERARKDB_NAMESPACE;
+
+static void usage(const char* prog) {
+  fprintf(stderr, R"EOS(usage: %s [options] db_path < key_tab_value_lines
+
+  -B batch_size
+     bytes of input sorted and ingested at once, default 256M
+
+  -t build_threads
+     sst files built concurrently per batch, default 4
+
+  -f target_file_size
+     bytes of keys and values per sst file, default 64M
+
+  -q queue_size
+     batches waiting between two stages, default 1
+
+  -O options_file
+     RocksDB options file of the db, the default column family is loaded.
+     Without it, the default options are used
+
+  -v verify_batch_size
+     read back every ingested batch with MultiGet of this many keys,
+     default 0 (no verification)
+
+  -b bench_report
+     report the stages every bench_report batches, default 0 (only at end)
+
+  -s sst_dir
+     directory of the sst files before they are ingested, default
+     db_path.kvload
+)EOS",
+          prog);
+}
+
+static uint64_t ParseSize(const char* s) {
+  char* endp = nullptr;
+  uint64_t n = strtoull(s, &endp, 10);
+  switch (*endp) {
+    case 'k':
+    case 'K':
+      return n << 10;
+    case 'm':
+    case 'M':
+      return n << 20;
+    case 'g':
+    case 'G':
+      return n << 30;
+    default:
+      return n;
+  }
+}
+
+namespace {
+
+// Keys and values of a batch, in one buffer
+struct Batch {
+  struct Entry {
+    size_t offset;
+    uint32_t key_size;
+    uint32_t value_size;
+  };
+  uint64_t seq = 0;
+  std::string buffer;
+  std::vector<Entry> entries;
+  std::vector<std::string> files;
+
+  Slice key(const Entry& e) const {
+    return Slice(buffer.data() + e.offset, e.key_size);
+  }
+  Slice value(const Entry& e) const {
+    return Slice(buffer.data() + e.offset + e.key_size, e.value_size);
+  }
+};
+
+// Bounded queue between two stages, nullptr marks the end of the input
+class BatchQueue {
+ public:
+  explicit BatchQueue(size_t capacity) : capacity_(capacity) {}
+
+  void Push(std::unique_ptr<Batch> batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return queue_.size() < capacity_; });
+    queue_.push_back(std::move(batch));
+    cv_.notify_all();
+  }
+
+  std::unique_ptr<Batch> Pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !queue_.empty(); });
+    std::unique_ptr<Batch> batch = std::move(queue_.front());
+    queue_.pop_front();
+    cv_.notify_all();
+    return batch;
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Batch>> queue_;
+};
+
+struct StageStats {
+  const char* name;
+  std::atomic<uint64_t> micros{0};
+  std::atomic<uint64_t> records{0};
+  std::atomic<uint64_t> bytes{0};
+
+  explicit StageStats(const char* _name) : name(_name) {}
+
+  void Add(uint64_t _micros, uint64_t _records, uint64_t _bytes) {
+    micros += _micros;
+    records += _records;
+    bytes += _bytes;
+  }
+
+  // The throughput is over the time the stage was busy, the slowest stage
+  // bounds the pipeline
+  void Report() const {
+    double sec = micros.load() / 1e6;
+    fprintf(stderr,
+            "%-7s records %12" PRIu64 " MB %10.1f busy %8.2f s "
+            "%8.3f M records/s %8.1f MB/s\n",
+            name, records.load(), bytes.load() / 1048576.0, sec,
+            sec > 0 ? records.load() / sec / 1e6 : 0,
+            sec > 0 ? bytes.load() / sec / 1048576.0 : 0);
+  }
+};
+
+std::mutex fail_mutex;
+std::atomic<bool> failed(false);
+
+// Reports the first error, the stages drop the batches after it
+void Fail(const char* stage, const Status& s) {
+  std::lock_guard<std::mutex> lock(fail_mutex);
+  if (!failed) {
+    fprintf(stderr, "ERROR: %s: %s\n", stage, s.ToString().c_str());
+    failed = true;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t batch_size = 256 << 20;
+  int build_threads = 4;
+  uint64_t target_file_size = 64 << 20;
+  size_t queue_size = 1;
+  std::string options_file;
+  size_t verify_batch_size = 0;
+  uint64_t bench_report = 0;
+  std::string sst_dir;
+  for (int gopt = 0; -1 != gopt && '?' != gopt;) {
+    gopt = getopt(argc, argv, "B:t:f:q:O:v:b:s:");
+    switch (gopt) {
+      default:
+        usage(argv[0]);
+        return 1;
+      case -1:
+        break;
+      case 'B':
+        batch_size = ParseSize(optarg);
+        break;
+      case 't':
+        build_threads = std::max(1, atoi(optarg));
+        break;
+      case 'f':
+        target_file_size = ParseSize(optarg);
+        break;
+      case 'q':
+        queue_size = std::max(1, atoi(optarg));
+        break;
+      case 'O':
+        options_file = optarg;
+        break;
+      case 'v':
+        verify_batch_size = atoi(optarg);
+        break;
+      case 'b':
+        bench_report = atoi(optarg);
+        break;
+      case 's':
+        sst_dir = optarg;
+        break;
+    }
+  }
+  if (optind >= argc) {
+    usage(argv[0]);
+    return 1;
+  }
+  std::string path = argv[optind];
+  if (sst_dir.empty()) {
+    sst_dir = path + ".kvload";
+  }
+
+  Env* env = Env::Default();
+  Options options;
+  if (!options_file.empty()) {
+    DBOptions db_options;
+    std::vector<ColumnFamilyDescriptor> cf_descs;
+    Status s = LoadOptionsFromFile(options_file, env, &db_options, &cf_descs);
+    if (!s.ok()) {
+      fprintf(stderr, "ERROR: LoadOptionsFromFile(%s) = %s\n",
+              options_file.c_str(), s.ToString().c_str());
+      return 1;
+    }
+    ColumnFamilyOptions cf_options;
+    for (auto& desc : cf_descs) {
+      if (desc.name == kDefaultColumnFamilyName) {
+        cf_options = desc.options;
+      }
+    }
+    options = Options(db_options, cf_options);
+  }
+  options.create_if_missing = true;
+  env->CreateDirIfMissing(sst_dir);
+  DB* db = nullptr;
+  Status s = DB::Open(options, path, &db);
+  if (!s.ok()) {
+    fprintf(stderr, "ERROR: Open(%s) = %s\n", path.c_str(),
+            s.ToString().c_str());
+    return 1;
+  }
+  const Comparator* ucmp = options.comparator;
+
+  StageStats parse_stats("parse"), sort_stats("sort"), build_stats("build"),
+      ingest_stats("ingest"), verify_stats("verify");
+  auto report = [&] {
+    parse_stats.Report();
+    sort_stats.Report();
+    build_stats.Report();
+    ingest_stats.Report();
+    if (verify_batch_size > 0) {
+      verify_stats.Report();
+    }
+  };
+  BatchQueue to_sort(queue_size), to_build(queue_size), to_ingest(queue_size);
+
+  std::thread sorter([&] {
+    while (auto batch = to_sort.Pop()) {
+      if (failed) {
+        continue;
+      }
+      uint64_t start = env->NowMicros();
+      auto& entries = batch->entries;
+      size_t input = entries.size();
+      std::stable_sort(entries.begin(), entries.end(),
+                       [&](const Batch::Entry& a, const Batch::Entry& b) {
+                         return ucmp->Compare(batch->key(a), batch->key(b)) <
+                                0;
+                       });
+      // Of the equal keys, the last one read is kept
+      size_t n = 0;
+      for (size_t i = 0; i < entries.size(); ++i) {
+        if (n > 0 && ucmp->Equal(batch->key(entries[n - 1]),
+                                 batch->key(entries[i]))) {
+          entries[n - 1] = entries[i];
+        } else {
+          entries[n++] = entries[i];
+        }
+      }
+      entries.resize(n);
+      sort_stats.Add(env->NowMicros() - start, input, batch->buffer.size());
+      to_build.Push(std::move(batch));
+    }
+    to_build.Push(nullptr);
+  });
+
+  std::thread builder([&] {
+    while (auto batch = to_build.Pop()) {
+      if (failed) {
+        continue;
+      }
+      uint64_t start = env->NowMicros();
+      ParallelSstFileWriter writer(EnvOptions(options), options, nullptr,
+                                   build_threads, target_file_size);
+      Status bs = writer.Open(sst_dir + "/batch" + std::to_string(batch->seq) + "_");
+      for (size_t i = 0; bs.ok() && i < batch->entries.size(); ++i) {
+        auto& e = batch->entries[i];
+        bs = writer.Put(batch->key(e), batch->value(e));
+      }
+      std::vector<ExternalSstFileInfo> infos;
+      if (bs.ok()) {
+        bs = writer.Finish(&infos);
+      }
+      if (!bs.ok()) {
+        Fail("build", bs);
+        continue;
+      }
+      uint64_t file_bytes = 0;
+      for (auto& info : infos) {
+        batch->files.push_back(info.file_path);
+        file_bytes += info.file_size;
+      }
+      build_stats.Add(env->NowMicros() - start, batch->entries.size(),
+                      file_bytes);
+      to_ingest.Push(std::move(batch));
+    }
+    to_ingest.Push(nullptr);
+  });
+
+  std::thread ingester([&] {
+    uint64_t batches = 0;
+    while (auto batch = to_ingest.Pop()) {
+      if (failed) {
+        continue;
+      }
+      uint64_t start = env->NowMicros();
+      IngestExternalFileOptions ingest_options;
+      ingest_options.move_files = true;
+      Status is = batch->files.empty()
+                      ? Status::OK()
+                      : db->IngestExternalFile(batch->files, ingest_options);
+      if (!is.ok()) {
+        Fail("ingest", is);
+        continue;
+      }
+      ingest_stats.Add(env->NowMicros() - start, batch->entries.size(),
+                       batch->buffer.size());
+
+      // Batches are ingested in order, nothing newer hides this one yet
+      if (verify_batch_size > 0) {
+        start = env->NowMicros();
+        std::vector<Slice> keys;
+        std::vector<std::string> values;
+        auto& entries = batch->entries;
+        for (size_t i = 0; is.ok() && i < entries.size();
+             i += verify_batch_size) {
+          size_t end = std::min(entries.size(), i + verify_batch_size);
+          keys.clear();
+          for (size_t j = i; j < end; ++j) {
+            keys.push_back(batch->key(entries[j]));
+          }
+          std::vector<Status> statuses =
+              db->MultiGet(ReadOptions(), keys, &values);
+          for (size_t j = i; is.ok() && j < end; ++j) {
+            is = statuses[j - i];
+            if (is.ok() && batch->value(entries[j]) != values[j - i]) {
+              is = Status::Corruption("Value mismatch of key",
+                                      batch->key(entries[j]).ToString(true));
+            }
+          }
+        }
+        if (!is.ok()) {
+          Fail("verify", is);
+          continue;
+        }
+        verify_stats.Add(env->NowMicros() - start, entries.size(),
+                         batch->buffer.size());
+      }
+      if (bench_report > 0 && ++batches % bench_report == 0) {
+        fprintf(stderr, "after %" PRIu64 " batches:\n", batches);
+        report();
+      }
+    }
+  });
+
+  // Parse stage, on the main thread
+  std::unique_ptr<Batch> batch(new Batch);
+  uint64_t next_seq = 0;
+  uint64_t parse_start = env->NowMicros();
+  char* line = nullptr;
+  size_t line_cap = 0;
+  ssize_t len;
+  while (!failed && (len = getline(&line, &line_cap, stdin)) > 0) {
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+      --len;
+    }
+    const char* tab = static_cast<const char*>(memchr(line, '\t', len));
+    size_t key_size = tab ? tab - line : len;
+    size_t value_size = tab ? len - key_size - 1 : 0;
+    batch->entries.push_back(
+        {batch->buffer.size(), static_cast<uint32_t>(key_size),
+         static_cast<uint32_t>(value_size)});
+    batch->buffer.append(line, key_size);
+    batch->buffer.append(line + key_size + (tab ? 1 : 0), value_size);
+    if (batch->buffer.size() >= batch_size) {
+      batch->seq = next_seq++;
+      parse_stats.Add(env->NowMicros() - parse_start, batch->entries.size(),
+                      batch->buffer.size());
+      to_sort.Push(std::move(batch));
+      batch.reset(new Batch);
+      parse_start = env->NowMicros();
+    }
+  }
+  free(line);
+  if (!batch->entries.empty()) {
+    batch->seq = next_seq++;
+    parse_stats.Add(env->NowMicros() - parse_start, batch->entries.size(),
+                    batch->buffer.size());
+    to_sort.Push(std::move(batch));
+  }
+  to_sort.Push(nullptr);
+  sorter.join();
+  builder.join();
+  ingester.join();
+
+  report();
+  delete db;
+  // Only left when empty
+  env->DeleteDir(sst_dir);
+  return failed ? 1 : 0;
+}
+
+#else  // ROCKSDB_LITE
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as kvload is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+#endif  // ROCKSDB_LITE
@@ -15,15 +15,18 @@
 #ifdef BOOSTLIB
 #include <boost/range/algorithm.hpp>
 #endif
+#include <condition_variable>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
 #include "db/db_impl.h"
 #include "db/dbformat.h"
@@ -786,15 +789,19 @@ bool LDBCommand::StringToBool(std::string val) {
   }
 }
 
+const std::string CompactorCommand::ARG_SHOW_PROGRESS = "show_progress";
+
 CompactorCommand::CompactorCommand(
     const std::vector<std::string>& /*params*/,
     const std::map<std::string, std::string>& options,
     const std::vector<std::string>& flags)
     : LDBCommand(options, flags, false,
                  BuildCmdLineOptions({ARG_FROM, ARG_TO, ARG_HEX, ARG_KEY_HEX,
-                                      ARG_VALUE_HEX, ARG_TTL})),
+                                      ARG_VALUE_HEX, ARG_TTL,
+                                      ARG_SHOW_PROGRESS})),
       null_from_(true),
       null_to_(true) {
+  show_progress_ = IsFlagPresent(flags, ARG_SHOW_PROGRESS);
   std::map<std::string, std::string>::const_iterator itr =
       options.find(ARG_FROM);
   if (itr != options.end()) {
@@ -822,9 +829,18 @@ void CompactorCommand::Help(std::string& ret) {
   ret.append("  ");
   ret.append(CompactorCommand::Name());
   ret.append(HelpRangeCmdArgs());
+  ret.append(" [--" + ARG_SHOW_PROGRESS + "]");
   ret.append("\n");
 }
 
+Options CompactorCommand::PrepareOptionsForOpenDB() {
+  Options opt = LDBCommand::PrepareOptionsForOpenDB();
+  if (show_progress_) {
+    opt.enable_thread_tracking = true;
+  }
+  return opt;
+}
+
 void CompactorCommand::DoCommand() {
   if (!db_) {
     assert(GetExecuteState().IsFailed());
@@ -843,7 +859,52 @@ void CompactorCommand::DoCommand() {
   CompactRangeOptions cro;
   cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
 
+  // Prints the background work of the db once a second until the compaction
+  // is done
+  std::mutex progress_mutex;
+  std::condition_variable progress_cv;
+  bool done = false;
+  std::thread progress_thread;
+  if (show_progress_) {
+    progress_thread = std::thread([&] {
+      Env* env = db_->GetEnv();
+      std::unique_lock<std::mutex> lock(progress_mutex);
+      while (!progress_cv.wait_for(lock, std::chrono::seconds(1),
+                                   [&] { return done; })) {
+        std::vector<ThreadStatus> thread_list;
+        if (!env->GetThreadList(&thread_list).ok()) {
+          continue;
+        }
+        for (auto& ts : thread_list) {
+          if (ts.operation_type == ThreadStatus::OP_UNKNOWN) {
+            continue;
+          }
+          double progress = ThreadStatus::GetOperationProgress(
+              ts.operation_type, ts.op_properties);
+          fprintf(stdout, "%s %s %s %s", ts.cf_name.c_str(),
+                  ThreadStatus::GetOperationName(ts.operation_type).c_str(),
+                  ThreadStatus::GetOperationStageName(ts.operation_stage)
+                      .c_str(),
+                  ThreadStatus::MicrosToString(ts.op_elapsed_micros).c_str());
+          if (progress >= 0) {
+            fprintf(stdout, " %.1f%%", progress);
+          }
+          fprintf(stdout, "\n");
+        }
+        fflush(stdout);
+      }
+    });
+  }
+
   db_->CompactRange(cro, GetCfHandle(), begin, end);
+  if (show_progress_) {
+    {
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      done = true;
+    }
+    progress_cv.notify_one();
+    progress_thread.join();
+  }
   exec_state_ = LDBCommandExecuteResult::Succeed("");
 
   delete begin;
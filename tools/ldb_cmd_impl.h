@@ -27,11 +27,16 @@ class CompactorCommand : public LDBCommand {
 
   virtual void DoCommand() override;
 
+  virtual Options PrepareOptionsForOpenDB() override;
+
  private:
   bool null_from_;
   std::string from_;
   bool null_to_;
   std::string to_;
+  bool show_progress_;
+
+  static const std::string ARG_SHOW_PROGRESS;
 };
 
 class DBFileDumperCommand : public LDBCommand {
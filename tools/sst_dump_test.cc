@@ -16,6 +16,8 @@
 #include "rocksdb/terark_namespace.h"
 #include "table/block_based_table_factory.h"
 #include "table/table_builder.h"
+#include "table/table_reader.h"
+#include "tools/sst_dump_tool_imp.h"
 #include "util/file_reader_writer.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
@@ -206,6 +208,35 @@ TEST_F(SSTDumpToolTest, CompressedSizes) {
     delete[] usage[i];
   }
 }
+
+TEST_F(SSTDumpToolTest, ParallelRead) {
+  table_options_.block_size = 256;
+  std::string file_path = MakeFilePath("rocksdb_sst_test.sst");
+  createSST(file_path, table_options_);
+
+  // Every entry is read once, whatever the number of ranges
+  for (size_t threads : {1, 3, 8, 100}) {
+    SstFileDumper dumper(file_path, true /* verify_checksum */, false);
+    ASSERT_OK(dumper.getStatus());
+    ASSERT_OK(dumper.ReadParallel(threads, false, "", false, ""));
+    ASSERT_EQ(1024U, dumper.GetReadNumber());
+  }
+  SstFileDumper dumper(file_path, true /* verify_checksum */, false);
+  ASSERT_OK(dumper.ReadParallel(4, true, "k_0100", true, "k_0900"));
+  ASSERT_EQ(800U, dumper.GetReadNumber());
+
+  char* usage[5];
+  PopulateCommandArgs(file_path, "--command=check", usage);
+  snprintf(usage[3], optLength, "--parallel=4");
+  snprintf(usage[4], optLength, "--verify_checksum");
+  SSTDumpTool tool;
+  ASSERT_TRUE(!tool.Run(5, usage));
+
+  cleanup(file_path);
+  for (int i = 0; i < 5; i++) {
+    delete[] usage[i];
+  }
+}
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -20,10 +20,12 @@
 #include <map>
 #include <memory>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include "db/memtable.h"
 #include "db/write_batch_internal.h"
+#include "monitoring/histogram.h"
 #include "options/cf_options.h"
 #include "port/port.h"
 #include "rocksdb/db.h"
@@ -382,6 +384,182 @@ Status SstFileDumper::ReadSequential(bool print_kv, uint64_t read_num,
   return ret;
 }
 
+namespace {
+// The key halfway between a and b, a < b, in bytewise order
+std::string MidKey(const Slice& a, const Slice& b) {
+  size_t n = std::max(a.size(), b.size()) + 1;
+  std::vector<unsigned> sum(n);
+  unsigned carry = 0;
+  for (size_t i = n; i-- > 0;) {
+    unsigned x = (i < a.size() ? static_cast<uint8_t>(a[i]) : 0) +
+                 (i < b.size() ? static_cast<uint8_t>(b[i]) : 0) + carry;
+    sum[i] = x & 0xff;
+    carry = x >> 8;
+  }
+  std::string mid(n, '\0');
+  for (size_t i = 0; i < n; ++i) {
+    unsigned x = (carry << 8) | sum[i];
+    mid[i] = static_cast<char>(x >> 1);
+    carry = x & 1;
+  }
+  return mid;
+}
+
+struct RangeScanStats {
+  uint64_t entries = 0;
+  uint64_t deletions = 0;
+  uint64_t merges = 0;
+  uint64_t key_bytes = 0;
+  uint64_t value_bytes = 0;
+  HistogramImpl key_sizes;
+  HistogramImpl value_sizes;
+  Status status;
+};
+}  // namespace
+
+Status SstFileDumper::ReadParallel(size_t num_threads, bool has_from,
+                                   const std::string& from_key, bool has_to,
+                                   const std::string& to_key) {
+  if (!table_reader_) {
+    return init_result_;
+  }
+  num_threads = std::max<size_t>(num_threads, 1);
+  const Comparator* ucmp = BytewiseComparator();
+  auto seek_key = [](const Slice& user_key) {
+    InternalKey ikey;
+    ikey.SetMinPossibleForUserKey(user_key);
+    return ikey;
+  };
+
+  // The ranges are cut where ApproximateOffsetOf, answered from the index,
+  // reaches even shares of the file, found by bisecting the key space
+  std::string first_key = from_key;
+  std::string last_key = to_key;
+  {
+    std::unique_ptr<InternalIterator> iter(table_reader_->NewIterator(
+        ReadOptions(verify_checksum_, false),
+        moptions_.prefix_extractor.get()));
+    if (!has_from) {
+      iter->SeekToFirst();
+      first_key = iter->Valid() ? ExtractUserKey(iter->key()).ToString() : "";
+    }
+    if (!has_to) {
+      iter->SeekToLast();
+      last_key = iter->Valid() ? ExtractUserKey(iter->key()).ToString() : "";
+    }
+    if (!iter->status().ok()) {
+      return iter->status();
+    }
+  }
+  std::vector<std::string> bounds;
+  if (ucmp->Compare(first_key, last_key) < 0) {
+    uint64_t begin_offset =
+        table_reader_->ApproximateOffsetOf(seek_key(first_key).Encode());
+    uint64_t end_offset =
+        table_reader_->ApproximateOffsetOf(seek_key(last_key).Encode());
+    std::string lo = first_key;
+    for (size_t i = 1; i < num_threads; ++i) {
+      uint64_t target =
+          begin_offset + (end_offset - begin_offset) * i / num_threads;
+      std::string l = lo;
+      std::string h = last_key;
+      for (int step = 0; step < 64; ++step) {
+        std::string m = MidKey(l, h);
+        if (ucmp->Compare(m, l) <= 0 || ucmp->Compare(m, h) >= 0) {
+          break;
+        }
+        if (table_reader_->ApproximateOffsetOf(seek_key(m).Encode()) <
+            target) {
+          l = std::move(m);
+        } else {
+          h = std::move(m);
+        }
+      }
+      bounds.push_back(h);
+      lo = h;
+    }
+  }
+
+  std::vector<RangeScanStats> stats(bounds.size() + 1);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    threads.emplace_back([&, i] {
+      RangeScanStats& s = stats[i];
+      bool has_begin = i > 0 || has_from;
+      const std::string& begin = i > 0 ? bounds[i - 1] : from_key;
+      bool has_end = i < bounds.size() || has_to;
+      const std::string& end = i < bounds.size() ? bounds[i] : to_key;
+      std::unique_ptr<InternalIterator> iter(table_reader_->NewIterator(
+          ReadOptions(verify_checksum_, false),
+          moptions_.prefix_extractor.get()));
+      if (has_begin) {
+        iter->Seek(seek_key(begin).Encode());
+      } else {
+        iter->SeekToFirst();
+      }
+      for (; iter->Valid(); iter->Next()) {
+        ParsedInternalKey ikey;
+        if (!ParseInternalKey(iter->key(), &ikey)) {
+          s.status = Status::Corruption("Internal key parse error",
+                                        iter->key().ToString(true));
+          return;
+        }
+        if (has_end && ucmp->Compare(ikey.user_key, end) >= 0) {
+          break;
+        }
+        LazyBuffer value = iter->value();
+        s.status = value.fetch();
+        if (!s.status.ok()) {
+          return;
+        }
+        ++s.entries;
+        if (ikey.type == kTypeDeletion || ikey.type == kTypeSingleDeletion) {
+          ++s.deletions;
+        } else if (ikey.type == kTypeMerge) {
+          ++s.merges;
+        }
+        s.key_bytes += ikey.user_key.size();
+        s.value_bytes += value.size();
+        s.key_sizes.Add(ikey.user_key.size());
+        s.value_sizes.Add(value.size());
+      }
+      s.status = iter->status();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  RangeScanStats total;
+  for (auto& s : stats) {
+    if (total.status.ok()) {
+      total.status = s.status;
+    }
+    total.entries += s.entries;
+    total.deletions += s.deletions;
+    total.merges += s.merges;
+    total.key_bytes += s.key_bytes;
+    total.value_bytes += s.value_bytes;
+    total.key_sizes.Merge(s.key_sizes);
+    total.value_sizes.Merge(s.value_sizes);
+  }
+  read_num_ += total.entries;
+  fprintf(stdout,
+          "Scanned %" ROCKSDB_PRIszt " ranges in parallel\n"
+          "  entries: %" PRIu64 "\n"
+          "  deletions: %" PRIu64 "\n"
+          "  merges: %" PRIu64 "\n"
+          "  raw key size: %" PRIu64 "\n"
+          "  raw value size: %" PRIu64 "\n"
+          "Key size histogram:\n%s"
+          "Value size histogram:\n%s",
+          stats.size(), total.entries, total.deletions, total.merges,
+          total.key_bytes, total.value_bytes,
+          total.key_sizes.ToString().c_str(),
+          total.value_sizes.ToString().c_str());
+  return total.status;
+}
+
 Status SstFileDumper::ReadTableProperties(
     std::shared_ptr<const TableProperties>* table_properties) {
   if (!table_reader_) {
@@ -427,6 +605,11 @@ void print_help() {
     --verify_checksum
       Verify file checksum when executing check|scan
 
+    --parallel=<num>
+      Can be combined with check command to split each file into num key
+      ranges of about the same size, iterated concurrently, and print the
+      aggregated entry counts and key and value size histograms
+
     --input_key_hex
       Can be combined with --from and --to to indicate that these values are encoded in Hex
 
@@ -459,6 +642,7 @@ int SSTDumpTool::Run(int argc, char** argv) {
   char junk;
   uint64_t n;
   bool verify_checksum = false;
+  size_t parallel = 0;
   bool output_hex = false;
   bool input_key_hex = false;
   bool has_from = false;
@@ -489,6 +673,9 @@ int SSTDumpTool::Run(int argc, char** argv) {
       read_num = n;
     } else if (strcmp(argv[i], "--verify_checksum") == 0) {
       verify_checksum = true;
+    } else if (sscanf(argv[i], "--parallel=%lu%c", (unsigned long*)&n,
+                      &junk) == 1) {
+      parallel = n;
     } else if (strncmp(argv[i], "--command=", 10) == 0) {
       command = argv[i] + 10;
     } else if (strncmp(argv[i], "--from=", 7) == 0) {
@@ -565,6 +752,11 @@ int SSTDumpTool::Run(int argc, char** argv) {
     exit(1);
   }
 
+  if (use_from_as_prefix && parallel > 0) {
+    fprintf(stderr, "Cannot specify --prefix and --parallel\n\n");
+    exit(1);
+  }
+
   if (input_key_hex) {
     if (has_from || use_from_as_prefix) {
       from_key = TERARKDB_NAMESPACE::LDBCommand::HexToString(from_key);
@@ -638,8 +830,14 @@ int SSTDumpTool::Run(int argc, char** argv) {
       continue;
     }
 
-    // scan all files in give file path.
-    if (command == "" || command == "scan" || command == "check") {
+    if (parallel > 0 && (command == "" || command == "check")) {
+      st = dumper.ReadParallel(parallel, has_from || use_from_as_prefix,
+                               from_key, has_to, to_key);
+      if (!st.ok()) {
+        fprintf(stderr, "%s: %s\n", filename.c_str(), st.ToString().c_str());
+      }
+    } else if (command == "" || command == "scan" || command == "check") {
+      // scan all files in give file path.
       st = dumper.ReadSequential(
           command == "scan", read_num > 0 ? (read_num - total_read) : read_num,
           has_from || use_from_as_prefix, from_key, has_to, to_key,
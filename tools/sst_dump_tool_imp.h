@@ -26,6 +26,14 @@ class SstFileDumper {
                         const std::string& to_key,
                         bool use_from_as_prefix = false);
 
+  // Splits the keys of the file, within [from_key, to_key) when given, into
+  // num_threads ranges of about the same size in the file and iterates them
+  // concurrently, verifying the checksums of the blocks read when asked.
+  // Prints the aggregated entry counts and key and value size histograms.
+  Status ReadParallel(size_t num_threads, bool has_from,
+                      const std::string& from_key, bool has_to,
+                      const std::string& to_key);
+
   Status ReadTableProperties(
       std::shared_ptr<const TableProperties>* table_properties);
   uint64_t GetReadNumber() { return read_num_; }
@@ -19,6 +19,7 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cinttypes>
 #include <cmath>
 #include <cstdio>
@@ -162,6 +163,19 @@ DEFINE_int32(value_interval, 8,
 DEFINE_double(sample_ratio, 1.0,
               "If the trace size is extremely huge or user want to sample "
               "the trace when analyzing, sample ratio can be set (0, 1.0]");
+DEFINE_bool(analyze_table_access, false,
+            "Analyze the reads of TerarkZip value records and blobs traced "
+            "by DB::StartTableAccessTrace().\n"
+            "File name: <prefix>-table_access_reuse_distance.txt\n"
+            "Format:[type reuse_distance_below_bytes reuses lru_hit_ratio]\n"
+            "File name: <prefix>-table_access_hot_ranges.txt\n"
+            "Format:[type file_number first_record reads]");
+DEFINE_int32(table_access_range_records, 1024,
+             "The records of a TerarkZip table in a range of the hot range "
+             "report. The blobs of a blob SST are one range, their records "
+             "are hashed.");
+DEFINE_int32(table_access_top_k_ranges, 10,
+             "The number of the hottest ranges reported.");
 
 namespace TERARKDB_NAMESPACE {
 
@@ -344,6 +358,7 @@ TraceAnalyzer::TraceAnalyzer(std::string& trace_path, std::string& output_path,
   for (int i = 0; i < kTaTypeNum; i++) {
     ta_[i].sample_count = 0;
   }
+  table_access_stats_.resize(kTableAccessTypeMax);
 }
 
 TraceAnalyzer::~TraceAnalyzer() {}
@@ -491,6 +506,23 @@ Status TraceAnalyzer::StartProcessing() {
         fprintf(stderr, "Cannot process the get in the trace\n");
         return s;
       }
+    } else if (trace.type == kTraceMultiGet) {
+      // Every key of a MultiGet is analyzed as a get
+      Slice buf(trace.payload);
+      uint32_t count = 0;
+      GetFixed32(&buf, &count);
+      for (uint32_t i = 0; i < count && s.ok(); ++i) {
+        uint32_t cf_id = 0;
+        Slice key;
+        GetFixed32(&buf, &cf_id);
+        GetLengthPrefixedSlice(&buf, &key);
+        total_gets_++;
+        s = HandleGet(cf_id, key.ToString(), trace.ts, 1);
+      }
+      if (!s.ok()) {
+        fprintf(stderr, "Cannot process the multiget in the trace\n");
+        return s;
+      }
     } else if (trace.type == kTraceIteratorSeek ||
                trace.type == kTraceIteratorSeekForPrev) {
       uint32_t cf_id = 0;
@@ -501,6 +533,14 @@ Status TraceAnalyzer::StartProcessing() {
         fprintf(stderr, "Cannot process the iterator in the trace\n");
         return s;
       }
+    } else if (trace.type == kTraceTableAccess) {
+      if (FLAGS_analyze_table_access) {
+        s = HandleTableAccess(trace);
+        if (!s.ok()) {
+          fprintf(stderr, "Cannot process the table access in the trace\n");
+          return s;
+        }
+      }
     } else if (trace.type == kTraceEnd) {
       break;
     }
@@ -651,9 +691,175 @@ Status TraceAnalyzer::MakeStatistics() {
     }
   }
 
+  if (FLAGS_analyze_table_access) {
+    s = MakeStatisticTableAccess();
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
   return Status::OK();
 }
 
+namespace {
+const char* TableAccessTypeName(int type) {
+  switch (type) {
+    case kTableAccessTerarkZipValue:
+      return "terark_zip_value";
+    case kTableAccessBlob:
+      return "blob";
+    default:
+      return "unknown";
+  }
+}
+
+const char* TableAccessCallerName(int caller) {
+  switch (caller) {
+    case kTableAccessGet:
+      return "get";
+    case kTableAccessIterator:
+      return "iterator";
+    case kTableAccessFetch:
+      return "fetch";
+    case kTableAccessSeekFetch:
+      return "seek_fetch";
+    default:
+      return "unknown";
+  }
+}
+
+uint32_t FloorLog2(uint64_t v) {
+  uint32_t r = 0;
+  while (v >>= 1) {
+    ++r;
+  }
+  return r;
+}
+}  // namespace
+
+// The reuse distances of every type are counted over the reads of that type
+// only, as TerarkZip value records and blobs go to different caches. A
+// Fenwick tree holds the size of every record at its last read, so the
+// distinct bytes read between two reads of a record are a range sum.
+Status TraceAnalyzer::MakeStatisticTableAccess() {
+  const size_t n = table_accesses_.size();
+  std::vector<uint64_t> fenwick(n + 1);
+  std::vector<size_t> last_read(table_access_records_.size());
+  // Sum of [0, pos), wraps around while the sizes are moved
+  auto prefix_sum = [&](size_t pos) {
+    uint64_t sum = 0;
+    for (; pos > 0; pos -= pos & (~pos + 1)) {
+      sum += fenwick[pos];
+    }
+    return sum;
+  };
+  auto add = [&](size_t pos, uint64_t delta) {
+    for (++pos; pos <= n; pos += pos & (~pos + 1)) {
+      fenwick[pos] += delta;
+    }
+  };
+  for (int type = 0; type < kTableAccessTypeMax; ++type) {
+    auto& stats = table_access_stats_[type];
+    std::fill(fenwick.begin(), fenwick.end(), 0);
+    std::fill(last_read.begin(), last_read.end(), port::kMaxSizet);
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t id = table_accesses_[i];
+      if (table_access_records_[id].first != type) {
+        continue;
+      }
+      uint64_t size = table_access_records_[id].second;
+      if (last_read[id] == port::kMaxSizet) {
+        stats.unique_records++;
+        stats.unique_bytes += size;
+      } else {
+        uint64_t distance = prefix_sum(i) - prefix_sum(last_read[id] + 1);
+        stats.reuse_distance[FloorLog2(distance + 1)]++;
+        add(last_read[id], ~size + 1);
+      }
+      add(i, size);
+      last_read[id] = i;
+    }
+  }
+
+  int ret;
+  Status s;
+  std::unique_ptr<WritableFile> reuse_f;
+  s = env_->NewWritableFile(output_path_ + "/" + FLAGS_output_prefix +
+                                "-table_access_reuse_distance.txt",
+                            &reuse_f, env_options_);
+  if (!s.ok()) {
+    return s;
+  }
+  for (int type = 0; type < kTableAccessTypeMax; ++type) {
+    auto& stats = table_access_stats_[type];
+    uint64_t reuses = 0;
+    for (auto& bucket : stats.reuse_distance) {
+      reuses += bucket.second;
+      // A LRU cache of this many bytes hits every reuse counted so far
+      ret = snprintf(buffer_, sizeof(buffer_),
+                     "%s %" PRIu64 " %" PRIu64 " %.6f\n",
+                     TableAccessTypeName(type),
+                     uint64_t{1} << (bucket.first + 1), bucket.second,
+                     static_cast<double>(reuses) / stats.access_count);
+      if (ret < 0) {
+        return Status::IOError("Format output failed");
+      }
+      s = reuse_f->Append(buffer_);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+  }
+  s = reuse_f->Close();
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::vector<std::pair<uint64_t, std::tuple<int, uint64_t, uint64_t>>> ranges;
+  ranges.reserve(table_access_ranges_.size());
+  for (auto& range : table_access_ranges_) {
+    ranges.emplace_back(range.second, range.first);
+  }
+  size_t top_k = std::min(
+      ranges.size(),
+      static_cast<size_t>(std::max(FLAGS_table_access_top_k_ranges, 0)));
+  std::partial_sort(
+      ranges.begin(), ranges.begin() + top_k, ranges.end(),
+      [](const std::pair<uint64_t, std::tuple<int, uint64_t, uint64_t>>& a,
+         const std::pair<uint64_t, std::tuple<int, uint64_t, uint64_t>>& b) {
+        return a.first > b.first;
+      });
+  std::unique_ptr<WritableFile> ranges_f;
+  s = env_->NewWritableFile(output_path_ + "/" + FLAGS_output_prefix +
+                                "-table_access_hot_ranges.txt",
+                            &ranges_f, env_options_);
+  if (!s.ok()) {
+    return s;
+  }
+  for (size_t i = 0; i < top_k; ++i) {
+    int type = std::get<0>(ranges[i].second);
+    if (type == kTableAccessBlob) {
+      ret = snprintf(buffer_, sizeof(buffer_),
+                     "%s %" PRIu64 " all %" PRIu64 "\n",
+                     TableAccessTypeName(type), std::get<1>(ranges[i].second),
+                     ranges[i].first);
+    } else {
+      ret = snprintf(buffer_, sizeof(buffer_),
+                     "%s %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+                     TableAccessTypeName(type), std::get<1>(ranges[i].second),
+                     std::get<2>(ranges[i].second), ranges[i].first);
+    }
+    if (ret < 0) {
+      return Status::IOError("Format output failed");
+    }
+    s = ranges_f->Append(buffer_);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return ranges_f->Close();
+}
+
 // Process the statistics of the key access and
 // prefix of the accessed keys if required
 Status TraceAnalyzer::MakeStatisticKeyStatsOrPrefix(TraceStats& stats) {
@@ -1735,6 +1941,86 @@ Status TraceAnalyzer::HandleIter(uint32_t column_family_id,
   return s;
 }
 
+Status TraceAnalyzer::HandleTableAccess(const Trace& trace) {
+  TableAccessRecord record;
+  Status s = TableAccessTracer::DecodeAccess(trace, &record);
+  if (!s.ok()) {
+    return s;
+  }
+  if (record.type >= kTableAccessTypeMax ||
+      record.caller >= kTableAccessCallerMax) {
+    return Status::Corruption("Unknown table access type or caller");
+  }
+  auto& stats = table_access_stats_[record.type];
+  stats.access_count++;
+  stats.access_bytes += record.size;
+  stats.cache_hits += record.is_cache_hit ? 1 : 0;
+  stats.caller_count[record.caller]++;
+
+  auto insert = table_access_ids_.emplace(
+      std::make_tuple(static_cast<int>(record.type), record.file_number,
+                      record.record),
+      static_cast<uint32_t>(table_access_records_.size()));
+  if (insert.second) {
+    table_access_records_.emplace_back(record.type, record.size);
+  }
+  // A lazily read record has no size, its size is the largest one read
+  auto& record_size = table_access_records_[insert.first->second].second;
+  record_size = std::max(record_size, record.size);
+  table_accesses_.push_back(insert.first->second);
+
+  uint64_t range_records =
+      static_cast<uint64_t>(std::max(FLAGS_table_access_range_records, 1));
+  uint64_t range = record.type == kTableAccessBlob
+                       ? 0
+                       : record.record / range_records * range_records;
+  table_access_ranges_[std::make_tuple(static_cast<int>(record.type),
+                                       record.file_number, range)]++;
+  return s;
+}
+
+void TraceAnalyzer::PrintTableAccessStatistics() {
+  for (int type = 0; type < kTableAccessTypeMax; ++type) {
+    auto& stats = table_access_stats_[type];
+    if (stats.access_count == 0) {
+      continue;
+    }
+    printf("\n################# Table Access Type: %s #####################\n",
+           TableAccessTypeName(type));
+    printf("Reads: %" PRIu64 " Bytes: %" PRIu64 " Cache hits: %" PRIu64 "\n",
+           stats.access_count, stats.access_bytes, stats.cache_hits);
+    for (int caller = 0; caller < kTableAccessCallerMax; ++caller) {
+      if (stats.caller_count[caller] > 0) {
+        printf("Reads by %s: %" PRIu64 "\n", TableAccessCallerName(caller),
+               stats.caller_count[caller]);
+      }
+    }
+    printf("Distinct records: %" PRIu64 " Bytes: %" PRIu64 "\n",
+           stats.unique_records, stats.unique_bytes);
+    uint64_t reuses = stats.access_count - stats.unique_records;
+    if (reuses == 0) {
+      continue;
+    }
+    // The smallest LRU caches hitting half and 90% of the reuses
+    uint64_t hits = 0;
+    bool half_printed = false;
+    for (auto& bucket : stats.reuse_distance) {
+      hits += bucket.second;
+      uint64_t capacity = uint64_t{1} << (bucket.first + 1);
+      if (!half_printed && hits * 2 >= reuses) {
+        printf("LRU cache bytes hitting 50%% of the reuses: %" PRIu64 "\n",
+               capacity);
+        half_printed = true;
+      }
+      if (hits * 10 >= reuses * 9) {
+        printf("LRU cache bytes hitting 90%% of the reuses: %" PRIu64 "\n",
+               capacity);
+        break;
+      }
+    }
+  }
+}
+
 // Before the analyzer is closed, the requested general statistic results are
 // printed out here. In current stage, these information are not output to
 // the files.
@@ -1896,6 +2182,10 @@ void TraceAnalyzer::PrintStatistics() {
              ta_[type].total_access);
     }
   }
+
+  if (FLAGS_analyze_table_access) {
+    PrintTableAccessStatistics();
+  }
 }
 
 // Write the trace sequence to file
@@ -10,6 +10,7 @@
 #include <map>
 #include <queue>
 #include <set>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -163,6 +164,20 @@ struct CfUnit {
   std::map<uint32_t, uint32_t> cf_qps;
 };
 
+// The kTraceTableAccess traces of a TableAccessType
+struct TableAccessTypeStats {
+  uint64_t access_count = 0;
+  uint64_t access_bytes = 0;
+  uint64_t cache_hits = 0;
+  uint64_t caller_count[kTableAccessCallerMax] = {0};
+  uint64_t unique_records = 0;
+  uint64_t unique_bytes = 0;
+  // Reuses by floor(log2(1 + reuse distance)). The reuse distance of a read
+  // is the bytes of the distinct records read since the last read of its
+  // record, so a LRU cache of more bytes than that hits it.
+  std::map<uint32_t, uint64_t> reuse_distance;
+};
+
 class TraceAnalyzer {
  public:
   TraceAnalyzer(std::string& trace_path, std::string& output_path,
@@ -194,7 +209,11 @@ class TraceAnalyzer {
                      const Slice& value);
   Status HandleIter(uint32_t column_family_id, const std::string& key,
                     const uint64_t& ts, TraceType& trace_type);
+  Status HandleTableAccess(const Trace& trace);
   std::vector<TypeUnit>& GetTaVector() { return ta_; }
+  const std::vector<TableAccessTypeStats>& GetTableAccessStats() const {
+    return table_access_stats_;
+  }
 
  private:
   TERARKDB_NAMESPACE::Env* env_;
@@ -226,6 +245,14 @@ class TraceAnalyzer {
   std::map<uint32_t, CfUnit> cfs_;  // All the cf_id appears in this trace;
   std::vector<uint32_t> qps_peak_;
   std::vector<double> qps_ave_;
+  // The records of the kTraceTableAccess traces by type, file number and
+  // record id, with their type and size, and the records read in trace order
+  std::map<std::tuple<int, uint64_t, uint64_t>, uint32_t> table_access_ids_;
+  std::vector<std::pair<int, uint64_t>> table_access_records_;
+  std::vector<uint32_t> table_accesses_;
+  std::vector<TableAccessTypeStats> table_access_stats_;
+  // Reads by type, file number and first record id of a range
+  std::map<std::tuple<int, uint64_t, uint64_t>, uint64_t> table_access_ranges_;
 
   Status ReadTraceHeader(Trace* header);
   Status ReadTraceFooter(Trace* footer);
@@ -252,6 +279,8 @@ class TraceAnalyzer {
   Status MakeStatisticKeyStatsOrPrefix(TraceStats& stats);
   Status MakeStatisticCorrelation(TraceStats& stats, StatsUnit& unit);
   Status MakeStatisticQPS();
+  Status MakeStatisticTableAccess();
+  void PrintTableAccessStatistics();
 };
 
 // write bach handler to be used for WriteBache iterator
@@ -12,6 +12,7 @@
 
 #include "port/port.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/memory_allocator.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -30,7 +31,8 @@ inline size_t Rounddown(size_t x, size_t y) { return (x / y) * y; }
 // though can be used for any purpose.
 class AlignedBuffer {
   size_t alignment_;
-  std::unique_ptr<char[]> buf_;
+  MemoryAllocator* allocator_ = nullptr;
+  CacheAllocationPtr buf_;
   size_t capacity_;
   size_t cursize_;
   char* bufstart_;
@@ -43,6 +45,7 @@ class AlignedBuffer {
 
   AlignedBuffer& operator=(AlignedBuffer&& o) ROCKSDB_NOEXCEPT {
     alignment_ = std::move(o.alignment_);
+    allocator_ = o.allocator_;
     buf_ = std::move(o.buf_);
     capacity_ = std::move(o.capacity_);
     cursize_ = std::move(o.cursize_);
@@ -80,6 +83,9 @@ class AlignedBuffer {
     alignment_ = alignment;
   }
 
+  // The new buffers are allocated from allocator, or with new[] if nullptr
+  void Allocator(MemoryAllocator* allocator) { allocator_ = allocator; }
+
   // Allocates a new buffer and sets bufstart_ to the aligned first byte.
   // requested_capacity: requested new buffer capacity. This capacity will be
   //     rounded up based on alignment.
@@ -99,9 +105,10 @@ class AlignedBuffer {
     }
 
     size_t new_capacity = Roundup(requested_capacity, alignment_);
-    char* new_buf = new char[new_capacity + alignment_];
+    CacheAllocationPtr new_buf =
+        AllocateBlock(new_capacity + alignment_, allocator_);
     char* new_bufstart = reinterpret_cast<char*>(
-        (reinterpret_cast<uintptr_t>(new_buf) + (alignment_ - 1)) &
+        (reinterpret_cast<uintptr_t>(new_buf.get()) + (alignment_ - 1)) &
         ~static_cast<uintptr_t>(alignment_ - 1));
 
     if (copy_data) {
@@ -114,7 +121,7 @@ class AlignedBuffer {
 
     bufstart_ = new_bufstart;
     capacity_ = new_capacity;
-    buf_.reset(new_buf);
+    buf_ = std::move(new_buf);
   }
   // Used for write
   // Returns the number of bytes appended
@@ -22,6 +22,7 @@
 
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/arena_block_pool.h"
 #include "util/logging.h"
 #include "util/sync_point.h"
 
@@ -49,8 +50,11 @@ size_t OptimizeBlockSize(size_t block_size) {
   return block_size;
 }
 
-Arena::Arena(size_t block_size, AllocTracker* tracker, size_t huge_page_size)
-    : kBlockSize(OptimizeBlockSize(block_size)), tracker_(tracker) {
+Arena::Arena(size_t block_size, AllocTracker* tracker, size_t huge_page_size,
+             ArenaBlockPool* block_pool)
+    : kBlockSize(OptimizeBlockSize(block_size)),
+      block_pool_(block_pool),
+      tracker_(tracker) {
   assert(kBlockSize >= kMinBlockSize && kBlockSize <= kMaxBlockSize &&
          kBlockSize % kAlignUnit == 0);
   TEST_SYNC_POINT_CALLBACK("Arena::Arena:0", const_cast<size_t*>(&kBlockSize));
@@ -79,6 +83,9 @@ Arena::~Arena() {
   for (const auto& block : blocks_) {
     delete[] block;
   }
+  for (const auto& block : pooled_blocks_) {
+    block_pool_->Release(block, kBlockSize);
+  }
 
 #ifdef MAP_HUGETLB
   for (const auto& mmap_info : huge_blocks_) {
@@ -112,7 +119,8 @@ char* Arena::AllocateFallback(size_t bytes, bool aligned) {
 #endif
   if (!block_head) {
     size = kBlockSize;
-    block_head = AllocateNewBlock(size);
+    block_head = block_pool_ != nullptr ? AllocateFromPool()
+                                        : AllocateNewBlock(size);
   }
   alloc_bytes_remaining_ = size - bytes;
 
@@ -205,6 +213,18 @@ char* Arena::AllocateAligned(size_t bytes, size_t huge_page_size,
   return result;
 }
 
+char* Arena::AllocateFromPool() {
+  // Reserve space in `pooled_blocks_` first, as in AllocateNewBlock()
+  pooled_blocks_.emplace_back(nullptr);
+  char* block = block_pool_->Allocate(kBlockSize);
+  blocks_memory_ += kBlockSize;
+  if (tracker_ != nullptr) {
+    tracker_->Allocate(kBlockSize);
+  }
+  pooled_blocks_.back() = block;
+  return block;
+}
+
 char* Arena::AllocateNewBlock(size_t block_bytes) {
   // Reserve space in `blocks_` before allocating memory via new.
   // Use `emplace_back()` instead of `reserve()` to let std::vector manage its
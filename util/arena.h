@@ -28,6 +28,8 @@
 
 namespace TERARKDB_NAMESPACE {
 
+class ArenaBlockPool;
+
 class Arena : public Allocator {
  public:
   // No copying allowed
@@ -41,8 +43,11 @@ class Arena : public Allocator {
   // huge_page_size: if 0, don't use huge page TLB. If > 0 (should set to the
   // supported hugepage size of the system), block allocation will try huge
   // page TLB first. If allocation fails, will fall back to normal case.
+  // block_pool: if not nullptr, the regular blocks are taken from it and
+  // given back to it when the arena is destroyed.
   explicit Arena(size_t block_size = kMinBlockSize,
-                 AllocTracker* tracker = nullptr, size_t huge_page_size = 0);
+                 AllocTracker* tracker = nullptr, size_t huge_page_size = 0,
+                 ArenaBlockPool* block_pool = nullptr);
   ~Arena();
 
   char* Allocate(size_t bytes) override;
@@ -98,6 +103,9 @@ class Arena : public Allocator {
     MmapInfo(void* addr, size_t length) : addr_(addr), length_(length) {}
   };
   std::vector<MmapInfo> huge_blocks_;
+  // Regular blocks taken from block_pool_
+  std::vector<char*> pooled_blocks_;
+  ArenaBlockPool* block_pool_;
   size_t irregular_block_num = 0;
 
   // Stats for current active block.
@@ -116,6 +124,7 @@ class Arena : public Allocator {
   char* AllocateFromHugePage(size_t bytes);
   char* AllocateFallback(size_t bytes, bool aligned);
   char* AllocateNewBlock(size_t block_bytes);
+  char* AllocateFromPool();
 
   // Bytes of memory in blocks allocated so far
   size_t blocks_memory_ = 0;
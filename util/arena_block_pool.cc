@@ -0,0 +1,72 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/arena_block_pool.h"
+
+#include <cassert>
+
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/write_buffer_manager.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+const size_t kPageSize = 4096;
+}  // namespace
+
+ArenaBlockPool::ArenaBlockPool(size_t capacity,
+                               const WriteBufferManager* write_buffer_manager)
+    : capacity_(capacity),
+      write_buffer_manager_(write_buffer_manager),
+      free_bytes_(0) {}
+
+ArenaBlockPool::~ArenaBlockPool() {
+  for (auto& blocks : free_blocks_) {
+    for (char* block : blocks.second) {
+      delete[] block;
+    }
+  }
+}
+
+char* ArenaBlockPool::Allocate(size_t block_size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = free_blocks_.find(block_size);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+      char* block = it->second.back();
+      it->second.pop_back();
+      free_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+      return block;
+    }
+  }
+  char* block = new char[block_size];
+  // Fault the pages in now, the block is likely to be filled up
+  for (size_t offset = 0; offset < block_size; offset += kPageSize) {
+    block[offset] = 0;
+  }
+  return block;
+}
+
+void ArenaBlockPool::Release(char* block, size_t block_size) {
+  assert(block != nullptr);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t free_bytes = free_bytes_.load(std::memory_order_relaxed);
+    bool keep = free_bytes + block_size <= capacity_;
+    if (keep && write_buffer_manager_ != nullptr &&
+        write_buffer_manager_->enabled()) {
+      keep = write_buffer_manager_->memory_usage() + free_bytes + block_size <=
+             write_buffer_manager_->buffer_size();
+    }
+    if (keep) {
+      free_blocks_[block_size].push_back(block);
+      free_bytes_.fetch_add(block_size, std::memory_order_relaxed);
+      return;
+    }
+  }
+  delete[] block;
+}
+
+}  // namespace TERARKDB_NAMESPACE
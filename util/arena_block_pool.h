@@ -0,0 +1,62 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// ArenaBlockPool keeps the blocks of the freed arenas for the next ones, so
+// that a new memtable reuses the pages the previous ones already faulted in
+// instead of taking fresh memory from malloc.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class WriteBufferManager;
+
+class ArenaBlockPool {
+ public:
+  // capacity: the most bytes of free blocks kept for reuse, the blocks
+  // released over it are freed.
+  // write_buffer_manager: if enabled, the free blocks are also freed when
+  // they and the memtables would use more than its buffer size.
+  explicit ArenaBlockPool(size_t capacity,
+                          const WriteBufferManager* write_buffer_manager =
+                              nullptr);
+  ~ArenaBlockPool();
+
+  // No copying allowed
+  ArenaBlockPool(const ArenaBlockPool&) = delete;
+  void operator=(const ArenaBlockPool&) = delete;
+
+  // Returns a free block of block_size bytes, or a new one with all of its
+  // pages faulted in
+  char* Allocate(size_t block_size);
+
+  // Gives back a block returned by Allocate(block_size)
+  void Release(char* block, size_t block_size);
+
+  // Bytes of the free blocks
+  size_t FreeBytes() const {
+    return free_bytes_.load(std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  const size_t capacity_;
+  const WriteBufferManager* write_buffer_manager_;
+  std::mutex mutex_;
+  // The free blocks of each block size
+  std::unordered_map<size_t, std::vector<char*>> free_blocks_;
+  std::atomic<size_t> free_bytes_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
@@ -9,7 +9,14 @@
 
 #include "util/arena.h"
 
+#include <thread>
+#include <vector>
+
+#include "port/port.h"
 #include "rocksdb/terark_namespace.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "util/arena_block_pool.h"
+#include "util/concurrent_arena.h"
 #include "util/random.h"
 #include "util/testharness.h"
 
@@ -198,6 +205,108 @@ TEST_F(ArenaTest, Simple) {
   SimpleTest(0);
   SimpleTest(kHugePageSize);
 }
+
+TEST_F(ArenaTest, ConcurrentArenaShardRefill) {
+  const int kNumThreads = 8;
+  const int kNumAllocs = 20000;
+  ConcurrentArena arena(64 << 10);
+  std::vector<std::vector<std::pair<size_t, char*>>> allocated(kNumThreads);
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rnd(301 + t);
+      for (int i = 0; i < kNumAllocs; i++) {
+        size_t s = 1 + rnd.Uniform(100);
+        char* r = rnd.OneIn(2) ? arena.AllocateAligned(s) : arena.Allocate(s);
+        memset(r, t * kNumAllocs + i, s);
+        allocated[t].emplace_back(s, r);
+      }
+    });
+  }
+  size_t bytes = 0;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads[t].join();
+  }
+  for (int t = 0; t < kNumThreads; t++) {
+    for (int i = 0; i < kNumAllocs; i++) {
+      const auto& a = allocated[t][i];
+      for (size_t b = 0; b < a.first; b++) {
+        ASSERT_EQ(static_cast<char>(t * kNumAllocs + i), a.second[b]);
+      }
+      bytes += a.first;
+    }
+  }
+  ASSERT_GE(arena.ApproximateMemoryUsage(), bytes);
+  ASSERT_LE(arena.ApproximateMemoryUsage(), arena.MemoryAllocatedBytes());
+}
+
+TEST_F(ArenaTest, BlockPool) {
+  const size_t kBlockSize = 64 << 10;
+  ArenaBlockPool pool(3 * kBlockSize);
+  std::vector<char*> blocks;
+  {
+    Arena arena(kBlockSize, nullptr, 0, &pool);
+    // The inline block, then two regular blocks
+    for (int i = 0; i < 3; i++) {
+      arena.Allocate(kBlockSize / 4);
+      arena.Allocate(kBlockSize / 4);
+      arena.Allocate(kBlockSize / 4);
+      arena.Allocate(kBlockSize / 4);
+    }
+    // Irregular blocks are not pooled
+    arena.Allocate(kBlockSize);
+    ASSERT_EQ(0U, pool.FreeBytes());
+  }
+  ASSERT_EQ(3 * kBlockSize, pool.FreeBytes());
+
+  // The next arena reuses the blocks
+  {
+    Arena arena(kBlockSize, nullptr, 0, &pool);
+    arena.Allocate(Arena::kInlineSize);
+    arena.Allocate(100);
+    ASSERT_EQ(2 * kBlockSize, pool.FreeBytes());
+  }
+  ASSERT_EQ(3 * kBlockSize, pool.FreeBytes());
+
+  // Blocks over the capacity are freed
+  for (int i = 0; i < 4; i++) {
+    blocks.push_back(pool.Allocate(kBlockSize));
+  }
+  ASSERT_EQ(0U, pool.FreeBytes());
+  for (char* block : blocks) {
+    pool.Release(block, kBlockSize);
+  }
+  ASSERT_EQ(3 * kBlockSize, pool.FreeBytes());
+
+  // Other block sizes have their own free list
+  char* block = pool.Allocate(kBlockSize / 2);
+  ASSERT_EQ(3 * kBlockSize, pool.FreeBytes());
+  pool.Release(block, kBlockSize / 2);
+  ASSERT_EQ(3 * kBlockSize, pool.FreeBytes());
+}
+
+TEST_F(ArenaTest, BlockPoolWriteBufferManagerLimit) {
+  const size_t kBlockSize = 64 << 10;
+  WriteBufferManager wbm(4 * kBlockSize, {}, false, 100 * kBlockSize);
+  ArenaBlockPool* pool = wbm.arena_block_pool();
+  ASSERT_NE(nullptr, pool);
+  ASSERT_EQ(100 * kBlockSize, pool->capacity());
+
+  std::vector<char*> blocks;
+  for (int i = 0; i < 4; i++) {
+    blocks.push_back(pool->Allocate(kBlockSize));
+  }
+  // The memtables use half of the buffer, so only two free blocks fit
+  wbm.ReserveMem(2 * kBlockSize);
+  for (char* block : blocks) {
+    pool->Release(block, kBlockSize);
+  }
+  ASSERT_EQ(2 * kBlockSize, pool->FreeBytes());
+  wbm.FreeMem(2 * kBlockSize);
+
+  ASSERT_EQ(nullptr, WriteBufferManager(0).arena_block_pool());
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -7,6 +7,10 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/terark_namespace.h"
@@ -15,12 +19,65 @@
 #include "table/full_filter_block.h"
 #include "util/coding.h"
 #include "util/hash.h"
+#include "util/xor_filter.h"
 
 namespace TERARKDB_NAMESPACE {
 
 class BlockBasedFilterBlockBuilder;
 class FullFilterBlockBuilder;
 
+namespace {
+// Probes of a full filter key all fall in one cache line. With 64 byte lines
+// they are gathered into a 512 bit mask, so that a probe is one and-compare
+// of the line, vectorized, instead of one branch per bit.
+const uint32_t kMaskLineBits = 512;
+
+inline void BuildProbeMask(uint32_t h, size_t num_probes, uint64_t mask[8]) {
+  const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
+  for (size_t w = 0; w < 8; ++w) {
+    mask[w] = 0;
+  }
+  for (size_t i = 0; i < num_probes; ++i) {
+    const uint32_t bitpos = h % kMaskLineBits;
+    mask[bitpos / 64] |= uint64_t(1) << (bitpos % 64);
+    h += delta;
+  }
+}
+
+// Bit n of the line is bit n % 8 of byte n / 8, which is bit n % 64 of
+// little endian word n / 64
+inline bool LineContainsMask(const char* line, const uint64_t mask[8]) {
+#if defined(__AVX512F__)
+  __m512i l = _mm512_loadu_si512(line);
+  __m512i m = _mm512_loadu_si512(mask);
+  return _mm512_mask_cmpneq_epi64_mask(0xFF, _mm512_and_si512(l, m), m) == 0;
+#elif defined(__AVX2__)
+  __m256i l0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line));
+  __m256i l1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line + 32));
+  __m256i m0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask));
+  __m256i m1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + 4));
+  return (_mm256_testc_si256(l0, m0) & _mm256_testc_si256(l1, m1)) != 0;
+#else
+  uint64_t missing = 0;
+  for (size_t w = 0; w < 8; ++w) {
+    uint64_t word;
+    memcpy(&word, line + w * 8, sizeof(word));
+    missing |= mask[w] & ~word;
+  }
+  return missing == 0;
+#endif
+}
+
+inline void OrMaskIntoLine(char* line, const uint64_t mask[8]) {
+  for (size_t w = 0; w < 8; ++w) {
+    uint64_t word;
+    memcpy(&word, line + w * 8, sizeof(word));
+    word |= mask[w];
+    memcpy(line + w * 8, &word, sizeof(word));
+  }
+}
+}  // namespace
+
 FullFilterBitsBuilder::FullFilterBitsBuilder(const size_t bits_per_key,
                                              const size_t num_probes)
     : bits_per_key_(bits_per_key), num_probes_(num_probes) {
@@ -125,9 +182,15 @@ inline void FullFilterBitsBuilder::AddHash(uint32_t h, char* data,
 #endif
   assert(num_lines > 0 && total_bits > 0);
 
-  const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
   uint32_t b = (h % num_lines) * (CACHE_LINE_SIZE * 8);
+  if (port::kLittleEndian && CACHE_LINE_SIZE * 8 == kMaskLineBits) {
+    uint64_t mask[8];
+    BuildProbeMask(h, num_probes_, mask);
+    OrMaskIntoLine(data + b / 8, mask);
+    return;
+  }
 
+  const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
   for (uint32_t i = 0; i < num_probes_; ++i) {
     // Since CACHE_LINE_SIZE is defined as 2^n, this line will be optimized
     // to a simple operation by compiler.
@@ -249,6 +312,12 @@ bool FullFilterBitsReader::HashMayMatch(const uint32_t& hash,
   const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
   // Left shift by an extra 3 to convert bytes to bits
   uint32_t b = (h % num_lines) << (log2_cache_line_size_ + 3);
+  if (port::kLittleEndian && (1u << (log2_cache_line_size_ + 3)) ==
+                                  kMaskLineBits) {
+    uint64_t mask[8];
+    BuildProbeMask(h, num_probes, mask);
+    return LineContainsMask(data + b / 8, mask);
+  }
   PREFETCH(&data[b / 8], 0 /* rw */, 1 /* locality */);
   PREFETCH(&data[b / 8 + (1 << log2_cache_line_size_) - 1], 0 /* rw */,
            1 /* locality */);
@@ -347,15 +416,19 @@ class BloomFilterPolicy : public FilterPolicy {
     return new FullFilterBitsBuilder(bits_per_key_, num_probes_);
   }
 
+  // Reads both bloom and xor full filters
   virtual FilterBitsReader* GetFilterBitsReader(
       const Slice& contents) const override {
+    if (XorFilterBitsBuilder::IsXorFilter(contents)) {
+      return NewXorFilterBitsReader(contents);
+    }
     return new FullFilterBitsReader(contents);
   }
 
   // If choose to use block based builder
   bool UseBlockBasedBuilder() { return use_block_based_builder_; }
 
- private:
+ protected:
   size_t bits_per_key_;
   size_t num_probes_;
   uint32_t (*hash_func_)(const Slice& key);
@@ -370,6 +443,19 @@ class BloomFilterPolicy : public FilterPolicy {
   }
 };
 
+// Builds xor full filters. The name is the one of the bloom policy, the
+// filters of tables built by either are read by both
+class XorFilterPolicy : public BloomFilterPolicy {
+ public:
+  explicit XorFilterPolicy(int bits_per_key)
+      : BloomFilterPolicy(bits_per_key, false) {}
+
+  virtual FilterBitsBuilder* GetFilterBitsBuilder() const override {
+    // A fingerprint of f bits costs 1.23 * f bits per key
+    return new XorFilterBitsBuilder(bits_per_key_ >= 20 ? 2 : 1);
+  }
+};
+
 }  // namespace
 
 const FilterPolicy* NewBloomFilterPolicy(int bits_per_key,
@@ -377,4 +463,8 @@ const FilterPolicy* NewBloomFilterPolicy(int bits_per_key,
   return new BloomFilterPolicy(bits_per_key, use_block_based_builder);
 }
 
+const FilterPolicy* NewXorFilterPolicy(int bits_per_key) {
+  return new XorFilterPolicy(bits_per_key);
+}
+
 }  // namespace TERARKDB_NAMESPACE
@@ -21,10 +21,13 @@ int main() {
 #include "rocksdb/terark_namespace.h"
 #include "table/full_filter_bits_builder.h"
 #include "util/arena.h"
+#include "util/coding.h"
 #include "util/gflags_compat.h"
+#include "util/hash.h"
 #include "util/logging.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
+#include "util/xor_filter.h"
 
 using GFLAGS_NAMESPACE::ParseCommandLineFlags;
 
@@ -299,6 +302,130 @@ TEST_F(FullBloomTest, FullVaryingLengths) {
   ASSERT_LE(mediocre_filters, good_filters / 5);
 }
 
+// The probe bits of a key are the ones of the scalar bit by bit probe, so
+// filters built before and after the masked probe read the same
+TEST_F(FullBloomTest, ProbeBitsCompatible) {
+  char buffer[sizeof(int)];
+  const int kNumKeys = 1000;
+  std::unique_ptr<const FilterPolicy> policy(
+      NewBloomFilterPolicy(FLAGS_bits_per_key, false));
+  std::unique_ptr<FilterBitsBuilder> builder(policy->GetFilterBitsBuilder());
+  for (int i = 0; i < kNumKeys; i++) {
+    builder->AddKey(Key(i, buffer));
+  }
+  std::unique_ptr<const char[]> buf;
+  Slice filter = builder->Finish(&buf);
+  ASSERT_GT(filter.size(), 5U);
+  const char* data = filter.data();
+  const uint32_t num_probes = static_cast<uint8_t>(data[filter.size() - 5]);
+  const uint32_t num_lines = DecodeFixed32(data + filter.size() - 4);
+  const uint32_t line_bits = CACHE_LINE_SIZE * 8;
+  for (int i = 0; i < kNumKeys; i++) {
+    uint32_t h = BloomHash(Key(i, buffer));
+    const uint32_t delta = (h >> 17) | (h << 15);
+    const uint32_t b = (h % num_lines) * line_bits;
+    for (uint32_t j = 0; j < num_probes; j++) {
+      const uint32_t bitpos = b + h % line_bits;
+      ASSERT_NE(0, data[bitpos / 8] & (1 << (bitpos % 8)));
+      h += delta;
+    }
+  }
+}
+
+class XorFilterTest : public testing::Test {
+ public:
+  XorFilterTest()
+      : policy_(NewXorFilterPolicy(FLAGS_bits_per_key)),
+        bloom_policy_(NewBloomFilterPolicy(FLAGS_bits_per_key, false)) {}
+
+  void Build(int length) {
+    char buffer[sizeof(int)];
+    std::unique_ptr<FilterBitsBuilder> builder(policy_->GetFilterBitsBuilder());
+    for (int i = 0; i < length; i++) {
+      builder->AddKey(Key(i, buffer));
+    }
+    filter_ = builder->Finish(&buf_);
+    reader_.reset(policy_->GetFilterBitsReader(filter_));
+  }
+
+  double FalsePositiveRate() {
+    char buffer[sizeof(int)];
+    int result = 0;
+    for (int i = 0; i < 10000; i++) {
+      if (reader_->MayMatch(Key(i + 1000000000, buffer))) {
+        result++;
+      }
+    }
+    return result / 10000.0;
+  }
+
+ protected:
+  std::unique_ptr<const FilterPolicy> policy_;
+  std::unique_ptr<const FilterPolicy> bloom_policy_;
+  std::unique_ptr<const char[]> buf_;
+  Slice filter_;
+  std::unique_ptr<FilterBitsReader> reader_;
+};
+
+TEST_F(XorFilterTest, EmptyFilter) {
+  Build(0);
+  ASSERT_TRUE(XorFilterBitsBuilder::IsXorFilter(filter_));
+  ASSERT_TRUE(!reader_->MayMatch("hello"));
+  ASSERT_TRUE(!reader_->MayMatch("world"));
+}
+
+TEST_F(XorFilterTest, FilterSize) {
+  XorFilterBitsBuilder builder(1);
+  for (int n = 1; n < 1000; n++) {
+    auto space = builder.CalculateSpace(n);
+    auto n2 = builder.CalculateNumEntry(space);
+    ASSERT_GE(n2, n);
+    ASSERT_EQ(space, builder.CalculateSpace(n2));
+  }
+}
+
+TEST_F(XorFilterTest, VaryingLengths) {
+  char buffer[sizeof(int)];
+  for (int length = 1; length <= 10000; length = NextLength(length)) {
+    Build(length);
+    // About 1.23 bytes per key
+    ASSERT_LE(filter_.size(),
+              static_cast<size_t>(length * 1.23 + 32 +
+                                  XorFilterBitsBuilder::kMetaSize))
+        << length;
+    for (int i = 0; i < length; i++) {
+      ASSERT_TRUE(reader_->MayMatch(Key(i, buffer)))
+          << "Length " << length << "; key " << i;
+    }
+    // 1/256 expected
+    ASSERT_LE(FalsePositiveRate(), 0.008) << length;
+  }
+}
+
+// Bloom and xor policies read the filters of each other
+TEST_F(XorFilterTest, ReadByBloomPolicy) {
+  char buffer[sizeof(int)];
+  Build(1000);
+  std::unique_ptr<FilterBitsReader> reader(
+      bloom_policy_->GetFilterBitsReader(filter_));
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(reader->MayMatch(Key(i, buffer)));
+  }
+
+  std::unique_ptr<FilterBitsBuilder> builder(
+      bloom_policy_->GetFilterBitsBuilder());
+  for (int i = 0; i < 1000; i++) {
+    builder->AddKey(Key(i, buffer));
+  }
+  std::unique_ptr<const char[]> buf;
+  Slice bloom_filter = builder->Finish(&buf);
+  ASSERT_TRUE(!XorFilterBitsBuilder::IsXorFilter(bloom_filter));
+  reader.reset(policy_->GetFilterBitsReader(bloom_filter));
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(reader->MayMatch(Key(i, buffer)));
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -12,6 +12,7 @@ namespace TERARKDB_NAMESPACE {
 
 void CompactionJobStats::Reset() {
   elapsed_micros = 0;
+  cpu_micros = 0;
 
   num_input_records = 0;
   num_input_files = 0;
@@ -40,12 +41,21 @@ void CompactionJobStats::Reset() {
   file_fsync_nanos = 0;
   file_prepare_write_nanos = 0;
 
+  input_read_time = {0, 0};
+  compaction_iterator_time = {0, 0};
+  compaction_filter_time = {0, 0};
+  merge_time = {0, 0};
+  table_add_time = {0, 0};
+  table_finish_time = {0, 0};
+  blob_output_time = {0, 0};
+
   num_single_del_fallthru = 0;
   num_single_del_mismatch = 0;
 }
 
 void CompactionJobStats::Add(const CompactionJobStats& stats) {
   elapsed_micros += stats.elapsed_micros;
+  cpu_micros += stats.cpu_micros;
 
   num_input_records += stats.num_input_records;
   num_input_files += stats.num_input_files;
@@ -72,6 +82,18 @@ void CompactionJobStats::Add(const CompactionJobStats& stats) {
   file_fsync_nanos += stats.file_fsync_nanos;
   file_prepare_write_nanos += stats.file_prepare_write_nanos;
 
+  auto add = [](PhaseTime* to, const PhaseTime& from) {
+    to->wall_nanos += from.wall_nanos;
+    to->cpu_nanos += from.cpu_nanos;
+  };
+  add(&input_read_time, stats.input_read_time);
+  add(&compaction_iterator_time, stats.compaction_iterator_time);
+  add(&compaction_filter_time, stats.compaction_filter_time);
+  add(&merge_time, stats.merge_time);
+  add(&table_add_time, stats.table_add_time);
+  add(&table_finish_time, stats.table_finish_time);
+  add(&blob_output_time, stats.blob_output_time);
+
   num_single_del_fallthru += stats.num_single_del_fallthru;
   num_single_del_mismatch += stats.num_single_del_mismatch;
 }
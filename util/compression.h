@@ -42,6 +42,9 @@
 #if ZSTD_VERSION_NUMBER >= 10103  // v1.1.3+
 #include <zdict.h>
 #endif  // ZSTD_VERSION_NUMBER >= 10103
+#if ZSTD_VERSION_NUMBER >= 700  // v0.7.0+
+#define ROCKSDB_ZSTD_DDICT
+#endif  // ZSTD_VERSION_NUMBER >= 700
 
 namespace TERARKDB_NAMESPACE {
 // Need this for the context allocation override
@@ -192,11 +195,59 @@ class CompressionContext {
   Slice& dict() { return dict_; }
 };
 
+// The compression dictionary of a table, and its digested form for ZSTD.
+// Digesting the dictionary costs about as much as decompressing a small
+// block, a table reader does it once when it loads the dictionary instead of
+// on every block read.
+class UncompressionDict {
+ public:
+  UncompressionDict() {}
+  // dict must outlive this
+  UncompressionDict(const Slice& dict, bool using_zstd) : dict_(dict) {
+#ifdef ROCKSDB_ZSTD_DDICT
+    if (using_zstd && !dict.empty()) {
+      zstd_ddict_ = ZSTD_createDDict(dict.data(), dict.size());
+    }
+#else
+    (void)using_zstd;
+#endif  // ROCKSDB_ZSTD_DDICT
+  }
+  ~UncompressionDict() {
+#ifdef ROCKSDB_ZSTD_DDICT
+    if (zstd_ddict_ != nullptr) {
+      ZSTD_freeDDict(zstd_ddict_);
+    }
+#endif  // ROCKSDB_ZSTD_DDICT
+  }
+  UncompressionDict(const UncompressionDict&) = delete;
+  UncompressionDict& operator=(const UncompressionDict&) = delete;
+
+  static const UncompressionDict& GetEmptyDict() {
+    static UncompressionDict empty_dict;
+    return empty_dict;
+  }
+
+  const Slice& dict() const { return dict_; }
+#ifdef ROCKSDB_ZSTD_DDICT
+  // nullptr if not digested
+  const ZSTD_DDict* zstd_ddict() const { return zstd_ddict_; }
+#endif  // ROCKSDB_ZSTD_DDICT
+
+ private:
+  Slice dict_;
+#ifdef ROCKSDB_ZSTD_DDICT
+  ZSTD_DDict* zstd_ddict_ = nullptr;
+#endif  // ROCKSDB_ZSTD_DDICT
+};
+
 // Instantiate this class and pass it to the uncompression API below
 class UncompressionContext {
  private:
   CompressionType type_;
   Slice dict_;
+#ifdef ROCKSDB_ZSTD_DDICT
+  const ZSTD_DDict* zstd_ddict_ = nullptr;
+#endif  // ROCKSDB_ZSTD_DDICT
   CompressionContextCache* ctx_cache_ = nullptr;
   ZSTDUncompressCachedData uncomp_cached_data_;
 
@@ -213,6 +264,13 @@ class UncompressionContext {
       uncomp_cached_data_ = ctx_cache_->GetCachedZSTDUncompressData();
     }
   }
+  UncompressionContext(CompressionType comp_type,
+                       const UncompressionDict& uncomp_dict)
+      : UncompressionContext(comp_type, uncomp_dict.dict()) {
+#ifdef ROCKSDB_ZSTD_DDICT
+    zstd_ddict_ = uncomp_dict.zstd_ddict();
+#endif  // ROCKSDB_ZSTD_DDICT
+  }
   ~UncompressionContext() {
     if ((type_ == kZSTD || type_ == kZSTDNotFinalCompression) &&
         uncomp_cached_data_.GetCacheIndex() != -1) {
@@ -230,6 +288,9 @@ class UncompressionContext {
   CompressionType type() const { return type_; }
   const Slice& dict() const { return dict_; }
   Slice& dict() { return dict_; }
+#ifdef ROCKSDB_ZSTD_DDICT
+  const ZSTD_DDict* zstd_ddict() const { return zstd_ddict_; }
+#endif  // ROCKSDB_ZSTD_DDICT
 };
 
 inline bool Snappy_Supported() {
@@ -1050,9 +1111,18 @@ inline CacheAllocationPtr ZSTD_Uncompress(
 #if ZSTD_VERSION_NUMBER >= 500  // v0.5.0+
   ZSTD_DCtx* context = ctx.GetZSTDContext();
   assert(context != nullptr);
-  actual_output_length = ZSTD_decompress_usingDict(
-      context, output.get(), output_len, input_data, input_length,
-      ctx.dict().data(), ctx.dict().size());
+#ifdef ROCKSDB_ZSTD_DDICT
+  if (ctx.zstd_ddict() != nullptr) {
+    actual_output_length =
+        ZSTD_decompress_usingDDict(context, output.get(), output_len,
+                                   input_data, input_length, ctx.zstd_ddict());
+  } else
+#endif  // ROCKSDB_ZSTD_DDICT
+  {
+    actual_output_length = ZSTD_decompress_usingDict(
+        context, output.get(), output_len, input_data, input_length,
+        ctx.dict().data(), ctx.dict().size());
+  }
 #else  // up to v0.4.x
   actual_output_length =
       ZSTD_decompress(output.get(), output_len, input_data, input_length);
@@ -1115,4 +1185,160 @@ inline std::string ZSTD_TrainDictionary(const std::string& samples,
 #endif  // ZSTD_VERSION_NUMBER >= 10103
 }
 
+// Compresses a stream of records with ZSTD. Every record is flushed, so it
+// can be decompressed as soon as its own compressed bytes are read, and a
+// frame is ended once it holds max_frame_size input bytes, so that the frames
+// can be decompressed independently of each other.
+class ZSTDStreamingCompress {
+ public:
+  ZSTDStreamingCompress(int level, size_t max_frame_size)
+      : level_(level), max_frame_size_(max_frame_size) {
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+    stream_ = ZSTD_createCStream();
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+  }
+
+  ~ZSTDStreamingCompress() {
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+    ZSTD_freeCStream(stream_);
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+  }
+
+  // Appends the compressed concatenation of the slices in [begin, end) to
+  // *output. Sets *new_frame if the record starts a frame and *frame_end if
+  // it ends one.
+  template <class SliceIterator>
+  bool Compress(SliceIterator begin, SliceIterator end, std::string* output,
+                bool* new_frame, bool* frame_end) {
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+    if (stream_ == nullptr) {
+      return false;
+    }
+    *new_frame = frame_bytes_ == 0;
+    if (*new_frame && ZSTD_isError(ZSTD_initCStream(stream_, level_))) {
+      return false;
+    }
+    size_t out_size = ZSTD_CStreamOutSize();
+    ZSTD_outBuffer out = {nullptr, 0, 0};
+    auto grow = [&] {
+      size_t old_size = output->size() - (out.size - out.pos);
+      output->resize(old_size + out_size);
+      out.dst = &(*output)[0] + old_size;
+      out.size = out_size;
+      out.pos = 0;
+    };
+    grow();
+    for (auto part = begin; part != end; ++part) {
+      ZSTD_inBuffer in = {part->data(), part->size(), 0};
+      while (in.pos < in.size) {
+        if (out.pos == out.size) {
+          grow();
+        }
+        if (ZSTD_isError(ZSTD_compressStream(stream_, &out, &in))) {
+          return false;
+        }
+      }
+      frame_bytes_ += part->size();
+    }
+    *frame_end = frame_bytes_ >= max_frame_size_;
+    while (true) {
+      if (out.pos == out.size) {
+        grow();
+      }
+      size_t left = *frame_end ? ZSTD_endStream(stream_, &out)
+                               : ZSTD_flushStream(stream_, &out);
+      if (ZSTD_isError(left)) {
+        return false;
+      }
+      if (left == 0) {
+        break;
+      }
+    }
+    output->resize(output->size() - (out.size - out.pos));
+    if (*frame_end) {
+      frame_bytes_ = 0;
+    }
+    return true;
+#else   // ZSTD_VERSION_NUMBER >= 10000
+    (void)begin;
+    (void)end;
+    (void)output;
+    (void)new_frame;
+    (void)frame_end;
+    (void)level_;
+    (void)max_frame_size_;
+    (void)frame_bytes_;
+    return false;
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+  }
+
+ private:
+  const int level_;
+  const size_t max_frame_size_;
+  // Input bytes in the current frame
+  size_t frame_bytes_ = 0;
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+  ZSTD_CStream* stream_;
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+
+  ZSTDStreamingCompress(const ZSTDStreamingCompress&) = delete;
+  void operator=(const ZSTDStreamingCompress&) = delete;
+};
+
+// Decompresses the records written by ZSTDStreamingCompress, in order
+class ZSTDStreamingUncompress {
+ public:
+  ZSTDStreamingUncompress() {
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+    stream_ = ZSTD_createDStream();
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+  }
+
+  ~ZSTDStreamingUncompress() {
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+    ZSTD_freeDStream(stream_);
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+  }
+
+  // Replaces *output with the decompressed record. The records of a frame
+  // must be passed in order, the first one with new_frame set.
+  bool Uncompress(const Slice& input, bool new_frame, std::string* output) {
+    output->clear();
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+    if (stream_ == nullptr ||
+        (new_frame && ZSTD_isError(ZSTD_initDStream(stream_)))) {
+      return false;
+    }
+    size_t out_size = std::max(ZSTD_DStreamOutSize(), input.size() * 4);
+    ZSTD_inBuffer in = {input.data(), input.size(), 0};
+    while (true) {
+      size_t old_size = output->size();
+      output->resize(old_size + out_size);
+      ZSTD_outBuffer out = {&(*output)[0] + old_size, out_size, 0};
+      size_t ret = ZSTD_decompressStream(stream_, &out, &in);
+      output->resize(old_size + out.pos);
+      if (ZSTD_isError(ret)) {
+        return false;
+      }
+      // A full output buffer may hold back flushed bytes
+      if (in.pos == in.size && out.pos < out.size) {
+        return true;
+      }
+    }
+#else   // ZSTD_VERSION_NUMBER >= 10000
+    (void)input;
+    (void)new_frame;
+    return false;
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+  }
+
+ private:
+#if ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+  ZSTD_DStream* stream_;
+#endif  // ZSTD_VERSION_NUMBER >= 10000
+
+  ZSTDStreamingUncompress(const ZSTDStreamingUncompress&) = delete;
+  void operator=(const ZSTDStreamingUncompress&) = delete;
+};
+
 }  // namespace TERARKDB_NAMESPACE
@@ -9,6 +9,7 @@
 
 #include "util/concurrent_arena.h"
 
+#include <new>
 #include <thread>
 
 #include "rocksdb/terark_namespace.h"
@@ -25,14 +26,41 @@ namespace {
 // 1MB, 64 cores will quickly allocate 64MB, and may quickly trigger a
 // flush. Cap the size instead.
 const size_t kMaxShardBlockSize = size_t{128 * 1024};
+
+// Upper bound of the shard blocks carved per block pool refill.  The pool
+// is also kept within a quarter of the arena block, so it is carved from
+// the current (possibly huge page backed) arena block rather than being
+// allocated as an irregular block of its own.
+const size_t kMaxPoolBlockCount = 16;
 }  // namespace
 
 ConcurrentArena::ConcurrentArena(size_t block_size, AllocTracker* tracker,
-                                 size_t huge_page_size)
+                                 size_t huge_page_size,
+                                 ArenaBlockPool* arena_block_pool)
     : shard_block_size_(std::min(kMaxShardBlockSize, block_size / 8)),
       shards_(),
-      arena_(block_size, tracker, huge_page_size) {
+      block_pool_(nullptr),
+      arena_(block_size, tracker, huge_page_size, arena_block_pool) {
+  pool_block_count_ = std::max<size_t>(
+      1, std::min({kMaxPoolBlockCount, shards_.Size(),
+                   arena_.BlockSize() / 4 /
+                       std::max<size_t>(shard_block_size_, 1)}));
+  Fixup();
+}
+
+char* ConcurrentArena::RefillBlockPool() {
+  char* block = TakePoolBlock();
+  if (block != nullptr) {
+    return block;
+  }
+  char* base = arena_.AllocateAligned(pool_block_count_ * shard_block_size_);
+  BlockPool* pool = new (arena_.AllocateAligned(sizeof(BlockPool)))
+      BlockPool(base, pool_block_count_);
+  // The caller takes the first block
+  pool->next.store(1, std::memory_order_relaxed);
+  block_pool_.store(pool, std::memory_order_release);
   Fixup();
+  return base;
 }
 
 ConcurrentArena::Shard* ConcurrentArena::Repick() {
@@ -8,6 +8,7 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <utility>
@@ -39,6 +40,11 @@ class Logger;
 // only if ConcurrentArena actually notices concurrent use, and they
 // adjust their size so that there is no fragmentation waste when the
 // shard blocks are allocated from the underlying main arena.
+//
+// Shards refill from a pool of shard blocks that is carved from the main
+// arena a few blocks at a time.  Taking a block from the pool is a single
+// atomic increment, so refills only take the arena spinlock when the pool
+// runs dry.
 class ConcurrentArena : public Allocator {
  public:
   // block_size and huge_page_size are the same as for Arena (and are
@@ -47,7 +53,8 @@ class ConcurrentArena : public Allocator {
   // that varies according to the hardware concurrency level.
   explicit ConcurrentArena(size_t block_size = Arena::kMinBlockSize,
                            AllocTracker* tracker = nullptr,
-                           size_t huge_page_size = 0);
+                           size_t huge_page_size = 0,
+                           ArenaBlockPool* arena_block_pool = nullptr);
 
   char* Allocate(size_t bytes) override {
     return AllocateImpl(bytes, false /*force_arena*/,
@@ -96,6 +103,18 @@ class ConcurrentArena : public Allocator {
     Shard() : free_begin_(nullptr), allocated_and_unused_(0) {}
   };
 
+  // A run of shard blocks handed out lock-free in order.  Lives inside the
+  // main arena, so it is never freed before the arena and a stale pointer
+  // to an exhausted pool is always safe to read.
+  struct BlockPool {
+    char* base;
+    size_t count;
+    std::atomic<size_t> next;
+
+    BlockPool(char* _base, size_t _count)
+        : base(_base), count(_count), next(0) {}
+  };
+
 #ifdef ROCKSDB_SUPPORT_THREAD_LOCAL
   static __thread size_t tls_cpuid;
 #else
@@ -105,8 +124,10 @@ class ConcurrentArena : public Allocator {
   char padding0[56] ROCKSDB_FIELD_UNUSED;
 
   size_t shard_block_size_;
+  size_t pool_block_count_;
 
   CoreLocalArray<Shard> shards_;
+  std::atomic<BlockPool*> block_pool_;
 
   Arena arena_;
   mutable SpinMutex arena_mutex_;
@@ -118,12 +139,36 @@ class ConcurrentArena : public Allocator {
 
   Shard* Repick();
 
+  // Carves a new block pool from the main arena and returns its first
+  // block, unless another thread refilled the pool meanwhile.
+  // REQUIRES: arena_mutex_ held
+  char* RefillBlockPool();
+
+  // Returns the next block of the current pool, or nullptr if the pool is
+  // absent or exhausted.
+  char* TakePoolBlock() {
+    BlockPool* pool = block_pool_.load(std::memory_order_acquire);
+    if (pool != nullptr) {
+      size_t i = pool->next.fetch_add(1, std::memory_order_relaxed);
+      if (i < pool->count) {
+        return pool->base + i * shard_block_size_;
+      }
+    }
+    return nullptr;
+  }
+
   size_t ShardAllocatedAndUnused() const {
     size_t total = 0;
     for (size_t i = 0; i < shards_.Size(); ++i) {
       total += shards_.AccessAtCore(i)->allocated_and_unused_.load(
           std::memory_order_relaxed);
     }
+    BlockPool* pool = block_pool_.load(std::memory_order_acquire);
+    if (pool != nullptr) {
+      size_t taken = std::min(pool->count,
+                              pool->next.load(std::memory_order_relaxed));
+      total += (pool->count - taken) * shard_block_size_;
+    }
     return total;
   }
 
@@ -159,11 +204,17 @@ class ConcurrentArena : public Allocator {
 
     size_t avail = s->allocated_and_unused_.load(std::memory_order_relaxed);
     if (avail < bytes) {
-      // reload
+      // reload, from the block pool if possible
+      char* block = TakePoolBlock();
+      if (block != nullptr) {
+        s->free_begin_ = block;
+        avail = shard_block_size_;
+      }
+    }
+    if (avail < bytes) {
+      // the pool is dry, reload under the arena lock
       std::lock_guard<SpinMutex> reload_lock(arena_mutex_);
 
-      // If the arena's current block is within a factor of 2 of the right
-      // size, we adjust our request to avoid arena waste.
       auto exact = arena_allocated_and_unused_.load(std::memory_order_relaxed);
       assert(exact == arena_.AllocatedAndUnused());
 
@@ -181,11 +232,8 @@ class ConcurrentArena : public Allocator {
         return rv;
       }
 
-      avail = exact >= shard_block_size_ / 2 && exact < shard_block_size_ * 2
-                  ? exact
-                  : shard_block_size_;
-      s->free_begin_ = arena_.AllocateAligned(avail);
-      Fixup();
+      s->free_begin_ = RefillBlockPool();
+      avail = shard_block_size_;
     }
     s->allocated_and_unused_.store(avail - bytes, std::memory_order_relaxed);
 
@@ -16,6 +16,15 @@
 #include <nmmintrin.h>
 #include <wmmintrin.h>
 #endif
+// The AVX-512 kernel needs a compiler that knows the vpclmulqdq target
+#if defined(HAVE_SSE42) && defined(HAVE_PCLMUL) &&                     \
+    !defined(NO_THREEWAY_CRC32C) && defined(__GNUC__) &&               \
+    defined(__x86_64__) && !defined(IOS_CROSS_COMPILE) &&              \
+    ((defined(__clang__) && __clang_major__ >= 6) ||                   \
+     (!defined(__clang__) && __GNUC__ >= 8))
+#define ROCKSDB_CRC32C_AVX512
+#include <immintrin.h>
+#endif
 #include "rocksdb/terark_namespace.h"
 #include "util/coding.h"
 #include "util/util.h"
@@ -1200,11 +1209,105 @@ uint32_t crc32c_3way(uint32_t crc, const char* buf, size_t len) {
 
 #endif //HAVE_SSE42 && HAVE_PCLMUL
 
+#ifdef ROCKSDB_CRC32C_AVX512
+// Below this size the 3-way kernel is as fast, and the wide registers are
+// not worth waking up
+static const size_t kAvx512MinSize = 1024;
+
+static bool isAVX512VPCLMULQDQ() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512vl") &&
+         __builtin_cpu_supports("vpclmulqdq");
+}
+
+// x * k, folded over a distance given by k, xor data
+__attribute__((target("avx512f,avx512vl,vpclmulqdq"))) static inline __m512i
+Fold512(__m512i x, __m512i k, __m512i data) {
+  return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00),
+                                   _mm512_clmulepi64_epi128(x, k, 0x11), data,
+                                   0x96);
+}
+
+__attribute__((target("pclmul"))) static inline __m128i Fold128(__m128i x,
+                                                                __m128i k,
+                                                                __m128i data) {
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00),
+                                     _mm_clmulepi64_si128(x, k, 0x11)),
+                       data);
+}
+
+// Folds 256 bytes per iteration in four 512-bit registers with carry-less
+// multiplications, folds them down to 16 bytes, and finishes those and the
+// tail with the crc32 instruction. The constants are x^(D+32) and x^(D-32)
+// mod P, bit reflected and shifted left by one, for a folding distance of D
+// bits.
+__attribute__((target("avx512f,avx512vl,vpclmulqdq,pclmul,sse4.2")))
+uint32_t crc32c_avx512(uint32_t crc, const char* buf, size_t len) {
+  if (len < kAvx512MinSize) {
+    return crc32c_3way(crc, buf, len);
+  }
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(buf);
+  const __m512i k2048 =
+      _mm512_set_epi64(0xb9e02b86, 0xdcb17aa4, 0xb9e02b86, 0xdcb17aa4,
+                       0xb9e02b86, 0xdcb17aa4, 0xb9e02b86, 0xdcb17aa4);
+  const __m512i k512 =
+      _mm512_set_epi64(0x9e4addf8, 0x740eef02, 0x9e4addf8, 0x740eef02,
+                       0x9e4addf8, 0x740eef02, 0x9e4addf8, 0x740eef02);
+  const __m128i k384 = _mm_set_epi64x(0x1d82c63da, 0x1c291d04);
+  const __m128i k256 = _mm_set_epi64x(0xba4fc28e, 0x1384aa63a);
+  const __m128i k128 = _mm_set_epi64x(0x14cd00bd6, 0xf20c0dfe);
+
+  __m512i x0 = _mm512_xor_si512(
+      _mm512_loadu_si512(p),
+      _mm512_set_epi64(0, 0, 0, 0, 0, 0, 0, static_cast<uint32_t>(~crc)));
+  __m512i x1 = _mm512_loadu_si512(p + 64);
+  __m512i x2 = _mm512_loadu_si512(p + 128);
+  __m512i x3 = _mm512_loadu_si512(p + 192);
+  p += 256;
+  len -= 256;
+  while (len >= 256) {
+    x0 = Fold512(x0, k2048, _mm512_loadu_si512(p));
+    x1 = Fold512(x1, k2048, _mm512_loadu_si512(p + 64));
+    x2 = Fold512(x2, k2048, _mm512_loadu_si512(p + 128));
+    x3 = Fold512(x3, k2048, _mm512_loadu_si512(p + 192));
+    p += 256;
+    len -= 256;
+  }
+  x1 = Fold512(x0, k512, x1);
+  x2 = Fold512(x1, k512, x2);
+  x3 = Fold512(x2, k512, x3);
+  alignas(64) __m128i lanes[4];
+  _mm512_store_si512(lanes, x3);
+  __m128i v = Fold128(lanes[0], k384, lanes[3]);
+  v = Fold128(lanes[1], k256, v);
+  v = Fold128(lanes[2], k128, v);
+
+  uint64_t l = _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(v)));
+  l = _mm_crc32_u64(l, static_cast<uint64_t>(_mm_extract_epi64(v, 1)));
+  while (len >= 8) {
+    l = _mm_crc32_u64(l, LE_LOAD64(p));
+    p += 8;
+    len -= 8;
+  }
+  while (len > 0) {
+    l = _mm_crc32_u8(static_cast<uint32_t>(l), *p++);
+    --len;
+  }
+  return ~static_cast<uint32_t>(l);
+}
+#endif  // ROCKSDB_CRC32C_AVX512
+
 static inline Function Choose_Extend() {
 #ifndef HAVE_POWER8
   if (isSSE42()) {
     if (isPCLMULQDQ()) {
 #if defined HAVE_SSE42  && defined HAVE_PCLMUL && !defined NO_THREEWAY_CRC32C
+#ifdef ROCKSDB_CRC32C_AVX512
+      if (isAVX512VPCLMULQDQ()) {
+        return crc32c_avx512;
+      }
+#endif
       return crc32c_3way;
 #else
     return ExtendImpl<Fast_CRC32>; // Fast_CRC32 will check HAVE_SSE42 itself
@@ -1227,6 +1330,28 @@ uint32_t Extend(uint32_t crc, const char* buf, size_t size) {
   return ChosenExtend(crc, buf, size);
 }
 
+std::string KernelName() {
+#ifdef ROCKSDB_CRC32C_AVX512
+  if (ChosenExtend == crc32c_avx512) {
+    return "avx512-vpclmulqdq";
+  }
+#endif
+#if defined HAVE_SSE42 && defined HAVE_PCLMUL && !defined NO_THREEWAY_CRC32C
+  if (ChosenExtend == crc32c_3way) {
+    return "sse42-pclmul-3way";
+  }
+#endif
+#if defined(HAVE_POWER8) && defined(HAS_ALTIVEC)
+  if (ChosenExtend == ExtendPPCImpl) {
+    return "ppc-vpmsum";
+  }
+#endif
+  if (ChosenExtend == ExtendImpl<Fast_CRC32>) {
+    return "sse42";
+  }
+  return "portable";
+}
+
 
 }  // namespace crc32c
 }  // namespace TERARKDB_NAMESPACE
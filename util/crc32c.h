@@ -20,6 +20,9 @@ namespace crc32c {
 
 extern std::string IsFastCrc32Supported();
 
+// The name of the implementation chosen at runtime for this CPU
+extern std::string KernelName();
+
 // Return the crc32c of concat(A, data[0,n-1]) where init_crc is the
 // crc32c of some string A.  Extend() is often used to maintain the
 // crc32c of a stream of data.
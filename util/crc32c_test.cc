@@ -10,6 +10,7 @@
 
 #include "rocksdb/terark_namespace.h"
 #include "util/coding.h"
+#include "util/random.h"
 #include "util/testharness.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -125,6 +126,36 @@ TEST(CRC, Mask) {
   ASSERT_EQ(crc, Unmask(Unmask(Mask(Mask(crc)))));
 }
 
+// The kernel chosen for this CPU, whichever it is, matches a bit at a time
+// reference, on the lengths and alignments around its block sizes
+TEST(CRC, MatchesReference) {
+  auto reference = [](uint32_t crc, const char* data, size_t n) {
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) {
+      crc ^= static_cast<uint8_t>(data[i]);
+      for (int b = 0; b < 8; ++b) {
+        crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+      }
+    }
+    return ~crc;
+  };
+  fprintf(stderr, "kernel: %s\n", KernelName().c_str());
+  Random rnd(301);
+  std::string buf;
+  for (size_t i = 0; i < 8192 + 64; ++i) {
+    buf.push_back(static_cast<char>(rnd.Uniform(256)));
+  }
+  for (size_t len : {0, 1, 7, 8, 255, 256, 1023, 1024, 1025, 1279, 1280, 1300,
+                     2048, 4095, 4096, 8192}) {
+    for (size_t offset = 0; offset < 64; offset += 13) {
+      uint32_t init = rnd.Next();
+      ASSERT_EQ(reference(init, buf.data() + offset, len),
+                Extend(init, buf.data() + offset, len))
+          << len << " " << offset;
+    }
+  }
+}
+
 }  // namespace crc32c
 }  // namespace TERARKDB_NAMESPACE
 
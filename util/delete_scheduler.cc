@@ -232,6 +232,9 @@ void DeleteScheduler::BackgroundEmptyTrash() {
     // Delete all files in queue_
     uint64_t start_time = env_->NowMicros();
     uint64_t total_deleted_bytes = 0;
+    // Unlinks are made durable in batches, one fsync per directory
+    std::set<std::string> dirs_to_sync;
+    size_t unsynced_deletes = 0;
     int64_t current_delete_rate = rate_bytes_per_sec_.load();
     while (!queue_.empty() && !closing_) {
       if (current_delete_rate != rate_bytes_per_sec_.load()) {
@@ -244,14 +247,14 @@ void DeleteScheduler::BackgroundEmptyTrash() {
       // Get new file to delete
       const FileAndDir& fad = queue_.front();
       std::string path_in_trash = fad.fname;
+      std::string dir_to_sync = fad.dir;
 
       // We dont need to hold the lock while deleting the file
       mu_.Unlock();
       uint64_t deleted_bytes = 0;
       bool is_complete = true;
       // Delete file from trash and update total_penlty value
-      Status s =
-          DeleteTrashFile(path_in_trash, fad.dir, &deleted_bytes, &is_complete);
+      Status s = DeleteTrashFile(path_in_trash, &deleted_bytes, &is_complete);
       total_deleted_bytes += deleted_bytes;
       mu_.Lock();
       if (is_complete) {
@@ -260,6 +263,16 @@ void DeleteScheduler::BackgroundEmptyTrash() {
 
       if (!s.ok()) {
         bg_errors_[path_in_trash] = s;
+      } else if (is_complete && !dir_to_sync.empty()) {
+        dirs_to_sync.insert(dir_to_sync);
+        ++unsynced_deletes;
+      }
+      if (!dirs_to_sync.empty() &&
+          (queue_.empty() || unsynced_deletes >= kMaxDeletesPerDirSync)) {
+        mu_.Unlock();
+        SyncTrashDirs(&dirs_to_sync);
+        mu_.Lock();
+        unsynced_deletes = 0;
       }
 
       // Apply penlty if necessary
@@ -289,11 +302,36 @@ void DeleteScheduler::BackgroundEmptyTrash() {
         cv_.SignalAll();
       }
     }
+    if (!dirs_to_sync.empty()) {
+      // Interrupted by closing_
+      mu_.Unlock();
+      SyncTrashDirs(&dirs_to_sync);
+      mu_.Lock();
+    }
   }
 }
 
+void DeleteScheduler::SyncTrashDirs(std::set<std::string>* dirs) {
+  for (auto& dir : *dirs) {
+    std::unique_ptr<Directory> dir_obj;
+    Status s = env_->NewDirectory(dir, &dir_obj);
+    if (s.ok()) {
+      s = dir_obj->Fsync();
+      TEST_SYNC_POINT_CALLBACK(
+          "DeleteScheduler::SyncTrashDirs:AfterSyncDir",
+          reinterpret_cast<void*>(const_cast<std::string*>(&dir)));
+    }
+    if (!s.ok()) {
+      ROCKS_LOG_ERROR(info_log_, "Failed to sync %s after deleting trash -- %s",
+                      dir.c_str(), s.ToString().c_str());
+      InstrumentedMutexLock l(&mu_);
+      bg_errors_[dir] = s;
+    }
+  }
+  dirs->clear();
+}
+
 Status DeleteScheduler::DeleteTrashFile(const std::string& path_in_trash,
-                                        const std::string& dir_to_sync,
                                         uint64_t* deleted_bytes,
                                         bool* is_complete) {
   uint64_t file_size;
@@ -349,18 +387,6 @@ Status DeleteScheduler::DeleteTrashFile(const std::string& path_in_trash,
 
     if (need_full_delete) {
       s = env_->DeleteFile(path_in_trash);
-      if (!dir_to_sync.empty()) {
-        std::unique_ptr<Directory> dir_obj;
-        if (s.ok()) {
-          s = env_->NewDirectory(dir_to_sync, &dir_obj);
-        }
-        if (s.ok()) {
-          s = dir_obj->Fsync();
-          TEST_SYNC_POINT_CALLBACK(
-              "DeleteScheduler::DeleteTrashFile::AfterSyncDir",
-              reinterpret_cast<void*>(const_cast<std::string*>(&dir_to_sync)));
-        }
-      }
       *deleted_bytes = file_size;
       sst_file_manager_->OnDeleteFile(path_in_trash);
     }
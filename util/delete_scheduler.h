@@ -9,6 +9,7 @@
 
 #include <map>
 #include <queue>
+#include <set>
 #include <string>
 #include <thread>
 
@@ -78,6 +79,10 @@ class DeleteScheduler {
   static const std::string kTrashExtension;
   static bool IsTrashFile(const std::string& file_path);
 
+  // Directories of deleted trash files are synced once per this many
+  // deletes, and whenever the trash queue runs empty
+  static const size_t kMaxDeletesPerDirSync = 32;
+
   // Check if there are any .trash filse in path, and schedule their deletion
   // Or delete immediately if sst_file_manager is nullptr
   static Status CleanupDirectory(Env* env, SstFileManagerImpl* sfm,
@@ -87,9 +92,11 @@ class DeleteScheduler {
   Status MarkAsTrash(const std::string& file_path, std::string* path_in_trash);
 
   Status DeleteTrashFile(const std::string& path_in_trash,
-                         const std::string& dir_to_sync,
                          uint64_t* deleted_bytes, bool* is_complete);
 
+  // Syncs and clears dirs, REQUIRES: mu_ not held
+  void SyncTrashDirs(std::set<std::string>* dirs);
+
   void BackgroundEmptyTrash();
 
   Env* env_;
@@ -128,7 +128,7 @@ TEST_F(DeleteSchedulerTest, BasicRateLimiting) {
       [&](void* arg) { penalties.push_back(*(static_cast<uint64_t*>(arg))); });
   int dir_synced = 0;
   TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
-      "DeleteScheduler::DeleteTrashFile::AfterSyncDir", [&](void* arg) {
+      "DeleteScheduler::SyncTrashDirs:AfterSyncDir", [&](void* arg) {
         dir_synced++;
         std::string* dir = reinterpret_cast<std::string*>(arg);
         EXPECT_EQ(dummy_files_dirs_[0], *dir);
@@ -180,7 +180,10 @@ TEST_F(DeleteSchedulerTest, BasicRateLimiting) {
     }
     ASSERT_GT(time_spent_deleting, expected_penlty * 0.9);
 
-    ASSERT_EQ(num_files, dir_synced);
+    // One sync per batch of deletes, the last one when the trash runs empty
+    ASSERT_EQ((num_files + DeleteScheduler::kMaxDeletesPerDirSync - 1) /
+                  DeleteScheduler::kMaxDeletesPerDirSync,
+              dir_synced);
 
     ASSERT_EQ(CountTrashFiles(), 0);
     TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
@@ -0,0 +1,93 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/epoch_manager.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+// Gives the record back to the registry when the thread exits
+struct LocalRecordHolder {
+  void* record = nullptr;
+  std::atomic<bool>* owned = nullptr;
+
+  ~LocalRecordHolder() {
+    if (owned != nullptr) {
+      owned->store(false, std::memory_order_release);
+    }
+  }
+};
+
+thread_local LocalRecordHolder local_record;
+}  // namespace
+
+EpochManager* EpochManager::Default() {
+  // Never destroyed, threads may exit their epochs after static destruction
+  static EpochManager* manager = new EpochManager;
+  return manager;
+}
+
+EpochManager::Record* EpochManager::LocalRecord() {
+  if (local_record.record != nullptr) {
+    return static_cast<Record*>(local_record.record);
+  }
+  Record* record = nullptr;
+  for (Record* r = records_.load(std::memory_order_acquire); r != nullptr;
+       r = r->next) {
+    bool owned = false;
+    if (!r->owned.load(std::memory_order_relaxed) &&
+        r->owned.compare_exchange_strong(owned, true,
+                                         std::memory_order_acquire)) {
+      record = r;
+      break;
+    }
+  }
+  if (record == nullptr) {
+    record = new Record;
+    record->next = records_.load(std::memory_order_relaxed);
+    while (!records_.compare_exchange_weak(record->next, record,
+                                           std::memory_order_release)) {
+    }
+  }
+  local_record.record = record;
+  local_record.owned = &record->owned;
+  return record;
+}
+
+void EpochManager::Enter() {
+  Record* record = LocalRecord();
+  if (record->depth++ == 0) {
+    // Acquire, a thread reading the epoch after a Retire() sees the
+    // pointers unlinked before it
+    record->epoch.store(epoch_.load(std::memory_order_acquire),
+                        std::memory_order_seq_cst);
+  }
+}
+
+void EpochManager::Exit() {
+  Record* record = LocalRecord();
+  assert(record->depth > 0);
+  if (--record->depth == 0) {
+    record->epoch.store(0, std::memory_order_release);
+  }
+}
+
+uint64_t EpochManager::MinActiveEpoch() const {
+  uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+  for (Record* r = records_.load(std::memory_order_acquire); r != nullptr;
+       r = r->next) {
+    uint64_t epoch = r->epoch.load(std::memory_order_seq_cst);
+    if (epoch != 0) {
+      min_epoch = std::min(min_epoch, epoch);
+    }
+  }
+  return min_epoch;
+}
+
+}  // namespace TERARKDB_NAMESPACE
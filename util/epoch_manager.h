@@ -0,0 +1,64 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "port/port.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Epoch based reclamation. A reader announces the current epoch in a slot of
+// its own thread while it uses shared objects, without any read-modify-write
+// of shared memory. A writer unlinks an object, ends the epoch with Retire(),
+// and frees the object once no thread announces that epoch or an older one:
+//
+//   reader:                        writer:
+//     EpochManager::Enter();         old = ptr.exchange(new);
+//     T* p = ptr.load();             uint64_t e = Retire();
+//     ...                            ...
+//     EpochManager::Exit();          if (e < MinActiveEpoch()) delete old;
+//
+// Enter() and Exit() nest, the outermost Enter() announces the epoch. The
+// shared pointers must be stored and loaded with memory_order_seq_cst.
+class EpochManager {
+ public:
+  static EpochManager* Default();
+
+  void Enter();
+  void Exit();
+
+  // Ends the current epoch and returns it
+  uint64_t Retire() { return epoch_.fetch_add(1); }
+
+  // The oldest epoch announced by a thread, UINT64_MAX if none
+  uint64_t MinActiveEpoch() const;
+
+ private:
+  struct Record {
+    // 0 when the thread is not in an epoch
+    std::atomic<uint64_t> epoch{0};
+    // Written by the owner thread only
+    uint64_t depth = 0;
+    std::atomic<bool> owned{true};
+    Record* next = nullptr;
+    // One record per cache line, a thread announcing does not invalidate the
+    // record of another
+    char padding[CACHE_LINE_SIZE];
+  };
+
+  // The record of the calling thread, taken from the registry when the
+  // thread enters its first epoch and given back when it exits
+  Record* LocalRecord();
+
+  std::atomic<uint64_t> epoch_{1};
+  // Push only list of the records of all threads, never freed
+  std::atomic<Record*> records_{nullptr};
+};
+
+}  // namespace TERARKDB_NAMESPACE
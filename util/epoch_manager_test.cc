@@ -0,0 +1,136 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/epoch_manager.h"
+
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class EpochManagerTest : public testing::Test {};
+
+TEST_F(EpochManagerTest, NestedEpochs) {
+  EpochManager* manager = EpochManager::Default();
+  const uint64_t kNone = std::numeric_limits<uint64_t>::max();
+  ASSERT_EQ(kNone, manager->MinActiveEpoch());
+
+  manager->Enter();
+  uint64_t epoch = manager->MinActiveEpoch();
+  ASSERT_NE(kNone, epoch);
+  ASSERT_EQ(epoch, manager->Retire());
+  // The nested epoch keeps the outer announcement
+  manager->Enter();
+  ASSERT_EQ(epoch, manager->MinActiveEpoch());
+  manager->Exit();
+  ASSERT_EQ(epoch, manager->MinActiveEpoch());
+  manager->Exit();
+  ASSERT_EQ(kNone, manager->MinActiveEpoch());
+
+  manager->Enter();
+  ASSERT_LT(epoch, manager->MinActiveEpoch());
+  manager->Exit();
+}
+
+TEST_F(EpochManagerTest, OtherThreads) {
+  EpochManager* manager = EpochManager::Default();
+  std::atomic<int> stage{0};
+  uint64_t epoch = 0;
+  port::Thread reader([&] {
+    manager->Enter();
+    epoch = manager->MinActiveEpoch();
+    stage = 1;
+    while (stage != 2) {
+      std::this_thread::yield();
+    }
+    manager->Exit();
+  });
+  while (stage != 1) {
+    std::this_thread::yield();
+  }
+  uint64_t retired = manager->Retire();
+  ASSERT_LE(epoch, retired);
+  // The reader may still use what was retired
+  ASSERT_FALSE(retired < manager->MinActiveEpoch());
+  stage = 2;
+  reader.join();
+  ASSERT_TRUE(retired < manager->MinActiveEpoch());
+
+  // The records of the exited threads are reused
+  for (int i = 0; i < 100; ++i) {
+    port::Thread t([manager] {
+      manager->Enter();
+      manager->Exit();
+    });
+    t.join();
+  }
+}
+
+TEST_F(EpochManagerTest, Reclamation) {
+  EpochManager* manager = EpochManager::Default();
+  struct Object {
+    std::atomic<bool> freed{false};
+  };
+  std::atomic<Object*> current{new Object};
+  std::atomic<bool> stop{false};
+  std::atomic<int> errors{0};
+  std::vector<port::Thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop) {
+        manager->Enter();
+        Object* object = current.load(std::memory_order_seq_cst);
+        for (int j = 0; j < 10; ++j) {
+          if (object->freed.load()) {
+            ++errors;
+          }
+        }
+        manager->Exit();
+      }
+    });
+  }
+  // Objects are marked freed instead of deleted, so that a reader seeing a
+  // reclaimed object is detected
+  std::vector<std::unique_ptr<Object>> reclaimed;
+  std::deque<std::pair<uint64_t, Object*>> retired;
+  for (int i = 0; i < 10000; ++i) {
+    Object* old = current.exchange(new Object, std::memory_order_seq_cst);
+    retired.emplace_back(manager->Retire(), old);
+    uint64_t min_active_epoch = manager->MinActiveEpoch();
+    while (!retired.empty() && retired.front().first < min_active_epoch) {
+      retired.front().second->freed = true;
+      reclaimed.emplace_back(retired.front().second);
+      retired.pop_front();
+    }
+  }
+  stop = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+  ASSERT_EQ(0, errors.load());
+  // Everything is reclaimed once the readers are gone
+  ASSERT_EQ(std::numeric_limits<uint64_t>::max(), manager->MinActiveEpoch());
+  ASSERT_EQ(10000U, reclaimed.size() + retired.size());
+  for (auto& r : retired) {
+    delete r.second;
+  }
+  delete current.load();
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -10,6 +10,7 @@
 #include "util/file_reader_writer.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <mutex>
 
 #include "monitoring/histogram.h"
@@ -222,6 +223,189 @@ Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
   return s;
 }
 
+Status RandomAccessFileReader::MultiRead(ReadRequest* reqs,
+                                         size_t num_reqs) const {
+  if (use_direct_io() || use_fsread_ ||
+      (for_compaction_ && rate_limiter_ != nullptr)) {
+    // Alignment and rate limiting are handled per read
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      req.status = Read(req.offset, req.len, &req.result, req.scratch);
+    }
+    return Status::OK();
+  }
+  Status s;
+  uint64_t elapsed = 0;
+  {
+    StopWatch sw(env_, stats_, hist_type_,
+                 (stats_ != nullptr) ? &elapsed : nullptr, true /*overwrite*/,
+                 true /*delay_enabled*/);
+    IOSTATS_TIMER_GUARD(read_nanos);
+#ifndef ROCKSDB_LITE
+    FileOperationInfo::TimePoint start_ts;
+    if (ShouldNotifyListeners()) {
+      start_ts = std::chrono::system_clock::now();
+    }
+#endif
+    s = file_->MultiRead(reqs, num_reqs);
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      if (!s.ok()) {
+        req.status = s;
+      }
+      if (!req.status.ok()) {
+        req.result = Slice(req.scratch, 0);
+      }
+#ifndef ROCKSDB_LITE
+      if (ShouldNotifyListeners()) {
+        auto finish_ts = std::chrono::system_clock::now();
+        NotifyOnFileReadFinish(req.offset, req.result.size(), start_ts,
+                               finish_ts, req.status);
+      }
+#endif
+      IOSTATS_ADD_IF_POSITIVE(bytes_read, req.result.size());
+    }
+  }
+  if (stats_ != nullptr && file_read_hist_ != nullptr) {
+    file_read_hist_->Add(elapsed);
+  }
+  return s;
+}
+
+struct WritableFileWriter::AsyncWriter {
+  port::Thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  // The buffer being written while pending, the spare one otherwise
+  AlignedBuffer buffer;
+  // File size once the buffer is written
+  uint64_t end_offset = 0;
+  bool pending = false;
+  bool shutdown = false;
+  // The first error of the background writes
+  Status status;
+};
+
+WritableFileWriter::WritableFileWriter(
+    std::unique_ptr<WritableFile>&& file, const std::string& _file_name,
+    const EnvOptions& options, Statistics* stats,
+    const std::vector<std::shared_ptr<EventListener>>& listeners,
+    MemoryAllocator* buffer_allocator)
+    : writable_file_(std::move(file)),
+      file_name_(_file_name),
+      buf_(),
+      max_buffer_size_(options.writable_file_max_buffer_size),
+      filesize_(0),
+#ifndef ROCKSDB_LITE
+      next_write_offset_(0),
+#endif  // ROCKSDB_LITE
+      pending_sync_(false),
+      last_sync_size_(0),
+      bytes_per_sync_(options.bytes_per_sync),
+      rate_limiter_(options.rate_limiter),
+      stats_(stats),
+      listeners_() {
+  TEST_SYNC_POINT_CALLBACK("WritableFileWriter::WritableFileWriter:0",
+                           reinterpret_cast<void*>(max_buffer_size_));
+  buf_.Alignment(writable_file_->GetRequiredBufferAlignment());
+  buf_.Allocator(buffer_allocator);
+  buf_.AllocateNewBuffer(std::min((size_t)65536, max_buffer_size_));
+#ifndef ROCKSDB_LITE
+  std::for_each(listeners.begin(), listeners.end(),
+                [this](const std::shared_ptr<EventListener>& e) {
+                  if (e->ShouldBeNotifiedOnFileIO()) {
+                    listeners_.emplace_back(e);
+                  }
+                });
+#else  // !ROCKSDB_LITE
+  (void)listeners;
+#endif
+  if (options.use_async_writes && !use_direct_io()) {
+    InitAsyncWriter();
+  }
+}
+
+WritableFileWriter::~WritableFileWriter() { Close(); }
+
+void WritableFileWriter::InitAsyncWriter() {
+  async_writer_.reset(new AsyncWriter);
+  async_writer_->buffer.Alignment(buf_.Alignment());
+  async_writer_->thread =
+      port::Thread(&WritableFileWriter::BGWriteThread, this);
+}
+
+void WritableFileWriter::BGWriteThread() {
+  AsyncWriter* async = async_writer_.get();
+  std::unique_lock<std::mutex> lock(async->mutex);
+  while (true) {
+    async->cv.wait(lock, [async] { return async->pending || async->shutdown; });
+    if (!async->pending) {
+      break;
+    }
+    lock.unlock();
+    size_t size = async->buffer.CurrentSize();
+    uint64_t offset = async->end_offset - size;
+    {
+      IOSTATS_TIMER_GUARD(prepare_write_nanos);
+      writable_file_->PrepareWrite(static_cast<size_t>(offset), size);
+    }
+    Status s = WriteBuffered(async->buffer.BufferStart(), size, false);
+    if (s.ok()) {
+      s = AutoRangeSync(async->end_offset);
+    }
+    TEST_SYNC_POINT("WritableFileWriter::BGWriteThread:AfterWrite");
+    lock.lock();
+    if (async->status.ok()) {
+      async->status = s;
+    }
+    async->buffer.Size(0);
+    async->pending = false;
+    async->cv.notify_all();
+  }
+}
+
+Status WritableFileWriter::FlushAsync() {
+  assert(async_writer_ != nullptr);
+  Status s = WaitForAsyncWrite();
+  if (!s.ok()) {
+    return s;
+  }
+  AsyncWriter* async = async_writer_.get();
+  std::lock_guard<std::mutex> lock(async->mutex);
+  std::swap(buf_, async->buffer);
+  if (buf_.Capacity() < async->buffer.Capacity()) {
+    buf_.AllocateNewBuffer(async->buffer.Capacity());
+  }
+  buf_.Size(0);
+  async->end_offset = filesize_;
+  async->pending = true;
+  async->cv.notify_all();
+  return s;
+}
+
+Status WritableFileWriter::WaitForAsyncWrite() {
+  if (async_writer_ == nullptr) {
+    return Status::OK();
+  }
+  AsyncWriter* async = async_writer_.get();
+  std::unique_lock<std::mutex> lock(async->mutex);
+  async->cv.wait(lock, [async] { return !async->pending; });
+  return async->status;
+}
+
+void WritableFileWriter::StopAsyncWriter() {
+  if (async_writer_ == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(async_writer_->mutex);
+    async_writer_->shutdown = true;
+    async_writer_->cv.notify_all();
+  }
+  async_writer_->thread.join();
+  async_writer_.reset();
+}
+
 Status WritableFileWriter::Append(const Slice& data) {
   const char* src = data.data();
   size_t left = data.size();
@@ -231,7 +415,8 @@ Status WritableFileWriter::Append(const Slice& data) {
   TEST_KILL_RANDOM("WritableFileWriter::Append:0",
                    rocksdb_kill_odds * REDUCE_ODDS2);
 
-  {
+  if (async_writer_ == nullptr) {
+    // The background thread prepares the ranges it writes
     IOSTATS_TIMER_GUARD(prepare_write_nanos);
     TEST_SYNC_POINT("WritableFileWriter::Append:BeforePrepareWrite");
     writable_file_->PrepareWrite(static_cast<size_t>(GetFileSize()), left);
@@ -256,7 +441,7 @@ Status WritableFileWriter::Append(const Slice& data) {
   // Flush only when buffered I/O
   if (!use_direct_io() && (buf_.Capacity() - buf_.CurrentSize()) < left) {
     if (buf_.CurrentSize() > 0) {
-      s = Flush();
+      s = async_writer_ != nullptr ? FlushAsync() : Flush();
       if (!s.ok()) {
         return s;
       }
@@ -283,7 +468,10 @@ Status WritableFileWriter::Append(const Slice& data) {
   } else {
     // Writing directly to file bypassing the buffer
     assert(buf_.CurrentSize() == 0);
-    s = WriteBuffered(src, left, true);
+    s = WaitForAsyncWrite();
+    if (s.ok()) {
+      s = WriteBuffered(src, left, true);
+    }
   }
 
   TEST_KILL_RANDOM("WritableFileWriter::Append:1", rocksdb_kill_odds);
@@ -331,6 +519,7 @@ Status WritableFileWriter::Close() {
   }
 
   s = Flush();  // flush cache to OS
+  StopAsyncWriter();
 
   Status interim;
   // In direct I/O mode we write whole pages so
@@ -364,6 +553,10 @@ Status WritableFileWriter::Flush() {
   TEST_KILL_RANDOM("WritableFileWriter::Flush:0",
                    rocksdb_kill_odds * REDUCE_ODDS2);
 
+  s = WaitForAsyncWrite();
+  if (!s.ok()) {
+    return s;
+  }
   if (buf_.CurrentSize() > 0) {
     if (use_direct_io()) {
 #ifndef ROCKSDB_LITE
@@ -371,6 +564,9 @@ Status WritableFileWriter::Flush() {
 #endif  // !ROCKSDB_LITE
     } else {
       s = WriteBuffered(buf_.BufferStart(), buf_.CurrentSize(), false);
+      if (s.ok()) {
+        buf_.Size(0);
+      }
     }
     if (!s.ok()) {
       return s;
@@ -473,7 +669,7 @@ Status WritableFileWriter::WriteBuffered(const char* data, size_t size,
   assert(!use_direct_io());
   const char* src = data;
   size_t left = size;
-  size_t filesize_for_sync = filesize_;
+  size_t filesize_for_sync = auto_sync ? filesize_ : 0;
 
   while (left > 0) {
     size_t allowed;
@@ -522,7 +718,6 @@ Status WritableFileWriter::WriteBuffered(const char* data, size_t size,
     left -= allowed;
     src += allowed;
   }
-  buf_.Size(0);
   return s;
 }
 
@@ -613,14 +808,29 @@ namespace {
 class ReadaheadRandomAccessFile : public RandomAccessFile {
  public:
   ReadaheadRandomAccessFile(std::unique_ptr<RandomAccessFile>&& file,
-                            size_t readahead_size)
+                            size_t readahead_size, Env* env)
       : file_(std::move(file)),
         alignment_(file_->GetRequiredBufferAlignment()),
         readahead_size_(Roundup(readahead_size, alignment_)),
+        env_(env),
         buffer_(),
         buffer_offset_(0) {
     buffer_.Alignment(alignment_);
     buffer_.AllocateNewBuffer(readahead_size_);
+    // Direct reads bypass the page cache, nothing else overlaps them with
+    // the consumer. Fill the next chunk in the background meanwhile
+    if (env_ != nullptr && file_->use_direct_io()) {
+      fill_ = std::make_shared<AsyncFill>();
+      fill_->file = file_.get();
+      fill_->buffer.Alignment(alignment_);
+      fill_->buffer.AllocateNewBuffer(readahead_size_);
+    }
+  }
+
+  ~ReadaheadRandomAccessFile() {
+    if (fill_ != nullptr) {
+      CancelFill();
+    }
   }
 
   ReadaheadRandomAccessFile(const ReadaheadRandomAccessFile&) = delete;
@@ -727,23 +937,144 @@ class ReadaheadRandomAccessFile : public RandomAccessFile {
     }
     assert(IsFileSectorAligned(offset, alignment_));
     assert(IsFileSectorAligned(n, alignment_));
-    Slice result;
-    Status s = file_->Read(offset, n, &result, buffer_.BufferStart());
-    if (s.ok()) {
+    Status s;
+    if (fill_ != nullptr && fill_->offset == offset && n == readahead_size_ &&
+        WaitForFill()) {
+      // The chunk was read ahead, swap it in
+      std::swap(buffer_, fill_->buffer);
       buffer_offset_ = offset;
-      buffer_.Size(result.size());
-      assert(buffer_.BufferStart() == result.data());
+      s = fill_->status;
+      TEST_SYNC_POINT("ReadaheadRandomAccessFile::ReadIntoBuffer:FillHit");
+    } else {
+      if (fill_ != nullptr) {
+        CancelFill();
+      }
+      Slice result;
+      s = file_->Read(offset, n, &result, buffer_.BufferStart());
+      if (s.ok()) {
+        buffer_offset_ = offset;
+        buffer_.Size(result.size());
+        assert(buffer_.BufferStart() == result.data());
+      }
+    }
+    if (s.ok() && fill_ != nullptr && buffer_.CurrentSize() == readahead_size_) {
+      ScheduleFill(buffer_offset_ + buffer_.CurrentSize());
     }
     return s;
   }
 
+  // A background read of the chunk following the buffer
+  struct AsyncFill {
+    enum State { kIdle, kPending, kRunning, kDone };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    State state = kIdle;
+    RandomAccessFile* file = nullptr;
+    AlignedBuffer buffer;
+    uint64_t offset = port::kMaxUint64;
+    Status status;
+
+    // Reads the chunk, REQUIRES: state == kRunning
+    void Fill() {
+      Slice result;
+      Status s = file->Read(offset, buffer.Capacity(), &result,
+                            buffer.BufferStart());
+      std::lock_guard<std::mutex> guard(mutex);
+      status = s;
+      buffer.Size(s.ok() ? result.size() : 0);
+      state = kDone;
+      cv.notify_all();
+    }
+
+    static void BGWork(void* arg) {
+      std::unique_ptr<std::shared_ptr<AsyncFill>> holder(
+          static_cast<std::shared_ptr<AsyncFill>*>(arg));
+      AsyncFill* fill = holder->get();
+      {
+        std::lock_guard<std::mutex> guard(fill->mutex);
+        if (fill->state != kPending) {
+          // Taken over or cancelled by the owner
+          return;
+        }
+        fill->state = kRunning;
+      }
+      fill->Fill();
+    }
+
+    static void UnscheduleBGWork(void* arg) {
+      delete static_cast<std::shared_ptr<AsyncFill>*>(arg);
+    }
+  };
+
+  // Flushes and compactions are short lived next to the compaction reading
+  // this file, so their pool picks the job up soon. A job that hasn't
+  // started when its chunk is needed is taken over by the reader
+  static const Env::Priority kFillPriority = Env::Priority::HIGH;
+
+  void ScheduleFill(uint64_t offset) const {
+    {
+      std::lock_guard<std::mutex> guard(fill_->mutex);
+      assert(fill_->state == AsyncFill::kIdle ||
+             fill_->state == AsyncFill::kDone);
+      fill_->state = AsyncFill::kPending;
+      fill_->offset = offset;
+    }
+    env_->Schedule(&AsyncFill::BGWork, new std::shared_ptr<AsyncFill>(fill_),
+                   kFillPriority, fill_.get(), &AsyncFill::UnscheduleBGWork);
+  }
+
+  // Waits for the scheduled chunk, reading it here if no thread has picked
+  // it up yet. Returns false if nothing was scheduled
+  bool WaitForFill() const {
+    std::unique_lock<std::mutex> guard(fill_->mutex);
+    switch (fill_->state) {
+      case AsyncFill::kIdle:
+        return false;
+      case AsyncFill::kPending:
+        fill_->state = AsyncFill::kRunning;
+        guard.unlock();
+        env_->UnSchedule(fill_.get(), kFillPriority);
+        fill_->Fill();
+        guard.lock();
+        break;
+      case AsyncFill::kRunning:
+        fill_->cv.wait(guard, [this] {
+          return fill_->state == AsyncFill::kDone;
+        });
+        break;
+      case AsyncFill::kDone:
+        break;
+    }
+    fill_->state = AsyncFill::kIdle;
+    return true;
+  }
+
+  // Drops the scheduled chunk, waiting for it if it's being read
+  void CancelFill() const {
+    std::unique_lock<std::mutex> guard(fill_->mutex);
+    if (fill_->state == AsyncFill::kPending) {
+      fill_->state = AsyncFill::kIdle;
+      guard.unlock();
+      env_->UnSchedule(fill_.get(), kFillPriority);
+      guard.lock();
+    }
+    fill_->cv.wait(guard,
+                   [this] { return fill_->state != AsyncFill::kRunning; });
+    fill_->state = AsyncFill::kIdle;
+    fill_->offset = port::kMaxUint64;
+  }
+
   std::unique_ptr<RandomAccessFile> file_;
   const size_t alignment_;
   size_t readahead_size_;
+  Env* env_;
 
   mutable std::mutex lock_;
   mutable AlignedBuffer buffer_;
   mutable uint64_t buffer_offset_;
+  // Null unless the next chunk is read in the background
+  std::shared_ptr<AsyncFill> fill_;
 };
 
 class MemoryRandomAccessFile : public RandomAccessFile {
@@ -936,9 +1267,10 @@ bool FilePrefetchBuffer::TryReadFromCache(uint64_t offset, size_t n,
 }
 
 std::unique_ptr<RandomAccessFile> NewReadaheadRandomAccessFile(
-    std::unique_ptr<RandomAccessFile>&& file, size_t readahead_size) {
+    std::unique_ptr<RandomAccessFile>&& file, size_t readahead_size,
+    Env* env) {
   std::unique_ptr<RandomAccessFile> result(
-      new ReadaheadRandomAccessFile(std::move(file), readahead_size));
+      new ReadaheadRandomAccessFile(std::move(file), readahead_size, env));
   return result;
 }
 
@@ -24,8 +24,11 @@ namespace TERARKDB_NAMESPACE {
 class Statistics;
 class HistogramImpl;
 
+// With env set, a file using direct I/O reads the chunk following its
+// readahead buffer in the background of env
 std::unique_ptr<RandomAccessFile> NewReadaheadRandomAccessFile(
-    std::unique_ptr<RandomAccessFile>&& file, size_t readahead_size);
+    std::unique_ptr<RandomAccessFile>&& file, size_t readahead_size,
+    Env* env = nullptr);
 
 std::unique_ptr<RandomAccessFile> NewMemoryRandomAccessFile(
     std::unique_ptr<RandomAccessFile>&& file, uint64_t file_size);
@@ -113,6 +116,10 @@ class RandomAccessFileReader {
 
   Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const;
 
+  // Reads a batch of ranges through RandomAccessFile::MultiRead, see there.
+  // Falls back to one Read per request under direct I/O or a rate limiter
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) const;
+
   Status Prefetch(uint64_t offset, size_t n) const {
     return file_->Prefetch(offset, n);
   }
@@ -166,47 +173,23 @@ class WritableFileWriter {
   RateLimiter* rate_limiter_;
   Statistics* stats_;
   std::vector<std::shared_ptr<EventListener>> listeners_;
+  // Writes full buffers in the background, null unless
+  // EnvOptions::use_async_writes is set for buffered I/O
+  struct AsyncWriter;
+  std::unique_ptr<AsyncWriter> async_writer_;
 
  public:
   WritableFileWriter(
       std::unique_ptr<WritableFile>&& file, const std::string& _file_name,
       const EnvOptions& options, Statistics* stats = nullptr,
-      const std::vector<std::shared_ptr<EventListener>>& listeners = {})
-      : writable_file_(std::move(file)),
-        file_name_(_file_name),
-        buf_(),
-        max_buffer_size_(options.writable_file_max_buffer_size),
-        filesize_(0),
-#ifndef ROCKSDB_LITE
-        next_write_offset_(0),
-#endif  // ROCKSDB_LITE
-        pending_sync_(false),
-        last_sync_size_(0),
-        bytes_per_sync_(options.bytes_per_sync),
-        rate_limiter_(options.rate_limiter),
-        stats_(stats),
-        listeners_() {
-    TEST_SYNC_POINT_CALLBACK("WritableFileWriter::WritableFileWriter:0",
-                             reinterpret_cast<void*>(max_buffer_size_));
-    buf_.Alignment(writable_file_->GetRequiredBufferAlignment());
-    buf_.AllocateNewBuffer(std::min((size_t)65536, max_buffer_size_));
-#ifndef ROCKSDB_LITE
-    std::for_each(listeners.begin(), listeners.end(),
-                  [this](const std::shared_ptr<EventListener>& e) {
-                    if (e->ShouldBeNotifiedOnFileIO()) {
-                      listeners_.emplace_back(e);
-                    }
-                  });
-#else  // !ROCKSDB_LITE
-    (void)listeners;
-#endif
-  }
+      const std::vector<std::shared_ptr<EventListener>>& listeners = {},
+      MemoryAllocator* buffer_allocator = nullptr);
 
   WritableFileWriter(const WritableFileWriter&) = delete;
 
   WritableFileWriter& operator=(const WritableFileWriter&) = delete;
 
-  ~WritableFileWriter() { Close(); }
+  ~WritableFileWriter();
 
   const std::string& file_name() const { return file_name_; }
 
@@ -248,6 +231,15 @@ class WritableFileWriter {
   Status AutoRangeSync(uint64_t filesize_for_sync);
   Status RangeSync(uint64_t offset, uint64_t nbytes);
   Status SyncInternal(bool use_fsync);
+  // Background writes, see use_async_writes
+  void InitAsyncWriter();
+  // Hands buf_ over to the background thread and swaps in its spare buffer
+  Status FlushAsync();
+  // Waits for the outstanding background write, returns the first error
+  // of the background writes
+  Status WaitForAsyncWrite();
+  void StopAsyncWriter();
+  void BGWriteThread();
 };
 
 // FilePrefetchBuffer can automatically do the readahead if file_reader,
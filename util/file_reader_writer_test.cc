@@ -6,6 +6,8 @@
 #include "util/file_reader_writer.h"
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include "rocksdb/terark_namespace.h"
@@ -92,6 +94,75 @@ TEST_F(WritableFileWriterTest, RangeSync) {
   writer->Close();
 }
 
+TEST_F(WritableFileWriterTest, AsyncWrites) {
+  class FakeWF : public WritableFile {
+   public:
+    explicit FakeWF(std::string* contents, int* background_appends,
+                    uint64_t* last_synced)
+        : contents_(contents),
+          background_appends_(background_appends),
+          last_synced_(last_synced),
+          owner_(std::this_thread::get_id()) {}
+
+    Status Append(const Slice& data) override {
+      contents_->append(data.data(), data.size());
+      if (std::this_thread::get_id() != owner_) {
+        (*background_appends_)++;
+      }
+      return Status::OK();
+    }
+    Status Truncate(uint64_t /*size*/) override { return Status::OK(); }
+    Status Close() override { return Status::OK(); }
+    Status Flush() override { return Status::OK(); }
+    Status Sync() override { return Status::OK(); }
+    Status Fsync() override { return Status::OK(); }
+    uint64_t GetFileSize() override { return contents_->size(); }
+
+   protected:
+    Status RangeSync(uint64_t offset, uint64_t nbytes) override {
+      EXPECT_EQ(offset, *last_synced_);
+      EXPECT_LE(offset + nbytes + kMb, contents_->size());
+      *last_synced_ = offset + nbytes;
+      return Status::OK();
+    }
+
+    std::string* contents_;
+    int* background_appends_;
+    uint64_t* last_synced_;
+    std::thread::id owner_;
+  };
+
+  std::string contents;
+  int background_appends = 0;
+  uint64_t last_synced = 0;
+  EnvOptions env_options;
+  env_options.bytes_per_sync = kMb;
+  env_options.writable_file_max_buffer_size = 64 << 10;
+  env_options.use_async_writes = true;
+  std::unique_ptr<WritableFileWriter> writer(new WritableFileWriter(
+      std::unique_ptr<WritableFile>(
+          new FakeWF(&contents, &background_appends, &last_synced)),
+      "" /* don't care */, env_options));
+
+  Random r(301);
+  std::string expected;
+  for (int i = 0; i < 2000; i++) {
+    std::string piece = test::RandomHumanReadableString(
+        &r, static_cast<int>(r.Skewed(14)) + 1);
+    ASSERT_OK(writer->Append(piece));
+    expected.append(piece);
+    if (r.Uniform(100) == 0) {
+      ASSERT_OK(writer->Flush());
+      ASSERT_EQ(expected, contents);
+    }
+  }
+  ASSERT_EQ(expected.size(), writer->GetFileSize());
+  ASSERT_OK(writer->Close());
+  ASSERT_EQ(expected, contents);
+  ASSERT_GT(background_appends, 0);
+  ASSERT_GT(last_synced, 0u);
+}
+
 TEST_F(WritableFileWriterTest, IncrementalBuffer) {
   class FakeWF : public WritableFile {
    public:
@@ -222,6 +293,58 @@ TEST_F(WritableFileWriterTest, AppendStatusReturn) {
 }
 #endif
 
+TEST_F(WritableFileWriterTest, BufferAllocator) {
+  class CountingAllocator : public MemoryAllocator {
+   public:
+    const char* Name() const override { return "CountingAllocator"; }
+    void* Allocate(size_t size) override {
+      ++allocations;
+      return new char[size];
+    }
+    void Deallocate(void* p) override {
+      ++deallocations;
+      delete[] static_cast<char*>(p);
+    }
+    int allocations = 0;
+    int deallocations = 0;
+  };
+  class FakeWF : public WritableFile {
+   public:
+    explicit FakeWF(std::string* _file_data) : file_data_(_file_data) {}
+    Status Append(const Slice& data) override {
+      file_data_->append(data.data(), data.size());
+      return Status::OK();
+    }
+    Status Close() override { return Status::OK(); }
+    Status Flush() override { return Status::OK(); }
+    Status Sync() override { return Status::OK(); }
+
+    std::string* file_data_;
+  };
+
+  CountingAllocator allocator;
+  std::string actual;
+  std::string target;
+  {
+    EnvOptions env_options;
+    env_options.writable_file_max_buffer_size = 1024 * 1024;
+    WritableFileWriter writer(std::unique_ptr<FakeWF>(new FakeWF(&actual)),
+                              "" /* don't care */, env_options, nullptr, {},
+                              &allocator);
+    ASSERT_EQ(1, allocator.allocations);
+    // The buffer grows up to the max buffer size
+    for (int i = 0; i < 100; i++) {
+      std::string data(10000, static_cast<char>('a' + i % 26));
+      ASSERT_OK(writer.Append(data));
+      target.append(data);
+    }
+    ASSERT_GT(allocator.allocations, 1);
+    ASSERT_OK(writer.Close());
+  }
+  ASSERT_EQ(allocator.allocations, allocator.deallocations);
+  ASSERT_EQ(target, actual);
+}
+
 class ReadaheadRandomAccessFileTest
     : public testing::Test,
       public testing::WithParamInterface<size_t> {
@@ -311,6 +434,52 @@ TEST_P(ReadaheadRandomAccessFileTest, NExceedReadaheadTest) {
   }
 }
 
+TEST_P(ReadaheadRandomAccessFileTest, DirectIOReadsNextChunkInBackground) {
+  class DirectStringSource : public test::StringSource {
+   public:
+    explicit DirectStringSource(const Slice& contents)
+        : test::StringSource(contents) {}
+    bool use_direct_io() const override { return true; }
+    size_t GetRequiredBufferAlignment() const override { return 512; }
+  };
+
+  Random rng(11);
+  size_t strLen = 8 * GetReadaheadSize() +
+                  rng.Uniform(static_cast<int>(GetReadaheadSize()));
+  std::string str =
+      test::RandomHumanReadableString(&rng, static_cast<int>(strLen));
+
+  std::atomic<int> fill_hits(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "ReadaheadRandomAccessFile::ReadIntoBuffer:FillHit",
+      [&](void* /*arg*/) { fill_hits++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  std::unique_ptr<RandomAccessFile> file = NewReadaheadRandomAccessFile(
+      std::unique_ptr<RandomAccessFile>(new DirectStringSource(str)),
+      GetReadaheadSize(), Env::Default());
+  std::unique_ptr<char[]> scratch(new char[GetReadaheadSize()]);
+  // Sequential scan, then a jump back that drops the chunk read ahead
+  size_t offset = 0;
+  while (offset < strLen) {
+    size_t n = 1 + rng.Uniform(static_cast<int>(GetReadaheadSize() / 2));
+    Slice result;
+    ASSERT_OK(file->Read(offset, n, &result, scratch.get()));
+    ASSERT_EQ(str.substr(offset, std::min(n, strLen - offset)),
+              result.ToString());
+    offset += n;
+  }
+  Slice result;
+  ASSERT_OK(file->Read(3, 10, &result, scratch.get()));
+  ASSERT_EQ(str.substr(3, 10), result.ToString());
+  file.reset();
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  // Every chunk but the first came from the background read
+  ASSERT_EQ(8, fill_hits.load());
+}
+
 INSTANTIATE_TEST_CASE_P(
     EmptySourceStrTest, ReadaheadRandomAccessFileTest,
     ::testing::ValuesIn(ReadaheadRandomAccessFileTest::GetReadaheadSizeList()));
@@ -324,6 +493,9 @@ INSTANTIATE_TEST_CASE_P(
 INSTANTIATE_TEST_CASE_P(
     NExceedReadaheadTest, ReadaheadRandomAccessFileTest,
     ::testing::ValuesIn(ReadaheadRandomAccessFileTest::GetReadaheadSizeList()));
+INSTANTIATE_TEST_CASE_P(
+    DirectIOReadsNextChunkInBackground, ReadaheadRandomAccessFileTest,
+    ::testing::ValuesIn(ReadaheadRandomAccessFileTest::GetReadaheadSizeList()));
 
 }  // namespace TERARKDB_NAMESPACE
 
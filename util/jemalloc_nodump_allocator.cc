@@ -128,6 +128,37 @@ size_t JemallocNodumpAllocator::UsableSize(void* p,
                                            size_t /*allocation_size*/) const {
   return malloc_usable_size(static_cast<void*>(p));
 }
+
+Status JemallocNodumpAllocator::GetStats(MemoryAllocatorStats* stats) const {
+  // Refresh the stats jemalloc caches
+  uint64_t epoch = 1;
+  size_t epoch_size = sizeof(epoch);
+  mallctl("epoch", &epoch, &epoch_size, &epoch, epoch_size);
+
+  std::string prefix = "stats.arenas." + ToString(arena_index_) + ".";
+  size_t small_allocated = 0;
+  size_t large_allocated = 0;
+  size_t resident = 0;
+  size_t value_size = sizeof(size_t);
+  int ret = mallctl((prefix + "small.allocated").c_str(), &small_allocated,
+                    &value_size, nullptr, 0);
+  if (ret == 0) {
+    ret = mallctl((prefix + "large.allocated").c_str(), &large_allocated,
+                  &value_size, nullptr, 0);
+  }
+  if (ret == 0) {
+    ret = mallctl((prefix + "resident").c_str(), &resident, &value_size,
+                  nullptr, 0);
+  }
+  if (ret != 0) {
+    // jemalloc built without --enable-stats
+    return Status::NotSupported("Failed to read jemalloc arena stats",
+                                ToString(ret));
+  }
+  stats->allocated_bytes = small_allocated + large_allocated;
+  stats->resident_bytes = resident;
+  return Status::OK();
+}
 #endif  // ROCKSDB_JEMALLOC_NODUMP_ALLOCATOR
 
 Status NewJemallocNodumpAllocator(
@@ -164,6 +195,12 @@ Status NewJemallocNodumpAllocator(
   }
   assert(arena_index != 0);
 
+  if (!options.dont_dump) {
+    memory_allocator->reset(
+        new JemallocNodumpAllocator(options, nullptr, arena_index));
+    return Status::OK();
+  }
+
   // Read existing hooks.
   std::string key = "arena." + ToString(arena_index) + ".extent_hooks";
   extent_hooks_t* hooks;
@@ -35,6 +35,7 @@ class JemallocNodumpAllocator : public MemoryAllocator {
   void* Allocate(size_t size) override;
   void Deallocate(void* p) override;
   size_t UsableSize(void* p, size_t allocation_size) const override;
+  Status GetStats(MemoryAllocatorStats* stats) const override;
 
  private:
   friend Status NewJemallocNodumpAllocator(
@@ -65,7 +66,8 @@ class JemallocNodumpAllocator : public MemoryAllocator {
 
   const JemallocAllocatorOptions options_;
 
-  // Custom hooks has to outlive corresponding arena.
+  // Custom hooks has to outlive corresponding arena. nullptr if the arena
+  // keeps the default hooks.
   const std::unique_ptr<extent_hooks_t> arena_hooks_;
 
   // Arena index.
@@ -393,6 +393,11 @@ const LazyBufferState* LazyBufferState::cleanable_state() {
   return &static_state;
 }
 
+const LazyBufferState* LazyBufferState::cleanable_db_state() {
+  static CleanableLazyBufferState static_state;
+  return &static_state;
+}
+
 bool LazyBufferState::reserve_buffer(LazyBuffer* buffer, size_t size) {
   if (size <= sizeof(LazyBufferContext)) {
     buffer->state_ = light_state();
@@ -586,7 +591,8 @@ void LazyBuffer::pin(LazyBufferPinLevel level) {
     return;
   }
   Status s = Status::NotSupported();
-  if (level == LazyBufferPinLevel::Internal) {
+  if (level == LazyBufferPinLevel::Internal ||
+      state_ == LazyBufferState::cleanable_db_state()) {
     s = state_->pin_buffer(this);
     if (s.ok()) {
       return;
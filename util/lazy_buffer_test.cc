@@ -370,6 +370,35 @@ TEST_F(LazyBufferTest, ConstructorCleanable) {
   ASSERT_EQ(string, "empty");
 }
 
+TEST_F(LazyBufferTest, ConstructorCleanableDB) {
+  std::string string = "abc";
+  Cleanable clean(
+      [](void* arg1, void* /*arg2*/) {
+        reinterpret_cast<std::string*>(arg1)->assign("empty");
+      },
+      &string, nullptr);
+
+  LazyBuffer buffer(string, std::move(clean), LazyBufferPinLevel::DB, 2);
+  ASSERT_EQ(buffer.TEST_state(), LazyBufferState::cleanable_db_state());
+  ASSERT_EQ(buffer.file_number(), 2);
+
+  buffer.pin(LazyBufferPinLevel::DB);
+  ASSERT_EQ(buffer.TEST_state(), LazyBufferState::cleanable_db_state());
+  ASSERT_EQ(buffer.data(), string.data());
+  ASSERT_EQ(string, "abc");
+
+  LazyBuffer other;
+  other.reset(string, Cleanable(), LazyBufferPinLevel::Internal, 3);
+  ASSERT_EQ(other.TEST_state(), LazyBufferState::cleanable_state());
+  other.pin(LazyBufferPinLevel::DB);
+  ASSERT_NE(other.data(), string.data());
+  ASSERT_EQ(other.slice(), "abc");
+
+  buffer.clear();
+  ASSERT_EQ(string, "empty");
+  ASSERT_EQ(other.slice(), "abc");
+}
+
 TEST_F(LazyBufferTest, ConstructorCustomizeState) {
   class CustomizeLazyBufferState : public LazyBufferState {
    public:
@@ -0,0 +1,106 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/threadpool.h"
+#include "util/mutexlock.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// The items of a ParallelFor call, claimed one at a time by the caller and
+// the jobs it scheduled
+class ParallelForState {
+ public:
+  ParallelForState(size_t n, const std::function<void(size_t)>* fn)
+      : n_(n), fn_(fn), cv_(&mutex_) {}
+
+  // Runs the items not started yet, returns when there is none left
+  void Run() {
+    mutex_.Lock();
+    while (next_ < n_) {
+      size_t i = next_++;
+      ++running_;
+      mutex_.Unlock();
+      (*fn_)(i);
+      mutex_.Lock();
+      if (--running_ == 0) {
+        cv_.SignalAll();
+      }
+    }
+    mutex_.Unlock();
+  }
+
+  // Runs the items not started yet, then waits for the running ones
+  void RunAndWait() {
+    Run();
+    MutexLock l(&mutex_);
+    while (running_ > 0) {
+      cv_.Wait();
+    }
+  }
+
+ private:
+  const size_t n_;
+  // Only called while the caller waits, the jobs left in the queue
+  // afterwards find no item and never touch it
+  const std::function<void(size_t)>* fn_;
+  port::Mutex mutex_;
+  port::CondVar cv_;
+  size_t next_ = 0;
+  size_t running_ = 0;
+};
+
+// Runs fn(i) for every i in [0, n), on the calling thread and on up to
+// n - 1 jobs of the pri thread pool of env. The calling thread takes every
+// item no pool thread has started yet, so it never waits on a queued job
+// and a busy pool only costs parallelism. Returns once every fn(i) did.
+inline void ParallelForInEnv(Env* env, Env::Priority pri, size_t n,
+                             const std::function<void(size_t)>& fn) {
+  if (n <= 1) {
+    if (n == 1) {
+      fn(0);
+    }
+    return;
+  }
+  auto state = std::make_shared<ParallelForState>(n, &fn);
+  for (size_t i = 1; i < n; ++i) {
+    env->Schedule(
+        [](void* arg) {
+          auto* job = static_cast<std::shared_ptr<ParallelForState>*>(arg);
+          (*job)->Run();
+          delete job;
+        },
+        new std::shared_ptr<ParallelForState>(state), pri, nullptr,
+        [](void* arg) {
+          delete static_cast<std::shared_ptr<ParallelForState>*>(arg);
+        });
+  }
+  state->RunAndWait();
+}
+
+// Same as ParallelForInEnv, with the jobs submitted to pool
+inline void ParallelForInPool(ThreadPool* pool, size_t n,
+                              const std::function<void(size_t)>& fn) {
+  if (n <= 1) {
+    if (n == 1) {
+      fn(0);
+    }
+    return;
+  }
+  auto state = std::make_shared<ParallelForState>(n, &fn);
+  for (size_t i = 1; i < n; ++i) {
+    pool->SubmitJob([state] { state->Run(); });
+  }
+  state->RunAndWait();
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -69,22 +69,21 @@ GenericRateLimiter::GenericRateLimiter(int64_t rate_bytes_per_sec,
       prev_num_drains_(0),
       max_bytes_per_sec_(rate_bytes_per_sec),
       tuned_time_(NowMicrosMonotonic(env_)) {
-  total_requests_[0] = 0;
-  total_requests_[1] = 0;
-  total_bytes_through_[0] = 0;
-  total_bytes_through_[1] = 0;
+  for (int i = Env::IO_LOW; i < Env::IO_TOTAL; ++i) {
+    total_requests_[i] = 0;
+    total_bytes_through_[i] = 0;
+  }
 }
 
 GenericRateLimiter::~GenericRateLimiter() {
   MutexLock g(&request_mutex_);
   stop_ = true;
-  requests_to_wait_ = static_cast<int32_t>(queue_[Env::IO_LOW].size() +
-                                           queue_[Env::IO_HIGH].size());
-  for (auto& r : queue_[Env::IO_HIGH]) {
-    r->cv.Signal();
-  }
-  for (auto& r : queue_[Env::IO_LOW]) {
-    r->cv.Signal();
+  requests_to_wait_ = 0;
+  for (int i = Env::IO_TOTAL - 1; i >= Env::IO_LOW; --i) {
+    requests_to_wait_ += static_cast<int32_t>(queue_[i].size());
+    for (auto& r : queue_[i]) {
+      r->cv.Signal();
+    }
   }
   while (requests_to_wait_ > 0) {
     exit_cv_.Wait();
@@ -122,6 +121,10 @@ void GenericRateLimiter::Request(int64_t bytes, const Env::IOPriority pri,
   }
 
   ++total_requests_[pri];
+  static const Tickers kPriBytesTicker[Env::IO_TOTAL] = {
+      RATE_LIMITER_LOW_PRI_BYTES, RATE_LIMITER_MID_PRI_BYTES,
+      RATE_LIMITER_HIGH_PRI_BYTES};
+  RecordTick(stats, kPriBytesTicker[pri], bytes);
 
   if (available_bytes_ >= bytes) {
     // Refill thread assigns quota and notifies requests waiting on
@@ -144,10 +147,7 @@ void GenericRateLimiter::Request(int64_t bytes, const Env::IOPriority pri,
     //     to lower priority
     // (3) a previous waiter at the front of queue, who got notified by
     //     previous leader
-    if (leader_ == nullptr &&
-        ((!queue_[Env::IO_HIGH].empty() &&
-          &r == queue_[Env::IO_HIGH].front()) ||
-         (!queue_[Env::IO_LOW].empty() && &r == queue_[Env::IO_LOW].front()))) {
+    if (leader_ == nullptr && &r == queue_[pri].front()) {
       leader_ = &r;
       int64_t delta = next_refill_us_ - NowMicrosMonotonic(env_);
       delta = delta > 0 ? delta : 0;
@@ -172,15 +172,8 @@ void GenericRateLimiter::Request(int64_t bytes, const Env::IOPriority pri,
     }
 
     // Make sure the waken up request is always the header of its queue
-    assert(
-        r.granted ||
-        (!queue_[Env::IO_HIGH].empty() && &r == queue_[Env::IO_HIGH].front()) ||
-        (!queue_[Env::IO_LOW].empty() && &r == queue_[Env::IO_LOW].front()));
-    assert(leader_ == nullptr ||
-           (!queue_[Env::IO_HIGH].empty() &&
-            leader_ == queue_[Env::IO_HIGH].front()) ||
-           (!queue_[Env::IO_LOW].empty() &&
-            leader_ == queue_[Env::IO_LOW].front()));
+    assert(r.granted || &r == queue_[pri].front());
+    assert(leader_ == nullptr || IsFrontOfAnyQueue(leader_));
 
     if (leader_ == &r) {
       // Waken up from TimedWait()
@@ -196,15 +189,8 @@ void GenericRateLimiter::Request(int64_t bytes, const Env::IOPriority pri,
         if (r.granted) {
           // Current leader already got granted with quota. Notify header
           // of waiting queue to participate next round of election.
-          assert((queue_[Env::IO_HIGH].empty() ||
-                  &r != queue_[Env::IO_HIGH].front()) &&
-                 (queue_[Env::IO_LOW].empty() ||
-                  &r != queue_[Env::IO_LOW].front()));
-          if (!queue_[Env::IO_HIGH].empty()) {
-            queue_[Env::IO_HIGH].front()->cv.Signal();
-          } else if (!queue_[Env::IO_LOW].empty()) {
-            queue_[Env::IO_LOW].front()->cv.Signal();
-          }
+          assert(!IsFrontOfAnyQueue(&r));
+          SignalFrontOfQueues();
           // Done
           break;
         }
@@ -236,9 +222,9 @@ void GenericRateLimiter::Refill() {
     available_bytes_ += refill_bytes_per_period;
   }
 
-  int use_low_pri_first = rnd_.OneIn(fairness_) ? 0 : 1;
-  for (int q = 0; q < 2; ++q) {
-    auto use_pri = (use_low_pri_first == q) ? Env::IO_LOW : Env::IO_HIGH;
+  Env::IOPriority pri_iteration_order[Env::IO_TOTAL];
+  GeneratePriorityIterationOrder(pri_iteration_order);
+  for (auto use_pri : pri_iteration_order) {
     auto* queue = &queue_[use_pri];
     while (!queue->empty()) {
       auto* next_req = queue->front();
@@ -262,6 +248,40 @@ void GenericRateLimiter::Refill() {
   }
 }
 
+void GenericRateLimiter::GeneratePriorityIterationOrder(
+    Env::IOPriority (&pri_iteration_order)[Env::IO_TOTAL]) {
+  // Insertion from the highest priority down, a lower priority jumps over
+  // each higher one that is already placed by 1/fairness chance
+  int n = 0;
+  for (int i = Env::IO_TOTAL - 1; i >= Env::IO_LOW; --i) {
+    int pos = n;
+    while (pos > 0 && rnd_.OneIn(fairness_)) {
+      pri_iteration_order[pos] = pri_iteration_order[pos - 1];
+      --pos;
+    }
+    pri_iteration_order[pos] = static_cast<Env::IOPriority>(i);
+    ++n;
+  }
+}
+
+bool GenericRateLimiter::IsFrontOfAnyQueue(const Req* r) const {
+  for (int i = Env::IO_LOW; i < Env::IO_TOTAL; ++i) {
+    if (!queue_[i].empty() && r == queue_[i].front()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void GenericRateLimiter::SignalFrontOfQueues() {
+  for (int i = Env::IO_TOTAL - 1; i >= Env::IO_LOW; --i) {
+    if (!queue_[i].empty()) {
+      queue_[i].front()->cv.Signal();
+      return;
+    }
+  }
+}
+
 int64_t GenericRateLimiter::CalculateRefillBytesPerPeriod(
     int64_t rate_bytes_per_sec) {
   if (port::kMaxInt64 / rate_bytes_per_sec < refill_period_us_) {
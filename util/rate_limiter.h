@@ -49,8 +49,11 @@ class GenericRateLimiter : public RateLimiter {
       const Env::IOPriority pri = Env::IO_TOTAL) const override {
     MutexLock g(&request_mutex_);
     if (pri == Env::IO_TOTAL) {
-      return total_bytes_through_[Env::IO_LOW] +
-             total_bytes_through_[Env::IO_HIGH];
+      int64_t total_bytes_through_sum = 0;
+      for (int i = Env::IO_LOW; i < Env::IO_TOTAL; ++i) {
+        total_bytes_through_sum += total_bytes_through_[i];
+      }
+      return total_bytes_through_sum;
     }
     return total_bytes_through_[pri];
   }
@@ -59,7 +62,11 @@ class GenericRateLimiter : public RateLimiter {
       const Env::IOPriority pri = Env::IO_TOTAL) const override {
     MutexLock g(&request_mutex_);
     if (pri == Env::IO_TOTAL) {
-      return total_requests_[Env::IO_LOW] + total_requests_[Env::IO_HIGH];
+      int64_t total_requests_sum = 0;
+      for (int i = Env::IO_LOW; i < Env::IO_TOTAL; ++i) {
+        total_requests_sum += total_requests_[i];
+      }
+      return total_requests_sum;
     }
     return total_requests_[pri];
   }
@@ -69,7 +76,16 @@ class GenericRateLimiter : public RateLimiter {
   }
 
  private:
+  struct Req;
+
   void Refill();
+  // Queues are served from the highest priority down, but each lower
+  // priority is moved ahead of the higher ones by 1/fairness chance
+  void GeneratePriorityIterationOrder(
+      Env::IOPriority (&pri_iteration_order)[Env::IO_TOTAL]);
+  bool IsFrontOfAnyQueue(const Req* r) const;
+  // Signals the head of the highest priority non-empty queue
+  void SignalFrontOfQueues();
   int64_t CalculateRefillBytesPerPeriod(int64_t rate_bytes_per_sec);
   Status Tune();
 
@@ -101,7 +117,6 @@ class GenericRateLimiter : public RateLimiter {
   int32_t fairness_;
   Random rnd_;
 
-  struct Req;
   Req* leader_;
   std::deque<Req*> queue_[Env::IO_TOTAL];
 
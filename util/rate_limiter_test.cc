@@ -65,6 +65,29 @@ TEST_F(RateLimiterTest, Modes) {
   }
 }
 
+TEST_F(RateLimiterTest, Priorities) {
+  std::shared_ptr<Statistics> stats = CreateDBStatistics();
+  GenericRateLimiter limiter(
+      2000 /* rate_bytes_per_sec */, 1000 * 1000 /* refill_period_us */,
+      10 /* fairness */, RateLimiter::Mode::kAllIo, Env::Default(),
+      false /* auto_tuned */);
+  limiter.Request(100 /* bytes */, Env::IO_LOW, stats.get(),
+                  RateLimiter::OpType::kWrite);
+  limiter.Request(200 /* bytes */, Env::IO_MID, stats.get(),
+                  RateLimiter::OpType::kWrite);
+  limiter.Request(300 /* bytes */, Env::IO_HIGH, stats.get(),
+                  RateLimiter::OpType::kWrite);
+  ASSERT_EQ(100, limiter.GetTotalBytesThrough(Env::IO_LOW));
+  ASSERT_EQ(200, limiter.GetTotalBytesThrough(Env::IO_MID));
+  ASSERT_EQ(300, limiter.GetTotalBytesThrough(Env::IO_HIGH));
+  ASSERT_EQ(600, limiter.GetTotalBytesThrough());
+  ASSERT_EQ(1, limiter.GetTotalRequests(Env::IO_MID));
+  ASSERT_EQ(3, limiter.GetTotalRequests());
+  ASSERT_EQ(100, stats->getTickerCount(RATE_LIMITER_LOW_PRI_BYTES));
+  ASSERT_EQ(200, stats->getTickerCount(RATE_LIMITER_MID_PRI_BYTES));
+  ASSERT_EQ(300, stats->getTickerCount(RATE_LIMITER_HIGH_PRI_BYTES));
+}
+
 #if !(defined(TRAVIS) && defined(OS_MACOSX))
 TEST_F(RateLimiterTest, Rate) {
   auto* env = Env::Default();
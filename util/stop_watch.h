@@ -23,7 +23,9 @@ class StopWatch {
         elapsed_(elapsed),
         hist_type_(hist_type),
         overwrite_(overwrite),
-        stats_enabled_(statistics && statistics->HistEnabledForType(hist_type)),
+        stats_enabled_(statistics &&
+                       statistics->HistEnabledForType(hist_type) &&
+                       (elapsed != nullptr || TimerSampled(statistics))),
         delay_enabled_(delay_enabled),
         total_delay_(0),
         delay_start_time_(0),
@@ -71,6 +73,22 @@ class StopWatch {
   uint64_t start_time() const { return start_time_; }
 
  private:
+  static bool TimerSampled(const Statistics* statistics) {
+    uint32_t rate = statistics->timer_sample_rate_;
+    if (LIKELY(rate <= 1)) {
+      return true;
+    }
+#ifdef ROCKSDB_SUPPORT_THREAD_LOCAL
+    static __thread uint32_t timer_sample_count = 0;
+    return ++timer_sample_count % rate == 0;
+#else
+    static std::atomic<uint32_t> timer_sample_count(0);
+    return (timer_sample_count.fetch_add(1, std::memory_order_relaxed) + 1) %
+               rate ==
+           0;
+#endif
+  }
+
   Env* const env_;
   Statistics* statistics_;
   uint64_t* elapsed_;
@@ -83,6 +101,36 @@ class StopWatch {
   const uint64_t start_time_;
 };
 
+// Adds the wall and CPU nano seconds from construction to destruction,
+// multiplied by scale, to *wall_nanos and *cpu_nanos. Timing a sample of
+// 1/scale calls estimates the total. Does nothing if env is nullptr.
+class PhaseStopWatch {
+ public:
+  PhaseStopWatch(Env* const env, uint64_t* wall_nanos, uint64_t* cpu_nanos,
+                 uint64_t scale = 1)
+      : env_(env),
+        wall_nanos_(wall_nanos),
+        cpu_nanos_(cpu_nanos),
+        scale_(scale),
+        wall_start_(env != nullptr ? env->NowNanos() : 0),
+        cpu_start_(env != nullptr ? env->NowCPUNanos() : 0) {}
+
+  ~PhaseStopWatch() {
+    if (env_ != nullptr) {
+      *wall_nanos_ += (env_->NowNanos() - wall_start_) * scale_;
+      *cpu_nanos_ += (env_->NowCPUNanos() - cpu_start_) * scale_;
+    }
+  }
+
+ private:
+  Env* const env_;
+  uint64_t* wall_nanos_;
+  uint64_t* cpu_nanos_;
+  const uint64_t scale_;
+  const uint64_t wall_start_;
+  const uint64_t cpu_start_;
+};
+
 // a nano second precision stopwatch
 class StopWatchNano {
  public:
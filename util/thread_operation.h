@@ -66,6 +66,13 @@ static OperationStageInfo global_op_stage_table[] = {
      "MemTableList::RollbackMemtableFlush"},
     {ThreadStatus::STAGE_MEMTABLE_INSTALL_FLUSH_RESULTS,
      "MemTableList::TryInstallMemtableFlushResults"},
+    {ThreadStatus::STAGE_GARBAGE_COLLECTION,
+     "CompactionJob::ProcessGarbageCollection"},
+    {ThreadStatus::STAGE_MAP_SST_BUILD, "MapBuilder::WriteOutputFile"},
+    {ThreadStatus::STAGE_TERARK_ZIP_VALUES,
+     "TerarkZipTableBuilder::ZipValueToFinish"},
+    {ThreadStatus::STAGE_TERARK_ZIP_WRITE_SST,
+     "TerarkZipTableBuilder::WriteSSTFile"},
 };
 
 // The structure that describes a state.
@@ -96,12 +103,16 @@ static OperationProperty compaction_operation_properties[] = {
     {ThreadStatus::COMPACTION_TOTAL_INPUT_BYTES, "TotalInputBytes"},
     {ThreadStatus::COMPACTION_BYTES_READ, "BytesRead"},
     {ThreadStatus::COMPACTION_BYTES_WRITTEN, "BytesWritten"},
+    {ThreadStatus::COMPACTION_PROGRESS_BYTES_DONE, "ProgressBytesDone"},
+    {ThreadStatus::COMPACTION_PROGRESS_BYTES_TOTAL, "ProgressBytesTotal"},
 };
 
 static OperationProperty flush_operation_properties[] = {
     {ThreadStatus::FLUSH_JOB_ID, "JobID"},
     {ThreadStatus::FLUSH_BYTES_MEMTABLES, "BytesMemtables"},
-    {ThreadStatus::FLUSH_BYTES_WRITTEN, "BytesWritten"}};
+    {ThreadStatus::FLUSH_BYTES_WRITTEN, "BytesWritten"},
+    {ThreadStatus::FLUSH_PROGRESS_BYTES_DONE, "ProgressBytesDone"},
+    {ThreadStatus::FLUSH_PROGRESS_BYTES_TOTAL, "ProgressBytesTotal"}};
 
 #else
 
@@ -8,6 +8,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -47,6 +48,34 @@ class Timer {
         running_(false),
         executing_task_(false) {}
   ~Timer() { Shutdown(); }
+
+  // The started timer of env, shared by the periodic work of all the DB
+  // instances and utilities on it, so that their mostly idle tasks cost one
+  // thread instead of one each. It shuts down when its last holder releases
+  // it, so env only has to outlive the holders. The owners of tasks must pick
+  // names unique in the process and cancel them.
+  static std::shared_ptr<Timer> Shared(Env* env) {
+    static std::mutex mutex;
+    // Leaked, holders may still release their timer during static destruction
+    static auto* timers = new std::unordered_map<Env*, std::weak_ptr<Timer>>;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Timer> timer = (*timers)[env].lock();
+    if (timer == nullptr) {
+      // Forget the released timers, a new env may reuse the address of theirs
+      for (auto it = timers->begin(); it != timers->end();) {
+        if (it->second.expired()) {
+          it = timers->erase(it);
+        } else {
+          ++it;
+        }
+      }
+      timer = std::make_shared<Timer>(env);
+      timer->Start();
+      (*timers)[env] = timer;
+    }
+    return timer;
+  }
+
   // Add a new function to run.
   // fn_name has to be identical, otherwise, the new one overrides the existing
   // one, regardless if the function is pending removed (invalid) or not.
@@ -343,6 +343,36 @@ TEST_F(TimerTest, RepeatIntervalWithFuncRunningTime) {
 
   ASSERT_TRUE(timer.Shutdown());
 }
+
+TEST_F(TimerTest, SharedPerEnv) {
+  std::unique_ptr<MockTimeEnv> env(new MockTimeEnv(Env::Default()));
+  std::shared_ptr<Timer> timer = Timer::Shared(env.get());
+  ASSERT_EQ(timer, Timer::Shared(env.get()));
+  ASSERT_NE(timer, Timer::Shared(Env::Default()));
+  // Already started
+  ASSERT_FALSE(timer->Start());
+
+  int count = 0;
+  timer->Add([&] { count++; }, "fn_shared_test", kUsPerSec, kUsPerSec);
+  timer->TEST_WaitForRun([&] { env->MockSleepForMicroseconds(kUsPerSec); });
+  ASSERT_EQ(1, count);
+  timer->TEST_WaitForRun([&] { env->MockSleepForMicroseconds(kUsPerSec); });
+  ASSERT_EQ(2, count);
+
+  timer->Cancel("fn_shared_test");
+  ASSERT_FALSE(timer->HasPendingTask());
+
+  // Shut down with its last holder, before its env
+  std::weak_ptr<Timer> released = timer;
+  timer.reset();
+  ASSERT_TRUE(released.expired());
+  // A new env, may be at the same address, gets a new timer
+  env.reset(new MockTimeEnv(Env::Default()));
+  timer = Timer::Shared(env.get());
+  ASSERT_FALSE(timer->Start());
+  ASSERT_EQ(0U, timer->TEST_GetPendingTaskNum());
+  timer.reset();
+}
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -10,11 +10,15 @@
 #include <thread>
 
 #include "db/db_impl.h"
+#include "rocksdb/iostats_context.h"
+#include "rocksdb/perf_context.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/write_batch.h"
 #include "util/coding.h"
+#include "util/hash.h"
 #include "util/string_util.h"
+#include "util/xxhash.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -31,6 +35,82 @@ void DecodeCFAndKey(std::string& buffer, uint32_t* cf_id, Slice* key) {
   GetFixed32(&buf, cf_id);
   GetLengthPrefixedSlice(&buf, key);
 }
+
+bool DecodeMultiGet(const std::string& buffer, std::vector<uint32_t>* cf_ids,
+                    std::vector<Slice>* keys) {
+  Slice buf(buffer);
+  uint32_t count = 0;
+  if (!GetFixed32(&buf, &count)) {
+    return false;
+  }
+  cf_ids->resize(count);
+  keys->resize(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!GetFixed32(&buf, &(*cf_ids)[i]) ||
+        !GetLengthPrefixedSlice(&buf, &(*keys)[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Stops at the first key of a WriteBatch
+class FirstKeyHandler : public WriteBatch::Handler {
+ public:
+  virtual Status PutCF(uint32_t /*cf_id*/, const Slice& key,
+                       const Slice& /*value*/) override {
+    return SetKey(key);
+  }
+  virtual Status DeleteCF(uint32_t /*cf_id*/, const Slice& key) override {
+    return SetKey(key);
+  }
+  virtual Status SingleDeleteCF(uint32_t /*cf_id*/, const Slice& key) override {
+    return SetKey(key);
+  }
+  virtual Status DeleteRangeCF(uint32_t /*cf_id*/, const Slice& begin_key,
+                               const Slice& /*end_key*/) override {
+    return SetKey(begin_key);
+  }
+  virtual Status MergeCF(uint32_t /*cf_id*/, const Slice& key,
+                         const Slice& /*value*/) override {
+    return SetKey(key);
+  }
+  virtual bool Continue() override { return !found; }
+
+  Slice key;
+  bool found = false;
+
+ private:
+  Status SetKey(const Slice& k) {
+    key = k;
+    found = true;
+    return Status::OK();
+  }
+};
+
+const char* TraceTypeName(TraceType type) {
+  switch (type) {
+    case kTraceWrite:
+      return "Write";
+    case kTraceGet:
+      return "Get";
+    case kTraceMultiGet:
+      return "MultiGet";
+    case kTraceIteratorSeek:
+      return "IteratorSeek";
+    case kTraceIteratorSeekForPrev:
+      return "IteratorSeekForPrev";
+    default:
+      return "Unknown";
+  }
+}
+
+void EncodeTrace(const Trace& trace, std::string* dst) {
+  PutFixed64(dst, trace.ts);
+  dst->push_back(trace.type);
+  PutFixed32(dst, static_cast<uint32_t>(trace.payload.size()));
+  dst->append(trace.payload);
+}
 }  // namespace
 
 Tracer::Tracer(Env* env, const TraceOptions& trace_options,
@@ -65,6 +145,22 @@ Status Tracer::Get(ColumnFamilyHandle* column_family, const Slice& key) {
   return WriteTrace(trace);
 }
 
+Status Tracer::MultiGet(
+    const std::vector<ColumnFamilyHandle*>& column_families,
+    const std::vector<Slice>& keys) {
+  if (IsTraceFileOverMax()) {
+    return Status::OK();
+  }
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = kTraceMultiGet;
+  PutFixed32(&trace.payload, static_cast<uint32_t>(keys.size()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EncodeCFAndKey(&trace.payload, column_families[i]->GetID(), keys[i]);
+  }
+  return WriteTrace(trace);
+}
+
 Status Tracer::IteratorSeek(const uint32_t& cf_id, const Slice& key) {
   if (IsTraceFileOverMax()) {
     return Status::OK();
@@ -117,18 +213,283 @@ Status Tracer::WriteFooter() {
 
 Status Tracer::WriteTrace(const Trace& trace) {
   std::string encoded_trace;
-  PutFixed64(&encoded_trace, trace.ts);
-  encoded_trace.push_back(trace.type);
-  PutFixed32(&encoded_trace, static_cast<uint32_t>(trace.payload.size()));
-  encoded_trace.append(trace.payload);
+  EncodeTrace(trace, &encoded_trace);
   return trace_writer_->Write(Slice(encoded_trace));
 }
 
 Status Tracer::Close() { return WriteFooter(); }
 
+PerfTracer::PerfTracer(Env* env, const PerfTraceOptions& options,
+                       std::unique_ptr<TraceWriter>&& trace_writer)
+    : env_(env),
+      options_(options),
+      trace_writer_(std::move(trace_writer)),
+      closing_(false) {
+  std::ostringstream s;
+  s << kTraceMagic << "\t"
+    << "Trace Version: 0.1\t"
+    << "RocksDB Version: " << kMajorVersion << "." << kMinorVersion << "\t"
+    << "Format: Timestamp OpType Payload\t"
+    << "Perf Sample Rate: " << options_.sample_rate << "\n";
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = kTraceBegin;
+  trace.payload = s.str();
+  status_ = WriteTrace(trace);
+  thread_ = std::thread(&PerfTracer::BGWork, this);
+}
+
+PerfTracer::~PerfTracer() { Close(); }
+
+bool PerfTracer::Sampled(uint32_t sample_rate) {
+#ifdef ROCKSDB_SUPPORT_THREAD_LOCAL
+  static __thread uint32_t sample_count = 0;
+  return ++sample_count % sample_rate == 0;
+#else
+  static std::atomic<uint32_t> sample_count(0);
+  return (sample_count.fetch_add(1, std::memory_order_relaxed) + 1) %
+             sample_rate ==
+         0;
+#endif
+}
+
+void PerfTracer::Add(PerfTraceOp op, uint32_t cf_id, uint64_t latency_micros) {
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = kTracePerfSample;
+  trace.payload.push_back(op);
+  PutFixed32(&trace.payload, cf_id);
+  PutFixed64(&trace.payload, latency_micros);
+  PutLengthPrefixedSlice(&trace.payload, get_perf_context()->ToString(true));
+  PutLengthPrefixedSlice(&trace.payload,
+                         get_iostats_context()->ToString(true));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closing_ || pending_.size() >= options_.max_pending_samples) {
+    return;
+  }
+  pending_.emplace_back(std::move(trace));
+  cv_.notify_one();
+}
+
+void PerfTracer::BGWork() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return closing_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      break;
+    }
+    Trace trace = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    Status s;
+    if (trace_writer_->GetFileSize() <= options_.max_trace_file_size) {
+      s = WriteTrace(trace);
+    }
+    lock.lock();
+    if (status_.ok()) {
+      status_ = s;
+    }
+  }
+}
+
+Status PerfTracer::WriteTrace(const Trace& trace) {
+  std::string encoded_trace;
+  EncodeTrace(trace, &encoded_trace);
+  return trace_writer_->Write(Slice(encoded_trace));
+}
+
+Status PerfTracer::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) {
+      return status_;
+    }
+    closing_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = kTraceEnd;
+  Status s = WriteTrace(trace);
+  if (status_.ok()) {
+    status_ = s;
+  }
+  return status_;
+}
+
+Status PerfTracer::DecodeSample(const Trace& trace, PerfTraceOp* op,
+                                uint32_t* cf_id, uint64_t* latency_micros,
+                                std::string* perf_context,
+                                std::string* iostats_context) {
+  Slice buf(trace.payload);
+  Slice perf, iostats;
+  if (trace.type != kTracePerfSample || buf.empty()) {
+    return Status::Corruption("Not a perf trace sample");
+  }
+  *op = static_cast<PerfTraceOp>(buf[0]);
+  buf.remove_prefix(1);
+  if (!GetFixed32(&buf, cf_id) || !GetFixed64(&buf, latency_micros) ||
+      !GetLengthPrefixedSlice(&buf, &perf) ||
+      !GetLengthPrefixedSlice(&buf, &iostats)) {
+    return Status::Corruption("Corrupted perf trace sample");
+  }
+  perf_context->assign(perf.data(), perf.size());
+  iostats_context->assign(iostats.data(), iostats.size());
+  return Status::OK();
+}
+
+PerfTraceScope::PerfTraceScope(DBImpl* db, PerfTraceOp op, uint32_t cf_id)
+    : env_(nullptr),
+      op_(op),
+      cf_id_(cf_id),
+      prev_perf_level_(PerfLevel::kDisable),
+      prev_per_level_perf_context_(false),
+      start_micros_(0) {
+  if (db == nullptr) {
+    return;
+  }
+  uint32_t sample_rate =
+      db->perf_trace_sample_rate_.load(std::memory_order_relaxed);
+  if (sample_rate == 0 || GetPerfLevel() > PerfLevel::kEnableCount ||
+      !PerfTracer::Sampled(sample_rate)) {
+    return;
+  }
+  {
+    InstrumentedMutexLock lock(&db->trace_mutex_);
+    tracer_ = db->perf_tracer_;
+  }
+  if (tracer_ == nullptr) {
+    return;
+  }
+  env_ = db->env_;
+  prev_perf_level_ = GetPerfLevel();
+  SetPerfLevel(PerfLevel::kEnableTimeExceptForMutex);
+  auto perf_context = get_perf_context();
+  prev_per_level_perf_context_ = perf_context->per_level_perf_context_enabled;
+  perf_context->Reset();
+  perf_context->EnablePerLevelPerfContext();
+  get_iostats_context()->Reset();
+  start_micros_ = env_->NowMicros();
+}
+
+PerfTraceScope::~PerfTraceScope() {
+  if (tracer_ == nullptr) {
+    return;
+  }
+  tracer_->Add(op_, cf_id_, env_->NowMicros() - start_micros_);
+  if (!prev_per_level_perf_context_) {
+    get_perf_context()->DisablePerLevelPerfContext();
+  }
+  SetPerfLevel(prev_perf_level_);
+}
+
+TableAccessTracer::TableAccessTracer() : tracing_(false), env_(nullptr) {}
+
+TableAccessTracer::~TableAccessTracer() { EndTrace(); }
+
+Status TableAccessTracer::StartTrace(
+    Env* env, const TableAccessTraceOptions& options,
+    std::unique_ptr<TraceWriter>&& trace_writer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (trace_writer_ != nullptr) {
+    return Status::Busy("A table access trace is running");
+  }
+  env_ = env;
+  options_ = options;
+  trace_writer_ = std::move(trace_writer);
+  std::ostringstream s;
+  s << kTraceMagic << "\t"
+    << "Trace Version: 0.1\t"
+    << "RocksDB Version: " << kMajorVersion << "." << kMinorVersion << "\t"
+    << "Format: Timestamp OpType Payload\t"
+    << "Sampling Frequency: " << options_.sampling_frequency << "\n";
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = kTraceBegin;
+  trace.payload = s.str();
+  Status st = WriteTrace(trace);
+  if (!st.ok()) {
+    trace_writer_.reset();
+    return st;
+  }
+  // Publishes options_ to the readers checking IsTracing()
+  tracing_.store(true, std::memory_order_release);
+  return st;
+}
+
+Status TableAccessTracer::EndTrace() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (trace_writer_ == nullptr) {
+    return Status::NotFound("No table access trace is running");
+  }
+  tracing_.store(false, std::memory_order_relaxed);
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = kTraceEnd;
+  Status s = WriteTrace(trace);
+  trace_writer_.reset();
+  return s;
+}
+
+void TableAccessTracer::Add(TableAccessType type, TableAccessCaller caller,
+                            uint64_t file_number, uint64_t record,
+                            uint64_t size, bool is_cache_hit) {
+  if (!IsTracing()) {
+    return;
+  }
+  char id[16];
+  EncodeFixed64(id, file_number);
+  EncodeFixed64(id + 8, record);
+  if (options_.sampling_frequency > 1 &&
+      XXH64(id, sizeof(id), 0) % options_.sampling_frequency != 0) {
+    return;
+  }
+  Trace trace;
+  trace.type = kTraceTableAccess;
+  trace.payload.push_back(type);
+  trace.payload.push_back(caller);
+  trace.payload.push_back(is_cache_hit ? 1 : 0);
+  trace.payload.append(id, sizeof(id));
+  PutFixed64(&trace.payload, size);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (trace_writer_ == nullptr ||
+      trace_writer_->GetFileSize() > options_.max_trace_file_size) {
+    return;
+  }
+  trace.ts = env_->NowMicros();
+  WriteTrace(trace);
+}
+
+Status TableAccessTracer::WriteTrace(const Trace& trace) {
+  std::string encoded_trace;
+  EncodeTrace(trace, &encoded_trace);
+  return trace_writer_->Write(Slice(encoded_trace));
+}
+
+Status TableAccessTracer::DecodeAccess(const Trace& trace,
+                                       TableAccessRecord* record) {
+  Slice buf(trace.payload);
+  if (trace.type != kTraceTableAccess || buf.size() < 3) {
+    return Status::Corruption("Not a table access trace");
+  }
+  record->access_timestamp = trace.ts;
+  record->type = static_cast<TableAccessType>(buf[0]);
+  record->caller = static_cast<TableAccessCaller>(buf[1]);
+  record->is_cache_hit = buf[2] != 0;
+  buf.remove_prefix(3);
+  if (!GetFixed64(&buf, &record->file_number) ||
+      !GetFixed64(&buf, &record->record) || !GetFixed64(&buf, &record->size)) {
+    return Status::Corruption("Corrupted table access trace");
+  }
+  return Status::OK();
+}
+
 Replayer::Replayer(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
                    std::unique_ptr<TraceReader>&& reader)
-    : trace_reader_(std::move(reader)) {
+    : trace_reader_(std::move(reader)), fast_forward_(1.0) {
   assert(db != nullptr);
   db_ = static_cast<DBImpl*>(db->GetRootDB());
   for (ColumnFamilyHandle* cfh : handles) {
@@ -138,6 +499,14 @@ Replayer::Replayer(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
 
 Replayer::~Replayer() { trace_reader_.reset(); }
 
+Status Replayer::SetFastForward(double fast_forward) {
+  if (!(fast_forward > 0.0)) {
+    return Status::InvalidArgument("Fast forward must be positive.");
+  }
+  fast_forward_ = fast_forward;
+  return Status::OK();
+}
+
 Status Replayer::Replay() {
   Status s;
   Trace header;
@@ -148,86 +517,250 @@ Status Replayer::Replay() {
 
   std::chrono::system_clock::time_point replay_epoch =
       std::chrono::system_clock::now();
-  WriteOptions woptions;
-  ReadOptions roptions;
+  std::map<TraceType, HistogramImpl> latency;
   Trace trace;
-  uint64_t ops = 0;
-  Iterator* single_iter = nullptr;
   while (s.ok()) {
     trace.reset();
     s = ReadTrace(&trace);
     if (!s.ok()) {
       break;
     }
+    if (trace.type == kTraceEnd) {
+      // Do nothing for now.
+      // TODO: Add some validations later.
+      break;
+    }
 
     std::this_thread::sleep_until(
-        replay_epoch + std::chrono::microseconds(trace.ts - header.ts));
-    if (trace.type == kTraceWrite) {
-      WriteBatch batch(trace.payload);
-      db_->Write(woptions, &batch);
-      ops++;
-    } else if (trace.type == kTraceGet) {
-      uint32_t cf_id = 0;
-      Slice key;
-      DecodeCFAndKey(trace.payload, &cf_id, &key);
-      if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
-        return Status::Corruption("Invalid Column Family ID.");
-      }
+        replay_epoch + std::chrono::microseconds(static_cast<uint64_t>(
+                           (trace.ts - header.ts) / fast_forward_)));
+    s = Execute(&trace, &latency);
+  }
+  MergeLatency(latency);
 
-      std::string value;
-      if (cf_id == 0) {
-        db_->Get(roptions, key, &value);
-      } else {
-        db_->Get(roptions, cf_map_[cf_id], key, &value);
-      }
-      ops++;
-    } else if (trace.type == kTraceIteratorSeek) {
-      uint32_t cf_id = 0;
-      Slice key;
-      DecodeCFAndKey(trace.payload, &cf_id, &key);
-      if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
-        return Status::Corruption("Invalid Column Family ID.");
-      }
+  if (s.IsIncomplete()) {
+    // Reaching eof returns Incomplete status at the moment.
+    // Could happen when killing a process without calling EndTrace() API.
+    // TODO: Add better error handling.
+    return Status::OK();
+  }
+  return s;
+}
 
-      if (cf_id == 0) {
-        single_iter = db_->NewIterator(roptions);
-      } else {
-        single_iter = db_->NewIterator(roptions, cf_map_[cf_id]);
-      }
-      single_iter->Seek(key);
-      ops++;
-      delete single_iter;
-    } else if (trace.type == kTraceIteratorSeekForPrev) {
-      // Currently, only support to call the Seek()
-      uint32_t cf_id = 0;
-      Slice key;
-      DecodeCFAndKey(trace.payload, &cf_id, &key);
-      if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
-        return Status::Corruption("Invalid Column Family ID.");
+namespace {
+struct ReplayWorker {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Trace> queue;
+  bool done = false;
+  Status status;
+  std::map<TraceType, HistogramImpl> latency;
+};
+
+// Traces a worker may have queued before the reader waits for it
+const size_t kMaxQueuedTraces = 1024;
+}  // namespace
+
+Status Replayer::MultiThreadReplay(uint32_t threads_num) {
+  if (threads_num <= 1) {
+    return Replay();
+  }
+  Status s;
+  Trace header;
+  s = ReadHeader(&header);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::chrono::system_clock::time_point replay_epoch =
+      std::chrono::system_clock::now();
+  std::vector<std::unique_ptr<ReplayWorker>> workers;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < threads_num; ++i) {
+    workers.emplace_back(new ReplayWorker);
+    ReplayWorker* worker = workers.back().get();
+    threads.emplace_back([this, worker, replay_epoch, &header] {
+      Trace trace;
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock(worker->mutex);
+          worker->cv.wait(lock, [worker] {
+            return worker->done || !worker->queue.empty();
+          });
+          if (worker->queue.empty()) {
+            break;
+          }
+          trace = std::move(worker->queue.front());
+          worker->queue.pop_front();
+        }
+        worker->cv.notify_all();
+        std::this_thread::sleep_until(
+            replay_epoch + std::chrono::microseconds(static_cast<uint64_t>(
+                               (trace.ts - header.ts) / fast_forward_)));
+        Status exec_s = Execute(&trace, &worker->latency);
+        if (!exec_s.ok() && worker->status.ok()) {
+          worker->status = exec_s;
+        }
       }
+    });
+  }
 
+  Trace trace;
+  while (s.ok()) {
+    trace.reset();
+    s = ReadTrace(&trace);
+    if (!s.ok() || trace.type == kTraceEnd) {
+      break;
+    }
+    ReplayWorker* worker = workers[Partition(&trace, threads_num)].get();
+    {
+      std::unique_lock<std::mutex> lock(worker->mutex);
+      worker->cv.wait(
+          lock, [worker] { return worker->queue.size() < kMaxQueuedTraces; });
+      worker->queue.emplace_back(std::move(trace));
+    }
+    worker->cv.notify_all();
+  }
+
+  for (auto& worker : workers) {
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->done = true;
+    }
+    worker->cv.notify_all();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (s.IsIncomplete()) {
+    // See Replay()
+    s = Status::OK();
+  }
+  for (auto& worker : workers) {
+    MergeLatency(worker->latency);
+    if (s.ok()) {
+      s = worker->status;
+    }
+  }
+  return s;
+}
+
+void Replayer::GetLatencyHistograms(
+    std::map<TraceType, HistogramData>* histograms) {
+  std::lock_guard<std::mutex> lock(latency_mutex_);
+  histograms->clear();
+  for (auto& pair : latency_) {
+    pair.second.Data(&(*histograms)[pair.first]);
+  }
+}
+
+std::string Replayer::LatencyReport() {
+  std::lock_guard<std::mutex> lock(latency_mutex_);
+  std::string report;
+  for (auto& pair : latency_) {
+    report.append("Replay latency (micros) of ");
+    report.append(TraceTypeName(pair.first));
+    report.append(":\n");
+    report.append(pair.second.ToString());
+  }
+  return report;
+}
+
+Status Replayer::Execute(Trace* trace,
+                         std::map<TraceType, HistogramImpl>* latency) {
+  WriteOptions woptions;
+  ReadOptions roptions;
+  Env* env = db_->GetEnv();
+  uint64_t start_micros = env->NowMicros();
+  if (trace->type == kTraceWrite) {
+    WriteBatch batch(trace->payload);
+    db_->Write(woptions, &batch);
+  } else if (trace->type == kTraceGet) {
+    uint32_t cf_id = 0;
+    Slice key;
+    DecodeCFAndKey(trace->payload, &cf_id, &key);
+    if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
+      return Status::Corruption("Invalid Column Family ID.");
+    }
+
+    std::string value;
+    if (cf_id == 0) {
+      db_->Get(roptions, key, &value);
+    } else {
+      db_->Get(roptions, cf_map_[cf_id], key, &value);
+    }
+  } else if (trace->type == kTraceMultiGet) {
+    std::vector<uint32_t> cf_ids;
+    std::vector<Slice> keys;
+    if (!DecodeMultiGet(trace->payload, &cf_ids, &keys)) {
+      return Status::Corruption("Corrupted MultiGet trace.");
+    }
+    std::vector<ColumnFamilyHandle*> handles;
+    for (uint32_t cf_id : cf_ids) {
       if (cf_id == 0) {
-        single_iter = db_->NewIterator(roptions);
+        handles.push_back(db_->DefaultColumnFamily());
+      } else if (cf_map_.find(cf_id) == cf_map_.end()) {
+        return Status::Corruption("Invalid Column Family ID.");
       } else {
-        single_iter = db_->NewIterator(roptions, cf_map_[cf_id]);
+        handles.push_back(cf_map_[cf_id]);
       }
+    }
+    std::vector<std::string> values;
+    db_->MultiGet(roptions, handles, keys, &values);
+  } else if (trace->type == kTraceIteratorSeek ||
+             trace->type == kTraceIteratorSeekForPrev) {
+    uint32_t cf_id = 0;
+    Slice key;
+    DecodeCFAndKey(trace->payload, &cf_id, &key);
+    if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
+      return Status::Corruption("Invalid Column Family ID.");
+    }
+
+    std::unique_ptr<Iterator> single_iter;
+    if (cf_id == 0) {
+      single_iter.reset(db_->NewIterator(roptions));
+    } else {
+      single_iter.reset(db_->NewIterator(roptions, cf_map_[cf_id]));
+    }
+    if (trace->type == kTraceIteratorSeek) {
+      single_iter->Seek(key);
+    } else {
       single_iter->SeekForPrev(key);
-      ops++;
-      delete single_iter;
-    } else if (trace.type == kTraceEnd) {
-      // Do nothing for now.
-      // TODO: Add some validations later.
-      break;
     }
+  } else {
+    return Status::OK();
   }
+  (*latency)[trace->type].Add(env->NowMicros() - start_micros);
+  return Status::OK();
+}
 
-  if (s.IsIncomplete()) {
-    // Reaching eof returns Incomplete status at the moment.
-    // Could happen when killing a process without calling EndTrace() API.
-    // TODO: Add better error handling.
-    return Status::OK();
+uint32_t Replayer::Partition(Trace* trace, uint32_t threads_num) {
+  Slice key;
+  if (trace->type == kTraceWrite) {
+    WriteBatch batch(trace->payload);
+    FirstKeyHandler handler;
+    batch.Iterate(&handler);
+    return handler.found ? GetSliceHash(handler.key) % threads_num : 0;
+  } else if (trace->type == kTraceMultiGet) {
+    std::vector<uint32_t> cf_ids;
+    std::vector<Slice> keys;
+    if (!DecodeMultiGet(trace->payload, &cf_ids, &keys) || keys.empty()) {
+      return 0;
+    }
+    key = keys[0];
+  } else if (trace->type == kTraceGet || trace->type == kTraceIteratorSeek ||
+             trace->type == kTraceIteratorSeekForPrev) {
+    uint32_t cf_id = 0;
+    DecodeCFAndKey(trace->payload, &cf_id, &key);
+  }
+  return GetSliceHash(key) % threads_num;
+}
+
+void Replayer::MergeLatency(const std::map<TraceType, HistogramImpl>& latency) {
+  std::lock_guard<std::mutex> lock(latency_mutex_);
+  for (auto& pair : latency) {
+    latency_[pair.first].Merge(pair.second);
   }
-  return s;
 }
 
 Status Replayer::ReadHeader(Trace* header) {
@@ -5,12 +5,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "monitoring/histogram.h"
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
+#include "rocksdb/perf_level.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/trace_reader_writer.h"
 
@@ -37,9 +46,55 @@ enum TraceType : char {
   kTraceGet = 4,
   kTraceIteratorSeek = 5,
   kTraceIteratorSeekForPrev = 6,
+  kTracePerfSample = 7,
+  kTraceMultiGet = 8,
+  kTraceTableAccess = 9,
   kTraceMax,
 };
 
+// The operation of a kTracePerfSample
+enum PerfTraceOp : char {
+  kPerfTraceGet = 0,
+  kPerfTraceMultiGet = 1,
+  kPerfTraceSeek = 2,
+  kPerfTraceSeekForPrev = 3,
+  kPerfTraceWrite = 4,
+};
+
+// What a kTraceTableAccess read
+enum TableAccessType : char {
+  // A value record of a TerarkZip table, read by its record id
+  kTableAccessTerarkZipValue = 0,
+  // A separated value fetched from a blob SST by its internal key
+  kTableAccessBlob = 1,
+  kTableAccessTypeMax,
+};
+
+// The read that caused a kTraceTableAccess
+enum TableAccessCaller : char {
+  kTableAccessGet = 0,
+  kTableAccessIterator = 1,
+  // A separated value fetched on its own, see Version::fetch_buffer()
+  kTableAccessFetch = 2,
+  // Separated values fetched through an iterator of their blob SST by a
+  // MultiGet or a forward scan
+  kTableAccessSeekFetch = 3,
+  kTableAccessCallerMax,
+};
+
+struct TableAccessRecord {
+  uint64_t access_timestamp = 0;
+  TableAccessType type = kTableAccessTypeMax;
+  TableAccessCaller caller = kTableAccessCallerMax;
+  bool is_cache_hit = false;
+  uint64_t file_number = 0;
+  // The record id in a TerarkZip table, the hash of the internal key of a
+  // blob
+  uint64_t record = 0;
+  // Bytes of the record, 0 when it is read lazily
+  uint64_t size = 0;
+};
+
 // TODO: This should also be made part of public interface to help users build
 // custom TracerReaders and TraceWriters.
 struct Trace {
@@ -63,6 +118,8 @@ class Tracer {
 
   Status Write(WriteBatch* write_batch);
   Status Get(ColumnFamilyHandle* cfname, const Slice& key);
+  Status MultiGet(const std::vector<ColumnFamilyHandle*>& column_families,
+                  const std::vector<Slice>& keys);
   Status IteratorSeek(const uint32_t& cf_id, const Slice& key);
   Status IteratorSeekForPrev(const uint32_t& cf_id, const Slice& key);
   bool IsTraceFileOverMax();
@@ -79,6 +136,102 @@ class Tracer {
   std::unique_ptr<TraceWriter> trace_writer_;
 };
 
+// Writes sampled operations to a TraceWriter. The payload of a
+// kTracePerfSample is the PerfTraceOp, the fixed32 column family id, the
+// fixed64 latency in micros and the length prefixed PerfContext and
+// IOStatsContext strings, the per level PerfContext included.
+//
+// The operation only queues its sample, a background thread writes it.
+class PerfTracer {
+ public:
+  PerfTracer(Env* env, const PerfTraceOptions& options,
+             std::unique_ptr<TraceWriter>&& trace_writer);
+  ~PerfTracer();
+
+  // Sampling of the calling thread, see PerfTraceOptions::sample_rate
+  static bool Sampled(uint32_t sample_rate);
+
+  // Queues the contexts of the calling thread
+  void Add(PerfTraceOp op, uint32_t cf_id, uint64_t latency_micros);
+
+  // Writes the queued samples and the footer
+  Status Close();
+
+  static Status DecodeSample(const Trace& trace, PerfTraceOp* op,
+                             uint32_t* cf_id, uint64_t* latency_micros,
+                             std::string* perf_context,
+                             std::string* iostats_context);
+
+ private:
+  void BGWork();
+  Status WriteTrace(const Trace& trace);
+
+  Env* env_;
+  PerfTraceOptions options_;
+  std::unique_ptr<TraceWriter> trace_writer_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Trace> pending_;
+  bool closing_;
+  Status status_;
+  std::thread thread_;
+};
+
+// Traces the enclosing operation of db when it is sampled, the tracer is
+// kept alive until the operation is done
+class PerfTraceScope {
+ public:
+  PerfTraceScope(DBImpl* db, PerfTraceOp op, uint32_t cf_id);
+  ~PerfTraceScope();
+
+ private:
+  std::shared_ptr<PerfTracer> tracer_;
+  Env* env_;
+  PerfTraceOp op_;
+  uint32_t cf_id_;
+  PerfLevel prev_perf_level_;
+  bool prev_per_level_perf_context_;
+  uint64_t start_micros_;
+};
+
+// Traces the reads of the records of a db that bypass the block cache, the
+// value records of TerarkZip tables and the separated values of blob SSTs,
+// so the reuse of these records can be analyzed like that of blocks.
+//
+// The payload of a kTraceTableAccess is the TableAccessType, the
+// TableAccessCaller and the cache hit byte, followed by the fixed64 file
+// number, record and size.
+//
+// Shared by the table readers of a db, which check IsTracing() before
+// building a record. Thread safe.
+class TableAccessTracer {
+ public:
+  TableAccessTracer();
+  ~TableAccessTracer();
+
+  Status StartTrace(Env* env, const TableAccessTraceOptions& options,
+                    std::unique_ptr<TraceWriter>&& trace_writer);
+  // Writes the footer
+  Status EndTrace();
+
+  bool IsTracing() const { return tracing_.load(std::memory_order_acquire); }
+
+  void Add(TableAccessType type, TableAccessCaller caller,
+           uint64_t file_number, uint64_t record, uint64_t size,
+           bool is_cache_hit);
+
+  static Status DecodeAccess(const Trace& trace, TableAccessRecord* record);
+
+ private:
+  Status WriteTrace(const Trace& trace);
+
+  std::atomic<bool> tracing_;
+  std::mutex mutex_;
+  Env* env_;
+  TableAccessTraceOptions options_;
+  std::unique_ptr<TraceWriter> trace_writer_;
+};
+
 // Replay RocksDB operations from a trace.
 class Replayer {
  public:
@@ -86,16 +239,39 @@ class Replayer {
            std::unique_ptr<TraceReader>&& reader);
   ~Replayer();
 
+  // The operations are issued fast_forward times as fast as they were
+  // traced, 1.0 keeps the traced timing
+  Status SetFastForward(double fast_forward);
+
   Status Replay();
 
+  // Replays on threads_num threads. A trace does not record the thread that
+  // issued an operation, so the operations are partitioned by the hash of
+  // their key, the first key of a Write or MultiGet. The operations on a key
+  // keep their order and every thread waits for the traced time of its next
+  // operation.
+  Status MultiThreadReplay(uint32_t threads_num);
+
+  // Latency in micros of the replayed operations by TraceType
+  void GetLatencyHistograms(std::map<TraceType, HistogramData>* histograms);
+  std::string LatencyReport();
+
  private:
   Status ReadHeader(Trace* header);
   Status ReadFooter(Trace* footer);
   Status ReadTrace(Trace* trace);
 
+  // Issues the operation of trace and adds its latency to latency
+  Status Execute(Trace* trace, std::map<TraceType, HistogramImpl>* latency);
+  uint32_t Partition(Trace* trace, uint32_t threads_num);
+  void MergeLatency(const std::map<TraceType, HistogramImpl>& latency);
+
   DBImpl* db_;
   std::unique_ptr<TraceReader> trace_reader_;
   std::unordered_map<uint32_t, ColumnFamilyHandle*> cf_map_;
+  double fast_forward_;
+  std::mutex latency_mutex_;
+  std::map<TraceType, HistogramImpl> latency_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,422 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/work_stealing_thread_pool.h"
+
+#ifdef OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+// Priorities from the most to the least urgent
+const Env::Priority kPriorityOrder[] = {Env::HIGH, Env::LOW, Env::BOTTOM};
+
+// The CPUs of each NUMA node, empty if unknown
+std::vector<std::vector<int>> GetNumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+#ifdef OS_LINUX
+  for (int node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" +
+                       std::to_string(node) + "/cpulist");
+    std::string cpulist;
+    if (!file || !std::getline(file, cpulist)) {
+      break;
+    }
+    // e.g. "0-3,8-11"
+    std::vector<int> cpus;
+    std::stringstream ranges(cpulist);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+      int first = 0, last = 0;
+      char dash = 0;
+      std::stringstream parse(range);
+      if (!(parse >> first)) {
+        continue;
+      }
+      last = parse >> dash >> last ? last : first;
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    nodes.push_back(std::move(cpus));
+  }
+#endif
+  return nodes;
+}
+
+class WorkStealingThreadPoolImpl : public WorkStealingThreadPool {
+ public:
+  explicit WorkStealingThreadPoolImpl(
+      const WorkStealingThreadPoolOptions& options)
+      : workers_(kMaxThreads),
+        num_workers_(0),
+        threads_limit_(0),
+        queue_len_(0),
+        next_queue_(0),
+        num_sleeping_(0),
+        exiting_(false),
+        wait_for_jobs_(false) {
+    if (options.numa_affinity) {
+      numa_node_cpus_ = GetNumaNodeCpus();
+    }
+    SetBackgroundThreads(options.num_threads);
+  }
+
+  ~WorkStealingThreadPoolImpl() { JoinThreads(false); }
+
+  void JoinAllThreads() override { JoinThreads(false); }
+
+  void WaitForJobsAndJoinAllThreads() override { JoinThreads(true); }
+
+  void SetBackgroundThreads(int num) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (exiting_) {
+      return;
+    }
+    threads_limit_ = std::min(std::max(num, 0), static_cast<int>(kMaxThreads));
+    // Wakes up the excessive threads to terminate
+    cv_.notify_all();
+    StartThreads();
+  }
+
+  int GetBackgroundThreads() override { return threads_limit_; }
+
+  unsigned int GetQueueLen() const override { return queue_len_; }
+
+  void SubmitJob(const std::function<void()>& job) override {
+    auto copy(job);
+    Submit(std::move(copy), std::function<void()>(), nullptr, Env::LOW);
+  }
+
+  void SubmitJob(std::function<void()>&& job) override {
+    Submit(std::move(job), std::function<void()>(), nullptr, Env::LOW);
+  }
+
+  void Schedule(void (*function)(void* arg), void* arg, Env::Priority pri,
+                void* tag, void (*unschedFunction)(void* arg)) override {
+    Submit(std::bind(function, arg),
+           unschedFunction == nullptr ? std::function<void()>()
+                                      : std::bind(unschedFunction, arg),
+           tag, pri);
+  }
+
+  int UnSchedule(void* tag) override {
+    std::vector<std::function<void()>> candidates;
+    int count = 0;
+    size_t num_workers = num_workers_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < num_workers; ++i) {
+      Worker* worker = workers_[i].get();
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      for (auto& queue : worker->queues) {
+        for (auto it = queue.begin(); it != queue.end();) {
+          if (it->tag != tag) {
+            ++it;
+            continue;
+          }
+          if (it->unschedFunction) {
+            candidates.push_back(std::move(it->unschedFunction));
+          }
+          it = queue.erase(it);
+          --worker->size;
+          --queue_len_;
+          ++count;
+        }
+      }
+    }
+    // Run unschedule functions outside the mutexes
+    for (auto& f : candidates) {
+      f();
+    }
+    return count;
+  }
+
+ private:
+  // Up to kMaxThreads queues are created, and never destroyed before the
+  // pool, so stealing reads them without locking the pool
+  static const size_t kMaxThreads = 1024;
+
+  struct Job {
+    void* tag = nullptr;
+    std::function<void()> function;
+    std::function<void()> unschedFunction;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    // Indexed by Env::Priority
+    std::deque<Job> queues[Env::TOTAL];
+    // Jobs in the queues, read by thieves without the mutex
+    std::atomic<size_t> size{0};
+    int numa_node = -1;
+    // Whether thread runs BGThread(), guarded by mu_
+    bool running = false;
+    port::Thread thread;
+  };
+
+  // The pool and the index of the worker the current thread runs, if any
+  struct CurrentWorker {
+    WorkStealingThreadPoolImpl* pool;
+    size_t index;
+  };
+  static thread_local CurrentWorker current_worker_;
+
+  void Submit(std::function<void()>&& function,
+              std::function<void()>&& unschedFunction, void* tag,
+              Env::Priority pri) {
+    assert(pri >= Env::BOTTOM && pri < Env::TOTAL);
+    size_t num_workers = num_workers_.load(std::memory_order_acquire);
+    if (num_workers < static_cast<size_t>(threads_limit_.load())) {
+      std::lock_guard<std::mutex> lock(mu_);
+      StartThreads();
+      num_workers = num_workers_.load(std::memory_order_acquire);
+    }
+    if (exiting_.load() || num_workers == 0) {
+      return;
+    }
+    size_t index = current_worker_.pool == this
+                       ? current_worker_.index
+                       : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                             num_workers;
+    Worker* worker = workers_[index].get();
+    // Counted before it is queued so queue_len_ never goes below the jobs
+    // taken. The sleeping threads check queue_len_ after counting
+    // themselves, so one of them sees the job or is counted below.
+    ++queue_len_;
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->queues[pri].emplace_back();
+      Job& job = worker->queues[pri].back();
+      job.tag = tag;
+      job.function = std::move(function);
+      job.unschedFunction = std::move(unschedFunction);
+      ++worker->size;
+    }
+    if (num_sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock(mu_);
+      cv_.notify_one();
+    }
+  }
+
+  // Pops the newest job of the worker's own queues, or steals the oldest job
+  // of another worker, the most urgent first
+  bool TakeJob(size_t index, Job* job) {
+    Worker* self = workers_[index].get();
+    if (self->size.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(self->mutex);
+      for (auto pri : kPriorityOrder) {
+        auto& queue = self->queues[pri];
+        if (!queue.empty()) {
+          *job = std::move(queue.back());
+          queue.pop_back();
+          --self->size;
+          --queue_len_;
+          return true;
+        }
+      }
+    }
+    size_t num_workers = num_workers_.load(std::memory_order_acquire);
+    // The workers of the same NUMA node in the first pass, the others in
+    // the second one
+    int passes = numa_node_cpus_.empty() ? 1 : 2;
+    for (auto pri : kPriorityOrder) {
+      for (int pass = 0; pass < passes; ++pass) {
+        for (size_t k = 1; k < num_workers; ++k) {
+          Worker* victim = workers_[(index + k) % num_workers].get();
+          if (victim->size.load(std::memory_order_relaxed) == 0 ||
+              (passes == 2 &&
+               (victim->numa_node == self->numa_node) != (pass == 0))) {
+            continue;
+          }
+          std::lock_guard<std::mutex> lock(victim->mutex);
+          auto& queue = victim->queues[pri];
+          if (!queue.empty()) {
+            *job = std::move(queue.front());
+            queue.pop_front();
+            --victim->size;
+            --queue_len_;
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  void BGThread(size_t index) {
+    current_worker_ = {this, index};
+    while (true) {
+      if (exiting_.load() ? !wait_for_jobs_.load()
+                          : index >= static_cast<size_t>(threads_limit_)) {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (exiting_ ? !wait_for_jobs_
+                     : index >= static_cast<size_t>(threads_limit_)) {
+          // The jobs left in its queues are stolen by the other threads
+          workers_[index]->running = false;
+          cv_.notify_all();
+          break;
+        }
+        continue;
+      }
+      Job job;
+      if (TakeJob(index, &job)) {
+        job.function();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mu_);
+      if (exiting_ && queue_len_ == 0) {
+        workers_[index]->running = false;
+        break;
+      }
+      ++num_sleeping_;
+      if (queue_len_.load() == 0 && !exiting_ &&
+          index < static_cast<size_t>(threads_limit_)) {
+        cv_.wait(lock);
+      }
+      --num_sleeping_;
+    }
+    current_worker_ = {nullptr, 0};
+  }
+
+  // Creates the queues of the threads up to threads_limit_, at least one so
+  // jobs are kept while the pool has no thread, and starts the threads
+  // REQUIRES: mu_ is held
+  void StartThreads() {
+    if (exiting_) {
+      return;
+    }
+    size_t limit = static_cast<size_t>(threads_limit_);
+    size_t num_workers = num_workers_.load(std::memory_order_relaxed);
+    for (size_t i = num_workers; i < std::max<size_t>(limit, 1); ++i) {
+      workers_[i].reset(new Worker);
+      if (!numa_node_cpus_.empty()) {
+        workers_[i]->numa_node = static_cast<int>(i % numa_node_cpus_.size());
+      }
+      num_workers_.store(i + 1, std::memory_order_release);
+    }
+    for (size_t i = 0; i < limit; ++i) {
+      Worker* worker = workers_[i].get();
+      if (worker->running) {
+        continue;
+      }
+      if (worker->thread.joinable()) {
+        // An excessive thread which terminated
+        worker->thread.join();
+      }
+      worker->running = true;
+      worker->thread = port::Thread([this, i] { BGThread(i); });
+#if defined(_GNU_SOURCE) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 12)
+      auto th_handle = worker->thread.native_handle();
+      std::string thread_name = "rocksdb:ws" + std::to_string(i);
+      pthread_setname_np(th_handle, thread_name.c_str());
+#endif
+#endif
+      SetAffinity(worker);
+    }
+  }
+
+  void SetAffinity(Worker* worker) {
+#ifdef OS_LINUX
+    if (worker->numa_node < 0 || numa_node_cpus_[worker->numa_node].empty()) {
+      return;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : numa_node_cpus_[worker->numa_node]) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpu_set);
+      }
+    }
+    pthread_setaffinity_np(worker->thread.native_handle(), sizeof(cpu_set),
+                           &cpu_set);
+#else
+    (void)worker;
+#endif
+  }
+
+  void JoinThreads(bool wait_for_jobs) {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (exiting_) {
+      return;
+    }
+    wait_for_jobs_ = wait_for_jobs;
+    exiting_ = true;
+    cv_.notify_all();
+    size_t num_workers = num_workers_.load(std::memory_order_relaxed);
+    lock.unlock();
+    for (size_t i = 0; i < num_workers; ++i) {
+      if (workers_[i]->thread.joinable()) {
+        workers_[i]->thread.join();
+      }
+    }
+    lock.lock();
+    // Prevent threads from being recreated right after they're joined, in
+    // case the user is concurrently submitting jobs
+    threads_limit_ = 0;
+    exiting_ = false;
+    wait_for_jobs_ = false;
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> num_workers_;
+  std::atomic<int> threads_limit_;
+  std::atomic<unsigned int> queue_len_;
+  std::atomic<size_t> next_queue_;
+  std::atomic<int> num_sleeping_;
+  std::atomic<bool> exiting_;
+  std::atomic<bool> wait_for_jobs_;
+  std::vector<std::vector<int>> numa_node_cpus_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+};
+
+thread_local WorkStealingThreadPoolImpl::CurrentWorker
+    WorkStealingThreadPoolImpl::current_worker_ = {nullptr, 0};
+
+}  // namespace
+
+WorkStealingThreadPool* NewWorkStealingThreadPool(
+    const WorkStealingThreadPoolOptions& options) {
+  return new WorkStealingThreadPoolImpl(options);
+}
+
+void ScheduleParallelTask(Env* env, WorkStealingThreadPool* pool,
+                          void (*function)(void* arg), void* arg,
+                          Env::Priority pri, void* tag,
+                          void (*unschedFunction)(void* arg)) {
+  if (pool != nullptr) {
+    pool->Schedule(function, arg, pri, tag, unschedFunction);
+  } else {
+    env->Schedule(function, arg, pri, tag, unschedFunction);
+  }
+}
+
+int UnScheduleParallelTasks(Env* env, WorkStealingThreadPool* pool, void* tag,
+                            Env::Priority pri) {
+  if (pool != nullptr) {
+    return pool->UnSchedule(tag);
+  }
+  return env->UnSchedule(tag, pri);
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,28 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/threadpool.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// The parallel parts of one background job, e.g. the subcompactions of a
+// compaction or the index and store builds of a TerarkZip table, run in
+// DBOptions::parallel_task_pool when it is set and in the pool of env at pri
+// otherwise. Their tags let the thread waiting for them run the ones not
+// started yet itself, see UnScheduleParallelTasks().
+extern void ScheduleParallelTask(Env* env, WorkStealingThreadPool* pool,
+                                 void (*function)(void* arg), void* arg,
+                                 Env::Priority pri = Env::LOW,
+                                 void* tag = nullptr,
+                                 void (*unschedFunction)(void* arg) = nullptr);
+
+extern int UnScheduleParallelTasks(Env* env, WorkStealingThreadPool* pool,
+                                   void* tag, Env::Priority pri = Env::LOW);
+
+}  // namespace TERARKDB_NAMESPACE
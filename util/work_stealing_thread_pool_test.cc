@@ -0,0 +1,223 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/work_stealing_thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/threadpool.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+// Blocks the threads running Wait() until Release()
+class Gate {
+ public:
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waiting_;
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return open_; });
+  }
+
+  void WaitForWaiters(int n) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this, n] { return waiting_ >= n; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int waiting_ = 0;
+  bool open_ = false;
+};
+
+struct Counter {
+  std::atomic<int> runs{0};
+  std::atomic<int> unscheduled{0};
+};
+
+void CountRun(void* arg) { ++static_cast<Counter*>(arg)->runs; }
+
+void CountUnschedule(void* arg) {
+  ++static_cast<Counter*>(arg)->unscheduled;
+}
+
+std::unique_ptr<WorkStealingThreadPool> NewPool(int num_threads) {
+  WorkStealingThreadPoolOptions options;
+  options.num_threads = num_threads;
+  return std::unique_ptr<WorkStealingThreadPool>(
+      NewWorkStealingThreadPool(options));
+}
+}  // namespace
+
+class WorkStealingThreadPoolTest : public testing::Test {};
+
+TEST_F(WorkStealingThreadPoolTest, RunsAllJobs) {
+  auto pool = NewPool(4);
+  Counter counter;
+  for (int i = 0; i < 1000; ++i) {
+    pool->Schedule(&CountRun, &counter,
+                   static_cast<Env::Priority>(i % Env::TOTAL));
+  }
+  std::atomic<int> submitted{0};
+  for (int i = 0; i < 100; ++i) {
+    pool->SubmitJob([&submitted] { ++submitted; });
+  }
+  pool->WaitForJobsAndJoinAllThreads();
+  ASSERT_EQ(1000, counter.runs.load());
+  ASSERT_EQ(100, submitted.load());
+  ASSERT_EQ(0U, pool->GetQueueLen());
+}
+
+TEST_F(WorkStealingThreadPoolTest, IdleThreadsStealNestedJobs) {
+  auto pool = NewPool(4);
+  // The nested jobs go to the queue of the blocked thread, only the other
+  // threads can run them
+  std::atomic<int> nested{0};
+  Gate done;
+  pool->SubmitJob([&] {
+    for (int i = 0; i < 100; ++i) {
+      pool->SubmitJob([&] {
+        if (++nested == 100) {
+          done.Release();
+        }
+      });
+    }
+    done.Wait();
+  });
+  done.WaitForWaiters(1);
+  pool->WaitForJobsAndJoinAllThreads();
+  ASSERT_EQ(100, nested.load());
+}
+
+TEST_F(WorkStealingThreadPoolTest, HigherPriorityFirst) {
+  auto pool = NewPool(1);
+  Gate gate;
+  pool->SubmitJob([&gate] { gate.Wait(); });
+  gate.WaitForWaiters(1);
+
+  std::mutex mutex;
+  std::vector<Env::Priority> order;
+  struct Arg {
+    Env::Priority pri;
+    std::mutex* mutex;
+    std::vector<Env::Priority>* order;
+  };
+  std::vector<Arg> args;
+  for (auto pri : {Env::BOTTOM, Env::LOW, Env::HIGH}) {
+    for (int i = 0; i < 3; ++i) {
+      args.push_back(Arg{pri, &mutex, &order});
+    }
+  }
+  for (auto& arg : args) {
+    pool->Schedule(
+        [](void* a) {
+          auto* arg = static_cast<Arg*>(a);
+          std::lock_guard<std::mutex> lock(*arg->mutex);
+          arg->order->push_back(arg->pri);
+        },
+        &arg, arg.pri);
+  }
+  ASSERT_EQ(9U, pool->GetQueueLen());
+  gate.Release();
+  pool->WaitForJobsAndJoinAllThreads();
+  ASSERT_EQ(std::vector<Env::Priority>({Env::HIGH, Env::HIGH, Env::HIGH,
+                                        Env::LOW, Env::LOW, Env::LOW,
+                                        Env::BOTTOM, Env::BOTTOM,
+                                        Env::BOTTOM}),
+            order);
+}
+
+TEST_F(WorkStealingThreadPoolTest, UnSchedule) {
+  auto pool = NewPool(2);
+  Gate gate;
+  for (int i = 0; i < 2; ++i) {
+    pool->SubmitJob([&gate] { gate.Wait(); });
+  }
+  gate.WaitForWaiters(2);
+
+  Counter tagged, untagged;
+  int tag;
+  for (int i = 0; i < 10; ++i) {
+    pool->Schedule(&CountRun, &tagged, Env::LOW, &tag, &CountUnschedule);
+    pool->Schedule(&CountRun, &untagged, Env::HIGH, nullptr,
+                   &CountUnschedule);
+  }
+  ASSERT_EQ(10, pool->UnSchedule(&tag));
+  ASSERT_EQ(10, tagged.unscheduled.load());
+  ASSERT_EQ(0, pool->UnSchedule(&tag));
+  ASSERT_EQ(10U, pool->GetQueueLen());
+
+  gate.Release();
+  pool->WaitForJobsAndJoinAllThreads();
+  ASSERT_EQ(0, tagged.runs.load());
+  ASSERT_EQ(10, untagged.runs.load());
+  ASSERT_EQ(0, untagged.unscheduled.load());
+}
+
+TEST_F(WorkStealingThreadPoolTest, ScheduleParallelTask) {
+  auto pool = NewPool(2);
+  Gate gate;
+  for (int i = 0; i < 2; ++i) {
+    pool->SubmitJob([&gate] { gate.Wait(); });
+  }
+  gate.WaitForWaiters(2);
+  // The pool is used instead of env
+  Counter counter;
+  int tag;
+  for (int i = 0; i < 10; ++i) {
+    ScheduleParallelTask(Env::Default(), pool.get(), &CountRun, &counter,
+                         Env::LOW, &tag, &CountUnschedule);
+  }
+  ASSERT_EQ(10U, pool->GetQueueLen());
+  ASSERT_EQ(10, UnScheduleParallelTasks(Env::Default(), pool.get(), &tag));
+  ASSERT_EQ(10, counter.unscheduled.load());
+  gate.Release();
+  pool->WaitForJobsAndJoinAllThreads();
+  ASSERT_EQ(0, counter.runs.load());
+}
+
+TEST_F(WorkStealingThreadPoolTest, SetBackgroundThreads) {
+  auto pool = NewPool(4);
+  ASSERT_EQ(4, pool->GetBackgroundThreads());
+  Gate gate;
+  pool->SetBackgroundThreads(2);
+  ASSERT_EQ(2, pool->GetBackgroundThreads());
+  // The jobs of the queues of the terminated threads are stolen
+  Counter counter;
+  for (int i = 0; i < 100; ++i) {
+    pool->Schedule(&CountRun, &counter, Env::LOW);
+  }
+  pool->SetBackgroundThreads(8);
+  for (int i = 0; i < 8; ++i) {
+    pool->SubmitJob([&gate] { gate.Wait(); });
+  }
+  // All 8 threads run at the same time
+  gate.WaitForWaiters(8);
+  gate.Release();
+  pool->WaitForJobsAndJoinAllThreads();
+  ASSERT_EQ(100, counter.runs.load());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,236 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/xor_filter.h"
+
+#include <algorithm>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
+#include "util/xxhash.h"
+
+namespace TERARKDB_NAMESPACE {
+
+const char XorFilterBitsBuilder::kXorFilterMarker = static_cast<char>(-2);
+const uint32_t XorFilterBitsBuilder::kMetaSize;
+
+namespace {
+// Construction retries with another seed when the keys can't be peeled
+const int kMaxSeeds = 64;
+
+inline uint64_t KeyHash(const Slice& key) {
+  return XXH64(key.data(), key.size(), 0);
+}
+
+// Murmur3 finalizer, rehashes a key hash for a seed
+inline uint64_t Mix(uint64_t h, uint64_t seed) {
+  h += seed;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline uint32_t Fingerprint(uint64_t h) {
+  return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// Slot of the key in block i
+inline uint32_t Slot(uint64_t h, int i, uint32_t block_length) {
+  uint32_t r = static_cast<uint32_t>(i == 0 ? h : (h << (21 * i)) |
+                                                     (h >> (64 - 21 * i)));
+  return static_cast<uint32_t>((uint64_t(r) * block_length) >> 32) +
+         i * block_length;
+}
+
+inline uint32_t BlockLength(size_t num_keys) {
+  uint32_t capacity = 32 + static_cast<uint32_t>(1.23 * num_keys);
+  return capacity / 3;
+}
+
+inline uint32_t LoadFingerprint(const char* data, size_t fingerprint_bytes,
+                                uint32_t slot) {
+  if (fingerprint_bytes == 1) {
+    return static_cast<uint8_t>(data[slot]);
+  }
+  return DecodeFixed16(data + slot * 2);
+}
+
+class XorFilterBitsReader : public FilterBitsReader {
+ public:
+  explicit XorFilterBitsReader(const Slice& contents)
+      : data_(contents.data()) {
+    size_t len = contents.size();
+    seed_ = DecodeFixed64(data_ + len - 14);
+    fingerprint_bytes_ = static_cast<uint8_t>(data_[len - 6]);
+    block_length_ = DecodeFixed32(data_ + len - 4);
+    uint64_t expect = uint64_t(block_length_) * 3 * fingerprint_bytes_ +
+                      XorFilterBitsBuilder::kMetaSize;
+    // Sanitize broken or unknown parameters, regarded as match
+    broken_ = (fingerprint_bytes_ != 1 && fingerprint_bytes_ != 2) ||
+              expect != len;
+  }
+
+  virtual bool MayMatch(const Slice& entry) override {
+    if (broken_) {
+      return true;
+    }
+    if (block_length_ == 0) {
+      return false;
+    }
+    uint64_t h = Mix(KeyHash(entry), seed_);
+    uint32_t mask = fingerprint_bytes_ == 1 ? 0xFF : 0xFFFF;
+    uint32_t f = Fingerprint(h) & mask;
+    f ^= LoadFingerprint(data_, fingerprint_bytes_, Slot(h, 0, block_length_));
+    f ^= LoadFingerprint(data_, fingerprint_bytes_, Slot(h, 1, block_length_));
+    f ^= LoadFingerprint(data_, fingerprint_bytes_, Slot(h, 2, block_length_));
+    return f == 0;
+  }
+
+ private:
+  const char* data_;
+  uint64_t seed_;
+  size_t fingerprint_bytes_;
+  uint32_t block_length_;
+  bool broken_;
+};
+}  // namespace
+
+XorFilterBitsBuilder::XorFilterBitsBuilder(size_t fingerprint_bytes)
+    : fingerprint_bytes_(fingerprint_bytes) {
+  assert(fingerprint_bytes_ == 1 || fingerprint_bytes_ == 2);
+}
+
+void XorFilterBitsBuilder::AddKey(const Slice& key) {
+  uint64_t hash = KeyHash(key);
+  if (hash_entries_.empty() || hash != hash_entries_.back()) {
+    hash_entries_.push_back(hash);
+  }
+}
+
+Slice XorFilterBitsBuilder::Finish(std::unique_ptr<const char[]>* buf) {
+  // A key hashed twice can't be peeled
+  std::sort(hash_entries_.begin(), hash_entries_.end());
+  hash_entries_.erase(std::unique(hash_entries_.begin(), hash_entries_.end()),
+                      hash_entries_.end());
+  const size_t num_keys = hash_entries_.size();
+  uint32_t block_length = num_keys == 0 ? 0 : BlockLength(num_keys);
+  const uint32_t capacity = block_length * 3;
+  const uint32_t size = CalculateSpace(static_cast<int>(num_keys));
+  char* data = new char[size];
+  memset(data, 0, size);
+
+  uint64_t seed = 0;
+  size_t fingerprint_bytes = fingerprint_bytes_;
+  if (num_keys != 0) {
+    std::vector<uint32_t> count(capacity);
+    std::vector<uint64_t> xor_hash(capacity);
+    std::vector<uint32_t> queue;
+    // Peeled keys, the last one is assigned first
+    std::vector<std::pair<uint64_t, uint32_t>> stack;
+    queue.reserve(capacity);
+    stack.reserve(num_keys);
+    bool peeled = false;
+    for (int attempt = 0; attempt < kMaxSeeds && !peeled; ++attempt) {
+      seed = XXH64(&attempt, sizeof(attempt), num_keys);
+      std::fill(count.begin(), count.end(), 0);
+      std::fill(xor_hash.begin(), xor_hash.end(), 0);
+      queue.clear();
+      stack.clear();
+      for (uint64_t key_hash : hash_entries_) {
+        uint64_t h = Mix(key_hash, seed);
+        for (int i = 0; i < 3; ++i) {
+          uint32_t slot = Slot(h, i, block_length);
+          ++count[slot];
+          xor_hash[slot] ^= h;
+        }
+      }
+      for (uint32_t slot = 0; slot < capacity; ++slot) {
+        if (count[slot] == 1) {
+          queue.push_back(slot);
+        }
+      }
+      while (!queue.empty()) {
+        uint32_t slot = queue.back();
+        queue.pop_back();
+        if (count[slot] != 1) {
+          continue;
+        }
+        uint64_t h = xor_hash[slot];
+        stack.emplace_back(h, slot);
+        for (int i = 0; i < 3; ++i) {
+          uint32_t other = Slot(h, i, block_length);
+          --count[other];
+          xor_hash[other] ^= h;
+          if (count[other] == 1) {
+            queue.push_back(other);
+          }
+        }
+      }
+      peeled = stack.size() == num_keys;
+    }
+    if (peeled) {
+      const uint32_t mask = fingerprint_bytes == 1 ? 0xFF : 0xFFFF;
+      for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        uint64_t h = it->first;
+        // The slot of the key is still 0, the xor of the three is the
+        // xor of the other two
+        uint32_t f = Fingerprint(h) & mask;
+        for (int i = 0; i < 3; ++i) {
+          f ^= LoadFingerprint(data, fingerprint_bytes,
+                               Slot(h, i, block_length));
+        }
+        if (fingerprint_bytes == 1) {
+          data[it->second] = static_cast<char>(f);
+        } else {
+          EncodeFixed16(data + it->second * 2, static_cast<uint16_t>(f));
+        }
+      }
+    } else {
+      // Leave a filter that matches everything
+      fingerprint_bytes = 0;
+    }
+  }
+  char* meta = data + size - kMetaSize;
+  EncodeFixed64(meta, seed);
+  meta[8] = static_cast<char>(fingerprint_bytes);
+  meta[9] = kXorFilterMarker;
+  EncodeFixed32(meta + 10, block_length);
+
+  buf->reset(data);
+  hash_entries_.clear();
+  return Slice(data, size);
+}
+
+uint32_t XorFilterBitsBuilder::CalculateSpace(int num_entry) const {
+  if (num_entry <= 0) {
+    return kMetaSize;
+  }
+  return static_cast<uint32_t>(BlockLength(num_entry) * 3 *
+                               fingerprint_bytes_) +
+         kMetaSize;
+}
+
+int XorFilterBitsBuilder::CalculateNumEntry(const uint32_t space) {
+  assert(space > 0);
+  int high = static_cast<int>(space / fingerprint_bytes_ / 1.23 + 1);
+  int n = high;
+  for (; n >= 1; n--) {
+    if (CalculateSpace(n) <= space) {
+      break;
+    }
+  }
+  assert(n < high);  // High should be an overestimation
+  return n;
+}
+
+FilterBitsReader* NewXorFilterBitsReader(const Slice& contents) {
+  assert(XorFilterBitsBuilder::IsXorFilter(contents));
+  return new XorFilterBitsReader(contents);
+}
+
+}  // namespace TERARKDB_NAMESPACE
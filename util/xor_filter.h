@@ -0,0 +1,67 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Full filter storing one fingerprint per slot in three blocks of slots,
+// a key matches if the fingerprints of its three slots xor to its own
+// fingerprint. About 1.23 slots per key, the false positive rate of 8 bit
+// fingerprints is 1/256 at 9.84 bits per key, a bloom filter needs about
+// 11.5 bits per key for it.
+//
+// +-----------------------------------------------------------------+
+// | fingerprints : 3 * block_length * fingerprint_bytes             |
+// +-----------------------------------------------------------------+
+// | seed : 8 bytes | fingerprint_bytes : 1 byte |                    |
+// +-----------------------------------------------------------------+
+// | kXorFilterMarker : 1 byte | block_length : 4 bytes              |
+// +-----------------------------------------------------------------+
+//
+// The marker is at the place of num_probes of a bloom full filter, so the
+// bloom policy reads both formats.
+class XorFilterBitsBuilder : public FilterBitsBuilder {
+ public:
+  static const char kXorFilterMarker;
+  static const uint32_t kMetaSize = 14;
+
+  // fingerprint_bytes : 1 or 2
+  explicit XorFilterBitsBuilder(size_t fingerprint_bytes);
+
+  virtual void AddKey(const Slice& key) override;
+
+  virtual Slice Finish(std::unique_ptr<const char[]>* buf) override;
+
+  virtual int CalculateNumEntry(const uint32_t space) override;
+
+  // Filter size of num_entry keys
+  uint32_t CalculateSpace(int num_entry) const;
+
+  static bool IsXorFilter(const Slice& contents) {
+    return contents.size() >= kMetaSize &&
+           contents.data()[contents.size() - 5] == kXorFilterMarker;
+  }
+
+ private:
+  size_t fingerprint_bytes_;
+  std::vector<uint64_t> hash_entries_;
+
+  // No Copy allowed
+  XorFilterBitsBuilder(const XorFilterBitsBuilder&);
+  void operator=(const XorFilterBitsBuilder&);
+};
+
+// REQUIRES: XorFilterBitsBuilder::IsXorFilter(contents)
+extern FilterBitsReader* NewXorFilterBitsReader(const Slice& contents);
+
+}  // namespace TERARKDB_NAMESPACE
@@ -44,6 +44,13 @@ Status Checkpoint::CreateCheckpoint(const std::string& /*checkpoint_dir*/,
   return Status::NotSupported("");
 }
 
+Status Checkpoint::CreateIncrementalCheckpoint(
+    const std::string& /*checkpoint_dir*/,
+    const std::string& /*base_checkpoint_dir*/,
+    uint64_t /*log_size_for_flush*/) {
+  return Status::NotSupported("");
+}
+
 void CheckpointImpl::CleanStagingDirectory(const std::string& full_private_path,
                                            Logger* info_log) {
   std::vector<std::string> subchildren;
@@ -69,6 +76,26 @@ void CheckpointImpl::CleanStagingDirectory(const std::string& full_private_path,
 // Builds an openable snapshot of RocksDB
 Status CheckpointImpl::CreateCheckpoint(const std::string& checkpoint_dir,
                                         uint64_t log_size_for_flush) {
+  return CreateCheckpointImpl(checkpoint_dir, "", log_size_for_flush);
+}
+
+Status CheckpointImpl::CreateIncrementalCheckpoint(
+    const std::string& checkpoint_dir, const std::string& base_checkpoint_dir,
+    uint64_t log_size_for_flush) {
+  if (base_checkpoint_dir.empty()) {
+    return Status::InvalidArgument("invalid base checkpoint directory name");
+  }
+  Status s = db_->GetEnv()->FileExists(base_checkpoint_dir);
+  if (!s.ok()) {
+    return s;
+  }
+  return CreateCheckpointImpl(checkpoint_dir, base_checkpoint_dir,
+                              log_size_for_flush);
+}
+
+Status CheckpointImpl::CreateCheckpointImpl(
+    const std::string& checkpoint_dir, const std::string& base_checkpoint_dir,
+    uint64_t log_size_for_flush) {
   DBOptions db_options = db_->GetDBOptions();
 
   Status s = db_->GetEnv()->FileExists(checkpoint_dir);
@@ -102,18 +129,44 @@ Status CheckpointImpl::CreateCheckpoint(const std::string& checkpoint_dir,
   // create snapshot directory
   s = db_->GetEnv()->CreateDir(full_private_path);
   uint64_t sequence_number = 0;
+  // SST files are immutable and never reuse a file number, a file of the
+  // same name and size in the base checkpoint is the same file
+  auto link_from_base = [&](const std::string& src_dirname,
+                            const std::string& fname, FileType type) {
+    if (base_checkpoint_dir.empty() || type != kTableFile) {
+      return false;
+    }
+    Env* env = db_->GetEnv();
+    std::string base_fname = base_checkpoint_dir + fname;
+    uint64_t base_size = 0, src_size = 0;
+    if (!env->GetFileSize(base_fname, &base_size).ok() ||
+        !env->GetFileSize(src_dirname + fname, &src_size).ok() ||
+        base_size != src_size) {
+      return false;
+    }
+    ROCKS_LOG_INFO(db_options.info_log, "Hard Linking %s from base",
+                   fname.c_str());
+    TEST_SYNC_POINT("CheckpointImpl::CreateCheckpoint:LinkFromBase");
+    return env->LinkFile(base_fname, full_private_path + fname).ok();
+  };
   if (s.ok()) {
     db_->DisableFileDeletions();
     s = CreateCustomCheckpoint(
         db_options,
         [&](const std::string& src_dirname, const std::string& fname,
-            FileType) {
+            FileType type) {
+          if (link_from_base(src_dirname, fname, type)) {
+            return Status::OK();
+          }
           ROCKS_LOG_INFO(db_options.info_log, "Hard Linking %s", fname.c_str());
           return db_->GetEnv()->LinkFile(src_dirname + fname,
                                          full_private_path + fname);
         } /* link_file_cb */,
         [&](const std::string& src_dirname, const std::string& fname,
-            uint64_t size_limit_bytes, FileType) {
+            uint64_t size_limit_bytes, FileType type) {
+          if (link_from_base(src_dirname, fname, type)) {
+            return Status::OK();
+          }
           ROCKS_LOG_INFO(db_options.info_log, "Copying %s", fname.c_str());
           return CopyFile(db_->GetEnv(), src_dirname + fname,
                           full_private_path + fname, size_limit_bytes,
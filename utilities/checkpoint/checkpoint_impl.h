@@ -31,6 +31,11 @@ class CheckpointImpl : public Checkpoint {
   virtual Status CreateCheckpoint(const std::string& checkpoint_dir,
                                   uint64_t log_size_for_flush) override;
 
+  using Checkpoint::CreateIncrementalCheckpoint;
+  virtual Status CreateIncrementalCheckpoint(
+      const std::string& checkpoint_dir, const std::string& base_checkpoint_dir,
+      uint64_t log_size_for_flush) override;
+
   // Checkpoint logic can be customized by providing callbacks for link, copy,
   // or create.
   Status CreateCustomCheckpoint(
@@ -49,6 +54,10 @@ class CheckpointImpl : public Checkpoint {
 
  private:
   void CleanStagingDirectory(const std::string& path, Logger* info_log);
+  // base_checkpoint_dir is empty for a full checkpoint
+  Status CreateCheckpointImpl(const std::string& checkpoint_dir,
+                              const std::string& base_checkpoint_dir,
+                              uint64_t log_size_for_flush);
   DB* db_;
 };
 
@@ -286,6 +286,47 @@ TEST_F(CheckpointTest, GetSnapshotLink) {
   }
 }
 
+TEST_F(CheckpointTest, IncrementalCheckpoint) {
+  Options options = CurrentOptions();
+  std::string inc_name = snapshot_name_ + "_inc";
+  ASSERT_OK(DestroyDB(inc_name, options));
+
+  ASSERT_OK(Put("k1", "v1"));
+  ASSERT_OK(Flush());
+  Checkpoint* checkpoint;
+  ASSERT_OK(Checkpoint::Create(db_, &checkpoint));
+  ASSERT_OK(checkpoint->CreateCheckpoint(snapshot_name_));
+  ASSERT_OK(Put("k2", "v2"));
+  ASSERT_OK(Flush());
+
+  int linked_from_base = 0;
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "CheckpointImpl::CreateCheckpoint:LinkFromBase",
+      [&](void* /*arg*/) { linked_from_base++; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_TRUE(checkpoint->CreateIncrementalCheckpoint(inc_name,
+                                                      dbname_ + "_missing")
+                  .IsNotFound());
+  ASSERT_OK(checkpoint->CreateIncrementalCheckpoint(inc_name, snapshot_name_));
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  // The sst file of k1 comes from the base checkpoint
+  ASSERT_EQ(1, linked_from_base);
+  delete checkpoint;
+
+  // The base checkpoint can go away
+  ASSERT_OK(DestroyDB(snapshot_name_, options));
+  DB* inc_db;
+  options.create_if_missing = false;
+  ASSERT_OK(DB::Open(options, inc_name, &inc_db));
+  std::string result;
+  ASSERT_OK(inc_db->Get(ReadOptions(), "k1", &result));
+  ASSERT_EQ("v1", result);
+  ASSERT_OK(inc_db->Get(ReadOptions(), "k2", &result));
+  ASSERT_EQ("v2", result);
+  delete inc_db;
+  ASSERT_OK(DestroyDB(inc_name, options));
+}
+
 TEST_F(CheckpointTest, CheckpointCF) {
   Options options = CurrentOptions();
   CreateAndReopenWithCF({"one", "two", "three", "four", "five"}, options);
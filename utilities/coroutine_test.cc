@@ -0,0 +1,171 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/utilities/coroutine.h"
+
+#ifdef ROCKSDB_HAS_COROUTINES
+
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/cache.h"
+#include "rocksdb/table.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+// A coroutine that runs to completion on its own, done is set at the end
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+struct GetResult {
+  Status status;
+  std::string value;
+  std::thread::id thread;
+};
+
+Detached DoGet(DB* db, ThreadPool* pool, std::string key,
+               std::promise<GetResult>* done) {
+  GetResult result;
+  result.status = co_await AwaitGet(db, pool, ReadOptions(), key, &result.value);
+  result.thread = std::this_thread::get_id();
+  done->set_value(std::move(result));
+}
+
+struct MultiGetResult {
+  std::vector<Status> statuses;
+  std::vector<std::string> values;
+  std::thread::id thread;
+};
+
+Detached DoMultiGet(DB* db, ThreadPool* pool, std::vector<Slice> keys,
+                    std::promise<MultiGetResult>* done) {
+  MultiGetResult result;
+  std::vector<ColumnFamilyHandle*> column_family(keys.size(),
+                                                 db->DefaultColumnFamily());
+  result.statuses = co_await AwaitMultiGet(db, pool, ReadOptions(),
+                                           column_family, keys, &result.values);
+  result.thread = std::this_thread::get_id();
+  done->set_value(std::move(result));
+}
+
+}  // namespace
+
+class CoroutineTest : public testing::Test {
+ public:
+  CoroutineTest() : pool_(NewThreadPool(1)) {
+    dbname_ = test::PerThreadDBPath("coroutine_test");
+    options_.create_if_missing = true;
+    DestroyDB(dbname_, options_);
+  }
+
+  ~CoroutineTest() {
+    db_.reset();
+    DestroyDB(dbname_, options_);
+  }
+
+  // Opens the DB with an empty block cache
+  void Reopen() {
+    db_.reset();
+    BlockBasedTableOptions table_options;
+    table_options.block_cache = NewLRUCache(1 << 20);
+    options_.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    DB* db = nullptr;
+    ASSERT_OK(DB::Open(options_, dbname_, &db));
+    db_.reset(db);
+  }
+
+  GetResult Get(const std::string& key) {
+    std::promise<GetResult> done;
+    DoGet(db_.get(), pool_.get(), key, &done);
+    return done.get_future().get();
+  }
+
+  std::string dbname_;
+  Options options_;
+  std::unique_ptr<DB> db_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+TEST_F(CoroutineTest, GetUncachedKey) {
+  Reopen();
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "va"));
+  ASSERT_OK(db_->Put(WriteOptions(), "b", "vb"));
+  ASSERT_OK(db_->Flush(FlushOptions()));
+  Reopen();
+
+  // The data block is read in the pool
+  GetResult result = Get("a");
+  ASSERT_OK(result.status);
+  ASSERT_EQ("va", result.value);
+  ASSERT_NE(std::this_thread::get_id(), result.thread);
+
+  // Now it is cached, no suspending
+  result = Get("b");
+  ASSERT_OK(result.status);
+  ASSERT_EQ("vb", result.value);
+  ASSERT_EQ(std::this_thread::get_id(), result.thread);
+
+  ASSERT_OK(db_->Put(WriteOptions(), "c", "vc"));
+  result = Get("c");
+  ASSERT_OK(result.status);
+  ASSERT_EQ("vc", result.value);
+  ASSERT_EQ(std::this_thread::get_id(), result.thread);
+
+  result = Get("a0");
+  ASSERT_TRUE(result.status.IsNotFound());
+}
+
+TEST_F(CoroutineTest, MultiGetUncachedKeys) {
+  Reopen();
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "va"));
+  ASSERT_OK(db_->Put(WriteOptions(), "b", "vb"));
+  ASSERT_OK(db_->Flush(FlushOptions()));
+  Reopen();
+  ASSERT_OK(db_->Put(WriteOptions(), "c", "vc"));
+
+  std::promise<MultiGetResult> done;
+  DoMultiGet(db_.get(), pool_.get(), {"c", "a", "missing", "b"}, &done);
+  MultiGetResult result = done.get_future().get();
+  ASSERT_NE(std::this_thread::get_id(), result.thread);
+  ASSERT_EQ(4U, result.statuses.size());
+  ASSERT_OK(result.statuses[0]);
+  ASSERT_EQ("vc", result.values[0]);
+  ASSERT_OK(result.statuses[1]);
+  ASSERT_EQ("va", result.values[1]);
+  ASSERT_TRUE(result.statuses[2].IsNotFound());
+  ASSERT_OK(result.statuses[3]);
+  ASSERT_EQ("vb", result.values[3]);
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else  // ROCKSDB_HAS_COROUTINES
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as C++20 coroutines are not supported\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_HAS_COROUTINES
@@ -0,0 +1,467 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+const char* kCacheFileSuffix = ".rcache";
+
+// The local copy of one remote file, filled block by block
+struct CachedFile {
+  enum BlockState : uint8_t { kMissing, kFetching, kCached };
+
+  CachedFile(std::string _local_name, uint64_t _file_size, size_t block_size)
+      : local_name(std::move(_local_name)),
+        file_size(_file_size),
+        blocks((_file_size + block_size - 1) / block_size, kMissing) {}
+
+  const std::string local_name;
+  const uint64_t file_size;
+  std::unique_ptr<RandomRWFile> local;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<BlockState> blocks;
+
+  // Guarded by the mutex of the env
+  uint64_t charged = 0;
+  bool evicted = false;
+};
+
+// A range of the file, in bytes
+struct Range {
+  uint64_t begin;
+  uint64_t end;
+};
+
+}  // namespace
+
+class RemoteReadCacheEnv : public EnvWrapper {
+ public:
+  RemoteReadCacheEnv(Env* remote_env, const RemoteReadCacheOptions& options)
+      : EnvWrapper(remote_env), options_(options), usage_(0) {
+    if (options_.local_env == nullptr) {
+      options_.local_env = Env::Default();
+    }
+    options_.block_size = std::max<size_t>(options_.block_size, 4096);
+    options_.max_parallel_reads = std::max(options_.max_parallel_reads, 1);
+  }
+
+  // Removes the copies of a previous env, which blocks of them are valid is
+  // not known
+  Status Init() {
+    Env* local_env = options_.local_env;
+    Status s = local_env->CreateDirIfMissing(options_.cache_dir);
+    std::vector<std::string> children;
+    if (s.ok()) {
+      s = local_env->GetChildren(options_.cache_dir, &children);
+    }
+    size_t suffix_len = strlen(kCacheFileSuffix);
+    for (size_t i = 0; s.ok() && i < children.size(); ++i) {
+      const std::string& name = children[i];
+      if (name.size() > suffix_len &&
+          name.compare(name.size() - suffix_len, suffix_len,
+                       kCacheFileSuffix) == 0) {
+        s = local_env->DeleteFile(options_.cache_dir + "/" + name);
+      }
+    }
+    return s;
+  }
+
+  Status NewRandomAccessFile(const std::string& fname,
+                             std::unique_ptr<RandomAccessFile>* result,
+                             const EnvOptions& options) override;
+
+  Status DeleteFile(const std::string& fname) override {
+    Invalidate(fname);
+    return EnvWrapper::DeleteFile(fname);
+  }
+
+  Status RenameFile(const std::string& src,
+                    const std::string& target) override {
+    Invalidate(src);
+    Invalidate(target);
+    return EnvWrapper::RenameFile(src, target);
+  }
+
+  const RemoteReadCacheOptions& options() const { return options_; }
+
+  // Accounts bytes newly cached in file, and removes the least recently used
+  // copies beyond the capacity
+  void Charge(CachedFile* file, uint64_t bytes);
+
+ private:
+  typedef std::list<std::string> LRUList;
+  struct Entry {
+    std::shared_ptr<CachedFile> file;
+    LRUList::iterator lru_pos;
+  };
+
+  std::string LocalName(const std::string& fname) const {
+    std::string name = options_.cache_dir + "/";
+    for (char c : fname) {
+      if (c == '/' || c == '%') {
+        char buf[4];
+        snprintf(buf, sizeof(buf), "%%%02X", c);
+        name.append(buf);
+      } else {
+        name.push_back(c);
+      }
+    }
+    return name + kCacheFileSuffix;
+  }
+
+  // Called with mutex_ held. The readers of the file keep their open copy,
+  // they no longer charge the env.
+  void Evict(std::unordered_map<std::string, Entry>::iterator it) {
+    CachedFile* file = it->second.file.get();
+    file->evicted = true;
+    usage_ -= file->charged;
+    options_.local_env->DeleteFile(file->local_name);
+    lru_.erase(it->second.lru_pos);
+    files_.erase(it);
+  }
+
+  void Invalidate(const std::string& fname) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(fname);
+    if (it != files_.end()) {
+      Evict(it);
+    }
+  }
+
+  RemoteReadCacheOptions options_;
+
+  std::mutex mutex_;
+  // Most recently used first
+  LRUList lru_;
+  std::unordered_map<std::string, Entry> files_;
+  uint64_t usage_;
+};
+
+namespace {
+
+class CachedRandomAccessFile : public RandomAccessFile {
+ public:
+  CachedRandomAccessFile(RemoteReadCacheEnv* env,
+                         std::unique_ptr<RandomAccessFile>&& remote,
+                         std::shared_ptr<CachedFile> file)
+      : env_(env),
+        remote_(std::move(remote)),
+        file_(std::move(file)),
+        next_offset_(0) {}
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    if (offset >= file_->file_size) {
+      *result = Slice(scratch, 0);
+      return Status::OK();
+    }
+    uint64_t end = offset + std::min<uint64_t>(n, file_->file_size - offset);
+    // A read continuing the previous one fetches ahead
+    uint64_t readahead_end = 0;
+    if (offset == next_offset_.exchange(end, std::memory_order_relaxed)) {
+      readahead_end =
+          std::min(file_->file_size, end + env_->options().readahead_size);
+    }
+    return ReadCached(offset, n, result, scratch, readahead_end);
+  }
+
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) override {
+    std::vector<Range> ranges;
+    ranges.reserve(num_reqs);
+    for (size_t i = 0; i < num_reqs; ++i) {
+      uint64_t begin = std::min(reqs[i].offset, file_->file_size);
+      ranges.push_back(
+          Range{begin, std::min(begin + reqs[i].len, file_->file_size)});
+    }
+    std::sort(ranges.begin(), ranges.end(),
+              [](const Range& a, const Range& b) { return a.begin < b.begin; });
+    // The statuses of the requests tell which ones failed
+    Fetch(ranges.data(), ranges.size(), 0);
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      req.status =
+          ReadCached(req.offset, req.len, &req.result, req.scratch, 0);
+    }
+    return Status::OK();
+  }
+
+  Status Prefetch(uint64_t offset, size_t n) override {
+    if (offset >= file_->file_size) {
+      return Status::OK();
+    }
+    Range range{offset, std::min<uint64_t>(offset + n, file_->file_size)};
+    return Fetch(&range, 1, 0);
+  }
+
+  size_t GetUniqueId(char* id, size_t max_size) const override {
+    return remote_->GetUniqueId(id, max_size);
+  }
+
+ private:
+  Status ReadCached(uint64_t offset, size_t n, Slice* result, char* scratch,
+                    uint64_t readahead_end) const {
+    if (offset >= file_->file_size) {
+      *result = Slice(scratch, 0);
+      return Status::OK();
+    }
+    n = static_cast<size_t>(std::min<uint64_t>(n, file_->file_size - offset));
+    Range range{offset, offset + n};
+    Status s = Fetch(&range, 1, readahead_end);
+    if (s.ok()) {
+      s = file_->local->Read(offset, n, result, scratch);
+    }
+    return s;
+  }
+
+  // Caches the blocks of the sorted ranges, and of the ones up to
+  // readahead_end on a best effort basis
+  Status Fetch(const Range* ranges, size_t num_ranges,
+               uint64_t readahead_end) const {
+    const uint64_t block_size = env_->options().block_size;
+    // The runs of missing blocks, coalesced
+    std::vector<Range> runs;
+    {
+      std::lock_guard<std::mutex> lock(file_->mutex);
+      auto claim = [&](uint64_t begin, uint64_t end) {
+        for (uint64_t b = begin / block_size; b * block_size < end; ++b) {
+          if (file_->blocks[b] != CachedFile::kMissing) {
+            continue;
+          }
+          file_->blocks[b] = CachedFile::kFetching;
+          if (!runs.empty() && runs.back().end == b) {
+            ++runs.back().end;
+          } else {
+            runs.push_back(Range{b, b + 1});
+          }
+        }
+      };
+      for (size_t i = 0; i < num_ranges; ++i) {
+        claim(ranges[i].begin, ranges[i].end);
+      }
+      // Read ahead a whole window once the reads reach the end of the
+      // previous one, rather than a block at a time
+      if (num_ranges > 0) {
+        uint64_t next = (ranges[num_ranges - 1].end + block_size - 1) /
+                        block_size * block_size;
+        if (next < readahead_end &&
+            file_->blocks[next / block_size] == CachedFile::kMissing) {
+          claim(next, readahead_end);
+        }
+      }
+    }
+    Status s = FetchRuns(&runs);
+
+    // Wait for the blocks other reads are fetching
+    std::unique_lock<std::mutex> lock(file_->mutex);
+    for (size_t i = 0; i < num_ranges; ++i) {
+      for (uint64_t b = ranges[i].begin / block_size;
+           b * block_size < ranges[i].end; ++b) {
+        file_->cv.wait(lock, [&] {
+          return file_->blocks[b] != CachedFile::kFetching;
+        });
+        if (file_->blocks[b] != CachedFile::kCached) {
+          return s.ok() ? Status::IOError("Failed to fetch remote block")
+                        : s;
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  // Splits the runs of blocks into at most max_parallel_reads ranged reads
+  // of similar size, and issues them at the same time
+  Status FetchRuns(std::vector<Range>* runs) const {
+    if (runs->empty()) {
+      return Status::OK();
+    }
+    const size_t max_parallel_reads = env_->options().max_parallel_reads;
+    uint64_t num_blocks = 0;
+    for (auto& run : *runs) {
+      num_blocks += run.end - run.begin;
+    }
+    uint64_t max_blocks =
+        (num_blocks + max_parallel_reads - 1) / max_parallel_reads;
+    std::vector<Range> reads;
+    for (auto& run : *runs) {
+      for (uint64_t b = run.begin; b < run.end; b += max_blocks) {
+        reads.push_back(Range{b, std::min(b + max_blocks, run.end)});
+      }
+    }
+
+    std::vector<Status> statuses(reads.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+      for (size_t i; (i = next.fetch_add(1)) < reads.size();) {
+        statuses[i] = FetchBlocks(reads[i].begin, reads[i].end);
+      }
+    };
+    std::vector<port::Thread> threads;
+    size_t num_threads = std::min(reads.size(), max_parallel_reads);
+    for (size_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+      t.join();
+    }
+    for (auto& s : statuses) {
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    return Status::OK();
+  }
+
+  // Reads the blocks [begin, end) from the remote file into the local copy
+  Status FetchBlocks(uint64_t begin, uint64_t end) const {
+    const uint64_t block_size = env_->options().block_size;
+    uint64_t offset = begin * block_size;
+    size_t len = static_cast<size_t>(
+        std::min(end * block_size, file_->file_size) - offset);
+    std::unique_ptr<char[]> buf(new char[len]);
+    size_t done = 0;
+    Status s;
+    while (s.ok() && done < len) {
+      Slice data;
+      s = remote_->Read(offset + done, len - done, &data, buf.get() + done);
+      if (s.ok() && data.empty()) {
+        s = Status::Corruption("Remote file is shorter than expected");
+      }
+      if (s.ok() && data.data() != buf.get() + done) {
+        memmove(buf.get() + done, data.data(), data.size());
+      }
+      done += data.size();
+    }
+    if (s.ok()) {
+      s = file_->local->Write(offset, Slice(buf.get(), len));
+    }
+    {
+      std::lock_guard<std::mutex> lock(file_->mutex);
+      for (uint64_t b = begin; b < end; ++b) {
+        file_->blocks[b] = s.ok() ? CachedFile::kCached : CachedFile::kMissing;
+      }
+    }
+    file_->cv.notify_all();
+    if (s.ok()) {
+      env_->Charge(file_.get(), len);
+    }
+    return s;
+  }
+
+  RemoteReadCacheEnv* env_;
+  std::unique_ptr<RandomAccessFile> remote_;
+  std::shared_ptr<CachedFile> file_;
+  // Where the last read ended
+  mutable std::atomic<uint64_t> next_offset_;
+};
+
+}  // namespace
+
+Status RemoteReadCacheEnv::NewRandomAccessFile(
+    const std::string& fname, std::unique_ptr<RandomAccessFile>* result,
+    const EnvOptions& options) {
+  std::unique_ptr<RandomAccessFile> remote;
+  uint64_t file_size = 0;
+  Status s = EnvWrapper::NewRandomAccessFile(fname, &remote, options);
+  if (s.ok()) {
+    s = EnvWrapper::GetFileSize(fname, &file_size);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  std::shared_ptr<CachedFile> file;
+  // Creating the local copy is held under the mutex, so that two threads
+  // opening the same file do not truncate the copy of each other
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = files_.find(fname);
+  if (it != files_.end() && it->second.file->file_size != file_size) {
+    Evict(it);
+    it = files_.end();
+  }
+  if (it != files_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    file = it->second.file;
+  } else {
+    Env* local_env = options_.local_env;
+    file = std::make_shared<CachedFile>(LocalName(fname), file_size,
+                                        options_.block_size);
+    std::unique_ptr<WritableFile> writable;
+    EnvOptions local_options;
+    s = local_env->NewWritableFile(file->local_name, &writable, local_options);
+    if (s.ok()) {
+      s = writable->Close();
+    }
+    if (s.ok()) {
+      s = local_env->NewRandomRWFile(file->local_name, &file->local,
+                                     local_options);
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    lru_.push_front(fname);
+    files_[fname] = Entry{file, lru_.begin()};
+  }
+  result->reset(new CachedRandomAccessFile(this, std::move(remote), file));
+  return Status::OK();
+}
+
+void RemoteReadCacheEnv::Charge(CachedFile* file, uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file->evicted) {
+    return;
+  }
+  file->charged += bytes;
+  usage_ += bytes;
+  while (usage_ > options_.capacity && lru_.size() > 1) {
+    auto it = files_.find(lru_.back());
+    assert(it != files_.end());
+    if (it->second.file.get() == file) {
+      break;
+    }
+    Evict(it);
+  }
+}
+
+Status NewRemoteReadCacheEnv(Env* remote_env,
+                             const RemoteReadCacheOptions& options,
+                             Env** result) {
+  if (options.cache_dir.empty()) {
+    return Status::InvalidArgument("cache_dir is empty");
+  }
+  std::unique_ptr<RemoteReadCacheEnv> env(
+      new RemoteReadCacheEnv(remote_env, options));
+  Status s = env->Init();
+  if (s.ok()) {
+    *result = env.release();
+  }
+  return s;
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,178 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+// Counts the reads of the files it opens
+class CountingEnv : public EnvWrapper {
+ public:
+  explicit CountingEnv(Env* base) : EnvWrapper(base) {}
+
+  Status NewRandomAccessFile(const std::string& fname,
+                             std::unique_ptr<RandomAccessFile>* result,
+                             const EnvOptions& options) override {
+    class CountingFile : public RandomAccessFileWrapper {
+     public:
+      CountingFile(std::unique_ptr<RandomAccessFile>&& target,
+                   std::atomic<int>* reads)
+          : RandomAccessFileWrapper(target.get()),
+            target_(std::move(target)),
+            reads_(reads) {}
+
+      Status Read(uint64_t offset, size_t n, Slice* result,
+                  char* scratch) const override {
+        ++*reads_;
+        return RandomAccessFileWrapper::Read(offset, n, result, scratch);
+      }
+
+     private:
+      std::unique_ptr<RandomAccessFile> target_;
+      std::atomic<int>* reads_;
+    };
+    std::unique_ptr<RandomAccessFile> target;
+    Status s = EnvWrapper::NewRandomAccessFile(fname, &target, options);
+    if (s.ok()) {
+      result->reset(new CountingFile(std::move(target), &reads));
+    }
+    return s;
+  }
+
+  std::atomic<int> reads{0};
+};
+}  // namespace
+
+class RemoteReadCacheEnvTest : public testing::Test {
+ public:
+  RemoteReadCacheEnvTest() : remote_env_(Env::Default()) {
+    dir_ = test::PerThreadDBPath("remote_read_cache_env_test");
+    Env::Default()->CreateDirIfMissing(dir_);
+    fname_ = dir_ + "/remote_file";
+    RemoteReadCacheOptions options;
+    options.cache_dir = dir_ + "/cache";
+    options.block_size = 4096;
+    options.readahead_size = 4 * 4096;
+    options.max_parallel_reads = 2;
+    Env* env = nullptr;
+    EXPECT_OK(NewRemoteReadCacheEnv(&remote_env_, options, &env));
+    env_.reset(env);
+  }
+
+  void WriteRemoteFile(size_t size) {
+    data_.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      data_[i] = static_cast<char>(i * 7 + i / 4096);
+    }
+    ASSERT_OK(WriteStringToFile(Env::Default(), data_, fname_));
+  }
+
+  void CheckRead(RandomAccessFile* file, uint64_t offset, size_t n) {
+    std::string scratch(n, '\0');
+    Slice result;
+    ASSERT_OK(file->Read(offset, n, &result, &scratch[0]));
+    ASSERT_EQ(data_.substr(offset, n), result.ToString());
+  }
+
+  CountingEnv remote_env_;
+  std::unique_ptr<Env> env_;
+  std::string dir_;
+  std::string fname_;
+  std::string data_;
+};
+
+TEST_F(RemoteReadCacheEnvTest, ReadThrough) {
+  WriteRemoteFile(100 * 4096 + 123);
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname_, &file, EnvOptions()));
+
+  CheckRead(file.get(), 50 * 4096 + 10, 3 * 4096);
+  int reads = remote_env_.reads;
+  ASSERT_GT(reads, 0);
+  // Cached blocks are not fetched again, even by another reader
+  CheckRead(file.get(), 50 * 4096 + 100, 4096);
+  std::unique_ptr<RandomAccessFile> file2;
+  ASSERT_OK(env_->NewRandomAccessFile(fname_, &file2, EnvOptions()));
+  CheckRead(file2.get(), 51 * 4096, 4096);
+  ASSERT_EQ(reads, remote_env_.reads.load());
+
+  // The partial last block
+  CheckRead(file.get(), 100 * 4096, 123);
+  Slice result;
+  char scratch[10];
+  ASSERT_OK(file->Read(data_.size(), 10, &result, scratch));
+  ASSERT_TRUE(result.empty());
+
+  // Deleting the remote file drops the copy
+  file.reset();
+  file2.reset();
+  ASSERT_OK(env_->DeleteFile(fname_));
+  WriteRemoteFile(10 * 4096);
+  ASSERT_OK(env_->NewRandomAccessFile(fname_, &file, EnvOptions()));
+  CheckRead(file.get(), 0, 10 * 4096);
+}
+
+TEST_F(RemoteReadCacheEnvTest, ReadaheadAndMultiRead) {
+  WriteRemoteFile(64 * 4096);
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname_, &file, EnvOptions()));
+
+  // Sequential reads fetch a window of 4 blocks ahead, with 2 ranged reads
+  int reads = remote_env_.reads;
+  for (uint64_t offset = 0; offset < 9 * 4096; offset += 100) {
+    CheckRead(file.get(), offset, 100);
+  }
+  ASSERT_EQ(reads + 6, remote_env_.reads.load());
+
+  // Adjacent requests are coalesced, and their reads overlap
+  std::vector<std::string> scratches(3, std::string(4096, '\0'));
+  std::vector<ReadRequest> reqs(3);
+  uint64_t offsets[] = {30 * 4096, 20 * 4096, 21 * 4096};
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    reqs[i].offset = offsets[i];
+    reqs[i].len = 4096;
+    reqs[i].scratch = &scratches[i][0];
+  }
+  reads = remote_env_.reads;
+  ASSERT_OK(file->MultiRead(reqs.data(), reqs.size()));
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    ASSERT_OK(reqs[i].status);
+    ASSERT_EQ(data_.substr(offsets[i], 4096), reqs[i].result.ToString());
+  }
+  ASSERT_EQ(reads + 2, remote_env_.reads.load());
+
+  ASSERT_OK(file->Prefetch(40 * 4096, 8 * 4096));
+  reads = remote_env_.reads;
+  CheckRead(file.get(), 44 * 4096, 4096);
+  ASSERT_EQ(reads, remote_env_.reads.load());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else  // ROCKSDB_LITE
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr,
+          "SKIPPED as RemoteReadCacheEnv is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_LITE
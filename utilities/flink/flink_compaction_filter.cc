@@ -5,9 +5,12 @@
 
 #include "utilities/flink/flink_compaction_filter.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <iostream>
 
+#include "port/port.h"
 #include "rocksdb/terark_namespace.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -15,13 +18,30 @@ namespace flink {
 
 int64_t DeserializeTimestamp(const char* src, std::size_t offset) {
   uint64_t result = 0;
+#if defined(__GNUC__)
+  memcpy(&result, src + offset, sizeof(result));
+  if (port::kLittleEndian) {
+    result = __builtin_bswap64(result);
+  }
+#else
   for (unsigned long i = 0; i < sizeof(uint64_t); i++) {
     result |= static_cast<uint64_t>(static_cast<unsigned char>(src[offset + i]))
               << ((sizeof(int64_t) - 1 - i) * BITS_PER_BYTE);
   }
+#endif
   return static_cast<int64_t>(result);
 }
 
+static std::size_t DeserializeElementLength(const char* src,
+                                            std::size_t offset) {
+  uint32_t result = 0;
+  for (std::size_t i = 0; i < LIST_ELEMENT_HEADER_SIZE; i++) {
+    result = (result << BITS_PER_BYTE) |
+             static_cast<unsigned char>(src[offset + i]);
+  }
+  return result;
+}
+
 CompactionFilter::Decision Decide(const char* ts_bytes, const int64_t ttl,
                                   const std::size_t timestamp_offset,
                                   const int64_t current_timestamp,
@@ -38,6 +58,42 @@ CompactionFilter::Decision Decide(const char* ts_bytes, const int64_t ttl,
              : CompactionFilter::Decision::kKeep;
 }
 
+namespace {
+// Decides the expiration of the list elements like Decide() does. When ttl
+// and current_timestamp leave no room for overflow, which is the usual case,
+// an element is expired iff its timestamp is not after current_timestamp -
+// ttl, one comparison per element without logging.
+class ExpiryCheck {
+ public:
+  ExpiryCheck(int64_t ttl, int64_t current_timestamp,
+              const std::shared_ptr<Logger>& logger)
+      : ttl_(ttl),
+        current_timestamp_(current_timestamp),
+        logger_(logger),
+        fast_(ttl >= 0 && current_timestamp != JAVA_MAX_LONG &&
+              current_timestamp >= JAVA_MIN_LONG + ttl),
+        threshold_(fast_ ? current_timestamp - ttl : 0) {}
+
+  bool Expired(const char* list, std::size_t timestamp_offset) const {
+    if (fast_) {
+      return DeserializeTimestamp(list, timestamp_offset) <= threshold_;
+    }
+    return Decide(list, ttl_, timestamp_offset, current_timestamp_,
+                  logger_) != CompactionFilter::Decision::kKeep;
+  }
+
+ private:
+  const int64_t ttl_;
+  const int64_t current_timestamp_;
+  const std::shared_ptr<Logger>& logger_;
+  const bool fast_;
+  const int64_t threshold_;
+};
+
+// Elements whose expiration is checked together by the fixed size scan
+const std::size_t kExpiryScanBatch = 4;
+}  // namespace
+
 FlinkCompactionFilter::ConfigHolder::ConfigHolder()
     : config_(const_cast<FlinkCompactionFilter::Config*>(&DISABLED_CONFIG)){};
 
@@ -69,19 +125,65 @@ FlinkCompactionFilter::ConfigHolder::GetConfig() {
 
 std::size_t FlinkCompactionFilter::FixedListElementFilter::NextUnexpiredOffset(
     const Slice& list, int64_t ttl, int64_t current_timestamp) const {
+  if (list.size() >= JAVA_MAX_SIZE) {
+    return JAVA_MAX_SIZE;
+  }
+  ExpiryCheck check(ttl, current_timestamp, logger_);
+  const std::size_t timestamp_end = timestamp_offset_ + TIMESTAMP_BYTE_SIZE;
+  std::size_t offset = 0;
+  // Whole batches of expired elements, their timestamps are independent so
+  // they are decoded and compared without a branch per element
+  const std::size_t batch_size = fixed_size_ * kExpiryScanBatch;
+  while (fixed_size_ >= timestamp_end &&
+         list.size() - offset >= batch_size) {
+    bool expired = true;
+    for (std::size_t i = 0; i < kExpiryScanBatch; i++) {
+      expired &= check.Expired(list.data(),
+                               offset + i * fixed_size_ + timestamp_offset_);
+    }
+    if (!expired) {
+      break;
+    }
+    offset += batch_size;
+  }
+  while (offset < list.size()) {
+    if (list.size() - offset < timestamp_end ||
+        !check.Expired(list.data(), offset + timestamp_offset_)) {
+      break;
+    }
+    std::size_t new_offset = offset + fixed_size_;
+    if (new_offset >= JAVA_MAX_SIZE || new_offset < offset) {
+      return JAVA_MAX_SIZE;
+    }
+    offset = new_offset;
+  }
+  return offset;
+}
+
+std::size_t
+FlinkCompactionFilter::LengthPrefixedListElementFilter::NextUnexpiredOffset(
+    const Slice& list, int64_t ttl, int64_t current_timestamp) const {
+  if (list.size() >= JAVA_MAX_SIZE) {
+    return JAVA_MAX_SIZE;
+  }
+  ExpiryCheck check(ttl, current_timestamp, logger_);
   std::size_t offset = 0;
   while (offset < list.size()) {
-    Decision decision = Decide(list.data(), ttl, offset + timestamp_offset_,
-                               current_timestamp, logger_);
-    if (decision != Decision::kKeep) {
-      std::size_t new_offset = offset + fixed_size_;
-      if (new_offset >= JAVA_MAX_SIZE || new_offset < offset) {
-        return JAVA_MAX_SIZE;
-      }
-      offset = new_offset;
-    } else {
+    std::size_t begin = offset + LIST_ELEMENT_HEADER_SIZE;
+    std::size_t length = begin <= list.size()
+                             ? DeserializeElementLength(list.data(), offset)
+                             : 0;
+    if (begin > list.size() || length > list.size() - begin ||
+        length < timestamp_offset_ + TIMESTAMP_BYTE_SIZE) {
+      Error(logger_.get(),
+            "Wrong list element at %" ROCKSDB_PRIszt ", length %" ROCKSDB_PRIszt,
+            offset, length);
+      return JAVA_MAX_SIZE;
+    }
+    if (!check.Expired(list.data(), begin + timestamp_offset_)) {
       break;
     }
+    offset = begin + length;
   }
   return offset;
 }
@@ -25,6 +25,9 @@ static const std::size_t TIMESTAMP_BYTE_SIZE = static_cast<std::size_t>(8);
 static const int64_t JAVA_MIN_LONG = static_cast<int64_t>(0x8000000000000000);
 static const int64_t JAVA_MAX_LONG = static_cast<int64_t>(0x7fffffffffffffff);
 static const std::size_t JAVA_MAX_SIZE = static_cast<std::size_t>(0x7fffffff);
+// Big endian byte length of the element in front of each element of a length
+// prefixed list
+static const std::size_t LIST_ELEMENT_HEADER_SIZE = static_cast<std::size_t>(4);
 
 /**
  * Compaction filter for removing expired Flink state entries with ttl.
@@ -80,6 +83,23 @@ class FlinkCompactionFilter : public CompactionFilter {
     std::shared_ptr<Logger> logger_;
   };
 
+  // this filter operates natively on list state whose elements have a
+  // variable byte length, each element being prefixed by its big endian
+  // 4 byte length, see LIST_ELEMENT_HEADER_SIZE. timestamp_offset is the
+  // position of the last access timestamp after the header.
+  class LengthPrefixedListElementFilter : public ListElementFilter {
+   public:
+    explicit LengthPrefixedListElementFilter(std::size_t timestamp_offset,
+                                             std::shared_ptr<Logger> logger)
+        : timestamp_offset_(timestamp_offset), logger_(std::move(logger)) {}
+    std::size_t NextUnexpiredOffset(const Slice& list, int64_t ttl,
+                                    int64_t current_timestamp) const override;
+
+   private:
+    std::size_t timestamp_offset_;
+    std::shared_ptr<Logger> logger_;
+  };
+
   // Factory is needed to create one filter per filter/thread
   // and avoid concurrent access to the filter state
   class ListElementFilterFactory {
@@ -104,6 +124,21 @@ class FlinkCompactionFilter : public CompactionFilter {
     std::size_t timestamp_offset_;
   };
 
+  class LengthPrefixedListElementFilterFactory
+      : public ListElementFilterFactory {
+   public:
+    explicit LengthPrefixedListElementFilterFactory(
+        std::size_t timestamp_offset)
+        : timestamp_offset_(timestamp_offset) {}
+    LengthPrefixedListElementFilter* CreateListElementFilter(
+        std::shared_ptr<Logger> logger) const override {
+      return new LengthPrefixedListElementFilter(timestamp_offset_, logger);
+    };
+
+   private:
+    std::size_t timestamp_offset_;
+  };
+
   struct Config {
     StateType state_type_;
     std::size_t timestamp_offset_;
@@ -214,6 +214,78 @@ TEST(FlinkListStateTtlTest, HalfExpired) {  // NOLINT
   Deinit();
 }
 
+// A list of num_elements fixed size elements, the first num_expired expired
+std::string MakeFixedList(size_t num_elements, size_t num_expired) {
+  std::string list(num_elements * LIST_ELEM_FIXED_LEN, 'x');
+  for (size_t i = 0; i < num_elements; i++) {
+    SetTimestamp(i < num_expired ? time - ttl - 20 : time,
+                 i * LIST_ELEM_FIXED_LEN, &list[0]);
+  }
+  return list;
+}
+
+// Length prefixed elements holding their timestamp first, and one more
+// byte per element than the previous one
+std::string MakeLengthPrefixedList(size_t num_elements, size_t num_expired) {
+  std::string list;
+  for (size_t i = 0; i < num_elements; i++) {
+    size_t length = TIMESTAMP_BYTE_SIZE + i;
+    char header[LIST_ELEMENT_HEADER_SIZE] = {0, 0, 0,
+                                             static_cast<char>(length)};
+    list.append(header, LIST_ELEMENT_HEADER_SIZE);
+    size_t offset = list.size();
+    list.append(length, 'x');
+    SetTimestamp(i < num_expired ? time - ttl - 20 : time, offset, &list[0]);
+  }
+  return list;
+}
+
+CompactionFilter::Decision decideList(const std::string& list) {
+  return filter->FilterV2(0, key, KMERGE, nullptr, LazyBuffer(Slice(list)),
+                          &new_list, &stub);
+}
+
+TEST(FlinkListStateTtlTest, FixedListBatchScan) {  // NOLINT
+  time = rnd(mt);
+  Init(LIST, KMERGE,
+       new FlinkCompactionFilter::FixedListElementFilterFactory(
+           LIST_ELEM_FIXED_LEN, static_cast<std::size_t>(0)),
+       0);
+  for (size_t num_expired = 0; num_expired <= 11; num_expired++) {
+    std::string list = MakeFixedList(11, num_expired);
+    if (num_expired == 0) {
+      EXPECT_EQ(decideList(list), KKEEP);
+    } else if (num_expired == 11) {
+      EXPECT_EQ(decideList(list), KREMOVE);
+    } else {
+      EXPECT_EQ(decideList(list), KCHANGE);
+      EXPECT_EQ(list.substr(num_expired * LIST_ELEM_FIXED_LEN),
+                new_list.ToString());
+    }
+  }
+  Deinit();
+}
+
+TEST(FlinkListStateTtlTest, LengthPrefixedList) {  // NOLINT
+  time = rnd(mt);
+  Init(LIST, KMERGE,
+       new FlinkCompactionFilter::LengthPrefixedListElementFilterFactory(
+           static_cast<std::size_t>(0)),
+       LIST_ELEMENT_HEADER_SIZE);
+  EXPECT_EQ(decideList(MakeLengthPrefixedList(5, 0)), KKEEP);
+  EXPECT_EQ(decideList(MakeLengthPrefixedList(5, 5)), KREMOVE);
+  std::string list = MakeLengthPrefixedList(5, 2);
+  EXPECT_EQ(decideList(list), KCHANGE);
+  size_t expired_size = 2 * (LIST_ELEMENT_HEADER_SIZE + TIMESTAMP_BYTE_SIZE) + 1;
+  EXPECT_EQ(list.substr(expired_size), new_list.ToString());
+
+  // A truncated element keeps the list
+  list = MakeLengthPrefixedList(3, 3);
+  list.resize(list.size() - 1);
+  EXPECT_EQ(decideList(list), KKEEP);
+  Deinit();
+}
+
 // TEST(FlinkListStateTtlTest, WrongFilterValueType) {  // NOLINT
 //   InitList(KBLOB, true);
 //   EXPECT_EQ(decide(), KKEEP);
@@ -195,6 +195,8 @@ TEST_F(MemoryTest, MemTableAndTableReadersTotal) {
               usage_history_[MemoryUtil::kMemTableUnFlushed][i - 1]);
     ASSERT_EQ(usage_history_[MemoryUtil::kTableReadersTotal][i],
               usage_history_[MemoryUtil::kTableReadersTotal][i - 1]);
+    // Skip list memtables keep everything in their arenas
+    ASSERT_EQ(0, usage_history_[MemoryUtil::kMemTableRepTotal][i]);
   }
 
   size_t usage_check_point = usage_history_[MemoryUtil::kMemTableTotal].size();
@@ -227,6 +229,11 @@ TEST_F(MemoryTest, MemTableAndTableReadersTotal) {
     // as we flush tables.
     ASSERT_GT(usage_history_[MemoryUtil::kTableReadersTotal][i],
               usage_history_[MemoryUtil::kTableReadersTotal][i - 1]);
+    // The index blocks are held by the table readers
+    ASSERT_GT(usage_history_[MemoryUtil::kTableIndexTotal][i],
+              usage_history_[MemoryUtil::kTableIndexTotal][i - 1]);
+    ASSERT_LE(usage_history_[MemoryUtil::kTableIndexTotal][i],
+              usage_history_[MemoryUtil::kTableReadersTotal][i]);
     ASSERT_GT(usage_history_[MemoryUtil::kCacheTotal][i],
               usage_history_[MemoryUtil::kCacheTotal][i - 1]);
   }
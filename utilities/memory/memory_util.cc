@@ -29,6 +29,10 @@ Status MemoryUtil::GetApproximateMemoryUsageByType(
                                      &usage)) {
       (*usage_by_type)[MemoryUtil::kMemTableUnFlushed] += usage;
     }
+    if (db->GetAggregatedIntProperty(DB::Properties::kCurSizeAllMemTableReps,
+                                     &usage)) {
+      (*usage_by_type)[MemoryUtil::kMemTableRepTotal] += usage;
+    }
   }
 
   // Table Readers
@@ -38,6 +42,22 @@ Status MemoryUtil::GetApproximateMemoryUsageByType(
                                      &usage)) {
       (*usage_by_type)[MemoryUtil::kTableReadersTotal] += usage;
     }
+    if (db->GetAggregatedIntProperty(DB::Properties::kEstimateTableIndexMem,
+                                     &usage)) {
+      (*usage_by_type)[MemoryUtil::kTableIndexTotal] += usage;
+    }
+    if (db->GetAggregatedIntProperty(DB::Properties::kEstimateTableDictMem,
+                                     &usage)) {
+      (*usage_by_type)[MemoryUtil::kTableDictTotal] += usage;
+    }
+    if (db->GetAggregatedIntProperty(DB::Properties::kEstimateBlobReferenceMem,
+                                     &usage)) {
+      (*usage_by_type)[MemoryUtil::kBlobReferenceTotal] += usage;
+    }
+    if (db->GetAggregatedIntProperty(DB::Properties::kTableBuilderMem,
+                                     &usage)) {
+      (*usage_by_type)[MemoryUtil::kTableBuilderTotal] += usage;
+    }
   }
 
   // Cache
@@ -0,0 +1,203 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "rocksdb/utilities/options_auto_tuner.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/logging.h"
+#include "util/string_util.h"
+#include "util/timer.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+// The write stalls caused by compaction debt, which the separation options
+// move, the memtable ones are left out
+uint64_t CompactionStallCount(DB* db, ColumnFamilyHandle* column_family) {
+  std::map<std::string, std::string> stats;
+  if (!db->GetMapProperty(column_family, DB::Properties::kCFStats, &stats)) {
+    return 0;
+  }
+  uint64_t count = 0;
+  for (const char* name :
+       {"io_stalls.level0_slowdown", "io_stalls.level0_numfiles",
+        "io_stalls.stop_for_pending_compaction_bytes",
+        "io_stalls.slowdown_for_pending_compaction_bytes"}) {
+    auto find = stats.find(name);
+    if (find != stats.end()) {
+      count += ParseUint64(find->second);
+    }
+  }
+  return count;
+}
+
+class OptionsAutoTunerImpl : public OptionsAutoTuner {
+ public:
+  OptionsAutoTunerImpl(DB* db,
+                       const std::vector<ColumnFamilyHandle*>& column_families,
+                       const OptionsAutoTunerOptions& options)
+      : db_(db),
+        column_families_(column_families),
+        options_(options),
+        info_log_(db->GetDBOptions().info_log) {
+    for (auto column_family : column_families_) {
+      stall_counts_.push_back(CompactionStallCount(db_, column_family));
+    }
+    if (options_.period_sec > 0) {
+      static std::atomic<uint64_t> next_task_id(0);
+      uint64_t period_us = options_.period_sec * 1000000;
+      timer_ = Timer::Shared(db_->GetEnv());
+      task_name_ = "options_auto_tuner:" + ToString(next_task_id++);
+      timer_->Add([this] { Tune(); }, task_name_, period_us, period_us);
+    }
+  }
+
+  ~OptionsAutoTunerImpl() {
+    if (timer_ != nullptr) {
+      timer_->Cancel(task_name_);
+    }
+  }
+
+  Status Tune() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Status result;
+    for (size_t i = 0; i < column_families_.size(); ++i) {
+      Status s = TuneColumnFamily(i);
+      if (result.ok()) {
+        result = s;
+      }
+    }
+    return result;
+  }
+
+ private:
+  // Moves value a step towards direction, within [min, max]. Options without
+  // bounds keep their value
+  double Step(double value, double min, double max, int direction,
+              bool integer) const {
+    if (!(max > min) || direction == 0) {
+      return value;
+    }
+    if (direction > 0) {
+      value *= options_.step;
+      value = integer ? std::ceil(value) : value;
+    } else {
+      value /= options_.step;
+      value = integer ? std::floor(value) : value;
+    }
+    return std::min(max, std::max(min, value));
+  }
+
+  Status TuneColumnFamily(size_t i) {
+    ColumnFamilyHandle* column_family = column_families_[i];
+    uint64_t blob_files_size = 0;
+    uint64_t blob_garbage_size = 0;
+    uint64_t read_amp_debt = 0;
+    db_->GetIntProperty(column_family, DB::Properties::kTotalBlobFilesSize,
+                        &blob_files_size);
+    db_->GetIntProperty(column_family,
+                        DB::Properties::kEstimateBlobGarbageSize,
+                        &blob_garbage_size);
+    db_->GetIntProperty(column_family, DB::Properties::kReadAmpDebt,
+                        &read_amp_debt);
+    uint64_t stall_count = CompactionStallCount(db_, column_family);
+    bool stalled = stall_count > stall_counts_[i];
+    stall_counts_[i] = stall_count;
+    double garbage_ratio =
+        blob_files_size == 0 ? 0 : double(blob_garbage_size) / blob_files_size;
+    bool garbage_above_target =
+        garbage_ratio > options_.target_blob_garbage_ratio;
+    bool garbage_below_target =
+        blob_files_size > 0 &&
+        garbage_ratio < options_.target_blob_garbage_ratio / 2;
+
+    ColumnFamilyOptions current = db_->GetOptions(column_family);
+    std::unordered_map<std::string, std::string> changes;
+
+    double blob_gc_ratio =
+        Step(current.blob_gc_ratio, options_.min_blob_gc_ratio,
+             options_.max_blob_gc_ratio,
+             garbage_above_target ? -1 : garbage_below_target ? 1 : 0, false);
+    if (blob_gc_ratio != current.blob_gc_ratio) {
+      changes.emplace("blob_gc_ratio", ToString(blob_gc_ratio));
+    }
+    size_t blob_size = static_cast<size_t>(
+        Step(double(current.blob_size), double(options_.min_blob_size),
+             double(options_.max_blob_size),
+             stalled ? -1 : garbage_above_target ? 1 : 0, true));
+    if (blob_size != current.blob_size) {
+      changes.emplace("blob_size", ToString(blob_size));
+    }
+    size_t overlap = static_cast<size_t>(
+        Step(double(current.max_dependence_blob_overlap),
+             double(options_.min_max_dependence_blob_overlap),
+             double(options_.max_max_dependence_blob_overlap),
+             stalled ? 1 : read_amp_debt > options_.target_read_amp_debt ? -1
+                                                                          : 0,
+             true));
+    if (overlap != current.max_dependence_blob_overlap) {
+      changes.emplace("max_dependence_blob_overlap", ToString(overlap));
+    }
+    if (changes.empty()) {
+      return Status::OK();
+    }
+
+    std::string summary;
+    for (auto& pair : changes) {
+      summary += " " + pair.first + "=" + pair.second;
+    }
+    ROCKS_LOG_INFO(info_log_.get(),
+                   "[%s] Options auto tuner, garbage ratio %.3f, read amp "
+                   "debt %" PRIu64 ", %s, set%s",
+                   column_family->GetName().c_str(), garbage_ratio,
+                   read_amp_debt, stalled ? "stalled" : "not stalled",
+                   summary.c_str());
+    return db_->SetOptions(column_family, changes);
+  }
+
+  DB* db_;
+  std::vector<ColumnFamilyHandle*> column_families_;
+  OptionsAutoTunerOptions options_;
+  std::shared_ptr<Logger> info_log_;
+  std::mutex mutex_;
+  std::vector<uint64_t> stall_counts_;
+  // The shared timer running the rounds, null without period_sec
+  std::shared_ptr<Timer> timer_;
+  std::string task_name_;
+};
+}  // namespace
+
+Status NewOptionsAutoTuner(
+    DB* db, const std::vector<ColumnFamilyHandle*>& column_families,
+    const OptionsAutoTunerOptions& options,
+    std::unique_ptr<OptionsAutoTuner>* result) {
+  if (db == nullptr || result == nullptr) {
+    return Status::InvalidArgument("db and result must be set");
+  }
+  if (!(options.step > 1)) {
+    return Status::InvalidArgument("step must be larger than 1");
+  }
+  result->reset(new OptionsAutoTunerImpl(db, column_families, options));
+  return Status::OK();
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+#endif  // ROCKSDB_LITE
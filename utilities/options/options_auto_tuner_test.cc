@@ -0,0 +1,113 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/options_auto_tuner.h"
+
+#include <memory>
+#include <string>
+
+#include "rocksdb/db.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/sync_point.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class OptionsAutoTunerTest : public testing::Test {
+ public:
+  OptionsAutoTunerTest() {
+    dbname_ = test::PerThreadDBPath("options_auto_tuner_test");
+    DestroyDB(dbname_, Options());
+  }
+
+  ~OptionsAutoTunerTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  std::string dbname_;
+  DB* db_ = nullptr;
+};
+
+TEST_F(OptionsAutoTunerTest, TuneFromBlobGarbage) {
+  Options options;
+  options.create_if_missing = true;
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  options.blob_size = 32;
+  options.blob_gc_ratio = 0.1;
+  options.max_dependence_blob_overlap = 1024;
+
+  // gc job banned, the garbage stays
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::ProcessGarbageCollection::Start",
+      [&](void* arg) { *(bool*)arg = true; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_OK(DB::Open(options, dbname_, &db_));
+
+  std::string bigval(100, 'v');
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_OK(db_->Put(WriteOptions(), "key" + std::to_string(i), bigval));
+    }
+    ASSERT_OK(db_->Flush(FlushOptions()));
+  }
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  OptionsAutoTunerOptions tuner_options;
+  tuner_options.period_sec = 0;
+  tuner_options.target_blob_garbage_ratio = 0.2;
+  tuner_options.min_blob_gc_ratio = 0.05;
+  tuner_options.max_blob_gc_ratio = 0.5;
+  tuner_options.min_blob_size = 32;
+  tuner_options.max_blob_size = 40;
+  std::unique_ptr<OptionsAutoTuner> tuner;
+  ASSERT_OK(NewOptionsAutoTuner(db_, {db_->DefaultColumnFamily()},
+                                tuner_options, &tuner));
+
+  // Half of the blobs are garbage, GC is made more eager and fewer values
+  // are separated
+  ASSERT_OK(tuner->Tune());
+  Options current = db_->GetOptions();
+  ASSERT_NEAR(0.08, current.blob_gc_ratio, 1e-6);
+  ASSERT_EQ(40U, current.blob_size);
+  // Not bounded, not tuned
+  ASSERT_EQ(1024U, current.max_dependence_blob_overlap);
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_OK(tuner->Tune());
+  }
+  current = db_->GetOptions();
+  ASSERT_NEAR(0.05, current.blob_gc_ratio, 1e-6);
+  ASSERT_EQ(40U, current.blob_size);
+  ASSERT_EQ(1024U, current.max_dependence_blob_overlap);
+
+  tuner_options.step = 1;
+  ASSERT_TRUE(NewOptionsAutoTuner(db_, {db_->DefaultColumnFamily()},
+                                  tuner_options, &tuner)
+                  .IsInvalidArgument());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else  // ROCKSDB_LITE
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr,
+          "SKIPPED as OptionsAutoTuner is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_LITE
@@ -22,6 +22,8 @@
 #include <cctype>
 #include <iostream>
 
+#include "utilities/redis/redis_store.h"
+
 #include "rocksdb/terark_namespace.h"
 #include "util/random.h"
 #include "util/testharness.h"
@@ -740,6 +742,91 @@ TEST_F(RedisListsTest, PersistenceMultiKeyTest) {
   }
 }
 
+// RedisStore lists, one key per element
+TEST_F(RedisListsTest, StoreListTest) {
+  ASSERT_OK(DestroyDB(kDefaultDbName, options));
+  std::unique_ptr<RedisStore> store;
+  ASSERT_OK(RedisStore::Open(options, kDefaultDbName, &store));
+  uint64_t length = 0;
+  ASSERT_OK(store->RPush("k1", "b", &length));
+  ASSERT_EQ(1U, length);
+  ASSERT_OK(store->RPush("k1", "c", &length));
+  ASSERT_OK(store->LPush("k1", "a", &length));
+  ASSERT_EQ(3U, length);
+  ASSERT_OK(store->RPush("k2", "x", &length));
+  ASSERT_EQ(1U, length);
+
+  std::string value;
+  ASSERT_OK(store->LIndex("k1", 0, &value));
+  ASSERT_EQ("a", value);
+  ASSERT_OK(store->LIndex("k1", -1, &value));
+  ASSERT_EQ("c", value);
+  ASSERT_TRUE(store->LIndex("k1", 3, &value).IsNotFound());
+  std::vector<std::string> values;
+  ASSERT_OK(store->LRange("k1", 0, -1, &values));
+  AssertListEq(values, {"a", "b", "c"});
+  ASSERT_OK(store->LRange("k1", -2, 10, &values));
+  AssertListEq(values, {"b", "c"});
+  ASSERT_OK(store->LRange("nokey", 0, -1, &values));
+  ASSERT_TRUE(values.empty());
+
+  ASSERT_OK(store->LPop("k1", &value));
+  ASSERT_EQ("a", value);
+  ASSERT_OK(store->RPop("k1", &value));
+  ASSERT_EQ("c", value);
+  ASSERT_OK(store->RPop("k1", &value));
+  ASSERT_EQ("b", value);
+  ASSERT_TRUE(store->RPop("k1", &value).IsNotFound());
+  ASSERT_OK(store->LLen("k1", &length));
+  ASSERT_EQ(0U, length);
+
+  // Bounds survive flushes and compactions of the merge operands
+  ASSERT_OK(store->LPush("k1", "y", &length));
+  ASSERT_OK(store->db()->Flush(FlushOptions()));
+  ASSERT_OK(store->LPush("k1", "z", &length));
+  ASSERT_OK(store->db()->CompactRange(CompactRangeOptions(), nullptr,
+                                      nullptr));
+  ASSERT_OK(store->LRange("k1", 0, -1, &values));
+  AssertListEq(values, {"z", "y"});
+  ASSERT_OK(store->LRange("k2", 0, -1, &values));
+  AssertListEq(values, {"x"});
+}
+
+// RedisStore hashes, one key per field
+TEST_F(RedisListsTest, StoreHashTest) {
+  ASSERT_OK(DestroyDB(kDefaultDbName, options));
+  std::unique_ptr<RedisStore> store;
+  ASSERT_OK(RedisStore::Open(options, kDefaultDbName, &store));
+  bool created = false;
+  ASSERT_OK(store->HSet("h", "f2", "v2", &created));
+  ASSERT_TRUE(created);
+  ASSERT_OK(store->HSet("h", "f1", "v1", &created));
+  ASSERT_OK(store->HSet("h", "f1", "v1b", &created));
+  ASSERT_FALSE(created);
+  ASSERT_OK(store->HSet("h2", "f1", "other"));
+
+  uint64_t length = 0;
+  ASSERT_OK(store->HLen("h", &length));
+  ASSERT_EQ(2U, length);
+  std::string value;
+  ASSERT_OK(store->HGet("h", "f1", &value));
+  ASSERT_EQ("v1b", value);
+  std::vector<std::pair<std::string, std::string>> fields;
+  ASSERT_OK(store->HGetAll("h", &fields));
+  ASSERT_EQ(2U, fields.size());
+  ASSERT_EQ("f1", fields[0].first);
+  ASSERT_EQ("v1b", fields[0].second);
+  ASSERT_EQ("f2", fields[1].first);
+
+  ASSERT_OK(store->HDel("h", "f1"));
+  ASSERT_TRUE(store->HDel("h", "f1").IsNotFound());
+  ASSERT_TRUE(store->HGet("h", "f1", &value).IsNotFound());
+  ASSERT_OK(store->HLen("h", &length));
+  ASSERT_EQ(1U, length);
+  ASSERT_OK(store->HLen("h2", &length));
+  ASSERT_EQ(1U, length);
+}
+
 /// THE manual REDIS TEST begins here
 /// THIS WILL ONLY OCCUR IF YOU RUN: ./redis_test -m
 
@@ -0,0 +1,329 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+#include "utilities/redis/redis_store.h"
+
+#include <algorithm>
+
+#include "rocksdb/snapshot.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
+#include "util/logging.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+const char kListMeta = 'l';
+const char kListElement = 'L';
+const char kHashMeta = 'h';
+const char kHashField = 'H';
+
+std::string EncodeKey(char type, const Slice& key) {
+  std::string result(1, type);
+  PutLengthPrefixedSlice(&result, key);
+  return result;
+}
+
+std::string ElementKey(const Slice& key, int64_t index) {
+  std::string result = EncodeKey(kListElement, key);
+  uint64_t ordered = static_cast<uint64_t>(index) ^ (uint64_t(1) << 63);
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    result.push_back(static_cast<char>(ordered >> shift));
+  }
+  return result;
+}
+
+std::string FieldKey(const Slice& key, const Slice& field) {
+  std::string result = EncodeKey(kHashField, key);
+  result.append(field.data(), field.size());
+  return result;
+}
+
+std::string EncodeDeltas(int64_t a, int64_t b) {
+  std::string result;
+  PutFixed64(&result, static_cast<uint64_t>(a));
+  PutFixed64(&result, static_cast<uint64_t>(b));
+  return result;
+}
+
+// Element wise sum of the fixed 64 bit integers of the bounds or the field
+// counts
+class RedisMetaMergeOperator : public AssociativeMergeOperator {
+ public:
+  virtual bool Merge(const Slice& /*key*/, const Slice* existing_value,
+                     const Slice& value, std::string* new_value,
+                     Logger* logger) const override {
+    if (value.size() % sizeof(uint64_t) != 0 ||
+        (existing_value != nullptr &&
+         existing_value->size() != value.size())) {
+      ROCKS_LOG_ERROR(logger,
+                      "RedisStore meta corruption, size: %" ROCKSDB_PRIszt,
+                      value.size());
+      return false;
+    }
+    new_value->clear();
+    for (size_t i = 0; i < value.size(); i += sizeof(uint64_t)) {
+      uint64_t sum = DecodeFixed64(value.data() + i);
+      if (existing_value != nullptr) {
+        sum += DecodeFixed64(existing_value->data() + i);
+      }
+      PutFixed64(new_value, sum);
+    }
+    return true;
+  }
+
+  virtual const char* Name() const override {
+    return "RedisMetaMergeOperator";
+  }
+};
+}  // namespace
+
+Status RedisStore::Open(Options options, const std::string& path,
+                        std::unique_ptr<RedisStore>* store) {
+  options.merge_operator = NewMergeOperator();
+  DB* db;
+  Status s = DB::Open(options, path, &db);
+  if (s.ok()) {
+    store->reset(new RedisStore(db));
+  }
+  return s;
+}
+
+std::shared_ptr<MergeOperator> RedisStore::NewMergeOperator() {
+  return std::make_shared<RedisMetaMergeOperator>();
+}
+
+Status RedisStore::GetBounds(const Slice& key, int64_t* head, int64_t* tail) {
+  std::string meta;
+  Status s = db_->Get(ReadOptions(), EncodeKey(kListMeta, key), &meta);
+  if (s.IsNotFound()) {
+    *head = *tail = 0;
+    return Status::OK();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (meta.size() != 2 * sizeof(uint64_t)) {
+    return Status::Corruption("RedisStore: list bounds");
+  }
+  *head = static_cast<int64_t>(DecodeFixed64(meta.data()));
+  *tail = static_cast<int64_t>(DecodeFixed64(meta.data() + sizeof(uint64_t)));
+  return Status::OK();
+}
+
+Status RedisStore::Push(const Slice& key, const Slice& value, bool left,
+                        uint64_t* length) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t head, tail;
+  Status s = GetBounds(key, &head, &tail);
+  if (!s.ok()) {
+    return s;
+  }
+  WriteBatch batch;
+  if (left) {
+    batch.Put(ElementKey(key, head - 1), value);
+    batch.Merge(EncodeKey(kListMeta, key), EncodeDeltas(-1, 0));
+  } else {
+    batch.Put(ElementKey(key, tail), value);
+    batch.Merge(EncodeKey(kListMeta, key), EncodeDeltas(0, 1));
+  }
+  s = db_->Write(WriteOptions(), &batch);
+  if (s.ok() && length != nullptr) {
+    *length = static_cast<uint64_t>(tail - head + 1);
+  }
+  return s;
+}
+
+Status RedisStore::Pop(const Slice& key, bool left, std::string* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t head, tail;
+  Status s = GetBounds(key, &head, &tail);
+  if (!s.ok()) {
+    return s;
+  }
+  if (head >= tail) {
+    return Status::NotFound();
+  }
+  std::string element_key = ElementKey(key, left ? head : tail - 1);
+  s = db_->Get(ReadOptions(), element_key, value);
+  if (!s.ok()) {
+    return s.IsNotFound() ? Status::Corruption("RedisStore: list element")
+                          : s;
+  }
+  WriteBatch batch;
+  batch.Delete(element_key);
+  batch.Merge(EncodeKey(kListMeta, key),
+              left ? EncodeDeltas(1, 0) : EncodeDeltas(0, -1));
+  return db_->Write(WriteOptions(), &batch);
+}
+
+Status RedisStore::LPush(const Slice& key, const Slice& value,
+                         uint64_t* length) {
+  return Push(key, value, true, length);
+}
+
+Status RedisStore::RPush(const Slice& key, const Slice& value,
+                         uint64_t* length) {
+  return Push(key, value, false, length);
+}
+
+Status RedisStore::LPop(const Slice& key, std::string* value) {
+  return Pop(key, true, value);
+}
+
+Status RedisStore::RPop(const Slice& key, std::string* value) {
+  return Pop(key, false, value);
+}
+
+Status RedisStore::LLen(const Slice& key, uint64_t* length) {
+  int64_t head, tail;
+  Status s = GetBounds(key, &head, &tail);
+  if (s.ok()) {
+    *length = static_cast<uint64_t>(tail - head);
+  }
+  return s;
+}
+
+Status RedisStore::LIndex(const Slice& key, int64_t index,
+                          std::string* value) {
+  int64_t head, tail;
+  Status s = GetBounds(key, &head, &tail);
+  if (!s.ok()) {
+    return s;
+  }
+  if (index < 0) {
+    index += tail - head;
+  }
+  if (index < 0 || index >= tail - head) {
+    return Status::NotFound();
+  }
+  return db_->Get(ReadOptions(), ElementKey(key, head + index), value);
+}
+
+Status RedisStore::LRange(const Slice& key, int64_t first, int64_t last,
+                          std::vector<std::string>* values) {
+  values->clear();
+  // The bounds and the elements are read from the same snapshot
+  ManagedSnapshot snapshot(db_.get());
+  ReadOptions read_options;
+  read_options.snapshot = snapshot.snapshot();
+  std::string meta;
+  Status s = db_->Get(read_options, EncodeKey(kListMeta, key), &meta);
+  if (s.IsNotFound()) {
+    return Status::OK();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (meta.size() != 2 * sizeof(uint64_t)) {
+    return Status::Corruption("RedisStore: list bounds");
+  }
+  int64_t head = static_cast<int64_t>(DecodeFixed64(meta.data()));
+  int64_t tail =
+      static_cast<int64_t>(DecodeFixed64(meta.data() + sizeof(uint64_t)));
+  int64_t length = tail - head;
+  if (first < 0) {
+    first += length;
+  }
+  if (last < 0) {
+    last += length;
+  }
+  first = std::max<int64_t>(first, 0);
+  last = std::min<int64_t>(last, length - 1);
+  if (first > last) {
+    return Status::OK();
+  }
+  std::string upper_bound = ElementKey(key, head + last + 1);
+  Slice upper_bound_slice(upper_bound);
+  read_options.iterate_upper_bound = &upper_bound_slice;
+  std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+  values->reserve(static_cast<size_t>(last - first + 1));
+  for (iter->Seek(ElementKey(key, head + first)); iter->Valid();
+       iter->Next()) {
+    values->emplace_back(iter->value().ToString());
+  }
+  return iter->status();
+}
+
+Status RedisStore::HSet(const Slice& key, const Slice& field,
+                        const Slice& value, bool* created) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string field_key = FieldKey(key, field);
+  std::string existing;
+  Status s = db_->Get(ReadOptions(), field_key, &existing);
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+  bool is_new = s.IsNotFound();
+  WriteBatch batch;
+  batch.Put(field_key, value);
+  if (is_new) {
+    std::string delta;
+    PutFixed64(&delta, 1);
+    batch.Merge(EncodeKey(kHashMeta, key), delta);
+  }
+  s = db_->Write(WriteOptions(), &batch);
+  if (s.ok() && created != nullptr) {
+    *created = is_new;
+  }
+  return s;
+}
+
+Status RedisStore::HGet(const Slice& key, const Slice& field,
+                        std::string* value) {
+  return db_->Get(ReadOptions(), FieldKey(key, field), value);
+}
+
+Status RedisStore::HDel(const Slice& key, const Slice& field) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string field_key = FieldKey(key, field);
+  std::string existing;
+  Status s = db_->Get(ReadOptions(), field_key, &existing);
+  if (!s.ok()) {
+    return s;
+  }
+  WriteBatch batch;
+  batch.Delete(field_key);
+  std::string delta;
+  PutFixed64(&delta, static_cast<uint64_t>(-1));
+  batch.Merge(EncodeKey(kHashMeta, key), delta);
+  return db_->Write(WriteOptions(), &batch);
+}
+
+Status RedisStore::HLen(const Slice& key, uint64_t* length) {
+  std::string meta;
+  Status s = db_->Get(ReadOptions(), EncodeKey(kHashMeta, key), &meta);
+  if (s.IsNotFound()) {
+    *length = 0;
+    return Status::OK();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (meta.size() != sizeof(uint64_t)) {
+    return Status::Corruption("RedisStore: hash length");
+  }
+  *length = DecodeFixed64(meta.data());
+  return Status::OK();
+}
+
+Status RedisStore::HGetAll(
+    const Slice& key, std::vector<std::pair<std::string, std::string>>* fields) {
+  fields->clear();
+  std::string prefix = EncodeKey(kHashField, key);
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix);
+       iter->Next()) {
+    fields->emplace_back(
+        std::string(iter->key().data() + prefix.size(),
+                    iter->key().size() - prefix.size()),
+        iter->value().ToString());
+  }
+  return iter->status();
+}
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,92 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Redis lists and hashes with one rocksdb key per element, unlike
+// RedisLists which rewrites the whole list on every change. A push, pop,
+// hset or hdel reads and writes a few keys whatever the size of the list
+// or hash, and ranges are read by one prefix scan.
+//
+// Layout, <key> is length prefixed:
+//   'l' <key>                       -> list bounds [head, tail)
+//   'L' <key> <index>               -> element, index is big endian with
+//                                      the sign bit flipped, so elements
+//                                      sort by index
+//   'h' <key>                       -> number of fields
+//   'H' <key> <field>               -> value
+// The bounds and the number of fields are fixed 64 bit integers updated by
+// Merge of their deltas, see RedisStore::NewMergeOperator().
+
+#ifndef ROCKSDB_LITE
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/merge_operator.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class RedisStore {
+ public:
+  // Opens the db at path with options, whose merge_operator is replaced by
+  // NewMergeOperator()
+  static Status Open(Options options, const std::string& path,
+                     std::unique_ptr<RedisStore>* store);
+
+  // Adds the deltas of the bounds and field counts
+  static std::shared_ptr<MergeOperator> NewMergeOperator();
+
+  // Lists. Negative indexes count from the end of the list, as in Redis.
+
+  // *length is the length after the push
+  Status LPush(const Slice& key, const Slice& value, uint64_t* length);
+  Status RPush(const Slice& key, const Slice& value, uint64_t* length);
+  // NotFound if the list is empty
+  Status LPop(const Slice& key, std::string* value);
+  Status RPop(const Slice& key, std::string* value);
+  Status LLen(const Slice& key, uint64_t* length);
+  // NotFound if index is out of range
+  Status LIndex(const Slice& key, int64_t index, std::string* value);
+  // The elements of [first, last], both included
+  Status LRange(const Slice& key, int64_t first, int64_t last,
+                std::vector<std::string>* values);
+
+  // Hashes
+
+  // *created is whether field is new
+  Status HSet(const Slice& key, const Slice& field, const Slice& value,
+              bool* created = nullptr);
+  Status HGet(const Slice& key, const Slice& field, std::string* value);
+  // NotFound if field does not exist
+  Status HDel(const Slice& key, const Slice& field);
+  Status HLen(const Slice& key, uint64_t* length);
+  // The fields and values, in field order
+  Status HGetAll(const Slice& key,
+                 std::vector<std::pair<std::string, std::string>>* fields);
+
+  DB* db() { return db_.get(); }
+
+ private:
+  explicit RedisStore(DB* db) : db_(db) {}
+
+  // Bounds of the list, [0, 0) if it does not exist
+  Status GetBounds(const Slice& key, int64_t* head, int64_t* tail);
+  Status Push(const Slice& key, const Slice& value, bool left,
+              uint64_t* length);
+  Status Pop(const Slice& key, bool left, std::string* value);
+
+  std::unique_ptr<DB> db_;
+  // Serializes the changes of lists and hashes, which read the bounds or
+  // the field before writing
+  std::mutex mutex_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,320 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/replication.h"
+
+#include <unordered_set>
+
+#include "db/log_reader.h"
+#include "db/version_edit.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/file_reader_writer.h"
+#include "util/file_util.h"
+#include "util/filename.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+struct ManifestReporter : public log::Reader::Reporter {
+  Status* status;
+  virtual void Corruption(size_t /*bytes*/, const Status& s) override {
+    if (status->ok()) {
+      *status = s;
+    }
+  }
+};
+
+// Collects the numbers of the table files added by the records that start
+// in [offset, end) of the MANIFEST fname
+Status ReadNewTableFiles(Env* env, const std::string& fname, uint64_t offset,
+                         uint64_t end, std::vector<uint64_t>* numbers) {
+  std::unique_ptr<SequentialFile> file;
+  Status s = env->NewSequentialFile(fname, &file, EnvOptions());
+  if (!s.ok()) {
+    return s;
+  }
+  // Records are framed in 32KB blocks, the reader has to start at offset 0
+  std::unique_ptr<SequentialFileReader> file_reader(
+      new SequentialFileReader(std::move(file), fname));
+  ManifestReporter reporter;
+  reporter.status = &s;
+  log::Reader reader(nullptr, std::move(file_reader), &reporter,
+                     true /* checksum */, 0 /* log_number */,
+                     false /* retry_after_eof */);
+  Slice record;
+  std::string scratch;
+  while (reader.ReadRecord(&record, &scratch) && s.ok()) {
+    if (reader.LastRecordOffset() >= end) {
+      // Written after the live files were taken
+      break;
+    }
+    if (reader.LastRecordOffset() < offset) {
+      continue;
+    }
+    VersionEdit edit;
+    s = edit.DecodeFrom(record);
+    if (!s.ok()) {
+      break;
+    }
+    for (auto& level_and_file : edit.GetNewFiles()) {
+      numbers->push_back(level_and_file.second.fd.GetNumber());
+    }
+  }
+  return s;
+}
+
+Status ReadManifestRange(Env* env, const std::string& fname, uint64_t offset,
+                         uint64_t end, std::string* data) {
+  std::unique_ptr<SequentialFile> file;
+  Status s = env->NewSequentialFile(fname, &file, EnvOptions());
+  if (s.ok() && offset > 0) {
+    s = file->Skip(offset);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  data->resize(static_cast<size_t>(end - offset));
+  size_t read = 0;
+  while (s.ok() && read < data->size()) {
+    Slice result;
+    s = file->Read(data->size() - read, &result, &(*data)[read]);
+    if (s.ok() && result.empty()) {
+      s = Status::Corruption("MANIFEST shorter than expected", fname);
+    }
+    if (s.ok() && result.data() != &(*data)[read]) {
+      memcpy(&(*data)[read], result.data(), result.size());
+    }
+    read += result.size();
+  }
+  return s;
+}
+
+Status ShipUpdates(DB* db, const ReplicationCursor& cursor,
+                   ReplicationSink* sink) {
+  Env* env = db->GetEnv();
+  std::vector<std::string> live_files;
+  uint64_t manifest_size = 0;
+  // The MANIFEST size is taken along with the live files, the two match
+  Status s = db->GetLiveFiles(live_files, &manifest_size,
+                              false /* flush_memtable */);
+  if (!s.ok()) {
+    return s;
+  }
+  std::unordered_set<uint64_t> live_tables;
+  std::vector<std::string> live_table_files;
+  uint64_t manifest_number = 0;
+  for (auto& live_file : live_files) {
+    uint64_t number;
+    FileType type;
+    if (!ParseFileName(live_file, &number, &type)) {
+      return Status::Corruption("Can't parse file name", live_file);
+    }
+    if (type == kTableFile) {
+      live_tables.insert(number);
+      live_table_files.push_back(MakeTableFileName("", number).substr(1));
+    } else if (type == kDescriptorFile) {
+      manifest_number = number;
+    }
+  }
+  uint64_t offset = cursor.manifest_number == manifest_number
+                        ? cursor.manifest_offset
+                        : 0;
+  if (offset > manifest_size) {
+    return Status::Corruption("Follower is ahead of the leader MANIFEST");
+  }
+  std::string manifest_fname =
+      DescriptorFileName(db->GetName(), manifest_number);
+  std::vector<uint64_t> new_tables;
+  s = ReadNewTableFiles(env, manifest_fname, offset, manifest_size,
+                        &new_tables);
+  // Files first, the follower must never reference a missing one. Files
+  // added and dropped again since the cursor are gone and not needed.
+  for (size_t i = 0; s.ok() && i < new_tables.size(); ++i) {
+    if (live_tables.count(new_tables[i]) == 0) {
+      continue;
+    }
+    std::string src_path = MakeTableFileName(db->GetName(), new_tables[i]);
+    uint64_t file_size = 0;
+    s = env->GetFileSize(src_path, &file_size);
+    if (s.ok()) {
+      s = sink->AddTableFile(
+          src_path, MakeTableFileName("", new_tables[i]).substr(1), file_size);
+    }
+  }
+  if (s.ok() && manifest_size > offset) {
+    std::string data;
+    s = ReadManifestRange(env, manifest_fname, offset, manifest_size, &data);
+    if (s.ok()) {
+      s = sink->AppendManifest(manifest_number, offset, data);
+    }
+  }
+  if (s.ok()) {
+    s = sink->Finish(live_table_files);
+  }
+  return s;
+}
+
+class DirectoryReplicationSink : public ReplicationSink {
+ public:
+  DirectoryReplicationSink(Env* env, const std::string& dir)
+      : env_(env), dir_(dir), manifest_number_(0) {}
+
+  virtual Status GetCursor(ReplicationCursor* cursor) override {
+    *cursor = ReplicationCursor();
+    std::string current;
+    Status s = ReadFileToString(env_, CurrentFileName(dir_), &current);
+    if (s.IsNotFound()) {
+      // A new follower
+      return Status::OK();
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    if (current.empty() || current.back() != '\n') {
+      return Status::Corruption("CURRENT file does not end with newline");
+    }
+    current.pop_back();
+    FileType type;
+    if (!ParseFileName(current, &manifest_number_, &type) ||
+        type != kDescriptorFile) {
+      return Status::Corruption("CURRENT file corrupted", current);
+    }
+    s = env_->GetFileSize(dir_ + "/" + current, &cursor->manifest_offset);
+    if (s.ok()) {
+      cursor->manifest_number = manifest_number_;
+    }
+    return s;
+  }
+
+  virtual Status AddTableFile(const std::string& src_path,
+                              const std::string& fname,
+                              uint64_t file_size) override {
+    std::string dst_path = dir_ + "/" + fname;
+    uint64_t dst_size = 0;
+    if (env_->GetFileSize(dst_path, &dst_size).ok()) {
+      if (dst_size == file_size) {
+        // Table files never reuse a number
+        return Status::OK();
+      }
+      // Left over by an interrupted copy
+      env_->DeleteFile(dst_path);
+    }
+    Status s = env_->LinkFile(src_path, dst_path);
+    if (!s.ok()) {
+      s = CopyFile(env_, src_path, dst_path, file_size, true /* use_fsync */);
+    }
+    return s;
+  }
+
+  virtual Status AppendManifest(uint64_t manifest_number, uint64_t offset,
+                                const Slice& data) override {
+    std::string fname = DescriptorFileName(dir_, manifest_number);
+    std::unique_ptr<WritableFile> file;
+    Status s;
+    if (offset == 0) {
+      s = env_->NewWritableFile(fname, &file, EnvOptions());
+    } else {
+      uint64_t size = 0;
+      s = env_->GetFileSize(fname, &size);
+      if (s.ok() && size != offset) {
+        s = Status::Corruption("MANIFEST size does not match the cursor",
+                               fname);
+      }
+      if (s.ok()) {
+        s = env_->ReopenWritableFile(fname, &file, EnvOptions());
+      }
+    }
+    if (s.ok()) {
+      s = file->Append(data);
+    }
+    if (s.ok()) {
+      s = file->Fsync();
+    }
+    if (s.ok()) {
+      s = file->Close();
+    }
+    if (s.ok() && offset == 0) {
+      std::unique_ptr<Directory> dir;
+      s = env_->NewDirectory(dir_, &dir);
+      if (s.ok()) {
+        s = SetCurrentFile(env_, dir_, manifest_number, dir.get());
+      }
+    }
+    if (s.ok()) {
+      manifest_number_ = manifest_number;
+    }
+    return s;
+  }
+
+  virtual Status Finish(
+      const std::vector<std::string>& live_table_files) override {
+    std::unordered_set<std::string> live(live_table_files.begin(),
+                                         live_table_files.end());
+    std::vector<std::string> children;
+    Status s = env_->GetChildren(dir_, &children);
+    for (size_t i = 0; s.ok() && i < children.size(); ++i) {
+      uint64_t number;
+      FileType type;
+      if (!ParseFileName(children[i], &number, &type)) {
+        continue;
+      }
+      if ((type == kTableFile && live.count(children[i]) == 0) ||
+          (type == kDescriptorFile && number != manifest_number_)) {
+        s = env_->DeleteFile(dir_ + "/" + children[i]);
+      }
+    }
+    if (s.ok()) {
+      std::unique_ptr<Directory> dir;
+      s = env_->NewDirectory(dir_, &dir);
+      if (s.ok()) {
+        s = dir->Fsync();
+      }
+    }
+    return s;
+  }
+
+ private:
+  Env* env_;
+  std::string dir_;
+  // The current MANIFEST of the follower
+  uint64_t manifest_number_;
+};
+}  // namespace
+
+Status ShipReplicationUpdates(DB* db, ReplicationSink* sink) {
+  DBOptions db_options = db->GetDBOptions();
+  if (db_options.db_paths.size() > 1) {
+    return Status::NotSupported("Replication of multiple db_paths");
+  }
+  ReplicationCursor cursor;
+  Status s = sink->GetCursor(&cursor);
+  if (!s.ok()) {
+    return s;
+  }
+  s = db->DisableFileDeletions();
+  if (!s.ok()) {
+    return s;
+  }
+  s = ShipUpdates(db, cursor, sink);
+  db->EnableFileDeletions(false);
+  return s;
+}
+
+Status NewDirectoryReplicationSink(Env* env, const std::string& follower_dir,
+                                   std::unique_ptr<ReplicationSink>* sink) {
+  Status s = env->CreateDirIfMissing(follower_dir);
+  if (s.ok()) {
+    sink->reset(new DirectoryReplicationSink(env, follower_dir));
+  }
+  return s;
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+#endif  // ROCKSDB_LITE
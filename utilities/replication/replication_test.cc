@@ -0,0 +1,180 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/replication.h"
+
+#include "port/stack_trace.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Counts the table files shipped to a directory sink
+class CountingSink : public ReplicationSink {
+ public:
+  explicit CountingSink(std::unique_ptr<ReplicationSink>&& target)
+      : target_(std::move(target)), num_table_files(0) {}
+
+  virtual Status GetCursor(ReplicationCursor* cursor) override {
+    return target_->GetCursor(cursor);
+  }
+  virtual Status AddTableFile(const std::string& src_path,
+                              const std::string& fname,
+                              uint64_t file_size) override {
+    ++num_table_files;
+    return target_->AddTableFile(src_path, fname, file_size);
+  }
+  virtual Status AppendManifest(uint64_t manifest_number, uint64_t offset,
+                                const Slice& data) override {
+    return target_->AppendManifest(manifest_number, offset, data);
+  }
+  virtual Status Finish(
+      const std::vector<std::string>& live_table_files) override {
+    return target_->Finish(live_table_files);
+  }
+
+ private:
+  std::unique_ptr<ReplicationSink> target_;
+
+ public:
+  int num_table_files;
+};
+
+class ReplicationTest : public testing::Test {
+ public:
+  ReplicationTest() : env_(Env::Default()), db_(nullptr) {
+    dbname_ = test::PerThreadDBPath(env_, "replication_test");
+    follower_dir_ = dbname_ + "_follower";
+    options_.create_if_missing = true;
+    options_.disable_auto_compactions = true;
+    EXPECT_OK(DestroyDB(dbname_, options_));
+    EXPECT_OK(DestroyDB(follower_dir_, options_));
+    EXPECT_OK(DB::Open(options_, dbname_, &db_));
+  }
+
+  ~ReplicationTest() {
+    delete db_;
+    EXPECT_OK(DestroyDB(dbname_, options_));
+    EXPECT_OK(DestroyDB(follower_dir_, options_));
+  }
+
+  void WriteAndFlush(int begin, int end, const std::string& prefix) {
+    for (int i = begin; i < end; ++i) {
+      ASSERT_OK(db_->Put(WriteOptions(), Key(i), prefix + ToString(i)));
+    }
+    ASSERT_OK(db_->Flush(FlushOptions()));
+  }
+
+  void VerifyFollower(int num_keys, const std::string& prefix) {
+    DB* follower = nullptr;
+    ASSERT_OK(DB::OpenForReadOnly(options_, follower_dir_, &follower));
+    std::string value;
+    for (int i = 0; i < num_keys; ++i) {
+      ASSERT_OK(follower->Get(ReadOptions(), Key(i), &value));
+      ASSERT_EQ(prefix + ToString(i), value);
+    }
+    delete follower;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return buf;
+  }
+
+  Env* env_;
+  DB* db_;
+  Options options_;
+  std::string dbname_;
+  std::string follower_dir_;
+};
+
+TEST_F(ReplicationTest, ShipsOnlyNewFiles) {
+  std::unique_ptr<ReplicationSink> dir_sink;
+  ASSERT_OK(NewDirectoryReplicationSink(env_, follower_dir_, &dir_sink));
+  CountingSink sink(std::move(dir_sink));
+
+  WriteAndFlush(0, 100, "a");
+  WriteAndFlush(100, 200, "a");
+  ASSERT_OK(ShipReplicationUpdates(db_, &sink));
+  ASSERT_EQ(2, sink.num_table_files);
+  VerifyFollower(200, "a");
+
+  // Nothing new
+  ASSERT_OK(ShipReplicationUpdates(db_, &sink));
+  ASSERT_EQ(2, sink.num_table_files);
+
+  // The compaction output is shipped as is, its inputs are dropped
+  WriteAndFlush(0, 200, "b");
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_OK(ShipReplicationUpdates(db_, &sink));
+  std::vector<std::string> leader_files, follower_files;
+  uint64_t manifest_size;
+  ASSERT_OK(db_->GetLiveFiles(leader_files, &manifest_size, false));
+  ASSERT_OK(env_->GetChildren(follower_dir_, &follower_files));
+  for (auto& fname : leader_files) {
+    if (fname.find(".sst") != std::string::npos) {
+      ASSERT_OK(env_->FileExists(follower_dir_ + fname));
+    }
+  }
+  size_t num_follower_tables = 0;
+  for (auto& fname : follower_files) {
+    if (fname.find(".sst") != std::string::npos) {
+      ++num_follower_tables;
+    }
+  }
+  ASSERT_EQ(leader_files.size() - 3, num_follower_tables);
+  VerifyFollower(200, "b");
+}
+
+TEST_F(ReplicationTest, FollowsNewManifest) {
+  std::unique_ptr<ReplicationSink> sink;
+  ASSERT_OK(NewDirectoryReplicationSink(env_, follower_dir_, &sink));
+  WriteAndFlush(0, 100, "a");
+  ASSERT_OK(ShipReplicationUpdates(db_, sink.get()));
+
+  // Reopening the leader rolls its MANIFEST
+  delete db_;
+  db_ = nullptr;
+  ASSERT_OK(DB::Open(options_, dbname_, &db_));
+  WriteAndFlush(100, 200, "a");
+
+  // A new sink resumes from the follower directory
+  ASSERT_OK(NewDirectoryReplicationSink(env_, follower_dir_, &sink));
+  ASSERT_OK(ShipReplicationUpdates(db_, sink.get()));
+  VerifyFollower(200, "a");
+  std::vector<std::string> follower_files;
+  ASSERT_OK(env_->GetChildren(follower_dir_, &follower_files));
+  int num_manifests = 0;
+  for (auto& fname : follower_files) {
+    if (fname.compare(0, 9, "MANIFEST-") == 0) {
+      ++num_manifests;
+    }
+  }
+  ASSERT_EQ(1, num_manifests);
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  TERARKDB_NAMESPACE::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as replication is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // !ROCKSDB_LITE
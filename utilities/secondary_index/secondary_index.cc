@@ -0,0 +1,344 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/secondary_index.h"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+
+#include "port/port.h"
+#include "rocksdb/compaction_filter.h"
+#include "rocksdb/db.h"
+#include "rocksdb/listener.h"
+#include "rocksdb/sst_file_reader.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/value_extractor.h"
+#include "util/coding.h"
+#include "util/logging.h"
+#include "util/mutexlock.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+// An index key is the length prefixed field followed by the primary key, so
+// the entries of a field are adjacent in bytewise order
+void AppendIndexKey(std::string* dst, const Slice& field,
+                    const Slice& primary_key) {
+  PutLengthPrefixedSlice(dst, field);
+  dst->append(primary_key.data(), primary_key.size());
+}
+
+bool DecodeIndexKey(Slice input, Slice* field, Slice* primary_key) {
+  if (!GetLengthPrefixedSlice(&input, field)) {
+    return false;
+  }
+  *primary_key = input;
+  return true;
+}
+
+// Index entries written at most per batch
+const size_t kMaxBatchEntries = 1024;
+
+class SecondaryIndexImpl
+    : public SecondaryIndex,
+      public std::enable_shared_from_this<SecondaryIndexImpl> {
+ public:
+  explicit SecondaryIndexImpl(
+      std::shared_ptr<const ValueExtractorFactory> extractor_factory)
+      : extractor_factory_(std::move(extractor_factory)),
+        db_(nullptr),
+        primary_(nullptr),
+        index_(nullptr) {}
+
+  virtual std::shared_ptr<EventListener> GetListener() override;
+
+  virtual std::shared_ptr<CompactionFilterFactory>
+  GetCompactionFilterFactory() override;
+
+  virtual Status Attach(DB* db, ColumnFamilyHandle* primary,
+                        ColumnFamilyHandle* index) override {
+    if (db == nullptr || primary == nullptr || index == nullptr ||
+        primary->GetID() == index->GetID()) {
+      return Status::InvalidArgument("SecondaryIndex::Attach");
+    }
+    ValueExtractorContext context = {primary->GetID()};
+    auto extractor = extractor_factory_->CreateValueExtractor(context);
+    if (!extractor) {
+      return Status::InvalidArgument("SecondaryIndex: no extractor");
+    }
+    WriteLock l(&mutex_);
+    if (db_ != nullptr) {
+      return Status::InvalidArgument("SecondaryIndex: already attached");
+    }
+    db_ = db;
+    primary_ = primary;
+    index_ = index;
+    extractor_ = std::move(extractor);
+    return Status::OK();
+  }
+
+  virtual void Detach() override {
+    WriteLock l(&mutex_);
+    db_ = nullptr;
+    primary_ = nullptr;
+    index_ = nullptr;
+    extractor_.reset();
+    std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+    pending_.clear();
+  }
+
+  virtual Status Lookup(const ReadOptions& read_options, const Slice& field,
+                        std::vector<std::string>* primary_keys) override {
+    primary_keys->clear();
+    ReadLock l(&mutex_);
+    if (db_ == nullptr) {
+      return Status::InvalidArgument("SecondaryIndex: not attached");
+    }
+    std::string prefix;
+    AppendIndexKey(&prefix, field, Slice());
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options, index_));
+    for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix);
+         iter->Next()) {
+      Slice primary_key(iter->key().data() + prefix.size(),
+                        iter->key().size() - prefix.size());
+      bool current = false;
+      Status s = IsCurrent(read_options, field, primary_key, &current);
+      if (!s.ok()) {
+        return s;
+      }
+      if (current) {
+        primary_keys->emplace_back(primary_key.ToString());
+      }
+    }
+    return iter->status();
+  }
+
+  virtual Status Rebuild() override {
+    ReadLock l(&mutex_);
+    if (db_ == nullptr) {
+      return Status::InvalidArgument("SecondaryIndex: not attached");
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions(), primary_));
+    WriteBatch batch;
+    std::string field;
+    std::string index_key;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      field.clear();
+      Status s = extractor_->Extract(iter->key(), iter->value(), &field);
+      if (!s.ok()) {
+        return s;
+      }
+      index_key.clear();
+      AppendIndexKey(&index_key, field, iter->key());
+      batch.Put(index_, index_key, Slice());
+      if (static_cast<size_t>(batch.Count()) >= kMaxBatchEntries) {
+        s = db_->Write(WriteOptions(), &batch);
+        if (!s.ok()) {
+          return s;
+        }
+        batch.Clear();
+      }
+    }
+    if (!iter->status().ok()) {
+      return iter->status();
+    }
+    return db_->Write(WriteOptions(), &batch);
+  }
+
+  // Indexes the keys of the table file a flush of the primary column family
+  // wrote
+  void IndexFlushedFile(DB* db, const FlushJobInfo& info) {
+    ReadLock l(&mutex_);
+    if (db_ == nullptr || db != db_ || info.cf_name != primary_->GetName()) {
+      return;
+    }
+    Options options = db_->GetOptions(primary_);
+    std::vector<std::string> index_keys;
+    {
+      std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+      index_keys.swap(pending_);
+    }
+    SstFileReader reader(options);
+    Status s = reader.Open(info.file_path);
+    std::unique_ptr<Iterator> iter;
+    if (s.ok()) {
+      iter.reset(reader.NewIterator(ReadOptions()));
+      std::string value;
+      std::string field;
+      for (iter->SeekToFirst(); s.ok() && iter->Valid(); iter->Next()) {
+        // The latest value of the key, a newer one may have been written
+        // since the flush
+        s = db_->Get(ReadOptions(), primary_, iter->key(), &value);
+        if (s.IsNotFound()) {
+          s = Status::OK();
+          continue;
+        }
+        field.clear();
+        if (s.ok()) {
+          s = extractor_->Extract(iter->key(), value, &field);
+        }
+        if (s.ok()) {
+          index_keys.emplace_back();
+          AppendIndexKey(&index_keys.back(), field, iter->key());
+        }
+      }
+      if (s.ok()) {
+        s = iter->status();
+      }
+    }
+    if (!s.ok()) {
+      // E.g. the file was compacted away already, Rebuild() catches up
+      ROCKS_LOG_WARN(options.info_log,
+                     "SecondaryIndex: failed to index %s of [%s]: %s",
+                     info.file_path.c_str(), info.cf_name.c_str(),
+                     s.ToString().c_str());
+    }
+
+    // The flush thread must not wait for a write stall that waits for
+    // flushes, the entries refused are retried after the next flush
+    WriteOptions write_options;
+    write_options.no_slowdown = true;
+    for (size_t begin = 0; begin < index_keys.size();
+         begin += kMaxBatchEntries) {
+      size_t end = std::min(index_keys.size(), begin + kMaxBatchEntries);
+      WriteBatch batch;
+      for (size_t i = begin; i < end; ++i) {
+        batch.Put(index_, index_keys[i], Slice());
+      }
+      s = db_->Write(write_options, &batch);
+      if (!s.ok()) {
+        std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+        pending_.insert(pending_.end(),
+                        std::make_move_iterator(index_keys.begin() + begin),
+                        std::make_move_iterator(index_keys.end()));
+        break;
+      }
+    }
+  }
+
+  // Whether index_key is still held by its primary key
+  bool IsLive(uint32_t column_family_id, const Slice& index_key) {
+    ReadLock l(&mutex_);
+    if (db_ == nullptr || column_family_id != index_->GetID()) {
+      return true;
+    }
+    Slice field;
+    Slice primary_key;
+    if (!DecodeIndexKey(index_key, &field, &primary_key)) {
+      return false;
+    }
+    bool current = true;
+    IsCurrent(ReadOptions(), field, primary_key, &current);
+    return current;
+  }
+
+ private:
+  // REQUIRES: mutex_ is held
+  Status IsCurrent(const ReadOptions& read_options, const Slice& field,
+                   const Slice& primary_key, bool* current) {
+    std::string value;
+    Status s = db_->Get(read_options, primary_, primary_key, &value);
+    if (s.IsNotFound()) {
+      *current = false;
+      return Status::OK();
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    std::string value_field;
+    s = extractor_->Extract(primary_key, value, &value_field);
+    if (s.ok()) {
+      *current = field == Slice(value_field);
+    }
+    return s;
+  }
+
+  const std::shared_ptr<const ValueExtractorFactory> extractor_factory_;
+  // Held shared by the index maintenance and lookups, exclusively by
+  // Attach() and Detach()
+  port::RWMutex mutex_;
+  DB* db_;
+  ColumnFamilyHandle* primary_;
+  ColumnFamilyHandle* index_;
+  std::unique_ptr<ValueExtractor> extractor_;
+  // Index keys refused by a write stall
+  std::mutex pending_mutex_;
+  std::vector<std::string> pending_;
+};
+
+// The listener and the filter factory keep the index alive
+class SecondaryIndexListener : public EventListener {
+ public:
+  explicit SecondaryIndexListener(std::shared_ptr<SecondaryIndexImpl> index)
+      : index_(std::move(index)) {}
+
+  virtual void OnFlushCompleted(DB* db, const FlushJobInfo& info) override {
+    index_->IndexFlushedFile(db, info);
+  }
+
+ private:
+  std::shared_ptr<SecondaryIndexImpl> index_;
+};
+
+// Drops the index entries whose primary key no longer holds their field
+class SecondaryIndexFilter : public CompactionFilter {
+ public:
+  SecondaryIndexFilter(SecondaryIndexImpl* index, uint32_t column_family_id)
+      : index_(index), column_family_id_(column_family_id) {}
+
+  virtual bool Filter(int /*level*/, const Slice& key,
+                      const Slice& /*existing_value*/,
+                      std::string* /*new_value*/,
+                      bool* /*value_changed*/) const override {
+    return !index_->IsLive(column_family_id_, key);
+  }
+
+  virtual const char* Name() const override { return "SecondaryIndexFilter"; }
+
+ private:
+  SecondaryIndexImpl* index_;
+  uint32_t column_family_id_;
+};
+
+class SecondaryIndexFilterFactory : public CompactionFilterFactory {
+ public:
+  explicit SecondaryIndexFilterFactory(
+      std::shared_ptr<SecondaryIndexImpl> index)
+      : index_(std::move(index)) {}
+
+  virtual std::unique_ptr<CompactionFilter> CreateCompactionFilter(
+      const CompactionFilter::Context& context) override {
+    return std::unique_ptr<CompactionFilter>(
+        new SecondaryIndexFilter(index_.get(), context.column_family_id));
+  }
+
+  virtual const char* Name() const override {
+    return "SecondaryIndexFilterFactory";
+  }
+
+ private:
+  std::shared_ptr<SecondaryIndexImpl> index_;
+};
+
+std::shared_ptr<EventListener> SecondaryIndexImpl::GetListener() {
+  return std::make_shared<SecondaryIndexListener>(shared_from_this());
+}
+
+std::shared_ptr<CompactionFilterFactory>
+SecondaryIndexImpl::GetCompactionFilterFactory() {
+  return std::make_shared<SecondaryIndexFilterFactory>(shared_from_this());
+}
+}  // namespace
+
+std::shared_ptr<SecondaryIndex> NewSecondaryIndex(
+    std::shared_ptr<const ValueExtractorFactory> extractor_factory) {
+  return std::make_shared<SecondaryIndexImpl>(std::move(extractor_factory));
+}
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // !ROCKSDB_LITE
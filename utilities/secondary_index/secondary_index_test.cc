@@ -0,0 +1,185 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/secondary_index.h"
+
+#include <atomic>
+
+#include "port/stack_trace.h"
+#include "rocksdb/compaction_filter.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/listener.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/value_extractor.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// The field of a value is the part before the first ':'
+class ColorExtractor : public ValueExtractor {
+ public:
+  virtual Status Extract(const Slice& /*key*/, const Slice& value,
+                         std::string* output) const override {
+    std::string v = value.ToString();
+    output->assign(v.substr(0, v.find(':')));
+    return Status::OK();
+  }
+};
+
+class ColorExtractorFactory : public ValueExtractorFactory {
+ public:
+  virtual std::unique_ptr<ValueExtractor> CreateValueExtractor(
+      const Context& /*context*/) const override {
+    return std::unique_ptr<ValueExtractor>(new ColorExtractor);
+  }
+  virtual const char* Name() const override { return "ColorExtractorFactory"; }
+};
+
+// Counts the completed flushes, it is called after the index listener
+class FlushCounter : public EventListener {
+ public:
+  FlushCounter() : flushes(0) {}
+  virtual void OnFlushCompleted(DB* /*db*/,
+                                const FlushJobInfo& /*info*/) override {
+    ++flushes;
+  }
+  std::atomic<int> flushes;
+};
+
+class SecondaryIndexTest : public testing::Test {
+ public:
+  SecondaryIndexTest()
+      : env_(Env::Default()),
+        index_(NewSecondaryIndex(std::make_shared<ColorExtractorFactory>())),
+        flush_counter_(std::make_shared<FlushCounter>()),
+        db_(nullptr) {
+    dbname_ = test::PerThreadDBPath(env_, "secondary_index_test");
+    options_.create_if_missing = true;
+    options_.create_missing_column_families = true;
+    options_.disable_auto_compactions = true;
+    options_.listeners.push_back(index_->GetListener());
+    options_.listeners.push_back(flush_counter_);
+    EXPECT_OK(DestroyDB(dbname_, options_));
+    ColumnFamilyOptions index_options(options_);
+    index_options.compaction_filter_factory =
+        index_->GetCompactionFilterFactory();
+    std::vector<ColumnFamilyDescriptor> column_families = {
+        {kDefaultColumnFamilyName, options_},
+        {"primary", options_},
+        {"index", index_options}};
+    EXPECT_OK(DB::Open(options_, dbname_, column_families, &handles_, &db_));
+    EXPECT_OK(index_->Attach(db_, handles_[1], handles_[2]));
+  }
+
+  ~SecondaryIndexTest() {
+    index_->Detach();
+    for (auto handle : handles_) {
+      delete handle;
+    }
+    delete db_;
+    EXPECT_OK(DestroyDB(dbname_, options_));
+  }
+
+  Status Put(const std::string& key, const std::string& value) {
+    return db_->Put(WriteOptions(), handles_[1], key, value);
+  }
+
+  // Flushes the primary column family and waits for it to be indexed
+  void FlushPrimary() {
+    int flushes = flush_counter_->flushes;
+    ASSERT_OK(db_->Flush(FlushOptions(), handles_[1]));
+    while (flush_counter_->flushes == flushes) {
+      env_->SleepForMicroseconds(1000);
+    }
+  }
+
+  std::string Lookup(const std::string& field) {
+    std::vector<std::string> primary_keys;
+    Status s = index_->Lookup(ReadOptions(), field, &primary_keys);
+    if (!s.ok()) {
+      return s.ToString();
+    }
+    std::string result;
+    for (auto& key : primary_keys) {
+      result += result.empty() ? key : "," + key;
+    }
+    return result;
+  }
+
+  int CountIndexEntries() {
+    std::unique_ptr<Iterator> iter(
+        db_->NewIterator(ReadOptions(), handles_[2]));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ++count;
+    }
+    EXPECT_OK(iter->status());
+    return count;
+  }
+
+  Env* env_;
+  std::string dbname_;
+  Options options_;
+  std::shared_ptr<SecondaryIndex> index_;
+  std::shared_ptr<FlushCounter> flush_counter_;
+  DB* db_;
+  std::vector<ColumnFamilyHandle*> handles_;
+};
+
+TEST_F(SecondaryIndexTest, IndexedOnFlushPrunedOnCompaction) {
+  ASSERT_OK(Put("k1", "red:1"));
+  ASSERT_OK(Put("k2", "blue:2"));
+  ASSERT_OK(Put("k3", "red:3"));
+  // Only flushed keys are indexed
+  ASSERT_EQ("", Lookup("red"));
+  FlushPrimary();
+  ASSERT_EQ("k1,k3", Lookup("red"));
+  ASSERT_EQ("k2", Lookup("blue"));
+  ASSERT_EQ(3, CountIndexEntries());
+
+  ASSERT_OK(Put("k1", "blue:1"));
+  ASSERT_OK(db_->Delete(WriteOptions(), handles_[1], "k3"));
+  // The stale entries are never returned
+  ASSERT_EQ("", Lookup("red"));
+  FlushPrimary();
+  ASSERT_EQ("k1,k2", Lookup("blue"));
+  ASSERT_EQ(4, CountIndexEntries());
+
+  ASSERT_OK(
+      db_->CompactRange(CompactRangeOptions(), handles_[2], nullptr, nullptr));
+  ASSERT_EQ(2, CountIndexEntries());
+  ASSERT_EQ("k1,k2", Lookup("blue"));
+}
+
+TEST_F(SecondaryIndexTest, Rebuild) {
+  ASSERT_OK(Put("k1", "red:1"));
+  ASSERT_OK(Put("k2", "green:2"));
+  ASSERT_EQ("", Lookup("green"));
+  ASSERT_OK(index_->Rebuild());
+  ASSERT_EQ("k2", Lookup("green"));
+  ASSERT_EQ("k1", Lookup("red"));
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  TERARKDB_NAMESPACE::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr,
+          "SKIPPED as SecondaryIndex is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // !ROCKSDB_LITE
@@ -0,0 +1,829 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/sharded_db.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/sst_file_writer.h"
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/threadpool.h"
+#include "rocksdb/write_batch.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+#include "util/parallel_for.h"
+#include "util/string_util.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+const char* kShardsFileName = "SHARDS";
+
+// An sst file built from a shard is about this large
+const uint64_t kMoveFileSize = 64 << 20;
+const int kMoveThreads = 4;
+// Threads helping the caller run an operation over several shards
+const int kParallelThreads = 4;
+
+const size_t kNoShard = static_cast<size_t>(-1);
+
+// Deletes the DB of a shard once the shard set and the iterators are done
+// with it, and its files too when the shard was merged away
+struct ShardDeleter {
+  std::shared_ptr<std::atomic<bool>> dropped;
+  std::string path;
+  Options options;
+
+  void operator()(DB* db) const {
+    delete db;
+    if (dropped->load(std::memory_order_acquire)) {
+      DestroyDB(path, options);
+    }
+  }
+};
+
+struct Shard {
+  uint64_t id;
+  // Empty for the first shard
+  std::string lower;
+  std::shared_ptr<DB> db;
+};
+
+std::string ShardPath(const std::string& dbname, uint64_t id) {
+  return dbname + "/shard_" + ToString(id);
+}
+
+// Iterates the shards one after another, each bounded to its range, so the
+// keys a shard still holds out of its range after a split or merge are never
+// seen. The DBs of the shards are pinned, so the iterator keeps reading the
+// shards it was created over across splits and merges
+class ShardedIterator : public Iterator {
+ public:
+  ShardedIterator(const Comparator* ucmp, const ReadOptions& options,
+                  std::vector<std::shared_ptr<DB>>&& dbs,
+                  std::vector<std::string>&& lowers)
+      : ucmp_(ucmp),
+        options_(options),
+        dbs_(std::move(dbs)),
+        lowers_(std::move(lowers)),
+        lower_slices_(dbs_.size()),
+        upper_slices_(dbs_.size()),
+        children_(dbs_.size()),
+        current_(dbs_.size()) {}
+
+  bool Valid() const override {
+    return current_ < children_.size() && children_[current_]->Valid();
+  }
+
+  void SeekToFirst() override {
+    current_ = 0;
+    SeekToFirstInShard();
+    SkipForward();
+  }
+
+  void SeekToLast() override {
+    current_ = children_.size() - 1;
+    Child(current_)->SeekToLast();
+    SkipBackward();
+  }
+
+  void Seek(const Slice& target) override {
+    current_ = FindShard(target);
+    Child(current_)->Seek(target);
+    SkipForward();
+  }
+
+  void SeekForPrev(const Slice& target) override {
+    current_ = FindShard(target);
+    Child(current_)->SeekForPrev(target);
+    SkipBackward();
+  }
+
+  void Next() override {
+    assert(Valid());
+    children_[current_]->Next();
+    SkipForward();
+  }
+
+  void Prev() override {
+    assert(Valid());
+    children_[current_]->Prev();
+    SkipBackward();
+  }
+
+  Slice key() const override { return children_[current_]->key(); }
+
+  Slice value() const override { return children_[current_]->value(); }
+
+  Status status() const override {
+    if (current_ < children_.size()) {
+      return children_[current_]->status();
+    }
+    return Status::OK();
+  }
+
+ private:
+  size_t FindShard(const Slice& key) const {
+    auto it = std::upper_bound(lowers_.begin() + 1, lowers_.end(), key,
+                               [this](const Slice& k, const std::string& b) {
+                                 return ucmp_->Compare(k, b) < 0;
+                               });
+    return it - lowers_.begin() - 1;
+  }
+
+  Iterator* Child(size_t i) {
+    if (children_[i] == nullptr) {
+      ReadOptions options = options_;
+      if (i > 0) {
+        lower_slices_[i] = lowers_[i];
+        options.iterate_lower_bound = &lower_slices_[i];
+      }
+      if (i + 1 < lowers_.size()) {
+        upper_slices_[i] = lowers_[i + 1];
+        options.iterate_upper_bound = &upper_slices_[i];
+      }
+      children_[i].reset(dbs_[i]->NewIterator(options));
+    }
+    return children_[i].get();
+  }
+
+  void SeekToFirstInShard() {
+    if (current_ == 0) {
+      Child(0)->SeekToFirst();
+    } else {
+      Child(current_)->Seek(lowers_[current_]);
+    }
+  }
+
+  // Moves on to the next shards while the current one is exhausted
+  void SkipForward() {
+    while (!Child(current_)->Valid() && Child(current_)->status().ok() &&
+           current_ + 1 < children_.size()) {
+      ++current_;
+      SeekToFirstInShard();
+    }
+  }
+
+  void SkipBackward() {
+    while (!Child(current_)->Valid() && Child(current_)->status().ok() &&
+           current_ > 0) {
+      --current_;
+      Child(current_)->SeekToLast();
+    }
+  }
+
+  const Comparator* ucmp_;
+  const ReadOptions options_;
+  const std::vector<std::shared_ptr<DB>> dbs_;
+  const std::vector<std::string> lowers_;
+  std::vector<Slice> lower_slices_;
+  std::vector<Slice> upper_slices_;
+  std::vector<std::unique_ptr<Iterator>> children_;
+  size_t current_;
+};
+
+class ShardedDBImpl : public ShardedDB {
+ public:
+  ShardedDBImpl(const Options& options, const std::string& dbname)
+      : options_(options),
+        dbname_(dbname),
+        pool_(NewThreadPool(kParallelThreads)),
+        next_id_(0),
+        moving_shard_(kNoShard) {}
+
+  ~ShardedDBImpl() { pool_->JoinAllThreads(); }
+
+  Status Open(const std::vector<std::string>& split_keys) {
+    Env* env = options_.env;
+    std::string data;
+    Status s = ReadFileToString(env, ShardsFileName(), &data);
+    if (s.IsNotFound()) {
+      if (!options_.create_if_missing) {
+        return Status::InvalidArgument(dbname_, "does not exist");
+      }
+      s = env->CreateDirIfMissing(dbname_);
+      if (!s.ok()) {
+        return s;
+      }
+      shards_.resize(split_keys.size() + 1);
+      for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i].id = next_id_++;
+        if (i > 1 &&
+            ucmp()->Compare(split_keys[i - 2], split_keys[i - 1]) >= 0) {
+          return Status::InvalidArgument("Split keys are not sorted");
+        }
+        if (i > 0) {
+          shards_[i].lower = split_keys[i - 1];
+        }
+      }
+      s = OpenShards();
+      if (s.ok()) {
+        s = SaveShards();
+      }
+      return s;
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    if (options_.error_if_exists) {
+      return Status::InvalidArgument(dbname_, "exists");
+    }
+    s = DecodeShards(data);
+    if (s.ok()) {
+      s = OpenShards();
+    }
+    return s;
+  }
+
+  Status Put(const WriteOptions& options, const Slice& key,
+             const Slice& value) override {
+    ReadLock l(&mutex_);
+    size_t shard = FindShard(key);
+    if (shard == moving_shard_) {
+      WriteBatch batch;
+      batch.Put(key, value);
+      return WriteMovingShard(options, &batch);
+    }
+    return shards_[shard].db->Put(options, key, value);
+  }
+
+  Status Delete(const WriteOptions& options, const Slice& key) override {
+    ReadLock l(&mutex_);
+    size_t shard = FindShard(key);
+    if (shard == moving_shard_) {
+      WriteBatch batch;
+      batch.Delete(key);
+      return WriteMovingShard(options, &batch);
+    }
+    return shards_[shard].db->Delete(options, key);
+  }
+
+  Status Merge(const WriteOptions& options, const Slice& key,
+               const Slice& value) override {
+    ReadLock l(&mutex_);
+    size_t shard = FindShard(key);
+    if (shard == moving_shard_) {
+      WriteBatch batch;
+      batch.Merge(key, value);
+      return WriteMovingShard(options, &batch);
+    }
+    return shards_[shard].db->Merge(options, key, value);
+  }
+
+  Status Write(const WriteOptions& options, WriteBatch* updates) override {
+    ReadLock l(&mutex_);
+    // Routes the updates into a batch per shard
+    class Router : public WriteBatch::Handler {
+     public:
+      explicit Router(ShardedDBImpl* db)
+          : db_(db), batches_(db->shards_.size()) {}
+
+      Status PutCF(uint32_t column_family_id, const Slice& key,
+                   const Slice& value) override {
+        if (column_family_id != 0) {
+          return NotSupported();
+        }
+        return batches_[db_->FindShard(key)].Put(key, value);
+      }
+      Status DeleteCF(uint32_t column_family_id, const Slice& key) override {
+        if (column_family_id != 0) {
+          return NotSupported();
+        }
+        return batches_[db_->FindShard(key)].Delete(key);
+      }
+      Status SingleDeleteCF(uint32_t column_family_id,
+                            const Slice& key) override {
+        if (column_family_id != 0) {
+          return NotSupported();
+        }
+        return batches_[db_->FindShard(key)].SingleDelete(key);
+      }
+      Status MergeCF(uint32_t column_family_id, const Slice& key,
+                     const Slice& value) override {
+        if (column_family_id != 0) {
+          return NotSupported();
+        }
+        return batches_[db_->FindShard(key)].Merge(key, value);
+      }
+      Status DeleteRangeCF(uint32_t /*column_family_id*/,
+                           const Slice& /*begin_key*/,
+                           const Slice& /*end_key*/) override {
+        return NotSupported();
+      }
+
+      std::vector<WriteBatch>& batches() { return batches_; }
+
+     private:
+      static Status NotSupported() {
+        return Status::NotSupported(
+            "ShardedDB writes only the default column family, without range "
+            "deletions");
+      }
+
+      ShardedDBImpl* db_;
+      std::vector<WriteBatch> batches_;
+    };
+    Router router(this);
+    Status s = updates->Iterate(&router);
+    if (!s.ok()) {
+      return s;
+    }
+    std::vector<size_t> touched;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      if (router.batches()[i].Count() > 0) {
+        touched.push_back(i);
+      }
+    }
+    std::vector<Status> statuses(touched.size());
+    ParallelForInPool(pool_.get(), touched.size(), [&](size_t i) {
+      WriteBatch* batch = &router.batches()[touched[i]];
+      statuses[i] = touched[i] == moving_shard_
+                        ? WriteMovingShard(options, batch)
+                        : shards_[touched[i]].db->Write(options, batch);
+    });
+    for (auto& status : statuses) {
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Get(const ReadOptions& options, const Slice& key,
+             std::string* value) override {
+    if (options.snapshot != nullptr) {
+      return Status::InvalidArgument("ShardedDB reads without snapshots");
+    }
+    ReadLock l(&mutex_);
+    return ShardOf(key)->Get(options, key, value);
+  }
+
+  std::vector<Status> MultiGet(const ReadOptions& options,
+                               const std::vector<Slice>& keys,
+                               std::vector<std::string>* values) override {
+    values->assign(keys.size(), std::string());
+    std::vector<Status> statuses(keys.size());
+    if (options.snapshot != nullptr) {
+      statuses.assign(keys.size(), Status::InvalidArgument(
+                                       "ShardedDB reads without snapshots"));
+      return statuses;
+    }
+    ReadLock l(&mutex_);
+    // The positions of the keys of each shard
+    std::vector<std::vector<size_t>> groups(shards_.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      groups[FindShard(keys[i])].push_back(i);
+    }
+    std::vector<size_t> touched;
+    for (size_t i = 0; i < groups.size(); ++i) {
+      if (!groups[i].empty()) {
+        touched.push_back(i);
+      }
+    }
+    ParallelForInPool(pool_.get(), touched.size(), [&](size_t t) {
+      const std::vector<size_t>& group = groups[touched[t]];
+      std::vector<Slice> shard_keys;
+      for (size_t i : group) {
+        shard_keys.push_back(keys[i]);
+      }
+      std::vector<std::string> shard_values;
+      std::vector<Status> shard_statuses =
+          shards_[touched[t]].db->MultiGet(options, shard_keys, &shard_values);
+      for (size_t i = 0; i < group.size(); ++i) {
+        statuses[group[i]] = std::move(shard_statuses[i]);
+        (*values)[group[i]] = std::move(shard_values[i]);
+      }
+    });
+    return statuses;
+  }
+
+  Iterator* NewIterator(const ReadOptions& options) override {
+    if (options.snapshot != nullptr || options.iterate_lower_bound != nullptr ||
+        options.iterate_upper_bound != nullptr) {
+      return NewErrorIterator(Status::InvalidArgument(
+          "ShardedDB iterates without snapshots and bounds"));
+    }
+    ReadLock l(&mutex_);
+    std::vector<std::shared_ptr<DB>> dbs;
+    std::vector<std::string> lowers;
+    for (auto& shard : shards_) {
+      dbs.push_back(shard.db);
+      lowers.push_back(shard.lower);
+    }
+    return new ShardedIterator(ucmp(), options, std::move(dbs),
+                               std::move(lowers));
+  }
+
+  Status Flush(const FlushOptions& options) override {
+    ReadLock l(&mutex_);
+    std::vector<Status> statuses(shards_.size());
+    ParallelForInPool(pool_.get(), shards_.size(), [&](size_t i) {
+      statuses[i] = shards_[i].db->Flush(options);
+    });
+    for (auto& status : statuses) {
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status SplitShard(size_t shard, const Slice& split_key) override {
+    MutexLock change(&change_mutex_);
+    std::shared_ptr<DB> source;
+    std::string upper;
+    {
+      ReadLock l(&mutex_);
+      if (shard >= shards_.size()) {
+        return Status::InvalidArgument("No such shard");
+      }
+      if ((shard > 0 &&
+           ucmp()->Compare(split_key, shards_[shard].lower) <= 0) ||
+          (shard + 1 < shards_.size() &&
+           ucmp()->Compare(split_key, shards_[shard + 1].lower) >= 0)) {
+        return Status::InvalidArgument("Split key is out of the shard");
+      }
+      source = shards_[shard].db;
+      if (shard + 1 < shards_.size()) {
+        upper = shards_[shard + 1].lower;
+      }
+    }
+    Shard added;
+    added.lower = split_key.ToString();
+    {
+      WriteLock l(&mutex_);
+      added.id = next_id_++;
+    }
+    std::string path = ShardPath(dbname_, added.id);
+    // Left by an interrupted split
+    Status s = DestroyDB(path, options_);
+    if (s.ok()) {
+      s = OpenShard(&added);
+    }
+    bool rerouted = false;
+    if (s.ok()) {
+      s = MoveRange(shard, source.get(), split_key, upper, added.db.get(),
+                    path, [&] {
+                      shards_.insert(shards_.begin() + shard + 1, added);
+                      rerouted = true;
+                    });
+    }
+    if (!s.ok()) {
+      if (added.db != nullptr && !rerouted) {
+        MarkDropped(added);
+      }
+      return s;
+    }
+    // The moved keys are out of the range of the shard now, unreachable
+    // before they are deleted
+    return DeleteMovedKeys(source.get(), split_key, upper);
+  }
+
+  Status MergeShards(size_t shard) override {
+    MutexLock change(&change_mutex_);
+    Shard dropped;
+    Shard target;
+    std::string upper;
+    {
+      ReadLock l(&mutex_);
+      if (shard + 1 >= shards_.size()) {
+        return Status::InvalidArgument("No shard after the shard");
+      }
+      dropped = shards_[shard + 1];
+      target = shards_[shard];
+      if (shard + 2 < shards_.size()) {
+        upper = shards_[shard + 2].lower;
+      }
+    }
+    Status s = MoveRange(shard + 1, dropped.db.get(), dropped.lower, upper,
+                         target.db.get(), ShardPath(dbname_, target.id),
+                         [&] { shards_.erase(shards_.begin() + shard + 1); });
+    if (s.ok()) {
+      // The files go once the iterators reading the shard are done
+      MarkDropped(dropped);
+    }
+    return s;
+  }
+
+  size_t NumShards() override {
+    ReadLock l(&mutex_);
+    return shards_.size();
+  }
+
+  std::vector<std::string> GetSplitKeys() override {
+    ReadLock l(&mutex_);
+    std::vector<std::string> split_keys;
+    for (size_t i = 1; i < shards_.size(); ++i) {
+      split_keys.push_back(shards_[i].lower);
+    }
+    return split_keys;
+  }
+
+  DB* GetShard(size_t shard) override {
+    ReadLock l(&mutex_);
+    return shard < shards_.size() ? shards_[shard].db.get() : nullptr;
+  }
+
+ private:
+  const Comparator* ucmp() const { return options_.comparator; }
+
+  std::string ShardsFileName() const { return dbname_ + "/" + kShardsFileName; }
+
+  size_t FindShard(const Slice& key) const {
+    auto it = std::upper_bound(shards_.begin() + 1, shards_.end(), key,
+                               [this](const Slice& k, const Shard& shard) {
+                                 return ucmp()->Compare(k, shard.lower) < 0;
+                               });
+    return it - shards_.begin() - 1;
+  }
+
+  DB* ShardOf(const Slice& key) const {
+    return shards_[FindShard(key)].db.get();
+  }
+
+  Status OpenShard(Shard* shard) {
+    Options options = options_;
+    options.create_if_missing = true;
+    options.error_if_exists = false;
+    DB* db = nullptr;
+    std::string path = ShardPath(dbname_, shard->id);
+    Status s = DB::Open(options, path, &db);
+    if (s.ok()) {
+      auto dropped = std::make_shared<std::atomic<bool>>(false);
+      shard->db.reset(db, ShardDeleter{dropped, path, options_});
+    }
+    return s;
+  }
+
+  static void MarkDropped(const Shard& shard) {
+    std::get_deleter<ShardDeleter>(shard.db)->dropped->store(
+        true, std::memory_order_release);
+  }
+
+  // REQUIRES: mutex_ held shared, shard == moving_shard_
+  Status WriteMovingShard(const WriteOptions& options, WriteBatch* batch) {
+    // Copies the updates of the moved keys into move_pending_
+    class Recorder : public WriteBatch::Handler {
+     public:
+      explicit Recorder(ShardedDBImpl* db) : db_(db) {}
+
+      Status PutCF(uint32_t /*column_family_id*/, const Slice& key,
+                   const Slice& value) override {
+        return Moved(key) ? db_->move_pending_.Put(key, value) : Status::OK();
+      }
+      Status DeleteCF(uint32_t /*column_family_id*/,
+                      const Slice& key) override {
+        return Moved(key) ? db_->move_pending_.Delete(key) : Status::OK();
+      }
+      Status SingleDeleteCF(uint32_t /*column_family_id*/,
+                            const Slice& key) override {
+        return Moved(key) ? db_->move_pending_.SingleDelete(key)
+                          : Status::OK();
+      }
+      Status MergeCF(uint32_t /*column_family_id*/, const Slice& key,
+                     const Slice& value) override {
+        return Moved(key) ? db_->move_pending_.Merge(key, value)
+                          : Status::OK();
+      }
+
+     private:
+      bool Moved(const Slice& key) const {
+        return db_->ucmp()->Compare(key, db_->move_begin_) >= 0;
+      }
+
+      ShardedDBImpl* db_;
+    };
+    // Keeps the order of the updates of a key the same in both shards
+    MutexLock l(&move_mutex_);
+    Status s = shards_[moving_shard_].db->Write(options, batch);
+    if (s.ok()) {
+      Recorder recorder(this);
+      s = batch->Iterate(&recorder);
+    }
+    return s;
+  }
+
+  Status OpenShards() {
+    std::vector<Status> statuses(shards_.size());
+    ParallelForInPool(pool_.get(), shards_.size(), [&](size_t i) {
+      statuses[i] = OpenShard(&shards_[i]);
+    });
+    for (auto& status : statuses) {
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status DecodeShards(Slice input) {
+    uint64_t count = 0;
+    if (!GetVarint64(&input, &next_id_) || !GetVarint64(&input, &count)) {
+      return Status::Corruption(ShardsFileName(), "bad header");
+    }
+    shards_.resize(count);
+    for (auto& shard : shards_) {
+      Slice lower;
+      if (!GetVarint64(&input, &shard.id) ||
+          !GetLengthPrefixedSlice(&input, &lower)) {
+        return Status::Corruption(ShardsFileName(), "bad shard");
+      }
+      shard.lower = lower.ToString();
+    }
+    if (shards_.empty()) {
+      return Status::Corruption(ShardsFileName(), "no shard");
+    }
+    return Status::OK();
+  }
+
+  // Replaces the SHARDS file atomically
+  Status SaveShards() {
+    std::string data;
+    PutVarint64(&data, next_id_);
+    PutVarint64(&data, shards_.size());
+    for (auto& shard : shards_) {
+      PutVarint64(&data, shard.id);
+      PutLengthPrefixedSlice(&data, shard.lower);
+    }
+    std::string temp = ShardsFileName() + ".tmp";
+    Status s = WriteStringToFile(options_.env, data, temp, true);
+    if (s.ok()) {
+      s = options_.env->RenameFile(temp, ShardsFileName());
+    }
+    return s;
+  }
+
+  // Moves the keys of source, the DB of shard, in [begin, upper) into
+  // target, then calls reroute to change the shards. upper is empty for the
+  // last shard.
+  //
+  // The keys are copied from a snapshot through sst files built in dir,
+  // while the reads and writes go on. The updates of the moved keys made
+  // meanwhile are recorded, and replayed into target under the exclusive
+  // lock along with reroute.
+  //
+  // REQUIRES: change_mutex_ held
+  template <class Reroute>
+  Status MoveRange(size_t shard, DB* source, const Slice& begin,
+                   const std::string& upper, DB* target,
+                   const std::string& dir, Reroute reroute) {
+    const Snapshot* snapshot;
+    {
+      WriteLock l(&mutex_);
+      moving_shard_ = shard;
+      move_begin_ = begin.ToString();
+      move_pending_.Clear();
+      snapshot = source->GetSnapshot();
+    }
+    ReadOptions read_options;
+    read_options.fill_cache = false;
+    read_options.snapshot = snapshot;
+    Slice upper_slice(upper);
+    if (!upper.empty()) {
+      read_options.iterate_upper_bound = &upper_slice;
+    }
+    std::unique_ptr<Iterator> iter(source->NewIterator(read_options));
+    ParallelSstFileWriter writer(EnvOptions(options_), options_, nullptr,
+                                 kMoveThreads, kMoveFileSize);
+    Status s = writer.Open(dir + "/move_");
+    bool empty = true;
+    for (iter->Seek(begin); s.ok() && iter->Valid(); iter->Next()) {
+      s = writer.Put(iter->key(), iter->value());
+      empty = false;
+    }
+    if (s.ok()) {
+      s = iter->status();
+    }
+    iter.reset();
+    source->ReleaseSnapshot(snapshot);
+    std::vector<ExternalSstFileInfo> infos;
+    if (s.ok()) {
+      s = writer.Finish(&infos);
+    }
+    if (s.ok() && !empty) {
+      std::vector<std::string> files;
+      for (auto& info : infos) {
+        files.push_back(info.file_path);
+      }
+      IngestExternalFileOptions ingest_options;
+      ingest_options.move_files = true;
+      s = target->IngestExternalFile(files, ingest_options);
+    }
+
+    WriteLock l(&mutex_);
+    if (s.ok() && move_pending_.Count() > 0) {
+      s = target->Write(WriteOptions(), &move_pending_);
+    }
+    moving_shard_ = kNoShard;
+    move_pending_.Clear();
+    if (s.ok()) {
+      reroute();
+      s = SaveShards();
+    }
+    return s;
+  }
+
+  // Deletes the keys of source in [begin, upper), out of its range since
+  // they moved to another shard
+  Status DeleteMovedKeys(DB* source, const Slice& begin,
+                         const std::string& upper) {
+    std::string end = upper;
+    bool delete_end = false;
+    if (end.empty()) {
+      // The last shard, its last key ends the range
+      std::unique_ptr<Iterator> iter(source->NewIterator(ReadOptions()));
+      iter->SeekToLast();
+      if (!iter->Valid()) {
+        return iter->status();
+      }
+      if (ucmp()->Compare(iter->key(), begin) < 0) {
+        return Status::OK();
+      }
+      end = iter->key().ToString();
+      delete_end = true;
+    }
+    Status s = source->DeleteRange(WriteOptions(),
+                                   source->DefaultColumnFamily(), begin, end);
+    if (s.ok() && delete_end) {
+      s = source->Delete(WriteOptions(), end);
+    }
+    return s;
+  }
+
+  const Options options_;
+  const std::string dbname_;
+  // Runs the operations over several shards, the caller takes a part too
+  std::unique_ptr<ThreadPool> pool_;
+  // Held shared by the reads and writes, and exclusively by the changes of
+  // the shards
+  port::RWMutex mutex_;
+  std::vector<Shard> shards_;
+  uint64_t next_id_;
+  // Held across a split or a merge
+  port::Mutex change_mutex_;
+  // The shard whose keys from move_begin_ on are being moved, kNoShard when
+  // none. Set under the exclusive mutex_
+  size_t moving_shard_;
+  std::string move_begin_;
+  // The updates of the moved keys made during the move, written under
+  // move_mutex_
+  port::Mutex move_mutex_;
+  WriteBatch move_pending_;
+};
+
+}  // namespace
+
+Status ShardedDB::Open(const Options& options, const std::string& dbname,
+                       const std::vector<std::string>& split_keys,
+                       ShardedDB** dbptr) {
+  *dbptr = nullptr;
+  std::unique_ptr<ShardedDBImpl> impl(new ShardedDBImpl(options, dbname));
+  Status s = impl->Open(split_keys);
+  if (s.ok()) {
+    *dbptr = impl.release();
+  }
+  return s;
+}
+
+Status DestroyShardedDB(const std::string& dbname, const Options& options) {
+  Env* env = options.env;
+  std::vector<std::string> children;
+  Status s = env->GetChildren(dbname, &children);
+  if (s.IsNotFound()) {
+    return Status::OK();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  for (auto& child : children) {
+    if (child.compare(0, 6, "shard_") == 0) {
+      s = DestroyDB(dbname + "/" + child, options);
+      if (s.ok()) {
+        env->DeleteDir(dbname + "/" + child);
+      }
+    } else if (child.compare(0, strlen(kShardsFileName), kShardsFileName) ==
+               0) {
+      s = env->DeleteFile(dbname + "/" + child);
+    }
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  env->DeleteDir(dbname);
+  return Status::OK();
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+#endif  // ROCKSDB_LITE
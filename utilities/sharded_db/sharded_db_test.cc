@@ -0,0 +1,260 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/sharded_db.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/write_batch.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class ShardedDBTest : public testing::Test {
+ public:
+  ShardedDBTest() {
+    dbname_ = test::PerThreadDBPath("sharded_db_test");
+    options_.create_if_missing = true;
+    DestroyShardedDB(dbname_, options_);
+  }
+
+  ~ShardedDBTest() {
+    db_.reset();
+    DestroyShardedDB(dbname_, options_);
+  }
+
+  void Open(const std::vector<std::string>& split_keys = {}) {
+    db_.reset();
+    ShardedDB* db = nullptr;
+    ASSERT_OK(ShardedDB::Open(options_, dbname_, split_keys, &db));
+    db_.reset(db);
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%04d", i);
+    return buf;
+  }
+
+  std::string Get(const std::string& key) {
+    std::string value;
+    Status s = db_->Get(ReadOptions(), key, &value);
+    if (s.IsNotFound()) {
+      return "NOT_FOUND";
+    }
+    return s.ok() ? value : s.ToString();
+  }
+
+  // The keys in iteration order, forward and backward
+  void CheckIteration(int count) {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int i = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++i) {
+      ASSERT_EQ(Key(i), iter->key().ToString());
+      ASSERT_EQ("v" + Key(i), iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(count, i);
+    for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+      ASSERT_EQ(Key(--i), iter->key().ToString());
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(0, i);
+  }
+
+  void Fill(int count) {
+    for (int i = 0; i < count; ++i) {
+      ASSERT_OK(db_->Put(WriteOptions(), Key(i), "v" + Key(i)));
+    }
+  }
+
+  std::string dbname_;
+  Options options_;
+  std::unique_ptr<ShardedDB> db_;
+};
+
+TEST_F(ShardedDBTest, Routing) {
+  Open({Key(100), Key(200)});
+  ASSERT_EQ(3U, db_->NumShards());
+  Fill(300);
+
+  // Every shard holds its range only
+  std::string value;
+  ASSERT_OK(db_->GetShard(0)->Get(ReadOptions(), Key(99), &value));
+  ASSERT_TRUE(db_->GetShard(0)->Get(ReadOptions(), Key(100), &value)
+                  .IsNotFound());
+  ASSERT_OK(db_->GetShard(1)->Get(ReadOptions(), Key(100), &value));
+  ASSERT_OK(db_->GetShard(2)->Get(ReadOptions(), Key(299), &value));
+
+  WriteBatch batch;
+  ASSERT_OK(batch.Put(Key(50), "a"));
+  ASSERT_OK(batch.Put(Key(150), "b"));
+  ASSERT_OK(batch.Delete(Key(250)));
+  ASSERT_OK(db_->Write(WriteOptions(), &batch));
+  ASSERT_EQ("a", Get(Key(50)));
+  ASSERT_EQ("b", Get(Key(150)));
+  ASSERT_EQ("NOT_FOUND", Get(Key(250)));
+
+  WriteBatch range_batch;
+  ASSERT_OK(range_batch.DeleteRange(Key(0), Key(10)));
+  ASSERT_TRUE(db_->Write(WriteOptions(), &range_batch).IsNotSupported());
+}
+
+TEST_F(ShardedDBTest, MultiGet) {
+  Open({Key(100), Key(200)});
+  Fill(300);
+  std::vector<std::string> keys = {Key(250), Key(5), "missing", Key(150),
+                                   Key(6)};
+  std::vector<Slice> key_slices(keys.begin(), keys.end());
+  std::vector<std::string> values;
+  std::vector<Status> statuses =
+      db_->MultiGet(ReadOptions(), key_slices, &values);
+  ASSERT_EQ(keys.size(), statuses.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] == "missing") {
+      ASSERT_TRUE(statuses[i].IsNotFound());
+    } else {
+      ASSERT_OK(statuses[i]);
+      ASSERT_EQ("v" + keys[i], values[i]);
+    }
+  }
+}
+
+TEST_F(ShardedDBTest, Iterator) {
+  Open({Key(100), Key(150), Key(200)});
+  // The shard of [Key(150), Key(200)) stays empty
+  for (int i = 0; i < 300; ++i) {
+    if (i < 150 || i >= 200) {
+      ASSERT_OK(db_->Put(WriteOptions(), Key(i), "v" + Key(i)));
+    }
+  }
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  iter->Seek(Key(149));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(149), iter->key().ToString());
+  iter->Next();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(200), iter->key().ToString());
+  iter->Prev();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(149), iter->key().ToString());
+  iter->SeekForPrev(Key(170));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(149), iter->key().ToString());
+  iter->Seek(Key(170));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(200), iter->key().ToString());
+  iter->Seek(Key(300));
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_OK(iter->status());
+}
+
+TEST_F(ShardedDBTest, SplitAndMerge) {
+  Open();
+  Fill(300);
+  ASSERT_OK(db_->Flush(FlushOptions()));
+
+  ASSERT_OK(db_->SplitShard(0, Key(100)));
+  ASSERT_OK(db_->SplitShard(1, Key(200)));
+  ASSERT_EQ(std::vector<std::string>({Key(100), Key(200)}),
+            db_->GetSplitKeys());
+  CheckIteration(300);
+  for (int i = 0; i < 300; i += 7) {
+    ASSERT_EQ("v" + Key(i), Get(Key(i)));
+  }
+  // The moved keys are gone from the split shard
+  std::string value;
+  ASSERT_TRUE(db_->GetShard(0)->Get(ReadOptions(), Key(100), &value)
+                  .IsNotFound());
+  ASSERT_TRUE(db_->SplitShard(0, Key(150)).IsInvalidArgument());
+
+  // The bounds survive reopening
+  Open();
+  ASSERT_EQ(3U, db_->NumShards());
+  CheckIteration(300);
+
+  ASSERT_OK(db_->MergeShards(0));
+  ASSERT_EQ(std::vector<std::string>({Key(200)}), db_->GetSplitKeys());
+  CheckIteration(300);
+  ASSERT_OK(db_->GetShard(0)->Get(ReadOptions(), Key(150), &value));
+  ASSERT_TRUE(db_->MergeShards(1).IsInvalidArgument());
+
+  Open();
+  ASSERT_EQ(2U, db_->NumShards());
+  CheckIteration(300);
+}
+
+TEST_F(ShardedDBTest, IteratorOutlivesMerge) {
+  Open({Key(100)});
+  Fill(200);
+  ASSERT_OK(db_->Flush(FlushOptions()));
+
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  iter->Seek(Key(50));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_OK(db_->MergeShards(0));
+  ASSERT_EQ(1U, db_->NumShards());
+
+  // Still reading the merged away shard
+  int i = 50;
+  for (; iter->Valid(); iter->Next(), ++i) {
+    ASSERT_EQ(Key(i), iter->key().ToString());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(200, i);
+  iter.reset();
+  CheckIteration(200);
+}
+
+TEST_F(ShardedDBTest, WritesDuringSplit) {
+  Open();
+  Fill(300);
+  ASSERT_OK(db_->Flush(FlushOptions()));
+
+  // Overwrites the keys while they move
+  std::atomic<bool> stop(false);
+  std::thread writer([&] {
+    while (!stop.load()) {
+      for (int i = 0; i < 300; ++i) {
+        ASSERT_OK(db_->Put(WriteOptions(), Key(i), "v" + Key(i)));
+      }
+    }
+  });
+  ASSERT_OK(db_->SplitShard(0, Key(150)));
+  stop.store(true);
+  writer.join();
+  ASSERT_OK(db_->Delete(WriteOptions(), Key(299)));
+
+  ASSERT_EQ(2U, db_->NumShards());
+  CheckIteration(299);
+  std::string value;
+  ASSERT_TRUE(db_->GetShard(0)->Get(ReadOptions(), Key(150), &value)
+                  .IsNotFound());
+  ASSERT_OK(db_->GetShard(1)->Get(ReadOptions(), Key(150), &value));
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else  // ROCKSDB_LITE
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as ShardedDB is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_LITE
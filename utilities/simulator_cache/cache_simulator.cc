@@ -0,0 +1,252 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "utilities/simulator_cache/cache_simulator.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+const std::string kGhostCachePrefix = "ghost_";
+const uint64_t kMicrosInSecond = 1000 * 1000;
+
+// The simulated caches are keyed by the file number and the record
+std::string RecordKey(const TableAccessRecord& access) {
+  std::string key;
+  PutFixed64(&key, access.file_number);
+  PutFixed64(&key, access.record);
+  return key;
+}
+
+// A record read lazily has no size, it still takes room in the cache
+size_t RecordCharge(const TableAccessRecord& access) {
+  return static_cast<size_t>(std::max<uint64_t>(access.size, 1));
+}
+
+Status ReadTrace(TraceReader* reader, Trace* trace) {
+  std::string encoded_trace;
+  Status s = reader->Read(&encoded_trace);
+  if (!s.ok()) {
+    return s;
+  }
+  Slice enc_slice(encoded_trace);
+  if (enc_slice.size() < kTraceMetadataSize ||
+      !GetFixed64(&enc_slice, &trace->ts)) {
+    return Status::Corruption("Corrupted trace file. Short trace.");
+  }
+  trace->type = static_cast<TraceType>(enc_slice[0]);
+  enc_slice.remove_prefix(kTraceTypeSize + kTracePayloadLengthSize);
+  trace->payload = enc_slice.ToString();
+  return s;
+}
+
+// The simulated caches store keys only.
+void DeleteNothing(const Slice& /*key*/, void* /*value*/) {}
+}  // namespace
+
+GhostCache::GhostCache(std::shared_ptr<Cache> sim_cache)
+    : sim_cache_(sim_cache) {}
+
+bool GhostCache::Admit(const Slice& lookup_key) {
+  auto handle = sim_cache_->Lookup(lookup_key);
+  if (handle != nullptr) {
+    sim_cache_->Release(handle);
+    return true;
+  }
+  sim_cache_->Insert(lookup_key, /*value=*/nullptr, lookup_key.size(),
+                     &DeleteNothing);
+  return false;
+}
+
+CacheSimulator::CacheSimulator(std::unique_ptr<GhostCache>&& ghost_cache,
+                               std::shared_ptr<Cache> sim_cache)
+    : ghost_cache_(std::move(ghost_cache)), sim_cache_(sim_cache) {}
+
+void CacheSimulator::AccessKey(const TableAccessRecord& access,
+                               Cache::Priority priority) {
+  std::string key = RecordKey(access);
+  auto handle = sim_cache_->Lookup(key);
+  if (handle != nullptr) {
+    sim_cache_->Release(handle);
+    num_hits_++;
+    return;
+  }
+  num_misses_++;
+  // The ghost cache must see every miss, including the ones that are not
+  // inserted, so that its recency window covers the whole trace.
+  bool admit = ghost_cache_ == nullptr || ghost_cache_->Admit(key);
+  if (admit) {
+    sim_cache_->Insert(key, /*value=*/nullptr, RecordCharge(access),
+                       &DeleteNothing, /*handle=*/nullptr, priority);
+  }
+}
+
+void CacheSimulator::Access(const TableAccessRecord& access) {
+  AccessKey(access, Cache::Priority::LOW);
+}
+
+void PrioritizedCacheSimulator::Access(const TableAccessRecord& access) {
+  Cache::Priority priority = Cache::Priority::LOW;
+  if (access.caller == kTableAccessGet || access.caller == kTableAccessFetch) {
+    priority = Cache::Priority::HIGH;
+  }
+  AccessKey(access, priority);
+}
+
+double CacheSimulator::miss_ratio() const {
+  uint64_t accesses = total_accesses();
+  if (accesses == 0) {
+    return -1;
+  }
+  return static_cast<double>(num_misses_ * 100.0 / accesses);
+}
+
+TableAccessTraceSimulator::TableAccessTraceSimulator(
+    uint64_t warmup_seconds, uint32_t downsample_ratio,
+    const std::vector<CacheConfiguration>& cache_configurations)
+    : warmup_seconds_(warmup_seconds),
+      downsample_ratio_(std::max<uint32_t>(downsample_ratio, 1)),
+      cache_configurations_(cache_configurations) {}
+
+Status TableAccessTraceSimulator::InitializeCaches() {
+  for (auto const& config : cache_configurations_) {
+    std::string cache_name = config.cache_name;
+    bool ghost = false;
+    if (cache_name.compare(0, kGhostCachePrefix.size(), kGhostCachePrefix) ==
+        0) {
+      ghost = true;
+      cache_name = cache_name.substr(kGhostCachePrefix.size());
+    }
+    int num_shard_bits = static_cast<int>(config.num_shard_bits);
+    for (auto cache_capacity : config.cache_capacities) {
+      // Scale down the cache capacity since the trace contains accesses on
+      // 1/'downsample_ratio' records.
+      uint64_t simulate_cache_capacity = cache_capacity / downsample_ratio_;
+      std::unique_ptr<GhostCache> ghost_cache;
+      if (ghost) {
+        uint64_t ghost_cache_capacity = config.ghost_cache_capacity == 0
+                                            ? simulate_cache_capacity
+                                            : config.ghost_cache_capacity /
+                                                  downsample_ratio_;
+        ghost_cache.reset(new GhostCache(
+            NewLRUCache(ghost_cache_capacity, num_shard_bits,
+                        /*strict_capacity_limit=*/false,
+                        /*high_pri_pool_ratio=*/0)));
+      }
+      std::shared_ptr<CacheSimulator> sim_cache;
+      if (cache_name == "lru") {
+        sim_cache = std::make_shared<CacheSimulator>(
+            std::move(ghost_cache),
+            NewLRUCache(simulate_cache_capacity, num_shard_bits,
+                        /*strict_capacity_limit=*/false,
+                        /*high_pri_pool_ratio=*/0));
+      } else if (cache_name == "lru_priority") {
+        sim_cache = std::make_shared<PrioritizedCacheSimulator>(
+            std::move(ghost_cache),
+            NewLRUCache(simulate_cache_capacity, num_shard_bits,
+                        /*strict_capacity_limit=*/false,
+                        /*high_pri_pool_ratio=*/0.5));
+      } else if (cache_name == "lirs") {
+        sim_cache = std::make_shared<CacheSimulator>(
+            std::move(ghost_cache),
+            NewLIRSCache(simulate_cache_capacity, num_shard_bits,
+                         /*strict_capacity_limit=*/false));
+      } else if (cache_name == "clock") {
+        std::shared_ptr<Cache> clock_cache =
+            NewClockCache(simulate_cache_capacity, num_shard_bits,
+                          /*strict_capacity_limit=*/false);
+        if (clock_cache == nullptr) {
+          return Status::NotSupported("Clock cache is not supported");
+        }
+        sim_cache = std::make_shared<CacheSimulator>(std::move(ghost_cache),
+                                                     clock_cache);
+      } else {
+        // Not supported.
+        return Status::InvalidArgument("Unknown cache name " +
+                                       config.cache_name);
+      }
+      sim_caches_[config].push_back(sim_cache);
+    }
+  }
+  return Status::OK();
+}
+
+void TableAccessTraceSimulator::Access(const TableAccessRecord& access) {
+  if (trace_start_time_ == 0) {
+    trace_start_time_ = access.access_timestamp;
+  }
+  // access.access_timestamp is in microseconds.
+  if (!warmup_complete_ &&
+      trace_start_time_ + warmup_seconds_ * kMicrosInSecond <=
+          access.access_timestamp) {
+    for (auto& config_caches : sim_caches_) {
+      for (auto& sim_cache : config_caches.second) {
+        sim_cache->reset_counter();
+      }
+    }
+    warmup_complete_ = true;
+  }
+  for (auto& config_caches : sim_caches_) {
+    for (auto& sim_cache : config_caches.second) {
+      sim_cache->Access(access);
+    }
+  }
+}
+
+Status TableAccessTraceSimulator::Replay(TraceReader* reader) {
+  Trace trace;
+  Status s = ReadTrace(reader, &trace);
+  if (!s.ok()) {
+    return s;
+  }
+  if (trace.type != kTraceBegin ||
+      trace.payload.compare(0, kTraceMagic.size(), kTraceMagic) != 0) {
+    return Status::Corruption("Corrupted trace file. Incorrect header.");
+  }
+  TableAccessRecord access;
+  while (true) {
+    s = ReadTrace(reader, &trace);
+    if (s.IsIncomplete() || (s.ok() && trace.type == kTraceEnd)) {
+      // Reached the end of the trace.
+      return Status::OK();
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    if (trace.type != kTraceTableAccess) {
+      continue;
+    }
+    s = TableAccessTracer::DecodeAccess(trace, &access);
+    if (!s.ok()) {
+      return s;
+    }
+    Access(access);
+  }
+}
+
+void TableAccessTraceSimulator::ReportMissRatioCurves(
+    std::string* report) const {
+  char buf[256];
+  for (auto const& config_caches : sim_caches_) {
+    const CacheConfiguration& config = config_caches.first;
+    for (auto const& sim_cache : config_caches.second) {
+      snprintf(buf, sizeof(buf),
+               ",%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%.2f,%" PRIu64 "\n",
+               config.num_shard_bits, config.ghost_cache_capacity,
+               static_cast<uint64_t>(sim_cache->capacity()) *
+                   downsample_ratio_,
+               sim_cache->miss_ratio(), sim_cache->total_accesses());
+      report->append(config.cache_name);
+      report->append(buf);
+    }
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
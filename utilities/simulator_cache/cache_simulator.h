@@ -5,32 +5,78 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/cache.h"
 #include "rocksdb/terark_namespace.h"
-#include "rocksdb/utilities/sim_cache.h"
-#include "trace_replay/block_cache_tracer.h"
+#include "rocksdb/trace_reader_writer.h"
+#include "util/trace_replay.h"
 
 namespace TERARKDB_NAMESPACE {
 
 // A cache configuration provided by user.
+//
+// cache_name selects the replacement policy of the simulated cache: "lru",
+// "lru_priority", "lirs" or "clock". Prefixing the name with "ghost_" (e.g.
+// "ghost_lirs") puts a ghost cache in front of the simulated cache so that a
+// missing record is only admitted on its second miss within the ghost cache
+// window.
 struct CacheConfiguration {
-  std::string cache_name;  // LRU.
+  std::string cache_name;  // LRU, LIRS, CLOCK, optionally ghost admitted.
   uint32_t num_shard_bits;
+  uint64_t ghost_cache_capacity;  // ghost cache capacity in bytes of keys.
+                                  // 0 means the simulated cache capacity.
   std::vector<uint64_t>
       cache_capacities;  // simulate cache capacities in bytes.
 
-  bool operator=(const CacheConfiguration& o) const {
-    return cache_name == o.cache_name && num_shard_bits == o.num_shard_bits;
+  CacheConfiguration() : num_shard_bits(0), ghost_cache_capacity(0) {}
+
+  bool operator==(const CacheConfiguration& o) const {
+    return cache_name == o.cache_name && num_shard_bits == o.num_shard_bits &&
+           ghost_cache_capacity == o.ghost_cache_capacity;
   }
   bool operator<(const CacheConfiguration& o) const {
     return cache_name < o.cache_name ||
-           (cache_name == o.cache_name && num_shard_bits < o.num_shard_bits);
+           (cache_name == o.cache_name && num_shard_bits < o.num_shard_bits) ||
+           (cache_name == o.cache_name && num_shard_bits == o.num_shard_bits &&
+            ghost_cache_capacity < o.ghost_cache_capacity);
   }
 };
 
-// A cache simulator that runs against a block cache trace.
+// A ghost cache remembers the keys of recently missed records without their
+// values. It admits a key into the simulated cache only when the key is
+// already in the ghost cache, which keeps one-time accesses (e.g. scans) from
+// polluting the simulated cache.
+class GhostCache {
+ public:
+  explicit GhostCache(std::shared_ptr<Cache> sim_cache);
+  ~GhostCache() = default;
+  // No copy and move.
+  GhostCache(const GhostCache&) = delete;
+  GhostCache& operator=(const GhostCache&) = delete;
+  GhostCache(GhostCache&&) = delete;
+  GhostCache& operator=(GhostCache&&) = delete;
+
+  // Returns true if the lookup_key is in the ghost cache.
+  // Returns false otherwise, and records the key in the ghost cache.
+  bool Admit(const Slice& lookup_key);
+
+ private:
+  std::shared_ptr<Cache> sim_cache_;
+};
+
+// A cache simulator that runs against a table access trace, see
+// TableAccessTracer. A record is identified by its file number and record,
+// its size is the charge. It keeps keys only, so any Cache implementation
+// (LRU, LIRS, CLOCK) can be used as the simulated cache, and counts hits and
+// misses itself.
 class CacheSimulator {
  public:
-  CacheSimulator(std::shared_ptr<SimCache> sim_cache);
+  CacheSimulator(std::unique_ptr<GhostCache>&& ghost_cache,
+                 std::shared_ptr<Cache> sim_cache);
   virtual ~CacheSimulator() = default;
   // No copy and move.
   CacheSimulator(const CacheSimulator&) = delete;
@@ -38,44 +84,72 @@ class CacheSimulator {
   CacheSimulator(CacheSimulator&&) = delete;
   CacheSimulator& operator=(CacheSimulator&&) = delete;
 
-  virtual void Access(const BlockCacheTraceRecord& access);
-  void reset_counter() { sim_cache_->reset_counter(); }
-  double miss_ratio();
-  uint64_t total_accesses();
+  virtual void Access(const TableAccessRecord& access);
+  void reset_counter() {
+    num_hits_ = 0;
+    num_misses_ = 0;
+  }
+  double miss_ratio() const;
+  uint64_t total_accesses() const { return num_hits_ + num_misses_; }
+  size_t capacity() const { return sim_cache_->GetCapacity(); }
 
  protected:
-  std::shared_ptr<SimCache> sim_cache_;
+  // Looks up the record and, on a miss, inserts it with the given priority if
+  // the ghost cache admits it.
+  void AccessKey(const TableAccessRecord& access, Cache::Priority priority);
+
+  std::unique_ptr<GhostCache> ghost_cache_;
+  std::shared_ptr<Cache> sim_cache_;
+  uint64_t num_hits_ = 0;
+  uint64_t num_misses_ = 0;
 };
 
-// A prioritized cache simulator that runs against a block cache trace.
-// It inserts missing index/filter/uncompression-dictionary blocks with high
-// priority in the cache.
+// A prioritized cache simulator that runs against a table access trace.
+// It inserts the records missed by point lookups (Get and separated value
+// fetches) with high priority in the cache, so scans do not evict them.
 class PrioritizedCacheSimulator : public CacheSimulator {
  public:
-  PrioritizedCacheSimulator(std::shared_ptr<SimCache> sim_cache)
-      : CacheSimulator(sim_cache) {}
-  void Access(const BlockCacheTraceRecord& access) override;
+  PrioritizedCacheSimulator(std::unique_ptr<GhostCache>&& ghost_cache,
+                            std::shared_ptr<Cache> sim_cache)
+      : CacheSimulator(std::move(ghost_cache), sim_cache) {}
+  void Access(const TableAccessRecord& access) override;
 };
 
-// A block cache simulator that reports miss ratio curves given a set of cache
-// configurations.
-class BlockCacheTraceSimulator {
+// A record cache simulator that reports miss ratio curves given a set of cache
+// configurations, e.g. to size the blob cache or the TerarkZip record cache
+// and pick its policy.
+class TableAccessTraceSimulator {
  public:
   // warmup_seconds: The number of seconds to warmup simulated caches. The
   // hit/miss counters are reset after the warmup completes.
-  BlockCacheTraceSimulator(
+  // downsample_ratio: The TableAccessTraceOptions::sampling_frequency of the
+  // trace, the simulated capacities are scaled down by it.
+  TableAccessTraceSimulator(
       uint64_t warmup_seconds, uint32_t downsample_ratio,
       const std::vector<CacheConfiguration>& cache_configurations);
-  ~BlockCacheTraceSimulator() = default;
+  ~TableAccessTraceSimulator() = default;
   // No copy and move.
-  BlockCacheTraceSimulator(const BlockCacheTraceSimulator&) = delete;
-  BlockCacheTraceSimulator& operator=(const BlockCacheTraceSimulator&) = delete;
-  BlockCacheTraceSimulator(BlockCacheTraceSimulator&&) = delete;
-  BlockCacheTraceSimulator& operator=(BlockCacheTraceSimulator&&) = delete;
-
+  TableAccessTraceSimulator(const TableAccessTraceSimulator&) = delete;
+  TableAccessTraceSimulator& operator=(const TableAccessTraceSimulator&) =
+      delete;
+  TableAccessTraceSimulator(TableAccessTraceSimulator&&) = delete;
+  TableAccessTraceSimulator& operator=(TableAccessTraceSimulator&&) = delete;
+
+  // Creates one simulated cache per configured capacity. Returns
+  // InvalidArgument for an unknown cache name and NotSupported for a policy
+  // that is not available in this build (e.g. CLOCK without TBB).
   Status InitializeCaches();
 
-  void Access(const BlockCacheTraceRecord& access);
+  void Access(const TableAccessRecord& access);
+
+  // Replays the table accesses of a trace written by TableAccessTracer, the
+  // header included, until its footer or its end.
+  Status Replay(TraceReader* reader);
+
+  // Appends one "cache_name,num_shard_bits,ghost_cache_capacity,capacity,
+  // miss_ratio,total_accesses" line per simulated cache to report, i.e. the
+  // miss ratio curve of every configuration.
+  void ReportMissRatioCurves(std::string* report) const;
 
   const std::map<CacheConfiguration,
                  std::vector<std::shared_ptr<CacheSimulator>>>&
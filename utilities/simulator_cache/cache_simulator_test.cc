@@ -0,0 +1,176 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "utilities/simulator_cache/cache_simulator.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "port/stack_trace.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class CacheSimulatorTest : public testing::Test {
+ public:
+  const uint64_t kNumRecords = 10;
+  const uint64_t kRecordSize = 100;
+
+  TableAccessRecord GenerateAccess(uint64_t record, uint64_t timestamp) {
+    TableAccessRecord access;
+    access.access_timestamp = timestamp;
+    access.type = kTableAccessBlob;
+    access.caller = kTableAccessFetch;
+    access.file_number = 7;
+    access.record = record;
+    access.size = kRecordSize;
+    return access;
+  }
+
+  CacheConfiguration Config(const std::string& cache_name) {
+    CacheConfiguration config;
+    config.cache_name = cache_name;
+    config.num_shard_bits = 0;
+    // Holds a fifth, then all of the records
+    config.cache_capacities = {2 * kRecordSize, 2 * kNumRecords * kRecordSize};
+    return config;
+  }
+
+  // Reads every record three times in a loop
+  void AccessLoop(TableAccessTraceSimulator* simulator) {
+    uint64_t timestamp = 1;
+    for (int round = 0; round < 3; ++round) {
+      for (uint64_t i = 0; i < kNumRecords; ++i) {
+        simulator->Access(GenerateAccess(i, timestamp++));
+      }
+    }
+  }
+};
+
+TEST_F(CacheSimulatorTest, GhostCache) {
+  GhostCache ghost_cache(NewLRUCache(/*capacity=*/1024, /*num_shard_bits=*/0));
+  ASSERT_FALSE(ghost_cache.Admit("a"));
+  ASSERT_TRUE(ghost_cache.Admit("a"));
+  ASSERT_TRUE(ghost_cache.Admit("a"));
+  ASSERT_FALSE(ghost_cache.Admit("b"));
+}
+
+TEST_F(CacheSimulatorTest, MissRatioCurves) {
+  TableAccessTraceSimulator simulator(
+      /*warmup_seconds=*/0, /*downsample_ratio=*/1,
+      {Config("lru"), Config("lirs"), Config("ghost_lru")});
+  ASSERT_OK(simulator.InitializeCaches());
+  AccessLoop(&simulator);
+
+  const auto& sim_caches = simulator.sim_caches();
+  ASSERT_EQ(3U, sim_caches.size());
+  for (auto const& config_caches : sim_caches) {
+    const std::string& cache_name = config_caches.first.cache_name;
+    auto& caches = config_caches.second;
+    ASSERT_EQ(2U, caches.size());
+    for (auto& cache : caches) {
+      ASSERT_EQ(3 * kNumRecords, cache->total_accesses());
+    }
+    double small_miss_ratio = caches[0]->miss_ratio();
+    double large_miss_ratio = caches[1]->miss_ratio();
+    if (cache_name == "lru") {
+      // A loop over more records than fit always misses in a LRU cache
+      ASSERT_DOUBLE_EQ(100.0, small_miss_ratio);
+      // Only the first round misses
+      ASSERT_DOUBLE_EQ(100.0 / 3, large_miss_ratio);
+    } else if (cache_name == "ghost_lru") {
+      // Admitted on the second miss
+      ASSERT_DOUBLE_EQ(200.0 / 3, large_miss_ratio);
+    } else {
+      ASSERT_EQ("lirs", cache_name);
+      ASSERT_LE(large_miss_ratio, small_miss_ratio);
+    }
+  }
+
+  std::string report;
+  simulator.ReportMissRatioCurves(&report);
+  ASSERT_EQ(6, std::count(report.begin(), report.end(), '\n'));
+  ASSERT_NE(std::string::npos, report.find("lru,0,0,2000,33.33,30\n"));
+}
+
+TEST_F(CacheSimulatorTest, Warmup) {
+  TableAccessTraceSimulator simulator(/*warmup_seconds=*/1,
+                                      /*downsample_ratio=*/1, {Config("lru")});
+  ASSERT_OK(simulator.InitializeCaches());
+  // The first round is the warmup
+  for (uint64_t i = 0; i < kNumRecords; ++i) {
+    simulator.Access(GenerateAccess(i, 1));
+  }
+  for (uint64_t i = 0; i < kNumRecords; ++i) {
+    simulator.Access(GenerateAccess(i, 1 + 1000 * 1000));
+  }
+  auto& large_cache = simulator.sim_caches().begin()->second[1];
+  ASSERT_EQ(kNumRecords, large_cache->total_accesses());
+  ASSERT_DOUBLE_EQ(0, large_cache->miss_ratio());
+}
+
+TEST_F(CacheSimulatorTest, UnknownCache) {
+  TableAccessTraceSimulator simulator(/*warmup_seconds=*/0,
+                                      /*downsample_ratio=*/1,
+                                      {Config("unknown")});
+  ASSERT_TRUE(simulator.InitializeCaches().IsInvalidArgument());
+
+  TableAccessTraceSimulator clock_simulator(/*warmup_seconds=*/0,
+                                            /*downsample_ratio=*/1,
+                                            {Config("ghost_clock")});
+  Status s = clock_simulator.InitializeCaches();
+  if (s.ok()) {
+    AccessLoop(&clock_simulator);
+    auto& caches = clock_simulator.sim_caches().begin()->second;
+    ASSERT_EQ(3 * kNumRecords, caches[1]->total_accesses());
+  } else {
+    ASSERT_TRUE(s.IsNotSupported());
+  }
+}
+
+TEST_F(CacheSimulatorTest, ReplayTrace) {
+  Env* env = Env::Default();
+  EnvOptions env_options;
+  std::string trace_path =
+      test::PerThreadDBPath("cache_simulator_test_trace");
+
+  std::unique_ptr<TraceWriter> trace_writer;
+  ASSERT_OK(NewFileTraceWriter(env, env_options, trace_path, &trace_writer));
+  TableAccessTracer tracer;
+  ASSERT_OK(tracer.StartTrace(env, TableAccessTraceOptions(),
+                              std::move(trace_writer)));
+  for (int round = 0; round < 3; ++round) {
+    for (uint64_t i = 0; i < kNumRecords; ++i) {
+      tracer.Add(kTableAccessTerarkZipValue, kTableAccessIterator,
+                 /*file_number=*/7, /*record=*/i, kRecordSize,
+                 /*is_cache_hit=*/false);
+    }
+  }
+  ASSERT_OK(tracer.EndTrace());
+
+  TableAccessTraceSimulator simulator(/*warmup_seconds=*/0,
+                                      /*downsample_ratio=*/1,
+                                      {Config("lru_priority")});
+  ASSERT_OK(simulator.InitializeCaches());
+  std::unique_ptr<TraceReader> trace_reader;
+  ASSERT_OK(NewFileTraceReader(env, env_options, trace_path, &trace_reader));
+  ASSERT_OK(simulator.Replay(trace_reader.get()));
+  auto& large_cache = simulator.sim_caches().begin()->second[1];
+  ASSERT_EQ(3 * kNumRecords, large_cache->total_accesses());
+  ASSERT_DOUBLE_EQ(100.0 / 3, large_cache->miss_ratio());
+  ASSERT_OK(env->DeleteFile(trace_path));
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  TERARKDB_NAMESPACE::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
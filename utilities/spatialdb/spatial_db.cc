@@ -14,7 +14,9 @@
 #include <inttypes.h>
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <set>
 #include <string>
@@ -28,11 +30,14 @@
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/snapshot.h"
+#include "rocksdb/sst_file_writer.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/table.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/utilities/stackable_db.h"
 #include "util/coding.h"
+#include "util/string_util.h"
 #include "utilities/spatialdb/utils.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -45,10 +50,12 @@ namespace spatial {
 // (serialized)
 // We have one additional column family for each spatial index. The name of the
 // column family is [spatial$<spatial_index_name>]. The format is:
-// * quad_key (fixed 64 bit big endian) id (fixed 64 bit big endian) -> ""
+// * tile_key (fixed 64 bit big endian) id (fixed 64 bit big endian) -> ""
+// where tile_key is the quad key or the Hilbert key of the tile, see
+// SpatialIndexOptions::key_type
 // We store information about indexes in [metadata] column family. Format is:
 // * spatial$<spatial_index_name> -> bbox (4 double encodings) tile_bits
-// (varint32)
+// (varint32) key_type (varint32, absent for quad keys)
 
 namespace {
 const std::string kMetadataColumnFamilyName("metadata");
@@ -348,59 +355,102 @@ class ValueGetterFromIterator : public ValueGetter {
   Status status_;
 };
 
-class SpatialIndexCursor : public Cursor {
- public:
-  // tile_box is inclusive
-  SpatialIndexCursor(Iterator* spatial_iterator, ValueGetter* value_getter,
-                     const BoundingBox<uint64_t>& tile_bbox, uint32_t tile_bits)
-      : value_getter_(value_getter), valid_(true) {
-    // calculate quad keys we'll need to query
-    std::vector<uint64_t> quad_keys;
-    quad_keys.reserve(
-        static_cast<size_t>((tile_bbox.max_x - tile_bbox.min_x + 1) *
-                            (tile_bbox.max_y - tile_bbox.min_y + 1)));
-    for (uint64_t x = tile_bbox.min_x; x <= tile_bbox.max_x; ++x) {
-      for (uint64_t y = tile_bbox.min_y; y <= tile_bbox.max_y; ++y) {
-        quad_keys.push_back(GetQuadKeyFromTile(x, y, tile_bits));
-      }
+namespace {
+// The key ranges [first, last] of the spatial index covering the tiles of
+// tile_bbox, which is inclusive, in key order
+std::vector<std::pair<uint64_t, uint64_t>> GetTileKeyRanges(
+    const SpatialIndexOptions& spatial_index,
+    const BoundingBox<uint64_t>& tile_bbox) {
+  std::vector<uint64_t> keys;
+  keys.reserve(static_cast<size_t>((tile_bbox.max_x - tile_bbox.min_x + 1) *
+                                   (tile_bbox.max_y - tile_bbox.min_y + 1)));
+  for (uint64_t x = tile_bbox.min_x; x <= tile_bbox.max_x; ++x) {
+    for (uint64_t y = tile_bbox.min_y; y <= tile_bbox.max_y; ++y) {
+      keys.push_back(GetKeyFromTile(spatial_index, x, y));
     }
-    std::sort(quad_keys.begin(), quad_keys.end());
+  }
+  std::sort(keys.begin(), keys.end());
 
-    // load primary key ids for all quad keys
-    for (auto quad_key : quad_keys) {
-      std::string encoded_quad_key;
-      PutFixed64BigEndian(&encoded_quad_key, quad_key);
-      Slice slice_quad_key(encoded_quad_key);
+  // tiles adjacent on the curve are read by one seek
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  for (auto key : keys) {
+    if (!ranges.empty() && ranges.back().second + 1 == key) {
+      ranges.back().second = key;
+    } else {
+      ranges.emplace_back(key, key);
+    }
+  }
+  return ranges;
+}
 
-      // If CheckQuadKey is true, there is no need to reseek, since
-      // spatial_iterator is already pointing at the correct quad key. This is
-      // an optimization.
-      if (!CheckQuadKey(spatial_iterator, slice_quad_key)) {
-        spatial_iterator->Seek(slice_quad_key);
+// Runs task(0), ..., task(num_tasks - 1) with up to num_threads threads and
+// returns the first error
+Status RunTasks(size_t num_tasks, size_t num_threads,
+                const std::function<Status(size_t)>& task) {
+  std::atomic<size_t> next_task(0);
+  std::mutex mutex;
+  Status s;
+  auto run = [&] {
+    for (size_t i = next_task.fetch_add(1); i < num_tasks;
+         i = next_task.fetch_add(1)) {
+      Status t = task(i);
+      if (!t.ok()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (s.ok()) {
+          s = t;
+        }
       }
+    }
+  };
+  std::vector<port::Thread> threads;
+  for (size_t i = 1; i < std::min(num_tasks, num_threads); ++i) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (auto& t : threads) {
+    t.join();
+  }
+  return s;
+}
+}  // namespace
 
-      while (CheckQuadKey(spatial_iterator, slice_quad_key)) {
-        // extract ID from spatial_iterator
-        uint64_t id;
-        bool ok = GetFixed64BigEndian(
-            Slice(spatial_iterator->key().data() + sizeof(uint64_t),
-                  sizeof(uint64_t)),
-            &id);
-        if (!ok) {
-          valid_ = false;
-          status_ = Status::Corruption("Spatial index corruption");
-          break;
-        }
-        primary_key_ids_.insert(id);
-        spatial_iterator->Next();
+class SpatialIndexCursor : public Cursor {
+ public:
+  // Each of spatial_iterators scans some of key_ranges in its own thread,
+  // the iterators are deleted when the scan is done
+  SpatialIndexCursor(
+      const std::vector<Iterator*>& spatial_iterators,
+      ValueGetter* value_getter,
+      const std::vector<std::pair<uint64_t, uint64_t>>& key_ranges)
+      : value_getter_(value_getter), valid_(true) {
+    std::vector<std::vector<uint64_t>> ids(spatial_iterators.size());
+    std::vector<Status> statuses(spatial_iterators.size());
+    std::atomic<size_t> next_range(0);
+    auto scan = [&](size_t i) {
+      for (size_t r = next_range.fetch_add(1);
+           r < key_ranges.size() && statuses[i].ok();
+           r = next_range.fetch_add(1)) {
+        statuses[i] = ScanKeyRange(spatial_iterators[i], key_ranges[r],
+                                   &ids[i]);
       }
+    };
+    std::vector<port::Thread> threads;
+    for (size_t i = 1; i < spatial_iterators.size(); ++i) {
+      threads.emplace_back(scan, i);
+    }
+    scan(0);
+    for (auto& t : threads) {
+      t.join();
     }
 
-    if (!spatial_iterator->status().ok()) {
-      status_ = spatial_iterator->status();
-      valid_ = false;
+    for (size_t i = 0; i < spatial_iterators.size(); ++i) {
+      if (status_.ok() && !statuses[i].ok()) {
+        status_ = statuses[i];
+        valid_ = false;
+      }
+      primary_key_ids_.insert(ids[i].begin(), ids[i].end());
+      delete spatial_iterators[i];
     }
-    delete spatial_iterator;
 
     valid_ = valid_ && !primary_key_ids_.empty();
 
@@ -437,27 +487,29 @@ class SpatialIndexCursor : public Cursor {
   }
 
  private:
-  // * returns true if spatial iterator is on the current quad key and all is
-  // well
-  // * returns false if spatial iterator is not on current, or iterator is
-  // invalid or corruption
-  bool CheckQuadKey(Iterator* spatial_iterator, const Slice& quad_key) {
-    if (!spatial_iterator->Valid()) {
-      return false;
-    }
-    if (spatial_iterator->key().size() != 2 * sizeof(uint64_t)) {
-      status_ = Status::Corruption("Invalid spatial index key");
-      valid_ = false;
-      return false;
-    }
-    Slice spatial_iterator_quad_key(spatial_iterator->key().data(),
-                                    sizeof(uint64_t));
-    if (spatial_iterator_quad_key != quad_key) {
-      // caller needs to reseek
-      return false;
+  // Loads the primary key ids of the keys in key_range
+  static Status ScanKeyRange(Iterator* spatial_iterator,
+                             const std::pair<uint64_t, uint64_t>& key_range,
+                             std::vector<uint64_t>* ids) {
+    std::string encoded_key;
+    PutFixed64BigEndian(&encoded_key, key_range.first);
+    for (spatial_iterator->Seek(encoded_key); spatial_iterator->Valid();
+         spatial_iterator->Next()) {
+      Slice key = spatial_iterator->key();
+      uint64_t tile_key;
+      uint64_t id;
+      if (key.size() != 2 * sizeof(uint64_t) ||
+          !GetFixed64BigEndian(key, &tile_key) ||
+          !GetFixed64BigEndian(
+              Slice(key.data() + sizeof(uint64_t), sizeof(uint64_t)), &id)) {
+        return Status::Corruption("Invalid spatial index key");
+      }
+      if (tile_key > key_range.second) {
+        break;
+      }
+      ids->push_back(id);
     }
-    // if we come to here, we have found the quad key
-    return true;
+    return spatial_iterator->status();
   }
 
   void ExtractData() {
@@ -521,11 +573,12 @@ class SpatialDBImpl : public SpatialDB {
       DB* db, ColumnFamilyHandle* data_column_family,
       const std::vector<std::pair<SpatialIndexOptions, ColumnFamilyHandle*>>&
           spatial_indexes,
-      uint64_t next_id, bool read_only)
+      uint64_t next_id, bool read_only, int query_threads)
       : SpatialDB(db),
         data_column_family_(data_column_family),
         next_id_(next_id),
-        read_only_(read_only) {
+        read_only_(read_only),
+        query_threads_(query_threads) {
     for (const auto& index : spatial_indexes) {
       name_to_index_.insert(
           {index.first.name, IndexColumnFamily(index.first, index.second)});
@@ -567,8 +620,7 @@ class SpatialDBImpl : public SpatialDB {
         for (uint64_t y = tile_bbox.min_y; y <= tile_bbox.max_y; ++y) {
           // see above for format
           std::string key;
-          PutFixed64BigEndian(
-              &key, GetQuadKeyFromTile(x, y, spatial_index.tile_bits));
+          PutFixed64BigEndian(&key, GetKeyFromTile(spatial_index, x, y));
           PutFixed64BigEndian(&key, id);
           batch.Put(itr->second.column_family, key, Slice());
           if (batch.GetDataSize() >= kWriteOutEveryBytes) {
@@ -593,6 +645,168 @@ class SpatialDBImpl : public SpatialDB {
     return Write(write_options, &batch);
   }
 
+  virtual Status BulkLoad(const std::vector<SpatialElement>& elements,
+                          const std::vector<std::string>& spatial_indexes,
+                          int num_threads) override {
+    if (read_only_) {
+      return Status::NotSupported("BulkLoad on a read only SpatialDB");
+    }
+    if (spatial_indexes.size() == 0) {
+      return Status::InvalidArgument("Spatial indexes can't be empty");
+    }
+    std::vector<const IndexColumnFamily*> indexes;
+    for (const auto& si : spatial_indexes) {
+      auto itr = name_to_index_.find(si);
+      if (itr == name_to_index_.end()) {
+        return Status::InvalidArgument("Can't find index " + si);
+      }
+      indexes.push_back(&itr->second);
+    }
+    if (elements.empty()) {
+      return Status::OK();
+    }
+    size_t num_chunks = std::max<size_t>(
+        1, std::min(elements.size(),
+                    static_cast<size_t>(std::max(num_threads, 1))));
+    uint64_t first_id = next_id_.fetch_add(elements.size());
+
+    // files[0] are the table files of the data column family, files[j + 1]
+    // the ones of indexes[j]. Each table file holds a key range of its own,
+    // so they are ingested together into the lowest possible level
+    std::vector<std::vector<std::string>> files(
+        indexes.size() + 1, std::vector<std::string>(num_chunks));
+    auto file_name = [&](size_t cf, size_t chunk) {
+      return GetName() + "/spatial_bulk_load_" + ToString(first_id) + "_" +
+             ToString(cf) + "_" + ToString(chunk) + ".sst";
+    };
+    auto write_file = [&](ColumnFamilyHandle* cfh, size_t cf, size_t chunk,
+                          const std::function<Status(SstFileWriter*)>& put) {
+      SstFileWriter writer(EnvOptions(), GetOptions(cfh), cfh);
+      std::string path = file_name(cf, chunk);
+      Status s = writer.Open(path);
+      if (s.ok()) {
+        files[cf][chunk] = path;
+        s = put(&writer);
+      }
+      if (s.ok()) {
+        s = writer.Finish();
+      }
+      return s;
+    };
+
+    // The chunks of elements are written to the data column family and
+    // their index entries collected in parallel, then the index entries
+    // sorted by tile key are split into chunks written in parallel.
+    // An index entry is <tile key, id>.
+    std::vector<std::vector<std::vector<std::pair<uint64_t, uint64_t>>>>
+        chunk_entries(num_chunks,
+                      std::vector<std::vector<std::pair<uint64_t, uint64_t>>>(
+                          indexes.size()));
+    Status s = RunTasks(num_chunks, num_chunks, [&](size_t chunk) {
+      size_t begin = elements.size() * chunk / num_chunks;
+      size_t end = elements.size() * (chunk + 1) / num_chunks;
+      for (size_t i = begin; i < end; ++i) {
+        const auto& bbox = elements[i].bbox;
+        for (size_t j = 0; j < indexes.size(); ++j) {
+          const auto& spatial_index = indexes[j]->index;
+          if (!spatial_index.bbox.Intersects(bbox)) {
+            continue;
+          }
+          BoundingBox<uint64_t> tile_bbox =
+              GetTileBoundingBox(spatial_index, bbox);
+          for (uint64_t x = tile_bbox.min_x; x <= tile_bbox.max_x; ++x) {
+            for (uint64_t y = tile_bbox.min_y; y <= tile_bbox.max_y; ++y) {
+              chunk_entries[chunk][j].emplace_back(
+                  GetKeyFromTile(spatial_index, x, y), first_id + i);
+            }
+          }
+        }
+      }
+      return write_file(
+          data_column_family_, 0, chunk, [&](SstFileWriter* writer) {
+            std::string data_key;
+            std::string data_value;
+            Status t;
+            for (size_t i = begin; t.ok() && i < end; ++i) {
+              data_key.clear();
+              PutFixed64BigEndian(&data_key, first_id + i);
+              data_value.clear();
+              PutLengthPrefixedSlice(&data_value, elements[i].blob);
+              elements[i].feature_set.Serialize(&data_value);
+              t = writer->Put(data_key, data_value);
+            }
+            return t;
+          });
+    });
+
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> entries(
+        indexes.size());
+    if (s.ok()) {
+      s = RunTasks(indexes.size(), num_chunks, [&](size_t j) {
+        for (auto& chunk : chunk_entries) {
+          entries[j].insert(entries[j].end(), chunk[j].begin(),
+                            chunk[j].end());
+          chunk[j].clear();
+          chunk[j].shrink_to_fit();
+        }
+        std::sort(entries[j].begin(), entries[j].end());
+        return Status::OK();
+      });
+    }
+    if (s.ok()) {
+      s = RunTasks(indexes.size() * num_chunks, num_chunks, [&](size_t task) {
+        size_t j = task / num_chunks;
+        size_t chunk = task % num_chunks;
+        size_t begin = entries[j].size() * chunk / num_chunks;
+        size_t end = entries[j].size() * (chunk + 1) / num_chunks;
+        if (begin == end) {
+          return Status::OK();
+        }
+        return write_file(indexes[j]->column_family, j + 1, chunk,
+                          [&](SstFileWriter* writer) {
+                            std::string key;
+                            Status t;
+                            for (size_t i = begin; t.ok() && i < end; ++i) {
+                              key.clear();
+                              PutFixed64BigEndian(&key, entries[j][i].first);
+                              PutFixed64BigEndian(&key, entries[j][i].second);
+                              t = writer->Put(key, Slice());
+                            }
+                            return t;
+                          });
+      });
+    }
+
+    // The data is ingested before the index entries pointing to it
+    IngestExternalFileOptions ingest_options;
+    ingest_options.move_files = true;
+    for (size_t cf = 0; s.ok() && cf < files.size(); ++cf) {
+      std::vector<std::string> cf_files;
+      for (auto& path : files[cf]) {
+        if (!path.empty()) {
+          cf_files.push_back(path);
+        }
+      }
+      if (!cf_files.empty()) {
+        s = IngestExternalFile(
+            cf == 0 ? data_column_family_ : indexes[cf - 1]->column_family,
+            cf_files, ingest_options);
+      }
+      if (s.ok()) {
+        // moved into the db
+        files[cf].clear();
+      }
+    }
+    for (auto& cf_files : files) {
+      for (auto& path : cf_files) {
+        if (!path.empty()) {
+          GetEnv()->DeleteFile(path);
+        }
+      }
+    }
+    return s;
+  }
+
   virtual Status Compact(int num_threads) override {
     std::vector<ColumnFamilyHandle*> column_families;
     column_families.push_back(data_column_family_);
@@ -648,26 +862,43 @@ class SpatialDBImpl : public SpatialDB {
           "Spatial index " + spatial_index + " not found"));
     }
     const auto& si = itr->second.index;
-    Iterator* spatial_iterator;
+    auto key_ranges = GetTileKeyRanges(si, GetTileBoundingBox(si, bbox));
+    size_t num_iterators = std::max<size_t>(
+        1, std::min<size_t>(key_ranges.size(),
+                            static_cast<size_t>(std::max(query_threads_, 1))));
+    std::vector<Iterator*> spatial_iterators;
     ValueGetter* value_getter;
 
     if (read_only_) {
-      spatial_iterator = NewIterator(read_options, itr->second.column_family);
+      for (size_t i = 0; i < num_iterators; ++i) {
+        spatial_iterators.push_back(
+            NewIterator(read_options, itr->second.column_family));
+      }
       value_getter = new ValueGetterFromDB(this, data_column_family_);
     } else {
+      // all the iterators read the same snapshot
+      ReadOptions snapshot_options = read_options;
+      std::unique_ptr<ManagedSnapshot> snapshot;
+      if (num_iterators > 1 && read_options.snapshot == nullptr) {
+        snapshot.reset(new ManagedSnapshot(this));
+        snapshot_options.snapshot = snapshot->snapshot();
+      }
       std::vector<Iterator*> iterators;
-      Status s = NewIterators(read_options,
+      Status s = NewIterators(snapshot_options,
                               {data_column_family_, itr->second.column_family},
                               &iterators);
       if (!s.ok()) {
         return new ErrorCursor(s);
       }
 
-      spatial_iterator = iterators[1];
+      spatial_iterators.push_back(iterators[1]);
       value_getter = new ValueGetterFromIterator(iterators[0]);
+      for (size_t i = 1; i < num_iterators; ++i) {
+        spatial_iterators.push_back(
+            NewIterator(snapshot_options, itr->second.column_family));
+      }
     }
-    return new SpatialIndexCursor(spatial_iterator, value_getter,
-                                  GetTileBoundingBox(si, bbox), si.tile_bits);
+    return new SpatialIndexCursor(spatial_iterators, value_getter, key_ranges);
   }
 
  private:
@@ -684,6 +915,7 @@ class SpatialDBImpl : public SpatialDB {
 
   std::atomic<uint64_t> next_id_;
   bool read_only_;
+  int query_threads_;
 };
 
 namespace {
@@ -755,7 +987,7 @@ class MetadataStorage {
   ~MetadataStorage() {}
 
   // format: <min_x double> <min_y double> <max_x double> <max_y double>
-  // <tile_bits varint32>
+  // <tile_bits varint32> [<key_type varint32>]
   Status AddIndex(const SpatialIndexOptions& index) {
     std::string encoded_index;
     PutDouble(&encoded_index, index.bbox.min_x);
@@ -763,6 +995,10 @@ class MetadataStorage {
     PutDouble(&encoded_index, index.bbox.max_x);
     PutDouble(&encoded_index, index.bbox.max_y);
     PutVarint32(&encoded_index, index.tile_bits);
+    // indexes of quad keys stay readable by older versions
+    if (index.key_type != SpatialIndexOptions::kQuadKey) {
+      PutVarint32(&encoded_index, index.key_type);
+    }
     return db_->Put(WriteOptions(), cf_,
                     GetSpatialIndexColumnFamilyName(index.name), encoded_index);
   }
@@ -781,6 +1017,13 @@ class MetadataStorage {
     ok = ok && GetDouble(&encoded_index, &(dst->bbox.max_x));
     ok = ok && GetDouble(&encoded_index, &(dst->bbox.max_y));
     ok = ok && GetVarint32(&encoded_index, &(dst->tile_bits));
+    dst->key_type = SpatialIndexOptions::kQuadKey;
+    if (ok && !encoded_index.empty()) {
+      uint32_t key_type = 0;
+      ok = GetVarint32(&encoded_index, &key_type) &&
+           key_type <= SpatialIndexOptions::kHilbertKey;
+      dst->key_type = static_cast<SpatialIndexOptions::KeyType>(key_type);
+    }
     return ok ? Status::OK() : Status::Corruption("Index encoding corrupted");
   }
 
@@ -916,7 +1159,8 @@ Status SpatialDB::Open(const SpatialDBOptions& options, const std::string& name,
 
   // I don't need metadata column family any more, so delete it
   delete handles[1];
-  *db = new SpatialDBImpl(base_db, handles[0], index_cf, next_id, read_only);
+  *db = new SpatialDBImpl(base_db, handles[0], index_cf, next_id, read_only,
+                          options.query_threads);
   return Status::OK();
 }
 
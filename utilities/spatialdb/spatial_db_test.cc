@@ -16,6 +16,7 @@
 #include "util/random.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
+#include "utilities/spatialdb/utils.h"
 
 namespace TERARKDB_NAMESPACE {
 namespace spatial {
@@ -290,6 +291,89 @@ TEST_F(SpatialDBTest, RandomizedTest) {
   delete db_;
 }
 
+TEST_F(SpatialDBTest, HilbertKeyTest) {
+  const uint32_t tile_bits = 3;
+  const uint64_t tiles = 1 << tile_bits;
+  std::vector<std::pair<uint64_t, uint64_t>> curve(tiles * tiles,
+                                                   {tiles, tiles});
+  for (uint64_t x = 0; x < tiles; ++x) {
+    for (uint64_t y = 0; y < tiles; ++y) {
+      uint64_t key = GetHilbertKeyFromTile(x, y, tile_bits);
+      ASSERT_LT(key, curve.size());
+      ASSERT_EQ(curve[key].first, tiles);
+      curve[key] = {x, y};
+    }
+  }
+  // consecutive keys are neighbouring tiles
+  for (size_t i = 1; i < curve.size(); ++i) {
+    uint64_t dx = curve[i].first > curve[i - 1].first
+                      ? curve[i].first - curve[i - 1].first
+                      : curve[i - 1].first - curve[i].first;
+    uint64_t dy = curve[i].second > curve[i - 1].second
+                      ? curve[i].second - curve[i - 1].second
+                      : curve[i - 1].second - curve[i].second;
+    ASSERT_EQ(dx + dy, 1U);
+  }
+}
+
+TEST_F(SpatialDBTest, BulkLoadTest) {
+  if (!LZ4_Supported()) {
+    return;
+  }
+  Random rnd(301);
+  std::vector<std::pair<std::string, BoundingBox<int>>> elements;
+
+  BoundingBox<double> spatial_index_bounds(0, 0, (1LL << 32), (1LL << 32));
+  ASSERT_OK(SpatialDB::Create(
+      SpatialDBOptions(), dbname_,
+      {SpatialIndexOptions("quad", spatial_index_bounds, 7),
+       SpatialIndexOptions("hilbert", spatial_index_bounds, 7,
+                           SpatialIndexOptions::kHilbertKey)}));
+  SpatialDBOptions options;
+  options.query_threads = 4;
+  ASSERT_OK(SpatialDB::Open(options, dbname_, &db_));
+  double step = (1LL << 32) / (1 << 7);
+
+  for (int i = 0; i < 100; ++i) {
+    std::string blob = RandomStr(&rnd);
+    BoundingBox<int> bbox = RandomBoundingBox(128, &rnd, 10);
+    ASSERT_OK(db_->Insert(WriteOptions(), ScaleBB(bbox, step), blob,
+                          FeatureSet(), {"quad", "hilbert"}));
+    elements.push_back(make_pair(blob, bbox));
+  }
+  std::vector<SpatialElement> bulk;
+  for (int i = 0; i < 1000; ++i) {
+    std::string blob = RandomStr(&rnd);
+    BoundingBox<int> bbox = RandomBoundingBox(128, &rnd, 10);
+    bulk.emplace_back(ScaleBB(bbox, step), blob, FeatureSet());
+    elements.push_back(make_pair(blob, bbox));
+  }
+  ASSERT_OK(db_->BulkLoad(bulk, {"quad", "hilbert"}, 4));
+  ASSERT_TRUE(db_->BulkLoad(bulk, {"none"}, 4).IsInvalidArgument());
+
+  // the key type of the index is persisted
+  delete db_;
+  ASSERT_OK(SpatialDB::Open(options, dbname_, &db_));
+  ASSERT_OK(db_->Insert(WriteOptions(), ScaleBB(elements[0].second, step),
+                        "last", FeatureSet(), {"quad", "hilbert"}));
+  elements.push_back(std::make_pair(std::string("last"), elements[0].second));
+
+  for (int i = 0; i < 200; ++i) {
+    BoundingBox<int> int_bbox = RandomBoundingBox(128, &rnd, 30);
+    BoundingBox<double> double_bbox = ScaleBB(int_bbox, step);
+    std::vector<std::string> blobs;
+    for (auto e : elements) {
+      if (e.second.Intersects(int_bbox)) {
+        blobs.push_back(e.first);
+      }
+    }
+    AssertCursorResults(double_bbox, "quad", blobs);
+    AssertCursorResults(double_bbox, "hilbert", blobs);
+  }
+
+  delete db_;
+}
+
 }  // namespace spatial
 }  // namespace TERARKDB_NAMESPACE
 
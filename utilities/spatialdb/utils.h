@@ -35,6 +35,35 @@ inline uint64_t GetQuadKeyFromTile(uint64_t tile_x, uint64_t tile_y,
   return quad_key;
 }
 
+// d of the tile on the Hilbert curve filling the (1 << tile_bits)^2 tiles
+inline uint64_t GetHilbertKeyFromTile(uint64_t tile_x, uint64_t tile_y,
+                                      uint32_t tile_bits) {
+  uint64_t n = 1ull << tile_bits;
+  uint64_t hilbert_key = 0;
+  for (uint64_t s = n >> 1; s > 0; s >>= 1) {
+    uint64_t rx = (tile_x & s) ? 1 : 0;
+    uint64_t ry = (tile_y & s) ? 1 : 0;
+    hilbert_key += s * s * ((3 * rx) ^ ry);
+    // rotate the quadrant
+    if (ry == 0) {
+      if (rx == 1) {
+        tile_x = n - 1 - tile_x;
+        tile_y = n - 1 - tile_y;
+      }
+      std::swap(tile_x, tile_y);
+    }
+  }
+  return hilbert_key;
+}
+
+inline uint64_t GetKeyFromTile(const SpatialIndexOptions& spatial_index,
+                               uint64_t tile_x, uint64_t tile_y) {
+  if (spatial_index.key_type == SpatialIndexOptions::kHilbertKey) {
+    return GetHilbertKeyFromTile(tile_x, tile_y, spatial_index.tile_bits);
+  }
+  return GetQuadKeyFromTile(tile_x, tile_y, spatial_index.tile_bits);
+}
+
 inline BoundingBox<uint64_t> GetTileBoundingBox(
     const SpatialIndexOptions& spatial_index, BoundingBox<double> bbox) {
   return BoundingBox<uint64_t>(
@@ -118,6 +118,40 @@ TEST_F(OptimisticTransactionTest, WriteConflictTest) {
   delete txn;
 }
 
+TEST_F(OptimisticTransactionTest, ManyKeysConflictTest) {
+  WriteOptions write_options;
+  ReadOptions read_options;
+
+  for (int i = 0; i < 200; i += 2) {
+    ASSERT_OK(txn_db->Put(write_options, "key" + std::to_string(i), "v"));
+  }
+
+  // Keys written before the transaction started do not conflict
+  Transaction* txn = txn_db->BeginTransaction(write_options);
+  ASSERT_TRUE(txn);
+  for (int i = 0; i < 200; i++) {
+    ASSERT_OK(txn->Put("key" + std::to_string(i), "txn"));
+  }
+  ASSERT_OK(txn_db->Put(write_options, "other", "v"));
+  ASSERT_OK(txn->Commit());
+  delete txn;
+
+  // A single conflicting key among many fails the commit
+  txn = txn_db->BeginTransaction(write_options);
+  ASSERT_TRUE(txn);
+  for (int i = 0; i < 200; i++) {
+    ASSERT_OK(txn->Put("key" + std::to_string(i), "txn2"));
+  }
+  ASSERT_OK(txn_db->Delete(write_options, "key123"));
+  ASSERT_TRUE(txn->Commit().IsBusy());
+  delete txn;
+
+  std::string value;
+  ASSERT_OK(txn_db->Get(read_options, "key122", &value));
+  ASSERT_EQ("txn", value);
+  ASSERT_TRUE(txn_db->Get(read_options, "key123", &value).IsNotFound());
+}
+
 TEST_F(OptimisticTransactionTest, WriteConflictTest2) {
   WriteOptions write_options;
   ReadOptions read_options;
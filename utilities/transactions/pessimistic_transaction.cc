@@ -482,19 +482,20 @@ Status PessimisticTransaction::LockBatch(WriteBatch* batch,
 
   Status s;
 
-  // Attempt to lock all keys
+  // Attempt to lock all keys, a column family at a time
+  std::vector<const std::string*> cfh_keys;
   for (const auto& cf_iter : handler.keys_) {
     uint32_t cfh_id = cf_iter.first;
-    auto& cfh_keys = cf_iter.second;
-
-    for (const auto& key_iter : cfh_keys) {
-      const std::string& key = key_iter;
+    cfh_keys.clear();
+    for (const auto& key : cf_iter.second) {
+      cfh_keys.push_back(&key);
+    }
 
-      s = txn_db_impl_->TryLock(this, cfh_id, key, true /* exclusive */);
-      if (!s.ok()) {
-        break;
-      }
-      TrackKey(keys_to_unlock, cfh_id, std::move(key), kMaxSequenceNumber,
+    size_t num_locked = 0;
+    s = txn_db_impl_->TryLock(this, cfh_id, cfh_keys, true /* exclusive */,
+                              &num_locked);
+    for (size_t i = 0; i < num_locked; ++i) {
+      TrackKey(keys_to_unlock, cfh_id, *cfh_keys[i], kMaxSequenceNumber,
                false, true /* exclusive */);
     }
 
@@ -13,6 +13,7 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -42,7 +43,8 @@ PessimisticTransactionDB::PessimisticTransactionDB(
                 txn_db_options_.custom_mutex_factory
                     ? txn_db_options_.custom_mutex_factory
                     : std::shared_ptr<TransactionDBMutexFactory>(
-                          new TransactionDBMutexFactoryImpl())) {
+                          new TransactionDBMutexFactoryImpl()),
+                txn_db_options_.deadlock_detect_interval_ms) {
   assert(db_impl_ != nullptr);
   info_log_ = db_impl_->GetDBOptions().info_log;
 }
@@ -73,7 +75,8 @@ PessimisticTransactionDB::PessimisticTransactionDB(
                 txn_db_options_.custom_mutex_factory
                     ? txn_db_options_.custom_mutex_factory
                     : std::shared_ptr<TransactionDBMutexFactory>(
-                          new TransactionDBMutexFactoryImpl())) {
+                          new TransactionDBMutexFactoryImpl()),
+                txn_db_options_.deadlock_detect_interval_ms) {
   assert(db_impl_ != nullptr);
 }
 
@@ -191,6 +194,8 @@ TransactionDBOptions PessimisticTransactionDB::ValidateTxnDBOptions(
   if (txn_db_options.num_stripes == 0) {
     validated.num_stripes = 1;
   }
+  validated.write_prepared_commit_cache_bits = std::min<size_t>(
+      txn_db_options.write_prepared_commit_cache_bits, 30);
 
   return validated;
 }
@@ -387,6 +392,14 @@ Status PessimisticTransactionDB::TryLock(PessimisticTransaction* txn,
   return lock_mgr_.TryLock(txn, cfh_id, key, GetEnv(), exclusive);
 }
 
+Status PessimisticTransactionDB::TryLock(
+    PessimisticTransaction* txn, uint32_t cfh_id,
+    const std::vector<const std::string*>& keys, bool exclusive,
+    size_t* num_locked) {
+  return lock_mgr_.TryLock(txn, cfh_id, keys, GetEnv(), exclusive,
+                           num_locked);
+}
+
 void PessimisticTransactionDB::UnLock(PessimisticTransaction* txn,
                                       const TransactionKeyMap* keys) {
   lock_mgr_.UnLock(txn, keys, GetEnv());
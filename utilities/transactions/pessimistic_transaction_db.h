@@ -79,6 +79,9 @@ class PessimisticTransactionDB : public TransactionDB {
 
   Status TryLock(PessimisticTransaction* txn, uint32_t cfh_id,
                  const std::string& key, bool exclusive);
+  Status TryLock(PessimisticTransaction* txn, uint32_t cfh_id,
+                 const std::vector<const std::string*>& keys, bool exclusive,
+                 size_t* num_locked);
 
   void UnLock(PessimisticTransaction* txn, const TransactionKeyMap* keys);
   void UnLock(PessimisticTransaction* txn, uint32_t cfh_id,
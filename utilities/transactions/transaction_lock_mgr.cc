@@ -18,14 +18,17 @@
 #include <functional>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "monitoring/perf_context_imp.h"
+#include "port/port.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/utilities/transaction_db_mutex.h"
 #include "util/cast_util.h"
 #include "util/murmurhash.h"
+#include "util/string_util.h"
 #include "util/sync_point.h"
 #include "util/thread_local.h"
 #include "utilities/transactions/pessimistic_transaction_db.h"
@@ -66,13 +69,93 @@ struct LockMapStripe {
   // Locked keys mapped to the info about the transactions that locked them.
   // TODO(agiardullo): Explore performance of other data structures.
   std::unordered_map<std::string, LockInfo> keys;
+
+  // The number of keys plus the number of threads locking a key through
+  // stripe_mutex. The fast path only claims keys of a stripe without any, so
+  // a key is either in keys or in a FastLockSlot and waiters are not starved
+  // by the fast path.
+  std::atomic<int64_t> slow_users{0};
+};
+
+// An exclusive lock of a transaction without an expiration time, taken and
+// released with atomics only. A key has a single slot, a key whose slot is
+// taken by another key goes through the stripe.
+struct FastLockSlot {
+  // While kBusy is set the slot is being read or written by one thread, the
+  // other bits are the id of the owner, 0 when the slot is free
+  static const uint64_t kBusy = uint64_t(1) << 63;
+
+  std::atomic<uint64_t> state{0};
+  // Only accessed by the thread that set kBusy, the capacity is reused
+  std::string key;
+
+  // Spins while another thread has the slot busy, returns the owner
+  TransactionID Acquire() {
+    uint64_t owner = state.load(std::memory_order_relaxed);
+    while (true) {
+      if (owner & kBusy) {
+        port::AsmVolatilePause();
+        owner = state.load(std::memory_order_relaxed);
+      } else if (state.compare_exchange_weak(owner, owner | kBusy)) {
+        return owner;
+      }
+    }
+  }
+
+  void Release(TransactionID owner) { state.store(owner); }
+};
+
+// A transaction waiting in AcquireWithTimeout() for the background deadlock
+// detector. Lives on the stack of the waiter.
+struct WaitNode {
+  WaitNode(TransactionID id, uint32_t cf, const std::string* k, bool ex)
+      : txn_id(id), cf_id(cf), key(k), exclusive(ex) {}
+
+  const TransactionID txn_id;
+  const uint32_t cf_id;
+  const std::string* const key;
+  const bool exclusive;
+  // Only accessed with the slot busy
+  autovector<TransactionID> wait_ids;
+  uint64_t version = 0;
+  // Only accessed by the waiter
+  WaitSlot* slot = nullptr;
+  // Set by the detector when the waiter is picked as a deadlock victim
+  std::atomic<bool> deadlocked{false};
+};
+
+struct WaitSlot {
+  // While kBusy is set the slot is being read or written by one thread, the
+  // other bits are the published WaitNode, 0 when the slot is free
+  static const uintptr_t kBusy = 1;
+
+  std::atomic<uintptr_t> state{0};
+
+  // Spins while another thread has the slot busy, returns the node
+  WaitNode* Acquire() {
+    uintptr_t node = state.load(std::memory_order_relaxed);
+    while (true) {
+      if (node & kBusy) {
+        port::AsmVolatilePause();
+        node = state.load(std::memory_order_relaxed);
+      } else if (state.compare_exchange_weak(node, node | kBusy)) {
+        return reinterpret_cast<WaitNode*>(node);
+      }
+    }
+  }
+
+  void Release(WaitNode* node) {
+    state.store(reinterpret_cast<uintptr_t>(node));
+  }
 };
 
+static const size_t kNumWaitSlots = 1024;
+
 // Map of #num_stripes LockMapStripes
 struct LockMap {
   explicit LockMap(size_t num_stripes,
                    std::shared_ptr<TransactionDBMutexFactory> factory)
-      : num_stripes_(num_stripes) {
+      : num_stripes_(num_stripes), fast_lock_slots_(kNumFastLockSlots) {
     lock_map_stripes_.reserve(num_stripes);
     for (size_t i = 0; i < num_stripes; i++) {
       LockMapStripe* stripe = new LockMapStripe(factory);
@@ -95,9 +178,80 @@ struct LockMap {
 
   std::vector<LockMapStripe*> lock_map_stripes_;
 
-  size_t GetStripe(const std::string& key) const;
+  static const size_t kNumFastLockSlots = 4096;
+  std::vector<FastLockSlot> fast_lock_slots_;
+
+  static size_t Hash(const std::string& key) {
+    static murmur_hash hash;
+    return hash(key);
+  }
+
+  size_t GetStripe(size_t hash) const {
+    assert(num_stripes_ > 0);
+    return hash % num_stripes_;
+  }
+
+  FastLockSlot* GetFastLockSlot(size_t hash) {
+    return &fast_lock_slots_[hash / num_stripes_ % kNumFastLockSlots];
+  }
+
+  // Claims the slot for txn_id when neither the slot nor the stripe is in use
+  bool TryFastLock(FastLockSlot* slot, LockMapStripe* stripe,
+                   TransactionID txn_id, const std::string& key);
+
+  // Frees the slot if txn_id holds key in it
+  bool TryFastUnLock(FastLockSlot* slot, TransactionID txn_id,
+                     const std::string& key);
 };
 
+namespace {
+// Wakes the waiters of a stripe after a lock they may wait on is released.
+// Taking the mutex orders the notification after the check of a waiter that
+// has not started waiting yet.
+void NotifyStripe(LockMapStripe* stripe) {
+  stripe->stripe_mutex->Lock();
+  stripe->stripe_mutex->UnLock();
+  stripe->stripe_cv->NotifyAll();
+}
+}  // anonymous namespace
+
+bool LockMap::TryFastLock(FastLockSlot* slot, LockMapStripe* stripe,
+                          TransactionID txn_id, const std::string& key) {
+  if (stripe->slow_users.load(std::memory_order_acquire) != 0) {
+    return false;
+  }
+  uint64_t free_state = 0;
+  if (!slot->state.compare_exchange_strong(free_state, FastLockSlot::kBusy)) {
+    return false;
+  }
+  slot->key.assign(key);
+  slot->Release(txn_id);
+  // A thread that started locking through the stripe meanwhile either sees
+  // the slot taken, or is seen here and the slot is given up to it
+  if (stripe->slow_users.load() != 0) {
+    slot->Acquire();
+    slot->Release(0);
+    NotifyStripe(stripe);
+    return false;
+  }
+  return true;
+}
+
+bool LockMap::TryFastUnLock(FastLockSlot* slot, TransactionID txn_id,
+                            const std::string& key) {
+  if ((slot->state.load(std::memory_order_relaxed) & ~FastLockSlot::kBusy) !=
+      txn_id) {
+    return false;
+  }
+  TransactionID owner = slot->Acquire();
+  if (owner != txn_id || slot->key != key) {
+    slot->Release(owner);
+    return false;
+  }
+  slot->Release(0);
+  return true;
+}
+
 void DeadlockInfoBuffer::AddNewPath(DeadlockPath path) {
   std::lock_guard<std::mutex> lock(paths_buffer_mutex_);
 
@@ -168,25 +322,35 @@ void UnrefLockMapsCache(void* ptr) {
 TransactionLockMgr::TransactionLockMgr(
     TransactionDB* txn_db, size_t default_num_stripes, int64_t max_num_locks,
     uint32_t max_num_deadlocks,
-    std::shared_ptr<TransactionDBMutexFactory> mutex_factory)
+    std::shared_ptr<TransactionDBMutexFactory> mutex_factory,
+    uint64_t deadlock_detect_interval_ms)
     : txn_db_impl_(nullptr),
       default_num_stripes_(default_num_stripes),
       max_num_locks_(max_num_locks),
       lock_maps_cache_(new ThreadLocalPtr(&UnrefLockMapsCache)),
       dlock_buffer_(max_num_deadlocks),
-      mutex_factory_(mutex_factory) {
+      mutex_factory_(mutex_factory),
+      deadlock_detect_interval_us_(deadlock_detect_interval_ms * 1000),
+      next_wait_version_(0) {
   assert(txn_db);
   txn_db_impl_ =
       static_cast_with_check<PessimisticTransactionDB, TransactionDB>(txn_db);
+  if (deadlock_detect_interval_us_ > 0) {
+    wait_slots_.reset(new WaitSlot[kNumWaitSlots]);
+    Env* env = txn_db->GetEnv();
+    deadlock_timer_ = Timer::Shared(env);
+    static std::atomic<uint64_t> next_task_id(0);
+    deadlock_task_name_ = "txn_deadlock:" + ToString(next_task_id++);
+    deadlock_timer_->Add([this, env]() { DetectDeadlocks(env); },
+                         deadlock_task_name_, deadlock_detect_interval_us_,
+                         deadlock_detect_interval_us_);
+  }
 }
 
-TransactionLockMgr::~TransactionLockMgr() {}
-
-size_t LockMap::GetStripe(const std::string& key) const {
-  assert(num_stripes_ > 0);
-  static murmur_hash hash;
-  size_t stripe = hash(key) % num_stripes_;
-  return stripe;
+TransactionLockMgr::~TransactionLockMgr() {
+  if (deadlock_timer_ != nullptr) {
+    deadlock_timer_->Cancel(deadlock_task_name_);
+  }
 }
 
 void TransactionLockMgr::AddColumnFamily(uint32_t column_family_id) {
@@ -303,24 +467,70 @@ Status TransactionLockMgr::TryLock(PessimisticTransaction* txn,
 
     return Status::InvalidArgument(msg);
   }
+  return TryLockKey(txn, lock_map, column_family_id, key, env, exclusive);
+}
+
+Status TransactionLockMgr::TryLock(PessimisticTransaction* txn,
+                                   uint32_t column_family_id,
+                                   const std::vector<const std::string*>& keys,
+                                   Env* env, bool exclusive,
+                                   size_t* num_locked) {
+  *num_locked = 0;
+  std::shared_ptr<LockMap> lock_map_ptr = GetLockMap(column_family_id);
+  LockMap* lock_map = lock_map_ptr.get();
+  if (lock_map == nullptr) {
+    char msg[255];
+    snprintf(msg, sizeof(msg), "Column family id not found: %" PRIu32,
+             column_family_id);
+
+    return Status::InvalidArgument(msg);
+  }
+  Status s;
+  for (const std::string* key : keys) {
+    s = TryLockKey(txn, lock_map, column_family_id, *key, env, exclusive);
+    if (!s.ok()) {
+      break;
+    }
+    ++*num_locked;
+  }
+  return s;
+}
 
+Status TransactionLockMgr::TryLockKey(PessimisticTransaction* txn,
+                                      LockMap* lock_map,
+                                      uint32_t column_family_id,
+                                      const std::string& key, Env* env,
+                                      bool exclusive) {
   // Need to lock the mutex for the stripe that this key hashes to
-  size_t stripe_num = lock_map->GetStripe(key);
+  size_t hash = LockMap::Hash(key);
+  size_t stripe_num = lock_map->GetStripe(hash);
   assert(lock_map->lock_map_stripes_.size() > stripe_num);
   LockMapStripe* stripe = lock_map->lock_map_stripes_.at(stripe_num);
+  FastLockSlot* slot = lock_map->GetFastLockSlot(hash);
+
+  // Shared and expiring locks need the LockInfo of the stripe
+  if (exclusive && txn->GetExpirationTime() == 0 &&
+      (max_num_locks_ <= 0 ||
+       lock_map->lock_cnt.load(std::memory_order_acquire) < max_num_locks_) &&
+      lock_map->TryFastLock(slot, stripe, txn->GetID(), key)) {
+    if (max_num_locks_ > 0) {
+      lock_map->lock_cnt++;
+    }
+    return Status::OK();
+  }
 
   LockInfo lock_info(txn->GetID(), txn->GetExpirationTime(), exclusive);
   int64_t timeout = txn->GetLockTimeout();
 
-  return AcquireWithTimeout(txn, lock_map, stripe, column_family_id, key, env,
-                            timeout, lock_info);
+  return AcquireWithTimeout(txn, lock_map, stripe, slot, column_family_id, key,
+                            env, timeout, lock_info);
 }
 
 // Helper function for TryLock().
 Status TransactionLockMgr::AcquireWithTimeout(
     PessimisticTransaction* txn, LockMap* lock_map, LockMapStripe* stripe,
-    uint32_t column_family_id, const std::string& key, Env* env,
-    int64_t timeout, const LockInfo& lock_info) {
+    FastLockSlot* slot, uint32_t column_family_id, const std::string& key,
+    Env* env, int64_t timeout, const LockInfo& lock_info) {
   Status result;
   uint64_t end_time = 0;
 
@@ -340,11 +550,13 @@ Status TransactionLockMgr::AcquireWithTimeout(
     // failed to acquire mutex
     return result;
   }
+  // Keeps the fast path off this stripe until we are done
+  stripe->slow_users.fetch_add(1);
 
   // Acquire lock if we are able to
   uint64_t expire_time_hint = 0;
   autovector<TransactionID> wait_ids;
-  result = AcquireLocked(lock_map, stripe, key, env, lock_info,
+  result = AcquireLocked(lock_map, stripe, slot, key, env, lock_info,
                          &expire_time_hint, &wait_ids);
 
   if (!result.ok() && timeout != 0) {
@@ -353,9 +565,12 @@ Status TransactionLockMgr::AcquireWithTimeout(
     // If we weren't able to acquire the lock, we will keep retrying as long
     // as the timeout allows.
     bool timed_out = false;
+    WaitNode wait_node(txn->GetID(), column_family_id, &key,
+                       lock_info.exclusive);
     do {
       // Decide how long to wait
       int64_t cv_end_time = -1;
+      bool detect_async = false;
 
       // Check if held lock's expiration time is sooner than our timeout
       if (expire_time_hint > 0 &&
@@ -372,16 +587,40 @@ Status TransactionLockMgr::AcquireWithTimeout(
       // detection.
       if (wait_ids.size() != 0) {
         if (txn->IsDeadlockDetect()) {
-          if (IncrementWaiters(txn, wait_ids, key, column_family_id,
+          if (deadlock_timer_ != nullptr) {
+            if (wait_node.deadlocked.load(std::memory_order_acquire)) {
+              stripe->slow_users.fetch_sub(1);
+              stripe->stripe_mutex->UnLock();
+              UnpublishWaiter(&wait_node);
+              return Status::Busy(Status::SubCode::kDeadlock);
+            }
+            detect_async = PublishWaiter(&wait_node, wait_ids);
+          }
+          if (!detect_async &&
+              IncrementWaiters(txn, wait_ids, key, column_family_id,
                                lock_info.exclusive, env)) {
             result = Status::Busy(Status::SubCode::kDeadlock);
+            stripe->slow_users.fetch_sub(1);
             stripe->stripe_mutex->UnLock();
+            UnpublishWaiter(&wait_node);
             return result;
           }
         }
         txn->SetWaitingTxn(wait_ids, column_family_id, &key);
       }
 
+      // Nobody notifies a victim of the detector, wake up every interval to
+      // check
+      bool polled = false;
+      if (detect_async) {
+        int64_t poll_time = static_cast<int64_t>(env->NowMicros() +
+                                                 deadlock_detect_interval_us_);
+        if (cv_end_time < 0 || poll_time < cv_end_time) {
+          cv_end_time = poll_time;
+          polled = true;
+        }
+      }
+
       TEST_SYNC_POINT("TransactionLockMgr::AcquireWithTimeout:WaitingTxn");
       if (cv_end_time < 0) {
         // Wait indefinitely
@@ -396,12 +635,14 @@ Status TransactionLockMgr::AcquireWithTimeout(
 
       if (wait_ids.size() != 0) {
         txn->ClearWaitingTxn();
-        if (txn->IsDeadlockDetect()) {
+        if (txn->IsDeadlockDetect() && !detect_async) {
           DecrementWaiters(txn, wait_ids);
         }
       }
 
-      if (result.IsTimedOut()) {
+      if (result.IsTimedOut() && polled) {
+        result = Status::OK();
+      } else if (result.IsTimedOut()) {
         timed_out = true;
         // Even though we timed out, we will still make one more attempt to
         // acquire lock below (it is possible the lock expired and we
@@ -409,17 +650,169 @@ Status TransactionLockMgr::AcquireWithTimeout(
       }
 
       if (result.ok() || result.IsTimedOut()) {
-        result = AcquireLocked(lock_map, stripe, key, env, lock_info,
+        result = AcquireLocked(lock_map, stripe, slot, key, env, lock_info,
                                &expire_time_hint, &wait_ids);
       }
     } while (!result.ok() && !timed_out);
+    UnpublishWaiter(&wait_node);
   }
 
+  stripe->slow_users.fetch_sub(1);
   stripe->stripe_mutex->UnLock();
 
   return result;
 }
 
+bool TransactionLockMgr::PublishWaiter(
+    WaitNode* node, const autovector<TransactionID>& wait_ids) {
+  if (node->slot == nullptr) {
+    size_t start = static_cast<size_t>(node->txn_id % kNumWaitSlots);
+    for (size_t i = 0; i < kNumWaitSlots; i++) {
+      WaitSlot* slot = &wait_slots_[(start + i) % kNumWaitSlots];
+      uintptr_t free_state = 0;
+      if (slot->state.load(std::memory_order_relaxed) == 0 &&
+          slot->state.compare_exchange_strong(free_state, WaitSlot::kBusy)) {
+        node->slot = slot;
+        break;
+      }
+    }
+    if (node->slot == nullptr) {
+      return false;
+    }
+  } else {
+    node->slot->Acquire();
+  }
+  node->wait_ids = wait_ids;
+  node->version = next_wait_version_.fetch_add(1) + 1;
+  node->slot->Release(node);
+  return true;
+}
+
+void TransactionLockMgr::UnpublishWaiter(WaitNode* node) {
+  if (node->slot != nullptr) {
+    node->slot->Acquire();
+    node->slot->Release(nullptr);
+    node->slot = nullptr;
+  }
+}
+
+void TransactionLockMgr::DetectDeadlocks(Env* env) {
+  struct Waiter {
+    size_t slot;
+    WaitNode* node;
+    uint64_t version;
+    DeadlockInfo info;
+    autovector<TransactionID> wait_ids;
+    bool removed;
+  };
+  // Copy the published edges, a slot is held busy only for its own copy
+  std::vector<Waiter> waiters;
+  for (size_t i = 0; i < kNumWaitSlots; i++) {
+    WaitSlot& slot = wait_slots_[i];
+    if ((slot.state.load(std::memory_order_relaxed) & ~WaitSlot::kBusy) == 0) {
+      continue;
+    }
+    WaitNode* node = slot.Acquire();
+    if (node != nullptr) {
+      waiters.push_back({i,
+                         node,
+                         node->version,
+                         {node->txn_id, node->cf_id, node->exclusive,
+                          *node->key},
+                         node->wait_ids,
+                         false});
+    }
+    slot.Release(node);
+  }
+  if (waiters.size() < 2) {
+    return;
+  }
+  std::unordered_map<TransactionID, size_t> index;
+  for (size_t i = 0; i < waiters.size(); i++) {
+    index.emplace(waiters[i].info.m_txn_id, i);
+  }
+
+  // Depth first search for a cycle, break it by its youngest transaction and
+  // search again until there is none
+  enum : char { kNew, kOnStack, kDone };
+  std::vector<char> state(waiters.size());
+  // The waiters on the path and the next edge of each to follow
+  std::vector<std::pair<size_t, size_t>> stack;
+  while (true) {
+    std::fill(state.begin(), state.end(), kNew);
+    size_t cycle_begin = 0;
+    bool found = false;
+    for (size_t root = 0; root < waiters.size() && !found; root++) {
+      if (waiters[root].removed || state[root] != kNew) {
+        continue;
+      }
+      stack.assign(1, {root, 0});
+      state[root] = kOnStack;
+      while (!stack.empty() && !found) {
+        auto& top = stack.back();
+        const auto& wait_ids = waiters[top.first].wait_ids;
+        if (top.second == wait_ids.size()) {
+          state[top.first] = kDone;
+          stack.pop_back();
+          continue;
+        }
+        auto it = index.find(wait_ids[top.second++]);
+        if (it == index.end() || waiters[it->second].removed ||
+            state[it->second] == kDone) {
+          continue;
+        }
+        if (state[it->second] == kOnStack) {
+          while (stack[cycle_begin].first != it->second) {
+            cycle_begin++;
+          }
+          found = true;
+        } else {
+          state[it->second] = kOnStack;
+          stack.push_back({it->second, 0});
+        }
+      }
+    }
+    if (!found) {
+      break;
+    }
+
+    size_t victim = cycle_begin;
+    for (size_t i = cycle_begin; i < stack.size(); i++) {
+      if (waiters[stack[i].first].info.m_txn_id >
+          waiters[stack[victim].first].info.m_txn_id) {
+        victim = i;
+      }
+    }
+    Waiter& w = waiters[stack[victim].first];
+    w.removed = true;
+
+    // The waiter may have moved on since the copy
+    bool marked = false;
+    WaitSlot& slot = wait_slots_[w.slot];
+    WaitNode* node = slot.Acquire();
+    if (node == w.node && node->version == w.version) {
+      node->deadlocked.store(true, std::memory_order_release);
+      marked = true;
+    }
+    slot.Release(node);
+    if (!marked) {
+      continue;
+    }
+
+    // Starting with the transaction the victim waits for, like the paths
+    // found by the waiters themselves end with the one that detected it
+    std::vector<DeadlockInfo> path;
+    for (size_t i = 1; i <= stack.size() - cycle_begin; i++) {
+      size_t pos = cycle_begin + (victim - cycle_begin + i) %
+                                     (stack.size() - cycle_begin);
+      path.push_back(waiters[stack[pos].first].info);
+    }
+    int64_t deadlock_time = 0;
+    env->GetCurrentTime(&deadlock_time);
+    dlock_buffer_.AddNewPath(DeadlockPath(path, deadlock_time));
+  }
+}
+
 void TransactionLockMgr::DecrementWaiters(
     const PessimisticTransaction* txn,
     const autovector<TransactionID>& wait_ids) {
@@ -526,9 +919,10 @@ bool TransactionLockMgr::IncrementWaiters(
 // Try to lock this key after we have acquired the mutex.
 // Sets *expire_time to the expiration time in microseconds
 //  or 0 if no expiration.
-// REQUIRED:  Stripe mutex must be held.
+// REQUIRED:  Stripe mutex must be held and counted in slow_users.
 Status TransactionLockMgr::AcquireLocked(LockMap* lock_map,
                                          LockMapStripe* stripe,
+                                         FastLockSlot* slot,
                                          const std::string& key, Env* env,
                                          const LockInfo& txn_lock_info,
                                          uint64_t* expire_time,
@@ -536,6 +930,23 @@ Status TransactionLockMgr::AcquireLocked(LockMap* lock_map,
   assert(txn_lock_info.txn_ids.size() == 1);
 
   Status result;
+  // A key held through the fast path is not in the stripe. It is moved to
+  // the stripe when its owner locks it again, held locks never expire.
+  bool moved_from_slot = false;
+  TransactionID slot_owner = slot->Acquire();
+  if (slot_owner != 0 && slot->key == key) {
+    if (slot_owner != txn_lock_info.txn_ids[0]) {
+      slot->Release(slot_owner);
+      *expire_time = 0;
+      txn_ids->clear();
+      txn_ids->push_back(slot_owner);
+      return Status::TimedOut(Status::SubCode::kLockTimeout);
+    }
+    slot_owner = 0;
+    moved_from_slot = true;
+  }
+  slot->Release(slot_owner);
+
   // Check if this key is already locked
   auto stripe_iter = stripe->keys.find(key);
   if (stripe_iter != stripe->keys.end()) {
@@ -577,15 +988,16 @@ Status TransactionLockMgr::AcquireLocked(LockMap* lock_map,
     }
   } else {  // Lock not held.
     // Check lock limit
-    if (max_num_locks_ > 0 &&
+    if (max_num_locks_ > 0 && !moved_from_slot &&
         lock_map->lock_cnt.load(std::memory_order_acquire) >= max_num_locks_) {
       result = Status::Busy(Status::SubCode::kLockLimit);
     } else {
       // acquire lock
       stripe->keys.insert({key, txn_lock_info});
+      stripe->slow_users.fetch_add(1);
 
       // Maintain lock count if there is a limit on the number of locks
-      if (max_num_locks_) {
+      if (max_num_locks_ && !moved_from_slot) {
         lock_map->lock_cnt++;
       }
     }
@@ -611,6 +1023,7 @@ void TransactionLockMgr::UnLockKey(const PessimisticTransaction* txn,
     if (txn_it != txns.end()) {
       if (txns.size() == 1) {
         stripe->keys.erase(stripe_iter);
+        stripe->slow_users.fetch_sub(1);
       } else {
         auto last_it = txns.end() - 1;
         if (txn_it != last_it) {
@@ -633,6 +1046,18 @@ void TransactionLockMgr::UnLockKey(const PessimisticTransaction* txn,
   }
 }
 
+void TransactionLockMgr::FastUnLocked(LockMap* lock_map,
+                                      LockMapStripe* stripe) {
+  if (max_num_locks_ > 0) {
+    assert(lock_map->lock_cnt.load(std::memory_order_relaxed) > 0);
+    lock_map->lock_cnt--;
+  }
+  // Pairs with the check of the slot by a thread locking through the stripe
+  if (stripe->slow_users.load() != 0) {
+    NotifyStripe(stripe);
+  }
+}
+
 void TransactionLockMgr::UnLock(PessimisticTransaction* txn,
                                 uint32_t column_family_id,
                                 const std::string& key, Env* env) {
@@ -644,10 +1069,17 @@ void TransactionLockMgr::UnLock(PessimisticTransaction* txn,
   }
 
   // Lock the mutex for the stripe that this key hashes to
-  size_t stripe_num = lock_map->GetStripe(key);
+  size_t hash = LockMap::Hash(key);
+  size_t stripe_num = lock_map->GetStripe(hash);
   assert(lock_map->lock_map_stripes_.size() > stripe_num);
   LockMapStripe* stripe = lock_map->lock_map_stripes_.at(stripe_num);
 
+  if (lock_map->TryFastUnLock(lock_map->GetFastLockSlot(hash), txn->GetID(),
+                              key)) {
+    FastUnLocked(lock_map, stripe);
+    return;
+  }
+
   stripe->stripe_mutex->Lock();
   UnLockKey(txn, key, stripe, lock_map, env);
   stripe->stripe_mutex->UnLock();
@@ -677,7 +1109,13 @@ void TransactionLockMgr::UnLock(const PessimisticTransaction* txn,
     for (auto& key_iter : keys) {
       const std::string& key = key_iter.first;
 
-      size_t stripe_num = lock_map->GetStripe(key);
+      size_t hash = LockMap::Hash(key);
+      size_t stripe_num = lock_map->GetStripe(hash);
+      if (lock_map->TryFastUnLock(lock_map->GetFastLockSlot(hash),
+                                  txn->GetID(), key)) {
+        FastUnLocked(lock_map, lock_map->lock_map_stripes_.at(stripe_num));
+        continue;
+      }
       keys_by_stripe[stripe_num].push_back(&key);
     }
 
@@ -731,6 +1169,22 @@ TransactionLockMgr::LockStatusData TransactionLockMgr::GetLockStatusData() {
         data.insert({i, info});
       }
     }
+    // The fast path locks are not frozen by the stripe mutexes, each slot is
+    // read consistently
+    for (auto& slot : lock_maps_[i]->fast_lock_slots_) {
+      if (slot.state.load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+      TransactionID owner = slot.Acquire();
+      if (owner != 0) {
+        struct KeyLockInfo info;
+        info.exclusive = true;
+        info.key = slot.key;
+        info.ids.push_back(owner);
+        data.insert({i, info});
+      }
+      slot.Release(owner);
+    }
   }
 
   // Unlock everything. Unlocking order is not important.
@@ -7,6 +7,7 @@
 #ifndef ROCKSDB_LITE
 
 #include <chrono>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -18,14 +19,18 @@
 #include "util/autovector.h"
 #include "util/hash_map.h"
 #include "util/thread_local.h"
+#include "util/timer.h"
 #include "utilities/transactions/pessimistic_transaction.h"
 
 namespace TERARKDB_NAMESPACE {
 
 class ColumnFamilyHandle;
+struct FastLockSlot;
 struct LockInfo;
 struct LockMap;
 struct LockMapStripe;
+struct WaitNode;
+struct WaitSlot;
 
 struct DeadlockInfoBuffer {
  private:
@@ -56,7 +61,8 @@ class TransactionLockMgr {
  public:
   TransactionLockMgr(TransactionDB* txn_db, size_t default_num_stripes,
                      int64_t max_num_locks, uint32_t max_num_deadlocks,
-                     std::shared_ptr<TransactionDBMutexFactory> factory);
+                     std::shared_ptr<TransactionDBMutexFactory> factory,
+                     uint64_t deadlock_detect_interval_ms = 0);
 
   ~TransactionLockMgr();
 
@@ -73,6 +79,13 @@ class TransactionLockMgr {
   Status TryLock(PessimisticTransaction* txn, uint32_t column_family_id,
                  const std::string& key, Env* env, bool exclusive);
 
+  // Attempt to lock keys in the given order, stopping at the first one that
+  // fails. *num_locked is set to the number of keys locked, the caller is
+  // responsible for unlocking them.
+  Status TryLock(PessimisticTransaction* txn, uint32_t column_family_id,
+                 const std::vector<const std::string*>& keys, Env* env,
+                 bool exclusive, size_t* num_locked);
+
   // Unlock a key locked by TryLock().  txn must be the same Transaction that
   // locked this key.
   void UnLock(const PessimisticTransaction* txn, const TransactionKeyMap* keys,
@@ -123,21 +136,43 @@ class TransactionLockMgr {
   // Used to allocate mutexes/condvars to use when locking keys
   std::shared_ptr<TransactionDBMutexFactory> mutex_factory_;
 
+  // The wait-for edges of the waiters with deadlock detection, published
+  // without a shared mutex for the background detector. A waiter that finds
+  // every slot taken detects deadlocks itself.
+  const uint64_t deadlock_detect_interval_us_;
+  std::unique_ptr<WaitSlot[]> wait_slots_;
+  // Tells a publication of a waiter from the ones before it
+  std::atomic<uint64_t> next_wait_version_;
+  // The shared timer running the detector, cancelled on destruction
+  std::shared_ptr<Timer> deadlock_timer_;
+  std::string deadlock_task_name_;
+
   bool IsLockExpired(TransactionID txn_id, const LockInfo& lock_info, Env* env,
                      uint64_t* wait_time);
 
   std::shared_ptr<LockMap> GetLockMap(uint32_t column_family_id);
 
+  // An exclusive lock without an expiration time is taken through a
+  // FastLockSlot without the stripe mutex when nobody else locks a key of
+  // its stripe, and through the stripe otherwise.
+  Status TryLockKey(PessimisticTransaction* txn, LockMap* lock_map,
+                    uint32_t column_family_id, const std::string& key,
+                    Env* env, bool exclusive);
+
   Status AcquireWithTimeout(PessimisticTransaction* txn, LockMap* lock_map,
-                            LockMapStripe* stripe, uint32_t column_family_id,
-                            const std::string& key, Env* env, int64_t timeout,
+                            LockMapStripe* stripe, FastLockSlot* slot,
+                            uint32_t column_family_id, const std::string& key,
+                            Env* env, int64_t timeout,
                             const LockInfo& lock_info);
 
   Status AcquireLocked(LockMap* lock_map, LockMapStripe* stripe,
-                       const std::string& key, Env* env,
+                       FastLockSlot* slot, const std::string& key, Env* env,
                        const LockInfo& lock_info, uint64_t* wait_time,
                        autovector<TransactionID>* txn_ids);
 
+  // Book-keeping after a key is unlocked from its FastLockSlot
+  void FastUnLocked(LockMap* lock_map, LockMapStripe* stripe);
+
   void UnLockKey(const PessimisticTransaction* txn, const std::string& key,
                  LockMapStripe* stripe, LockMap* lock_map, Env* env);
 
@@ -150,6 +185,14 @@ class TransactionLockMgr {
   void DecrementWaitersImpl(const PessimisticTransaction* txn,
                             const autovector<TransactionID>& wait_ids);
 
+  // Publishes the edges of a waiter in its WaitSlot, claiming one first.
+  // Returns false if no slot is free.
+  bool PublishWaiter(WaitNode* node, const autovector<TransactionID>& wait_ids);
+  void UnpublishWaiter(WaitNode* node);
+  // Finds the cycles among the published waiters and marks the youngest
+  // transaction of each as deadlocked
+  void DetectDeadlocks(Env* env);
+
   // No copying allowed
   TransactionLockMgr(const TransactionLockMgr&);
   void operator=(const TransactionLockMgr&);
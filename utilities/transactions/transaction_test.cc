@@ -395,6 +395,106 @@ TEST_P(TransactionTest, SharedLocks) {
   delete txn3;
 }
 
+TEST_P(TransactionTest, FastPathLocks) {
+  WriteOptions write_options;
+  ReadOptions read_options;
+  TransactionOptions txn_options;
+  Status s;
+
+  txn_options.lock_timeout = 1;
+  Transaction* txn1 = db->BeginTransaction(write_options, txn_options);
+  Transaction* txn2 = db->BeginTransaction(write_options, txn_options);
+  ASSERT_TRUE(txn1);
+  ASSERT_TRUE(txn2);
+
+  // Exclusive locks without an expiration time skip the stripes
+  ASSERT_OK(txn1->GetForUpdate(read_options, "foo", nullptr));
+  ASSERT_OK(txn1->GetForUpdate(read_options, "bar", nullptr));
+  auto lock_data = db->GetLockStatusData();
+  ASSERT_EQ(lock_data.size(), 2);
+  for (auto& lock : lock_data) {
+    ASSERT_EQ(0, lock.first);
+    ASSERT_TRUE(lock.second.key == "foo" || lock.second.key == "bar");
+    ASSERT_TRUE(lock.second.exclusive);
+    ASSERT_EQ(std::vector<TransactionID>{txn1->GetID()}, lock.second.ids);
+  }
+
+  s = txn2->GetForUpdate(read_options, "foo", nullptr);
+  ASSERT_TRUE(s.IsTimedOut());
+  s = txn2->GetForUpdate(read_options, "foo", nullptr, false /* exclusive */);
+  ASSERT_TRUE(s.IsTimedOut());
+
+  // A waiter through the stripe is woken up by the fast path unlock
+  TransactionOptions wait_options;
+  wait_options.lock_timeout = 10 * 1000;
+  Transaction* txn3 = db->BeginTransaction(write_options, wait_options);
+  ASSERT_TRUE(txn3);
+  port::Thread waiter([&] {
+    ASSERT_OK(txn3->GetForUpdate(read_options, "foo", nullptr));
+  });
+  txn1->UndoGetForUpdate("foo");
+  waiter.join();
+  ASSERT_OK(txn1->Rollback());
+  lock_data = db->GetLockStatusData();
+  ASSERT_EQ(lock_data.size(), 1);
+  ASSERT_EQ("foo", lock_data.begin()->second.key);
+  ASSERT_EQ(std::vector<TransactionID>{txn3->GetID()},
+            lock_data.begin()->second.ids);
+
+  // Batched locks of a write are all released on commit
+  WriteBatch batch;
+  ASSERT_OK(batch.Put("a", "1"));
+  ASSERT_OK(batch.Put("b", "2"));
+  ASSERT_OK(batch.Put("foo", "3"));
+  s = db->Write(write_options, &batch);
+  ASSERT_TRUE(s.IsTimedOut());
+  ASSERT_OK(txn3->Rollback());
+  ASSERT_OK(db->Write(write_options, &batch));
+  ASSERT_EQ(db->GetLockStatusData().size(), 0);
+
+  delete txn1;
+  delete txn2;
+  delete txn3;
+}
+
+TEST_P(TransactionTest, AsyncDeadlockDetect) {
+  WriteOptions write_options;
+  ReadOptions read_options;
+  TransactionOptions txn_options;
+
+  txn_db_options.deadlock_detect_interval_ms = 10;
+  ASSERT_OK(ReOpen());
+
+  txn_options.lock_timeout = 10 * 1000;
+  txn_options.deadlock_detect = true;
+  Transaction* txn1 = db->BeginTransaction(write_options, txn_options);
+  Transaction* txn2 = db->BeginTransaction(write_options, txn_options);
+  ASSERT_TRUE(txn1);
+  ASSERT_TRUE(txn2);
+  ASSERT_OK(txn1->GetForUpdate(read_options, "a", nullptr));
+  ASSERT_OK(txn2->GetForUpdate(read_options, "b", nullptr));
+
+  // The detector breaks the cycle by the younger transaction
+  port::Thread waiter([&] {
+    ASSERT_OK(txn1->GetForUpdate(read_options, "b", nullptr));
+  });
+  Status s = txn2->GetForUpdate(read_options, "a", nullptr);
+  ASSERT_TRUE(s.IsDeadlock());
+  ASSERT_OK(txn2->Rollback());
+  waiter.join();
+  ASSERT_OK(txn1->Commit());
+
+  auto dlock_buffer = db->GetDeadlockInfoBuffer();
+  ASSERT_EQ(dlock_buffer.size(), 1);
+  ASSERT_EQ(dlock_buffer[0].path.size(), 2);
+  ASSERT_FALSE(dlock_buffer[0].limit_exceeded);
+  ASSERT_EQ(txn2->GetID(), dlock_buffer[0].path[1].m_txn_id);
+  ASSERT_EQ("a", dlock_buffer[0].path[1].m_waiting_key);
+
+  delete txn1;
+  delete txn2;
+}
+
 TEST_P(TransactionTest, DeadlockCycleShared) {
   WriteOptions write_options;
   ReadOptions read_options;
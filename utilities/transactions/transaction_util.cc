@@ -56,8 +56,37 @@ Status TransactionUtil::CheckKey(DBImpl* db_impl, SuperVersion* sv,
                                  SequenceNumber snap_seq,
                                  const std::string& key, bool cache_only,
                                  ReadCallback* snap_checker) {
-  Status result;
   bool need_to_read_sst = false;
+  Status result = CheckMemTableHistory(earliest_seq, snap_seq, cache_only,
+                                       &need_to_read_sst);
+
+  if (result.ok()) {
+    SequenceNumber seq = kMaxSequenceNumber;
+    bool found_record_for_key = false;
+
+    Status s = db_impl->GetLatestSequenceForKey(sv, key, !need_to_read_sst,
+                                                &seq, &found_record_for_key);
+
+    if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
+      result = s;
+    } else if (found_record_for_key) {
+      bool write_conflict = snap_checker == nullptr
+                                ? snap_seq < seq
+                                : !snap_checker->IsVisible(seq);
+      if (write_conflict) {
+        result = Status::Busy();
+      }
+    }
+  }
+
+  return result;
+}
+
+Status TransactionUtil::CheckMemTableHistory(SequenceNumber earliest_seq,
+                                             SequenceNumber snap_seq,
+                                             bool cache_only,
+                                             bool* need_to_read_sst) {
+  Status result;
 
   // Since it would be too slow to check the SST files, we will only use
   // the memtables to check whether there have been any recent writes
@@ -69,7 +98,7 @@ Status TransactionUtil::CheckKey(DBImpl* db_impl, SuperVersion* sv,
     // for recent writes.  This error shouldn't happen often in practice as
     // the Memtable should have a valid earliest sequence number except in some
     // corner cases (such as error cases during recovery).
-    need_to_read_sst = true;
+    *need_to_read_sst = true;
 
     if (cache_only) {
       result = Status::TryAgain(
@@ -78,7 +107,7 @@ Status TransactionUtil::CheckKey(DBImpl* db_impl, SuperVersion* sv,
           ToString(snap_seq));
     }
   } else if (snap_seq < earliest_seq) {
-    need_to_read_sst = true;
+    *need_to_read_sst = true;
 
     if (cache_only) {
       // The age of this memtable is too new to use to check for recent
@@ -98,25 +127,6 @@ Status TransactionUtil::CheckKey(DBImpl* db_impl, SuperVersion* sv,
     }
   }
 
-  if (result.ok()) {
-    SequenceNumber seq = kMaxSequenceNumber;
-    bool found_record_for_key = false;
-
-    Status s = db_impl->GetLatestSequenceForKey(sv, key, !need_to_read_sst,
-                                                &seq, &found_record_for_key);
-
-    if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
-      result = s;
-    } else if (found_record_for_key) {
-      bool write_conflict = snap_checker == nullptr
-                                ? snap_seq < seq
-                                : !snap_checker->IsVisible(seq);
-      if (write_conflict) {
-        result = Status::Busy();
-      }
-    }
-  }
-
   return result;
 }
 
@@ -140,16 +150,34 @@ Status TransactionUtil::CheckKeysForConflicts(DBImpl* db_impl,
         db_impl->GetEarliestMemTableSequenceNumber(sv, true);
 
     // For each of the keys in this transaction, check to see if someone has
-    // written to this key since the start of the transaction.
+    // written to this key since the start of the transaction. The latest
+    // sequences of all the keys of a column family are looked up together.
+    std::vector<Slice> key_slices;
+    std::vector<SequenceNumber> key_seqs;
+    key_slices.reserve(keys.size());
+    key_seqs.reserve(keys.size());
+    bool need_to_read_sst = false;
     for (const auto& key_iter : keys) {
-      const auto& key = key_iter.first;
-      const SequenceNumber key_seq = key_iter.second.seq;
-
-      result = CheckKey(db_impl, sv, earliest_seq, key_seq, key, cache_only);
-
+      result = CheckMemTableHistory(earliest_seq, key_iter.second.seq,
+                                    cache_only, &need_to_read_sst);
       if (!result.ok()) {
         break;
       }
+      key_slices.emplace_back(key_iter.first);
+      key_seqs.push_back(key_iter.second.seq);
+    }
+
+    std::vector<SequenceNumber> latest_seqs;
+    if (result.ok()) {
+      result = db_impl->GetLatestSequenceForKeys(sv, key_slices,
+                                                 !need_to_read_sst,
+                                                 &latest_seqs);
+    }
+    for (size_t i = 0; result.ok() && i < latest_seqs.size(); ++i) {
+      if (latest_seqs[i] != kMaxSequenceNumber &&
+          key_seqs[i] < latest_seqs[i]) {
+        result = Status::Busy();
+      }
     }
 
     db_impl->ReturnAndCleanupSuperVersion(cf_id, sv);
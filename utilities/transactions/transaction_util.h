@@ -75,6 +75,13 @@ class TransactionUtil {
                          SequenceNumber earliest_seq, SequenceNumber snap_seq,
                          const std::string& key, bool cache_only,
                          ReadCallback* snap_checker = nullptr);
+
+  // Whether the memtables, whose earliest sequence is earliest_seq, hold
+  // the writes since snap_seq. If not, *need_to_read_sst is set and
+  // TryAgain is returned when cache_only.
+  static Status CheckMemTableHistory(SequenceNumber earliest_seq,
+                                     SequenceNumber snap_seq, bool cache_only,
+                                     bool* need_to_read_sst);
 };
 
 }  // namespace TERARKDB_NAMESPACE
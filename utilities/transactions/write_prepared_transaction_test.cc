@@ -1443,6 +1443,26 @@ TEST_P(WritePreparedTransactionTest, IsInSnapshotEmptyMapTest) {
   ASSERT_TRUE(wp_db->IsInSnapshot(100, 150));
 }
 
+TEST_P(WritePreparedTransactionTest, SmallestUnCommittedSeqTest) {
+  txn_db_options.write_prepared_commit_cache_bits = 10;
+  ASSERT_OK(ReOpen());
+  WritePreparedTxnDB* wp_db = dynamic_cast<WritePreparedTxnDB*>(db);
+  ASSERT_EQ(1024, wp_db->COMMIT_CACHE_SIZE);
+
+  // Read without prepared_mutex_, it follows the prepared heap
+  SequenceNumber latest = db->GetLatestSequenceNumber();
+  ASSERT_EQ(latest + 1, wp_db->SmallestUnCommittedSeq());
+  wp_db->AddPrepared(latest + 1);
+  wp_db->AddPrepared(latest + 2);
+  ASSERT_EQ(latest + 1, wp_db->SmallestUnCommittedSeq());
+  wp_db->RemovePrepared(latest + 1);
+  ASSERT_EQ(latest + 1, wp_db->SmallestUnCommittedSeq());
+  ASSERT_EQ(latest + 2, wp_db->min_prepared_.load());
+  wp_db->RemovePrepared(latest + 2);
+  ASSERT_EQ(kMaxSequenceNumber, wp_db->min_prepared_.load());
+  ASSERT_EQ(latest + 1, wp_db->SmallestUnCommittedSeq());
+}
+
 // Test WritePreparedTxnDB's IsInSnapshot against different ordering of
 // snapshot, max_committed_seq_, prepared, and commit entries.
 TEST_P(WritePreparedTransactionTest, IsInSnapshotTest) {
@@ -396,6 +396,7 @@ void WritePreparedTxnDB::AddPrepared(uint64_t seq) {
   }
   WriteLock wl(&prepared_mutex_);
   prepared_txns_.push(seq);
+  UpdateMinPrepared();
 }
 
 void WritePreparedTxnDB::AddCommitted(uint64_t prepare_seq, uint64_t commit_seq,
@@ -456,6 +457,7 @@ void WritePreparedTxnDB::RemovePrepared(const uint64_t prepare_seq,
       }
     }
   }
+  UpdateMinPrepared();
 }
 
 bool WritePreparedTxnDB::GetCommitEntry(const uint64_t indexed_seq,
@@ -512,6 +514,7 @@ void WritePreparedTxnDB::AdvanceMaxEvictedSeq(const SequenceNumber& prev_max,
       prepared_txns_.pop();
       delayed_prepared_empty_.store(false, std::memory_order_release);
     }
+    UpdateMinPrepared();
   }
 
   // With each change to max_evicted_seq_ fetch the live snapshots behind it.
@@ -52,7 +52,9 @@ class WritePreparedTxnDB : public PessimisticTransactionDB {
       : PessimisticTransactionDB(db, txn_db_options),
         SNAPSHOT_CACHE_BITS(snapshot_cache_bits),
         SNAPSHOT_CACHE_SIZE(static_cast<size_t>(1ull << SNAPSHOT_CACHE_BITS)),
-        COMMIT_CACHE_BITS(commit_cache_bits),
+        COMMIT_CACHE_BITS(txn_db_options.write_prepared_commit_cache_bits > 0
+                              ? txn_db_options.write_prepared_commit_cache_bits
+                              : commit_cache_bits),
         COMMIT_CACHE_SIZE(static_cast<size_t>(1ull << COMMIT_CACHE_BITS)),
         FORMAT(COMMIT_CACHE_BITS) {
     Init(txn_db_options);
@@ -65,7 +67,9 @@ class WritePreparedTxnDB : public PessimisticTransactionDB {
       : PessimisticTransactionDB(db, txn_db_options),
         SNAPSHOT_CACHE_BITS(snapshot_cache_bits),
         SNAPSHOT_CACHE_SIZE(static_cast<size_t>(1ull << SNAPSHOT_CACHE_BITS)),
-        COMMIT_CACHE_BITS(commit_cache_bits),
+        COMMIT_CACHE_BITS(txn_db_options.write_prepared_commit_cache_bits > 0
+                              ? txn_db_options.write_prepared_commit_cache_bits
+                              : commit_cache_bits),
         COMMIT_CACHE_SIZE(static_cast<size_t>(1ull << COMMIT_CACHE_BITS)),
         FORMAT(COMMIT_CACHE_BITS) {
     Init(txn_db_options);
@@ -383,11 +387,19 @@ class WritePreparedTxnDB : public PessimisticTransactionDB {
   friend class WritePreparedTransactionTest_IsInSnapshotEmptyMapTest_Test;
   friend class WritePreparedTransactionTest_OldCommitMapGC_Test;
   friend class WritePreparedTransactionTest_RollbackTest_Test;
+  friend class WritePreparedTransactionTest_SmallestUnCommittedSeqTest_Test;
   friend class WriteUnpreparedTxnDB;
   friend class WriteUnpreparedTransactionTest_RecoveryTest_Test;
 
   void Init(const TransactionDBOptions& /* unused */);
 
+  // REQUIRES: prepared_mutex_ write lock
+  void UpdateMinPrepared() {
+    min_prepared_.store(
+        prepared_txns_.empty() ? kMaxSequenceNumber : prepared_txns_.top(),
+        std::memory_order_release);
+  }
+
   void WPRecordTick(uint32_t ticker_type) const {
     RecordTick(db_impl_->immutable_db_options_.statistics.get(), ticker_type);
   }
@@ -485,18 +497,14 @@ class WritePreparedTxnDB : public PessimisticTransactionDB {
     // written in two steps, we also update prepared_txns_ at the first step
     // (via the same mechanism) so that their uncommitted data is reflected in
     // SmallestUnCommittedSeq.
-    ReadLock rl(&prepared_mutex_);
-    // Since we are holding the mutex, and GetLatestSequenceNumber is updated
-    // after prepared_txns_ are, the value of GetLatestSequenceNumber would
-    // reflect any uncommitted data that is not added to prepared_txns_ yet.
-    // Otherwise, if there is no concurrent txn, this value simply reflects that
-    // latest value in the memtable.
-    if (prepared_txns_.empty()) {
-      return db_impl_->GetLatestSequenceNumber() + 1;
-    } else {
-      return std::min(prepared_txns_.top(),
-                      db_impl_->GetLatestSequenceNumber() + 1);
-    }
+    //
+    // GetLatestSequenceNumber is updated after prepared_txns_ and
+    // min_prepared_ are, so reading it first makes min_prepared_ reflect any
+    // uncommitted data up to it, without taking prepared_mutex_. Otherwise, if
+    // there is no concurrent txn, this value simply reflects that latest value
+    // in the memtable.
+    auto latest = db_impl_->GetLatestSequenceNumber() + 1;
+    return std::min(min_prepared_.load(std::memory_order_acquire), latest);
   }
   // Enhance the snapshot object by recording in it the smallest uncommitted seq
   inline void EnhanceSnapshot(SnapshotImpl* snapshot,
@@ -569,6 +577,9 @@ class WritePreparedTxnDB : public PessimisticTransactionDB {
   // A heap of prepared transactions. Thread-safety is provided with
   // prepared_mutex_.
   PreparedHeap prepared_txns_;
+  // The top of prepared_txns_, kMaxSequenceNumber when it is empty. Written
+  // under prepared_mutex_ and read without it.
+  std::atomic<uint64_t> min_prepared_ = {kMaxSequenceNumber};
   // 8m entry, 64MB size
   static const size_t DEF_COMMIT_CACHE_BITS = static_cast<size_t>(23);
   const size_t COMMIT_CACHE_BITS;
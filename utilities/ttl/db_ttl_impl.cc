@@ -5,6 +5,8 @@
 
 #include "utilities/ttl/db_ttl_impl.h"
 
+#include <string.h>
+
 #include "db/write_batch_internal.h"
 #include "rocksdb/convenience.h"
 #include "rocksdb/env.h"
@@ -17,7 +19,7 @@
 namespace TERARKDB_NAMESPACE {
 
 void DBWithTTLImpl::SanitizeOptions(int32_t ttl, ColumnFamilyOptions* options,
-                                    Env* env) {
+                                    Env* env, bool use_ttl_extractor) {
   if (options->compaction_filter) {
     options->compaction_filter =
         new TtlCompactionFilter(ttl, env, options->compaction_filter);
@@ -31,10 +33,16 @@ void DBWithTTLImpl::SanitizeOptions(int32_t ttl, ColumnFamilyOptions* options,
     options->merge_operator.reset(
         new TtlMergeOperator(options->merge_operator, env));
   }
+
+  if (use_ttl_extractor && options->ttl_extractor_factory == nullptr) {
+    options->ttl_extractor_factory =
+        std::make_shared<TtlTimestampExtractorFactory>(ttl, env);
+  }
 }
 
 // Open the db inside DBWithTTLImpl because options needs pointer to its ttl
-DBWithTTLImpl::DBWithTTLImpl(DB* db) : DBWithTTL(db) {}
+DBWithTTLImpl::DBWithTTLImpl(DB* db, bool use_ttl_extractor)
+    : DBWithTTL(db), use_ttl_extractor_(use_ttl_extractor) {}
 
 DBWithTTLImpl::~DBWithTTLImpl() {
   // Need to stop background compaction before getting rid of the filter
@@ -55,7 +63,8 @@ Status UtilityDB::OpenTtlDB(const Options& options, const std::string& dbname,
 }
 
 Status DBWithTTL::Open(const Options& options, const std::string& dbname,
-                       DBWithTTL** dbptr, int32_t ttl, bool read_only) {
+                       DBWithTTL** dbptr, int32_t ttl, bool read_only,
+                       bool use_ttl_extractor) {
   DBOptions db_options(options);
   ColumnFamilyOptions cf_options(options);
   std::vector<ColumnFamilyDescriptor> column_families;
@@ -63,7 +72,7 @@ Status DBWithTTL::Open(const Options& options, const std::string& dbname,
       ColumnFamilyDescriptor(kDefaultColumnFamilyName, cf_options));
   std::vector<ColumnFamilyHandle*> handles;
   Status s = DBWithTTL::Open(db_options, dbname, column_families, &handles,
-                             dbptr, {ttl}, read_only);
+                             dbptr, {ttl}, read_only, use_ttl_extractor);
   if (s.ok()) {
     assert(handles.size() == 1);
     // i can delete the handle since DBImpl is always holding a reference to
@@ -77,7 +86,7 @@ Status DBWithTTL::Open(
     const DBOptions& db_options, const std::string& dbname,
     const std::vector<ColumnFamilyDescriptor>& column_families,
     std::vector<ColumnFamilyHandle*>* handles, DBWithTTL** dbptr,
-    std::vector<int32_t> ttls, bool read_only) {
+    std::vector<int32_t> ttls, bool read_only, bool use_ttl_extractor) {
   if (ttls.size() != column_families.size()) {
     return Status::InvalidArgument(
         "ttls size has to be the same as number of column families");
@@ -88,7 +97,8 @@ Status DBWithTTL::Open(
   for (size_t i = 0; i < column_families_sanitized.size(); ++i) {
     DBWithTTLImpl::SanitizeOptions(
         ttls[i], &column_families_sanitized[i].options,
-        db_options.env == nullptr ? Env::Default() : db_options.env);
+        db_options.env == nullptr ? Env::Default() : db_options.env,
+        use_ttl_extractor);
   }
   DB* db;
 
@@ -100,7 +110,7 @@ Status DBWithTTL::Open(
     st = DB::Open(db_options, dbname, column_families_sanitized, handles, &db);
   }
   if (st.ok()) {
-    *dbptr = new DBWithTTLImpl(db);
+    *dbptr = new DBWithTTLImpl(db, use_ttl_extractor);
   } else {
     *dbptr = nullptr;
   }
@@ -111,7 +121,8 @@ Status DBWithTTLImpl::CreateColumnFamilyWithTtl(
     const ColumnFamilyOptions& options, const std::string& column_family_name,
     ColumnFamilyHandle** handle, int ttl) {
   ColumnFamilyOptions sanitized_options = options;
-  DBWithTTLImpl::SanitizeOptions(ttl, &sanitized_options, GetEnv());
+  DBWithTTLImpl::SanitizeOptions(ttl, &sanitized_options, GetEnv(),
+                                 use_ttl_extractor_);
 
   return DBWithTTL::CreateColumnFamily(sanitized_options, column_family_name,
                                        handle);
@@ -169,7 +180,8 @@ bool DBWithTTLImpl::IsStale(const Slice& value, int32_t ttl, Env* env) {
   return (timestamp_value + ttl) < curtime;
 }
 
-// Strips the TS from the end of the slice
+// Strips the TS from the end of the slice. A value referring to pinned data
+// is narrowed in place instead of being copied.
 Status DBWithTTLImpl::StripTS(LazyBuffer* lazy_val) {
   Status st = lazy_val->fetch();
   if (!st.ok()) {
@@ -179,6 +191,13 @@ Status DBWithTTLImpl::StripTS(LazyBuffer* lazy_val) {
   if (size < kTSLength) {
     return Status::Corruption("Bad timestamp in key-value");
   }
+  auto state = LazyBufferState::get_state(lazy_val);
+  if (state == LazyBufferState::cleanable_state() ||
+      state == LazyBufferState::cleanable_db_state()) {
+    LazyBufferState::set_slice(lazy_val,
+                               Slice(lazy_val->data(), size - kTSLength));
+    return st;
+  }
   // Erasing characters which hold the TS
   auto builder = lazy_val->get_builder();
   if (!builder->resize(size - kTSLength)) {
@@ -323,6 +342,13 @@ void DBWithTTLImpl::SetTtl(ColumnFamilyHandle* h, int32_t ttl) {
       opts.compaction_filter_factory);
   if (!filter) return;
   filter->SetTtl(ttl);
+  if (opts.ttl_extractor_factory != nullptr &&
+      strcmp(opts.ttl_extractor_factory->Name(),
+             "TtlTimestampExtractorFactory") == 0) {
+    std::static_pointer_cast<const TtlTimestampExtractorFactory>(
+        opts.ttl_extractor_factory)
+        ->SetTtl(ttl);
+  }
 }
 
 }  // namespace TERARKDB_NAMESPACE
@@ -5,6 +5,8 @@
 #pragma once
 
 #ifndef ROCKSDB_LITE
+#include <algorithm>
+#include <atomic>
 #include <deque>
 #include <string>
 #include <vector>
@@ -15,6 +17,7 @@
 #include "rocksdb/env.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/terark_namespace.h"
+#include "rocksdb/ttl_extractor.h"
 #include "rocksdb/utilities/db_ttl.h"
 #include "rocksdb/utilities/utility_db.h"
 
@@ -28,9 +31,9 @@ namespace TERARKDB_NAMESPACE {
 class DBWithTTLImpl : public DBWithTTL {
  public:
   static void SanitizeOptions(int32_t ttl, ColumnFamilyOptions* options,
-                              Env* env);
+                              Env* env, bool use_ttl_extractor = false);
 
-  explicit DBWithTTLImpl(DB* db);
+  explicit DBWithTTLImpl(DB* db, bool use_ttl_extractor = false);
 
   virtual ~DBWithTTLImpl();
 
@@ -98,6 +101,10 @@ class DBWithTTLImpl : public DBWithTTL {
   void SetTtl(int32_t ttl) override { SetTtl(DefaultColumnFamily(), ttl); }
 
   void SetTtl(ColumnFamilyHandle* h, int32_t ttl) override;
+
+ private:
+  // Whether the column families created later get a TtlTimestampExtractor
+  const bool use_ttl_extractor_;
 };
 
 class TtlIterator : public Iterator {
@@ -224,6 +231,58 @@ class TtlCompactionFilterFactory : public CompactionFilterFactory {
   std::shared_ptr<CompactionFilterFactory> user_comp_filter_factory_;
 };
 
+// The time left to the expiry of a value, read from its timestamp
+class TtlTimestampExtractor : public TtlExtractor {
+ public:
+  TtlTimestampExtractor(int32_t ttl, Env* env) : ttl_(ttl), env_(env) {}
+
+  virtual Status Extract(EntryType /*entry_type*/, const Slice& /*user_key*/,
+                         const Slice& value_or_meta, bool* has_ttl,
+                         std::chrono::seconds* ttl) const override {
+    *has_ttl = false;
+    int64_t curtime;
+    if (ttl_ <= 0 || !DBWithTTLImpl::SanityCheckTimestamp(value_or_meta).ok() ||
+        !env_->GetCurrentTime(&curtime).ok()) {
+      return Status::OK();
+    }
+    int64_t expiry =
+        int64_t(DecodeFixed32(value_or_meta.data() + value_or_meta.size() -
+                              DBWithTTLImpl::kTSLength)) +
+        ttl_;
+    *has_ttl = true;
+    *ttl = std::chrono::seconds(std::max<int64_t>(expiry - curtime, 0));
+    return Status::OK();
+  }
+
+ private:
+  int32_t ttl_;
+  Env* env_;
+};
+
+class TtlTimestampExtractorFactory : public TtlExtractorFactory {
+ public:
+  TtlTimestampExtractorFactory(int32_t ttl, Env* env) : ttl_(ttl), env_(env) {}
+
+  virtual std::unique_ptr<TtlExtractor> CreateTtlExtractor(
+      const TtlContext& /*context*/) const override {
+    return std::unique_ptr<TtlExtractor>(
+        new TtlTimestampExtractor(ttl_.load(std::memory_order_relaxed), env_));
+  }
+
+  // Applies to the extractors created later
+  void SetTtl(int32_t ttl) const {
+    ttl_.store(ttl, std::memory_order_relaxed);
+  }
+
+  virtual const char* Name() const override {
+    return "TtlTimestampExtractorFactory";
+  }
+
+ private:
+  mutable std::atomic<int32_t> ttl_;
+  Env* env_;
+};
+
 class TtlMergeOperator : public MergeOperator {
  public:
   explicit TtlMergeOperator(const std::shared_ptr<MergeOperator>& merge_op,
@@ -8,6 +8,8 @@
 #include <memory>
 
 #include "rocksdb/compaction_filter.h"
+#include "rocksdb/table_properties.h"
+#include "rocksdb/ttl_extractor.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/utilities/db_ttl.h"
 #include "util/string_util.h"
@@ -84,6 +86,14 @@ class TtlTest : public testing::Test {
     OpenTtl(ttl);
   }
 
+  // Open database with TTL support whose timestamps are read by the
+  // TtlTimestampExtractor
+  void OpenTtlWithExtractor(int32_t ttl) {
+    ASSERT_TRUE(db_ttl_ == nullptr);
+    ASSERT_OK(DBWithTTL::Open(options_, dbname_, &db_ttl_, ttl, false,
+                              true /* use_ttl_extractor */));
+  }
+
   // Open database with TTL support in read_only mode
   void OpenReadOnlyTtl(int32_t ttl) {
     ASSERT_TRUE(db_ttl_ == nullptr);
@@ -646,6 +656,55 @@ TEST_F(TtlTest, ChangeTtlOnOpenDb) {
   CloseTtl();
 }
 
+TEST_F(TtlTest, TtlExtractor) {
+  MakeKVMap(kSampleSize_);
+
+  OpenTtlWithExtractor(100);
+  ASSERT_STREQ("TtlTimestampExtractorFactory",
+               db_ttl_->GetOptions().ttl_extractor_factory->Name());
+  PutValues(0, kSampleSize_);
+
+  // The flushed table knows when its rows expire
+  TablePropertiesCollection props;
+  ASSERT_OK(db_ttl_->GetPropertiesOfAllTables(&props));
+  ASSERT_EQ(1U, props.size());
+  for (auto& prop : props) {
+    ASSERT_EQ(1U, prop.second->user_collected_properties.count(
+                      TablePropertiesNames::kTtlExpiryHistogram));
+  }
+
+  // Values read from the table come without the timestamp
+  std::unique_ptr<Iterator> iter(db_ttl_->NewIterator(ReadOptions()));
+  int64_t count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++count) {
+    LazyBuffer value;
+    ASSERT_OK(db_ttl_->Get(ReadOptions(), db_ttl_->DefaultColumnFamily(),
+                           iter->key(), &value));
+    ASSERT_OK(value.fetch());
+    ASSERT_EQ(iter->value(), value.slice());
+  }
+  ASSERT_EQ(kSampleSize_ + 1, count);
+
+  auto extractor =
+      db_ttl_->GetOptions().ttl_extractor_factory->CreateTtlExtractor(
+          TtlExtractorContext{0});
+  iter.reset(db_ttl_->GetBaseDB()->NewIterator(ReadOptions()));
+  iter->SeekToFirst();
+  ASSERT_TRUE(iter->Valid());
+  bool has_ttl = false;
+  std::chrono::seconds ttl(0);
+  env_->Sleep(40);
+  ASSERT_OK(extractor->Extract(kEntryPut, iter->key(), iter->value(), &has_ttl,
+                               &ttl));
+  iter.reset();
+  ASSERT_TRUE(has_ttl);
+  ASSERT_EQ(60, ttl.count());
+
+  // Expired rows are still dropped by compactions
+  SleepCompactCheck(61, 0, kSampleSize_, false);
+  CloseTtl();
+}
+
 }  //  namespace TERARKDB_NAMESPACE
 
 // A black-box test for the ttl wrapper around rocksdb
@@ -7,6 +7,7 @@
 
 #include "rocksdb/utilities/write_batch_with_index.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "db/column_family.h"
@@ -963,6 +964,152 @@ Status WriteBatchWithIndex::GetFromBatchAndDB(
   return s;
 }
 
+std::vector<Status> WriteBatchWithIndex::MultiGetFromBatchAndDB(
+    DB* db, const ReadOptions& read_options, const std::vector<Slice>& keys,
+    std::vector<std::string>* values) {
+  return MultiGetFromBatchAndDB(
+      db, read_options,
+      std::vector<ColumnFamilyHandle*>(keys.size(), db->DefaultColumnFamily()),
+      keys, values);
+}
+
+std::vector<Status> WriteBatchWithIndex::MultiGetFromBatchAndDB(
+    DB* db, const ReadOptions& read_options,
+    const std::vector<ColumnFamilyHandle*>& column_family,
+    const std::vector<Slice>& keys, std::vector<std::string>* values) {
+  assert(column_family.size() == keys.size());
+  size_t num_keys = keys.size();
+  values->resize(num_keys);
+  std::vector<Status> stat_list(num_keys);
+
+  DBImpl* db_impl = static_cast_with_check<DBImpl, DB>(db->GetRootDB());
+  const ImmutableDBOptions& immuable_db_options =
+      db_impl->immutable_db_options();
+
+  // Visit the keys grouped by column family and in index order, so each
+  // column family needs one iterator and the seeks only move forward.
+  std::vector<uint32_t> cf_ids(num_keys);
+  std::vector<const Comparator*> cmps(num_keys);
+  std::vector<size_t> order(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    cf_ids[i] = GetColumnFamilyID(column_family[i]);
+    cmps[i] = rep->GetComparator(column_family[i]);
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (cf_ids[a] != cf_ids[b]) {
+      return cf_ids[a] < cf_ids[b];
+    }
+    return cmps[a] != nullptr && cmps[a]->Compare(keys[a], keys[b]) < 0;
+  });
+
+  // Keys the batch cannot resolve, with the merge operands they collected
+  std::vector<size_t> db_index;
+  std::vector<ColumnFamilyHandle*> db_column_family;
+  std::vector<Slice> db_keys;
+  std::vector<MergeContext> merge_contexts(num_keys);
+  std::vector<bool> merge_in_progress(num_keys, false);
+
+  WBWIIterator::IteratorStorage iter;
+  uint32_t iter_cf_id = 0;
+  for (size_t i : order) {
+    if (cmps[i] == nullptr) {
+      // Nothing of this column family in the batch
+      db_index.push_back(i);
+      db_column_family.push_back(column_family[i]);
+      db_keys.push_back(keys[i]);
+      continue;
+    }
+    if (iter.iter == nullptr || iter_cf_id != cf_ids[i]) {
+      if (iter.iter != nullptr) {
+        iter.iter->~WBWIIterator();
+        iter.iter = nullptr;
+      }
+      NewIterator(column_family[i], iter, true);
+      iter_cf_id = cf_ids[i];
+    }
+    Status s;
+    std::string* value = &(*values)[i];
+    LazyBuffer lazy_val(value);
+    WriteBatchWithIndexInternal::Result result =
+        WriteBatchWithIndexInternal::GetFromBatch(
+            immuable_db_options, iter.iter, column_family[i], keys[i],
+            &merge_contexts[i], cmps[i], &lazy_val, rep->overwrite_key, &s);
+    switch (result) {
+      case WriteBatchWithIndexInternal::Result::kFound:
+        stat_list[i] = std::move(lazy_val).dump(value);
+        break;
+      case WriteBatchWithIndexInternal::Result::kDeleted:
+        stat_list[i] = Status::NotFound();
+        break;
+      case WriteBatchWithIndexInternal::Result::kError:
+        stat_list[i] = s;
+        break;
+      case WriteBatchWithIndexInternal::Result::kMergeInProgress:
+        if (rep->overwrite_key) {
+          // See GetFromBatchAndDB()
+          stat_list[i] = Status::MergeInProgress();
+          break;
+        }
+        merge_in_progress[i] = true;
+        db_index.push_back(i);
+        db_column_family.push_back(column_family[i]);
+        db_keys.push_back(keys[i]);
+        break;
+      case WriteBatchWithIndexInternal::Result::kNotFound:
+        db_index.push_back(i);
+        db_column_family.push_back(column_family[i]);
+        db_keys.push_back(keys[i]);
+        break;
+      default:
+        assert(false);
+    }
+  }
+
+  if (db_keys.empty()) {
+    return stat_list;
+  }
+
+  std::vector<std::string> db_values;
+  std::vector<Status> db_stat_list =
+      db_impl->MultiGet(read_options, db_column_family, db_keys, &db_values);
+
+  Statistics* statistics = immuable_db_options.statistics.get();
+  Env* env = immuable_db_options.env;
+  Logger* logger = immuable_db_options.info_log.get();
+  for (size_t j = 0; j < db_index.size(); ++j) {
+    size_t i = db_index[j];
+    Status& s = stat_list[i] = std::move(db_stat_list[j]);
+    if (!merge_in_progress[i]) {
+      if (s.ok()) {
+        (*values)[i] = std::move(db_values[j]);
+      }
+      continue;
+    }
+    if (!s.ok() && !s.IsNotFound()) {
+      continue;
+    }
+    // Merge result from DB with merges in Batch
+    auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
+    const MergeOperator* merge_operator =
+        cfh->cfd()->ioptions()->merge_operator;
+    if (merge_operator == nullptr) {
+      s = Status::InvalidArgument("Options::merge_operator must be set");
+      continue;
+    }
+    LazyBuffer db_value(db_values[j]);
+    LazyBuffer merge_result;
+    s = MergeHelper::TimedFullMerge(
+        merge_operator, keys[i], s.ok() ? &db_value : nullptr,
+        merge_contexts[i].GetOperands(), &merge_result, logger, statistics,
+        env);
+    if (s.ok()) {
+      s = std::move(merge_result).dump(&(*values)[i]);
+    }
+  }
+  return stat_list;
+}
+
 void WriteBatchWithIndex::SetSavePoint() { rep->write_batch.SetSavePoint(); }
 
 Status WriteBatchWithIndex::RollbackToSavePoint() {
@@ -101,6 +101,22 @@ WriteBatchWithIndexInternal::Result WriteBatchWithIndexInternal::GetFromBatch(
     ColumnFamilyHandle* column_family, const Slice& key,
     MergeContext* merge_context, const Comparator* cmp, LazyBuffer* value,
     bool overwrite_key, Status* s) {
+  if (cmp == nullptr) {
+    *s = Status::OK();
+    return WriteBatchWithIndexInternal::Result::kNotFound;
+  }
+
+  WBWIIterator::IteratorStorage iter;
+  batch->NewIterator(column_family, iter, true);
+  return GetFromBatch(immuable_db_options, iter.iter, column_family, key,
+                      merge_context, cmp, value, overwrite_key, s);
+}
+
+WriteBatchWithIndexInternal::Result WriteBatchWithIndexInternal::GetFromBatch(
+    const ImmutableDBOptions& immuable_db_options, WBWIIterator* iter,
+    ColumnFamilyHandle* column_family, const Slice& key,
+    MergeContext* merge_context, const Comparator* cmp, LazyBuffer* value,
+    bool overwrite_key, Status* s) {
   *s = Status::OK();
   WriteBatchWithIndexInternal::Result result =
       WriteBatchWithIndexInternal::Result::kNotFound;
@@ -109,9 +125,6 @@ WriteBatchWithIndexInternal::Result WriteBatchWithIndexInternal::GetFromBatch(
     return result;
   }
 
-  WBWIIterator::IteratorStorage iter;
-  batch->NewIterator(column_family, iter, true);
-
   // We want to iterate in the reverse order that the writes were added to the
   // batch.  Since we don't have a reverse iterator, we must seek past the end.
   // TODO(agiardullo): consider adding support for reverse iteration
@@ -82,6 +82,14 @@ class WriteBatchWithIndexInternal {
       ColumnFamilyHandle* column_family, const Slice& key,
       MergeContext* merge_context, const Comparator* cmp, LazyBuffer* value,
       bool overwrite_key, Status* s);
+
+  // Same as above, but looks the key up through iter, an iterator over the
+  // column family's entries. Lets callers reuse one iterator for many keys.
+  static WriteBatchWithIndexInternal::Result GetFromBatch(
+      const ImmutableDBOptions& ioptions, WBWIIterator* iter,
+      ColumnFamilyHandle* column_family, const Slice& key,
+      MergeContext* merge_context, const Comparator* cmp, LazyBuffer* value,
+      bool overwrite_key, Status* s);
 };
 
 class WriteBatchKeyExtractor {
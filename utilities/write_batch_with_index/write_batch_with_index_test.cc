@@ -1364,6 +1364,66 @@ TEST_F(WriteBatchWithIndexTest, TestGetFromBatchAndDBMerge3) {
   DestroyDB(dbname, options);
 }
 
+TEST_F(WriteBatchWithIndexTest, TestMultiGetFromBatchAndDB) {
+  for (auto index_type : all_index_types) {
+    DB* db;
+    Options options;
+
+    options.create_if_missing = true;
+    std::string dbname = test::PerThreadDBPath("write_batch_with_index_test");
+
+    options.merge_operator = MergeOperators::CreateFromStringId("stringappend");
+
+    DestroyDB(dbname, options);
+    Status s = DB::Open(options, dbname, &db);
+    assert(s.ok());
+
+    WriteBatchWithIndex batch(BytewiseComparator(), 0, false, 0, index_type);
+    ReadOptions read_options;
+    WriteOptions write_options;
+
+    ASSERT_OK(db->Put(write_options, "a", "a0"));
+    ASSERT_OK(db->Put(write_options, "b", "b0"));
+    ASSERT_OK(db->Put(write_options, "c", "c0"));
+    ASSERT_OK(db->Merge(write_options, "d", "d0"));
+    ASSERT_OK(db->Put(write_options, "f", "f0"));
+
+    ASSERT_OK(batch.Put("a", "a1"));
+    ASSERT_OK(batch.Delete("b"));
+    ASSERT_OK(batch.Merge("c", "c1"));
+    ASSERT_OK(batch.Merge("d", "d1"));
+    ASSERT_OK(batch.Merge("e", "e0"));
+
+    // Unsorted, with a duplicate, keys missing from the batch and a key
+    // missing everywhere
+    std::vector<Slice> keys = {"f", "c", "a", "x", "b", "e", "d", "c"};
+    std::vector<std::string> values;
+    std::vector<Status> statuses =
+        batch.MultiGetFromBatchAndDB(db, read_options, keys, &values);
+    ASSERT_EQ(keys.size(), statuses.size());
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      std::string value;
+      s = batch.GetFromBatchAndDB(db, read_options, keys[i], &value);
+      ASSERT_EQ(s.ToString(), statuses[i].ToString());
+      if (s.ok()) {
+        ASSERT_EQ(value, values[i]);
+      }
+    }
+    ASSERT_EQ("f0", values[0]);
+    ASSERT_EQ("c0,c1", values[1]);
+    ASSERT_EQ("a1", values[2]);
+    ASSERT_TRUE(statuses[3].IsNotFound());
+    ASSERT_TRUE(statuses[4].IsNotFound());
+    ASSERT_EQ("e0", values[5]);
+    ASSERT_EQ("d0,d1", values[6]);
+    ASSERT_EQ("c0,c1", values[7]);
+
+    delete db;
+    DestroyDB(dbname, options);
+  }
+}
+
 void AssertKey(std::string key, WBWIIterator* iter) {
   ASSERT_TRUE(iter->Valid());
   ASSERT_EQ(key, iter->Entry().key.ToString());